@@ -0,0 +1,174 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/async_log_writer.h"
+
+#include <chrono>
+
+namespace base {
+
+namespace {
+
+// Upper bound for the wakeup latency of the writer thread, see write().
+constexpr std::chrono::milliseconds kWakeupInterval { 100 };
+
+// Maximum size of the data passed to the write callback at once.
+constexpr size_t kMaxBatchSize = 64 * 1024;
+
+size_t roundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 2;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+} // namespace
+
+AsyncLogWriter::AsyncLogWriter(size_t capacity, WriteCallback write_callback)
+    : mask_(roundUpToPowerOfTwo(capacity) - 1),
+      slots_(std::make_unique<Slot[]>(mask_ + 1)),
+      write_callback_(std::move(write_callback))
+{
+    for (size_t i = 0; i <= mask_; ++i)
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+
+    thread_ = std::thread(&AsyncLogWriter::threadMain, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+    {
+        std::scoped_lock lock(lock_);
+        stopping_ = true;
+    }
+
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+bool AsyncLogWriter::write(std::string&& message)
+{
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;)
+    {
+        slot = &slots_[pos & mask_];
+
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0)
+        {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // The slot has not been read yet, the queue is full.
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->message = std::move(message);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // The notification is sent without the lock, so the writer thread may miss it if it is just
+    // going to sleep. In that case the message is written after kWakeupInterval.
+    if (waiting_.load(std::memory_order_acquire))
+        wakeup_.notify_one();
+
+    return true;
+}
+
+void AsyncLogWriter::flush()
+{
+    const size_t pos = enqueue_pos_.load(std::memory_order_acquire);
+
+    std::unique_lock lock(lock_);
+    wakeup_.notify_one();
+    written_.wait(lock, [this, pos]() { return written_pos_ >= pos; });
+}
+
+bool AsyncLogWriter::pop(std::string* message)
+{
+    Slot& slot = slots_[dequeue_pos_ & mask_];
+
+    if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+        return false;
+
+    message->swap(slot.message);
+    slot.message.clear();
+    slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+}
+
+bool AsyncLogWriter::isEmpty() const
+{
+    const Slot& slot = slots_[dequeue_pos_ & mask_];
+    return slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+}
+
+void AsyncLogWriter::threadMain()
+{
+    std::string batch;
+    std::string message;
+
+    for (;;)
+    {
+        batch.clear();
+
+        while (batch.size() < kMaxBatchSize && pop(&message))
+            batch.append(message);
+
+        uint64_t dropped_count = dropped_count_.load(std::memory_order_relaxed);
+        if (dropped_count != reported_dropped_count_)
+        {
+            batch.append(std::to_string(dropped_count - reported_dropped_count_));
+            batch.append(" log messages dropped: the logging queue is full\n");
+            reported_dropped_count_ = dropped_count;
+        }
+
+        if (!batch.empty())
+            write_callback_(batch);
+
+        std::unique_lock lock(lock_);
+
+        written_pos_ = dequeue_pos_;
+        written_.notify_all();
+
+        if (!isEmpty())
+            continue;
+
+        if (stopping_)
+            return;
+
+        waiting_.store(true, std::memory_order_release);
+        wakeup_.wait_for(lock, kWakeupInterval, [this]() { return stopping_ || !isEmpty(); });
+        waiting_.store(false, std::memory_order_relaxed);
+    }
+}
+
+} // namespace base
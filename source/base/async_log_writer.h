@@ -0,0 +1,98 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__ASYNC_LOG_WRITER_H
+#define BASE__ASYNC_LOG_WRITER_H
+
+#include "base/macros_magic.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace base {
+
+// Moves the writing of log messages out of the threads that produce them. Messages are put into a
+// bounded lock-free ring buffer and a background thread writes them in batches. When the buffer is
+// full, new messages are dropped instead of blocking the caller; the number of dropped messages is
+// written to the log as soon as there is room again.
+class AsyncLogWriter
+{
+public:
+    // Called on the background thread with one or more complete messages.
+    using WriteCallback = std::function<void(const std::string& messages)>;
+
+    // |capacity| is the maximum number of queued messages, rounded up to a power of two.
+    AsyncLogWriter(size_t capacity, WriteCallback write_callback);
+
+    // Writes all the queued messages and stops the background thread.
+    ~AsyncLogWriter();
+
+    // Adds the message to the queue. Never blocks. Returns false if the queue is full and the
+    // message was dropped. Can be called from any thread.
+    bool write(std::string&& message);
+
+    // Blocks until all messages queued before the call are written. Must not be called from the
+    // write callback.
+    void flush();
+
+    // Total number of messages dropped because the queue was full.
+    uint64_t droppedCount() const { return dropped_count_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        std::string message;
+    };
+
+    bool pop(std::string* message);
+    bool isEmpty() const;
+    void threadMain();
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    WriteCallback write_callback_;
+
+    // Producers and the consumer use their own cache lines.
+    alignas(64) std::atomic<size_t> enqueue_pos_ { 0 };
+    alignas(64) size_t dequeue_pos_ = 0;
+
+    std::atomic<uint64_t> dropped_count_ { 0 };
+    uint64_t reported_dropped_count_ = 0;
+
+    std::atomic_bool waiting_ { false };
+
+    std::mutex lock_;
+    std::condition_variable wakeup_;
+    std::condition_variable written_;
+    size_t written_pos_ = 0;
+    bool stopping_ = false;
+
+    std::thread thread_;
+
+    DISALLOW_COPY_AND_ASSIGN(AsyncLogWriter);
+};
+
+} // namespace base
+
+#endif // BASE__ASYNC_LOG_WRITER_H
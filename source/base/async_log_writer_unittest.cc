@@ -0,0 +1,114 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/async_log_writer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace base {
+
+TEST(AsyncLogWriterTest, WritesInOrder)
+{
+    std::string output;
+
+    {
+        AsyncLogWriter writer(16, [&](const std::string& messages) { output.append(messages); });
+
+        for (int i = 0; i < 10; ++i)
+            EXPECT_TRUE(writer.write(std::to_string(i) + '\n'));
+
+        writer.flush();
+        EXPECT_EQ(output, "0\n1\n2\n3\n4\n5\n6\n7\n8\n9\n");
+
+        EXPECT_TRUE(writer.write("last\n"));
+    }
+
+    EXPECT_EQ(output, "0\n1\n2\n3\n4\n5\n6\n7\n8\n9\nlast\n");
+}
+
+TEST(AsyncLogWriterTest, DropsWhenFull)
+{
+    std::mutex lock;
+    std::string output;
+
+    // Block the writer thread inside the callback so that the queue fills up.
+    std::unique_lock blocker(lock);
+
+    AsyncLogWriter writer(4, [&](const std::string& messages)
+    {
+        std::scoped_lock callback_lock(lock);
+        output.append(messages);
+    });
+
+    int written = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (writer.write("message\n"))
+            ++written;
+    }
+
+    // Four messages are queued and the blocked thread may already hold up to four more.
+    EXPECT_GE(written, 4);
+    EXPECT_LE(written, 8);
+    EXPECT_EQ(writer.droppedCount(), static_cast<uint64_t>(100 - written));
+
+    blocker.unlock();
+    writer.flush();
+
+    std::scoped_lock output_lock(lock);
+    EXPECT_NE(output.find(" log messages dropped"), std::string::npos);
+}
+
+TEST(AsyncLogWriterTest, ManyThreads)
+{
+    static const int kThreadCount = 4;
+    static const int kMessageCount = 1000;
+
+    size_t lines = 0;
+
+    {
+        AsyncLogWriter writer(kThreadCount * kMessageCount, [&](const std::string& messages)
+        {
+            lines += std::count(messages.begin(), messages.end(), '\n');
+        });
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreadCount; ++i)
+        {
+            threads.emplace_back([&writer]()
+            {
+                for (int j = 0; j < kMessageCount; ++j)
+                    writer.write("message\n");
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        writer.flush();
+        EXPECT_EQ(writer.droppedCount(), 0u);
+    }
+
+    EXPECT_EQ(lines, static_cast<size_t>(kThreadCount * kMessageCount));
+}
+
+} // namespace base
@@ -0,0 +1,460 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/audio/audio_capturer_pulse.h"
+
+#include "base/logging.h"
+#include "base/audio/linux/pulseaudio_symbol_table.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
+
+// Accesses Pulse functions through our late-binding symbol table instead of directly. This way we
+// don't have to link to libpulse, which means our binary will work on systems that don't have it.
+#define LATE(sym) LATESYM_GET(base::PulseAudioSymbolTable, base::pulseSymbolTable(), sym)
+
+namespace base {
+
+namespace {
+
+const int kSampleRate = proto::AudioPacket::SAMPLING_RATE_48000;
+const int kChannels = 2;
+const int kBytesPerSample = 2;
+const int kBytesPerFrame = kChannels * kBytesPerSample;
+
+// The server delivers the recorded data in fragments of this duration. Small fragments keep the
+// capture latency low, the encoder collects them into frames of its own duration.
+const std::chrono::milliseconds kFragmentDuration { 10 };
+
+// The record stream is connected again not earlier than this interval after the previous attempt
+// (for example, when the default sink is removed).
+const std::chrono::seconds kRecordRestartInterval { 1 };
+
+const int kSilenceThreshold = 2;
+
+class ScopedPaLock
+{
+public:
+    explicit ScopedPaLock(pa_threaded_mainloop* pa_main_loop)
+        : pa_main_loop_(pa_main_loop)
+    {
+        LATE(pa_threaded_mainloop_lock)(pa_main_loop_);
+    }
+
+    ~ScopedPaLock()
+    {
+        LATE(pa_threaded_mainloop_unlock)(pa_main_loop_);
+    }
+
+private:
+    pa_threaded_mainloop* pa_main_loop_;
+    DISALLOW_COPY_AND_ASSIGN(ScopedPaLock);
+};
+
+} // namespace
+
+AudioCapturerPulse::AudioCapturerPulse()
+    : silence_detector_(kSilenceThreshold)
+{
+    silence_detector_.reset(kSampleRate, kChannels);
+}
+
+AudioCapturerPulse::~AudioCapturerPulse()
+{
+    if (capture_timer_)
+        capture_timer_->cancel();
+
+    terminateRecording();
+    terminatePulseAudio();
+}
+
+bool AudioCapturerPulse::start(const PacketCapturedCallback& callback)
+{
+    MessageLoop* message_loop = MessageLoop::current();
+    if (!message_loop)
+    {
+        LOG(LS_ERROR) << "No message loop in current thread";
+        return false;
+    }
+
+    if (message_loop->type() != MessageLoop::Type::ASIO)
+    {
+        LOG(LS_ERROR) << "Wrong message loop type: " << static_cast<int>(message_loop->type());
+        return false;
+    }
+
+    if (!initPulseAudio())
+    {
+        LOG(LS_ERROR) << "Failed to initialize PulseAudio";
+        terminatePulseAudio();
+        return false;
+    }
+
+    if (!initRecording())
+    {
+        terminateRecording();
+        terminatePulseAudio();
+        return false;
+    }
+
+    callback_ = callback;
+
+    capture_timer_ = std::make_unique<asio::high_resolution_timer>(
+        message_loop->pumpAsio()->ioContext());
+    capture_timer_->expires_after(kFragmentDuration);
+    capture_timer_->async_wait(
+        std::bind(&AudioCapturerPulse::onCaptureTimeout, this, std::placeholders::_1));
+
+    LOG(LS_INFO) << "Audio capture started";
+    return true;
+}
+
+// static
+void AudioCapturerPulse::paContextStateCallback(pa_context* context, void* self)
+{
+    AudioCapturerPulse* capturer = static_cast<AudioCapturerPulse*>(self);
+
+    switch (LATE(pa_context_get_state)(context))
+    {
+        case PA_CONTEXT_FAILED:
+        case PA_CONTEXT_TERMINATED:
+        case PA_CONTEXT_READY:
+            capturer->pa_state_changed_ = true;
+            LATE(pa_threaded_mainloop_signal)(capturer->pa_main_loop_, 0);
+            break;
+
+        default:
+            break;
+    }
+}
+
+// static
+void AudioCapturerPulse::paServerInfoCallback(
+    pa_context* /* context */, const pa_server_info* info, void* self)
+{
+    AudioCapturerPulse* capturer = static_cast<AudioCapturerPulse*>(self);
+
+    // Each sink has a monitor source which records everything the sink plays.
+    if (info && info->default_sink_name)
+        capturer->monitor_source_ = std::string(info->default_sink_name) + ".monitor";
+    else
+        capturer->monitor_source_.clear();
+
+    LATE(pa_threaded_mainloop_signal)(capturer->pa_main_loop_, 0);
+}
+
+// static
+void AudioCapturerPulse::paStreamStateCallback(pa_stream* /* stream */, void* self)
+{
+    LATE(pa_threaded_mainloop_signal)(static_cast<AudioCapturerPulse*>(self)->pa_main_loop_, 0);
+}
+
+bool AudioCapturerPulse::initPulseAudio()
+{
+    if (!pulseSymbolTable()->load())
+    {
+        // Most likely the Pulse library and sound server are not installed on this system.
+        LOG(LS_ERROR) << "Failed to load symbol table";
+        return false;
+    }
+
+    pa_main_loop_ = LATE(pa_threaded_mainloop_new)();
+    if (!pa_main_loop_)
+    {
+        LOG(LS_ERROR) << "Could not create mainloop";
+        return false;
+    }
+
+    int ret = LATE(pa_threaded_mainloop_start)(pa_main_loop_);
+    if (ret != PA_OK)
+    {
+        LOG(LS_ERROR) << "Failed to start main loop: " << ret;
+        return false;
+    }
+
+    ScopedPaLock pa_lock(pa_main_loop_);
+
+    pa_mainloop_api* pa_main_loop_api = LATE(pa_threaded_mainloop_get_api)(pa_main_loop_);
+    if (!pa_main_loop_api)
+    {
+        LOG(LS_ERROR) << "Could not create mainloop API";
+        return false;
+    }
+
+    pa_context_ = LATE(pa_context_new)(pa_main_loop_api, "Aspia Host");
+    if (!pa_context_)
+    {
+        LOG(LS_ERROR) << "Could not create context";
+        return false;
+    }
+
+    LATE(pa_context_set_state_callback)(pa_context_, paContextStateCallback, this);
+
+    // Connect the context to the default server.
+    pa_state_changed_ = false;
+    ret = LATE(pa_context_connect)(pa_context_, nullptr, PA_CONTEXT_NOAUTOSPAWN, nullptr);
+    if (ret != PA_OK)
+    {
+        LOG(LS_ERROR) << "Failed to connect context: " << ret;
+        return false;
+    }
+
+    while (!pa_state_changed_)
+        LATE(pa_threaded_mainloop_wait)(pa_main_loop_);
+
+    if (LATE(pa_context_get_state)(pa_context_) != PA_CONTEXT_READY)
+    {
+        LOG(LS_ERROR) << "Failed to connect to PulseAudio sound server";
+        return false;
+    }
+
+    LOG(LS_INFO) << "PulseAudio initialized";
+    return true;
+}
+
+void AudioCapturerPulse::terminatePulseAudio()
+{
+    if (!pa_main_loop_)
+        return;
+
+    {
+        ScopedPaLock pa_lock(pa_main_loop_);
+
+        if (pa_context_)
+        {
+            LATE(pa_context_disconnect)(pa_context_);
+            LATE(pa_context_unref)(pa_context_);
+            pa_context_ = nullptr;
+        }
+    }
+
+    LATE(pa_threaded_mainloop_stop)(pa_main_loop_);
+    LATE(pa_threaded_mainloop_free)(pa_main_loop_);
+    pa_main_loop_ = nullptr;
+
+    LOG(LS_INFO) << "PulseAudio terminated";
+}
+
+bool AudioCapturerPulse::initRecording()
+{
+    record_start_time_ = std::chrono::steady_clock::now();
+
+    ScopedPaLock pa_lock(pa_main_loop_);
+
+    // The default sink can be changed by the user, so it is requested for each new stream.
+    monitor_source_.clear();
+
+    pa_operation* op = LATE(pa_context_get_server_info)(pa_context_, paServerInfoCallback, this);
+    if (op)
+    {
+        while (LATE(pa_operation_get_state)(op) == PA_OPERATION_RUNNING)
+            LATE(pa_threaded_mainloop_wait)(pa_main_loop_);
+
+        LATE(pa_operation_unref)(op);
+    }
+
+    if (monitor_source_.empty())
+    {
+        LOG(LS_ERROR) << "No default sink";
+        return false;
+    }
+
+    pa_sample_spec spec;
+    spec.format = PA_SAMPLE_S16LE;
+    spec.rate = kSampleRate;
+    spec.channels = kChannels;
+
+    pa_proplist* prop_list = LATE(pa_proplist_new)();
+    LATE(pa_proplist_sets)(prop_list, PA_PROP_MEDIA_ROLE, "production");
+
+    record_stream_ = LATE(pa_stream_new_with_proplist)(
+        pa_context_, "recordStream", &spec, nullptr, prop_list);
+
+    LATE(pa_proplist_free)(prop_list);
+
+    if (!record_stream_)
+    {
+        LOG(LS_ERROR) << "Failed to create record stream: " << LATE(pa_context_errno)(pa_context_);
+        return false;
+    }
+
+    LATE(pa_stream_set_state_callback)(record_stream_, paStreamStateCallback, this);
+
+    // The server is asked to deliver the data in small fragments and to adjust the latency of the
+    // source to them.
+    pa_buffer_attr buffer_attr;
+    buffer_attr.fragsize = static_cast<uint32_t>(
+        LATE(pa_usec_to_bytes)(kFragmentDuration.count() * 1000, &spec));
+    buffer_attr.maxlength = static_cast<uint32_t>(-1);
+    buffer_attr.minreq = static_cast<uint32_t>(-1);
+    buffer_attr.prebuf = static_cast<uint32_t>(-1);
+    buffer_attr.tlength = static_cast<uint32_t>(-1);
+
+    if (LATE(pa_stream_connect_record)(record_stream_,
+                                       monitor_source_.c_str(),
+                                       &buffer_attr,
+                                       PA_STREAM_ADJUST_LATENCY) != PA_OK)
+    {
+        LOG(LS_ERROR) << "Failed to connect record stream: "
+                      << LATE(pa_context_errno)(pa_context_);
+        return false;
+    }
+
+    while (true)
+    {
+        pa_stream_state_t state = LATE(pa_stream_get_state)(record_stream_);
+        if (state == PA_STREAM_READY)
+            break;
+
+        if (state == PA_STREAM_FAILED || state == PA_STREAM_TERMINATED)
+        {
+            LOG(LS_ERROR) << "Record stream failed: " << LATE(pa_context_errno)(pa_context_);
+            return false;
+        }
+
+        LATE(pa_threaded_mainloop_wait)(pa_main_loop_);
+    }
+
+    LOG(LS_INFO) << "Audio recording of '" << monitor_source_ << "' initialized";
+    return true;
+}
+
+void AudioCapturerPulse::terminateRecording()
+{
+    if (!record_stream_)
+        return;
+
+    ScopedPaLock pa_lock(pa_main_loop_);
+
+    LATE(pa_stream_set_state_callback)(record_stream_, nullptr, nullptr);
+
+    if (LATE(pa_stream_get_state)(record_stream_) != PA_STREAM_UNCONNECTED)
+        LATE(pa_stream_disconnect)(record_stream_);
+
+    LATE(pa_stream_unref)(record_stream_);
+    record_stream_ = nullptr;
+}
+
+void AudioCapturerPulse::doCapture()
+{
+    bool stream_failed = !record_stream_;
+
+    buffer_.clear();
+
+    if (record_stream_)
+    {
+        ScopedPaLock pa_lock(pa_main_loop_);
+
+        if (LATE(pa_stream_get_state)(record_stream_) != PA_STREAM_READY)
+        {
+            stream_failed = true;
+        }
+        else
+        {
+            while (LATE(pa_stream_readable_size)(record_stream_) > 0)
+            {
+                const void* data;
+                size_t size;
+
+                if (LATE(pa_stream_peek)(record_stream_, &data, &size) < 0)
+                {
+                    LOG(LS_ERROR) << "pa_stream_peek failed: "
+                                  << LATE(pa_context_errno)(pa_context_);
+                    break;
+                }
+
+                if (!size)
+                    break;
+
+                // A null pointer with a non-zero size is a hole in the stream, it is skipped.
+                if (data)
+                {
+                    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+                    buffer_.insert(buffer_.end(), bytes, bytes + size);
+                }
+
+                LATE(pa_stream_drop)(record_stream_);
+            }
+        }
+    }
+
+    if (stream_failed)
+    {
+        if (std::chrono::steady_clock::now() - record_start_time_ < kRecordRestartInterval)
+            return;
+
+        terminateRecording();
+
+        // The connection to the server is lost if the server has been restarted.
+        if (!pa_context_ || LATE(pa_context_get_state)(pa_context_) != PA_CONTEXT_READY)
+        {
+            terminatePulseAudio();
+
+            if (!initPulseAudio())
+            {
+                record_start_time_ = std::chrono::steady_clock::now();
+                terminatePulseAudio();
+                return;
+            }
+        }
+
+        if (!initRecording())
+            terminateRecording();
+        return;
+    }
+
+    const size_t frames = buffer_.size() / kBytesPerFrame;
+    if (!frames)
+        return;
+
+    if (silence_detector_.isSilence(reinterpret_cast<const int16_t*>(buffer_.data()), frames))
+        return;
+
+    std::unique_ptr<proto::AudioPacket> packet = std::make_unique<proto::AudioPacket>();
+    packet->add_data(buffer_.data(), frames * kBytesPerFrame);
+    packet->set_encoding(proto::AUDIO_ENCODING_RAW);
+    packet->set_sampling_rate(static_cast<proto::AudioPacket::SamplingRate>(kSampleRate));
+    packet->set_bytes_per_sample(proto::AudioPacket::BYTES_PER_SAMPLE_2);
+    packet->set_channels(proto::AudioPacket::CHANNELS_STEREO);
+
+    callback_(std::move(packet));
+}
+
+void AudioCapturerPulse::onCaptureTimeout(const std::error_code& error_code)
+{
+    if (error_code == asio::error::operation_aborted)
+        return;
+
+    if (!error_code)
+        doCapture();
+
+    capture_timer_->expires_after(kFragmentDuration);
+    capture_timer_->async_wait(
+        std::bind(&AudioCapturerPulse::onCaptureTimeout, this, std::placeholders::_1));
+}
+
+bool AudioCapturer::isSupported()
+{
+    return pulseSymbolTable()->load();
+}
+
+std::unique_ptr<AudioCapturer> AudioCapturer::create()
+{
+    return std::unique_ptr<AudioCapturer>(new AudioCapturerPulse());
+}
+
+} // namespace base
@@ -0,0 +1,84 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__AUDIO__AUDIO_CAPTURER_PULSE_H
+#define BASE__AUDIO__AUDIO_CAPTURER_PULSE_H
+
+#include "base/macros_magic.h"
+#include "base/audio/audio_capturer.h"
+#include "base/audio/audio_silence_detector.h"
+#include "base/memory/byte_array.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <asio/high_resolution_timer.hpp>
+#include <pulse/pulseaudio.h>
+
+namespace base {
+
+// An AudioCapturer implementation for Linux. It records the monitor source of the default sink,
+// so the client hears everything the host plays. PipeWire is supported through its PulseAudio
+// server. The library is loaded at runtime (see PulseAudioSymbolTable).
+class AudioCapturerPulse : public AudioCapturer
+{
+public:
+    AudioCapturerPulse();
+    ~AudioCapturerPulse() override;
+
+    // AudioCapturer interface.
+    bool start(const PacketCapturedCallback& callback) override;
+
+private:
+    static void paContextStateCallback(pa_context* context, void* self);
+    static void paServerInfoCallback(pa_context* context, const pa_server_info* info, void* self);
+    static void paStreamStateCallback(pa_stream* stream, void* self);
+
+    bool initPulseAudio();
+    void terminatePulseAudio();
+
+    // Connects a record stream to the monitor of the current default sink.
+    bool initRecording();
+    void terminateRecording();
+
+    // Reads all fragments recorded since the previous call and sends them as one packet.
+    void doCapture();
+
+    void onCaptureTimeout(const std::error_code& error_code);
+
+    PacketCapturedCallback callback_;
+    std::unique_ptr<asio::high_resolution_timer> capture_timer_;
+    AudioSilenceDetector silence_detector_;
+    ByteArray buffer_;
+
+    bool pa_state_changed_ = false;
+    pa_threaded_mainloop* pa_main_loop_ = nullptr;
+    pa_context* pa_context_ = nullptr;
+    pa_stream* record_stream_ = nullptr;
+    std::string monitor_source_;
+
+    // Time of the last attempt to connect the record stream.
+    std::chrono::steady_clock::time_point record_start_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(AudioCapturerPulse);
+};
+
+} // namespace base
+
+#endif // BASE__AUDIO__AUDIO_CAPTURER_PULSE_H
@@ -38,17 +38,12 @@ AudioCapturerWrapper::~AudioCapturerWrapper()
 
 void AudioCapturerWrapper::start()
 {
+    thread_->setProfile(ThreadProfile::CAPTURE);
     thread_->start(MessageLoop::Type::ASIO, this);
 }
 
 void AudioCapturerWrapper::onBeforeThreadRunning()
 {
-#if defined(OS_WIN)
-    thread_->setPriority(Thread::Priority::HIGHEST);
-#else
-#warning Not implemented
-#endif
-
     capturer_ = AudioCapturer::create();
     capturer_->start([this](std::unique_ptr<proto::AudioPacket> packet)
     {
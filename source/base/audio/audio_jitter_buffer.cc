@@ -0,0 +1,208 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/audio/audio_jitter_buffer.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace base {
+
+namespace {
+
+// Upper limit of the target delay.
+const AudioJitterBuffer::Milliseconds kMaxDelay { 400 };
+
+// If the buffer holds more than the target delay plus this time, the oldest samples are dropped.
+const AudioJitterBuffer::Milliseconds kDropThreshold { 300 };
+
+// Longer gaps between packets are pauses of the stream (the host does not send silence), they are
+// not taken into account in the jitter.
+const std::chrono::microseconds kMaxJitterSample { 500000 };
+
+// Playback speed while the excess is played out: 21 frames are played in the time of 20 frames.
+// The change of pitch at 5% is hardly noticeable.
+const uint32_t kPhaseOne = 1 << 16;
+const uint32_t kStretchStep = kPhaseOne * 21 / 20;
+
+} // namespace
+
+// static
+const AudioJitterBuffer::Milliseconds AudioJitterBuffer::kDefaultMinDelay { 40 };
+const AudioJitterBuffer::Milliseconds AudioJitterBuffer::kLowLatencyMinDelay { 10 };
+
+AudioJitterBuffer::AudioJitterBuffer(int sample_rate, int channels, Milliseconds min_delay)
+    : sample_rate_(sample_rate),
+      channels_(channels),
+      min_delay_(min_delay),
+      target_delay_(min_delay)
+{
+    DCHECK_GT(sample_rate_, 0);
+    DCHECK_GT(channels_, 0);
+    DCHECK_GT(min_delay_.count(), 0);
+}
+
+AudioJitterBuffer::~AudioJitterBuffer() = default;
+
+void AudioJitterBuffer::addSamples(const TimePoint& time, const int16_t* samples, size_t frames)
+{
+    if (!frames)
+        return;
+
+    updateJitter(time, frames);
+    samples_.insert(samples_.end(), samples, samples + frames * channels_);
+}
+
+size_t AudioJitterBuffer::readSamples(int16_t* samples, size_t frames)
+{
+    if (!playing_)
+    {
+        if (bufferedFrames() < framesFromTime(target_delay_))
+        {
+            std::fill(samples, samples + frames * channels_, 0);
+            return 0;
+        }
+
+        playing_ = true;
+    }
+
+    const size_t target_frames = framesFromTime(target_delay_);
+    const size_t buffered_frames = bufferedFrames();
+
+    size_t count;
+
+    if (buffered_frames > target_frames + framesFromTime(kDropThreshold))
+    {
+        // The delay is too large to play it out in a reasonable time.
+        const size_t drop_frames = buffered_frames - target_frames;
+        samples_.erase(samples_.begin(), samples_.begin() + drop_frames * channels_);
+        stretch_phase_ = 0;
+
+        LOG(LS_INFO) << "Dropped " << drop_frames * 1000 / sample_rate_ << " ms of audio";
+    }
+
+    // Playback is sped up if the buffer holds more than the target delay plus the minimum delay.
+    // It goes on until the buffer holds the target delay.
+    if (bufferedFrames() > target_frames + framesFromTime(min_delay_))
+        stretching_ = true;
+    else if (bufferedFrames() <= target_frames)
+        stretching_ = false;
+
+    if (stretching_)
+    {
+        count = readStretched(samples, frames);
+    }
+    else
+    {
+        stretch_phase_ = 0;
+
+        count = std::min(frames, bufferedFrames());
+        auto end = samples_.begin() + count * channels_;
+
+        std::copy(samples_.begin(), end, samples);
+        samples_.erase(samples_.begin(), end);
+    }
+
+    if (count < frames)
+    {
+        // Underrun. Playback resumes when the buffer holds the target delay again.
+        std::fill(samples + count * channels_, samples + frames * channels_, 0);
+        playing_ = false;
+        stretching_ = false;
+        ++underrun_count_;
+    }
+
+    return count;
+}
+
+AudioJitterBuffer::Milliseconds AudioJitterBuffer::bufferedTime() const
+{
+    return Milliseconds(static_cast<int64_t>(bufferedFrames()) * 1000 / sample_rate_);
+}
+
+AudioJitterBuffer::Milliseconds AudioJitterBuffer::jitter() const
+{
+    return std::chrono::duration_cast<Milliseconds>(
+        std::chrono::microseconds(jitter_x16_ / 16));
+}
+
+size_t AudioJitterBuffer::framesFromTime(Milliseconds time) const
+{
+    return static_cast<size_t>(time.count() * sample_rate_ / 1000);
+}
+
+void AudioJitterBuffer::updateJitter(const TimePoint& time, size_t frames)
+{
+    if (last_arrival_ != TimePoint())
+    {
+        const std::chrono::microseconds interval =
+            std::chrono::duration_cast<std::chrono::microseconds>(time - last_arrival_);
+
+        if (interval < kMaxJitterSample)
+        {
+            // Deviation of the interval between packets from the duration of the previous
+            // packet.
+            const int64_t deviation = std::abs((interval - last_duration_).count());
+            jitter_x16_ += deviation - (jitter_x16_ + 8) / 16;
+        }
+    }
+
+    last_arrival_ = time;
+    last_duration_ = std::chrono::microseconds(
+        static_cast<int64_t>(frames) * 1000000 / sample_rate_);
+
+    // The buffer covers the duration of a packet and several average deviations.
+    const std::chrono::microseconds target =
+        last_duration_ + std::chrono::microseconds(jitter_x16_ / 4);
+
+    target_delay_ = std::clamp(
+        std::chrono::duration_cast<Milliseconds>(target), min_delay_, kMaxDelay);
+}
+
+size_t AudioJitterBuffer::readStretched(int16_t* samples, size_t frames)
+{
+    size_t count = 0;
+
+    // Linear interpolation between two neighbouring frames.
+    while (count < frames && bufferedFrames() >= 2)
+    {
+        for (int channel = 0; channel < channels_; ++channel)
+        {
+            const int32_t first = samples_[channel];
+            const int32_t second = samples_[channels_ + channel];
+
+            samples[count * channels_ + channel] = static_cast<int16_t>(
+                first + ((static_cast<int64_t>(second - first) * stretch_phase_) >> 16));
+        }
+
+        ++count;
+        stretch_phase_ += kStretchStep;
+
+        while (stretch_phase_ >= kPhaseOne && !samples_.empty())
+        {
+            samples_.erase(samples_.begin(), samples_.begin() + channels_);
+            stretch_phase_ -= kPhaseOne;
+        }
+    }
+
+    return count;
+}
+
+} // namespace base
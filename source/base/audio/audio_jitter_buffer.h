@@ -0,0 +1,103 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__AUDIO__AUDIO_JITTER_BUFFER_H
+#define BASE__AUDIO__AUDIO_JITTER_BUFFER_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+namespace base {
+
+// Smooths out the irregular arrival of audio packets. The target delay of the buffer follows the
+// measured arrival jitter: playback starts (and restarts after an underrun) only when the buffer
+// holds the target amount of audio. If the buffer holds more than needed (for example, after a
+// burst of delayed packets), playback is slightly sped up until the excess is played out. If the
+// delay becomes too large, the oldest samples are dropped.
+//
+// Samples are interleaved 16-bit with a fixed number of channels. The class is not thread-safe.
+class AudioJitterBuffer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = std::chrono::time_point<Clock>;
+    using Milliseconds = std::chrono::milliseconds;
+
+    // The target delay is never less than |min_delay|. A small minimum gives a lower latency on a
+    // good network, but playback stutters more often when packets are late.
+    static const Milliseconds kDefaultMinDelay;
+    static const Milliseconds kLowLatencyMinDelay;
+
+    AudioJitterBuffer(int sample_rate, int channels, Milliseconds min_delay = kDefaultMinDelay);
+    ~AudioJitterBuffer();
+
+    // Adds |frames| frames (a frame contains a sample for each channel) received at |time|.
+    void addSamples(const TimePoint& time, const int16_t* samples, size_t frames);
+
+    // Fills |frames| frames of |samples|. Silence is written while the buffer is filling.
+    // Returns the number of frames filled with audio (the rest is silence).
+    size_t readSamples(int16_t* samples, size_t frames);
+
+    // Returns the amount of buffered audio.
+    Milliseconds bufferedTime() const;
+
+    // The delay which the buffer tries to keep.
+    Milliseconds targetDelay() const { return target_delay_; }
+
+    // Smoothed deviation of packet arrivals from their expected times.
+    Milliseconds jitter() const;
+
+    size_t underrunCount() const { return underrun_count_; }
+
+private:
+    size_t bufferedFrames() const { return samples_.size() / channels_; }
+    size_t framesFromTime(Milliseconds time) const;
+    void updateJitter(const TimePoint& time, size_t frames);
+    size_t readStretched(int16_t* samples, size_t frames);
+
+    const int sample_rate_;
+    const int channels_;
+    const Milliseconds min_delay_;
+
+    std::deque<int16_t> samples_;
+    bool playing_ = false;
+    bool stretching_ = false;
+
+    // Arrival time of the previous packet and the duration of the audio received in it.
+    TimePoint last_arrival_;
+    std::chrono::microseconds last_duration_ = std::chrono::microseconds::zero();
+
+    // Jitter in microseconds multiplied by 16 (see RFC 3550, section 6.4.1).
+    int64_t jitter_x16_ = 0;
+    Milliseconds target_delay_;
+
+    // Position between the first and the second frame of the buffer while playback is sped up,
+    // in 1/65536 of a frame.
+    uint32_t stretch_phase_ = 0;
+
+    size_t underrun_count_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(AudioJitterBuffer);
+};
+
+} // namespace base
+
+#endif // BASE__AUDIO__AUDIO_JITTER_BUFFER_H
@@ -0,0 +1,173 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/audio/audio_jitter_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace base {
+
+namespace {
+
+const int kSampleRate = 48000;
+const int kChannels = 2;
+
+// Frames in 10 and 20 milliseconds.
+const size_t k10ms = kSampleRate / 100;
+const size_t k20ms = kSampleRate / 50;
+
+std::vector<int16_t> createSamples(size_t frames, int16_t value)
+{
+    return std::vector<int16_t>(frames * kChannels, value);
+}
+
+} // namespace
+
+TEST(AudioJitterBufferTest, WaitsForTargetDelay)
+{
+    AudioJitterBuffer buffer(kSampleRate, kChannels);
+    AudioJitterBuffer::TimePoint now = AudioJitterBuffer::Clock::now();
+
+    std::vector<int16_t> packet = createSamples(k20ms, 100);
+    std::vector<int16_t> output = createSamples(k10ms, 1);
+
+    // Silence is played until the buffer holds the target delay.
+    buffer.addSamples(now, packet.data(), k20ms);
+    EXPECT_EQ(buffer.readSamples(output.data(), k10ms), 0u);
+    EXPECT_EQ(output, createSamples(k10ms, 0));
+
+    now += std::chrono::milliseconds(20);
+    buffer.addSamples(now, packet.data(), k20ms);
+    ASSERT_GE(buffer.bufferedTime(), buffer.targetDelay());
+
+    EXPECT_EQ(buffer.readSamples(output.data(), k10ms), k10ms);
+    EXPECT_EQ(output, createSamples(k10ms, 100));
+    EXPECT_EQ(buffer.underrunCount(), 0u);
+}
+
+TEST(AudioJitterBufferTest, LowLatency)
+{
+    AudioJitterBuffer buffer(kSampleRate, kChannels, AudioJitterBuffer::kLowLatencyMinDelay);
+    AudioJitterBuffer::TimePoint now = AudioJitterBuffer::Clock::now();
+
+    std::vector<int16_t> packet = createSamples(k10ms, 100);
+    std::vector<int16_t> output = createSamples(k10ms, 1);
+
+    // With regular 10 ms packets playback starts after the first packet.
+    buffer.addSamples(now, packet.data(), k10ms);
+    now += std::chrono::milliseconds(10);
+    buffer.addSamples(now, packet.data(), k10ms);
+
+    EXPECT_EQ(buffer.targetDelay(), AudioJitterBuffer::Milliseconds(10));
+    EXPECT_EQ(buffer.readSamples(output.data(), k10ms), k10ms);
+    EXPECT_EQ(output, createSamples(k10ms, 100));
+}
+
+TEST(AudioJitterBufferTest, Underrun)
+{
+    AudioJitterBuffer buffer(kSampleRate, kChannels);
+    AudioJitterBuffer::TimePoint now = AudioJitterBuffer::Clock::now();
+
+    std::vector<int16_t> packet = createSamples(k20ms, 100);
+    std::vector<int16_t> output = createSamples(k10ms, 1);
+
+    for (int i = 0; i < 3; ++i, now += std::chrono::milliseconds(20))
+        buffer.addSamples(now, packet.data(), k20ms);
+
+    // 60 ms of audio are played, then the rest of the buffer is filled with silence.
+    for (int i = 0; i < 6; ++i)
+        EXPECT_EQ(buffer.readSamples(output.data(), k10ms), k10ms);
+
+    EXPECT_EQ(buffer.readSamples(output.data(), k10ms), 0u);
+    EXPECT_EQ(output, createSamples(k10ms, 0));
+    EXPECT_EQ(buffer.underrunCount(), 1u);
+
+    // A single packet is not enough to resume playback.
+    buffer.addSamples(now, packet.data(), k20ms);
+    EXPECT_EQ(buffer.readSamples(output.data(), k10ms), 0u);
+}
+
+TEST(AudioJitterBufferTest, TargetFollowsJitter)
+{
+    AudioJitterBuffer buffer(kSampleRate, kChannels);
+    AudioJitterBuffer::TimePoint now = AudioJitterBuffer::Clock::now();
+
+    std::vector<int16_t> packet = createSamples(k20ms, 100);
+
+    // Regular arrivals keep the minimal delay.
+    for (int i = 0; i < 50; ++i, now += std::chrono::milliseconds(20))
+        buffer.addSamples(now, packet.data(), k20ms);
+
+    EXPECT_EQ(buffer.jitter(), AudioJitterBuffer::Milliseconds::zero());
+    AudioJitterBuffer::Milliseconds regular_delay = buffer.targetDelay();
+
+    // Packets arrive in pairs: 0 and 40 ms apart.
+    for (int i = 0; i < 50; ++i)
+    {
+        buffer.addSamples(now, packet.data(), k20ms);
+        buffer.addSamples(now, packet.data(), k20ms);
+        now += std::chrono::milliseconds(40);
+    }
+
+    EXPECT_GE(buffer.jitter(), AudioJitterBuffer::Milliseconds(15));
+    EXPECT_GT(buffer.targetDelay(), regular_delay);
+    EXPECT_LE(buffer.targetDelay(), AudioJitterBuffer::Milliseconds(400));
+}
+
+TEST(AudioJitterBufferTest, DrainsExcess)
+{
+    AudioJitterBuffer buffer(kSampleRate, kChannels);
+    AudioJitterBuffer::TimePoint now = AudioJitterBuffer::Clock::now();
+
+    std::vector<int16_t> packet = createSamples(k20ms, 100);
+    std::vector<int16_t> output = createSamples(k10ms, 0);
+
+    // A burst of 200 ms of audio.
+    for (int i = 0; i < 10; ++i)
+        buffer.addSamples(now, packet.data(), k20ms);
+
+    AudioJitterBuffer::Milliseconds initial = buffer.bufferedTime();
+
+    // While the excess is played out, every 10 ms of output take 10.5 ms of audio.
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(buffer.readSamples(output.data(), k10ms), k10ms);
+
+    EXPECT_LE(buffer.bufferedTime(), initial - AudioJitterBuffer::Milliseconds(104));
+    EXPECT_EQ(output, createSamples(k10ms, 100));
+    EXPECT_EQ(buffer.underrunCount(), 0u);
+}
+
+TEST(AudioJitterBufferTest, DropsLargeDelay)
+{
+    AudioJitterBuffer buffer(kSampleRate, kChannels);
+    AudioJitterBuffer::TimePoint now = AudioJitterBuffer::Clock::now();
+
+    std::vector<int16_t> packet = createSamples(k20ms, 100);
+    std::vector<int16_t> output = createSamples(k10ms, 0);
+
+    // Two seconds of audio arrive at once.
+    for (int i = 0; i < 100; ++i)
+        buffer.addSamples(now, packet.data(), k20ms);
+
+    EXPECT_EQ(buffer.readSamples(output.data(), k10ms), k10ms);
+    EXPECT_LE(buffer.bufferedTime(), buffer.targetDelay());
+}
+
+} // namespace base
@@ -29,25 +29,28 @@
 #include "base/audio/audio_output_pulse.h"
 #endif
 
+#include <algorithm>
 #include <cstring>
 
 namespace base {
 
-AudioOutput::AudioOutput(const NeedMoreDataCB& need_more_data_cb)
-    : need_more_data_cb_(need_more_data_cb)
+AudioOutput::AudioOutput(const NeedMoreDataCB& need_more_data_cb, Latency latency)
+    : need_more_data_cb_(need_more_data_cb),
+      latency_(latency)
 {
     // Nothing
 }
 
 // static
-std::unique_ptr<AudioOutput> AudioOutput::create(const NeedMoreDataCB& need_more_data_cb)
+std::unique_ptr<AudioOutput> AudioOutput::create(const NeedMoreDataCB& need_more_data_cb,
+                                                 Latency latency)
 {
 #if defined(OS_WIN)
-    return std::make_unique<AudioOutputWin>(need_more_data_cb);
+    return std::make_unique<AudioOutputWin>(need_more_data_cb, latency);
 #elif defined(OS_MAC)
-    return std::make_unique<AudioOutputMac>(need_more_data_cb);
+    return std::make_unique<AudioOutputMac>(need_more_data_cb, latency);
 #elif defined(OS_LINUX)
-    return std::make_unique<AudioOutputPulse>(need_more_data_cb);
+    return std::make_unique<AudioOutputPulse>(need_more_data_cb, latency);
 #else
     NOTIMPLEMENTED();
     return nullptr;
@@ -58,13 +61,15 @@ void AudioOutput::onDataRequest(int16_t* audio_samples, size_t audio_samples_cou
 {
     static const size_t kSamplesPerChannel10ms = kSampleRate * 10 / 1000;
     static const size_t kSamplesPer10ms = kChannels * kSamplesPerChannel10ms;
-    static const size_t kBytesPer10ms = kSamplesPer10ms * sizeof(int16_t);
 
-    const size_t rounds = audio_samples_count / kSamplesPer10ms;
-    for (size_t i = 0; i < rounds; ++i)
+    // The audio is requested in parts of at most 10ms. In the low latency mode the device period
+    // can be shorter than 10ms, so the last part may be smaller.
+    for (size_t offset = 0; offset < audio_samples_count; offset += kSamplesPer10ms)
     {
-        // Get 10ms decoded audio.
-        size_t num_bytes = need_more_data_cb_(audio_samples + (i * kSamplesPer10ms), kBytesPer10ms);
+        const size_t samples_count = std::min(kSamplesPer10ms, audio_samples_count - offset);
+
+        size_t num_bytes =
+            need_more_data_cb_(audio_samples + offset, samples_count * sizeof(int16_t));
         if (!num_bytes)
         {
             memset(audio_samples, 0, audio_samples_count * sizeof(int16_t));
@@ -37,17 +37,31 @@ public:
 
     using NeedMoreDataCB = std::function<size_t(void* data, size_t size)>;
 
-    static std::unique_ptr<AudioOutput> create(const NeedMoreDataCB& need_more_data_cb);
+    enum class Latency
+    {
+        // The buffers of the device are large enough to survive scheduling delays.
+        NORMAL,
+
+        // The device is asked for the smallest period it supports. The callback is called more
+        // often with less data. Underruns are more likely on a loaded system.
+        LOW
+    };
+
+    static std::unique_ptr<AudioOutput> create(const NeedMoreDataCB& need_more_data_cb,
+                                               Latency latency = Latency::NORMAL);
 
     virtual bool start() = 0;
     virtual bool stop() = 0;
 
+    Latency latency() const { return latency_; }
+
 protected:
-    explicit AudioOutput(const NeedMoreDataCB& need_more_data_cb);
+    AudioOutput(const NeedMoreDataCB& need_more_data_cb, Latency latency);
     void onDataRequest(int16_t* audio_samples, size_t audio_samples_count);
 
 private:
     NeedMoreDataCB need_more_data_cb_;
+    const Latency latency_;
 };
 
 } // namespace base
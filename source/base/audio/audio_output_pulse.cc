@@ -23,15 +23,9 @@
 #include "base/message_loop/message_pump_asio.h"
 #include "base/threading/simple_thread.h"
 
-base::PulseAudioSymbolTable* pulseSymbolTable()
-{
-    static base::PulseAudioSymbolTable* pulse_symbol_table = new base::PulseAudioSymbolTable();
-    return pulse_symbol_table;
-}
-
 // Accesses Pulse functions through our late-binding symbol table instead of directly. This way we
 // don't have to link to libpulse, which means our binary will work on systems that don't have it.
-#define LATE(sym) LATESYM_GET(base::PulseAudioSymbolTable, pulseSymbolTable(), sym)
+#define LATE(sym) LATESYM_GET(base::PulseAudioSymbolTable, base::pulseSymbolTable(), sym)
 
 namespace base {
 
@@ -58,8 +52,8 @@ private:
 
 } // namespace
 
-AudioOutputPulse::AudioOutputPulse(const NeedMoreDataCB& need_more_data_cb)
-    : AudioOutput(need_more_data_cb)
+AudioOutputPulse::AudioOutputPulse(const NeedMoreDataCB& need_more_data_cb, Latency latency)
+    : AudioOutput(need_more_data_cb, latency)
 {
     if (initDevice())
         initPlayout();
@@ -286,22 +280,30 @@ bool AudioOutputPulse::initPlayout()
     LATE(pa_stream_set_state_callback)(play_stream_, paStreamStateCallback, this);
     LATE(pa_stream_set_write_callback)(play_stream_, paStreamWriteCallback, this);
 
-    const int kBufferTimeMs = 10;
-    const int kBufferSizeMs = 40;
+    const bool low_latency = latency() == Latency::LOW;
+
+    // In the low latency mode the server is asked to keep the whole latency of the sink (not only
+    // the buffer of the stream) within |kBufferSizeMs|. PipeWire supports it as well.
+    const int kBufferTimeMs = low_latency ? 5 : 10;
+    const int kBufferSizeMs = low_latency ? 15 : 40;
     const int kBytesPerSecond = kSampleRate * kChannels * kBytesPerSample;
     const int kBufferSize = kBytesPerSecond * kBufferSizeMs / 1000LL;
+    const int kPeriodSize = kBytesPerSecond * kBufferTimeMs / 1000LL;
 
     pa_buffer_attr pa_buffer_attr;
     pa_buffer_attr.fragsize = -1;
     pa_buffer_attr.maxlength = -1;
-    pa_buffer_attr.minreq = -1;
+    pa_buffer_attr.minreq = low_latency ? kPeriodSize : -1;
     pa_buffer_attr.prebuf = -1;
     pa_buffer_attr.tlength = kBufferSize;
 
+    const pa_stream_flags_t flags =
+        low_latency ? PA_STREAM_ADJUST_LATENCY : static_cast<pa_stream_flags_t>(0);
+
     if (LATE(pa_stream_connect_playback)(play_stream_,
                                          nullptr,
                                          &pa_buffer_attr,
-                                         static_cast<pa_stream_flags_t>(0),
+                                         flags,
                                          nullptr,
                                          nullptr))
     {
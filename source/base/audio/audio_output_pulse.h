@@ -35,7 +35,7 @@ class SimpleThread;
 class AudioOutputPulse : public AudioOutput
 {
 public:
-    explicit AudioOutputPulse(const NeedMoreDataCB& need_more_data_cb);
+    AudioOutputPulse(const NeedMoreDataCB& need_more_data_cb, Latency latency);
     ~AudioOutputPulse();
 
     // AudioOutput implementation.
@@ -45,8 +45,8 @@ const char* sessionStateToString(AudioSessionState state)
 
 } // namespace
 
-AudioOutputWin::AudioOutputWin(const NeedMoreDataCB& need_more_data_cb)
-    : AudioOutput(need_more_data_cb)
+AudioOutputWin::AudioOutputWin(const NeedMoreDataCB& need_more_data_cb, Latency latency)
+    : AudioOutput(need_more_data_cb, latency)
 {
     // Create the event which the audio engine will signal each time a buffer becomes ready to be
     // processed by the client.
@@ -248,16 +248,41 @@ bool AudioOutputWin::init()
     if (!isFormatSupported(audio_client.Get(), AUDCLNT_SHAREMODE_SHARED, &format_extensible))
         return false;
 
-    // Initialize the audio stream between the client and the device in shared mode using
-    // event-driven buffer handling. Also, using 0 as requested buffer size results in a default
-    // (minimum) endpoint buffer size.
-    const REFERENCE_TIME requested_buffer_size = 0;
-    if (!sharedModeInitialize(audio_client.Get(), &format_extensible, audio_samples_event_,
-                              requested_buffer_size, true, &endpoint_buffer_size_frames_))
+    bool is_initialized = false;
+
+    if (latency() == Latency::LOW)
     {
-        return false;
+        // The smallest engine period gives a few milliseconds of latency instead of the usual 10ms
+        // period and a buffer of two periods.
+        is_initialized = sharedModeInitializeLowLatency(
+            audio_client.Get(), &format_extensible, audio_samples_event_,
+            &endpoint_buffer_size_frames_);
+        if (!is_initialized)
+        {
+            LOG(LS_WARNING) << "Low latency stream is not supported. The default stream is used";
+
+            // A client which failed to initialize can not be initialized again.
+            audio_client = createClient(device.Get());
+            if (!audio_client.Get())
+                return false;
+        }
+    }
+
+    if (!is_initialized)
+    {
+        // Initialize the audio stream between the client and the device in shared mode using
+        // event-driven buffer handling. Also, using 0 as requested buffer size results in a
+        // default (minimum) endpoint buffer size.
+        const REFERENCE_TIME requested_buffer_size = 0;
+        if (!sharedModeInitialize(audio_client.Get(), &format_extensible, audio_samples_event_,
+                                  requested_buffer_size, true, &endpoint_buffer_size_frames_))
+        {
+            return false;
+        }
     }
 
+    LOG(LS_INFO) << "Endpoint buffer size: " << endpoint_buffer_size_frames_ << " frames";
+
     // Create an IAudioRenderClient for an initialized IAudioClient. The IAudioRenderClient
     // interface enables us to write output data to a rendering endpoint buffer.
     Microsoft::WRL::ComPtr<IAudioRenderClient> audio_render_client =
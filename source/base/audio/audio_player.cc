@@ -19,19 +19,26 @@
 #include "base/audio/audio_player.h"
 
 #include "base/logging.h"
-#include "base/audio/audio_output.h"
 #include "proto/desktop.pb.h"
 
 namespace base {
 
-AudioPlayer::AudioPlayer() = default;
+AudioPlayer::AudioPlayer(AudioOutput::Latency latency)
+    : latency_(latency),
+      jitter_buffer_(AudioOutput::kSampleRate, AudioOutput::kChannels,
+                     latency == AudioOutput::Latency::LOW ?
+                         AudioJitterBuffer::kLowLatencyMinDelay :
+                         AudioJitterBuffer::kDefaultMinDelay)
+{
+    // Nothing
+}
 
 AudioPlayer::~AudioPlayer() = default;
 
 // static
-std::unique_ptr<AudioPlayer> AudioPlayer::create()
+std::unique_ptr<AudioPlayer> AudioPlayer::create(AudioOutput::Latency latency)
 {
-    std::unique_ptr<AudioPlayer> player(new AudioPlayer());
+    std::unique_ptr<AudioPlayer> player(new AudioPlayer(latency));
     if (!player->init())
         return nullptr;
 
@@ -40,60 +47,41 @@ std::unique_ptr<AudioPlayer> AudioPlayer::create()
 
 void AudioPlayer::addPacket(std::unique_ptr<proto::AudioPacket> packet)
 {
-    std::scoped_lock lock(incoming_queue_lock_);
-    incoming_queue_.emplace(std::move(packet));
+    if (packet->data_size() != 1 || packet->sampling_rate() != AudioOutput::kSampleRate ||
+        packet->channels() != AudioOutput::kChannels ||
+        packet->bytes_per_sample() != AudioOutput::kBytesPerSample)
+    {
+        LOG(LS_WARNING) << "Unsupported audio packet format";
+        return;
+    }
+
+    const std::string& data = packet->data(0);
+    const size_t frames = data.size() / (AudioOutput::kChannels * AudioOutput::kBytesPerSample);
+
+    std::scoped_lock lock(jitter_buffer_lock_);
+    jitter_buffer_.addSamples(AudioJitterBuffer::Clock::now(),
+                              reinterpret_cast<const int16_t*>(data.data()), frames);
 }
 
 size_t AudioPlayer::onMoreDataRequired(void* data, size_t size)
 {
-    if (work_queue_.empty())
-    {
-        {
-            std::scoped_lock lock(incoming_queue_lock_);
-            work_queue_.swap(incoming_queue_);
-        }
-
-        if (work_queue_.empty())
-            return 0;
-    }
+    const size_t frames = size / (AudioOutput::kChannels * AudioOutput::kBytesPerSample);
 
-    size_t target_pos = 0;
-
-    while (!work_queue_.empty())
     {
-        const std::string& packet_data = work_queue_.front()->data(0);
-
-        size_t source_size = packet_data.size() - source_pos_;
-        size_t target_size = size - target_pos;
-        size_t num_bytes = std::min(target_size, source_size);
-
-        memcpy(reinterpret_cast<uint8_t*>(data) + target_pos,
-               packet_data.data() + source_pos_,
-               num_bytes);
-        target_pos += num_bytes;
-
-        if (target_size < source_size)
-        {
-            source_pos_ += num_bytes;
-            break;
-        }
-        else
-        {
-            work_queue_.pop();
-            source_pos_ = 0;
-
-            if (target_size == source_size)
-                break;
-        }
+        std::scoped_lock lock(jitter_buffer_lock_);
+
+        // While the buffer is filling or after an underrun, silence is written.
+        jitter_buffer_.readSamples(reinterpret_cast<int16_t*>(data), frames);
     }
 
-    return target_pos;
+    return frames * AudioOutput::kChannels * AudioOutput::kBytesPerSample;
 }
 
 bool AudioPlayer::init()
 {
     output_ = AudioOutput::create(std::bind(
-        &AudioPlayer::onMoreDataRequired, this, std::placeholders::_1, std::placeholders::_2));
+        &AudioPlayer::onMoreDataRequired, this, std::placeholders::_1, std::placeholders::_2),
+        latency_);
     if (!output_)
     {
         LOG(LS_ERROR) << "AudioOutput::create failed";
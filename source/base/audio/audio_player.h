@@ -20,10 +20,11 @@
 #define BASE__AUDIO__AUDIO_PLAYER_H
 
 #include "base/macros_magic.h"
+#include "base/audio/audio_jitter_buffer.h"
+#include "base/audio/audio_output.h"
 
 #include <memory>
 #include <mutex>
-#include <queue>
 
 namespace proto {
 class AudioPacket;
@@ -31,28 +32,30 @@ class AudioPacket;
 
 namespace base {
 
-class AudioOutput;
-
 class AudioPlayer
 {
 public:
     ~AudioPlayer();
 
-    static std::unique_ptr<AudioPlayer> create();
+    // In the low latency mode the device buffers are small and the jitter buffer keeps a smaller
+    // minimum delay. It is intended for interactive audio on a good network.
+    static std::unique_ptr<AudioPlayer> create(
+        AudioOutput::Latency latency = AudioOutput::Latency::NORMAL);
     void addPacket(std::unique_ptr<proto::AudioPacket> packet);
 
+    AudioOutput::Latency latency() const { return latency_; }
+
 private:
-    AudioPlayer();
+    explicit AudioPlayer(AudioOutput::Latency latency);
     bool init();
     size_t onMoreDataRequired(void* data, size_t size);
 
+    const AudioOutput::Latency latency_;
     std::unique_ptr<AudioOutput> output_;
 
-    std::queue<std::unique_ptr<proto::AudioPacket>> incoming_queue_;
-    std::mutex incoming_queue_lock_;
-
-    std::queue<std::unique_ptr<proto::AudioPacket>> work_queue_;
-    size_t source_pos_ = 0;
+    // Packets are added on the network thread and played on the thread of the audio output.
+    AudioJitterBuffer jitter_buffer_;
+    std::mutex jitter_buffer_lock_;
 
     DISALLOW_COPY_AND_ASSIGN(AudioPlayer);
 };
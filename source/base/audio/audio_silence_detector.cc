@@ -18,10 +18,9 @@
 
 #include "base/audio/audio_silence_detector.h"
 
+#include "base/codec/vector_math.h"
 #include "base/logging.h"
 
-#include <cstdlib>
-
 namespace base {
 
 namespace {
@@ -56,20 +55,9 @@ void AudioSilenceDetector::reset(int sampling_rate, int channels)
 bool AudioSilenceDetector::isSilence(const int16_t* samples, size_t frames)
 {
     const int samples_count = frames * channels();
-    bool silent_packet = true;
-    // Potentially this loop can be optimized (e.g. using SSE or adding special case for
-    // threshold_==0), but it's not worth worrying about because the amount of data it processes is
-    // relaively small.
-    for (int i = 0; i < samples_count; ++i)
-    {
-        if (abs(samples[i]) > threshold_)
-        {
-            silent_packet = false;
-            break;
-        }
-    }
 
-    if (!silent_packet)
+    // The scan is vectorized and stops at the first sample above the threshold.
+    if (exceedsThreshold(samples, samples_count, threshold_))
     {
         silence_length_ = 0;
         return false;
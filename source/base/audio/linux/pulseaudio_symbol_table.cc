@@ -26,4 +26,10 @@ PULSE_AUDIO_SYMBOLS_LIST
 #undef X
 LATE_BINDING_SYMBOL_TABLE_DEFINE_END(PulseAudioSymbolTable)
 
+PulseAudioSymbolTable* pulseSymbolTable()
+{
+    static PulseAudioSymbolTable* pulse_symbol_table = new PulseAudioSymbolTable();
+    return pulse_symbol_table;
+}
+
 } // namespace base
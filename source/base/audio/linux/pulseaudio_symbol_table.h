@@ -44,10 +44,13 @@ namespace base {
     X(pa_proplist_new)                       \
     X(pa_proplist_sets)                      \
     X(pa_stream_connect_playback)            \
+    X(pa_stream_connect_record)              \
     X(pa_stream_disconnect)                  \
+    X(pa_stream_drop)                        \
     X(pa_stream_get_buffer_attr)             \
     X(pa_stream_get_state)                   \
     X(pa_stream_new_with_proplist)           \
+    X(pa_stream_peek)                        \
     X(pa_stream_readable_size)               \
     X(pa_stream_set_buffer_attr)             \
     X(pa_stream_set_state_callback)          \
@@ -73,6 +76,9 @@ PULSE_AUDIO_SYMBOLS_LIST
 #undef X
 LATE_BINDING_SYMBOL_TABLE_DECLARE_END(PulseAudioSymbolTable)
 
+// Returns the symbol table shared by all users of PulseAudio in the process.
+PulseAudioSymbolTable* pulseSymbolTable();
+
 } // namespace base
 
 #endif // BASE__AUDIO__LINUX__PULSEAUDIO_SYMBOL_TABLE_H
@@ -226,6 +226,72 @@ bool sharedModeInitialize(IAudioClient* client,
     return true;
 }
 
+bool sharedModeInitializeLowLatency(IAudioClient* client,
+                                    const WAVEFORMATEXTENSIBLE* format,
+                                    HANDLE event_handle,
+                                    uint32_t* endpoint_buffer_size)
+{
+    DCHECK(client);
+    DCHECK(event_handle != nullptr && event_handle != INVALID_HANDLE_VALUE);
+
+    Microsoft::WRL::ComPtr<IAudioClient3> client3;
+    HRESULT hr = client->QueryInterface(IID_PPV_ARGS(&client3));
+    if (FAILED(hr))
+    {
+        LOG(LS_INFO) << "IAudioClient3 is not available: " << SystemError(hr).toString();
+        return false;
+    }
+
+    const WAVEFORMATEX* wave_format = reinterpret_cast<const WAVEFORMATEX*>(format);
+
+    // The periods are in frames. The engine supports any multiple of the fundamental period
+    // between the minimum and the maximum. The default period is usually 10ms.
+    UINT32 default_period = 0;
+    UINT32 fundamental_period = 0;
+    UINT32 min_period = 0;
+    UINT32 max_period = 0;
+    hr = client3->GetSharedModeEnginePeriod(
+        wave_format, &default_period, &fundamental_period, &min_period, &max_period);
+    if (FAILED(hr))
+    {
+        // The low latency periods are not available if the format is converted by the engine.
+        LOG(LS_INFO) << "IAudioClient3::GetSharedModeEnginePeriod failed: "
+                     << SystemError(hr).toString();
+        return false;
+    }
+
+    LOG(LS_INFO) << "Engine periods (frames): default=" << default_period
+                 << " min=" << min_period << " max=" << max_period;
+
+    const DWORD stream_flags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK | AUDCLNT_STREAMFLAGS_NOPERSIST;
+
+    hr = client3->InitializeSharedAudioStream(stream_flags, min_period, wave_format, nullptr);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IAudioClient3::InitializeSharedAudioStream failed: "
+                      << SystemError(hr).toString();
+        return false;
+    }
+
+    hr = client->SetEventHandle(event_handle);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IAudioClient::SetEventHandle failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    UINT32 buffer_size_in_frames = 0;
+    hr = client->GetBufferSize(&buffer_size_in_frames);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IAudioClient::GetBufferSize failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    *endpoint_buffer_size = buffer_size_in_frames;
+    return true;
+}
+
 bool isFormatSupported(IAudioClient* client,
                        AUDCLNT_SHAREMODE share_mode,
                        const WAVEFORMATEXTENSIBLE* format)
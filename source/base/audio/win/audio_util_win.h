@@ -41,6 +41,14 @@ bool sharedModeInitialize(IAudioClient* client,
                           bool auto_convert_pcm,
                           uint32_t* endpoint_buffer_size);
 
+// Initializes the shared mode stream with the smallest period which the audio engine supports for
+// |format| (IAudioClient3, Windows 10 and later). The stream is always event driven. Returns false
+// if a low latency stream is not supported. In this case |client| must not be used any more.
+bool sharedModeInitializeLowLatency(IAudioClient* client,
+                                    const WAVEFORMATEXTENSIBLE* format,
+                                    HANDLE event_handle,
+                                    uint32_t* endpoint_buffer_size);
+
 bool isFormatSupported(IAudioClient* client,
                        AUDCLNT_SHAREMODE share_mode,
                        const WAVEFORMATEXTENSIBLE* format);
@@ -0,0 +1,69 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/base64.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace base {
+
+namespace {
+
+std::string makeData(size_t size)
+{
+    std::string data(size, 0);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = static_cast<char>(i * 31 + 7);
+    return data;
+}
+
+void BM_Base64Encode(benchmark::State& state)
+{
+    const std::string input = makeData(static_cast<size_t>(state.range(0)));
+    std::string output;
+
+    for (auto _ : state)
+    {
+        Base64::encode(input, &output);
+        benchmark::DoNotOptimize(output);
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Base64Encode)->Arg(64)->Arg(4096)->Arg(65536);
+
+void BM_Base64Decode(benchmark::State& state)
+{
+    const std::string input = Base64::encode(makeData(static_cast<size_t>(state.range(0))));
+    std::string output;
+
+    for (auto _ : state)
+    {
+        Base64::decode(input, &output);
+        benchmark::DoNotOptimize(output);
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(input.size()));
+}
+BENCHMARK(BM_Base64Decode)->Arg(64)->Arg(4096)->Arg(65536);
+
+} // namespace
+
+} // namespace base
@@ -0,0 +1,46 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/crypto/scoped_crypto_initializer.h"
+#include "base/logging.h"
+
+#include <benchmark/benchmark.h>
+
+int main(int argc, char **argv)
+{
+    // Options of Google Benchmark are supported. For example, --benchmark_format=json prints the
+    // results in JSON and --benchmark_out=<file> writes them to a file.
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    base::initLogging();
+
+    int ret = 1;
+
+    base::ScopedCryptoInitializer crypto_initializer;
+    if (crypto_initializer.isSucceeded())
+    {
+        benchmark::RunSpecifiedBenchmarks();
+        ret = 0;
+    }
+
+    benchmark::Shutdown();
+    base::shutdownLogging();
+    return ret;
+}
@@ -37,6 +37,12 @@ public:
 
     // Returns average bitrate for the stream in bits per second.
     virtual int bitrate() = 0;
+
+    // Sets the target bitrate in bits per second. The encoder limits it to the supported range.
+    virtual void setBitrate(int bitrate) = 0;
+
+    // Sets the expected packet loss of the channel in percent (0-100).
+    virtual void setPacketLoss(int percentage) = 0;
 };
 
 } // namespace base
@@ -22,26 +22,23 @@
 #include "base/codec/audio_bus.h"
 #include "base/codec/multi_channel_resampler.h"
 
+#include <algorithm>
+
 #include <opus.h>
 
 namespace base {
 
 namespace {
 
-// Output 64 kb/s bitrate.
-const int kOutputBitrateBps = 64 * 1024;
+// Default output bitrate is 64 kb/s. The bitrate is reduced when the channel is slow.
+const int kDefaultBitrateBps = 64 * 1024;
+const int kMinBitrateBps = 16 * 1024;
+const int kMaxBitrateBps = 128 * 1024;
 
 // Opus doesn't support 44100 sampling rate so we always resample to 48kHz.
 const proto::AudioPacket::SamplingRate kOpusSamplingRate =
     proto::AudioPacket::SAMPLING_RATE_48000;
 
-// Opus supports frame sizes of 2.5, 5, 10, 20, 40 and 60 ms. We use 20 ms
-// frames to balance latency and efficiency.
-const std::chrono::milliseconds kFrameSizeMs { 20 };
-
-// Number of samples per frame when using default sampling rate.
-const int kFrameSamples = kOpusSamplingRate * kFrameSizeMs / std::chrono::milliseconds(1000);
-
 const proto::AudioPacket::BytesPerSample kBytesPerSample =
     proto::AudioPacket::BYTES_PER_SAMPLE_2;
 
@@ -52,13 +49,34 @@ bool isSupportedSampleRate(int rate)
 
 } // namespace
 
-AudioEncoderOpus::AudioEncoderOpus() = default;
+// Opus supports frame sizes of 2.5, 5, 10, 20, 40 and 60 ms. By default we use 20 ms frames to
+// balance latency and efficiency.
+// static
+const std::chrono::milliseconds AudioEncoderOpus::kDefaultFrameDuration { 20 };
+
+AudioEncoderOpus::AudioEncoderOpus(std::chrono::milliseconds frame_duration)
+    : frame_duration_(isSupportedFrameDuration(frame_duration) ?
+                      frame_duration : kDefaultFrameDuration),
+      bitrate_(kDefaultBitrateBps)
+{
+    LOG(LS_INFO) << "Opus frame duration: " << frame_duration_.count() << " ms";
+}
 
 AudioEncoderOpus::~AudioEncoderOpus()
 {
     destroyEncoder();
 }
 
+// static
+bool AudioEncoderOpus::isSupportedFrameDuration(std::chrono::milliseconds frame_duration)
+{
+    // Frames of 2.5 and 5 ms are not used because the overhead of a packet becomes too large.
+    return frame_duration == std::chrono::milliseconds(10) ||
+           frame_duration == std::chrono::milliseconds(20) ||
+           frame_duration == std::chrono::milliseconds(40) ||
+           frame_duration == std::chrono::milliseconds(60);
+}
+
 void AudioEncoderOpus::initEncoder()
 {
     DCHECK(!encoder_);
@@ -71,13 +89,17 @@ void AudioEncoderOpus::initEncoder()
         return;
     }
 
-    opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(kOutputBitrateBps));
+    // Silence is encoded with a few bytes once in 400 ms (discontinuous transmission). Such
+    // frames are not sent (see encode()).
+    opus_encoder_ctl(encoder_, OPUS_SET_DTX(1));
+    applySettings();
 
-    frame_size_ = sampling_rate_ * kFrameSizeMs / std::chrono::milliseconds(1000);
+    frame_size_ = sampling_rate_ * frame_duration_ / std::chrono::milliseconds(1000);
+    opus_frame_size_ = kOpusSamplingRate * frame_duration_ / std::chrono::milliseconds(1000);
 
     if (sampling_rate_ != kOpusSamplingRate)
     {
-        resample_buffer_.reset(new char[kFrameSamples * kBytesPerSample * channels_]);
+        resample_buffer_.reset(new char[opus_frame_size_ * kBytesPerSample * channels_]);
         // TODO(sergeyu): Figure out the right buffer size to use per packet instead
         // of using SincResampler::kDefaultRequestSize.
         resampler_.reset(new MultiChannelResampler(
@@ -86,7 +108,7 @@ void AudioEncoderOpus::initEncoder()
             SincResampler::kDefaultRequestSize,
             std::bind(&AudioEncoderOpus::fetchBytesToResample,
                 this, std::placeholders::_1, std::placeholders::_2)));
-        resampler_bus_ = AudioBus::Create(channels_, kFrameSamples);
+        resampler_bus_ = AudioBus::Create(channels_, opus_frame_size_);
     }
 
     // Drop leftover data because it's for different sampling rate.
@@ -144,9 +166,40 @@ void AudioEncoderOpus::fetchBytesToResample(int /* resampler_frame_delay */, Aud
     DCHECK_LE(resampling_data_pos_, static_cast<int>(resampling_data_size_));
 }
 
+void AudioEncoderOpus::applySettings()
+{
+    DCHECK(encoder_);
+
+    opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(bitrate_));
+    opus_encoder_ctl(encoder_, OPUS_SET_INBAND_FEC(packet_loss_ > 0 ? 1 : 0));
+    opus_encoder_ctl(encoder_, OPUS_SET_PACKET_LOSS_PERC(packet_loss_));
+}
+
 int AudioEncoderOpus::bitrate()
 {
-    return kOutputBitrateBps;
+    return bitrate_;
+}
+
+void AudioEncoderOpus::setBitrate(int bitrate)
+{
+    bitrate = std::clamp(bitrate, kMinBitrateBps, kMaxBitrateBps);
+    if (bitrate == bitrate_)
+        return;
+
+    bitrate_ = bitrate;
+    if (encoder_)
+        applySettings();
+}
+
+void AudioEncoderOpus::setPacketLoss(int percentage)
+{
+    percentage = std::clamp(percentage, 0, 100);
+    if (percentage == packet_loss_)
+        return;
+
+    packet_loss_ = percentage;
+    if (encoder_)
+        applySettings();
 }
 
 bool AudioEncoderOpus::encode(
@@ -197,12 +250,12 @@ bool AudioEncoderOpus::encode(
             resampling_data_ = reinterpret_cast<const char*>(pcm_buffer);
             resampling_data_pos_ = 0;
             resampling_data_size_ = samples_wanted * channels_ * kBytesPerSample;
-            resampler_->Resample(kFrameSamples, resampler_bus_.get());
+            resampler_->Resample(opus_frame_size_, resampler_bus_.get());
             resampling_data_ = nullptr;
             samples_consumed = resampling_data_pos_ / channels_ / kBytesPerSample;
 
             resampler_bus_->ToInterleaved<SignedInt16SampleTypeTraits>(
-                kFrameSamples, reinterpret_cast<int16_t*>(resample_buffer_.get()));
+                opus_frame_size_, reinterpret_cast<int16_t*>(resample_buffer_.get()));
             pcm_buffer = reinterpret_cast<int16_t*>(resample_buffer_.get());
         }
         else
@@ -212,11 +265,11 @@ bool AudioEncoderOpus::encode(
 
         // Initialize output buffer.
         std::string* data = output_packet->add_data();
-        data->resize(kFrameSamples * kBytesPerSample * channels_);
+        data->resize(opus_frame_size_ * kBytesPerSample * channels_);
 
         // Encode.
         unsigned char* buffer = reinterpret_cast<unsigned char*>(std::data(*data));
-        int result = opus_encode(encoder_, pcm_buffer, kFrameSamples, buffer, data->length());
+        int result = opus_encode(encoder_, pcm_buffer, opus_frame_size_, buffer, data->length());
         if (result < 0)
         {
             LOG(LS_ERROR) << "opus_encode() failed with error code: " << result;
@@ -224,7 +277,13 @@ bool AudioEncoderOpus::encode(
         }
 
         DCHECK_LE(result, static_cast<int>(data->length()));
-        data->resize(result);
+
+        // Frames of 2 bytes or less are not transmitted in DTX mode. The decoder side plays
+        // silence while there is no data.
+        if (result <= 2)
+            output_packet->mutable_data()->RemoveLast();
+        else
+            data->resize(result);
 
         // Cleanup leftover buffer.
         if (samples_consumed >= leftover_samples_)
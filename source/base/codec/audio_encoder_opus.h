@@ -23,6 +23,8 @@
 #include "base/codec/audio_encoder.h"
 #include "proto/desktop.pb.h"
 
+#include <chrono>
+
 struct OpusEncoder;
 
 namespace base {
@@ -33,24 +35,44 @@ class MultiChannelResampler;
 class AudioEncoderOpus : public AudioEncoder
 {
 public:
-    AudioEncoderOpus();
+    static const std::chrono::milliseconds kDefaultFrameDuration;
+
+    // |frame_duration| must be 10, 20, 40 or 60 ms. Shorter frames reduce the latency, longer
+    // frames reduce the overhead of packets.
+    explicit AudioEncoderOpus(std::chrono::milliseconds frame_duration = kDefaultFrameDuration);
     ~AudioEncoderOpus() override;
 
+    static bool isSupportedFrameDuration(std::chrono::milliseconds frame_duration);
+
     // AudioEncoder interface.
     bool encode(const proto::AudioPacket& input_packet, proto::AudioPacket* output_packet) override;
     int bitrate() override;
 
+    void setBitrate(int bitrate) override;
+
+    // If |percentage| is not zero, in-band FEC is enabled: each frame carries a low bitrate copy
+    // of the previous one, which the decoder uses if the previous frame is lost.
+    void setPacketLoss(int percentage) override;
+
 private:
     void initEncoder();
     void destroyEncoder();
     bool resetForPacket(const proto::AudioPacket& packet);
     void fetchBytesToResample(int resampler_frame_delay, AudioBus* audio_bus);
+    void applySettings();
+
+    const std::chrono::milliseconds frame_duration_;
+    int bitrate_;
+    int packet_loss_ = 0;
 
     int sampling_rate_ = 0;
     proto::AudioPacket::Channels channels_ = proto::AudioPacket::CHANNELS_STEREO;
     OpusEncoder* encoder_ = nullptr;
 
+    // Number of input samples and number of samples at the Opus sampling rate in a frame.
     int frame_size_ = 0;
+    int opus_frame_size_ = 0;
+
     std::unique_ptr<MultiChannelResampler> resampler_;
     std::unique_ptr<char[]> resample_buffer_;
     std::unique_ptr<AudioBus> resampler_bus_;
@@ -0,0 +1,142 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/content_classifier.h"
+
+#include "base/desktop/frame.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace base {
+
+namespace {
+
+constexpr int kBlockSize = 32;
+
+// A block is changed if it has changed in at least kMinChangedFrames of the last 16 frames.
+constexpr int kMinChangedFrames = 10;
+
+// A block is in the middle of a video if at least kMinChangedBlocks of the 3x3 blocks around it
+// (including itself) are changed. The changed blocks next to it are a part of the video too.
+constexpr int kMinChangedBlocks = 6;
+
+} // namespace
+
+ContentClassifier::ContentClassifier() = default;
+ContentClassifier::~ContentClassifier() = default;
+
+void ContentClassifier::update(const Frame* frame)
+{
+    if (frame->size() != size_)
+        reset(frame->size());
+
+    for (auto& history : history_)
+        history = static_cast<uint16_t>(history << 1);
+
+    for (Region::Iterator it(frame->constUpdatedRegion()); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+
+        const int right = std::min((rect.right() + kBlockSize - 1) / kBlockSize, columns_);
+        const int bottom = std::min((rect.bottom() + kBlockSize - 1) / kBlockSize, rows_);
+
+        for (int row = std::max(rect.top() / kBlockSize, 0); row < bottom; ++row)
+        {
+            for (int column = std::max(rect.left() / kBlockSize, 0); column < right; ++column)
+                history_[static_cast<size_t>(row * columns_ + column)] |= 1;
+        }
+    }
+
+    // The blocks in the middle of a video have enough changed blocks around them.
+    for (int row = 0; row < rows_; ++row)
+    {
+        for (int column = 0; column < columns_; ++column)
+        {
+            int changed_blocks = 0;
+
+            if (isChanged(column, row))
+            {
+                for (int y = row - 1; y <= row + 1; ++y)
+                {
+                    for (int x = column - 1; x <= column + 1; ++x)
+                    {
+                        if (isChanged(x, y))
+                            ++changed_blocks;
+                    }
+                }
+            }
+
+            core_[static_cast<size_t>(row * columns_ + column)] =
+                (changed_blocks >= kMinChangedBlocks);
+        }
+    }
+
+    video_region_.clear();
+
+    // The changed blocks next to them are at the edges of the video.
+    for (int row = 0; row < rows_; ++row)
+    {
+        for (int column = 0; column < columns_; ++column)
+        {
+            if (!isChanged(column, row) || !isNearCore(column, row))
+                continue;
+
+            video_region_.addRect(
+                Rect::makeXYWH(column * kBlockSize, row * kBlockSize, kBlockSize, kBlockSize));
+        }
+    }
+
+    video_region_.intersectWith(Rect::makeSize(size_));
+}
+
+void ContentClassifier::reset(const Size& size)
+{
+    size_ = size;
+    columns_ = (size.width() + kBlockSize - 1) / kBlockSize;
+    rows_ = (size.height() + kBlockSize - 1) / kBlockSize;
+
+    history_.assign(static_cast<size_t>(columns_ * rows_), 0);
+    core_.assign(static_cast<size_t>(columns_ * rows_), false);
+    video_region_.clear();
+}
+
+bool ContentClassifier::isChanged(int column, int row) const
+{
+    if (column < 0 || row < 0 || column >= columns_ || row >= rows_)
+        return false;
+
+    const std::bitset<16> history(history_[static_cast<size_t>(row * columns_ + column)]);
+    return static_cast<int>(history.count()) >= kMinChangedFrames;
+}
+
+bool ContentClassifier::isNearCore(int column, int row) const
+{
+    for (int y = std::max(row - 1, 0); y <= std::min(row + 1, rows_ - 1); ++y)
+    {
+        for (int x = std::max(column - 1, 0); x <= std::min(column + 1, columns_ - 1); ++x)
+        {
+            if (core_[static_cast<size_t>(y * columns_ + x)])
+                return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace base
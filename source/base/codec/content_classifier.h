@@ -0,0 +1,71 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__CONTENT_CLASSIFIER_H
+#define BASE__CODEC__CONTENT_CLASSIFIER_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+#include "base/desktop/region.h"
+
+#include <vector>
+
+namespace base {
+
+class Frame;
+
+// Finds the areas of the screen which play a video or an animation from the history of the
+// changes. A block is a part of a video if it has changed in most of the recent frames and most
+// of the blocks around it have too (a blinking caret or a small spinner is not a video). The
+// motion hides the details, so the encoder can spend fewer bits per pixel in these areas and keep
+// the sharpness for the static user interface.
+class ContentClassifier
+{
+public:
+    ContentClassifier();
+    ~ContentClassifier();
+
+    // Must be called for every encoded frame. The moved areas are not counted as changes: the
+    // scrolled text must stay sharp.
+    void update(const Frame* frame);
+
+    // Area of the video in the coordinates of the frame (aligned to the blocks).
+    const Region& videoRegion() const { return video_region_; }
+
+private:
+    void reset(const Size& size);
+    bool isChanged(int column, int row) const;
+    bool isNearCore(int column, int row) const;
+
+    Size size_;
+    int columns_ = 0;
+    int rows_ = 0;
+
+    // A bit for each of the recent frames, the lowest bit is the last frame.
+    std::vector<uint16_t> history_;
+
+    // The blocks in the middle of a video (see kMinChangedBlocks).
+    std::vector<bool> core_;
+    Region video_region_;
+
+    DISALLOW_COPY_AND_ASSIGN(ContentClassifier);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__CONTENT_CLASSIFIER_H
@@ -0,0 +1,102 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/content_classifier.h"
+
+#include "base/desktop/frame_simple.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(320, 240);
+
+// The number of the frames in the history of the classifier.
+const int kHistoryFrames = 16;
+
+} // namespace
+
+TEST(ContentClassifierTest, Video)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+    ContentClassifier classifier;
+
+    const Rect video_rect = Rect::makeXYWH(64, 32, 128, 96);
+
+    for (int i = 0; i < kHistoryFrames; ++i)
+    {
+        frame->updatedRegion()->clear();
+        frame->updatedRegion()->addRect(video_rect);
+
+        // A change once in a while elsewhere is not a video.
+        if (i % 4 == 0)
+            frame->updatedRegion()->addRect(Rect::makeXYWH(256, 160, 64, 64));
+
+        classifier.update(frame.get());
+    }
+
+    EXPECT_TRUE(classifier.videoRegion().equals(Region(video_rect)));
+
+    // The video stops.
+    for (int i = 0; i < kHistoryFrames; ++i)
+    {
+        frame->updatedRegion()->clear();
+        classifier.update(frame.get());
+    }
+
+    EXPECT_TRUE(classifier.videoRegion().isEmpty());
+}
+
+TEST(ContentClassifierTest, SmallAnimation)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+    ContentClassifier classifier;
+
+    for (int i = 0; i < kHistoryFrames; ++i)
+    {
+        // A caret or a spinner changes in every frame.
+        frame->updatedRegion()->clear();
+        frame->updatedRegion()->addRect(Rect::makeXYWH(100, 100, 16, 16));
+
+        classifier.update(frame.get());
+    }
+
+    EXPECT_TRUE(classifier.videoRegion().isEmpty());
+}
+
+TEST(ContentClassifierTest, MovedRects)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+    ContentClassifier classifier;
+
+    for (int i = 0; i < kHistoryFrames; ++i)
+    {
+        // The scrolled text is not a video.
+        frame->movedRects()->clear();
+        frame->movedRects()->push_back(
+            { Point(0, 10), Rect::makeXYWH(0, 0, kFrameSize.width(), kFrameSize.height() - 10) });
+
+        classifier.update(frame.get());
+    }
+
+    EXPECT_TRUE(classifier.videoRegion().isEmpty());
+}
+
+} // namespace base
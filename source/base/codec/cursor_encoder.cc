@@ -22,7 +22,7 @@
 #include "base/desktop/mouse_cursor.h"
 #include "proto/desktop.pb.h"
 
-#include <libyuv/compare.h>
+#include <algorithm>
 
 namespace base {
 
@@ -34,8 +34,8 @@ constexpr size_t kCacheSize = 30;
 // The compression ratio can be in the range of 1 to 22.
 constexpr int kCompressionRatio = 8;
 
-// Recommended seed value for a hash.
-constexpr uint32_t kHashingSeed = 5381;
+// Number of the compressed cursors in SharedCache.
+constexpr size_t kSharedCacheSize = 30;
 
 uint8_t* outputBuffer(proto::CursorShape* cursor_shape, size_t size)
 {
@@ -57,6 +57,28 @@ CursorEncoder::CursorEncoder()
 
 CursorEncoder::~CursorEncoder() = default;
 
+const std::string* CursorEncoder::SharedCache::find(uint32_t hash) const
+{
+    auto result = std::find_if(entries_.begin(), entries_.end(),
+                               [hash](const auto& entry) { return entry.first == hash; });
+    if (result == entries_.end())
+        return nullptr;
+
+    return &result->second;
+}
+
+void CursorEncoder::SharedCache::add(uint32_t hash, const std::string& data)
+{
+    if (find(hash))
+        return;
+
+    entries_.emplace_back(hash, data);
+
+    // The oldest cursor is removed.
+    if (entries_.size() > kSharedCacheSize)
+        entries_.erase(entries_.begin());
+}
+
 bool CursorEncoder::compressCursor(
     const MouseCursor& mouse_cursor, proto::CursorShape* cursor_shape) const
 {
@@ -89,7 +111,9 @@ bool CursorEncoder::compressCursor(
     return true;
 }
 
-bool CursorEncoder::encode(const MouseCursor& mouse_cursor, proto::CursorShape* cursor_shape)
+bool CursorEncoder::encode(const MouseCursor& mouse_cursor,
+                           proto::CursorShape* cursor_shape,
+                           SharedCache* shared_cache)
 {
     const Size& size = mouse_cursor.size();
     const int kMaxSize = std::numeric_limits<int16_t>::max() / 2;
@@ -102,10 +126,8 @@ bool CursorEncoder::encode(const MouseCursor& mouse_cursor, proto::CursorShape*
         return false;
     }
 
-    // Calculate the hash of the cursor to search in the cache.
-    uint32_t hash = libyuv::HashDjb2(mouse_cursor.constImage().data(),
-                                     mouse_cursor.constImage().size(),
-                                     kHashingSeed);
+    // The hash of the cursor to search in the cache. It is calculated once for all the clients.
+    const uint32_t hash = mouse_cursor.hash();
 
     // Trying to find cursor in cache.
     for (size_t index = 0; index < cache_.size(); ++index)
@@ -124,9 +146,21 @@ bool CursorEncoder::encode(const MouseCursor& mouse_cursor, proto::CursorShape*
     cursor_shape->set_hotspot_x(mouse_cursor.hotSpot().x());
     cursor_shape->set_hotspot_y(mouse_cursor.hotSpot().y());
 
-    // Compress the cursor using ZSTD.
-    if (!compressCursor(mouse_cursor, cursor_shape))
-        return false;
+    const std::string* shared_data = shared_cache ? shared_cache->find(hash) : nullptr;
+    if (shared_data)
+    {
+        // Another client has already got this cursor.
+        cursor_shape->set_data(*shared_data);
+    }
+    else
+    {
+        // Compress the cursor using ZSTD.
+        if (!compressCursor(mouse_cursor, cursor_shape))
+            return false;
+
+        if (shared_cache)
+            shared_cache->add(hash, cursor_shape->data());
+    }
 
     if (cache_.empty())
     {
@@ -22,6 +22,8 @@
 #include "base/macros_magic.h"
 #include "base/codec/scoped_zstd_stream.h"
 
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace proto {
@@ -38,7 +40,28 @@ public:
     CursorEncoder();
     ~CursorEncoder();
 
-    bool encode(const MouseCursor& mouse_cursor, proto::CursorShape* cursor_shape);
+    // The compressed cursors shared by the encoders of several clients, so that a cursor which is
+    // sent to all of them is compressed only once. The cache is not thread-safe.
+    class SharedCache
+    {
+    public:
+        SharedCache() = default;
+        ~SharedCache() = default;
+
+        // Returns the compressed image of the cursor with |hash| or nullptr.
+        const std::string* find(uint32_t hash) const;
+        void add(uint32_t hash, const std::string& data);
+
+    private:
+        std::vector<std::pair<uint32_t, std::string>> entries_;
+
+        DISALLOW_COPY_AND_ASSIGN(SharedCache);
+    };
+
+    // If |shared_cache| is not null, the compressed cursors are taken from it and added to it.
+    bool encode(const MouseCursor& mouse_cursor,
+                proto::CursorShape* cursor_shape,
+                SharedCache* shared_cache = nullptr);
 
 private:
     bool compressCursor(const MouseCursor& mouse_cursor, proto::CursorShape* cursor_shape) const;
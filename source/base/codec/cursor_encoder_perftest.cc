@@ -0,0 +1,67 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/cursor_encoder.h"
+#include "base/desktop/mouse_cursor.h"
+#include "proto/desktop.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace base {
+
+namespace {
+
+// More cursors than the encoder keeps in its cache, so that every cursor is compressed.
+const int kCursorCount = 64;
+const int kCursorSize = 32;
+
+void BM_CursorEncoder(benchmark::State& state)
+{
+    std::vector<MouseCursor> cursors;
+
+    for (int i = 0; i < kCursorCount; ++i)
+    {
+        ByteArray image(kCursorSize * kCursorSize * 4);
+        for (size_t j = 0; j < image.size(); ++j)
+            image[j] = static_cast<uint8_t>(((j / 4) % kCursorSize < kCursorSize / 2) ? i : j);
+
+        cursors.emplace_back(std::move(image), Size(kCursorSize, kCursorSize), Point(0, 0));
+    }
+
+    CursorEncoder encoder;
+    proto::CursorShape cursor_shape;
+    size_t index = 0;
+
+    for (auto _ : state)
+    {
+        cursor_shape.Clear();
+        benchmark::DoNotOptimize(encoder.encode(cursors[index], &cursor_shape));
+
+        if (++index == cursors.size())
+            index = 0;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CursorEncoder);
+
+} // namespace
+
+} // namespace base
@@ -0,0 +1,230 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/palette_decoder.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "proto/desktop.pb.h"
+
+namespace base {
+
+namespace {
+
+class BufferReader
+{
+public:
+    explicit BufferReader(const ByteArray& buffer)
+        : buffer_(buffer)
+    {
+        // Nothing
+    }
+
+    bool isAtEnd() const { return pos_ == buffer_.size(); }
+
+    bool readUInt8(uint8_t* value)
+    {
+        if (buffer_.size() - pos_ < 1)
+            return false;
+
+        *value = buffer_[pos_++];
+        return true;
+    }
+
+    bool readUInt16(uint16_t* value)
+    {
+        if (buffer_.size() - pos_ < 2)
+            return false;
+
+        *value = static_cast<uint16_t>(buffer_[pos_] | (buffer_[pos_ + 1] << 8));
+        pos_ += 2;
+        return true;
+    }
+
+    bool readUInt32(uint32_t* value)
+    {
+        if (buffer_.size() - pos_ < 4)
+            return false;
+
+        *value = static_cast<uint32_t>(buffer_[pos_]) |
+            (static_cast<uint32_t>(buffer_[pos_ + 1]) << 8) |
+            (static_cast<uint32_t>(buffer_[pos_ + 2]) << 16) |
+            (static_cast<uint32_t>(buffer_[pos_ + 3]) << 24);
+        pos_ += 4;
+        return true;
+    }
+
+private:
+    const ByteArray& buffer_;
+    size_t pos_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(BufferReader);
+};
+
+bool decodeBlock(BufferReader* reader, Frame* frame)
+{
+    uint16_t x, y, width, height;
+
+    if (!reader->readUInt16(&x) || !reader->readUInt16(&y) ||
+        !reader->readUInt16(&width) || !reader->readUInt16(&height))
+    {
+        LOG(LS_ERROR) << "Invalid block header";
+        return false;
+    }
+
+    const Rect rect = Rect::makeXYWH(x, y, width, height);
+
+    if (rect.isEmpty() || !Rect::makeSize(frame->size()).containsRect(rect))
+    {
+        LOG(LS_ERROR) << "Wrong block rect";
+        return false;
+    }
+
+    uint8_t last_index;
+    if (!reader->readUInt8(&last_index))
+        return false;
+
+    const size_t palette_size = static_cast<size_t>(last_index) + 1;
+    uint32_t palette[256];
+
+    for (size_t i = 0; i < palette_size; ++i)
+    {
+        if (!reader->readUInt32(&palette[i]))
+            return false;
+    }
+
+    int column = 0;
+    int row = 0;
+    uint32_t* pixels = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(rect.x(), rect.y()));
+
+    while (row < rect.height())
+    {
+        uint8_t index;
+        uint8_t run_length;
+
+        if (!reader->readUInt8(&index) || !reader->readUInt8(&run_length))
+            return false;
+
+        if (index >= palette_size)
+        {
+            LOG(LS_ERROR) << "Wrong color index";
+            return false;
+        }
+
+        for (int i = 0; i <= run_length; ++i)
+        {
+            if (row >= rect.height())
+            {
+                LOG(LS_ERROR) << "Run is out of block";
+                return false;
+            }
+
+            pixels[column] = palette[index];
+
+            if (++column == rect.width())
+            {
+                column = 0;
+                ++row;
+                pixels = reinterpret_cast<uint32_t*>(
+                    frame->frameDataAtPos(rect.x(), rect.y() + row));
+            }
+        }
+    }
+
+    frame->updatedRegion()->addRect(rect);
+    return true;
+}
+
+} // namespace
+
+PaletteDecoder::PaletteDecoder()
+    : stream_(ZSTD_createDStream())
+{
+    // Nothing
+}
+
+PaletteDecoder::~PaletteDecoder() = default;
+
+bool PaletteDecoder::decode(const proto::VideoPacket& packet, Frame* frame)
+{
+    if (packet.palette_data().empty())
+        return true;
+
+    if (!decompress(packet, *frame))
+        return false;
+
+    BufferReader reader(buffer_);
+
+    while (!reader.isAtEnd())
+    {
+        if (!decodeBlock(&reader, frame))
+            return false;
+    }
+
+    return true;
+}
+
+bool PaletteDecoder::decompress(const proto::VideoPacket& packet, const Frame& frame)
+{
+    const size_t size = packet.palette_data_size();
+    const std::string& data = packet.palette_data();
+
+    // The encoded blocks are much smaller than the same pixels in ARGB.
+    const size_t max_size = static_cast<size_t>(frame.size().width()) *
+        static_cast<size_t>(frame.size().height()) * Frame::kBytesPerPixel * 2;
+
+    if (!size || size > max_size)
+    {
+        LOG(LS_ERROR) << "Wrong palette data size: " << size;
+        return false;
+    }
+
+    buffer_.resize(size);
+
+    size_t ret = ZSTD_initDStream(stream_.get());
+    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+    ZSTD_inBuffer input = { data.data(), data.size(), 0 };
+    ZSTD_outBuffer output = { buffer_.data(), buffer_.size(), 0 };
+
+    while (input.pos < input.size)
+    {
+        ret = ZSTD_decompressStream(stream_.get(), &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_decompressStream failed: " << ZSTD_getErrorName(ret);
+            return false;
+        }
+
+        if (output.pos == output.size && input.pos < input.size)
+        {
+            LOG(LS_ERROR) << "Palette data is larger than expected";
+            return false;
+        }
+    }
+
+    if (output.pos != size)
+    {
+        LOG(LS_ERROR) << "Palette data is smaller than expected";
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace base
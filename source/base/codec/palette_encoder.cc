@@ -0,0 +1,216 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/palette_encoder.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "proto/desktop.pb.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+// The updated region is checked in blocks of this size aligned to the frame.
+constexpr int kBlockSize = 32;
+
+// Blocks with more colors are left to the video codec. Small blocks (at the edges of the updated
+// region) must have at least kMinPixelsPerColor pixels of each color.
+constexpr size_t kMaxColors = 64;
+constexpr size_t kMinPixelsPerColor = 8;
+
+// Maximum length of one run.
+constexpr int kMaxRunLength = 256;
+
+// The compression ratio can be in the range of 1 to 22. The data is compressed for every frame,
+// so the fastest level is used.
+constexpr int kCompressionRatio = 1;
+
+void writeUInt16(uint16_t value, ByteArray* buffer)
+{
+    buffer->push_back(static_cast<uint8_t>(value & 0xFF));
+    buffer->push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
+}
+
+void writeUInt32(uint32_t value, ByteArray* buffer)
+{
+    for (int i = 0; i < 4; ++i)
+        buffer->push_back(static_cast<uint8_t>((value >> (i * 8)) & 0xFF));
+}
+
+} // namespace
+
+PaletteEncoder::PaletteEncoder()
+    : stream_(ZSTD_createCStream())
+{
+    static_assert(kMaxColors <= 256);
+    static_assert(kCompressionRatio >= 1 && kCompressionRatio <= 22);
+
+    palette_.reserve(kMaxColors);
+    indexes_.reserve(kBlockSize * kBlockSize);
+}
+
+PaletteEncoder::~PaletteEncoder() = default;
+
+void PaletteEncoder::encode(const Frame* frame, Region* updated_region, proto::VideoPacket* packet)
+{
+    buffer_.clear();
+
+    Region palette_region;
+
+    for (Region::Iterator it(*updated_region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+
+        const int left = rect.left() / kBlockSize;
+        const int top = rect.top() / kBlockSize;
+        const int right = (rect.right() - 1) / kBlockSize;
+        const int bottom = (rect.bottom() - 1) / kBlockSize;
+
+        for (int row = top; row <= bottom; ++row)
+        {
+            for (int column = left; column <= right; ++column)
+            {
+                Rect block = Rect::makeXYWH(
+                    column * kBlockSize, row * kBlockSize, kBlockSize, kBlockSize);
+                block.intersectWith(rect);
+
+                if (encodeBlock(frame, block))
+                    palette_region.addRect(block);
+            }
+        }
+    }
+
+    if (buffer_.empty())
+        return;
+
+    // If the data could not be compressed, the video codec encodes the whole area.
+    if (!compress(packet))
+        return;
+
+    updated_region->subtract(palette_region);
+}
+
+bool PaletteEncoder::encodeBlock(const Frame* frame, const Rect& rect)
+{
+    palette_.clear();
+    indexes_.clear();
+
+    const size_t max_colors = std::clamp(
+        static_cast<size_t>(rect.width() * rect.height()) / kMinPixelsPerColor,
+        size_t(1), kMaxColors);
+
+    uint32_t last_color = 0;
+    uint8_t last_index = 0;
+
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+    {
+        const uint32_t* row = reinterpret_cast<const uint32_t*>(frame->frameDataAtPos(0, y));
+
+        for (int x = rect.left(); x < rect.right(); ++x)
+        {
+            const uint32_t color = row[x];
+
+            if (palette_.empty() || color != last_color)
+            {
+                size_t index = 0;
+
+                while (index < palette_.size() && palette_[index] != color)
+                    ++index;
+
+                if (index == palette_.size())
+                {
+                    if (palette_.size() == max_colors)
+                        return false;
+
+                    palette_.emplace_back(color);
+                }
+
+                last_color = color;
+                last_index = static_cast<uint8_t>(index);
+            }
+
+            indexes_.emplace_back(last_index);
+        }
+    }
+
+    writeUInt16(static_cast<uint16_t>(rect.x()), &buffer_);
+    writeUInt16(static_cast<uint16_t>(rect.y()), &buffer_);
+    writeUInt16(static_cast<uint16_t>(rect.width()), &buffer_);
+    writeUInt16(static_cast<uint16_t>(rect.height()), &buffer_);
+
+    buffer_.push_back(static_cast<uint8_t>(palette_.size() - 1));
+    for (const auto& color : palette_)
+        writeUInt32(color, &buffer_);
+
+    for (size_t i = 0; i < indexes_.size();)
+    {
+        const uint8_t index = indexes_[i];
+        int run_length = 1;
+
+        while (i + run_length < indexes_.size() && indexes_[i + run_length] == index &&
+               run_length < kMaxRunLength)
+        {
+            ++run_length;
+        }
+
+        buffer_.push_back(index);
+        buffer_.push_back(static_cast<uint8_t>(run_length - 1));
+
+        i += run_length;
+    }
+
+    return true;
+}
+
+bool PaletteEncoder::compress(proto::VideoPacket* packet)
+{
+    size_t ret = ZSTD_initCStream(stream_.get(), kCompressionRatio);
+    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+    const size_t output_size = ZSTD_compressBound(buffer_.size());
+
+    std::string* data = packet->mutable_palette_data();
+    data->resize(output_size);
+
+    ZSTD_inBuffer input = { buffer_.data(), buffer_.size(), 0 };
+    ZSTD_outBuffer output = { data->data(), output_size, 0 };
+
+    while (input.pos < input.size)
+    {
+        ret = ZSTD_compressStream(stream_.get(), &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_compressStream failed: " << ZSTD_getErrorName(ret);
+            packet->clear_palette_data();
+            return false;
+        }
+    }
+
+    ret = ZSTD_endStream(stream_.get(), &output);
+    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+    data->resize(output.pos);
+    packet->set_palette_data_size(static_cast<uint32_t>(buffer_.size()));
+    return true;
+}
+
+} // namespace base
@@ -0,0 +1,69 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__PALETTE_ENCODER_H
+#define BASE__CODEC__PALETTE_ENCODER_H
+
+#include "base/macros_magic.h"
+#include "base/codec/scoped_zstd_stream.h"
+#include "base/desktop/region.h"
+#include "base/memory/byte_array.h"
+
+#include <vector>
+
+namespace proto {
+class VideoPacket;
+} // namespace proto
+
+namespace base {
+
+class Frame;
+
+// Sends the areas of the frame with few colors (usually text and simple UI) without loss. Lossy
+// video codecs blur small text at screen bitrates, while a palette with run-length encoding
+// compressed by ZSTD keeps it sharp and small.
+//
+// The uncompressed data is a sequence of blocks. Each block contains:
+//   uint16 x, y, width, height (little-endian);
+//   uint8 number of colors minus one and the colors (uint32 ARGB, little-endian);
+//   pairs of uint8 color index and uint8 run length minus one, which cover the pixels of the block
+//   row by row.
+class PaletteEncoder
+{
+public:
+    PaletteEncoder();
+    ~PaletteEncoder();
+
+    // Removes the blocks of |updated_region| with few colors and adds them to |packet|.
+    void encode(const Frame* frame, Region* updated_region, proto::VideoPacket* packet);
+
+private:
+    bool encodeBlock(const Frame* frame, const Rect& rect);
+    bool compress(proto::VideoPacket* packet);
+
+    ScopedZstdCStream stream_;
+    ByteArray buffer_;
+    std::vector<uint32_t> palette_;
+    std::vector<uint8_t> indexes_;
+
+    DISALLOW_COPY_AND_ASSIGN(PaletteEncoder);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__PALETTE_ENCODER_H
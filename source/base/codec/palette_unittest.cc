@@ -0,0 +1,125 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/palette_decoder.h"
+#include "base/codec/palette_encoder.h"
+
+#include "base/desktop/frame_simple.h"
+#include "proto/desktop.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(100, 70);
+
+bool isEqualRect(const Frame& frame1, const Frame& frame2, const Rect& rect)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+    {
+        if (memcmp(frame1.frameDataAtPos(rect.left(), y), frame2.frameDataAtPos(rect.left(), y),
+                   rect.width() * Frame::kBytesPerPixel) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+TEST(PaletteTest, FewColors)
+{
+    std::unique_ptr<Frame> host_frame = FrameSimple::create(kFrameSize);
+    std::unique_ptr<Frame> client_frame = FrameSimple::create(kFrameSize);
+
+    // Stripes of 3 colors.
+    for (int y = 0; y < kFrameSize.height(); ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(host_frame->frameDataAtPos(0, y));
+
+        for (int x = 0; x < kFrameSize.width(); ++x)
+            row[x] = 0xFF000000 | static_cast<uint32_t>(((x / 3 + y) % 3) * 0x404040);
+    }
+
+    memset(client_frame->frameData(), 0, client_frame->stride() * kFrameSize.height());
+
+    Rect rect = Rect::makeXYWH(5, 3, 90, 60);
+    Region updated_region(rect);
+    proto::VideoPacket packet;
+
+    PaletteEncoder encoder;
+    encoder.encode(host_frame.get(), &updated_region, &packet);
+
+    EXPECT_TRUE(updated_region.isEmpty());
+    EXPECT_FALSE(packet.palette_data().empty());
+
+    PaletteDecoder decoder;
+    ASSERT_TRUE(decoder.decode(packet, client_frame.get()));
+    EXPECT_TRUE(isEqualRect(*host_frame, *client_frame, rect));
+    EXPECT_TRUE(client_frame->constUpdatedRegion().equals(Region(rect)));
+}
+
+TEST(PaletteTest, ManyColors)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+
+    for (int y = 0; y < kFrameSize.height(); ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(0, y));
+
+        for (int x = 0; x < kFrameSize.width(); ++x)
+            row[x] = static_cast<uint32_t>(y * kFrameSize.width() + x);
+    }
+
+    // The top-left block is filled with one color.
+    for (int y = 0; y < 32; ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(0, y));
+
+        for (int x = 0; x < 32; ++x)
+            row[x] = 0xFFFFFFFF;
+    }
+
+    Region updated_region(Rect::makeSize(kFrameSize));
+    proto::VideoPacket packet;
+
+    PaletteEncoder encoder;
+    encoder.encode(frame.get(), &updated_region, &packet);
+
+    Region expected_region(Rect::makeSize(kFrameSize));
+    expected_region.subtract(Rect::makeWH(32, 32));
+    EXPECT_TRUE(updated_region.equals(expected_region));
+}
+
+TEST(PaletteTest, WrongData)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+
+    proto::VideoPacket packet;
+    packet.set_palette_data("wrong data");
+    packet.set_palette_data_size(100);
+
+    PaletteDecoder decoder;
+    EXPECT_FALSE(decoder.decode(packet, frame.get()));
+}
+
+} // namespace base
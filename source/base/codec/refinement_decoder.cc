@@ -0,0 +1,160 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/refinement_decoder.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "proto/desktop.pb.h"
+
+namespace base {
+
+namespace {
+
+// Size of the block header: x, y, width and height.
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kPixelSize = Frame::kBytesPerPixel;
+
+uint16_t readUInt16(const uint8_t* data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+} // namespace
+
+RefinementDecoder::RefinementDecoder()
+    : stream_(ZSTD_createDStream())
+{
+    // Nothing
+}
+
+RefinementDecoder::~RefinementDecoder() = default;
+
+bool RefinementDecoder::decode(const proto::VideoPacket& packet, Frame* frame)
+{
+    if (packet.refinement_data().empty())
+        return true;
+
+    if (!decompress(packet, *frame))
+        return false;
+
+    size_t pos = 0;
+
+    while (pos < buffer_.size())
+    {
+        if (!decodeBlock(&pos, frame))
+            return false;
+    }
+
+    return true;
+}
+
+bool RefinementDecoder::decompress(const proto::VideoPacket& packet, const Frame& frame)
+{
+    const size_t size = packet.refinement_data_size();
+    const std::string& data = packet.refinement_data();
+
+    // Each pixel of the frame is sent once at most, the headers of the blocks are small.
+    const size_t max_size = static_cast<size_t>(frame.size().width()) *
+        static_cast<size_t>(frame.size().height()) * Frame::kBytesPerPixel * 2;
+
+    if (!size || size > max_size)
+    {
+        LOG(LS_ERROR) << "Wrong refinement data size: " << size;
+        return false;
+    }
+
+    buffer_.resize(size);
+
+    size_t ret = ZSTD_initDStream(stream_.get());
+    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+    ZSTD_inBuffer input = { data.data(), data.size(), 0 };
+    ZSTD_outBuffer output = { buffer_.data(), buffer_.size(), 0 };
+
+    while (input.pos < input.size)
+    {
+        ret = ZSTD_decompressStream(stream_.get(), &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_decompressStream failed: " << ZSTD_getErrorName(ret);
+            return false;
+        }
+
+        if (output.pos == output.size && input.pos < input.size)
+        {
+            LOG(LS_ERROR) << "Refinement data is larger than expected";
+            return false;
+        }
+    }
+
+    if (output.pos != size)
+    {
+        LOG(LS_ERROR) << "Refinement data is smaller than expected";
+        return false;
+    }
+
+    return true;
+}
+
+bool RefinementDecoder::decodeBlock(size_t* pos, Frame* frame)
+{
+    if (buffer_.size() - *pos < kHeaderSize)
+    {
+        LOG(LS_ERROR) << "Invalid block header";
+        return false;
+    }
+
+    const uint8_t* header = buffer_.data() + *pos;
+    const Rect rect = Rect::makeXYWH(readUInt16(header), readUInt16(header + 2),
+                                     readUInt16(header + 4), readUInt16(header + 6));
+    *pos += kHeaderSize;
+
+    if (rect.isEmpty() || !Rect::makeSize(frame->size()).containsRect(rect))
+    {
+        LOG(LS_ERROR) << "Wrong block rect";
+        return false;
+    }
+
+    const size_t row_size = static_cast<size_t>(rect.width()) * kPixelSize;
+
+    if ((buffer_.size() - *pos) / row_size < static_cast<size_t>(rect.height()))
+    {
+        LOG(LS_ERROR) << "Block is out of data";
+        return false;
+    }
+
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+    {
+        const uint8_t* source = buffer_.data() + *pos;
+        uint8_t* row = frame->frameDataAtPos(rect.left(), y);
+
+        for (size_t i = 0; i < row_size; ++i)
+        {
+            const uint8_t left = (i < kPixelSize) ? 0 : row[i - kPixelSize];
+            row[i] = static_cast<uint8_t>(source[i] + left);
+        }
+
+        *pos += row_size;
+    }
+
+    frame->updatedRegion()->addRect(rect);
+    return true;
+}
+
+} // namespace base
@@ -0,0 +1,57 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__REFINEMENT_DECODER_H
+#define BASE__CODEC__REFINEMENT_DECODER_H
+
+#include "base/macros_magic.h"
+#include "base/codec/scoped_zstd_stream.h"
+#include "base/memory/byte_array.h"
+
+namespace proto {
+class VideoPacket;
+} // namespace proto
+
+namespace base {
+
+class Frame;
+
+// Draws the blocks sent by RefinementEncoder (see it for the format of the data).
+class RefinementDecoder
+{
+public:
+    RefinementDecoder();
+    ~RefinementDecoder();
+
+    // Must be called after the video packet data is decoded. The drawn blocks are added to the
+    // updated region of |frame|.
+    bool decode(const proto::VideoPacket& packet, Frame* frame);
+
+private:
+    bool decompress(const proto::VideoPacket& packet, const Frame& frame);
+    bool decodeBlock(size_t* pos, Frame* frame);
+
+    ScopedZstdDStream stream_;
+    ByteArray buffer_;
+
+    DISALLOW_COPY_AND_ASSIGN(RefinementDecoder);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__REFINEMENT_DECODER_H
@@ -0,0 +1,259 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/refinement_encoder.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "base/desktop/region.h"
+#include "proto/desktop.pb.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// The frame is divided into blocks of this size aligned to the frame.
+constexpr int kBlockSize = 32;
+constexpr size_t kPixelSize = Frame::kBytesPerPixel;
+
+// A block is refined when it has not changed for this number of frames.
+constexpr uint8_t kStaticFrames = 10;
+constexpr uint8_t kRefinedBlock = 0xFF;
+
+// The compression ratio can be in the range of 1 to 22. The blocks are sent rarely, so a level
+// a bit better than the fastest one is used.
+constexpr int kCompressionRatio = 3;
+
+void writeUInt16(uint16_t value, ByteArray* buffer)
+{
+    buffer->push_back(static_cast<uint8_t>(value & 0xFF));
+    buffer->push_back(static_cast<uint8_t>((value >> 8) & 0xFF));
+}
+
+} // namespace
+
+RefinementEncoder::RefinementEncoder()
+    : stream_(ZSTD_createCStream())
+{
+    static_assert(kStaticFrames < kRefinedBlock);
+    static_assert(kCompressionRatio >= 1 && kCompressionRatio <= 22);
+
+    buffer_.reserve(8 + kBlockSize * kBlockSize * Frame::kBytesPerPixel);
+}
+
+RefinementEncoder::~RefinementEncoder() = default;
+
+void RefinementEncoder::encode(const Frame* frame,
+                               const Region& lossy_region,
+                               const Region& lossless_region,
+                               size_t budget,
+                               proto::VideoPacket* packet)
+{
+    if (frame->size() != size_)
+        reset(frame->size());
+
+    for (auto& block : blocks_)
+    {
+        if (block < kStaticFrames)
+            ++block;
+    }
+
+    // The lossless areas are drawn by the client after the lossy ones.
+    markBlocks(lossy_region, false);
+    markBlocks(lossless_region, true);
+
+    if (!budget || blocks_.empty())
+        return;
+
+    size_t ret = ZSTD_initCStream(stream_.get(), kCompressionRatio);
+    DCHECK(!ZSTD_isError(ret)) << ZSTD_getErrorName(ret);
+
+    size_t output_pos = 0;
+    size_t input_size = 0;
+    size_t last_block = next_block_;
+
+    refined_blocks_.clear();
+
+    for (size_t i = 0; i < blocks_.size() && output_pos < budget; ++i)
+    {
+        const size_t index = (next_block_ + i) % blocks_.size();
+        if (blocks_[index] != kStaticFrames)
+            continue;
+
+        writeBlock(frame, blockRect(index));
+        input_size += buffer_.size();
+
+        if (!compressBlock(packet, &output_pos))
+            return;
+
+        refined_blocks_.emplace_back(index);
+        last_block = index;
+    }
+
+    if (refined_blocks_.empty())
+        return;
+
+    if (!endStream(packet, &output_pos))
+        return;
+
+    packet->mutable_refinement_data()->resize(output_pos);
+    packet->set_refinement_data_size(static_cast<uint32_t>(input_size));
+
+    // The blocks are marked only when the data is in the packet.
+    for (const auto& index : refined_blocks_)
+        blocks_[index] = kRefinedBlock;
+
+    next_block_ = (last_block + 1) % blocks_.size();
+}
+
+bool RefinementEncoder::isComplete() const
+{
+    return std::all_of(blocks_.begin(), blocks_.end(),
+                       [](uint8_t block) { return block == kRefinedBlock; });
+}
+
+void RefinementEncoder::reset(const Size& size)
+{
+    size_ = size;
+    columns_ = (size.width() + kBlockSize - 1) / kBlockSize;
+    rows_ = (size.height() + kBlockSize - 1) / kBlockSize;
+
+    // The client gets the whole frame with the new size, so all the blocks start as changed.
+    blocks_.assign(static_cast<size_t>(columns_) * static_cast<size_t>(rows_), 0);
+    next_block_ = 0;
+}
+
+void RefinementEncoder::markBlocks(const Region& region, bool lossless)
+{
+    const Rect frame_rect = Rect::makeSize(size_);
+
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+    {
+        Rect rect = it.rect();
+        rect.intersectWith(frame_rect);
+        if (rect.isEmpty())
+            continue;
+
+        const int left = rect.left() / kBlockSize;
+        const int top = rect.top() / kBlockSize;
+        const int right = (rect.right() - 1) / kBlockSize;
+        const int bottom = (rect.bottom() - 1) / kBlockSize;
+
+        for (int row = top; row <= bottom; ++row)
+        {
+            for (int column = left; column <= right; ++column)
+            {
+                const size_t index = static_cast<size_t>(row * columns_ + column);
+
+                // A block which is sent entirely without loss does not need the refinement.
+                if (lossless && rect.containsRect(blockRect(index)))
+                    blocks_[index] = kRefinedBlock;
+                else
+                    blocks_[index] = 0;
+            }
+        }
+    }
+}
+
+Rect RefinementEncoder::blockRect(size_t index) const
+{
+    const int column = static_cast<int>(index % static_cast<size_t>(columns_));
+    const int row = static_cast<int>(index / static_cast<size_t>(columns_));
+
+    Rect rect = Rect::makeXYWH(column * kBlockSize, row * kBlockSize, kBlockSize, kBlockSize);
+    rect.intersectWith(Rect::makeSize(size_));
+    return rect;
+}
+
+void RefinementEncoder::writeBlock(const Frame* frame, const Rect& rect)
+{
+    buffer_.clear();
+
+    writeUInt16(static_cast<uint16_t>(rect.x()), &buffer_);
+    writeUInt16(static_cast<uint16_t>(rect.y()), &buffer_);
+    writeUInt16(static_cast<uint16_t>(rect.width()), &buffer_);
+    writeUInt16(static_cast<uint16_t>(rect.height()), &buffer_);
+
+    const size_t row_size = static_cast<size_t>(rect.width()) * kPixelSize;
+
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+    {
+        const uint8_t* row = frame->frameDataAtPos(rect.left(), y);
+
+        for (size_t i = 0; i < row_size; ++i)
+        {
+            const uint8_t left = (i < kPixelSize) ? 0 : row[i - kPixelSize];
+            buffer_.push_back(static_cast<uint8_t>(row[i] - left));
+        }
+    }
+}
+
+bool RefinementEncoder::compressBlock(proto::VideoPacket* packet, size_t* output_pos)
+{
+    std::string* data = packet->mutable_refinement_data();
+    data->resize(*output_pos + ZSTD_compressBound(buffer_.size()));
+
+    ZSTD_inBuffer input = { buffer_.data(), buffer_.size(), 0 };
+    ZSTD_outBuffer output = { data->data(), data->size(), *output_pos };
+
+    while (input.pos < input.size)
+    {
+        size_t ret = ZSTD_compressStream(stream_.get(), &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_compressStream failed: " << ZSTD_getErrorName(ret);
+            packet->clear_refinement_data();
+            return false;
+        }
+    }
+
+    // The data is flushed after each block to know the size of the packet.
+    size_t ret = ZSTD_flushStream(stream_.get(), &output);
+    if (ZSTD_isError(ret) || ret != 0)
+    {
+        LOG(LS_ERROR) << "ZSTD_flushStream failed";
+        packet->clear_refinement_data();
+        return false;
+    }
+
+    *output_pos = output.pos;
+    return true;
+}
+
+bool RefinementEncoder::endStream(proto::VideoPacket* packet, size_t* output_pos)
+{
+    std::string* data = packet->mutable_refinement_data();
+    data->resize(*output_pos + ZSTD_compressBound(0));
+
+    ZSTD_outBuffer output = { data->data(), data->size(), *output_pos };
+
+    size_t ret = ZSTD_endStream(stream_.get(), &output);
+    if (ZSTD_isError(ret) || ret != 0)
+    {
+        LOG(LS_ERROR) << "ZSTD_endStream failed";
+        packet->clear_refinement_data();
+        return false;
+    }
+
+    *output_pos = output.pos;
+    return true;
+}
+
+} // namespace base
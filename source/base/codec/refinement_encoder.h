@@ -0,0 +1,95 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__REFINEMENT_ENCODER_H
+#define BASE__CODEC__REFINEMENT_ENCODER_H
+
+#include "base/macros_magic.h"
+#include "base/codec/scoped_zstd_stream.h"
+#include "base/desktop/geometry.h"
+#include "base/memory/byte_array.h"
+
+#include <vector>
+
+namespace proto {
+class VideoPacket;
+} // namespace proto
+
+namespace base {
+
+class Frame;
+class Region;
+
+// Sends the areas of the frame which stopped changing without loss. A lossy video codec leaves a
+// static area as it was encoded at the last change, so the small details stay blurred until the
+// area changes again. The blocks which have not changed for several frames are sent again in
+// ARGB, a few of them per frame, while the video leaves some bandwidth unused.
+//
+// The uncompressed data is a sequence of blocks. Each block contains:
+//   uint16 x, y, width, height (little-endian);
+//   the pixels of the block row by row (uint32 ARGB, little-endian). Each byte of a pixel is
+//   stored as the difference with the same byte of the pixel on the left (modulo 256), the first
+//   pixel of a row is stored as is.
+class RefinementEncoder
+{
+public:
+    RefinementEncoder();
+    ~RefinementEncoder();
+
+    // Must be called for every frame which is sent. |lossy_region| is the area which the client
+    // gets with loss in this frame, |lossless_region| is the area which is drawn over it without
+    // loss (for example, by PaletteEncoder). Adds the static blocks to |packet| until their
+    // compressed size exceeds |budget| bytes.
+    void encode(const Frame* frame,
+                const Region& lossy_region,
+                const Region& lossless_region,
+                size_t budget,
+                proto::VideoPacket* packet);
+
+    // Returns true if all the blocks have been sent without loss.
+    bool isComplete() const;
+
+private:
+    void reset(const Size& size);
+    void markBlocks(const Region& region, bool lossless);
+    Rect blockRect(size_t index) const;
+    void writeBlock(const Frame* frame, const Rect& rect);
+    bool compressBlock(proto::VideoPacket* packet, size_t* output_pos);
+    bool endStream(proto::VideoPacket* packet, size_t* output_pos);
+
+    ScopedZstdCStream stream_;
+    ByteArray buffer_;
+
+    Size size_;
+    int columns_ = 0;
+    int rows_ = 0;
+
+    // Number of the frames in which each block has not changed (see kStaticFrames) or
+    // kRefinedBlock if the block has been sent without loss.
+    std::vector<uint8_t> blocks_;
+    std::vector<size_t> refined_blocks_;
+
+    // The blocks are refined in turn starting from this one.
+    size_t next_block_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(RefinementEncoder);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__REFINEMENT_ENCODER_H
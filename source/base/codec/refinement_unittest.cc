@@ -0,0 +1,171 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/refinement_decoder.h"
+#include "base/codec/refinement_encoder.h"
+
+#include "base/desktop/frame_simple.h"
+#include "base/desktop/region.h"
+#include "proto/desktop.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(100, 70);
+
+// The number of the frames after which a static block is refined.
+const int kStaticFrames = 10;
+
+void fillFrame(Frame* frame)
+{
+    for (int y = 0; y < frame->size().height(); ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(0, y));
+
+        for (int x = 0; x < frame->size().width(); ++x)
+            row[x] = static_cast<uint32_t>((x * 7919 + y * 104729) ^ (x << 16) ^ (y << 24));
+    }
+}
+
+bool isEqualRect(const Frame& frame1, const Frame& frame2, const Rect& rect)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+    {
+        if (memcmp(frame1.frameDataAtPos(rect.left(), y), frame2.frameDataAtPos(rect.left(), y),
+                   rect.width() * Frame::kBytesPerPixel) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+TEST(RefinementTest, StaticBlocks)
+{
+    std::unique_ptr<Frame> host_frame = FrameSimple::create(kFrameSize);
+    std::unique_ptr<Frame> client_frame = FrameSimple::create(kFrameSize);
+
+    fillFrame(host_frame.get());
+    memset(client_frame->frameData(), 0, client_frame->stride() * kFrameSize.height());
+
+    const Rect frame_rect = Rect::makeSize(kFrameSize);
+    RefinementEncoder encoder;
+    proto::VideoPacket packet;
+
+    encoder.encode(host_frame.get(), Region(frame_rect), Region(), 1024 * 1024, &packet);
+    EXPECT_TRUE(packet.refinement_data().empty());
+    EXPECT_FALSE(encoder.isComplete());
+
+    for (int i = 1; i < kStaticFrames; ++i)
+    {
+        packet.Clear();
+        encoder.encode(host_frame.get(), Region(), Region(), 1024 * 1024, &packet);
+    }
+
+    EXPECT_TRUE(packet.refinement_data().empty());
+
+    packet.Clear();
+    encoder.encode(host_frame.get(), Region(), Region(), 1024 * 1024, &packet);
+    EXPECT_FALSE(packet.refinement_data().empty());
+    EXPECT_TRUE(encoder.isComplete());
+
+    RefinementDecoder decoder;
+    ASSERT_TRUE(decoder.decode(packet, client_frame.get()));
+    EXPECT_TRUE(isEqualRect(*host_frame, *client_frame, frame_rect));
+    EXPECT_TRUE(client_frame->constUpdatedRegion().equals(Region(frame_rect)));
+}
+
+TEST(RefinementTest, ChangedBlocks)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+    fillFrame(frame.get());
+
+    RefinementEncoder encoder;
+    proto::VideoPacket packet;
+
+    // The top-left block changes in every frame, the block on the right is sent without loss.
+    for (int i = 0; i <= kStaticFrames; ++i)
+    {
+        Region lossless_region(Rect::makeXYWH(32, 0, 32, 32));
+        Region lossy_region(Rect::makeWH(40, 10));
+        if (!i)
+            lossy_region.addRect(Rect::makeSize(kFrameSize));
+
+        packet.Clear();
+        encoder.encode(frame.get(), lossy_region, lossless_region, 1024 * 1024, &packet);
+    }
+
+    EXPECT_FALSE(encoder.isComplete());
+
+    std::unique_ptr<Frame> client_frame = FrameSimple::create(kFrameSize);
+    RefinementDecoder decoder;
+    ASSERT_TRUE(decoder.decode(packet, client_frame.get()));
+
+    Region expected_region(Rect::makeSize(kFrameSize));
+    expected_region.subtract(Rect::makeWH(64, 32));
+    EXPECT_TRUE(client_frame->constUpdatedRegion().equals(expected_region));
+}
+
+TEST(RefinementTest, Budget)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+    fillFrame(frame.get());
+
+    RefinementEncoder encoder;
+    proto::VideoPacket packet;
+
+    encoder.encode(frame.get(), Region(Rect::makeSize(kFrameSize)), Region(), 0, &packet);
+    for (int i = 0; i < kStaticFrames; ++i)
+        encoder.encode(frame.get(), Region(), Region(), 0, &packet);
+
+    EXPECT_TRUE(packet.refinement_data().empty());
+
+    // The blocks are sent in several frames.
+    int frames = 0;
+    while (!encoder.isComplete() && frames < 100)
+    {
+        packet.Clear();
+        encoder.encode(frame.get(), Region(), Region(), 1024, &packet);
+        EXPECT_FALSE(packet.refinement_data().empty());
+        EXPECT_LT(packet.refinement_data().size(), 3 * 4096);
+        ++frames;
+    }
+
+    EXPECT_TRUE(encoder.isComplete());
+    EXPECT_GT(frames, 1);
+}
+
+TEST(RefinementTest, WrongData)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+
+    proto::VideoPacket packet;
+    packet.set_refinement_data("wrong data");
+    packet.set_refinement_data_size(100);
+
+    RefinementDecoder decoder;
+    EXPECT_FALSE(decoder.decode(packet, frame.get()));
+}
+
+} // namespace base
@@ -19,26 +19,55 @@
 #include "base/codec/scale_reducer.h"
 
 #include "base/logging.h"
-#include "base/desktop/frame_simple.h"
+#include "base/desktop/frame.h"
+#include "base/threading/thread_pool.h"
+#include "base/trace_event.h"
 
 #include <libyuv/scale_argb.h>
 
+#include <algorithm>
+
 namespace base {
 
-ScaleReducer::ScaleReducer() = default;
+namespace {
+
+// Smaller regions are scaled on the calling thread.
+const int kMinParallelPixels = 256 * 256;
+const int kStripeHeight = 32;
+const size_t kMaxScaleThreads = 4;
+
+// At high frame rates the cheaper bilinear filter is used instead of the box filter.
+const std::chrono::milliseconds kBilinearFrameInterval{ 40 };
+const std::chrono::milliseconds kBoxFrameInterval{ 60 };
+const std::chrono::milliseconds kMaxFrameInterval{ 1000 };
+
+// The frames of the previous target sizes are kept while the scale changes back and forth (for
+// example, when the client window is resized).
+const size_t kFramePoolLimit = 16 * 1024 * 1024;
+
+} // namespace
+
+ScaleReducer::ScaleReducer()
+    : frame_pool_(kFramePoolLimit)
+{
+    // Nothing
+}
 
 ScaleReducer::~ScaleReducer() = default;
 
 const Frame* ScaleReducer::scaleFrame(const Frame* source_frame, const Size& target_size)
 {
+    TRACE_EVENT("codec", "ScaleReducer::scaleFrame");
+
     DCHECK(source_frame);
-    DCHECK(!source_frame->constUpdatedRegion().isEmpty());
 
     const Size& source_size = source_frame->size();
 
     if (source_size_ != source_size || target_size_ != target_size)
     {
-        const_cast<Frame*>(source_frame)->updatedRegion()->addRect(Rect::makeSize(source_size));
+        Frame* frame = const_cast<Frame*>(source_frame);
+        frame->updatedRegion()->addRect(Rect::makeSize(source_size));
+        frame->movedRects()->clear();
 
         scale_x_ = static_cast<double>(target_size.width() * 100.0) /
             static_cast<double>(source_size.width());
@@ -53,6 +82,24 @@ const Frame* ScaleReducer::scaleFrame(const Frame* source_frame, const Size& tar
                      << " scale_x:" << scale_x_ << " scale_y:" << scale_y_ << ")";
     }
 
+    if (invalidated_)
+    {
+        invalidated_ = false;
+
+        if (source_size == target_size)
+        {
+            // The source frame is passed to the encoder as is.
+            Frame* frame = const_cast<Frame*>(source_frame);
+            frame->updatedRegion()->addRect(Rect::makeSize(source_size));
+            frame->movedRects()->clear();
+        }
+        else
+        {
+            // The target frame is created again and is scaled entirely.
+            target_frame_.reset();
+        }
+    }
+
     if (source_size == target_size)
         return source_frame;
 
@@ -60,54 +107,140 @@ const Frame* ScaleReducer::scaleFrame(const Frame* source_frame, const Size& tar
 
     if (!target_frame_)
     {
-        target_frame_ = FrameSimple::create(target_size);
+        target_frame_ = frame_pool_.create(target_size);
         if (!target_frame_)
             return nullptr;
 
         target_frame_->updatedRegion()->addRect(target_frame_rect);
-
-        libyuv::ARGBScale(source_frame->frameData(),
-                          source_frame->stride(),
-                          source_size.width(),
-                          source_size.height(),
-                          target_frame_->frameData(),
-                          target_frame_->stride(),
-                          target_size.width(),
-                          target_size.height(),
-                          libyuv::kFilterBox);
     }
     else
     {
         Region* updated_region = target_frame_->updatedRegion();
         updated_region->clear();
 
-        for (Region::Iterator it(source_frame->constUpdatedRegion());
-             !it.isAtEnd(); it.advance())
+        // Moves can not be scaled exactly, so the moved areas are scaled as updated.
+        Region source_region = source_frame->constUpdatedRegion();
+        for (const auto& moved_rect : source_frame->constMovedRects())
+            source_region.addRect(moved_rect.dest_rect);
+
+        for (Region::Iterator it(source_region); !it.isAtEnd(); it.advance())
         {
             Rect target_rect = scaledRect(it.rect());
             target_rect.intersectWith(target_frame_rect);
 
-            libyuv::ARGBScaleClip(source_frame->frameData(),
-                                  source_frame->stride(),
-                                  source_size.width(),
-                                  source_size.height(),
-                                  target_frame_->frameData(),
-                                  target_frame_->stride(),
-                                  target_size.width(),
-                                  target_size.height(),
-                                  target_rect.x(),
-                                  target_rect.y(),
-                                  target_rect.width(),
-                                  target_rect.height(),
-                                  libyuv::kFilterBox);
-
             updated_region->addRect(target_rect);
         }
     }
 
+    const std::optional<Point>& cursor_position = source_frame->cursorPosition();
+    if (cursor_position.has_value())
+    {
+        target_frame_->setCursorPosition(Point(
+            static_cast<int>(static_cast<double>(cursor_position->x() * scale_x_) / 100.0),
+            static_cast<int>(static_cast<double>(cursor_position->y() * scale_y_) / 100.0)));
+    }
+    else
+    {
+        target_frame_->setCursorPosition(std::nullopt);
+    }
+
+    Rect active_window_rect = source_frame->activeWindowRect();
+    if (!active_window_rect.isEmpty())
+    {
+        active_window_rect = scaledRect(active_window_rect);
+        active_window_rect.intersectWith(target_frame_rect);
+    }
+    target_frame_->setActiveWindowRect(active_window_rect);
+
+    updateFilterMode();
+    scaleRegion(source_frame, target_frame_->constUpdatedRegion());
+
     return target_frame_.get();
 }
 
+void ScaleReducer::updateFilterMode()
+{
+    const Clock::time_point now = Clock::now();
+
+    if (last_frame_time_ != Clock::time_point())
+    {
+        const std::chrono::milliseconds interval =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - last_frame_time_);
+
+        // Smooth the interval so that single slow frames do not switch the filter.
+        avg_frame_interval_ = (avg_frame_interval_ * 7 + std::min(interval, kMaxFrameInterval)) / 8;
+    }
+
+    last_frame_time_ = now;
+
+    // The thresholds are different to avoid switching back and forth at the boundary.
+    if (!bilinear_filter_ && avg_frame_interval_ < kBilinearFrameInterval)
+    {
+        LOG(LS_INFO) << "Bilinear scaling enabled (interval: " << avg_frame_interval_.count()
+                     << "ms)";
+        bilinear_filter_ = true;
+    }
+    else if (bilinear_filter_ && avg_frame_interval_ > kBoxFrameInterval)
+    {
+        LOG(LS_INFO) << "Box scaling enabled (interval: " << avg_frame_interval_.count() << "ms)";
+        bilinear_filter_ = false;
+    }
+}
+
+void ScaleReducer::scaleRegion(const Frame* source_frame, const Region& target_region)
+{
+    const libyuv::FilterMode filter_mode =
+        bilinear_filter_ ? libyuv::kFilterBilinear : libyuv::kFilterBox;
+    Frame* target_frame = target_frame_.get();
+
+    auto scale_rect = [=](const Rect& target_rect)
+    {
+        libyuv::ARGBScaleClip(source_frame->frameData(),
+                              source_frame->stride(),
+                              source_frame->size().width(),
+                              source_frame->size().height(),
+                              target_frame->frameData(),
+                              target_frame->stride(),
+                              target_frame->size().width(),
+                              target_frame->size().height(),
+                              target_rect.x(),
+                              target_rect.y(),
+                              target_rect.width(),
+                              target_rect.height(),
+                              filter_mode);
+    };
+
+    int64_t pixels = 0;
+    for (Region::Iterator it(target_region); !it.isAtEnd(); it.advance())
+        pixels += static_cast<int64_t>(it.rect().width()) * it.rect().height();
+
+    if (pixels < kMinParallelPixels)
+    {
+        for (Region::Iterator it(target_region); !it.isAtEnd(); it.advance())
+            scale_rect(it.rect());
+        return;
+    }
+
+    std::vector<ThreadPool::Task> tasks;
+
+    // Large regions (for example, the first frame) are scaled by stripes on the shared thread
+    // pool. Each stripe of the target frame is scaled from the source frame independently.
+    for (Region::Iterator it(target_region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+
+        for (int top = rect.top(); top < rect.bottom(); top += kStripeHeight)
+        {
+            Rect stripe = Rect::makeLTRB(
+                rect.left(), top, rect.right(), std::min(top + kStripeHeight, rect.bottom()));
+
+            tasks.emplace_back([=]() { scale_rect(stripe); });
+        }
+    }
+
+    ThreadPool::shared()->runTasks(std::move(tasks), kMaxScaleThreads);
+}
+
 Rect ScaleReducer::scaledRect(const Rect& source_rect)
 {
     int left = static_cast<int>(
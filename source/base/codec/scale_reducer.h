@@ -20,13 +20,16 @@
 #define BASE__CODEC__SCALE_REDUCER_H
 
 #include "base/macros_magic.h"
+#include "base/desktop/frame_pool.h"
 #include "base/desktop/geometry.h"
 
+#include <chrono>
 #include <memory>
 
 namespace base {
 
 class Frame;
+class Region;
 
 class ScaleReducer
 {
@@ -36,18 +39,32 @@ public:
 
     const Frame* scaleFrame(const Frame* source_frame, const Size& target_size);
 
+    // The next frame is scaled entirely. It is used when the previous frames were not scaled, so
+    // the updated region of the next frame does not contain all the changes.
+    void invalidate() { invalidated_ = true; }
+
     double scaleFactorX() const { return scale_x_; }
     double scaleFactorY() const { return scale_y_; }
 
 private:
+    using Clock = std::chrono::steady_clock;
+
     Rect scaledRect(const Rect& source_rect);
+    void updateFilterMode();
+    void scaleRegion(const Frame* source_frame, const Region& target_region);
 
+    FramePool frame_pool_;
     std::unique_ptr<Frame> target_frame_;
     Size source_size_;
     Size target_size_;
     double scale_x_ = 0;
     double scale_y_ = 0;
 
+    Clock::time_point last_frame_time_;
+    std::chrono::milliseconds avg_frame_interval_{ 1000 };
+    bool bilinear_filter_ = false;
+    bool invalidated_ = false;
+
     DISALLOW_COPY_AND_ASSIGN(ScaleReducer);
 };
 
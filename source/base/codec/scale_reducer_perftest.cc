@@ -0,0 +1,53 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/scale_reducer.h"
+#include "base/desktop/frame.h"
+#include "base/desktop/screen_fixture.h"
+
+#include <benchmark/benchmark.h>
+
+namespace base {
+
+namespace {
+
+// Scales the frames of the fixture to |state.range(0)| percent of their size.
+void BM_ScaleReducer(benchmark::State& state)
+{
+    const ScreenFixture& fixture = ScreenFixture::shared();
+    const Size target_size(fixture.size().width() * state.range(0) / 100,
+                           fixture.size().height() * state.range(0) / 100);
+
+    ScaleReducer scale_reducer;
+    int index = 0;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(scale_reducer.scaleFrame(fixture.frame(index), target_size));
+
+        if (++index == fixture.frameCount())
+            index = 0;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScaleReducer)->Arg(50)->Arg(67)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+} // namespace base
@@ -89,6 +89,7 @@
 
 #include "base/codec/sinc_resampler.h"
 
+#include "base/codec/vector_math_avx2.h"
 #include "base/logging.h"
 
 #include <cmath>
@@ -96,13 +97,11 @@
 #include <limits>
 
 #if defined(ARCH_CPU_X86_FAMILY)
+#include "base/cpuid_util.h"
+
 #include <xmmintrin.h>
-#define CONVOLVE_FUNC Convolve_SSE
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 #include <arm_neon.h>
-#define CONVOLVE_FUNC Convolve_NEON
-#else
-#define CONVOLVE_FUNC Convolve_C
 #endif
 
 namespace base {
@@ -171,7 +170,8 @@ SincResampler::SincResampler(double io_sample_rate_ratio,
       kernel_window_storage_(static_cast<float*>(alignedAlloc(sizeof(float) * kKernelStorageSize, 16))),
       input_buffer_(static_cast<float*>(alignedAlloc(sizeof(float) * input_buffer_size_, 16))),
       r1_(input_buffer_.get()),
-      r2_(input_buffer_.get() + kKernelSize / 2)
+      r2_(input_buffer_.get() + kKernelSize / 2),
+      convolve_proc_(ConvolveFunction())
 {
     CHECK_GT(request_frames_, 0);
     Flush();
@@ -310,7 +310,7 @@ void SincResampler::Resample(int frames, float* destination)
 
                 // Figure out how much to weight each kernel's "convolution".
                 const double kernel_interpolation_factor = virtual_offset_idx - offset_idx;
-                *destination++ = CONVOLVE_FUNC(input_ptr, k1, k2, kernel_interpolation_factor);
+                *destination++ = convolve_proc_(input_ptr, k1, k2, kernel_interpolation_factor);
 
                 // Advance the virtual index.
                 virtual_source_idx_ += io_sample_rate_ratio_;
@@ -358,6 +358,21 @@ double SincResampler::BufferedFrames() const
     return buffer_primed_ ? request_frames_ - virtual_source_idx_ : 0;
 }
 
+// static
+SincResampler::ConvolveProc SincResampler::ConvolveFunction()
+{
+#if defined(ARCH_CPU_X86_FAMILY)
+    static const bool has_avx2 = CpuidUtil::hasAvx2();
+    if (has_avx2)
+        return Convolve_AVX2;
+    return Convolve_SSE;
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+    return Convolve_NEON;
+#else
+    return Convolve_C;
+#endif
+}
+
 float SincResampler::Convolve_C(const float* input_ptr, const float* k1,
                                 const float* k2,
                                 double kernel_interpolation_factor)
@@ -420,6 +435,14 @@ float SincResampler::Convolve_SSE(const float* input_ptr, const float* k1,
 
     return result;
 }
+
+float SincResampler::Convolve_AVX2(const float* input_ptr, const float* k1,
+                                   const float* k2,
+                                   double kernel_interpolation_factor)
+{
+    static_assert(kKernelSize % 8 == 0);
+    return convolve_AVX2(input_ptr, k1, k2, kKernelSize, kernel_interpolation_factor);
+}
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 float SincResampler::Convolve_NEON(const float* input_ptr, const float* k1,
                                    const float* k2,
@@ -99,9 +99,15 @@ private:
     void InitializeKernel();
     void UpdateRegions(bool second_load);
 
+    using ConvolveProc = float (*)(const float* input_ptr, const float* k1,
+                                   const float* k2, double kernel_interpolation_factor);
+
+    // Returns the fastest convolution function supported by the processor.
+    static ConvolveProc ConvolveFunction();
+
     // Compute convolution of |k1| and |k2| over |input_ptr|, resultant sums are
     // linearly interpolated using |kernel_interpolation_factor|.  On x86, the
-    // underlying implementation is chosen at run time based on SSE support.  On
+    // underlying implementation is chosen at run time based on AVX2 support.  On
     // ARM, NEON support is chosen at compile time based on compilation flags.
     static float Convolve_C(const float* input_ptr, const float* k1,
                             const float* k2, double kernel_interpolation_factor);
@@ -109,6 +115,9 @@ private:
     static float Convolve_SSE(const float* input_ptr, const float* k1,
                               const float* k2,
                               double kernel_interpolation_factor);
+    static float Convolve_AVX2(const float* input_ptr, const float* k1,
+                               const float* k2,
+                               double kernel_interpolation_factor);
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
     static float Convolve_NEON(const float* input_ptr, const float* k1,
                                const float* k2,
@@ -159,6 +168,9 @@ private:
     float* r3_;
     float* r4_;
 
+    // Convolution function selected for the current processor.
+    const ConvolveProc convolve_proc_;
+
     DISALLOW_COPY_AND_ASSIGN(SincResampler);
 };
 
@@ -0,0 +1,140 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/tile_cache_decoder.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "proto/desktop.pb.h"
+
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+// The size of the tile must be the same on the host side.
+constexpr int kTileSize = 64;
+constexpr size_t kTileRowSize = kTileSize * Frame::kBytesPerPixel;
+constexpr size_t kTileDataSize = kTileRowSize * kTileSize;
+
+constexpr size_t kMaxCacheSize = 4096;
+
+bool isValidTile(const proto::VideoTile& tile, const Frame& frame)
+{
+    return Rect::makeSize(frame.size()).containsRect(
+        Rect::makeXYWH(tile.x(), tile.y(), kTileSize, kTileSize));
+}
+
+} // namespace
+
+TileCacheDecoder::TileCacheDecoder() = default;
+
+TileCacheDecoder::~TileCacheDecoder() = default;
+
+bool TileCacheDecoder::reset(size_t cache_size)
+{
+    cache_.clear();
+    order_.clear();
+
+    if (cache_size > kMaxCacheSize)
+    {
+        LOG(LS_ERROR) << "Wrong tile cache size: " << cache_size;
+        cache_size_ = 0;
+        return false;
+    }
+
+    cache_size_ = cache_size;
+    return true;
+}
+
+bool TileCacheDecoder::copyCachedTiles(const proto::VideoPacket& packet, Frame* frame) const
+{
+    for (int i = 0; i < packet.cached_tile_size(); ++i)
+    {
+        const proto::VideoTile& tile = packet.cached_tile(i);
+
+        if (!isValidTile(tile, *frame))
+        {
+            LOG(LS_ERROR) << "Wrong cached tile position";
+            return false;
+        }
+
+        auto cached_tile = cache_.find(tile.hash());
+        if (cached_tile == cache_.end())
+        {
+            LOG(LS_ERROR) << "Tile not found in cache: " << tile.hash();
+            return false;
+        }
+
+        const Rect tile_rect = Rect::makeXYWH(tile.x(), tile.y(), kTileSize, kTileSize);
+
+        frame->copyPixelsFrom(cached_tile->second.get(), kTileRowSize, tile_rect);
+        frame->updatedRegion()->addRect(tile_rect);
+    }
+
+    return true;
+}
+
+bool TileCacheDecoder::storeNewTiles(const proto::VideoPacket& packet, const Frame& frame)
+{
+    if (packet.new_tile_size() && !cache_size_)
+    {
+        LOG(LS_ERROR) << "Host did not send tile cache size";
+        return false;
+    }
+
+    for (int i = 0; i < packet.new_tile_size(); ++i)
+    {
+        const proto::VideoTile& tile = packet.new_tile(i);
+
+        if (!isValidTile(tile, frame))
+        {
+            LOG(LS_ERROR) << "Wrong new tile position";
+            return false;
+        }
+
+        std::unique_ptr<uint8_t[]> data = std::make_unique<uint8_t[]>(kTileDataSize);
+
+        for (int row = 0; row < kTileSize; ++row)
+        {
+            memcpy(data.get() + row * kTileRowSize,
+                   frame.frameDataAtPos(tile.x(), tile.y() + row),
+                   kTileRowSize);
+        }
+
+        if (!cache_.emplace(tile.hash(), std::move(data)).second)
+        {
+            LOG(LS_ERROR) << "Tile is already in cache: " << tile.hash();
+            return false;
+        }
+
+        order_.emplace_back(tile.hash());
+
+        // The host removes the oldest tile in the same way.
+        if (order_.size() > cache_size_)
+        {
+            cache_.erase(order_.front());
+            order_.pop_front();
+        }
+    }
+
+    return true;
+}
+
+} // namespace base
@@ -0,0 +1,66 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__TILE_CACHE_DECODER_H
+#define BASE__CODEC__TILE_CACHE_DECODER_H
+
+#include "base/macros_magic.h"
+
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+namespace proto {
+class VideoPacket;
+} // namespace proto
+
+namespace base {
+
+class Frame;
+
+// Stores the tiles of the frame that the host asks to keep and copies them back to the frame when
+// the host refers to them.
+class TileCacheDecoder
+{
+public:
+    TileCacheDecoder();
+    ~TileCacheDecoder();
+
+    // Clears the cache and sets the maximum number of tiles. If |cache_size| is 0, the cache is
+    // not used.
+    bool reset(size_t cache_size);
+
+    // Copies the cached tiles of |packet| to |frame| and adds them to the updated region of the
+    // frame. Must be called before the packet is decoded.
+    bool copyCachedTiles(const proto::VideoPacket& packet, Frame* frame) const;
+
+    // Adds the new tiles of |packet| from |frame| to the cache. Must be called after the packet is
+    // decoded.
+    bool storeNewTiles(const proto::VideoPacket& packet, const Frame& frame);
+
+private:
+    std::unordered_map<uint32_t, std::unique_ptr<uint8_t[]>> cache_;
+    std::deque<uint32_t> order_;
+    size_t cache_size_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(TileCacheDecoder);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__TILE_CACHE_DECODER_H
@@ -0,0 +1,198 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/tile_cache_encoder.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "proto/desktop.pb.h"
+
+#include <cstring>
+
+#include <libyuv/compare.h>
+
+namespace base {
+
+namespace {
+
+// The size of the tile must be the same on the client side.
+constexpr int kTileSize = 64;
+constexpr size_t kTileRowSize = kTileSize * Frame::kBytesPerPixel;
+constexpr size_t kTileDataSize = kTileRowSize * kTileSize;
+
+// Maximum number of tiles in the cache (32 MB on each side, about 4 screens of 1920x1080).
+constexpr size_t kCacheSize = 2048;
+
+// Recommended seed value for a hash.
+constexpr uint32_t kHashingSeed = 5381;
+
+uint32_t hashTile(const Frame* frame, int x, int y)
+{
+    uint32_t hash = kHashingSeed;
+
+    for (int row = 0; row < kTileSize; ++row)
+        hash = libyuv::HashDjb2(frame->frameDataAtPos(x, y + row), kTileRowSize, hash);
+
+    return hash;
+}
+
+bool isEqualTile(const Frame* frame, int x, int y, const uint8_t* tile)
+{
+    for (int row = 0; row < kTileSize; ++row)
+    {
+        if (memcmp(frame->frameDataAtPos(x, y + row), tile + row * kTileRowSize, kTileRowSize) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+void copyTile(const Frame* frame, int x, int y, uint8_t* tile)
+{
+    for (int row = 0; row < kTileSize; ++row)
+        memcpy(tile + row * kTileRowSize, frame->frameDataAtPos(x, y + row), kTileRowSize);
+}
+
+void addTile(uint32_t hash, int x, int y,
+             google::protobuf::RepeatedPtrField<proto::VideoTile>* list)
+{
+    proto::VideoTile* tile = list->Add();
+    tile->set_hash(hash);
+    tile->set_x(x);
+    tile->set_y(y);
+}
+
+} // namespace
+
+TileCacheEncoder::TileCacheEncoder() = default;
+
+TileCacheEncoder::~TileCacheEncoder() = default;
+
+void TileCacheEncoder::reset(proto::VideoPacket* packet)
+{
+    DCHECK(packet->has_format());
+
+    cache_.clear();
+    order_.clear();
+
+    packet->mutable_format()->set_tile_cache_size(kCacheSize);
+}
+
+void TileCacheEncoder::encode(
+    const Frame* frame, Region* updated_region, proto::VideoPacket* packet)
+{
+    markTiles(frame, *updated_region);
+
+    const int columns = frame->size().width() / kTileSize;
+    const int rows = frame->size().height() / kTileSize;
+
+    // Tiles are looked up only among the tiles that the client already has, the new tiles are
+    // added to the cache after the whole frame is checked.
+    std::vector<std::pair<uint32_t, std::unique_ptr<uint8_t[]>>> new_tiles;
+
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int column = 0; column < columns; ++column)
+        {
+            if (!marked_tiles_[row * columns + column])
+                continue;
+
+            const int x = column * kTileSize;
+            const int y = row * kTileSize;
+            const uint32_t hash = hashTile(frame, x, y);
+
+            auto cached_tile = cache_.find(hash);
+            if (cached_tile != cache_.end())
+            {
+                // Different tiles with the same hash are encoded as usual.
+                if (isEqualTile(frame, x, y, cached_tile->second.get()))
+                {
+                    addTile(hash, x, y, packet->mutable_cached_tile());
+                    updated_region->subtract(Rect::makeXYWH(x, y, kTileSize, kTileSize));
+                }
+                continue;
+            }
+
+            bool is_duplicate = false;
+
+            for (const auto& new_tile : new_tiles)
+            {
+                if (new_tile.first == hash)
+                {
+                    is_duplicate = true;
+                    break;
+                }
+            }
+
+            if (is_duplicate)
+                continue;
+
+            std::unique_ptr<uint8_t[]> tile = std::make_unique<uint8_t[]>(kTileDataSize);
+            copyTile(frame, x, y, tile.get());
+
+            addTile(hash, x, y, packet->mutable_new_tile());
+            new_tiles.emplace_back(hash, std::move(tile));
+        }
+    }
+
+    for (auto& new_tile : new_tiles)
+    {
+        cache_.emplace(new_tile.first, std::move(new_tile.second));
+        order_.emplace_back(new_tile.first);
+
+        // If the current cache size exceeds the maximum cache size, then delete the oldest tile.
+        if (order_.size() > kCacheSize)
+        {
+            cache_.erase(order_.front());
+            order_.pop_front();
+        }
+    }
+}
+
+void TileCacheEncoder::markTiles(const Frame* frame, const Region& updated_region)
+{
+    const int columns = frame->size().width() / kTileSize;
+    const int rows = frame->size().height() / kTileSize;
+
+    marked_tiles_.assign(columns * rows, false);
+
+    // Only whole tiles inside the frame can be cached.
+    const Rect tiles_rect = Rect::makeWH(columns * kTileSize, rows * kTileSize);
+
+    for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+    {
+        Rect rect = it.rect();
+        rect.intersectWith(tiles_rect);
+
+        if (rect.isEmpty())
+            continue;
+
+        const int left = rect.left() / kTileSize;
+        const int top = rect.top() / kTileSize;
+        const int right = (rect.right() - 1) / kTileSize;
+        const int bottom = (rect.bottom() - 1) / kTileSize;
+
+        for (int row = top; row <= bottom; ++row)
+        {
+            for (int column = left; column <= right; ++column)
+                marked_tiles_[row * columns + column] = true;
+        }
+    }
+}
+
+} // namespace base
@@ -0,0 +1,66 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__TILE_CACHE_ENCODER_H
+#define BASE__CODEC__TILE_CACHE_ENCODER_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/region.h"
+
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace proto {
+class VideoPacket;
+} // namespace proto
+
+namespace base {
+
+class Frame;
+
+// Keeps the hashes of the tiles that are stored in the tile cache of the client. When a changed
+// tile of the frame is already in the cache (for example, after switching back to a window), the
+// client copies it from the cache and the tile is not encoded again.
+class TileCacheEncoder
+{
+public:
+    TileCacheEncoder();
+    ~TileCacheEncoder();
+
+    // Clears the cache. The packet must contain the format, the client clears its cache too.
+    void reset(proto::VideoPacket* packet);
+
+    // Adds the tiles of |updated_region| which are in the cache to |packet| and removes them from
+    // |updated_region|. The other tiles are added to |packet| to be stored by the client.
+    void encode(const Frame* frame, Region* updated_region, proto::VideoPacket* packet);
+
+private:
+    void markTiles(const Frame* frame, const Region& updated_region);
+
+    std::unordered_map<uint32_t, std::unique_ptr<uint8_t[]>> cache_;
+    std::deque<uint32_t> order_;
+    std::vector<bool> marked_tiles_;
+
+    DISALLOW_COPY_AND_ASSIGN(TileCacheEncoder);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__TILE_CACHE_ENCODER_H
@@ -0,0 +1,152 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/tile_cache_decoder.h"
+#include "base/codec/tile_cache_encoder.h"
+
+#include "base/desktop/frame_simple.h"
+#include "proto/desktop.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(256, 128);
+
+void fillFrame(Frame* frame, uint32_t value)
+{
+    for (int y = 0; y < frame->size().height(); ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(0, y));
+
+        for (int x = 0; x < frame->size().width(); ++x)
+            row[x] = value + static_cast<uint32_t>(y * frame->size().width() + x);
+    }
+}
+
+bool isEqualFrame(const Frame& frame1, const Frame& frame2)
+{
+    for (int y = 0; y < frame1.size().height(); ++y)
+    {
+        if (memcmp(frame1.frameDataAtPos(0, y), frame2.frameDataAtPos(0, y),
+                   frame1.size().width() * Frame::kBytesPerPixel) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+TEST(TileCacheTest, RepeatedContent)
+{
+    std::unique_ptr<Frame> host_frame = FrameSimple::create(kFrameSize);
+    std::unique_ptr<Frame> client_frame = FrameSimple::create(kFrameSize);
+
+    TileCacheEncoder encoder;
+    TileCacheDecoder decoder;
+
+    // The first frame is stored completely.
+    proto::VideoPacket packet;
+    packet.mutable_format();
+    encoder.reset(&packet);
+
+    fillFrame(host_frame.get(), 0);
+    Region updated_region(Rect::makeSize(kFrameSize));
+    encoder.encode(host_frame.get(), &updated_region, &packet);
+
+    EXPECT_EQ(packet.cached_tile_size(), 0);
+    EXPECT_EQ(packet.new_tile_size(), 8);
+    EXPECT_TRUE(updated_region.equals(Region(Rect::makeSize(kFrameSize))));
+
+    ASSERT_TRUE(decoder.reset(packet.format().tile_cache_size()));
+    ASSERT_TRUE(decoder.copyCachedTiles(packet, client_frame.get()));
+    client_frame->copyPixelsFrom(*host_frame, Point(0, 0), Rect::makeSize(kFrameSize));
+    ASSERT_TRUE(decoder.storeNewTiles(packet, *client_frame));
+
+    // Other content.
+    packet.Clear();
+    fillFrame(host_frame.get(), 12345);
+    updated_region = Region(Rect::makeSize(kFrameSize));
+    encoder.encode(host_frame.get(), &updated_region, &packet);
+
+    EXPECT_EQ(packet.cached_tile_size(), 0);
+    EXPECT_EQ(packet.new_tile_size(), 8);
+
+    ASSERT_TRUE(decoder.copyCachedTiles(packet, client_frame.get()));
+    client_frame->copyPixelsFrom(*host_frame, Point(0, 0), Rect::makeSize(kFrameSize));
+    ASSERT_TRUE(decoder.storeNewTiles(packet, *client_frame));
+
+    // The first content again. All tiles are taken from the cache.
+    packet.Clear();
+    fillFrame(host_frame.get(), 0);
+    updated_region = Region(Rect::makeSize(kFrameSize));
+    encoder.encode(host_frame.get(), &updated_region, &packet);
+
+    EXPECT_EQ(packet.cached_tile_size(), 8);
+    EXPECT_EQ(packet.new_tile_size(), 0);
+    EXPECT_TRUE(updated_region.isEmpty());
+
+    client_frame->updatedRegion()->clear();
+    ASSERT_TRUE(decoder.copyCachedTiles(packet, client_frame.get()));
+    EXPECT_TRUE(isEqualFrame(*host_frame, *client_frame));
+    EXPECT_TRUE(client_frame->constUpdatedRegion().equals(Region(Rect::makeSize(kFrameSize))));
+}
+
+TEST(TileCacheTest, PartialTiles)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(Size(100, 100));
+    fillFrame(frame.get(), 0);
+
+    TileCacheEncoder encoder;
+
+    proto::VideoPacket packet;
+    packet.mutable_format();
+    encoder.reset(&packet);
+
+    // Only one whole tile fits in the frame and only tiles touching the updated region are used.
+    Region updated_region(Rect::makeXYWH(70, 70, 30, 30));
+    encoder.encode(frame.get(), &updated_region, &packet);
+    EXPECT_EQ(packet.new_tile_size(), 0);
+
+    updated_region = Region(Rect::makeXYWH(10, 10, 5, 5));
+    encoder.encode(frame.get(), &updated_region, &packet);
+    ASSERT_EQ(packet.new_tile_size(), 1);
+    EXPECT_EQ(packet.new_tile(0).x(), 0);
+    EXPECT_EQ(packet.new_tile(0).y(), 0);
+}
+
+TEST(TileCacheTest, UnknownTile)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+
+    TileCacheDecoder decoder;
+    ASSERT_TRUE(decoder.reset(16));
+
+    proto::VideoPacket packet;
+    proto::VideoTile* tile = packet.add_cached_tile();
+    tile->set_hash(1);
+
+    EXPECT_FALSE(decoder.copyCachedTiles(packet, frame.get()));
+}
+
+} // namespace base
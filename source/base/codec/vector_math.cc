@@ -18,13 +18,20 @@
 
 #include "base/codec/vector_math.h"
 
+#include "base/codec/vector_math_avx2.h"
 #include "base/logging.h"
 #include "build/build_config.h"
 
+#if defined(ARCH_CPU_X86_FAMILY)
+#include "base/cpuid_util.h"
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
 #include <algorithm>
+#include <cstdlib>
 
 // NaCl does not allow intrinsics.
 #if defined(ARCH_CPU_X86_FAMILY)
+#include <emmintrin.h>
 #include <xmmintrin.h>
 // Don't use custom SSE versions where the auto-vectorized C version performs better, which is
 // anywhere clang is used.
@@ -38,15 +45,18 @@
 #define FMUL_FUNC FMUL_C
 #endif
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_SSE
+#define exceedsThreshold_FUNC exceedsThreshold_SSE2
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 #include <arm_neon.h>
 #define FMAC_FUNC FMAC_NEON
 #define FMUL_FUNC FMUL_NEON
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_NEON
+#define exceedsThreshold_FUNC exceedsThreshold_NEON
 #else
 #define FMAC_FUNC FMAC_C
 #define FMUL_FUNC FMUL_C
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_C
+#define exceedsThreshold_FUNC exceedsThreshold_C
 #endif
 
 namespace base {
@@ -63,6 +73,17 @@ void FMUL_C(const float src[], float scale, int len, float dest[])
         dest[i] = src[i] * scale;
 }
 
+bool exceedsThreshold_C(const int16_t src[], int len, int threshold)
+{
+    for (int i = 0; i < len; ++i)
+    {
+        if (std::abs(static_cast<int>(src[i])) > threshold)
+            return true;
+    }
+
+    return false;
+}
+
 std::pair<float, float> EWMAAndMaxPower_C(
     float initial_value, const float src[], int len, float smoothing_factor)
 {
@@ -120,6 +141,31 @@ void FMAC_SSE(const float src[], float scale, int len, float dest[])
          _mm_cvtss_f32(a) : \
          _mm_cvtss_f32(_mm_shuffle_ps(a, a, i)))
 
+bool exceedsThreshold_SSE2(const int16_t src[], int len, int threshold)
+{
+    if (threshold > 32767)
+        return false;
+
+    const int rem = len % 8;
+    const int last_index = len - rem;
+    const __m128i m_upper = _mm_set1_epi16(static_cast<int16_t>(threshold));
+    const __m128i m_lower = _mm_set1_epi16(static_cast<int16_t>(-threshold));
+
+    for (int i = 0; i < last_index; i += 8)
+    {
+        const __m128i m_src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+        // |x| > threshold is the same as x > threshold or x < -threshold (including -32768).
+        const __m128i m_result = _mm_or_si128(_mm_cmpgt_epi16(m_src, m_upper),
+                                              _mm_cmpgt_epi16(m_lower, m_src));
+        if (_mm_movemask_epi8(m_result))
+            return true;
+    }
+
+    // Handle any remaining values that wouldn't fit in an SSE pass.
+    return exceedsThreshold_C(src + last_index, rem, threshold);
+}
+
 std::pair<float, float> EWMAAndMaxPower_SSE(
     float initial_value, const float src[], int len, float smoothing_factor)
 {
@@ -219,6 +265,31 @@ void FMUL_NEON(const float src[], float scale, int len, float dest[])
         dest[i] = src[i] * scale;
 }
 
+bool exceedsThreshold_NEON(const int16_t src[], int len, int threshold)
+{
+    if (threshold > 32767)
+        return false;
+
+    const int rem = len % 8;
+    const int last_index = len - rem;
+    const int16x8_t m_upper = vdupq_n_s16(static_cast<int16_t>(threshold));
+    const int16x8_t m_lower = vdupq_n_s16(static_cast<int16_t>(-threshold));
+
+    for (int i = 0; i < last_index; i += 8)
+    {
+        const int16x8_t m_src = vld1q_s16(src + i);
+        const uint16x8_t m_result = vorrq_u16(vcgtq_s16(m_src, m_upper),
+                                              vcltq_s16(m_src, m_lower));
+        const uint64x2_t m_result64 = vreinterpretq_u64_u16(m_result);
+
+        if (vgetq_lane_u64(m_result64, 0) | vgetq_lane_u64(m_result64, 1))
+            return true;
+    }
+
+    // Handle any remaining values that wouldn't fit in an NEON pass.
+    return exceedsThreshold_C(src + last_index, rem, threshold);
+}
+
 std::pair<float, float> EWMAAndMaxPower_NEON(
     float initial_value, const float src[], int len, float smoothing_factor)
 {
@@ -291,6 +362,11 @@ void FMAC(const float src[], float scale, int len, float dest[])
     // Ensure |src| and |dest| are 16-byte aligned.
     DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(src) & (kRequiredAlignment - 1));
     DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(dest) & (kRequiredAlignment - 1));
+#if defined(ARCH_CPU_X86_FAMILY)
+    static const bool has_avx2 = CpuidUtil::hasAvx2();
+    if (has_avx2)
+        return FMAC_AVX2(src, scale, len, dest);
+#endif // defined(ARCH_CPU_X86_FAMILY)
     return FMAC_FUNC(src, scale, len, dest);
 }
 
@@ -299,6 +375,11 @@ void FMUL(const float src[], float scale, int len, float dest[])
     // Ensure |src| and |dest| are 16-byte aligned.
     DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(src) & (kRequiredAlignment - 1));
     DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(dest) & (kRequiredAlignment - 1));
+#if defined(ARCH_CPU_X86_FAMILY)
+    static const bool has_avx2 = CpuidUtil::hasAvx2();
+    if (has_avx2)
+        return FMUL_AVX2(src, scale, len, dest);
+#endif // defined(ARCH_CPU_X86_FAMILY)
     return FMUL_FUNC(src, scale, len, dest);
 }
 
@@ -310,6 +391,17 @@ std::pair<float, float> EWMAAndMaxPower(
     return EWMAAndMaxPower_FUNC(initial_value, src, len, smoothing_factor);
 }
 
+bool exceedsThreshold(const int16_t src[], int len, int threshold)
+{
+    DCHECK_GE(threshold, 0);
+#if defined(ARCH_CPU_X86_FAMILY)
+    static const bool has_avx2 = CpuidUtil::hasAvx2();
+    if (has_avx2)
+        return exceedsThreshold_AVX2(src, len, threshold);
+#endif // defined(ARCH_CPU_X86_FAMILY)
+    return exceedsThreshold_FUNC(src, len, threshold);
+}
+
 void crossfade(const float src[], int len, float dest[])
 {
     float cf_ratio = 0;
@@ -19,6 +19,7 @@
 #ifndef BASE_CODEC__VECTOR_MATH_H
 #define BASE_CODEC__VECTOR_MATH_H
 
+#include <cstdint>
 #include <utility>
 
 namespace base {
@@ -44,6 +45,10 @@ void FMUL(const float src[], float scale, int len, float dest[]);
 std::pair<float, float> EWMAAndMaxPower(
     float initial_value, const float src[], int len, float smoothing_factor);
 
+// Returns true if the absolute value of any element of |src| (up to |len|) is greater than
+// |threshold|. |src| does not need to be aligned.
+bool exceedsThreshold(const int16_t src[], int len, int threshold);
+
 void crossfade(const float src[], int len, float dest[]);
 
 } // namespace base
@@ -0,0 +1,119 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/vector_math_avx2.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <immintrin.h>
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+namespace base {
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+void FMAC_AVX2(const float src[], float scale, int len, float dest[])
+{
+    const int last_index = len - len % 8;
+    const __m256 m_scale = _mm256_set1_ps(scale);
+
+    // The buffers are aligned by 16 bytes only, so unaligned loads are used.
+    for (int i = 0; i < last_index; i += 8)
+    {
+        _mm256_storeu_ps(dest + i,
+                         _mm256_add_ps(_mm256_loadu_ps(dest + i),
+                         _mm256_mul_ps(_mm256_loadu_ps(src + i), m_scale)));
+    }
+
+    // Handle any remaining values that wouldn't fit in an AVX pass.
+    for (int i = last_index; i < len; ++i)
+        dest[i] += src[i] * scale;
+}
+
+void FMUL_AVX2(const float src[], float scale, int len, float dest[])
+{
+    const int last_index = len - len % 8;
+    const __m256 m_scale = _mm256_set1_ps(scale);
+
+    for (int i = 0; i < last_index; i += 8)
+        _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), m_scale));
+
+    // Handle any remaining values that wouldn't fit in an AVX pass.
+    for (int i = last_index; i < len; ++i)
+        dest[i] = src[i] * scale;
+}
+
+bool exceedsThreshold_AVX2(const int16_t src[], int len, int threshold)
+{
+    if (threshold > 32767)
+        return false;
+
+    const int last_index = len - len % 16;
+    const __m256i m_upper = _mm256_set1_epi16(static_cast<int16_t>(threshold));
+    const __m256i m_lower = _mm256_set1_epi16(static_cast<int16_t>(-threshold));
+
+    for (int i = 0; i < last_index; i += 16)
+    {
+        const __m256i m_src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+        // |x| > threshold is the same as x > threshold or x < -threshold (including -32768).
+        const __m256i m_result = _mm256_or_si256(_mm256_cmpgt_epi16(m_src, m_upper),
+                                                 _mm256_cmpgt_epi16(m_lower, m_src));
+        if (!_mm256_testz_si256(m_result, m_result))
+            return true;
+    }
+
+    for (int i = last_index; i < len; ++i)
+    {
+        if (src[i] > threshold || src[i] < -threshold)
+            return true;
+    }
+
+    return false;
+}
+
+float convolve_AVX2(const float* input_ptr, const float* k1, const float* k2, int len,
+                    double kernel_interpolation_factor)
+{
+    __m256 m_sums1 = _mm256_setzero_ps();
+    __m256 m_sums2 = _mm256_setzero_ps();
+
+    for (int i = 0; i < len; i += 8)
+    {
+        const __m256 m_input = _mm256_loadu_ps(input_ptr + i);
+        m_sums1 = _mm256_add_ps(m_sums1, _mm256_mul_ps(m_input, _mm256_loadu_ps(k1 + i)));
+        m_sums2 = _mm256_add_ps(m_sums2, _mm256_mul_ps(m_input, _mm256_loadu_ps(k2 + i)));
+    }
+
+    // Linearly interpolate the two "convolutions".
+    m_sums1 = _mm256_mul_ps(
+        m_sums1, _mm256_set1_ps(static_cast<float>(1.0 - kernel_interpolation_factor)));
+    m_sums2 = _mm256_mul_ps(
+        m_sums2, _mm256_set1_ps(static_cast<float>(kernel_interpolation_factor)));
+    m_sums1 = _mm256_add_ps(m_sums1, m_sums2);
+
+    // Sum components together.
+    __m128 m_sum = _mm_add_ps(_mm256_castps256_ps128(m_sums1), _mm256_extractf128_ps(m_sums1, 1));
+    m_sum = _mm_add_ps(_mm_movehl_ps(m_sum, m_sum), m_sum);
+    m_sum = _mm_add_ss(m_sum, _mm_shuffle_ps(m_sum, m_sum, 1));
+
+    return _mm_cvtss_f32(m_sum);
+}
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+} // namespace base
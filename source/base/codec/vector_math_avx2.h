@@ -0,0 +1,44 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__VECTOR_MATH_AVX2_H
+#define BASE__CODEC__VECTOR_MATH_AVX2_H
+
+#include "build/build_config.h"
+
+#include <cstdint>
+
+namespace base {
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+// AVX2 versions of the functions from vector_math.h. The caller must check that the processor
+// supports AVX2.
+void FMAC_AVX2(const float src[], float scale, int len, float dest[]);
+void FMUL_AVX2(const float src[], float scale, int len, float dest[]);
+bool exceedsThreshold_AVX2(const int16_t src[], int len, int threshold);
+
+// Convolution of SincResampler. |len| must be a multiple of 8.
+float convolve_AVX2(const float* input_ptr, const float* k1, const float* k2, int len,
+                    double kernel_interpolation_factor);
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+} // namespace base
+
+#endif // BASE__CODEC__VECTOR_MATH_AVX2_H
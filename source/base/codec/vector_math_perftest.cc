@@ -0,0 +1,92 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/vector_math.h"
+#include "base/memory/aligned_memory.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+
+namespace base {
+
+namespace {
+
+using AlignedFloats = std::unique_ptr<float[], AlignedFreeDeleter>;
+
+// 10 ms of 48 kHz stereo audio.
+const int kSamples = 960;
+const float kScale = 0.5f;
+
+AlignedFloats allocateFloats(int size)
+{
+    AlignedFloats floats(
+        static_cast<float*>(alignedAlloc(sizeof(float) * size, kRequiredAlignment)));
+
+    for (int i = 0; i < size; ++i)
+        floats[i] = std::sin(static_cast<float>(i) * 0.01f);
+
+    return floats;
+}
+
+void BM_FMAC(benchmark::State& state)
+{
+    AlignedFloats src = allocateFloats(kSamples);
+    AlignedFloats dest = allocateFloats(kSamples);
+
+    for (auto _ : state)
+    {
+        FMAC(src.get(), kScale, kSamples, dest.get());
+        benchmark::DoNotOptimize(dest.get());
+    }
+
+    state.SetItemsProcessed(state.iterations() * kSamples);
+}
+BENCHMARK(BM_FMAC);
+
+void BM_FMUL(benchmark::State& state)
+{
+    AlignedFloats src = allocateFloats(kSamples);
+    AlignedFloats dest = allocateFloats(kSamples);
+
+    for (auto _ : state)
+    {
+        FMUL(src.get(), kScale, kSamples, dest.get());
+        benchmark::DoNotOptimize(dest.get());
+    }
+
+    state.SetItemsProcessed(state.iterations() * kSamples);
+}
+BENCHMARK(BM_FMUL);
+
+// Silence: every sample is checked.
+void BM_ExceedsThreshold(benchmark::State& state)
+{
+    std::unique_ptr<int16_t[]> samples = std::make_unique<int16_t[]>(kSamples);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(exceedsThreshold(samples.get(), kSamples, 10));
+
+    state.SetItemsProcessed(state.iterations() * kSamples);
+}
+BENCHMARK(BM_ExceedsThreshold);
+
+} // namespace
+
+} // namespace base
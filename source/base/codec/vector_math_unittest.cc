@@ -0,0 +1,186 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/vector_math.h"
+#include "base/codec/vector_math_avx2.h"
+#include "base/cpuid_util.h"
+#include "base/memory/aligned_memory.h"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <cmath>
+#include <memory>
+
+namespace base {
+
+namespace {
+
+using AlignedFloats = std::unique_ptr<float[], AlignedFreeDeleter>;
+
+// Odd length ensures that the tail of every vector loop is exercised.
+const int kVectorSize = 8191;
+const float kScale = 0.5f;
+
+AlignedFloats allocateFloats(int size)
+{
+    return AlignedFloats(
+        static_cast<float*>(alignedAlloc(sizeof(float) * size, kRequiredAlignment)));
+}
+
+void fillFloats(float* data, int size)
+{
+    for (int i = 0; i < size; ++i)
+        data[i] = std::sin(static_cast<float>(i) * 0.01f);
+}
+
+float convolveReference(const float* input, const float* k1, const float* k2, int len,
+                        double factor)
+{
+    float sum1 = 0;
+    float sum2 = 0;
+
+    for (int i = 0; i < len; ++i)
+    {
+        sum1 += input[i] * k1[i];
+        sum2 += input[i] * k2[i];
+    }
+
+    return static_cast<float>((1.0 - factor) * sum1 + factor * sum2);
+}
+
+} // namespace
+
+TEST(VectorMathTest, FMAC)
+{
+    AlignedFloats src = allocateFloats(kVectorSize);
+    AlignedFloats dest = allocateFloats(kVectorSize);
+
+    fillFloats(src.get(), kVectorSize);
+    fillFloats(dest.get(), kVectorSize);
+
+    FMAC(src.get(), kScale, kVectorSize, dest.get());
+
+    for (int i = 0; i < kVectorSize; ++i)
+        EXPECT_FLOAT_EQ(dest[i], src[i] + src[i] * kScale);
+}
+
+TEST(VectorMathTest, FMUL)
+{
+    AlignedFloats src = allocateFloats(kVectorSize);
+    AlignedFloats dest = allocateFloats(kVectorSize);
+
+    fillFloats(src.get(), kVectorSize);
+
+    FMUL(src.get(), kScale, kVectorSize, dest.get());
+
+    for (int i = 0; i < kVectorSize; ++i)
+        EXPECT_FLOAT_EQ(dest[i], src[i] * kScale);
+}
+
+TEST(VectorMathTest, ExceedsThreshold)
+{
+    int16_t samples[37] = { 0 };
+
+    EXPECT_FALSE(exceedsThreshold(samples, std::size(samples), 0));
+    EXPECT_FALSE(exceedsThreshold(samples, 0, 0));
+
+    // Every position is checked, including the ones handled by the scalar tail.
+    for (size_t i = 0; i < std::size(samples); ++i)
+    {
+        samples[i] = 11;
+        EXPECT_TRUE(exceedsThreshold(samples, std::size(samples), 10)) << i;
+        EXPECT_FALSE(exceedsThreshold(samples, std::size(samples), 11)) << i;
+
+        samples[i] = -11;
+        EXPECT_TRUE(exceedsThreshold(samples, std::size(samples), 10)) << i;
+        EXPECT_FALSE(exceedsThreshold(samples, std::size(samples), 11)) << i;
+
+        samples[i] = 0;
+    }
+
+    samples[5] = -32768;
+    EXPECT_TRUE(exceedsThreshold(samples, std::size(samples), 32767));
+    EXPECT_FALSE(exceedsThreshold(samples, std::size(samples), 32768));
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+TEST(VectorMathTest, AVX2)
+{
+    if (!CpuidUtil::hasAvx2())
+        return;
+
+    AlignedFloats src = allocateFloats(kVectorSize);
+    AlignedFloats dest = allocateFloats(kVectorSize);
+
+    fillFloats(src.get(), kVectorSize);
+    fillFloats(dest.get(), kVectorSize);
+
+    FMAC_AVX2(src.get(), kScale, kVectorSize, dest.get());
+    for (int i = 0; i < kVectorSize; ++i)
+        EXPECT_FLOAT_EQ(dest[i], src[i] + src[i] * kScale);
+
+    FMUL_AVX2(src.get(), kScale, kVectorSize, dest.get());
+    for (int i = 0; i < kVectorSize; ++i)
+        EXPECT_FLOAT_EQ(dest[i], src[i] * kScale);
+
+    int16_t samples[37] = { 0 };
+    EXPECT_FALSE(exceedsThreshold_AVX2(samples, std::size(samples), 0));
+
+    for (size_t i = 0; i < std::size(samples); ++i)
+    {
+        samples[i] = -32768;
+        EXPECT_TRUE(exceedsThreshold_AVX2(samples, std::size(samples), 32767)) << i;
+        EXPECT_FALSE(exceedsThreshold_AVX2(samples, std::size(samples), 32768)) << i;
+        samples[i] = 0;
+    }
+}
+
+TEST(VectorMathTest, ConvolveAVX2)
+{
+    if (!CpuidUtil::hasAvx2())
+        return;
+
+    static const int kKernelSize = 32;
+
+    AlignedFloats input = allocateFloats(kKernelSize + 1);
+    AlignedFloats k1 = allocateFloats(kKernelSize);
+    AlignedFloats k2 = allocateFloats(kKernelSize);
+
+    fillFloats(input.get(), kKernelSize + 1);
+    for (int i = 0; i < kKernelSize; ++i)
+    {
+        k1[i] = static_cast<float>(i) / kKernelSize;
+        k2[i] = 1.0f - k1[i];
+    }
+
+    // The input of the resampler is not always aligned.
+    for (int offset = 0; offset < 2; ++offset)
+    {
+        const float* input_ptr = input.get() + offset;
+
+        EXPECT_NEAR(convolve_AVX2(input_ptr, k1.get(), k2.get(), kKernelSize, 0.25),
+                    convolveReference(input_ptr, k1.get(), k2.get(), kKernelSize, 0.25),
+                    1e-5);
+    }
+}
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+} // namespace base
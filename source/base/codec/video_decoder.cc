@@ -18,20 +18,35 @@
 
 #include "base/codec/video_decoder.h"
 
+#include "base/codec/video_decoder_aom.h"
 #include "base/codec/video_decoder_vpx.h"
+#include "build/build_config.h"
+
+#if defined(OS_WIN)
+#include "base/codec/video_decoder_mf.h"
+#endif // defined(OS_WIN)
 
 namespace base {
 
 // static
-std::unique_ptr<VideoDecoder> VideoDecoder::create(proto::VideoEncoding encoding)
+std::unique_ptr<VideoDecoder> VideoDecoder::create(proto::VideoEncoding encoding,
+                                                   uint32_t threads)
 {
     switch (encoding)
     {
         case proto::VIDEO_ENCODING_VP8:
-            return VideoDecoderVPX::createVP8();
+            return VideoDecoderVPX::createVP8(threads);
 
         case proto::VIDEO_ENCODING_VP9:
-            return VideoDecoderVPX::createVP9();
+            return VideoDecoderVPX::createVP9(threads);
+
+        case proto::VIDEO_ENCODING_AV1:
+            return VideoDecoderAOM::createAV1(threads);
+
+#if defined(OS_WIN)
+        case proto::VIDEO_ENCODING_H264:
+            return VideoDecoderMF::createH264();
+#endif // defined(OS_WIN)
 
         default:
             return nullptr;
@@ -32,7 +32,9 @@ class VideoDecoder
 public:
     virtual ~VideoDecoder() = default;
 
-    static std::unique_ptr<VideoDecoder> create(proto::VideoEncoding encoding);
+    // |threads| limits the number of the threads of the codec. If it is 0, the codec chooses it.
+    static std::unique_ptr<VideoDecoder> create(proto::VideoEncoding encoding,
+                                                uint32_t threads = 0);
 
     virtual bool decode(const proto::VideoPacket& packet, Frame* frame) = 0;
 };
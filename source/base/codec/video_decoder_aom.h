@@ -0,0 +1,48 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__VIDEO_DECODER_AOM_H
+#define BASE__CODEC__VIDEO_DECODER_AOM_H
+
+#include "base/macros_magic.h"
+#include "base/codec/scoped_aom_codec.h"
+#include "base/codec/video_decoder.h"
+
+namespace base {
+
+class VideoDecoderAOM : public VideoDecoder
+{
+public:
+    ~VideoDecoderAOM() override = default;
+
+    // See VideoDecoder::create for |threads|.
+    static std::unique_ptr<VideoDecoderAOM> createAV1(uint32_t threads = 0);
+
+    bool decode(const proto::VideoPacket& packet, Frame* frame) override;
+
+private:
+    explicit VideoDecoderAOM(uint32_t threads);
+
+    ScopedAomCodec codec_;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoDecoderAOM);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__VIDEO_DECODER_AOM_H
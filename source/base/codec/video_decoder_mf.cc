@@ -0,0 +1,357 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/video_decoder_mf.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+
+#include <libyuv/convert_argb.h>
+
+#include <codecapi.h>
+#include <mfapi.h>
+#include <mferror.h>
+
+using Microsoft::WRL::ComPtr;
+
+namespace base {
+
+VideoDecoderMF::VideoDecoderMF()
+    : mf_started_(SUCCEEDED(MFStartup(MF_VERSION, MFSTARTUP_LITE)))
+{
+    // Nothing
+}
+
+VideoDecoderMF::~VideoDecoderMF()
+{
+    transform_.Reset();
+
+    if (mf_started_)
+        MFShutdown();
+}
+
+// static
+std::unique_ptr<VideoDecoderMF> VideoDecoderMF::createH264()
+{
+    std::unique_ptr<VideoDecoderMF> decoder(new VideoDecoderMF());
+    if (!decoder->initialize())
+        return nullptr;
+
+    return decoder;
+}
+
+bool VideoDecoderMF::decode(const proto::VideoPacket& packet, Frame* frame)
+{
+    if (packet.data().empty())
+    {
+        LOG(LS_WARNING) << "Empty video packet";
+        return false;
+    }
+
+    ComPtr<IMFMediaBuffer> buffer;
+
+    HRESULT hr = MFCreateMemoryBuffer(static_cast<DWORD>(packet.data().size()),
+                                      buffer.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "MFCreateMemoryBuffer failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    BYTE* data = nullptr;
+
+    hr = buffer->Lock(&data, nullptr, nullptr);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFMediaBuffer::Lock failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    memcpy(data, packet.data().data(), packet.data().size());
+    buffer->Unlock();
+    buffer->SetCurrentLength(static_cast<DWORD>(packet.data().size()));
+
+    ComPtr<IMFSample> sample;
+
+    hr = MFCreateSample(sample.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "MFCreateSample failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    sample->AddBuffer(buffer.Get());
+
+    hr = transform_->ProcessInput(0, sample.Get(), 0);
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "IMFTransform::ProcessInput failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    bool is_decoded = false;
+
+    // In the low latency mode each packet gives one picture. We take all the available output to
+    // be sure that the decoder does not fall behind.
+    while (true)
+    {
+        MFT_OUTPUT_STREAM_INFO stream_info;
+        memset(&stream_info, 0, sizeof(stream_info));
+
+        hr = transform_->GetOutputStreamInfo(0, &stream_info);
+        if (FAILED(hr))
+        {
+            LOG(LS_ERROR) << "IMFTransform::GetOutputStreamInfo failed: "
+                          << SystemError(hr).toString();
+            return false;
+        }
+
+        ComPtr<IMFSample> output_sample;
+        ComPtr<IMFMediaBuffer> output_buffer;
+
+        if (!(stream_info.dwFlags & MFT_OUTPUT_STREAM_PROVIDES_SAMPLES))
+        {
+            hr = MFCreateMemoryBuffer(stream_info.cbSize, output_buffer.GetAddressOf());
+            if (FAILED(hr))
+            {
+                LOG(LS_ERROR) << "MFCreateMemoryBuffer failed: " << SystemError(hr).toString();
+                return false;
+            }
+
+            hr = MFCreateSample(output_sample.GetAddressOf());
+            if (FAILED(hr))
+            {
+                LOG(LS_ERROR) << "MFCreateSample failed: " << SystemError(hr).toString();
+                return false;
+            }
+
+            output_sample->AddBuffer(output_buffer.Get());
+        }
+
+        MFT_OUTPUT_DATA_BUFFER output;
+        memset(&output, 0, sizeof(output));
+        output.pSample = output_sample.Get();
+
+        DWORD status = 0;
+        hr = transform_->ProcessOutput(0, 1, &output, &status);
+
+        if (output.pEvents)
+            output.pEvents->Release();
+
+        if (!output_sample && output.pSample)
+        {
+            // The transform allocated the sample, we take ownership of it.
+            output_sample.Attach(output.pSample);
+        }
+
+        if (hr == MF_E_TRANSFORM_NEED_MORE_INPUT)
+            break;
+
+        if (hr == MF_E_TRANSFORM_STREAM_CHANGE)
+        {
+            // The decoder has parsed the stream parameters (for example, the picture size).
+            if (!setOutputType())
+                return false;
+
+            continue;
+        }
+
+        if (FAILED(hr))
+        {
+            LOG(LS_WARNING) << "IMFTransform::ProcessOutput failed: "
+                            << SystemError(hr).toString();
+            return false;
+        }
+
+        if (!output_sample || !convertImage(output_sample.Get(), frame))
+            return false;
+
+        is_decoded = true;
+    }
+
+    if (!is_decoded)
+    {
+        LOG(LS_WARNING) << "No video frame decoded";
+        return false;
+    }
+
+    return true;
+}
+
+bool VideoDecoderMF::initialize()
+{
+    if (!mf_started_)
+    {
+        LOG(LS_ERROR) << "Media Foundation is not initialized";
+        return false;
+    }
+
+    MFT_REGISTER_TYPE_INFO input_info = { MFMediaType_Video, MFVideoFormat_H264 };
+    MFT_REGISTER_TYPE_INFO output_info = { MFMediaType_Video, MFVideoFormat_NV12 };
+
+    IMFActivate** activates = nullptr;
+    UINT32 count = 0;
+
+    HRESULT hr = MFTEnumEx(MFT_CATEGORY_VIDEO_DECODER,
+                           MFT_ENUM_FLAG_SYNCMFT | MFT_ENUM_FLAG_SORTANDFILTER,
+                           &input_info,
+                           &output_info,
+                           &activates,
+                           &count);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "MFTEnumEx failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    for (UINT32 i = 0; i < count; ++i)
+    {
+        if (!transform_)
+            activates[i]->ActivateObject(IID_PPV_ARGS(transform_.GetAddressOf()));
+
+        activates[i]->Release();
+    }
+
+    CoTaskMemFree(activates);
+
+    if (!transform_)
+    {
+        LOG(LS_ERROR) << "No H.264 decoders";
+        return false;
+    }
+
+    ComPtr<IMFAttributes> attributes;
+    if (SUCCEEDED(transform_->GetAttributes(attributes.GetAddressOf())))
+        attributes->SetUINT32(CODECAPI_AVLowLatencyMode, TRUE);
+
+    ComPtr<IMFMediaType> input_type;
+
+    hr = MFCreateMediaType(input_type.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "MFCreateMediaType failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    input_type->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+    input_type->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_H264);
+    input_type->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+
+    hr = transform_->SetInputType(0, input_type.Get(), 0);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "Unable to set input type: " << SystemError(hr).toString();
+        return false;
+    }
+
+    if (!setOutputType())
+        return false;
+
+    transform_->ProcessMessage(MFT_MESSAGE_NOTIFY_BEGIN_STREAMING, 0);
+    transform_->ProcessMessage(MFT_MESSAGE_NOTIFY_START_OF_STREAM, 0);
+    return true;
+}
+
+bool VideoDecoderMF::setOutputType()
+{
+    for (DWORD i = 0;; ++i)
+    {
+        ComPtr<IMFMediaType> output_type;
+
+        HRESULT hr = transform_->GetOutputAvailableType(0, i, output_type.GetAddressOf());
+        if (FAILED(hr))
+        {
+            LOG(LS_ERROR) << "Decoder has no NV12 output: " << SystemError(hr).toString();
+            return false;
+        }
+
+        GUID subtype;
+        if (FAILED(output_type->GetGUID(MF_MT_SUBTYPE, &subtype)) || subtype != MFVideoFormat_NV12)
+            continue;
+
+        hr = transform_->SetOutputType(0, output_type.Get(), 0);
+        if (FAILED(hr))
+        {
+            LOG(LS_ERROR) << "Unable to set output type: " << SystemError(hr).toString();
+            return false;
+        }
+
+        UINT32 width = 0;
+        UINT32 height = 0;
+        MFGetAttributeSize(output_type.Get(), MF_MT_FRAME_SIZE, &width, &height);
+
+        UINT32 stride = 0;
+        if (FAILED(output_type->GetUINT32(MF_MT_DEFAULT_STRIDE, &stride)))
+            stride = width;
+
+        image_size_ = Size(static_cast<int>(width), static_cast<int>(height));
+        image_stride_ = static_cast<int>(stride);
+        return true;
+    }
+}
+
+bool VideoDecoderMF::convertImage(IMFSample* sample, Frame* frame)
+{
+    if (image_size_.width() < frame->size().width() ||
+        image_size_.height() < frame->size().height())
+    {
+        LOG(LS_WARNING) << "Size of the encoded frame doesn't match size in the header";
+        return false;
+    }
+
+    ComPtr<IMFMediaBuffer> buffer;
+
+    HRESULT hr = sample->ConvertToContiguousBuffer(buffer.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFSample::ConvertToContiguousBuffer failed: "
+                      << SystemError(hr).toString();
+        return false;
+    }
+
+    BYTE* data = nullptr;
+    DWORD length = 0;
+
+    hr = buffer->Lock(&data, nullptr, &length);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFMediaBuffer::Lock failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    const size_t y_size = static_cast<size_t>(image_stride_) * image_size_.height();
+    if (length < y_size + y_size / 2)
+    {
+        buffer->Unlock();
+        LOG(LS_WARNING) << "Decoded picture is too small: " << length;
+        return false;
+    }
+
+    // The encoder may improve unchanged areas of the picture, so the whole frame is updated.
+    libyuv::NV12ToARGB(data, image_stride_,
+                       data + y_size, image_stride_,
+                       frame->frameData(),
+                       frame->stride(),
+                       frame->size().width(),
+                       frame->size().height());
+
+    buffer->Unlock();
+    return true;
+}
+
+} // namespace base
@@ -0,0 +1,64 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__VIDEO_DECODER_MF_H
+#define BASE__CODEC__VIDEO_DECODER_MF_H
+
+#include "base/macros_magic.h"
+#include "base/codec/video_decoder.h"
+#include "base/desktop/geometry.h"
+
+#include <mftransform.h>
+#include <wrl/client.h>
+
+namespace base {
+
+// H.264 decoder which uses a Media Foundation transform. The decoded NV12 picture is converted to
+// the frame on the CPU.
+class VideoDecoderMF : public VideoDecoder
+{
+public:
+    ~VideoDecoderMF() override;
+
+    // Returns nullptr if there is no H.264 decoder in the system (for example, in "N" editions of
+    // Windows without the Media Feature Pack).
+    static std::unique_ptr<VideoDecoderMF> createH264();
+
+    bool decode(const proto::VideoPacket& packet, Frame* frame) override;
+
+private:
+    VideoDecoderMF();
+
+    bool initialize();
+    bool setOutputType();
+    bool convertImage(IMFSample* sample, Frame* frame);
+
+    const bool mf_started_;
+    Microsoft::WRL::ComPtr<IMFTransform> transform_;
+
+    // Size and stride of the decoded picture. The size may be aligned to the macroblock size and be
+    // larger than the frame size.
+    Size image_size_;
+    int image_stride_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoDecoderMF);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__VIDEO_DECODER_MF_H
@@ -26,15 +26,23 @@
 
 #define VPX_CODEC_DISABLE_COMPAT 1
 #include <vpx/vpx_decoder.h>
+#include <vpx/vpx_frame_buffer.h>
 #include <vpx/vp8dx.h>
 
+#include <algorithm>
+#include <thread>
+
 namespace base {
 
 namespace {
 
+const unsigned int kMaxDecoderThreads = 8;
+
 bool convertImage(const proto::VideoPacket& packet, vpx_image_t* image, Frame* frame)
 {
-    if (image->fmt != VPX_IMG_FMT_I420)
+    // The host sends I444 (VP9 profile 1) if the client asked for the full chroma.
+    const bool full_chroma = (image->fmt == VPX_IMG_FMT_I444);
+    if (image->fmt != VPX_IMG_FMT_I420 && !full_chroma)
         return false;
 
     Rect frame_rect = Rect::makeSize(frame->size());
@@ -54,11 +62,27 @@ bool convertImage(const proto::VideoPacket& packet, vpx_image_t* image, Frame* f
 
         if (!frame_rect.containsRect(rect))
         {
-            LOG(LS_WARNING) << "The rectangle is outside the screen area";
+            LOG_EVERY_T(LS_WARNING, std::chrono::seconds(1))
+                << "The rectangle is outside the screen area";
             return false;
         }
 
         int y_offset = y_stride * rect.y() + rect.x();
+
+        if (full_chroma)
+        {
+            int uv_offset = uv_stride * rect.y() + rect.x();
+
+            libyuv::I444ToARGB(y_data + y_offset, y_stride,
+                               u_data + uv_offset, uv_stride,
+                               v_data + uv_offset, uv_stride,
+                               frame->frameDataAtPos(rect.topLeft()),
+                               frame->stride(),
+                               rect.width(),
+                               rect.height());
+            continue;
+        }
+
         int uv_offset = uv_stride * rect.y() / 2 + rect.x() / 2;
 
         libyuv::I420ToARGB(y_data + y_offset, y_stride,
@@ -76,18 +100,20 @@ bool convertImage(const proto::VideoPacket& packet, vpx_image_t* image, Frame* f
 } // namespace
 
 // static
-std::unique_ptr<VideoDecoderVPX> VideoDecoderVPX::createVP8()
+std::unique_ptr<VideoDecoderVPX> VideoDecoderVPX::createVP8(uint32_t threads)
 {
-    return std::unique_ptr<VideoDecoderVPX>(new VideoDecoderVPX(proto::VIDEO_ENCODING_VP8));
+    return std::unique_ptr<VideoDecoderVPX>(
+        new VideoDecoderVPX(proto::VIDEO_ENCODING_VP8, threads));
 }
 
 // static
-std::unique_ptr<VideoDecoderVPX> VideoDecoderVPX::createVP9()
+std::unique_ptr<VideoDecoderVPX> VideoDecoderVPX::createVP9(uint32_t threads)
 {
-    return std::unique_ptr<VideoDecoderVPX>(new VideoDecoderVPX(proto::VIDEO_ENCODING_VP9));
+    return std::unique_ptr<VideoDecoderVPX>(
+        new VideoDecoderVPX(proto::VIDEO_ENCODING_VP9, threads));
 }
 
-VideoDecoderVPX::VideoDecoderVPX(proto::VideoEncoding encoding)
+VideoDecoderVPX::VideoDecoderVPX(proto::VideoEncoding encoding, uint32_t threads)
 {
     codec_.reset(new vpx_codec_ctx_t());
 
@@ -95,7 +121,11 @@ VideoDecoderVPX::VideoDecoderVPX(proto::VideoEncoding encoding)
 
     config.w = 0;
     config.h = 0;
-    config.threads = 2;
+    // VP9 decodes tile columns in parallel (the encoder makes up to one column per thread of the
+    // host) and row based multithreading spreads the loop filter too.
+    if (!threads)
+        threads = std::thread::hardware_concurrency();
+    config.threads = std::clamp(threads, 1U, kMaxDecoderThreads);
 
     vpx_codec_iface_t* algo;
 
@@ -116,6 +146,64 @@ VideoDecoderVPX::VideoDecoderVPX(proto::VideoEncoding encoding)
 
     int ret = vpx_codec_dec_init(codec_.get(), algo, &config, 0);
     CHECK_EQ(ret, VPX_CODEC_OK);
+
+    if (encoding == proto::VIDEO_ENCODING_VP9)
+    {
+        ret = vpx_codec_control(codec_.get(), VP9D_SET_ROW_MT, 1);
+        DCHECK_EQ(ret, VPX_CODEC_OK);
+
+        // Only VP9 supports the external frame buffers. If they can not be set, the decoder uses
+        // its own buffers.
+        ret = vpx_codec_set_frame_buffer_functions(
+            codec_.get(), &VideoDecoderVPX::getFrameBuffer, &VideoDecoderVPX::releaseFrameBuffer,
+            this);
+        if (ret != VPX_CODEC_OK)
+            LOG(LS_WARNING) << "vpx_codec_set_frame_buffer_functions failed: " << ret;
+    }
+}
+
+// static
+int VideoDecoderVPX::getFrameBuffer(void* priv, size_t min_size, vpx_codec_frame_buffer_t* fb)
+{
+    VideoDecoderVPX* self = static_cast<VideoDecoderVPX*>(priv);
+
+    FrameBuffer* buffer = nullptr;
+
+    for (const auto& frame_buffer : self->frame_buffers_)
+    {
+        if (!frame_buffer->in_use)
+        {
+            buffer = frame_buffer.get();
+            break;
+        }
+    }
+
+    if (!buffer)
+    {
+        self->frame_buffers_.emplace_back(std::make_unique<FrameBuffer>());
+        buffer = self->frame_buffers_.back().get();
+    }
+
+    // The decoder requires the new memory to be zeroed. The reused memory keeps the previous
+    // pictures, the same as with the buffers of the decoder itself.
+    if (buffer->data.size() < min_size)
+        buffer->data.resize(min_size);
+
+    buffer->in_use = true;
+
+    fb->data = buffer->data.data();
+    fb->size = buffer->data.size();
+    fb->priv = buffer;
+    return 0;
+}
+
+// static
+int VideoDecoderVPX::releaseFrameBuffer(void* /* priv */, vpx_codec_frame_buffer_t* fb)
+{
+    FrameBuffer* buffer = static_cast<FrameBuffer*>(fb->priv);
+    if (buffer)
+        buffer->in_use = false;
+    return 0;
 }
 
 bool VideoDecoderVPX::decode(const proto::VideoPacket& packet, Frame* frame)
@@ -132,8 +220,9 @@ bool VideoDecoderVPX::decode(const proto::VideoPacket& packet, Frame* frame)
         const char* error = vpx_codec_error(codec_.get());
         const char* error_detail = vpx_codec_error_detail(codec_.get());
 
-        LOG(LS_WARNING) << "Decoding failed: " << (error ? error : "(NULL)") << "\n"
-                        << "Details: " << (error_detail ? error_detail : "(NULL)");
+        LOG_EVERY_T(LS_WARNING, std::chrono::seconds(1))
+            << "Decoding failed: " << (error ? error : "(NULL)") << "\n"
+            << "Details: " << (error_detail ? error_detail : "(NULL)");
         return false;
     }
 
@@ -143,13 +232,14 @@ bool VideoDecoderVPX::decode(const proto::VideoPacket& packet, Frame* frame)
     vpx_image_t* image = vpx_codec_get_frame(codec_.get(), &iter);
     if (!image)
     {
-        LOG(LS_WARNING) << "No video frame decoded";
+        LOG_EVERY_T(LS_WARNING, std::chrono::seconds(1)) << "No video frame decoded";
         return false;
     }
 
     if (base::Size(image->d_w, image->d_h) != frame->size())
     {
-        LOG(LS_WARNING) << "Size of the encoded frame doesn't match size in the header";
+        LOG_EVERY_T(LS_WARNING, std::chrono::seconds(1))
+            << "Size of the encoded frame doesn't match size in the header";
         return false;
     }
 
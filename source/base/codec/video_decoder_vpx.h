@@ -22,6 +22,14 @@
 #include "base/macros_magic.h"
 #include "base/codec/scoped_vpx_codec.h"
 #include "base/codec/video_decoder.h"
+#include "base/memory/byte_array.h"
+
+#include <vector>
+
+extern "C"
+{
+typedef struct vpx_codec_frame_buffer vpx_codec_frame_buffer_t;
+}
 
 namespace base {
 
@@ -30,13 +38,29 @@ class VideoDecoderVPX : public VideoDecoder
 public:
     ~VideoDecoderVPX() = default;
 
-    static std::unique_ptr<VideoDecoderVPX> createVP8();
-    static std::unique_ptr<VideoDecoderVPX> createVP9();
+    // See VideoDecoder::create for |threads|.
+    static std::unique_ptr<VideoDecoderVPX> createVP8(uint32_t threads = 0);
+    static std::unique_ptr<VideoDecoderVPX> createVP9(uint32_t threads = 0);
 
     bool decode(const proto::VideoPacket& packet, Frame* frame) override;
 
 private:
-    explicit VideoDecoderVPX(proto::VideoEncoding encoding);
+    VideoDecoderVPX(proto::VideoEncoding encoding, uint32_t threads);
+
+    struct FrameBuffer
+    {
+        ByteArray data;
+        bool in_use = false;
+    };
+
+    // Callbacks of the external frame buffers of VP9 (|priv| is the decoder).
+    static int getFrameBuffer(void* priv, size_t min_size, vpx_codec_frame_buffer_t* fb);
+    static int releaseFrameBuffer(void* priv, vpx_codec_frame_buffer_t* fb);
+
+    // VP9 decodes into the buffers of the pool instead of its own ones. The buffers are not freed
+    // while the decoder exists and keep their capacity when the size of the video changes. The
+    // codec releases its buffers when it is destroyed, so the pool is destroyed after it.
+    std::vector<std::unique_ptr<FrameBuffer>> frame_buffers_;
 
     ScopedVpxCodec codec_;
 
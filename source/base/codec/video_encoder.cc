@@ -19,15 +19,68 @@
 #include "base/codec/video_encoder.h"
 
 #include "base/desktop/frame.h"
+#include "base/threading/thread_pool.h"
+
+#include <libyuv/convert.h>
+#include <libyuv/convert_from_argb.h>
+
+#include <algorithm>
 
 namespace base {
 
+namespace {
+
+// Smaller regions are converted on the calling thread.
+const int kMinParallelPixels = 512 * 512;
+
+// Height of the stripes (must be even). The conversion is limited by the memory bandwidth, so a
+// few threads are enough.
+const int kStripeHeight = 64;
+const size_t kMaxConvertThreads = 4;
+
+template <typename ConvertRect>
+void convertRegion(const Region& region, const ConvertRect& convert_rect)
+{
+    int64_t pixels = 0;
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+        pixels += static_cast<int64_t>(it.rect().width()) * it.rect().height();
+
+    if (pixels < kMinParallelPixels)
+    {
+        for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+            convert_rect(it.rect());
+        return;
+    }
+
+    std::vector<ThreadPool::Task> tasks;
+
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+
+        // Stripes start at even rows, so the chroma rows of neighbouring stripes do not overlap.
+        for (int top = rect.top(); top < rect.bottom(); top += kStripeHeight)
+        {
+            Rect stripe = Rect::makeLTRB(
+                rect.left(), top, rect.right(), std::min(top + kStripeHeight, rect.bottom()));
+
+            tasks.emplace_back([=]() { convert_rect(stripe); });
+        }
+    }
+
+    ThreadPool::shared()->runTasks(std::move(tasks), kMaxConvertThreads);
+}
+
+} // namespace
+
 VideoEncoder::VideoEncoder(proto::VideoEncoding encoding)
     : encoding_(encoding)
 {
     // Nothing
 }
 
+VideoEncoder::~VideoEncoder() = default;
+
 void VideoEncoder::fillPacketInfo(const Frame* frame, proto::VideoPacket* packet)
 {
     packet->set_encoding(encoding_);
@@ -42,4 +95,63 @@ void VideoEncoder::fillPacketInfo(const Frame* frame, proto::VideoPacket* packet
     }
 }
 
+// static
+void VideoEncoder::fillCopyRects(const Frame* frame, proto::VideoPacket* packet)
+{
+    for (const auto& moved_rect : frame->constMovedRects())
+    {
+        proto::CopyRect* copy_rect = packet->add_copy_rect();
+        proto::Rect* dest_rect = copy_rect->mutable_dest_rect();
+
+        copy_rect->set_src_x(moved_rect.src_pos.x());
+        copy_rect->set_src_y(moved_rect.src_pos.y());
+        dest_rect->set_x(moved_rect.dest_rect.x());
+        dest_rect->set_y(moved_rect.dest_rect.y());
+        dest_rect->set_width(moved_rect.dest_rect.width());
+        dest_rect->set_height(moved_rect.dest_rect.height());
+    }
+}
+
+void VideoEncoder::convertToI420(const Frame* frame, const Region& region,
+                                 uint8_t* y_data, int y_stride,
+                                 uint8_t* u_data, uint8_t* v_data, int uv_stride)
+{
+    auto convert_rect = [=](const Rect& rect)
+    {
+        const int y_offset = y_stride * rect.y() + rect.x();
+        const int uv_offset = uv_stride * rect.y() / 2 + rect.x() / 2;
+
+        libyuv::ARGBToI420(frame->frameDataAtPos(rect.topLeft()),
+                           frame->stride(),
+                           y_data + y_offset, y_stride,
+                           u_data + uv_offset, uv_stride,
+                           v_data + uv_offset, uv_stride,
+                           rect.width(),
+                           rect.height());
+    };
+
+    convertRegion(region, convert_rect);
+}
+
+void VideoEncoder::convertToI444(const Frame* frame, const Region& region,
+                                 uint8_t* y_data, int y_stride,
+                                 uint8_t* u_data, uint8_t* v_data, int uv_stride)
+{
+    auto convert_rect = [=](const Rect& rect)
+    {
+        const int y_offset = y_stride * rect.y() + rect.x();
+        const int uv_offset = uv_stride * rect.y() + rect.x();
+
+        libyuv::ARGBToI444(frame->frameDataAtPos(rect.topLeft()),
+                           frame->stride(),
+                           y_data + y_offset, y_stride,
+                           u_data + uv_offset, uv_stride,
+                           v_data + uv_offset, uv_stride,
+                           rect.width(),
+                           rect.height());
+    };
+
+    convertRegion(region, convert_rect);
+}
+
 } // namespace base
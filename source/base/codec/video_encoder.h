@@ -20,25 +20,57 @@
 #define BASE__CODEC__VIDEO_ENCODER_H
 
 #include "base/desktop/geometry.h"
+#include "base/memory/memory_accounting.h"
 #include "proto/desktop.pb.h"
 
+#include <memory>
+
 namespace base {
 
 class Frame;
+class Region;
 
 class VideoEncoder
 {
 public:
     explicit VideoEncoder(proto::VideoEncoding encoding);
-    virtual ~VideoEncoder() = default;
+    virtual ~VideoEncoder();
 
     virtual void encode(const Frame* frame, proto::VideoPacket* packet) = 0;
 
+    // Sets the target bitrate in kilobits per second.
+    virtual void setBitrate(uint32_t bitrate) = 0;
+
+    // Sets the range of the quantizer. Higher values give lower quality and smaller frames.
+    virtual void setQuantizerRange(uint32_t min_quantizer, uint32_t max_quantizer) = 0;
+
+    // Returns true if the encoder still improves the static areas of the frame, so it needs the
+    // frames without changes too.
+    virtual bool isRefining() const { return false; }
+
     proto::VideoEncoding encoding() const { return encoding_; }
 
 protected:
     void fillPacketInfo(const Frame* frame, proto::VideoPacket* packet);
 
+    // Adds the moved rects of |frame| to |packet| as copy rects. The encoder must not convert the
+    // moved areas: the client copies them from its own frame.
+    static void fillCopyRects(const Frame* frame, proto::VideoPacket* packet);
+
+    // Converts |region| of |frame| to the I420 planes. The rectangles must have even top-left
+    // coords. Large regions (for example, key frames) are converted by stripes on several threads.
+    void convertToI420(const Frame* frame, const Region& region,
+                       uint8_t* y_data, int y_stride,
+                       uint8_t* u_data, uint8_t* v_data, int uv_stride);
+
+    // Converts |region| of |frame| to the I444 planes (the chroma is not subsampled).
+    void convertToI444(const Frame* frame, const Region& region,
+                       uint8_t* y_data, int y_stride,
+                       uint8_t* u_data, uint8_t* v_data, int uv_stride);
+
+    // Buffers owned by the encoder (the image and the maps). Updated when they are recreated.
+    TrackedMemory memory_ { MemoryTag::CODECS };
+
 private:
     const proto::VideoEncoding encoding_;
     Size last_size_;
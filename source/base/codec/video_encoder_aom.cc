@@ -0,0 +1,393 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/video_encoder_aom.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "base/trace_event.h"
+
+#include <thread>
+
+namespace base {
+
+namespace {
+
+const std::chrono::milliseconds kTargetFrameInterval{ 80 };
+
+// Defines the dimension of a macro block. This is used to compute the active map for the encoder.
+const int kMacroBlockSize = 16;
+
+// Speed settings from 7 and above are intended for real time encoding. Higher values turn off
+// the tools which are too slow, but palette and intra block copy are still used for screen
+// content.
+const int kAv1CpuUsed = 8;
+
+// Magic encoder constant for adaptive quantization strategy.
+const int kAv1AqModeCyclicRefresh = 3;
+
+void setCommonCodecParameters(aom_codec_enc_cfg_t* config, const Size& size)
+{
+    // Use microsecond granularity time base.
+    config->g_timebase.num = 1;
+    config->g_timebase.den = static_cast<int>(
+        std::chrono::microseconds(std::chrono::seconds(1)).count());
+
+    config->g_w = size.width();
+    config->g_h = size.height();
+    config->g_pass = AOM_RC_ONE_PASS;
+
+    // Start emitting packets immediately.
+    config->g_lag_in_frames = 0;
+
+    // Since the transport layer is reliable, keyframes should not be necessary.
+    config->kf_mode = AOM_KF_DISABLED;
+    config->kf_min_dist = 10000;
+    config->kf_max_dist = 10000;
+
+    config->g_threads = (std::thread::hardware_concurrency() + 1) / 2;
+
+    // Do not drop any frames at encoder.
+    config->rc_dropframe_thresh = 0;
+
+    // We do not want variations in bandwidth.
+    config->rc_end_usage = AOM_VBR;
+    config->rc_undershoot_pct = 100;
+    config->rc_overshoot_pct = 15;
+}
+
+int roundToTwosMultiple(int x)
+{
+    return x & (~1);
+}
+
+Rect alignRect(const Rect& rect)
+{
+    int x = roundToTwosMultiple(rect.left());
+    int y = roundToTwosMultiple(rect.top());
+    int right = roundToTwosMultiple(rect.right() + 1);
+    int bottom = roundToTwosMultiple(rect.bottom() + 1);
+
+    return Rect::makeLTRB(x, y, right, bottom);
+}
+
+} // namespace
+
+// static
+std::unique_ptr<VideoEncoderAOM> VideoEncoderAOM::createAV1()
+{
+    return std::unique_ptr<VideoEncoderAOM>(new VideoEncoderAOM());
+}
+
+VideoEncoderAOM::VideoEncoderAOM()
+    : VideoEncoder(proto::VIDEO_ENCODING_AV1)
+{
+    memset(&config_, 0, sizeof(config_));
+    memset(&active_map_, 0, sizeof(active_map_));
+}
+
+void VideoEncoderAOM::encode(const Frame* frame, proto::VideoPacket* packet)
+{
+    TRACE_EVENT("codec", "VideoEncoderAOM::encode");
+
+    fillPacketInfo(frame, packet);
+
+    bool is_key_frame = false;
+
+    if (packet->has_format())
+    {
+        const Size& frame_size = frame->size();
+
+        image_.reset(aom_img_alloc(nullptr, AOM_IMG_FMT_I420,
+                                   frame_size.width(), frame_size.height(), 16));
+        if (!image_)
+        {
+            LOG(LS_ERROR) << "aom_img_alloc failed";
+            codec_.reset();
+            return;
+        }
+
+        size_t image_size = 0;
+
+        // Reset image value to 128 so we just need to fill in the y plane.
+        for (int plane = 0; plane < 3; ++plane)
+        {
+            const int rows = (plane == 0) ? image_->h : (image_->h + 1) >> image_->y_chroma_shift;
+            memset(image_->planes[plane], 128, image_->stride[plane] * rows);
+            image_size += static_cast<size_t>(image_->stride[plane]) * rows;
+        }
+
+        createActiveMap(frame_size);
+
+        memory_.set(image_size + active_map_buffer_.capacity());
+
+        if (!createCodec(frame_size))
+        {
+            codec_.reset();
+            return;
+        }
+
+        tile_cache_.reset(packet);
+        is_key_frame = true;
+    }
+
+    if (!codec_)
+        return;
+
+    // Convert the updated capture data ready for encode.
+    // Update active map based on updated region.
+    prepareImageAndActiveMap(is_key_frame, frame, packet);
+
+    // Apply active map to the encoder.
+    aom_codec_err_t ret = aom_codec_control(codec_.get(), AOME_SET_ACTIVEMAP, &active_map_);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+
+    const int64_t duration = std::chrono::microseconds(kTargetFrameInterval).count();
+
+    // Do the actual encoding.
+    ret = aom_codec_encode(codec_.get(), image_.get(), pts_,
+                           static_cast<unsigned long>(duration), 0);
+    if (ret != AOM_CODEC_OK)
+    {
+        LOG(LS_ERROR) << "aom_codec_encode failed: " << aom_codec_error(codec_.get());
+        return;
+    }
+
+    pts_ += duration;
+
+    // Read the encoded data.
+    aom_codec_iter_t iter = nullptr;
+
+    while (true)
+    {
+        const aom_codec_cx_pkt_t* pkt = aom_codec_get_cx_data(codec_.get(), &iter);
+        if (!pkt)
+            break;
+
+        if (pkt->kind == AOM_CODEC_CX_FRAME_PKT)
+        {
+            packet->set_data(pkt->data.frame.buf, pkt->data.frame.sz);
+            break;
+        }
+    }
+}
+
+void VideoEncoderAOM::setBitrate(uint32_t bitrate)
+{
+    if (bitrate_ == bitrate)
+        return;
+
+    bitrate_ = bitrate;
+    updateConfig();
+}
+
+void VideoEncoderAOM::setQuantizerRange(uint32_t min_quantizer, uint32_t max_quantizer)
+{
+    DCHECK_LE(min_quantizer, max_quantizer);
+
+    if (min_quantizer_ == min_quantizer && max_quantizer_ == max_quantizer)
+        return;
+
+    min_quantizer_ = min_quantizer;
+    max_quantizer_ = max_quantizer;
+    updateConfig();
+}
+
+void VideoEncoderAOM::createActiveMap(const Size& size)
+{
+    active_map_.cols = (size.width() + kMacroBlockSize - 1) / kMacroBlockSize;
+    active_map_.rows = (size.height() + kMacroBlockSize - 1) / kMacroBlockSize;
+
+    active_map_buffer_.resize(active_map_.cols * active_map_.rows);
+    active_map_.active_map = active_map_buffer_.data();
+
+    clearActiveMap();
+}
+
+bool VideoEncoderAOM::createCodec(const Size& size)
+{
+    codec_.reset(new aom_codec_ctx_t());
+
+    // Configure the encoder.
+    aom_codec_iface_t* algo = aom_codec_av1_cx();
+
+    aom_codec_err_t ret = aom_codec_enc_config_default(algo, &config_, AOM_USAGE_REALTIME);
+    if (ret != AOM_CODEC_OK)
+    {
+        LOG(LS_ERROR) << "aom_codec_enc_config_default failed: " << aom_codec_err_to_string(ret);
+        return false;
+    }
+
+    setCommonCodecParameters(&config_, size);
+
+    config_.rc_min_quantizer = min_quantizer_;
+    config_.rc_max_quantizer = max_quantizer_;
+    config_.rc_target_bitrate = bitrate_;
+
+    ret = aom_codec_enc_init(codec_.get(), algo, &config_, 0);
+    if (ret != AOM_CODEC_OK)
+    {
+        LOG(LS_ERROR) << "aom_codec_enc_init failed: " << aom_codec_err_to_string(ret);
+        return false;
+    }
+
+    ret = aom_codec_control(codec_.get(), AOME_SET_CPUUSED, kAv1CpuUsed);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+
+    // Enables the screen content tools (palette mode and intra block copy).
+    ret = aom_codec_control(codec_.get(), AV1E_SET_TUNE_CONTENT, AOM_CONTENT_SCREEN);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+
+    ret = aom_codec_control(codec_.get(), AV1E_SET_ENABLE_PALETTE, 1);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+
+    // Intra block copy is only used in key frames. They are rare, but they are large and text
+    // repeats a lot in them.
+    ret = aom_codec_control(codec_.get(), AV1E_SET_ENABLE_INTRABC, 1);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+
+    // Use the lowest level of noise sensitivity so as to spend less time on motion estimation and
+    // inter-prediction mode.
+    ret = aom_codec_control(codec_.get(), AV1E_SET_NOISE_SENSITIVITY, 0);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+
+    // Set cyclic refresh (aka "top-off").
+    ret = aom_codec_control(codec_.get(), AV1E_SET_AQ_MODE, kAv1AqModeCyclicRefresh);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+
+    // Encode rows of superblocks in parallel. It gives the most of the multithreading gain at
+    // large resolutions.
+    ret = aom_codec_control(codec_.get(), AV1E_SET_ROW_MT, 1);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+
+    pts_ = 0;
+    return true;
+}
+
+void VideoEncoderAOM::prepareImageAndActiveMap(
+    bool is_key_frame, const Frame* frame, proto::VideoPacket* packet)
+{
+    Rect image_rect = Rect::makeWH(image_->d_w, image_->d_h);
+    Region updated_region;
+
+    if (!is_key_frame)
+    {
+        // The loop filters of AV1 change up to 8 pixels on either side of an edge (like VP9).
+        const int padding = 8;
+
+        // The tiles which the client has in its cache are not encoded.
+        Region frame_region = frame->constUpdatedRegion();
+        tile_cache_.encode(frame, &frame_region, packet);
+
+        // The blocks with few colors are sent without loss instead of the video.
+        palette_encoder_.encode(frame, &frame_region, packet);
+
+        for (Region::Iterator it(frame_region); !it.isAtEnd(); it.advance())
+        {
+            Rect rect = it.rect();
+
+            // Pad each rectangle and align it to even top-left coords, which is required by
+            // ARGBToI420() (see VideoEncoderVPX for details).
+            updated_region.addRect(
+                alignRect(Rect::makeLTRB(
+                    rect.left() - padding, rect.top() - padding,
+                    rect.right() + padding, rect.bottom() + padding)));
+        }
+
+        // Clip back to the screen dimensions.
+        updated_region.intersectWith(image_rect);
+
+        // The moved areas are left as they are in the image, the client copies them itself.
+        fillCopyRects(frame, packet);
+    }
+    else
+    {
+        updated_region = Region(image_rect);
+
+        // The client stores all tiles of the key frame.
+        tile_cache_.encode(frame, &updated_region, packet);
+
+        // The key frame must contain the whole image, the blocks with few colors are sent
+        // without loss in addition.
+        Region palette_region = updated_region;
+        palette_encoder_.encode(frame, &palette_region, packet);
+    }
+
+    clearActiveMap();
+
+    const int y_stride = image_->stride[AOM_PLANE_Y];
+    const int uv_stride = image_->stride[AOM_PLANE_U];
+    uint8_t* y_data = image_->planes[AOM_PLANE_Y];
+    uint8_t* u_data = image_->planes[AOM_PLANE_U];
+    uint8_t* v_data = image_->planes[AOM_PLANE_V];
+
+    convertToI420(frame, updated_region, y_data, y_stride, u_data, v_data, uv_stride);
+
+    for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+
+        addRectToActiveMap(rect);
+
+        proto::Rect* dirty_rect = packet->add_dirty_rect();
+        dirty_rect->set_x(rect.x());
+        dirty_rect->set_y(rect.y());
+        dirty_rect->set_width(rect.width());
+        dirty_rect->set_height(rect.height());
+    }
+}
+
+void VideoEncoderAOM::updateConfig()
+{
+    // If the codec is not created yet, then the parameters are applied when it is created.
+    if (!codec_)
+        return;
+
+    config_.rc_target_bitrate = bitrate_;
+    config_.rc_min_quantizer = min_quantizer_;
+    config_.rc_max_quantizer = max_quantizer_;
+
+    // The encoder applies the new rate control parameters starting from the next frame.
+    aom_codec_err_t ret = aom_codec_enc_config_set(codec_.get(), &config_);
+    DCHECK_EQ(ret, AOM_CODEC_OK);
+}
+
+void VideoEncoderAOM::addRectToActiveMap(const Rect& rect)
+{
+    int left = rect.left() / kMacroBlockSize;
+    int top = rect.top() / kMacroBlockSize;
+    int right = (rect.right() - 1) / kMacroBlockSize;
+    int bottom = (rect.bottom() - 1) / kMacroBlockSize;
+
+    uint8_t* map = active_map_.active_map + top * active_map_.cols;
+
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
+            map[x] = 1;
+
+        map += active_map_.cols;
+    }
+}
+
+void VideoEncoderAOM::clearActiveMap()
+{
+    memset(active_map_buffer_.data(), 0, active_map_buffer_.size());
+}
+
+} // namespace base
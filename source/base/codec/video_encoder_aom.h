@@ -0,0 +1,82 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__VIDEO_ENCODER_AOM_H
+#define BASE__CODEC__VIDEO_ENCODER_AOM_H
+
+#include "base/macros_magic.h"
+#include "base/codec/scoped_aom_codec.h"
+#include "base/codec/palette_encoder.h"
+#include "base/codec/tile_cache_encoder.h"
+#include "base/codec/video_encoder.h"
+#include "base/desktop/region.h"
+#include "base/memory/byte_array.h"
+
+#include <aom/aom_encoder.h>
+#include <aom/aomcx.h>
+
+namespace base {
+
+// AV1 encoder (libaom) configured for screen content. The palette and intra block copy tools give
+// much smaller frames for text and user interface than VP8 and VP9.
+class VideoEncoderAOM : public VideoEncoder
+{
+public:
+    ~VideoEncoderAOM() override = default;
+
+    static std::unique_ptr<VideoEncoderAOM> createAV1();
+
+    void encode(const Frame* frame, proto::VideoPacket* packet) override;
+    void setBitrate(uint32_t bitrate) override;
+    void setQuantizerRange(uint32_t min_quantizer, uint32_t max_quantizer) override;
+
+private:
+    VideoEncoderAOM();
+
+    void createActiveMap(const Size& size);
+    bool createCodec(const Size& size);
+    void prepareImageAndActiveMap(bool is_key_frame, const Frame* frame, proto::VideoPacket* packet);
+    void addRectToActiveMap(const Rect& rect);
+    void clearActiveMap();
+    void updateConfig();
+
+    // Same defaults as in VideoEncoderVPX. libaom uses the same quantizer range (0-63).
+    uint32_t bitrate_ = 1000;
+    uint32_t min_quantizer_ = 20;
+    uint32_t max_quantizer_ = 30;
+
+    aom_codec_enc_cfg_t config_;
+    ScopedAomCodec codec_;
+
+    ByteArray active_map_buffer_;
+    aom_active_map_t active_map_;
+
+    ScopedAomImage image_;
+
+    TileCacheEncoder tile_cache_;
+    PaletteEncoder palette_encoder_;
+
+    // Presentation time of the next frame.
+    int64_t pts_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoEncoderAOM);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__VIDEO_ENCODER_AOM_H
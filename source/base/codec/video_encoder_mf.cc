@@ -0,0 +1,737 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/video_encoder_mf.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "base/trace_event.h"
+
+#include <libyuv/convert_from_argb.h>
+
+#include <codecapi.h>
+#include <mfapi.h>
+#include <mferror.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+namespace base {
+
+namespace {
+
+const UINT32 kFrameRate = 30;
+
+// Since the transport layer is reliable, key frames are only needed when the encoder is created.
+const UINT32 kGopSize = 10000;
+
+// VideoRateController works with the quantizer range of libvpx (0-63). H.264 uses 0-51.
+const uint32_t kMaxVpxQuantizer = 63;
+const uint32_t kMaxH264Quantizer = 51;
+
+// Maximum time to wait for an event of the asynchronous transform.
+const std::chrono::milliseconds kEventTimeout{ 1000 };
+
+int roundToTwosMultiple(int x)
+{
+    return x & (~1);
+}
+
+Rect alignRect(const Rect& rect)
+{
+    int x = roundToTwosMultiple(rect.left());
+    int y = roundToTwosMultiple(rect.top());
+    int right = roundToTwosMultiple(rect.right() + 1);
+    int bottom = roundToTwosMultiple(rect.bottom() + 1);
+
+    return Rect::makeLTRB(x, y, right, bottom);
+}
+
+uint32_t toH264Quantizer(uint32_t vpx_quantizer)
+{
+    return std::min(vpx_quantizer, kMaxVpxQuantizer) * kMaxH264Quantizer / kMaxVpxQuantizer;
+}
+
+std::vector<ComPtr<IMFActivate>> enumHardwareEncoders()
+{
+    MFT_REGISTER_TYPE_INFO output_info = { MFMediaType_Video, MFVideoFormat_H264 };
+
+    IMFActivate** activates = nullptr;
+    UINT32 count = 0;
+
+    HRESULT hr = MFTEnumEx(MFT_CATEGORY_VIDEO_ENCODER,
+                           MFT_ENUM_FLAG_HARDWARE | MFT_ENUM_FLAG_SORTANDFILTER,
+                           nullptr,
+                           &output_info,
+                           &activates,
+                           &count);
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "MFTEnumEx failed: " << SystemError(hr).toString();
+        return {};
+    }
+
+    std::vector<ComPtr<IMFActivate>> encoders;
+
+    for (UINT32 i = 0; i < count; ++i)
+    {
+        encoders.emplace_back(activates[i]);
+        activates[i]->Release();
+    }
+
+    CoTaskMemFree(activates);
+    return encoders;
+}
+
+bool setCodecValue(ICodecAPI* codec_api, const GUID& key, UINT32 value)
+{
+    VARIANT variant;
+    VariantInit(&variant);
+
+    variant.vt = VT_UI4;
+    variant.ulVal = value;
+
+    return SUCCEEDED(codec_api->SetValue(&key, &variant));
+}
+
+bool setMediaType(IMFTransform* transform, DWORD stream_id, const GUID& subtype,
+                  const Size& size, uint32_t bitrate, bool is_output)
+{
+    ComPtr<IMFMediaType> media_type;
+
+    HRESULT hr = MFCreateMediaType(media_type.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "MFCreateMediaType failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    media_type->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+    media_type->SetGUID(MF_MT_SUBTYPE, subtype);
+    media_type->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+    MFSetAttributeSize(media_type.Get(), MF_MT_FRAME_SIZE, size.width(), size.height());
+    MFSetAttributeRatio(media_type.Get(), MF_MT_FRAME_RATE, kFrameRate, 1);
+    MFSetAttributeRatio(media_type.Get(), MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+
+    if (is_output)
+    {
+        media_type->SetUINT32(MF_MT_AVG_BITRATE, bitrate * 1000);
+        media_type->SetUINT32(MF_MT_MPEG2_PROFILE, eAVEncH264VProfile_Main);
+
+        hr = transform->SetOutputType(stream_id, media_type.Get(), 0);
+    }
+    else
+    {
+        hr = transform->SetInputType(stream_id, media_type.Get(), 0);
+    }
+
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "Unable to set " << (is_output ? "output" : "input")
+                      << " type: " << SystemError(hr).toString();
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+VideoEncoderMF::VideoEncoderMF(ComPtr<IMFActivate> activate)
+    : VideoEncoder(proto::VIDEO_ENCODING_H264),
+      mf_started_(SUCCEEDED(MFStartup(MF_VERSION, MFSTARTUP_LITE))),
+      activate_(std::move(activate))
+{
+    // Nothing
+}
+
+VideoEncoderMF::~VideoEncoderMF()
+{
+    destroyTransform();
+
+    if (mf_started_)
+        MFShutdown();
+}
+
+// static
+std::unique_ptr<VideoEncoderMF> VideoEncoderMF::createH264()
+{
+    std::vector<ComPtr<IMFActivate>> encoders = enumHardwareEncoders();
+    if (encoders.empty())
+    {
+        LOG(LS_INFO) << "No hardware H.264 encoders";
+        return nullptr;
+    }
+
+    // The list is sorted by merit. The first encoder is the preferred one.
+    return std::unique_ptr<VideoEncoderMF>(new VideoEncoderMF(std::move(encoders.front())));
+}
+
+// static
+bool VideoEncoderMF::isSupported()
+{
+    static const bool is_supported = !enumHardwareEncoders().empty();
+    return is_supported;
+}
+
+void VideoEncoderMF::encode(const Frame* frame, proto::VideoPacket* packet)
+{
+    TRACE_EVENT("codec", "VideoEncoderMF::encode");
+
+    fillPacketInfo(frame, packet);
+
+    const bool has_format = packet->has_format();
+
+    // The format is sent with the first packet which has data.
+    if (has_format)
+    {
+        pending_format_ = std::move(*packet->mutable_format());
+        packet->clear_format();
+    }
+
+    bool is_key_frame = false;
+
+    if (has_format || !transform_)
+    {
+        if (!createTransform(frame->size()))
+        {
+            destroyTransform();
+            return;
+        }
+
+        is_key_frame = true;
+    }
+
+    prepareImage(is_key_frame, frame);
+
+    if (!processInput() || !processOutput(packet))
+    {
+        // The transform is created again for the next frame. It starts with a key frame.
+        destroyTransform();
+        packet->clear_data();
+        return;
+    }
+
+    if (packet->data().empty())
+    {
+        // The transform keeps the frame and gives it with one of the next frames. The packet
+        // stays empty and is not sent.
+        return;
+    }
+
+    if (pending_format_)
+    {
+        *packet->mutable_format() = std::move(*pending_format_);
+        pending_format_.reset();
+    }
+
+    // The whole picture is encoded and the encoder can improve unchanged areas too, so the client
+    // has to update the whole frame.
+    proto::Rect* dirty_rect = packet->add_dirty_rect();
+    dirty_rect->set_width(frame->size().width());
+    dirty_rect->set_height(frame->size().height());
+}
+
+void VideoEncoderMF::setBitrate(uint32_t bitrate)
+{
+    if (bitrate_ == bitrate)
+        return;
+
+    bitrate_ = bitrate;
+    updateConfig();
+}
+
+void VideoEncoderMF::setQuantizerRange(uint32_t min_quantizer, uint32_t max_quantizer)
+{
+    DCHECK_LE(min_quantizer, max_quantizer);
+
+    if (min_quantizer_ == min_quantizer && max_quantizer_ == max_quantizer)
+        return;
+
+    min_quantizer_ = min_quantizer;
+    max_quantizer_ = max_quantizer;
+    updateConfig();
+}
+
+bool VideoEncoderMF::createTransform(const Size& size)
+{
+    destroyTransform();
+
+    if (!mf_started_)
+    {
+        LOG(LS_ERROR) << "Media Foundation is not initialized";
+        return false;
+    }
+
+    if (!activate_)
+    {
+        // The activation object can not be used again after the previous transform was shut down.
+        std::vector<ComPtr<IMFActivate>> encoders = enumHardwareEncoders();
+        if (encoders.empty())
+        {
+            LOG(LS_ERROR) << "No hardware H.264 encoders";
+            return false;
+        }
+
+        activate_ = std::move(encoders.front());
+    }
+
+    HRESULT hr = activate_->ActivateObject(IID_PPV_ARGS(transform_.GetAddressOf()));
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFActivate::ActivateObject failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    ComPtr<IMFAttributes> attributes;
+    if (SUCCEEDED(transform_->GetAttributes(attributes.GetAddressOf())))
+    {
+        UINT32 is_async = FALSE;
+        attributes->GetUINT32(MF_TRANSFORM_ASYNC, &is_async);
+
+        if (is_async)
+        {
+            // Hardware transforms are asynchronous and must be unlocked before use.
+            attributes->SetUINT32(MF_TRANSFORM_ASYNC_UNLOCK, TRUE);
+
+            hr = transform_.As(&event_generator_);
+            if (FAILED(hr))
+            {
+                LOG(LS_ERROR) << "Asynchronous transform without IMFMediaEventGenerator";
+                return false;
+            }
+        }
+
+        attributes->SetUINT32(MF_LOW_LATENCY, TRUE);
+    }
+
+    hr = transform_->GetStreamIDs(1, &input_stream_id_, 1, &output_stream_id_);
+    if (hr == E_NOTIMPL)
+    {
+        // The transform has a fixed number of streams with consecutive identifiers.
+        input_stream_id_ = 0;
+        output_stream_id_ = 0;
+    }
+    else if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFTransform::GetStreamIDs failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    image_size_ = Size((size.width() + 1) & ~1, (size.height() + 1) & ~1);
+
+    // The output type must be set before the input type.
+    if (!setMediaType(transform_.Get(), output_stream_id_, MFVideoFormat_H264, image_size_,
+                      bitrate_, true) ||
+        !setMediaType(transform_.Get(), input_stream_id_, MFVideoFormat_NV12, image_size_,
+                      bitrate_, false))
+    {
+        return false;
+    }
+
+    if (SUCCEEDED(transform_.As(&codec_api_)))
+    {
+        // Not all encoders support all the settings, so errors are not fatal.
+        setCodecValue(codec_api_.Get(), CODECAPI_AVLowLatencyMode, TRUE);
+        setCodecValue(codec_api_.Get(), CODECAPI_AVEncMPVDefaultBPictureCount, 0);
+        setCodecValue(codec_api_.Get(), CODECAPI_AVEncMPVGOPSize, kGopSize);
+        setCodecValue(codec_api_.Get(), CODECAPI_AVEncCommonRateControlMode,
+                      eAVEncCommonRateControlMode_LowDelayVBR);
+        updateConfig();
+    }
+
+    transform_->ProcessMessage(MFT_MESSAGE_NOTIFY_BEGIN_STREAMING, 0);
+    transform_->ProcessMessage(MFT_MESSAGE_NOTIFY_START_OF_STREAM, 0);
+
+    const int y_size = image_size_.width() * image_size_.height();
+
+    // The Y plane is black and the UV plane is neutral. The padding is never updated.
+    image_buffer_.resize(y_size + y_size / 2);
+    memset(image_buffer_.data(), 0, y_size);
+    memset(image_buffer_.data() + y_size, 128, y_size / 2);
+
+    start_time_ = std::chrono::steady_clock::now();
+
+    LOG(LS_INFO) << "Hardware H.264 encoder created (" << image_size_.width() << "x"
+                 << image_size_.height() << ")";
+    return true;
+}
+
+void VideoEncoderMF::destroyTransform()
+{
+    if (transform_)
+    {
+        transform_->ProcessMessage(MFT_MESSAGE_NOTIFY_END_STREAMING, 0);
+
+        activate_->ShutdownObject();
+        activate_.Reset();
+    }
+
+    codec_api_.Reset();
+    event_generator_.Reset();
+    transform_.Reset();
+
+    pending_input_requests_ = 0;
+}
+
+void VideoEncoderMF::updateConfig()
+{
+    if (!codec_api_)
+        return;
+
+    setCodecValue(codec_api_.Get(), CODECAPI_AVEncCommonMeanBitRate, bitrate_ * 1000);
+    setCodecValue(codec_api_.Get(), CODECAPI_AVEncVideoMinQP, toH264Quantizer(min_quantizer_));
+    setCodecValue(codec_api_.Get(), CODECAPI_AVEncVideoMaxQP, toH264Quantizer(max_quantizer_));
+}
+
+void VideoEncoderMF::prepareImage(bool is_key_frame, const Frame* frame)
+{
+    const Rect frame_rect = Rect::makeSize(frame->size());
+    Region updated_region;
+
+    if (!is_key_frame)
+    {
+        // All rectangles must have even top-left coords, which is required by ARGBToNV12().
+        for (Region::Iterator it(frame->constUpdatedRegion()); !it.isAtEnd(); it.advance())
+            updated_region.addRect(alignRect(it.rect()));
+
+        // The whole frame is sent in every packet, so the moved areas are converted as updated.
+        for (const auto& moved_rect : frame->constMovedRects())
+            updated_region.addRect(alignRect(moved_rect.dest_rect));
+
+        updated_region.intersectWith(frame_rect);
+    }
+    else
+    {
+        updated_region = Region(frame_rect);
+    }
+
+    const int y_stride = image_size_.width();
+    const int uv_stride = image_size_.width();
+    uint8_t* y_data = image_buffer_.data();
+    uint8_t* uv_data = y_data + y_stride * image_size_.height();
+
+    for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+
+        libyuv::ARGBToNV12(frame->frameDataAtPos(rect.topLeft()),
+                           frame->stride(),
+                           y_data + y_stride * rect.y() + rect.x(), y_stride,
+                           uv_data + uv_stride * rect.y() / 2 + rect.x(), uv_stride,
+                           rect.width(),
+                           rect.height());
+    }
+}
+
+bool VideoEncoderMF::processInput()
+{
+    if (event_generator_)
+    {
+        // The asynchronous transform accepts input only after it has requested it.
+        while (pending_input_requests_ <= 0)
+        {
+            MediaEventType type;
+            if (!waitForEvent(&type))
+                return false;
+
+            if (type == METransformNeedInput)
+                ++pending_input_requests_;
+        }
+
+        --pending_input_requests_;
+    }
+
+    ComPtr<IMFMediaBuffer> buffer;
+
+    HRESULT hr = MFCreateMemoryBuffer(static_cast<DWORD>(image_buffer_.size()),
+                                      buffer.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "MFCreateMemoryBuffer failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    BYTE* data = nullptr;
+
+    hr = buffer->Lock(&data, nullptr, nullptr);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFMediaBuffer::Lock failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    memcpy(data, image_buffer_.data(), image_buffer_.size());
+    buffer->Unlock();
+    buffer->SetCurrentLength(static_cast<DWORD>(image_buffer_.size()));
+
+    ComPtr<IMFSample> sample;
+
+    hr = MFCreateSample(sample.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "MFCreateSample failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    // Media Foundation uses 100-nanosecond units.
+    using Units = std::chrono::duration<LONGLONG, std::ratio<1, 10000000>>;
+
+    sample->AddBuffer(buffer.Get());
+    sample->SetSampleTime(
+        std::chrono::duration_cast<Units>(std::chrono::steady_clock::now() - start_time_).count());
+    sample->SetSampleDuration(
+        std::chrono::duration_cast<Units>(std::chrono::seconds(1)).count() / kFrameRate);
+
+    hr = transform_->ProcessInput(input_stream_id_, sample.Get(), 0);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFTransform::ProcessInput failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    return true;
+}
+
+bool VideoEncoderMF::processOutput(proto::VideoPacket* packet)
+{
+    if (!event_generator_)
+    {
+        // The synchronous transform gives outputs until it needs more input.
+        while (true)
+        {
+            bool need_more_input = false;
+            if (!readOutput(packet, &need_more_input))
+                return false;
+
+            if (need_more_input)
+                return true;
+        }
+    }
+
+    // Low latency mode gives one output for one input, so we wait for it.
+    while (true)
+    {
+        MediaEventType type;
+        if (!waitForEvent(&type))
+            return false;
+
+        if (type == METransformHaveOutput)
+            break;
+
+        if (type == METransformNeedInput)
+            ++pending_input_requests_;
+    }
+
+    while (true)
+    {
+        bool need_more_input = false;
+        if (!readOutput(packet, &need_more_input))
+            return false;
+
+        // The outputs which are ready already are sent in the same packet.
+        bool has_output = false;
+        if (!pollOutputEvent(&has_output))
+            return false;
+
+        if (!has_output)
+            return true;
+    }
+}
+
+bool VideoEncoderMF::readOutput(proto::VideoPacket* packet, bool* need_more_input)
+{
+    MFT_OUTPUT_STREAM_INFO stream_info;
+    memset(&stream_info, 0, sizeof(stream_info));
+
+    HRESULT hr = transform_->GetOutputStreamInfo(output_stream_id_, &stream_info);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFTransform::GetOutputStreamInfo failed: "
+                      << SystemError(hr).toString();
+        return false;
+    }
+
+    ComPtr<IMFSample> output_sample;
+
+    const bool provides_samples = (stream_info.dwFlags &
+        (MFT_OUTPUT_STREAM_PROVIDES_SAMPLES | MFT_OUTPUT_STREAM_CAN_PROVIDE_SAMPLES)) != 0;
+    if (!provides_samples)
+    {
+        ComPtr<IMFMediaBuffer> buffer;
+
+        hr = MFCreateMemoryBuffer(stream_info.cbSize, buffer.GetAddressOf());
+        if (FAILED(hr))
+        {
+            LOG(LS_ERROR) << "MFCreateMemoryBuffer failed: " << SystemError(hr).toString();
+            return false;
+        }
+
+        hr = MFCreateSample(output_sample.GetAddressOf());
+        if (FAILED(hr))
+        {
+            LOG(LS_ERROR) << "MFCreateSample failed: " << SystemError(hr).toString();
+            return false;
+        }
+
+        output_sample->AddBuffer(buffer.Get());
+    }
+
+    MFT_OUTPUT_DATA_BUFFER output;
+    memset(&output, 0, sizeof(output));
+
+    output.dwStreamID = output_stream_id_;
+    output.pSample = output_sample.Get();
+
+    DWORD status = 0;
+    hr = transform_->ProcessOutput(0, 1, &output, &status);
+
+    if (output.pEvents)
+        output.pEvents->Release();
+
+    if (provides_samples && output.pSample)
+    {
+        // The transform allocated the sample, we take ownership of it.
+        output_sample.Attach(output.pSample);
+    }
+
+    if (hr == MF_E_TRANSFORM_NEED_MORE_INPUT)
+    {
+        // The encoder has buffered the frame. It will be sent with one of the next packets.
+        *need_more_input = true;
+        return true;
+    }
+
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFTransform::ProcessOutput failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    if (!output_sample)
+    {
+        LOG(LS_ERROR) << "No output sample";
+        return false;
+    }
+
+    ComPtr<IMFMediaBuffer> buffer;
+
+    hr = output_sample->ConvertToContiguousBuffer(buffer.GetAddressOf());
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFSample::ConvertToContiguousBuffer failed: "
+                      << SystemError(hr).toString();
+        return false;
+    }
+
+    BYTE* data = nullptr;
+    DWORD length = 0;
+
+    hr = buffer->Lock(&data, nullptr, &length);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFMediaBuffer::Lock failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    // H.264 access units follow each other in the byte stream.
+    packet->mutable_data()->append(reinterpret_cast<const char*>(data), length);
+    buffer->Unlock();
+    return true;
+}
+
+bool VideoEncoderMF::pollOutputEvent(bool* has_output)
+{
+    while (true)
+    {
+        MediaEventType type;
+        bool has_event = false;
+
+        if (!nextEvent(&type, &has_event))
+            return false;
+
+        if (!has_event)
+            return true;
+
+        if (type == METransformHaveOutput)
+        {
+            *has_output = true;
+            return true;
+        }
+
+        if (type == METransformNeedInput)
+            ++pending_input_requests_;
+    }
+}
+
+bool VideoEncoderMF::waitForEvent(MediaEventType* type)
+{
+    const std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + kEventTimeout;
+
+    while (true)
+    {
+        bool has_event = false;
+
+        if (!nextEvent(type, &has_event))
+            return false;
+
+        if (has_event)
+            return true;
+
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            LOG(LS_ERROR) << "Timeout while waiting for the encoder";
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool VideoEncoderMF::nextEvent(MediaEventType* type, bool* has_event)
+{
+    ComPtr<IMFMediaEvent> event;
+
+    // The transform does not come back if the device is lost, so we do not block on it.
+    HRESULT hr = event_generator_->GetEvent(MF_EVENT_FLAG_NO_WAIT, event.GetAddressOf());
+    if (hr == MF_E_NO_EVENTS_AVAILABLE)
+        return true;
+
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFMediaEventGenerator::GetEvent failed: "
+                      << SystemError(hr).toString();
+        return false;
+    }
+
+    hr = event->GetType(type);
+    if (FAILED(hr))
+    {
+        LOG(LS_ERROR) << "IMFMediaEvent::GetType failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    *has_event = true;
+    return true;
+}
+
+} // namespace base
@@ -0,0 +1,114 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__VIDEO_ENCODER_MF_H
+#define BASE__CODEC__VIDEO_ENCODER_MF_H
+
+#include "base/macros_magic.h"
+#include "base/codec/video_encoder.h"
+#include "base/memory/byte_array.h"
+
+#include <chrono>
+#include <optional>
+
+#include <mfobjects.h>
+#include <mftransform.h>
+#include <strmif.h>
+#include <wrl/client.h>
+
+namespace base {
+
+// H.264 encoder which uses a hardware Media Foundation transform (NVENC, Intel Quick Sync, AMD VCE
+// and others register themselves as such transforms). The frames are converted to NV12 on the CPU
+// and the transform does the rest of the work.
+class VideoEncoderMF : public VideoEncoder
+{
+public:
+    ~VideoEncoderMF() override;
+
+    // Returns nullptr if there is no hardware H.264 encoder in the system.
+    static std::unique_ptr<VideoEncoderMF> createH264();
+
+    // Returns true if there is a hardware H.264 encoder in the system. The result is cached.
+    static bool isSupported();
+
+    void encode(const Frame* frame, proto::VideoPacket* packet) override;
+    void setBitrate(uint32_t bitrate) override;
+    void setQuantizerRange(uint32_t min_quantizer, uint32_t max_quantizer) override;
+
+private:
+    explicit VideoEncoderMF(Microsoft::WRL::ComPtr<IMFActivate> activate);
+
+    bool createTransform(const Size& size);
+    void destroyTransform();
+    void updateConfig();
+    void prepareImage(bool is_key_frame, const Frame* frame);
+    bool processInput();
+
+    // Appends all the outputs which the transform has to the packet data. If the transform keeps
+    // the frame, the data stays empty.
+    bool processOutput(proto::VideoPacket* packet);
+
+    // Reads one output of the transform. |need_more_input| is set if the transform has no output.
+    bool readOutput(proto::VideoPacket* packet, bool* need_more_input);
+
+    // Takes the events of the asynchronous transform without waiting until METransformHaveOutput.
+    // |has_output| is set if it is received.
+    bool pollOutputEvent(bool* has_output);
+
+    // Waits for the next event of the asynchronous transform and returns its type.
+    bool waitForEvent(MediaEventType* type);
+
+    // Takes the next event of the asynchronous transform if there is one.
+    bool nextEvent(MediaEventType* type, bool* has_event);
+
+    const bool mf_started_;
+
+    Microsoft::WRL::ComPtr<IMFActivate> activate_;
+    Microsoft::WRL::ComPtr<IMFTransform> transform_;
+    Microsoft::WRL::ComPtr<IMFMediaEventGenerator> event_generator_;
+    Microsoft::WRL::ComPtr<ICodecAPI> codec_api_;
+
+    DWORD input_stream_id_ = 0;
+    DWORD output_stream_id_ = 0;
+
+    // The number of METransformNeedInput events which were received but not used yet.
+    int pending_input_requests_ = 0;
+
+    // Same defaults as in VideoEncoderVPX.
+    uint32_t bitrate_ = 1000;
+    uint32_t min_quantizer_ = 20;
+    uint32_t max_quantizer_ = 30;
+
+    // Size of the encoded picture. It is the frame size rounded up to even values.
+    Size image_size_;
+
+    // NV12 image which contains the last frame.
+    ByteArray image_buffer_;
+
+    std::chrono::steady_clock::time_point start_time_;
+
+    // The format of the video which is not sent yet.
+    std::optional<proto::VideoPacketFormat> pending_format_;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoEncoderMF);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__VIDEO_ENCODER_MF_H
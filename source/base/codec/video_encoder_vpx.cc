@@ -20,10 +20,11 @@
 
 #include "base/logging.h"
 #include "base/desktop/frame.h"
+#include "base/trace_event.h"
 
-#include <libyuv/convert.h>
 #include <libyuv/cpu_id.h>
 
+#include <algorithm>
 #include <thread>
 
 namespace base {
@@ -35,12 +36,78 @@ const std::chrono::milliseconds kTargetFrameInterval{ 80 };
 // Defines the dimension of a macro block. This is used to compute the active map for the encoder.
 const int kMacroBlockSize = 16;
 
-// Magic encoder profile numbers for I420 input formats.
+// Magic encoder profile numbers for I420 and I444 input formats.
 const int kVp9I420ProfileNumber = 0;
+const int kVp9I444ProfileNumber = 1;
 
-// Magic encoder constant for adaptive quantization strategy.
+// Magic encoder constants for adaptive quantization strategy.
+const int kVp9AqModeNone = 0;
 const int kVp9AqModeCyclicRefresh = 3;
 
+// Size of a block in the region of interest map.
+const int kRoiBlockSize = 8;
+
+// Segments of the region of interest map and their quantizer deltas (in quantizer units).
+const int kRoiSegmentPeriphery = 0;
+const int kRoiSegmentActiveWindow = 1;
+const int kRoiSegmentCursor = 2;
+const int kRoiSegmentVideo = 3;
+
+const int kRoiPeripheryDeltaQ = 6;
+const int kRoiActiveWindowDeltaQ = -4;
+const int kRoiCursorDeltaQ = -8;
+
+// The motion of a video hides the details, so its pixels get fewer bits (see ContentClassifier).
+const int kRoiVideoDeltaQ = 12;
+
+// Half of the size of the area around the cursor which is encoded with the best quality.
+const int kRoiCursorAreaSize = 96;
+
+// VP9 does not allow tiles narrower than 256 pixels.
+const int kVp9MinTileWidth = 256;
+
+// A key frame is limited to kMaxIntraBitratePct percent of the size of an average frame and may
+// use quantizers up to kKeyFrameMaxQuantizer, so it does not cause a burst on a slow link. Then
+// the whole image is encoded again with the usual quantizers in stripes during kRefreshFrames
+// frames.
+const unsigned int kMaxIntraBitratePct = 300;
+const uint32_t kKeyFrameMaxQuantizer = 56;
+const int kRefreshFrames = 15;
+
+// Temporal layers use the 0-2-1-2 pattern: every fourth frame is in the base layer and every
+// second one is in the layers 0 and 1. Bitrates of the layers are in percents of the total bitrate
+// (each layer includes the lower ones).
+const int kTemporalLayerPeriodicity = 4;
+const uint32_t kTemporalLayerBitratePct[VideoEncoderVPX::kTemporalLayers] = { 40, 60, 100 };
+
+// The lossless refinement of the static areas uses the part of the bandwidth of a frame which the
+// video leaves unused, up to this percent of the target size of a frame.
+const size_t kRefinementBudgetPct = 25;
+
+uint32_t encoderThreadCount()
+{
+    // Using 2 threads gives a great boost in performance for most systems with adequate
+    // processing power. NB: Going to multiple threads on low end windows systems can really hurt
+    // performance.
+    // http://crbug.com/99179
+    return std::max((std::thread::hardware_concurrency() + 1) / 2, 1U);
+}
+
+// Returns log2 of the number of tile columns. Each tile column can be encoded and decoded by its
+// own thread, so we use as many columns as there are threads and the frame width allows.
+int vp9TileColumnsLog2(const Size& size, uint32_t threads)
+{
+    int tile_columns_log2 = 0;
+
+    while ((2U << tile_columns_log2) <= threads &&
+           (size.width() >> (tile_columns_log2 + 1)) >= kVp9MinTileWidth)
+    {
+        ++tile_columns_log2;
+    }
+
+    return tile_columns_log2;
+}
+
 void setCommonCodecParameters(vpx_codec_enc_cfg_t* config, const Size& size)
 {
     // Use millisecond granularity time base.
@@ -61,11 +128,7 @@ void setCommonCodecParameters(vpx_codec_enc_cfg_t* config, const Size& size)
     config->kf_min_dist = 10000;
     config->kf_max_dist = 10000;
 
-    // Using 2 threads gives a great boost in performance for most systems with
-    // adequate processing power. NB: Going to multiple threads on low end
-    // windows systems can really hurt performance.
-    // http://crbug.com/99179
-    config->g_threads = (std::thread::hardware_concurrency() + 1) / 2;
+    config->g_threads = encoderThreadCount();
 
     // Do not drop any frames at encoder.
     config->rc_dropframe_thresh = 0;
@@ -77,6 +140,7 @@ void setCommonCodecParameters(vpx_codec_enc_cfg_t* config, const Size& size)
 }
 
 void createImage(const Size& size,
+                 bool full_chroma,
                  std::unique_ptr<vpx_image_t>* out_image,
                  ByteArray* out_image_buffer)
 {
@@ -87,9 +151,18 @@ void createImage(const Size& size,
     image->d_w = image->w = size.width();
     image->d_h = image->h = size.height();
 
-    image->fmt = VPX_IMG_FMT_YV12;
-    image->x_chroma_shift = 1;
-    image->y_chroma_shift = 1;
+    if (full_chroma)
+    {
+        image->fmt = VPX_IMG_FMT_I444;
+        image->x_chroma_shift = 0;
+        image->y_chroma_shift = 0;
+    }
+    else
+    {
+        image->fmt = VPX_IMG_FMT_YV12;
+        image->x_chroma_shift = 1;
+        image->y_chroma_shift = 1;
+    }
 
     // libyuv's fast-path requires 16-byte aligned pointers and strides, so pad the Y, U and V
     // planes' strides to multiples of 16 bytes.
@@ -105,7 +178,7 @@ void createImage(const Size& size,
     const int y_rows = ((image->h - 1) & ~(kMacroBlockSize - 1)) + kMacroBlockSize;
     const int uv_rows = y_rows >> image->y_chroma_shift;
 
-    ByteArray image_buffer;
+    ByteArray& image_buffer = *out_image_buffer;
 
     // Allocate a YUV buffer large enough for the aligned data & padding.
     image_buffer.resize(y_stride * y_rows + (2 * uv_stride) * uv_rows);
@@ -122,7 +195,6 @@ void createImage(const Size& size,
     image->stride[1] = image->stride[2] = uv_stride;
 
     *out_image = std::move(image);
-    *out_image_buffer = std::move(image_buffer);
 }
 
 int roundToTwosMultiple(int x)
@@ -154,15 +226,26 @@ std::unique_ptr<VideoEncoderVPX> VideoEncoderVPX::createVP9()
     return std::unique_ptr<VideoEncoderVPX>(new VideoEncoderVPX(proto::VIDEO_ENCODING_VP9));
 }
 
+// static
+uint32_t VideoEncoderVPX::temporalLayerBitrate(int layer, uint32_t bitrate)
+{
+    DCHECK_GE(layer, 0);
+    DCHECK_LT(layer, kTemporalLayers);
+    return bitrate * kTemporalLayerBitratePct[layer] / 100;
+}
+
 VideoEncoderVPX::VideoEncoderVPX(proto::VideoEncoding encoding)
     : VideoEncoder(encoding)
 {
     memset(&config_, 0, sizeof(config_));
     memset(&active_map_, 0, sizeof(active_map_));
+    memset(&roi_map_, 0, sizeof(roi_map_));
 }
 
 void VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
 {
+    TRACE_EVENT("codec", "VideoEncoderVPX::encode");
+
     fillPacketInfo(frame, packet);
 
     bool is_key_frame = false;
@@ -171,20 +254,39 @@ void VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
     {
         const Size& frame_size = frame->size();
 
-        createImage(frame_size, &image_, &image_buffer_);
+        // VP8 has no profile with the full chroma.
+        DCHECK(!full_chroma_ || encoding() == proto::VIDEO_ENCODING_VP9);
+
+        // The buffers keep their capacity, so switching to a smaller screen and back does not
+        // allocate them again.
+        createImage(frame_size, full_chroma_, &image_, &image_buffer_);
         createActiveMap(frame_size);
 
-        if (encoding() == proto::VIDEO_ENCODING_VP8)
-        {
-            createVp8Codec(frame_size);
-        }
-        else
+        if (encoding() == proto::VIDEO_ENCODING_VP9)
+            createRoiMap(frame_size);
+
+        if (!resizeCodec(frame_size))
         {
-            DCHECK_EQ(encoding(), proto::VIDEO_ENCODING_VP9);
-            createVp9Codec(frame_size);
+            if (encoding() == proto::VIDEO_ENCODING_VP8)
+            {
+                createVp8Codec(frame_size);
+            }
+            else
+            {
+                DCHECK_EQ(encoding(), proto::VIDEO_ENCODING_VP9);
+                createVp9Codec(frame_size);
+            }
         }
 
+        memory_.set(image_buffer_.capacity() + active_map_buffer_.capacity() +
+                    roi_map_buffer_.capacity());
+
+        if (!bitstream_only_)
+            tile_cache_.reset(packet);
         is_key_frame = true;
+
+        // The stripes of the refresh follow the key frame.
+        refresh_row_ = 0;
     }
 
     // Convert the updated capture data ready for encode.
@@ -195,13 +297,16 @@ void VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
     vpx_codec_err_t ret = vpx_codec_control(codec_.get(), VP8E_SET_ACTIVEMAP, &active_map_);
     DCHECK_EQ(ret, VPX_CODEC_OK);
 
+    if (encoding() == proto::VIDEO_ENCODING_VP9)
+        updateRoiMap(frame);
+
     // Do the actual encoding.
     ret = vpx_codec_encode(codec_.get(),
                            image_.get(),
                            0, // pts
                            static_cast<unsigned long>(
                                std::chrono::microseconds(kTargetFrameInterval).count()),
-                           0, // flags
+                           is_key_frame ? VPX_EFLAG_FORCE_KF : 0,
                            VPX_DL_REALTIME);
     DCHECK_EQ(ret, VPX_CODEC_OK);
 
@@ -220,6 +325,58 @@ void VideoEncoderVPX::encode(const Frame* frame, proto::VideoPacket* packet)
             break;
         }
     }
+
+    if (temporal_layers_)
+    {
+        vpx_svc_layer_id_t layer_id;
+        memset(&layer_id, 0, sizeof(layer_id));
+
+        ret = vpx_codec_control(codec_.get(), VP9E_GET_SVC_LAYER_ID, &layer_id);
+        DCHECK_EQ(ret, VPX_CODEC_OK);
+
+        packet->set_temporal_layer(static_cast<uint32_t>(layer_id.temporal_layer_id));
+    }
+
+    // The next frames use the usual quantizer range.
+    if (is_key_frame)
+        updateConfig();
+
+    if (!bitstream_only_)
+    {
+        const size_t frame_size = static_cast<size_t>(bitrate_) * 1000 / 8 *
+            static_cast<size_t>(kTargetFrameInterval.count()) / 1000;
+        const size_t max_size = frame_size * kRefinementBudgetPct / 100;
+        const size_t packet_size = packet->ByteSizeLong();
+        const size_t budget = (packet_size < max_size) ? max_size - packet_size : 0;
+
+        refinement_encoder_.encode(frame, lossy_region_, lossless_region_, budget, packet);
+    }
+}
+
+bool VideoEncoderVPX::isRefining() const
+{
+    return !bitstream_only_ && !refinement_encoder_.isComplete();
+}
+
+void VideoEncoderVPX::setBitrate(uint32_t bitrate)
+{
+    if (bitrate_ == bitrate)
+        return;
+
+    bitrate_ = bitrate;
+    updateConfig();
+}
+
+void VideoEncoderVPX::setQuantizerRange(uint32_t min_quantizer, uint32_t max_quantizer)
+{
+    DCHECK_LE(min_quantizer, max_quantizer);
+
+    if (min_quantizer_ == min_quantizer && max_quantizer_ == max_quantizer)
+        return;
+
+    min_quantizer_ = min_quantizer;
+    max_quantizer_ = max_quantizer;
+    updateConfig();
 }
 
 void VideoEncoderVPX::createActiveMap(const Size& size)
@@ -233,9 +390,72 @@ void VideoEncoderVPX::createActiveMap(const Size& size)
     clearActiveMap();
 }
 
+void VideoEncoderVPX::createRoiMap(const Size& size)
+{
+    roi_map_.cols = (size.width() + kRoiBlockSize - 1) / kRoiBlockSize;
+    roi_map_.rows = (size.height() + kRoiBlockSize - 1) / kRoiBlockSize;
+
+    roi_map_buffer_.resize(roi_map_.cols * roi_map_.rows);
+    roi_map_.roi_map = nullptr;
+
+    roi_map_.delta_q[kRoiSegmentPeriphery] = kRoiPeripheryDeltaQ;
+    roi_map_.delta_q[kRoiSegmentActiveWindow] = kRoiActiveWindowDeltaQ;
+    roi_map_.delta_q[kRoiSegmentCursor] = kRoiCursorDeltaQ;
+    roi_map_.delta_q[kRoiSegmentVideo] = kRoiVideoDeltaQ;
+
+    // Reference frames are not restricted for any of the segments.
+    for (int i = 0; i < 8; ++i)
+        roi_map_.ref_frame[i] = -1;
+
+    // The new or resized codec uses the cyclic refresh (see resizeCodec).
+    roi_enabled_ = false;
+}
+
+bool VideoEncoderVPX::resizeCodec(const Size& size)
+{
+    // libvpx changes the size of the encoder in place only up to the size which the encoder was
+    // created with. The temporal layers are configured for the size of the encoder.
+    if (!codec_ || temporal_layers_ ||
+        size.width() > codec_size_.width() || size.height() > codec_size_.height())
+    {
+        return false;
+    }
+
+    config_.g_w = size.width();
+    config_.g_h = size.height();
+    config_.rc_max_quantizer = std::max(max_quantizer_, kKeyFrameMaxQuantizer);
+
+    vpx_codec_err_t ret = vpx_codec_enc_config_set(codec_.get(), &config_);
+    if (ret != VPX_CODEC_OK)
+    {
+        LOG(LS_WARNING) << "Failed to resize the encoder: " << vpx_codec_error(codec_.get());
+        return false;
+    }
+
+    if (encoding() == proto::VIDEO_ENCODING_VP9)
+    {
+        // The maps of the previous size are dropped, the new map starts with the cyclic refresh.
+        roi_map_.roi_map = nullptr;
+
+        ret = vpx_codec_control(codec_.get(), VP9E_SET_ROI_MAP, &roi_map_);
+        DCHECK_EQ(ret, VPX_CODEC_OK);
+
+        ret = vpx_codec_control(codec_.get(), VP9E_SET_AQ_MODE, kVp9AqModeCyclicRefresh);
+        DCHECK_EQ(ret, VPX_CODEC_OK);
+
+        ret = vpx_codec_control(codec_.get(), VP9E_SET_TILE_COLUMNS,
+                                vp9TileColumnsLog2(size, config_.g_threads));
+        DCHECK_EQ(ret, VPX_CODEC_OK);
+    }
+
+    LOG(LS_INFO) << "Encoder resized to " << size << " (created for " << codec_size_ << ")";
+    return true;
+}
+
 void VideoEncoderVPX::createVp8Codec(const Size& size)
 {
     codec_.reset(new vpx_codec_ctx_t());
+    codec_size_ = size;
 
     // Configure the encoder.
     vpx_codec_iface_t* algo = vpx_codec_vp8_cx();
@@ -249,18 +469,16 @@ void VideoEncoderVPX::createVp8Codec(const Size& size)
     // explicitly select real time mode when doing encoding.
     config_.g_profile = 2;
 
-    // To enable remoting to be highly interactive and allow the target bitrate to be met, we relax
-    // the max quantizer. The quality will get topped-off in subsequent frames.
-    config_.rc_min_quantizer = 20;
-    config_.rc_max_quantizer = 30;
-
-    // In the absence of a good bandwidth estimator set the target bitrate to a
-    // conservative default.
-    config_.rc_target_bitrate = 1000;
+    config_.rc_min_quantizer = min_quantizer_;
+    config_.rc_max_quantizer = std::max(max_quantizer_, kKeyFrameMaxQuantizer);
+    config_.rc_target_bitrate = bitrate_;
 
     ret = vpx_codec_enc_init(codec_.get(), algo, &config_, 0);
     DCHECK_EQ(VPX_CODEC_OK, ret);
 
+    ret = vpx_codec_control(codec_.get(), VP8E_SET_MAX_INTRA_BITRATE_PCT, kMaxIntraBitratePct);
+    DCHECK_EQ(VPX_CODEC_OK, ret);
+
     // Value of 16 will have the smallest CPU load. This turns off subpixel motion search.
     ret = vpx_codec_control(codec_.get(), VP8E_SET_CPUUSED, 16);
     DCHECK_EQ(VPX_CODEC_OK, ret);
@@ -277,6 +495,7 @@ void VideoEncoderVPX::createVp8Codec(const Size& size)
 void VideoEncoderVPX::createVp9Codec(const Size& size)
 {
     codec_.reset(new vpx_codec_ctx_t());
+    codec_size_ = size;
 
     // Configure the encoder.
     vpx_codec_iface_t* algo = vpx_codec_vp9_cx();
@@ -286,18 +505,39 @@ void VideoEncoderVPX::createVp9Codec(const Size& size)
 
     setCommonCodecParameters(&config_, size);
 
-    // Configure VP9 for I420 source frames.
-    config_.g_profile = kVp9I420ProfileNumber;
-    config_.rc_min_quantizer = 20;
-    config_.rc_max_quantizer = 30;
+    // Configure VP9 for I420 or I444 source frames.
+    config_.g_profile = full_chroma_ ? kVp9I444ProfileNumber : kVp9I420ProfileNumber;
+    config_.rc_min_quantizer = min_quantizer_;
+    config_.rc_max_quantizer = std::max(max_quantizer_, kKeyFrameMaxQuantizer);
+    config_.rc_target_bitrate = bitrate_;
 
-    // In the absence of a good bandwidth estimator set the target bitrate to a
-    // conservative default.
-    config_.rc_target_bitrate = 1000;
+    if (temporal_layers_)
+    {
+        DCHECK(bitstream_only_);
+
+        config_.ss_number_layers = 1;
+        config_.ts_number_layers = kTemporalLayers;
+        config_.ts_periodicity = kTemporalLayerPeriodicity;
+        config_.temporal_layering_mode = VP9E_TEMPORAL_LAYERING_MODE_0212;
+
+        for (int i = 0; i < kTemporalLayers; ++i)
+            config_.ts_rate_decimator[i] = 1 << (kTemporalLayers - 1 - i);
+    }
 
     ret = vpx_codec_enc_init(codec_.get(), algo, &config_, 0);
     DCHECK_EQ(VPX_CODEC_OK, ret);
 
+    if (temporal_layers_)
+    {
+        ret = vpx_codec_control(codec_.get(), VP9E_SET_SVC, 1);
+        DCHECK_EQ(VPX_CODEC_OK, ret);
+
+        updateLayerConfig();
+    }
+
+    ret = vpx_codec_control(codec_.get(), VP8E_SET_MAX_INTRA_BITRATE_PCT, kMaxIntraBitratePct);
+    DCHECK_EQ(VPX_CODEC_OK, ret);
+
     // Request the lowest-CPU usage that VP9 supports, which depends on whether we are encoding
     // lossy or lossless.
     ret = vpx_codec_control(codec_.get(), VP8E_SET_CPUUSED, 6);
@@ -314,6 +554,19 @@ void VideoEncoderVPX::createVp9Codec(const Size& size)
     // Set cyclic refresh (aka "top-off") only for lossy encoding.
     ret = vpx_codec_control(codec_.get(), VP9E_SET_AQ_MODE, kVp9AqModeCyclicRefresh);
     DCHECK_EQ(VPX_CODEC_OK, ret);
+
+    // Without tiles a frame is encoded by one thread. With row based multithreading the threads
+    // also share the rows of superblocks inside the tiles.
+    const int tile_columns_log2 = vp9TileColumnsLog2(size, config_.g_threads);
+
+    ret = vpx_codec_control(codec_.get(), VP9E_SET_TILE_COLUMNS, tile_columns_log2);
+    DCHECK_EQ(VPX_CODEC_OK, ret);
+
+    ret = vpx_codec_control(codec_.get(), VP9E_SET_ROW_MT, 1);
+    DCHECK_EQ(VPX_CODEC_OK, ret);
+
+    LOG(LS_INFO) << "VP9 encoder threads: " << config_.g_threads
+                 << ", tile columns: " << (1 << tile_columns_log2);
 }
 
 void VideoEncoderVPX::prepareImageAndActiveMap(
@@ -326,7 +579,39 @@ void VideoEncoderVPX::prepareImageAndActiveMap(
     {
         const int padding = ((encoding() == proto::VIDEO_ENCODING_VP9) ? 8 : 3);
 
-        for (Region::Iterator it(frame->constUpdatedRegion()); !it.isAtEnd(); it.advance())
+        Region frame_region = frame->constUpdatedRegion();
+        if (bitstream_only_)
+        {
+            // The moved areas are encoded as any other change.
+            for (const auto& moved_rect : frame->constMovedRects())
+                frame_region.addRect(moved_rect.dest_rect);
+        }
+        else
+        {
+            // The tiles which the client has in its cache are not encoded.
+            tile_cache_.encode(frame, &frame_region, packet);
+        }
+
+        // The stripe is encoded even if it has not changed, so it bypasses the tile cache.
+        addRefreshStripe(image_rect, &frame_region);
+
+        if (!bitstream_only_)
+        {
+            // The changed areas, the cached tiles and the moved areas may differ from what the
+            // client had without loss.
+            lossy_region_ = frame->constUpdatedRegion();
+            for (const auto& moved_rect : frame->constMovedRects())
+                lossy_region_.addRect(moved_rect.dest_rect);
+
+            lossless_region_ = frame_region;
+
+            // The blocks with few colors are sent without loss instead of the video.
+            palette_encoder_.encode(frame, &frame_region, packet);
+
+            lossless_region_.subtract(frame_region);
+        }
+
+        for (Region::Iterator it(frame_region); !it.isAtEnd(); it.advance())
         {
             Rect rect = it.rect();
 
@@ -346,10 +631,31 @@ void VideoEncoderVPX::prepareImageAndActiveMap(
         // The conversion routines don't require even width & height, so this is safe even if the
         // source dimensions are not even.
         updated_region.intersectWith(image_rect);
+
+        lossy_region_.addRegion(updated_region);
+
+        // The moved areas are left as they are in the image, the client copies them itself.
+        if (!bitstream_only_)
+            fillCopyRects(frame, packet);
     }
     else
     {
         updated_region = Region(image_rect);
+
+        if (!bitstream_only_)
+        {
+            // The client stores all tiles of the key frame.
+            tile_cache_.encode(frame, &updated_region, packet);
+
+            // The key frame must contain the whole image, the blocks with few colors are sent
+            // without loss in addition.
+            Region palette_region = updated_region;
+            palette_encoder_.encode(frame, &palette_region, packet);
+
+            lossy_region_ = updated_region;
+            lossless_region_ = updated_region;
+            lossless_region_.subtract(palette_region);
+        }
     }
 
     clearActiveMap();
@@ -360,22 +666,14 @@ void VideoEncoderVPX::prepareImageAndActiveMap(
     uint8_t* u_data = image_->planes[1];
     uint8_t* v_data = image_->planes[2];
 
+    if (full_chroma_)
+        convertToI444(frame, updated_region, y_data, y_stride, u_data, v_data, uv_stride);
+    else
+        convertToI420(frame, updated_region, y_data, y_stride, u_data, v_data, uv_stride);
+
     for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
     {
-        Rect rect = it.rect();
-
-        const int y_offset = y_stride * rect.y() + rect.x();
-        const int uv_offset = uv_stride * rect.y() / 2 + rect.x() / 2;
-        const int width = rect.width();
-        const int height = rect.height();
-
-        libyuv::ARGBToI420(frame->frameDataAtPos(rect.topLeft()),
-                           frame->stride(),
-                           y_data + y_offset, y_stride,
-                           u_data + uv_offset, uv_stride,
-                           v_data + uv_offset, uv_stride,
-                           width,
-                           height);
+        const Rect& rect = it.rect();
 
         addRectToActiveMap(rect);
 
@@ -387,6 +685,72 @@ void VideoEncoderVPX::prepareImageAndActiveMap(
     }
 }
 
+void VideoEncoderVPX::addRefreshStripe(const Rect& image_rect, Region* region)
+{
+    if (refresh_row_ >= image_rect.height())
+        return;
+
+    // The stripes are aligned to the macro blocks.
+    const int stripe_rows = (image_rect.height() + kRefreshFrames - 1) / kRefreshFrames;
+    const int stripe_height =
+        (stripe_rows + kMacroBlockSize - 1) / kMacroBlockSize * kMacroBlockSize;
+
+    Rect stripe_rect = Rect::makeXYWH(0, refresh_row_, image_rect.width(), stripe_height);
+    stripe_rect.intersectWith(image_rect);
+
+    region->addRect(stripe_rect);
+    refresh_row_ += stripe_height;
+}
+
+void VideoEncoderVPX::updateConfig()
+{
+    // If the codec is not created yet, then the parameters are applied when it is created.
+    if (!codec_)
+        return;
+
+    config_.rc_target_bitrate = bitrate_;
+    config_.rc_min_quantizer = min_quantizer_;
+    config_.rc_max_quantizer = max_quantizer_;
+
+    if (temporal_layers_)
+    {
+        updateLayerConfig();
+        return;
+    }
+
+    // The encoder applies the new rate control parameters starting from the next frame.
+    vpx_codec_err_t ret = vpx_codec_enc_config_set(codec_.get(), &config_);
+    DCHECK_EQ(ret, VPX_CODEC_OK);
+}
+
+void VideoEncoderVPX::updateLayerConfig()
+{
+    // Each layer has its own rate control. The bitrates of the layers include the lower layers.
+    for (int i = 0; i < kTemporalLayers; ++i)
+    {
+        config_.ts_target_bitrate[i] = temporalLayerBitrate(i, config_.rc_target_bitrate);
+        config_.layer_target_bitrate[i] = config_.ts_target_bitrate[i];
+    }
+
+    vpx_codec_err_t ret = vpx_codec_enc_config_set(codec_.get(), &config_);
+    DCHECK_EQ(ret, VPX_CODEC_OK);
+
+    vpx_svc_extra_cfg_t svc_params;
+    memset(&svc_params, 0, sizeof(svc_params));
+
+    svc_params.scaling_factor_num[0] = 1;
+    svc_params.scaling_factor_den[0] = 1;
+
+    for (int i = 0; i < kTemporalLayers; ++i)
+    {
+        svc_params.min_quantizers[i] = static_cast<int>(config_.rc_min_quantizer);
+        svc_params.max_quantizers[i] = static_cast<int>(config_.rc_max_quantizer);
+    }
+
+    ret = vpx_codec_control(codec_.get(), VP9E_SET_SVC_PARAMETERS, &svc_params);
+    DCHECK_EQ(ret, VPX_CODEC_OK);
+}
+
 void VideoEncoderVPX::addRectToActiveMap(const Rect& rect)
 {
     int left = rect.left() / kMacroBlockSize;
@@ -410,4 +774,88 @@ void VideoEncoderVPX::clearActiveMap()
     memset(active_map_buffer_.data(), 0, active_map_buffer_.size());
 }
 
+void VideoEncoderVPX::updateRoiMap(const Frame* frame)
+{
+    const std::optional<Point>& cursor_position = frame->cursorPosition();
+    const Rect& window_rect = frame->activeWindowRect();
+
+    content_classifier_.update(frame);
+    const Region& video_region = content_classifier_.videoRegion();
+
+    const bool has_roi =
+        cursor_position.has_value() || !window_rect.isEmpty() || !video_region.isEmpty();
+
+    if (has_roi != roi_enabled_)
+    {
+        // The encoder ignores the region of interest map while the cyclic refresh is enabled. When
+        // the focus is unknown and there is no video, the cyclic refresh is used to top-off the
+        // quality instead.
+        const int aq_mode = has_roi ? kVp9AqModeNone : kVp9AqModeCyclicRefresh;
+
+        vpx_codec_err_t ret = vpx_codec_control(codec_.get(), VP9E_SET_AQ_MODE, aq_mode);
+        DCHECK_EQ(ret, VPX_CODEC_OK);
+
+        roi_enabled_ = has_roi;
+
+        if (!has_roi)
+        {
+            roi_map_.roi_map = nullptr;
+
+            ret = vpx_codec_control(codec_.get(), VP9E_SET_ROI_MAP, &roi_map_);
+            DCHECK_EQ(ret, VPX_CODEC_OK);
+        }
+    }
+
+    if (!has_roi)
+        return;
+
+    memset(roi_map_buffer_.data(), kRoiSegmentPeriphery, roi_map_buffer_.size());
+
+    auto mark_rect = [this](const Rect& rect, uint8_t segment)
+    {
+        Rect map_rect = Rect::makeLTRB(rect.left() / kRoiBlockSize,
+                                       rect.top() / kRoiBlockSize,
+                                       (rect.right() + kRoiBlockSize - 1) / kRoiBlockSize,
+                                       (rect.bottom() + kRoiBlockSize - 1) / kRoiBlockSize);
+        map_rect.intersectWith(Rect::makeWH(static_cast<int32_t>(roi_map_.cols),
+                                             static_cast<int32_t>(roi_map_.rows)));
+
+        for (int y = map_rect.top(); y < map_rect.bottom(); ++y)
+        {
+            const uint8_t* active_map =
+                active_map_.active_map + (y * kRoiBlockSize / kMacroBlockSize) * active_map_.cols;
+            uint8_t* roi_map = roi_map_buffer_.data() + y * roi_map_.cols;
+
+            for (int x = map_rect.left(); x < map_rect.right(); ++x)
+            {
+                // The encoder applies the active map only to the blocks of the first segment.
+                // Unchanged blocks must stay there to be skipped.
+                if (active_map[x * kRoiBlockSize / kMacroBlockSize])
+                    roi_map[x] = segment;
+            }
+        }
+    };
+
+    if (!window_rect.isEmpty())
+        mark_rect(window_rect, kRoiSegmentActiveWindow);
+
+    // A video in the active window is cheaper too, only the area around the cursor stays sharp.
+    for (Region::Iterator it(video_region); !it.isAtEnd(); it.advance())
+        mark_rect(it.rect(), kRoiSegmentVideo);
+
+    if (cursor_position.has_value())
+    {
+        mark_rect(Rect::makeLTRB(cursor_position->x() - kRoiCursorAreaSize,
+                                 cursor_position->y() - kRoiCursorAreaSize,
+                                 cursor_position->x() + kRoiCursorAreaSize,
+                                 cursor_position->y() + kRoiCursorAreaSize),
+                  kRoiSegmentCursor);
+    }
+
+    roi_map_.roi_map = roi_map_buffer_.data();
+
+    vpx_codec_err_t ret = vpx_codec_control(codec_.get(), VP9E_SET_ROI_MAP, &roi_map_);
+    DCHECK_EQ(ret, VPX_CODEC_OK);
+}
+
 } // namespace base
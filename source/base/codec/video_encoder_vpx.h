@@ -21,6 +21,10 @@
 
 #include "base/macros_magic.h"
 #include "base/codec/scoped_vpx_codec.h"
+#include "base/codec/content_classifier.h"
+#include "base/codec/palette_encoder.h"
+#include "base/codec/refinement_encoder.h"
+#include "base/codec/tile_cache_encoder.h"
 #include "base/codec/video_encoder.h"
 #include "base/desktop/region.h"
 #include "base/memory/byte_array.h"
@@ -29,6 +33,8 @@
 #include <vpx/vpx_encoder.h>
 #include <vpx/vp8cx.h>
 
+#include <limits>
+
 namespace base {
 
 class VideoEncoderVPX : public VideoEncoder
@@ -40,27 +46,96 @@ public:
     static std::unique_ptr<VideoEncoderVPX> createVP9();
 
     void encode(const Frame* frame, proto::VideoPacket* packet) override;
+    void setBitrate(uint32_t bitrate) override;
+    void setQuantizerRange(uint32_t min_quantizer, uint32_t max_quantizer) override;
+    bool isRefining() const override;
+
+    // If enabled, the packets contain only the VP8/VP9 bitstream, without cached tiles, palette
+    // blocks and copy rects. Such a stream can be decoded by any decoder (for example, recorded to
+    // a WebM file). Must be set before the first frame.
+    void setBitstreamOnly(bool enable) { bitstream_only_ = enable; }
+
+    // If enabled, the VP9 frames are encoded in kTemporalLayers temporal layers (see
+    // proto::VideoPacket::temporal_layer). The frames of the upper layers can be skipped only if
+    // the packets contain nothing but the bitstream (see setBitstreamOnly). Must be set before
+    // the first frame.
+    void setTemporalLayers(bool enable) { temporal_layers_ = enable; }
+
+    // If enabled, the VP9 frames are encoded in profile 1 with the chroma planes at full
+    // resolution (I444). The colored text stays sharp at a much lower bitrate than with a lower
+    // quantizer in I420. Must be set before the first frame.
+    void setFullChroma(bool enable) { full_chroma_ = enable; }
+
+    static constexpr int kTemporalLayers = 3;
+
+    // Returns the bitrate of the video which contains the temporal layers from zero up to |layer|
+    // if the whole video has |bitrate|.
+    static uint32_t temporalLayerBitrate(int layer, uint32_t bitrate);
 
 private:
     explicit VideoEncoderVPX(proto::VideoEncoding encoding);
 
     void createActiveMap(const Size& size);
+    void createRoiMap(const Size& size);
+    bool resizeCodec(const Size& size);
     void createVp8Codec(const Size& size);
     void createVp9Codec(const Size& size);
     void prepareImageAndActiveMap(bool is_key_frame, const Frame* frame, proto::VideoPacket* packet);
     void addRectToActiveMap(const Rect& rect);
     void clearActiveMap();
+    void updateRoiMap(const Frame* frame);
+    void addRefreshStripe(const Rect& image_rect, Region* region);
+    void updateConfig();
+    void updateLayerConfig();
+
+    // In the absence of a good bandwidth estimator the target bitrate is set to a conservative
+    // default.
+    uint32_t bitrate_ = 1000;
+
+    // To enable remoting to be highly interactive and allow the target bitrate to be met, we relax
+    // the max quantizer. The quality will get topped-off in subsequent frames.
+    uint32_t min_quantizer_ = 20;
+    uint32_t max_quantizer_ = 30;
 
     vpx_codec_enc_cfg_t config_;
     ScopedVpxCodec codec_;
 
+    // Size which the codec was created with. The codec is resized in place to smaller sizes.
+    Size codec_size_;
+
     ByteArray active_map_buffer_;
     vpx_active_map_t active_map_;
 
+    // Region of interest map (VP9 only). Blocks around the cursor and inside the active window are
+    // encoded with a lower quantizer than the rest of the screen.
+    ByteArray roi_map_buffer_;
+    vpx_roi_map_t roi_map_;
+    bool roi_enabled_ = false;
+
+    // Finds the areas of video for the region of interest map.
+    ContentClassifier content_classifier_;
+
     // VPX image and buffer to hold the actual YUV planes.
     std::unique_ptr<vpx_image_t> image_;
     ByteArray image_buffer_;
 
+    TileCacheEncoder tile_cache_;
+    PaletteEncoder palette_encoder_;
+
+    // The static areas are sent again without loss (see RefinementEncoder). The areas which the
+    // client gets in the current frame with and without loss.
+    RefinementEncoder refinement_encoder_;
+    Region lossy_region_;
+    Region lossless_region_;
+
+    bool bitstream_only_ = false;
+    bool temporal_layers_ = false;
+    bool full_chroma_ = false;
+
+    // First row of the next stripe of the refresh after a key frame (see kRefreshFrames). The
+    // refresh is complete when it is beyond the image.
+    int refresh_row_ = std::numeric_limits<int>::max();
+
     DISALLOW_COPY_AND_ASSIGN(VideoEncoderVPX);
 };
 
@@ -0,0 +1,71 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/video_encoder_vpx.h"
+#include "base/desktop/frame.h"
+#include "base/desktop/screen_fixture.h"
+#include "proto/desktop.pb.h"
+
+#include <benchmark/benchmark.h>
+
+namespace base {
+
+namespace {
+
+void runVideoEncoder(benchmark::State& state, std::unique_ptr<VideoEncoderVPX> encoder)
+{
+    const ScreenFixture& fixture = ScreenFixture::shared();
+    proto::VideoPacket packet;
+    int64_t encoded_bytes = 0;
+
+    // The first frame is a key frame. It is encoded before the measurement starts, the sequence
+    // of the frames is repeated without it.
+    encoder->encode(fixture.frame(0), &packet);
+
+    int index = fixture.frameCount() > 1 ? 1 : 0;
+
+    for (auto _ : state)
+    {
+        packet.Clear();
+        encoder->encode(fixture.frame(index), &packet);
+        encoded_bytes += packet.data().size();
+
+        if (++index == fixture.frameCount())
+            index = fixture.frameCount() > 1 ? 1 : 0;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["encoded_bytes_per_frame"] = benchmark::Counter(
+        static_cast<double>(encoded_bytes), benchmark::Counter::kAvgIterations);
+}
+
+void BM_VideoEncoderVP8(benchmark::State& state)
+{
+    runVideoEncoder(state, VideoEncoderVPX::createVP8());
+}
+BENCHMARK(BM_VideoEncoderVP8)->Unit(benchmark::kMillisecond);
+
+void BM_VideoEncoderVP9(benchmark::State& state)
+{
+    runVideoEncoder(state, VideoEncoderVPX::createVP9());
+}
+BENCHMARK(BM_VideoEncoderVP9)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+} // namespace base
@@ -0,0 +1,152 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/codec/video_rate_controller.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// The initial bitrate matches the default bitrate of the encoder.
+const uint32_t kInitialBitrate = 1000;
+const uint32_t kMinBitrate = 100;
+const uint32_t kMaxBitrate = 20000;
+
+// Above this bitrate the encoder uses the default quantizer range. Below it the maximum quantizer
+// is relaxed so that the encoder can meet the target bitrate.
+const uint32_t kHighQualityBitrate = 1000;
+
+const uint32_t kDefaultMinQuantizer = 20;
+const uint32_t kDefaultMaxQuantizer = 30;
+const uint32_t kLowBitrateMinQuantizer = 24;
+const uint32_t kLowBitrateMaxQuantizer = 50;
+
+const std::chrono::milliseconds kMinCaptureInterval{ 40 };
+const std::chrono::milliseconds kMaxCaptureInterval{ 320 };
+
+// If sending of the queued data takes longer than this, the channel is considered congested.
+const std::chrono::milliseconds kHighQueueDelay{ 200 };
+
+// If sending of the queued data takes less than this, the bitrate may increase.
+const std::chrono::milliseconds kLowQueueDelay{ 20 };
+
+// Minimum time between two reductions of the bitrate. The reduction needs some time to take
+// effect on the queue, so further reductions are not done immediately.
+const std::chrono::milliseconds kDecreaseInterval{ 250 };
+
+// Minimum time between the last change and an increase of the bitrate.
+const std::chrono::milliseconds kIncreaseInterval{ 1000 };
+
+// Only this part of the measured throughput is used for video. The rest remains for the cursor,
+// audio and other messages.
+const int64_t kBandwidthUsagePercent = 85;
+
+} // namespace
+
+VideoRateController::VideoRateController()
+{
+    reset();
+}
+
+VideoRateController::~VideoRateController() = default;
+
+bool VideoRateController::update(const TimePoint& time, size_t pending_bytes, int64_t bandwidth)
+{
+    const Settings previous = settings_;
+
+    // If there is no throughput measurement yet, then assume the channel carries the current
+    // target bitrate.
+    int64_t rate = bandwidth;
+    if (rate <= 0)
+        rate = static_cast<int64_t>(settings_.bitrate) * 1000 / 8;
+
+    const std::chrono::milliseconds queue_delay(
+        static_cast<int64_t>(pending_bytes) * 1000 / std::max(rate, int64_t(1)));
+
+    const std::chrono::milliseconds elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(time - last_change_);
+
+    if (queue_delay > kHighQueueDelay)
+    {
+        if (elapsed < kDecreaseInterval)
+            return false;
+
+        // Multiplicative decrease. The measured throughput is the best estimate of what the
+        // channel can carry, so the bitrate does not stay above it.
+        uint32_t bitrate = settings_.bitrate * 3 / 4;
+        if (bandwidth > 0)
+        {
+            bitrate = std::min(bitrate, static_cast<uint32_t>(
+                bandwidth * 8 / 1000 * kBandwidthUsagePercent / 100));
+        }
+
+        settings_.bitrate = std::max(bitrate, kMinBitrate);
+        settings_.capture_interval =
+            std::min(settings_.capture_interval * 3 / 2, kMaxCaptureInterval);
+
+        last_change_ = time;
+    }
+    else if (queue_delay < kLowQueueDelay)
+    {
+        if (elapsed < kIncreaseInterval)
+            return false;
+
+        // Additive increase. The throughput is measured only while the queue is not empty, so the
+        // bitrate grows above it slowly to probe the channel.
+        settings_.bitrate = std::min(
+            settings_.bitrate + std::max(settings_.bitrate / 10, kMinBitrate / 2), kMaxBitrate);
+        settings_.capture_interval =
+            std::max(settings_.capture_interval * 4 / 5, kMinCaptureInterval);
+
+        last_change_ = time;
+    }
+
+    updateQuantizer();
+    return !settings_.equals(previous);
+}
+
+void VideoRateController::reset()
+{
+    settings_.bitrate = kInitialBitrate;
+    settings_.capture_interval = kMinCaptureInterval;
+    last_change_ = TimePoint();
+
+    updateQuantizer();
+}
+
+void VideoRateController::updateQuantizer()
+{
+    if (settings_.bitrate >= kHighQualityBitrate)
+    {
+        settings_.min_quantizer = kDefaultMinQuantizer;
+        settings_.max_quantizer = kDefaultMaxQuantizer;
+        return;
+    }
+
+    // At low bitrates the quantizer range moves linearly towards the coarser values.
+    const uint32_t range = kHighQualityBitrate - kMinBitrate;
+    const uint32_t position = kHighQualityBitrate - std::max(settings_.bitrate, kMinBitrate);
+
+    settings_.min_quantizer = kDefaultMinQuantizer +
+        (kLowBitrateMinQuantizer - kDefaultMinQuantizer) * position / range;
+    settings_.max_quantizer = kDefaultMaxQuantizer +
+        (kLowBitrateMaxQuantizer - kDefaultMaxQuantizer) * position / range;
+}
+
+} // namespace base
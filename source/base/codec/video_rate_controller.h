@@ -0,0 +1,84 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#ifndef BASE__CODEC__VIDEO_RATE_CONTROLLER_H
+#define BASE__CODEC__VIDEO_RATE_CONTROLLER_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <cstdint>
+
+namespace base {
+
+// Selects the parameters of the video encoder and the screen capture interval so that the video
+// stream fits into the network channel. The goal is to keep the send queue near empty: when
+// messages accumulate in the queue, the bitrate and the frame rate are reduced, when the queue
+// drains, they slowly grow back up to the measured throughput of the channel.
+class VideoRateController
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = std::chrono::time_point<Clock>;
+    using Milliseconds = std::chrono::milliseconds;
+
+    struct Settings
+    {
+        // Target bitrate in kilobits per second.
+        uint32_t bitrate = 0;
+
+        // Quantizer range of the encoder (0-63).
+        uint32_t min_quantizer = 0;
+        uint32_t max_quantizer = 0;
+
+        // Interval between screen captures.
+        Milliseconds capture_interval = Milliseconds::zero();
+
+        bool equals(const Settings& other) const
+        {
+            return bitrate == other.bitrate &&
+                   min_quantizer == other.min_quantizer &&
+                   max_quantizer == other.max_quantizer &&
+                   capture_interval == other.capture_interval;
+        }
+    };
+
+    VideoRateController();
+    ~VideoRateController();
+
+    // Updates the state of the controller. |pending_bytes| is the number of bytes waiting to be
+    // sent, |bandwidth| is the measured throughput of the channel in bytes per second (zero if
+    // unknown). Returns true if the settings have changed.
+    bool update(const TimePoint& time, size_t pending_bytes, int64_t bandwidth);
+
+    const Settings& settings() const { return settings_; }
+
+    // Returns the settings to the initial values.
+    void reset();
+
+private:
+    void updateQuantizer();
+
+    Settings settings_;
+    TimePoint last_change_;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoRateController);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__VIDEO_RATE_CONTROLLER_H
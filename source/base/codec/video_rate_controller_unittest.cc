@@ -0,0 +1,115 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/codec/video_rate_controller.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+using Milliseconds = std::chrono::milliseconds;
+
+} // namespace
+
+TEST(VideoRateControllerTest, Initial)
+{
+    VideoRateController controller;
+
+    const VideoRateController::Settings& settings = controller.settings();
+    EXPECT_EQ(settings.bitrate, 1000u);
+    EXPECT_EQ(settings.min_quantizer, 20u);
+    EXPECT_EQ(settings.max_quantizer, 30u);
+    EXPECT_EQ(settings.capture_interval, Milliseconds(40));
+}
+
+TEST(VideoRateControllerTest, Congestion)
+{
+    VideoRateController controller;
+    VideoRateController::TimePoint time = VideoRateController::Clock::now();
+
+    // 1 MB in the queue of a 250 KB/s channel takes 4 seconds.
+    EXPECT_TRUE(controller.update(time, 1024 * 1024, 250 * 1024));
+
+    const VideoRateController::Settings& settings = controller.settings();
+    EXPECT_LT(settings.bitrate, 1000u);
+    EXPECT_GT(settings.max_quantizer, 30u);
+    EXPECT_GT(settings.capture_interval, Milliseconds(40));
+
+    // The next decrease is not done immediately.
+    const uint32_t bitrate = settings.bitrate;
+    EXPECT_FALSE(controller.update(time + Milliseconds(10), 1024 * 1024, 250 * 1024));
+    EXPECT_EQ(settings.bitrate, bitrate);
+
+    EXPECT_TRUE(controller.update(time + Milliseconds(300), 1024 * 1024, 250 * 1024));
+    EXPECT_LT(settings.bitrate, bitrate);
+}
+
+TEST(VideoRateControllerTest, Limits)
+{
+    VideoRateController controller;
+    VideoRateController::TimePoint time = VideoRateController::Clock::now();
+
+    for (int i = 0; i < 100; ++i)
+    {
+        time += Milliseconds(500);
+        controller.update(time, 10 * 1024 * 1024, 10 * 1024);
+    }
+
+    const VideoRateController::Settings& settings = controller.settings();
+    EXPECT_EQ(settings.bitrate, 100u);
+    EXPECT_EQ(settings.min_quantizer, 24u);
+    EXPECT_EQ(settings.max_quantizer, 50u);
+    EXPECT_EQ(settings.capture_interval, Milliseconds(320));
+}
+
+TEST(VideoRateControllerTest, Recovery)
+{
+    VideoRateController controller;
+    VideoRateController::TimePoint time = VideoRateController::Clock::now();
+
+    for (int i = 0; i < 10; ++i)
+    {
+        time += Milliseconds(500);
+        controller.update(time, 1024 * 1024, 100 * 1024);
+    }
+
+    const VideoRateController::Settings& settings = controller.settings();
+    const uint32_t bitrate = settings.bitrate;
+
+    // With the empty queue the bitrate grows, but not faster than once per second.
+    time += Milliseconds(500);
+    EXPECT_FALSE(controller.update(time, 0, 100 * 1024));
+
+    time += Milliseconds(500);
+    EXPECT_TRUE(controller.update(time, 0, 100 * 1024));
+    EXPECT_GT(settings.bitrate, bitrate);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        time += Milliseconds(1000);
+        controller.update(time, 0, 100 * 1024);
+    }
+
+    EXPECT_GE(settings.bitrate, 1000u);
+    EXPECT_EQ(settings.min_quantizer, 20u);
+    EXPECT_EQ(settings.max_quantizer, 30u);
+    EXPECT_EQ(settings.capture_interval, Milliseconds(40));
+}
+
+} // namespace base
@@ -0,0 +1,109 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/viewport_filter.h"
+
+#include "base/desktop/frame_view.h"
+
+namespace base {
+
+namespace {
+
+// The area around the viewport which is updated too. Small scrolls do not wait for the lazy
+// updates then.
+const int kViewportMargin = 128;
+
+// Height of the stripe of the deferred changes which is passed with each frame.
+const int kLazyStripeHeight = 64;
+
+} // namespace
+
+ViewportFilter::ViewportFilter() = default;
+ViewportFilter::~ViewportFilter() = default;
+
+void ViewportFilter::setViewport(const Rect& viewport)
+{
+    viewport_ = viewport;
+}
+
+const Frame* ViewportFilter::filterFrame(const Frame* frame)
+{
+    if (frame->size() != frame_size_)
+    {
+        // The deferred changes of the previous frame size make no sense.
+        frame_size_ = frame->size();
+        reset();
+    }
+
+    if (viewport_.isEmpty() && deferred_region_.isEmpty())
+        return frame;
+
+    Region changes = frame->constUpdatedRegion();
+    for (const auto& moved_rect : frame->constMovedRects())
+        changes.addRect(moved_rect.dest_rect);
+    changes.addRegion(deferred_region_);
+
+    const Rect frame_rect = Rect::makeSize(frame_size_);
+
+    Rect visible_rect = frame_rect;
+    if (!viewport_.isEmpty())
+    {
+        visible_rect = viewport_;
+        visible_rect.extend(kViewportMargin, kViewportMargin, kViewportMargin, kViewportMargin);
+        visible_rect.intersectWith(frame_rect);
+    }
+
+    Region updated_region = changes;
+    updated_region.intersectWith(visible_rect);
+
+    deferred_region_.swap(&changes);
+    deferred_region_.subtract(visible_rect);
+
+    if (!deferred_region_.isEmpty())
+    {
+        const Rect stripe_rect =
+            Rect::makeXYWH(0, lazy_row_, frame_size_.width(), kLazyStripeHeight);
+
+        Region lazy_region = deferred_region_;
+        lazy_region.intersectWith(stripe_rect);
+
+        updated_region.addRegion(lazy_region);
+        deferred_region_.subtract(stripe_rect);
+
+        lazy_row_ += kLazyStripeHeight;
+        if (lazy_row_ >= frame_size_.height())
+            lazy_row_ = 0;
+    }
+
+    if (updated_region.isEmpty())
+        return nullptr;
+
+    frame_view_ = std::make_unique<FrameView>(*frame);
+    frame_view_->updatedRegion()->swap(&updated_region);
+    frame_view_->movedRects()->clear();
+
+    return frame_view_.get();
+}
+
+void ViewportFilter::reset()
+{
+    deferred_region_.clear();
+    lazy_row_ = 0;
+}
+
+} // namespace base
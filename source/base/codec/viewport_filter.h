@@ -0,0 +1,70 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CODEC__VIEWPORT_FILTER_H
+#define BASE__CODEC__VIEWPORT_FILTER_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+#include "base/desktop/region.h"
+
+#include <memory>
+
+namespace base {
+
+class Frame;
+class FrameView;
+
+// Restricts the changes of the frames to the area which the client sees (a zoomed or a scrolled
+// view shows only a part of the video). The changes outside of the area are kept and are passed
+// when the area moves to them. Meanwhile they are also passed one stripe of rows per frame, so that
+// the whole video is up to date after a while.
+class ViewportFilter
+{
+public:
+    ViewportFilter();
+    ~ViewportFilter();
+
+    // |viewport| is in the coordinates of the frames. An empty rectangle means the whole frame.
+    void setViewport(const Rect& viewport);
+    const Rect& viewport() const { return viewport_; }
+
+    // Returns |frame| or a frame with the same pixels and the restricted updated region (the moved
+    // areas become updated areas). Returns nullptr if there is nothing to update in the frame.
+    // The returned frame is valid until the next call.
+    const Frame* filterFrame(const Frame* frame);
+
+    // Drops the deferred changes. It is used when the next frame is sent entirely (a key frame).
+    void reset();
+
+    // Returns true if some changes are still to be sent.
+    bool hasDeferredChanges() const { return !deferred_region_.isEmpty(); }
+
+private:
+    std::unique_ptr<FrameView> frame_view_;
+    Rect viewport_;
+    Size frame_size_;
+    Region deferred_region_;
+    int lazy_row_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(ViewportFilter);
+};
+
+} // namespace base
+
+#endif // BASE__CODEC__VIEWPORT_FILTER_H
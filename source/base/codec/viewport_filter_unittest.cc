@@ -0,0 +1,99 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/codec/viewport_filter.h"
+
+#include "base/desktop/frame_simple.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(1024, 768);
+
+} // namespace
+
+TEST(ViewportFilterTest, WholeFrame)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+    frame->updatedRegion()->addRect(Rect::makeXYWH(10, 10, 100, 100));
+
+    ViewportFilter filter;
+    EXPECT_EQ(filter.filterFrame(frame.get()), frame.get());
+}
+
+TEST(ViewportFilterTest, DeferredChanges)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+
+    ViewportFilter filter;
+    filter.setViewport(Rect::makeXYWH(0, 0, 256, 256));
+
+    // A change inside the viewport and a change far from it.
+    const Rect visible_rect = Rect::makeXYWH(10, 10, 100, 100);
+    const Rect hidden_rect = Rect::makeXYWH(800, 600, 100, 100);
+
+    frame->updatedRegion()->addRect(visible_rect);
+    frame->updatedRegion()->addRect(hidden_rect);
+
+    const Frame* filtered_frame = filter.filterFrame(frame.get());
+    ASSERT_NE(filtered_frame, nullptr);
+    EXPECT_NE(filtered_frame, frame.get());
+    EXPECT_EQ(filtered_frame->frameData(), frame->frameData());
+    EXPECT_TRUE(filtered_frame->constUpdatedRegion().equals(Region(visible_rect)));
+
+    // The hidden change is sent when the viewport moves to it.
+    frame->updatedRegion()->clear();
+    filter.setViewport(Rect::makeXYWH(768, 512, 256, 256));
+
+    filtered_frame = filter.filterFrame(frame.get());
+    ASSERT_NE(filtered_frame, nullptr);
+    EXPECT_TRUE(filtered_frame->constUpdatedRegion().equals(Region(hidden_rect)));
+
+    // Nothing is left.
+    EXPECT_EQ(filter.filterFrame(frame.get()), nullptr);
+}
+
+TEST(ViewportFilterTest, LazyChanges)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(kFrameSize);
+
+    ViewportFilter filter;
+    filter.setViewport(Rect::makeXYWH(0, 0, 256, 256));
+
+    frame->updatedRegion()->addRect(Rect::makeSize(kFrameSize));
+
+    Region updated_region;
+    for (int i = 0; i < kFrameSize.height(); ++i)
+    {
+        const Frame* filtered_frame = filter.filterFrame(frame.get());
+        if (!filtered_frame)
+            break;
+
+        updated_region.addRegion(filtered_frame->constUpdatedRegion());
+        frame->updatedRegion()->clear();
+    }
+
+    // The whole frame is sent after a while without moving the viewport.
+    EXPECT_TRUE(updated_region.equals(Region(Rect::makeSize(kFrameSize))));
+    EXPECT_EQ(filter.filterFrame(frame.get()), nullptr);
+}
+
+} // namespace base
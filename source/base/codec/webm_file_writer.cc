@@ -28,20 +28,82 @@
 
 namespace base {
 
+namespace {
+
+// If more data is queued, the packets are dropped.
+const size_t kMaxPendingSize = 32 * 1024 * 1024; // 32 MB
+
+// The muxer writes many small blocks. They are written to the disk in large parts.
+const size_t kFileBufferSize = 1024 * 1024; // 1 MB
+
+} // namespace
+
 WebmFileWriter::WebmFileWriter(const std::filesystem::path& path, std::string_view name)
     : path_(path),
       name_(name)
 {
-    // Nothing
+    thread_.start(MessageLoop::Type::DEFAULT);
+    task_runner_ = thread_.taskRunner();
+    DCHECK(task_runner_);
 }
 
 WebmFileWriter::~WebmFileWriter()
 {
+    // The thread exits after the queued packets are written.
+    thread_.stop();
     close();
 }
 
 void WebmFileWriter::addVideoPacket(const proto::VideoPacket& packet)
 {
+    if (drop_video_)
+    {
+        // After the dropped packets the video can be continued only from a key frame.
+        if (!packet.has_format())
+            return;
+
+        drop_video_ = false;
+    }
+
+    if (!addPending(packet.ByteSizeLong()))
+    {
+        LOG(LS_WARNING) << "Video file writing is too slow. The video is dropped until a key frame";
+        drop_video_ = true;
+        return;
+    }
+
+    task_runner_->postTask(std::bind(&WebmFileWriter::writeVideoPacket,
+                                     this,
+                                     std::make_shared<proto::VideoPacket>(packet),
+                                     Clock::now()));
+}
+
+void WebmFileWriter::addAudioPacket(const proto::AudioPacket& packet)
+{
+    if (!addPending(packet.ByteSizeLong()))
+        return;
+
+    task_runner_->postTask(std::bind(&WebmFileWriter::writeAudioPacket,
+                                     this,
+                                     std::make_shared<proto::AudioPacket>(packet),
+                                     Clock::now()));
+}
+
+bool WebmFileWriter::addPending(size_t size)
+{
+    if (pending_size_.load(std::memory_order_relaxed) + size > kMaxPendingSize)
+        return false;
+
+    pending_size_.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
+
+void WebmFileWriter::writeVideoPacket(std::shared_ptr<proto::VideoPacket> video_packet,
+                                      TimePoint time)
+{
+    const proto::VideoPacket& packet = *video_packet;
+    pending_size_.fetch_sub(packet.ByteSizeLong(), std::memory_order_relaxed);
+
     if (packet.encoding() != last_video_encoding_ || packet.has_format())
     {
         close();
@@ -99,24 +161,15 @@ void WebmFileWriter::addVideoPacket(const proto::VideoPacket& packet)
     DCHECK(muxer_->hasVideoTrack());
     DCHECK(muxer_->hasAudioTrack());
 
-    TimePoint current = Clock::now();
-    NanoSeconds timestamp;
-
-    if (video_start_time_.has_value())
-    {
-        timestamp = std::chrono::duration_cast<NanoSeconds>(current - video_start_time_.value());
-    }
-    else
-    {
-        video_start_time_.emplace(current);
-        timestamp = NanoSeconds(0);
-    }
-
-    muxer_->writeVideoFrame(packet.data(), timestamp, is_key_frame);
+    muxer_->writeVideoFrame(packet.data(), timestamp(time), is_key_frame);
 }
 
-void WebmFileWriter::addAudioPacket(const proto::AudioPacket& packet)
+void WebmFileWriter::writeAudioPacket(std::shared_ptr<proto::AudioPacket> audio_packet,
+                                      TimePoint time)
 {
+    const proto::AudioPacket& packet = *audio_packet;
+    pending_size_.fetch_sub(packet.ByteSizeLong(), std::memory_order_relaxed);
+
     if (packet.encoding() != proto::AUDIO_ENCODING_OPUS ||
         packet.channels() != proto::AudioPacket::CHANNELS_STEREO ||
         packet.sampling_rate() != proto::AudioPacket::SAMPLING_RATE_48000)
@@ -129,23 +182,18 @@ void WebmFileWriter::addAudioPacket(const proto::AudioPacket& packet)
         return;
 
     for (int i = 0; i < packet.data_size(); ++i)
-    {
-        TimePoint current = Clock::now();
-        NanoSeconds timestamp;
-
-        if (video_start_time_.has_value())
-        {
-            timestamp = std::chrono::duration_cast<NanoSeconds>(
-                current - video_start_time_.value());
-        }
-        else
-        {
-            video_start_time_.emplace(current);
-            timestamp = NanoSeconds(0);
-        }
+        muxer_->writeAudioFrame(packet.data(i), timestamp(time));
+}
 
-        muxer_->writeAudioFrame(packet.data(i), timestamp);
+WebmFileWriter::NanoSeconds WebmFileWriter::timestamp(TimePoint time)
+{
+    if (!video_start_time_.has_value())
+    {
+        video_start_time_.emplace(time);
+        return NanoSeconds(0);
     }
+
+    return std::chrono::duration_cast<NanoSeconds>(time - video_start_time_.value());
 }
 
 bool WebmFileWriter::init()
@@ -183,6 +231,8 @@ bool WebmFileWriter::init()
         return false;
     }
 
+    setvbuf(file_, nullptr, _IOFBF, kFileBufferSize);
+
     muxer_ = std::make_unique<WebmFileMuxer>();
     if (!muxer_->init(file_))
     {
@@ -22,8 +22,10 @@
 #include "base/macros_magic.h"
 #include "base/desktop/geometry.h"
 #include "base/memory/byte_array.h"
+#include "base/threading/thread.h"
 #include "proto/desktop.pb.h"
 
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
@@ -34,28 +36,48 @@ namespace base {
 
 class WebmFileMuxer;
 
+// Muxing and writing are done in a separate thread, so a slow disk does not delay the caller. The
+// packets are queued with the time of their arrival. If the queue is too large, the packets are
+// dropped (the video until the next key frame).
 class WebmFileWriter
 {
 public:
     WebmFileWriter(const std::filesystem::path& path, std::string_view name);
+    // The queued packets are written before the file is closed.
     ~WebmFileWriter();
 
     void addVideoPacket(const proto::VideoPacket& packet);
     void addAudioPacket(const proto::AudioPacket& packet);
 
 private:
+    using Clock = std::chrono::high_resolution_clock;
+    using TimePoint = std::chrono::time_point<Clock>;
+    using NanoSeconds = std::chrono::nanoseconds;
+
+    // Returns false if the packet of |size| bytes does not fit in the queue.
+    bool addPending(size_t size);
+
+    // Called in the writer thread.
+    void writeVideoPacket(std::shared_ptr<proto::VideoPacket> packet, TimePoint time);
+    void writeAudioPacket(std::shared_ptr<proto::AudioPacket> packet, TimePoint time);
+    NanoSeconds timestamp(TimePoint time);
+
     bool init();
     void close();
 
+    Thread thread_;
+    std::shared_ptr<TaskRunner> task_runner_;
+
+    // Size of the packets which are queued and not written yet.
+    std::atomic<size_t> pending_size_ { 0 };
+    bool drop_video_ = false;
+
+    // The members below are used in the writer thread.
     std::filesystem::path path_;
     std::string name_;
     int file_counter_ = 0;
     FILE* file_ = nullptr;
 
-    using Clock = std::chrono::high_resolution_clock;
-    using TimePoint = std::chrono::time_point<Clock>;
-    using NanoSeconds = std::chrono::nanoseconds;
-
     std::unique_ptr<WebmFileMuxer> muxer_;
     std::optional<TimePoint> video_start_time_;
     std::optional<TimePoint> audio_start_time_;
@@ -21,6 +21,10 @@
 
 #include "build/build_config.h"
 
+#if defined(CC_MSVC)
+#include <intrin.h>
+#endif
+
 // Annotate a function indicating it should not be inlined.
 // Use like:
 //   NOINLINE void DoStuff() { ... }
@@ -40,4 +44,15 @@
 #define ALWAYS_INLINE inline
 #endif
 
+// Returns the address to which the current function returns (the program counter of its caller).
+// The function must not be inlined.
+#if defined(CC_MSVC)
+#define RETURN_ADDRESS() _ReturnAddress()
+#elif defined(CC_GCC) && !defined(OS_NACL)
+#define RETURN_ADDRESS() \
+  __builtin_extract_return_addr(__builtin_return_address(0))
+#else
+#define RETURN_ADDRESS() nullptr
+#endif
+
 #endif // BASE__COMPILER_SPECIFIC_H
@@ -30,6 +30,27 @@
 
 namespace base {
 
+namespace {
+
+// Returns the mask of the processor states enabled by the operating system (XCR0).
+uint64_t enabledProcessorStates()
+{
+    // Bit 27 of register ECX set to 1 indicates that the operating system uses XSAVE.
+    if (!BitSet<uint32_t>(CpuidUtil(1).ecx()).test(27))
+        return 0;
+
+#if defined(CC_MSVC)
+    return _xgetbv(0);
+#else
+    uint32_t eax;
+    uint32_t edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+} // namespace
+
 CpuidUtil::CpuidUtil(int leaf, int subleaf)
 {
     get(leaf, subleaf);
@@ -79,6 +100,46 @@ bool CpuidUtil::hasAesNi()
     return BitSet<uint32_t>(CpuidUtil(1).ecx()).test(25);
 }
 
+// static
+bool CpuidUtil::hasSse42()
+{
+    // Check if function 1 is supported.
+    if (CpuidUtil(0).eax() < 1)
+        return false;
+
+    // Bit 20 of register ECX set to 1 indicates the support of SSE 4.2 instructions.
+    return BitSet<uint32_t>(CpuidUtil(1).ecx()).test(20);
+}
+
+// static
+bool CpuidUtil::hasAvx2()
+{
+    // Check if function 7 is supported.
+    if (CpuidUtil(0).eax() < 7)
+        return false;
+
+    // The operating system must save the SSE (bit 1) and AVX (bit 2) registers.
+    if ((enabledProcessorStates() & 0x06) != 0x06)
+        return false;
+
+    // Bit 5 of register EBX of function 7 set to 1 indicates the support of AVX2 instructions.
+    return BitSet<uint32_t>(CpuidUtil(7).ebx()).test(5);
+}
+
+// static
+bool CpuidUtil::hasAvx512f()
+{
+    if (!hasAvx2())
+        return false;
+
+    // The operating system must also save the opmask and upper ZMM registers (bits 5-7).
+    if ((enabledProcessorStates() & 0xE6) != 0xE6)
+        return false;
+
+    // Bit 16 of register EBX of function 7 set to 1 indicates the support of AVX-512 Foundation.
+    return BitSet<uint32_t>(CpuidUtil(7).ebx()).test(16);
+}
+
 } // namespace base
 
 #endif // defined(ARCH_CPU_X86_FAMILY)
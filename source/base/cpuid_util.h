@@ -48,6 +48,11 @@ public:
     uint32_t edx() const { return edx_; }
 
     static bool hasAesNi();
+    static bool hasSse42();
+
+    // AVX2 and AVX-512 are reported only if they are also enabled by the operating system.
+    static bool hasAvx2();
+    static bool hasAvx512f();
 
 private:
     uint32_t eax_ = 0;
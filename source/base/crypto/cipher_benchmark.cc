@@ -0,0 +1,155 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/crypto/cipher_benchmark.h"
+
+#include "base/logging.h"
+#include "base/crypto/message_encryptor_openssl.h"
+#include "base/crypto/random.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+const size_t kKeySize = 32;
+const size_t kIVSize = 12;
+
+// Typical size of a message with video data.
+const size_t kMessageSize = 16 * 1024;
+
+constexpr std::chrono::milliseconds kDefaultDuration { 10 };
+
+uint32_t measure(std::unique_ptr<MessageEncryptor> encryptor, std::chrono::milliseconds duration)
+{
+    if (!encryptor)
+        return 0;
+
+    ByteArray input = Random::byteArray(kMessageSize);
+    ByteArray output;
+    output.resize(encryptor->encryptedDataSize(input.size()));
+
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point start_time = Clock::now();
+    Clock::duration elapsed;
+    uint64_t total_bytes = 0;
+
+    do
+    {
+        // Reading the clock is not free, so it is checked only after several messages.
+        for (int i = 0; i < 8; ++i)
+        {
+            if (!encryptor->encrypt(input.data(), input.size(), output.data()))
+                return 0;
+        }
+
+        total_bytes += 8 * input.size();
+        elapsed = Clock::now() - start_time;
+    }
+    while (elapsed < duration);
+
+    const int64_t elapsed_us =
+        std::max<int64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), 1);
+
+    // Bytes per microsecond are megabytes per second.
+    return static_cast<uint32_t>(total_bytes / static_cast<uint64_t>(elapsed_us));
+}
+
+uint32_t speedOf(proto::Encryption encryption, const CipherBenchmark::Result& result)
+{
+    switch (encryption)
+    {
+        case proto::ENCRYPTION_CHACHA20_POLY1305:
+            return result.chacha20_poly1305;
+
+        case proto::ENCRYPTION_AES256_GCM:
+            return result.aes256_gcm;
+
+        default:
+            return 0;
+    }
+}
+
+} // namespace
+
+// static
+const CipherBenchmark::Result& CipherBenchmark::current()
+{
+    static const Result result = []()
+    {
+        Result result = run(kDefaultDuration);
+
+        LOG(LS_INFO) << "Encryption speed: ChaCha20+Poly1305 " << result.chacha20_poly1305
+                     << " MB/s, AES256 GCM " << result.aes256_gcm << " MB/s";
+        return result;
+    }();
+
+    return result;
+}
+
+// static
+CipherBenchmark::Result CipherBenchmark::run(std::chrono::milliseconds duration)
+{
+    const ByteArray key = Random::byteArray(kKeySize);
+    const ByteArray iv = Random::byteArray(kIVSize);
+
+    Result result;
+    result.chacha20_poly1305 =
+        measure(MessageEncryptorOpenssl::createForChaCha20Poly1305(key, iv), duration);
+    result.aes256_gcm = measure(MessageEncryptorOpenssl::createForAes256Gcm(key, iv), duration);
+    return result;
+}
+
+// static
+proto::Encryption CipherBenchmark::select(
+    uint32_t methods, const Result& local, const Result& peer)
+{
+    // ChaCha20+Poly1305 goes first: it wins if the speeds are equal or unknown.
+    static const proto::Encryption kMethods[] =
+    {
+        proto::ENCRYPTION_CHACHA20_POLY1305,
+        proto::ENCRYPTION_AES256_GCM
+    };
+
+    proto::Encryption best_method = proto::ENCRYPTION_UNKNOWN;
+    uint32_t best_speed = 0;
+
+    for (proto::Encryption method : kMethods)
+    {
+        if (!(methods & method))
+            continue;
+
+        uint32_t speed = speedOf(method, local);
+        uint32_t peer_speed = speedOf(method, peer);
+        if (peer_speed)
+            speed = std::min(speed, peer_speed);
+
+        if (best_method == proto::ENCRYPTION_UNKNOWN || speed > best_speed)
+        {
+            best_method = method;
+            best_speed = speed;
+        }
+    }
+
+    return best_method;
+}
+
+} // namespace base
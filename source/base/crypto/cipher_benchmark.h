@@ -0,0 +1,60 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__CRYPTO__CIPHER_BENCHMARK_H
+#define BASE__CRYPTO__CIPHER_BENCHMARK_H
+
+#include "base/macros_magic.h"
+#include "proto/key_exchange.pb.h"
+
+#include <chrono>
+
+namespace base {
+
+// Measures how fast the message encryption methods work on the current CPU. Which method is
+// faster depends on hardware support: with AES instructions AES256 GCM is several times faster,
+// without them ChaCha20+Poly1305 wins.
+class CipherBenchmark
+{
+public:
+    // Encryption speed in megabytes per second. Zero if unknown.
+    struct Result
+    {
+        uint32_t chacha20_poly1305 = 0;
+        uint32_t aes256_gcm = 0;
+    };
+
+    // Returns the result for the current CPU. The benchmark runs once per process on the first
+    // call and takes about 20 ms.
+    static const Result& current();
+
+    // Encrypts messages with each method for |duration|.
+    static Result run(std::chrono::milliseconds duration);
+
+    // Returns the fastest method from |methods| (a bitmask of proto::Encryption values) for a
+    // connection between two peers. The slower side limits the speed of the connection. If the
+    // speed of the peer is unknown, only the local speed is used.
+    static proto::Encryption select(uint32_t methods, const Result& local, const Result& peer);
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CipherBenchmark);
+};
+
+} // namespace base
+
+#endif // BASE__CRYPTO__CIPHER_BENCHMARK_H
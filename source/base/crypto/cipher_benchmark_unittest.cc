@@ -0,0 +1,70 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/crypto/cipher_benchmark.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(CipherBenchmarkTest, Run)
+{
+    CipherBenchmark::Result result = CipherBenchmark::run(std::chrono::milliseconds(1));
+    EXPECT_GT(result.chacha20_poly1305, 0u);
+    EXPECT_GT(result.aes256_gcm, 0u);
+}
+
+TEST(CipherBenchmarkTest, Select)
+{
+    const uint32_t kAll = proto::ENCRYPTION_CHACHA20_POLY1305 | proto::ENCRYPTION_AES256_GCM;
+
+    CipherBenchmark::Result fast_aes;
+    fast_aes.chacha20_poly1305 = 1000;
+    fast_aes.aes256_gcm = 3000;
+
+    CipherBenchmark::Result slow_aes;
+    slow_aes.chacha20_poly1305 = 300;
+    slow_aes.aes256_gcm = 100;
+
+    CipherBenchmark::Result unknown;
+
+    // Both sides are faster with AES.
+    EXPECT_EQ(CipherBenchmark::select(kAll, fast_aes, fast_aes), proto::ENCRYPTION_AES256_GCM);
+
+    // The slower side decides.
+    EXPECT_EQ(CipherBenchmark::select(kAll, fast_aes, slow_aes),
+              proto::ENCRYPTION_CHACHA20_POLY1305);
+    EXPECT_EQ(CipherBenchmark::select(kAll, slow_aes, fast_aes),
+              proto::ENCRYPTION_CHACHA20_POLY1305);
+
+    // Only the offered methods are used.
+    EXPECT_EQ(CipherBenchmark::select(proto::ENCRYPTION_CHACHA20_POLY1305, fast_aes, fast_aes),
+              proto::ENCRYPTION_CHACHA20_POLY1305);
+    EXPECT_EQ(CipherBenchmark::select(proto::ENCRYPTION_AES256_GCM, slow_aes, slow_aes),
+              proto::ENCRYPTION_AES256_GCM);
+    EXPECT_EQ(CipherBenchmark::select(0, fast_aes, fast_aes), proto::ENCRYPTION_UNKNOWN);
+
+    // The local speed is used when the peer does not report its speed.
+    EXPECT_EQ(CipherBenchmark::select(kAll, fast_aes, unknown), proto::ENCRYPTION_AES256_GCM);
+    EXPECT_EQ(CipherBenchmark::select(kAll, slow_aes, unknown),
+              proto::ENCRYPTION_CHACHA20_POLY1305);
+    EXPECT_EQ(CipherBenchmark::select(kAll, unknown, unknown),
+              proto::ENCRYPTION_CHACHA20_POLY1305);
+}
+
+} // namespace base
@@ -106,6 +106,43 @@ void wrongKey(MessageEncryptor* client_encryptor, MessageDecryptor* host_decrypt
     ASSERT_FALSE(ret);
 }
 
+void inPlace(MessageEncryptor* encryptor, MessageDecryptor* decryptor)
+{
+    const ByteArray message = fromHex(
+        "6006ee8029610876ec2facd5fc9ce6bd6dc03d4a5ddb4d6c28f2ff048d4f7eb7bcf5048c901a4adaa7fd");
+
+    const size_t overhead = encryptor->encryptedDataSize(message.size()) - message.size();
+
+    // The message is placed after the space for the encryption overhead.
+    ByteArray buffer;
+    buffer.resize(overhead + message.size());
+    memcpy(buffer.data() + overhead, message.data(), message.size());
+
+    bool ret = encryptor->encrypt(buffer.data() + overhead, message.size(), buffer.data());
+    ASSERT_TRUE(ret);
+
+    ByteArray decrypted;
+    decrypted.resize(decryptor->decryptedDataSize(buffer.size()));
+
+    ret = decryptor->decrypt(buffer.data(), buffer.size(), decrypted.data());
+    ASSERT_TRUE(ret);
+    ASSERT_EQ(decrypted, message);
+
+    // The tag is separated from the data and the data is decrypted in place.
+    memcpy(buffer.data() + overhead, message.data(), message.size());
+
+    ret = encryptor->encrypt(buffer.data() + overhead, message.size(), buffer.data());
+    ASSERT_TRUE(ret);
+    ASSERT_EQ(decryptor->tagSize(), overhead);
+
+    ByteArray tag(buffer.begin(), buffer.begin() + overhead);
+    ByteArray data(buffer.begin() + overhead, buffer.end());
+
+    ret = decryptor->decryptInPlace(tag.data(), data.data(), data.size());
+    ASSERT_TRUE(ret);
+    ASSERT_EQ(data, message);
+}
+
 TEST(CryptorAes256GcmTest, TestVector)
 {
     const ByteArray key =
@@ -162,6 +199,24 @@ TEST(CryptorAes256GcmTest, WrongKey)
     wrongKey(client_encryptor.get(), host_decryptor.get());
 }
 
+TEST(CryptorAes256GcmTest, InPlace)
+{
+    const ByteArray key =
+        fromHex("5ce26794165a808ec425684e9384c27c22499512a513da8b455bd39746dc5014");
+    const ByteArray iv = fromHex("ee7eb0e6fb24d445597f3e6f");
+
+    std::unique_ptr<MessageEncryptor> encryptor =
+        MessageEncryptorOpenssl::createForAes256Gcm(key, iv);
+    ASSERT_NE(encryptor, nullptr);
+
+    std::unique_ptr<MessageDecryptor> decryptor =
+        MessageDecryptorOpenssl::createForAes256Gcm(key, iv);
+    ASSERT_NE(decryptor, nullptr);
+
+    for (int i = 0; i < 100; ++i)
+        inPlace(encryptor.get(), decryptor.get());
+}
+
 TEST(CryptorChaCha20Poly1305Test, TestVector)
 {
     const ByteArray key =
@@ -218,4 +273,22 @@ TEST(CryptorChaCha20Poly1305Test, WrongKey)
     wrongKey(client_encryptor.get(), host_decryptor.get());
 }
 
+TEST(CryptorChaCha20Poly1305Test, InPlace)
+{
+    const ByteArray key =
+        fromHex("5ce26794165a808ec425684e9384c27c22499512a513da8b455bd39746dc5014");
+    const ByteArray iv = fromHex("ee7eb0e6fb24d445597f3e6f");
+
+    std::unique_ptr<MessageEncryptor> encryptor =
+        MessageEncryptorOpenssl::createForChaCha20Poly1305(key, iv);
+    ASSERT_NE(encryptor, nullptr);
+
+    std::unique_ptr<MessageDecryptor> decryptor =
+        MessageDecryptorOpenssl::createForChaCha20Poly1305(key, iv);
+    ASSERT_NE(decryptor, nullptr);
+
+    for (int i = 0; i < 100; ++i)
+        inPlace(encryptor.get(), decryptor.get());
+}
+
 } // namespace base
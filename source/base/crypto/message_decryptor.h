@@ -30,6 +30,14 @@ public:
 
     virtual size_t decryptedDataSize(size_t in_size) = 0;
     virtual bool decrypt(const void* in, size_t in_size, void* out) = 0;
+
+    // Size of the authentication tag in front of the encrypted data.
+    virtual size_t tagSize() = 0;
+
+    // Decrypts |size| bytes of |data| in place. |tag| points to the tagSize() bytes which precede
+    // the encrypted data in the message. The tag does not have to be stored next to the data, so a
+    // message can be received with a scatter read straight into its final buffer.
+    virtual bool decryptInPlace(const void* tag, void* data, size_t size) = 0;
 };
 
 } // namespace base
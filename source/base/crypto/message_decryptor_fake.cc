@@ -37,4 +37,15 @@ bool MessageDecryptorFake::decrypt(const void* in, size_t in_size, void* out)
     return true;
 }
 
+size_t MessageDecryptorFake::tagSize()
+{
+    return 0;
+}
+
+bool MessageDecryptorFake::decryptInPlace(const void* /* tag */, void* /* data */,
+                                          size_t /* size */)
+{
+    return true;
+}
+
 } // namespace base
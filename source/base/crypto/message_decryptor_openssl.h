@@ -40,10 +40,14 @@ public:
     // MessageDecryptor implementation.
     size_t decryptedDataSize(size_t in_size) override;
     bool decrypt(const void* in, size_t in_size, void* out) override;
+    size_t tagSize() override;
+    bool decryptInPlace(const void* tag, void* data, size_t size) override;
 
 private:
     MessageDecryptorOpenssl(EVP_CIPHER_CTX_ptr ctx, const ByteArray& iv);
 
+    bool decryptImpl(const void* tag, const void* in, size_t in_size, void* out);
+
     EVP_CIPHER_CTX_ptr ctx_;
     ByteArray iv_;
 
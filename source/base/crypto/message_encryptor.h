@@ -29,6 +29,10 @@ public:
     virtual ~MessageEncryptor() = default;
 
     virtual size_t encryptedDataSize(size_t in_size) = 0;
+
+    // Encrypts |in_size| bytes from |in| to |out|. The size of the output buffer must be at least
+    // encryptedDataSize(in_size). In-place encryption is supported: |out| may point exactly
+    // (encryptedDataSize(in_size) - in_size) bytes in front of |in|.
     virtual bool encrypt(const void* in, size_t in_size, void* out) = 0;
 };
 
@@ -0,0 +1,73 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/crypto/message_encryptor_openssl.h"
+#include "base/memory/byte_array.h"
+
+#include <benchmark/benchmark.h>
+
+namespace base {
+
+namespace {
+
+const size_t kKeySize = 32;
+const size_t kIVSize = 12;
+
+void runMessageEncryptor(benchmark::State& state, std::unique_ptr<MessageEncryptor> encryptor)
+{
+    if (!encryptor)
+    {
+        state.SkipWithError("Unable to create encryptor");
+        return;
+    }
+
+    const size_t input_size = static_cast<size_t>(state.range(0));
+    ByteArray input(input_size, 0x5A);
+    ByteArray output(encryptor->encryptedDataSize(input_size));
+
+    for (auto _ : state)
+    {
+        if (!encryptor->encrypt(input.data(), input.size(), output.data()))
+        {
+            state.SkipWithError("Encryption failed");
+            break;
+        }
+
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_EncryptAes256Gcm(benchmark::State& state)
+{
+    runMessageEncryptor(state, MessageEncryptorOpenssl::createForAes256Gcm(
+        ByteArray(kKeySize, 0x11), ByteArray(kIVSize, 0x22)));
+}
+BENCHMARK(BM_EncryptAes256Gcm)->Arg(64)->Arg(1024)->Arg(16384)->Arg(65536);
+
+void BM_EncryptChaCha20Poly1305(benchmark::State& state)
+{
+    runMessageEncryptor(state, MessageEncryptorOpenssl::createForChaCha20Poly1305(
+        ByteArray(kKeySize, 0x11), ByteArray(kIVSize, 0x22)));
+}
+BENCHMARK(BM_EncryptChaCha20Poly1305)->Arg(64)->Arg(1024)->Arg(16384)->Arg(65536);
+
+} // namespace
+
+} // namespace base
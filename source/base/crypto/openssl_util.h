@@ -25,6 +25,7 @@
 
 struct bignum_ctx;
 struct bignum_st;
+struct bn_mont_ctx_st;
 struct evp_cipher_ctx_st;
 struct evp_pkey_ctx_st;
 struct evp_pkey_st;
@@ -41,6 +42,11 @@ struct BIGNUM_Deleter
     void operator()(bignum_st* bignum);
 };
 
+struct BN_MONT_CTX_Deleter
+{
+    void operator()(bn_mont_ctx_st* mont_ctx);
+};
+
 struct EVP_CIPHER_CTX_Deleter
 {
     void operator()(evp_cipher_ctx_st* ctx);
@@ -58,6 +64,7 @@ struct EVP_PKEY_Deleter
 
 using BIGNUM_CTX_ptr = std::unique_ptr<bignum_ctx, BIGNUM_CTX_Deleter>;
 using BIGNUM_ptr = std::unique_ptr<bignum_st, BIGNUM_Deleter>;
+using BN_MONT_CTX_ptr = std::unique_ptr<bn_mont_ctx_st, BN_MONT_CTX_Deleter>;
 using EVP_CIPHER_CTX_ptr = std::unique_ptr<evp_cipher_ctx_st, EVP_CIPHER_CTX_Deleter>;
 using EVP_PKEY_CTX_ptr = std::unique_ptr<evp_pkey_ctx_st, EVP_PKEY_CTX_Deleter>;
 using EVP_PKEY_ptr = std::unique_ptr<evp_pkey_st, EVP_PKEY_Deleter>;
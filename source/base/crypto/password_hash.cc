@@ -19,40 +19,166 @@
 #include "crypto/password_hash.h"
 
 #include "base/logging.h"
+#include "base/threading/thread_pool.h"
 
+#include <openssl/crypto.h>
 #include <openssl/evp.h>
 
+#include <algorithm>
+#include <vector>
+
 namespace base {
 
 namespace {
 
+// CPU/Memory cost parameter, must be larger than 1, a power of 2, and less than 2^(128 * r / 8).
+const uint64_t kCost = 16384;
+
+// Block size parameter.
+const uint64_t kBlockSize = 8;
+
+// Parallelization parameter, a positive integer less than or equal to ((2^32-1) * hLen) / MFLen
+// where hLen is 32 and MFlen is 128 * r.
+const uint64_t kParallelism = 2;
+
+// Size of the data of one lane (the output of BlockMix).
+const size_t kLaneSize = 128 * kBlockSize;
+
+uint32_t load32(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+void store32(uint8_t* data, uint32_t value)
+{
+    data[0] = static_cast<uint8_t>(value);
+    data[1] = static_cast<uint8_t>(value >> 8);
+    data[2] = static_cast<uint8_t>(value >> 16);
+    data[3] = static_cast<uint8_t>(value >> 24);
+}
+
+uint32_t rotl(uint32_t value, int shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+// Salsa20/8 core (RFC 7914, section 3).
+void salsa20_8(uint32_t block[16])
+{
+    uint32_t x[16];
+    std::copy(block, block + 16, x);
+
+    for (int i = 0; i < 8; i += 2)
+    {
+        x[ 4] ^= rotl(x[ 0] + x[12],  7); x[ 8] ^= rotl(x[ 4] + x[ 0],  9);
+        x[12] ^= rotl(x[ 8] + x[ 4], 13); x[ 0] ^= rotl(x[12] + x[ 8], 18);
+        x[ 9] ^= rotl(x[ 5] + x[ 1],  7); x[13] ^= rotl(x[ 9] + x[ 5],  9);
+        x[ 1] ^= rotl(x[13] + x[ 9], 13); x[ 5] ^= rotl(x[ 1] + x[13], 18);
+        x[14] ^= rotl(x[10] + x[ 6],  7); x[ 2] ^= rotl(x[14] + x[10],  9);
+        x[ 6] ^= rotl(x[ 2] + x[14], 13); x[10] ^= rotl(x[ 6] + x[ 2], 18);
+        x[ 3] ^= rotl(x[15] + x[11],  7); x[ 7] ^= rotl(x[ 3] + x[15],  9);
+        x[11] ^= rotl(x[ 7] + x[ 3], 13); x[15] ^= rotl(x[11] + x[ 7], 18);
+        x[ 1] ^= rotl(x[ 0] + x[ 3],  7); x[ 2] ^= rotl(x[ 1] + x[ 0],  9);
+        x[ 3] ^= rotl(x[ 2] + x[ 1], 13); x[ 0] ^= rotl(x[ 3] + x[ 2], 18);
+        x[ 6] ^= rotl(x[ 5] + x[ 4],  7); x[ 7] ^= rotl(x[ 6] + x[ 5],  9);
+        x[ 4] ^= rotl(x[ 7] + x[ 6], 13); x[ 5] ^= rotl(x[ 4] + x[ 7], 18);
+        x[11] ^= rotl(x[10] + x[ 9],  7); x[ 8] ^= rotl(x[11] + x[10],  9);
+        x[ 9] ^= rotl(x[ 8] + x[11], 13); x[10] ^= rotl(x[ 9] + x[ 8], 18);
+        x[12] ^= rotl(x[15] + x[14],  7); x[13] ^= rotl(x[12] + x[15],  9);
+        x[14] ^= rotl(x[13] + x[12], 13); x[15] ^= rotl(x[14] + x[13], 18);
+    }
+
+    for (int i = 0; i < 16; ++i)
+        block[i] += x[i];
+}
+
+// scryptBlockMix (RFC 7914, section 4). |in| and |out| contain 2 * r 64-byte blocks.
+void blockMix(const uint32_t* in, uint32_t* out)
+{
+    uint32_t x[16];
+    std::copy(in + (2 * kBlockSize - 1) * 16, in + 2 * kBlockSize * 16, x);
+
+    for (size_t i = 0; i < 2 * kBlockSize; ++i)
+    {
+        for (int j = 0; j < 16; ++j)
+            x[j] ^= in[i * 16 + j];
+
+        salsa20_8(x);
+
+        // Even blocks go to the first half of the output, odd blocks to the second.
+        std::copy(x, x + 16, out + ((i / 2) + (i & 1) * kBlockSize) * 16);
+    }
+}
+
+// scryptROMix (RFC 7914, section 5). Works on one lane of |kLaneSize| bytes in place.
+void roMix(uint8_t* lane)
+{
+    const size_t kWords = kLaneSize / sizeof(uint32_t);
+
+    std::vector<uint32_t> v(kWords * kCost);
+    std::vector<uint32_t> x(kWords);
+    std::vector<uint32_t> t(kWords);
+
+    for (size_t i = 0; i < kWords; ++i)
+        x[i] = load32(lane + i * sizeof(uint32_t));
+
+    for (uint64_t i = 0; i < kCost; ++i)
+    {
+        std::copy(x.begin(), x.end(), v.begin() + i * kWords);
+        blockMix(x.data(), t.data());
+        x.swap(t);
+    }
+
+    for (uint64_t i = 0; i < kCost; ++i)
+    {
+        // Integerify: the first word of the last 64-byte block (N fits in 32 bits).
+        const uint64_t j = x[(2 * kBlockSize - 1) * 16] & (kCost - 1);
+
+        for (size_t k = 0; k < kWords; ++k)
+            x[k] ^= v[j * kWords + k];
+
+        blockMix(x.data(), t.data());
+        x.swap(t);
+    }
+
+    for (size_t i = 0; i < kWords; ++i)
+        store32(lane + i * sizeof(uint32_t), x[i]);
+
+    OPENSSL_cleanse(v.data(), v.size() * sizeof(uint32_t));
+    OPENSSL_cleanse(x.data(), x.size() * sizeof(uint32_t));
+    OPENSSL_cleanse(t.data(), t.size() * sizeof(uint32_t));
+}
+
+// scrypt (RFC 7914, section 6). The lanes are independent and are processed in parallel.
 template <typename InputT, typename OutputT>
 OutputT hashT(PasswordHash::Type type, std::string_view password, InputT salt)
 {
     DCHECK_EQ(type, PasswordHash::Type::SCRYPT);
 
-    // CPU/Memory cost parameter, must be larger than 1, a power of 2, and less than 2^(128 * r / 8).
-    static const uint64_t N = 16384;
-
-    // Block size parameter.
-    static const uint64_t r = 8;
+    ByteArray lanes;
+    lanes.resize(kParallelism * kLaneSize);
 
-    // Parallelization parameter, a positive integer less than or equal to ((2^32-1) * hLen) / MFLen
-    // where hLen is 32 and MFlen is 128 * r.
-    static const uint64_t p = 2;
+    int ret = PKCS5_PBKDF2_HMAC(password.data(), static_cast<int>(password.size()),
+                                reinterpret_cast<const uint8_t*>(salt.data()),
+                                static_cast<int>(salt.size()), 1, EVP_sha256(),
+                                static_cast<int>(lanes.size()), lanes.data());
+    CHECK_EQ(ret, 1) << "PKCS5_PBKDF2_HMAC failed";
 
-    // 32MB
-    static const uint64_t max_mem = 32 * 1024 * 1024;
+    // Each lane needs 128 * r * N bytes (16 MB).
+    ThreadPool::shared()->parallelFor(
+        kParallelism, [&lanes](size_t index) { roMix(lanes.data() + index * kLaneSize); });
 
     OutputT result;
     result.resize(PasswordHash::kBytesSize);
 
-    int ret = EVP_PBE_scrypt(password.data(), password.size(),
-                             reinterpret_cast<const uint8_t*>(salt.data()), salt.size(),
-                             N, r, p, max_mem,
-                             reinterpret_cast<uint8_t*>(result.data()), result.size());
-    CHECK_EQ(ret, 1) << "EVP_PBE_scrypt failed";
+    ret = PKCS5_PBKDF2_HMAC(password.data(), static_cast<int>(password.size()),
+                            lanes.data(), static_cast<int>(lanes.size()), 1, EVP_sha256(),
+                            static_cast<int>(result.size()),
+                            reinterpret_cast<uint8_t*>(result.data()));
+    CHECK_EQ(ret, 1) << "PKCS5_PBKDF2_HMAC failed";
 
+    OPENSSL_cleanse(lanes.data(), lanes.size());
     return result;
 }
 
@@ -26,6 +26,9 @@
 #include <openssl/opensslv.h>
 #include <openssl/bn.h>
 
+#include <mutex>
+#include <vector>
+
 namespace base {
 
 namespace {
@@ -62,6 +65,91 @@ BigNum calc_k(const BigNum& N, const BigNum& g)
     return calc_xy(N, g, N);
 }
 
+// Values which depend only on the group. Every handshake uses one of a few fixed groups, so they
+// are computed once and shared by all handshakes.
+struct SrpGroup
+{
+    BigNum N;
+    BigNum g;
+    BigNum k;
+    BN_MONT_CTX_ptr mont;
+};
+
+// Groups other than the standard ones are not cached after this limit.
+const size_t kMaxCachedGroups = 16;
+
+BigNum copyOf(const BigNum& num)
+{
+    BigNum result;
+    result.reset(BN_dup(num));
+    return result;
+}
+
+std::shared_ptr<SrpGroup> createGroup(const BigNum& N, const BigNum& g, bignum_ctx* ctx)
+{
+    std::shared_ptr<SrpGroup> group = std::make_shared<SrpGroup>();
+
+    group->N = copyOf(N);
+    if (!group->N.isValid())
+        return nullptr;
+
+    group->mont.reset(BN_MONT_CTX_new());
+    if (!group->mont || !BN_MONT_CTX_set(group->mont.get(), N, ctx))
+        return nullptr;
+
+    if (g.isValid())
+    {
+        group->g = copyOf(g);
+        group->k = calc_k(N, g);
+        if (!group->g.isValid() || !group->k.isValid())
+            return nullptr;
+    }
+
+    return group;
+}
+
+// Returns the group with modulus |N|. If |g| is valid, the multiplier k of the group is also
+// available.
+std::shared_ptr<const SrpGroup> srpGroup(const BigNum& N, const BigNum& g, bignum_ctx* ctx)
+{
+    static std::mutex lock;
+    static std::vector<std::shared_ptr<SrpGroup>> groups;
+
+    std::scoped_lock scoped_lock(lock);
+
+    for (const auto& group : groups)
+    {
+        if (BN_cmp(group->N, N) != 0)
+            continue;
+
+        if (!g.isValid() || (group->g.isValid() && BN_cmp(group->g, g) == 0))
+            return group;
+    }
+
+    std::shared_ptr<SrpGroup> group = createGroup(N, g, ctx);
+    if (group && groups.size() < kMaxCachedGroups)
+        groups.emplace_back(group);
+
+    return group;
+}
+
+// Contexts hold temporary variables of the calculations. One context per thread is enough.
+bignum_ctx* threadContext()
+{
+    thread_local BigNum::Context ctx = BigNum::Context::create();
+    return ctx;
+}
+
+// r = a^p % N. The generator of all standard groups fits in a machine word, and the special
+// algorithm for a single word base is several times faster than the generic one.
+bool modExp(BigNum* r, const BigNum& a, const BigNum& p, const SrpGroup& group, bignum_ctx* ctx)
+{
+    if (BN_num_bits(a) <= BN_BITS2 && BN_ucmp(a, group.N) < 0)
+        return BN_mod_exp_mont_word(*r, BN_get_word(a), p, group.N, ctx, group.mont.get()) == 1;
+
+    return BN_mod_exp_mont(*r, a, p, group.N, ctx, group.mont.get()) == 1;
+}
+
 } // namespace
 
 // static
@@ -78,26 +166,26 @@ BigNum SrpMath::calc_B(const BigNum& b, const BigNum& N, const BigNum& g, const
     if (!b.isValid() || !N.isValid() || !g.isValid() || !v.isValid())
         return BigNum();
 
-    BigNum::Context ctx = BigNum::Context::create();
-    if (!ctx.isValid())
+    bignum_ctx* ctx = threadContext();
+    if (!ctx)
         return BigNum();
 
-    BigNum gb = BigNum::create();
-    if (!gb.isValid())
+    std::shared_ptr<const SrpGroup> group = srpGroup(N, g, ctx);
+    if (!group)
         return BigNum();
 
-    if (!BN_mod_exp(gb, g, b, N, ctx))
+    BigNum gb = BigNum::create();
+    if (!gb.isValid())
         return BigNum();
 
-    BigNum k = calc_k(N, g);
-    if (!k.isValid())
+    if (!modExp(&gb, g, b, *group, ctx))
         return BigNum();
 
     BigNum kv = BigNum::create();
     if (!kv.isValid())
         return BigNum();
 
-    if (!BN_mod_mul(kv, v, k, N, ctx))
+    if (!BN_mod_mul(kv, v, group->k, N, ctx))
         return BigNum();
 
     BigNum B = BigNum::create();
@@ -147,13 +235,17 @@ BigNum SrpMath::calc_A(const BigNum& a, const BigNum& N, const BigNum& g)
     if (!a.isValid() || !N.isValid() || !g.isValid())
         return BigNum();
 
-    BigNum::Context ctx = BigNum::Context::create();
+    bignum_ctx* ctx = threadContext();
     BigNum A = BigNum::create();
 
-    if (!A.isValid() || !ctx.isValid())
+    if (!A.isValid() || !ctx)
+        return BigNum();
+
+    std::shared_ptr<const SrpGroup> group = srpGroup(N, g, ctx);
+    if (!group)
         return BigNum();
 
-    if (!BN_mod_exp(A, g, a, N, ctx))
+    if (!modExp(&A, g, a, *group, ctx))
         return BigNum();
 
     return A;
@@ -170,13 +262,17 @@ BigNum SrpMath::calcServerKey(const BigNum& A, const BigNum& v, const BigNum& u,
         return BigNum();
     }
 
-    BigNum::Context ctx = BigNum::Context::create();
+    bignum_ctx* ctx = threadContext();
     BigNum tmp = BigNum::create();
 
-    if (!ctx.isValid() || !tmp.isValid())
+    if (!ctx || !tmp.isValid())
         return BigNum();
 
-    if (!BN_mod_exp(tmp, v, u, N, ctx))
+    std::shared_ptr<const SrpGroup> group = srpGroup(N, BigNum(), ctx);
+    if (!group)
+        return BigNum();
+
+    if (!modExp(&tmp, v, u, *group, ctx))
         return BigNum();
 
     if (!BN_mod_mul(tmp, A, tmp, N, ctx))
@@ -186,7 +282,7 @@ BigNum SrpMath::calcServerKey(const BigNum& A, const BigNum& v, const BigNum& u,
     if (!S.isValid())
         return BigNum();
 
-    if (!BN_mod_exp(S, tmp, b, N, ctx))
+    if (!modExp(&S, tmp, b, *group, ctx))
         return BigNum();
 
     return S;
@@ -200,8 +296,12 @@ BigNum SrpMath::calcClientKey(const BigNum& N, const BigNum& B, const BigNum& g,
     if (!N.isValid() || !B.isValid() || !g.isValid() || !x.isValid() || !a.isValid() || !u.isValid())
         return BigNum();
 
-    BigNum::Context ctx = BigNum::Context::create();
-    if (!ctx.isValid())
+    bignum_ctx* ctx = threadContext();
+    if (!ctx)
+        return BigNum();
+
+    std::shared_ptr<const SrpGroup> group = srpGroup(N, g, ctx);
+    if (!group)
         return BigNum();
 
     BigNum tmp = BigNum::create();
@@ -211,14 +311,10 @@ BigNum SrpMath::calcClientKey(const BigNum& N, const BigNum& B, const BigNum& g,
     if (!tmp.isValid() || !tmp2.isValid() || !tmp3.isValid())
         return BigNum();
 
-    if (!BN_mod_exp(tmp, g, x, N, ctx))
-        return BigNum();
-
-    BigNum k = calc_k(N, g);
-    if (!k.isValid())
+    if (!modExp(&tmp, g, x, *group, ctx))
         return BigNum();
 
-    if (!BN_mod_mul(tmp2, tmp, k, N, ctx))
+    if (!BN_mod_mul(tmp2, tmp, group->k, N, ctx))
         return BigNum();
 
     if (!BN_mod_sub(tmp, B, tmp2, N, ctx))
@@ -234,7 +330,7 @@ BigNum SrpMath::calcClientKey(const BigNum& N, const BigNum& B, const BigNum& g,
     if (!K.isValid())
         return BigNum();
 
-    if (!BN_mod_exp(K, tmp, tmp2, N, ctx))
+    if (!modExp(&K, tmp, tmp2, *group, ctx))
         return BigNum();
 
     return K;
@@ -246,10 +342,10 @@ bool SrpMath::verify_B_mod_N(const BigNum& B, const BigNum& N)
     if (!B.isValid() || !N.isValid())
         return false;
 
-    BigNum::Context ctx = BigNum::Context::create();
+    bignum_ctx* ctx = threadContext();
     BigNum result = BigNum::create();
 
-    if (!ctx.isValid() || !result.isValid())
+    if (!ctx || !result.isValid())
         return false;
 
     if (!BN_nnmod(result, B, N, ctx))
@@ -271,15 +367,21 @@ BigNum SrpMath::calc_v(std::u16string_view I, std::u16string_view p, const BigNu
     if (I.empty() || p.empty() || !N.isValid() || !g.isValid() || !s.isValid())
         return BigNum();
 
-    BigNum::Context ctx = BigNum::Context::create();
+    bignum_ctx* ctx = threadContext();
     BigNum v = BigNum::create();
 
-    if (!ctx.isValid() || !v.isValid())
+    if (!ctx || !v.isValid())
+        return BigNum();
+
+    std::shared_ptr<const SrpGroup> group = srpGroup(N, g, ctx);
+    if (!group)
         return BigNum();
 
     BigNum x = calc_x(s, I, p);
+    if (!x.isValid())
+        return BigNum();
 
-    if (!BN_mod_exp(v, g, x, N, ctx))
+    if (!modExp(&v, g, x, *group, ctx))
         return BigNum();
 
     return v;
@@ -292,15 +394,21 @@ BigNum SrpMath::calc_v(std::u16string_view I, const ByteArray& p, const BigNum&
     if (I.empty() || p.empty() || !N.isValid() || !g.isValid() || !s.isValid())
         return BigNum();
 
-    BigNum::Context ctx = BigNum::Context::create();
+    bignum_ctx* ctx = threadContext();
     BigNum v = BigNum::create();
 
-    if (!ctx.isValid() || !v.isValid())
+    if (!ctx || !v.isValid())
+        return BigNum();
+
+    std::shared_ptr<const SrpGroup> group = srpGroup(N, g, ctx);
+    if (!group)
         return BigNum();
 
     BigNum x = calc_x(s, I, p);
+    if (!x.isValid())
+        return BigNum();
 
-    if (!BN_mod_exp(v, g, x, N, ctx))
+    if (!modExp(&v, g, x, *group, ctx))
         return BigNum();
 
     return v;
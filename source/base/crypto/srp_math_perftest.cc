@@ -0,0 +1,93 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/crypto/random.h"
+#include "base/crypto/srp_constants.h"
+#include "base/crypto/srp_math.h"
+
+#include <benchmark/benchmark.h>
+
+namespace base {
+
+namespace {
+
+// Performs the calculations of both sides of a handshake. Returns true if the keys are equal.
+bool handshake(const SrpNgPair& Ng_pair)
+{
+    const std::u16string I = u"alice";
+    const std::u16string p = u"password123";
+
+    BigNum N = BigNum::fromStdString(Ng_pair.first);
+    BigNum g = BigNum::fromStdString(Ng_pair.second);
+    BigNum s = BigNum::fromByteArray(Random::byteArray(64));
+    BigNum v = SrpMath::calc_v(I, p, s, N, g);
+
+    BigNum b = BigNum::fromByteArray(Random::byteArray(128));
+    BigNum B = SrpMath::calc_B(b, N, g, v);
+
+    BigNum a = BigNum::fromByteArray(Random::byteArray(128));
+    BigNum A = SrpMath::calc_A(a, N, g);
+
+    if (!SrpMath::verify_A_mod_N(A, N) || !SrpMath::verify_B_mod_N(B, N))
+        return false;
+
+    BigNum u = SrpMath::calc_u(A, B, N);
+    BigNum x = SrpMath::calc_x(s, I, p);
+
+    BigNum server_key = SrpMath::calcServerKey(A, v, u, b, N);
+    BigNum client_key = SrpMath::calcClientKey(N, B, g, x, a, u);
+
+    return server_key.isValid() && server_key.toByteArray() == client_key.toByteArray();
+}
+
+void runHandshake(benchmark::State& state, const SrpNgPair& Ng_pair)
+{
+    for (auto _ : state)
+    {
+        if (!handshake(Ng_pair))
+        {
+            state.SkipWithError("Handshake failed");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// The groups used by the server.
+void BM_SrpHandshake4096(benchmark::State& state)
+{
+    runHandshake(state, kSrpNgPair_4096);
+}
+BENCHMARK(BM_SrpHandshake4096)->Unit(benchmark::kMillisecond);
+
+void BM_SrpHandshake6144(benchmark::State& state)
+{
+    runHandshake(state, kSrpNgPair_6144);
+}
+BENCHMARK(BM_SrpHandshake6144)->Unit(benchmark::kMillisecond);
+
+void BM_SrpHandshake8192(benchmark::State& state)
+{
+    runHandshake(state, kSrpNgPair_8192);
+}
+BENCHMARK(BM_SrpHandshake8192)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+} // namespace base
@@ -16,6 +16,7 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 //
 
+#include "base/crypto/random.h"
 #include "base/crypto/srp_constants.h"
 #include "base/crypto/srp_math.h"
 
@@ -23,6 +24,49 @@
 
 namespace base {
 
+namespace {
+
+// Performs the calculations of both sides of a handshake. Returns true if the keys are equal.
+bool handshake(const SrpNgPair& Ng_pair)
+{
+    const std::u16string I = u"alice";
+    const std::u16string p = u"password123";
+
+    BigNum N = BigNum::fromStdString(Ng_pair.first);
+    BigNum g = BigNum::fromStdString(Ng_pair.second);
+    BigNum s = BigNum::fromByteArray(Random::byteArray(64));
+    BigNum v = SrpMath::calc_v(I, p, s, N, g);
+
+    BigNum b = BigNum::fromByteArray(Random::byteArray(128));
+    BigNum B = SrpMath::calc_B(b, N, g, v);
+
+    BigNum a = BigNum::fromByteArray(Random::byteArray(128));
+    BigNum A = SrpMath::calc_A(a, N, g);
+
+    if (!SrpMath::verify_A_mod_N(A, N) || !SrpMath::verify_B_mod_N(B, N))
+        return false;
+
+    BigNum u = SrpMath::calc_u(A, B, N);
+    BigNum x = SrpMath::calc_x(s, I, p);
+
+    BigNum server_key = SrpMath::calcServerKey(A, v, u, b, N);
+    BigNum client_key = SrpMath::calcClientKey(N, B, g, x, a, u);
+
+    return server_key.isValid() && server_key.toByteArray() == client_key.toByteArray();
+}
+
+} // namespace
+
+TEST(srp_math_test, handshake)
+{
+    for (const SrpNgPair* Ng_pair : { &kSrpNgPair_1024, &kSrpNgPair_4096, &kSrpNgPair_8192 })
+    {
+        // The second handshake uses the cached group.
+        EXPECT_TRUE(handshake(*Ng_pair));
+        EXPECT_TRUE(handshake(*Ng_pair));
+    }
+}
+
 TEST(srp_math_test, test_vector)
 {
     std::u16string I = u"alice";
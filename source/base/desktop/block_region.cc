@@ -0,0 +1,248 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/block_region.h"
+
+#include "base/logging.h"
+#include "base/desktop/region.h"
+#include "build/build_config.h"
+
+#include <algorithm>
+
+#if defined(CC_MSVC)
+#include <intrin.h>
+#endif
+
+namespace base {
+
+namespace {
+
+const int kBitsPerWord = 64;
+
+int countTrailingZeros(uint64_t value)
+{
+    DCHECK(value);
+
+#if defined(CC_MSVC)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// Returns the index of the first block starting from |from| which is set (or not set if |set| is
+// false) or |end| if there is no such block.
+int findBlock(const uint64_t* row, int from, int end, bool set)
+{
+    while (from < end)
+    {
+        const int word = from / kBitsPerWord;
+
+        uint64_t bits = set ? row[word] : ~row[word];
+        bits &= ~uint64_t(0) << (from % kBitsPerWord);
+
+        if (bits)
+            return std::min(end, word * kBitsPerWord + countTrailingZeros(bits));
+
+        from = (word + 1) * kBitsPerWord;
+    }
+
+    return end;
+}
+
+} // namespace
+
+BlockRegion::BlockRegion(const Size& size, int block_size)
+{
+    reset(size, block_size);
+}
+
+void BlockRegion::reset(const Size& size, int block_size)
+{
+    DCHECK_GT(block_size, 0);
+
+    size_ = size;
+    block_size_ = block_size;
+    columns_ = (std::max(size.width(), 0) + block_size - 1) / block_size;
+    rows_ = (std::max(size.height(), 0) + block_size - 1) / block_size;
+    words_per_row_ = (columns_ + kBitsPerWord - 1) / kBitsPerWord;
+
+    bits_.assign(static_cast<size_t>(words_per_row_) * rows_, 0);
+}
+
+bool BlockRegion::isEmpty() const
+{
+    return std::all_of(bits_.cbegin(), bits_.cend(), [](uint64_t bits) { return !bits; });
+}
+
+void BlockRegion::clear()
+{
+    std::fill(bits_.begin(), bits_.end(), 0);
+}
+
+void BlockRegion::addBlock(int column, int row)
+{
+    DCHECK(column >= 0 && column < columns_);
+    DCHECK(row >= 0 && row < rows_);
+
+    this->row(row)[column / kBitsPerWord] |= uint64_t(1) << (column % kBitsPerWord);
+}
+
+bool BlockRegion::hasBlock(int column, int row) const
+{
+    DCHECK(column >= 0 && column < columns_);
+    DCHECK(row >= 0 && row < rows_);
+
+    return (this->row(row)[column / kBitsPerWord] >> (column % kBitsPerWord)) & 1;
+}
+
+void BlockRegion::addRect(const Rect& rect)
+{
+    Rect clipped = rect;
+    clipped.intersectWith(Rect::makeSize(size_));
+    if (clipped.isEmpty())
+        return;
+
+    const int first_column = clipped.left() / block_size_;
+    const int last_column = (clipped.right() - 1) / block_size_;
+    const int first_row = clipped.top() / block_size_;
+    const int last_row = (clipped.bottom() - 1) / block_size_;
+
+    for (int y = first_row; y <= last_row; ++y)
+    {
+        uint64_t* bits = row(y);
+
+        for (int x = first_column; x <= last_column;)
+        {
+            const int word = x / kBitsPerWord;
+            const int first_bit = x % kBitsPerWord;
+            const int last_bit = std::min(last_column - word * kBitsPerWord, kBitsPerWord - 1);
+
+            uint64_t mask = ~uint64_t(0) << first_bit;
+            if (last_bit < kBitsPerWord - 1)
+                mask &= (uint64_t(1) << (last_bit + 1)) - 1;
+
+            bits[word] |= mask;
+            x = (word + 1) * kBitsPerWord;
+        }
+    }
+}
+
+void BlockRegion::setBlockMap(const uint8_t* map, int stride, int first_row, int last_row)
+{
+    DCHECK_GE(stride, columns_);
+
+    first_row = std::max(first_row, 0);
+    last_row = std::min(last_row, rows_);
+
+    for (int y = first_row; y < last_row; ++y)
+    {
+        const uint8_t* blocks = map + static_cast<size_t>(y) * stride;
+        uint64_t* bits = row(y);
+
+        for (int word = 0; word < words_per_row_; ++word)
+        {
+            const int first = word * kBitsPerWord;
+            const int count = std::min(kBitsPerWord, columns_ - first);
+
+            uint64_t value = 0;
+            for (int i = 0; i < count; ++i)
+                value |= uint64_t(blocks[first + i] != 0) << i;
+
+            bits[word] = value;
+        }
+    }
+}
+
+void BlockRegion::addRegion(const BlockRegion& other)
+{
+    DCHECK_EQ(bits_.size(), other.bits_.size());
+
+    for (size_t i = 0; i < bits_.size(); ++i)
+        bits_[i] |= other.bits_[i];
+}
+
+void BlockRegion::intersectWith(const BlockRegion& other)
+{
+    DCHECK_EQ(bits_.size(), other.bits_.size());
+
+    for (size_t i = 0; i < bits_.size(); ++i)
+        bits_[i] &= other.bits_[i];
+}
+
+void BlockRegion::subtract(const BlockRegion& other)
+{
+    DCHECK_EQ(bits_.size(), other.bits_.size());
+
+    for (size_t i = 0; i < bits_.size(); ++i)
+        bits_[i] &= ~other.bits_[i];
+}
+
+void BlockRegion::toRegion(Region* region) const
+{
+    DCHECK(region);
+
+    // Each row of blocks is a band of the region. The rows with the same blocks as the previous
+    // row extend its band.
+    std::vector<Rect> rects;
+    size_t band_start = 0;
+    const uint64_t* band_bits = nullptr;
+
+    for (int y = 0; y < rows_; ++y)
+    {
+        const uint64_t* bits = row(y);
+
+        if (band_bits && std::equal(bits, bits + words_per_row_, band_bits))
+        {
+            const int bottom = std::min((y + 1) * block_size_, size_.height());
+
+            for (size_t i = band_start; i < rects.size(); ++i)
+            {
+                Rect& rect = rects[i];
+                rect = Rect::makeLTRB(rect.left(), rect.top(), rect.right(), bottom);
+            }
+            continue;
+        }
+
+        band_start = rects.size();
+        band_bits = nullptr;
+
+        const int top = y * block_size_;
+        const int bottom = std::min(top + block_size_, size_.height());
+
+        for (int x = findBlock(bits, 0, columns_, true); x < columns_;)
+        {
+            const int end = findBlock(bits, x, columns_, false);
+
+            const int left = x * block_size_;
+            const int right = std::min(end * block_size_, size_.width());
+            rects.emplace_back(Rect::makeLTRB(left, top, right, bottom));
+
+            x = findBlock(bits, end, columns_, true);
+        }
+
+        if (rects.size() != band_start)
+            band_bits = bits;
+    }
+
+    region->setBandedRects(rects.data(), static_cast<int>(rects.size()));
+}
+
+} // namespace base
@@ -0,0 +1,89 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__BLOCK_REGION_H
+#define BASE__DESKTOP__BLOCK_REGION_H
+
+#include "base/desktop/geometry.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace base {
+
+class Region;
+
+// Set of the blocks of a grid which covers an area of |size| pixels. Each block is one bit, a row
+// of the grid is stored in 64-bit words, so the operations on two sets process 64 blocks at once.
+// It is used for dirty regions made of blocks (see Differ): the conversion to a Region gives its
+// rects in the canonical order, so no union operations are needed.
+class BlockRegion
+{
+public:
+    BlockRegion() = default;
+    BlockRegion(const Size& size, int block_size);
+
+    // Resizes the grid. All blocks are removed.
+    void reset(const Size& size, int block_size);
+
+    const Size& size() const { return size_; }
+    int blockSize() const { return block_size_; }
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+
+    bool isEmpty() const;
+    void clear();
+
+    void addBlock(int column, int row);
+    bool hasBlock(int column, int row) const;
+
+    // Adds the blocks which intersect |rect|.
+    void addRect(const Rect& rect);
+
+    // Replaces the rows from |first_row| to |last_row| (exclusive) with the blocks of |map|. It
+    // contains a byte for each block, not zero for the blocks in the set. |stride| is the offset
+    // between the rows of |map|. Different rows can be set from different threads.
+    void setBlockMap(const uint8_t* map, int stride, int first_row, int last_row);
+
+    // The other set must have the same grid.
+    void addRegion(const BlockRegion& other);
+    void intersectWith(const BlockRegion& other);
+    void subtract(const BlockRegion& other);
+
+    // Replaces |region| with the area of the blocks. The blocks of the last column and the last row
+    // are clipped by the size.
+    void toRegion(Region* region) const;
+
+private:
+    uint64_t* row(int index) { return bits_.data() + static_cast<size_t>(index) * words_per_row_; }
+    const uint64_t* row(int index) const
+    {
+        return bits_.data() + static_cast<size_t>(index) * words_per_row_;
+    }
+
+    Size size_;
+    int block_size_ = 0;
+    int columns_ = 0;
+    int rows_ = 0;
+    int words_per_row_ = 0;
+    std::vector<uint64_t> bits_;
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__BLOCK_REGION_H
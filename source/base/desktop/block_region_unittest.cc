@@ -0,0 +1,234 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/block_region.h"
+
+#include "base/desktop/region.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+const int kBlockSize = 32;
+
+Rect blockRect(int column, int row, const Size& size)
+{
+    Rect rect = Rect::makeXYWH(column * kBlockSize, row * kBlockSize, kBlockSize, kBlockSize);
+    rect.intersectWith(Rect::makeSize(size));
+    return rect;
+}
+
+// Region of the blocks built with union operations.
+Region expectedRegion(const BlockRegion& blocks)
+{
+    Region region;
+
+    for (int row = 0; row < blocks.rows(); ++row)
+    {
+        for (int column = 0; column < blocks.columns(); ++column)
+        {
+            if (blocks.hasBlock(column, row))
+                region.addRect(blockRect(column, row, blocks.size()));
+        }
+    }
+
+    return region;
+}
+
+void compareRegion(const BlockRegion& blocks)
+{
+    Region region;
+    blocks.toRegion(&region);
+
+    EXPECT_TRUE(region.equals(expectedRegion(blocks)));
+}
+
+} // namespace
+
+TEST(block_region_test, empty)
+{
+    BlockRegion blocks(Size(100, 100), kBlockSize);
+
+    EXPECT_TRUE(blocks.isEmpty());
+    EXPECT_EQ(blocks.columns(), 4);
+    EXPECT_EQ(blocks.rows(), 4);
+
+    Region region(Rect::makeXYWH(0, 0, 10, 10));
+    blocks.toRegion(&region);
+    EXPECT_TRUE(region.isEmpty());
+}
+
+TEST(block_region_test, single_block)
+{
+    BlockRegion blocks(Size(100, 100), kBlockSize);
+
+    blocks.addBlock(1, 2);
+    EXPECT_FALSE(blocks.isEmpty());
+    EXPECT_TRUE(blocks.hasBlock(1, 2));
+    EXPECT_FALSE(blocks.hasBlock(2, 1));
+
+    Region region;
+    blocks.toRegion(&region);
+    EXPECT_TRUE(region.equals(Region(Rect::makeXYWH(32, 64, 32, 32))));
+
+    blocks.clear();
+    EXPECT_TRUE(blocks.isEmpty());
+}
+
+TEST(block_region_test, partial_blocks)
+{
+    BlockRegion blocks(Size(100, 70), kBlockSize);
+
+    blocks.addBlock(3, 2);
+
+    Region region;
+    blocks.toRegion(&region);
+    EXPECT_TRUE(region.equals(Region(Rect::makeXYWH(96, 64, 4, 6))));
+}
+
+TEST(block_region_test, add_rect)
+{
+    BlockRegion blocks(Size(200, 200), kBlockSize);
+
+    blocks.addRect(Rect::makeXYWH(40, 10, 30, 60));
+
+    Region region;
+    blocks.toRegion(&region);
+    EXPECT_TRUE(region.equals(Region(Rect::makeXYWH(32, 0, 64, 96))));
+
+    // Rects outside the grid are clipped.
+    blocks.clear();
+    blocks.addRect(Rect::makeXYWH(-50, 190, 100, 100));
+    blocks.toRegion(&region);
+    EXPECT_TRUE(region.equals(Region(Rect::makeXYWH(0, 160, 64, 40))));
+}
+
+TEST(block_region_test, merged_rows)
+{
+    BlockRegion blocks(Size(256, 256), kBlockSize);
+
+    // Two rows with the same blocks give one rect.
+    blocks.addRect(Rect::makeXYWH(0, 0, 96, 64));
+
+    Region region;
+    blocks.toRegion(&region);
+
+    int count = 0;
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+        ++count;
+
+    EXPECT_EQ(count, 1);
+    compareRegion(blocks);
+}
+
+TEST(block_region_test, random_blocks)
+{
+    // Widths which give a partial word and a partial block in the last column.
+    const Size kSizes[] = { Size(1920, 1080), Size(2100, 1000), Size(4100, 70), Size(31, 33) };
+
+    for (const auto& size : kSizes)
+    {
+        BlockRegion blocks(size, kBlockSize);
+
+        for (int i = 0; i < 20; ++i)
+        {
+            SCOPED_TRACE(i);
+
+            blocks.clear();
+
+            const int count = rand() % (blocks.columns() * blocks.rows() + 1);
+            for (int j = 0; j < count; ++j)
+                blocks.addBlock(rand() % blocks.columns(), rand() % blocks.rows());
+
+            compareRegion(blocks);
+        }
+    }
+}
+
+TEST(block_region_test, set_block_map)
+{
+    BlockRegion blocks(Size(3000, 100), kBlockSize);
+
+    // The map has a boundary column like the map of the differ.
+    const int stride = blocks.columns() + 1;
+    std::vector<uint8_t> map(static_cast<size_t>(stride) * blocks.rows());
+
+    for (size_t i = 0; i < map.size(); ++i)
+        map[i] = (rand() % 3) ? 0 : 1;
+
+    blocks.addBlock(0, 0);
+    blocks.setBlockMap(map.data(), stride, 0, 2);
+    blocks.setBlockMap(map.data(), stride, 2, blocks.rows());
+
+    for (int row = 0; row < blocks.rows(); ++row)
+    {
+        for (int column = 0; column < blocks.columns(); ++column)
+        {
+            EXPECT_EQ(blocks.hasBlock(column, row), map[row * stride + column] != 0);
+        }
+    }
+
+    compareRegion(blocks);
+}
+
+TEST(block_region_test, set_operations)
+{
+    const Size size(2200, 600);
+
+    BlockRegion blocks1(size, kBlockSize);
+    BlockRegion blocks2(size, kBlockSize);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        blocks1.addBlock(rand() % blocks1.columns(), rand() % blocks1.rows());
+        blocks2.addBlock(rand() % blocks2.columns(), rand() % blocks2.rows());
+    }
+
+    const Region region1 = expectedRegion(blocks1);
+    const Region region2 = expectedRegion(blocks2);
+
+    BlockRegion result(blocks1);
+    result.addRegion(blocks2);
+
+    Region expected(region1);
+    expected.addRegion(region2);
+    EXPECT_TRUE(expectedRegion(result).equals(expected));
+    compareRegion(result);
+
+    result = blocks1;
+    result.intersectWith(blocks2);
+
+    expected.intersect(region1, region2);
+    EXPECT_TRUE(expectedRegion(result).equals(expected));
+    compareRegion(result);
+
+    result = blocks1;
+    result.subtract(blocks2);
+
+    expected = region1;
+    expected.subtract(region2);
+    EXPECT_TRUE(expectedRegion(result).equals(expected));
+    compareRegion(result);
+}
+
+} // namespace base
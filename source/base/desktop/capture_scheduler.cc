@@ -18,43 +18,105 @@
 
 #include "base/desktop/capture_scheduler.h"
 
+#include <algorithm>
+
 namespace base {
 
-CaptureScheduler::CaptureScheduler(const std::chrono::milliseconds& update_interval)
+namespace {
+
+// Short pauses (typing, a blinking caret) do not reduce the rate.
+const int kIdleCapturesBeforeBackoff = 3;
+
+} // namespace
+
+// static
+const CaptureScheduler::Milliseconds CaptureScheduler::kMaxIdleInterval{ 500 };
+
+// static
+const CaptureScheduler::Milliseconds CaptureScheduler::kMaxHintedIdleInterval{ 2000 };
+
+CaptureScheduler::CaptureScheduler(const Milliseconds& update_interval)
     : update_interval_(update_interval)
 {
     // Nothing
 }
 
-void CaptureScheduler::setUpdateInterval(const std::chrono::milliseconds& update_interval)
+void CaptureScheduler::setUpdateInterval(const Milliseconds& update_interval)
 {
     update_interval_ = update_interval;
 }
 
-std::chrono::milliseconds CaptureScheduler::updateInterval() const
+CaptureScheduler::Milliseconds CaptureScheduler::updateInterval() const
 {
     return update_interval_;
 }
 
-void CaptureScheduler::beginCapture()
+void CaptureScheduler::beginCapture(const TimePoint& time)
+{
+    begin_time_ = time;
+}
+
+void CaptureScheduler::endCapture(bool has_changes)
+{
+    if (has_changes)
+        idle_captures_ = 0;
+    else
+        ++idle_captures_;
+}
+
+void CaptureScheduler::onUserInput()
+{
+    idle_captures_ = 0;
+}
+
+void CaptureScheduler::setChangeHintsEnabled(bool enabled)
 {
-    begin_time_ = std::chrono::high_resolution_clock::now();
+    change_hints_enabled_ = enabled;
 }
 
-void CaptureScheduler::endCapture()
+bool CaptureScheduler::isChangeHintsEnabled() const
 {
-    end_time_ = std::chrono::high_resolution_clock::now();
+    return change_hints_enabled_;
+}
+
+void CaptureScheduler::onChangeHint()
+{
+    idle_captures_ = 0;
+}
+
+CaptureScheduler::Milliseconds CaptureScheduler::captureInterval() const
+{
+    // The interval is never less than the update interval, even if it is above the idle limit.
+    const Milliseconds max_interval = std::max(
+        update_interval_, change_hints_enabled_ ? kMaxHintedIdleInterval : kMaxIdleInterval);
+
+    Milliseconds interval = update_interval_;
+
+    for (int i = kIdleCapturesBeforeBackoff; i < idle_captures_ && interval < max_interval; ++i)
+        interval = std::max(interval * 2, Milliseconds(1));
+
+    return std::min(interval, max_interval);
+}
+
+CaptureScheduler::Milliseconds CaptureScheduler::nextCaptureDelay(const TimePoint& time) const
+{
+    const Milliseconds interval = captureInterval();
+    const Milliseconds elapsed = std::chrono::duration_cast<Milliseconds>(time - begin_time_);
+
+    if (elapsed >= interval)
+        return Milliseconds::zero();
+
+    return interval - std::max(elapsed, Milliseconds::zero());
 }
 
-std::chrono::milliseconds CaptureScheduler::nextCaptureDelay() const
+CaptureScheduler::Milliseconds CaptureScheduler::minCaptureDelay(const TimePoint& time) const
 {
-    std::chrono::milliseconds diff_time =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end_time_ - begin_time_);
+    const Milliseconds elapsed = std::chrono::duration_cast<Milliseconds>(time - begin_time_);
 
-    if (diff_time > update_interval_)
-        diff_time = update_interval_;
+    if (elapsed >= update_interval_)
+        return Milliseconds::zero();
 
-    return update_interval_ - diff_time;
+    return update_interval_ - std::max(elapsed, Milliseconds::zero());
 }
 
 } // namespace base
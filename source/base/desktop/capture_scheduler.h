@@ -25,23 +25,62 @@
 
 namespace base {
 
+// Selects the time of the next screen capture. While the screen is changing, it is captured with
+// the update interval (the limit set by the encoder and the network). When captures find no
+// changes, the interval grows exponentially up to kMaxIdleInterval. User input returns the
+// scheduler to the update interval at once.
+//
+// If the system reports the events which may change the screen (change hints), a static screen
+// is only polled every kMaxHintedIdleInterval for the changes without a hint, and a hint returns
+// the scheduler to the update interval.
 class CaptureScheduler
 {
 public:
-    explicit CaptureScheduler(const std::chrono::milliseconds& update_interval);
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = std::chrono::time_point<Clock>;
+    using Milliseconds = std::chrono::milliseconds;
+
+    static const Milliseconds kMaxIdleInterval;
+    static const Milliseconds kMaxHintedIdleInterval;
+
+    explicit CaptureScheduler(const Milliseconds& update_interval);
     ~CaptureScheduler() = default;
 
-    void setUpdateInterval(const std::chrono::milliseconds& update_interval);
-    std::chrono::milliseconds updateInterval() const;
+    void setUpdateInterval(const Milliseconds& update_interval);
+    Milliseconds updateInterval() const;
+
+    void beginCapture(const TimePoint& time = Clock::now());
+
+    // |has_changes| is true if the captured frame or the cursor has changed.
+    void endCapture(bool has_changes);
+
+    // Injected input usually changes the screen, so the next capture must not be delayed.
+    void onUserInput();
+
+    // Enables the longer idle interval. It must be enabled only while the hints are delivered.
+    void setChangeHintsEnabled(bool enabled);
+    bool isChangeHintsEnabled() const;
+
+    // Something on the screen may have changed (a window is moved, a caret is blinking).
+    void onChangeHint();
+
+    // Returns the current interval between the beginnings of the captures.
+    Milliseconds captureInterval() const;
+
+    // Returns the delay of the next capture from |time|.
+    Milliseconds nextCaptureDelay(const TimePoint& time = Clock::now()) const;
 
-    void beginCapture();
-    void endCapture();
-    std::chrono::milliseconds nextCaptureDelay() const;
+    // Returns the delay from |time| until the update interval passes after the beginning of the
+    // last capture. A capturer which waits for the updates of the screen captures the next frame
+    // as soon as the screen is updated, but not earlier than this (and not later than
+    // nextCaptureDelay()).
+    Milliseconds minCaptureDelay(const TimePoint& time = Clock::now()) const;
 
 private:
-    std::chrono::milliseconds update_interval_;
-    std::chrono::time_point<std::chrono::high_resolution_clock> begin_time_;
-    std::chrono::time_point<std::chrono::high_resolution_clock> end_time_;
+    Milliseconds update_interval_;
+    TimePoint begin_time_;
+    int idle_captures_ = 0;
+    bool change_hints_enabled_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(CaptureScheduler);
 };
@@ -0,0 +1,143 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/capture_scheduler.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+using Milliseconds = CaptureScheduler::Milliseconds;
+
+const Milliseconds kUpdateInterval(40);
+
+// Makes |count| captures which take no time and returns the delay after the last one.
+Milliseconds capture(CaptureScheduler* scheduler, bool has_changes, int count)
+{
+    const CaptureScheduler::TimePoint time = CaptureScheduler::Clock::now();
+
+    for (int i = 0; i < count; ++i)
+    {
+        scheduler->beginCapture(time);
+        scheduler->endCapture(has_changes);
+    }
+
+    return scheduler->nextCaptureDelay(time);
+}
+
+} // namespace
+
+TEST(CaptureSchedulerTest, FullRateWhileChanging)
+{
+    CaptureScheduler scheduler(kUpdateInterval);
+
+    EXPECT_EQ(capture(&scheduler, true, 1), kUpdateInterval);
+    EXPECT_EQ(capture(&scheduler, true, 100), kUpdateInterval);
+}
+
+TEST(CaptureSchedulerTest, CaptureTimeIsSubtracted)
+{
+    CaptureScheduler scheduler(kUpdateInterval);
+
+    const CaptureScheduler::TimePoint time = CaptureScheduler::Clock::now();
+
+    scheduler.beginCapture(time);
+    scheduler.endCapture(true);
+
+    EXPECT_EQ(scheduler.nextCaptureDelay(time + Milliseconds(15)), Milliseconds(25));
+    EXPECT_EQ(scheduler.nextCaptureDelay(time + Milliseconds(60)), Milliseconds::zero());
+}
+
+TEST(CaptureSchedulerTest, BackoffOnStaticScreen)
+{
+    CaptureScheduler scheduler(kUpdateInterval);
+
+    // A few captures without changes do not reduce the rate.
+    EXPECT_EQ(capture(&scheduler, false, 3), kUpdateInterval);
+
+    EXPECT_EQ(capture(&scheduler, false, 1), kUpdateInterval * 2);
+    EXPECT_EQ(capture(&scheduler, false, 1), kUpdateInterval * 4);
+    EXPECT_EQ(capture(&scheduler, false, 1), kUpdateInterval * 8);
+
+    // The interval is limited.
+    EXPECT_EQ(capture(&scheduler, false, 100), CaptureScheduler::kMaxIdleInterval);
+
+    // The first change returns the full rate.
+    EXPECT_EQ(capture(&scheduler, true, 1), kUpdateInterval);
+}
+
+TEST(CaptureSchedulerTest, UserInputResetsBackoff)
+{
+    CaptureScheduler scheduler(kUpdateInterval);
+
+    EXPECT_EQ(capture(&scheduler, false, 100), CaptureScheduler::kMaxIdleInterval);
+
+    scheduler.onUserInput();
+    EXPECT_EQ(scheduler.captureInterval(), kUpdateInterval);
+}
+
+TEST(CaptureSchedulerTest, ChangeHintsExtendBackoff)
+{
+    CaptureScheduler scheduler(kUpdateInterval);
+    scheduler.setChangeHintsEnabled(true);
+
+    EXPECT_EQ(capture(&scheduler, false, 100), CaptureScheduler::kMaxHintedIdleInterval);
+
+    // A hint returns the full rate.
+    scheduler.onChangeHint();
+    EXPECT_EQ(scheduler.captureInterval(), kUpdateInterval);
+
+    // Without the hints the usual limit applies.
+    EXPECT_EQ(capture(&scheduler, false, 100), CaptureScheduler::kMaxHintedIdleInterval);
+    scheduler.setChangeHintsEnabled(false);
+    EXPECT_EQ(scheduler.captureInterval(), CaptureScheduler::kMaxIdleInterval);
+}
+
+TEST(CaptureSchedulerTest, MinDelayIgnoresBackoff)
+{
+    CaptureScheduler scheduler(kUpdateInterval);
+
+    const CaptureScheduler::TimePoint time = CaptureScheduler::Clock::now();
+
+    for (int i = 0; i < 100; ++i)
+    {
+        scheduler.beginCapture(time);
+        scheduler.endCapture(false);
+    }
+
+    // An update of the screen is captured at the full rate even after the backoff.
+    EXPECT_EQ(scheduler.nextCaptureDelay(time), CaptureScheduler::kMaxIdleInterval);
+    EXPECT_EQ(scheduler.minCaptureDelay(time), kUpdateInterval);
+    EXPECT_EQ(scheduler.minCaptureDelay(time + Milliseconds(15)), Milliseconds(25));
+    EXPECT_EQ(scheduler.minCaptureDelay(time + Milliseconds(60)), Milliseconds::zero());
+}
+
+TEST(CaptureSchedulerTest, UpdateIntervalIsLowerLimit)
+{
+    CaptureScheduler scheduler(kUpdateInterval);
+
+    // The receiving side is slower than the idle limit.
+    scheduler.setUpdateInterval(Milliseconds(800));
+
+    EXPECT_EQ(capture(&scheduler, true, 1), Milliseconds(800));
+    EXPECT_EQ(capture(&scheduler, false, 100), Milliseconds(800));
+}
+
+} // namespace base
@@ -52,8 +52,13 @@ const MouseCursor* CursorCapturerWin::captureCursor()
     cursor_info.cbSize = sizeof(cursor_info);
     if (GetCursorInfo(&cursor_info))
     {
-        if (!isSameCursorShape(cursor_info, prev_cursor_info_))
+        if (!has_prev_cursor_ || !isSameCursorShape(cursor_info, prev_cursor_info_))
         {
+            // If the bitmap can not be taken from the cursor, it is not tried again until the
+            // cursor is changed.
+            prev_cursor_info_ = cursor_info;
+            has_prev_cursor_ = true;
+
             if (cursor_info.flags == 0)
             {
                 // Host machine does not have a hardware mouse attached, we will send a default one
@@ -63,11 +68,7 @@ const MouseCursor* CursorCapturerWin::captureCursor()
             }
 
             mouse_cursor_.reset(mouseCursorFromHCursor(desktop_dc_, cursor_info.hCursor));
-            if (mouse_cursor_)
-            {
-                prev_cursor_info_ = cursor_info;
-                return mouse_cursor_.get();
-            }
+            return mouse_cursor_.get();
         }
     }
 
@@ -77,6 +78,7 @@ const MouseCursor* CursorCapturerWin::captureCursor()
 void CursorCapturerWin::reset()
 {
     desktop_dc_.close();
+    has_prev_cursor_ = false;
 }
 
 } // namespace base
@@ -38,7 +38,11 @@ public:
 private:
     win::ScopedGetDC desktop_dc_;
     std::unique_ptr<MouseCursor> mouse_cursor_;
+
+    // The bitmap is taken from the cursor only if its handle or its state is changed. After
+    // reset() the current cursor is taken in any case.
     CURSORINFO prev_cursor_info_;
+    bool has_prev_cursor_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(CursorCapturerWin);
 };
@@ -19,22 +19,128 @@
 #include "base/desktop/cursor_capturer_x11.h"
 
 #include "base/logging.h"
+#include "base/desktop/mouse_cursor.h"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/Xfixes.h>
+
+#include <algorithm>
 
 namespace base {
 
+namespace {
+
+// Number of the recent cursors which are kept with their serials.
+const size_t kMaxRecentCursors = 8;
+
+} // namespace
+
 CursorCapturerX11::CursorCapturerX11() = default;
 
-CursorCapturerX11::~CursorCapturerX11() = default;
+CursorCapturerX11::~CursorCapturerX11()
+{
+    if (display_)
+        XCloseDisplay(display_);
+}
 
 const MouseCursor* CursorCapturerX11::captureCursor()
 {
-    NOTIMPLEMENTED();
-    return nullptr;
+    if (!display_ && !initialize())
+        return nullptr;
+
+    processXEvents();
+
+    if (!cursor_changed_)
+        return nullptr;
+
+    if (cursor_serial_)
+    {
+        auto it = std::find_if(recent_cursors_.begin(), recent_cursors_.end(),
+                               [this](const auto& entry) { return entry.first == cursor_serial_; });
+        if (it != recent_cursors_.end())
+        {
+            cursor_changed_ = false;
+
+            if (it != recent_cursors_.begin())
+                std::rotate(recent_cursors_.begin(), it, it + 1);
+
+            return recent_cursors_.front().second.get();
+        }
+    }
+
+    XFixesCursorImage* image = XFixesGetCursorImage(display_);
+    if (!image)
+        return nullptr;
+
+    cursor_changed_ = false;
+    cursor_serial_ = image->cursor_serial;
+
+    const Size size(image->width, image->height);
+    ByteArray pixels(size.width() * size.height() * sizeof(uint32_t));
+
+    // The pixels are premultiplied ARGB, but they are stored in unsigned long (which is 64 bits
+    // on 64-bit systems).
+    uint32_t* dst = reinterpret_cast<uint32_t*>(pixels.data());
+    for (int i = 0; i < size.width() * size.height(); ++i)
+        dst[i] = static_cast<uint32_t>(image->pixels[i]);
+
+    recent_cursors_.emplace_front(cursor_serial_, std::make_unique<MouseCursor>(
+        std::move(pixels), size, Point(image->xhot, image->yhot)));
+    if (recent_cursors_.size() > kMaxRecentCursors)
+        recent_cursors_.pop_back();
+
+    XFree(image);
+    return recent_cursors_.front().second.get();
 }
 
 void CursorCapturerX11::reset()
 {
-    NOTIMPLEMENTED();
+    cursor_changed_ = true;
+}
+
+bool CursorCapturerX11::initialize()
+{
+    display_ = XOpenDisplay(nullptr);
+    if (!display_)
+    {
+        LOG(LS_ERROR) << "XOpenDisplay failed";
+        return false;
+    }
+
+    int error_base;
+
+    if (!XFixesQueryExtension(display_, &xfixes_event_base_, &error_base))
+    {
+        LOG(LS_ERROR) << "X server does not support XFixes";
+        XCloseDisplay(display_);
+        display_ = nullptr;
+        return false;
+    }
+
+    XFixesSelectCursorInput(display_, DefaultRootWindow(display_), XFixesDisplayCursorNotifyMask);
+    cursor_changed_ = true;
+    return true;
+}
+
+void CursorCapturerX11::processXEvents()
+{
+    while (XPending(display_))
+    {
+        XEvent event;
+        XNextEvent(display_, &event);
+
+        if (event.type != xfixes_event_base_ + XFixesCursorNotify)
+            continue;
+
+        // The same cursor may be set again. It is not sent again.
+        const XFixesCursorNotifyEvent* notify_event =
+            reinterpret_cast<const XFixesCursorNotifyEvent*>(&event);
+        if (notify_event->cursor_serial != cursor_serial_)
+        {
+            cursor_serial_ = notify_event->cursor_serial;
+            cursor_changed_ = true;
+        }
+    }
 }
 
 } // namespace base
@@ -22,8 +22,17 @@
 #include "base/macros_magic.h"
 #include "desktop/cursor_capturer.h"
 
+#include <deque>
+#include <memory>
+
+typedef struct _XDisplay Display;
+
 namespace base {
 
+// Captures the cursor shape with XFixes. The shape is fetched only after the X server reports
+// that the cursor was changed. Every cursor of the X server has its own serial, so a cursor
+// which is shown again (for example, the arrow and the text cursor in turn) is taken from the
+// recent cursors instead of being fetched and hashed again.
 class CursorCapturerX11 : public CursorCapturer
 {
 public:
@@ -34,6 +43,19 @@ public:
     void reset() override;
 
 private:
+    bool initialize();
+    void processXEvents();
+
+    Display* display_ = nullptr;
+    int xfixes_event_base_ = -1;
+    bool cursor_changed_ = true;
+
+    // Serial of the cursor which is shown now (zero if it is unknown).
+    unsigned long cursor_serial_ = 0;
+
+    // The recently shown cursors with their serials, the most recent first.
+    std::deque<std::pair<unsigned long, std::unique_ptr<MouseCursor>>> recent_cursors_;
+
     DISALLOW_COPY_AND_ASSIGN(CursorCapturerX11);
 };
 
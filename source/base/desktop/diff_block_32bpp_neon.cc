@@ -0,0 +1,85 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/diff_block_32bpp_neon.h"
+
+#if defined(ARCH_CPU_ARM64)
+#include <arm_neon.h>
+#endif // defined(ARCH_CPU_ARM64)
+
+namespace base {
+
+#if defined(ARCH_CPU_ARM64)
+
+namespace {
+
+bool hasDifferences(uint8x16_t acc)
+{
+    return vmaxvq_u8(acc) != 0;
+}
+
+uint8x16_t diffRow16Pixels(const uint8_t* image1, const uint8_t* image2)
+{
+    uint8x16_t acc = veorq_u8(vld1q_u8(image1 + 0), vld1q_u8(image2 + 0));
+    acc = vorrq_u8(acc, veorq_u8(vld1q_u8(image1 + 16), vld1q_u8(image2 + 16)));
+    acc = vorrq_u8(acc, veorq_u8(vld1q_u8(image1 + 32), vld1q_u8(image2 + 32)));
+    acc = vorrq_u8(acc, veorq_u8(vld1q_u8(image1 + 48), vld1q_u8(image2 + 48)));
+    return acc;
+}
+
+} // namespace
+
+uint8_t diffFullBlock_32bpp_32x32_NEON(
+    const uint8_t* image1, const uint8_t* image2, int bytes_per_row)
+{
+    for (int i = 0; i < 32; ++i)
+    {
+        // A row of the block is 128 bytes (two halves of 16 pixels).
+        uint8x16_t acc = vorrq_u8(diffRow16Pixels(image1, image2),
+                                  diffRow16Pixels(image1 + 64, image2 + 64));
+
+        // If the row has differences.
+        if (hasDifferences(acc))
+            return 1U;
+
+        image1 += bytes_per_row;
+        image2 += bytes_per_row;
+    }
+
+    return 0U;
+}
+
+uint8_t diffFullBlock_32bpp_16x16_NEON(
+    const uint8_t* image1, const uint8_t* image2, int bytes_per_row)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        // If the row has differences.
+        if (hasDifferences(diffRow16Pixels(image1, image2)))
+            return 1U;
+
+        image1 += bytes_per_row;
+        image2 += bytes_per_row;
+    }
+
+    return 0U;
+}
+
+#endif // defined(ARCH_CPU_ARM64)
+
+} // namespace base
@@ -18,10 +18,16 @@
 
 #include "base/desktop/differ.h"
 
+#include "base/cpuid_util.h"
 #include "base/logging.h"
-#include "base/desktop/diff_block_32bpp_sse2.h"
+#include "base/desktop/diff_block_32bpp_avx2.h"
+#include "base/desktop/diff_block_32bpp_avx512.h"
 #include "base/desktop/diff_block_32bpp_c.h"
+#include "base/desktop/diff_block_32bpp_neon.h"
+#include "base/desktop/diff_block_32bpp_sse2.h"
+#include "base/threading/thread_pool.h"
 
+#include <algorithm>
 #include <cstring>
 #include <libyuv/cpu_id.h>
 
@@ -33,6 +39,22 @@ const int kBlockSize = 16;
 const int kBytesPerPixel = 4;
 const int kBytesPerBlock = kBlockSize * kBytesPerPixel;
 
+// Screens smaller than this are diffed on the calling thread.
+const int64_t kMinParallelPixels = 2560 * 1440;
+
+// The diff is mostly limited by the memory bandwidth, so more threads do not help.
+const size_t kMaxDiffThreads = 4;
+
+// The size of a tile in blocks. An unchanged tile of 64x64 pixels is rejected by its checksum.
+const int kTileBlocks = 4;
+const int kTileSize = kTileBlocks * kBlockSize;
+
+// Every block is diffed once per this number of frames regardless of the checksums.
+const int kFullSweepInterval = 30;
+
+const uint64_t kChecksumBasis = 0xCBF29CE484222325ULL;
+const uint64_t kChecksumPrime = 0x100000001B3ULL;
+
 // Check for diffs in upper-left portion of the block. The size of the portion to check is
 // specified by the |width| and |height| values.
 // Note that if we force the capturer to always return images whose width and height are multiples
@@ -55,17 +77,60 @@ uint8_t diffPartialBlock(const uint8_t* prev_image,
     return 0U;
 }
 
+// Calculates the checksum of the |width_bytes| x |height| part of the image. A step of each lane
+// is a bijection of its state, so a change of a single word always changes the checksum. Four
+// independent lanes keep the multiplications off the critical path.
+uint64_t checksumRect(const uint8_t* image, int bytes_per_row, int width_bytes, int height)
+{
+    const int kBytesPerStep = 4 * static_cast<int>(sizeof(uint64_t));
+
+    uint64_t h0 = kChecksumBasis;
+    uint64_t h1 = kChecksumBasis + 1;
+    uint64_t h2 = kChecksumBasis + 2;
+    uint64_t h3 = kChecksumBasis + 3;
+
+    for (int y = 0; y < height; ++y)
+    {
+        int x = 0;
 
+        for (; x + kBytesPerStep <= width_bytes; x += kBytesPerStep)
+        {
+            uint64_t words[4];
+            memcpy(words, image + x, sizeof(words));
+
+            h0 = (h0 ^ words[0]) * kChecksumPrime;
+            h1 = (h1 ^ words[1]) * kChecksumPrime;
+            h2 = (h2 ^ words[2]) * kChecksumPrime;
+            h3 = (h3 ^ words[3]) * kChecksumPrime;
+        }
+
+        for (; x + kBytesPerPixel <= width_bytes; x += kBytesPerPixel)
+        {
+            uint32_t pixel;
+            memcpy(&pixel, image + x, sizeof(pixel));
+
+            h0 = (h0 ^ pixel) * kChecksumPrime;
+        }
+
+        image += bytes_per_row;
+    }
+
+    h0 = (h0 ^ h1) * kChecksumPrime;
+    h0 = (h0 ^ h2) * kChecksumPrime;
+    return (h0 ^ h3) * kChecksumPrime;
+}
 
 } // namespace
 
 Differ::Differ(const Size& size)
-    : screen_rect_(Rect::makeSize(size)),
+    : size_(size),
       bytes_per_row_(size.width() * kBytesPerPixel),
       diff_width_(((size.width() + kBlockSize - 1) / kBlockSize) + 1),
       diff_height_(((size.height() + kBlockSize - 1) / kBlockSize) + 1),
       full_blocks_x_(size.width() / kBlockSize),
-      full_blocks_y_(size.height() / kBlockSize)
+      full_blocks_y_(size.height() / kBlockSize),
+      tiles_x_((size.width() + kTileSize - 1) / kTileSize),
+      tiles_y_((size.height() + kTileSize - 1) / kTileSize)
 {
     DLOG(LS_INFO) << "Screen size: " << size;
     DLOG(LS_INFO) << "Bytes per row: " << bytes_per_row_;
@@ -77,6 +142,15 @@ Differ::Differ(const Size& size)
     diff_info_ = std::make_unique<uint8_t[]>(diff_info_size);
     memset(diff_info_.get(), 0, diff_info_size);
 
+    dirty_blocks_.reset(size, kBlockSize);
+
+    const size_t tile_count = static_cast<size_t>(tiles_x_) * tiles_y_;
+
+    tile_checksums_ = std::make_unique<uint64_t[]>(tile_count);
+    tile_changed_ = std::make_unique<uint8_t[]>(tile_count);
+    memset(tile_checksums_.get(), 0, tile_count * sizeof(uint64_t));
+    memset(tile_changed_.get(), 1, tile_count);
+
     // Calc size of partial blocks which may be present on right and bottom edge.
     partial_column_width_ = size.width() - (full_blocks_x_ * kBlockSize);
     partial_row_height_ = size.height() - (full_blocks_y_ * kBlockSize);
@@ -91,57 +165,132 @@ Differ::Differ(const Size& size)
 
     diff_full_block_func_ = diffFunction();
     CHECK(diff_full_block_func_);
+
+    const size_t thread_count = std::min(ThreadPool::shared()->threadCount(), kMaxDiffThreads);
+
+    const int64_t pixels = static_cast<int64_t>(size.width()) * size.height();
+
+    if (thread_count > 1 && pixels >= kMinParallelPixels)
+    {
+        band_rows_ = (diff_height_ + static_cast<int>(thread_count) - 1) /
+            static_cast<int>(thread_count);
+
+        // A tile must not be shared by two bands.
+        band_rows_ = (band_rows_ + kTileBlocks - 1) / kTileBlocks * kTileBlocks;
+
+        DLOG(LS_INFO) << "Diff threads: " << thread_count << ", band rows: " << band_rows_;
+    }
 }
 
+Differ::~Differ() = default;
+
 // static
 Differ::DiffFullBlockFunc Differ::diffFunction()
 {
-    if (libyuv::TestCpuFlag(libyuv::kCpuHasSSE2))
-    {
 #if defined(ARCH_CPU_X86_FAMILY)
-        LOG(LS_INFO) << "SSE2 differ loaded";
+    if (CpuidUtil::hasAvx512f())
+    {
+        LOG(LS_INFO) << "AVX-512 differ loaded";
 
         if constexpr (kBlockSize == 16)
-            return diffFullBlock_32bpp_16x16_SSE2;
+            return diffFullBlock_32bpp_16x16_AVX512;
         else if constexpr (kBlockSize == 32)
-            return diffFullBlock_32bpp_32x32_SSE2;
-#endif // defined(ARCH_CPU_X86_FAMILY)
+            return diffFullBlock_32bpp_32x32_AVX512;
     }
-    else
+
+    if (CpuidUtil::hasAvx2())
+    {
+        LOG(LS_INFO) << "AVX2 differ loaded";
+
+        if constexpr (kBlockSize == 16)
+            return diffFullBlock_32bpp_16x16_AVX2;
+        else if constexpr (kBlockSize == 32)
+            return diffFullBlock_32bpp_32x32_AVX2;
+    }
+
+    if (libyuv::TestCpuFlag(libyuv::kCpuHasSSE2))
     {
-        LOG(LS_INFO) << "C differ loaded";
+        LOG(LS_INFO) << "SSE2 differ loaded";
 
         if constexpr (kBlockSize == 16)
-            return diffFullBlock_32bpp_16x16_C;
+            return diffFullBlock_32bpp_16x16_SSE2;
         else if constexpr (kBlockSize == 32)
-            return diffFullBlock_32bpp_32x32_C;
+            return diffFullBlock_32bpp_32x32_SSE2;
     }
+#elif defined(ARCH_CPU_ARM64)
+    // NEON is always available on ARM64.
+    LOG(LS_INFO) << "NEON differ loaded";
+
+    if constexpr (kBlockSize == 16)
+        return diffFullBlock_32bpp_16x16_NEON;
+    else if constexpr (kBlockSize == 32)
+        return diffFullBlock_32bpp_32x32_NEON;
+#endif // defined(ARCH_CPU_*)
+
+    LOG(LS_INFO) << "C differ loaded";
+
+    if constexpr (kBlockSize == 16)
+        return diffFullBlock_32bpp_16x16_C;
+    else if constexpr (kBlockSize == 32)
+        return diffFullBlock_32bpp_32x32_C;
 
     return nullptr;
 }
 
-// Identify all of the blocks that contain changed pixels.
-void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image)
+// Calculates the checksums of the tiles in the block rows from |first_row| to |last_row|
+// (exclusive) and marks the tiles which must be diffed block by block.
+void Differ::updateTiles(const uint8_t* curr_image, int first_row, int last_row, bool full_sweep)
 {
-    const uint8_t* prev_block_row_start = prev_image;
-    const uint8_t* curr_block_row_start = curr_image;
+    const int first_tile_row = first_row / kTileBlocks;
+    const int last_tile_row = std::min((last_row + kTileBlocks - 1) / kTileBlocks, tiles_y_);
+
+    for (int y = first_tile_row; y < last_tile_row; ++y)
+    {
+        const int top = y * kTileSize;
+        const int height = std::min(kTileSize, size_.height() - top);
+
+        for (int x = 0; x < tiles_x_; ++x)
+        {
+            const int left = x * kTileSize;
+            const int width = std::min(kTileSize, size_.width() - left);
+            const size_t index = static_cast<size_t>(y) * tiles_x_ + x;
+
+            const uint64_t checksum =
+                checksumRect(curr_image + top * bytes_per_row_ + left * kBytesPerPixel,
+                             bytes_per_row_, width * kBytesPerPixel, height);
+
+            tile_changed_[index] = full_sweep || checksum != tile_checksums_[index];
+            tile_checksums_[index] = checksum;
+        }
+    }
+}
+
+// Identify all of the blocks that contain changed pixels in the block rows from |first_row| to
+// |last_row| (exclusive). The blocks of the tiles which are not marked as changed are skipped.
+void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image,
+                             int first_row, int last_row)
+{
+    const uint8_t* prev_block_row_start = prev_image + first_row * block_stride_y_;
+    const uint8_t* curr_block_row_start = curr_image + first_row * block_stride_y_;
 
     // Offset from the start of one diff_info row to the next.
     const int diff_stride = diff_width_;
 
-    uint8_t* is_diff_row_start = diff_info_.get();
+    uint8_t* is_diff_row_start = diff_info_.get() + first_row * diff_stride;
 
-    for (int y = 0; y < full_blocks_y_; ++y)
+    for (int y = first_row; y < std::min(last_row, full_blocks_y_); ++y)
     {
         const uint8_t* prev_block = prev_block_row_start;
         const uint8_t* curr_block = curr_block_row_start;
 
         uint8_t* is_different = is_diff_row_start;
+        const uint8_t* tile_changed = tile_changed_.get() + (y / kTileBlocks) * tiles_x_;
 
         for (int x = 0; x < full_blocks_x_; ++x)
         {
             // Mark this block as being modified so that it gets incorporated into a dirty rect.
-            *is_different = diff_full_block_func_(prev_block, curr_block, bytes_per_row_);
+            *is_different = tile_changed[x / kTileBlocks] ?
+                diff_full_block_func_(prev_block, curr_block, bytes_per_row_) : 0U;
 
             prev_block += kBytesPerBlock;
             curr_block += kBytesPerBlock;
@@ -153,11 +302,12 @@ void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_imag
         // ever, occur.
         if (partial_column_width_ != 0)
         {
-            *is_different = diffPartialBlock(prev_block,
-                                             curr_block,
-                                             bytes_per_row_,
-                                             partial_column_width_ * kBytesPerPixel,
-                                             kBlockSize);
+            *is_different = tile_changed[full_blocks_x_ / kTileBlocks] ?
+                diffPartialBlock(prev_block,
+                                 curr_block,
+                                 bytes_per_row_,
+                                 partial_column_width_ * kBytesPerPixel,
+                                 kBlockSize) : 0U;
         }
 
         // Update pointers for next row.
@@ -169,20 +319,23 @@ void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_imag
 
     // If the screen height is not a multiple of the block size, then this handles the last partial
     // row. This situation is far more common than the 'partial column' case.
-    if (partial_row_height_ != 0)
+    if (partial_row_height_ != 0 && first_row <= full_blocks_y_ && full_blocks_y_ < last_row)
     {
         const uint8_t* prev_block = prev_block_row_start;
         const uint8_t* curr_block = curr_block_row_start;
 
         uint8_t* is_different = is_diff_row_start;
+        const uint8_t* tile_changed =
+            tile_changed_.get() + (full_blocks_y_ / kTileBlocks) * tiles_x_;
 
         for (int x = 0; x < full_blocks_x_; ++x)
         {
-            *is_different = diffPartialBlock(prev_block,
-                                             curr_block,
-                                             bytes_per_row_,
-                                             kBytesPerBlock,
-                                             partial_row_height_);
+            *is_different = tile_changed[x / kTileBlocks] ?
+                diffPartialBlock(prev_block,
+                                 curr_block,
+                                 bytes_per_row_,
+                                 kBytesPerBlock,
+                                 partial_row_height_) : 0U;
 
             prev_block += kBytesPerBlock;
             curr_block += kBytesPerBlock;
@@ -191,111 +344,59 @@ void Differ::markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_imag
 
         if (partial_column_width_ != 0)
         {
-            *is_different =
+            *is_different = tile_changed[full_blocks_x_ / kTileBlocks] ?
                 diffPartialBlock(prev_block,
                                  curr_block,
                                  bytes_per_row_,
                                  partial_column_width_ * kBytesPerPixel,
-                                 partial_row_height_);
+                                 partial_row_height_) : 0U;
         }
     }
 }
 
-// After the dirty blocks have been identified, this routine merges adjacent blocks into a region.
-// The goal is to minimize the region that covers the dirty blocks.
-void Differ::mergeBlocks(Region* dirty_region)
+void Differ::calcDirtyRegion(const uint8_t* prev_image,
+                             const uint8_t* curr_image,
+                             Region* dirty_region)
 {
-    uint8_t* is_diff_row_start = diff_info_.get();
-    const int diff_stride = diff_width_;
+    // The checksums describe the previous image only if it is the one that was diffed last time.
+    const bool full_sweep =
+        prev_image != last_image_ || frames_since_sweep_ + 1 >= kFullSweepInterval;
 
-    for (int y = 0; y < diff_height_; ++y)
+    if (!band_rows_)
     {
-        uint8_t* is_different = is_diff_row_start;
+        // Identify all the blocks that contain changed pixels.
+        updateTiles(curr_image, 0, diff_height_, full_sweep);
+        markDirtyBlocks(prev_image, curr_image, 0, diff_height_);
+        dirty_blocks_.setBlockMap(diff_info_.get(), diff_width_, 0, diff_height_);
+    }
+    else
+    {
+        // Each band of block rows is diffed in parallel. The bands set different rows of the
+        // dirty blocks.
+        const int band_count = (diff_height_ + band_rows_ - 1) / band_rows_;
+        std::vector<ThreadPool::Task> tasks;
 
-        for (int x = 0; x < diff_width_; ++x)
+        for (int i = 0; i < band_count; ++i)
         {
-            // We've found a modified block. Look at blocks to the right and below to group this
-            // block with as many others as we can.
-            if (*is_different != 0)
+            const int first_row = i * band_rows_;
+            const int last_row = std::min(first_row + band_rows_, diff_height_);
+
+            tasks.emplace_back([=]()
             {
-                // Width and height of the rectangle in blocks.
-                int width  = 1;
-                int height = 1;
-
-                *is_different = 0;
-
-                // Group with blocks to the right. We can keep looking until we find an unchanged
-                // block because we have a boundary block which is never marked as having diffs.
-                uint8_t* right = is_different + 1;
-
-                while (*right != 0)
-                {
-                    *right++ = 0;
-                    ++width;
-                }
-
-                // Group with blocks below. The entire width of blocks that we matched above much
-                // match for each row that we add.
-                uint8_t* bottom = is_different;
-                bool found_new_row;
-
-                do
-                {
-                    found_new_row = true;
-                    bottom += diff_stride;
-                    right = bottom;
-
-                    for (int x2 = 0; x2 < width; ++x2)
-                    {
-                        if (*right++ == 0)
-                            found_new_row = false;
-                    }
-
-                    if (found_new_row)
-                    {
-                        ++height;
-
-                        // We need to go back and erase the diff markers so that we don't try to
-                        // add these blocks a second time.
-                        right = bottom;
-
-                        for (int x2 = 0; x2 < width; ++x2)
-                        {
-                            *right++ = 0;
-                        }
-                    }
-                } while (found_new_row);
-
-                Rect dirty_rect = Rect::makeXYWH(x * kBlockSize, y * kBlockSize,
-                                                 width * kBlockSize, height * kBlockSize);
-
-                dirty_rect.intersectWith(screen_rect_);
-
-                // Add rect to region.
-                dirty_region->addRect(dirty_rect);
-            }
-
-            // Increment to next block in this row.
-            ++is_different;
+                updateTiles(curr_image, first_row, last_row, full_sweep);
+                markDirtyBlocks(prev_image, curr_image, first_row, last_row);
+                dirty_blocks_.setBlockMap(diff_info_.get(), diff_width_, first_row, last_row);
+            });
         }
 
-        // Go to start of next row.
-        is_diff_row_start += diff_stride;
+        ThreadPool::shared()->runTasks(std::move(tasks), kMaxDiffThreads);
     }
-}
-
-void Differ::calcDirtyRegion(const uint8_t* prev_image,
-                             const uint8_t* curr_image,
-                             Region* dirty_region)
-{
-    dirty_region->clear();
 
-    // Identify all the blocks that contain changed pixels.
-    markDirtyBlocks(prev_image, curr_image);
+    last_image_ = curr_image;
+    frames_since_sweep_ = full_sweep ? 0 : frames_since_sweep_ + 1;
 
-    // Now that we've identified the blocks that have changed, merge adjacent blocks to minimize
-    // the number of rects that we return.
-    mergeBlocks(dirty_region);
+    // Adjacent dirty blocks are merged to minimize the number of rects that we return.
+    dirty_blocks_.toRegion(dirty_region);
 }
 
 } // namespace base
@@ -20,6 +20,7 @@
 #define BASE__DESKTOP__DIFFER_H
 
 #include "base/macros_magic.h"
+#include "base/desktop/block_region.h"
 #include "base/desktop/region.h"
 
 #include <memory>
@@ -31,7 +32,7 @@ class Differ
 {
 public:
     explicit Differ(const Size& size);
-    ~Differ() = default;
+    ~Differ();
 
     void calcDirtyRegion(const uint8_t* prev_image,
                          const uint8_t* curr_image,
@@ -42,10 +43,11 @@ private:
 
     static DiffFullBlockFunc diffFunction();
 
-    void markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image);
-    void mergeBlocks(Region* dirty_region);
+    void updateTiles(const uint8_t* curr_image, int first_row, int last_row, bool full_sweep);
+    void markDirtyBlocks(const uint8_t* prev_image, const uint8_t* curr_image,
+                         int first_row, int last_row);
 
-    const Rect screen_rect_;
+    const Size size_;
     const int bytes_per_row_;
     const int diff_width_;
     const int diff_height_;
@@ -57,8 +59,26 @@ private:
     int block_stride_y_;
 
     std::unique_ptr<uint8_t[]> diff_info_;
+    BlockRegion dirty_blocks_;
     DiffFullBlockFunc diff_full_block_func_;
 
+    // Large screens are split into bands of |band_rows_| block rows which are diffed in parallel
+    // on the shared thread pool. If it is 0, the screen is diffed on the calling thread.
+    int band_rows_ = 0;
+
+    // The screen is also split into tiles of several blocks. Only the tiles whose checksum
+    // differs from the checksum of the previous frame are diffed block by block, so an idle
+    // screen is read once instead of comparing two frames.
+    const int tiles_x_;
+    const int tiles_y_;
+    std::unique_ptr<uint64_t[]> tile_checksums_;
+    std::unique_ptr<uint8_t[]> tile_changed_;
+
+    // The checksums are valid only if |prev_image| is the image passed as |curr_image| last time.
+    // Every block is also diffed periodically in case the images were changed behind our back.
+    const uint8_t* last_image_ = nullptr;
+    int frames_since_sweep_ = 0;
+
     DISALLOW_COPY_AND_ASSIGN(Differ);
 };
 
@@ -0,0 +1,188 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/cpuid_util.h"
+#include "base/desktop/diff_block_32bpp_avx2.h"
+#include "base/desktop/diff_block_32bpp_avx512.h"
+#include "base/desktop/diff_block_32bpp_c.h"
+#include "base/desktop/diff_block_32bpp_neon.h"
+#include "base/desktop/diff_block_32bpp_sse2.h"
+#include "base/desktop/differ.h"
+#include "base/desktop/frame.h"
+#include "base/desktop/region.h"
+#include "base/desktop/screen_fixture.h"
+
+#include <benchmark/benchmark.h>
+
+namespace base {
+
+namespace {
+
+using DiffBlockFunc = uint8_t(*)(const uint8_t*, const uint8_t*, int);
+
+void BM_Differ(benchmark::State& state)
+{
+    const ScreenFixture& fixture = ScreenFixture::shared();
+    if (fixture.frameCount() < 2)
+    {
+        state.SkipWithError("At least two frames are required");
+        return;
+    }
+
+    Differ differ(fixture.size());
+    Region region;
+    int index = 1;
+
+    for (auto _ : state)
+    {
+        region.clear();
+        differ.calcDirtyRegion(
+            fixture.frame(index - 1)->frameData(), fixture.frame(index)->frameData(), &region);
+        benchmark::DoNotOptimize(region);
+
+        if (++index == fixture.frameCount())
+            index = 1;
+    }
+
+    const Size& size = fixture.size();
+    state.SetBytesProcessed(
+        state.iterations() * size.width() * size.height() * Frame::kBytesPerPixel);
+}
+BENCHMARK(BM_Differ);
+
+// Compares blocks which are the same (the worst case: all the pixels are read). The differ uses
+// 16x16 blocks, the 32x32 kernels are kept for comparison.
+void runDiffBlock(benchmark::State& state, DiffBlockFunc diff_func, int block_size)
+{
+    const ScreenFixture& fixture = ScreenFixture::shared();
+    const Frame* frame = fixture.frame(0);
+
+    const int blocks_x = fixture.size().width() / block_size;
+    const int blocks_y = fixture.size().height() / block_size;
+    int block = 0;
+
+    for (auto _ : state)
+    {
+        const uint8_t* data = frame->frameDataAtPos(
+            (block % blocks_x) * block_size, (block / blocks_x) * block_size);
+
+        benchmark::DoNotOptimize(diff_func(data, data, frame->stride()));
+
+        if (++block == blocks_x * blocks_y)
+            block = 0;
+    }
+
+    state.SetBytesProcessed(
+        state.iterations() * 2 * block_size * block_size * Frame::kBytesPerPixel);
+}
+
+void BM_DiffBlock_C(benchmark::State& state)
+{
+    runDiffBlock(state, diffFullBlock_32bpp_16x16_C, 16);
+}
+BENCHMARK(BM_DiffBlock_C);
+
+void BM_DiffBlock32_C(benchmark::State& state)
+{
+    runDiffBlock(state, diffFullBlock_32bpp_32x32_C, 32);
+}
+BENCHMARK(BM_DiffBlock32_C);
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+void BM_DiffBlock_SSE2(benchmark::State& state)
+{
+    runDiffBlock(state, diffFullBlock_32bpp_16x16_SSE2, 16);
+}
+BENCHMARK(BM_DiffBlock_SSE2);
+
+void BM_DiffBlock32_SSE2(benchmark::State& state)
+{
+    runDiffBlock(state, diffFullBlock_32bpp_32x32_SSE2, 32);
+}
+BENCHMARK(BM_DiffBlock32_SSE2);
+
+void BM_DiffBlock_AVX2(benchmark::State& state)
+{
+    if (!CpuidUtil::hasAvx2())
+    {
+        state.SkipWithError("AVX2 is not supported");
+        return;
+    }
+
+    runDiffBlock(state, diffFullBlock_32bpp_16x16_AVX2, 16);
+}
+BENCHMARK(BM_DiffBlock_AVX2);
+
+void BM_DiffBlock32_AVX2(benchmark::State& state)
+{
+    if (!CpuidUtil::hasAvx2())
+    {
+        state.SkipWithError("AVX2 is not supported");
+        return;
+    }
+
+    runDiffBlock(state, diffFullBlock_32bpp_32x32_AVX2, 32);
+}
+BENCHMARK(BM_DiffBlock32_AVX2);
+
+void BM_DiffBlock_AVX512(benchmark::State& state)
+{
+    if (!CpuidUtil::hasAvx512f())
+    {
+        state.SkipWithError("AVX-512 is not supported");
+        return;
+    }
+
+    runDiffBlock(state, diffFullBlock_32bpp_16x16_AVX512, 16);
+}
+BENCHMARK(BM_DiffBlock_AVX512);
+
+void BM_DiffBlock32_AVX512(benchmark::State& state)
+{
+    if (!CpuidUtil::hasAvx512f())
+    {
+        state.SkipWithError("AVX-512 is not supported");
+        return;
+    }
+
+    runDiffBlock(state, diffFullBlock_32bpp_32x32_AVX512, 32);
+}
+BENCHMARK(BM_DiffBlock32_AVX512);
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+#if defined(ARCH_CPU_ARM64)
+
+void BM_DiffBlock_NEON(benchmark::State& state)
+{
+    runDiffBlock(state, diffFullBlock_32bpp_16x16_NEON, 16);
+}
+BENCHMARK(BM_DiffBlock_NEON);
+
+void BM_DiffBlock32_NEON(benchmark::State& state)
+{
+    runDiffBlock(state, diffFullBlock_32bpp_32x32_NEON, 32);
+}
+BENCHMARK(BM_DiffBlock32_NEON);
+
+#endif // defined(ARCH_CPU_ARM64)
+
+} // namespace
+
+} // namespace base
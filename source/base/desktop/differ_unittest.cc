@@ -0,0 +1,224 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/differ.h"
+
+#include "base/cpuid_util.h"
+#include "base/desktop/diff_block_32bpp_avx2.h"
+#include "base/desktop/diff_block_32bpp_avx512.h"
+#include "base/desktop/diff_block_32bpp_c.h"
+#include "base/desktop/diff_block_32bpp_neon.h"
+#include "base/desktop/diff_block_32bpp_sse2.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <libyuv/cpu_id.h>
+
+namespace base {
+
+namespace {
+
+// 4K frame.
+const int kWidth = 3840;
+const int kHeight = 2160;
+const int kBytesPerPixel = 4;
+const int kBytesPerRow = kWidth * kBytesPerPixel;
+const int kBlockSize = 16;
+
+using DiffFullBlockFunc = uint8_t(*)(const uint8_t*, const uint8_t*, int);
+
+struct DiffKernel
+{
+    const char* name;
+    DiffFullBlockFunc func;
+};
+
+std::vector<DiffKernel> availableKernels()
+{
+    std::vector<DiffKernel> kernels;
+
+    kernels.push_back({ "C", diffFullBlock_32bpp_16x16_C });
+
+#if defined(ARCH_CPU_X86_FAMILY)
+    if (libyuv::TestCpuFlag(libyuv::kCpuHasSSE2))
+        kernels.push_back({ "SSE2", diffFullBlock_32bpp_16x16_SSE2 });
+
+    if (CpuidUtil::hasAvx2())
+        kernels.push_back({ "AVX2", diffFullBlock_32bpp_16x16_AVX2 });
+
+    if (CpuidUtil::hasAvx512f())
+        kernels.push_back({ "AVX-512", diffFullBlock_32bpp_16x16_AVX512 });
+#elif defined(ARCH_CPU_ARM64)
+    kernels.push_back({ "NEON", diffFullBlock_32bpp_16x16_NEON });
+#endif // defined(ARCH_CPU_*)
+
+    return kernels;
+}
+
+std::vector<uint8_t> generateFrame(int width = kWidth, int height = kHeight)
+{
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * kBytesPerPixel);
+
+    for (size_t i = 0; i < frame.size(); ++i)
+        frame[i] = static_cast<uint8_t>(i * 7);
+
+    return frame;
+}
+
+} // namespace
+
+TEST(differ, dirty_region)
+{
+    std::vector<uint8_t> prev_frame = generateFrame();
+    std::vector<uint8_t> curr_frame = prev_frame;
+
+    Differ differ(Size(kWidth, kHeight));
+    Region dirty_region;
+
+    differ.calcDirtyRegion(prev_frame.data(), curr_frame.data(), &dirty_region);
+    EXPECT_TRUE(dirty_region.isEmpty());
+
+    const Point changed_pixel(1000, 500);
+    curr_frame[changed_pixel.y() * kBytesPerRow + changed_pixel.x() * kBytesPerPixel] += 1;
+
+    differ.calcDirtyRegion(prev_frame.data(), curr_frame.data(), &dirty_region);
+    EXPECT_TRUE(dirty_region.equals(Region(Rect::makeXYWH(
+        changed_pixel.x() / kBlockSize * kBlockSize,
+        changed_pixel.y() / kBlockSize * kBlockSize,
+        kBlockSize, kBlockSize))));
+}
+
+TEST(differ, bands_match_blocks)
+{
+    // The size is not a multiple of the block size, so there are partial blocks on the edges.
+    const int width = kWidth + 5;
+    const int height = kHeight + 5;
+    const int bytes_per_row = width * kBytesPerPixel;
+
+    std::vector<uint8_t> prev_frame = generateFrame(width, height);
+    std::vector<uint8_t> curr_frame = prev_frame;
+
+    Region expected_region;
+
+    // Vertical lines cross the borders between the bands, diagonal ones touch every band.
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x : { 0, 1000, width - 1, y * width / height })
+        {
+            curr_frame[y * bytes_per_row + x * kBytesPerPixel] ^= 0xFF;
+
+            Rect block = Rect::makeXYWH(x / kBlockSize * kBlockSize, y / kBlockSize * kBlockSize,
+                                        kBlockSize, kBlockSize);
+            block.intersectWith(Rect::makeWH(width, height));
+            expected_region.addRect(block);
+        }
+    }
+
+    Differ differ(Size(width, height));
+    Region dirty_region;
+
+    differ.calcDirtyRegion(prev_frame.data(), curr_frame.data(), &dirty_region);
+    EXPECT_TRUE(dirty_region.equals(expected_region));
+
+    // The diff information is cleared after each call.
+    differ.calcDirtyRegion(prev_frame.data(), prev_frame.data(), &dirty_region);
+    EXPECT_TRUE(dirty_region.isEmpty());
+}
+
+TEST(differ, tiles_follow_frame_queue)
+{
+    const int width = kWidth + 5;
+    const int height = kHeight + 5;
+    const int bytes_per_row = width * kBytesPerPixel;
+
+    // Two buffers are used in turns like in the frame queue of a capturer, so the checksums of
+    // the tiles are reused between the frames.
+    std::vector<uint8_t> frames[2] = { generateFrame(width, height), generateFrame(width, height) };
+
+    Differ differ(Size(width, height));
+    Region dirty_region;
+
+    const Point changed_pixels[] = { Point(0, 0), Point(1000, 500), Point(width - 1, height - 1),
+                                     Point(63, 64), Point(64, 63), Point(width - 1, 0) };
+
+    for (int i = 0; i < 100; ++i)
+    {
+        const std::vector<uint8_t>& prev_frame = frames[i % 2];
+        std::vector<uint8_t>& curr_frame = frames[(i + 1) % 2];
+
+        curr_frame = prev_frame;
+
+        Region expected_region;
+
+        // Every third frame is unchanged.
+        if (i % 3 != 0)
+        {
+            const Point& pixel = changed_pixels[i % std::size(changed_pixels)];
+
+            curr_frame[pixel.y() * bytes_per_row + pixel.x() * kBytesPerPixel + i % 4] ^= 0x01;
+
+            Rect block = Rect::makeXYWH(pixel.x() / kBlockSize * kBlockSize,
+                                        pixel.y() / kBlockSize * kBlockSize,
+                                        kBlockSize, kBlockSize);
+            block.intersectWith(Rect::makeWH(width, height));
+            expected_region.addRect(block);
+        }
+
+        differ.calcDirtyRegion(prev_frame.data(), curr_frame.data(), &dirty_region);
+        EXPECT_TRUE(dirty_region.equals(expected_region)) << "frame " << i;
+    }
+}
+
+TEST(differ, kernels_match)
+{
+    std::vector<uint8_t> prev_frame = generateFrame();
+    std::vector<uint8_t> curr_frame = prev_frame;
+
+    // Change a pixel in every 5th block in a different position of the block.
+    for (int y = 0; y < kHeight; y += kBlockSize)
+    {
+        for (int x = 0; x < kWidth; x += kBlockSize * 5)
+        {
+            const int offset = ((x + y) / kBlockSize) % (kBlockSize * kBlockSize);
+            const int pixel_x = x + offset % kBlockSize;
+            const int pixel_y = y + offset / kBlockSize;
+
+            curr_frame[pixel_y * kBytesPerRow + pixel_x * kBytesPerPixel + offset % 4] ^= 0x80;
+        }
+    }
+
+    for (const auto& kernel : availableKernels())
+    {
+        for (int y = 0; y < kHeight; y += kBlockSize)
+        {
+            for (int x = 0; x < kWidth; x += kBlockSize)
+            {
+                const int offset = y * kBytesPerRow + x * kBytesPerPixel;
+
+                EXPECT_EQ(diffFullBlock_32bpp_16x16_C(
+                              prev_frame.data() + offset, curr_frame.data() + offset, kBytesPerRow),
+                          kernel.func(
+                              prev_frame.data() + offset, curr_frame.data() + offset, kBytesPerRow))
+                    << kernel.name << " " << x << "x" << y;
+            }
+        }
+    }
+}
+
+} // namespace base
@@ -19,13 +19,25 @@
 #include "base/desktop/frame.h"
 
 #include "base/logging.h"
+#include "base/threading/thread_pool.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include <libyuv/convert_argb.h>
 
 namespace base {
 
+namespace {
+
+// Smaller areas are copied on the calling thread. Larger ones (for example, a full screen update)
+// are copied by stripes on the shared thread pool.
+const int64_t kMinParallelCopyPixels = 1920 * 1080;
+const int kCopyStripeHeight = 128;
+const size_t kMaxCopyThreads = 4;
+
+} // namespace
+
 Frame::Frame(const Size& size,
              int stride,
              uint8_t* data,
@@ -46,9 +58,30 @@ bool Frame::contains(int x, int y) const
 
 void Frame::copyPixelsFrom(const uint8_t* src_buffer, int src_stride, const Rect& dest_rect)
 {
-    libyuv::ARGBCopy(src_buffer, src_stride,
-                     frameDataAtPos(dest_rect.topLeft()), stride(),
-                     dest_rect.width(), dest_rect.height());
+    const int64_t pixels = static_cast<int64_t>(dest_rect.width()) * dest_rect.height();
+    if (pixels < kMinParallelCopyPixels)
+    {
+        libyuv::ARGBCopy(src_buffer, src_stride,
+                         frameDataAtPos(dest_rect.topLeft()), stride(),
+                         dest_rect.width(), dest_rect.height());
+        return;
+    }
+
+    std::vector<ThreadPool::Task> tasks;
+
+    for (int y = 0; y < dest_rect.height(); y += kCopyStripeHeight)
+    {
+        const int height = std::min(kCopyStripeHeight, dest_rect.height() - y);
+
+        tasks.emplace_back([=]()
+        {
+            libyuv::ARGBCopy(src_buffer + static_cast<ptrdiff_t>(y) * src_stride, src_stride,
+                             frameDataAtPos(dest_rect.x(), dest_rect.y() + y), stride(),
+                             dest_rect.width(), height);
+        });
+    }
+
+    ThreadPool::shared()->runTasks(std::move(tasks), kMaxCopyThreads);
 }
 
 void Frame::copyPixelsFrom(const Frame& src_frame, const Point& src_pos, const Rect& dest_rect)
@@ -56,6 +89,33 @@ void Frame::copyPixelsFrom(const Frame& src_frame, const Point& src_pos, const R
     copyPixelsFrom(src_frame.frameDataAtPos(src_pos), src_frame.stride(), dest_rect);
 }
 
+void Frame::movePixels(const Point& src_pos, const Rect& dest_rect)
+{
+    const size_t row_size = static_cast<size_t>(dest_rect.width()) * kBytesPerPixel;
+    const int height = dest_rect.height();
+
+    if (src_pos.y() < dest_rect.y())
+    {
+        // The area is moved down. The rows are copied from the bottom so that the source rows are
+        // not overwritten before they are copied.
+        for (int y = height - 1; y >= 0; --y)
+        {
+            memmove(frameDataAtPos(dest_rect.x(), dest_rect.y() + y),
+                    frameDataAtPos(src_pos.x(), src_pos.y() + y),
+                    row_size);
+        }
+    }
+    else
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            memmove(frameDataAtPos(dest_rect.x(), dest_rect.y() + y),
+                    frameDataAtPos(src_pos.x(), src_pos.y() + y),
+                    row_size);
+        }
+    }
+}
+
 uint8_t* Frame::frameDataAtPos(const Point& pos) const
 {
     return frameDataAtPos(pos.x(), pos.y());
@@ -69,9 +129,13 @@ uint8_t* Frame::frameDataAtPos(int x, int y) const
 void Frame::copyFrameInfoFrom(const Frame& other)
 {
     updated_region_ = other.updated_region_;
+    moved_rects_ = other.moved_rects_;
     top_left_ = other.top_left_;
     dpi_ = other.dpi_;
     capturer_type_ = other.capturer_type_;
+    cursor_position_ = other.cursor_position_;
+    active_window_rect_ = other.active_window_rect_;
+    timing_ = other.timing_;
 }
 
 // static
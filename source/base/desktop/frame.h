@@ -22,6 +22,10 @@
 #include "base/macros_magic.h"
 #include "base/desktop/region.h"
 
+#include <chrono>
+#include <optional>
+#include <vector>
+
 namespace base {
 
 class SharedMemoryBase;
@@ -34,6 +38,16 @@ public:
     static const int kBytesPerPixel = 4;
     static const int kBitsPerPixel = 32;
 
+    // An area of the frame that contains the same pixels as the area at |src_pos| of the previous
+    // frame (for example, after scrolling). Moved areas are not included in the updated region.
+    struct MovedRect
+    {
+        Point src_pos;
+        Rect dest_rect;
+    };
+
+    using MovedRects = std::vector<MovedRect>;
+
     SharedMemoryBase* sharedMemory() const { return shared_memory_; }
 
     uint8_t* frameDataAtPos(const Point& pos) const;
@@ -46,9 +60,19 @@ public:
     void copyPixelsFrom(const uint8_t* src_buffer, int src_stride, const Rect& dest_rect);
     void copyPixelsFrom(const Frame& src_frame, const Point& src_pos, const Rect& dest_rect);
 
+    // Copies the pixels at |src_pos| of the same frame to |dest_rect|. The source and destination
+    // areas may overlap.
+    void movePixels(const Point& src_pos, const Rect& dest_rect);
+
     const Region& constUpdatedRegion() const { return updated_region_; }
     Region* updatedRegion() { return &updated_region_; }
 
+    const MovedRects& constMovedRects() const { return moved_rects_; }
+    MovedRects* movedRects() { return &moved_rects_; }
+
+    // Returns true if the frame differs from the previous one.
+    bool hasChanges() const { return !updated_region_.isEmpty() || !moved_rects_.empty(); }
+
     void setTopLeft(const Point& top_left) { top_left_ = top_left; }
     const Point& topLeft() const { return top_left_; }
 
@@ -58,6 +82,29 @@ public:
     void setCapturerType(uint32_t capturer_type) { capturer_type_ = capturer_type; }
     uint32_t capturerType() const { return capturer_type_; }
 
+    // Position of the cursor and the rectangle of the foreground window in the coordinates of the
+    // frame (if they are known). Video encoders spend more bits around them.
+    void setCursorPosition(const std::optional<Point>& position) { cursor_position_ = position; }
+    const std::optional<Point>& cursorPosition() const { return cursor_position_; }
+
+    void setActiveWindowRect(const Rect& rect) { active_window_rect_ = rect; }
+    const Rect& activeWindowRect() const { return active_window_rect_; }
+
+    // Times of the capture of the frame. They are used only for the latency statistics.
+    struct Timing
+    {
+        std::chrono::steady_clock::time_point capture_start;
+        std::chrono::steady_clock::time_point capture_end;
+
+        // Time spent on the search for the changed areas (zero if the capturer does not compare
+        // the frames itself).
+        std::chrono::microseconds diff = std::chrono::microseconds::zero();
+    };
+
+    void setTiming(const Timing& timing) { timing_ = timing; }
+    const Timing& timing() const { return timing_; }
+    Timing* mutableTiming() { return &timing_; }
+
     // Copies various information from |other|. Anything initialized in constructor are not copied.
     // This function is usually used when sharing a source Frame with several clients: the original
     // Frame should be kept unchanged. For example and SharedFrame::share().
@@ -81,9 +128,13 @@ private:
     const int stride_;
 
     Region updated_region_;
+    MovedRects moved_rects_;
     Point top_left_;
     Point dpi_;
     uint32_t capturer_type_ = 0;
+    std::optional<Point> cursor_position_;
+    Rect active_window_rect_;
+    Timing timing_;
 
     DISALLOW_COPY_AND_ASSIGN(Frame);
 };
@@ -23,7 +23,8 @@
 namespace base {
 
 FrameAligned::FrameAligned(const Size& size, uint8_t* data)
-    : Frame(size, size.width() * kBytesPerPixel, data, nullptr)
+    : Frame(size, size.width() * kBytesPerPixel, data, nullptr),
+      memory_(MemoryTag::FRAMES, calcMemorySize(size, kBytesPerPixel))
 {
     // Nothing
 }
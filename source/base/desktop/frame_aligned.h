@@ -20,6 +20,7 @@
 #define BASE__DESKTOP__FRAME_ALIGNED_H
 
 #include "base/desktop/frame.h"
+#include "base/memory/memory_accounting.h"
 
 #include <memory>
 
@@ -35,6 +36,8 @@ public:
 private:
     FrameAligned(const Size& size, uint8_t* data);
 
+    TrackedMemory memory_;
+
     DISALLOW_COPY_AND_ASSIGN(FrameAligned);
 };
 
@@ -0,0 +1,255 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/frame_pool.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+#include "base/ipc/shared_memory.h"
+#include "base/ipc/shared_memory_factory.h"
+#include "base/memory/aligned_memory.h"
+
+#include <deque>
+#include <mutex>
+
+namespace base {
+
+namespace {
+
+const size_t kAlignment = 32;
+
+} // namespace
+
+class FramePool::Buffer
+{
+public:
+    Buffer(size_t size, uint8_t* memory)
+        : size_(size),
+          memory_(memory)
+    {
+        // Nothing
+    }
+
+    Buffer(size_t size, std::unique_ptr<SharedMemory> shared_memory, SharedMemoryFactory* factory)
+        : size_(size),
+          shared_memory_(std::move(shared_memory)),
+          factory_(factory)
+    {
+        // Nothing
+    }
+
+    size_t size() const { return size_; }
+    SharedMemoryFactory* factory() const { return factory_; }
+    SharedMemory* sharedMemory() const { return shared_memory_.get(); }
+
+    uint8_t* data() const
+    {
+        if (shared_memory_)
+            return reinterpret_cast<uint8_t*>(shared_memory_->data());
+
+        return memory_.get();
+    }
+
+private:
+    const size_t size_;
+    std::unique_ptr<uint8_t, AlignedFreeDeleter> memory_;
+    std::unique_ptr<SharedMemory> shared_memory_;
+    SharedMemoryFactory* const factory_ = nullptr;
+
+    DISALLOW_COPY_AND_ASSIGN(Buffer);
+};
+
+class FramePool::Storage
+{
+public:
+    explicit Storage(size_t memory_limit)
+        : memory_limit_(memory_limit)
+    {
+        // Nothing
+    }
+
+    std::unique_ptr<Buffer> take(size_t size, SharedMemoryFactory* factory);
+    void put(std::unique_ptr<Buffer> buffer);
+    void clear();
+
+    size_t memoryLimit() const { return memory_limit_; }
+    size_t unusedMemory() const;
+
+private:
+    const size_t memory_limit_;
+
+    mutable std::mutex lock_;
+
+    // The most recently released buffers are at the back.
+    std::deque<std::unique_ptr<Buffer>> buffers_;
+    size_t unused_memory_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(Storage);
+};
+
+std::unique_ptr<FramePool::Buffer> FramePool::Storage::take(
+    size_t size, SharedMemoryFactory* factory)
+{
+    std::scoped_lock lock(lock_);
+
+    for (auto it = buffers_.rbegin(); it != buffers_.rend(); ++it)
+    {
+        if ((*it)->size() == size && (*it)->factory() == factory)
+        {
+            std::unique_ptr<Buffer> buffer = std::move(*it);
+            buffers_.erase(std::next(it).base());
+            unused_memory_ -= size;
+            return buffer;
+        }
+    }
+
+    return nullptr;
+}
+
+void FramePool::Storage::put(std::unique_ptr<Buffer> buffer)
+{
+    // The buffers are freed outside of the lock.
+    std::deque<std::unique_ptr<Buffer>> freed_buffers;
+
+    {
+        std::scoped_lock lock(lock_);
+
+        if (buffer->size() > memory_limit_)
+            return;
+
+        while (unused_memory_ + buffer->size() > memory_limit_)
+        {
+            unused_memory_ -= buffers_.front()->size();
+            freed_buffers.emplace_back(std::move(buffers_.front()));
+            buffers_.pop_front();
+        }
+
+        unused_memory_ += buffer->size();
+        buffers_.emplace_back(std::move(buffer));
+    }
+}
+
+void FramePool::Storage::clear()
+{
+    std::deque<std::unique_ptr<Buffer>> freed_buffers;
+
+    {
+        std::scoped_lock lock(lock_);
+        freed_buffers.swap(buffers_);
+        unused_memory_ = 0;
+    }
+}
+
+size_t FramePool::Storage::unusedMemory() const
+{
+    std::scoped_lock lock(lock_);
+    return unused_memory_;
+}
+
+class FramePool::PooledFrame : public Frame
+{
+public:
+    PooledFrame(const Size& size, std::unique_ptr<Buffer> buffer, std::weak_ptr<Storage> storage)
+        : Frame(size, size.width() * kBytesPerPixel, buffer->data(), buffer->sharedMemory()),
+          buffer_(std::move(buffer)),
+          storage_(std::move(storage))
+    {
+        // Nothing
+    }
+
+    ~PooledFrame() override
+    {
+        std::shared_ptr<Storage> storage = storage_.lock();
+        if (storage)
+            storage->put(std::move(buffer_));
+    }
+
+private:
+    std::unique_ptr<Buffer> buffer_;
+    std::weak_ptr<Storage> storage_;
+
+    DISALLOW_COPY_AND_ASSIGN(PooledFrame);
+};
+
+FramePool::FramePool(size_t memory_limit)
+    : storage_(std::make_shared<Storage>(memory_limit))
+{
+    // Nothing
+}
+
+FramePool::~FramePool() = default;
+
+std::unique_ptr<Frame> FramePool::create(const Size& size)
+{
+    return createFrame(size, nullptr);
+}
+
+std::unique_ptr<Frame> FramePool::createShared(const Size& size, SharedMemoryFactory* factory)
+{
+    DCHECK(factory);
+    return createFrame(size, factory);
+}
+
+void FramePool::clear()
+{
+    storage_->clear();
+}
+
+size_t FramePool::memoryLimit() const
+{
+    return storage_->memoryLimit();
+}
+
+size_t FramePool::unusedMemory() const
+{
+    return storage_->unusedMemory();
+}
+
+std::unique_ptr<Frame> FramePool::createFrame(const Size& size, SharedMemoryFactory* factory)
+{
+    if (size.isEmpty())
+        return nullptr;
+
+    const size_t buffer_size = static_cast<size_t>(size.width()) *
+        static_cast<size_t>(size.height()) * Frame::kBytesPerPixel;
+
+    std::unique_ptr<Buffer> buffer = storage_->take(buffer_size, factory);
+    if (!buffer)
+    {
+        if (factory)
+        {
+            std::unique_ptr<SharedMemory> shared_memory = factory->create(buffer_size);
+            if (!shared_memory)
+                return nullptr;
+
+            buffer = std::make_unique<Buffer>(buffer_size, std::move(shared_memory), factory);
+        }
+        else
+        {
+            uint8_t* memory = reinterpret_cast<uint8_t*>(alignedAlloc(buffer_size, kAlignment));
+            if (!memory)
+                return nullptr;
+
+            buffer = std::make_unique<Buffer>(buffer_size, memory);
+        }
+    }
+
+    return std::make_unique<PooledFrame>(size, std::move(buffer), storage_);
+}
+
+} // namespace base
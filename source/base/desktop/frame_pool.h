@@ -0,0 +1,75 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__FRAME_POOL_H
+#define BASE__DESKTOP__FRAME_POOL_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+
+#include <memory>
+
+namespace base {
+
+class Frame;
+class SharedMemoryFactory;
+
+// Keeps the buffers of destroyed frames and gives them to the new frames of the same size. Screen
+// switches and resolution changes repeatedly allocate buffers of several megabytes (33 MB for a
+// 4K screen), which costs page faults and, for shared memory, a round trip to the service.
+//
+// Frames may outlive the pool, in which case their buffers are freed. Frames can be destroyed on
+// any thread. The buffers are not cleared when reused.
+class FramePool
+{
+public:
+    // Two unused 4K frames.
+    static const size_t kDefaultMemoryLimit = 64 * 1024 * 1024;
+
+    // |memory_limit| is the maximum size of the unused buffers kept by the pool. The least
+    // recently released buffers are freed first.
+    explicit FramePool(size_t memory_limit = kDefaultMemoryLimit);
+    ~FramePool();
+
+    // Creates a frame in the memory of the process (aligned to 32 bytes).
+    std::unique_ptr<Frame> create(const Size& size);
+
+    // Creates a frame in the shared memory of |factory|.
+    std::unique_ptr<Frame> createShared(const Size& size, SharedMemoryFactory* factory);
+
+    // Frees all unused buffers.
+    void clear();
+
+    size_t memoryLimit() const;
+    size_t unusedMemory() const;
+
+private:
+    class Buffer;
+    class PooledFrame;
+    class Storage;
+
+    std::unique_ptr<Frame> createFrame(const Size& size, SharedMemoryFactory* factory);
+
+    std::shared_ptr<Storage> storage_;
+
+    DISALLOW_COPY_AND_ASSIGN(FramePool);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__FRAME_POOL_H
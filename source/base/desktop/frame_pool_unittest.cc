@@ -0,0 +1,105 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/frame_pool.h"
+
+#include "base/desktop/frame.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(640, 480);
+const size_t kFrameMemory = 640 * 480 * Frame::kBytesPerPixel;
+
+} // namespace
+
+TEST(FramePoolTest, ReuseBuffer)
+{
+    FramePool pool;
+
+    std::unique_ptr<Frame> frame = pool.create(kFrameSize);
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(frame->size(), kFrameSize);
+    EXPECT_EQ(frame->stride(), kFrameSize.width() * Frame::kBytesPerPixel);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(frame->frameData()) % 32, 0u);
+
+    uint8_t* data = frame->frameData();
+    frame.reset();
+    EXPECT_EQ(pool.unusedMemory(), kFrameMemory);
+
+    frame = pool.create(kFrameSize);
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(frame->frameData(), data);
+    EXPECT_EQ(pool.unusedMemory(), 0u);
+}
+
+TEST(FramePoolTest, DifferentSize)
+{
+    FramePool pool;
+
+    std::unique_ptr<Frame> frame = pool.create(kFrameSize);
+    frame.reset();
+
+    frame = pool.create(Size(320, 240));
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(frame->size(), Size(320, 240));
+
+    // The buffer of the other size is still kept.
+    EXPECT_EQ(pool.unusedMemory(), kFrameMemory);
+}
+
+TEST(FramePoolTest, MemoryLimit)
+{
+    FramePool pool(kFrameMemory * 2);
+
+    std::unique_ptr<Frame> frames[3];
+    for (auto& frame : frames)
+        frame = pool.create(kFrameSize);
+
+    for (auto& frame : frames)
+        frame.reset();
+
+    EXPECT_EQ(pool.unusedMemory(), kFrameMemory * 2);
+
+    // A buffer larger than the limit is not kept.
+    std::unique_ptr<Frame> large_frame = pool.create(Size(1280, 960));
+    large_frame.reset();
+    EXPECT_EQ(pool.unusedMemory(), kFrameMemory * 2);
+
+    pool.clear();
+    EXPECT_EQ(pool.unusedMemory(), 0u);
+}
+
+TEST(FramePoolTest, FrameOutlivesPool)
+{
+    std::unique_ptr<Frame> frame;
+
+    {
+        FramePool pool;
+        frame = pool.create(kFrameSize);
+    }
+
+    ASSERT_TRUE(frame);
+    memset(frame->frameData(), 0, kFrameMemory);
+    frame.reset();
+}
+
+} // namespace base
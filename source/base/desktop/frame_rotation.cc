@@ -19,6 +19,9 @@
 #include "base/desktop/frame_rotation.h"
 
 #include "base/logging.h"
+#include "base/threading/thread_pool.h"
+
+#include <algorithm>
 
 #include <libyuv/rotate_argb.h>
 
@@ -26,6 +29,12 @@ namespace base {
 
 namespace {
 
+// Smaller rectangles are rotated on the calling thread. Larger ones are split into stripes of
+// source rows which are rotated on the shared thread pool.
+const int64_t kMinParallelPixels = 512 * 512;
+const int kStripeHeight = 64;
+const size_t kMaxRotateThreads = 4;
+
 libyuv::RotationMode ToLibyuvRotationMode(Rotation rotation)
 {
     switch (rotation)
@@ -126,12 +135,38 @@ void rotateDesktopFrame(const Frame& source,
     if (target_rect.isEmpty())
         return;
 
-    int result = libyuv::ARGBRotate(
-        source.frameDataAtPos(source_rect.topLeft()), source.stride(),
-        target->frameDataAtPos(target_rect.topLeft()), target->stride(),
-        source_rect.width(), source_rect.height(),
-        ToLibyuvRotationMode(rotation));
-    DCHECK_EQ(result, 0);
+    auto rotate_rect = [&](const Rect& rect)
+    {
+        const Rect rotated_rect = rotateAndOffsetRect(rect, source.size(), rotation, target_offset);
+
+        int result = libyuv::ARGBRotate(
+            source.frameDataAtPos(rect.topLeft()), source.stride(),
+            target->frameDataAtPos(rotated_rect.topLeft()), target->stride(),
+            rect.width(), rect.height(),
+            ToLibyuvRotationMode(rotation));
+        DCHECK_EQ(result, 0);
+    };
+
+    const int64_t pixels = static_cast<int64_t>(source_rect.width()) * source_rect.height();
+    if (pixels < kMinParallelPixels)
+    {
+        rotate_rect(source_rect);
+        return;
+    }
+
+    // Each stripe of the source rows becomes a stripe of the target columns (or rows for 180
+    // degrees). The stripes do not overlap, so they are written in parallel.
+    std::vector<ThreadPool::Task> tasks;
+
+    for (int top = source_rect.top(); top < source_rect.bottom(); top += kStripeHeight)
+    {
+        const Rect stripe = Rect::makeLTRB(source_rect.left(), top, source_rect.right(),
+                                           std::min(top + kStripeHeight, source_rect.bottom()));
+
+        tasks.emplace_back([=]() { rotate_rect(stripe); });
+    }
+
+    ThreadPool::shared()->runTasks(std::move(tasks), kMaxRotateThreads);
 }
 
 } // namespace base
@@ -0,0 +1,101 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/frame_rotation.h"
+
+#include "base/desktop/frame_simple.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+uint32_t pixelAt(const Frame& frame, int x, int y)
+{
+    uint32_t pixel;
+    memcpy(&pixel, frame.frameDataAtPos(x, y), sizeof(pixel));
+    return pixel;
+}
+
+// Each pixel is unique, so a misplaced pixel is found.
+std::unique_ptr<Frame> createTestFrame(const Size& size)
+{
+    std::unique_ptr<Frame> frame = FrameSimple::create(size);
+
+    for (int y = 0; y < size.height(); ++y)
+    {
+        for (int x = 0; x < size.width(); ++x)
+        {
+            const uint32_t pixel = static_cast<uint32_t>(y) << 16 | static_cast<uint32_t>(x);
+            memcpy(frame->frameDataAtPos(x, y), &pixel, sizeof(pixel));
+        }
+    }
+
+    return frame;
+}
+
+void testRotation(const Size& size, const Rect& source_rect)
+{
+    const Rotation kRotations[] = { Rotation::CLOCK_WISE_0, Rotation::CLOCK_WISE_90,
+                                    Rotation::CLOCK_WISE_180, Rotation::CLOCK_WISE_270 };
+
+    std::unique_ptr<Frame> source = createTestFrame(size);
+
+    for (const auto& rotation : kRotations)
+    {
+        SCOPED_TRACE(static_cast<int>(rotation));
+
+        const Point offset(3, 5);
+        const Size target_size = rotateSize(size, rotation);
+
+        std::unique_ptr<Frame> target = FrameSimple::create(
+            Size(target_size.width() + offset.x(), target_size.height() + offset.y()));
+
+        rotateDesktopFrame(*source, source_rect, rotation, offset, target.get());
+
+        for (int y = source_rect.top(); y < source_rect.bottom(); ++y)
+        {
+            for (int x = source_rect.left(); x < source_rect.right(); ++x)
+            {
+                Rect pixel_rect = rotateRect(Rect::makeXYWH(x, y, 1, 1), size, rotation);
+                pixel_rect.translate(offset.x(), offset.y());
+
+                ASSERT_EQ(pixelAt(*target, pixel_rect.x(), pixel_rect.y()),
+                          pixelAt(*source, x, y)) << x << "x" << y;
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST(frame_rotation_test, small_rect)
+{
+    testRotation(Size(100, 60), Rect::makeXYWH(10, 20, 30, 17));
+}
+
+TEST(frame_rotation_test, large_rect)
+{
+    // Large rects are rotated by stripes in parallel.
+    testRotation(Size(1100, 900), Rect::makeXYWH(7, 3, 1090, 870));
+}
+
+} // namespace base
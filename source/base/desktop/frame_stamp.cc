@@ -0,0 +1,142 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/frame_stamp.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame.h"
+
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+const int kChecksumBits = 16;
+const int kBitCount = FrameStamp::kValueBits + kChecksumBits;
+
+// The blocks are large enough to keep their colors after the encoding with any quality.
+const int kBlockSize = 16;
+const int kBlocksPerRow = 16;
+const int kRowCount = kBitCount / kBlocksPerRow;
+
+const uint64_t kValueMask = (uint64_t(1) << FrameStamp::kValueBits) - 1;
+
+uint64_t checksum(uint64_t value)
+{
+    return ((value ^ (value >> 16) ^ (value >> 32)) & 0xFFFF) ^ 0x5A3C;
+}
+
+Rect blockRect(int bit)
+{
+    return Rect::makeXYWH((bit % kBlocksPerRow) * kBlockSize, (bit / kBlocksPerRow) * kBlockSize,
+                          kBlockSize, kBlockSize);
+}
+
+void fillBlock(Frame* frame, const Rect& rect, uint8_t color)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+        memset(frame->frameDataAtPos(rect.left(), y), color, rect.width() * Frame::kBytesPerPixel);
+}
+
+// Only the center of the block is taken into account: the edges are blurred by the encoder.
+bool readBlock(const Frame& frame, const Rect& rect)
+{
+    const int margin = kBlockSize / 4;
+    uint32_t sum = 0;
+    uint32_t count = 0;
+
+    for (int y = rect.top() + margin; y < rect.bottom() - margin; ++y)
+    {
+        const uint8_t* pixel = frame.frameDataAtPos(rect.left() + margin, y);
+
+        for (int x = rect.left() + margin; x < rect.right() - margin; ++x)
+        {
+            sum += pixel[0] + pixel[1] + pixel[2];
+            count += 3;
+            pixel += Frame::kBytesPerPixel;
+        }
+    }
+
+    return sum >= count * 128;
+}
+
+} // namespace
+
+// static
+Rect FrameStamp::rect()
+{
+    return Rect::makeWH(kBlocksPerRow * kBlockSize, kRowCount * kBlockSize);
+}
+
+// static
+void FrameStamp::write(uint64_t value, Frame* frame)
+{
+    DCHECK(frame);
+
+    const Rect stamp_rect = rect();
+    if (!Rect::makeSize(frame->size()).containsRect(stamp_rect))
+        return;
+
+    value &= kValueMask;
+    const uint64_t bits = value | (checksum(value) << kValueBits);
+
+    for (int bit = 0; bit < kBitCount; ++bit)
+        fillBlock(frame, blockRect(bit), ((bits >> bit) & 1) ? 0xFF : 0x00);
+
+    frame->updatedRegion()->addRect(stamp_rect);
+}
+
+// static
+std::optional<uint64_t> FrameStamp::read(const Frame& frame)
+{
+    if (!Rect::makeSize(frame.size()).containsRect(rect()))
+        return std::nullopt;
+
+    uint64_t bits = 0;
+
+    for (int bit = 0; bit < kBitCount; ++bit)
+    {
+        if (readBlock(frame, blockRect(bit)))
+            bits |= uint64_t(1) << bit;
+    }
+
+    const uint64_t value = bits & kValueMask;
+    if ((bits >> kValueBits) != checksum(value))
+        return std::nullopt;
+
+    return value;
+}
+
+// static
+uint64_t FrameStamp::currentTime()
+{
+    const auto time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    return static_cast<uint64_t>(time.count()) & kValueMask;
+}
+
+// static
+std::chrono::microseconds FrameStamp::elapsedSince(uint64_t stamp)
+{
+    // The difference is taken modulo 2^kValueBits, so that the wrap of the value is handled.
+    const uint64_t elapsed = (currentTime() - stamp) & kValueMask;
+    return std::chrono::microseconds(static_cast<int64_t>(elapsed));
+}
+
+} // namespace base
@@ -0,0 +1,68 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__FRAME_STAMP_H
+#define BASE__DESKTOP__FRAME_STAMP_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace base {
+
+class Frame;
+
+// A value drawn into the pixels of a frame, which can be read after the frame has been encoded
+// with a lossy codec and decoded again. The capturer writes the time of the capture and the client
+// reads it when the frame is displayed, which gives the latency of the whole pipeline.
+//
+// The value is drawn as black and white blocks at the top left corner of the frame, followed by a
+// checksum, so that a frame without a stamp is not taken for a stamped one.
+class FrameStamp
+{
+public:
+    // Number of the bits of the value which are kept.
+    static const int kValueBits = 48;
+
+    // Area of the frame which is overwritten by the stamp.
+    static Rect rect();
+
+    // Draws the lower kValueBits bits of |value| into |frame| and adds rect() to the updated region
+    // of the frame. Does nothing if the frame is smaller than rect().
+    static void write(uint64_t value, Frame* frame);
+
+    // Returns the value drawn into |frame| or std::nullopt if the frame has no valid stamp.
+    static std::optional<uint64_t> read(const Frame& frame);
+
+    // Current time (microseconds of the system clock) reduced to kValueBits bits. The clocks of
+    // the host and the client must be synchronized if they are on different computers.
+    static uint64_t currentTime();
+
+    // Time elapsed since |stamp| which was made by currentTime().
+    static std::chrono::microseconds elapsedSince(uint64_t stamp);
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(FrameStamp);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__FRAME_STAMP_H
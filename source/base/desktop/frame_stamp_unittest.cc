@@ -0,0 +1,118 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/frame_stamp.h"
+
+#include "base/desktop/frame_simple.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(320, 240);
+
+} // namespace
+
+TEST(FrameStampTest, WriteAndRead)
+{
+    std::unique_ptr<FrameSimple> frame = FrameSimple::create(kFrameSize);
+    ASSERT_TRUE(frame);
+    memset(frame->frameData(), 0x80, frame->stride() * kFrameSize.height());
+
+    const uint64_t values[] = { 0, 1, 0x123456789ABC, (uint64_t(1) << FrameStamp::kValueBits) - 1 };
+
+    for (uint64_t value : values)
+    {
+        frame->updatedRegion()->clear();
+        FrameStamp::write(value, frame.get());
+
+        EXPECT_EQ(FrameStamp::read(*frame), value);
+        EXPECT_TRUE(frame->constUpdatedRegion().equals(Region(FrameStamp::rect())));
+    }
+
+    // The pixels outside of the stamp are not changed.
+    EXPECT_EQ(*frame->frameDataAtPos(FrameStamp::rect().right(), 0), 0x80);
+    EXPECT_EQ(*frame->frameDataAtPos(0, FrameStamp::rect().bottom()), 0x80);
+}
+
+TEST(FrameStampTest, ReadWithNoise)
+{
+    std::unique_ptr<FrameSimple> frame = FrameSimple::create(kFrameSize);
+    ASSERT_TRUE(frame);
+
+    const uint64_t value = 0xA5A5F00F1234;
+    FrameStamp::write(value, frame.get());
+
+    // A lossy encoder changes the colors of the blocks a little.
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> noise(-60, 60);
+
+    for (int y = 0; y < kFrameSize.height(); ++y)
+    {
+        uint8_t* pixel = frame->frameDataAtPos(0, y);
+        for (int x = 0; x < kFrameSize.width() * Frame::kBytesPerPixel; ++x)
+            pixel[x] = static_cast<uint8_t>(std::clamp(pixel[x] + noise(random), 0, 255));
+    }
+
+    EXPECT_EQ(FrameStamp::read(*frame), value);
+}
+
+TEST(FrameStampTest, NoStamp)
+{
+    std::unique_ptr<FrameSimple> frame = FrameSimple::create(kFrameSize);
+    ASSERT_TRUE(frame);
+
+    memset(frame->frameData(), 0, frame->stride() * kFrameSize.height());
+    EXPECT_FALSE(FrameStamp::read(*frame));
+
+    memset(frame->frameData(), 0xFF, frame->stride() * kFrameSize.height());
+    EXPECT_FALSE(FrameStamp::read(*frame));
+
+    // A damaged stamp (the first bit is changed) is rejected by the checksum.
+    FrameStamp::write(12344, frame.get());
+    for (int y = 0; y < 16; ++y)
+        memset(frame->frameDataAtPos(0, y), 0xFF, 16 * Frame::kBytesPerPixel);
+    EXPECT_FALSE(FrameStamp::read(*frame));
+}
+
+TEST(FrameStampTest, SmallFrame)
+{
+    std::unique_ptr<FrameSimple> frame = FrameSimple::create(Size(64, 64));
+    ASSERT_TRUE(frame);
+
+    FrameStamp::write(1, frame.get());
+    EXPECT_TRUE(frame->constUpdatedRegion().isEmpty());
+    EXPECT_FALSE(FrameStamp::read(*frame));
+}
+
+TEST(FrameStampTest, ElapsedTime)
+{
+    const uint64_t stamp = FrameStamp::currentTime();
+    const std::chrono::microseconds elapsed = FrameStamp::elapsedSince(stamp);
+
+    EXPECT_GE(elapsed.count(), 0);
+    EXPECT_LT(elapsed, std::chrono::seconds(10));
+}
+
+} // namespace base
@@ -68,4 +68,33 @@ TEST(FrameTest, Performance)
     }
 }
 
+TEST(FrameTest, LargeCopy)
+{
+    // Large areas are copied by stripes in parallel.
+    const Size size(2000, 1200);
+
+    auto source = FrameSimple::create(size);
+    for (int y = 0; y < size.height(); ++y)
+    {
+        for (int x = 0; x < size.width(); ++x)
+        {
+            const uint32_t pixel = static_cast<uint32_t>(y) << 16 | static_cast<uint32_t>(x);
+            memcpy(source->frameDataAtPos(x, y), &pixel, sizeof(pixel));
+        }
+    }
+
+    auto target = createTestFrame(Rect::makeWH(size.width() + 10, size.height()), 0);
+
+    const Rect dest_rect = Rect::makeXYWH(10, 0, 1990, 1150);
+    target->copyPixelsFrom(*source, Point(0, 50), dest_rect);
+
+    const size_t row_size = static_cast<size_t>(dest_rect.width()) * Frame::kBytesPerPixel;
+
+    for (int y = 0; y < dest_rect.height(); ++y)
+    {
+        ASSERT_EQ(memcmp(target->frameDataAtPos(dest_rect.x(), y),
+                         source->frameDataAtPos(0, 50 + y), row_size), 0) << y;
+    }
+}
+
 } // namespace base
@@ -0,0 +1,41 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__FRAME_VIEW_H
+#define BASE__DESKTOP__FRAME_VIEW_H
+
+#include "base/desktop/frame.h"
+
+namespace base {
+
+// Uses the pixels of another frame with its own updated region and other information. The
+// consumers of a shared frame change the view instead of the frame. The other frame must outlive
+// the view.
+class FrameView : public Frame
+{
+public:
+    explicit FrameView(const Frame& frame);
+    ~FrameView() override;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(FrameView);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__FRAME_VIEW_H
@@ -0,0 +1,132 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/frame_xshm.h"
+
+#include "base/logging.h"
+#include "base/x11/x_error_trap.h"
+
+#include <cstring>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+namespace base {
+
+FrameXShm::FrameXShm(Display* display,
+                     const Size& size,
+                     const XShmSegmentInfo& shm_info,
+                     Pixmap pixmap)
+    : Frame(size, size.width() * kBytesPerPixel, reinterpret_cast<uint8_t*>(shm_info.shmaddr),
+            nullptr),
+      display_(display),
+      shm_info_(shm_info),
+      pixmap_(pixmap)
+{
+    // Nothing
+}
+
+FrameXShm::~FrameXShm()
+{
+    XFreePixmap(display_, pixmap_);
+    XShmDetach(display_, &shm_info_);
+    XSync(display_, False);
+
+    shmdt(shm_info_.shmaddr);
+}
+
+// static
+std::unique_ptr<FrameXShm> FrameXShm::create(
+    Display* display, Drawable drawable, int depth, const Size& size)
+{
+    int major;
+    int minor;
+    Bool have_pixmaps;
+
+    if (!XShmQueryVersion(display, &major, &minor, &have_pixmaps))
+    {
+        LOG(LS_INFO) << "MIT-SHM extension is not available";
+        return nullptr;
+    }
+
+    if (!have_pixmaps || XShmPixmapFormat(display) != ZPixmap)
+    {
+        LOG(LS_INFO) << "MIT-SHM pixmaps are not supported (version "
+                     << major << "." << minor << ")";
+        return nullptr;
+    }
+
+    XShmSegmentInfo shm_info;
+    memset(&shm_info, 0, sizeof(shm_info));
+
+    shm_info.shmid = shmget(IPC_PRIVATE, calcMemorySize(size, kBytesPerPixel), IPC_CREAT | 0600);
+    if (shm_info.shmid == -1)
+    {
+        PLOG(LS_WARNING) << "shmget failed";
+        return nullptr;
+    }
+
+    void* address = shmat(shm_info.shmid, nullptr, 0);
+
+    // The segment is destroyed after the last detach.
+    shmctl(shm_info.shmid, IPC_RMID, nullptr);
+
+    if (address == reinterpret_cast<void*>(-1))
+    {
+        PLOG(LS_WARNING) << "shmat failed";
+        return nullptr;
+    }
+
+    shm_info.shmaddr = reinterpret_cast<char*>(address);
+    shm_info.readOnly = False;
+
+    // The X server reports a failed attach asynchronously, so the result is checked after XSync.
+    XErrorTrap error_trap;
+
+    if (!XShmAttach(display, &shm_info))
+    {
+        error_trap.lastErrorAndDisable();
+        shmdt(address);
+        LOG(LS_WARNING) << "XShmAttach failed";
+        return nullptr;
+    }
+
+    XSync(display, False);
+
+    if (error_trap.lastErrorAndDisable() != Success)
+    {
+        LOG(LS_WARNING) << "XShmAttach failed (the X server may be remote)";
+        shmdt(address);
+        return nullptr;
+    }
+
+    Pixmap pixmap = XShmCreatePixmap(display, drawable, shm_info.shmaddr, &shm_info,
+                                     size.width(), size.height(), depth);
+    if (!pixmap)
+    {
+        LOG(LS_WARNING) << "XShmCreatePixmap failed";
+        XShmDetach(display, &shm_info);
+        XSync(display, False);
+        shmdt(address);
+        return nullptr;
+    }
+
+    return std::unique_ptr<FrameXShm>(new FrameXShm(display, size, shm_info, pixmap));
+}
+
+} // namespace base
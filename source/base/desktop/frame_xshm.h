@@ -0,0 +1,60 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__FRAME_XSHM_H
+#define BASE__DESKTOP__FRAME_XSHM_H
+
+#include "base/desktop/frame.h"
+
+#include <memory>
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
+
+namespace base {
+
+// Frame which is stored in a MIT-SHM segment shared with the X server. The X server copies the
+// screen directly into the frame through the pixmap() created on the segment.
+class FrameXShm : public Frame
+{
+public:
+    ~FrameXShm();
+
+    // Returns nullptr if the X server does not support shared memory pixmaps. |depth| is the depth
+    // of |drawable| which is used to create the pixmap. The pixels must be stored in 32 bits.
+    static std::unique_ptr<FrameXShm> create(
+        Display* display, Drawable drawable, int depth, const Size& size);
+
+    Pixmap pixmap() const { return pixmap_; }
+
+private:
+    FrameXShm(Display* display,
+              const Size& size,
+              const XShmSegmentInfo& shm_info,
+              Pixmap pixmap);
+
+    Display* display_;
+    XShmSegmentInfo shm_info_;
+    Pixmap pixmap_;
+
+    DISALLOW_COPY_AND_ASSIGN(FrameXShm);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__FRAME_XSHM_H
@@ -18,8 +18,17 @@
 
 #include "base/desktop/mouse_cursor.h"
 
+#include <libyuv/compare.h>
+
 namespace base {
 
+namespace {
+
+// Recommended seed value for a hash.
+constexpr uint32_t kHashingSeed = 5381;
+
+} // namespace
+
 MouseCursor::MouseCursor(ByteArray&& image, const Size& size, const Point& hotspot)
     : image_(std::move(image)),
       size_(size),
@@ -40,9 +49,11 @@ MouseCursor& MouseCursor::operator=(MouseCursor&& other) noexcept
         image_ = std::move(other.image_);
         size_ = other.size_;
         hotspot_ = other.hotspot_;
+        hash_ = other.hash_;
 
         other.size_ = Size();
         other.hotspot_ = Point();
+        other.hash_.reset();
     }
 
     return *this;
@@ -60,4 +71,21 @@ bool MouseCursor::equals(const MouseCursor& other)
            base::equals(image_, other.image_);
 }
 
+uint32_t MouseCursor::hash() const
+{
+    if (!hash_.has_value())
+    {
+        const int32_t params[] =
+            { size_.width(), size_.height(), hotspot_.x(), hotspot_.y() };
+
+        uint32_t hash = libyuv::HashDjb2(image_.data(), image_.size(), kHashingSeed);
+        hash = libyuv::HashDjb2(
+            reinterpret_cast<const uint8_t*>(params), sizeof(params), hash);
+
+        hash_ = hash;
+    }
+
+    return *hash_;
+}
+
 } // namespace base
@@ -22,6 +22,8 @@
 #include "base/desktop/geometry.h"
 #include "base/memory/byte_array.h"
 
+#include <optional>
+
 namespace base {
 
 class MouseCursor
@@ -52,10 +54,17 @@ public:
 
     bool equals(const MouseCursor& other);
 
+    // Returns the hash of the image, the size and the hotspot. The hash is calculated on the first
+    // call, the cursor must not be changed after that. The cursors received from another process
+    // can keep the hash calculated there (see setHash()).
+    uint32_t hash() const;
+    void setHash(uint32_t hash) { hash_ = hash; }
+
 private:
     ByteArray image_;
     Size size_;
     Point hotspot_;
+    mutable std::optional<uint32_t> hash_;
 };
 
 } // namespace base
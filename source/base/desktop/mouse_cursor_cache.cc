@@ -0,0 +1,60 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/mouse_cursor_cache.h"
+
+#include "base/desktop/mouse_cursor.h"
+
+#include <algorithm>
+
+namespace base {
+
+MouseCursorCache::MouseCursorCache() = default;
+MouseCursorCache::~MouseCursorCache() = default;
+
+bool MouseCursorCache::contains(uint32_t hash) const
+{
+    return std::any_of(cursors_.begin(), cursors_.end(),
+                       [hash](const auto& entry) { return entry.first == hash; });
+}
+
+std::shared_ptr<MouseCursor> MouseCursorCache::find(uint32_t hash) const
+{
+    for (const auto& entry : cursors_)
+    {
+        if (entry.first == hash)
+            return entry.second;
+    }
+
+    return nullptr;
+}
+
+void MouseCursorCache::add(uint32_t hash, std::shared_ptr<MouseCursor> cursor)
+{
+    cursors_.emplace_back(hash, std::move(cursor));
+
+    if (cursors_.size() > kCacheSize)
+        cursors_.pop_front();
+}
+
+void MouseCursorCache::clear()
+{
+    cursors_.clear();
+}
+
+} // namespace base
@@ -0,0 +1,62 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__MOUSE_CURSOR_CACHE_H
+#define BASE__DESKTOP__MOUSE_CURSOR_CACHE_H
+
+#include "base/macros_magic.h"
+
+#include <deque>
+#include <memory>
+#include <utility>
+
+namespace base {
+
+class MouseCursor;
+
+// Keeps the last cursors sent from the desktop agent to the service. Both sides add the same
+// cursors in the same order, so a cursor that is found in the cache of the agent is also in the
+// cache of the service, and only its hash is sent. The agent keeps only the hashes.
+class MouseCursorCache
+{
+public:
+    static const size_t kCacheSize = 32;
+
+    MouseCursorCache();
+    ~MouseCursorCache();
+
+    bool contains(uint32_t hash) const;
+
+    // Returns the cursor with |hash| or nullptr if it is not in the cache or was added without the
+    // cursor.
+    std::shared_ptr<MouseCursor> find(uint32_t hash) const;
+
+    // Adds the cursor with |hash|. If the cache is full, the oldest cursor is removed.
+    void add(uint32_t hash, std::shared_ptr<MouseCursor> cursor = nullptr);
+
+    void clear();
+
+private:
+    std::deque<std::pair<uint32_t, std::shared_ptr<MouseCursor>>> cursors_;
+
+    DISALLOW_COPY_AND_ASSIGN(MouseCursorCache);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__MOUSE_CURSOR_CACHE_H
@@ -0,0 +1,84 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/mouse_cursor_cache.h"
+
+#include "base/desktop/mouse_cursor.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+std::shared_ptr<MouseCursor> createCursor(uint8_t value)
+{
+    return std::make_shared<MouseCursor>(ByteArray(16 * 16 * 4, value), Size(16, 16), Point(1, 1));
+}
+
+} // namespace
+
+TEST(MouseCursorCacheTest, FindCursor)
+{
+    MouseCursorCache cache;
+
+    std::shared_ptr<MouseCursor> cursor = createCursor(1);
+    const uint32_t hash = cursor->hash();
+
+    EXPECT_FALSE(cache.contains(hash));
+    EXPECT_EQ(cache.find(hash), nullptr);
+
+    cache.add(hash, cursor);
+
+    EXPECT_TRUE(cache.contains(hash));
+    EXPECT_EQ(cache.find(hash), cursor);
+}
+
+TEST(MouseCursorCacheTest, HashOnly)
+{
+    MouseCursorCache cache;
+
+    cache.add(100);
+
+    EXPECT_TRUE(cache.contains(100));
+    EXPECT_EQ(cache.find(100), nullptr);
+}
+
+TEST(MouseCursorCacheTest, OldestRemoved)
+{
+    MouseCursorCache cache;
+
+    for (uint32_t i = 0; i <= MouseCursorCache::kCacheSize; ++i)
+        cache.add(i);
+
+    EXPECT_FALSE(cache.contains(0));
+    EXPECT_TRUE(cache.contains(1));
+    EXPECT_TRUE(cache.contains(MouseCursorCache::kCacheSize));
+}
+
+TEST(MouseCursorCacheTest, HashDependsOnHotspot)
+{
+    MouseCursor first(ByteArray(16 * 16 * 4, 1), Size(16, 16), Point(1, 1));
+    MouseCursor second(ByteArray(16 * 16 * 4, 1), Size(16, 16), Point(2, 2));
+    MouseCursor third(ByteArray(16 * 16 * 4, 1), Size(16, 16), Point(1, 1));
+
+    EXPECT_NE(first.hash(), second.hash());
+    EXPECT_EQ(first.hash(), third.hash());
+}
+
+} // namespace base
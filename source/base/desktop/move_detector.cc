@@ -0,0 +1,188 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/move_detector.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace base {
+
+namespace {
+
+// Smaller areas are cheap to encode and are not checked.
+const int kMinMoveWidth = 64;
+const int kMinMoveHeight = 32;
+
+// Minimum number of distinct rows that must point to the same offset.
+const int kMinVotes = 8;
+
+uint32_t hashRow(const uint8_t* row, int width)
+{
+    // 32-bit FNV-1a over pixels instead of bytes.
+    uint32_t hash = 2166136261U;
+
+    for (int x = 0; x < width; ++x)
+    {
+        uint32_t pixel;
+        memcpy(&pixel, row + x * Frame::kBytesPerPixel, sizeof(pixel));
+
+        hash = (hash ^ pixel) * 16777619U;
+    }
+
+    return hash;
+}
+
+void hashRows(const Frame& frame, const Rect& rect, std::vector<uint32_t>* hashes)
+{
+    hashes->resize(rect.height());
+
+    for (int y = 0; y < rect.height(); ++y)
+        (*hashes)[y] = hashRow(frame.frameDataAtPos(rect.left(), rect.top() + y), rect.width());
+}
+
+} // namespace
+
+void MoveDetector::detectMoves(const Frame& prev_frame, Frame* curr_frame)
+{
+    DCHECK(curr_frame);
+    DCHECK_EQ(prev_frame.size(), curr_frame->size());
+
+    Frame::MovedRects* moved_rects = curr_frame->movedRects();
+    moved_rects->clear();
+
+    for (Region::Iterator it(curr_frame->constUpdatedRegion()); !it.isAtEnd(); it.advance())
+    {
+        Frame::MovedRect moved_rect;
+
+        if (detectMove(prev_frame, *curr_frame, it.rect(), &moved_rect))
+            moved_rects->emplace_back(moved_rect);
+    }
+
+    // The rectangles of the updated region do not overlap and each moved rect is inside one of
+    // them together with its source, so the moves can be applied in any order.
+    for (const auto& moved_rect : *moved_rects)
+        curr_frame->updatedRegion()->subtract(moved_rect.dest_rect);
+}
+
+bool MoveDetector::detectMove(const Frame& prev_frame, const Frame& curr_frame, const Rect& rect,
+                              Frame::MovedRect* moved_rect)
+{
+    const int height = rect.height();
+
+    if (rect.width() < kMinMoveWidth || height < kMinMoveHeight)
+        return false;
+
+    hashRows(prev_frame, rect, &prev_hashes_);
+    hashRows(curr_frame, rect, &curr_hashes_);
+
+    // Rows of the previous frame by the hash. Rows that occur more than once are ambiguous and get
+    // index -1. Repeated adjacent rows (for example, a solid background) are skipped.
+    std::unordered_map<uint32_t, int> prev_rows;
+    prev_rows.reserve(height);
+
+    for (int y = 0; y < height; ++y)
+    {
+        if (y > 0 && prev_hashes_[y] == prev_hashes_[y - 1])
+            continue;
+
+        auto result = prev_rows.emplace(prev_hashes_[y], y);
+        if (!result.second)
+            result.first->second = -1;
+    }
+
+    // Each distinct row of the current frame votes for the offset from its position in the
+    // previous frame.
+    votes_.assign(height * 2, 0);
+
+    for (int y = 0; y < height; ++y)
+    {
+        if (curr_hashes_[y] == prev_hashes_[y])
+            continue;
+
+        if (y > 0 && curr_hashes_[y] == curr_hashes_[y - 1])
+            continue;
+
+        auto prev_row = prev_rows.find(curr_hashes_[y]);
+        if (prev_row == prev_rows.end() || prev_row->second == -1)
+            continue;
+
+        ++votes_[y - prev_row->second + height];
+    }
+
+    int offset = 0;
+    int max_votes = 0;
+
+    for (int i = 0; i < height * 2; ++i)
+    {
+        if (votes_[i] > max_votes)
+        {
+            max_votes = votes_[i];
+            offset = i - height;
+        }
+    }
+
+    if (max_votes < kMinVotes)
+        return false;
+
+    // Row |y| of the current frame must match row |y - offset| of the previous frame. Find the
+    // longest run of matched rows.
+    const size_t row_size = static_cast<size_t>(rect.width()) * Frame::kBytesPerPixel;
+    const int first_row = std::max(0, offset);
+    const int last_row = std::min(height, height + offset);
+
+    int best_top = 0;
+    int best_height = 0;
+    int run_top = first_row;
+
+    for (int y = first_row; y <= last_row; ++y)
+    {
+        bool matched = false;
+
+        if (y < last_row && curr_hashes_[y] == prev_hashes_[y - offset])
+        {
+            matched = memcmp(curr_frame.frameDataAtPos(rect.left(), rect.top() + y),
+                             prev_frame.frameDataAtPos(rect.left(), rect.top() + y - offset),
+                             row_size) == 0;
+        }
+
+        if (!matched)
+        {
+            if (y - run_top > best_height)
+            {
+                best_top = run_top;
+                best_height = y - run_top;
+            }
+
+            run_top = y + 1;
+        }
+    }
+
+    if (best_height < kMinMoveHeight)
+        return false;
+
+    moved_rect->dest_rect = Rect::makeXYWH(
+        rect.left(), rect.top() + best_top, rect.width(), best_height);
+    moved_rect->src_pos = Point(rect.left(), rect.top() + best_top - offset);
+    return true;
+}
+
+} // namespace base
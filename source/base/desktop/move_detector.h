@@ -0,0 +1,56 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__MOVE_DETECTOR_H
+#define BASE__DESKTOP__MOVE_DETECTOR_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/frame.h"
+
+#include <vector>
+
+namespace base {
+
+// Class to search for areas of the screen that were moved vertically (for example, when a window
+// is scrolled). The rows of the previous and the current frame are compared by their hashes, so
+// moved content is found without encoding it again.
+class MoveDetector
+{
+public:
+    MoveDetector() = default;
+    ~MoveDetector() = default;
+
+    // Searches each rectangle of the updated region of |curr_frame| for content moved from the same
+    // rectangle of |prev_frame|. The found areas replace the moved rects of |curr_frame| and are
+    // removed from its updated region.
+    void detectMoves(const Frame& prev_frame, Frame* curr_frame);
+
+private:
+    bool detectMove(const Frame& prev_frame, const Frame& curr_frame, const Rect& rect,
+                    Frame::MovedRect* moved_rect);
+
+    std::vector<uint32_t> prev_hashes_;
+    std::vector<uint32_t> curr_hashes_;
+    std::vector<int> votes_;
+
+    DISALLOW_COPY_AND_ASSIGN(MoveDetector);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__MOVE_DETECTOR_H
@@ -0,0 +1,136 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/move_detector.h"
+
+#include "base/desktop/frame_simple.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(400, 300);
+
+// Fills the frame with rows that are different from each other. |offset| shifts the content up.
+void fillFrame(Frame* frame, int offset)
+{
+    for (int y = 0; y < frame->size().height(); ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(0, y));
+
+        for (int x = 0; x < frame->size().width(); ++x)
+            row[x] = static_cast<uint32_t>((y + offset) * 7919 + x * 31);
+    }
+}
+
+} // namespace
+
+TEST(MoveDetectorTest, VerticalScroll)
+{
+    std::unique_ptr<Frame> prev_frame = FrameSimple::create(kFrameSize);
+    std::unique_ptr<Frame> curr_frame = FrameSimple::create(kFrameSize);
+
+    fillFrame(prev_frame.get(), 0);
+    fillFrame(curr_frame.get(), 20);
+
+    // The last rows of the current frame contain new content.
+    Rect new_rows = Rect::makeXYWH(0, kFrameSize.height() - 20, kFrameSize.width(), 20);
+    curr_frame->updatedRegion()->addRect(Rect::makeSize(kFrameSize));
+
+    MoveDetector detector;
+    detector.detectMoves(*prev_frame, curr_frame.get());
+
+    ASSERT_EQ(curr_frame->constMovedRects().size(), 1u);
+
+    const Frame::MovedRect& moved_rect = curr_frame->constMovedRects().front();
+    EXPECT_EQ(moved_rect.dest_rect, Rect::makeWH(kFrameSize.width(), kFrameSize.height() - 20));
+    EXPECT_EQ(moved_rect.src_pos, Point(0, 20));
+    EXPECT_TRUE(curr_frame->constUpdatedRegion().equals(Region(new_rows)));
+
+    // Applying the move to the previous frame gives the current frame.
+    prev_frame->movePixels(moved_rect.src_pos, moved_rect.dest_rect);
+
+    for (int y = 0; y < moved_rect.dest_rect.height(); ++y)
+    {
+        EXPECT_EQ(memcmp(prev_frame->frameDataAtPos(0, y), curr_frame->frameDataAtPos(0, y),
+                         kFrameSize.width() * Frame::kBytesPerPixel), 0);
+    }
+}
+
+TEST(MoveDetectorTest, VerticalScrollDown)
+{
+    std::unique_ptr<Frame> prev_frame = FrameSimple::create(kFrameSize);
+    std::unique_ptr<Frame> curr_frame = FrameSimple::create(kFrameSize);
+
+    fillFrame(prev_frame.get(), 0);
+    fillFrame(curr_frame.get(), -50);
+
+    Rect rect = Rect::makeXYWH(100, 0, 200, kFrameSize.height());
+    curr_frame->updatedRegion()->addRect(rect);
+
+    MoveDetector detector;
+    detector.detectMoves(*prev_frame, curr_frame.get());
+
+    ASSERT_EQ(curr_frame->constMovedRects().size(), 1u);
+
+    const Frame::MovedRect& moved_rect = curr_frame->constMovedRects().front();
+    EXPECT_EQ(moved_rect.dest_rect, Rect::makeXYWH(100, 50, 200, kFrameSize.height() - 50));
+    EXPECT_EQ(moved_rect.src_pos, Point(100, 0));
+    EXPECT_TRUE(curr_frame->constUpdatedRegion().equals(Region(Rect::makeXYWH(100, 0, 200, 50))));
+}
+
+TEST(MoveDetectorTest, NoMove)
+{
+    std::unique_ptr<Frame> prev_frame = FrameSimple::create(kFrameSize);
+    std::unique_ptr<Frame> curr_frame = FrameSimple::create(kFrameSize);
+
+    fillFrame(prev_frame.get(), 0);
+    memset(curr_frame->frameData(), 0x7f, curr_frame->stride() * kFrameSize.height());
+
+    Rect rect = Rect::makeSize(kFrameSize);
+    curr_frame->updatedRegion()->addRect(rect);
+    curr_frame->movedRects()->push_back({ Point(0, 0), rect });
+
+    MoveDetector detector;
+    detector.detectMoves(*prev_frame, curr_frame.get());
+
+    EXPECT_TRUE(curr_frame->constMovedRects().empty());
+    EXPECT_TRUE(curr_frame->constUpdatedRegion().equals(Region(rect)));
+}
+
+TEST(MoveDetectorTest, SmallRect)
+{
+    std::unique_ptr<Frame> prev_frame = FrameSimple::create(kFrameSize);
+    std::unique_ptr<Frame> curr_frame = FrameSimple::create(kFrameSize);
+
+    fillFrame(prev_frame.get(), 0);
+    fillFrame(curr_frame.get(), 5);
+
+    Rect rect = Rect::makeXYWH(10, 10, 32, 200);
+    curr_frame->updatedRegion()->addRect(rect);
+
+    MoveDetector detector;
+    detector.detectMoves(*prev_frame, curr_frame.get());
+
+    EXPECT_TRUE(curr_frame->constMovedRects().empty());
+    EXPECT_TRUE(curr_frame->constUpdatedRegion().equals(Region(rect)));
+}
+
+} // namespace base
@@ -0,0 +1,416 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/pipewire_stream.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame_simple.h"
+
+#include <spa/buffer/meta.h>
+#include <spa/param/video/format-utils.h>
+
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <mutex>
+
+namespace base {
+
+namespace {
+
+const int kMaxDamageRegions = 16;
+
+// Maps the DMA-BUF into the memory of the process for reading. Only linear buffers are
+// requested so the mapped memory has the usual layout.
+class ScopedDmaBufMapping
+{
+public:
+    ScopedDmaBufMapping(int fd, size_t size)
+        : fd_(fd),
+          size_(size)
+    {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED)
+        {
+            PLOG(LS_ERROR) << "mmap failed";
+            return;
+        }
+
+        data_ = reinterpret_cast<uint8_t*>(data);
+        sync(DMA_BUF_SYNC_START);
+    }
+
+    ~ScopedDmaBufMapping()
+    {
+        if (!data_)
+            return;
+
+        sync(DMA_BUF_SYNC_END);
+        munmap(data_, size_);
+    }
+
+    uint8_t* data() const { return data_; }
+
+private:
+    void sync(uint64_t flags)
+    {
+        // The GPU may still be writing the buffer, the ioctl waits until the access is allowed.
+        dma_buf_sync sync = { flags | DMA_BUF_SYNC_READ };
+        if (ioctl(fd_, DMA_BUF_IOCTL_SYNC, &sync) == -1)
+            PLOG(LS_WARNING) << "DMA_BUF_IOCTL_SYNC failed";
+    }
+
+    const int fd_;
+    const size_t size_;
+    uint8_t* data_ = nullptr;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedDmaBufMapping);
+};
+
+} // namespace
+
+PipeWireStream::PipeWireStream()
+{
+    static std::once_flag init_flag;
+    std::call_once(init_flag, []() { pw_init(nullptr, nullptr); });
+
+    memset(&stream_listener_, 0, sizeof(stream_listener_));
+    memset(&stream_events_, 0, sizeof(stream_events_));
+    memset(&video_format_, 0, sizeof(video_format_));
+
+    stream_events_.version = PW_VERSION_STREAM_EVENTS;
+    stream_events_.state_changed = &PipeWireStream::onStateChanged;
+    stream_events_.param_changed = &PipeWireStream::onParamChanged;
+    stream_events_.process = &PipeWireStream::onProcess;
+}
+
+PipeWireStream::~PipeWireStream()
+{
+    if (loop_)
+        pw_thread_loop_stop(loop_);
+
+    if (stream_)
+        pw_stream_destroy(stream_);
+
+    if (core_)
+        pw_core_disconnect(core_);
+
+    if (context_)
+        pw_context_destroy(context_);
+
+    if (loop_)
+        pw_thread_loop_destroy(loop_);
+}
+
+bool PipeWireStream::start(int fd, uint32_t node)
+{
+    DCHECK(!loop_);
+
+    loop_ = pw_thread_loop_new("aspia_pipewire", nullptr);
+    if (!loop_)
+    {
+        LOG(LS_ERROR) << "pw_thread_loop_new failed";
+        close(fd);
+        return false;
+    }
+
+    context_ = pw_context_new(pw_thread_loop_get_loop(loop_), nullptr, 0);
+    if (!context_)
+    {
+        LOG(LS_ERROR) << "pw_context_new failed";
+        close(fd);
+        return false;
+    }
+
+    if (pw_thread_loop_start(loop_) < 0)
+    {
+        LOG(LS_ERROR) << "pw_thread_loop_start failed";
+        close(fd);
+        return false;
+    }
+
+    pw_thread_loop_lock(loop_);
+
+    // The descriptor is closed by the core.
+    core_ = pw_context_connect_fd(context_, fd, nullptr, 0);
+    if (!core_)
+    {
+        LOG(LS_ERROR) << "pw_context_connect_fd failed";
+        pw_thread_loop_unlock(loop_);
+        return false;
+    }
+
+    stream_ = pw_stream_new(core_, "aspia_screen_capturer",
+                            pw_properties_new(PW_KEY_MEDIA_TYPE, "Video",
+                                              PW_KEY_MEDIA_CATEGORY, "Capture",
+                                              PW_KEY_MEDIA_ROLE, "Screen",
+                                              nullptr));
+    if (!stream_)
+    {
+        LOG(LS_ERROR) << "pw_stream_new failed";
+        pw_thread_loop_unlock(loop_);
+        return false;
+    }
+
+    pw_stream_add_listener(stream_, &stream_listener_, &stream_events_, this);
+
+    uint8_t buffer[1024];
+    spa_pod_builder builder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+
+    spa_rectangle default_size = { 1920, 1080 };
+    spa_rectangle min_size = { 1, 1 };
+    spa_rectangle max_size = { 16384, 16384 };
+    spa_fraction default_rate = { 30, 1 };
+    spa_fraction min_rate = { 0, 1 };
+    spa_fraction max_rate = { 60, 1 };
+
+    // BGRx and BGRA have the same layout in memory as the frames.
+    const spa_pod* params[1];
+    params[0] = reinterpret_cast<const spa_pod*>(spa_pod_builder_add_object(&builder,
+        SPA_TYPE_OBJECT_Format, SPA_PARAM_EnumFormat,
+        SPA_FORMAT_mediaType, SPA_POD_Id(SPA_MEDIA_TYPE_video),
+        SPA_FORMAT_mediaSubtype, SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+        SPA_FORMAT_VIDEO_format, SPA_POD_CHOICE_ENUM_Id(
+            3, SPA_VIDEO_FORMAT_BGRx, SPA_VIDEO_FORMAT_BGRx, SPA_VIDEO_FORMAT_BGRA),
+        SPA_FORMAT_VIDEO_size, SPA_POD_CHOICE_RANGE_Rectangle(
+            &default_size, &min_size, &max_size),
+        SPA_FORMAT_VIDEO_framerate, SPA_POD_CHOICE_RANGE_Fraction(
+            &default_rate, &min_rate, &max_rate)));
+
+    const int ret = pw_stream_connect(
+        stream_, PW_DIRECTION_INPUT, node,
+        static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS),
+        params, 1);
+
+    pw_thread_loop_unlock(loop_);
+
+    if (ret != 0)
+    {
+        LOG(LS_ERROR) << "pw_stream_connect failed: " << spa_strerror(ret);
+        return false;
+    }
+
+    LOG(LS_INFO) << "PipeWire stream connected (node: " << node << ")";
+    return true;
+}
+
+Size PipeWireStream::frameSize() const
+{
+    std::scoped_lock lock(frame_lock_);
+
+    if (!frame_)
+        return Size();
+
+    return frame_->size();
+}
+
+bool PipeWireStream::copyChanges(Frame* frame, bool full_refresh)
+{
+    std::scoped_lock lock(frame_lock_);
+
+    if (!frame_ || frame_->size() != frame->size())
+        return false;
+
+    Region* updated_region = frame->updatedRegion();
+
+    if (full_refresh)
+    {
+        changed_region_.clear();
+        changed_region_.addRect(Rect::makeSize(frame_->size()));
+    }
+
+    for (Region::Iterator it(changed_region_); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+        frame->copyPixelsFrom(*frame_, rect.topLeft(), rect);
+    }
+
+    updated_region->addRegion(changed_region_);
+    changed_region_.clear();
+    return true;
+}
+
+// static
+void PipeWireStream::onStateChanged(void* data, pw_stream_state /* old_state */,
+                                    pw_stream_state state, const char* error_message)
+{
+    PipeWireStream* self = reinterpret_cast<PipeWireStream*>(data);
+
+    switch (state)
+    {
+        case PW_STREAM_STATE_ERROR:
+            LOG(LS_ERROR) << "PipeWire stream error: " << error_message;
+            self->failed_ = true;
+            break;
+
+        case PW_STREAM_STATE_UNCONNECTED:
+            LOG(LS_INFO) << "PipeWire stream disconnected";
+            self->failed_ = true;
+            break;
+
+        default:
+            LOG(LS_INFO) << "PipeWire stream state: " << pw_stream_state_as_string(state);
+            break;
+    }
+}
+
+// static
+void PipeWireStream::onParamChanged(void* data, uint32_t id, const spa_pod* param)
+{
+    if (!param || id != SPA_PARAM_Format)
+        return;
+
+    PipeWireStream* self = reinterpret_cast<PipeWireStream*>(data);
+
+    spa_format_video_raw_parse(param, &self->video_format_);
+
+    LOG(LS_INFO) << "PipeWire stream format: " << self->video_format_.size.width << "x"
+                 << self->video_format_.size.height;
+
+    self->updateParams();
+}
+
+// static
+void PipeWireStream::onProcess(void* data)
+{
+    PipeWireStream* self = reinterpret_cast<PipeWireStream*>(data);
+
+    // The damage of each buffer is relative to the previous one so none of them can be skipped.
+    while (pw_buffer* buffer = pw_stream_dequeue_buffer(self->stream_))
+    {
+        self->processBuffer(buffer->buffer);
+        pw_stream_queue_buffer(self->stream_, buffer);
+    }
+}
+
+void PipeWireStream::updateParams()
+{
+    uint8_t buffer[1024];
+    spa_pod_builder builder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+
+    const int data_types =
+        (1 << SPA_DATA_MemPtr) | (1 << SPA_DATA_MemFd) | (1 << SPA_DATA_DmaBuf);
+
+    const spa_pod* params[3];
+
+    params[0] = reinterpret_cast<const spa_pod*>(spa_pod_builder_add_object(&builder,
+        SPA_TYPE_OBJECT_ParamBuffers, SPA_PARAM_Buffers,
+        SPA_PARAM_BUFFERS_dataType, SPA_POD_Int(data_types)));
+
+    params[1] = reinterpret_cast<const spa_pod*>(spa_pod_builder_add_object(&builder,
+        SPA_TYPE_OBJECT_ParamMeta, SPA_PARAM_Meta,
+        SPA_PARAM_META_type, SPA_POD_Id(SPA_META_Header),
+        SPA_PARAM_META_size, SPA_POD_Int(sizeof(spa_meta_header))));
+
+    params[2] = reinterpret_cast<const spa_pod*>(spa_pod_builder_add_object(&builder,
+        SPA_TYPE_OBJECT_ParamMeta, SPA_PARAM_Meta,
+        SPA_PARAM_META_type, SPA_POD_Id(SPA_META_VideoDamage),
+        SPA_PARAM_META_size, SPA_POD_CHOICE_RANGE_Int(
+            sizeof(spa_meta_region) * kMaxDamageRegions,
+            sizeof(spa_meta_region),
+            sizeof(spa_meta_region) * kMaxDamageRegions)));
+
+    pw_stream_update_params(stream_, params, 3);
+}
+
+void PipeWireStream::processBuffer(spa_buffer* buffer)
+{
+    spa_meta_header* header = reinterpret_cast<spa_meta_header*>(
+        spa_buffer_find_meta_data(buffer, SPA_META_Header, sizeof(spa_meta_header)));
+    if (header && (header->flags & SPA_META_HEADER_FLAG_CORRUPTED))
+        return;
+
+    spa_data& data = buffer->datas[0];
+    if (!data.chunk || data.chunk->size == 0)
+        return;
+
+    const Size size(static_cast<int>(video_format_.size.width),
+                    static_cast<int>(video_format_.size.height));
+    if (size.isEmpty())
+        return;
+
+    std::unique_ptr<ScopedDmaBufMapping> dma_buf_mapping;
+    uint8_t* src;
+
+    if (data.type == SPA_DATA_DmaBuf)
+    {
+        // The frames are encoded on the CPU, so the GPU buffer is read directly instead of
+        // importing it with EGL.
+        dma_buf_mapping = std::make_unique<ScopedDmaBufMapping>(
+            static_cast<int>(data.fd), data.maxsize + data.mapoffset);
+        src = dma_buf_mapping->data();
+        if (src)
+            src += data.mapoffset;
+    }
+    else
+    {
+        src = reinterpret_cast<uint8_t*>(data.data);
+    }
+
+    if (!src)
+        return;
+
+    src += data.chunk->offset % data.maxsize;
+
+    const int stride = data.chunk->stride ?
+        data.chunk->stride : size.width() * Frame::kBytesPerPixel;
+    const Rect frame_rect = Rect::makeSize(size);
+
+    std::scoped_lock lock(frame_lock_);
+
+    Region damage;
+
+    spa_meta* damage_meta = spa_buffer_find_meta(buffer, SPA_META_VideoDamage);
+    if (frame_ && frame_->size() == size && damage_meta)
+    {
+        spa_meta_region* region;
+        spa_meta_for_each(region, damage_meta)
+        {
+            if (!spa_meta_region_is_valid(region))
+                break;
+
+            damage.addRect(Rect::makeXYWH(region->region.position.x, region->region.position.y,
+                                          region->region.size.width, region->region.size.height));
+        }
+
+        damage.intersectWith(frame_rect);
+    }
+    else
+    {
+        if (!frame_ || frame_->size() != size)
+        {
+            frame_ = FrameSimple::create(size);
+            changed_region_.clear();
+        }
+
+        damage.addRect(frame_rect);
+    }
+
+    for (Region::Iterator it(damage); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+        frame_->copyPixelsFrom(src + rect.y() * stride + rect.x() * Frame::kBytesPerPixel,
+                               stride, rect);
+    }
+
+    changed_region_.addRegion(damage);
+}
+
+} // namespace base
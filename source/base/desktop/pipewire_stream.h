@@ -0,0 +1,92 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__PIPEWIRE_STREAM_H
+#define BASE__DESKTOP__PIPEWIRE_STREAM_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+#include "base/desktop/region.h"
+
+#include <pipewire/pipewire.h>
+#include <spa/param/video/raw.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace base {
+
+class Frame;
+class FrameSimple;
+
+// Receives the video stream of the screen cast from PipeWire. The buffers are handled on the
+// thread of the PipeWire loop: only the areas listed in the damage metadata are copied into the
+// internal frame, from which they are taken with copyChanges().
+class PipeWireStream
+{
+public:
+    PipeWireStream();
+    ~PipeWireStream();
+
+    // Connects to the PipeWire remote |fd| returned by the portal and starts receiving the node
+    // |node|. The ownership of |fd| is passed to the stream.
+    bool start(int fd, uint32_t node);
+
+    // Returns true if the stream has been stopped by the server.
+    bool hasFailed() const { return failed_; }
+
+    // Returns the size of the received frames or an empty size if no frame was received yet.
+    Size frameSize() const;
+
+    // Copies the areas changed since the previous call into |frame| and adds them to its updated
+    // region. If |full_refresh| is true the whole frame is copied. Returns false if the size of
+    // |frame| does not match frameSize().
+    bool copyChanges(Frame* frame, bool full_refresh);
+
+private:
+    static void onStateChanged(void* data, pw_stream_state old_state, pw_stream_state state,
+                               const char* error_message);
+    static void onParamChanged(void* data, uint32_t id, const spa_pod* param);
+    static void onProcess(void* data);
+
+    void updateParams();
+    void processBuffer(spa_buffer* buffer);
+
+    pw_thread_loop* loop_ = nullptr;
+    pw_context* context_ = nullptr;
+    pw_core* core_ = nullptr;
+    pw_stream* stream_ = nullptr;
+    spa_hook stream_listener_;
+    pw_stream_events stream_events_;
+
+    // Accessed only on the thread of the PipeWire loop.
+    spa_video_info_raw video_format_;
+
+    std::atomic_bool failed_ { false };
+
+    mutable std::mutex frame_lock_;
+    std::unique_ptr<FrameSimple> frame_;
+    Region changed_region_;
+
+    DISALLOW_COPY_AND_ASSIGN(PipeWireStream);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__PIPEWIRE_STREAM_H
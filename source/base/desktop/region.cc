@@ -19,6 +19,10 @@
 #include "base/desktop/region.h"
 
 #include "base/compiler_specific.h"
+#include "base/logging.h"
+
+#include <algorithm>
+#include <limits>
 
 namespace base {
 
@@ -138,6 +142,55 @@ void Region::addRects(const Rect* rects, int count)
         addRect(rects[i]);
 }
 
+void Region::setBandedRects(const Rect* rects, int count)
+{
+    if (count <= 1)
+    {
+        clear();
+        if (count == 1)
+            addRect(rects[0]);
+        return;
+    }
+
+    miRegionUninit(&x11reg_);
+
+    RegDataPtr data = reinterpret_cast<RegDataPtr>(xalloc(REGION_SZOF(count)));
+    if (!data)
+    {
+        miRegionInit(&x11reg_, NullBox, 0);
+        return;
+    }
+
+    data->size = count;
+    data->numRects = count;
+
+    BoxPtr boxes = reinterpret_cast<BoxPtr>(data + 1);
+    short left = std::numeric_limits<short>::max();
+    short right = std::numeric_limits<short>::min();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const Rect& rect = rects[i];
+        DCHECK(!rect.isEmpty());
+        DCHECK(!i || rect.top() >= rects[i - 1].top());
+
+        BoxRec& box = boxes[i];
+        box.x1 = static_cast<short>(rect.left());
+        box.x2 = static_cast<short>(rect.right());
+        box.y1 = static_cast<short>(rect.top());
+        box.y2 = static_cast<short>(rect.bottom());
+
+        left = std::min(left, box.x1);
+        right = std::max(right, box.x2);
+    }
+
+    x11reg_.data = data;
+    x11reg_.extents.x1 = left;
+    x11reg_.extents.x2 = right;
+    x11reg_.extents.y1 = boxes[0].y1;
+    x11reg_.extents.y2 = boxes[count - 1].y2;
+}
+
 void Region::addRegion(const Region& region)
 {
     miUnion(&x11reg_, &x11reg_, region_cast(&region.x11reg_));
@@ -82,6 +82,12 @@ public:
     void addRects(const Rect* rects, int count);
     void addRegion(const Region& region);
 
+    // Replaces the region with |rects| without the union operations. The rects must be in the
+    // order in which the region stores them: in bands sorted from top to bottom, where all rects
+    // have the same top and bottom and are sorted from left to right without touching each other.
+    // Adjacent bands must not have the same rects (such bands are merged into one).
+    void setBandedRects(const Rect* rects, int count);
+
     // Finds intersection of two regions and stores them in the current region.
     void intersect(const Region& region1, const Region& region2);
 
@@ -0,0 +1,145 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/block_region.h"
+#include "base/desktop/region.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace base {
+
+namespace {
+
+// Blocks of a 1920x1080 screen in which every |step|-th block of 32x32 is changed. This is the
+// shape of the regions made by the differ.
+std::vector<Rect> makeBlocks(int step)
+{
+    static const int kBlockSize = 32;
+    static const int kBlocksX = 1920 / kBlockSize;
+    static const int kBlocksY = 1080 / kBlockSize;
+
+    std::vector<Rect> rects;
+
+    for (int i = 0; i < kBlocksX * kBlocksY; i += step)
+    {
+        rects.emplace_back(Rect::makeXYWH(
+            (i % kBlocksX) * kBlockSize, (i / kBlocksX) * kBlockSize, kBlockSize, kBlockSize));
+    }
+
+    return rects;
+}
+
+void BM_RegionAddRect(benchmark::State& state)
+{
+    const std::vector<Rect> rects = makeBlocks(static_cast<int>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        Region region;
+        for (const auto& rect : rects)
+            region.addRect(rect);
+
+        benchmark::DoNotOptimize(region);
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(rects.size()));
+}
+BENCHMARK(BM_RegionAddRect)->Arg(1)->Arg(3)->Arg(17);
+
+void BM_BlockRegionAddRect(benchmark::State& state)
+{
+    const std::vector<Rect> rects = makeBlocks(static_cast<int>(state.range(0)));
+
+    BlockRegion blocks(Size(1920, 1080), 32);
+
+    for (auto _ : state)
+    {
+        blocks.clear();
+        for (const auto& rect : rects)
+            blocks.addRect(rect);
+
+        Region region;
+        blocks.toRegion(&region);
+        benchmark::DoNotOptimize(region);
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(rects.size()));
+}
+BENCHMARK(BM_BlockRegionAddRect)->Arg(1)->Arg(3)->Arg(17);
+
+void BM_RegionIntersect(benchmark::State& state)
+{
+    const std::vector<Rect> rects1 = makeBlocks(3);
+    const std::vector<Rect> rects2 = makeBlocks(5);
+
+    const Region region1(rects1.data(), static_cast<int>(rects1.size()));
+    const Region region2(rects2.data(), static_cast<int>(rects2.size()));
+
+    for (auto _ : state)
+    {
+        Region result;
+        result.intersect(region1, region2);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_RegionIntersect);
+
+void BM_BlockRegionIntersect(benchmark::State& state)
+{
+    BlockRegion blocks1(Size(1920, 1080), 32);
+    BlockRegion blocks2(Size(1920, 1080), 32);
+
+    for (const auto& rect : makeBlocks(3))
+        blocks1.addRect(rect);
+    for (const auto& rect : makeBlocks(5))
+        blocks2.addRect(rect);
+
+    for (auto _ : state)
+    {
+        BlockRegion result(blocks1);
+        result.intersectWith(blocks2);
+
+        Region region;
+        result.toRegion(&region);
+        benchmark::DoNotOptimize(region);
+    }
+}
+BENCHMARK(BM_BlockRegionIntersect);
+
+void BM_RegionSubtract(benchmark::State& state)
+{
+    const std::vector<Rect> rects1 = makeBlocks(1);
+    const std::vector<Rect> rects2 = makeBlocks(7);
+
+    const Region region1(rects1.data(), static_cast<int>(rects1.size()));
+    const Region region2(rects2.data(), static_cast<int>(rects2.size()));
+
+    for (auto _ : state)
+    {
+        Region result(region1);
+        result.subtract(region2);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_RegionSubtract);
+
+} // namespace
+
+} // namespace base
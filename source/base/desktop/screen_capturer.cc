@@ -18,18 +18,26 @@
 
 #include "base/desktop/screen_capturer.h"
 
+#include "base/desktop/frame_pool.h"
 #include "base/ipc/shared_memory_factory.h"
 
 namespace base {
 
 ScreenCapturer::ScreenCapturer(Type type)
-    : type_(type)
+    : frame_pool_(std::make_unique<FramePool>()),
+      type_(type)
 {
     // Nothing
 }
 
+ScreenCapturer::~ScreenCapturer() = default;
+
 void ScreenCapturer::setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory)
 {
+    // The buffers of the previous factory must not be given to the new frames.
+    if (shared_memory_factory != shared_memory_factory_)
+        frame_pool_->clear();
+
     shared_memory_factory_ = shared_memory_factory;
 }
 
@@ -57,6 +65,12 @@ const char* ScreenCapturer::typeToString(Type type)
         case Type::MACOSX:
             return "MACOSX";
 
+        case Type::LINUX_PIPEWIRE:
+            return "LINUX_PIPEWIRE";
+
+        case Type::WIN_WGC:
+            return "WIN_WGC";
+
         default:
             return "UNKNOWN";
     }
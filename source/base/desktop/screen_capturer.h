@@ -21,28 +21,32 @@
 
 #include "base/desktop/frame.h"
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace base {
 
+class FramePool;
 class SharedFrame;
 class SharedMemoryFactory;
 
 class ScreenCapturer
 {
 public:
-    virtual ~ScreenCapturer() = default;
+    virtual ~ScreenCapturer();
 
     enum class Type
     {
-        DEFAULT   = 0,
-        FAKE      = 1,
-        WIN_GDI   = 2,
-        WIN_DXGI  = 3,
-        LINUX_X11 = 4,
-        MACOSX    = 5
+        DEFAULT        = 0,
+        FAKE           = 1,
+        WIN_GDI        = 2,
+        WIN_DXGI       = 3,
+        LINUX_X11      = 4,
+        MACOSX         = 5,
+        LINUX_PIPEWIRE = 6,
+        WIN_WGC        = 7
     };
 
     enum class Error
@@ -71,9 +75,24 @@ public:
     virtual bool selectScreen(ScreenId screen_id) = 0;
     virtual const Frame* captureFrame(Error* error) = 0;
 
+    // Number of the frames returned by captureFrame() whose buffers are valid at the same time. A
+    // call of captureFrame() may write to the buffer of the frame returned this number of calls
+    // earlier, so at most this number of frames can be processed while the next one is captured.
+    virtual int frameBufferCount() const { return 1; }
+
+    // A capturer which returns true from canWaitForUpdate() can block in waitForUpdate() until the
+    // screen is updated or |timeout| passes. The next captureFrame() takes the update. The wait
+    // may be on another thread, but not at the same time as the other methods. Returns true if
+    // the screen is updated.
+    virtual bool canWaitForUpdate() const { return false; }
+    virtual bool waitForUpdate(const std::chrono::milliseconds& /* timeout */) { return false; }
+
     void setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory);
     SharedMemoryFactory* sharedMemoryFactory() const;
 
+    // The pool from which the implementations allocate their frames.
+    FramePool* framePool() const { return frame_pool_.get(); }
+
     static const char* typeToString(Type type);
     Type type() const;
 
@@ -89,6 +108,8 @@ protected:
     public:
         FrameQueue() = default;
 
+        static const int kQueueLength = 2;
+
         // Moves to the next frame in the queue, moving the 'current' frame to become the
         // 'previous' one.
         void moveToNextFrame();
@@ -103,7 +124,6 @@ protected:
         // Index of the current frame.
         int current_ = 0;
 
-        static const int kQueueLength = 2;
         std::unique_ptr<FrameType> frames_[kQueueLength];
 
         DISALLOW_COPY_AND_ASSIGN(FrameQueue);
@@ -111,6 +131,7 @@ protected:
 
 private:
     SharedMemoryFactory* shared_memory_factory_ = nullptr;
+    std::unique_ptr<FramePool> frame_pool_;
     const Type type_;
 };
 
@@ -147,6 +147,21 @@ bool ScreenCapturerDxgi::selectScreen(ScreenId screen_id)
     return true;
 }
 
+int ScreenCapturerDxgi::frameBufferCount() const
+{
+    return FrameQueue<DxgiFrame>::kQueueLength;
+}
+
+bool ScreenCapturerDxgi::canWaitForUpdate() const
+{
+    return controller_->canWaitForUpdate();
+}
+
+bool ScreenCapturerDxgi::waitForUpdate(const std::chrono::milliseconds& timeout)
+{
+    return controller_->waitForUpdate(static_cast<int>(current_screen_id_), timeout);
+}
+
 const Frame* ScreenCapturerDxgi::captureFrame(Error* error)
 {
     DCHECK(error);
@@ -156,7 +171,7 @@ const Frame* ScreenCapturerDxgi::captureFrame(Error* error)
     if (!queue_.currentFrame())
     {
         queue_.replaceCurrentFrame(
-            std::make_unique<DxgiFrame>(controller_, sharedMemoryFactory()));
+            std::make_unique<DxgiFrame>(controller_, sharedMemoryFactory(), framePool()));
     }
 
     DxgiDuplicatorController::Result result;
@@ -46,6 +46,9 @@ public:
     bool screenList(ScreenList* screens) override;
     bool selectScreen(ScreenId screen_id) override;
     const Frame* captureFrame(Error* error) override;
+    int frameBufferCount() const override;
+    bool canWaitForUpdate() const override;
+    bool waitForUpdate(const std::chrono::milliseconds& timeout) override;
 
 protected:
     // ScreenCapturer implementation.
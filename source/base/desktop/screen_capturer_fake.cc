@@ -0,0 +1,126 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/screen_capturer_fake.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame_pool.h"
+#include "base/desktop/frame_stamp.h"
+#include "base/desktop/screen_fixture.h"
+
+namespace base {
+
+namespace {
+
+const ScreenCapturer::ScreenId kScreenId = 0;
+
+} // namespace
+
+ScreenCapturerFake::ScreenCapturerFake(std::unique_ptr<ScreenFixture> fixture)
+    : ScreenCapturer(Type::FAKE),
+      fixture_(std::move(fixture))
+{
+    DCHECK(fixture_);
+    DCHECK_GT(fixture_->frameCount(), 0);
+}
+
+ScreenCapturerFake::~ScreenCapturerFake() = default;
+
+int ScreenCapturerFake::screenCount()
+{
+    return 1;
+}
+
+bool ScreenCapturerFake::screenList(ScreenList* screens)
+{
+    DCHECK(screens);
+
+    screens->clear();
+    screens->push_back({ kScreenId, "Fake", true });
+    return true;
+}
+
+bool ScreenCapturerFake::selectScreen(ScreenId screen_id)
+{
+    return screen_id == kScreenId || screen_id == kFullDesktopScreenId;
+}
+
+const Frame* ScreenCapturerFake::captureFrame(Error* error)
+{
+    DCHECK(error);
+
+    queue_.moveToNextFrame();
+
+    const Frame* source = fixture_->frame(index_);
+    const Rect screen_rect = Rect::makeSize(source->size());
+    Region copy_region = source->constUpdatedRegion();
+
+    if (!queue_.currentFrame())
+    {
+        std::unique_ptr<Frame> frame = sharedMemoryFactory() ?
+            framePool()->createShared(source->size(), sharedMemoryFactory()) :
+            framePool()->create(source->size());
+        if (!frame)
+        {
+            LOG(LS_ERROR) << "Unable to create frame";
+            *error = Error::TEMPORARY;
+            return nullptr;
+        }
+
+        frame->setCapturerType(static_cast<uint32_t>(type()));
+        frame->setDpi(Point(96, 96));
+
+        queue_.replaceCurrentFrame(std::move(frame));
+        copy_region.addRect(screen_rect);
+    }
+    else
+    {
+        copy_region.addRegion(previous_region_);
+    }
+
+    Frame* frame = queue_.currentFrame();
+
+    for (Region::Iterator it(copy_region); !it.isAtEnd(); it.advance())
+        frame->copyPixelsFrom(*source, it.rect().topLeft(), it.rect());
+
+    Region* updated_region = frame->updatedRegion();
+    *updated_region = source->constUpdatedRegion();
+
+    // The stamp is drawn over the content, so the area has to be restored in the next frames.
+    FrameStamp::write(FrameStamp::currentTime(), frame);
+    previous_region_ = *updated_region;
+
+    if (++index_ == fixture_->frameCount())
+        index_ = 0;
+
+    *error = Error::SUCCEEDED;
+    return frame;
+}
+
+int ScreenCapturerFake::frameBufferCount() const
+{
+    return FrameQueue<Frame>::kQueueLength;
+}
+
+void ScreenCapturerFake::reset()
+{
+    queue_.reset();
+    previous_region_.clear();
+}
+
+} // namespace base
@@ -0,0 +1,64 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__SCREEN_CAPTURER_FAKE_H
+#define BASE__DESKTOP__SCREEN_CAPTURER_FAKE_H
+
+#include "base/desktop/screen_capturer.h"
+
+namespace base {
+
+class ScreenFixture;
+
+// Replays the frames of a ScreenFixture in a loop instead of capturing the screen. It is used to
+// load hosts, relays and routers without real desktops. The time of the capture is written into
+// every frame with FrameStamp, so that the client can measure the latency up to the display.
+class ScreenCapturerFake : public ScreenCapturer
+{
+public:
+    explicit ScreenCapturerFake(std::unique_ptr<ScreenFixture> fixture);
+    ~ScreenCapturerFake() override;
+
+    // ScreenCapturer implementation.
+    int screenCount() override;
+    bool screenList(ScreenList* screens) override;
+    bool selectScreen(ScreenId screen_id) override;
+    const Frame* captureFrame(Error* error) override;
+    int frameBufferCount() const override;
+
+protected:
+    // ScreenCapturer implementation.
+    void reset() override;
+
+private:
+    std::unique_ptr<ScreenFixture> fixture_;
+    FrameQueue<Frame> queue_;
+
+    // Index of the next frame of the fixture.
+    int index_ = 0;
+
+    // Updated region of the previous frame. The buffer of the current frame contains the frame
+    // before the previous one, so both regions have to be copied to it.
+    Region previous_region_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScreenCapturerFake);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__SCREEN_CAPTURER_FAKE_H
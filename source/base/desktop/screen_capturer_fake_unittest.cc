@@ -0,0 +1,92 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/screen_capturer_fake.h"
+
+#include "base/desktop/frame.h"
+#include "base/desktop/frame_stamp.h"
+#include "base/desktop/screen_fixture.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+const Size kFrameSize(320, 240);
+const int kFrameCount = 3;
+
+bool equalOutsideStamp(const Frame& frame, const Frame& expected)
+{
+    const Rect stamp_rect = FrameStamp::rect();
+    const int row_size = frame.size().width() * Frame::kBytesPerPixel;
+    const int stamp_size = stamp_rect.right() * Frame::kBytesPerPixel;
+
+    for (int y = 0; y < frame.size().height(); ++y)
+    {
+        const int offset = (y < stamp_rect.bottom()) ? stamp_size : 0;
+
+        if (memcmp(frame.frameDataAtPos(0, y) + offset, expected.frameDataAtPos(0, y) + offset,
+                   row_size - offset) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+TEST(ScreenCapturerFakeTest, ReplayFrames)
+{
+    std::unique_ptr<ScreenFixture> fixture =
+        ScreenFixture::createSynthetic(kFrameSize, kFrameCount);
+    ASSERT_TRUE(fixture);
+    const ScreenFixture* frames = fixture.get();
+
+    ScreenCapturerFake capturer(std::move(fixture));
+    EXPECT_EQ(capturer.screenCount(), 1);
+    EXPECT_TRUE(capturer.selectScreen(ScreenCapturer::kFullDesktopScreenId));
+
+    // Two loops over the fixture, so that both buffers are reused.
+    for (int i = 0; i < kFrameCount * 2 + 1; ++i)
+    {
+        ScreenCapturer::Error error;
+        const Frame* frame = capturer.captureFrame(&error);
+        ASSERT_TRUE(frame);
+        EXPECT_EQ(error, ScreenCapturer::Error::SUCCEEDED);
+
+        const Frame* expected = frames->frame(i % kFrameCount);
+        EXPECT_EQ(frame->size(), kFrameSize);
+        EXPECT_EQ(frame->capturerType(), static_cast<uint32_t>(ScreenCapturer::Type::FAKE));
+        EXPECT_TRUE(equalOutsideStamp(*frame, *expected)) << "Frame " << i;
+
+        Region expected_region = expected->constUpdatedRegion();
+        expected_region.addRect(FrameStamp::rect());
+        EXPECT_TRUE(frame->constUpdatedRegion().equals(expected_region)) << "Frame " << i;
+
+        std::optional<uint64_t> stamp = FrameStamp::read(*frame);
+        ASSERT_TRUE(stamp);
+        EXPECT_LT(FrameStamp::elapsedSince(*stamp), std::chrono::seconds(10));
+    }
+}
+
+} // namespace base
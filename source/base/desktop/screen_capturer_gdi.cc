@@ -63,6 +63,11 @@ bool ScreenCapturerGdi::selectScreen(ScreenId screen_id)
     return true;
 }
 
+int ScreenCapturerGdi::frameBufferCount() const
+{
+    return FrameQueue<Frame>::kQueueLength;
+}
+
 const Frame* ScreenCapturerGdi::captureFrame(Error* error)
 {
     DCHECK(error);
@@ -139,12 +144,21 @@ const Frame* ScreenCapturerGdi::captureImage()
     {
         differ_ = std::make_unique<Differ>(screen_rect.size());
         current->updatedRegion()->addRect(Rect::makeSize(screen_rect.size()));
+        current->movedRects()->clear();
+        current->mutableTiming()->diff = std::chrono::microseconds::zero();
     }
     else
     {
+        const auto diff_start = std::chrono::steady_clock::now();
+
         differ_->calcDirtyRegion(previous->frameData(),
                                  current->frameData(),
                                  current->updatedRegion());
+
+        current->mutableTiming()->diff = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - diff_start);
+
+        move_detector_.detectMoves(*previous, current);
     }
 
     return current;
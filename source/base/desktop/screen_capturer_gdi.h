@@ -19,6 +19,7 @@
 #ifndef BASE__DESKTOP__SCREEN_CAPTURER_GDI_H
 #define BASE__DESKTOP__SCREEN_CAPTURER_GDI_H
 
+#include "base/desktop/move_detector.h"
 #include "base/desktop/screen_capturer.h"
 #include "base/desktop/shared_frame.h"
 #include "base/win/scoped_hdc.h"
@@ -39,6 +40,7 @@ public:
     bool screenList(ScreenList* screens) override;
     bool selectScreen(ScreenId screen_id) override;
     const Frame* captureFrame(Error* error) override;
+    int frameBufferCount() const override;
 
 protected:
     // ScreenCapturer implementation.
@@ -56,6 +58,7 @@ private:
     Rect desktop_dc_rect_;
 
     std::unique_ptr<Differ> differ_;
+    MoveDetector move_detector_;
     win::ScopedGetDC desktop_dc_;
     win::ScopedCreateDC memory_dc_;
 
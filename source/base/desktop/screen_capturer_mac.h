@@ -21,8 +21,13 @@
 
 #include "base/desktop/screen_capturer.h"
 
+#include <memory>
+
 namespace base {
 
+// Captures a display with ScreenCaptureKit (macOS 12.3 and later). The frames are delivered by the
+// window server in IOSurfaces together with the list of the changed areas, only these areas are
+// copied into the frame.
 class ScreenCapturerMac : public ScreenCapturer
 {
 public:
@@ -40,6 +45,13 @@ protected:
     void reset() override;
 
 private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+
+    ScreenId current_screen_id_ = kFullDesktopScreenId;
+    std::unique_ptr<Frame> frame_;
+    bool full_refresh_ = true;
+
     DISALLOW_COPY_AND_ASSIGN(ScreenCapturerMac);
 };
 
@@ -19,9 +19,402 @@
 #include "base/desktop/screen_capturer_mac.h"
 
 #include "base/logging.h"
+#include "base/desktop/frame_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+#include <CoreGraphics/CoreGraphics.h>
+#include <CoreMedia/CoreMedia.h>
+#include <CoreVideo/CoreVideo.h>
+#include <IOSurface/IOSurface.h>
+#include <ScreenCaptureKit/ScreenCaptureKit.h>
+
+namespace base {
+
+namespace {
+
+const uint32_t kMaxScreenCount = 16;
+const int kMaxFrameRate = 60;
+
+// One frame is kept by the capturer, the others are used by the window server.
+const int kQueueDepth = 4;
+
+const int64_t kTimeoutNs = 5 * NSEC_PER_SEC;
+
+// Receives the frames on the queue of the stream. Only the last IOSurface is kept, the changed
+// areas of all frames received since the last copyChanges() call are accumulated.
+class FrameReceiver
+{
+public:
+    FrameReceiver() = default;
+    ~FrameReceiver();
+
+    void onSampleBuffer(CMSampleBufferRef sample_buffer) API_AVAILABLE(macos(12.3));
+    void onStopped() { failed_ = true; }
+    bool hasFailed() const { return failed_; }
+
+    Size frameSize() const;
+    bool copyChanges(Frame* frame, bool full_refresh);
+
+private:
+    void releaseSurface();
+
+    std::atomic_bool failed_ { false };
+
+    mutable std::mutex lock_;
+    IOSurfaceRef surface_ = nullptr;
+    Region dirty_region_;
+
+    DISALLOW_COPY_AND_ASSIGN(FrameReceiver);
+};
+
+FrameReceiver::~FrameReceiver()
+{
+    releaseSurface();
+}
+
+void FrameReceiver::onSampleBuffer(CMSampleBufferRef sample_buffer)
+{
+    CFArrayRef attachments_array = CMSampleBufferGetSampleAttachmentsArray(sample_buffer, false);
+    if (!attachments_array || CFArrayGetCount(attachments_array) < 1)
+        return;
+
+    NSDictionary* attachments = reinterpret_cast<NSDictionary*>(
+        CFArrayGetValueAtIndex(attachments_array, 0));
+
+    // Idle frames are sent when nothing has changed, they have no new content.
+    NSNumber* status = attachments[SCStreamFrameInfoStatus];
+    if (!status || status.integerValue != SCFrameStatusComplete)
+        return;
+
+    CVPixelBufferRef pixel_buffer = CMSampleBufferGetImageBuffer(sample_buffer);
+    if (!pixel_buffer)
+        return;
+
+    IOSurfaceRef surface = CVPixelBufferGetIOSurface(pixel_buffer);
+    if (!surface)
+        return;
+
+    const Size size(static_cast<int>(IOSurfaceGetWidth(surface)),
+                    static_cast<int>(IOSurfaceGetHeight(surface)));
+    const Rect frame_rect = Rect::makeSize(size);
+
+    Region dirty_region;
+
+    NSArray* dirty_rects = attachments[SCStreamFrameInfoDirtyRects];
+    for (id dirty_rect in dirty_rects)
+    {
+        CGRect rect;
+        if (!CGRectMakeWithDictionaryRepresentation(
+                reinterpret_cast<CFDictionaryRef>(dirty_rect), &rect))
+        {
+            continue;
+        }
+
+        const int left = static_cast<int>(std::floor(CGRectGetMinX(rect)));
+        const int top = static_cast<int>(std::floor(CGRectGetMinY(rect)));
+        const int right = static_cast<int>(std::ceil(CGRectGetMaxX(rect)));
+        const int bottom = static_cast<int>(std::ceil(CGRectGetMaxY(rect)));
+
+        dirty_region.addRect(Rect::makeLTRB(left, top, right, bottom));
+    }
+
+    dirty_region.intersectWith(frame_rect);
+
+    std::scoped_lock lock(lock_);
+
+    if (!dirty_rects || !surface_ || IOSurfaceGetWidth(surface_) != IOSurfaceGetWidth(surface) ||
+        IOSurfaceGetHeight(surface_) != IOSurfaceGetHeight(surface))
+    {
+        dirty_region_.clear();
+        dirty_region.clear();
+        dirty_region.addRect(frame_rect);
+    }
+
+    // The surface is kept after the sample buffer is released. The use count prevents the window
+    // server from reusing it for the next frames.
+    releaseSurface();
+    surface_ = surface;
+    CFRetain(surface_);
+    IOSurfaceIncrementUseCount(surface_);
+
+    dirty_region_.addRegion(dirty_region);
+}
+
+Size FrameReceiver::frameSize() const
+{
+    std::scoped_lock lock(lock_);
+
+    if (!surface_)
+        return Size();
+
+    return Size(static_cast<int>(IOSurfaceGetWidth(surface_)),
+                static_cast<int>(IOSurfaceGetHeight(surface_)));
+}
+
+bool FrameReceiver::copyChanges(Frame* frame, bool full_refresh)
+{
+    std::scoped_lock lock(lock_);
+
+    if (!surface_)
+        return false;
+
+    const Size size(static_cast<int>(IOSurfaceGetWidth(surface_)),
+                    static_cast<int>(IOSurfaceGetHeight(surface_)));
+    if (frame->size() != size)
+        return false;
+
+    if (full_refresh)
+    {
+        dirty_region_.clear();
+        dirty_region_.addRect(Rect::makeSize(size));
+    }
+
+    if (IOSurfaceLock(surface_, kIOSurfaceLockReadOnly, nullptr) != kIOReturnSuccess)
+    {
+        LOG(LS_ERROR) << "IOSurfaceLock failed";
+        return false;
+    }
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(IOSurfaceGetBaseAddress(surface_));
+    const int src_stride = static_cast<int>(IOSurfaceGetBytesPerRow(surface_));
+
+    for (Region::Iterator it(dirty_region_); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+        frame->copyPixelsFrom(src + rect.y() * src_stride + rect.x() * Frame::kBytesPerPixel,
+                              src_stride, rect);
+    }
+
+    IOSurfaceUnlock(surface_, kIOSurfaceLockReadOnly, nullptr);
+
+    frame->updatedRegion()->addRegion(dirty_region_);
+    dirty_region_.clear();
+    return true;
+}
+
+void FrameReceiver::releaseSurface()
+{
+    if (!surface_)
+        return;
+
+    IOSurfaceDecrementUseCount(surface_);
+    CFRelease(surface_);
+    surface_ = nullptr;
+}
+
+CGDirectDisplayID displayId(ScreenCapturer::ScreenId screen_id)
+{
+    if (screen_id == ScreenCapturer::kFullDesktopScreenId)
+        return CGMainDisplayID();
+
+    return static_cast<CGDirectDisplayID>(screen_id);
+}
+
+} // namespace
+
+} // namespace base
+
+API_AVAILABLE(macos(12.3))
+@interface AspiaStreamOutput : NSObject <SCStreamOutput, SCStreamDelegate>
+{
+    std::shared_ptr<base::FrameReceiver> receiver_;
+}
+
+- (instancetype)initWithReceiver:(std::shared_ptr<base::FrameReceiver>)receiver;
+
+@end
+
+@implementation AspiaStreamOutput
+
+- (instancetype)initWithReceiver:(std::shared_ptr<base::FrameReceiver>)receiver
+{
+    self = [super init];
+    if (self)
+        receiver_ = std::move(receiver);
+
+    return self;
+}
+
+- (void)stream:(SCStream*)stream
+    didOutputSampleBuffer:(CMSampleBufferRef)sample_buffer
+                   ofType:(SCStreamOutputType)type
+{
+    if (type == SCStreamOutputTypeScreen)
+        receiver_->onSampleBuffer(sample_buffer);
+}
+
+- (void)stream:(SCStream*)stream didStopWithError:(NSError*)error
+{
+    LOG(LS_ERROR) << "Screen capture stream stopped: " << error.localizedDescription.UTF8String;
+    receiver_->onStopped();
+}
+
+@end
 
 namespace base {
 
+class ScreenCapturerMac::Impl
+{
+public:
+    Impl() = default;
+    ~Impl();
+
+    bool start(CGDirectDisplayID display_id) API_AVAILABLE(macos(12.3));
+    FrameReceiver* receiver() const { return receiver_.get(); }
+
+private:
+    std::shared_ptr<FrameReceiver> receiver_;
+    id stream_ = nil;
+    id output_ = nil;
+    dispatch_queue_t queue_ = nullptr;
+
+    DISALLOW_COPY_AND_ASSIGN(Impl);
+};
+
+ScreenCapturerMac::Impl::~Impl()
+{
+    if (@available(macOS 12.3, *))
+    {
+        if (stream_)
+        {
+            SCStream* stream = reinterpret_cast<SCStream*>(stream_);
+            dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+
+            [stream stopCaptureWithCompletionHandler:^(NSError* /* error */) {
+                dispatch_semaphore_signal(semaphore);
+            }];
+
+            dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, kTimeoutNs));
+            dispatch_release(semaphore);
+
+            [stream removeStreamOutput:output_ type:SCStreamOutputTypeScreen error:nil];
+            [stream release];
+        }
+    }
+
+    if (queue_)
+    {
+        // Waits for the callbacks which are already queued.
+        dispatch_sync(queue_, ^{});
+        dispatch_release(queue_);
+    }
+
+    [output_ release];
+}
+
+bool ScreenCapturerMac::Impl::start(CGDirectDisplayID display_id)
+{
+    DCHECK(!stream_);
+
+    __block SCShareableContent* content = nil;
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+
+    [SCShareableContent getShareableContentWithCompletionHandler:
+        ^(SCShareableContent* result, NSError* error) {
+            if (result)
+                content = [result retain];
+            else
+                LOG(LS_ERROR) << "Unable to get shareable content: "
+                              << error.localizedDescription.UTF8String;
+
+            dispatch_semaphore_signal(semaphore);
+        }];
+
+    // The request fails if the Screen Recording permission is not granted.
+    const long wait_result =
+        dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, kTimeoutNs));
+    dispatch_release(semaphore);
+
+    if (wait_result != 0 || !content)
+    {
+        LOG(LS_ERROR) << "No shareable content";
+        return false;
+    }
+
+    SCDisplay* display = nil;
+    for (SCDisplay* current in content.displays)
+    {
+        if (current.displayID == display_id)
+        {
+            display = current;
+            break;
+        }
+    }
+
+    if (!display)
+    {
+        LOG(LS_ERROR) << "Display " << display_id << " not found";
+        [content release];
+        return false;
+    }
+
+    // The frames are received in the native resolution of the display (in pixels, not points).
+    size_t width = display.width;
+    size_t height = display.height;
+
+    CGDisplayModeRef mode = CGDisplayCopyDisplayMode(display_id);
+    if (mode)
+    {
+        width = CGDisplayModeGetPixelWidth(mode);
+        height = CGDisplayModeGetPixelHeight(mode);
+        CGDisplayModeRelease(mode);
+    }
+
+    SCContentFilter* filter =
+        [[SCContentFilter alloc] initWithDisplay:display excludingWindows:@[]];
+
+    SCStreamConfiguration* config = [[SCStreamConfiguration alloc] init];
+    config.width = width;
+    config.height = height;
+    config.pixelFormat = kCVPixelFormatType_32BGRA;
+    config.minimumFrameInterval = CMTimeMake(1, kMaxFrameRate);
+    config.queueDepth = kQueueDepth;
+    config.showsCursor = YES;
+
+    receiver_ = std::make_shared<FrameReceiver>();
+    AspiaStreamOutput* output = [[AspiaStreamOutput alloc] initWithReceiver:receiver_];
+    output_ = output;
+
+    SCStream* stream =
+        [[SCStream alloc] initWithFilter:filter configuration:config delegate:output];
+    stream_ = stream;
+
+    [filter release];
+    [config release];
+    [content release];
+
+    queue_ = dispatch_queue_create("aspia.screen_capturer", DISPATCH_QUEUE_SERIAL);
+
+    NSError* error = nil;
+    if (![stream addStreamOutput:output
+                            type:SCStreamOutputTypeScreen
+              sampleHandlerQueue:queue_
+                           error:&error])
+    {
+        LOG(LS_ERROR) << "addStreamOutput failed: " << error.localizedDescription.UTF8String;
+        return false;
+    }
+
+    std::shared_ptr<FrameReceiver> receiver = receiver_;
+
+    [stream startCaptureWithCompletionHandler:^(NSError* start_error) {
+        if (start_error)
+        {
+            LOG(LS_ERROR) << "Unable to start capture: "
+                          << start_error.localizedDescription.UTF8String;
+            receiver->onStopped();
+        }
+    }];
+
+    LOG(LS_INFO) << "Capture of display " << display_id << " started (" << width << "x"
+                 << height << ")";
+    return true;
+}
+
 ScreenCapturerMac::ScreenCapturerMac()
     : ScreenCapturer(ScreenCapturer::Type::MACOSX)
 {
@@ -32,33 +425,141 @@ ScreenCapturerMac::~ScreenCapturerMac() = default;
 
 int ScreenCapturerMac::screenCount()
 {
-    NOTIMPLEMENTED();
-    return 0;
+    uint32_t count = 0;
+    if (CGGetActiveDisplayList(0, nullptr, &count) != kCGErrorSuccess)
+        return 0;
+
+    return static_cast<int>(count);
 }
 
-bool ScreenCapturerMac::screenList(ScreenList* /* screens */)
+bool ScreenCapturerMac::screenList(ScreenList* screens)
 {
-    NOTIMPLEMENTED();
-    return false;
+    CGDirectDisplayID displays[kMaxScreenCount];
+    uint32_t count = 0;
+
+    if (CGGetActiveDisplayList(kMaxScreenCount, displays, &count) != kCGErrorSuccess)
+    {
+        LOG(LS_ERROR) << "CGGetActiveDisplayList failed";
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        screens->push_back({ static_cast<ScreenId>(displays[i]), std::string(),
+                             CGDisplayIsMain(displays[i]) != 0 });
+    }
+
+    return true;
 }
 
-bool ScreenCapturerMac::selectScreen(ScreenId /* screen_id */)
+bool ScreenCapturerMac::selectScreen(ScreenId screen_id)
 {
-    NOTIMPLEMENTED();
-    return false;
+    if (screen_id != kFullDesktopScreenId)
+    {
+        ScreenList screens;
+        if (!screenList(&screens))
+            return false;
+
+        auto it = std::find_if(screens.begin(), screens.end(), [screen_id](const Screen& screen)
+        {
+            return screen.id == screen_id;
+        });
+        if (it == screens.end())
+            return false;
+    }
+
+    if (screen_id != current_screen_id_)
+    {
+        // The stream captures one display. It is created again for the new one.
+        impl_.reset();
+        current_screen_id_ = screen_id;
+    }
+
+    return true;
 }
 
 const Frame* ScreenCapturerMac::captureFrame(Error* error)
 {
     DCHECK(error);
-    NOTIMPLEMENTED();
-    *error = Error::PERMANENT;
-    return nullptr;
+
+    if (@available(macOS 12.3, *))
+    {
+        if (!impl_)
+        {
+            std::unique_ptr<Impl> impl = std::make_unique<Impl>();
+            if (!impl->start(displayId(current_screen_id_)))
+            {
+                *error = Error::PERMANENT;
+                return nullptr;
+            }
+
+            impl_ = std::move(impl);
+            full_refresh_ = true;
+        }
+    }
+    else
+    {
+        LOG(LS_ERROR) << "ScreenCaptureKit requires macOS 12.3 or later";
+        *error = Error::PERMANENT;
+        return nullptr;
+    }
+
+    FrameReceiver* receiver = impl_->receiver();
+
+    if (receiver->hasFailed())
+    {
+        impl_.reset();
+        *error = Error::PERMANENT;
+        return nullptr;
+    }
+
+    const Size size = receiver->frameSize();
+    if (size.isEmpty())
+    {
+        // No frame has been received yet.
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    if (!frame_ || frame_->size() != size)
+    {
+        frame_.reset();
+        frame_ = framePool()->create(size);
+        if (!frame_)
+        {
+            *error = Error::TEMPORARY;
+            return nullptr;
+        }
+
+        full_refresh_ = true;
+    }
+
+    frame_->updatedRegion()->clear();
+
+    if (!receiver->copyChanges(frame_.get(), full_refresh_))
+    {
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    full_refresh_ = false;
+    frame_->setTopLeft(Point(0, 0));
+
+    const CGDirectDisplayID display_id = displayId(current_screen_id_);
+    const CGSize size_mm = CGDisplayScreenSize(display_id);
+    if (size_mm.width > 0 && size_mm.height > 0)
+    {
+        frame_->setDpi(Point(static_cast<int>(size.width() * 25.4 / size_mm.width),
+                             static_cast<int>(size.height() * 25.4 / size_mm.height)));
+    }
+
+    *error = Error::SUCCEEDED;
+    return frame_.get();
 }
 
 void ScreenCapturerMac::reset()
 {
-    NOTIMPLEMENTED();
+    full_refresh_ = true;
 }
 
 } // namespace base
@@ -0,0 +1,164 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/screen_capturer_pipewire.h"
+
+#include "base/logging.h"
+#include "base/desktop/frame_pool.h"
+#include "base/desktop/pipewire_stream.h"
+#include "base/desktop/screen_cast_portal.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace base {
+
+ScreenCapturerPipeWire::ScreenCapturerPipeWire()
+    : ScreenCapturer(ScreenCapturer::Type::LINUX_PIPEWIRE)
+{
+    // Nothing
+}
+
+ScreenCapturerPipeWire::~ScreenCapturerPipeWire()
+{
+    // The stream is stopped before the portal session is closed.
+    stream_.reset();
+    portal_.reset();
+}
+
+// static
+bool ScreenCapturerPipeWire::isWaylandSession()
+{
+    const char* session_type = getenv("XDG_SESSION_TYPE");
+    if (session_type && strcmp(session_type, "wayland") == 0)
+        return true;
+
+    return getenv("WAYLAND_DISPLAY") != nullptr;
+}
+
+int ScreenCapturerPipeWire::screenCount()
+{
+    // The monitor is selected by the user in the dialog of the portal.
+    return 1;
+}
+
+bool ScreenCapturerPipeWire::screenList(ScreenList* screens)
+{
+    screens->push_back({ kFullDesktopScreenId, std::string(), true });
+    return true;
+}
+
+bool ScreenCapturerPipeWire::selectScreen(ScreenId screen_id)
+{
+    return screen_id == kFullDesktopScreenId;
+}
+
+const Frame* ScreenCapturerPipeWire::captureFrame(Error* error)
+{
+    DCHECK(error);
+
+    if (!stream_)
+    {
+        *error = startStream();
+        if (*error != Error::SUCCEEDED)
+            return nullptr;
+    }
+
+    if (stream_->hasFailed())
+    {
+        *error = Error::PERMANENT;
+        return nullptr;
+    }
+
+    const Size size = stream_->frameSize();
+    if (size.isEmpty())
+    {
+        // No frame has been received yet.
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    if (!frame_ || frame_->size() != size)
+    {
+        frame_.reset();
+        frame_ = framePool()->create(size);
+        if (!frame_)
+        {
+            *error = Error::TEMPORARY;
+            return nullptr;
+        }
+
+        full_refresh_ = true;
+    }
+
+    frame_->updatedRegion()->clear();
+
+    if (!stream_->copyChanges(frame_.get(), full_refresh_))
+    {
+        // The size of the stream has changed after frameSize() was called.
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    full_refresh_ = false;
+    frame_->setTopLeft(Point(0, 0));
+
+    *error = Error::SUCCEEDED;
+    return frame_.get();
+}
+
+void ScreenCapturerPipeWire::reset()
+{
+    full_refresh_ = true;
+}
+
+ScreenCapturer::Error ScreenCapturerPipeWire::startStream()
+{
+    if (!portal_)
+    {
+        portal_ = std::make_unique<ScreenCastPortal>();
+        portal_->start();
+    }
+
+    portal_->dispatch();
+
+    switch (portal_->state())
+    {
+        case ScreenCastPortal::State::STARTED:
+            break;
+
+        case ScreenCastPortal::State::FAILED:
+            return Error::PERMANENT;
+
+        default:
+            // Waiting for the user to select the monitor.
+            return Error::TEMPORARY;
+    }
+
+    std::unique_ptr<PipeWireStream> stream = std::make_unique<PipeWireStream>();
+    if (!stream->start(portal_->takePipeWireFd(), portal_->pipeWireNode()))
+    {
+        LOG(LS_ERROR) << "Unable to start the PipeWire stream";
+        return Error::PERMANENT;
+    }
+
+    stream_ = std::move(stream);
+    return Error::SUCCEEDED;
+}
+
+} // namespace base
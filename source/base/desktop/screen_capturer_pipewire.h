@@ -0,0 +1,66 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__SCREEN_CAPTURER_PIPEWIRE_H
+#define BASE__DESKTOP__SCREEN_CAPTURER_PIPEWIRE_H
+
+#include "base/desktop/screen_capturer.h"
+
+#include <memory>
+
+namespace base {
+
+class PipeWireStream;
+class ScreenCastPortal;
+
+// Captures the screen of a Wayland session. The compositor does not allow clients to read the
+// screen, the monitor is shared through the ScreenCast portal (the user confirms it in a dialog)
+// and the frames are received as a PipeWire stream.
+class ScreenCapturerPipeWire : public ScreenCapturer
+{
+public:
+    ScreenCapturerPipeWire();
+    ~ScreenCapturerPipeWire();
+
+    // Returns true if the current session is a Wayland session.
+    static bool isWaylandSession();
+
+    // ScreenCapturer implementation.
+    int screenCount() override;
+    bool screenList(ScreenList* screens) override;
+    bool selectScreen(ScreenId screen_id) override;
+    const Frame* captureFrame(Error* error) override;
+
+protected:
+    // ScreenCapturer implementation.
+    void reset() override;
+
+private:
+    Error startStream();
+
+    std::unique_ptr<ScreenCastPortal> portal_;
+    std::unique_ptr<PipeWireStream> stream_;
+    std::unique_ptr<Frame> frame_;
+    bool full_refresh_ = true;
+
+    DISALLOW_COPY_AND_ASSIGN(ScreenCapturerPipeWire);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__SCREEN_CAPTURER_PIPEWIRE_H
@@ -0,0 +1,609 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/screen_capturer_wgc.h"
+
+#include "base/logging.h"
+#include "base/system_error.h"
+#include "base/desktop/differ.h"
+#include "base/desktop/frame.h"
+#include "base/desktop/frame_pool.h"
+#include "base/desktop/win/screen_capture_utils.h"
+#include "base/strings/unicode.h"
+
+#include <algorithm>
+
+#include <dwmapi.h>
+#include <roapi.h>
+#include <windows.graphics.capture.interop.h>
+#include <windows.graphics.directx.direct3d11.interop.h>
+#include <wrl/wrappers/corewrappers.h>
+
+using Microsoft::WRL::ComPtr;
+using Microsoft::WRL::Wrappers::HStringReference;
+
+namespace WGC = ABI::Windows::Graphics::Capture;
+namespace WGD = ABI::Windows::Graphics::DirectX;
+
+namespace base {
+
+namespace {
+
+// The frame pool keeps two textures: one is copied into the frame while the system renders
+// into the other.
+const int kPoolBufferCount = 2;
+
+ComPtr<WGC::IDirect3D11CaptureFramePoolStatics2> framePoolStatics()
+{
+    ComPtr<WGC::IDirect3D11CaptureFramePoolStatics2> statics;
+
+    HRESULT hr = RoGetActivationFactory(
+        HStringReference(RuntimeClass_Windows_Graphics_Capture_Direct3D11CaptureFramePool).Get(),
+        IID_PPV_ARGS(&statics));
+    if (FAILED(hr))
+        return nullptr;
+
+    return statics;
+}
+
+bool isCapturableWindow(HWND window)
+{
+    if (!IsWindowVisible(window) || IsIconic(window))
+        return false;
+
+    // Only the top-level application windows are listed.
+    if (GetWindow(window, GW_OWNER) != nullptr)
+        return false;
+
+    if (GetWindowLongW(window, GWL_EXSTYLE) & WS_EX_TOOLWINDOW)
+        return false;
+
+    if (GetWindowTextLengthW(window) <= 0)
+        return false;
+
+    // Windows of the suspended UWP applications and of the other virtual desktops are cloaked.
+    DWORD cloaked = 0;
+    if (SUCCEEDED(DwmGetWindowAttribute(window, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) &&
+        cloaked)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+BOOL CALLBACK enumWindowsProc(HWND window, LPARAM lparam)
+{
+    ScreenCapturer::ScreenList* screens = reinterpret_cast<ScreenCapturer::ScreenList*>(lparam);
+
+    if (!isCapturableWindow(window))
+        return TRUE;
+
+    wchar_t title[256];
+    if (GetWindowTextW(window, title, std::size(title)) <= 0)
+        return TRUE;
+
+    screens->push_back(
+        { reinterpret_cast<ScreenCapturer::ScreenId>(window), utf8FromWide(title), false });
+    return TRUE;
+}
+
+} // namespace
+
+ScreenCapturerWgc::ScreenCapturerWgc()
+    : ScreenCapturer(Type::WIN_WGC)
+{
+    // The thread may already be initialized for COM in another apartment, WinRT works in either.
+    HRESULT hr = RoInitialize(RO_INIT_MULTITHREADED);
+    ro_initialized_ = SUCCEEDED(hr);
+}
+
+ScreenCapturerWgc::~ScreenCapturerWgc()
+{
+    stopSession();
+
+    if (ro_initialized_)
+        RoUninitialize();
+}
+
+// static
+bool ScreenCapturerWgc::isSupported()
+{
+    // Free-threaded frame pools and the capture of windows by their handle are available since
+    // Windows 10 version 1903.
+    if (!framePoolStatics())
+        return false;
+
+    ComPtr<WGC::IGraphicsCaptureSessionStatics> session_statics;
+
+    HRESULT hr = RoGetActivationFactory(
+        HStringReference(RuntimeClass_Windows_Graphics_Capture_GraphicsCaptureSession).Get(),
+        IID_PPV_ARGS(&session_statics));
+    if (FAILED(hr))
+        return false;
+
+    boolean is_supported = false;
+    hr = session_statics->IsSupported(&is_supported);
+    return SUCCEEDED(hr) && is_supported;
+}
+
+int ScreenCapturerWgc::screenCount()
+{
+    return ScreenCaptureUtils::screenCount();
+}
+
+bool ScreenCapturerWgc::screenList(ScreenList* screens)
+{
+    if (!ScreenCaptureUtils::screenList(screens))
+        return false;
+
+    EnumWindows(enumWindowsProc, reinterpret_cast<LPARAM>(screens));
+    return true;
+}
+
+bool ScreenCapturerWgc::selectScreen(ScreenId screen_id)
+{
+    HWND window = nullptr;
+    std::wstring device_key;
+
+    if (screen_id != kFullDesktopScreenId &&
+        !ScreenCaptureUtils::isScreenValid(screen_id, &device_key))
+    {
+        // Window handles never match the indexes of the monitors.
+        window = reinterpret_cast<HWND>(screen_id);
+        if (!IsWindow(window) || !isCapturableWindow(window))
+            return false;
+    }
+
+    // At next screen capture, the capture session is recreated for the new source.
+    stopSession();
+
+    current_screen_id_ = screen_id;
+    current_device_key_ = std::move(device_key);
+    current_window_ = window;
+    return true;
+}
+
+int ScreenCapturerWgc::frameBufferCount() const
+{
+    return FrameQueue<Frame>::kQueueLength;
+}
+
+const Frame* ScreenCapturerWgc::captureFrame(Error* error)
+{
+    DCHECK(error);
+
+    if (current_window_ && !IsWindow(current_window_))
+    {
+        LOG(LS_WARNING) << "Captured window is closed";
+        *error = Error::PERMANENT;
+        return nullptr;
+    }
+
+    if (!session_ && !startSession())
+    {
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    // Only the latest frame is needed, the older ones are returned to the pool.
+    ComPtr<WGC::IDirect3D11CaptureFrame> capture_frame;
+    for (;;)
+    {
+        ComPtr<WGC::IDirect3D11CaptureFrame> next_frame;
+
+        HRESULT hr = capture_pool_->TryGetNextFrame(&next_frame);
+        if (FAILED(hr))
+        {
+            LOG(LS_WARNING) << "TryGetNextFrame failed: " << SystemError(hr).toString();
+            stopSession();
+            *error = Error::TEMPORARY;
+            return nullptr;
+        }
+
+        if (!next_frame)
+            break;
+
+        capture_frame = std::move(next_frame);
+    }
+
+    if (!capture_frame)
+    {
+        Frame* previous = queue_.currentFrame();
+        if (!previous)
+        {
+            // The first frame has not arrived yet.
+            *error = Error::TEMPORARY;
+            return nullptr;
+        }
+
+        // The screen is not updated. The frame is repeated in the next buffer of the queue
+        // because the previous one may still be in use.
+        queue_.moveToNextFrame();
+
+        Frame* current = queue_.currentFrame();
+        if (!current || current->size() != previous->size())
+        {
+            std::unique_ptr<Frame> frame = sharedMemoryFactory() ?
+                framePool()->createShared(previous->size(), sharedMemoryFactory()) :
+                framePool()->create(previous->size());
+            if (!frame)
+            {
+                *error = Error::PERMANENT;
+                return nullptr;
+            }
+
+            frame->setCapturerType(static_cast<uint32_t>(type()));
+            queue_.replaceCurrentFrame(std::move(frame));
+            current = queue_.currentFrame();
+        }
+
+        current->copyPixelsFrom(*previous, Point(0, 0), Rect::makeSize(previous->size()));
+        current->setTopLeft(previous->topLeft());
+        current->setDpi(previous->dpi());
+        current->updatedRegion()->clear();
+        current->movedRects()->clear();
+        current->mutableTiming()->diff = std::chrono::microseconds::zero();
+
+        *error = Error::SUCCEEDED;
+        return current;
+    }
+
+    ABI::Windows::Graphics::SizeInt32 content_size;
+    HRESULT hr = capture_frame->get_ContentSize(&content_size);
+    if (FAILED(hr))
+    {
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    if (content_size.Width != pool_size_.width() || content_size.Height != pool_size_.height())
+    {
+        // The window is resized or the resolution of the monitor is changed. The textures of the
+        // pool are recreated, the current frame is still in the old size.
+        hr = capture_pool_->Recreate(direct3d_device_.Get(),
+                                     WGD::DirectXPixelFormat_B8G8R8A8UIntNormalized,
+                                     kPoolBufferCount,
+                                     content_size);
+        if (FAILED(hr))
+        {
+            LOG(LS_WARNING) << "Recreate failed: " << SystemError(hr).toString();
+            stopSession();
+            *error = Error::TEMPORARY;
+            return nullptr;
+        }
+
+        pool_size_ = Size(content_size.Width, content_size.Height);
+    }
+
+    ComPtr<WGD::Direct3D11::IDirect3DSurface> surface;
+    hr = capture_frame->get_Surface(&surface);
+    if (FAILED(hr))
+    {
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    ComPtr<Windows::Graphics::DirectX::Direct3D11::IDirect3DDxgiInterfaceAccess> access;
+    hr = surface.As(&access);
+    if (FAILED(hr))
+    {
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    ComPtr<ID3D11Texture2D> texture;
+    hr = access->GetInterface(IID_PPV_ARGS(&texture));
+    if (FAILED(hr))
+    {
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+
+    // The texture may be larger than the content during the resize.
+    Size size(std::min(content_size.Width, static_cast<int32_t>(desc.Width)),
+              std::min(content_size.Height, static_cast<int32_t>(desc.Height)));
+    if (size.isEmpty())
+    {
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    return copyTexture(texture.Get(), size, error);
+}
+
+void ScreenCapturerWgc::reset()
+{
+    // The session is bound to the desktop of the thread.
+    stopSession();
+    queue_.reset();
+}
+
+bool ScreenCapturerWgc::createDevice()
+{
+    if (direct3d_device_)
+        return true;
+
+    HRESULT hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+                                   D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0,
+                                   D3D11_SDK_VERSION, &d3d_device_, nullptr, &d3d_context_);
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "D3D11CreateDevice failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    ComPtr<IDXGIDevice> dxgi_device;
+    hr = d3d_device_.As(&dxgi_device);
+    if (FAILED(hr))
+        return false;
+
+    ComPtr<IInspectable> inspectable;
+    hr = CreateDirect3D11DeviceFromDXGIDevice(dxgi_device.Get(), &inspectable);
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "CreateDirect3D11DeviceFromDXGIDevice failed: "
+                        << SystemError(hr).toString();
+        return false;
+    }
+
+    hr = inspectable.As(&direct3d_device_);
+    return SUCCEEDED(hr);
+}
+
+bool ScreenCapturerWgc::startSession()
+{
+    DCHECK(!session_);
+
+    if (!createDevice())
+        return false;
+
+    ComPtr<IGraphicsCaptureItemInterop> interop;
+
+    HRESULT hr = RoGetActivationFactory(
+        HStringReference(RuntimeClass_Windows_Graphics_Capture_GraphicsCaptureItem).Get(),
+        IID_PPV_ARGS(&interop));
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "RoGetActivationFactory failed: " << SystemError(hr).toString();
+        return false;
+    }
+
+    if (current_window_)
+    {
+        hr = interop->CreateForWindow(current_window_, IID_PPV_ARGS(&item_));
+    }
+    else
+    {
+        Rect rect = sourceRect();
+        RECT monitor_rect = { rect.left(), rect.top(), rect.right(), rect.bottom() };
+
+        HMONITOR monitor = MonitorFromRect(&monitor_rect, MONITOR_DEFAULTTOPRIMARY);
+        hr = interop->CreateForMonitor(monitor, IID_PPV_ARGS(&item_));
+    }
+
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "Failed to create capture item: " << SystemError(hr).toString();
+        return false;
+    }
+
+    ABI::Windows::Graphics::SizeInt32 item_size;
+    hr = item_->get_Size(&item_size);
+    if (FAILED(hr))
+        return false;
+
+    ComPtr<WGC::IDirect3D11CaptureFramePoolStatics2> statics = framePoolStatics();
+    if (!statics)
+        return false;
+
+    // The free-threaded pool does not need a dispatcher queue on the capture thread, the frames
+    // are polled in captureFrame().
+    hr = statics->CreateFreeThreaded(direct3d_device_.Get(),
+                                     WGD::DirectXPixelFormat_B8G8R8A8UIntNormalized,
+                                     kPoolBufferCount,
+                                     item_size,
+                                     &capture_pool_);
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "CreateFreeThreaded failed: " << SystemError(hr).toString();
+        stopSession();
+        return false;
+    }
+
+    pool_size_ = Size(item_size.Width, item_size.Height);
+
+    hr = capture_pool_->CreateCaptureSession(item_.Get(), &session_);
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "CreateCaptureSession failed: " << SystemError(hr).toString();
+        stopSession();
+        return false;
+    }
+
+    // The cursor is captured by CursorCapturerWin. The property is missing before Windows 10
+    // version 2004.
+    ComPtr<WGC::IGraphicsCaptureSession2> session2;
+    if (SUCCEEDED(session_.As(&session2)))
+        session2->put_IsCursorCaptureEnabled(false);
+
+    hr = session_->StartCapture();
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "StartCapture failed: " << SystemError(hr).toString();
+        stopSession();
+        return false;
+    }
+
+    LOG(LS_INFO) << "WGC session started (source: " << current_screen_id_
+                 << ", size: " << pool_size_ << ")";
+    return true;
+}
+
+void ScreenCapturerWgc::stopSession()
+{
+    ComPtr<ABI::Windows::Foundation::IClosable> closable;
+
+    if (session_ && SUCCEEDED(session_.As(&closable)))
+        closable->Close();
+    session_.Reset();
+
+    if (capture_pool_ && SUCCEEDED(capture_pool_.As(&closable)))
+        closable->Close();
+    capture_pool_.Reset();
+
+    item_.Reset();
+    pool_size_ = Size();
+}
+
+const Frame* ScreenCapturerWgc::copyTexture(
+    ID3D11Texture2D* texture, const Size& size, Error* error)
+{
+    if (!staging_texture_ || staging_size_ != size)
+    {
+        D3D11_TEXTURE2D_DESC desc;
+        texture->GetDesc(&desc);
+
+        desc.Width = size.width();
+        desc.Height = size.height();
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.SampleDesc.Count = 1;
+        desc.SampleDesc.Quality = 0;
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        desc.MiscFlags = 0;
+
+        staging_texture_.Reset();
+
+        HRESULT hr = d3d_device_->CreateTexture2D(&desc, nullptr, &staging_texture_);
+        if (FAILED(hr))
+        {
+            LOG(LS_WARNING) << "CreateTexture2D failed: " << SystemError(hr).toString();
+            staging_size_ = Size();
+            *error = Error::TEMPORARY;
+            return nullptr;
+        }
+
+        staging_size_ = size;
+    }
+
+    D3D11_BOX box = { 0, 0, 0, static_cast<UINT>(size.width()),
+                      static_cast<UINT>(size.height()), 1 };
+    d3d_context_->CopySubresourceRegion(staging_texture_.Get(), 0, 0, 0, 0, texture, 0, &box);
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    HRESULT hr = d3d_context_->Map(staging_texture_.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr))
+    {
+        LOG(LS_WARNING) << "Map failed: " << SystemError(hr).toString();
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    queue_.moveToNextFrame();
+
+    if (!queue_.currentFrame() || queue_.currentFrame()->size() != size)
+    {
+        std::unique_ptr<Frame> frame = sharedMemoryFactory() ?
+            framePool()->createShared(size, sharedMemoryFactory()) : framePool()->create(size);
+        if (!frame)
+        {
+            LOG(LS_WARNING) << "Failed to create frame buffer";
+            d3d_context_->Unmap(staging_texture_.Get(), 0);
+            *error = Error::PERMANENT;
+            return nullptr;
+        }
+
+        frame->setCapturerType(static_cast<uint32_t>(type()));
+        queue_.replaceCurrentFrame(std::move(frame));
+    }
+
+    Frame* current = queue_.currentFrame();
+    Frame* previous = queue_.previousFrame();
+
+    current->copyPixelsFrom(reinterpret_cast<const uint8_t*>(mapped.pData),
+                            static_cast<int>(mapped.RowPitch),
+                            Rect::makeSize(size));
+    d3d_context_->Unmap(staging_texture_.Get(), 0);
+
+    current->setTopLeft(sourceRect().topLeft().subtract(
+        ScreenCaptureUtils::fullScreenRect().topLeft()));
+
+    if (!previous || previous->size() != current->size())
+    {
+        differ_ = std::make_unique<Differ>(size);
+        current->updatedRegion()->setRect(Rect::makeSize(size));
+        current->movedRects()->clear();
+        current->mutableTiming()->diff = std::chrono::microseconds::zero();
+    }
+    else
+    {
+        const auto diff_start = std::chrono::steady_clock::now();
+
+        differ_->calcDirtyRegion(previous->frameData(),
+                                 current->frameData(),
+                                 current->updatedRegion());
+
+        current->mutableTiming()->diff = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - diff_start);
+        current->movedRects()->clear();
+    }
+
+    *error = Error::SUCCEEDED;
+    return current;
+}
+
+Rect ScreenCapturerWgc::sourceRect() const
+{
+    if (current_window_)
+    {
+        // The frame of the window without the invisible resize borders.
+        RECT rect;
+        if (FAILED(DwmGetWindowAttribute(current_window_, DWMWA_EXTENDED_FRAME_BOUNDS,
+                                         &rect, sizeof(rect))))
+        {
+            if (!GetWindowRect(current_window_, &rect))
+                return Rect();
+        }
+
+        return Rect::makeLTRB(rect.left, rect.top, rect.right, rect.bottom);
+    }
+
+    if (current_screen_id_ == kFullDesktopScreenId)
+    {
+        // A capture item is a single monitor, the primary one is captured for the full desktop.
+        HMONITOR monitor = MonitorFromPoint(POINT{ 0, 0 }, MONITOR_DEFAULTTOPRIMARY);
+
+        MONITORINFO info;
+        info.cbSize = sizeof(info);
+        if (!GetMonitorInfoW(monitor, &info))
+            return Rect();
+
+        return Rect::makeLTRB(info.rcMonitor.left, info.rcMonitor.top,
+                              info.rcMonitor.right, info.rcMonitor.bottom);
+    }
+
+    return ScreenCaptureUtils::screenRect(current_screen_id_, current_device_key_);
+}
+
+} // namespace base
@@ -0,0 +1,95 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__SCREEN_CAPTURER_WGC_H
+#define BASE__DESKTOP__SCREEN_CAPTURER_WGC_H
+
+#include "base/desktop/screen_capturer.h"
+
+#include <D3D11.h>
+#include <windows.graphics.capture.h>
+#include <windows.graphics.directx.direct3d11.h>
+#include <wrl/client.h>
+
+namespace base {
+
+class Differ;
+
+// Captures a monitor or a single top-level window with Windows.Graphics.Capture (Windows 10
+// version 1903 and later). The windows are listed after the monitors in screenList() and their
+// ids are the window handles. The captured textures are read back into the frames in memory, so
+// capturing a window costs only the size of the window.
+class ScreenCapturerWgc : public ScreenCapturer
+{
+public:
+    ScreenCapturerWgc();
+    ~ScreenCapturerWgc();
+
+    static bool isSupported();
+
+    // ScreenCapturer implementation.
+    int screenCount() override;
+    bool screenList(ScreenList* screens) override;
+    bool selectScreen(ScreenId screen_id) override;
+    const Frame* captureFrame(Error* error) override;
+    int frameBufferCount() const override;
+
+protected:
+    // ScreenCapturer implementation.
+    void reset() override;
+
+private:
+    using CaptureFramePool = ABI::Windows::Graphics::Capture::IDirect3D11CaptureFramePool;
+    using CaptureItem = ABI::Windows::Graphics::Capture::IGraphicsCaptureItem;
+    using CaptureSession = ABI::Windows::Graphics::Capture::IGraphicsCaptureSession;
+    using Direct3DDevice = ABI::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice;
+
+    bool createDevice();
+    bool startSession();
+    void stopSession();
+    const Frame* copyTexture(ID3D11Texture2D* texture, const Size& size, Error* error);
+    Rect sourceRect() const;
+
+    bool ro_initialized_ = false;
+
+    ScreenId current_screen_id_ = kFullDesktopScreenId;
+    std::wstring current_device_key_;
+    // Not null if a window is selected.
+    HWND current_window_ = nullptr;
+
+    Microsoft::WRL::ComPtr<ID3D11Device> d3d_device_;
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> d3d_context_;
+    Microsoft::WRL::ComPtr<Direct3DDevice> direct3d_device_;
+
+    Microsoft::WRL::ComPtr<CaptureItem> item_;
+    Microsoft::WRL::ComPtr<CaptureFramePool> capture_pool_;
+    Microsoft::WRL::ComPtr<CaptureSession> session_;
+    Size pool_size_;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> staging_texture_;
+    Size staging_size_;
+
+    std::unique_ptr<Differ> differ_;
+    FrameQueue<Frame> queue_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScreenCapturerWgc);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__SCREEN_CAPTURER_WGC_H
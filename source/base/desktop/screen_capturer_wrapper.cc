@@ -23,17 +23,25 @@
 #include "base/desktop/desktop_environment.h"
 #include "base/desktop/mouse_cursor.h"
 #include "base/desktop/power_save_blocker.h"
+#include "base/desktop/screen_capturer_fake.h"
+#include "base/desktop/screen_fixture.h"
 #include "base/ipc/shared_memory_factory.h"
+#include "base/trace_event.h"
 
 #if defined(OS_WIN)
 #include "base/desktop/cursor_capturer_win.h"
 #include "base/desktop/screen_capturer_dxgi.h"
 #include "base/desktop/screen_capturer_gdi.h"
+#include "base/desktop/screen_capturer_wgc.h"
 #include "base/win/windows_version.h"
 #elif defined(OS_LINUX)
-// TODO
+#include "base/desktop/cursor_capturer_x11.h"
+#include "base/desktop/screen_capturer_x11.h"
+#if defined(USE_PIPEWIRE)
+#include "base/desktop/screen_capturer_pipewire.h"
+#endif // defined(USE_PIPEWIRE)
 #elif defined(OS_MAC)
-// TODO
+#include "base/desktop/screen_capturer_mac.h"
 #else
 #error Platform support not implemented
 #endif
@@ -41,9 +49,11 @@
 namespace base {
 
 ScreenCapturerWrapper::ScreenCapturerWrapper(ScreenCapturer::Type preferred_type,
-                                             Delegate* delegate)
+                                             Delegate* delegate,
+                                             const std::filesystem::path& fake_screen_file)
     : preferred_type_(preferred_type),
       delegate_(delegate),
+      fake_screen_file_(fake_screen_file),
       power_save_blocker_(std::make_unique<PowerSaveBlocker>()),
       environment_(std::make_unique<DesktopEnvironment>())
 {
@@ -88,6 +98,8 @@ void ScreenCapturerWrapper::selectScreen(ScreenCapturer::ScreenId screen_id)
 
 void ScreenCapturerWrapper::captureFrame()
 {
+    TRACE_EVENT("desktop", "ScreenCapturerWrapper::captureFrame");
+
     DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
 
     if (!screen_capturer_)
@@ -126,7 +138,63 @@ void ScreenCapturerWrapper::captureFrame()
         }
     }
 
-    delegate_->onScreenCaptured(frame, cursor_capturer_->captureCursor());
+    delegate_->onScreenCaptured(
+        frame, cursor_capturer_ ? cursor_capturer_->captureCursor() : nullptr);
+}
+
+void ScreenCapturerWrapper::suspend()
+{
+    DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+    LOG(LS_INFO) << "Screen capturer suspended";
+
+    environment_.reset();
+    power_save_blocker_.reset();
+}
+
+void ScreenCapturerWrapper::resume()
+{
+    DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+    if (!isSuspended())
+        return;
+
+    LOG(LS_INFO) << "Screen capturer resumed";
+
+    power_save_blocker_ = std::make_unique<PowerSaveBlocker>();
+    environment_ = std::make_unique<DesktopEnvironment>();
+
+#if defined(OS_WIN)
+    SetThreadExecutionState(ES_DISPLAY_REQUIRED);
+#endif // defined(OS_WIN)
+
+    // The previous frames are dropped, so the next frame is captured in full.
+    if (screen_capturer_)
+        screen_capturer_->reset();
+
+    if (cursor_capturer_)
+        cursor_capturer_->reset();
+
+    // The default screen is selected again and the list of screens is sent.
+    screen_count_ = 0;
+}
+
+int ScreenCapturerWrapper::frameBufferCount() const
+{
+    return screen_capturer_ ? screen_capturer_->frameBufferCount() : 1;
+}
+
+bool ScreenCapturerWrapper::canWaitForUpdate() const
+{
+    return screen_capturer_ && !isSuspended() && screen_capturer_->canWaitForUpdate();
+}
+
+bool ScreenCapturerWrapper::waitForUpdate(const std::chrono::milliseconds& timeout)
+{
+    TRACE_EVENT("desktop", "ScreenCapturerWrapper::waitForUpdate");
+
+    // There is no thread check, the call is on the thread which waits.
+    return screen_capturer_ ? screen_capturer_->waitForUpdate(timeout) : false;
 }
 
 void ScreenCapturerWrapper::setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory)
@@ -136,17 +204,20 @@ void ScreenCapturerWrapper::setSharedMemoryFactory(SharedMemoryFactory* shared_m
 
 void ScreenCapturerWrapper::enableWallpaper(bool enable)
 {
-    environment_->setWallpaper(enable);
+    if (environment_)
+        environment_->setWallpaper(enable);
 }
 
 void ScreenCapturerWrapper::enableEffects(bool enable)
 {
-    environment_->setEffects(enable);
+    if (environment_)
+        environment_->setEffects(enable);
 }
 
 void ScreenCapturerWrapper::enableFontSmoothing(bool enable)
 {
-    environment_->setFontSmoothing(enable);
+    if (environment_)
+        environment_->setFontSmoothing(enable);
 }
 
 ScreenCapturer::ScreenId ScreenCapturerWrapper::defaultScreen()
@@ -172,6 +243,16 @@ void ScreenCapturerWrapper::selectCapturer()
 {
     DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
 
+    if (preferred_type_ == ScreenCapturer::Type::FAKE)
+    {
+        LOG(LS_INFO) << "Using fake capturer (file: " << fake_screen_file_ << ")";
+
+        cursor_capturer_.reset();
+        screen_capturer_ =
+            std::make_unique<ScreenCapturerFake>(ScreenFixture::create(fake_screen_file_));
+        return;
+    }
+
 #if defined(OS_WIN)
     cursor_capturer_ = std::make_unique<CursorCapturerWin>();
 
@@ -191,6 +272,20 @@ void ScreenCapturerWrapper::selectCapturer()
         }
     }
 
+    if (!screen_capturer_ &&
+        (preferred_type_ == ScreenCapturer::Type::WIN_WGC ||
+         preferred_type_ == ScreenCapturer::Type::WIN_DXGI ||
+         preferred_type_ == ScreenCapturer::Type::DEFAULT))
+    {
+        // Windows.Graphics.Capture works where the duplication of the outputs fails and it can
+        // capture a single window.
+        if (ScreenCapturerWgc::isSupported())
+        {
+            LOG(LS_INFO) << "Using WGC capturer";
+            screen_capturer_ = std::make_unique<ScreenCapturerWgc>();
+        }
+    }
+
     if (!screen_capturer_)
     {
         LOG(LS_INFO) << "Using GDI capturer";
@@ -198,9 +293,29 @@ void ScreenCapturerWrapper::selectCapturer()
     }
 
 #elif defined(OS_LINUX)
-    NOTIMPLEMENTED();
+#if defined(USE_PIPEWIRE)
+    if (ScreenCapturerPipeWire::isWaylandSession() &&
+        preferred_type_ != ScreenCapturer::Type::LINUX_X11)
+    {
+        // The cursor is drawn into the frames by the compositor. The X11 cursor capturer sees
+        // only the cursor of the XWayland clients.
+        LOG(LS_INFO) << "Using PipeWire capturer";
+        cursor_capturer_.reset();
+        screen_capturer_ = std::make_unique<ScreenCapturerPipeWire>();
+        return;
+    }
+#endif // defined(USE_PIPEWIRE)
+
+    LOG(LS_INFO) << "Using X11 capturer";
+
+    cursor_capturer_ = std::make_unique<CursorCapturerX11>();
+    screen_capturer_ = std::make_unique<ScreenCapturerX11>();
 #elif defined(OS_MAC)
-    NOTIMPLEMENTED();
+    // The cursor is drawn into the frames by ScreenCaptureKit.
+    LOG(LS_INFO) << "Using ScreenCaptureKit capturer";
+
+    cursor_capturer_.reset();
+    screen_capturer_ = std::make_unique<ScreenCapturerMac>();
 #else
     NOTIMPLEMENTED();
 #endif
@@ -28,6 +28,8 @@
 #elif defined(OS_LINUX)
 #endif
 
+#include <filesystem>
+
 namespace base {
 
 class CursorCapturer;
@@ -48,11 +50,31 @@ public:
         virtual void onScreenCaptured(const Frame* frame, const MouseCursor* mouse_cursor) = 0;
     };
 
-    ScreenCapturerWrapper(ScreenCapturer::Type preferred_type, Delegate* delegate);
+    // If |preferred_type| is ScreenCapturer::Type::FAKE, the frames of |fake_screen_file| are
+    // replayed instead of the screen (see ScreenCapturerFake and ScreenFixture::create()).
+    ScreenCapturerWrapper(ScreenCapturer::Type preferred_type,
+                          Delegate* delegate,
+                          const std::filesystem::path& fake_screen_file = std::filesystem::path());
     ~ScreenCapturerWrapper();
 
     void selectScreen(ScreenCapturer::ScreenId screen_id);
     void captureFrame();
+
+    // While nobody is connected, the capturer can be kept initialized and suspended. The power
+    // save blocker is released and the desktop environment (wallpaper, effects and font
+    // smoothing) is restored. After resume() the list of screens is sent again and the full frame
+    // is captured, as with a new wrapper.
+    void suspend();
+    void resume();
+    bool isSuspended() const { return !environment_; }
+
+    // See ScreenCapturer::frameBufferCount().
+    int frameBufferCount() const;
+
+    // See ScreenCapturer::waitForUpdate(). The wait may be on another thread while the thread of
+    // the wrapper does not use the capturer.
+    bool canWaitForUpdate() const;
+    bool waitForUpdate(const std::chrono::milliseconds& timeout);
     void setSharedMemoryFactory(SharedMemoryFactory* shared_memory_factory);
     void enableWallpaper(bool enable);
     void enableEffects(bool enable);
@@ -65,6 +87,7 @@ private:
 
     ScreenCapturer::Type preferred_type_;
     Delegate* delegate_;
+    std::filesystem::path fake_screen_file_;
 
 #if defined(OS_WIN)
     ScopedThreadDesktop desktop_;
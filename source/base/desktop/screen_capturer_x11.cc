@@ -19,46 +19,341 @@
 #include "base/desktop/screen_capturer_x11.h"
 
 #include "base/logging.h"
+#include "base/desktop/frame_pool.h"
+#include "base/desktop/frame_xshm.h"
+
+#include <X11/Xutil.h>
 
 namespace base {
 
+namespace {
+
+// The frames are stored in 32 bits per pixel with 8 bits per color component (BGRA in memory).
+bool isSupportedFormat(Display* display, int depth)
+{
+    Visual* visual = DefaultVisual(display, DefaultScreen(display));
+
+    if (visual->c_class != TrueColor || visual->red_mask != 0xFF0000 ||
+        visual->green_mask != 0xFF00 || visual->blue_mask != 0xFF)
+    {
+        return false;
+    }
+
+    int count = 0;
+    XPixmapFormatValues* formats = XListPixmapFormats(display, &count);
+    if (!formats)
+        return false;
+
+    bool result = false;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (formats[i].depth == depth)
+        {
+            result = formats[i].bits_per_pixel == Frame::kBitsPerPixel;
+            break;
+        }
+    }
+
+    XFree(formats);
+    return result;
+}
+
+} // namespace
+
 ScreenCapturerX11::ScreenCapturerX11()
     : ScreenCapturer(ScreenCapturer::Type::LINUX_X11)
 {
     // Nothing
 }
 
-ScreenCapturerX11::~ScreenCapturerX11() = default;
+ScreenCapturerX11::~ScreenCapturerX11()
+{
+    deinitialize();
+}
 
 int ScreenCapturerX11::screenCount()
 {
-    NOTIMPLEMENTED();
-    return 0;
+    // Monitors of the X screen are not enumerated yet, the whole screen is captured.
+    return 1;
 }
 
-bool ScreenCapturerX11::screenList(ScreenList* /* screens */)
+bool ScreenCapturerX11::screenList(ScreenList* screens)
 {
-    NOTIMPLEMENTED();
-    return false;
+    screens->push_back({ kFullDesktopScreenId, std::string(), true });
+    return true;
 }
 
-bool ScreenCapturerX11::selectScreen(ScreenId /* screen_id */)
+bool ScreenCapturerX11::selectScreen(ScreenId screen_id)
 {
-    NOTIMPLEMENTED();
-    return false;
+    return screen_id == kFullDesktopScreenId;
 }
 
 const Frame* ScreenCapturerX11::captureFrame(Error* error)
 {
     DCHECK(error);
-    NOTIMPLEMENTED();
-    *error = Error::PERMANENT;
-    return nullptr;
+
+    if (!display_ && !initialize())
+    {
+        *error = Error::PERMANENT;
+        return nullptr;
+    }
+
+    processXEvents();
+
+    if (!frame_ && !createFrame())
+    {
+        *error = Error::TEMPORARY;
+        return nullptr;
+    }
+
+    const Rect screen_rect = Rect::makeSize(screen_size_);
+    Region* updated_region = frame_->updatedRegion();
+
+    updated_region->clear();
+
+    if (damage_handle_ && !full_refresh_)
+    {
+        // Take the damaged region and reset it. Changes which are made after this point are
+        // copied now and are reported again with the next frame.
+        XDamageSubtract(display_, damage_handle_, None, damage_region_);
+
+        int rects_count = 0;
+        XRectangle* rects = XFixesFetchRegion(display_, damage_region_, &rects_count);
+
+        for (int i = 0; i < rects_count; ++i)
+        {
+            updated_region->addRect(
+                Rect::makeXYWH(rects[i].x, rects[i].y, rects[i].width, rects[i].height));
+        }
+
+        if (rects)
+            XFree(rects);
+
+        updated_region->intersectWith(screen_rect);
+    }
+    else
+    {
+        if (damage_handle_)
+            XDamageSubtract(display_, damage_handle_, None, None);
+
+        updated_region->addRect(screen_rect);
+        full_refresh_ = false;
+    }
+
+    captureRegion(*updated_region);
+
+    frame_->setTopLeft(Point(0, 0));
+
+    const int screen = DefaultScreen(display_);
+    const int width_mm = DisplayWidthMM(display_, screen);
+    const int height_mm = DisplayHeightMM(display_, screen);
+
+    if (width_mm > 0 && height_mm > 0)
+    {
+        frame_->setDpi(Point(static_cast<int>(screen_size_.width() * 25.4 / width_mm),
+                             static_cast<int>(screen_size_.height() * 25.4 / height_mm)));
+    }
+
+    *error = Error::SUCCEEDED;
+    return frame_.get();
 }
 
 void ScreenCapturerX11::reset()
 {
-    NOTIMPLEMENTED();
+    full_refresh_ = true;
+}
+
+bool ScreenCapturerX11::initialize()
+{
+    display_ = XOpenDisplay(nullptr);
+    if (!display_)
+    {
+        LOG(LS_ERROR) << "XOpenDisplay failed";
+        return false;
+    }
+
+    const int screen = DefaultScreen(display_);
+
+    root_window_ = RootWindow(display_, screen);
+    depth_ = DefaultDepth(display_, screen);
+    screen_size_ = Size(DisplayWidth(display_, screen), DisplayHeight(display_, screen));
+
+    if (!isSupportedFormat(display_, depth_))
+    {
+        LOG(LS_ERROR) << "Unsupported pixel format of the X server (depth: " << depth_ << ")";
+        deinitialize();
+        return false;
+    }
+
+    gc_ = XCreateGC(display_, root_window_, 0, nullptr);
+    if (!gc_)
+    {
+        LOG(LS_ERROR) << "XCreateGC failed";
+        deinitialize();
+        return false;
+    }
+
+    // The windows which are drawn over the root window must be copied too.
+    XSetSubwindowMode(display_, gc_, IncludeInferiors);
+
+    // Screen size changes are reported with ConfigureNotify.
+    XSelectInput(display_, root_window_, StructureNotifyMask);
+
+    initDamage();
+
+    LOG(LS_INFO) << "X11 capturer initialized (screen: " << screen_size_
+                 << ", damage: " << (damage_handle_ != 0) << ")";
+    return true;
+}
+
+void ScreenCapturerX11::deinitialize()
+{
+    frame_.reset();
+
+    if (!display_)
+        return;
+
+    if (damage_region_)
+    {
+        XFixesDestroyRegion(display_, damage_region_);
+        damage_region_ = 0;
+    }
+
+    if (damage_handle_)
+    {
+        XDamageDestroy(display_, damage_handle_);
+        damage_handle_ = 0;
+    }
+
+    if (gc_)
+    {
+        XFreeGC(display_, gc_);
+        gc_ = nullptr;
+    }
+
+    XCloseDisplay(display_);
+    display_ = nullptr;
+}
+
+void ScreenCapturerX11::initDamage()
+{
+    int error_base;
+
+    if (!XDamageQueryExtension(display_, &damage_event_base_, &error_base))
+    {
+        LOG(LS_INFO) << "X server does not support XDamage";
+        return;
+    }
+
+    int xfixes_event_base;
+
+    // XFixes is used to fetch the damaged region.
+    if (!XFixesQueryExtension(display_, &xfixes_event_base, &error_base))
+    {
+        LOG(LS_INFO) << "X server does not support XFixes";
+        return;
+    }
+
+    // Only one DamageNotify is sent until the damage is subtracted.
+    damage_handle_ = XDamageCreate(display_, root_window_, XDamageReportNonEmpty);
+    if (!damage_handle_)
+    {
+        LOG(LS_WARNING) << "XDamageCreate failed";
+        return;
+    }
+
+    damage_region_ = XFixesCreateRegion(display_, nullptr, 0);
+    if (!damage_region_)
+    {
+        XDamageDestroy(display_, damage_handle_);
+        damage_handle_ = 0;
+        LOG(LS_WARNING) << "XFixesCreateRegion failed";
+    }
+}
+
+bool ScreenCapturerX11::createFrame()
+{
+    std::unique_ptr<FrameXShm> shm_frame =
+        FrameXShm::create(display_, root_window_, depth_, screen_size_);
+    if (shm_frame)
+    {
+        frame_ = std::move(shm_frame);
+        is_shm_frame_ = true;
+    }
+    else
+    {
+        frame_ = framePool()->create(screen_size_);
+        is_shm_frame_ = false;
+
+        if (!frame_)
+            return false;
+    }
+
+    frame_->setCapturerType(static_cast<uint32_t>(type()));
+    full_refresh_ = true;
+    return true;
+}
+
+void ScreenCapturerX11::processXEvents()
+{
+    // The events are processed only to keep the queue empty and to detect the screen size
+    // changes. The damaged region is fetched directly.
+    while (XPending(display_))
+    {
+        XEvent event;
+        XNextEvent(display_, &event);
+
+        if (event.type == ConfigureNotify && event.xconfigure.window == root_window_)
+        {
+            const Size screen_size(event.xconfigure.width, event.xconfigure.height);
+            if (screen_size != screen_size_)
+            {
+                LOG(LS_INFO) << "Screen size changed: " << screen_size;
+
+                screen_size_ = screen_size;
+                frame_.reset();
+            }
+        }
+    }
+}
+
+void ScreenCapturerX11::captureRegion(const Region& region)
+{
+    if (is_shm_frame_)
+    {
+        Pixmap pixmap = static_cast<FrameXShm*>(frame_.get())->pixmap();
+
+        for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+        {
+            const Rect& rect = it.rect();
+
+            XCopyArea(display_, root_window_, pixmap, gc_,
+                      rect.x(), rect.y(), rect.width(), rect.height(), rect.x(), rect.y());
+        }
+
+        // Wait until the X server has written the pixels.
+        XSync(display_, False);
+        return;
+    }
+
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+    {
+        const Rect& rect = it.rect();
+
+        XImage* image = XGetImage(display_, root_window_, rect.x(), rect.y(),
+                                  rect.width(), rect.height(), AllPlanes, ZPixmap);
+        if (!image)
+        {
+            LOG(LS_WARNING) << "XGetImage failed";
+            continue;
+        }
+
+        frame_->copyPixelsFrom(
+            reinterpret_cast<const uint8_t*>(image->data), image->bytes_per_line, rect);
+
+        XDestroyImage(image);
+    }
 }
 
 } // namespace base
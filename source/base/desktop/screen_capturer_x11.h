@@ -21,8 +21,14 @@
 
 #include "base/desktop/screen_capturer.h"
 
+#include <X11/Xlib.h>
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+
 namespace base {
 
+// Captures the X11 screen. The pixels are copied by the X server into a shared memory pixmap (if
+// MIT-SHM is available) and only the areas reported by XDamage are copied.
 class ScreenCapturerX11 : public ScreenCapturer
 {
 public:
@@ -40,6 +46,30 @@ protected:
     void reset() override;
 
 private:
+    bool initialize();
+    void deinitialize();
+    void initDamage();
+    bool createFrame();
+    void processXEvents();
+    void captureRegion(const Region& region);
+
+    Display* display_ = nullptr;
+    Window root_window_ = 0;
+    GC gc_ = nullptr;
+    int depth_ = 0;
+    Size screen_size_;
+
+    // XDamage is used to get the changed areas of the screen. Without it the full screen is
+    // captured each time.
+    Damage damage_handle_ = 0;
+    XserverRegion damage_region_ = 0;
+    int damage_event_base_ = -1;
+
+    // The frame is either FrameXShm or FrameSimple filled with XGetImage().
+    std::unique_ptr<Frame> frame_;
+    bool is_shm_frame_ = false;
+    bool full_refresh_ = true;
+
     DISALLOW_COPY_AND_ASSIGN(ScreenCapturerX11);
 };
 
@@ -0,0 +1,452 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/screen_cast_portal.h"
+
+#include "base/logging.h"
+
+#include <gio/gunixfdlist.h>
+
+#include <unistd.h>
+
+namespace base {
+
+namespace {
+
+const char kDesktopBusName[] = "org.freedesktop.portal.Desktop";
+const char kDesktopObjectPath[] = "/org/freedesktop/portal/desktop";
+const char kDesktopRequestObjectPath[] = "/org/freedesktop/portal/desktop/request/";
+const char kRequestInterfaceName[] = "org.freedesktop.portal.Request";
+const char kSessionInterfaceName[] = "org.freedesktop.portal.Session";
+const char kScreenCastInterfaceName[] = "org.freedesktop.portal.ScreenCast";
+
+// Values of the ScreenCast portal (see the xdg-desktop-portal documentation).
+const uint32_t kSourceTypeMonitor = 1;
+const uint32_t kCursorModeEmbedded = 2;
+
+class ScopedGError
+{
+public:
+    ScopedGError() = default;
+    ~ScopedGError()
+    {
+        if (error_)
+            g_error_free(error_);
+    }
+
+    GError** receive() { return &error_; }
+    GError* get() const { return error_; }
+    GError* operator->() const { return error_; }
+    explicit operator bool() const { return error_ != nullptr; }
+
+    bool isCancelled() const
+    {
+        return error_ && g_error_matches(error_, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    }
+
+private:
+    GError* error_ = nullptr;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedGError);
+};
+
+// Makes |context| the thread-default main context while in scope. The asynchronous calls and
+// signal subscriptions are dispatched to the thread-default context at the time they are made.
+class ScopedThreadDefaultContext
+{
+public:
+    explicit ScopedThreadDefaultContext(GMainContext* context)
+        : context_(context)
+    {
+        g_main_context_push_thread_default(context_);
+    }
+
+    ~ScopedThreadDefaultContext()
+    {
+        g_main_context_pop_thread_default(context_);
+    }
+
+private:
+    GMainContext* context_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedThreadDefaultContext);
+};
+
+} // namespace
+
+ScreenCastPortal::ScreenCastPortal()
+    : context_(g_main_context_new()),
+      cancellable_(g_cancellable_new())
+{
+    // Nothing
+}
+
+ScreenCastPortal::~ScreenCastPortal()
+{
+    g_cancellable_cancel(cancellable_);
+
+    unsubscribeFromResponse();
+    closeSession();
+
+    if (pipewire_fd_ != -1)
+        close(pipewire_fd_);
+
+    if (proxy_)
+        g_object_unref(proxy_);
+
+    if (connection_)
+        g_object_unref(connection_);
+
+    g_object_unref(cancellable_);
+    g_main_context_unref(context_);
+}
+
+void ScreenCastPortal::start()
+{
+    DCHECK(state_ == State::NOT_STARTED);
+
+    ScopedThreadDefaultContext scoped_context(context_);
+    ScopedGError error;
+
+    state_ = State::STARTING;
+
+    connection_ = g_bus_get_sync(G_BUS_TYPE_SESSION, cancellable_, error.receive());
+    if (!connection_)
+    {
+        LOG(LS_ERROR) << "Unable to connect to the session bus: " << error->message;
+        setFailed();
+        return;
+    }
+
+    proxy_ = g_dbus_proxy_new_sync(connection_, G_DBUS_PROXY_FLAGS_NONE, nullptr,
+                                   kDesktopBusName, kDesktopObjectPath, kScreenCastInterfaceName,
+                                   cancellable_, error.receive());
+    if (!proxy_)
+    {
+        LOG(LS_ERROR) << "Unable to create the ScreenCast portal proxy: " << error->message;
+        setFailed();
+        return;
+    }
+
+    // The request objects are created by the portal on the path which contains the unique name
+    // of the connection: ":1.42" becomes "1_42".
+    sender_name_ = g_dbus_connection_get_unique_name(connection_) + 1;
+    for (auto& ch : sender_name_)
+    {
+        if (ch == '.')
+            ch = '_';
+    }
+
+    const std::string session_token = newHandleToken();
+    const std::string handle_token = newHandleToken();
+
+    GVariantBuilder options;
+    g_variant_builder_init(&options, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&options, "{sv}", "session_handle_token",
+                          g_variant_new_string(session_token.c_str()));
+    g_variant_builder_add(&options, "{sv}", "handle_token",
+                          g_variant_new_string(handle_token.c_str()));
+
+    LOG(LS_INFO) << "Creating the screen cast session";
+
+    callMethod("CreateSession", g_variant_new("(a{sv})", &options), handle_token,
+               &ScreenCastPortal::onCreateSessionResponse);
+}
+
+void ScreenCastPortal::dispatch()
+{
+    ScopedThreadDefaultContext scoped_context(context_);
+
+    while (g_main_context_iteration(context_, FALSE))
+    {
+        // Nothing
+    }
+}
+
+int ScreenCastPortal::takePipeWireFd()
+{
+    DCHECK(state_ == State::STARTED);
+
+    int fd = pipewire_fd_;
+    pipewire_fd_ = -1;
+    return fd;
+}
+
+std::string ScreenCastPortal::newHandleToken()
+{
+    return "aspia" + std::to_string(++handle_counter_) + "_" + std::to_string(g_random_int());
+}
+
+void ScreenCastPortal::callMethod(const char* method, GVariant* parameters,
+                                  const std::string& handle_token, ResponseHandler handler)
+{
+    // The subscription is made before the call. Otherwise the response can be sent before the
+    // request path is known.
+    subscribeToResponse(kDesktopRequestObjectPath + sender_name_ + '/' + handle_token, handler);
+
+    g_dbus_proxy_call(proxy_, method, parameters, G_DBUS_CALL_FLAGS_NONE, -1, cancellable_,
+                      &ScreenCastPortal::onMethodCalled, this);
+}
+
+void ScreenCastPortal::subscribeToResponse(const std::string& request_path,
+                                           ResponseHandler handler)
+{
+    unsubscribeFromResponse();
+
+    request_path_ = request_path;
+    response_handler_ = handler;
+    response_subscription_ = g_dbus_connection_signal_subscribe(
+        connection_, kDesktopBusName, kRequestInterfaceName, "Response", request_path_.c_str(),
+        nullptr, G_DBUS_SIGNAL_FLAGS_NONE, &ScreenCastPortal::onResponseSignal, this,
+        nullptr);
+}
+
+void ScreenCastPortal::unsubscribeFromResponse()
+{
+    if (!response_subscription_)
+        return;
+
+    g_dbus_connection_signal_unsubscribe(connection_, response_subscription_);
+    response_subscription_ = 0;
+    request_path_.clear();
+}
+
+void ScreenCastPortal::closeSession()
+{
+    if (session_handle_.empty() || !connection_)
+        return;
+
+    g_dbus_connection_call(connection_, kDesktopBusName, session_handle_.c_str(),
+                           kSessionInterfaceName, "Close", nullptr, nullptr,
+                           G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr, nullptr);
+    g_dbus_connection_flush_sync(connection_, nullptr, nullptr);
+    session_handle_.clear();
+}
+
+void ScreenCastPortal::setFailed()
+{
+    unsubscribeFromResponse();
+    closeSession();
+    state_ = State::FAILED;
+}
+
+void ScreenCastPortal::selectSources()
+{
+    const std::string handle_token = newHandleToken();
+
+    GVariantBuilder options;
+    g_variant_builder_init(&options, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&options, "{sv}", "types", g_variant_new_uint32(kSourceTypeMonitor));
+    g_variant_builder_add(&options, "{sv}", "multiple", g_variant_new_boolean(FALSE));
+    g_variant_builder_add(&options, "{sv}", "handle_token",
+                          g_variant_new_string(handle_token.c_str()));
+
+    // The cursor is drawn into the frames by the compositor if possible. The cursor of Wayland
+    // clients is not visible to the X11 cursor capturer.
+    GVariant* cursor_modes = g_dbus_proxy_get_cached_property(proxy_, "AvailableCursorModes");
+    if (cursor_modes)
+    {
+        if (g_variant_get_uint32(cursor_modes) & kCursorModeEmbedded)
+        {
+            g_variant_builder_add(&options, "{sv}", "cursor_mode",
+                                  g_variant_new_uint32(kCursorModeEmbedded));
+        }
+
+        g_variant_unref(cursor_modes);
+    }
+
+    callMethod("SelectSources", g_variant_new("(oa{sv})", session_handle_.c_str(), &options),
+               handle_token, &ScreenCastPortal::onSelectSourcesResponse);
+}
+
+void ScreenCastPortal::startSession()
+{
+    const std::string handle_token = newHandleToken();
+
+    GVariantBuilder options;
+    g_variant_builder_init(&options, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&options, "{sv}", "handle_token",
+                          g_variant_new_string(handle_token.c_str()));
+
+    // The portal shows the dialog to select the monitor now.
+    callMethod("Start", g_variant_new("(osa{sv})", session_handle_.c_str(), "", &options),
+               handle_token, &ScreenCastPortal::onStartResponse);
+}
+
+void ScreenCastPortal::openPipeWireRemote()
+{
+    GVariantBuilder options;
+    g_variant_builder_init(&options, G_VARIANT_TYPE_VARDICT);
+
+    g_dbus_proxy_call_with_unix_fd_list(
+        proxy_, "OpenPipeWireRemote", g_variant_new("(oa{sv})", session_handle_.c_str(), &options),
+        G_DBUS_CALL_FLAGS_NONE, -1, nullptr, cancellable_,
+        &ScreenCastPortal::onPipeWireRemoteOpened, this);
+}
+
+void ScreenCastPortal::onCreateSessionResponse(GVariant* results)
+{
+    const gchar* session_handle = nullptr;
+    if (!g_variant_lookup(results, "session_handle", "&s", &session_handle))
+    {
+        LOG(LS_ERROR) << "No session handle in the response";
+        setFailed();
+        return;
+    }
+
+    session_handle_ = session_handle;
+    selectSources();
+}
+
+void ScreenCastPortal::onSelectSourcesResponse(GVariant* /* results */)
+{
+    startSession();
+}
+
+void ScreenCastPortal::onStartResponse(GVariant* results)
+{
+    GVariant* streams = g_variant_lookup_value(results, "streams", G_VARIANT_TYPE("a(ua{sv})"));
+    if (!streams)
+    {
+        LOG(LS_ERROR) << "No streams in the response";
+        setFailed();
+        return;
+    }
+
+    // Only one monitor is requested.
+    bool has_stream = false;
+    if (g_variant_n_children(streams) > 0)
+    {
+        GVariant* stream_properties = nullptr;
+        g_variant_get_child(streams, 0, "(u@a{sv})", &pipewire_node_, &stream_properties);
+        g_variant_unref(stream_properties);
+        has_stream = true;
+    }
+
+    g_variant_unref(streams);
+
+    if (!has_stream)
+    {
+        LOG(LS_ERROR) << "Empty list of streams";
+        setFailed();
+        return;
+    }
+
+    LOG(LS_INFO) << "Screen cast started (node: " << pipewire_node_ << ")";
+    openPipeWireRemote();
+}
+
+// static
+void ScreenCastPortal::onMethodCalled(GObject* object, GAsyncResult* result, gpointer user_data)
+{
+    ScopedGError error;
+    GVariant* reply = g_dbus_proxy_call_finish(G_DBUS_PROXY(object), result, error.receive());
+
+    if (error.isCancelled())
+        return;
+
+    ScreenCastPortal* self = reinterpret_cast<ScreenCastPortal*>(user_data);
+
+    if (!reply)
+    {
+        LOG(LS_ERROR) << "Portal call failed: " << error->message;
+        self->setFailed();
+        return;
+    }
+
+    // Old versions of the portal do not support "handle_token" and return a different path.
+    const gchar* request_path = nullptr;
+    g_variant_get(reply, "(&o)", &request_path);
+
+    if (self->request_path_ != request_path)
+        self->subscribeToResponse(request_path, self->response_handler_);
+
+    g_variant_unref(reply);
+}
+
+// static
+void ScreenCastPortal::onResponseSignal(GDBusConnection* /* connection */,
+                                        const gchar* /* sender_name */,
+                                        const gchar* /* object_path */,
+                                        const gchar* /* interface_name */,
+                                        const gchar* /* signal_name */,
+                                        GVariant* parameters,
+                                        gpointer user_data)
+{
+    ScreenCastPortal* self = reinterpret_cast<ScreenCastPortal*>(user_data);
+
+    uint32_t response = 0;
+    GVariant* results = nullptr;
+    g_variant_get(parameters, "(u@a{sv})", &response, &results);
+
+    ResponseHandler handler = self->response_handler_;
+    self->unsubscribeFromResponse();
+
+    if (response != 0)
+    {
+        // 1 - the user cancelled the request, 2 - the request failed.
+        LOG(LS_ERROR) << "Portal request failed (response: " << response << ")";
+        self->setFailed();
+    }
+    else
+    {
+        (self->*handler)(results);
+    }
+
+    g_variant_unref(results);
+}
+
+// static
+void ScreenCastPortal::onPipeWireRemoteOpened(
+    GObject* object, GAsyncResult* result, gpointer user_data)
+{
+    ScopedGError error;
+    GUnixFDList* fd_list = nullptr;
+    GVariant* reply = g_dbus_proxy_call_with_unix_fd_list_finish(
+        G_DBUS_PROXY(object), &fd_list, result, error.receive());
+
+    if (error.isCancelled())
+        return;
+
+    ScreenCastPortal* self = reinterpret_cast<ScreenCastPortal*>(user_data);
+
+    if (!reply)
+    {
+        LOG(LS_ERROR) << "Unable to open the PipeWire remote: " << error->message;
+        self->setFailed();
+        return;
+    }
+
+    int32_t index = 0;
+    g_variant_get(reply, "(h)", &index);
+    g_variant_unref(reply);
+
+    self->pipewire_fd_ = g_unix_fd_list_get(fd_list, index, error.receive());
+    g_object_unref(fd_list);
+
+    if (self->pipewire_fd_ == -1)
+    {
+        LOG(LS_ERROR) << "Unable to get the PipeWire descriptor: " << error->message;
+        self->setFailed();
+        return;
+    }
+
+    self->state_ = State::STARTED;
+}
+
+} // namespace base
@@ -0,0 +1,106 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__SCREEN_CAST_PORTAL_H
+#define BASE__DESKTOP__SCREEN_CAST_PORTAL_H
+
+#include "base/macros_magic.h"
+
+#include <gio/gio.h>
+
+#include <string>
+
+namespace base {
+
+// Requests a screen cast session from xdg-desktop-portal (org.freedesktop.portal.ScreenCast).
+// The portal asks the user which monitor to share and returns a PipeWire remote with the stream
+// of the monitor. All calls are asynchronous, the replies are handled in dispatch() which must be
+// called periodically from the thread on which the portal was created.
+class ScreenCastPortal
+{
+public:
+    ScreenCastPortal();
+    ~ScreenCastPortal();
+
+    enum class State { NOT_STARTED, STARTING, STARTED, FAILED };
+
+    // Connects to the session bus and creates the screen cast session.
+    void start();
+
+    // Handles the pending replies of the portal without blocking.
+    void dispatch();
+
+    State state() const { return state_; }
+
+    // Available in STARTED state. The ownership of the descriptor is passed to the caller.
+    int takePipeWireFd();
+    uint32_t pipeWireNode() const { return pipewire_node_; }
+
+private:
+    using ResponseHandler = void (ScreenCastPortal::*)(GVariant* results);
+
+    std::string newHandleToken();
+    void callMethod(const char* method, GVariant* parameters, const std::string& handle_token,
+                    ResponseHandler handler);
+    void subscribeToResponse(const std::string& request_path, ResponseHandler handler);
+    void unsubscribeFromResponse();
+    void closeSession();
+    void setFailed();
+
+    void selectSources();
+    void startSession();
+    void openPipeWireRemote();
+
+    void onCreateSessionResponse(GVariant* results);
+    void onSelectSourcesResponse(GVariant* results);
+    void onStartResponse(GVariant* results);
+
+    static void onMethodCalled(GObject* object, GAsyncResult* result, gpointer user_data);
+    static void onResponseSignal(GDBusConnection* connection,
+                                 const gchar* sender_name,
+                                 const gchar* object_path,
+                                 const gchar* interface_name,
+                                 const gchar* signal_name,
+                                 GVariant* parameters,
+                                 gpointer user_data);
+    static void onPipeWireRemoteOpened(GObject* object, GAsyncResult* result, gpointer user_data);
+
+    State state_ = State::NOT_STARTED;
+
+    GMainContext* context_ = nullptr;
+    GCancellable* cancellable_ = nullptr;
+    GDBusConnection* connection_ = nullptr;
+    GDBusProxy* proxy_ = nullptr;
+
+    guint response_subscription_ = 0;
+    std::string request_path_;
+    ResponseHandler response_handler_ = nullptr;
+
+    std::string sender_name_;
+    std::string session_handle_;
+    uint32_t handle_counter_ = 0;
+
+    int pipewire_fd_ = -1;
+    uint32_t pipewire_node_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(ScreenCastPortal);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__SCREEN_CAST_PORTAL_H
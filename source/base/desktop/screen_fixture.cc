@@ -0,0 +1,337 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/screen_fixture.h"
+
+#include "base/environment.h"
+#include "base/logging.h"
+#include "base/desktop/differ.h"
+#include "base/desktop/frame_simple.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace base {
+
+namespace {
+
+const Size kDefaultSize(1920, 1080);
+const int kDefaultFrameCount = 30;
+const int kMaxRecordedFrameCount = 300;
+
+const int kLineHeight = 16;
+const int kScrollStep = 8;
+
+uint32_t makeColor(int r, int g, int b)
+{
+    return 0xFF000000 | (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) |
+        static_cast<uint32_t>(b);
+}
+
+// Simple deterministic generator, so that the frames are the same on every platform.
+uint32_t nextRandom(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+void fillRect(Frame* frame, const Rect& rect, uint32_t color)
+{
+    Rect clipped = rect;
+    clipped.intersectWith(Rect::makeSize(frame->size()));
+
+    for (int y = clipped.top(); y < clipped.bottom(); ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(clipped.left(), y));
+        for (int x = 0; x < clipped.width(); ++x)
+            row[x] = color;
+    }
+}
+
+void drawWallpaper(Frame* frame)
+{
+    const Size& size = frame->size();
+
+    for (int y = 0; y < size.height(); ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(0, y));
+        const int blue = 96 + y * 128 / size.height();
+
+        for (int x = 0; x < size.width(); ++x)
+            row[x] = makeColor(16, 48 + x * 64 / size.width(), blue);
+    }
+}
+
+// Draws lines of "words" made of thin vertical strokes. The words of line N are always the same,
+// |first_line| is the number of the line at the top of |rect|.
+void drawText(Frame* frame, const Rect& rect, int first_line)
+{
+    Rect clipped = rect;
+    clipped.intersectWith(Rect::makeSize(frame->size()));
+
+    const uint32_t text_color = makeColor(32, 32, 32);
+
+    for (int line = 0; line * kLineHeight < clipped.height(); ++line)
+    {
+        uint32_t state = static_cast<uint32_t>(first_line + line) * 2654435761u;
+        const int top = clipped.top() + line * kLineHeight + 3;
+        const int bottom = std::min(top + 10, clipped.bottom());
+
+        int x = clipped.left() + 8;
+        while (x < clipped.right() - 8)
+        {
+            const int word_width = 12 + static_cast<int>(nextRandom(&state) % 48);
+
+            for (int stroke = x; stroke < std::min(x + word_width, clipped.right()); stroke += 3)
+            {
+                const int height = 6 + static_cast<int>(nextRandom(&state) % 5);
+                for (int y = std::max(bottom - height, top); y < bottom; ++y)
+                    *reinterpret_cast<uint32_t*>(frame->frameDataAtPos(stroke, y)) = text_color;
+            }
+
+            x += word_width + 6;
+        }
+    }
+}
+
+void drawWindow(Frame* frame, const Rect& rect, int first_line)
+{
+    fillRect(frame, rect, makeColor(240, 240, 240));
+    fillRect(frame, Rect::makeXYWH(rect.left(), rect.top(), rect.width(), 30),
+             makeColor(60, 90, 150));
+
+    drawText(frame, Rect::makeLTRB(rect.left(), rect.top() + 30, rect.right(), rect.bottom()),
+             first_line);
+}
+
+void drawVideo(Frame* frame, const Rect& rect, int index)
+{
+    Rect clipped = rect;
+    clipped.intersectWith(Rect::makeSize(frame->size()));
+
+    uint32_t state = static_cast<uint32_t>(index) + 1;
+
+    for (int y = clipped.top(); y < clipped.bottom(); ++y)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(frame->frameDataAtPos(clipped.left(), y));
+        for (int x = 0; x < clipped.width(); ++x)
+        {
+            // Smooth moving gradient with a small amount of noise.
+            const int noise = static_cast<int>(nextRandom(&state) % 16);
+            row[x] = makeColor((x + index * 4) % 256, (y + index * 2) % 256,
+                               (x + y) / 4 % 192 + noise);
+        }
+    }
+}
+
+void drawSyntheticFrame(Frame* frame, int index)
+{
+    const Size& size = frame->size();
+    const int width = size.width();
+    const int height = size.height();
+
+    drawWallpaper(frame);
+
+    // A static window on the left, a document which scrolls on the right.
+    const Rect static_window = Rect::makeXYWH(width / 20, height / 10, width * 2 / 5, height / 2);
+    const Rect document = Rect::makeXYWH(width / 2, height / 20, width * 9 / 20, height * 4 / 5);
+
+    drawWindow(frame, static_window, 0);
+    drawWindow(frame, document, index * kScrollStep / kLineHeight);
+
+    // Caret in the static window blinks every 4 frames.
+    if ((index / 4) % 2 == 0)
+    {
+        fillRect(frame, Rect::makeXYWH(static_window.left() + 40, static_window.top() + 50, 2, 14),
+                 makeColor(0, 0, 0));
+    }
+
+    drawVideo(frame, Rect::makeXYWH(width / 10, height * 2 / 3, width / 6, height / 6), index);
+
+    // Taskbar with a clock which changes every 10 frames.
+    const Rect taskbar = Rect::makeXYWH(0, height - 40, width, 40);
+    fillRect(frame, taskbar, makeColor(30, 30, 40));
+    fillRect(frame, Rect::makeXYWH(width - 80 + (index / 10) % 4 * 8, height - 28, 6, 16),
+             makeColor(220, 220, 220));
+}
+
+} // namespace
+
+// static
+const char ScreenFixture::kRecordedScreenVariable[] = "ASPIA_BENCHMARK_SCREEN";
+
+ScreenFixture::ScreenFixture(const Size& size)
+    : size_(size)
+{
+    // Nothing
+}
+
+ScreenFixture::~ScreenFixture() = default;
+
+// static
+std::unique_ptr<ScreenFixture> ScreenFixture::createSynthetic(const Size& size, int frame_count)
+{
+    DCHECK(!size.isEmpty());
+    DCHECK_GT(frame_count, 0);
+
+    std::unique_ptr<ScreenFixture> fixture(new ScreenFixture(size));
+
+    for (int i = 0; i < frame_count; ++i)
+    {
+        std::unique_ptr<Frame> frame = FrameSimple::create(size);
+        if (!frame)
+            return nullptr;
+
+        drawSyntheticFrame(frame.get(), i);
+        fixture->frames_.emplace_back(std::move(frame));
+    }
+
+    fixture->calcUpdatedRegions();
+    return fixture;
+}
+
+// static
+std::unique_ptr<ScreenFixture> ScreenFixture::createFromFile(
+    const std::filesystem::path& path, int max_frame_count)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        LOG(LS_ERROR) << "Unable to open file: " << path;
+        return nullptr;
+    }
+
+    uint8_t header[8];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+    {
+        LOG(LS_ERROR) << "Unable to read header: " << path;
+        return nullptr;
+    }
+
+    auto readUint32 = [](const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+            (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    };
+
+    const uint32_t width = readUint32(header);
+    const uint32_t height = readUint32(header + 4);
+
+    if (!width || !height || width > 16384 || height > 16384)
+    {
+        LOG(LS_ERROR) << "Invalid frame size: " << width << "x" << height;
+        return nullptr;
+    }
+
+    const Size size(static_cast<int32_t>(width), static_cast<int32_t>(height));
+    const int row_size = size.width() * Frame::kBytesPerPixel;
+
+    std::unique_ptr<ScreenFixture> fixture(new ScreenFixture(size));
+
+    while (fixture->frameCount() < max_frame_count)
+    {
+        std::unique_ptr<Frame> frame = FrameSimple::create(size);
+        if (!frame)
+            return nullptr;
+
+        bool is_complete = true;
+
+        for (int y = 0; y < size.height(); ++y)
+        {
+            if (!file.read(reinterpret_cast<char*>(frame->frameDataAtPos(0, y)), row_size))
+            {
+                is_complete = false;
+                break;
+            }
+        }
+
+        if (!is_complete)
+            break;
+
+        fixture->frames_.emplace_back(std::move(frame));
+    }
+
+    if (fixture->frames_.empty())
+    {
+        LOG(LS_ERROR) << "No frames in file: " << path;
+        return nullptr;
+    }
+
+    fixture->calcUpdatedRegions();
+    return fixture;
+}
+
+// static
+std::unique_ptr<ScreenFixture> ScreenFixture::create(const std::filesystem::path& path)
+{
+    if (!path.empty())
+    {
+        std::unique_ptr<ScreenFixture> fixture = createFromFile(path, kMaxRecordedFrameCount);
+        if (fixture)
+            return fixture;
+
+        LOG(LS_WARNING) << "Recorded screen not loaded. Synthetic frames are used";
+    }
+
+    return createSynthetic(kDefaultSize, kDefaultFrameCount);
+}
+
+// static
+std::unique_ptr<ScreenFixture> ScreenFixture::createDefault()
+{
+    std::string path;
+    Environment::get(kRecordedScreenVariable, &path);
+    return create(path);
+}
+
+// static
+const ScreenFixture& ScreenFixture::shared()
+{
+    static const std::unique_ptr<ScreenFixture> fixture = createDefault();
+    CHECK(fixture);
+    return *fixture;
+}
+
+const Frame* ScreenFixture::frame(int index) const
+{
+    DCHECK_GE(index, 0);
+    DCHECK_LT(index, frameCount());
+    return frames_[static_cast<size_t>(index)].get();
+}
+
+void ScreenFixture::calcUpdatedRegions()
+{
+    Differ differ(size_);
+
+    for (size_t i = 0; i < frames_.size(); ++i)
+    {
+        Region* updated_region = frames_[i]->updatedRegion();
+
+        if (i == 0)
+        {
+            updated_region->setRect(Rect::makeSize(size_));
+            continue;
+        }
+
+        updated_region->clear();
+        differ.calcDirtyRegion(
+            frames_[i - 1]->frameData(), frames_[i]->frameData(), updated_region);
+    }
+}
+
+} // namespace base
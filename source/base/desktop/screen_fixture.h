@@ -0,0 +1,83 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__SCREEN_FIXTURE_H
+#define BASE__DESKTOP__SCREEN_FIXTURE_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace base {
+
+class Frame;
+
+// A sequence of screen frames for the benchmarks of the screen pipeline and for the fake screen
+// capturer (see ScreenCapturerFake). The updated region of
+// every frame contains the blocks which differ from the previous frame (the whole first frame is
+// updated), as a capturer would report it.
+class ScreenFixture
+{
+public:
+    ~ScreenFixture();
+
+    // The environment variable with the path of a recorded screen (see createFromFile()).
+    static const char kRecordedScreenVariable[];
+
+    // Frames which look like a desktop: a wallpaper, windows with text, a blinking caret, a
+    // document which scrolls and a video which changes in every frame. The content depends only
+    // on |size| and |frame_count|, so the results of different runs can be compared.
+    static std::unique_ptr<ScreenFixture> createSynthetic(const Size& size, int frame_count);
+
+    // Reads a recorded screen. The file contains the width and the height of the frames (32-bit
+    // little-endian integers) followed by the frames in the 32bpp BGRA format without
+    // padding. No more than |max_frame_count| frames are read.
+    static std::unique_ptr<ScreenFixture> createFromFile(
+        const std::filesystem::path& path, int max_frame_count);
+
+    // Returns the recorded screen from |path| if it is not empty and the file can be read,
+    // otherwise 30 synthetic frames of 1920x1080.
+    static std::unique_ptr<ScreenFixture> create(const std::filesystem::path& path);
+
+    // Same as create() with the path from kRecordedScreenVariable.
+    static std::unique_ptr<ScreenFixture> createDefault();
+
+    // The fixture made by createDefault() once for the process. The benchmarks use it, so that the
+    // frames are not generated (or read) for every benchmark.
+    static const ScreenFixture& shared();
+
+    const Size& size() const { return size_; }
+    int frameCount() const { return static_cast<int>(frames_.size()); }
+    const Frame* frame(int index) const;
+
+private:
+    explicit ScreenFixture(const Size& size);
+    void calcUpdatedRegions();
+
+    const Size size_;
+    std::vector<std::unique_ptr<Frame>> frames_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScreenFixture);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__SCREEN_FIXTURE_H
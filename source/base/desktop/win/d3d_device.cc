@@ -23,6 +23,7 @@
 #include <utility>
 
 #include <comdef.h>
+#include <d3d10.h>
 
 namespace base {
 
@@ -49,7 +50,7 @@ bool D3dDevice::initialize(const ComPtr<IDXGIAdapter>& adapter)
     // Default feature levels contain D3D 9.1 through D3D 11.0.
     _com_error error = D3D11CreateDevice(
         adapter.Get(), D3D_DRIVER_TYPE_UNKNOWN, nullptr,
-        D3D11_CREATE_DEVICE_BGRA_SUPPORT | D3D11_CREATE_DEVICE_SINGLETHREADED,
+        D3D11_CREATE_DEVICE_BGRA_SUPPORT,
         nullptr, 0, D3D11_SDK_VERSION, d3d_device_.GetAddressOf(), &feature_level,
         context_.GetAddressOf());
     if (error.Error() != S_OK || !d3d_device_ || !context_)
@@ -68,6 +69,19 @@ bool D3dDevice::initialize(const ComPtr<IDXGIAdapter>& adapter)
         // duplicator APIs.
     }
 
+    // The outputs of the adapter are duplicated from several threads which share the immediate
+    // context, so the calls to the context must be serialized.
+    ComPtr<ID3D10Multithread> multithread;
+    error = context_.As(&multithread);
+    if (error.Error() != S_OK || !multithread)
+    {
+        LOG(LS_WARNING) << "ID3D11DeviceContext does not support ID3D10Multithread, error "
+                        << error.ErrorMessage() << " with code " << error.Error();
+        return false;
+    }
+
+    multithread->SetMultithreadProtected(TRUE);
+
     error = d3d_device_.As(&dxgi_device_);
     if (error.Error() != S_OK || !dxgi_device_)
     {
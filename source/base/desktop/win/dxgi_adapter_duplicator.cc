@@ -19,6 +19,7 @@
 #include "base/desktop/win/dxgi_adapter_duplicator.h"
 
 #include "base/logging.h"
+#include "base/threading/thread_pool.h"
 
 #include <algorithm>
 
@@ -150,18 +151,58 @@ void DxgiAdapterDuplicator::unregister(const Context* const context)
         duplicators_[i].unregister(&context->contexts[i]);
 }
 
-bool DxgiAdapterDuplicator::duplicate(Context* context, SharedFrame* target)
+bool DxgiAdapterDuplicator::duplicate(Context* context, SharedFrame* target,
+                                      ThreadPool* thread_pool)
 {
     DCHECK_EQ(context->contexts.size(), duplicators_.size());
 
+    if (!thread_pool || duplicators_.size() < 2)
+    {
+        for (size_t i = 0; i < duplicators_.size(); ++i)
+        {
+            if (!duplicators_[i].duplicate(&context->contexts[i],
+                                           duplicators_[i].desktopRect().topLeft(),
+                                           target))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // While one output waits for the GPU to copy its texture to the staging texture, the others
+    // copy their pixels to |target|. Each output collects its changes separately, they are merged
+    // into |target| when all the outputs are done.
+    std::vector<Region> updated_regions(duplicators_.size());
+    std::vector<Frame::MovedRects> moved_rects(duplicators_.size());
+    std::vector<uint8_t> results(duplicators_.size(), 0);
+    std::vector<ThreadPool::Task> tasks;
+
     for (size_t i = 0; i < duplicators_.size(); ++i)
     {
-        if (!duplicators_[i].duplicate(&context->contexts[i],
-                                       duplicators_[i].desktopRect().topLeft(),
-                                       target))
+        tasks.emplace_back([&, i]()
         {
+            results[i] = duplicators_[i].duplicate(&context->contexts[i],
+                                                   duplicators_[i].desktopRect().topLeft(),
+                                                   target,
+                                                   &updated_regions[i],
+                                                   &moved_rects[i]);
+        });
+    }
+
+    thread_pool->runTasks(std::move(tasks));
+
+    for (size_t i = 0; i < duplicators_.size(); ++i)
+    {
+        if (!results[i])
             return false;
-        }
+
+        target->updatedRegion()->addRegion(updated_regions[i]);
+
+        Frame::MovedRects* target_moved_rects = target->movedRects();
+        target_moved_rects->insert(
+            target_moved_rects->end(), moved_rects[i].begin(), moved_rects[i].end());
     }
 
     return true;
@@ -176,6 +217,14 @@ bool DxgiAdapterDuplicator::duplicateMonitor(Context* context, int monitor_id, S
     return duplicators_[monitor_id].duplicate(&context->contexts[monitor_id], Point(), target);
 }
 
+bool DxgiAdapterDuplicator::waitForFrame(int monitor_id, const std::chrono::milliseconds& timeout)
+{
+    DCHECK_GE(monitor_id, 0);
+    DCHECK_LT(monitor_id, static_cast<int>(duplicators_.size()));
+
+    return duplicators_[monitor_id].waitForFrame(timeout);
+}
+
 Rect DxgiAdapterDuplicator::screenRect(int id) const
 {
     DCHECK_GE(id, 0);
@@ -28,6 +28,8 @@
 
 namespace base {
 
+class ThreadPool;
+
 // A container of DxgiOutputDuplicators to duplicate monitors attached to a single video card.
 class DxgiAdapterDuplicator
 {
@@ -47,13 +49,17 @@ public:
     // Initializes the DxgiAdapterDuplicator from a D3dDevice.
     bool initialize();
 
-    // Sequentially calls Duplicate function of all the DxgiOutputDuplicator instances owned by
-    // this instance, and writes into |target|.
-    bool duplicate(Context* context, SharedFrame* target);
+    // Calls Duplicate function of all the DxgiOutputDuplicator instances owned by this instance,
+    // and writes into |target|. If |thread_pool| is not null, the outputs are duplicated on its
+    // threads in parallel, otherwise sequentially.
+    bool duplicate(Context* context, SharedFrame* target, ThreadPool* thread_pool = nullptr);
 
     // Captures one monitor and writes into |target|. |monitor_id| should be between [0, screenCount()).
     bool duplicateMonitor(Context* context, int monitor_id, SharedFrame* target);
 
+    // Waits for an update of one monitor. See DxgiOutputDuplicator::waitForFrame().
+    bool waitForFrame(int monitor_id, const std::chrono::milliseconds& timeout);
+
     // Returns desktop rect covered by this DxgiAdapterDuplicator.
     const Rect& desktopRect() const { return desktop_rect_; }
 
@@ -22,12 +22,27 @@
 #include "base/desktop/frame_aligned.h"
 #include "base/desktop/win/dxgi_frame.h"
 #include "base/desktop/win/screen_capture_utils.h"
+#include "base/threading/thread_pool.h"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
 namespace base {
 
+namespace {
+
+// Sends the moved areas of |frame| as updated areas.
+void dropMovedRects(Frame* frame)
+{
+    for (const auto& moved_rect : frame->constMovedRects())
+        frame->updatedRegion()->addRect(moved_rect.dest_rect);
+
+    frame->movedRects()->clear();
+}
+
+} // namespace
+
 // static
 const char* DxgiDuplicatorController::resultName(DxgiDuplicatorController::Result result)
 {
@@ -112,6 +127,31 @@ DxgiDuplicatorController::Result DxgiDuplicatorController::duplicateMonitor(
     return doDuplicate(frame, monitor_id);
 }
 
+bool DxgiDuplicatorController::canWaitForUpdate() const
+{
+    return last_duplication_succeeded_ && !duplicators_.empty();
+}
+
+bool DxgiDuplicatorController::waitForUpdate(
+    int monitor_id, const std::chrono::milliseconds& timeout)
+{
+    if (!canWaitForUpdate())
+        return true;
+
+    if (monitor_id < 0)
+        monitor_id = 0;
+
+    for (auto& duplicator : duplicators_)
+    {
+        if (monitor_id < duplicator.screenCount())
+            return duplicator.waitForFrame(monitor_id, timeout);
+
+        monitor_id -= duplicator.screenCount();
+    }
+
+    return true;
+}
+
 Point DxgiDuplicatorController::dpi()
 {
     if (!initialize())
@@ -181,6 +221,15 @@ DxgiDuplicatorController::Result DxgiDuplicatorController::doDuplicate(
         return Result::FRAME_PREPARE_FAILED;
 
     frame->frame()->updatedRegion()->clear();
+    frame->frame()->movedRects()->clear();
+
+    // The first frames after the initialization are captured by ensureFrameCaptured() and are not
+    // returned to the caller.
+    const bool moves_allowed = last_duplication_succeeded_ && last_monitor_id_ == monitor_id &&
+                               numFramesCaptured() > 0;
+
+    last_duplication_succeeded_ = false;
+    last_monitor_id_ = monitor_id;
 
     setup(frame->context());
 
@@ -200,6 +249,10 @@ DxgiDuplicatorController::Result DxgiDuplicatorController::doDuplicate(
 
         if (result)
         {
+            if (!moves_allowed)
+                dropMovedRects(frame->frame());
+
+            last_duplication_succeeded_ = true;
             ++succeeded_duplications_;
             return Result::SUCCEEDED;
         }
@@ -287,6 +340,22 @@ bool DxgiDuplicatorController::doInitialize()
 
     translateRect();
 
+    size_t max_output_count = 0;
+    for (const auto& duplicator : duplicators_)
+    {
+        max_output_count =
+            std::max(max_output_count, static_cast<size_t>(duplicator.screenCount()));
+    }
+
+    const size_t thread_count = std::min(
+        max_output_count, static_cast<size_t>(std::thread::hardware_concurrency()));
+
+    if (thread_count > 1)
+    {
+        LOG(LS_INFO) << "Outputs are duplicated in parallel on " << thread_count << " threads";
+        thread_pool_ = std::make_unique<ThreadPool>(thread_count);
+    }
+
     HDC hdc = GetDC(nullptr);
     // Use old DPI value if failed.
     if (hdc)
@@ -309,6 +378,7 @@ void DxgiDuplicatorController::deinitialize()
 {
     desktop_rect_ = Rect();
     duplicators_.clear();
+    thread_pool_.reset();
     display_configuration_monitor_.reset();
 }
 
@@ -338,7 +408,7 @@ bool DxgiDuplicatorController::doDuplicateAll(Context* context, SharedFrame* tar
 {
     for (size_t i = 0; i < duplicators_.size(); ++i)
     {
-        if (!duplicators_[i].duplicate(&context->contexts[i], target))
+        if (!duplicators_[i].duplicate(&context->contexts[i], target, thread_pool_.get()))
             return false;
     }
 
@@ -27,11 +27,15 @@
 
 #include <D3DCommon.h>
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace base {
 
+class ThreadPool;
+
 // A controller for all the objects we need to call Windows DirectX capture APIs It's a singleton
 // because only one IDXGIOutputDuplication instance per monitor is allowed per application.
 //
@@ -100,6 +104,16 @@ public:
     // greater than the total screen count of all the Duplicators, this function returns false.
     Result duplicateMonitor(DxgiFrame* frame, int monitor_id);
 
+    // Returns true if waitForUpdate() can wait for the updates of the screen. It needs the
+    // duplicators created by a successful duplicate().
+    bool canWaitForUpdate() const;
+
+    // Blocks until Windows presents an update of the monitor |monitor_id| or |timeout| passes.
+    // Setting |monitor_id| < 0 waits for the first monitor only, the updates of the other monitors
+    // are captured when the wait times out. Returns true if there is an update or an error, which
+    // the next duplicate() handles.
+    bool waitForUpdate(int monitor_id, const std::chrono::milliseconds& timeout);
+
     // Returns dpi of current system. Returns an empty DesktopVector if system
     // does not support DXGI based capturer.
     Point dpi();
@@ -188,10 +202,16 @@ private:
     Rect desktop_rect_;
     Point dpi_;
     std::vector<DxgiAdapterDuplicator> duplicators_;
+    // Duplicates the outputs of an adapter in parallel. Null if no adapter has several outputs.
+    std::unique_ptr<ThreadPool> thread_pool_;
     D3dInfo d3d_info_;
     DisplayConfigurationMonitor display_configuration_monitor_;
     // A number to indicate how many succeeded duplications have been performed.
     uint32_t succeeded_duplications_ = 0;
+    // The moves returned by Windows are relative to the previously captured frame. They are sent
+    // only when that frame was returned by the previous duplication of the same monitor.
+    bool last_duplication_succeeded_ = false;
+    int last_monitor_id_ = -1;
 };
 
 } // namespace base
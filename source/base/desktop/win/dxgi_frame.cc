@@ -19,17 +19,18 @@
 #include "base/desktop/win/dxgi_frame.h"
 
 #include "base/logging.h"
-#include "base/desktop/frame_aligned.h"
-#include "base/desktop/shared_memory_frame.h"
+#include "base/desktop/frame_pool.h"
 
 namespace base {
 
 DxgiFrame::DxgiFrame(std::shared_ptr<DxgiDuplicatorController> controller,
-                     SharedMemoryFactory* shared_memory_factory)
+                     SharedMemoryFactory* shared_memory_factory,
+                     FramePool* frame_pool)
     : context_(std::move(controller)),
-      shared_memory_factory_(shared_memory_factory)
+      shared_memory_factory_(shared_memory_factory),
+      frame_pool_(frame_pool)
 {
-    // Nothing
+    DCHECK(frame_pool_);
 }
 
 DxgiFrame::~DxgiFrame() = default;
@@ -57,13 +58,14 @@ bool DxgiFrame::prepare(const Size& size, ScreenCapturer::ScreenId source_id)
     {
         std::unique_ptr<Frame> frame;
 
+        // The buffer of the previous frame (if it had the same size) is reused.
         if (shared_memory_factory_)
         {
-            frame = SharedMemoryFrame::create(size, shared_memory_factory_);
+            frame = frame_pool_->createShared(size, shared_memory_factory_);
         }
         else
         {
-            frame = FrameAligned::create(size, 32);
+            frame = frame_pool_->create(size);
         }
 
         if (!frame)
@@ -30,6 +30,7 @@
 namespace base {
 
 class DxgiDuplicatorController;
+class FramePool;
 class SharedMemoryFactory;
 
 // A pair of a SharedFrame and a DxgiDuplicatorController::Context for the client of
@@ -39,8 +40,9 @@ class DxgiFrame final
 public:
     using Context = DxgiFrameContext;
 
-    explicit DxgiFrame(std::shared_ptr<DxgiDuplicatorController> controller,
-                       SharedMemoryFactory* shared_memory_factory);
+    DxgiFrame(std::shared_ptr<DxgiDuplicatorController> controller,
+              SharedMemoryFactory* shared_memory_factory,
+              FramePool* frame_pool);
     ~DxgiFrame();
 
     // Should not be called if prepare() is not executed or returns false.
@@ -58,6 +60,7 @@ private:
     Context* context();
 
     SharedMemoryFactory* const shared_memory_factory_;
+    FramePool* const frame_pool_;
     std::optional<Size> last_frame_size_;
     ScreenCapturer::ScreenId source_id_ = ScreenCapturer::kFullDesktopScreenId;
     std::unique_ptr<SharedFrame> frame_;
@@ -191,10 +191,19 @@ bool DxgiOutputDuplicator::releaseFrame()
 }
 
 bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, SharedFrame* target)
+{
+    DCHECK(target);
+    return duplicate(context, offset, target, target->updatedRegion(), target->movedRects());
+}
+
+bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, SharedFrame* target,
+                                     Region* target_region, Frame::MovedRects* target_moved_rects)
 {
     DCHECK(duplication_);
     DCHECK(texture_);
     DCHECK(target);
+    DCHECK(target_region);
+    DCHECK(target_moved_rects);
 
     if (!Rect::makeSize(target->size()).containsRect(translatedDesktopRect(offset)))
     {
@@ -207,9 +216,22 @@ bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, Shar
 
     ComPtr<IDXGIResource> resource;
 
-    _com_error error = duplication_->AcquireNextFrame(kAcquireTimeoutMs,
-                                                      &frame_info,
-                                                      resource.GetAddressOf());
+    _com_error error(S_OK);
+
+    if (has_waited_frame_)
+    {
+        // The frame is already acquired by waitForFrame().
+        has_waited_frame_ = false;
+        frame_info = waited_frame_info_;
+        resource = std::move(waited_resource_);
+    }
+    else
+    {
+        error = _com_error(duplication_->AcquireNextFrame(kAcquireTimeoutMs,
+                                                          &frame_info,
+                                                          resource.GetAddressOf()));
+    }
+
     if (error.Error() != S_OK && error.Error() != DXGI_ERROR_WAIT_TIMEOUT)
     {
         LOG(LS_ERROR) << "Failed to capture frame, error "
@@ -225,14 +247,32 @@ bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, Shar
 
     if (error.Error() == S_OK && frame_info.AccumulatedFrames > 0 && resource)
     {
-        detectUpdatedRegion(frame_info, &context->updated_region);
-        spreadContextChange(context);
+        Frame::MovedRects moved_rects;
+        Region moved_region;
 
-        if (!texture_->copyFrom(frame_info, resource.Get()))
-            return false;
+        detectUpdatedRegion(frame_info, &context->updated_region, &moved_rects, &moved_region);
+        spreadContextChange(context);
 
         updated_region.addRegion(context->updated_region);
 
+        // Only the updated areas are read back from the GPU. The texture is not rotated.
+        Region texture_region;
+        if (rotation_ != Rotation::CLOCK_WISE_0)
+        {
+            for (Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+            {
+                texture_region.addRect(
+                    rotateRect(it.rect(), desktopSize(), reverseRotation(rotation_)));
+            }
+        }
+        else
+        {
+            texture_region = updated_region;
+        }
+
+        if (!texture_->copyFrom(frame_info, resource.Get(), texture_region))
+            return false;
+
         // TODO(zijiehe): Figure out why clearing context->updated_region() here
         // triggers screen flickering?
 
@@ -264,7 +304,20 @@ bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, Shar
         last_frame_offset_ = offset;
 
         updated_region.translate(offset.x(), offset.y());
-        target->updatedRegion()->addRegion(updated_region);
+
+        // The areas which are only moved are sent as copy operations instead of the pixels. The
+        // pixels are still copied to |target| above.
+        moved_region.translate(offset.x(), offset.y());
+        updated_region.subtract(moved_region);
+
+        for (auto& moved_rect : moved_rects)
+        {
+            moved_rect.src_pos.translate(offset);
+            moved_rect.dest_rect.translate(offset);
+            target_moved_rects->push_back(moved_rect);
+        }
+
+        target_region->addRegion(updated_region);
         ++num_frames_captured_;
 
         return texture_->release() && releaseFrame();
@@ -289,7 +342,7 @@ bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, Shar
         }
 
         updated_region.translate(offset.x(), offset.y());
-        target->updatedRegion()->addRegion(updated_region);
+        target_region->addRegion(updated_region);
     }
     else
     {
@@ -302,6 +355,53 @@ bool DxgiOutputDuplicator::duplicate(Context* context, const Point& offset, Shar
     return error.Error() == DXGI_ERROR_WAIT_TIMEOUT || releaseFrame();
 }
 
+bool DxgiOutputDuplicator::waitForFrame(const std::chrono::milliseconds& timeout)
+{
+    DCHECK(duplication_);
+
+    if (has_waited_frame_)
+        return true;
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    for (;;)
+    {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0)
+            return false;
+
+        memset(&waited_frame_info_, 0, sizeof(waited_frame_info_));
+        waited_resource_.Reset();
+
+        HRESULT hr = duplication_->AcquireNextFrame(static_cast<UINT>(remaining.count()),
+                                                    &waited_frame_info_,
+                                                    waited_resource_.GetAddressOf());
+        if (hr == DXGI_ERROR_WAIT_TIMEOUT)
+            return false;
+
+        if (FAILED(hr))
+        {
+            // The error (for example, a lost access on a switch of the desktop) is handled by the
+            // next duplicate().
+            waited_resource_.Reset();
+            return true;
+        }
+
+        if (waited_frame_info_.AccumulatedFrames > 0 ||
+            waited_frame_info_.PointerShapeBufferSize > 0)
+        {
+            has_waited_frame_ = true;
+            return true;
+        }
+
+        // Only the pointer is moved. Its position is sent apart from the frames.
+        waited_resource_.Reset();
+        if (!releaseFrame())
+            return true;
+    }
+}
+
 Rect DxgiOutputDuplicator::translatedDesktopRect(const Point& offset) const
 {
     Rect result(Rect::makeSize(desktopSize()));
@@ -315,9 +415,11 @@ Rect DxgiOutputDuplicator::untranslatedDesktopRect() const
 }
 
 void DxgiOutputDuplicator::detectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
-                                               Region* updated_region)
+                                               Region* updated_region,
+                                               Frame::MovedRects* moved_rects,
+                                               Region* moved_region)
 {
-    if (doDetectUpdatedRegion(frame_info, updated_region))
+    if (doDetectUpdatedRegion(frame_info, updated_region, moved_rects, moved_region))
     {
         // Make sure even a region returned by Windows API is out of the scope of
         // desktop_rect_, we still won't export it to the target DesktopFrame.
@@ -326,14 +428,23 @@ void DxgiOutputDuplicator::detectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO& fr
     else
     {
         updated_region->setRect(untranslatedDesktopRect());
+        moved_rects->clear();
+        moved_region->clear();
     }
 }
 
 bool DxgiOutputDuplicator::doDetectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
-                                                 Region* updated_region)
+                                                 Region* updated_region,
+                                                 Frame::MovedRects* moved_rects,
+                                                 Region* moved_region)
 {
     DCHECK(updated_region);
+    DCHECK(moved_rects);
+    DCHECK(moved_region);
+
     updated_region->clear();
+    moved_rects->clear();
+    moved_region->clear();
 
     if (frame_info.TotalMetadataBufferSize == 0)
     {
@@ -401,6 +512,18 @@ bool DxgiOutputDuplicator::doDetectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO&
                                           move_rects->DestinationRect.right,
                                           move_rects->DestinationRect.bottom),
                            unrotated_size_, rotation_));
+
+            // Moves of a rotated screen are sent as updated areas.
+            if (rotation_ == Rotation::CLOCK_WISE_0)
+            {
+                Frame::MovedRect moved_rect;
+                moved_rect.src_pos = Point(move_rects->SourcePoint.x, move_rects->SourcePoint.y);
+                moved_rect.dest_rect = Rect::makeLTRB(move_rects->DestinationRect.left,
+                                                      move_rects->DestinationRect.top,
+                                                      move_rects->DestinationRect.right,
+                                                      move_rects->DestinationRect.bottom);
+                moved_rects->push_back(moved_rect);
+            }
         }
         else
         {
@@ -415,17 +538,57 @@ bool DxgiOutputDuplicator::doDetectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO&
         --move_rects_count;
     }
 
+    Region dirty_region;
+
     while (dirty_rects_count > 0)
     {
-        updated_region->addRect(rotateRect(
+        const Rect dirty_rect = rotateRect(
             Rect::makeLTRB(dirty_rects->left, dirty_rects->top,
                            dirty_rects->right, dirty_rects->bottom),
-            unrotated_size_, rotation_));
+            unrotated_size_, rotation_);
+
+        updated_region->addRect(dirty_rect);
+        dirty_region.addRect(dirty_rect);
 
         ++dirty_rects;
         --dirty_rects_count;
     }
 
+    // The receivers apply the moves one after another, so a move must not read pixels written by a
+    // previous one. In this case (and for moves out of the screen) all moves are sent as updated
+    // areas.
+    const Rect desktop_rect = untranslatedDesktopRect();
+    Region written_region;
+
+    for (const auto& moved_rect : *moved_rects)
+    {
+        const Rect src_rect = Rect::makeXYWH(moved_rect.src_pos, moved_rect.dest_rect.size());
+
+        if (!desktop_rect.containsRect(src_rect) ||
+            !desktop_rect.containsRect(moved_rect.dest_rect))
+        {
+            moved_rects->clear();
+            break;
+        }
+
+        Region overlap(src_rect);
+        overlap.intersectWith(written_region);
+        if (!overlap.isEmpty())
+        {
+            moved_rects->clear();
+            break;
+        }
+
+        written_region.addRect(moved_rect.dest_rect);
+    }
+
+    if (!moved_rects->empty())
+    {
+        // Windows applies the dirty rectangles after the moves.
+        moved_region->swap(&written_region);
+        moved_region->subtract(dirty_region);
+    }
+
     return true;
 }
 
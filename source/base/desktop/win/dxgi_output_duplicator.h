@@ -30,6 +30,7 @@
 #include <DXGI1_2.h>
 #include <wrl/client.h>
 
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -66,6 +67,18 @@ public:
     // Returns false in case of a failure.
     bool duplicate(Context* context, const Point& offset, SharedFrame* target);
 
+    // Same as above, but the updated region and the moved rects are added to |target_region| and
+    // |target_moved_rects| instead of |target|. Several outputs can write into the same |target|
+    // in parallel this way, the pixels of the outputs do not overlap.
+    bool duplicate(Context* context, const Point& offset, SharedFrame* target,
+                   Region* target_region, Frame::MovedRects* target_moved_rects);
+
+    // Blocks until Windows presents a new image of the output (or a new shape of the pointer) or
+    // |timeout| passes. Returns true if there is an update. The frame is kept and the next
+    // duplicate() takes it instead of acquiring a new one. Moves of the pointer alone are not
+    // updates.
+    bool waitForFrame(const std::chrono::milliseconds& timeout);
+
     // Returns the desktop rect covered by this DxgiOutputDuplicator.
     const Rect& desktopRect() const { return desktop_rect_; }
 
@@ -84,12 +97,20 @@ public:
 
 private:
     // Calls doDetectUpdatedRegion(). If it fails, this function sets the |updated_region| as
-    // entire untranslatedDesktopRect().
-    void detectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO& frame_info, Region* updated_region);
+    // entire untranslatedDesktopRect() and clears |moved_rects| and |moved_region|.
+    void detectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
+                             Region* updated_region,
+                             Frame::MovedRects* moved_rects,
+                             Region* moved_region);
 
     // Returns untranslated updated region, which are directly returned by Windows APIs. Returns
-    // false in case of a failure.
-    bool doDetectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO& frame_info, Region* updated_region);
+    // false in case of a failure. The |updated_region| includes the sources and destinations of
+    // the moves. The moves which can be sent as copy operations are returned in |moved_rects| and
+    // the destination areas which are not changed after the moves are returned in |moved_region|.
+    bool doDetectUpdatedRegion(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
+                               Region* updated_region,
+                               Frame::MovedRects* moved_rects,
+                               Region* moved_region);
 
     bool releaseFrame();
 
@@ -130,6 +151,11 @@ private:
     std::unique_ptr<SharedFrame> last_frame_;
     Point last_frame_offset_;
 
+    // The frame acquired by waitForFrame() which is not duplicated yet.
+    bool has_waited_frame_ = false;
+    DXGI_OUTDUPL_FRAME_INFO waited_frame_info_;
+    Microsoft::WRL::ComPtr<IDXGIResource> waited_resource_;
+
     int64_t num_frames_captured_ = 0;
     Desktop desktop_;
 };
@@ -50,7 +50,8 @@ public:
 DxgiTexture::DxgiTexture() = default;
 DxgiTexture::~DxgiTexture() = default;
 
-bool DxgiTexture::copyFrom(const DXGI_OUTDUPL_FRAME_INFO& frame_info, IDXGIResource* resource)
+bool DxgiTexture::copyFrom(const DXGI_OUTDUPL_FRAME_INFO& frame_info, IDXGIResource* resource,
+                           const Region& region)
 {
     DCHECK_GT(frame_info.AccumulatedFrames, 0u);
     DCHECK(resource);
@@ -71,7 +72,7 @@ bool DxgiTexture::copyFrom(const DXGI_OUTDUPL_FRAME_INFO& frame_info, IDXGIResou
 
     desktop_size_.set(desc.Width, desc.Height);
 
-    return copyFromTexture(frame_info, texture.Get());
+    return copyFromTexture(frame_info, texture.Get(), region);
 }
 
 const Frame& DxgiTexture::asDesktopFrame()
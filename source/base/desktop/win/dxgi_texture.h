@@ -37,9 +37,11 @@ public:
     DxgiTexture();
     virtual ~DxgiTexture();
 
-    // Copies selected regions of a frame represented by frame_info and resource.
+    // Copies selected regions of a frame represented by frame_info and resource. Only the pixels
+    // in |region| (in the coordinates of the texture) are guaranteed to be valid in bits().
     // Returns false if anything wrong.
-    bool copyFrom(const DXGI_OUTDUPL_FRAME_INFO& frame_info, IDXGIResource* resource);
+    bool copyFrom(const DXGI_OUTDUPL_FRAME_INFO& frame_info, IDXGIResource* resource,
+                  const Region& region);
 
     const Size& desktopSize() const { return desktop_size_; }
     uint8_t* bits() const { return static_cast<uint8_t*>(rect_.pBits); }
@@ -60,7 +62,8 @@ protected:
     DXGI_MAPPED_RECT* rect();
 
     virtual bool copyFromTexture(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
-                                 ID3D11Texture2D* texture) = 0;
+                                 ID3D11Texture2D* texture,
+                                 const Region& region) = 0;
 
     virtual bool doRelease() = 0;
 
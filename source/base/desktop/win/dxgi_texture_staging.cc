@@ -28,6 +28,12 @@ using Microsoft::WRL::ComPtr;
 
 namespace base {
 
+namespace {
+
+const int kMaxCopyRects = 64;
+
+} // namespace
+
 DxgiTextureStaging::DxgiTextureStaging(const D3dDevice& device)
     : device_(device)
 {
@@ -92,6 +98,56 @@ bool DxgiTextureStaging::initializeStage(ID3D11Texture2D* texture)
     return true;
 }
 
+void DxgiTextureStaging::copyRegionToStage(ID3D11Texture2D* texture, const Region& region)
+{
+    D3D11_TEXTURE2D_DESC desc = { 0 };
+    texture->GetDesc(&desc);
+
+    const Rect texture_rect = Rect::makeWH(desc.Width, desc.Height);
+
+    int rect_count = 0;
+    int64_t area = 0;
+
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+    {
+        Rect rect = it.rect();
+        rect.intersectWith(texture_rect);
+
+        ++rect_count;
+        area += static_cast<int64_t>(rect.width()) * rect.height();
+    }
+
+    // Only the changed areas are read back from the GPU. Above a certain count of rectangles the
+    // cost of the separate copy commands is higher than the saved bandwidth.
+    const int64_t texture_area = static_cast<int64_t>(desc.Width) * desc.Height;
+    if (rect_count > kMaxCopyRects || area * 2 > texture_area)
+    {
+        device_.context()->CopyResource(static_cast<ID3D11Resource*>(stage_.Get()),
+                                        static_cast<ID3D11Resource*>(texture));
+        return;
+    }
+
+    for (Region::Iterator it(region); !it.isAtEnd(); it.advance())
+    {
+        Rect rect = it.rect();
+        rect.intersectWith(texture_rect);
+        if (rect.isEmpty())
+            continue;
+
+        D3D11_BOX box;
+        box.left = static_cast<UINT>(rect.left());
+        box.top = static_cast<UINT>(rect.top());
+        box.front = 0;
+        box.right = static_cast<UINT>(rect.right());
+        box.bottom = static_cast<UINT>(rect.bottom());
+        box.back = 1;
+
+        device_.context()->CopySubresourceRegion(
+            static_cast<ID3D11Resource*>(stage_.Get()), 0, box.left, box.top, 0,
+            static_cast<ID3D11Resource*>(texture), 0, &box);
+    }
+}
+
 void DxgiTextureStaging::assertStageAndSurfaceAreSameObject()
 {
     ComPtr<IUnknown> left;
@@ -106,7 +162,8 @@ void DxgiTextureStaging::assertStageAndSurfaceAreSameObject()
 }
 
 bool DxgiTextureStaging::copyFromTexture(const DXGI_OUTDUPL_FRAME_INFO& frame_info,
-                                         ID3D11Texture2D* texture)
+                                         ID3D11Texture2D* texture,
+                                         const Region& region)
 {
     DCHECK_GT(frame_info.AccumulatedFrames, 0u);
     DCHECK(texture);
@@ -116,8 +173,7 @@ bool DxgiTextureStaging::copyFromTexture(const DXGI_OUTDUPL_FRAME_INFO& frame_in
     if (!initializeStage(texture))
         return false;
 
-    device_.context()->CopyResource(static_cast<ID3D11Resource*>(stage_.Get()),
-                                    static_cast<ID3D11Resource*>(texture));
+    copyRegionToStage(texture, region);
 
     *rect() = { 0 };
 
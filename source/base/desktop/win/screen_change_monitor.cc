@@ -0,0 +1,156 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/desktop/win/screen_change_monitor.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+
+namespace base {
+
+namespace {
+
+// The display configuration has no WinEvent, it is checked with this interval.
+const std::chrono::milliseconds kDisplayCheckInterval{ 500 };
+
+struct EventRange
+{
+    DWORD min;
+    DWORD max;
+};
+
+const EventRange kEventRanges[] =
+{
+    { EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND },
+    { EVENT_SYSTEM_MOVESIZESTART, EVENT_SYSTEM_MINIMIZEEND },
+    // Create, destroy, show, hide and reorder.
+    { EVENT_OBJECT_CREATE, EVENT_OBJECT_REORDER },
+    // State, location (including the caret), name, description and value change.
+    { EVENT_OBJECT_STATECHANGE, EVENT_OBJECT_VALUECHANGE },
+    { EVENT_OBJECT_CONTENTSCROLLED, EVENT_OBJECT_CONTENTSCROLLED }
+};
+
+// The hooks are called on the thread of the monitor.
+thread_local ScreenChangeMonitor* current_monitor = nullptr;
+
+} // namespace
+
+ScreenChangeMonitor::ScreenChangeMonitor()
+    : self_(std::make_shared<ScreenChangeMonitor*>(this)),
+      thread_(std::make_unique<Thread>())
+{
+    // Nothing
+}
+
+ScreenChangeMonitor::~ScreenChangeMonitor()
+{
+    thread_->stop();
+}
+
+void ScreenChangeMonitor::start(std::shared_ptr<TaskRunner> caller_task_runner,
+                                Delegate* delegate)
+{
+    caller_task_runner_ = std::move(caller_task_runner);
+    delegate_ = delegate;
+
+    DCHECK(caller_task_runner_);
+    DCHECK(delegate_);
+
+    // The out-of-context hooks are delivered through the message queue of the thread.
+    thread_->start(MessageLoop::Type::WIN, this);
+}
+
+void ScreenChangeMonitor::onBeforeThreadRunning()
+{
+    current_monitor = this;
+
+    for (const auto& range : kEventRanges)
+    {
+        HWINEVENTHOOK hook = SetWinEventHook(range.min, range.max, nullptr, winEventProc, 0, 0,
+                                             WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+        if (!hook)
+        {
+            PLOG(LS_WARNING) << "SetWinEventHook failed";
+            continue;
+        }
+
+        hooks_.push_back(hook);
+    }
+
+    display_timer_ = std::make_unique<WaitableTimer>(
+        WaitableTimer::Type::REPEATED, thread_->taskRunner(), WaitableTimer::Precision::COARSE);
+    display_timer_->start(kDisplayCheckInterval,
+                          std::bind(&ScreenChangeMonitor::checkDisplayConfiguration, this));
+}
+
+void ScreenChangeMonitor::onAfterThreadRunning()
+{
+    display_timer_.reset();
+
+    for (HWINEVENTHOOK hook : hooks_)
+        UnhookWinEvent(hook);
+    hooks_.clear();
+
+    current_monitor = nullptr;
+}
+
+// static
+void CALLBACK ScreenChangeMonitor::winEventProc(HWINEVENTHOOK /* hook */, DWORD event,
+                                                HWND /* window */, LONG object_id,
+                                                LONG /* child_id */, DWORD /* event_thread */,
+                                                DWORD /* event_time */)
+{
+    // The cursor is captured separately and moves all the time.
+    if (object_id == OBJID_CURSOR)
+        return;
+
+    if (event == EVENT_OBJECT_LOCATIONCHANGE && object_id != OBJID_WINDOW &&
+        object_id != OBJID_CARET)
+    {
+        return;
+    }
+
+    if (current_monitor)
+        current_monitor->onEvent();
+}
+
+void ScreenChangeMonitor::onEvent()
+{
+    if (report_pending_.exchange(true))
+        return;
+
+    std::weak_ptr<ScreenChangeMonitor*> self = self_;
+
+    caller_task_runner_->postTask([self]()
+    {
+        std::shared_ptr<ScreenChangeMonitor*> monitor = self.lock();
+        if (!monitor)
+            return;
+
+        (*monitor)->report_pending_ = false;
+        (*monitor)->delegate_->onScreenChangeHint();
+    });
+}
+
+void ScreenChangeMonitor::checkDisplayConfiguration()
+{
+    if (display_configuration_monitor_.isChanged())
+        onEvent();
+}
+
+} // namespace base
@@ -0,0 +1,92 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__DESKTOP__WIN__SCREEN_CHANGE_MONITOR_H
+#define BASE__DESKTOP__WIN__SCREEN_CHANGE_MONITOR_H
+
+#include "base/desktop/win/display_configuration_monitor.h"
+#include "base/threading/thread.h"
+#include "base/waitable_timer.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <windows.h>
+
+namespace base {
+
+class TaskRunner;
+
+// Reports the events which may change the screen: windows are shown, moved or reordered, their
+// contents are changed, the caret blinks, the display configuration is changed. The events are
+// received by WinEvent hooks on a separate thread with a message loop. A burst of the events is
+// reported once, until the delegate receives the previous report. The movements of the mouse
+// cursor are not reported.
+//
+// The events of the applications which draw without them (video players, games) are not
+// reported at all, so the screen must still be polled from time to time.
+class ScreenChangeMonitor : public Thread::Delegate
+{
+public:
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        // Called on the thread of |caller_task_runner|.
+        virtual void onScreenChangeHint() = 0;
+    };
+
+    ScreenChangeMonitor();
+    ~ScreenChangeMonitor();
+
+    void start(std::shared_ptr<TaskRunner> caller_task_runner, Delegate* delegate);
+
+protected:
+    // Thread::Delegate implementation.
+    void onBeforeThreadRunning() override;
+    void onAfterThreadRunning() override;
+
+private:
+    static void CALLBACK winEventProc(HWINEVENTHOOK hook, DWORD event, HWND window,
+                                      LONG object_id, LONG child_id, DWORD event_thread,
+                                      DWORD event_time);
+    void onEvent();
+    void checkDisplayConfiguration();
+
+    Delegate* delegate_ = nullptr;
+    std::shared_ptr<TaskRunner> caller_task_runner_;
+
+    // The reports posted to the caller are dropped after the monitor is destroyed.
+    std::shared_ptr<ScreenChangeMonitor*> self_;
+
+    std::unique_ptr<Thread> thread_;
+    std::vector<HWINEVENTHOOK> hooks_;
+    std::unique_ptr<WaitableTimer> display_timer_;
+    DisplayConfigurationMonitor display_configuration_monitor_;
+
+    // True from a report until the delegate receives it.
+    std::atomic_bool report_pending_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(ScreenChangeMonitor);
+};
+
+} // namespace base
+
+#endif // BASE__DESKTOP__WIN__SCREEN_CHANGE_MONITOR_H
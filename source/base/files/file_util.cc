@@ -18,8 +18,25 @@
 
 #include "base/files/file_util.h"
 
+#include "base/logging.h"
+#include "base/process_handle.h"
+#include "base/strings/string_number_conversions.h"
+#include "build/build_config.h"
+
+#include <atomic>
 #include <fstream>
 
+#if defined(OS_WIN)
+#include "base/win/scoped_object.h"
+#include <Windows.h>
+#endif // defined(OS_WIN)
+
+#if defined(OS_POSIX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // defined(OS_POSIX)
+
 namespace base {
 
 namespace {
@@ -47,6 +64,122 @@ bool readFileT(const std::filesystem::path& filename, Container* buffer)
     return !stream.fail();
 }
 
+std::filesystem::path tempFilePath(const std::filesystem::path& filename)
+{
+    static std::atomic_uint32_t last_number { 0 };
+
+    // The name is unique within the process and between processes, so several writers of the same
+    // file do not overwrite each other's temporary files.
+    std::filesystem::path temp_path(filename);
+    temp_path += ".";
+    temp_path += numberToString(currentProcessId());
+    temp_path += ".";
+    temp_path += numberToString(++last_number);
+    temp_path += ".tmp";
+    return temp_path;
+}
+
+#if defined(OS_WIN)
+
+bool writeAndFlush(const std::filesystem::path& filename, std::string_view buffer)
+{
+    ScopedHandle file(CreateFileW(filename.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr));
+    if (!file.isValid())
+    {
+        PLOG(LS_ERROR) << "CreateFileW failed";
+        return false;
+    }
+
+    DWORD written = 0;
+    if (!WriteFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &written, nullptr) ||
+        written != buffer.size())
+    {
+        PLOG(LS_ERROR) << "WriteFile failed";
+        return false;
+    }
+
+    if (!FlushFileBuffers(file))
+    {
+        PLOG(LS_ERROR) << "FlushFileBuffers failed";
+        return false;
+    }
+
+    return true;
+}
+
+bool replaceFile(const std::filesystem::path& from, const std::filesystem::path& to)
+{
+    // ReplaceFileW keeps the security descriptor and the attributes of the existing file.
+    if (ReplaceFileW(to.c_str(), from.c_str(), nullptr, REPLACEFILE_IGNORE_MERGE_ERRORS,
+                     nullptr, nullptr))
+    {
+        return true;
+    }
+
+    // The other errors mean that the target file exists and could not be replaced, it must not be
+    // overwritten by the move then.
+    if (GetLastError() != ERROR_FILE_NOT_FOUND)
+    {
+        PLOG(LS_ERROR) << "ReplaceFileW failed";
+        return false;
+    }
+
+    // The target file does not exist yet.
+    if (!MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        PLOG(LS_ERROR) << "MoveFileExW failed";
+        return false;
+    }
+
+    return true;
+}
+
+#elif defined(OS_POSIX)
+
+bool writeAndFlush(const std::filesystem::path& filename, std::string_view buffer, mode_t mode)
+{
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    if (fd == -1)
+    {
+        PLOG(LS_ERROR) << "open failed";
+        return false;
+    }
+
+    const char* data = buffer.data();
+    size_t remaining = buffer.size();
+
+    while (remaining)
+    {
+        ssize_t written = write(fd, data, remaining);
+        if (written == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            PLOG(LS_ERROR) << "write failed";
+            close(fd);
+            return false;
+        }
+
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+
+    // Without fsync the rename may reach the disk before the data does and a crash leaves an empty
+    // file.
+    if (fsync(fd) == -1)
+    {
+        PLOG(LS_ERROR) << "fsync failed";
+        close(fd);
+        return false;
+    }
+
+    return close(fd) == 0;
+}
+
+#endif // defined(OS_*)
+
 } // namespace
 
 bool writeFile(const std::filesystem::path& filename, const void* data, size_t size)
@@ -72,6 +205,45 @@ bool writeFile(const std::filesystem::path& filename, std::string_view buffer)
     return writeFile(filename, buffer.data(), buffer.size());
 }
 
+bool writeFileAtomically(const std::filesystem::path& filename, std::string_view buffer)
+{
+    std::filesystem::path temp_path = tempFilePath(filename);
+
+#if defined(OS_WIN)
+    if (!writeAndFlush(temp_path, buffer) || !replaceFile(temp_path, filename))
+    {
+        DeleteFileW(temp_path.c_str());
+        return false;
+    }
+#elif defined(OS_POSIX)
+    mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+
+    struct stat file_stat;
+    if (stat(filename.c_str(), &file_stat) == 0)
+        mode = file_stat.st_mode & 07777;
+
+    if (!writeAndFlush(temp_path, buffer, mode))
+    {
+        unlink(temp_path.c_str());
+        return false;
+    }
+
+    // open() applies the umask, so the permissions of the existing file are set explicitly.
+    chmod(temp_path.c_str(), mode);
+
+    if (rename(temp_path.c_str(), filename.c_str()) == -1)
+    {
+        PLOG(LS_ERROR) << "rename failed";
+        unlink(temp_path.c_str());
+        return false;
+    }
+#else
+#error Not implemented
+#endif
+
+    return true;
+}
+
 bool readFile(const std::filesystem::path& filename, ByteArray* buffer)
 {
     return readFileT(filename, buffer);
@@ -29,6 +29,11 @@ bool writeFile(const std::filesystem::path& filename, const void* data, size_t s
 bool writeFile(const std::filesystem::path& filename, const ByteArray& buffer);
 bool writeFile(const std::filesystem::path& filename, std::string_view buffer);
 
+// Writes |buffer| to a temporary file in the same directory and then renames it to |filename|.
+// Readers see either the old or the new contents of the file, never a partially written file.
+// If the file already exists, its permissions are preserved.
+bool writeFileAtomically(const std::filesystem::path& filename, std::string_view buffer);
+
 bool readFile(const std::filesystem::path& filename, ByteArray* buffer);
 bool readFile(const std::filesystem::path& filename, std::string* buffer);
 
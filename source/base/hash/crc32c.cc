@@ -0,0 +1,124 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/hash/crc32c.h"
+
+#include "base/cpuid_util.h"
+#include "base/logging.h"
+#include "base/hash/crc32c_arm64.h"
+#include "base/hash/crc32c_sse42.h"
+
+#include <array>
+#include <cstring>
+
+namespace base {
+
+namespace {
+
+using Crc32cFunc = uint32_t(*)(uint32_t crc, const void* data, size_t size);
+
+// Reversed Castagnoli polynomial.
+constexpr uint32_t kPolynomial = 0x82F63B78;
+
+using Crc32cTables = std::array<std::array<uint32_t, 256>, 8>;
+
+// Tables for the "slicing-by-8" algorithm: |tables[k][i]| is the CRC of byte |i| followed by |k|
+// zero bytes, so eight bytes are processed with eight independent lookups.
+constexpr Crc32cTables makeTables()
+{
+    Crc32cTables tables {};
+
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; ++j)
+            crc = (crc & 1) ? (kPolynomial ^ (crc >> 1)) : (crc >> 1);
+        tables[0][i] = crc;
+    }
+
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        for (size_t k = 1; k < tables.size(); ++k)
+            tables[k][i] = tables[0][tables[k - 1][i] & 0xFF] ^ (tables[k - 1][i] >> 8);
+    }
+
+    return tables;
+}
+
+constexpr Crc32cTables kTables = makeTables();
+
+Crc32cFunc crc32cFunction()
+{
+#if defined(ARCH_CPU_X86_FAMILY)
+    if (CpuidUtil::hasSse42())
+    {
+        LOG(LS_INFO) << "SSE4.2 CRC-32C loaded";
+        return crc32c_SSE42;
+    }
+#elif defined(ARCH_CPU_ARM64)
+    if (hasCrc32cARM64())
+    {
+        LOG(LS_INFO) << "ARM64 CRC-32C loaded";
+        return crc32c_ARM64;
+    }
+#endif // defined(ARCH_CPU_*)
+
+    LOG(LS_INFO) << "C CRC-32C loaded";
+    return crc32c_C;
+}
+
+} // namespace
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t size)
+{
+    static const Crc32cFunc func = crc32cFunction();
+    return func(crc, data, size);
+}
+
+uint32_t crc32c_C(uint32_t crc, const void* data, size_t size)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    crc = ~crc;
+
+    for (; size >= 8; size -= 8, bytes += 8)
+    {
+        uint32_t low;
+        uint32_t high;
+        memcpy(&low, bytes, sizeof(low));
+        memcpy(&high, bytes + 4, sizeof(high));
+
+        // The words are little-endian (as on all supported processors).
+        low ^= crc;
+
+        crc = kTables[7][low & 0xFF] ^
+              kTables[6][(low >> 8) & 0xFF] ^
+              kTables[5][(low >> 16) & 0xFF] ^
+              kTables[4][low >> 24] ^
+              kTables[3][high & 0xFF] ^
+              kTables[2][(high >> 8) & 0xFF] ^
+              kTables[1][(high >> 16) & 0xFF] ^
+              kTables[0][high >> 24];
+    }
+
+    while (size--)
+        crc = kTables[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+} // namespace base
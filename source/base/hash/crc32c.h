@@ -0,0 +1,38 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__HASH__CRC32C_H
+#define BASE__HASH__CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace base {
+
+// Calculates CRC-32C (Castagnoli polynomial). Unlike crc32(), it is the standard checksum (as in
+// iSCSI and ext4) and the processors compute it with the dedicated instructions (SSE 4.2 on x86,
+// the CRC extension on ARM64), which are used when available. |crc| is zero for new data or the
+// result of the previous call to continue the calculation.
+uint32_t crc32c(uint32_t crc, const void* data, size_t size);
+
+// Portable implementation. Used if the processor has no CRC instructions.
+uint32_t crc32c_C(uint32_t crc, const void* data, size_t size);
+
+} // namespace base
+
+#endif // BASE__HASH__CRC32C_H
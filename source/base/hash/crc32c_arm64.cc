@@ -0,0 +1,80 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/hash/crc32c_arm64.h"
+
+#if defined(ARCH_CPU_ARM64)
+
+#include <cstring>
+
+#if defined(OS_WIN)
+#include <windows.h>
+#include <arm64_neon.h>
+#else
+#include <arm_acle.h>
+#endif // defined(OS_WIN)
+
+#if defined(OS_LINUX)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif // defined(OS_LINUX)
+
+namespace base {
+
+bool hasCrc32cARM64()
+{
+#if defined(OS_WIN)
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != FALSE;
+#elif defined(OS_LINUX)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#elif defined(OS_MAC)
+    // All Apple processors have the extension.
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t crc32c_ARM64(uint32_t crc, const void* data, size_t size)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    crc = ~crc;
+
+    // Process the bytes before the first aligned word one by one.
+    while (size && (reinterpret_cast<uintptr_t>(bytes) & 7))
+    {
+        crc = __crc32cb(crc, *bytes++);
+        --size;
+    }
+
+    for (; size >= 8; size -= 8, bytes += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+
+    while (size--)
+        crc = __crc32cb(crc, *bytes++);
+
+    return ~crc;
+}
+
+} // namespace base
+
+#endif // defined(ARCH_CPU_ARM64)
@@ -0,0 +1,40 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__HASH__CRC32C_ARM64_H
+#define BASE__HASH__CRC32C_ARM64_H
+
+#include "build/build_config.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace base {
+
+#if defined(ARCH_CPU_ARM64)
+
+// Returns true if the processor has the CRC extension (it is optional before ARMv8.1).
+bool hasCrc32cARM64();
+
+uint32_t crc32c_ARM64(uint32_t crc, const void* data, size_t size);
+
+#endif // defined(ARCH_CPU_ARM64)
+
+} // namespace base
+
+#endif // BASE__HASH__CRC32C_ARM64_H
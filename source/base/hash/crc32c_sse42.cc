@@ -0,0 +1,68 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/hash/crc32c_sse42.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+#include <cstring>
+#include <nmmintrin.h>
+
+namespace base {
+
+uint32_t crc32c_SSE42(uint32_t crc, const void* data, size_t size)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    crc = ~crc;
+
+    // Process the bytes before the first aligned word one by one.
+    while (size && (reinterpret_cast<uintptr_t>(bytes) & 7))
+    {
+        crc = _mm_crc32_u8(crc, *bytes++);
+        --size;
+    }
+
+#if defined(ARCH_CPU_X86_64)
+    uint64_t crc64 = crc;
+
+    for (; size >= 8; size -= 8, bytes += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    crc = static_cast<uint32_t>(crc64);
+#endif // defined(ARCH_CPU_X86_64)
+
+    for (; size >= 4; size -= 4, bytes += 4)
+    {
+        uint32_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+
+    while (size--)
+        crc = _mm_crc32_u8(crc, *bytes++);
+
+    return ~crc;
+}
+
+} // namespace base
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
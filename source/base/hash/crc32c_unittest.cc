@@ -0,0 +1,135 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/hash/crc32c.h"
+#include "base/hash/crc32c_arm64.h"
+#include "base/hash/crc32c_sse42.h"
+#include "base/cpuid_util.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+std::vector<uint8_t> makeData(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+    return data;
+}
+
+using Crc32cFunc = uint32_t(*)(uint32_t crc, const void* data, size_t size);
+
+void testKnownValues(Crc32cFunc func)
+{
+    // Values from RFC 3720 (iSCSI), B.4.
+    uint8_t buffer[32];
+
+    memset(buffer, 0, sizeof(buffer));
+    EXPECT_EQ(func(0, buffer, sizeof(buffer)), 0x8A9136AAu);
+
+    memset(buffer, 0xFF, sizeof(buffer));
+    EXPECT_EQ(func(0, buffer, sizeof(buffer)), 0x62A8AB43u);
+
+    for (size_t i = 0; i < sizeof(buffer); ++i)
+        buffer[i] = static_cast<uint8_t>(i);
+    EXPECT_EQ(func(0, buffer, sizeof(buffer)), 0x46DD794Eu);
+
+    EXPECT_EQ(func(0, "123456789", 9), 0xE3069283u);
+    EXPECT_EQ(func(0, nullptr, 0), 0u);
+}
+
+// Compares with the portable implementation for all alignments and tails and checks that the
+// calculation can be continued.
+void testSameAsC(Crc32cFunc func)
+{
+    const std::vector<uint8_t> data = makeData(1024);
+
+    for (size_t offset = 0; offset < 8; ++offset)
+    {
+        for (size_t size = 0; size < 100; ++size)
+        {
+            const uint8_t* bytes = data.data() + offset;
+            const uint32_t expected = crc32c_C(0, bytes, size);
+
+            EXPECT_EQ(func(0, bytes, size), expected);
+            EXPECT_EQ(func(func(0, bytes, size / 3), bytes + size / 3, size - size / 3), expected);
+        }
+    }
+
+    EXPECT_EQ(func(0, data.data(), data.size()), crc32c_C(0, data.data(), data.size()));
+}
+
+} // namespace
+
+TEST(Crc32cTest, KnownValues)
+{
+    testKnownValues(crc32c);
+    testKnownValues(crc32c_C);
+}
+
+TEST(Crc32cTest, Continuation)
+{
+    const std::vector<uint8_t> data = makeData(4096);
+    const uint32_t expected = crc32c(0, data.data(), data.size());
+
+    uint32_t crc = 0;
+    for (size_t i = 0; i < data.size(); i += 100)
+        crc = crc32c(crc, data.data() + i, std::min(size_t(100), data.size() - i));
+
+    EXPECT_EQ(crc, expected);
+}
+
+TEST(Crc32cTest, SameAsC)
+{
+    testSameAsC(crc32c);
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+
+TEST(Crc32cTest, SSE42)
+{
+    if (!CpuidUtil::hasSse42())
+        GTEST_SKIP() << "SSE 4.2 is not supported";
+
+    testKnownValues(crc32c_SSE42);
+    testSameAsC(crc32c_SSE42);
+}
+
+#endif // defined(ARCH_CPU_X86_FAMILY)
+
+#if defined(ARCH_CPU_ARM64)
+
+TEST(Crc32cTest, ARM64)
+{
+    if (!hasCrc32cARM64())
+        GTEST_SKIP() << "CRC extension is not supported";
+
+    testKnownValues(crc32c_ARM64);
+    testSameAsC(crc32c_ARM64);
+}
+
+#endif // defined(ARCH_CPU_ARM64)
+
+} // namespace base
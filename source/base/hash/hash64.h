@@ -0,0 +1,35 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__HASH__HASH64_H
+#define BASE__HASH__HASH64_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace base {
+
+// Calculates a fast non-cryptographic 64-bit hash of the data (the XXH64 algorithm, so the values
+// match other xxHash implementations). Four independent lanes make it run at several bytes per
+// cycle on any processor. It is not a "secure" hash: it must not be used where an attacker
+// chooses the data and benefits from the collisions.
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+} // namespace base
+
+#endif // BASE__HASH__HASH64_H
@@ -0,0 +1,72 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/hash/hash64.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+namespace base {
+
+TEST(Hash64Test, KnownValues)
+{
+    // Values of the reference implementation of XXH64.
+    EXPECT_EQ(hash64(nullptr, 0), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(hash64("a", 1), 0xD24EC4F1A98C6E5BULL);
+    EXPECT_EQ(hash64("abc", 3), 0x44BC2CF5AD770999ULL);
+
+    const char kText[] = "Nobody inspects the spammish repetition";
+    EXPECT_EQ(hash64(kText, strlen(kText)), 0xFBCEA83C8A378BF1ULL);
+}
+
+TEST(Hash64Test, Seed)
+{
+    const char kText[] = "Nobody inspects the spammish repetition";
+    const size_t size = strlen(kText);
+
+    EXPECT_EQ(hash64(kText, size, 1), hash64(kText, size, 1));
+    EXPECT_NE(hash64(kText, size, 1), hash64(kText, size, 0));
+}
+
+TEST(Hash64Test, AllSizesDiffer)
+{
+    std::vector<uint8_t> data(256);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+
+    // Every prefix takes its own path through the lanes and the tail, so all hashes are different.
+    std::set<uint64_t> hashes;
+    for (size_t size = 0; size <= data.size(); ++size)
+        hashes.insert(hash64(data.data(), size));
+
+    EXPECT_EQ(hashes.size(), data.size() + 1);
+
+    // A change of any byte changes the hash.
+    const uint64_t original = hash64(data.data(), data.size());
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] ^= 1;
+        EXPECT_NE(hash64(data.data(), data.size()), original) << "Byte " << i;
+        data[i] ^= 1;
+    }
+}
+
+} // namespace base
@@ -0,0 +1,73 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/hash/crc32c.h"
+#include "base/hash/hash64.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace base {
+
+namespace {
+
+std::string makeData(size_t size)
+{
+    std::string data(size, 0);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = static_cast<char>(i * 31 + 7);
+    return data;
+}
+
+void BM_Crc32c(benchmark::State& state)
+{
+    const std::string input = makeData(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(crc32c(0, input.data(), input.size()));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Crc32c)->Arg(64)->Arg(4096)->Arg(65536);
+
+void BM_Crc32c_C(benchmark::State& state)
+{
+    const std::string input = makeData(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(crc32c_C(0, input.data(), input.size()));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Crc32c_C)->Arg(64)->Arg(4096)->Arg(65536);
+
+void BM_Hash64(benchmark::State& state)
+{
+    const std::string input = makeData(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(hash64(input.data(), input.size()));
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Hash64)->Arg(64)->Arg(4096)->Arg(65536);
+
+} // namespace
+
+} // namespace base
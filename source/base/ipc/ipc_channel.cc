@@ -21,13 +21,16 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/ipc/ipc_channel_proxy.h"
+#include "base/memory/buffer_pool.h"
 #include "base/message_loop/message_loop.h"
 #include "base/message_loop/message_pump_asio.h"
 #include "base/strings/unicode.h"
+#include "base/trace_event.h"
 
 #include <asio/read.hpp>
 #include <asio/write.hpp>
 
+#include <array>
 #include <functional>
 
 #if defined(OS_WIN)
@@ -41,6 +44,9 @@ namespace {
 
 const uint32_t kMaxMessageSize = 16 * 1024 * 1024; // 16MB
 
+// Messages smaller than this are coalesced into one write operation up to this size in total.
+const size_t kMaxWriteBatchSize = 64 * 1024; // 64KB
+
 #if defined(OS_WIN)
 
 const char16_t kPipeNamePrefix[] = u"\\\\.\\pipe\\aspia.";
@@ -251,15 +257,14 @@ void IpcChannel::resume()
 
 void IpcChannel::send(ByteArray&& buffer)
 {
-    DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
-
-    const bool schedule_write = write_queue_.empty();
-
-    // Add the buffer to the queue for sending.
-    write_queue_.emplace(std::move(buffer));
+    addWriteTask(WriteTask(WriteTask::Type::USER_DATA, WriteTask::Priority::NORMAL,
+                           std::move(buffer)));
+}
 
-    if (schedule_write)
-        doWrite();
+void IpcChannel::send(SharedByteArray&& buffer)
+{
+    addWriteTask(WriteTask(WriteTask::Type::USER_DATA, WriteTask::Priority::NORMAL,
+                           std::move(buffer)));
 }
 
 std::filesystem::path IpcChannel::peerFilePath() const
@@ -320,52 +325,112 @@ void IpcChannel::onErrorOccurred(const Location& location, const std::error_code
     }
 }
 
+void IpcChannel::addWriteTask(WriteTask&& task)
+{
+    DCHECK_CALLED_ON_VALID_THREAD(thread_checker_);
+
+    const bool schedule_write = write_queue_.empty() && !write_pending_;
+
+    // Add the buffer to the queue for sending.
+    write_queue_.emplace(std::move(task));
+
+    if (schedule_write)
+        doWrite();
+}
+
 void IpcChannel::doWrite()
 {
-    write_size_ = write_queue_.front().size();
+    TRACE_EVENT("ipc", "IpcChannel::doWrite");
 
-    if (!write_size_ || write_size_ > kMaxMessageSize)
-    {
-        onErrorOccurred(FROM_HERE, asio::error::message_size);
-        return;
-    }
+    DCHECK(!write_pending_);
+    DCHECK(!write_queue_.empty());
 
-    asio::async_write(stream_, asio::buffer(&write_size_, sizeof(write_size_)),
-        [this](const std::error_code& error_code, size_t bytes_transferred)
+    std::array<asio::const_buffer, 2> buffers;
+
+    if (write_queue_.front().messageSize() >= kMaxWriteBatchSize)
     {
-        if (error_code)
+        // A large message is written as it is, without copying.
+        write_message_.emplace(std::move(write_queue_.front()));
+        write_queue_.pop();
+
+        const size_t message_size = write_message_->messageSize();
+        if (message_size > kMaxMessageSize)
         {
-            onErrorOccurred(FROM_HERE, error_code);
+            onErrorOccurred(FROM_HERE, asio::error::message_size);
             return;
         }
 
-        DCHECK_EQ(bytes_transferred, sizeof(write_size_));
-        DCHECK(!write_queue_.empty());
+        write_size_ = static_cast<uint32_t>(message_size);
 
-        const ByteArray& buffer = write_queue_.front();
+        buffers[0] = asio::buffer(&write_size_, sizeof(write_size_));
+        buffers[1] = asio::buffer(write_message_->message(), message_size);
+    }
+    else
+    {
+        // The small messages queued one after another (for example, a burst of UI or clipboard
+        // messages) are copied together with their sizes into one buffer. The buffer is sent with
+        // a single write operation.
+        write_buffer_.clear();
 
-        // Send the buffer to the recipient.
-        asio::async_write(stream_, asio::buffer(buffer.data(), buffer.size()),
-            [this](const std::error_code& error_code, size_t bytes_transferred)
+        do
         {
-            if (error_code)
+            WriteTask& task = write_queue_.front();
+
+            if (!task.messageSize())
             {
-                onErrorOccurred(FROM_HERE, error_code);
+                onErrorOccurred(FROM_HERE, asio::error::message_size);
                 return;
             }
 
-            DCHECK_EQ(bytes_transferred, write_size_);
-            DCHECK(!write_queue_.empty());
+            if (!write_buffer_.empty() &&
+                write_buffer_.size() + sizeof(uint32_t) + task.messageSize() > kMaxWriteBatchSize)
+            {
+                break;
+            }
+
+            const uint32_t message_size = static_cast<uint32_t>(task.messageSize());
+            const uint8_t* size_data = reinterpret_cast<const uint8_t*>(&message_size);
 
-            // Delete the sent message from the queue.
+            write_buffer_.insert(write_buffer_.end(), size_data, size_data + sizeof(message_size));
+            write_buffer_.insert(write_buffer_.end(), task.message(), task.message() + message_size);
+
+            // The message is copied, its buffer is returned to the pool.
+            BufferPool::instance()->release(std::move(task.data()));
             write_queue_.pop();
 
-            // If the queue is not empty, then we send the following message.
-            if (write_queue_.empty() && !proxy_->reloadWriteQueue(&write_queue_))
-                return;
+            if (write_queue_.empty())
+                proxy_->reloadWriteQueue(&write_queue_);
+        }
+        while (!write_queue_.empty() && write_queue_.front().messageSize() < kMaxWriteBatchSize);
 
-            doWrite();
-        });
+        buffers[0] = asio::buffer(write_buffer_.data(), write_buffer_.size());
+    }
+
+    write_pending_ = true;
+
+    asio::async_write(stream_, buffers,
+        [this](const std::error_code& error_code, size_t /* bytes_transferred */)
+    {
+        write_pending_ = false;
+
+        if (error_code)
+        {
+            onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        if (write_message_)
+        {
+            // The buffer of the large message is returned to the pool.
+            BufferPool::instance()->release(std::move(write_message_->data()));
+            write_message_.reset();
+        }
+
+        // If the queue is not empty, then we send the following messages.
+        if (write_queue_.empty() && !proxy_->reloadWriteQueue(&write_queue_))
+            return;
+
+        doWrite();
     });
 }
 
@@ -388,13 +453,16 @@ void IpcChannel::doReadMessage()
             return;
         }
 
+        // If the reserved buffer size is less, then exchange it for a larger one from the pool.
         if (read_buffer_.capacity() < read_size_)
         {
-            read_buffer_.clear();
-            read_buffer_.reserve(read_size_);
+            BufferPool::instance()->release(std::move(read_buffer_));
+            read_buffer_ = BufferPool::instance()->acquire(read_size_);
+        }
+        else
+        {
+            read_buffer_.resize(read_size_);
         }
-
-        read_buffer_.resize(read_size_);
 
         asio::async_read(stream_, asio::buffer(read_buffer_.data(), read_buffer_.size()),
             [this](const std::error_code& error_code, size_t bytes_transferred)
@@ -424,6 +492,8 @@ void IpcChannel::doReadMessage()
 
 void IpcChannel::onMessageReceived()
 {
+    TRACE_EVENT("ipc", "IpcChannel::onMessageReceived");
+
     if (listener_)
         listener_->onMessageReceived(read_buffer_);
 
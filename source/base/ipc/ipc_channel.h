@@ -22,6 +22,8 @@
 #include "base/process_handle.h"
 #include "base/session_id.h"
 #include "base/memory/byte_array.h"
+#include "base/memory/shared_byte_array.h"
+#include "base/net/write_task.h"
 #include "base/threading/thread_checker.h"
 
 #if defined(OS_WIN)
@@ -31,6 +33,7 @@
 #endif
 
 #include <filesystem>
+#include <optional>
 #include <queue>
 
 namespace base {
@@ -73,6 +76,10 @@ public:
 
     void send(ByteArray&& buffer);
 
+    // Same as the method above, but the buffer can be sent to several channels at once. A large
+    // message is written directly from the shared buffer.
+    void send(SharedByteArray&& buffer);
+
     ProcessId peerProcessId() const { return peer_process_id_; }
     SessionId peerSessionId() const { return peer_session_id_; }
     std::filesystem::path peerFilePath() const;
@@ -91,6 +98,7 @@ private:
     static std::u16string channelName(std::u16string_view channel_id);
 
     void onErrorOccurred(const Location& location, const std::error_code& error_code);
+    void addWriteTask(WriteTask&& task);
     void doWrite();
     void doReadMessage();
     void onMessageReceived();
@@ -104,8 +112,14 @@ private:
     bool is_connected_ = false;
     bool is_paused_ = true;
 
-    std::queue<ByteArray> write_queue_;
+    std::queue<WriteTask> write_queue_;
+
+    // Small messages with their sizes are copied into |write_buffer_| and written together. A
+    // large message is written from |write_message_| after its size |write_size_|.
+    ByteArray write_buffer_;
+    std::optional<WriteTask> write_message_;
     uint32_t write_size_ = 0;
+    bool write_pending_ = false;
 
     uint32_t read_size_ = 0;
     ByteArray read_buffer_;
@@ -31,12 +31,24 @@ IpcChannelProxy::IpcChannelProxy(std::shared_ptr<TaskRunner> task_runner, IpcCha
 }
 
 void IpcChannelProxy::send(ByteArray&& buffer)
+{
+    addWriteTask(WriteTask(WriteTask::Type::USER_DATA, WriteTask::Priority::NORMAL,
+                           std::move(buffer)));
+}
+
+void IpcChannelProxy::send(SharedByteArray&& buffer)
+{
+    addWriteTask(WriteTask(WriteTask::Type::USER_DATA, WriteTask::Priority::NORMAL,
+                           std::move(buffer)));
+}
+
+void IpcChannelProxy::addWriteTask(WriteTask&& task)
 {
     std::scoped_lock lock(incoming_queue_lock_);
 
     bool schedule_write = incoming_queue_.empty();
 
-    incoming_queue_.emplace(std::move(buffer));
+    incoming_queue_.emplace(std::move(task));
 
     if (!schedule_write)
         return;
@@ -57,10 +69,14 @@ void IpcChannelProxy::scheduleWrite()
     if (!reloadWriteQueue(&channel_->write_queue_))
         return;
 
+    // If a write operation is in progress, the queue will be sent after it is completed.
+    if (channel_->write_pending_)
+        return;
+
     channel_->doWrite();
 }
 
-bool IpcChannelProxy::reloadWriteQueue(std::queue<ByteArray>* work_queue)
+bool IpcChannelProxy::reloadWriteQueue(std::queue<WriteTask>* work_queue)
 {
     if (!work_queue->empty())
         return false;
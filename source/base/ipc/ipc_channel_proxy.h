@@ -29,6 +29,7 @@ class IpcChannelProxy : public std::enable_shared_from_this<IpcChannelProxy>
 {
 public:
     void send(ByteArray&& buffer);
+    void send(SharedByteArray&& buffer);
 
 private:
     friend class IpcChannel;
@@ -38,12 +39,13 @@ private:
     void willDestroyCurrentChannel();
 
     void scheduleWrite();
-    bool reloadWriteQueue(std::queue<ByteArray>* work_queue);
+    void addWriteTask(WriteTask&& task);
+    bool reloadWriteQueue(std::queue<WriteTask>* work_queue);
 
     std::shared_ptr<TaskRunner> task_runner_;
     IpcChannel* channel_;
 
-    std::queue<ByteArray> incoming_queue_;
+    std::queue<WriteTask> incoming_queue_;
     std::mutex incoming_queue_lock_;
 
     DISALLOW_COPY_AND_ASSIGN(IpcChannelProxy);
@@ -29,6 +29,15 @@
 #include <AclAPI.h>
 #endif // defined(OS_WIN)
 
+#if defined(OS_POSIX)
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // defined(OS_POSIX)
+
 namespace base {
 
 namespace {
@@ -48,14 +57,14 @@ int createUniqueId()
     return last_id++;
 }
 
+#if defined(OS_WIN)
+
 std::u16string createFilePath(int id)
 {
     static const char16_t kPrefix[] = u"Global\\aspia_";
     return kPrefix + numberToString16(id);
 }
 
-#if defined(OS_WIN)
-
 bool modeToDesiredAccess(SharedMemory::Mode mode, DWORD* desired_access)
 {
     switch (mode)
@@ -159,8 +168,110 @@ bool mapViewOfFile(SharedMemory::Mode mode, HANDLE file, void** memory)
 
 #endif // defined(OS_WIN)
 
+#if defined(OS_POSIX)
+
+// The name must be short enough for macOS (PSHMNAMLEN is 31 characters).
+std::string createFilePath(int id)
+{
+    static const char kPrefix[] = "/aspia_";
+    return kPrefix + numberToString(id);
+}
+
+int modeToProtection(SharedMemory::Mode mode)
+{
+    switch (mode)
+    {
+        case SharedMemory::Mode::READ_ONLY:
+            return PROT_READ;
+
+        case SharedMemory::Mode::READ_WRITE:
+            return PROT_READ | PROT_WRITE;
+
+        default:
+            NOTREACHED();
+            return PROT_NONE;
+    }
+}
+
+bool createSharedMemory(int id, size_t size, SharedMemory::ScopedPlatformHandle* out)
+{
+    const std::string path = createFilePath(id);
+
+    // Only the processes of the same user (and root) can open the memory.
+    SharedMemory::ScopedPlatformHandle file(
+        shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR));
+    if (!file.isValid())
+    {
+        if (errno == EEXIST)
+            LOG(LS_WARNING) << "Already exists shared memory: " << path;
+        else
+            PLOG(LS_WARNING) << "shm_open failed";
+        return false;
+    }
+
+    // The new pages are filled with zeros.
+    if (ftruncate(file, static_cast<off_t>(size)) != 0)
+    {
+        PLOG(LS_WARNING) << "ftruncate failed";
+        shm_unlink(path.c_str());
+        return false;
+    }
+
+    out->swap(file);
+    return true;
+}
+
+bool openSharedMemory(SharedMemory::Mode mode, int id, SharedMemory::ScopedPlatformHandle* out)
+{
+    const int flags = (mode == SharedMemory::Mode::READ_WRITE) ? O_RDWR : O_RDONLY;
+
+    SharedMemory::ScopedPlatformHandle file(shm_open(createFilePath(id).c_str(), flags, 0));
+    if (!file.isValid())
+    {
+        PLOG(LS_WARNING) << "shm_open failed";
+        return false;
+    }
+
+    out->swap(file);
+    return true;
+}
+
+bool mapSharedMemory(SharedMemory::Mode mode, int file, size_t size, void** memory)
+{
+    *memory = mmap(nullptr, size, modeToProtection(mode), MAP_SHARED, file, 0);
+    if (*memory == MAP_FAILED)
+    {
+        PLOG(LS_WARNING) << "mmap failed";
+        *memory = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+#endif // defined(OS_POSIX)
+
 } // namespace
 
+#if defined(OS_POSIX)
+
+void SharedMemoryBase::ScopedPlatformHandle::reset(PlatformHandle handle)
+{
+    if (handle_ != -1)
+        close(handle_);
+
+    handle_ = handle;
+}
+
+SharedMemoryBase::PlatformHandle SharedMemoryBase::ScopedPlatformHandle::release()
+{
+    PlatformHandle handle = handle_;
+    handle_ = -1;
+    return handle;
+}
+
+#endif // defined(OS_POSIX)
+
 #if defined(OS_WIN)
 const SharedMemory::PlatformHandle kInvalidHandle = nullptr;
 #else
@@ -170,11 +281,15 @@ const SharedMemory::PlatformHandle kInvalidHandle = -1;
 SharedMemory::SharedMemory(int id,
                            ScopedPlatformHandle&& handle,
                            void* data,
+                           size_t size,
+                           bool owner,
                            std::shared_ptr<SharedMemoryFactoryProxy> factory_proxy)
     : factory_proxy_(std::move(factory_proxy)),
       handle_(std::move(handle)),
       data_(data),
-      id_(id)
+      size_(size),
+      id_(id),
+      owner_(owner)
 {
     if (factory_proxy_)
         factory_proxy_->onSharedMemoryCreate(id_);
@@ -187,7 +302,13 @@ SharedMemory::~SharedMemory()
 
 #if defined(OS_WIN)
     UnmapViewOfFile(data_);
-#endif // defined(OS_WIN)
+#elif defined(OS_POSIX)
+    munmap(data_, size_);
+
+    // The processes which have already opened the memory keep their mappings.
+    if (owner_)
+        shm_unlink(createFilePath(id_).c_str());
+#endif
 }
 
 // static
@@ -217,7 +338,32 @@ std::unique_ptr<SharedMemory> SharedMemory::create(
     memset(memory, 0, size);
 
     return std::unique_ptr<SharedMemory>(
-        new SharedMemory(id, std::move(file), memory, std::move(factory_proxy)));
+        new SharedMemory(id, std::move(file), memory, size, true, std::move(factory_proxy)));
+#elif defined(OS_POSIX)
+    static const int kRetryCount = 10;
+
+    ScopedPlatformHandle file;
+    int id = -1;
+
+    for (int i = 0; i < kRetryCount; ++i)
+    {
+        id = createUniqueId();
+        if (createSharedMemory(id, size, &file))
+            break;
+    }
+
+    if (!file.isValid())
+        return nullptr;
+
+    void* memory = nullptr;
+    if (!mapSharedMemory(mode, file, size, &memory))
+    {
+        shm_unlink(createFilePath(id).c_str());
+        return nullptr;
+    }
+
+    return std::unique_ptr<SharedMemory>(
+        new SharedMemory(id, std::move(file), memory, size, true, std::move(factory_proxy)));
 #else
     NOTIMPLEMENTED();
     return nullptr;
@@ -238,7 +384,27 @@ std::unique_ptr<SharedMemory> SharedMemory::open(
         return nullptr;
 
     return std::unique_ptr<SharedMemory>(
-        new SharedMemory(id, std::move(file), memory, std::move(factory_proxy)));
+        new SharedMemory(id, std::move(file), memory, 0, false, std::move(factory_proxy)));
+#elif defined(OS_POSIX)
+    ScopedPlatformHandle file;
+    if (!openSharedMemory(mode, id, &file))
+        return nullptr;
+
+    struct stat info;
+    if (fstat(file, &info) != 0)
+    {
+        PLOG(LS_WARNING) << "fstat failed";
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(info.st_size);
+
+    void* memory = nullptr;
+    if (!mapSharedMemory(mode, file, size, &memory))
+        return nullptr;
+
+    return std::unique_ptr<SharedMemory>(
+        new SharedMemory(id, std::move(file), memory, size, false, std::move(factory_proxy)));
 #else
     NOTIMPLEMENTED();
     return nullptr;
@@ -29,6 +29,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <utility>
 
 namespace base {
 
@@ -51,24 +52,43 @@ public:
 #else
     using PlatformHandle = int;
 
+    // Owns a file descriptor and closes it on destruction.
     class ScopedPlatformHandle
     {
     public:
-        ScopedPlatformHandle(PlatformHandle handle)
+        ScopedPlatformHandle() = default;
+        explicit ScopedPlatformHandle(PlatformHandle handle)
             : handle_(handle)
         {
-            NOTIMPLEMENTED();
+            // Nothing
         }
 
-        ~ScopedPlatformHandle()
+        ScopedPlatformHandle(ScopedPlatformHandle&& other) noexcept
         {
-            NOTIMPLEMENTED();
+            swap(other);
         }
 
+        ScopedPlatformHandle& operator=(ScopedPlatformHandle&& other) noexcept
+        {
+            reset(other.release());
+            return *this;
+        }
+
+        ~ScopedPlatformHandle() { reset(); }
+
         PlatformHandle get() const { return handle_; }
+        bool isValid() const { return handle_ != -1; }
+
+        void reset(PlatformHandle handle = -1);
+        PlatformHandle release();
+        void swap(ScopedPlatformHandle& other) noexcept { std::swap(handle_, other.handle_); }
+
+        operator PlatformHandle() const { return handle_; }
 
     private:
-        PlatformHandle handle_;
+        PlatformHandle handle_ = -1;
+
+        DISALLOW_COPY_AND_ASSIGN(ScopedPlatformHandle);
     };
 
 #endif
@@ -99,13 +119,20 @@ private:
     SharedMemory(int id,
                  ScopedPlatformHandle&& handle,
                  void* data,
+                 size_t size,
+                 bool owner,
                  std::shared_ptr<SharedMemoryFactoryProxy> factory_proxy);
 
     std::shared_ptr<SharedMemoryFactoryProxy> factory_proxy_;
     ScopedPlatformHandle handle_;
     void* data_;
+    size_t size_;
     int id_;
 
+    // The memory was created by this instance (not opened). On POSIX systems the owner removes
+    // the name of the memory object when it is destroyed.
+    bool owner_;
+
     DISALLOW_COPY_AND_ASSIGN(SharedMemory);
 };
 
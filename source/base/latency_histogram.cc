@@ -0,0 +1,66 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/latency_histogram.h"
+
+#include <algorithm>
+
+namespace base {
+
+// static
+const std::array<int64_t, LatencyHistogram::kBoundsCount> LatencyHistogram::kUpperBounds =
+    { 1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (auto& count : counts_)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::add(const std::chrono::microseconds& value)
+{
+    const int64_t us = std::max(value.count(), int64_t(0));
+
+    // A value equal to the bound belongs to the bucket of this bound.
+    const size_t bucket = static_cast<size_t>(
+        std::lower_bound(kUpperBounds.begin(), kUpperBounds.end(), us,
+                         [](int64_t bound, int64_t value) { return bound * 1000 < value; }) -
+        kUpperBounds.begin());
+
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(us, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot snapshot;
+
+    snapshot.upper_bounds.assign(kUpperBounds.begin(), kUpperBounds.end());
+    snapshot.counts.reserve(counts_.size());
+
+    for (const auto& count : counts_)
+    {
+        snapshot.counts.emplace_back(count.load(std::memory_order_relaxed));
+        snapshot.count += snapshot.counts.back();
+    }
+
+    snapshot.sum = std::chrono::microseconds(sum_.load(std::memory_order_relaxed));
+    return snapshot;
+}
+
+} // namespace base
@@ -0,0 +1,66 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__LATENCY_HISTOGRAM_H
+#define BASE__LATENCY_HISTOGRAM_H
+
+#include "base/macros_magic.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace base {
+
+// Histogram of latencies with fixed buckets from 1 ms to 10 seconds. The values are accumulated
+// since the creation of the histogram. All methods can be called from any thread.
+class LatencyHistogram
+{
+public:
+    static constexpr size_t kBoundsCount = 13;
+
+    // Upper bounds of the buckets in milliseconds. The last bucket contains all larger values.
+    static const std::array<int64_t, kBoundsCount> kUpperBounds;
+
+    struct Snapshot
+    {
+        std::vector<int64_t> upper_bounds; // Milliseconds.
+        std::vector<uint64_t> counts;      // Not cumulative, one more than |upper_bounds|.
+        std::chrono::microseconds sum { 0 };
+        uint64_t count = 0;
+    };
+
+    LatencyHistogram();
+    ~LatencyHistogram() = default;
+
+    void add(const std::chrono::microseconds& value);
+
+    Snapshot snapshot() const;
+
+private:
+    std::array<std::atomic<uint64_t>, kBoundsCount + 1> counts_;
+    std::atomic<int64_t> sum_ { 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(LatencyHistogram);
+};
+
+} // namespace base
+
+#endif // BASE__LATENCY_HISTOGRAM_H
@@ -23,10 +23,6 @@
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_printf.h"
 
-#if defined(CC_MSVC)
-#include <intrin.h>
-#endif
-
 namespace base {
 
 Location::Location() = default;
@@ -81,15 +77,6 @@ std::string Location::toString(PathType path_type) const
     return stringPrintf("pc:%p", program_counter_);
 }
 
-#if defined(CC_MSVC)
-#define RETURN_ADDRESS() _ReturnAddress()
-#elif defined(CC_GCC) && !defined(OS_NACL)
-#define RETURN_ADDRESS() \
-  __builtin_extract_return_addr(__builtin_return_address(0))
-#else
-#define RETURN_ADDRESS() nullptr
-#endif
-
 // static
 NOINLINE Location Location::createFromHere(const char* file_name)
 {
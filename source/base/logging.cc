@@ -18,11 +18,14 @@
 
 #include "base/logging.h"
 
+#include "base/async_log_writer.h"
 #include "base/debug.h"
 #include "base/endian_util.h"
 #include "base/system_time.h"
 #include "base/strings/unicode.h"
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iomanip>
 #include <mutex>
@@ -55,6 +58,11 @@ std::filesystem::path g_log_file_path;
 std::ofstream g_log_file;
 std::mutex g_log_file_lock;
 
+// Number of messages the asynchronous writer can hold before it starts dropping them.
+constexpr size_t kAsyncQueueCapacity = 8192;
+
+std::atomic<AsyncLogWriter*> g_async_writer { nullptr };
+
 const char* severityName(LoggingSeverity severity)
 {
     static const char* const kLogSeverityNames[] =
@@ -82,13 +90,47 @@ std::filesystem::path defaultLogFileDir()
     return path;
 }
 
+// Writes the messages to all enabled destinations.
+void writeMessages(const std::string& messages)
+{
+    if ((g_logging_destination & LOG_TO_SYSTEM_DEBUG_LOG) != 0)
+    {
+        debugPrint(messages.data());
+
+        fwrite(messages.data(), messages.size(), 1, stderr);
+        fflush(stderr);
+    }
+
+    if ((g_logging_destination & LOG_TO_FILE) != 0)
+    {
+        std::scoped_lock lock(g_log_file_lock);
+        g_log_file.write(messages.c_str(), messages.size());
+        g_log_file.flush();
+    }
+}
+
+// Writes the queued messages and returns to synchronous logging.
+void stopAsyncWriter()
+{
+    // The writer thread uses g_log_file_lock, so it must be stopped without holding the lock.
+    delete g_async_writer.exchange(nullptr, std::memory_order_acq_rel);
+}
+
 bool initLoggingImpl(const LoggingSettings& settings, const std::filesystem::path& file_name)
 {
+    stopAsyncWriter();
+
     std::scoped_lock lock(g_log_file_lock);
     g_log_file.close();
 
     g_logging_destination = settings.destination;
 
+    if (settings.asynchronous && g_logging_destination != LOG_NONE)
+    {
+        g_async_writer.store(new AsyncLogWriter(kAsyncQueueCapacity, writeMessages),
+                             std::memory_order_release);
+    }
+
     if (!(g_logging_destination & LOG_TO_FILE))
         return true;
 
@@ -145,7 +187,8 @@ std::ostream* g_swallow_stream;
 
 LoggingSettings::LoggingSettings()
     : destination(LOG_DEFAULT),
-      min_log_level(LOG_LS_INFO)
+      min_log_level(LOG_LS_INFO),
+      asynchronous(false)
 {
     // Nothing
 }
@@ -199,6 +242,8 @@ void shutdownLogging()
 {
     LOG(LS_INFO) << "Logging finished";
 
+    stopAsyncWriter();
+
     std::scoped_lock lock(g_log_file_lock);
     g_log_file.close();
 }
@@ -294,14 +339,7 @@ LogMessage::~LogMessage()
 
     std::string message(stream_.str());
 
-    if ((g_logging_destination & LOG_TO_SYSTEM_DEBUG_LOG) != 0)
-    {
-        debugPrint(message.data());
-
-        fwrite(message.data(), message.size(), 1, stderr);
-        fflush(stderr);
-    }
-    else if (severity_ >= LOG_LS_ERROR)
+    if ((g_logging_destination & LOG_TO_SYSTEM_DEBUG_LOG) == 0 && severity_ >= LOG_LS_ERROR)
     {
         // When we're only outputting to a log file, above a certain log level, we
         // should still output to stderr so that we can better detect and diagnose
@@ -310,12 +348,19 @@ LogMessage::~LogMessage()
         fflush(stderr);
     }
 
-    // Write to log file.
-    if ((g_logging_destination & LOG_TO_FILE) != 0)
+    AsyncLogWriter* async_writer = g_async_writer.load(std::memory_order_acquire);
+    if (async_writer && severity_ != LOG_LS_FATAL)
     {
-        std::scoped_lock lock(g_log_file_lock);
-        g_log_file.write(message.c_str(), message.size());
-        g_log_file.flush();
+        async_writer->write(std::move(message));
+    }
+    else
+    {
+        // The process is going to crash, so the queued messages are written first and the fatal
+        // message is written directly.
+        if (async_writer)
+            async_writer->flush();
+
+        writeMessages(message);
     }
 
     if (severity_ == LOG_LS_FATAL)
@@ -361,6 +406,64 @@ ErrorLogMessage::~ErrorLogMessage()
     stream() << ": " << error_.toString();
 }
 
+LogRateLimiter::LogRateLimiter(uint32_t n)
+    : every_n_(std::max(n, 1U)),
+      interval_(0),
+      tolerance_(0)
+{
+    // Nothing
+}
+
+LogRateLimiter::LogRateLimiter(uint32_t burst, std::chrono::milliseconds period)
+    : every_n_(0),
+      interval_(std::chrono::duration_cast<std::chrono::microseconds>(period).count() /
+                std::max(burst, 1U)),
+      tolerance_(std::chrono::duration_cast<std::chrono::microseconds>(period).count() -
+                 interval_)
+{
+    // Nothing
+}
+
+uint64_t LogRateLimiter::tryAcquire(Clock::time_point now)
+{
+    if (!isAllowed(now))
+    {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    return skipped_.exchange(0, std::memory_order_relaxed) + 1;
+}
+
+bool LogRateLimiter::isAllowed(Clock::time_point now)
+{
+    if (every_n_)
+        return counter_.fetch_add(1, std::memory_order_relaxed) % every_n_ == 0;
+
+    const int64_t now_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    int64_t next_time = next_time_.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        if (next_time - tolerance_ > now_us)
+            return false;
+
+        if (next_time_.compare_exchange_weak(next_time, std::max(next_time, now_us) + interval_,
+                                             std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+}
+
+std::ostream& operator<<(std::ostream& out, const LogSkippedMessages& skipped)
+{
+    if (skipped.count)
+        out << '(' << skipped.count << " similar messages skipped) ";
+    return out;
+}
+
 void logErrorNotReached(const char* file, int line)
 {
     LogMessage(file, line, LOG_LS_ERROR).stream() << "NOTREACHED() hit.";
@@ -22,6 +22,8 @@
 #include "base/scoped_clear_last_error.h"
 #include "base/system_error.h"
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <sstream>
 #include <type_traits>
@@ -121,11 +123,17 @@ struct LoggingSettings
     //
     //  destination: LOG_DEFAULT
     //  min_log_level: LOG_LS_INFO
+    //  asynchronous: false
     LoggingSettings();
 
     LoggingDestination destination;
     LoggingSeverity min_log_level;
 
+    // If true, messages are written by a background thread and the logging threads never wait
+    // for the file or the console. When the queue of the background thread is full, messages are
+    // dropped. Fatal messages are always written synchronously.
+    bool asynchronous;
+
     std::filesystem::path log_dir;
 };
 
@@ -134,7 +142,8 @@ struct LoggingSettings
 // See the definition of the enums above for descriptions and default values.
 bool initLogging(const LoggingSettings& settings = LoggingSettings());
 
-// Closes the log file explicitly if open.
+// Writes the queued messages, stops asynchronous logging and closes the log file explicitly if
+// open.
 // NOTE: Since the log file is opened as necessary by the action of logging statements, there's no
 //       guarantee that it will stay closed after this call.
 void shutdownLogging();
@@ -198,6 +207,35 @@ bool shouldCreateLogMessage(LoggingSeverity severity);
 #define PLOG_IF(severity, condition) \
   LAZY_STREAM(PLOG_STREAM(severity), LOG_IS_ON(severity) && (condition))
 
+// Rate-limited logging for code that can fail many times per second (for every packet, frame,
+// etc). Every call site has its own limit. When messages are skipped, the next written message
+// starts with the number of skipped messages.
+//
+//   LOG_EVERY_N(LS_WARNING, 100) << "Invalid packet";
+//   LOG_EVERY_T(LS_ERROR, std::chrono::seconds(1)) << "Decoding failed";
+//   LOG_RATE_LIMITED(LS_ERROR, 10, std::chrono::seconds(1)) << "Connection error";
+//
+// LOG_EVERY_N writes the first message and then every n-th one. LOG_EVERY_T writes at most one
+// message per period. LOG_RATE_LIMITED writes bursts of up to |burst| messages and no more than
+// |burst| messages per period on average. All parameters except the severity must be constants.
+#define LOG_RATE_LIMITER(...)                                                                    \
+  ([]() -> ::base::LogRateLimiter& {                                                             \
+      static ::base::LogRateLimiter limiter(__VA_ARGS__);                                        \
+      return limiter;                                                                            \
+  }())
+
+#define LOG_LIMITED(severity, limiter)                                                           \
+  switch (0) case 0: default:                                                                    \
+  if (const uint64_t log_count = LOG_IS_ON(severity) ? (limiter).tryAcquire() : 0;               \
+      log_count == 0) {}                                                                         \
+  else                                                                                           \
+      LOG_STREAM(severity) << ::base::LogSkippedMessages{ log_count - 1 }
+
+#define LOG_EVERY_N(severity, n) LOG_LIMITED(severity, LOG_RATE_LIMITER(n))
+#define LOG_EVERY_T(severity, period) LOG_LIMITED(severity, LOG_RATE_LIMITER(1, period))
+#define LOG_RATE_LIMITED(severity, burst, period) \
+  LOG_LIMITED(severity, LOG_RATE_LIMITER(burst, period))
+
 extern std::ostream* g_swallow_stream;
 
 // Note that g_swallow_stream is used instead of an arbitrary LOG() stream to avoid the creation of
@@ -524,6 +562,49 @@ public:
     void operator&(std::ostream&) { }
 };
 
+// Decides whether a message from a rate-limited call site is written (see LOG_EVERY_N,
+// LOG_EVERY_T and LOG_RATE_LIMITED). Thread-safe and lock-free.
+class LogRateLimiter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Allows the first message and then every |n|-th message.
+    explicit LogRateLimiter(uint32_t n);
+
+    // Token bucket that holds up to |burst| tokens and gets |burst| tokens per |period|.
+    LogRateLimiter(uint32_t burst, std::chrono::milliseconds period);
+
+    // Returns zero if the message must be skipped. Otherwise, returns the number of messages
+    // skipped since the previous written message plus one.
+    uint64_t tryAcquire() { return tryAcquire(Clock::now()); }
+    uint64_t tryAcquire(Clock::time_point now);
+
+private:
+    bool isAllowed(Clock::time_point now);
+
+    const uint32_t every_n_;
+    std::atomic<uint64_t> counter_ { 0 };
+
+    // The token bucket is implemented as a virtual scheduler: |next_time_| is the time when the
+    // bucket becomes full again. A message is allowed if the bucket is not empty at |now|.
+    const int64_t interval_;
+    const int64_t tolerance_;
+    std::atomic<int64_t> next_time_ { 0 };
+
+    std::atomic<uint64_t> skipped_ { 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(LogRateLimiter);
+};
+
+// Streams the number of messages skipped by a rate-limited call site.
+struct LogSkippedMessages
+{
+    uint64_t count;
+};
+
+std::ostream& operator<<(std::ostream& out, const LogSkippedMessages& skipped);
+
 // Appends a formatted system message of the GetLastError() type.
 class ErrorLogMessage
 {
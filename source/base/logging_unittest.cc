@@ -0,0 +1,104 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/logging.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+using namespace std::chrono_literals;
+
+TEST(LogRateLimiterTest, EveryN)
+{
+    LogRateLimiter limiter(3);
+
+    EXPECT_EQ(limiter.tryAcquire(), 1u);
+    EXPECT_EQ(limiter.tryAcquire(), 0u);
+    EXPECT_EQ(limiter.tryAcquire(), 0u);
+    EXPECT_EQ(limiter.tryAcquire(), 3u);
+    EXPECT_EQ(limiter.tryAcquire(), 0u);
+}
+
+TEST(LogRateLimiterTest, EveryPeriod)
+{
+    LogRateLimiter limiter(1, 1000ms);
+    LogRateLimiter::Clock::time_point now = LogRateLimiter::Clock::now();
+
+    EXPECT_EQ(limiter.tryAcquire(now), 1u);
+    EXPECT_EQ(limiter.tryAcquire(now + 500ms), 0u);
+    EXPECT_EQ(limiter.tryAcquire(now + 999ms), 0u);
+    EXPECT_EQ(limiter.tryAcquire(now + 1000ms), 3u);
+    EXPECT_EQ(limiter.tryAcquire(now + 1500ms), 0u);
+    EXPECT_EQ(limiter.tryAcquire(now + 5000ms), 2u);
+}
+
+TEST(LogRateLimiterTest, Burst)
+{
+    LogRateLimiter limiter(4, 1000ms);
+    LogRateLimiter::Clock::time_point now = LogRateLimiter::Clock::now();
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(limiter.tryAcquire(now), 1u);
+
+    EXPECT_EQ(limiter.tryAcquire(now), 0u);
+    EXPECT_EQ(limiter.tryAcquire(now + 100ms), 0u);
+
+    // One token is added every 250 ms.
+    EXPECT_EQ(limiter.tryAcquire(now + 250ms), 3u);
+    EXPECT_EQ(limiter.tryAcquire(now + 250ms), 0u);
+
+    // After a quiet period the whole burst is available again.
+    for (int i = 0; i < 4; ++i)
+        EXPECT_NE(limiter.tryAcquire(now + 10s), 0u);
+    EXPECT_EQ(limiter.tryAcquire(now + 10s), 0u);
+}
+
+TEST(LogRateLimiterTest, SkippedMessages)
+{
+    std::ostringstream stream;
+
+    stream << LogSkippedMessages{ 0 } << "message";
+    EXPECT_EQ(stream.str(), "message");
+
+    stream.str(std::string());
+    stream << LogSkippedMessages{ 5 } << "message";
+    EXPECT_EQ(stream.str(), "(5 similar messages skipped) message");
+}
+
+TEST(LogRateLimiterTest, Macros)
+{
+    int evaluated = 0;
+
+    for (int i = 0; i < 10; ++i)
+        LOG_EVERY_N(LS_INFO, 5) << "every n " << ++evaluated;
+    EXPECT_EQ(evaluated, 2);
+
+    for (int i = 0; i < 10; ++i)
+        LOG_EVERY_T(LS_INFO, 1h) << "every t " << ++evaluated;
+    EXPECT_EQ(evaluated, 3);
+
+    bool condition = false;
+    if (condition)
+        LOG_RATE_LIMITED(LS_INFO, 2, 1h) << "rate limited " << ++evaluated;
+    else
+        ++evaluated;
+    EXPECT_EQ(evaluated, 4);
+}
+
+} // namespace base
@@ -0,0 +1,163 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/buffer_pool.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+BufferPool::BufferPool() = default;
+
+BufferPool::~BufferPool() = default;
+
+// static
+BufferPool* BufferPool::instance()
+{
+    // The pool is never destroyed because buffers can be released from any thread at any time.
+    static BufferPool* pool = new BufferPool();
+    return pool;
+}
+
+ByteArray BufferPool::acquire(size_t size)
+{
+    ++acquired_;
+
+    const int index = classForSize(size);
+    if (index != -1)
+    {
+        std::scoped_lock lock(lock_);
+
+        std::vector<ByteArray>& buffers = classes_[index];
+        if (!buffers.empty())
+        {
+            ByteArray buffer = std::move(buffers.back());
+            buffers.pop_back();
+
+            cached_bytes_ -= buffer.capacity();
+            cached_memory_.set(cached_bytes_);
+            ++reused_;
+
+            buffer.resize(size);
+            return buffer;
+        }
+    }
+
+    ++allocated_;
+
+    ByteArray buffer;
+
+    // Allocate the full class size so that the buffer can be reused for any size in the class.
+    if (index != -1)
+        buffer.reserve(size_t(1) << (index + kMinClassShift));
+
+    buffer.resize(size);
+    return buffer;
+}
+
+void BufferPool::release(ByteArray&& buffer)
+{
+    const int index = classForCapacity(buffer.capacity());
+    if (index == -1)
+    {
+        // The buffer is too small or too large for the pool.
+        buffer = ByteArray();
+        return;
+    }
+
+    buffer.clear();
+
+    {
+        std::scoped_lock lock(lock_);
+
+        std::vector<ByteArray>& buffers = classes_[index];
+
+        if (buffers.size() < kMaxBuffersPerClass &&
+            cached_bytes_ + buffer.capacity() <= kMaxCachedBytes)
+        {
+            cached_bytes_ += buffer.capacity();
+            cached_memory_.set(cached_bytes_);
+            buffers.emplace_back(std::move(buffer));
+
+            ++released_;
+            return;
+        }
+    }
+
+    ++dropped_;
+    buffer = ByteArray();
+}
+
+BufferPool::Statistics BufferPool::statistics() const
+{
+    Statistics statistics;
+
+    statistics.acquired = acquired_;
+    statistics.reused = reused_;
+    statistics.allocated = allocated_;
+    statistics.released = released_;
+    statistics.dropped = dropped_;
+
+    std::scoped_lock lock(lock_);
+    statistics.cached_bytes = cached_bytes_;
+
+    return statistics;
+}
+
+void BufferPool::clear()
+{
+    std::scoped_lock lock(lock_);
+
+    for (auto& buffers : classes_)
+        buffers.clear();
+
+    cached_bytes_ = 0;
+    cached_memory_.set(0);
+}
+
+// static
+int BufferPool::classForSize(size_t size)
+{
+    if (size < (size_t(1) << kMinClassShift) || size > (size_t(1) << kMaxClassShift))
+        return -1;
+
+    size_t shift = kMinClassShift;
+    while ((size_t(1) << shift) < size)
+        ++shift;
+
+    return static_cast<int>(shift - kMinClassShift);
+}
+
+// static
+int BufferPool::classForCapacity(size_t capacity)
+{
+    if (capacity < (size_t(1) << kMinClassShift))
+        return -1;
+
+    size_t shift = kMinClassShift;
+    while (shift < kMaxClassShift && (size_t(1) << (shift + 1)) <= capacity)
+        ++shift;
+
+    // Buffers much larger than the largest class are not kept.
+    if (capacity >= (size_t(1) << (kMaxClassShift + 1)))
+        return -1;
+
+    return static_cast<int>(shift - kMinClassShift);
+}
+
+} // namespace base
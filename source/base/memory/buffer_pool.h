@@ -0,0 +1,99 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MEMORY__BUFFER_POOL_H
+#define BASE__MEMORY__BUFFER_POOL_H
+
+#include "base/macros_magic.h"
+#include "base/memory/byte_array.h"
+#include "base/memory/memory_accounting.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace base {
+
+// Thread-safe pool of byte buffers divided into size classes (powers of two). Buffers for messages
+// are taken from the pool and returned to it after use, so frame-sized buffers are not freed and
+// allocated again for each message.
+class BufferPool
+{
+public:
+    struct Statistics
+    {
+        uint64_t acquired = 0;     // Total number of acquire() calls.
+        uint64_t reused = 0;       // Number of buffers taken from the pool.
+        uint64_t allocated = 0;    // Number of buffers allocated because the pool was empty.
+        uint64_t released = 0;     // Number of buffers returned to the pool.
+        uint64_t dropped = 0;      // Number of buffers freed because the pool was full.
+        size_t cached_bytes = 0;   // Total capacity of the buffers in the pool.
+    };
+
+    ~BufferPool();
+
+    // Returns the process-wide instance of the pool.
+    static BufferPool* instance();
+
+    // Returns a buffer with the size |size|. The contents of the buffer are undefined.
+    ByteArray acquire(size_t size);
+
+    // Returns the buffer to the pool. If the pool is full, the buffer is freed.
+    void release(ByteArray&& buffer);
+
+    Statistics statistics() const;
+
+    // Frees all buffers in the pool.
+    void clear();
+
+private:
+    BufferPool();
+
+    // Buffers smaller than the minimum class are not pooled, they are cheap to allocate.
+    static const size_t kMinClassShift = 12; // 4 KB
+    static const size_t kMaxClassShift = 24; // 16 MB
+    static constexpr size_t kClassCount = kMaxClassShift - kMinClassShift + 1;
+
+    // Maximum number of buffers in one class and the maximum total capacity of cached buffers.
+    static const size_t kMaxBuffersPerClass = 16;
+    static const size_t kMaxCachedBytes = 64 * 1024 * 1024; // 64 MB
+
+    // Returns the index of the class which can contain a buffer of |size| bytes or -1.
+    static int classForSize(size_t size);
+
+    // Returns the index of the class to which a buffer of |capacity| bytes belongs or -1.
+    static int classForCapacity(size_t capacity);
+
+    mutable std::mutex lock_;
+    std::array<std::vector<ByteArray>, kClassCount> classes_;
+    size_t cached_bytes_ = 0;
+    TrackedMemory cached_memory_ { MemoryTag::BUFFER_POOL };
+
+    std::atomic<uint64_t> acquired_ { 0 };
+    std::atomic<uint64_t> reused_ { 0 };
+    std::atomic<uint64_t> allocated_ { 0 };
+    std::atomic<uint64_t> released_ { 0 };
+    std::atomic<uint64_t> dropped_ { 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(BufferPool);
+};
+
+} // namespace base
+
+#endif // BASE__MEMORY__BUFFER_POOL_H
@@ -0,0 +1,120 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/buffer_pool.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(BufferPoolTest, SmallBuffer)
+{
+    BufferPool* pool = BufferPool::instance();
+    pool->clear();
+
+    const BufferPool::Statistics before = pool->statistics();
+
+    ByteArray buffer = pool->acquire(100);
+    EXPECT_EQ(buffer.size(), 100u);
+
+    pool->release(std::move(buffer));
+
+    const BufferPool::Statistics after = pool->statistics();
+
+    // Small buffers are not kept in the pool.
+    EXPECT_EQ(after.acquired - before.acquired, 1u);
+    EXPECT_EQ(after.allocated - before.allocated, 1u);
+    EXPECT_EQ(after.released - before.released, 0u);
+    EXPECT_EQ(after.cached_bytes, 0u);
+}
+
+TEST(BufferPoolTest, Reuse)
+{
+    BufferPool* pool = BufferPool::instance();
+    pool->clear();
+
+    const BufferPool::Statistics before = pool->statistics();
+
+    ByteArray buffer = pool->acquire(100 * 1024);
+    EXPECT_EQ(buffer.size(), 100 * 1024u);
+    EXPECT_GE(buffer.capacity(), 128 * 1024u);
+
+    const uint8_t* data = buffer.data();
+    pool->release(std::move(buffer));
+
+    EXPECT_EQ(pool->statistics().cached_bytes, 128 * 1024u);
+
+    // A buffer of the same class is taken from the pool.
+    ByteArray other = pool->acquire(70 * 1024);
+    EXPECT_EQ(other.size(), 70 * 1024u);
+    EXPECT_EQ(other.data(), data);
+
+    const BufferPool::Statistics after = pool->statistics();
+    EXPECT_EQ(after.acquired - before.acquired, 2u);
+    EXPECT_EQ(after.allocated - before.allocated, 1u);
+    EXPECT_EQ(after.reused - before.reused, 1u);
+    EXPECT_EQ(after.released - before.released, 1u);
+    EXPECT_EQ(after.cached_bytes, 0u);
+
+    pool->release(std::move(other));
+    pool->clear();
+    EXPECT_EQ(pool->statistics().cached_bytes, 0u);
+}
+
+TEST(BufferPoolTest, DifferentClasses)
+{
+    BufferPool* pool = BufferPool::instance();
+    pool->clear();
+
+    pool->release(pool->acquire(8 * 1024));
+
+    const BufferPool::Statistics before = pool->statistics();
+
+    // A larger buffer can not be served from a smaller class.
+    ByteArray buffer = pool->acquire(9 * 1024);
+    EXPECT_EQ(buffer.size(), 9 * 1024u);
+
+    const BufferPool::Statistics after = pool->statistics();
+    EXPECT_EQ(after.allocated - before.allocated, 1u);
+    EXPECT_EQ(after.reused - before.reused, 0u);
+
+    pool->clear();
+}
+
+TEST(BufferPoolTest, Limit)
+{
+    BufferPool* pool = BufferPool::instance();
+    pool->clear();
+
+    const BufferPool::Statistics before = pool->statistics();
+
+    std::vector<ByteArray> buffers;
+    for (int i = 0; i < 32; ++i)
+        buffers.emplace_back(pool->acquire(4096));
+
+    for (auto& buffer : buffers)
+        pool->release(std::move(buffer));
+
+    const BufferPool::Statistics after = pool->statistics();
+    EXPECT_EQ(after.released - before.released, 16u);
+    EXPECT_EQ(after.dropped - before.dropped, 16u);
+
+    pool->clear();
+}
+
+} // namespace base
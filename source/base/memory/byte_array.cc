@@ -19,6 +19,7 @@
 #include "base/memory/byte_array.h"
 
 #include "base/logging.h"
+#include "base/memory/buffer_pool.h"
 
 namespace base {
 
@@ -128,13 +129,32 @@ base::ByteArray serialize(const google::protobuf::MessageLite& message)
     if (!size)
         return base::ByteArray();
 
-    base::ByteArray buffer;
-    buffer.resize(size);
+    base::ByteArray buffer = BufferPool::instance()->acquire(size);
 
     message.SerializeWithCachedSizesToArray(buffer.data());
     return buffer;
 }
 
+void serialize(const google::protobuf::MessageLite& message, size_t headroom, ByteArray* buffer)
+{
+    DCHECK(buffer);
+
+    const size_t size = message.ByteSizeLong();
+
+    if (buffer->capacity() < headroom + size)
+    {
+        BufferPool::instance()->release(std::move(*buffer));
+        *buffer = BufferPool::instance()->acquire(headroom + size);
+    }
+    else
+    {
+        buffer->resize(headroom + size);
+    }
+
+    if (size)
+        message.SerializeWithCachedSizesToArray(buffer->data() + headroom);
+}
+
 int compare(const base::ByteArray& first, const base::ByteArray& second)
 {
     if (first.empty() && second.empty())
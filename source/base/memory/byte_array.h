@@ -37,8 +37,15 @@ std::string toStdString(const ByteArray& in);
 ByteArray fromHex(std::string_view in);
 std::string toHex(const ByteArray& in);
 
+// Serializes |message| to a buffer taken from BufferPool. When the buffer is no longer needed, it
+// can be returned to the pool.
 base::ByteArray serialize(const google::protobuf::MessageLite& message);
 
+// Serializes |message| to |buffer| after |headroom| bytes reserved at the beginning of the buffer.
+// The contents of the headroom are undefined. The capacity of |buffer| is reused if it is enough,
+// otherwise the buffer is taken from BufferPool.
+void serialize(const google::protobuf::MessageLite& message, size_t headroom, ByteArray* buffer);
+
 template <class T>
 bool parse(const base::ByteArray& buffer, T* message)
 {
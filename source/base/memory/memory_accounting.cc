@@ -0,0 +1,201 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/memory_accounting.h"
+
+#include "base/logging.h"
+
+#include <sstream>
+
+namespace base {
+
+MemoryAccount::MemoryAccount(std::string name)
+    : name_(std::move(name))
+{
+    for (size_t i = 0; i < kTagCount; ++i)
+    {
+        current_[i].store(0, std::memory_order_relaxed);
+        peak_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// static
+MemoryAccount* MemoryAccount::global()
+{
+    // The account is never destroyed because tracked objects can be destroyed at any time.
+    static MemoryAccount* account = new MemoryAccount("process");
+    return account;
+}
+
+// static
+const char* MemoryAccount::tagToString(MemoryTag tag)
+{
+    switch (tag)
+    {
+        case MemoryTag::FRAMES:
+            return "frames";
+
+        case MemoryTag::BUFFER_POOL:
+            return "buffer_pool";
+
+        case MemoryTag::WRITE_QUEUES:
+            return "write_queues";
+
+        case MemoryTag::CODECS:
+            return "codecs";
+
+        case MemoryTag::RELAY_BUFFERS:
+            return "relay_buffers";
+
+        default:
+            return "unknown";
+    }
+}
+
+void MemoryAccount::add(MemoryTag tag, size_t bytes)
+{
+    const size_t index = static_cast<size_t>(tag);
+    DCHECK_LT(index, kTagCount);
+
+    const size_t current = current_[index].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    size_t peak = peak_[index].load(std::memory_order_relaxed);
+    while (current > peak &&
+           !peak_[index].compare_exchange_weak(peak, current, std::memory_order_relaxed))
+    {
+        // The peak has been changed by another thread, |peak| contains the new value.
+    }
+}
+
+void MemoryAccount::remove(MemoryTag tag, size_t bytes)
+{
+    const size_t index = static_cast<size_t>(tag);
+    DCHECK_LT(index, kTagCount);
+    DCHECK_GE(current_[index].load(std::memory_order_relaxed), bytes);
+
+    current_[index].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+size_t MemoryAccount::current(MemoryTag tag) const
+{
+    return current_[static_cast<size_t>(tag)].load(std::memory_order_relaxed);
+}
+
+size_t MemoryAccount::peak(MemoryTag tag) const
+{
+    return peak_[static_cast<size_t>(tag)].load(std::memory_order_relaxed);
+}
+
+size_t MemoryAccount::total() const
+{
+    size_t total = 0;
+
+    for (const auto& current : current_)
+        total += current.load(std::memory_order_relaxed);
+
+    return total;
+}
+
+std::string MemoryAccount::toString() const
+{
+    std::ostringstream stream;
+    stream << "Memory of " << name_ << " (current/peak KB):";
+
+    for (size_t i = 0; i < kTagCount; ++i)
+    {
+        const MemoryTag tag = static_cast<MemoryTag>(i);
+        stream << ' ' << tagToString(tag) << '=' << (current(tag) / 1024) << '/'
+               << (peak(tag) / 1024);
+    }
+
+    return stream.str();
+}
+
+TrackedMemory::TrackedMemory(MemoryTag tag, size_t bytes)
+    : tag_(tag)
+{
+    set(bytes);
+}
+
+TrackedMemory::~TrackedMemory()
+{
+    set(0);
+}
+
+TrackedMemory::TrackedMemory(TrackedMemory&& other) noexcept
+    : tag_(other.tag_),
+      bytes_(other.bytes_),
+      account_(std::move(other.account_))
+{
+    other.bytes_ = 0;
+}
+
+TrackedMemory& TrackedMemory::operator=(TrackedMemory&& other) noexcept
+{
+    if (&other != this)
+    {
+        set(0);
+
+        tag_ = other.tag_;
+        bytes_ = other.bytes_;
+        account_ = std::move(other.account_);
+
+        other.bytes_ = 0;
+    }
+
+    return *this;
+}
+
+void TrackedMemory::set(size_t bytes)
+{
+    if (bytes == bytes_)
+        return;
+
+    MemoryAccount* global = MemoryAccount::global();
+
+    if (bytes > bytes_)
+    {
+        global->add(tag_, bytes - bytes_);
+        if (account_)
+            account_->add(tag_, bytes - bytes_);
+    }
+    else
+    {
+        global->remove(tag_, bytes_ - bytes);
+        if (account_)
+            account_->remove(tag_, bytes_ - bytes);
+    }
+
+    bytes_ = bytes;
+}
+
+void TrackedMemory::setAccount(std::shared_ptr<MemoryAccount> account)
+{
+    if (account == account_)
+        return;
+
+    if (account_)
+        account_->remove(tag_, bytes_);
+
+    account_ = std::move(account);
+
+    if (account_)
+        account_->add(tag_, bytes_);
+}
+
+} // namespace base
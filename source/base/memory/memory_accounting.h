@@ -0,0 +1,112 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MEMORY__MEMORY_ACCOUNTING_H
+#define BASE__MEMORY__MEMORY_ACCOUNTING_H
+
+#include "base/macros_magic.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace base {
+
+// Subsystems whose memory is counted.
+enum class MemoryTag
+{
+    FRAMES,        // Desktop frame buffers (see FrameAligned and FrameSimple).
+    BUFFER_POOL,   // Buffers cached by BufferPool.
+    WRITE_QUEUES,  // Messages waiting in the write queues of network channels.
+    CODECS,        // Buffers owned by the video encoders (the state of the libraries is not
+                   // counted).
+    RELAY_BUFFERS, // Buffers of the relay sessions.
+    COUNT
+};
+
+// Counters of the memory used by the subsystems. The global account counts the memory of the
+// whole process, an account of a session counts only the memory used by this session (the memory
+// is also counted in the global account). All methods are thread safe.
+class MemoryAccount
+{
+public:
+    explicit MemoryAccount(std::string name);
+    ~MemoryAccount() = default;
+
+    // Returns the account of the whole process.
+    static MemoryAccount* global();
+
+    static const char* tagToString(MemoryTag tag);
+
+    const std::string& name() const { return name_; }
+
+    void add(MemoryTag tag, size_t bytes);
+    void remove(MemoryTag tag, size_t bytes);
+
+    // Current and maximum number of bytes used by |tag|.
+    size_t current(MemoryTag tag) const;
+    size_t peak(MemoryTag tag) const;
+
+    // Current number of bytes used by all tags.
+    size_t total() const;
+
+    // Returns the current and peak values of all tags as a single line for the log.
+    std::string toString() const;
+
+private:
+    static constexpr size_t kTagCount = static_cast<size_t>(MemoryTag::COUNT);
+
+    const std::string name_;
+    std::array<std::atomic<size_t>, kTagCount> current_;
+    std::array<std::atomic<size_t>, kTagCount> peak_;
+
+    DISALLOW_COPY_AND_ASSIGN(MemoryAccount);
+};
+
+// Memory of |tag| owned by an object. The size is counted in the global account and in the
+// account of the session to which the object belongs (if any) until the object is destroyed.
+// The object itself is not thread safe.
+class TrackedMemory
+{
+public:
+    explicit TrackedMemory(MemoryTag tag, size_t bytes = 0);
+    ~TrackedMemory();
+
+    TrackedMemory(TrackedMemory&& other) noexcept;
+    TrackedMemory& operator=(TrackedMemory&& other) noexcept;
+
+    // Changes the number of bytes owned by the object.
+    void set(size_t bytes);
+    size_t bytes() const { return bytes_; }
+
+    // Moves the counted bytes to |account|. If |account| is nullptr, the bytes are counted only
+    // in the global account.
+    void setAccount(std::shared_ptr<MemoryAccount> account);
+
+private:
+    MemoryTag tag_;
+    size_t bytes_ = 0;
+    std::shared_ptr<MemoryAccount> account_;
+
+    DISALLOW_COPY_AND_ASSIGN(TrackedMemory);
+};
+
+} // namespace base
+
+#endif // BASE__MEMORY__MEMORY_ACCOUNTING_H
@@ -0,0 +1,77 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/memory_accounting.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(MemoryAccountingTest, TrackedMemory)
+{
+    MemoryAccount* global = MemoryAccount::global();
+    const size_t global_before = global->current(MemoryTag::CODECS);
+
+    std::shared_ptr<MemoryAccount> account = std::make_shared<MemoryAccount>("test");
+
+    {
+        TrackedMemory memory(MemoryTag::CODECS, 100);
+        EXPECT_EQ(global->current(MemoryTag::CODECS), global_before + 100);
+
+        memory.setAccount(account);
+        EXPECT_EQ(account->current(MemoryTag::CODECS), 100u);
+
+        memory.set(300);
+        memory.set(50);
+        EXPECT_EQ(account->current(MemoryTag::CODECS), 50u);
+        EXPECT_EQ(account->peak(MemoryTag::CODECS), 300u);
+        EXPECT_EQ(account->total(), 50u);
+        EXPECT_EQ(global->current(MemoryTag::CODECS), global_before + 50);
+    }
+
+    EXPECT_EQ(account->current(MemoryTag::CODECS), 0u);
+    EXPECT_EQ(account->peak(MemoryTag::CODECS), 300u);
+    EXPECT_EQ(global->current(MemoryTag::CODECS), global_before);
+}
+
+TEST(MemoryAccountingTest, Move)
+{
+    std::shared_ptr<MemoryAccount> account = std::make_shared<MemoryAccount>("test");
+
+    TrackedMemory first(MemoryTag::FRAMES, 10);
+    first.setAccount(account);
+
+    TrackedMemory second(std::move(first));
+    EXPECT_EQ(first.bytes(), 0u);
+    EXPECT_EQ(second.bytes(), 10u);
+    EXPECT_EQ(account->current(MemoryTag::FRAMES), 10u);
+
+    TrackedMemory third(MemoryTag::FRAMES, 5);
+    third.setAccount(account);
+    EXPECT_EQ(account->current(MemoryTag::FRAMES), 15u);
+
+    // The memory of |third| is released and replaced by the memory of |second|.
+    third = std::move(second);
+    EXPECT_EQ(third.bytes(), 10u);
+    EXPECT_EQ(account->current(MemoryTag::FRAMES), 10u);
+
+    third.setAccount(nullptr);
+    EXPECT_EQ(account->current(MemoryTag::FRAMES), 0u);
+}
+
+} // namespace base
@@ -0,0 +1,52 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/message_arena.h"
+
+namespace base {
+
+MessageArena::MessageArena(size_t block_size)
+    : initial_block_(std::make_unique<char[]>(block_size)),
+      arena_(makeOptions(initial_block_.get(), block_size))
+{
+    // Nothing
+}
+
+MessageArena::~MessageArena() = default;
+
+void MessageArena::reset()
+{
+    arena_.Reset();
+}
+
+size_t MessageArena::spaceUsed() const
+{
+    return static_cast<size_t>(arena_.SpaceUsed());
+}
+
+// static
+google::protobuf::ArenaOptions MessageArena::makeOptions(char* block, size_t block_size)
+{
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = block_size;
+    options.start_block_size = block_size;
+    return options;
+}
+
+} // namespace base
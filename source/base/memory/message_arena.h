@@ -0,0 +1,78 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MEMORY__MESSAGE_ARENA_H
+#define BASE__MEMORY__MESSAGE_ARENA_H
+
+#include "base/macros_magic.h"
+
+#include <google/protobuf/arena.h>
+
+#include <memory>
+
+namespace base {
+
+// Arena for the protobuf messages which live only while one incoming message is handled. The
+// messages and all their fields are allocated in the arena and are released at once by reset().
+// The initial block of the arena is kept between the resets, so handling of a typical message does
+// not touch the heap at all.
+//
+// Messages created by the arena must not outlive the next call of reset(). Fields must not be
+// released from them (release_*() on an arena message makes a heap copy).
+class MessageArena
+{
+public:
+    static const size_t kDefaultBlockSize = 8 * 1024; // 8 KB
+
+    explicit MessageArena(size_t block_size = kDefaultBlockSize);
+    ~MessageArena();
+
+    // Creates an empty message of type |T| in the arena.
+    template <class T>
+    T* create()
+    {
+        return google::protobuf::Arena::CreateMessage<T>(&arena_);
+    }
+
+    // Releases all the messages created by the arena and creates a new empty message of type |T|.
+    template <class T>
+    T* resetAndCreate()
+    {
+        reset();
+        return create<T>();
+    }
+
+    // Destroys all the messages created by the arena. Blocks allocated in addition to the initial
+    // one are returned to the heap.
+    void reset();
+
+    // Returns the number of bytes used in the blocks of the arena.
+    size_t spaceUsed() const;
+
+private:
+    static google::protobuf::ArenaOptions makeOptions(char* block, size_t block_size);
+
+    std::unique_ptr<char[]> initial_block_;
+    google::protobuf::Arena arena_;
+
+    DISALLOW_COPY_AND_ASSIGN(MessageArena);
+};
+
+} // namespace base
+
+#endif // BASE__MEMORY__MESSAGE_ARENA_H
@@ -0,0 +1,69 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/message_arena.h"
+
+#include "proto/desktop.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(MessageArenaTest, CreateAndReset)
+{
+    MessageArena arena;
+
+    proto::VideoPacket* packet = arena.create<proto::VideoPacket>();
+    ASSERT_NE(packet, nullptr);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        proto::Rect* rect = packet->add_dirty_rect();
+        rect->set_x(i);
+        rect->set_width(i + 1);
+    }
+
+    EXPECT_EQ(packet->dirty_rect_size(), 16);
+    EXPECT_EQ(packet->dirty_rect(15).width(), 16);
+
+    const size_t used = arena.spaceUsed();
+    EXPECT_GT(used, 0u);
+
+    packet = arena.resetAndCreate<proto::VideoPacket>();
+    EXPECT_EQ(packet->dirty_rect_size(), 0);
+    EXPECT_LE(arena.spaceUsed(), used);
+}
+
+TEST(MessageArenaTest, LargeMessage)
+{
+    MessageArena arena(1024);
+
+    // The message does not fit in the initial block and takes additional blocks from the heap.
+    for (int round = 0; round < 3; ++round)
+    {
+        proto::VideoPacket* packet = arena.resetAndCreate<proto::VideoPacket>();
+
+        for (int i = 0; i < 1000; ++i)
+            packet->add_dirty_rect()->set_x(i);
+
+        EXPECT_EQ(packet->dirty_rect_size(), 1000);
+        EXPECT_EQ(packet->dirty_rect(999).x(), 999);
+    }
+}
+
+} // namespace base
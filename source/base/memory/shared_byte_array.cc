@@ -0,0 +1,35 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/shared_byte_array.h"
+
+#include "base/memory/buffer_pool.h"
+
+namespace base {
+
+SharedByteArray::SharedByteArray(ByteArray&& buffer)
+    : buffer_(new ByteArray(std::move(buffer)), [](ByteArray* buffer)
+      {
+          BufferPool::instance()->release(std::move(*buffer));
+          delete buffer;
+      })
+{
+    // Nothing
+}
+
+} // namespace base
@@ -0,0 +1,56 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MEMORY__SHARED_BYTE_ARRAY_H
+#define BASE__MEMORY__SHARED_BYTE_ARRAY_H
+
+#include "base/memory/byte_array.h"
+
+#include <memory>
+
+namespace base {
+
+// Immutable byte array with shared ownership. Copies only change the reference counter, so one
+// buffer can be queued to several channels at once without copying the data (for example, a
+// packet encoded once for several clients). When the last copy is destroyed, the buffer is
+// returned to BufferPool.
+class SharedByteArray
+{
+public:
+    SharedByteArray() = default;
+    explicit SharedByteArray(ByteArray&& buffer);
+
+    SharedByteArray(const SharedByteArray& other) = default;
+    SharedByteArray& operator=(const SharedByteArray& other) = default;
+    SharedByteArray(SharedByteArray&& other) noexcept = default;
+    SharedByteArray& operator=(SharedByteArray&& other) noexcept = default;
+
+    const uint8_t* data() const { return buffer_ ? buffer_->data() : nullptr; }
+    size_t size() const { return buffer_ ? buffer_->size() : 0; }
+    bool empty() const { return !size(); }
+
+    // Returns the number of copies which refer to the buffer.
+    long useCount() const { return buffer_.use_count(); }
+
+private:
+    std::shared_ptr<const ByteArray> buffer_;
+};
+
+} // namespace base
+
+#endif // BASE__MEMORY__SHARED_BYTE_ARRAY_H
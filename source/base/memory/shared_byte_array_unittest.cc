@@ -0,0 +1,65 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/shared_byte_array.h"
+
+#include "base/memory/buffer_pool.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(SharedByteArrayTest, Empty)
+{
+    SharedByteArray buffer;
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(buffer.data(), nullptr);
+    EXPECT_EQ(buffer.useCount(), 0);
+}
+
+TEST(SharedByteArrayTest, Copies)
+{
+    const uint8_t* data;
+
+    {
+        ByteArray source = BufferPool::instance()->acquire(64 * 1024);
+        source[0] = 1;
+        data = source.data();
+
+        SharedByteArray buffer(std::move(source));
+        EXPECT_EQ(buffer.size(), 64u * 1024);
+        EXPECT_EQ(buffer.data(), data);
+
+        SharedByteArray copy = buffer;
+        EXPECT_EQ(copy.data(), data);
+        EXPECT_EQ(copy.data()[0], 1);
+        EXPECT_EQ(buffer.useCount(), 2);
+
+        SharedByteArray moved = std::move(copy);
+        EXPECT_EQ(moved.data(), data);
+        EXPECT_EQ(buffer.useCount(), 2);
+    }
+
+    // The buffer is returned to the pool when the last copy is destroyed.
+    ByteArray reused = BufferPool::instance()->acquire(64 * 1024);
+    EXPECT_EQ(reused.data(), data);
+    BufferPool::instance()->release(std::move(reused));
+}
+
+} // namespace base
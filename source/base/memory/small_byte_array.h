@@ -0,0 +1,69 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MEMORY__SMALL_BYTE_ARRAY_H
+#define BASE__MEMORY__SMALL_BYTE_ARRAY_H
+
+#include "base/logging.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace base {
+
+// Byte array with inline storage for tiny messages (input events, acknowledgements, service
+// messages). Unlike ByteArray it does not allocate memory, and buffers of this size are too small
+// to be taken from BufferPool.
+class SmallByteArray
+{
+public:
+    static constexpr size_t kCapacity = 64;
+
+    SmallByteArray() = default;
+
+    SmallByteArray(const void* data, size_t size)
+    {
+        resize(size);
+        if (size)
+            memcpy(data_.data(), data, size);
+    }
+
+    // Returns true if |size| bytes fit into the array.
+    static bool fits(size_t size) { return size <= kCapacity; }
+
+    uint8_t* data() { return data_.data(); }
+    const uint8_t* data() const { return data_.data(); }
+    size_t size() const { return size_; }
+    bool empty() const { return !size_; }
+
+    // The contents of the added bytes are undefined.
+    void resize(size_t size)
+    {
+        DCHECK(fits(size));
+        size_ = static_cast<uint8_t>(size);
+    }
+
+private:
+    std::array<uint8_t, kCapacity> data_;
+    uint8_t size_ = 0;
+};
+
+} // namespace base
+
+#endif // BASE__MEMORY__SMALL_BYTE_ARRAY_H
@@ -0,0 +1,53 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/memory/small_byte_array.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(SmallByteArrayTest, Basic)
+{
+    SmallByteArray empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.size(), 0u);
+
+    const uint8_t data[] = { 1, 2, 3, 4, 5 };
+
+    SmallByteArray buffer(data, sizeof(data));
+    EXPECT_EQ(buffer.size(), sizeof(data));
+    EXPECT_EQ(memcmp(buffer.data(), data, sizeof(data)), 0);
+
+    SmallByteArray copy = buffer;
+    EXPECT_EQ(copy.size(), sizeof(data));
+    EXPECT_EQ(memcmp(copy.data(), data, sizeof(data)), 0);
+    EXPECT_NE(copy.data(), buffer.data());
+
+    copy.resize(SmallByteArray::kCapacity);
+    EXPECT_EQ(copy.size(), SmallByteArray::kCapacity);
+}
+
+TEST(SmallByteArrayTest, Fits)
+{
+    EXPECT_TRUE(SmallByteArray::fits(0));
+    EXPECT_TRUE(SmallByteArray::fits(SmallByteArray::kCapacity));
+    EXPECT_FALSE(SmallByteArray::fits(SmallByteArray::kCapacity + 1));
+}
+
+} // namespace base
@@ -0,0 +1,105 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/incoming_task_queue.h"
+
+#include "base/logging.h"
+
+#include <optional>
+#include <thread>
+
+namespace base {
+
+struct IncomingTaskQueue::Node
+{
+    Node() = default;
+
+    explicit Node(PendingTask&& pending_task)
+        : task(std::move(pending_task))
+    {
+        // Nothing
+    }
+
+    std::atomic<Node*> next = nullptr;
+
+    // Empty for the node before the first task.
+    std::optional<PendingTask> task;
+};
+
+IncomingTaskQueue::IncomingTaskQueue()
+    : head_(new Node()),
+      tail_(head_.load(std::memory_order_relaxed))
+{
+    // Nothing
+}
+
+IncomingTaskQueue::~IncomingTaskQueue()
+{
+    Node* node = tail_;
+
+    while (node)
+    {
+        Node* next = node->next.load(std::memory_order_acquire);
+        delete node;
+        node = next;
+    }
+}
+
+bool IncomingTaskQueue::push(PendingTask&& pending_task)
+{
+    Node* node = new Node(std::move(pending_task));
+
+    Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+
+    return size_.fetch_add(1, std::memory_order_release) == 0;
+}
+
+void IncomingTaskQueue::takeAll(TaskQueue* work_queue)
+{
+    DCHECK(work_queue);
+
+    const size_t size = size_.load(std::memory_order_acquire);
+    size_t taken = 0;
+
+    while (taken < size)
+    {
+        Node* next = tail_->next.load(std::memory_order_acquire);
+        if (!next)
+        {
+            // A producer has exchanged the head but has not yet linked its node. It takes only a
+            // few instructions, so the consumer waits for it.
+            std::this_thread::yield();
+            continue;
+        }
+
+        DCHECK(next->task.has_value());
+
+        work_queue->emplace(std::move(*next->task));
+        next->task.reset();
+
+        delete tail_;
+        tail_ = next;
+        ++taken;
+    }
+
+    if (taken)
+        size_.fetch_sub(taken, std::memory_order_acq_rel);
+}
+
+} // namespace base
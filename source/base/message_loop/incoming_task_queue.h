@@ -0,0 +1,65 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MESSAGE_LOOP__INCOMING_TASK_QUEUE_H
+#define BASE__MESSAGE_LOOP__INCOMING_TASK_QUEUE_H
+
+#include "base/macros_magic.h"
+#include "base/message_loop/pending_task.h"
+
+#include <atomic>
+
+namespace base {
+
+// A queue of tasks which are posted to a message loop from any thread and taken by the thread of
+// the message loop (multiple producers, single consumer). Producers do not take a lock: adding a
+// task is one atomic exchange and one atomic increment.
+class IncomingTaskQueue
+{
+public:
+    IncomingTaskQueue();
+    ~IncomingTaskQueue();
+
+    // Adds the task to the queue. Returns true if the queue was empty, so the consumer must be
+    // woken up. Can be called from any thread.
+    bool push(PendingTask&& pending_task);
+
+    // Moves all tasks of the queue to |work_queue| in the order in which they were added. Must be
+    // called only from the consumer thread.
+    void takeAll(TaskQueue* work_queue);
+
+private:
+    struct Node;
+
+    // The last added node. Producers exchange it with the new node and then link the previous
+    // node to the new one.
+    std::atomic<Node*> head_;
+
+    // The node before the first task. It is accessed by the consumer only.
+    Node* tail_;
+
+    // Number of the linked tasks which are not yet taken. It is increased after the node is
+    // linked, so the consumer can take as many nodes as it sees here.
+    std::atomic<size_t> size_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(IncomingTaskQueue);
+};
+
+} // namespace base
+
+#endif // BASE__MESSAGE_LOOP__INCOMING_TASK_QUEUE_H
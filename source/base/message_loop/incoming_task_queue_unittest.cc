@@ -0,0 +1,143 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/incoming_task_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+namespace {
+
+PendingTask makeTask(std::function<void()> callback)
+{
+    return PendingTask(std::move(callback), PendingTask::TimePoint(), true);
+}
+
+} // namespace
+
+TEST(IncomingTaskQueueTest, EmptyQueue)
+{
+    IncomingTaskQueue queue;
+    TaskQueue work_queue;
+
+    queue.takeAll(&work_queue);
+    EXPECT_TRUE(work_queue.empty());
+}
+
+TEST(IncomingTaskQueueTest, KeepsOrder)
+{
+    IncomingTaskQueue queue;
+    std::vector<int> results;
+
+    // Only the first task finds the queue empty.
+    EXPECT_TRUE(queue.push(makeTask([&results]() { results.push_back(0); })));
+
+    for (int i = 1; i < 10; ++i)
+        EXPECT_FALSE(queue.push(makeTask([&results, i]() { results.push_back(i); })));
+
+    TaskQueue work_queue;
+    queue.takeAll(&work_queue);
+    ASSERT_EQ(work_queue.size(), 10U);
+
+    while (!work_queue.empty())
+    {
+        work_queue.front().callback();
+        work_queue.pop();
+    }
+
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(results[i], i);
+
+    // The queue is empty again.
+    EXPECT_TRUE(queue.push(makeTask([]() {})));
+}
+
+TEST(IncomingTaskQueueTest, DeletesPendingTasks)
+{
+    std::shared_ptr<int> value = std::make_shared<int>(0);
+
+    {
+        IncomingTaskQueue queue;
+        queue.push(makeTask([value]() {}));
+        EXPECT_EQ(value.use_count(), 2);
+    }
+
+    EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(IncomingTaskQueueTest, MultipleProducers)
+{
+    static const int kThreadCount = 4;
+    static const int kTaskCount = 10000;
+
+    IncomingTaskQueue queue;
+    std::vector<std::thread> threads;
+    std::vector<int> last_values(kThreadCount, -1);
+    std::atomic<int> wakeups = 0;
+
+    for (int i = 0; i < kThreadCount; ++i)
+    {
+        threads.emplace_back([&queue, &last_values, &wakeups, i]()
+        {
+            for (int j = 0; j < kTaskCount; ++j)
+            {
+                auto task = [&last_values, i, j]()
+                {
+                    // Tasks of one producer are taken in the order in which they were added.
+                    EXPECT_EQ(last_values[i] + 1, j);
+                    last_values[i] = j;
+                };
+
+                if (queue.push(makeTask(std::move(task))))
+                    ++wakeups;
+            }
+        });
+    }
+
+    int completed = 0;
+    TaskQueue work_queue;
+
+    while (completed < kThreadCount * kTaskCount)
+    {
+        queue.takeAll(&work_queue);
+
+        while (!work_queue.empty())
+        {
+            work_queue.front().callback();
+            work_queue.pop();
+            ++completed;
+        }
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int i = 0; i < kThreadCount; ++i)
+        EXPECT_EQ(last_values[i], kTaskCount - 1);
+
+    // The consumer is woken up at least when the first task is added.
+    EXPECT_GE(wakeups.load(), 1);
+}
+
+} // namespace base
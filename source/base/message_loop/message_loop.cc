@@ -21,16 +21,31 @@
 #include "base/message_loop/message_loop_task_runner.h"
 #include "base/message_loop/message_pump_asio.h"
 #include "base/message_loop/message_pump_default.h"
+#include "base/environment.h"
 #include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/timer_slack.h"
+#include "base/trace_event.h"
 
 #if defined(OS_WIN)
 #include "base/message_loop/message_pump_win.h"
+#include "base/message_loop/message_pump_win_asio.h"
 #endif // defined(OS_WIN)
 
 #include <memory>
 
 namespace base {
 
+namespace {
+
+// Maximum time for which a low priority task can be delayed by the tasks with a higher priority.
+const std::chrono::milliseconds kLowPriorityDeadline{ 100 };
+
+// If set, the statistics of all loops are written to the log with the interval in seconds.
+const char kStatsEnvVar[] = "ASPIA_MESSAGE_LOOP_STATS";
+
+} // namespace
+
 static thread_local MessageLoop* message_loop_for_current_thread = nullptr;
 
 // static
@@ -58,12 +73,24 @@ MessageLoop::MessageLoop(Type type)
         case Type::WIN:
             pump_ = std::make_unique<MessagePumpForWin>();
             break;
+
+        case Type::WIN_ASIO:
+            pump_ = std::make_unique<MessagePumpForWinAsio>();
+            break;
 #endif // defined(OS_WIN)
 
         default:
             pump_ = std::make_unique<MessagePumpDefault>();
             break;
     }
+
+    std::string stats_interval;
+    if (Environment::get(kStatsEnvVar, &stats_interval))
+    {
+        int seconds = 0;
+        if (stringToInt(stats_interval, &seconds) && seconds > 0)
+            enableStats(std::chrono::seconds(seconds));
+    }
 }
 
 MessageLoop::~MessageLoop()
@@ -118,34 +145,66 @@ void MessageLoop::quit()
     pump_->quit();
 }
 
+void MessageLoop::logStats()
+{
+    LOG(LS_INFO) << "Message loop statistics: " << stats_->toString();
+    stats_->reset();
+
+    postCoarseDelayedTask(std::bind(&MessageLoop::logStats, this), stats_log_interval_);
+}
+
 PendingTask::Callback MessageLoop::quitClosure()
 {
     return std::bind(&MessageLoop::quit, this);
 }
 
-void MessageLoop::postTask(PendingTask::Callback callback)
+void MessageLoop::postTask(PendingTask::Callback callback, const void* posted_from)
+{
+    DCHECK(callback != nullptr);
+    addToIncomingQueue(
+        std::move(callback), TimePoint(), true, TaskRunner::Priority::NORMAL, posted_from);
+}
+
+void MessageLoop::postPriorityTask(PendingTask::Callback callback,
+                                   TaskRunner::Priority priority,
+                                   const void* posted_from)
+{
+    DCHECK(callback != nullptr);
+    addToIncomingQueue(std::move(callback), TimePoint(), true, priority, posted_from);
+}
+
+void MessageLoop::postDelayedTask(PendingTask::Callback callback,
+                                  const Milliseconds& delay,
+                                  const void* posted_from)
 {
     DCHECK(callback != nullptr);
-    addToIncomingQueue(std::move(callback), Milliseconds::zero(), true);
+    addToIncomingQueue(std::move(callback), calculateDelayedRuntime(delay), true,
+                       TaskRunner::Priority::NORMAL, posted_from);
 }
 
-void MessageLoop::postDelayedTask(PendingTask::Callback callback, const Milliseconds& delay)
+void MessageLoop::postCoarseDelayedTask(PendingTask::Callback callback,
+                                        const Milliseconds& delay,
+                                        const void* posted_from)
 {
     DCHECK(callback != nullptr);
-    addToIncomingQueue(std::move(callback), delay, true);
+    addToIncomingQueue(std::move(callback), calculateCoarseDelayedRuntime(delay), true,
+                       TaskRunner::Priority::NORMAL, posted_from);
 }
 
-void MessageLoop::postNonNestableTask(PendingTask::Callback callback)
+void MessageLoop::postNonNestableTask(PendingTask::Callback callback, const void* posted_from)
 {
     DCHECK(callback != nullptr);
-    addToIncomingQueue(std::move(callback), Milliseconds::zero(), false);
+    addToIncomingQueue(
+        std::move(callback), TimePoint(), false, TaskRunner::Priority::NORMAL, posted_from);
 }
 
-void MessageLoop::postNonNestableDelayedTask(
-    PendingTask::Callback callback, const Milliseconds& delay)
+void MessageLoop::postNonNestableDelayedTask(PendingTask::Callback callback,
+                                             const Milliseconds& delay,
+                                             const void* posted_from)
 {
     DCHECK(callback != nullptr);
-    addToIncomingQueue(std::move(callback), delay, false);
+    addToIncomingQueue(std::move(callback), calculateDelayedRuntime(delay), false,
+                       TaskRunner::Priority::NORMAL, posted_from);
 }
 
 #if defined(OS_WIN)
@@ -165,19 +224,45 @@ std::shared_ptr<TaskRunner> MessageLoop::taskRunner() const
     return proxy_;
 }
 
+void MessageLoop::enableStats(const std::chrono::milliseconds& log_interval)
+{
+    DCHECK_EQ(this, current());
+
+    if (stats_)
+        return;
+
+    stats_ = std::make_unique<MessageLoopStats>();
+    stats_log_interval_ = log_interval;
+    stats_enabled_.store(true, std::memory_order_release);
+
+    if (stats_log_interval_ > Milliseconds::zero())
+        postCoarseDelayedTask(std::bind(&MessageLoop::logStats, this), stats_log_interval_);
+}
+
 void MessageLoop::runTask(const PendingTask& pending_task)
 {
+    TRACE_EVENT("message_loop", "MessageLoop::runTask");
+
     DCHECK(nestable_tasks_allowed_);
 
     // Execute the task and assume the worst: It is probably not reentrant.
     nestable_tasks_allowed_ = false;
 
-    pending_task.callback();
+    if (stats_)
+    {
+        const TimePoint start_time = Clock::now();
+        pending_task.callback();
+        stats_->addTask(pending_task, start_time, Clock::now());
+    }
+    else
+    {
+        pending_task.callback();
+    }
 
     nestable_tasks_allowed_ = true;
 }
 
-bool MessageLoop::deferOrRunPendingTask(const PendingTask& pending_task)
+bool MessageLoop::deferOrRunPendingTask(PendingTask&& pending_task)
 {
     if (pending_task.nestable)
     {
@@ -189,7 +274,7 @@ bool MessageLoop::deferOrRunPendingTask(const PendingTask& pending_task)
 
     // We couldn't run the task now because we're in a nested message loop
     // and the task isn't nestable.
-    deferred_non_nestable_work_queue_.emplace(pending_task);
+    deferred_non_nestable_work_queue_.emplace(std::move(pending_task));
     return false;
 }
 
@@ -198,28 +283,31 @@ void MessageLoop::addToDelayedWorkQueue(PendingTask* pending_task)
     // Move to the delayed work queue.  Initialize the sequence number before inserting into the
     // delayed_work_queue_. The sequence number is used to faciliate FIFO sorting when two tasks
     // have the same delayed_run_time value.
-    delayed_work_queue_.emplace(std::move(pending_task->callback),
-                                pending_task->delayed_run_time,
-                                pending_task->nestable,
-                                next_sequence_num_++);
+    pending_task->sequence_num = next_sequence_num_++;
+    delayed_work_queue_.emplace(std::move(*pending_task));
 }
 
-void MessageLoop::addToIncomingQueue(
-    PendingTask::Callback&& callback, const Milliseconds& delay, bool nestable)
+void MessageLoop::addToIncomingQueue(PendingTask::Callback&& callback,
+                                     const TimePoint& delayed_run_time,
+                                     bool nestable,
+                                     TaskRunner::Priority priority,
+                                     const void* posted_from)
 {
-    bool empty;
+    PendingTask pending_task(std::move(callback), delayed_run_time, nestable);
+    pending_task.priority = priority;
+    pending_task.posted_from = posted_from;
 
+    if (stats_enabled_.load(std::memory_order_acquire))
     {
-        std::scoped_lock lock(incoming_queue_lock_);
-
-        empty = incoming_queue_.empty();
-
-        incoming_queue_.emplace(std::move(callback),
-                                calculateDelayedRuntime(delay),
-                                nestable);
+        pending_task.post_time = Clock::now();
+        stats_->addPost();
     }
 
-    if (!empty)
+    if (priority == TaskRunner::Priority::LOW)
+        pending_task.deadline = Clock::now() + kLowPriorityDeadline;
+
+    // The pump is already scheduled if the queue is not empty.
+    if (!incoming_queue_.push(std::move(pending_task)))
         return;
 
     std::shared_ptr<MessagePump> pump(pump_);
@@ -228,32 +316,71 @@ void MessageLoop::addToIncomingQueue(
 
 void MessageLoop::reloadWorkQueue()
 {
-    if (!work_queue_.empty())
-        return;
+    // The incoming tasks are taken every time, so a task with a higher priority does not wait for
+    // the tasks which have already been taken.
+    incoming_queue_.takeAll(&reload_queue_);
 
-    std::scoped_lock lock(incoming_queue_lock_);
+    while (!reload_queue_.empty())
+    {
+        PendingTask& pending_task = reload_queue_.front();
+        const size_t index = static_cast<size_t>(pending_task.priority);
 
-    if (incoming_queue_.empty())
-        return;
+        DCHECK_LT(index, kPriorityCount);
+        work_queues_[index].emplace(std::move(pending_task));
+        reload_queue_.pop();
+    }
 
-    incoming_queue_.Swap(&work_queue_);
-    DCHECK(incoming_queue_.empty());
+    if (stats_)
+    {
+        size_t depth = 0;
+        for (const TaskQueue& work_queue : work_queues_)
+            depth += work_queue.size();
+
+        stats_->addQueueDepth(depth);
+    }
+}
+
+TaskQueue* MessageLoop::nextWorkQueue()
+{
+    TaskQueue& low_queue = work_queues_[static_cast<size_t>(TaskRunner::Priority::LOW)];
+
+    for (size_t i = 0; i < kPriorityCount; ++i)
+    {
+        if (work_queues_[i].empty())
+            continue;
+
+        // The oldest low priority task is run first if it has waited too long.
+        if (&work_queues_[i] != &low_queue && !low_queue.empty() &&
+            low_queue.front().deadline <= Clock::now())
+        {
+            return &low_queue;
+        }
+
+        return &work_queues_[i];
+    }
+
+    return nullptr;
 }
 
 bool MessageLoop::deletePendingTasks()
 {
-    bool did_work = !work_queue_.empty();
+    bool did_work = false;
 
-    while (!work_queue_.empty())
+    for (TaskQueue& work_queue : work_queues_)
     {
-        PendingTask pending_task = work_queue_.front();
-        work_queue_.pop();
+        did_work |= !work_queue.empty();
 
-        if (pending_task.delayed_run_time != TimePoint())
+        while (!work_queue.empty())
         {
-            // We want to delete delayed tasks in the same order in which they would normally be
-            // deleted in case of any funny dependencies between delayed tasks.
-            addToDelayedWorkQueue(&pending_task);
+            PendingTask pending_task = std::move(work_queue.front());
+            work_queue.pop();
+
+            if (pending_task.delayed_run_time != TimePoint())
+            {
+                // We want to delete delayed tasks in the same order in which they would normally
+                // be deleted in case of any funny dependencies between delayed tasks.
+                addToDelayedWorkQueue(&pending_task);
+            }
         }
     }
 
@@ -281,6 +408,17 @@ MessageLoop::TimePoint MessageLoop::calculateDelayedRuntime(const Milliseconds&
     return delayed_run_time;
 }
 
+// static
+MessageLoop::TimePoint MessageLoop::calculateCoarseDelayedRuntime(const Milliseconds& delay)
+{
+    TimePoint delayed_run_time;
+
+    if (delay > Milliseconds::zero())
+        delayed_run_time = coarseExpiration(Clock::now(), delay);
+
+    return delayed_run_time;
+}
+
 bool MessageLoop::doWork()
 {
     if (!nestable_tasks_allowed_)
@@ -293,32 +431,29 @@ bool MessageLoop::doWork()
     {
         reloadWorkQueue();
 
-        if (work_queue_.empty())
+        TaskQueue* work_queue = nextWorkQueue();
+        if (!work_queue)
             break;
 
-        // Execute oldest task.
-        do
-        {
-            PendingTask pending_task = work_queue_.front();
-            work_queue_.pop();
+        // Execute oldest task with the highest priority.
+        PendingTask pending_task = std::move(work_queue->front());
+        work_queue->pop();
 
-            if (pending_task.delayed_run_time != TimePoint())
-            {
-                const bool reschedule = delayed_work_queue_.empty();
+        if (pending_task.delayed_run_time != TimePoint())
+        {
+            const bool reschedule = delayed_work_queue_.empty();
 
-                addToDelayedWorkQueue(&pending_task);
+            addToDelayedWorkQueue(&pending_task);
 
-                // If we changed the topmost task, then it is time to reschedule.
-                if (reschedule)
-                    pump_->scheduleDelayedWork(pending_task.delayed_run_time);
-            }
-            else
-            {
-                if (deferOrRunPendingTask(pending_task))
-                    return true;
-            }
+            // If we changed the topmost task, then it is time to reschedule.
+            if (reschedule)
+                pump_->scheduleDelayedWork(pending_task.delayed_run_time);
+        }
+        else
+        {
+            if (deferOrRunPendingTask(std::move(pending_task)))
+                return true;
         }
-        while (!work_queue_.empty());
     }
 
     // Nothing happened.
@@ -351,13 +486,15 @@ bool MessageLoop::doDelayedWork(TimePoint* next_delayed_work_time)
         }
     }
 
-    PendingTask pending_task = delayed_work_queue_.top();
+    // The task is moved out of the queue before it is removed. The sort keys are not changed by
+    // the move.
+    PendingTask pending_task = std::move(const_cast<PendingTask&>(delayed_work_queue_.top()));
     delayed_work_queue_.pop();
 
     if (!delayed_work_queue_.empty())
         *next_delayed_work_time = delayed_work_queue_.top().delayed_run_time;
 
-    return deferOrRunPendingTask(pending_task);
+    return deferOrRunPendingTask(std::move(pending_task));
 }
 
 bool MessageLoop::doIdleWork()
@@ -365,7 +502,7 @@ bool MessageLoop::doIdleWork()
     if (deferred_non_nestable_work_queue_.empty())
         return false;
 
-    PendingTask pending_task = deferred_non_nestable_work_queue_.front();
+    PendingTask pending_task = std::move(deferred_non_nestable_work_queue_.front());
     deferred_non_nestable_work_queue_.pop();
 
     runTask(pending_task);
@@ -21,11 +21,14 @@
 
 #include "base/macros_magic.h"
 #include "base/task_runner.h"
+#include "base/message_loop/incoming_task_queue.h"
+#include "base/message_loop/message_loop_stats.h"
 #include "base/message_loop/message_pump.h"
 #include "base/message_loop/message_pump_dispatcher.h"
 #include "base/message_loop/pending_task.h"
 #include "build/build_config.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 
@@ -44,7 +47,11 @@ public:
         DEFAULT,
         ASIO,
 #if defined(OS_WIN)
-        WIN
+        WIN,
+
+        // ASIO handlers and window messages on the same thread (see MessagePumpForWinAsio).
+        // pumpAsio() can be used with the loop.
+        WIN_ASIO
 #endif // defined(OS_WIN)
     };
 
@@ -67,6 +74,15 @@ public:
 
     std::shared_ptr<TaskRunner> taskRunner() const;
 
+    // Enables the statistics of the tasks of the loop. If |log_interval| is not zero, the
+    // statistics are written to the log and reset with this interval. Must be called on the thread
+    // of the loop. The statistics of all loops are also enabled if the environment variable
+    // ASPIA_MESSAGE_LOOP_STATS is set to the log interval in seconds.
+    void enableStats(const std::chrono::milliseconds& log_interval);
+
+    // Returns the statistics or nullptr if they are not enabled.
+    const MessageLoopStats* stats() const { return stats_.get(); }
+
 protected:
     friend class MessageLoopTaskRunner;
     friend class Thread;
@@ -75,10 +91,21 @@ protected:
     using TimePoint = MessagePump::TimePoint;
     using Milliseconds = MessagePump::Milliseconds;
 
-    void postTask(PendingTask::Callback callback);
-    void postDelayedTask(PendingTask::Callback callback, const Milliseconds& delay);
-    void postNonNestableTask(PendingTask::Callback callback);
-    void postNonNestableDelayedTask(PendingTask::Callback callback, const Milliseconds& delay);
+    // |posted_from| is the address of the code which posted the task (for the statistics).
+    void postTask(PendingTask::Callback callback, const void* posted_from = nullptr);
+    void postPriorityTask(PendingTask::Callback callback,
+                          TaskRunner::Priority priority,
+                          const void* posted_from = nullptr);
+    void postDelayedTask(PendingTask::Callback callback,
+                         const Milliseconds& delay,
+                         const void* posted_from = nullptr);
+    void postCoarseDelayedTask(PendingTask::Callback callback,
+                               const Milliseconds& delay,
+                               const void* posted_from = nullptr);
+    void postNonNestableTask(PendingTask::Callback callback, const void* posted_from = nullptr);
+    void postNonNestableDelayedTask(PendingTask::Callback callback,
+                                    const Milliseconds& delay,
+                                    const void* posted_from = nullptr);
 
     PendingTask::Callback quitClosure();
 
@@ -87,7 +114,7 @@ protected:
 
     // Calls RunTask or queues the pending_task on the deferred task list if it cannot be run right
     // now. Returns true if the task was run.
-    bool deferOrRunPendingTask(const PendingTask& pending_task);
+    bool deferOrRunPendingTask(PendingTask&& pending_task);
 
     // Adds the pending task to delayed_work_queue_.
     void addToDelayedWorkQueue(PendingTask* pending_task);
@@ -97,17 +124,28 @@ protected:
     // Caller retains ownership of |pending_task|, but this function will reset the value of
     // pending_task->task. This is needed to ensure that the posting call stack does not retain
     // pending_task->task beyond this function call.
-    void addToIncomingQueue(PendingTask::Callback&& callback, const Milliseconds& delay, bool nestable);
-
-    // Load tasks from the incoming_queue_ into work_queue_ if the latter is empty. The former
-    // requires a lock to access, while the latter is directly accessible on this thread.
+    void addToIncomingQueue(PendingTask::Callback&& callback,
+                            const TimePoint& delayed_run_time,
+                            bool nestable,
+                            TaskRunner::Priority priority,
+                            const void* posted_from);
+
+    // Load tasks from the incoming_queue_ into work_queues_. The former is shared with the posting
+    // threads, while the latter are directly accessible on this thread.
     void reloadWorkQueue();
 
+    // Returns the queue of the next task to run or nullptr if all queues are empty.
+    TaskQueue* nextWorkQueue();
+
     bool deletePendingTasks();
 
     // Calculates the time at which a PendingTask should run.
     static TimePoint calculateDelayedRuntime(const Milliseconds& delay);
 
+    // Same as calculateDelayedRuntime, but the time is rounded up to the timer slack, so that
+    // coarse tasks posted at close moments run in the same wakeup.
+    static TimePoint calculateCoarseDelayedRuntime(const Milliseconds& delay);
+
     // MessagePump::Delegate methods:
     bool doWork() override;
     bool doDelayedWork(TimePoint* next_delayed_work_time) override;
@@ -121,9 +159,13 @@ protected:
     // Contains delayed tasks, sorted by their 'delayed_run_time' property.
     DelayedTaskQueue delayed_work_queue_;
 
-    // A list of tasks that need to be processed by this instance.  Note that this queue is only
-    // accessed (push/pop) by our current thread.
-    TaskQueue work_queue_;
+    // Lists of tasks that need to be processed by this instance, one for each priority. Note that
+    // these queues are only accessed (push/pop) by our current thread.
+    static constexpr size_t kPriorityCount = 3;
+    TaskQueue work_queues_[kPriorityCount];
+
+    // Tasks taken from incoming_queue_ before they are sorted by priority.
+    TaskQueue reload_queue_;
 
     // A queue of non-nestable tasks that we had to defer because when it came time to execute them
     // we were in a nested message loop. They will execute once we're out of nested message loops.
@@ -135,16 +177,22 @@ protected:
 
     std::shared_ptr<MessagePump> pump_;
 
-    TaskQueue incoming_queue_;
-    std::mutex incoming_queue_lock_;
+    IncomingTaskQueue incoming_queue_;
 
     // The next sequence number to use for delayed tasks.
     int next_sequence_num_ = 0;
 
     std::shared_ptr<MessageLoopTaskRunner> proxy_;
 
+    // Created once by enableStats and not changed after that. |stats_enabled_| is checked by the
+    // posting threads.
+    std::unique_ptr<MessageLoopStats> stats_;
+    std::atomic_bool stats_enabled_ = false;
+    Milliseconds stats_log_interval_;
+
 private:
     void quit();
+    void logStats();
 
     DISALLOW_COPY_AND_ASSIGN(MessageLoop);
 };
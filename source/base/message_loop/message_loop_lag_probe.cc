@@ -0,0 +1,47 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/message_loop_lag_probe.h"
+
+#include "base/task_runner.h"
+
+namespace base {
+
+MessageLoopLagProbe::MessageLoopLagProbe(std::shared_ptr<TaskRunner> task_runner,
+                                         const std::chrono::milliseconds& interval)
+    : task_runner_(task_runner),
+      histogram_(std::make_shared<LatencyHistogram>()),
+      timer_(WaitableTimer::Type::REPEATED, std::move(task_runner))
+{
+    timer_.start(interval, std::bind(&MessageLoopLagProbe::onTimer, this));
+}
+
+MessageLoopLagProbe::~MessageLoopLagProbe() = default;
+
+void MessageLoopLagProbe::onTimer()
+{
+    const auto post_time = std::chrono::steady_clock::now();
+
+    task_runner_->postTask([histogram = histogram_, post_time]()
+    {
+        histogram->add(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - post_time));
+    });
+}
+
+} // namespace base
@@ -0,0 +1,57 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MESSAGE_LOOP__MESSAGE_LOOP_LAG_PROBE_H
+#define BASE__MESSAGE_LOOP__MESSAGE_LOOP_LAG_PROBE_H
+
+#include "base/latency_histogram.h"
+#include "base/waitable_timer.h"
+
+#include <memory>
+
+namespace base {
+
+class TaskRunner;
+
+// Measures the lag of a message loop: a task is posted to the loop periodically and the time from
+// posting to running it is added to a histogram. Unlike MessageLoopStats, the histogram is
+// cumulative and can be read from any thread, so it fits monitoring systems.
+class MessageLoopLagProbe
+{
+public:
+    explicit MessageLoopLagProbe(
+        std::shared_ptr<TaskRunner> task_runner,
+        const std::chrono::milliseconds& interval = std::chrono::seconds(1));
+    ~MessageLoopLagProbe();
+
+    LatencyHistogram::Snapshot snapshot() const { return histogram_->snapshot(); }
+
+private:
+    void onTimer();
+
+    std::shared_ptr<TaskRunner> task_runner_;
+    // Shared with the posted tasks which may run after the probe is destroyed.
+    std::shared_ptr<LatencyHistogram> histogram_;
+    WaitableTimer timer_;
+
+    DISALLOW_COPY_AND_ASSIGN(MessageLoopLagProbe);
+};
+
+} // namespace base
+
+#endif // BASE__MESSAGE_LOOP__MESSAGE_LOOP_LAG_PROBE_H
@@ -0,0 +1,156 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/message_loop_stats.h"
+
+#include "base/strings/string_printf.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+size_t bucketIndex(int64_t value)
+{
+    size_t index = 0;
+
+    while (value > 0 && index < MessageLoopStats::Histogram::kBucketCount - 1)
+    {
+        value >>= 1;
+        ++index;
+    }
+
+    return index;
+}
+
+} // namespace
+
+void MessageLoopStats::Histogram::add(const Microseconds& value)
+{
+    const int64_t count = std::max(value.count(), static_cast<int64_t>(0));
+
+    ++buckets_[bucketIndex(count)];
+    ++count_;
+    total_ += static_cast<uint64_t>(count);
+    max_ = std::max(max_, count);
+}
+
+void MessageLoopStats::Histogram::reset()
+{
+    std::fill(std::begin(buckets_), std::end(buckets_), 0);
+    count_ = 0;
+    total_ = 0;
+    max_ = 0;
+}
+
+MessageLoopStats::Microseconds MessageLoopStats::Histogram::mean() const
+{
+    if (!count_)
+        return Microseconds::zero();
+
+    return Microseconds(static_cast<int64_t>(total_ / count_));
+}
+
+MessageLoopStats::Microseconds MessageLoopStats::Histogram::percentile(int percent) const
+{
+    if (!count_)
+        return Microseconds::zero();
+
+    const uint64_t rank = (count_ * static_cast<uint64_t>(percent) + 99) / 100;
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < kBucketCount; ++i)
+    {
+        total += buckets_[i];
+        if (total >= rank)
+        {
+            // The last bucket has no upper bound. The maximum is returned for it.
+            if (i == kBucketCount - 1)
+                return max();
+
+            return std::min(Microseconds((int64_t(1) << i) - 1), max());
+        }
+    }
+
+    return max();
+}
+
+MessageLoopStats::MessageLoopStats()
+    : start_time_(Clock::now())
+{
+    // Nothing
+}
+
+void MessageLoopStats::addQueueDepth(size_t depth)
+{
+    max_queue_depth_ = std::max(max_queue_depth_, depth);
+}
+
+void MessageLoopStats::addTask(
+    const PendingTask& pending_task, const TimePoint& start, const TimePoint& end)
+{
+    // For delayed tasks the wait is counted from the time at which the task should run.
+    const TimePoint ready_time = std::max(pending_task.delayed_run_time, pending_task.post_time);
+
+    if (ready_time != TimePoint())
+        queue_wait_.add(std::chrono::duration_cast<Microseconds>(start - ready_time));
+
+    const Microseconds duration = std::chrono::duration_cast<Microseconds>(end - start);
+
+    if (!run_time_.count() || duration > run_time_.max())
+        longest_task_posted_from_ = pending_task.posted_from;
+
+    run_time_.add(duration);
+}
+
+std::string MessageLoopStats::toString() const
+{
+    const double seconds = std::chrono::duration<double>(Clock::now() - start_time_).count();
+    const uint64_t posts = posts_.load(std::memory_order_relaxed);
+
+    return stringPrintf(
+        "posts/s: %.1f, tasks: %llu, max depth: %zu, "
+        "wait us (mean/p50/p99/max): %lld/%lld/%lld/%lld, "
+        "run us (mean/p50/p99/max): %lld/%lld/%lld/%lld, longest posted from: pc:%p",
+        seconds > 0 ? static_cast<double>(posts) / seconds : 0.0,
+        static_cast<unsigned long long>(run_time_.count()),
+        max_queue_depth_,
+        static_cast<long long>(queue_wait_.mean().count()),
+        static_cast<long long>(queue_wait_.percentile(50).count()),
+        static_cast<long long>(queue_wait_.percentile(99).count()),
+        static_cast<long long>(queue_wait_.max().count()),
+        static_cast<long long>(run_time_.mean().count()),
+        static_cast<long long>(run_time_.percentile(50).count()),
+        static_cast<long long>(run_time_.percentile(99).count()),
+        static_cast<long long>(run_time_.max().count()),
+        longest_task_posted_from_);
+}
+
+void MessageLoopStats::reset()
+{
+    start_time_ = Clock::now();
+    posts_.store(0, std::memory_order_relaxed);
+
+    queue_wait_.reset();
+    run_time_.reset();
+    max_queue_depth_ = 0;
+    longest_task_posted_from_ = nullptr;
+}
+
+} // namespace base
@@ -0,0 +1,107 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MESSAGE_LOOP__MESSAGE_LOOP_STATS_H
+#define BASE__MESSAGE_LOOP__MESSAGE_LOOP_STATS_H
+
+#include "base/macros_magic.h"
+#include "base/message_loop/pending_task.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace base {
+
+// Statistics of the tasks of a message loop: how long the tasks wait in the queue, how long they
+// run and how many tasks are posted. The statistics are collected only if they are enabled for the
+// loop (see MessageLoop::enableStats). All methods except addPost must be called on the thread of
+// the loop.
+class MessageLoopStats
+{
+public:
+    using Clock = PendingTask::Clock;
+    using TimePoint = PendingTask::TimePoint;
+    using Microseconds = std::chrono::microseconds;
+
+    // Histogram with power of two buckets. The bucket N contains the values from 2^(N-1) to 2^N
+    // microseconds, the last bucket also contains all larger values.
+    class Histogram
+    {
+    public:
+        static const size_t kBucketCount = 24;
+
+        void add(const Microseconds& value);
+        void reset();
+
+        uint64_t count() const { return count_; }
+        Microseconds max() const { return Microseconds(max_); }
+        Microseconds mean() const;
+
+        // Returns the upper bound of the bucket which contains the |percent| percentile.
+        Microseconds percentile(int percent) const;
+
+    private:
+        uint64_t buckets_[kBucketCount] = { 0 };
+        uint64_t count_ = 0;
+        uint64_t total_ = 0;
+        int64_t max_ = 0;
+    };
+
+    MessageLoopStats();
+    ~MessageLoopStats() = default;
+
+    // Can be called from any thread.
+    void addPost() { posts_.fetch_add(1, std::memory_order_relaxed); }
+
+    // Called when the loop takes the incoming tasks. |depth| is the number of tasks which are
+    // waiting to run.
+    void addQueueDepth(size_t depth);
+
+    // Called after a task is run. The task was started at |start| and completed at |end|.
+    void addTask(const PendingTask& pending_task, const TimePoint& start, const TimePoint& end);
+
+    const Histogram& queueWait() const { return queue_wait_; }
+    const Histogram& runTime() const { return run_time_; }
+    size_t maxQueueDepth() const { return max_queue_depth_; }
+
+    // Returns the posting address of the longest task (see PendingTask::posted_from).
+    const void* longestTaskPostedFrom() const { return longest_task_posted_from_; }
+
+    // Returns the statistics since the last reset as a single line for the log.
+    std::string toString() const;
+
+    // Starts a new measurement period.
+    void reset();
+
+private:
+    TimePoint start_time_;
+    std::atomic<uint64_t> posts_ = 0;
+
+    Histogram queue_wait_;
+    Histogram run_time_;
+    size_t max_queue_depth_ = 0;
+    const void* longest_task_posted_from_ = nullptr;
+
+    DISALLOW_COPY_AND_ASSIGN(MessageLoopStats);
+};
+
+} // namespace base
+
+#endif // BASE__MESSAGE_LOOP__MESSAGE_LOOP_STATS_H
@@ -0,0 +1,83 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/message_loop_stats.h"
+
+#include "base/message_loop/message_loop.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace base {
+
+using Microseconds = MessageLoopStats::Microseconds;
+
+TEST(MessageLoopStatsTest, Histogram)
+{
+    MessageLoopStats::Histogram histogram;
+
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.percentile(50), Microseconds::zero());
+
+    for (int i = 0; i < 99; ++i)
+        histogram.add(Microseconds(10));
+    histogram.add(Microseconds(5000));
+
+    EXPECT_EQ(histogram.count(), 100u);
+    EXPECT_EQ(histogram.max(), Microseconds(5000));
+    EXPECT_EQ(histogram.mean(), Microseconds((99 * 10 + 5000) / 100));
+
+    // 10 us is in the bucket [8, 15].
+    EXPECT_EQ(histogram.percentile(50), Microseconds(15));
+    EXPECT_EQ(histogram.percentile(99), Microseconds(15));
+    EXPECT_EQ(histogram.percentile(100), Microseconds(5000));
+
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.max(), Microseconds::zero());
+}
+
+TEST(MessageLoopStatsTest, MessageLoop)
+{
+    MessageLoop message_loop;
+    std::shared_ptr<TaskRunner> task_runner = message_loop.taskRunner();
+
+    message_loop.enableStats(std::chrono::milliseconds::zero());
+    ASSERT_NE(message_loop.stats(), nullptr);
+
+    for (int i = 0; i < 10; ++i)
+        task_runner->postTask([]() {});
+
+    task_runner->postTask([]() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+    task_runner->postQuit();
+
+    message_loop.run();
+
+    const MessageLoopStats* stats = message_loop.stats();
+
+    // The quit task is not counted because the loop exits before it is completed.
+    EXPECT_GE(stats->runTime().count(), 11u);
+    EXPECT_GE(stats->runTime().max(), std::chrono::milliseconds(20));
+    EXPECT_EQ(stats->queueWait().count(), stats->runTime().count());
+    EXPECT_GE(stats->maxQueueDepth(), 11u);
+    EXPECT_NE(stats->longestTaskPostedFrom(), nullptr);
+    EXPECT_FALSE(stats->toString().empty());
+}
+
+} // namespace base
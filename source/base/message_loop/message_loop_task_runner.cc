@@ -18,6 +18,8 @@
 
 #include "base/message_loop/message_loop_task_runner.h"
 
+#include "base/compiler_specific.h"
+
 namespace base {
 
 // static
@@ -36,36 +38,54 @@ bool MessageLoopTaskRunner::belongsToCurrentThread() const
     return thread_id_ == std::this_thread::get_id();
 }
 
-void MessageLoopTaskRunner::postTask(Callback callback)
+NOINLINE void MessageLoopTaskRunner::postTask(Callback callback)
+{
+    std::shared_lock lock(loop_lock_);
+
+    if (loop_)
+        loop_->postTask(std::move(callback), RETURN_ADDRESS());
+}
+
+NOINLINE void MessageLoopTaskRunner::postPriorityTask(Callback callback, Priority priority)
+{
+    std::shared_lock lock(loop_lock_);
+
+    if (loop_)
+        loop_->postPriorityTask(std::move(callback), priority, RETURN_ADDRESS());
+}
+
+NOINLINE void MessageLoopTaskRunner::postDelayedTask(Callback callback, const Milliseconds& delay)
 {
     std::shared_lock lock(loop_lock_);
 
     if (loop_)
-        loop_->postTask(std::move(callback));
+        loop_->postDelayedTask(std::move(callback), delay, RETURN_ADDRESS());
 }
 
-void MessageLoopTaskRunner::postDelayedTask(Callback callback, const Milliseconds& delay)
+NOINLINE void MessageLoopTaskRunner::postCoarseDelayedTask(
+    Callback callback, const Milliseconds& delay)
 {
     std::shared_lock lock(loop_lock_);
 
     if (loop_)
-        loop_->postDelayedTask(std::move(callback), delay);
+        loop_->postCoarseDelayedTask(std::move(callback), delay, RETURN_ADDRESS());
 }
 
-void MessageLoopTaskRunner::postNonNestableTask(Callback callback)
+NOINLINE void MessageLoopTaskRunner::postNonNestableTask(Callback callback)
 {
     std::shared_lock lock(loop_lock_);
 
     if (loop_)
-        loop_->postNonNestableTask(std::move(callback));
+        loop_->postNonNestableTask(std::move(callback), RETURN_ADDRESS());
 }
 
-void MessageLoopTaskRunner::postNonNestableDelayedTask(Callback callback, const Milliseconds& delay)
+NOINLINE void MessageLoopTaskRunner::postNonNestableDelayedTask(
+    Callback callback, const Milliseconds& delay)
 {
     std::shared_lock lock(loop_lock_);
 
     if (loop_)
-        loop_->postNonNestableDelayedTask(std::move(callback), delay);
+        loop_->postNonNestableDelayedTask(std::move(callback), delay, RETURN_ADDRESS());
 }
 
 void MessageLoopTaskRunner::postQuit()
@@ -36,7 +36,9 @@ public:
     // TaskRunner implementation.
     bool belongsToCurrentThread() const override;
     void postTask(Callback callback) override;
+    void postPriorityTask(Callback callback, Priority priority) override;
     void postDelayedTask(Callback callback, const Milliseconds& delay) override;
+    void postCoarseDelayedTask(Callback callback, const Milliseconds& delay) override;
     void postNonNestableTask(Callback callback) override;
     void postNonNestableDelayedTask(Callback callback, const Milliseconds& delay) override;
     void postQuit() override;
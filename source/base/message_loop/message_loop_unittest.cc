@@ -0,0 +1,109 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/message_loop.h"
+
+#include "base/timer_slack.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace base {
+
+TEST(MessageLoopTest, RunsHigherPriorityFirst)
+{
+    MessageLoop message_loop;
+    std::shared_ptr<TaskRunner> task_runner = message_loop.taskRunner();
+    std::vector<int> order;
+
+    task_runner->postPriorityTask([&order]() { order.push_back(5); }, TaskRunner::Priority::LOW);
+    task_runner->postTask([&order]() { order.push_back(3); });
+    task_runner->postTask([&order]() { order.push_back(4); });
+    task_runner->postPriorityTask([&order]() { order.push_back(1); }, TaskRunner::Priority::HIGH);
+    task_runner->postPriorityTask([&order]() { order.push_back(2); }, TaskRunner::Priority::HIGH);
+    task_runner->postPriorityTask([&]()
+    {
+        order.push_back(6);
+        task_runner->postQuit();
+    }, TaskRunner::Priority::LOW);
+
+    message_loop.run();
+
+    EXPECT_EQ(order, std::vector<int>({ 1, 2, 3, 4, 5, 6 }));
+}
+
+TEST(MessageLoopTest, LowPriorityTaskIsNotStarved)
+{
+    MessageLoop message_loop;
+    std::shared_ptr<TaskRunner> task_runner = message_loop.taskRunner();
+    bool low_priority_done = false;
+    int normal_count = 0;
+
+    task_runner->postPriorityTask([&low_priority_done]()
+    {
+        low_priority_done = true;
+    }, TaskRunner::Priority::LOW);
+
+    // Each normal task posts the next one, so the normal queue is never empty.
+    std::function<void()> normal_task = [&]()
+    {
+        ++normal_count;
+
+        if (low_priority_done)
+        {
+            task_runner->postQuit();
+            return;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        task_runner->postTask(normal_task);
+    };
+
+    task_runner->postTask(normal_task);
+    message_loop.run();
+
+    EXPECT_TRUE(low_priority_done);
+    EXPECT_GT(normal_count, 1);
+}
+
+TEST(MessageLoopTest, CoarseDelayedTaskRunsAfterDelay)
+{
+    MessageLoop message_loop;
+    std::shared_ptr<TaskRunner> task_runner = message_loop.taskRunner();
+    std::chrono::steady_clock::time_point run_time;
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    task_runner->postCoarseDelayedTask([&]()
+    {
+        run_time = std::chrono::steady_clock::now();
+        task_runner->postQuit();
+    }, std::chrono::milliseconds(500));
+
+    message_loop.run();
+
+    // The task is never run earlier than requested and is delayed by not more than the slack (and
+    // the scheduling latency).
+    EXPECT_GE(run_time - start, std::chrono::milliseconds(500));
+    EXPECT_LT(run_time - start, std::chrono::milliseconds(500) + timerSlack(
+        std::chrono::milliseconds(500)) + std::chrono::milliseconds(100));
+}
+
+} // namespace base
@@ -40,7 +40,7 @@ public:
 
     asio::io_context& ioContext() { return io_context_; }
 
-private:
+protected:
     // This flag is set to false when run() should return.
     bool keep_running_ = true;
 
@@ -49,6 +49,7 @@ private:
     // The time at which we should call doDelayedWork.
     TimePoint delayed_work_time_;
 
+private:
     DISALLOW_COPY_AND_ASSIGN(MessagePumpForAsio);
 };
 
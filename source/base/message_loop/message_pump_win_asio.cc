@@ -0,0 +1,145 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/message_loop/message_pump_win_asio.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// The wait in the completion port is rounded to the system timer resolution anyway.
+const std::chrono::milliseconds kMinMessageCheckInterval { 10 };
+
+// Window messages (including messages sent from other threads, whose senders are blocked) wait
+// no longer than this on an idle thread.
+const std::chrono::milliseconds kMaxMessageCheckInterval { 100 };
+
+} // namespace
+
+void MessagePumpForWinAsio::run(Delegate* delegate)
+{
+    DCHECK(keep_running_) << "Quit must have been called outside of run!";
+
+    asio::executor_work_guard work_guard = asio::make_work_guard(io_context_);
+    message_check_interval_ = kMinMessageCheckInterval;
+
+    for (;;)
+    {
+        bool did_work = processNextWindowsMessage();
+        if (!keep_running_)
+            break;
+
+        did_work |= delegate->doWork();
+        if (!keep_running_)
+            break;
+
+        did_work |= delegate->doDelayedWork(&delayed_work_time_);
+        if (!keep_running_)
+            break;
+
+        // Run the handlers which are ready without waiting.
+        io_context_.restart();
+        did_work |= io_context_.poll() != 0;
+        if (!keep_running_)
+            break;
+
+        if (did_work)
+            continue;
+
+        did_work = delegate->doIdleWork();
+        if (!keep_running_)
+            break;
+
+        if (did_work)
+            continue;
+
+        waitForWork();
+    }
+
+    keep_running_ = true;
+}
+
+bool MessagePumpForWinAsio::processNextWindowsMessage()
+{
+    // If there are sent messages in the queue then PeekMessage internally dispatches the message
+    // and returns false. We return true in this case to ensure that the loop peeks again.
+    const bool sent_messages_in_queue =
+        (HIWORD(GetQueueStatus(QS_SENDMESSAGE)) & QS_SENDMESSAGE) != 0;
+
+    MSG msg;
+
+    if (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE) == FALSE)
+    {
+        if (sent_messages_in_queue)
+            message_check_interval_ = kMinMessageCheckInterval;
+        return sent_messages_in_queue;
+    }
+
+    // More messages are likely to follow (for example, a series of input or timer messages).
+    message_check_interval_ = kMinMessageCheckInterval;
+
+    if (msg.message == WM_QUIT)
+    {
+        // Posted by Thread::stop.
+        keep_running_ = false;
+        return false;
+    }
+
+    TranslateMessage(&msg);
+    DispatchMessageW(&msg);
+    return true;
+}
+
+void MessagePumpForWinAsio::waitForWork()
+{
+    Milliseconds delay = message_check_interval_;
+
+    if (delayed_work_time_ != TimePoint())
+    {
+        Milliseconds delayed_work_delay = std::chrono::duration_cast<Milliseconds>(
+            delayed_work_time_ - Clock::now());
+
+        if (delayed_work_delay <= Milliseconds::zero())
+        {
+            // It looks like delayed_work_time_ indicates a time in the past, so we need to call
+            // doDelayedWork now.
+            delayed_work_time_ = TimePoint();
+            return;
+        }
+
+        delay = std::min(delay, delayed_work_delay);
+    }
+
+    // A message which arrived while the thread was busy is served without waiting.
+    MSG msg;
+    if (PeekMessageW(&msg, nullptr, 0, 0, PM_NOREMOVE) != FALSE)
+        return;
+
+    // Restart the io_context in preparation for a subsequent run_one_for() invocation.
+    io_context_.restart();
+
+    // I/O completions and posted tasks (see scheduleWork) end the wait immediately.
+    if (io_context_.run_one_for(delay) == 0)
+        message_check_interval_ = std::min(message_check_interval_ * 2, kMaxMessageCheckInterval);
+}
+
+} // namespace base
@@ -0,0 +1,58 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__MESSAGE_LOOP__MESSAGE_PUMP_WIN_ASIO_H
+#define BASE__MESSAGE_LOOP__MESSAGE_PUMP_WIN_ASIO_H
+
+#include "base/message_loop/message_pump_asio.h"
+
+#include <Windows.h>
+
+namespace base {
+
+// Serves ASIO handlers and window messages on the same thread, so components which need both
+// (for example, a network session with a message window) do not need a second thread and a proxy
+// between them.
+//
+// The thread waits in the completion port of ASIO, so I/O completions and posted tasks wake it
+// immediately. The completion port and the message queue can not be waited for together: ASIO
+// does not expose its port and the message queue has no waitable handle. The queue is therefore
+// checked on every iteration and between the waits. The check interval is short after a window
+// message and grows while the thread receives none, so an idle thread wakes rarely.
+class MessagePumpForWinAsio : public MessagePumpForAsio
+{
+public:
+    MessagePumpForWinAsio() = default;
+    ~MessagePumpForWinAsio() = default;
+
+    // MessagePump methods:
+    void run(Delegate* delegate) override;
+
+private:
+    // Dispatches one window message. Returns true if there may be more messages.
+    bool processNextWindowsMessage();
+    void waitForWork();
+
+    Milliseconds message_check_interval_;
+
+    DISALLOW_COPY_AND_ASSIGN(MessagePumpForWinAsio);
+};
+
+} // namespace base
+
+#endif // BASE__MESSAGE_LOOP__MESSAGE_PUMP_WIN_ASIO_H
@@ -19,6 +19,8 @@
 #ifndef BASE__MESSAGE_LOOP__PENDING_TASK_H
 #define BASE__MESSAGE_LOOP__PENDING_TASK_H
 
+#include "base/task_runner.h"
+
 #include <chrono>
 #include <functional>
 #include <queue>
@@ -30,7 +32,7 @@ namespace base {
 class PendingTask
 {
 public:
-    using Callback = std::function<void()>;
+    using Callback = TaskRunner::Callback;
     using Clock = std::chrono::high_resolution_clock;
     using TimePoint = std::chrono::time_point<Clock>;
 
@@ -40,6 +42,9 @@ public:
                 int sequence_num = 0);
     ~PendingTask() = default;
 
+    PendingTask(PendingTask&& other) = default;
+    PendingTask& operator=(PendingTask&& other) = default;
+
     // Used to support sorting.
     bool operator<(const PendingTask& other) const;
 
@@ -53,6 +58,19 @@ public:
 
     // OK to dispatch from a nested loop.
     bool nestable;
+
+    // Priority of a task which is not delayed.
+    TaskRunner::Priority priority = TaskRunner::Priority::NORMAL;
+
+    // A task with a lower priority is run before the tasks with a higher priority when its
+    // deadline is passed, so it is not delayed indefinitely. No deadline if not set.
+    TimePoint deadline;
+
+    // The time when the task was posted. Set only if the statistics of the loop are enabled.
+    TimePoint post_time;
+
+    // Address of the code which posted the task (see RETURN_ADDRESS) or nullptr if unknown.
+    const void* posted_from = nullptr;
 };
 
 // Wrapper around std::queue specialized for PendingTask which adds a Swap helper method.
@@ -0,0 +1,141 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/channel_estimator.h"
+
+#include <cstdlib>
+
+namespace base {
+
+namespace {
+
+// Minimum duration of the measurement for one throughput sample.
+const ChannelEstimator::Milliseconds kMinBandwidthInterval(100);
+
+// A change is reported if the value has changed by more than 1/kChangeDivider.
+const int64_t kChangeDivider = 8;
+
+// Changes of the queue delay less than this value are not reported.
+const ChannelEstimator::Milliseconds kMinQueueDelayChange(5);
+
+template <typename T>
+T smooth(T last, T sample, int64_t divider)
+{
+    // Exponentially weighted moving average (the same as for SRTT in RFC 6298).
+    if (last == T())
+        return sample;
+
+    return last + (sample - last) / divider;
+}
+
+bool isSignificant(int64_t last, int64_t current)
+{
+    if (last == current)
+        return false;
+
+    if (!last)
+        return true;
+
+    return std::llabs(current - last) > std::llabs(last) / kChangeDivider;
+}
+
+} // namespace
+
+ChannelEstimator::ChannelEstimator() = default;
+
+ChannelEstimator::~ChannelEstimator() = default;
+
+bool ChannelEstimator::addRttSample(const Milliseconds& rtt)
+{
+    if (rtt < Milliseconds::zero())
+        return false;
+
+    if (estimate_.min_rtt == Milliseconds::zero() || rtt < estimate_.min_rtt)
+        estimate_.min_rtt = rtt;
+
+    estimate_.rtt = smooth(estimate_.rtt, rtt, 8);
+    return checkChanged();
+}
+
+bool ChannelEstimator::addQueueDelaySample(const Milliseconds& delay)
+{
+    if (delay < Milliseconds::zero())
+        return false;
+
+    estimate_.queue_delay = smooth(estimate_.queue_delay, delay, 8);
+    return checkChanged();
+}
+
+void ChannelEstimator::onWriteStarted(const TimePoint& time, bool backlogged)
+{
+    if (!busy_)
+    {
+        busy_ = true;
+        busy_start_ = time;
+        busy_bytes_ = 0;
+    }
+
+    backlogged_ = backlogged;
+}
+
+bool ChannelEstimator::onWriteCompleted(const TimePoint& time, size_t bytes)
+{
+    if (!busy_)
+        return false;
+
+    busy_bytes_ += static_cast<int64_t>(bytes);
+
+    const Milliseconds duration = std::chrono::duration_cast<Milliseconds>(time - busy_start_);
+    bool changed = false;
+
+    // The throughput is measured only while the data is sent continuously. If the queue becomes
+    // empty, then the sender was limited by the application and not by the network.
+    if (duration >= kMinBandwidthInterval)
+    {
+        const int64_t sample = busy_bytes_ * 1000 / duration.count();
+
+        estimate_.bandwidth = smooth(estimate_.bandwidth, sample, 4);
+        changed = checkChanged();
+
+        // Start a new measurement interval.
+        busy_start_ = time;
+        busy_bytes_ = 0;
+    }
+
+    if (!backlogged_)
+        busy_ = false;
+
+    return changed;
+}
+
+bool ChannelEstimator::checkChanged()
+{
+    const bool changed =
+        isSignificant(last_reported_.rtt.count(), estimate_.rtt.count()) ||
+        isSignificant(last_reported_.bandwidth, estimate_.bandwidth) ||
+        (isSignificant(last_reported_.queue_delay.count(), estimate_.queue_delay.count()) &&
+         std::llabs((estimate_.queue_delay - last_reported_.queue_delay).count()) >=
+            kMinQueueDelayChange.count());
+
+    if (changed)
+        last_reported_ = estimate_;
+
+    return changed;
+}
+
+} // namespace base
@@ -0,0 +1,90 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__NET__CHANNEL_ESTIMATOR_H
+#define BASE__NET__CHANNEL_ESTIMATOR_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <cstdint>
+
+namespace base {
+
+// Estimates the round-trip time, the delay of messages in the send queue and the achievable
+// throughput of a network channel.
+class ChannelEstimator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = std::chrono::time_point<Clock>;
+    using Milliseconds = std::chrono::milliseconds;
+
+    struct Estimate
+    {
+        // Smoothed and minimal round-trip time. Zero if there were no measurements.
+        Milliseconds rtt = Milliseconds::zero();
+        Milliseconds min_rtt = Milliseconds::zero();
+
+        // Smoothed time between adding a message to the queue and writing it to the socket.
+        Milliseconds queue_delay = Milliseconds::zero();
+
+        // Throughput in bytes per second measured while the send queue was not empty. Zero if
+        // there were no measurements.
+        int64_t bandwidth = 0;
+    };
+
+    ChannelEstimator();
+    ~ChannelEstimator();
+
+    // Adds the round-trip time measured with keep alive packets.
+    // Returns true if the estimate has changed significantly.
+    bool addRttSample(const Milliseconds& rtt);
+
+    // Adds the delay of the written message in the send queue.
+    // Returns true if the estimate has changed significantly.
+    bool addQueueDelaySample(const Milliseconds& delay);
+
+    // Must be called when a write operation is started. |backlogged| is true if there are more
+    // messages in the queue after the current write operation.
+    void onWriteStarted(const TimePoint& time, bool backlogged);
+
+    // Must be called when a write operation is completed.
+    // Returns true if the estimate has changed significantly.
+    bool onWriteCompleted(const TimePoint& time, size_t bytes);
+
+    const Estimate& estimate() const { return estimate_; }
+
+private:
+    bool checkChanged();
+
+    Estimate estimate_;
+    Estimate last_reported_;
+
+    // Start time of the current period in which the write operations follow each other.
+    TimePoint busy_start_;
+    int64_t busy_bytes_ = 0;
+    bool busy_ = false;
+    bool backlogged_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(ChannelEstimator);
+};
+
+} // namespace base
+
+#endif // BASE__NET__CHANNEL_ESTIMATOR_H
@@ -0,0 +1,100 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/channel_estimator.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+using Milliseconds = ChannelEstimator::Milliseconds;
+
+TEST(ChannelEstimatorTest, Rtt)
+{
+    ChannelEstimator estimator;
+    EXPECT_EQ(estimator.estimate().rtt, Milliseconds::zero());
+
+    EXPECT_TRUE(estimator.addRttSample(Milliseconds(80)));
+    EXPECT_EQ(estimator.estimate().rtt, Milliseconds(80));
+    EXPECT_EQ(estimator.estimate().min_rtt, Milliseconds(80));
+
+    // Small changes are not reported.
+    EXPECT_FALSE(estimator.addRttSample(Milliseconds(88)));
+    EXPECT_EQ(estimator.estimate().rtt, Milliseconds(81));
+
+    bool changed = false;
+    for (int i = 0; i < 10; ++i)
+        changed |= estimator.addRttSample(Milliseconds(40));
+
+    EXPECT_TRUE(changed);
+    EXPECT_EQ(estimator.estimate().min_rtt, Milliseconds(40));
+    EXPECT_LT(estimator.estimate().rtt, Milliseconds(60));
+
+    for (int i = 0; i < 100; ++i)
+        estimator.addRttSample(Milliseconds(200));
+
+    EXPECT_GT(estimator.estimate().rtt, Milliseconds(190));
+    EXPECT_EQ(estimator.estimate().min_rtt, Milliseconds(40));
+}
+
+TEST(ChannelEstimatorTest, QueueDelay)
+{
+    ChannelEstimator estimator;
+
+    // Changes less than 5 ms are not reported.
+    EXPECT_FALSE(estimator.addQueueDelaySample(Milliseconds(2)));
+    EXPECT_TRUE(estimator.addQueueDelaySample(Milliseconds(100)));
+    EXPECT_GT(estimator.estimate().queue_delay, Milliseconds(2));
+}
+
+TEST(ChannelEstimatorTest, Bandwidth)
+{
+    ChannelEstimator estimator;
+    ChannelEstimator::TimePoint time = ChannelEstimator::Clock::now();
+
+    // 100 KB every 10 ms while the queue is not empty gives 10 MB/s.
+    bool changed = false;
+    for (int i = 0; i < 20; ++i)
+    {
+        estimator.onWriteStarted(time, true);
+        time += Milliseconds(10);
+        changed |= estimator.onWriteCompleted(time, 100000);
+    }
+
+    EXPECT_TRUE(changed);
+    EXPECT_EQ(estimator.estimate().bandwidth, 10000000);
+}
+
+TEST(ChannelEstimatorTest, ApplicationLimited)
+{
+    ChannelEstimator estimator;
+    ChannelEstimator::TimePoint time = ChannelEstimator::Clock::now();
+
+    // Single writes with pauses between them do not measure the throughput.
+    for (int i = 0; i < 20; ++i)
+    {
+        estimator.onWriteStarted(time, false);
+        time += Milliseconds(1);
+        EXPECT_FALSE(estimator.onWriteCompleted(time, 1000));
+        time += Milliseconds(100);
+    }
+
+    EXPECT_EQ(estimator.estimate().bandwidth, 0);
+}
+
+} // namespace base
@@ -0,0 +1,477 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/net/datagram_protocol.h"
+
+#include "base/endian_util.h"
+#include "base/logging.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// Header of each packet (all values are big-endian):
+// uint8_t  type           - PacketType.
+// uint8_t  flags          - Flags bitmask.
+// uint16_t fragment_index - Index of the fragment in the message (DATA only).
+// uint16_t fragment_count - Number of fragments in the message (DATA only).
+// uint16_t reserved       - Must be zero.
+// uint32_t sequence       - DATA: the packet number for reliable messages or the message number
+//                           for unreliable ones. ACK: number of the first packet not received.
+//
+// The payload of the ACK packet is a bitmask (uint32_t) of the received packets that follow the
+// first packet not received.
+const size_t kHeaderSize = 12;
+const size_t kAckPayloadSize = sizeof(uint32_t);
+const size_t kMaxPayloadSize = DatagramProtocol::kMaxPacketSize - kHeaderSize;
+const size_t kMaxFragmentCount = 0xFFFF;
+
+// Maximum number of reliable packets sent without acknowledgement.
+const size_t kMaxPacketsInFlight = 256;
+
+// Maximum distance between the expected packet and a packet that can be buffered by the receiver.
+const uint32_t kMaxOutOfOrderPackets = 1024;
+
+// A packet that is not acknowledged after this number of transmissions means the peer is lost.
+const int kMaxTransmissions = 10;
+
+const std::chrono::milliseconds kInitialRetransmissionTimeout{ 500 };
+const std::chrono::milliseconds kMinRetransmissionTimeout{ 100 };
+const std::chrono::milliseconds kMaxRetransmissionTimeout{ 5000 };
+
+enum Flags
+{
+    FLAG_RELIABLE = 1
+};
+
+struct Header
+{
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    uint16_t fragment_index = 0;
+    uint16_t fragment_count = 0;
+    uint32_t sequence = 0;
+};
+
+void writeHeader(const Header& header, uint8_t* out)
+{
+    const uint16_t fragment_index = EndianUtil::toBig(header.fragment_index);
+    const uint16_t fragment_count = EndianUtil::toBig(header.fragment_count);
+    const uint16_t reserved = 0;
+    const uint32_t sequence = EndianUtil::toBig(header.sequence);
+
+    out[0] = header.type;
+    out[1] = header.flags;
+    memcpy(out + 2, &fragment_index, sizeof(fragment_index));
+    memcpy(out + 4, &fragment_count, sizeof(fragment_count));
+    memcpy(out + 6, &reserved, sizeof(reserved));
+    memcpy(out + 8, &sequence, sizeof(sequence));
+}
+
+bool readHeader(const uint8_t* data, size_t size, Header* header)
+{
+    if (size < kHeaderSize)
+        return false;
+
+    uint16_t fragment_index;
+    uint16_t fragment_count;
+    uint16_t reserved;
+    uint32_t sequence;
+
+    memcpy(&fragment_index, data + 2, sizeof(fragment_index));
+    memcpy(&fragment_count, data + 4, sizeof(fragment_count));
+    memcpy(&reserved, data + 6, sizeof(reserved));
+    memcpy(&sequence, data + 8, sizeof(sequence));
+
+    if (reserved)
+        return false;
+
+    header->type = data[0];
+    header->flags = data[1];
+    header->fragment_index = EndianUtil::fromBig(fragment_index);
+    header->fragment_count = EndianUtil::fromBig(fragment_count);
+    header->sequence = EndianUtil::fromBig(sequence);
+    return true;
+}
+
+} // namespace
+
+DatagramProtocol::DatagramProtocol(Delegate* delegate, uint32_t first_sequence)
+    : delegate_(delegate),
+      next_sequence_(first_sequence),
+      rto_(kInitialRetransmissionTimeout),
+      next_message_number_(first_sequence),
+      next_expected_(first_sequence),
+      next_message_expected_(first_sequence)
+{
+    DCHECK(delegate_);
+}
+
+DatagramProtocol::~DatagramProtocol() = default;
+
+// static
+ByteArray DatagramProtocol::createPacket(PacketType type)
+{
+    DCHECK(type == PacketType::HELLO || type == PacketType::PING);
+
+    Header header;
+    header.type = static_cast<uint8_t>(type);
+
+    ByteArray packet(kHeaderSize);
+    writeHeader(header, packet.data());
+    return packet;
+}
+
+// static
+bool DatagramProtocol::packetType(const uint8_t* data, size_t size, PacketType* type)
+{
+    Header header;
+    if (!readHeader(data, size, &header))
+        return false;
+
+    switch (static_cast<PacketType>(header.type))
+    {
+        case PacketType::HELLO:
+        case PacketType::DATA:
+        case PacketType::ACK:
+        case PacketType::PING:
+            *type = static_cast<PacketType>(header.type);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool DatagramProtocol::send(const uint8_t* data, size_t size, bool reliable, const TimePoint& now)
+{
+    if (!data || !size)
+        return false;
+
+    const size_t fragment_count = (size + kMaxPayloadSize - 1) / kMaxPayloadSize;
+    if (fragment_count > kMaxFragmentCount)
+    {
+        LOG(LS_ERROR) << "Too big message: " << size;
+        return false;
+    }
+
+    const uint32_t message_number = reliable ? 0 : next_message_number_++;
+
+    for (size_t i = 0; i < fragment_count; ++i)
+    {
+        const size_t offset = i * kMaxPayloadSize;
+        const size_t payload_size = std::min(size - offset, kMaxPayloadSize);
+
+        Header header;
+        header.type = static_cast<uint8_t>(PacketType::DATA);
+        header.flags = reliable ? FLAG_RELIABLE : 0;
+        header.fragment_index = static_cast<uint16_t>(i);
+        header.fragment_count = static_cast<uint16_t>(fragment_count);
+        header.sequence = reliable ? next_sequence_++ : message_number;
+
+        ByteArray packet(kHeaderSize + payload_size);
+        writeHeader(header, packet.data());
+        memcpy(packet.data() + kHeaderSize, data + offset, payload_size);
+
+        if (reliable)
+            send_queue_.emplace_back(header.sequence, std::move(packet));
+        else
+            delegate_->onSendPacket(packet);
+    }
+
+    if (reliable)
+        flushSendQueue(now);
+
+    return true;
+}
+
+bool DatagramProtocol::onPacket(const uint8_t* data, size_t size, const TimePoint& now)
+{
+    Header header;
+    if (!readHeader(data, size, &header))
+        return false;
+
+    switch (static_cast<PacketType>(header.type))
+    {
+        case PacketType::HELLO:
+        case PacketType::PING:
+            // The connection is handled by the owner. The packets only show that the peer is alive.
+            return true;
+
+        case PacketType::ACK:
+        {
+            if (size != kHeaderSize + kAckPayloadSize)
+                return false;
+
+            uint32_t bitmap;
+            memcpy(&bitmap, data + kHeaderSize, sizeof(bitmap));
+
+            onAck(header.sequence, EndianUtil::fromBig(bitmap), now);
+            return true;
+        }
+
+        case PacketType::DATA:
+        {
+            if (size == kHeaderSize || !header.fragment_count ||
+                header.fragment_index >= header.fragment_count)
+            {
+                return false;
+            }
+
+            IncomingFragment fragment;
+            fragment.index = header.fragment_index;
+            fragment.count = header.fragment_count;
+            fragment.payload.assign(data + kHeaderSize, data + size);
+
+            if (header.flags & FLAG_RELIABLE)
+                return onReliableData(header.sequence, std::move(fragment));
+
+            return onUnreliableData(header.sequence, std::move(fragment));
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool DatagramProtocol::onTimer(const TimePoint& now)
+{
+    for (auto& entry : in_flight_)
+    {
+        OutgoingPacket& packet = entry.second;
+
+        // The timeout doubles with each retransmission of the packet.
+        const int backoff = std::min(packet.transmissions - 1, 4);
+        const Milliseconds timeout = std::min(rto_ * (1 << backoff), kMaxRetransmissionTimeout);
+
+        if (now - packet.sent_time < timeout)
+            continue;
+
+        if (packet.transmissions >= kMaxTransmissions)
+        {
+            LOG(LS_WARNING) << "Packet " << entry.first << " is not acknowledged";
+            return false;
+        }
+
+        transmit(&packet, now);
+    }
+
+    return true;
+}
+
+void DatagramProtocol::flushSendQueue(const TimePoint& now)
+{
+    while (!send_queue_.empty() && in_flight_.size() < kMaxPacketsInFlight)
+    {
+        OutgoingPacket& packet = in_flight_[send_queue_.front().first];
+        packet.data = std::move(send_queue_.front().second);
+        send_queue_.pop_front();
+
+        transmit(&packet, now);
+    }
+}
+
+void DatagramProtocol::transmit(OutgoingPacket* packet, const TimePoint& now)
+{
+    packet->sent_time = now;
+    ++packet->transmissions;
+
+    delegate_->onSendPacket(packet->data);
+}
+
+void DatagramProtocol::onAck(uint32_t sequence, uint32_t bitmap, const TimePoint& now)
+{
+    auto acknowledge = [&](std::map<uint32_t, OutgoingPacket, SequenceLess>::iterator it)
+    {
+        // The round-trip time is measured only for packets that were not retransmitted, because
+        // for others it is unknown which transmission is acknowledged.
+        if (it->second.transmissions == 1)
+            addRttSample(std::chrono::duration_cast<Milliseconds>(now - it->second.sent_time));
+
+        return in_flight_.erase(it);
+    };
+
+    // All packets before |sequence| have been received.
+    auto it = in_flight_.begin();
+    while (it != in_flight_.end() && SequenceLess()(it->first, sequence))
+        it = acknowledge(it);
+
+    for (uint32_t i = 0; i < 32; ++i)
+    {
+        if (!(bitmap & (1u << i)))
+            continue;
+
+        auto packet = in_flight_.find(sequence + 1 + i);
+        if (packet != in_flight_.end())
+            acknowledge(packet);
+    }
+
+    flushSendQueue(now);
+}
+
+void DatagramProtocol::addRttSample(const Milliseconds& rtt)
+{
+    // Calculation of the retransmission timeout as described in RFC 6298.
+    if (!has_rtt_)
+    {
+        srtt_ = rtt;
+        rttvar_ = rtt / 2;
+        has_rtt_ = true;
+    }
+    else
+    {
+        const Milliseconds delta = (srtt_ > rtt) ? (srtt_ - rtt) : (rtt - srtt_);
+
+        rttvar_ = (rttvar_ * 3 + delta) / 4;
+        srtt_ = (srtt_ * 7 + rtt) / 8;
+    }
+
+    rto_ = std::clamp(srtt_ + rttvar_ * 4, kMinRetransmissionTimeout, kMaxRetransmissionTimeout);
+}
+
+void DatagramProtocol::sendAck()
+{
+    uint32_t bitmap = 0;
+
+    for (uint32_t i = 0; i < 32; ++i)
+    {
+        if (out_of_order_.count(next_expected_ + 1 + i))
+            bitmap |= (1u << i);
+    }
+
+    Header header;
+    header.type = static_cast<uint8_t>(PacketType::ACK);
+    header.sequence = next_expected_;
+
+    ByteArray packet(kHeaderSize + kAckPayloadSize);
+    writeHeader(header, packet.data());
+
+    bitmap = EndianUtil::toBig(bitmap);
+    memcpy(packet.data() + kHeaderSize, &bitmap, sizeof(bitmap));
+
+    delegate_->onSendPacket(packet);
+}
+
+bool DatagramProtocol::onReliableData(uint32_t sequence, IncomingFragment&& fragment)
+{
+    // Duplicates are acknowledged again, because the previous acknowledgement could be lost.
+    if (!SequenceLess()(sequence, next_expected_))
+    {
+        // Packets too far ahead are dropped. The sender will retransmit them.
+        if (sequence - next_expected_ >= kMaxOutOfOrderPackets)
+            return true;
+
+        out_of_order_.emplace(sequence, std::move(fragment));
+
+        for (auto it = out_of_order_.find(next_expected_); it != out_of_order_.end();
+             it = out_of_order_.find(next_expected_))
+        {
+            if (!deliverReliableFragment(it->second))
+                return false;
+
+            out_of_order_.erase(it);
+            ++next_expected_;
+        }
+    }
+
+    sendAck();
+    return true;
+}
+
+bool DatagramProtocol::onUnreliableData(uint32_t number, IncomingFragment&& fragment)
+{
+    // The message has already been delivered or dropped.
+    if (SequenceLess()(number, next_message_expected_))
+        return true;
+
+    if (!has_current_message_ || number != current_message_)
+    {
+        // A fragment of an older message than the one being assembled.
+        if (has_current_message_ && SequenceLess()(number, current_message_))
+            return true;
+
+        // The incomplete message is dropped when a fragment of a newer message arrives.
+        if (has_current_message_)
+        {
+            ++lost_messages_;
+            next_message_expected_ = current_message_ + 1;
+        }
+
+        // Messages between the last one and the new one have not been received at all.
+        lost_messages_ += number - next_message_expected_;
+
+        current_message_ = number;
+        has_current_message_ = true;
+        fragments_.assign(fragment.count, ByteArray());
+        fragments_received_ = 0;
+    }
+
+    if (fragment.count != fragments_.size())
+        return false;
+
+    ByteArray& slot = fragments_[fragment.index];
+    if (slot.empty())
+    {
+        slot = std::move(fragment.payload);
+        ++fragments_received_;
+    }
+
+    if (fragments_received_ != fragments_.size())
+        return true;
+
+    ByteArray message;
+    for (const auto& payload : fragments_)
+        message.insert(message.end(), payload.begin(), payload.end());
+
+    has_current_message_ = false;
+    next_message_expected_ = current_message_ + 1;
+    fragments_.clear();
+
+    delegate_->onMessageReceived(message);
+    return true;
+}
+
+bool DatagramProtocol::deliverReliableFragment(const IncomingFragment& fragment)
+{
+    if (fragment.index != next_reliable_fragment_ ||
+        (fragment.index && fragment.count != reliable_fragment_count_))
+    {
+        LOG(LS_ERROR) << "Unexpected fragment " << fragment.index << " of " << fragment.count;
+        return false;
+    }
+
+    if (!fragment.index)
+    {
+        reliable_message_.clear();
+        reliable_fragment_count_ = fragment.count;
+    }
+
+    reliable_message_.insert(
+        reliable_message_.end(), fragment.payload.begin(), fragment.payload.end());
+    ++next_reliable_fragment_;
+
+    if (next_reliable_fragment_ != reliable_fragment_count_)
+        return true;
+
+    next_reliable_fragment_ = 0;
+    delegate_->onMessageReceived(reliable_message_);
+    return true;
+}
+
+} // namespace base
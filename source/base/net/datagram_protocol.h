@@ -0,0 +1,166 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#ifndef BASE__NET__DATAGRAM_PROTOCOL_H
+#define BASE__NET__DATAGRAM_PROTOCOL_H
+
+#include "base/macros_magic.h"
+#include "base/memory/byte_array.h"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace base {
+
+// Message delivery over datagrams. Messages are split into packets of at most kMaxPacketSize
+// bytes. Reliable messages are numbered, acknowledged by the receiver and retransmitted on loss;
+// they are delivered in the order of sending. Unreliable messages are never retransmitted: if a
+// packet of the message is lost or a newer message is completed first, the message is dropped.
+// Reliable and unreliable messages are independent of each other, so a loss of a packet of one
+// kind does not delay the other.
+//
+// The class does not perform any I/O. Packets to be sent are passed to the delegate, received
+// packets and timer ticks are passed to the class by the owner.
+class DatagramProtocol
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = std::chrono::time_point<Clock>;
+    using Milliseconds = std::chrono::milliseconds;
+
+    // Maximum size of a packet. It fits into the MTU of most networks, including tunnels.
+    static constexpr size_t kMaxPacketSize = 1200;
+
+    enum class PacketType : uint8_t
+    {
+        HELLO = 1, // Connection request and response.
+        DATA  = 2, // Fragment of a message.
+        ACK   = 3, // Acknowledgement of reliable packets.
+        PING  = 4  // Keeps the connection alive if there is no other traffic.
+    };
+
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        virtual void onSendPacket(const ByteArray& packet) = 0;
+        virtual void onMessageReceived(const ByteArray& message) = 0;
+    };
+
+    // |first_sequence| is the number of the first packet and message. Both peers must use the same
+    // number.
+    explicit DatagramProtocol(Delegate* delegate, uint32_t first_sequence = 0);
+    ~DatagramProtocol();
+
+    // Creates a packet without payload (HELLO or PING).
+    static ByteArray createPacket(PacketType type);
+
+    // Returns the type of the packet or false if the packet is invalid.
+    static bool packetType(const uint8_t* data, size_t size, PacketType* type);
+
+    // Splits the message into packets and sends them. Returns false if the message is empty or
+    // too large.
+    bool send(const uint8_t* data, size_t size, bool reliable, const TimePoint& now);
+
+    // Processes the received packet. Returns false if the packet violates the protocol.
+    bool onPacket(const uint8_t* data, size_t size, const TimePoint& now);
+
+    // Retransmits the reliable packets which were not acknowledged in time. Must be called
+    // periodically. Returns false if a packet was retransmitted too many times.
+    bool onTimer(const TimePoint& now);
+
+    // Number of reliable packets that are sent but not acknowledged or wait to be sent.
+    size_t pendingPackets() const { return in_flight_.size() + send_queue_.size(); }
+
+    // Number of unreliable messages that have been lost.
+    uint64_t lostMessages() const { return lost_messages_; }
+
+    const Milliseconds& retransmissionTimeout() const { return rto_; }
+
+private:
+    // Orders the numbers of packets and messages which wrap around (serial number arithmetic, see
+    // RFC 1982). The numbers compared are always within a small window.
+    struct SequenceLess
+    {
+        bool operator()(uint32_t a, uint32_t b) const
+        {
+            return static_cast<int32_t>(a - b) < 0;
+        }
+    };
+
+    struct OutgoingPacket
+    {
+        ByteArray data;
+        TimePoint sent_time;
+        int transmissions = 0;
+    };
+
+    struct IncomingFragment
+    {
+        uint16_t index;
+        uint16_t count;
+        ByteArray payload;
+    };
+
+    void flushSendQueue(const TimePoint& now);
+    void transmit(OutgoingPacket* packet, const TimePoint& now);
+    void onAck(uint32_t sequence, uint32_t bitmap, const TimePoint& now);
+    void addRttSample(const Milliseconds& rtt);
+    void sendAck();
+
+    bool onReliableData(uint32_t sequence, IncomingFragment&& fragment);
+    bool onUnreliableData(uint32_t number, IncomingFragment&& fragment);
+    bool deliverReliableFragment(const IncomingFragment& fragment);
+
+    Delegate* delegate_;
+
+    // Sender of reliable packets.
+    uint32_t next_sequence_;
+    std::map<uint32_t, OutgoingPacket, SequenceLess> in_flight_;
+    std::deque<std::pair<uint32_t, ByteArray>> send_queue_;
+    Milliseconds srtt_ = Milliseconds::zero();
+    Milliseconds rttvar_ = Milliseconds::zero();
+    Milliseconds rto_;
+    bool has_rtt_ = false;
+
+    // Sender of unreliable messages.
+    uint32_t next_message_number_;
+
+    // Receiver of reliable packets.
+    uint32_t next_expected_;
+    std::map<uint32_t, IncomingFragment, SequenceLess> out_of_order_;
+    ByteArray reliable_message_;
+    uint16_t next_reliable_fragment_ = 0;
+    uint16_t reliable_fragment_count_ = 0;
+
+    // Receiver of unreliable messages.
+    uint32_t next_message_expected_;
+    uint32_t current_message_ = 0;
+    bool has_current_message_ = false;
+    std::vector<ByteArray> fragments_;
+    size_t fragments_received_ = 0;
+    uint64_t lost_messages_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(DatagramProtocol);
+};
+
+} // namespace base
+
+#endif // BASE__NET__DATAGRAM_PROTOCOL_H
@@ -0,0 +1,261 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/net/datagram_protocol.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+class Peer : public DatagramProtocol::Delegate
+{
+public:
+    explicit Peer(uint32_t first_sequence = 0)
+        : protocol(this, first_sequence)
+    {
+        // Nothing
+    }
+
+    void onSendPacket(const ByteArray& packet) override
+    {
+        sent.emplace_back(packet);
+    }
+
+    void onMessageReceived(const ByteArray& message) override
+    {
+        received.emplace_back(message);
+    }
+
+    DatagramProtocol protocol;
+    std::vector<ByteArray> sent;
+    std::vector<ByteArray> received;
+};
+
+// Passes the packets sent by |from| to |to|. Packets for which |drop| returns true are lost.
+template <class Predicate>
+void transfer(Peer* from, Peer* to, const DatagramProtocol::TimePoint& now, Predicate drop)
+{
+    std::vector<ByteArray> packets;
+    packets.swap(from->sent);
+
+    for (size_t i = 0; i < packets.size(); ++i)
+    {
+        if (drop(i))
+            continue;
+
+        EXPECT_TRUE(to->protocol.onPacket(packets[i].data(), packets[i].size(), now));
+    }
+}
+
+void transfer(Peer* from, Peer* to, const DatagramProtocol::TimePoint& now)
+{
+    transfer(from, to, now, [](size_t) { return false; });
+}
+
+ByteArray makeMessage(size_t size, uint8_t seed)
+{
+    ByteArray message(size);
+    for (size_t i = 0; i < size; ++i)
+        message[i] = static_cast<uint8_t>(seed + i);
+    return message;
+}
+
+} // namespace
+
+TEST(DatagramProtocolTest, PacketType)
+{
+    ByteArray packet = DatagramProtocol::createPacket(DatagramProtocol::PacketType::HELLO);
+
+    DatagramProtocol::PacketType type;
+    ASSERT_TRUE(DatagramProtocol::packetType(packet.data(), packet.size(), &type));
+    EXPECT_EQ(type, DatagramProtocol::PacketType::HELLO);
+
+    EXPECT_FALSE(DatagramProtocol::packetType(packet.data(), 3, &type));
+
+    packet[0] = 100;
+    EXPECT_FALSE(DatagramProtocol::packetType(packet.data(), packet.size(), &type));
+}
+
+TEST(DatagramProtocolTest, Reliable)
+{
+    Peer sender;
+    Peer receiver;
+    DatagramProtocol::TimePoint now = DatagramProtocol::Clock::now();
+
+    ByteArray small = makeMessage(100, 1);
+    ByteArray large = makeMessage(10000, 2);
+
+    ASSERT_TRUE(sender.protocol.send(small.data(), small.size(), true, now));
+    ASSERT_TRUE(sender.protocol.send(large.data(), large.size(), true, now));
+
+    EXPECT_GT(sender.sent.size(), 2u);
+    for (const auto& packet : sender.sent)
+        EXPECT_LE(packet.size(), DatagramProtocol::kMaxPacketSize);
+
+    transfer(&sender, &receiver, now);
+
+    ASSERT_EQ(receiver.received.size(), 2u);
+    EXPECT_EQ(receiver.received[0], small);
+    EXPECT_EQ(receiver.received[1], large);
+
+    EXPECT_NE(sender.protocol.pendingPackets(), 0u);
+    transfer(&receiver, &sender, now);
+    EXPECT_EQ(sender.protocol.pendingPackets(), 0u);
+}
+
+TEST(DatagramProtocolTest, ReliableWithLoss)
+{
+    Peer sender;
+    Peer receiver;
+    DatagramProtocol::TimePoint now = DatagramProtocol::Clock::now();
+
+    ByteArray first = makeMessage(5000, 3);
+    ByteArray second = makeMessage(3000, 4);
+
+    ASSERT_TRUE(sender.protocol.send(first.data(), first.size(), true, now));
+    ASSERT_TRUE(sender.protocol.send(second.data(), second.size(), true, now));
+
+    // Every second packet is lost.
+    transfer(&sender, &receiver, now, [](size_t index) { return index % 2 == 0; });
+    EXPECT_TRUE(receiver.received.empty());
+
+    transfer(&receiver, &sender, now);
+
+    // Nothing is retransmitted before the timeout.
+    EXPECT_TRUE(sender.protocol.onTimer(now));
+    EXPECT_TRUE(sender.sent.empty());
+
+    now += sender.protocol.retransmissionTimeout();
+    EXPECT_TRUE(sender.protocol.onTimer(now));
+    EXPECT_FALSE(sender.sent.empty());
+
+    transfer(&sender, &receiver, now);
+
+    // The messages are delivered in order.
+    ASSERT_EQ(receiver.received.size(), 2u);
+    EXPECT_EQ(receiver.received[0], first);
+    EXPECT_EQ(receiver.received[1], second);
+
+    transfer(&receiver, &sender, now);
+    EXPECT_EQ(sender.protocol.pendingPackets(), 0u);
+}
+
+TEST(DatagramProtocolTest, PeerLost)
+{
+    Peer sender;
+    DatagramProtocol::TimePoint now = DatagramProtocol::Clock::now();
+
+    ByteArray message = makeMessage(100, 5);
+    ASSERT_TRUE(sender.protocol.send(message.data(), message.size(), true, now));
+
+    bool result = true;
+    for (int i = 0; i < 20 && result; ++i)
+    {
+        now += std::chrono::seconds(5);
+        result = sender.protocol.onTimer(now);
+    }
+
+    EXPECT_FALSE(result);
+}
+
+TEST(DatagramProtocolTest, Unreliable)
+{
+    Peer sender;
+    Peer receiver;
+    DatagramProtocol::TimePoint now = DatagramProtocol::Clock::now();
+
+    ByteArray first = makeMessage(3000, 6);
+    ByteArray second = makeMessage(3000, 7);
+    ByteArray third = makeMessage(500, 8);
+
+    ASSERT_TRUE(sender.protocol.send(first.data(), first.size(), false, now));
+    ASSERT_TRUE(sender.protocol.send(second.data(), second.size(), false, now));
+    ASSERT_TRUE(sender.protocol.send(third.data(), third.size(), false, now));
+
+    // One packet of the second message is lost.
+    const size_t lost_index = (first.size() + DatagramProtocol::kMaxPacketSize - 1) /
+        DatagramProtocol::kMaxPacketSize;
+    transfer(&sender, &receiver, now, [lost_index](size_t index) { return index == lost_index; });
+
+    ASSERT_EQ(receiver.received.size(), 2u);
+    EXPECT_EQ(receiver.received[0], first);
+    EXPECT_EQ(receiver.received[1], third);
+    EXPECT_EQ(receiver.protocol.lostMessages(), 1u);
+
+    // Unreliable messages are not acknowledged and not retransmitted.
+    EXPECT_TRUE(receiver.sent.empty());
+    EXPECT_EQ(sender.protocol.pendingPackets(), 0u);
+}
+
+TEST(DatagramProtocolTest, SequenceWrap)
+{
+    // The numbers of the packets and the messages wrap around in the middle of the transfer.
+    const uint32_t first_sequence = 0xFFFFFFFE;
+
+    Peer sender(first_sequence);
+    Peer receiver(first_sequence);
+    DatagramProtocol::TimePoint now = DatagramProtocol::Clock::now();
+
+    ByteArray first = makeMessage(5000, 9);
+    ByteArray second = makeMessage(3000, 10);
+
+    ASSERT_TRUE(sender.protocol.send(first.data(), first.size(), true, now));
+    ASSERT_TRUE(sender.protocol.send(second.data(), second.size(), true, now));
+
+    // The packets after the wrap are received before the lost packets before it.
+    transfer(&sender, &receiver, now, [](size_t index) { return index < 2; });
+    EXPECT_TRUE(receiver.received.empty());
+
+    transfer(&receiver, &sender, now);
+    EXPECT_EQ(sender.protocol.pendingPackets(), 2u);
+
+    now += sender.protocol.retransmissionTimeout();
+    EXPECT_TRUE(sender.protocol.onTimer(now));
+    transfer(&sender, &receiver, now);
+
+    ASSERT_EQ(receiver.received.size(), 2u);
+    EXPECT_EQ(receiver.received[0], first);
+    EXPECT_EQ(receiver.received[1], second);
+
+    transfer(&receiver, &sender, now);
+    EXPECT_EQ(sender.protocol.pendingPackets(), 0u);
+
+    receiver.received.clear();
+
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        ByteArray message = makeMessage(100, i);
+        ASSERT_TRUE(sender.protocol.send(message.data(), message.size(), false, now));
+    }
+
+    transfer(&sender, &receiver, now);
+    EXPECT_EQ(receiver.received.size(), 4u);
+    EXPECT_EQ(receiver.protocol.lostMessages(), 0u);
+}
+
+TEST(DatagramProtocolTest, InvalidMessage)
+{
+    Peer sender;
+    DatagramProtocol::TimePoint now = DatagramProtocol::Clock::now();
+
+    EXPECT_FALSE(sender.protocol.send(nullptr, 0, true, now));
+    EXPECT_TRUE(sender.sent.empty());
+}
+
+} // namespace base
@@ -0,0 +1,179 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__NET__HANDLER_ALLOCATOR_H
+#define BASE__NET__HANDLER_ALLOCATOR_H
+
+#include "base/macros_magic.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace base {
+
+// Memory for the handlers of a chain of asynchronous operations. Asio allocates the state of each
+// operation (with the handler) when the operation is started and frees it before the handler is
+// called. If only one operation of the chain is pending at a time (for example, the read loop of a
+// channel), the same block is reused for every operation and no heap allocation is made.
+// Not thread-safe: the operations must be completed in the same thread.
+class HandlerMemory
+{
+public:
+    HandlerMemory() = default;
+    ~HandlerMemory() = default;
+
+    void* allocate(size_t size)
+    {
+        if (!in_use_ && size <= sizeof(storage_))
+        {
+            in_use_ = true;
+            return &storage_;
+        }
+
+        // The block is busy or too small. The operation gets memory from the heap.
+        return ::operator new(size);
+    }
+
+    void deallocate(void* pointer)
+    {
+        if (pointer == &storage_)
+        {
+            in_use_ = false;
+            return;
+        }
+
+        ::operator delete(pointer);
+    }
+
+private:
+    static const size_t kSize = 1024;
+
+    std::aligned_storage_t<kSize> storage_;
+    bool in_use_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(HandlerMemory);
+};
+
+// Allocator which is used by asio for the operations of a handler created by makeAllocatingHandler.
+template <typename T>
+class HandlerAllocator
+{
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory& memory)
+        : memory_(memory)
+    {
+        // Nothing
+    }
+
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U>& other) noexcept
+        : memory_(other.memory_)
+    {
+        // Nothing
+    }
+
+    bool operator==(const HandlerAllocator& other) const noexcept
+    {
+        return &memory_ == &other.memory_;
+    }
+
+    bool operator!=(const HandlerAllocator& other) const noexcept
+    {
+        return &memory_ != &other.memory_;
+    }
+
+    T* allocate(size_t count) const
+    {
+        return static_cast<T*>(memory_.allocate(sizeof(T) * count));
+    }
+
+    void deallocate(T* pointer, size_t /* count */) const
+    {
+        memory_.deallocate(pointer);
+    }
+
+private:
+    template <typename> friend class HandlerAllocator;
+
+    HandlerMemory& memory_;
+};
+
+// Wrapper for a handler which tells asio to allocate the operations from |memory|.
+template <typename Handler>
+class AllocatingHandler
+{
+public:
+    using allocator_type = HandlerAllocator<Handler>;
+
+    AllocatingHandler(HandlerMemory& memory, Handler handler)
+        : memory_(memory),
+          handler_(std::move(handler))
+    {
+        // Nothing
+    }
+
+    // The handler shares the ownership of |memory|. The operation may be completed after the owner
+    // of the memory is destroyed (for example, a cancelled read of a destroyed channel).
+    AllocatingHandler(std::shared_ptr<HandlerMemory> memory, Handler handler)
+        : memory_(*memory),
+          owner_(std::move(memory)),
+          handler_(std::move(handler))
+    {
+        // Nothing
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(memory_);
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args)
+    {
+        handler_(std::forward<Args>(args)...);
+    }
+
+private:
+    HandlerMemory& memory_;
+    std::shared_ptr<HandlerMemory> owner_;
+    Handler handler_;
+};
+
+template <typename Handler>
+AllocatingHandler<std::decay_t<Handler>> makeAllocatingHandler(
+    HandlerMemory& memory, Handler&& handler)
+{
+    return AllocatingHandler<std::decay_t<Handler>>(memory, std::forward<Handler>(handler));
+}
+
+template <typename Handler>
+AllocatingHandler<std::decay_t<Handler>> makeAllocatingHandler(
+    std::shared_ptr<HandlerMemory> memory, Handler&& handler)
+{
+    return AllocatingHandler<std::decay_t<Handler>>(
+        std::move(memory), std::forward<Handler>(handler));
+}
+
+} // namespace base
+
+#endif // BASE__NET__HANDLER_ALLOCATOR_H
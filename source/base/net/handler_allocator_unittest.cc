@@ -0,0 +1,90 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/handler_allocator.h"
+
+#include <asio/io_context.hpp>
+#include <asio/post.hpp>
+
+#include <functional>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(HandlerAllocatorTest, ReusesMemory)
+{
+    HandlerMemory memory;
+    HandlerAllocator<int> allocator(memory);
+
+    int* first = allocator.allocate(1);
+    allocator.deallocate(first, 1);
+
+    // The block is free again and is returned for the next operation.
+    int* second = allocator.allocate(1);
+    EXPECT_EQ(first, second);
+
+    // The block is busy. The memory is taken from the heap.
+    int* third = allocator.allocate(1);
+    EXPECT_NE(second, third);
+
+    allocator.deallocate(third, 1);
+    allocator.deallocate(second, 1);
+}
+
+TEST(HandlerAllocatorTest, Chain)
+{
+    asio::io_context io_context;
+    HandlerMemory memory;
+    int count = 0;
+
+    std::function<void()> handler = [&]()
+    {
+        if (++count < 10)
+            asio::post(io_context, makeAllocatingHandler(memory, handler));
+    };
+
+    asio::post(io_context, makeAllocatingHandler(memory, handler));
+    io_context.run();
+
+    EXPECT_EQ(count, 10);
+}
+
+TEST(HandlerAllocatorTest, SharedMemoryOutlivesOwner)
+{
+    asio::io_context io_context;
+    std::weak_ptr<HandlerMemory> weak_memory;
+    bool called = false;
+
+    {
+        auto memory = std::make_shared<HandlerMemory>();
+        weak_memory = memory;
+        asio::post(io_context, makeAllocatingHandler(memory, [&]() { called = true; }));
+    }
+
+    // The pending operation keeps the memory alive.
+    EXPECT_FALSE(weak_memory.expired());
+
+    io_context.run();
+
+    EXPECT_TRUE(called);
+    EXPECT_TRUE(weak_memory.expired());
+}
+
+} // namespace base
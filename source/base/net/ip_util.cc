@@ -43,4 +43,17 @@ bool isValidIpV6Address(std::u16string_view address)
     return inet_pton(AF_INET6, base::local8BitFromUtf16(address).c_str(), &(sa.sin6_addr)) != 0;
 }
 
+bool isPrivateIpV4Address(std::u16string_view address)
+{
+    struct sockaddr_in sa;
+    if (inet_pton(AF_INET, base::local8BitFromUtf16(address).c_str(), &(sa.sin_addr)) != 1)
+        return false;
+
+    const uint32_t ip = ntohl(sa.sin_addr.s_addr);
+
+    return (ip & 0xFF000000) == 0x0A000000 || // 10.0.0.0/8
+           (ip & 0xFFF00000) == 0xAC100000 || // 172.16.0.0/12
+           (ip & 0xFFFF0000) == 0xC0A80000;   // 192.168.0.0/16
+}
+
 } // namespace base
@@ -26,6 +26,9 @@ namespace base {
 bool isValidIpV4Address(std::u16string_view address);
 bool isValidIpV6Address(std::u16string_view address);
 
+// Returns true if |address| is an IPv4 address from the private ranges (RFC 1918).
+bool isPrivateIpV4Address(std::u16string_view address);
+
 } // namespace base
 
 #endif // BASE__NET__IP_UTIL_H
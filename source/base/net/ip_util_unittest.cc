@@ -0,0 +1,46 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/ip_util.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(IpUtilTest, PrivateIpV4Address)
+{
+    EXPECT_TRUE(isPrivateIpV4Address(u"10.0.0.1"));
+    EXPECT_TRUE(isPrivateIpV4Address(u"10.255.255.255"));
+    EXPECT_TRUE(isPrivateIpV4Address(u"172.16.0.1"));
+    EXPECT_TRUE(isPrivateIpV4Address(u"172.31.255.254"));
+    EXPECT_TRUE(isPrivateIpV4Address(u"192.168.1.10"));
+
+    EXPECT_FALSE(isPrivateIpV4Address(u"172.32.0.1"));
+    EXPECT_FALSE(isPrivateIpV4Address(u"172.15.255.255"));
+    EXPECT_FALSE(isPrivateIpV4Address(u"192.169.0.1"));
+    EXPECT_FALSE(isPrivateIpV4Address(u"8.8.8.8"));
+    EXPECT_FALSE(isPrivateIpV4Address(u"127.0.0.1"));
+    EXPECT_FALSE(isPrivateIpV4Address(u"169.254.1.1"));
+
+    EXPECT_FALSE(isPrivateIpV4Address(u""));
+    EXPECT_FALSE(isPrivateIpV4Address(u"10.0.0"));
+    EXPECT_FALSE(isPrivateIpV4Address(u"fd00::1"));
+    EXPECT_FALSE(isPrivateIpV4Address(u"host.example.com"));
+}
+
+} // namespace base
@@ -0,0 +1,190 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/keep_alive_wheel.h"
+
+#include "base/logging.h"
+#include "base/strings/unicode.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// Keep alive intervals and timeouts of the channels are up to several minutes, so all of them fit
+// into one revolution of the wheel.
+const size_t kSlotCount = 512;
+
+// Returns the number of ticks after which a timer with |delay| expires. The current tick is already
+// in progress, so one more tick is added to not expire the timer too early.
+size_t ticksForDelay(const KeepAliveWheel::Clock::duration& delay)
+{
+    const auto tick = std::chrono::duration_cast<KeepAliveWheel::Clock::duration>(
+        KeepAliveWheel::kTickInterval);
+    return static_cast<size_t>((std::max(delay.count(), int64_t(0)) + tick.count() - 1) /
+        tick.count()) + 1;
+}
+
+} // namespace
+
+// static
+const std::chrono::seconds KeepAliveWheel::kTickInterval { 1 };
+
+KeepAliveWheel::Timer::Timer(Callback callback)
+    : callback_(std::move(callback))
+{
+    DCHECK(callback_);
+}
+
+KeepAliveWheel::Timer::~Timer()
+{
+    stop();
+}
+
+void KeepAliveWheel::Timer::start(asio::io_context& io_context,
+                                  const std::chrono::milliseconds& delay)
+{
+    if (!wheel_)
+        wheel_ = KeepAliveWheel::forCurrentThread(io_context);
+
+    wheel_->add(this, delay);
+}
+
+void KeepAliveWheel::Timer::stop()
+{
+    if (wheel_)
+        wheel_->remove(this);
+}
+
+KeepAliveWheel::KeepAliveWheel(asio::io_context& io_context)
+    : io_context_(io_context),
+      timer_(io_context),
+      wheel_(kSlotCount)
+{
+    // Nothing
+}
+
+KeepAliveWheel::~KeepAliveWheel()
+{
+    DCHECK_EQ(active_count_, 0U);
+}
+
+// static
+std::shared_ptr<KeepAliveWheel> KeepAliveWheel::forCurrentThread(asio::io_context& io_context)
+{
+    thread_local std::weak_ptr<KeepAliveWheel> current_wheel;
+
+    std::shared_ptr<KeepAliveWheel> wheel = current_wheel.lock();
+    if (!wheel || &wheel->io_context_ != &io_context)
+    {
+        wheel.reset(new KeepAliveWheel(io_context));
+        current_wheel = wheel;
+    }
+
+    return wheel;
+}
+
+void KeepAliveWheel::add(Timer* timer, const std::chrono::milliseconds& delay)
+{
+    remove(timer);
+
+    timer->expiration_ = Clock::now() + delay;
+    timer->active_ = true;
+    ++active_count_;
+
+    wheel_.schedule(timer, ticksForDelay(delay));
+
+    if (!ticking_)
+        doTick();
+}
+
+void KeepAliveWheel::remove(Timer* timer)
+{
+    if (!timer->active_)
+        return;
+
+    TimerWheel::cancel(timer);
+    std::replace(expired_.begin(), expired_.end(), timer, static_cast<Timer*>(nullptr));
+
+    timer->active_ = false;
+    DCHECK_GT(active_count_, 0U);
+    --active_count_;
+}
+
+void KeepAliveWheel::doTick()
+{
+    ticking_ = true;
+
+    timer_.expires_after(kTickInterval);
+    timer_.async_wait([wheel = weak_from_this()](const std::error_code& error_code)
+    {
+        std::shared_ptr<KeepAliveWheel> self = wheel.lock();
+        if (self)
+            self->onTick(error_code);
+    });
+}
+
+void KeepAliveWheel::onTick(const std::error_code& error_code)
+{
+    if (error_code == asio::error::operation_aborted)
+        return;
+
+    if (error_code)
+        LOG(LS_ERROR) << "Keep alive timer error: " << utf16FromLocal8Bit(error_code.message());
+
+    // The callbacks can destroy the channels, so the wheel must live until the end of the tick.
+    std::shared_ptr<KeepAliveWheel> self = shared_from_this();
+
+    DCHECK(expired_.empty());
+    for (TimerWheel::Item* item : wheel_.advance())
+        expired_.emplace_back(static_cast<Timer*>(item));
+
+    const Clock::time_point now = Clock::now();
+
+    for (size_t i = 0; i < expired_.size(); ++i)
+    {
+        Timer* timer = expired_[i];
+        if (!timer)
+            continue;
+
+        expired_[i] = nullptr;
+
+        // A timer which is longer than one revolution of the wheel is moved to its next slot.
+        if (timer->expiration_ > now)
+        {
+            wheel_.schedule(timer, ticksForDelay(timer->expiration_ - now));
+            continue;
+        }
+
+        timer->active_ = false;
+        --active_count_;
+
+        timer->callback_();
+    }
+
+    expired_.clear();
+
+    // The wheel does not wake up the thread if there are no timers.
+    if (active_count_)
+        doTick();
+    else
+        ticking_ = false;
+}
+
+} // namespace base
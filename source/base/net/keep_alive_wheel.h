@@ -0,0 +1,102 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__NET__KEEP_ALIVE_WHEEL_H
+#define BASE__NET__KEEP_ALIVE_WHEEL_H
+
+#include "base/timer_wheel.h"
+
+#include <asio/steady_timer.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace base {
+
+// Shared timer for the keep alive of the channels of one thread. Each channel has a small timer
+// item in the wheel instead of its own asio timer, and the wheel ticks once a second while at least
+// one timer is started. Keep alive timers do not need to be precise, so the expiration of each
+// timer is rounded up to a whole tick and the timers of all channels are served by one wakeup.
+// The wheel is not thread-safe: timers must be used on the thread where they were started.
+class KeepAliveWheel : public std::enable_shared_from_this<KeepAliveWheel>
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    class Timer : public TimerWheel::Item
+    {
+    public:
+        explicit Timer(Callback callback);
+        ~Timer();
+
+        // Calls the callback once after |delay|. If the timer is already started, it is restarted.
+        void start(asio::io_context& io_context, const std::chrono::milliseconds& delay);
+        void stop();
+
+        bool isActive() const { return active_; }
+
+    private:
+        friend class KeepAliveWheel;
+
+        Callback callback_;
+        Clock::time_point expiration_;
+        bool active_ = false;
+
+        // The wheel is kept while the timer exists, so the wheel of the thread is not recreated
+        // each time the timer is restarted.
+        std::shared_ptr<KeepAliveWheel> wheel_;
+
+        DISALLOW_COPY_AND_ASSIGN(Timer);
+    };
+
+    ~KeepAliveWheel();
+
+    static const std::chrono::seconds kTickInterval;
+
+private:
+    explicit KeepAliveWheel(asio::io_context& io_context);
+
+    // Returns the wheel of the current thread for |io_context|. It is created if it does not exist.
+    static std::shared_ptr<KeepAliveWheel> forCurrentThread(asio::io_context& io_context);
+
+    void add(Timer* timer, const std::chrono::milliseconds& delay);
+    void remove(Timer* timer);
+
+    void doTick();
+    void onTick(const std::error_code& error_code);
+
+    asio::io_context& io_context_;
+    asio::steady_timer timer_;
+    TimerWheel wheel_;
+
+    // Timers which expired on the current tick and whose callbacks are not called yet. A timer that
+    // is stopped or restarted by one of the callbacks is replaced with nullptr.
+    std::vector<Timer*> expired_;
+
+    size_t active_count_ = 0;
+    bool ticking_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(KeepAliveWheel);
+};
+
+} // namespace base
+
+#endif // BASE__NET__KEEP_ALIVE_WHEEL_H
@@ -0,0 +1,77 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/keep_alive_wheel.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(KeepAliveWheelTest, Expire)
+{
+    asio::io_context io_context;
+
+    int count1 = 0;
+    int count2 = 0;
+    KeepAliveWheel::Timer timer1([&]() { ++count1; });
+    KeepAliveWheel::Timer timer2([&]() { ++count2; });
+
+    timer1.start(io_context, std::chrono::milliseconds(10));
+    timer2.start(io_context, std::chrono::milliseconds(10));
+    EXPECT_TRUE(timer1.isActive());
+    timer2.stop();
+    EXPECT_FALSE(timer2.isActive());
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // The wheel stops ticking when no timers are started, so run() returns.
+    io_context.run();
+
+    EXPECT_GE(std::chrono::steady_clock::now() - start_time, std::chrono::milliseconds(10));
+    EXPECT_EQ(count1, 1);
+    EXPECT_EQ(count2, 0);
+    EXPECT_FALSE(timer1.isActive());
+}
+
+TEST(KeepAliveWheelTest, RestartFromCallback)
+{
+    asio::io_context io_context;
+
+    int count = 0;
+    std::unique_ptr<KeepAliveWheel::Timer> other;
+    KeepAliveWheel::Timer timer([&]()
+    {
+        // The other timer expires on the same tick, but it is destroyed before its callback.
+        other.reset();
+
+        if (++count < 2)
+            timer.start(io_context, std::chrono::milliseconds(10));
+    });
+
+    other = std::make_unique<KeepAliveWheel::Timer>([]() { FAIL(); });
+
+    timer.start(io_context, std::chrono::milliseconds(10));
+    other->start(io_context, std::chrono::milliseconds(10));
+
+    io_context.run();
+
+    EXPECT_EQ(count, 2);
+    EXPECT_FALSE(other);
+}
+
+} // namespace base
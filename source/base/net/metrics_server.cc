@@ -0,0 +1,300 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/metrics_server.h"
+
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
+#include "base/prometheus_writer.h"
+#include "base/strings/unicode.h"
+
+#include <asio/high_resolution_timer.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/read_until.hpp>
+#include <asio/streambuf.hpp>
+#include <asio/write.hpp>
+
+#include <functional>
+#include <istream>
+
+namespace base {
+
+namespace {
+
+// The request of a scraper is a few hundred bytes, larger requests are rejected.
+const size_t kMaxRequestSize = 8 * 1024;
+
+// Time for reading the request and writing the response.
+const std::chrono::seconds kConnectionTimeout { 10 };
+
+std::string makeResponse(std::string_view status, std::string_view content_type,
+                         const std::string& body)
+{
+    std::string response;
+
+    response.append("HTTP/1.1 ");
+    response.append(status);
+    response.append("\r\nContent-Type: ");
+    response.append(content_type);
+    response.append("\r\nContent-Length: ");
+    response.append(std::to_string(body.size()));
+    response.append("\r\nConnection: close\r\n\r\n");
+    response.append(body);
+
+    return response;
+}
+
+class Connection : public std::enable_shared_from_this<Connection>
+{
+public:
+    // |request_handler| returns the response for the request line.
+    using RequestHandler = std::function<std::string(const std::string& request_line)>;
+
+    Connection(asio::ip::tcp::socket socket, RequestHandler request_handler);
+
+    void start();
+
+private:
+    void onRead(const std::error_code& error_code, size_t bytes_transferred);
+    void onWrite(const std::error_code& error_code, size_t bytes_transferred);
+    void close();
+
+    asio::ip::tcp::socket socket_;
+    asio::high_resolution_timer timer_;
+    asio::streambuf buffer_;
+    std::string response_;
+    RequestHandler request_handler_;
+
+    DISALLOW_COPY_AND_ASSIGN(Connection);
+};
+
+Connection::Connection(asio::ip::tcp::socket socket, RequestHandler request_handler)
+    : socket_(std::move(socket)),
+      timer_(socket_.get_executor()),
+      buffer_(kMaxRequestSize),
+      request_handler_(std::move(request_handler))
+{
+    // Nothing
+}
+
+void Connection::start()
+{
+    timer_.expires_after(kConnectionTimeout);
+    timer_.async_wait([self = shared_from_this()](const std::error_code& error_code)
+    {
+        if (error_code != asio::error::operation_aborted)
+            self->close();
+    });
+
+    asio::async_read_until(socket_, buffer_, "\r\n\r\n",
+        std::bind(&Connection::onRead, shared_from_this(),
+                  std::placeholders::_1, std::placeholders::_2));
+}
+
+void Connection::onRead(const std::error_code& error_code, size_t /* bytes_transferred */)
+{
+    if (error_code)
+    {
+        // The request is larger than the buffer or the peer closed the connection.
+        close();
+        return;
+    }
+
+    std::istream stream(&buffer_);
+    std::string request_line;
+    std::getline(stream, request_line);
+
+    if (!request_line.empty() && request_line.back() == '\r')
+        request_line.pop_back();
+
+    response_ = request_handler_(request_line);
+
+    asio::async_write(socket_, asio::buffer(response_),
+        std::bind(&Connection::onWrite, shared_from_this(),
+                  std::placeholders::_1, std::placeholders::_2));
+}
+
+void Connection::onWrite(const std::error_code& /* error_code */, size_t /* bytes_transferred */)
+{
+    close();
+}
+
+void Connection::close()
+{
+    std::error_code ignored_code;
+    socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ignored_code);
+    socket_.close(ignored_code);
+    timer_.cancel();
+}
+
+} // namespace
+
+class MetricsServer::Impl : public std::enable_shared_from_this<Impl>
+{
+public:
+    explicit Impl(asio::io_context& io_context);
+    ~Impl();
+
+    bool start(const std::string& address, uint16_t port, Delegate* delegate);
+    void stop();
+
+private:
+    std::string handleRequest(const std::string& request_line);
+    void doAccept();
+    void onAccept(const std::error_code& error_code, asio::ip::tcp::socket socket);
+
+    asio::io_context& io_context_;
+    std::unique_ptr<asio::ip::tcp::acceptor> acceptor_;
+    Delegate* delegate_ = nullptr;
+
+    DISALLOW_COPY_AND_ASSIGN(Impl);
+};
+
+MetricsServer::Impl::Impl(asio::io_context& io_context)
+    : io_context_(io_context)
+{
+    // Nothing
+}
+
+MetricsServer::Impl::~Impl()
+{
+    DCHECK(!acceptor_);
+}
+
+bool MetricsServer::Impl::start(const std::string& address, uint16_t port, Delegate* delegate)
+{
+    DCHECK(delegate);
+    DCHECK(!acceptor_);
+
+    std::error_code error_code;
+    asio::ip::address ip_address = asio::ip::make_address(address, error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Invalid metrics address: " << address;
+        return false;
+    }
+
+    asio::ip::tcp::endpoint endpoint(ip_address, port);
+    std::unique_ptr<asio::ip::tcp::acceptor> acceptor =
+        std::make_unique<asio::ip::tcp::acceptor>(io_context_);
+
+    acceptor->open(endpoint.protocol(), error_code);
+    if (!error_code)
+        acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true), error_code);
+    if (!error_code)
+        acceptor->bind(endpoint, error_code);
+    if (!error_code)
+        acceptor->listen(asio::socket_base::max_listen_connections, error_code);
+
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Unable to listen for metrics on " << address << ":" << port << ": "
+                      << utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+    acceptor_ = std::move(acceptor);
+    delegate_ = delegate;
+
+    LOG(LS_INFO) << "Metrics are available on http://" << address << ":" << port << "/metrics";
+
+    doAccept();
+    return true;
+}
+
+void MetricsServer::Impl::stop()
+{
+    acceptor_.reset();
+    delegate_ = nullptr;
+}
+
+std::string MetricsServer::Impl::handleRequest(const std::string& request_line)
+{
+    // Request line: METHOD SP PATH SP VERSION.
+    const size_t method_end = request_line.find(' ');
+    const size_t path_end = request_line.find(' ', method_end + 1);
+
+    if (method_end == std::string::npos || path_end == std::string::npos)
+        return makeResponse("400 Bad Request", "text/plain", "Bad request\n");
+
+    const std::string method = request_line.substr(0, method_end);
+    std::string path = request_line.substr(method_end + 1, path_end - method_end - 1);
+
+    const size_t query = path.find('?');
+    if (query != std::string::npos)
+        path.resize(query);
+
+    if (method != "GET")
+        return makeResponse("405 Method Not Allowed", "text/plain", "Method not allowed\n");
+
+    if (path != "/metrics" || !delegate_)
+        return makeResponse("404 Not Found", "text/plain", "Not found\n");
+
+    return makeResponse("200 OK", PrometheusWriter::kContentType, delegate_->onMetricsRequest());
+}
+
+void MetricsServer::Impl::doAccept()
+{
+    acceptor_->async_accept(
+        std::bind(&Impl::onAccept, shared_from_this(),
+                  std::placeholders::_1, std::placeholders::_2));
+}
+
+void MetricsServer::Impl::onAccept(const std::error_code& error_code, asio::ip::tcp::socket socket)
+{
+    if (!delegate_)
+        return;
+
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Error while accepting metrics connection: "
+                      << utf16FromLocal8Bit(error_code.message());
+    }
+    else
+    {
+        std::make_shared<Connection>(
+            std::move(socket),
+            std::bind(&Impl::handleRequest, shared_from_this(), std::placeholders::_1))->start();
+    }
+
+    doAccept();
+}
+
+MetricsServer::MetricsServer()
+    : impl_(std::make_shared<Impl>(MessageLoop::current()->pumpAsio()->ioContext()))
+{
+    // Nothing
+}
+
+MetricsServer::~MetricsServer()
+{
+    impl_->stop();
+}
+
+bool MetricsServer::start(const std::string& address, uint16_t port, Delegate* delegate)
+{
+    return impl_->start(address, port, delegate);
+}
+
+void MetricsServer::stop()
+{
+    impl_->stop();
+}
+
+} // namespace base
@@ -0,0 +1,62 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__NET__METRICS_SERVER_H
+#define BASE__NET__METRICS_SERVER_H
+
+#include "base/macros_magic.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace base {
+
+// Minimal HTTP server for scraping metrics by Prometheus. Answers "GET /metrics" with the text
+// returned by the delegate, all other requests are rejected. Each connection serves one request.
+// The server and the delegate work on the thread on which the server was created.
+class MetricsServer
+{
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        // Returns the metrics in the Prometheus text format (see PrometheusWriter).
+        virtual std::string onMetricsRequest() = 0;
+    };
+
+    // Starts listening on |address| (for example, "127.0.0.1") and |port|. Returns false if the
+    // address is invalid or the port cannot be bound.
+    bool start(const std::string& address, uint16_t port, Delegate* delegate);
+    void stop();
+
+private:
+    class Impl;
+    std::shared_ptr<Impl> impl_;
+
+    DISALLOW_COPY_AND_ASSIGN(MetricsServer);
+};
+
+} // namespace base
+
+#endif // BASE__NET__METRICS_SERVER_H
@@ -23,12 +23,19 @@
 #include "base/crypto/large_number_increment.h"
 #include "base/crypto/message_encryptor_fake.h"
 #include "base/crypto/message_decryptor_fake.h"
+#include "base/memory/buffer_pool.h"
 #include "base/message_loop/message_loop.h"
 #include "base/message_loop/message_pump_asio.h"
 #include "base/net/network_channel_proxy.h"
+#include "base/net/tcp_congestion_control.h"
 #include "base/net/tcp_keep_alive.h"
+#include "base/net/tcp_low_watermark.h"
 #include "base/strings/string_printf.h"
 #include "base/strings/unicode.h"
+#include "base/task_runner.h"
+#include "base/trace_event.h"
+
+#include <algorithm>
 
 #include <asio/connect.hpp>
 #include <asio/read.hpp>
@@ -40,6 +47,40 @@ namespace {
 
 static const size_t kMaxMessageSize = 16 * 1024 * 1024; // 16 MB
 
+// Upper limit on the number of bytes that are sent with a single write operation. Messages are
+// added to the batch until this limit is reached, but the first message is always sent even if it
+// is larger.
+static const size_t kMaxWriteBatchSize = 256 * 1024; // 256 KB
+
+// The socket buffers are tuned not more often than this interval.
+const std::chrono::seconds kAutotuneInterval { 1 };
+
+// The buffers hold two bandwidth-delay products, so the window is not closed while the data waits
+// to be read by the application. A buffer grows only if the new size is larger by a quarter to
+// avoid frequent small changes.
+const int64_t kAutotuneBdpFactor = 2;
+const size_t kAutotuneMinGrowthDivisor = 4;
+
+// Maximum number of streams of a channel (see NetworkChannel::openStream).
+const size_t kMaxStreams = 16;
+
+// A stream sends this number of bytes without waiting for the peer to extend the window. The peer
+// extends the window when a quarter of it is delivered to the listener of the stream.
+const size_t kStreamWindow = 2 * 1024 * 1024; // 2 MB
+
+// Number of bytes which the channel and each of its streams can send per turn.
+const int64_t kWriteQuantum = 32 * 1024; // 32 KB
+
+// Returns the buffer size for the |speed| in bytes per second and the round-trip time.
+size_t autotuneTarget(int64_t speed, const std::chrono::milliseconds& rtt, size_t max_size)
+{
+    const int64_t target = speed * kAutotuneBdpFactor * rtt.count() / 1000;
+    if (target <= 0)
+        return 0;
+
+    return std::min(static_cast<size_t>(target), max_size);
+}
+
 int calculateSpeed(int last_speed, const std::chrono::milliseconds& duration, int64_t bytes)
 {
     static const double kAlpha = 0.1;
@@ -50,11 +91,12 @@ int calculateSpeed(int last_speed, const std::chrono::milliseconds& duration, in
 
 void resizeBuffer(ByteArray* buffer, size_t new_size)
 {
-    // If the reserved buffer size is less, then increase it.
+    // If the reserved buffer size is less, then exchange it for a larger one from the pool.
     if (buffer->capacity() < new_size)
     {
-        buffer->clear();
-        buffer->reserve(new_size);
+        BufferPool::instance()->release(std::move(*buffer));
+        *buffer = BufferPool::instance()->acquire(new_size);
+        return;
     }
 
     // Change the size of the buffer.
@@ -74,7 +116,7 @@ NetworkChannel::NetworkChannel()
     // Nothing
 }
 
-NetworkChannel::NetworkChannel(asio::ip::tcp::socket&& socket)
+NetworkChannel::NetworkChannel(asio::ip::tcp::socket&& socket, Role role)
     : proxy_(new NetworkChannelProxy(MessageLoop::current()->taskRunner(), this)),
       io_context_(MessageLoop::current()->pumpAsio()->ioContext()),
       socket_(std::move(socket)),
@@ -83,6 +125,25 @@ NetworkChannel::NetworkChannel(asio::ip::tcp::socket&& socket)
       decryptor_(std::make_unique<MessageDecryptorFake>())
 {
     DCHECK(socket_.is_open());
+
+    // The socket does not tell which end has connected. The peers which connect through a relay
+    // or directly get the socket the same way as the server.
+    next_stream_id_ = (role == Role::CLIENT) ? 1 : 2;
+}
+
+NetworkChannel::NetworkChannel(NetworkChannel* parent, uint16_t stream_id)
+    : proxy_(new NetworkChannelProxy(MessageLoop::current()->taskRunner(), this)),
+      io_context_(parent->io_context_),
+      socket_(io_context_),
+      connected_(true),
+      encryptor_(std::make_unique<MessageEncryptorFake>()),
+      decryptor_(std::make_unique<MessageDecryptorFake>())
+{
+    DCHECK(stream_id);
+
+    parent_ = parent;
+    stream_id_ = stream_id;
+    send_window_ = kStreamWindow;
 }
 
 NetworkChannel::~NetworkChannel()
@@ -92,6 +153,10 @@ NetworkChannel::~NetworkChannel()
 
     listener_ = nullptr;
 
+    if (parent_)
+        parent_->removeStream(this, true);
+
+    disconnectStreams(ErrorCode::NETWORK_ERROR);
     disconnect();
 }
 
@@ -100,6 +165,46 @@ std::shared_ptr<NetworkChannelProxy> NetworkChannel::channelProxy()
     return proxy_;
 }
 
+// static
+void NetworkChannel::destroy(std::unique_ptr<NetworkChannel> channel)
+{
+    if (!channel || channel->streams_.empty() || !channel->connected_)
+        return;
+
+    // The channel is deleted when its last stream is closed (see removeStream).
+    NetworkChannel* self = channel.release();
+    self->destroyed_ = true;
+    self->listener_ = nullptr;
+    self->sendServiceMessage(STREAM_CLOSE, 0, 0, nullptr, 0);
+
+    // Messages of the channel itself are no longer delivered, but the messages of the streams
+    // must still be read.
+    self->resume();
+}
+
+std::unique_ptr<NetworkChannel> NetworkChannel::openStream()
+{
+    if (parent_ || !connected_ || destroyed_)
+        return nullptr;
+
+    if (streams_.size() >= kMaxStreams || next_stream_id_ > 0xFFFF - 2)
+    {
+        LOG(LS_WARNING) << "Too many streams";
+        return nullptr;
+    }
+
+    const uint16_t stream_id = next_stream_id_;
+    next_stream_id_ += 2;
+
+    // The peer learns about the stream from its first message.
+    return createStream(stream_id);
+}
+
+void NetworkChannel::setStreamListener(StreamListener* listener)
+{
+    stream_listener_ = listener;
+}
+
 void NetworkChannel::setListener(Listener* listener)
 {
     listener_ = listener;
@@ -117,6 +222,9 @@ void NetworkChannel::setDecryptor(std::unique_ptr<MessageDecryptor> decryptor)
 
 std::u16string NetworkChannel::peerAddress() const
 {
+    if (parent_)
+        return parent_->peerAddress();
+
     if (!socket_.is_open())
         return std::u16string();
 
@@ -178,6 +286,12 @@ void NetworkChannel::resume()
 
     paused_ = false;
 
+    if (isStream())
+    {
+        deliverStreamData();
+        return;
+    }
+
     switch (state_)
     {
         // We already have an incomplete read operation.
@@ -185,6 +299,7 @@ void NetworkChannel::resume()
         case ReadState::READ_USER_DATA:
         case ReadState::READ_SERVICE_HEADER:
         case ReadState::READ_SERVICE_DATA:
+        case ReadState::READ_STREAM_DATA:
             return;
 
         default:
@@ -198,13 +313,49 @@ void NetworkChannel::resume()
     doReadSize();
 }
 
-void NetworkChannel::send(ByteArray&& buffer)
+void NetworkChannel::send(ByteArray&& buffer, Priority priority)
+{
+    addWriteTask(WriteTask(WriteTask::Type::USER_DATA, priority, std::move(buffer)));
+}
+
+void NetworkChannel::send(SharedByteArray&& buffer, Priority priority)
+{
+    addWriteTask(WriteTask(WriteTask::Type::USER_DATA, priority, std::move(buffer)));
+}
+
+void NetworkChannel::send(const google::protobuf::MessageLite& message, Priority priority)
+{
+    addWriteTask(messageTask(message, priority));
+}
+
+void NetworkChannel::sendDiscardable(const google::protobuf::MessageLite& message,
+                                     Priority priority)
+{
+    WriteTask task = messageTask(message, priority);
+    task.setDiscardable(true);
+
+    addWriteTask(std::move(task));
+}
+
+size_t NetworkChannel::discardQueued()
 {
-    addWriteTask(WriteTask::Type::USER_DATA, std::move(buffer));
+    // The messages of the batch which is being written are already encrypted and can not be
+    // removed. The rest of the queue is not encrypted yet and the message counter of the
+    // encryptor is not affected.
+    std::vector<WriteTask> discarded = write_queue_.takeDiscardable();
+
+    for (auto& task : discarded)
+        BufferPool::instance()->release(std::move(task.data()));
+
+    return discarded.size();
 }
 
 bool NetworkChannel::setNoDelay(bool enable)
 {
+    // Socket options of a stream are the options of its connection.
+    if (isStream())
+        return true;
+
     asio::ip::tcp::no_delay option(enable);
 
     asio::error_code error_code;
@@ -224,12 +375,19 @@ bool NetworkChannel::setTcpKeepAlive(bool enable,
                                      const Milliseconds& time,
                                      const Milliseconds& interval)
 {
+    if (isStream())
+        return true;
+
     return base::setTcpKeepAlive(socket_.native_handle(), enable, time, interval);
 }
 
 bool NetworkChannel::setOwnKeepAlive(bool enable, const Seconds& interval, const Seconds& timeout)
 {
-    if (enable && keep_alive_timer_)
+    // The keep alive of the connection checks the streams too.
+    if (isStream())
+        return true;
+
+    if (enable && keep_alive_enabled_)
     {
         LOG(LS_WARNING) << "Keep alive already active";
         return false;
@@ -250,12 +408,9 @@ bool NetworkChannel::setOwnKeepAlive(bool enable, const Seconds& interval, const
     if (!enable)
     {
         keep_alive_counter_.clear();
-
-        if (keep_alive_timer_)
-        {
-            keep_alive_timer_->cancel();
-            keep_alive_timer_.reset();
-        }
+        keep_alive_enabled_ = false;
+        keep_alive_ping_sent_ = false;
+        keep_alive_timer_.stop();
     }
     else
     {
@@ -265,10 +420,9 @@ bool NetworkChannel::setOwnKeepAlive(bool enable, const Seconds& interval, const
         keep_alive_counter_.resize(sizeof(uint32_t));
         memset(keep_alive_counter_.data(), 0, keep_alive_counter_.size());
 
-        keep_alive_timer_ = std::make_unique<asio::high_resolution_timer>(io_context_);
-        keep_alive_timer_->expires_after(keep_alive_interval_);
-        keep_alive_timer_->async_wait(
-            std::bind(&NetworkChannel::onKeepAliveInterval, this, std::placeholders::_1));
+        keep_alive_enabled_ = true;
+        keep_alive_ping_sent_ = false;
+        keep_alive_timer_.start(io_context_, keep_alive_interval_);
     }
 
     return true;
@@ -276,6 +430,9 @@ bool NetworkChannel::setOwnKeepAlive(bool enable, const Seconds& interval, const
 
 bool NetworkChannel::setReadBufferSize(size_t size)
 {
+    if (isStream())
+        return true;
+
     asio::socket_base::receive_buffer_size option(size);
 
     asio::error_code error_code;
@@ -288,11 +445,15 @@ bool NetworkChannel::setReadBufferSize(size_t size)
         return false;
     }
 
+    read_buffer_size_ = size;
     return true;
 }
 
 bool NetworkChannel::setWriteBufferSize(size_t size)
 {
+    if (isStream())
+        return true;
+
     asio::socket_base::send_buffer_size option(size);
 
     asio::error_code error_code;
@@ -305,9 +466,48 @@ bool NetworkChannel::setWriteBufferSize(size_t size)
         return false;
     }
 
+    write_buffer_size_ = size;
     return true;
 }
 
+void NetworkChannel::setBufferAutotuning(size_t max_size)
+{
+    if (isStream())
+        return;
+
+    autotune_max_size_ = max_size;
+    autotune_time_ = Clock::now();
+    autotune_rx_ = total_rx_;
+    autotune_tx_ = total_tx_;
+}
+
+bool NetworkChannel::setCongestionControl(std::string_view algorithm)
+{
+    if (isStream())
+        return true;
+
+    return setTcpCongestionControl(socket_.native_handle(), algorithm);
+}
+
+bool NetworkChannel::setWriteLowWatermark(size_t bytes)
+{
+    // The send buffer of the system is shared by all streams of the connection.
+    if (isStream())
+        return false;
+
+    if (!setTcpSendLowWatermark(socket_.native_handle(), bytes))
+        return false;
+
+    write_low_watermark_ = true;
+    return true;
+}
+
+void NetworkChannel::setMemoryAccount(std::shared_ptr<MemoryAccount> account)
+{
+    write_queue_.setMemoryAccount(account);
+    write_batch_memory_.setAccount(std::move(account));
+}
+
 int NetworkChannel::speedRx()
 {
     TimePoint current_time = Clock::now();
@@ -396,6 +596,14 @@ void NetworkChannel::disconnect()
 
     connected_ = false;
 
+    if (isStream())
+    {
+        // The connection belongs to the parent channel.
+        if (parent_)
+            parent_->removeStream(this, true);
+        return;
+    }
+
     std::error_code ignored_code;
 
     socket_.cancel(ignored_code);
@@ -424,17 +632,20 @@ void NetworkChannel::onErrorOccurred(const Location& location, const std::error_
     else if (error_code == asio::error::network_down)
         error = ErrorCode::NETWORK_ERROR;
 
-    LOG(LS_WARNING) << "Asio error: " << utf16FromLocal8Bit(error_code.message())
-                    << " (" << error_code.value() << ")";
+    LOG_RATE_LIMITED(LS_WARNING, 20, std::chrono::seconds(1))
+        << "Asio error: " << utf16FromLocal8Bit(error_code.message())
+        << " (" << error_code.value() << ")";
     onErrorOccurred(location, error);
 }
 
 void NetworkChannel::onErrorOccurred(const Location& location, ErrorCode error_code)
 {
-    LOG(LS_WARNING) << "Connection finished with error " << errorToString(error_code)
-                    << " from: " << location.toString();
+    LOG_RATE_LIMITED(LS_WARNING, 20, std::chrono::seconds(1))
+        << "Connection finished with error " << errorToString(error_code)
+        << " from: " << location.toString();
 
     disconnect();
+    disconnectStreams(error_code);
 
     if (listener_)
     {
@@ -451,110 +662,470 @@ void NetworkChannel::onMessageWritten()
 
 void NetworkChannel::onMessageReceived()
 {
-    resizeBuffer(&decrypt_buffer_, decryptor_->decryptedDataSize(read_buffer_.size()));
+    TRACE_EVENT("net", "NetworkChannel::onMessageReceived");
 
-    if (!decryptor_->decrypt(read_buffer_.data(), read_buffer_.size(), decrypt_buffer_.data()))
+    if (!decryptor_->decryptInPlace(read_tag_.data(), read_buffer_.data(), read_buffer_.size()))
     {
         onErrorOccurred(FROM_HERE, ErrorCode::ACCESS_DENIED);
         return;
     }
 
     if (listener_)
-        listener_->onMessageReceived(decrypt_buffer_);
+        listener_->onMessageReceived(read_buffer_);
 }
 
-void NetworkChannel::addWriteTask(WriteTask::Type type, ByteArray&& data)
+void NetworkChannel::addWriteTask(WriteTask&& task)
 {
-    const bool schedule_write = write_queue_.empty();
+    if (isStream())
+    {
+        // Messages of a closed stream are not sent.
+        if (!parent_)
+            return;
+
+        write_queue_.push(std::move(task));
+        parent_->scheduleWrite();
+        return;
+    }
+
+    // If a write operation is already in progress, the task will be sent after it is completed.
+    const bool schedule_write = !write_pending_;
 
     // Add the buffer to the queue for sending.
-    write_queue_.emplace(type, std::move(data));
+    write_queue_.push(std::move(task));
 
     if (schedule_write)
         doWrite();
 }
 
-void NetworkChannel::doWrite()
+// static
+WriteTask NetworkChannel::messageTask(const google::protobuf::MessageLite& message,
+                                      Priority priority)
 {
-    const ByteArray& source_buffer = write_queue_.front().data();
-    if (source_buffer.empty())
+    const size_t size = message.ByteSizeLong();
+
+    if (SmallByteArray::fits(size))
     {
-        onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+        // A tiny message does not need a buffer of its own.
+        SmallByteArray buffer;
+        buffer.resize(size);
+
+        if (size)
+            message.SerializeWithCachedSizesToArray(buffer.data());
+
+        return WriteTask(WriteTask::Type::USER_DATA, priority, buffer);
+    }
+
+    ByteArray buffer;
+    serialize(message, kWriteHeadroom, &buffer);
+
+    return WriteTask(WriteTask::Type::USER_DATA, priority, std::move(buffer), kWriteHeadroom);
+}
+
+void NetworkChannel::scheduleWrite()
+{
+    if (isStream())
+    {
+        if (parent_)
+            parent_->scheduleWrite();
+        return;
+    }
+
+    // If a write operation is in progress, the queues will be sent after it is completed.
+    if (write_pending_ || !reloadWriteQueues())
         return;
+
+    doWrite();
+}
+
+bool NetworkChannel::reloadWriteQueues()
+{
+    proxy_->reloadWriteQueue(&write_queue_);
+
+    for (NetworkChannel* stream : streams_)
+        stream->proxy_->reloadWriteQueue(&stream->write_queue_);
+
+    return hasWritableQueue();
+}
+
+bool NetworkChannel::hasWritableQueue() const
+{
+    if (!write_queue_.empty())
+        return true;
+
+    for (const NetworkChannel* stream : streams_)
+    {
+        if (stream->canWriteStream())
+            return true;
     }
 
-    if (write_queue_.front().type() == WriteTask::Type::USER_DATA)
+    return false;
+}
+
+NetworkChannel* NetworkChannel::nextWriteSource()
+{
+    DCHECK(hasWritableQueue());
+
+    const size_t count = streams_.size() + 1;
+
+    auto source_at = [this](size_t index)
+    {
+        return index ? streams_[index - 1] : this;
+    };
+
+    auto can_write = [this](const NetworkChannel* source)
+    {
+        return source == this ? !write_queue_.empty() : source->canWriteStream();
+    };
+
+    // Service messages and latency-sensitive messages of any stream do not wait for their turn.
+    for (size_t i = 0; i < count; ++i)
+    {
+        NetworkChannel* source = source_at(i);
+        if (!can_write(source))
+            continue;
+
+        const WriteTask& task = source->write_queue_.front();
+        if (task.type() == WriteTask::Type::SERVICE_DATA || task.priority() == Priority::HIGH)
+            return source;
+    }
+
+    for (;;)
     {
-        // Calculate the size of the encrypted message.
-        const size_t target_data_size = encryptor_->encryptedDataSize(source_buffer.size());
+        NetworkChannel* source = source_at(write_cursor_);
 
-        if (target_data_size > kMaxMessageSize)
+        if (can_write(source))
         {
-            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
-            return;
+            const int64_t size = static_cast<int64_t>(source->write_queue_.front().messageSize());
+            if (source->write_deficit_ >= size)
+            {
+                source->write_deficit_ -= size;
+                return source;
+            }
+        }
+        else
+        {
+            // A source without messages does not save its turns for later.
+            source->write_deficit_ = 0;
         }
 
-        asio::const_buffer variable_size = variable_size_writer_.variableSize(target_data_size);
+        write_cursor_ = (write_cursor_ + 1) % count;
+        source_at(write_cursor_)->write_deficit_ += kWriteQuantum;
+    }
+}
+
+bool NetworkChannel::encodeWriteTask(WriteTask* task, asio::const_buffer* buffer)
+{
+    const uint8_t* message = task->message();
+    const size_t message_size = task->messageSize();
+
+    if (task->type() == WriteTask::Type::SERVICE_DATA)
+    {
+        // Service data does not need encryption and is sent as is.
+        *buffer = asio::const_buffer(message, message_size);
+        return true;
+    }
+
+    // Messages of a stream are encrypted by the stream.
+    MessageEncryptor* encryptor = encryptor_.get();
+    if (task->stream())
+    {
+        NetworkChannel* stream = findStream(task->stream());
+        DCHECK(stream);
+        encryptor = stream->encryptor_.get();
+    }
+
+    // Calculate the size of the encrypted message.
+    const size_t target_data_size = encryptor->encryptedDataSize(message_size);
+
+    if (target_data_size > kMaxMessageSize)
+    {
+        onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+        return false;
+    }
+
+    // User messages are framed with their size. Messages of streams are sent as service messages
+    // with the encrypted message as the service data.
+    uint8_t service_frame[kServiceFrameSize];
+    asio::const_buffer frame;
+
+    if (task->stream())
+    {
+        ServiceHeader header;
+        memset(&header, 0, sizeof(header));
+
+        header.type   = STREAM_DATA;
+        header.stream = task->stream();
+        header.length = static_cast<uint32_t>(target_data_size);
+
+        // The first byte set to 0 indicates that this is a service message.
+        service_frame[0] = 0;
+        memcpy(service_frame + sizeof(uint8_t), &header, sizeof(header));
+
+        frame = asio::const_buffer(service_frame, sizeof(service_frame));
+    }
+    else
+    {
+        frame = variable_size_writer_.variableSize(target_data_size);
+    }
+
+    // Size of the frame and the encryption overhead in front of the message.
+    const size_t prefix_size = frame.size() + (target_data_size - message_size);
+    uint8_t* target;
 
-        resizeBuffer(&write_buffer_, variable_size.size() + target_data_size);
+    if (prefix_size <= task->headroom())
+    {
+        // The message has enough space in front of it. The message is encrypted in place.
+        target = task->data().data() + task->headroom() - prefix_size;
+    }
+    else
+    {
+        const size_t offset = write_buffer_.size();
+
+        // The space was reserved before. Previously added messages should not be moved.
+        DCHECK_LE(offset + frame.size() + target_data_size, write_buffer_.capacity());
+
+        write_buffer_.resize(offset + frame.size() + target_data_size);
+        target = write_buffer_.data() + offset;
+    }
+
+    // Copy the frame of the message to the buffer.
+    memcpy(target, frame.data(), frame.size());
 
-        // Copy the size of the message to the buffer.
-        memcpy(write_buffer_.data(), variable_size.data(), variable_size.size());
+    // Encrypt the message.
+    if (!encryptor->encrypt(message, message_size, target + frame.size()))
+    {
+        onErrorOccurred(FROM_HERE, ErrorCode::ACCESS_DENIED);
+        return false;
+    }
+
+    *buffer = asio::const_buffer(target, frame.size() + target_data_size);
+    return true;
+}
+
+void NetworkChannel::doWrite()
+{
+    TRACE_EVENT("net", "NetworkChannel::doWrite");
+
+    DCHECK(!write_pending_);
+
+    if (write_low_watermark_ && !socket_writable_)
+    {
+        // Messages are not written until the system sends the previous data. Meanwhile, the queue
+        // keeps collecting new messages.
+        doWaitWritable();
+        return;
+    }
+
+    // The socket may not be writable after this write.
+    socket_writable_ = false;
+
+    // Take the messages added from other threads. They are placed in the queue according to their
+    // priority.
+    reloadWriteQueues();
+    DCHECK(hasWritableQueue());
+
+    write_batch_.clear();
+    write_buffers_.clear();
+    write_buffer_.clear();
+    write_batch_messages_ = 0;
+    write_batch_bytes_ = 0;
+    write_batch_memory_.set(0);
+
+    size_t batch_size = 0;
+    size_t reserve_size = 0;
+
+    // All pending messages (up to the batch limit) are sent with a single write operation, so a
+    // burst of small messages costs one system call. Messages are taken in order of priority.
+    do
+    {
+        // Without streams, all messages are taken from the queue of the channel.
+        NetworkChannel* source = streams_.empty() ? this : nextWriteSource();
+        WriteTask& task = source->write_queue_.front();
 
-        // Encrypt the message.
-        if (!encryptor_->encrypt(source_buffer.data(),
-                                 source_buffer.size(),
-                                 write_buffer_.data() + variable_size.size()))
+        if (!task.messageSize())
         {
-            onErrorOccurred(FROM_HERE, ErrorCode::ACCESS_DENIED);
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
             return;
         }
+
+        if (task.type() != WriteTask::Type::SERVICE_DATA)
+        {
+            if (source == this)
+                ++write_batch_messages_;
+            user_activity_ = true;
+
+            // Messages without enough headroom are framed and encrypted into the write buffer.
+            const size_t frame_size = (source != this) ? kServiceFrameSize : sizeof(uint32_t);
+            const size_t encrypted_size =
+                source->encryptor_->encryptedDataSize(task.messageSize());
+            const size_t overhead = encrypted_size - task.messageSize();
+            if (task.headroom() < frame_size + overhead)
+                reserve_size += frame_size + overhead + task.messageSize();
+
+            if (source != this)
+            {
+                // The window is counted in the encrypted bytes which the peer receives.
+                task.setStream(source->stream_id_);
+                source->send_window_ -= static_cast<int64_t>(encrypted_size);
+            }
+        }
+
+        batch_size += task.messageSize();
+
+        write_batch_.emplace_back(source->write_queue_.take());
+
+        if (source->write_queue_.empty())
+            source->proxy_->reloadWriteQueue(&source->write_queue_);
     }
-    else
+    while (hasWritableQueue() && batch_size < kMaxWriteBatchSize);
+
+    write_batch_bytes_ = batch_size;
+    write_batch_memory_.set(batch_size);
+
+    // Buffers of the batch point to the write buffer, so it must not be reallocated.
+    write_buffer_.reserve(reserve_size);
+
+    for (auto& task : write_batch_)
     {
-        DCHECK_EQ(write_queue_.front().type(), WriteTask::Type::SERVICE_DATA);
+        asio::const_buffer buffer;
 
-        resizeBuffer(&write_buffer_, source_buffer.size());
+        if (!encodeWriteTask(&task, &buffer))
+            return;
 
-        // Service data does not need encryption. Copy the source buffer.
-        memcpy(write_buffer_.data(), source_buffer.data(), source_buffer.size());
+        write_buffers_.emplace_back(buffer);
     }
 
-    // Send the buffer to the recipient.
+    write_pending_ = true;
+    estimator_.onWriteStarted(ChannelEstimator::Clock::now(), hasWritableQueue());
+
+    // Send the buffers to the recipient.
     asio::async_write(socket_,
-                      asio::buffer(write_buffer_.data(), write_buffer_.size()),
-                      std::bind(&NetworkChannel::onWrite,
-                                this,
-                                std::placeholders::_1,
-                                std::placeholders::_2));
+                      write_buffers_,
+                      makeAllocatingHandler(write_handler_memory_,
+                                            std::bind(&NetworkChannel::onWrite,
+                                                      this,
+                                                      std::placeholders::_1,
+                                                      std::placeholders::_2)));
 }
 
 void NetworkChannel::onWrite(const std::error_code& error_code, size_t bytes_transferred)
 {
+    TRACE_EVENT("net", "NetworkChannel::onWrite");
+
+    DCHECK(write_pending_);
+    write_pending_ = false;
+
     if (error_code)
     {
         onErrorOccurred(FROM_HERE, error_code);
         return;
     }
 
-    DCHECK(!write_queue_.empty());
-
     // Update TX statistics.
     addTxBytes(bytes_transferred);
 
-    WriteTask::Type task_type = write_queue_.front().type();
+    const ChannelEstimator::TimePoint current_time = ChannelEstimator::Clock::now();
+    bool estimate_changed = estimator_.onWriteCompleted(current_time, bytes_transferred);
+
+    written_streams_.clear();
+
+    for (auto& task : write_batch_)
+    {
+        if (task.type() != WriteTask::Type::SERVICE_DATA)
+        {
+            estimate_changed |= estimator_.addQueueDelaySample(
+                std::chrono::duration_cast<ChannelEstimator::Milliseconds>(
+                    current_time - task.time()));
+
+            if (task.stream())
+            {
+                NetworkChannel* stream = findStream(task.stream());
+                if (stream)
+                {
+                    stream->addTxBytes(task.messageSize());
+                    written_streams_.emplace_back(task.stream());
+                }
+            }
+        }
+
+        // Buffers of the sent messages are returned to the pool to be reused for the next messages.
+        BufferPool::instance()->release(std::move(task.data()));
+    }
 
-    // Delete the sent message from the queue.
-    write_queue_.pop();
+    write_batch_.clear();
+    write_buffers_.clear();
+    write_batch_bytes_ = 0;
+    write_batch_memory_.set(0);
 
-    // If the queue is not empty, then we send the following message.
-    bool schedule_write = !write_queue_.empty() || proxy_->reloadWriteQueue(&write_queue_);
+    const size_t messages_written = write_batch_messages_;
+    write_batch_messages_ = 0;
 
-    if (task_type == WriteTask::Type::USER_DATA)
+    if (estimate_changed && listener_)
+        listener_->onEstimateChanged(estimator_.estimate());
+
+    // Notify about each user message sent in the batch.
+    for (size_t i = 0; i < messages_written; ++i)
         onMessageWritten();
 
-    if (schedule_write)
-        doWrite();
+    // A listener can destroy its stream, so the streams are looked up for each message.
+    for (uint16_t stream_id : written_streams_)
+    {
+        NetworkChannel* stream = findStream(stream_id);
+        if (stream)
+            stream->onMessageWritten();
+    }
+
+    // When notified, the listener can send new messages, and this already starts the next write.
+    if (write_pending_)
+        return;
+
+    // If the queues are not empty, then we send the following messages.
+    if (!reloadWriteQueues())
+    {
+        // The listener is notified when the socket is ready for the next message.
+        if (write_low_watermark_)
+            doWaitWritable();
+        return;
+    }
+
+    doWrite();
+}
+
+void NetworkChannel::doWaitWritable()
+{
+    DCHECK(!write_pending_);
+
+    // New messages are added to the queue while waiting.
+    write_pending_ = true;
+    socket_.async_wait(asio::ip::tcp::socket::wait_write,
+                       makeAllocatingHandler(write_handler_memory_,
+                                             std::bind(&NetworkChannel::onWaitWritable,
+                                                       this,
+                                                       std::placeholders::_1)));
+}
+
+void NetworkChannel::onWaitWritable(const std::error_code& error_code)
+{
+    DCHECK(write_pending_);
+    write_pending_ = false;
+
+    if (error_code)
+    {
+        onErrorOccurred(FROM_HERE, error_code);
+        return;
+    }
+
+    socket_writable_ = true;
+
+    if (!reloadWriteQueues())
+    {
+        // Nothing to send. The listener can send the next message right now.
+        if (listener_)
+            listener_->onWritable();
+        return;
+    }
+
+    doWrite();
 }
 
 void NetworkChannel::doReadSize()
@@ -562,10 +1133,11 @@ void NetworkChannel::doReadSize()
     state_ = ReadState::READ_SIZE;
     asio::async_read(socket_,
                      variable_size_reader_.buffer(),
-                     std::bind(&NetworkChannel::onReadSize,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
+                     makeAllocatingHandler(read_handler_memory_,
+                                           std::bind(&NetworkChannel::onReadSize,
+                                                     this,
+                                                     std::placeholders::_1,
+                                                     std::placeholders::_2)));
 }
 
 void NetworkChannel::onReadSize(const std::error_code& error_code, size_t bytes_transferred)
@@ -606,17 +1178,34 @@ void NetworkChannel::onReadSize(const std::error_code& error_code, size_t bytes_
     }
 }
 
+std::array<asio::mutable_buffer, 2> NetworkChannel::encryptedReadBuffers(size_t length)
+{
+    const size_t tag_size = decryptor_->tagSize();
+    DCHECK_GE(length, tag_size);
+
+    read_tag_.resize(tag_size);
+    resizeBuffer(&read_buffer_, length - tag_size);
+
+    return { asio::buffer(read_tag_.data(), read_tag_.size()),
+             asio::buffer(read_buffer_.data(), read_buffer_.size()) };
+}
+
 void NetworkChannel::doReadUserData(size_t length)
 {
-    resizeBuffer(&read_buffer_, length);
+    if (length < decryptor_->tagSize())
+    {
+        onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+        return;
+    }
 
     state_ = ReadState::READ_USER_DATA;
     asio::async_read(socket_,
-                     asio::buffer(read_buffer_.data(), read_buffer_.size()),
-                     std::bind(&NetworkChannel::onReadUserData,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
+                     encryptedReadBuffers(length),
+                     makeAllocatingHandler(read_handler_memory_,
+                                           std::bind(&NetworkChannel::onReadUserData,
+                                                     this,
+                                                     std::placeholders::_1,
+                                                     std::placeholders::_2)));
 }
 
 void NetworkChannel::onReadUserData(const std::error_code& error_code, size_t bytes_transferred)
@@ -632,7 +1221,8 @@ void NetworkChannel::onReadUserData(const std::error_code& error_code, size_t by
     // Update RX statistics.
     addRxBytes(bytes_transferred);
 
-    DCHECK_EQ(bytes_transferred, read_buffer_.size());
+    DCHECK_EQ(bytes_transferred, read_tag_.size() + read_buffer_.size());
+    user_activity_ = true;
 
     if (paused_)
     {
@@ -658,10 +1248,11 @@ void NetworkChannel::doReadServiceHeader()
     state_ = ReadState::READ_SERVICE_HEADER;
     asio::async_read(socket_,
                      asio::buffer(read_buffer_.data(), read_buffer_.size()),
-                     std::bind(&NetworkChannel::onReadServiceHeader,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
+                     makeAllocatingHandler(read_handler_memory_,
+                                           std::bind(&NetworkChannel::onReadServiceHeader,
+                                                     this,
+                                                     std::placeholders::_1,
+                                                     std::placeholders::_2)));
 }
 
 void NetworkChannel::onReadServiceHeader(const std::error_code& error_code, size_t bytes_transferred)
@@ -698,6 +1289,42 @@ void NetworkChannel::onReadServiceHeader(const std::error_code& error_code, size
 
         doReadServiceData(header->length);
     }
+    else if (header->type == STREAM_DATA)
+    {
+        // Messages of streams are encrypted by the streams and decrypted when they are delivered.
+        if (!header->stream || !header->length)
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+            return;
+        }
+
+        read_stream_id_ = header->stream;
+        doReadStreamData(header->length);
+    }
+    else if (header->type == STREAM_WINDOW)
+    {
+        if (!header->stream || header->length != sizeof(uint32_t))
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+            return;
+        }
+
+        doReadServiceData(header->length);
+    }
+    else if (header->type == STREAM_CLOSE)
+    {
+        if (header->length)
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+            return;
+        }
+
+        const uint16_t stream_id = header->stream;
+
+        // The listener of the stream can destroy the channel, so the next read is started before.
+        doReadSize();
+        onStreamClosed(stream_id);
+    }
     else
     {
         onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
@@ -718,10 +1345,11 @@ void NetworkChannel::doReadServiceData(size_t length)
     asio::async_read(socket_,
                      asio::buffer(read_buffer_.data() + sizeof(ServiceHeader),
                                   read_buffer_.size() - sizeof(ServiceHeader)),
-                     std::bind(&NetworkChannel::onReadServiceData,
-                               this,
-                               std::placeholders::_1,
-                               std::placeholders::_2));
+                     makeAllocatingHandler(read_handler_memory_,
+                                           std::bind(&NetworkChannel::onReadServiceData,
+                                                     this,
+                                                     std::placeholders::_1,
+                                                     std::placeholders::_2)));
 }
 
 void NetworkChannel::onReadServiceData(const std::error_code& error_code, size_t bytes_transferred)
@@ -776,17 +1404,17 @@ void NetworkChannel::onReadServiceData(const std::error_code& error_code, size_t
                 return;
             }
 
-            if (DCHECK_IS_ON())
-            {
-                Milliseconds ping_time = std::chrono::duration_cast<Milliseconds>(
-                    Clock::now() - keep_alive_timestamp_);
+            Milliseconds ping_time = std::chrono::duration_cast<Milliseconds>(
+                Clock::now() - keep_alive_timestamp_);
 
-                DLOG(LS_INFO) << "Ping result: " << ping_time.count() << " ms ("
-                              << keep_alive_counter_.size() << " bytes)";
-            }
+            DLOG(LS_INFO) << "Ping result: " << ping_time.count() << " ms ("
+                          << keep_alive_counter_.size() << " bytes)";
+
+            if (estimator_.addRttSample(ping_time) && listener_)
+                listener_->onEstimateChanged(estimator_.estimate());
 
             // The user can disable keep alive. Restart the timer only if keep alive is enabled.
-            if (keep_alive_timer_)
+            if (keep_alive_enabled_)
             {
                 DCHECK(!keep_alive_counter_.empty());
 
@@ -794,12 +1422,24 @@ void NetworkChannel::onReadServiceData(const std::error_code& error_code, size_t
                 largeNumberIncrement(&keep_alive_counter_);
 
                 // Restart keep alive timer.
-                keep_alive_timer_->expires_after(keep_alive_interval_);
-                keep_alive_timer_->async_wait(
-                    std::bind(&NetworkChannel::onKeepAliveInterval, this, std::placeholders::_1));
+                keep_alive_ping_sent_ = false;
+                keep_alive_timer_.start(io_context_, keep_alive_interval_);
             }
         }
     }
+    else if (header->type == STREAM_WINDOW)
+    {
+        uint32_t window;
+        memcpy(&window, read_buffer_.data() + sizeof(ServiceHeader), sizeof(window));
+
+        // The window of a closed stream is ignored.
+        NetworkChannel* stream = findStream(header->stream);
+        if (stream)
+        {
+            stream->send_window_ += window;
+            scheduleWrite();
+        }
+    }
     else
     {
         onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
@@ -809,59 +1449,295 @@ void NetworkChannel::onReadServiceData(const std::error_code& error_code, size_t
     doReadSize();
 }
 
-void NetworkChannel::onKeepAliveInterval(const std::error_code& error_code)
+void NetworkChannel::doReadStreamData(size_t length)
 {
-    if (error_code == asio::error::operation_aborted)
-        return;
+    DCHECK_EQ(state_, ReadState::READ_SERVICE_HEADER);
+    DCHECK_GT(length, 0u);
+
+    resizeBuffer(&read_buffer_, length);
 
-    DCHECK(keep_alive_timer_);
+    state_ = ReadState::READ_STREAM_DATA;
+    asio::async_read(socket_,
+                     asio::buffer(read_buffer_.data(), read_buffer_.size()),
+                     makeAllocatingHandler(read_handler_memory_,
+                                           std::bind(&NetworkChannel::onReadStreamData,
+                                                     this,
+                                                     std::placeholders::_1,
+                                                     std::placeholders::_2)));
+}
+
+void NetworkChannel::onReadStreamData(const std::error_code& error_code, size_t bytes_transferred)
+{
+    DCHECK_EQ(state_, ReadState::READ_STREAM_DATA);
 
     if (error_code)
     {
-        LOG(LS_ERROR) << "Keep alive timer error: " << utf16FromLocal8Bit(error_code.message());
+        onErrorOccurred(FROM_HERE, error_code);
+        return;
+    }
+
+    // Update RX statistics.
+    addRxBytes(bytes_transferred);
 
-        // Restarting the timer.
-        keep_alive_timer_->expires_after(keep_alive_interval_);
-        keep_alive_timer_->async_wait(
-            std::bind(&NetworkChannel::onKeepAliveInterval, this, std::placeholders::_1));
+    DCHECK_EQ(bytes_transferred, read_buffer_.size());
+    user_activity_ = true;
+
+    const uint16_t stream_id = read_stream_id_;
+
+    NetworkChannel* stream = findStream(stream_id);
+    if (stream)
+    {
+        if (!stream->onStreamData(std::move(read_buffer_)))
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+            return;
+        }
     }
-    else
+    else if ((stream_id & 1) != (next_stream_id_ & 1) && stream_id > last_peer_stream_id_)
     {
-        // Save sending time.
-        keep_alive_timestamp_ = Clock::now();
+        // The first message of a stream opened by the peer.
+        last_peer_stream_id_ = stream_id;
 
-        // Send ping.
-        sendKeepAlive(KEEP_ALIVE_PING, keep_alive_counter_.data(), keep_alive_counter_.size());
+        if (stream_listener_ && !destroyed_ && streams_.size() < kMaxStreams)
+        {
+            std::unique_ptr<NetworkChannel> new_stream = createStream(stream_id);
+            new_stream->onStreamData(std::move(read_buffer_));
 
-        // If a response is not received within the specified interval, the connection will be
-        // terminated.
-        keep_alive_timer_->expires_after(keep_alive_timeout_);
-        keep_alive_timer_->async_wait(
-            std::bind(&NetworkChannel::onKeepAliveTimeout, this, std::placeholders::_1));
+            doReadSize();
+            stream_listener_->onStreamOpened(std::move(new_stream));
+            return;
+        }
+
+        LOG(LS_WARNING) << "Stream " << stream_id << " is rejected";
+        sendServiceMessage(STREAM_CLOSE, 0, stream_id, nullptr, 0);
     }
+
+    // Messages of the closed streams are dropped.
+    doReadSize();
 }
 
-void NetworkChannel::onKeepAliveTimeout(const std::error_code& error_code)
+NetworkChannel* NetworkChannel::findStream(uint16_t stream_id) const
 {
-    if (error_code == asio::error::operation_aborted)
+    for (NetworkChannel* stream : streams_)
+    {
+        if (stream->stream_id_ == stream_id)
+            return stream;
+    }
+
+    return nullptr;
+}
+
+std::unique_ptr<NetworkChannel> NetworkChannel::createStream(uint16_t stream_id)
+{
+    std::unique_ptr<NetworkChannel> stream(new NetworkChannel(this, stream_id));
+    streams_.emplace_back(stream.get());
+    return stream;
+}
+
+void NetworkChannel::removeStream(NetworkChannel* stream, bool notify_peer)
+{
+    auto it = std::find(streams_.begin(), streams_.end(), stream);
+    if (it == streams_.end())
         return;
 
-    if (error_code)
+    streams_.erase(it);
+    write_cursor_ = 0;
+
+    stream->parent_ = nullptr;
+    stream->connected_ = false;
+
+    if (notify_peer && connected_)
+        sendServiceMessage(STREAM_CLOSE, 0, stream->stream_id_, nullptr, 0);
+
+    // A destroyed channel lives only for its streams.
+    if (destroyed_ && streams_.empty())
+    {
+        destroyed_ = false;
+        MessageLoop::current()->taskRunner()->deleteSoon(this);
+    }
+}
+
+void NetworkChannel::onStreamClosed(uint16_t stream_id)
+{
+    if (!stream_id)
+    {
+        // The peer has destroyed its channel and keeps the connection only for the streams. The
+        // messages of the streams are read even if the channel was paused.
+        paused_ = false;
+
+        if (listener_)
+        {
+            Listener* listener = listener_;
+            listener_ = nullptr;
+            listener->onDisconnected(ErrorCode::REMOTE_HOST_CLOSED);
+        }
+        return;
+    }
+
+    NetworkChannel* stream = findStream(stream_id);
+    if (!stream)
+        return;
+
+    removeStream(stream, false);
+
+    if (stream->listener_)
+    {
+        Listener* listener = stream->listener_;
+        stream->listener_ = nullptr;
+        listener->onDisconnected(ErrorCode::REMOTE_HOST_CLOSED);
+    }
+}
+
+void NetworkChannel::disconnectStreams(ErrorCode error_code)
+{
+    // A listener can destroy other streams, so the list is checked after each notification.
+    while (!streams_.empty())
+    {
+        NetworkChannel* stream = streams_.front();
+        removeStream(stream, false);
+
+        if (stream->listener_)
+        {
+            Listener* listener = stream->listener_;
+            stream->listener_ = nullptr;
+            listener->onDisconnected(error_code);
+        }
+    }
+}
+
+bool NetworkChannel::onStreamData(ByteArray&& data)
+{
+    DCHECK(isStream());
+
+    // The peer can exceed the window only with the last message it sent.
+    receive_pending_ += data.size();
+    if (receive_pending_ > kStreamWindow + kMaxMessageSize)
     {
-        LOG(LS_ERROR) << "Keep alive timer error: " << utf16FromLocal8Bit(error_code.message());
+        LOG(LS_ERROR) << "Window of stream " << stream_id_ << " is exceeded";
+        return false;
     }
 
-    // No response came within the specified period of time. We forcibly terminate the connection.
-    onErrorOccurred(FROM_HERE, ErrorCode::SOCKET_TIMEOUT);
+    stream_incoming_.push_back(std::move(data));
+
+    if (!paused_)
+        deliverStreamData();
+
+    return true;
+}
+
+void NetworkChannel::deliverStreamData()
+{
+    TRACE_EVENT("net", "NetworkChannel::deliverStreamData");
+
+    while (!paused_ && connected_ && !stream_incoming_.empty())
+    {
+        ByteArray data = std::move(stream_incoming_.front());
+        stream_incoming_.pop_front();
+
+        const size_t size = data.size();
+        if (size < decryptor_->tagSize())
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::INVALID_PROTOCOL);
+            return;
+        }
+
+        resizeBuffer(&read_buffer_, decryptor_->decryptedDataSize(size));
+
+        if (!decryptor_->decrypt(data.data(), size, read_buffer_.data()))
+        {
+            onErrorOccurred(FROM_HERE, ErrorCode::ACCESS_DENIED);
+            return;
+        }
+
+        BufferPool::instance()->release(std::move(data));
+        addRxBytes(size);
+
+        // The window is extended when a quarter of it is delivered to the listener, so a paused
+        // stream holds back only its own data.
+        receive_consumed_ += size;
+        if (receive_consumed_ >= kStreamWindow / 4 && parent_)
+        {
+            const uint32_t window = static_cast<uint32_t>(receive_consumed_);
+            parent_->sendServiceMessage(STREAM_WINDOW, 0, stream_id_, &window, sizeof(window));
+
+            receive_pending_ -= receive_consumed_;
+            receive_consumed_ = 0;
+        }
+
+        if (listener_)
+            listener_->onMessageReceived(read_buffer_);
+    }
+}
+
+void NetworkChannel::onKeepAliveTimer()
+{
+    DCHECK(keep_alive_enabled_);
+
+    if (keep_alive_ping_sent_)
+    {
+        // No response came within the specified period of time. We forcibly terminate the
+        // connection.
+        onErrorOccurred(FROM_HERE, ErrorCode::SOCKET_TIMEOUT);
+        return;
+    }
+
+    // Most of the channels of a server spend their time waiting for the next message. Such channels
+    // should not hold the buffers of the last message.
+    if (!user_activity_)
+        releaseIdleBuffers();
+    user_activity_ = false;
+
+    // Save sending time.
+    keep_alive_timestamp_ = Clock::now();
+
+    // Send ping.
+    sendKeepAlive(KEEP_ALIVE_PING, keep_alive_counter_.data(), keep_alive_counter_.size());
+
+    // If a response is not received within the specified interval, the connection will be
+    // terminated.
+    keep_alive_ping_sent_ = true;
+    keep_alive_timer_.start(io_context_, keep_alive_timeout_);
+}
+
+void NetworkChannel::releaseIdleBuffers()
+{
+    // The read buffer is not used while the channel waits for the size of the next message or is
+    // paused between messages.
+    if (state_ == ReadState::IDLE || state_ == ReadState::READ_SIZE)
+    {
+        if (read_buffer_.capacity())
+            BufferPool::instance()->release(std::move(read_buffer_));
+        read_buffer_ = ByteArray();
+        read_tag_ = ByteArray();
+    }
+
+    if (write_pending_)
+        return;
+
+    if (write_buffer_.capacity())
+        BufferPool::instance()->release(std::move(write_buffer_));
+    write_buffer_ = ByteArray();
+
+    write_batch_ = std::vector<WriteTask>();
+    write_buffers_ = std::vector<asio::const_buffer>();
+
+    write_queue_.releaseMemory();
 }
 
 void NetworkChannel::sendKeepAlive(uint8_t flags, const void* data, size_t size)
+{
+    sendServiceMessage(KEEP_ALIVE, flags, 0, data, size);
+}
+
+void NetworkChannel::sendServiceMessage(uint8_t type, uint8_t flags, uint16_t stream,
+                                        const void* data, size_t size)
 {
     ServiceHeader header;
     memset(&header, 0, sizeof(header));
 
-    header.type   = KEEP_ALIVE;
+    header.type   = type;
     header.flags  = flags;
+    header.stream = stream;
     header.length = static_cast<uint32_t>(size);
 
     ByteArray buffer;
@@ -872,22 +1748,106 @@ void NetworkChannel::sendKeepAlive(uint8_t flags, const void* data, size_t size)
 
     // Now copy the header and data to the buffer.
     memcpy(buffer.data() + sizeof(uint8_t), &header, sizeof(header));
-    memcpy(buffer.data() + sizeof(uint8_t) + sizeof(header), data, size);
+    if (size)
+        memcpy(buffer.data() + sizeof(uint8_t) + sizeof(header), data, size);
 
     // Add a task to the queue.
-    addWriteTask(WriteTask::Type::SERVICE_DATA, std::move(buffer));
+    addWriteTask(WriteTask(WriteTask::Type::SERVICE_DATA, Priority::NORMAL, std::move(buffer)));
 }
 
 void NetworkChannel::addTxBytes(size_t bytes_count)
 {
     bytes_tx_ += bytes_count;
     total_tx_ += bytes_count;
+
+    if (autotune_max_size_)
+        autotuneBuffers();
 }
 
 void NetworkChannel::addRxBytes(size_t bytes_count)
 {
     bytes_rx_ += bytes_count;
     total_rx_ += bytes_count;
+
+    if (autotune_max_size_)
+        autotuneBuffers();
+}
+
+void NetworkChannel::autotuneBuffers()
+{
+    const TimePoint current_time = Clock::now();
+    const Milliseconds duration =
+        std::chrono::duration_cast<Milliseconds>(current_time - autotune_time_);
+    if (duration < kAutotuneInterval)
+        return;
+
+    // The counters of speedRx() and speedTx() belong to the user, so the speed is calculated from
+    // the totals.
+    const ChannelEstimator::Estimate& estimate = estimator_.estimate();
+    const int64_t rx_speed = (total_rx_ - autotune_rx_) * 1000 / duration.count();
+    const int64_t tx_speed =
+        std::max(estimate.bandwidth, (total_tx_ - autotune_tx_) * 1000 / duration.count());
+
+    autotune_time_ = current_time;
+    autotune_rx_ = total_rx_;
+    autotune_tx_ = total_tx_;
+
+    // Without the round-trip time the bandwidth-delay product is unknown.
+    if (estimate.rtt <= Milliseconds::zero())
+        return;
+
+    const size_t read_target = autotuneTarget(rx_speed, estimate.rtt, autotune_max_size_);
+    if (read_target)
+    {
+        if (!read_buffer_size_)
+        {
+            asio::socket_base::receive_buffer_size option;
+            asio::error_code error_code;
+            socket_.get_option(option, error_code);
+            if (!error_code)
+                read_buffer_size_ = static_cast<size_t>(option.value());
+        }
+
+        if (read_target > read_buffer_size_ + read_buffer_size_ / kAutotuneMinGrowthDivisor)
+        {
+            // If the system does not accept the size, autotuning is stopped to not repeat the
+            // error.
+            LOG(LS_INFO) << "Read buffer size: " << read_buffer_size_ << " -> " << read_target
+                         << " (RTT: " << estimate.rtt.count() << " ms)";
+            if (!setReadBufferSize(read_target))
+            {
+                autotune_max_size_ = 0;
+                return;
+            }
+        }
+    }
+
+#if defined(OS_WIN)
+    // On Windows the low watermark is implemented with the size of the send buffer.
+    if (write_low_watermark_)
+        return;
+#endif // defined(OS_WIN)
+
+    const size_t write_target = autotuneTarget(tx_speed, estimate.rtt, autotune_max_size_);
+    if (write_target)
+    {
+        if (!write_buffer_size_)
+        {
+            asio::socket_base::send_buffer_size option;
+            asio::error_code error_code;
+            socket_.get_option(option, error_code);
+            if (!error_code)
+                write_buffer_size_ = static_cast<size_t>(option.value());
+        }
+
+        if (write_target > write_buffer_size_ + write_buffer_size_ / kAutotuneMinGrowthDivisor)
+        {
+            LOG(LS_INFO) << "Write buffer size: " << write_buffer_size_ << " -> " << write_target
+                         << " (RTT: " << estimate.rtt.count() << " ms)";
+            if (!setWriteBufferSize(write_target))
+                autotune_max_size_ = 0;
+        }
+    }
 }
 
 } // namespace base
@@ -20,13 +20,19 @@
 #define BASE__NET__NETWORK_CHANNEL_H
 
 #include "base/memory/byte_array.h"
+#include "base/memory/shared_byte_array.h"
+#include "base/net/channel_estimator.h"
+#include "base/net/handler_allocator.h"
+#include "base/net/keep_alive_wheel.h"
 #include "base/net/variable_size.h"
-#include "base/net/write_task.h"
+#include "base/net/write_queue.h"
 
 #include <asio/ip/tcp.hpp>
-#include <asio/high_resolution_timer.hpp>
 
-#include <queue>
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
 
 namespace base {
 
@@ -47,6 +53,7 @@ public:
     using TimePoint = std::chrono::time_point<Clock>;
     using Milliseconds = std::chrono::milliseconds;
     using Seconds = std::chrono::seconds;
+    using Priority = WriteTask::Priority;
 
     enum class ErrorCode
     {
@@ -93,10 +100,58 @@ public:
         virtual void onDisconnected(ErrorCode error_code) = 0;
         virtual void onMessageReceived(const ByteArray& buffer) = 0;
         virtual void onMessageWritten(size_t pending) = 0;
+
+        // Called when the estimate of the channel parameters has changed significantly.
+        // Implementation is optional.
+        virtual void onEstimateChanged(const ChannelEstimator::Estimate& /* estimate */) {}
+
+        // Called when all queued messages are written and the socket is ready to accept the next
+        // message without delay (see setWriteLowWatermark). Implementation is optional.
+        virtual void onWritable() {}
+    };
+
+    // The end of the connection. Streams opened by the client have odd numbers and streams opened
+    // by the server have even numbers, so both ends can open streams at the same time.
+    enum class Role
+    {
+        CLIENT, // The end which has connected (see connect).
+        SERVER  // The end which has accepted the connection.
+    };
+
+    class StreamListener
+    {
+    public:
+        virtual ~StreamListener() = default;
+
+        // Called when the peer opens a stream of the channel (see openStream). The stream is
+        // paused, and the first messages are delivered after resume(). If the stream is destroyed
+        // right away, it is closed for the peer.
+        virtual void onStreamOpened(std::unique_ptr<NetworkChannel> stream) = 0;
     };
 
     std::shared_ptr<NetworkChannelProxy> channelProxy();
 
+    // Destroys the channel. If the channel has streams, the connection stays open for them and is
+    // closed with the last stream. The peer gets Listener::onDisconnected for the channel itself.
+    static void destroy(std::unique_ptr<NetworkChannel> channel);
+
+    // Opens a logical stream over the connection of the channel. The stream is a channel of its
+    // own: it has its own listener, encryption, queue of messages and pause, but shares the socket,
+    // the keep alive and the estimate of the connection. Socket options of a stream are ignored.
+    // Messages of the channel and its streams are sent in turns, so a stream with bulk data does
+    // not delay the others, and each stream sends only as much data as the peer allows (the peer
+    // holds back the window of a paused stream). The stream ends with the connection. Returns
+    // nullptr if the channel is a stream itself, is not connected or has too many streams. The
+    // peer must support streams (see StreamListener).
+    std::unique_ptr<NetworkChannel> openStream();
+
+    // Sets the listener for the streams opened by the peer. If it is not set, the streams are
+    // closed right away.
+    void setStreamListener(StreamListener* listener);
+
+    // Returns true if the channel is a stream of another channel.
+    bool isStream() const { return stream_id_ != 0; }
+
     // Sets an instance of the class to receive connection status notifications or new messages.
     // You can change this in the process.
     void setListener(Listener* listener);
@@ -129,8 +184,30 @@ public:
     void resume();
 
     // Sending a message. The method call is thread safe. After the call, the message will be added
-    // to the queue to be sent.
-    void send(ByteArray&& buffer);
+    // to the queue to be sent. Messages with a higher |priority| are sent ahead of the already
+    // queued messages with a lower priority.
+    void send(ByteArray&& buffer, Priority priority = Priority::NORMAL);
+
+    // Same as the method above, but the buffer can be sent to several channels at once without
+    // copying. Since the buffer is not modified, the message is encrypted into the write buffer of
+    // the channel.
+    void send(SharedByteArray&& buffer, Priority priority = Priority::NORMAL);
+
+    // Same as the method above, but the message is serialized directly into a buffer with space
+    // reserved for the message size and the encryption overhead, and is encrypted in place. This
+    // avoids an extra allocation and copy of the message. Tiny messages are stored in the queue
+    // itself (see SmallByteArray).
+    void send(const google::protobuf::MessageLite& message, Priority priority = Priority::NORMAL);
+
+    // Same as the method above, but the message can be removed from the queue with
+    // discardQueued() while it waits to be sent. Used for the messages which become stale if they
+    // are not delivered in time (for example, video frames).
+    void sendDiscardable(const google::protobuf::MessageLite& message,
+                         Priority priority = Priority::NORMAL);
+
+    // Removes the discardable messages which are not yet written to the socket from the queue and
+    // returns their number. Must be called on the thread of the channel.
+    size_t discardQueued();
 
     // Disable or enable the algorithm of Nagle.
     bool setNoDelay(bool enable);
@@ -152,21 +229,55 @@ public:
     bool setReadBufferSize(size_t size);
     bool setWriteBufferSize(size_t size);
 
+    // Enables autotuning of the socket buffers. The buffers grow to the bandwidth-delay product
+    // of the connection (the measured throughput multiplied by the round-trip time), so a long
+    // fat link is not limited by the window of the connection. The buffers never shrink and never
+    // get larger than |max_size|. The round-trip time is measured only if own keep alive is
+    // enabled. If |max_size| is zero, autotuning is disabled.
+    void setBufferAutotuning(size_t max_size);
+
+    // Selects the congestion control algorithm of the socket (see setTcpCongestionControl).
+    bool setCongestionControl(std::string_view algorithm);
+
+    // Enables the writable notification mode. Messages are written to the socket only when the
+    // amount of data which the system has not yet sent drops below |bytes|, so the backlog stays in
+    // the queue of the channel (see pendingBytes()) instead of the send buffer of the system. When
+    // the queue is empty and the socket is writable, Listener::onWritable is called. The mode can
+    // not be disabled and is not supported by streams.
+    bool setWriteLowWatermark(size_t bytes);
+
+    // Returns the number of bytes of the messages that are waiting to be sent or are being written
+    // to the socket right now.
+    size_t pendingBytes() const { return write_queue_.bytes() + write_batch_bytes_; }
+
+    // Sets the account of the session to which the pending messages are counted (see
+    // MemoryTag::WRITE_QUEUES).
+    void setMemoryAccount(std::shared_ptr<MemoryAccount> account);
+
     int64_t totalRx() const { return total_rx_; }
     int64_t totalTx() const { return total_tx_; }
     int speedRx();
     int speedTx();
 
+    // Returns the current estimate of the round-trip time, the send queue delay and the achievable
+    // throughput. The round-trip time is measured only if own keep alive is enabled.
+    const ChannelEstimator::Estimate& estimate() const
+    {
+        return parent_ ? parent_->estimate() : estimator_.estimate();
+    }
+
     // Converts an error code to a human readable string.
     // Does not support localization. Used for logs.
     static std::string errorToString(ErrorCode error_code);
 
 protected:
     friend class NetworkServer;
+    friend class DirectPeer;
     friend class RelayPeer;
 
-    // Constructor available for server. An already connected socket is being moved.
-    explicit NetworkChannel(asio::ip::tcp::socket&& socket);
+    // Constructor available for server and peers. An already connected socket is being moved.
+    // |role| is the role of this end of the connection in the session.
+    NetworkChannel(asio::ip::tcp::socket&& socket, Role role);
 
     // Disconnects to remote host. The method is not available for an external call.
     // To disconnect, you must destroy the channel by calling the destructor.
@@ -182,12 +293,20 @@ private:
         READ_SERVICE_HEADER, // Reading the contents of the service header.
         READ_SERVICE_DATA,   // Reading the contents of the service data.
         READ_USER_DATA,      // Reading the contents of the user data.
+        READ_STREAM_DATA,    // Reading the contents of a message of a stream.
         PENDING              // There is a message about which we did not notify.
     };
 
+    // Space reserved in front of a serialized message for the message size (up to 4 bytes) and the
+    // encryption overhead (authentication tag, up to 16 bytes).
+    static constexpr size_t kWriteHeadroom = 4 + 16;
+
     enum ServiceMessageType
     {
-        KEEP_ALIVE = 1
+        KEEP_ALIVE = 1,
+        STREAM_DATA = 3,  // Encrypted message of a stream.
+        STREAM_CLOSE = 4, // The stream is closed (the stream 0 is the channel itself).
+        STREAM_WINDOW = 5 // The peer can send more data to the stream (uint32_t in bytes).
     };
 
     enum KeepAliveFlags
@@ -200,21 +319,47 @@ private:
     {
         uint8_t type;      // Type of service packet (see ServiceDataType).
         uint8_t flags;     // Flags bitmask (depends on the type).
-        uint8_t reserved1; // Reserved.
-        uint8_t reserved2; // Reserved.
+        uint16_t stream;   // Number of the stream (zero for the channel itself).
         uint32_t length;   // Additional data size.
     };
 
+    // Size of the frame of a message of a stream: the first zero byte of a service message
+    // followed by the service header.
+    static constexpr size_t kServiceFrameSize = sizeof(uint8_t) + sizeof(ServiceHeader);
+
+    // Constructor of a stream of |parent|.
+    NetworkChannel(NetworkChannel* parent, uint16_t stream_id);
+
     void onErrorOccurred(const Location& location, const std::error_code& error_code);
     void onErrorOccurred(const Location& location, ErrorCode error_code);
     void onMessageWritten();
     void onMessageReceived();
 
-    void addWriteTask(WriteTask::Type type, ByteArray&& data);
+    // Serializes |message| into a task for the write queue.
+    static WriteTask messageTask(const google::protobuf::MessageLite& message, Priority priority);
+
+    void addWriteTask(WriteTask&& task);
+    bool encodeWriteTask(WriteTask* task, asio::const_buffer* buffer);
+
+    // Starts writing if no write operation is in progress and there is something to send. For a
+    // stream, the connection is written.
+    void scheduleWrite();
+
+    // Takes the messages added from other threads to the queues of the channel and its streams.
+    // Returns true if any of the queues has a message which can be sent.
+    bool reloadWriteQueues();
+    bool hasWritableQueue() const;
+    bool canWriteStream() const { return !write_queue_.empty() && send_window_ > 0; }
+
+    // Returns the channel (this one or a stream) whose message is sent next.
+    NetworkChannel* nextWriteSource();
 
     void doWrite();
     void onWrite(const std::error_code& error_code, size_t bytes_transferred);
 
+    void doWaitWritable();
+    void onWaitWritable(const std::error_code& error_code);
+
     void doReadSize();
     void onReadSize(const std::error_code& error_code, size_t bytes_transferred);
 
@@ -227,24 +372,55 @@ private:
     void doReadServiceData(size_t length);
     void onReadServiceData(const std::error_code& error_code, size_t bytes_transferred);
 
-    void onKeepAliveInterval(const std::error_code& error_code);
-    void onKeepAliveTimeout(const std::error_code& error_code);
+    void doReadStreamData(size_t length);
+    void onReadStreamData(const std::error_code& error_code, size_t bytes_transferred);
+
+    NetworkChannel* findStream(uint16_t stream_id) const;
+    std::unique_ptr<NetworkChannel> createStream(uint16_t stream_id);
+
+    // Removes the stream from the list of the streams. If |notify_peer| is true, the peer gets
+    // STREAM_CLOSE.
+    void removeStream(NetworkChannel* stream, bool notify_peer);
+    void onStreamClosed(uint16_t stream_id);
+    void disconnectStreams(ErrorCode error_code);
+
+    // Called for a stream when its encrypted message is received by the connection.
+    bool onStreamData(ByteArray&& data);
+    void deliverStreamData();
+
+    // Returns buffers for reading an encrypted message of |length| bytes: the authentication tag
+    // goes to |read_tag_| and the encrypted data to |read_buffer_|, where it is decrypted in place.
+    std::array<asio::mutable_buffer, 2> encryptedReadBuffers(size_t length);
+
+    void onKeepAliveTimer();
     void sendKeepAlive(uint8_t flags, const void* data, size_t size);
+    void sendServiceMessage(uint8_t type, uint8_t flags, uint16_t stream,
+                            const void* data, size_t size);
+
+    // Returns the read and write buffers to the pool if the channel has not sent or received user
+    // data since the previous keep alive interval.
+    void releaseIdleBuffers();
 
     void addTxBytes(size_t bytes_count);
     void addRxBytes(size_t bytes_count);
+    void autotuneBuffers();
 
     std::shared_ptr<NetworkChannelProxy> proxy_;
     asio::io_context& io_context_;
     asio::ip::tcp::socket socket_;
     std::unique_ptr<asio::ip::tcp::resolver> resolver_;
 
-    std::unique_ptr<asio::high_resolution_timer> keep_alive_timer_;
+    KeepAliveWheel::Timer keep_alive_timer_ { std::bind(&NetworkChannel::onKeepAliveTimer, this) };
+    bool keep_alive_enabled_ = false;
+    bool keep_alive_ping_sent_ = false;
     Seconds keep_alive_interval_;
     Seconds keep_alive_timeout_;
     ByteArray keep_alive_counter_;
     TimePoint keep_alive_timestamp_;
 
+    // Set when user data is sent or received. It is reset on each keep alive interval.
+    bool user_activity_ = false;
+
     Listener* listener_ = nullptr;
     bool connected_ = false;
     bool paused_ = true;
@@ -252,18 +428,78 @@ private:
     std::unique_ptr<MessageEncryptor> encryptor_;
     std::unique_ptr<MessageDecryptor> decryptor_;
 
-    std::queue<WriteTask> write_queue_;
+    WriteQueue write_queue_;
     VariableSizeWriter variable_size_writer_;
+
+    // Messages of the current write operation and buffers that refer to them.
+    std::vector<WriteTask> write_batch_;
+    std::vector<asio::const_buffer> write_buffers_;
+    size_t write_batch_messages_ = 0;
+    size_t write_batch_bytes_ = 0;
+    TrackedMemory write_batch_memory_ { MemoryTag::WRITE_QUEUES };
+    bool write_pending_ = false;
+
+    // If the low watermark is set, the socket must be writable before a write operation.
+    bool write_low_watermark_ = false;
+    bool socket_writable_ = false;
+
+    // Storage for framed messages that could not be encrypted in place.
     ByteArray write_buffer_;
 
+    // Only one read and one write operation are pending at a time. Their handlers are allocated
+    // from these blocks instead of the heap. The blocks are shared with the pending operations,
+    // because the cancelled operations of a destroyed channel are completed later.
+    std::shared_ptr<HandlerMemory> read_handler_memory_ = std::make_shared<HandlerMemory>();
+    std::shared_ptr<HandlerMemory> write_handler_memory_ = std::make_shared<HandlerMemory>();
+
     ReadState state_ = ReadState::IDLE;
     VariableSizeReader variable_size_reader_;
     ByteArray read_buffer_;
-    ByteArray decrypt_buffer_;
+    ByteArray read_tag_;
+
+    ChannelEstimator estimator_;
+
+    // Streams of the channel (see openStream). The channel does not own them.
+    std::vector<NetworkChannel*> streams_;
+    StreamListener* stream_listener_ = nullptr;
+    uint16_t next_stream_id_ = 1;
+    uint16_t last_peer_stream_id_ = 0;
+    uint16_t read_stream_id_ = 0;
+
+    // Streams and the channel itself take turns in writing (deficit round robin). The cursor is
+    // the index in the list of the streams, where zero is the channel itself.
+    size_t write_cursor_ = 0;
+    int64_t write_deficit_ = 0;
+    std::vector<uint16_t> written_streams_;
+
+    // Set by destroy() when the channel stays alive for its streams.
+    bool destroyed_ = false;
+
+    // The stream: the channel which owns the connection and the number of the stream.
+    NetworkChannel* parent_ = nullptr;
+    uint16_t stream_id_ = 0;
+
+    // Bytes the stream can send before the peer extends the window.
+    int64_t send_window_ = 0;
+
+    // Encrypted messages of the stream which are not delivered yet. They are decrypted when they
+    // are delivered, because the authenticator changes the decryptor between messages.
+    std::deque<ByteArray> stream_incoming_;
+    size_t receive_pending_ = 0;
+    size_t receive_consumed_ = 0;
 
     int64_t total_tx_ = 0;
     int64_t total_rx_ = 0;
 
+    // Buffer autotuning (see setBufferAutotuning). The current sizes are zero until they are set
+    // or read from the socket.
+    size_t autotune_max_size_ = 0;
+    size_t read_buffer_size_ = 0;
+    size_t write_buffer_size_ = 0;
+    TimePoint autotune_time_;
+    int64_t autotune_rx_ = 0;
+    int64_t autotune_tx_ = 0;
+
     TimePoint begin_time_tx_;
     int64_t bytes_tx_ = 0;
     int speed_tx_ = 0;
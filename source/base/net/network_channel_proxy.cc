@@ -31,13 +31,29 @@ NetworkChannelProxy::NetworkChannelProxy(
     // Nothing
 }
 
-void NetworkChannelProxy::send(ByteArray&& buffer)
+void NetworkChannelProxy::send(ByteArray&& buffer, NetworkChannel::Priority priority)
+{
+    addWriteTask(WriteTask(WriteTask::Type::USER_DATA, priority, std::move(buffer)));
+}
+
+void NetworkChannelProxy::send(SharedByteArray&& buffer, NetworkChannel::Priority priority)
+{
+    addWriteTask(WriteTask(WriteTask::Type::USER_DATA, priority, std::move(buffer)));
+}
+
+void NetworkChannelProxy::send(const google::protobuf::MessageLite& message,
+                               NetworkChannel::Priority priority)
+{
+    addWriteTask(NetworkChannel::messageTask(message, priority));
+}
+
+void NetworkChannelProxy::addWriteTask(WriteTask&& task)
 {
     std::scoped_lock lock(incoming_queue_lock_);
 
     bool schedule_write = incoming_queue_.empty();
 
-    incoming_queue_.emplace(WriteTask::Type::USER_DATA, std::move(buffer));
+    incoming_queue_.emplace(std::move(task));
 
     if (!schedule_write)
         return;
@@ -58,21 +74,23 @@ void NetworkChannelProxy::scheduleWrite()
     if (!reloadWriteQueue(&channel_->write_queue_))
         return;
 
-    channel_->doWrite();
+    // If a write operation is in progress, the queue will be sent after it is completed.
+    channel_->scheduleWrite();
 }
 
-bool NetworkChannelProxy::reloadWriteQueue(std::queue<WriteTask>* work_queue)
+bool NetworkChannelProxy::reloadWriteQueue(WriteQueue* work_queue)
 {
-    if (!work_queue->empty())
-        return false;
-
     std::scoped_lock lock(incoming_queue_lock_);
 
     if (incoming_queue_.empty())
         return false;
 
-    incoming_queue_.swap(*work_queue);
-    DCHECK(incoming_queue_.empty());
+    // Messages are moved one by one so that each one gets into the lane of its priority.
+    while (!incoming_queue_.empty())
+    {
+        work_queue->push(std::move(incoming_queue_.front()));
+        incoming_queue_.pop();
+    }
 
     return true;
 }
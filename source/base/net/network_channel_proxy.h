@@ -21,6 +21,7 @@
 
 #include "base/net/network_channel.h"
 
+#include <queue>
 #include <shared_mutex>
 
 namespace base {
@@ -30,7 +31,14 @@ class TaskRunner;
 class NetworkChannelProxy : public std::enable_shared_from_this<NetworkChannelProxy>
 {
 public:
-    void send(ByteArray&& buffer);
+    void send(ByteArray&& buffer,
+              NetworkChannel::Priority priority = NetworkChannel::Priority::NORMAL);
+    void send(SharedByteArray&& buffer,
+              NetworkChannel::Priority priority = NetworkChannel::Priority::NORMAL);
+
+    // The message is serialized in the calling thread with space reserved for in-place encryption.
+    void send(const google::protobuf::MessageLite& message,
+              NetworkChannel::Priority priority = NetworkChannel::Priority::NORMAL);
 
 private:
     friend class NetworkChannel;
@@ -39,8 +47,9 @@ private:
     // Called directly by NetworkChannel::~NetworkChannel.
     void willDestroyCurrentChannel();
 
+    void addWriteTask(WriteTask&& task);
     void scheduleWrite();
-    bool reloadWriteQueue(std::queue<WriteTask>* work_queue);
+    bool reloadWriteQueue(WriteQueue* work_queue);
 
     std::shared_ptr<TaskRunner> task_runner_;
 
@@ -0,0 +1,186 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/network_channel.h"
+
+#include "base/message_loop/message_loop.h"
+#include "base/net/network_server.h"
+#include "base/peer/direct_peer.h"
+#include "base/task_runner.h"
+#include "proto/router_peer.pb.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+const std::chrono::seconds kTimeout { 10 };
+
+class TestEnd
+    : public NetworkChannel::Listener,
+      public NetworkChannel::StreamListener
+{
+public:
+    explicit TestEnd(std::shared_ptr<TaskRunner> task_runner)
+        : task_runner_(std::move(task_runner))
+    {
+        // Nothing
+    }
+
+    void setChannel(std::unique_ptr<NetworkChannel> channel)
+    {
+        channel_ = std::move(channel);
+        ASSERT_TRUE(channel_);
+
+        channel_->setListener(this);
+        channel_->setStreamListener(this);
+        channel_->resume();
+        task_runner_->postQuit();
+    }
+
+    NetworkChannel* channel() const { return channel_.get(); }
+    NetworkChannel* peerStream() const { return peer_stream_.get(); }
+    const std::string& received() const { return received_; }
+
+    // NetworkChannel::Listener implementation.
+    void onConnected() override {}
+    void onDisconnected(NetworkChannel::ErrorCode /* error_code */) override {}
+    void onMessageWritten(size_t /* pending */) override {}
+
+    void onMessageReceived(const ByteArray& buffer) override
+    {
+        received_.assign(buffer.begin(), buffer.end());
+        task_runner_->postQuit();
+    }
+
+    // NetworkChannel::StreamListener implementation.
+    void onStreamOpened(std::unique_ptr<NetworkChannel> stream) override
+    {
+        peer_stream_ = std::move(stream);
+        peer_stream_->setListener(this);
+        peer_stream_->resume();
+    }
+
+private:
+    std::shared_ptr<TaskRunner> task_runner_;
+    std::unique_ptr<NetworkChannel> channel_;
+    std::unique_ptr<NetworkChannel> peer_stream_;
+    std::string received_;
+};
+
+class ServerDelegate : public NetworkServer::Delegate
+{
+public:
+    explicit ServerDelegate(TestEnd* end) : end_(end) {}
+
+    void onNewConnection(std::unique_ptr<NetworkChannel> channel) override
+    {
+        end_->setChannel(std::move(channel));
+    }
+
+private:
+    TestEnd* end_;
+};
+
+class PeerDelegate : public DirectPeer::Delegate
+{
+public:
+    explicit PeerDelegate(TestEnd* end) : end_(end) {}
+
+    void onDirectConnectionReady(std::unique_ptr<NetworkChannel> channel) override
+    {
+        end_->setChannel(std::move(channel));
+    }
+
+    void onDirectConnectionError() override
+    {
+        ADD_FAILURE() << "Unable to connect";
+    }
+
+private:
+    TestEnd* end_;
+};
+
+ByteArray toByteArray(const std::string& string)
+{
+    return ByteArray(string.begin(), string.end());
+}
+
+} // namespace
+
+TEST(NetworkChannelTest, StreamsOfMovedSockets)
+{
+    MessageLoop message_loop(MessageLoop::Type::ASIO);
+    std::shared_ptr<TaskRunner> task_runner = message_loop.taskRunner();
+
+    // Stops the test if something does not arrive.
+    bool timeout = false;
+    task_runner->postDelayedTask([&]()
+    {
+        timeout = true;
+        task_runner->postQuit();
+    }, kTimeout);
+
+    TestEnd server_end(task_runner);
+    TestEnd client_end(task_runner);
+
+    // Both ends get the channel from the socket of the connection, as the peers which connect
+    // through a relay or directly do.
+    ServerDelegate server_delegate(&server_end);
+    NetworkServer server;
+    server.start(0, &server_delegate);
+
+    proto::ConnectionOffer offer;
+    proto::PeerCandidate* candidate = offer.add_candidate();
+    candidate->set_address("127.0.0.1");
+    candidate->set_port(server.port());
+
+    PeerDelegate peer_delegate(&client_end);
+    DirectPeer peer;
+    peer.start(offer, &peer_delegate);
+
+    while (!timeout && (!server_end.channel() || !client_end.channel()))
+        message_loop.run();
+
+    ASSERT_FALSE(timeout);
+
+    // Both ends open a stream at the same time.
+    std::unique_ptr<NetworkChannel> client_stream = client_end.channel()->openStream();
+    std::unique_ptr<NetworkChannel> server_stream = server_end.channel()->openStream();
+    ASSERT_TRUE(client_stream);
+    ASSERT_TRUE(server_stream);
+
+    client_stream->send(toByteArray("from client"));
+    server_stream->send(toByteArray("from server"));
+
+    while (!timeout && (server_end.received().empty() || client_end.received().empty()))
+        message_loop.run();
+
+    ASSERT_FALSE(timeout);
+
+    // Each end has accepted the stream of the other end.
+    EXPECT_TRUE(server_end.peerStream());
+    EXPECT_TRUE(client_end.peerStream());
+    EXPECT_EQ(server_end.received(), "from client");
+    EXPECT_EQ(client_end.received(), "from server");
+
+    server.stop();
+}
+
+} // namespace base
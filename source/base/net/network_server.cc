@@ -23,6 +23,7 @@
 #include "base/message_loop/message_pump_asio.h"
 #include "base/net/network_channel.h"
 #include "base/strings/unicode.h"
+#include "base/threading/thread.h"
 
 namespace base {
 
@@ -32,6 +33,7 @@ public:
     explicit Impl(asio::io_context& io_context);
     ~Impl();
 
+    void setThreadCount(size_t count);
     void start(uint16_t port, Delegate* delegate);
     void stop();
     uint16_t port() const;
@@ -39,12 +41,18 @@ public:
 private:
     void doAccept();
     void onAccept(const std::error_code& error_code, asio::ip::tcp::socket socket);
+    void onAcceptOnThread(std::shared_ptr<asio::ip::tcp::socket> socket);
 
     asio::io_context& io_context_;
     std::unique_ptr<asio::ip::tcp::acceptor> acceptor_;
     Delegate* delegate_ = nullptr;
     uint16_t port_ = 0;
 
+    // Threads that serve accepted connections and the index of the thread for the next one.
+    std::vector<std::unique_ptr<Thread>> threads_;
+    size_t next_thread_ = 0;
+    Thread* accept_thread_ = nullptr;
+
     DISALLOW_COPY_AND_ASSIGN(Impl);
 };
 
@@ -59,23 +67,46 @@ NetworkServer::Impl::~Impl()
     DCHECK(!acceptor_);
 }
 
+void NetworkServer::Impl::setThreadCount(size_t count)
+{
+    DCHECK(!acceptor_);
+    DCHECK(threads_.empty());
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::unique_ptr<Thread> thread = std::make_unique<Thread>();
+        thread->start(MessageLoop::Type::ASIO);
+        threads_.emplace_back(std::move(thread));
+    }
+}
+
 void NetworkServer::Impl::start(uint16_t port, Delegate* delegate)
 {
     delegate_ = delegate;
-    port_ = port;
 
     DCHECK(delegate_);
 
     asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port);
     acceptor_ = std::make_unique<asio::ip::tcp::acceptor>(io_context_, endpoint);
 
+    // The port is chosen by the system if zero is passed.
+    port_ = acceptor_->local_endpoint().port();
+
     doAccept();
 }
 
 void NetworkServer::Impl::stop()
 {
-    delegate_ = nullptr;
     acceptor_.reset();
+
+    // The tasks already posted to the threads (including the destruction of the channels served
+    // on them) are completed before the threads exit.
+    for (auto& thread : threads_)
+        thread->stop();
+    threads_.clear();
+    accept_thread_ = nullptr;
+
+    delegate_ = nullptr;
 }
 
 uint16_t NetworkServer::Impl::port() const
@@ -85,8 +116,22 @@ uint16_t NetworkServer::Impl::port() const
 
 void NetworkServer::Impl::doAccept()
 {
+    if (threads_.empty())
+    {
+        acceptor_->async_accept(
+            std::bind(&Impl::onAccept, shared_from_this(),
+                      std::placeholders::_1, std::placeholders::_2));
+        return;
+    }
+
+    accept_thread_ = threads_[next_thread_].get();
+    next_thread_ = (next_thread_ + 1) % threads_.size();
+
+    // The socket of the new connection is bound to the io_context of the serving thread.
     acceptor_->async_accept(
-        std::bind(&Impl::onAccept, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+        accept_thread_->messageLoop()->pumpAsio()->ioContext(),
+        std::bind(&Impl::onAccept, shared_from_this(),
+                  std::placeholders::_1, std::placeholders::_2));
 }
 
 void NetworkServer::Impl::onAccept(const std::error_code& error_code, asio::ip::tcp::socket socket)
@@ -99,10 +144,18 @@ void NetworkServer::Impl::onAccept(const std::error_code& error_code, asio::ip::
         LOG(LS_ERROR) << "Error while accepting connection: "
                       << base::utf16FromLocal8Bit(error_code.message());
     }
+    else if (accept_thread_)
+    {
+        // The channel is created on the thread that serves it. The socket is not copyable, so it is
+        // passed to the task by pointer.
+        accept_thread_->taskRunner()->postTask(
+            std::bind(&Impl::onAcceptOnThread, shared_from_this(),
+                      std::make_shared<asio::ip::tcp::socket>(std::move(socket))));
+    }
     else
     {
-        std::unique_ptr<NetworkChannel> channel =
-            std::unique_ptr<NetworkChannel>(new NetworkChannel(std::move(socket)));
+        std::unique_ptr<NetworkChannel> channel = std::unique_ptr<NetworkChannel>(
+            new NetworkChannel(std::move(socket), NetworkChannel::Role::SERVER));
 
         // Connection accepted.
         delegate_->onNewConnection(std::move(channel));
@@ -112,6 +165,18 @@ void NetworkServer::Impl::onAccept(const std::error_code& error_code, asio::ip::
     doAccept();
 }
 
+void NetworkServer::Impl::onAcceptOnThread(std::shared_ptr<asio::ip::tcp::socket> socket)
+{
+    // The delegate is reset only after the serving threads are stopped, so it remains valid here.
+    DCHECK(delegate_);
+
+    std::unique_ptr<NetworkChannel> channel = std::unique_ptr<NetworkChannel>(
+        new NetworkChannel(std::move(*socket), NetworkChannel::Role::SERVER));
+
+    // Connection accepted.
+    delegate_->onNewConnection(std::move(channel));
+}
+
 NetworkServer::NetworkServer()
     : impl_(std::make_shared<Impl>(MessageLoop::current()->pumpAsio()->ioContext()))
 {
@@ -123,6 +188,11 @@ NetworkServer::~NetworkServer()
     impl_->stop();
 }
 
+void NetworkServer::setThreadCount(size_t count)
+{
+    impl_->setThreadCount(count);
+}
+
 void NetworkServer::start(uint16_t port, Delegate* delegate)
 {
     impl_->start(port, delegate);
@@ -42,6 +42,13 @@ public:
         virtual void onNewConnection(std::unique_ptr<NetworkChannel> channel) = 0;
     };
 
+    // Sets the number of threads that serve accepted connections. If |count| is zero (default),
+    // connections are served on the thread of the server. Otherwise, accepted connections are
+    // spread round-robin across |count| threads, and Delegate::onNewConnection is called on the
+    // thread that serves the connection. In this case the delegate must be thread safe.
+    // Must be called before start().
+    void setThreadCount(size_t count);
+
     void start(uint16_t port, Delegate* delegate);
     void stop();
     uint16_t port() const;
@@ -0,0 +1,49 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/tcp_congestion_control.h"
+
+#include "base/logging.h"
+
+#if defined(OS_LINUX)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif // defined(OS_LINUX)
+
+namespace base {
+
+bool setTcpCongestionControl(NativeSocket socket, std::string_view algorithm)
+{
+#if defined(OS_LINUX)
+    if (setsockopt(socket, IPPROTO_TCP, TCP_CONGESTION,
+                   algorithm.data(), static_cast<socklen_t>(algorithm.size())) == -1)
+    {
+        PLOG(LS_WARNING) << "setsockopt(TCP_CONGESTION) failed for '" << algorithm << "'";
+        return false;
+    }
+
+    return true;
+#else
+    LOG(LS_WARNING) << "Congestion control can not be selected on this system";
+    return false;
+#endif
+}
+
+} // namespace base
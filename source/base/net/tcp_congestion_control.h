@@ -0,0 +1,36 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__NET__TCP_CONGESTION_CONTROL_H
+#define BASE__NET__TCP_CONGESTION_CONTROL_H
+
+#include "base/net/tcp_keep_alive.h"
+
+#include <string_view>
+
+namespace base {
+
+// Selects the congestion control algorithm of the socket (for example, "bbr" or "cubic"). The
+// algorithm must be available in the system. If it is set for a listening socket, the accepted
+// sockets inherit it. Supported only on Linux (TCP_CONGESTION), on other systems the default
+// algorithm of the system is used and false is returned.
+bool setTcpCongestionControl(NativeSocket socket, std::string_view algorithm);
+
+} // namespace base
+
+#endif // BASE__NET__TCP_CONGESTION_CONTROL_H
@@ -0,0 +1,77 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/net/tcp_low_watermark.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+
+#if defined(OS_WIN)
+#include <winsock2.h>
+#endif // defined(OS_WIN)
+
+#if defined(OS_POSIX)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif // defined(OS_POSIX)
+
+namespace base {
+
+bool setTcpSendLowWatermark(NativeSocket socket, size_t bytes)
+{
+#if defined(OS_WIN)
+    // The ideal send backlog is the amount of data that must be queued to keep the connection busy
+    // (the bandwidth-delay product).
+    ULONG backlog = 0;
+    DWORD bytes_returned = 0;
+
+    if (WSAIoctl(socket, SIO_IDEAL_SEND_BACKLOG_QUERY,
+                 nullptr, 0, &backlog, sizeof(backlog), &bytes_returned,
+                 nullptr, nullptr) == SOCKET_ERROR)
+    {
+        PLOG(LS_WARNING) << "WSAIoctl(SIO_IDEAL_SEND_BACKLOG_QUERY) failed";
+        return false;
+    }
+
+    int size = static_cast<int>(std::max(static_cast<size_t>(backlog), bytes));
+    if (setsockopt(socket, SOL_SOCKET, SO_SNDBUF,
+                   reinterpret_cast<const char*>(&size), sizeof(size)) == SOCKET_ERROR)
+    {
+        PLOG(LS_WARNING) << "setsockopt(SO_SNDBUF) failed";
+        return false;
+    }
+
+    return true;
+#elif defined(OS_POSIX)
+    int lowat = static_cast<int>(bytes);
+    if (setsockopt(socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, sizeof(int)) == -1)
+    {
+        PLOG(LS_WARNING) << "setsockopt(TCP_NOTSENT_LOWAT) failed";
+        return false;
+    }
+
+    return true;
+#else
+    #warning Not implemented
+    return false;
+#endif
+}
+
+} // namespace base
@@ -0,0 +1,36 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#ifndef BASE__NET__TCP_LOW_WATERMARK_H
+#define BASE__NET__TCP_LOW_WATERMARK_H
+
+#include "base/net/tcp_keep_alive.h"
+
+#include <cstddef>
+
+namespace base {
+
+// Limits the amount of data that the system holds in the send buffer of the socket without
+// sending it. The socket becomes writable only when the amount of unsent data drops below |bytes|,
+// so the data waits in the queue of the application, where it can still be replaced or dropped.
+// On Linux and macOS, TCP_NOTSENT_LOWAT is used. On Windows, the send buffer is limited to the
+// ideal send backlog of the connection (but not less than |bytes|).
+bool setTcpSendLowWatermark(NativeSocket socket, size_t bytes);
+
+} // namespace base
+
+#endif // BASE__NET__TCP_LOW_WATERMARK_H
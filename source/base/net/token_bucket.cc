@@ -0,0 +1,100 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/net/token_bucket.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+
+namespace base {
+
+TokenBucket::TokenBucket(int64_t rate, int64_t capacity)
+    : rate_(rate),
+      capacity_(capacity),
+      tokens_(capacity)
+{
+    DCHECK_GT(rate_, 0);
+    DCHECK_GT(capacity_, 0);
+}
+
+TokenBucket::~TokenBucket() = default;
+
+size_t TokenBucket::available(const TimePoint& now)
+{
+    std::scoped_lock lock(lock_);
+
+    refill(now);
+    return tokens_ > 0 ? static_cast<size_t>(tokens_) : 0;
+}
+
+void TokenBucket::consume(size_t bytes)
+{
+    std::scoped_lock lock(lock_);
+    tokens_ -= static_cast<int64_t>(bytes);
+}
+
+TokenBucket::Milliseconds TokenBucket::delay(size_t bytes, const TimePoint& now)
+{
+    std::scoped_lock lock(lock_);
+
+    refill(now);
+
+    const int64_t needed = std::min(static_cast<int64_t>(bytes), capacity_) - tokens_;
+    if (needed <= 0)
+        return Milliseconds::zero();
+
+    // Rounded up, so the tokens are surely available after the delay.
+    return Milliseconds((needed * 1000 + rate_ - 1) / rate_);
+}
+
+void TokenBucket::refill(const TimePoint& now)
+{
+    if (last_refill_time_ == TimePoint())
+    {
+        last_refill_time_ = now;
+        return;
+    }
+
+    const int64_t elapsed_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - last_refill_time_).count();
+    if (elapsed_us <= 0)
+        return;
+
+    // After a long idle the product below would overflow, so the bucket is simply filled up.
+    if (elapsed_us >= (capacity_ - tokens_) * 1000000 / rate_ + 1)
+    {
+        tokens_ = capacity_;
+        last_refill_time_ = now;
+        return;
+    }
+
+    const int64_t tokens = rate_ * elapsed_us / 1000000;
+    if (!tokens)
+    {
+        // Less than one token is accumulated. The time is not moved, so short intervals are not
+        // lost.
+        return;
+    }
+
+    tokens_ = std::min(tokens_ + tokens, capacity_);
+
+    // The time is moved only by the interval of the added tokens, so fractions are not lost.
+    last_refill_time_ += std::chrono::microseconds(tokens * 1000000 / rate_);
+}
+
+} // namespace base
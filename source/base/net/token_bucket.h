@@ -0,0 +1,72 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#ifndef BASE__NET__TOKEN_BUCKET_H
+#define BASE__NET__TOKEN_BUCKET_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace base {
+
+// Limits the rate of data transfer. The bucket is filled with |rate| tokens (bytes) per second up
+// to |capacity| (the maximum burst). The data is transferred only when the bucket has tokens for
+// it. The class is thread-safe, so one bucket can limit transfers on several threads. Between
+// available() and consume(), other threads can take the same tokens; the bucket then goes into
+// debt, which is paid off before the next tokens become available.
+class TokenBucket
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = std::chrono::time_point<Clock>;
+    using Milliseconds = std::chrono::milliseconds;
+
+    TokenBucket(int64_t rate, int64_t capacity);
+    ~TokenBucket();
+
+    int64_t rate() const { return rate_; }
+    int64_t capacity() const { return capacity_; }
+
+    // Returns the number of bytes which can be transferred now.
+    size_t available(const TimePoint& now);
+
+    // Takes tokens for |bytes| transferred bytes.
+    void consume(size_t bytes);
+
+    // Returns the time after which the bucket has tokens for |bytes| bytes (but not more than the
+    // capacity).
+    Milliseconds delay(size_t bytes, const TimePoint& now);
+
+private:
+    void refill(const TimePoint& now);
+
+    const int64_t rate_;
+    const int64_t capacity_;
+
+    std::mutex lock_;
+    int64_t tokens_;
+    TimePoint last_refill_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(TokenBucket);
+};
+
+} // namespace base
+
+#endif // BASE__NET__TOKEN_BUCKET_H
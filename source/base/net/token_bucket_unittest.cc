@@ -0,0 +1,107 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/net/token_bucket.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(TokenBucketTest, Burst)
+{
+    TokenBucket bucket(1000, 500);
+    TokenBucket::TimePoint now = TokenBucket::Clock::now();
+
+    // The bucket is full at the beginning.
+    EXPECT_EQ(bucket.available(now), 500u);
+    EXPECT_EQ(bucket.delay(500, now), TokenBucket::Milliseconds::zero());
+
+    bucket.consume(500);
+    EXPECT_EQ(bucket.available(now), 0u);
+
+    // The bucket is not filled over the capacity.
+    now += std::chrono::seconds(10);
+    EXPECT_EQ(bucket.available(now), 500u);
+}
+
+TEST(TokenBucketTest, Rate)
+{
+    TokenBucket bucket(1000, 1000);
+    TokenBucket::TimePoint now = TokenBucket::Clock::now();
+
+    bucket.available(now);
+    bucket.consume(1000);
+
+    EXPECT_EQ(bucket.delay(100, now), TokenBucket::Milliseconds(100));
+
+    // The delay is limited by the capacity.
+    EXPECT_EQ(bucket.delay(5000, now), TokenBucket::Milliseconds(1000));
+
+    now += TokenBucket::Milliseconds(250);
+    EXPECT_EQ(bucket.available(now), 250u);
+
+    // Small intervals are accumulated.
+    for (int i = 0; i < 10; ++i)
+    {
+        now += std::chrono::microseconds(500);
+        bucket.available(now);
+    }
+
+    EXPECT_EQ(bucket.available(now), 255u);
+}
+
+TEST(TokenBucketTest, Debt)
+{
+    TokenBucket bucket(1000, 100);
+    TokenBucket::TimePoint now = TokenBucket::Clock::now();
+
+    EXPECT_EQ(bucket.available(now), 100u);
+
+    // Another transfer took the same tokens.
+    bucket.consume(100);
+    bucket.consume(100);
+
+    EXPECT_EQ(bucket.available(now), 0u);
+    EXPECT_EQ(bucket.delay(100, now), TokenBucket::Milliseconds(200));
+
+    now += TokenBucket::Milliseconds(150);
+    EXPECT_EQ(bucket.available(now), 50u);
+}
+
+TEST(TokenBucketTest, LongIdle)
+{
+    // 1 GB/s.
+    TokenBucket bucket(1000 * 1000 * 1000, 1000 * 1000);
+    TokenBucket::TimePoint now = TokenBucket::Clock::now();
+
+    bucket.available(now);
+    bucket.consume(1000 * 1000);
+
+    // The number of tokens for this interval does not fit into int64.
+    now += std::chrono::hours(24 * 365);
+    EXPECT_EQ(bucket.available(now), 1000u * 1000u);
+
+    bucket.consume(1000 * 1000);
+    now += TokenBucket::Milliseconds(1);
+    EXPECT_EQ(bucket.available(now), 1000u * 1000u);
+
+    bucket.consume(500 * 1000);
+    now += std::chrono::hours(3);
+    EXPECT_EQ(bucket.available(now), 1000u * 1000u);
+}
+
+} // namespace base
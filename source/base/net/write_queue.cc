@@ -0,0 +1,166 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/write_queue.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+WriteQueue::WriteQueue() = default;
+
+WriteQueue::~WriteQueue() = default;
+
+void WriteQueue::push(WriteTask&& task)
+{
+    const size_t index = laneIndex(task);
+
+    bytes_ += task.messageSize();
+    memory_.set(bytes_);
+
+    if (!lanes_)
+        lanes_ = std::make_unique<Lanes>();
+
+    (*lanes_)[index].emplace(std::move(task));
+    ++count_;
+}
+
+void WriteQueue::pop()
+{
+    DCHECK(!empty());
+
+    std::queue<WriteTask>& lane = (*lanes_)[frontLane()];
+
+    DCHECK_GE(bytes_, lane.front().messageSize());
+    bytes_ -= lane.front().messageSize();
+    memory_.set(bytes_);
+
+    lane.pop();
+    --count_;
+}
+
+WriteTask WriteQueue::take()
+{
+    DCHECK(!empty());
+
+    std::queue<WriteTask>& lane = (*lanes_)[frontLane()];
+
+    WriteTask task = std::move(lane.front());
+    lane.pop();
+
+    DCHECK_GE(bytes_, task.messageSize());
+    bytes_ -= task.messageSize();
+    memory_.set(bytes_);
+    --count_;
+
+    return task;
+}
+
+WriteTask& WriteQueue::front()
+{
+    DCHECK(!empty());
+    return (*lanes_)[frontLane()].front();
+}
+
+const WriteTask& WriteQueue::front() const
+{
+    DCHECK(!empty());
+    return (*lanes_)[frontLane()].front();
+}
+
+void WriteQueue::setMemoryAccount(std::shared_ptr<MemoryAccount> account)
+{
+    memory_.setAccount(std::move(account));
+}
+
+void WriteQueue::releaseMemory()
+{
+    if (!count_)
+        lanes_.reset();
+}
+
+size_t WriteQueue::size(WriteTask::Priority priority) const
+{
+    if (!lanes_)
+        return 0;
+
+    return (*lanes_)[static_cast<size_t>(priority) + 1].size();
+}
+
+std::vector<WriteTask> WriteQueue::takeDiscardable()
+{
+    std::vector<WriteTask> discarded;
+    if (!lanes_)
+        return discarded;
+
+    for (auto& lane : *lanes_)
+    {
+        std::queue<WriteTask> kept;
+
+        while (!lane.empty())
+        {
+            WriteTask& task = lane.front();
+
+            if (task.isDiscardable())
+            {
+                DCHECK_GE(bytes_, task.messageSize());
+                bytes_ -= task.messageSize();
+                --count_;
+
+                discarded.emplace_back(std::move(task));
+            }
+            else
+            {
+                kept.emplace(std::move(task));
+            }
+
+            lane.pop();
+        }
+
+        lane.swap(kept);
+    }
+
+    memory_.set(bytes_);
+    return discarded;
+}
+
+// static
+size_t WriteQueue::laneIndex(const WriteTask& task)
+{
+    // Lane 0 is reserved for service data.
+    if (task.type() == WriteTask::Type::SERVICE_DATA)
+        return 0;
+
+    const size_t index = static_cast<size_t>(task.priority()) + 1;
+    DCHECK_LT(index, kLaneCount);
+    return index;
+}
+
+size_t WriteQueue::frontLane() const
+{
+    for (size_t i = 0; i < kLaneCount; ++i)
+    {
+        if (!(*lanes_)[i].empty())
+            return i;
+    }
+
+    NOTREACHED();
+    return 0;
+}
+
+} // namespace base
@@ -0,0 +1,87 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__NET__WRITE_QUEUE_H
+#define BASE__NET__WRITE_QUEUE_H
+
+#include "base/memory/memory_accounting.h"
+#include "base/net/write_task.h"
+
+#include <array>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace base {
+
+// Queue of outgoing messages divided into priority lanes. Service data is always taken first,
+// then user data in order of priority. Within one lane the order of adding is preserved.
+class WriteQueue
+{
+public:
+    WriteQueue();
+    ~WriteQueue();
+
+    void push(WriteTask&& task);
+    void pop();
+
+    // Removes the front message from the queue and returns it.
+    WriteTask take();
+
+    WriteTask& front();
+    const WriteTask& front() const;
+
+    bool empty() const { return !count_; }
+    size_t size() const { return count_; }
+
+    // Returns the total size of the queued messages in bytes (without the headroom).
+    size_t bytes() const { return bytes_; }
+
+    // Returns the number of messages with |priority|.
+    size_t size(WriteTask::Priority priority) const;
+
+    // Removes all discardable messages from the queue and returns them. The order of the rest of
+    // the messages is preserved.
+    std::vector<WriteTask> takeDiscardable();
+
+    // Sets the account of the session to which the queued messages are counted (see
+    // MemoryTag::WRITE_QUEUES).
+    void setMemoryAccount(std::shared_ptr<MemoryAccount> account);
+
+    // Frees the lanes if the queue is empty. Even empty lanes hold their blocks, so channels which
+    // stay idle for a long time release them. The lanes are allocated again by the next push().
+    void releaseMemory();
+
+private:
+    static constexpr size_t kLaneCount = 4;
+    using Lanes = std::array<std::queue<WriteTask>, kLaneCount>;
+
+    static size_t laneIndex(const WriteTask& task);
+    size_t frontLane() const;
+
+    std::unique_ptr<Lanes> lanes_;
+    size_t count_ = 0;
+    size_t bytes_ = 0;
+    TrackedMemory memory_ { MemoryTag::WRITE_QUEUES };
+
+    DISALLOW_COPY_AND_ASSIGN(WriteQueue);
+};
+
+} // namespace base
+
+#endif // BASE__NET__WRITE_QUEUE_H
@@ -0,0 +1,208 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/net/write_queue.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+WriteTask userTask(WriteTask::Priority priority, uint8_t value)
+{
+    return WriteTask(WriteTask::Type::USER_DATA, priority, ByteArray(1, value));
+}
+
+} // namespace
+
+TEST(WriteQueueTest, Fifo)
+{
+    WriteQueue queue;
+    EXPECT_TRUE(queue.empty());
+
+    for (uint8_t i = 0; i < 10; ++i)
+        queue.push(userTask(WriteTask::Priority::NORMAL, i));
+
+    EXPECT_EQ(queue.size(), 10u);
+
+    for (uint8_t i = 0; i < 10; ++i)
+    {
+        ASSERT_FALSE(queue.empty());
+        EXPECT_EQ(queue.front().data()[0], i);
+        queue.pop();
+    }
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(WriteQueueTest, Priority)
+{
+    WriteQueue queue;
+
+    queue.push(userTask(WriteTask::Priority::LOW, 1));
+    queue.push(userTask(WriteTask::Priority::NORMAL, 2));
+    queue.push(userTask(WriteTask::Priority::HIGH, 3));
+    queue.push(userTask(WriteTask::Priority::NORMAL, 4));
+    queue.push(WriteTask(WriteTask::Type::SERVICE_DATA, WriteTask::Priority::LOW, ByteArray(1, 5)));
+    queue.push(userTask(WriteTask::Priority::HIGH, 6));
+
+    EXPECT_EQ(queue.size(), 6u);
+    EXPECT_EQ(queue.size(WriteTask::Priority::HIGH), 2u);
+    EXPECT_EQ(queue.size(WriteTask::Priority::NORMAL), 2u);
+    EXPECT_EQ(queue.size(WriteTask::Priority::LOW), 1u);
+
+    const uint8_t expected[] = { 5, 3, 6, 2, 4, 1 };
+
+    for (size_t i = 0; i < std::size(expected); ++i)
+    {
+        ASSERT_FALSE(queue.empty());
+        EXPECT_EQ(queue.front().data()[0], expected[i]);
+        queue.pop();
+    }
+
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(WriteQueueTest, PushWhilePopping)
+{
+    WriteQueue queue;
+
+    queue.push(userTask(WriteTask::Priority::NORMAL, 1));
+    queue.push(userTask(WriteTask::Priority::NORMAL, 2));
+
+    EXPECT_EQ(queue.front().data()[0], 1);
+    queue.pop();
+
+    // The high priority message goes ahead of the already queued message.
+    queue.push(userTask(WriteTask::Priority::HIGH, 3));
+
+    EXPECT_EQ(queue.front().data()[0], 3);
+    queue.pop();
+    EXPECT_EQ(queue.front().data()[0], 2);
+    queue.pop();
+
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(WriteQueueTest, Bytes)
+{
+    WriteQueue queue;
+    EXPECT_EQ(queue.bytes(), 0u);
+
+    queue.push(WriteTask(WriteTask::Type::USER_DATA, WriteTask::Priority::NORMAL,
+                         ByteArray(100), 20));
+    queue.push(WriteTask(WriteTask::Type::USER_DATA, WriteTask::Priority::LOW, ByteArray(50)));
+    EXPECT_EQ(queue.bytes(), 130u);
+
+    WriteTask task = queue.take();
+    EXPECT_EQ(task.messageSize(), 80u);
+    EXPECT_EQ(queue.bytes(), 50u);
+    EXPECT_EQ(queue.size(), 1u);
+
+    queue.pop();
+    EXPECT_EQ(queue.bytes(), 0u);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(WriteQueueTest, TakeDiscardable)
+{
+    WriteQueue queue;
+
+    for (uint8_t i = 0; i < 6; ++i)
+    {
+        const WriteTask::Priority priority =
+            i < 3 ? WriteTask::Priority::NORMAL : WriteTask::Priority::HIGH;
+
+        WriteTask task = userTask(priority, i);
+        task.setDiscardable(i % 2 == 0);
+        queue.push(std::move(task));
+    }
+
+    EXPECT_EQ(queue.bytes(), 6u);
+
+    std::vector<WriteTask> discarded = queue.takeDiscardable();
+    ASSERT_EQ(discarded.size(), 3u);
+    EXPECT_EQ(queue.size(), 3u);
+    EXPECT_EQ(queue.bytes(), 3u);
+
+    for (const auto& task : discarded)
+        EXPECT_EQ(task.data()[0] % 2, 0);
+
+    const uint8_t expected[] = { 3, 5, 1 };
+
+    for (size_t i = 0; i < std::size(expected); ++i)
+    {
+        ASSERT_FALSE(queue.empty());
+        EXPECT_EQ(queue.front().data()[0], expected[i]);
+        queue.pop();
+    }
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_TRUE(queue.takeDiscardable().empty());
+}
+
+TEST(WriteQueueTest, SharedAndSmallMessages)
+{
+    WriteQueue queue;
+
+    SharedByteArray shared(ByteArray(100, 1));
+    const uint8_t small_data[] = { 2, 2, 2 };
+
+    queue.push(WriteTask(WriteTask::Type::USER_DATA, WriteTask::Priority::NORMAL,
+                         SharedByteArray(shared)));
+    queue.push(WriteTask(WriteTask::Type::USER_DATA, WriteTask::Priority::NORMAL,
+                         SmallByteArray(small_data, sizeof(small_data))));
+    EXPECT_EQ(queue.bytes(), 103u);
+    EXPECT_EQ(shared.useCount(), 2);
+
+    WriteTask task = queue.take();
+    EXPECT_EQ(task.messageSize(), 100u);
+    EXPECT_EQ(task.message(), shared.data());
+    EXPECT_TRUE(task.data().empty());
+
+    task = queue.take();
+    EXPECT_EQ(task.messageSize(), 3u);
+    EXPECT_EQ(task.message()[0], 2);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(WriteQueueTest, ReleaseMemory)
+{
+    WriteQueue queue;
+    queue.releaseMemory();
+    EXPECT_EQ(queue.size(WriteTask::Priority::NORMAL), 0u);
+
+    queue.push(userTask(WriteTask::Priority::NORMAL, 1));
+
+    // The lanes are kept while the queue has messages.
+    queue.releaseMemory();
+    ASSERT_EQ(queue.size(), 1u);
+    EXPECT_EQ(queue.front().data()[0], 1);
+
+    queue.pop();
+    queue.releaseMemory();
+    EXPECT_TRUE(queue.empty());
+
+    queue.push(userTask(WriteTask::Priority::HIGH, 2));
+    EXPECT_EQ(queue.size(WriteTask::Priority::HIGH), 1u);
+    EXPECT_EQ(queue.take().data()[0], 2);
+}
+
+} // namespace base
@@ -19,7 +19,13 @@
 #ifndef BASE__NET__WRITE_TASK_H
 #define BASE__NET__WRITE_TASK_H
 
+#include "base/logging.h"
+#include "base/macros_magic.h"
 #include "base/memory/byte_array.h"
+#include "base/memory/shared_byte_array.h"
+#include "base/memory/small_byte_array.h"
+
+#include <chrono>
 
 namespace base {
 
@@ -28,19 +34,105 @@ class WriteTask
 public:
     enum class Type { SERVICE_DATA, USER_DATA };
 
-    WriteTask(Type type, ByteArray&& data)
+    // Messages with a higher priority are sent before messages with a lower priority. The order of
+    // messages within the same priority is preserved.
+    enum class Priority
+    {
+        HIGH,   // Small latency-sensitive messages (for example, input events or cursor shapes).
+        NORMAL, // Default priority.
+        LOW     // Bulk data which can wait.
+    };
+
+    // |headroom| is the number of unused bytes at the beginning of |data| in front of the message.
+    // If the headroom is large enough, the message is framed and encrypted in place.
+    WriteTask(Type type, Priority priority, ByteArray&& data, size_t headroom = 0)
+        : type_(type),
+          priority_(priority),
+          data_(std::move(data)),
+          headroom_(headroom),
+          time_(std::chrono::steady_clock::now())
+    {
+        DCHECK_LE(headroom_, data_.size());
+    }
+
+    // The shared buffer is not copied and is not modified, so the message is framed and encrypted
+    // into the write buffer of the channel.
+    WriteTask(Type type, Priority priority, SharedByteArray&& data)
+        : type_(type),
+          priority_(priority),
+          shared_data_(std::move(data)),
+          time_(std::chrono::steady_clock::now())
+    {
+        // Nothing
+    }
+
+    // A tiny message is stored inside the task (see SmallByteArray).
+    WriteTask(Type type, Priority priority, const SmallByteArray& data)
         : type_(type),
-          data_(std::move(data))
+          priority_(priority),
+          small_data_(data),
+          is_small_(true),
+          time_(std::chrono::steady_clock::now())
     {
         // Nothing
     }
 
+    WriteTask(WriteTask&& other) = default;
+    WriteTask& operator=(WriteTask&& other) = default;
+
     Type type() const { return type_; }
+    Priority priority() const { return priority_; }
+    // Owned buffer of the message. It is empty if the message is in a shared or a small buffer.
     const ByteArray& data() const { return data_; }
+    ByteArray& data() { return data_; }
+    size_t headroom() const { return headroom_; }
+
+    // The message without the headroom, wherever it is stored.
+    const uint8_t* message() const
+    {
+        if (is_small_)
+            return small_data_.data();
+        if (!shared_data_.empty())
+            return shared_data_.data();
+        return data_.data() + headroom_;
+    }
+
+    // Size of the message without the headroom.
+    size_t messageSize() const
+    {
+        if (is_small_)
+            return small_data_.size();
+        if (!shared_data_.empty())
+            return shared_data_.size();
+        return data_.size() - headroom_;
+    }
+
+    // Time when the task was created (the message was added to the queue).
+    std::chrono::steady_clock::time_point time() const { return time_; }
+
+    // A discardable message can be removed from the queue before it is sent if it becomes stale
+    // (see WriteQueue::takeDiscardable).
+    bool isDiscardable() const { return discardable_; }
+    void setDiscardable(bool discardable) { discardable_ = discardable; }
+
+    // Number of the stream which sent the message (see NetworkChannel::openStream). Zero for the
+    // messages of the channel itself.
+    uint16_t stream() const { return stream_; }
+    void setStream(uint16_t stream) { stream_ = stream; }
 
 private:
-    const Type type_;
-    const ByteArray data_;
+    Type type_;
+    Priority priority_;
+    ByteArray data_;
+    size_t headroom_ = 0;
+    SharedByteArray shared_data_;
+    SmallByteArray small_data_;
+    bool is_small_ = false;
+    std::chrono::steady_clock::time_point time_;
+    bool discardable_ = false;
+    uint16_t stream_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(WriteTask);
 };
 
 } // namespace base
@@ -0,0 +1,115 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/peer/authentication_limiter.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// Rate at which the authentications are assumed to be served if the accept rate is not limited.
+const int64_t kDefaultServeRate = 100;
+
+const std::chrono::milliseconds kMinRetryDelay { 1000 };
+const std::chrono::milliseconds kMaxRetryDelay { 5 * 60 * 1000 };
+
+// Increments |counter| if it is less than |limit| (or if |limit| is zero).
+bool tryIncrement(std::atomic<size_t>* counter, uint32_t limit)
+{
+    size_t current = counter->load();
+
+    do
+    {
+        if (limit && current >= limit)
+            return false;
+    }
+    while (!counter->compare_exchange_weak(current, current + 1));
+
+    return true;
+}
+
+} // namespace
+
+AuthenticationLimiter::AuthenticationLimiter(const Limits& limits)
+    : limits_(limits)
+{
+    // The bucket allows a burst of the connections of one second.
+    if (limits_.accept_rate)
+        accept_bucket_ = std::make_unique<TokenBucket>(limits_.accept_rate, limits_.accept_rate);
+}
+
+AuthenticationLimiter::~AuthenticationLimiter() = default;
+
+bool AuthenticationLimiter::admit()
+{
+    if (accept_bucket_)
+    {
+        if (!accept_bucket_->available(TokenBucket::Clock::now()))
+        {
+            ++rejected_count_;
+            return false;
+        }
+
+        accept_bucket_->consume(1);
+    }
+
+    if (!tryIncrement(&pending_count_, limits_.max_pending))
+    {
+        ++rejected_count_;
+        return false;
+    }
+
+    return true;
+}
+
+void AuthenticationLimiter::finish()
+{
+    DCHECK(pending_count_ > 0);
+    --pending_count_;
+}
+
+bool AuthenticationLimiter::admitAnonymous()
+{
+    if (!tryIncrement(&anonymous_pending_count_, limits_.max_anonymous_pending))
+    {
+        ++rejected_count_;
+        return false;
+    }
+
+    return true;
+}
+
+void AuthenticationLimiter::finishAnonymous()
+{
+    DCHECK(anonymous_pending_count_ > 0);
+    --anonymous_pending_count_;
+}
+
+std::chrono::milliseconds AuthenticationLimiter::retryDelay() const
+{
+    const int64_t rate = limits_.accept_rate ? limits_.accept_rate : kDefaultServeRate;
+    const std::chrono::milliseconds delay(static_cast<int64_t>(pending_count_) * 1000 / rate);
+
+    return std::clamp(delay, kMinRetryDelay, kMaxRetryDelay);
+}
+
+} // namespace base
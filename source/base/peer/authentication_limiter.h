@@ -0,0 +1,81 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__PEER__AUTHENTICATION_LIMITER_H
+#define BASE__PEER__AUTHENTICATION_LIMITER_H
+
+#include "base/macros_magic.h"
+#include "base/net/token_bucket.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace base {
+
+// Admission control for the authentications of a server. New connections are admitted at most at
+// |accept_rate| connections per second and while less than |max_pending| authentications are in
+// progress. Anonymous peers (for example, hosts which register on a router) are admitted while
+// less than |max_anonymous_pending| of them are authenticated, so users are still served when many
+// anonymous peers reconnect at once. A limit of zero is not enforced. One limiter can be shared by
+// the authenticator managers of several threads. The class is thread-safe.
+class AuthenticationLimiter
+{
+public:
+    struct Limits
+    {
+        uint32_t accept_rate = 0;
+        uint32_t max_pending = 0;
+        uint32_t max_anonymous_pending = 0;
+    };
+
+    explicit AuthenticationLimiter(const Limits& limits);
+    ~AuthenticationLimiter();
+
+    // Called when a connection is accepted. If true is returned, finish() must be called when the
+    // authentication is finished. Otherwise the connection is closed.
+    bool admit();
+    void finish();
+
+    // Called when the peer of an admitted authentication is identified as anonymous. If true is
+    // returned, finishAnonymous() must be called when the authentication is finished. Otherwise the
+    // peer is asked to retry after retryDelay().
+    bool admitAnonymous();
+    void finishAnonymous();
+
+    // Time after which a rejected peer should connect again. It is the time to serve the current
+    // authentications at the accept rate.
+    std::chrono::milliseconds retryDelay() const;
+
+    size_t pendingCount() const { return pending_count_; }
+    uint64_t rejectedCount() const { return rejected_count_; }
+
+private:
+    const Limits limits_;
+    std::unique_ptr<TokenBucket> accept_bucket_;
+
+    std::atomic<size_t> pending_count_ = 0;
+    std::atomic<size_t> anonymous_pending_count_ = 0;
+    std::atomic<uint64_t> rejected_count_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(AuthenticationLimiter);
+};
+
+} // namespace base
+
+#endif // BASE__PEER__AUTHENTICATION_LIMITER_H
@@ -0,0 +1,98 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/peer/authentication_limiter.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(AuthenticationLimiterTest, NoLimits)
+{
+    AuthenticationLimiter limiter(AuthenticationLimiter::Limits{});
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_TRUE(limiter.admit());
+        EXPECT_TRUE(limiter.admitAnonymous());
+    }
+
+    EXPECT_EQ(limiter.pendingCount(), 1000U);
+    EXPECT_EQ(limiter.rejectedCount(), 0U);
+}
+
+TEST(AuthenticationLimiterTest, MaxPending)
+{
+    AuthenticationLimiter::Limits limits;
+    limits.max_pending = 3;
+    limits.max_anonymous_pending = 1;
+
+    AuthenticationLimiter limiter(limits);
+
+    EXPECT_TRUE(limiter.admit());
+    EXPECT_TRUE(limiter.admit());
+    EXPECT_TRUE(limiter.admit());
+    EXPECT_FALSE(limiter.admit());
+
+    // Only one of the admitted peers may be anonymous.
+    EXPECT_TRUE(limiter.admitAnonymous());
+    EXPECT_FALSE(limiter.admitAnonymous());
+    EXPECT_EQ(limiter.rejectedCount(), 2U);
+
+    limiter.finishAnonymous();
+    EXPECT_TRUE(limiter.admitAnonymous());
+
+    limiter.finish();
+    EXPECT_EQ(limiter.pendingCount(), 2U);
+    EXPECT_TRUE(limiter.admit());
+}
+
+TEST(AuthenticationLimiterTest, AcceptRate)
+{
+    AuthenticationLimiter::Limits limits;
+    limits.accept_rate = 10;
+
+    AuthenticationLimiter limiter(limits);
+
+    // A burst of one second is admitted.
+    int admitted = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (limiter.admit())
+            ++admitted;
+    }
+
+    EXPECT_GE(admitted, 10);
+    EXPECT_LE(admitted, 11);
+}
+
+TEST(AuthenticationLimiterTest, RetryDelay)
+{
+    AuthenticationLimiter limiter(AuthenticationLimiter::Limits{});
+
+    // Not less than one second.
+    EXPECT_EQ(limiter.retryDelay(), std::chrono::milliseconds(1000));
+
+    for (int i = 0; i < 500; ++i)
+        limiter.admit();
+
+    // Without an accept rate, 100 authentications per second are assumed.
+    EXPECT_EQ(limiter.retryDelay(), std::chrono::milliseconds(5000));
+}
+
+} // namespace base
@@ -32,7 +32,8 @@ constexpr std::chrono::minutes kTimeout{ 1 };
 } // namespace
 
 Authenticator::Authenticator(std::shared_ptr<TaskRunner> task_runner)
-    : timer_(WaitableTimer::Type::SINGLE_SHOT, std::move(task_runner))
+    : timer_(WaitableTimer::Type::SINGLE_SHOT, std::move(task_runner),
+             WaitableTimer::Precision::COARSE)
 {
     // Nothing
 }
@@ -52,6 +53,7 @@ void Authenticator::start(std::unique_ptr<NetworkChannel> channel, Callback call
     DCHECK(callback_);
 
     state_ = State::PENDING;
+    start_time_ = std::chrono::steady_clock::now();
 
     LOG(LS_INFO) << "Authentication started for: " << channel_->peerAddress();
 
@@ -136,6 +138,9 @@ void Authenticator::finish(const Location& location, ErrorCode error_code)
     channel_->setListener(nullptr);
     timer_.stop();
 
+    duration_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time_);
+
     if (error_code == ErrorCode::SUCCESS)
         state_ = State::SUCCESS;
     else
@@ -67,6 +67,9 @@ public:
     // Returns the current state.
     [[nodiscard]] State state() const { return state_; }
 
+    // Returns the time from start() to the completion of the authentication.
+    [[nodiscard]] std::chrono::milliseconds duration() const { return duration_; }
+
     // Releases network channel.
     [[nodiscard]] std::unique_ptr<NetworkChannel> takeChannel();
 
@@ -106,6 +109,8 @@ private:
     std::unique_ptr<NetworkChannel> channel_;
     Callback callback_;
     State state_ = State::STOPPED;
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::milliseconds duration_ { 0 };
     Version peer_version_; // Remote peer version.
     std::string peer_os_name_;
     std::string peer_computer_name_;
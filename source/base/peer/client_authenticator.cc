@@ -22,6 +22,7 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/sys_info.h"
+#include "base/crypto/cipher_benchmark.h"
 #include "base/crypto/generic_hash.h"
 #include "base/crypto/key_pair.h"
 #include "base/crypto/random.h"
@@ -104,6 +105,11 @@ void ClientAuthenticator::setSessionType(uint32_t session_type)
     session_type_ = session_type;
 }
 
+void ClientAuthenticator::setSessionTicket(const SessionTicket& session_ticket)
+{
+    session_ticket_ = session_ticket;
+}
+
 bool ClientAuthenticator::onStarted()
 {
     internal_state_ = InternalState::SEND_CLIENT_HELLO;
@@ -119,7 +125,7 @@ void ClientAuthenticator::onReceived(const ByteArray& buffer)
         {
             if (readServerHello(buffer))
             {
-                if (identify_ == proto::IDENTIFY_ANONYMOUS)
+                if (identify_ == proto::IDENTIFY_ANONYMOUS || session_resumed_)
                 {
                     internal_state_ = InternalState::READ_SESSION_CHALLENGE;
                 }
@@ -213,14 +219,22 @@ void ClientAuthenticator::sendClientHello()
 
     std::unique_ptr<proto::ClientHello> client_hello = std::make_unique<proto::ClientHello>();
 
+    const CipherBenchmark::Result& speed = CipherBenchmark::current();
     uint32_t encryption = proto::ENCRYPTION_CHACHA20_POLY1305;
 
+    bool has_fast_aes = speed.aes256_gcm > speed.chacha20_poly1305;
 #if defined(ARCH_CPU_X86_FAMILY)
-    if (CpuidUtil::hasAesNi())
-        encryption |= proto::ENCRYPTION_AES256_GCM;
+    has_fast_aes = has_fast_aes || CpuidUtil::hasAesNi();
 #endif
 
+    // AES256 GCM is offered only if it has hardware support. The server chooses the method
+    // according to the speeds of both sides.
+    if (has_fast_aes)
+        encryption |= proto::ENCRYPTION_AES256_GCM;
+
     client_hello->set_encryption(encryption);
+    client_hello->set_chacha20_poly1305_speed(speed.chacha20_poly1305);
+    client_hello->set_aes256_gcm_speed(speed.aes256_gcm);
     client_hello->set_identify(identify_);
 
     if (!peer_public_key_.empty())
@@ -264,6 +278,23 @@ void ClientAuthenticator::sendClientHello()
         client_hello->set_iv(toStdString(encrypt_iv_));
     }
 
+    if (identify_ == proto::IDENTIFY_SRP && session_ticket_.isValid())
+    {
+        // IV is required to calculate the key of the resumed session.
+        if (encrypt_iv_.empty())
+        {
+            encrypt_iv_ = Random::byteArray(kIvSize);
+            if (encrypt_iv_.empty())
+            {
+                finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
+                return;
+            }
+        }
+
+        client_hello->set_session_ticket(toStdString(session_ticket_.ticket));
+        client_hello->set_iv(toStdString(encrypt_iv_));
+    }
+
     LOG(LS_INFO) << "Sending: ClientHello";
     sendMessage(*client_hello);
 }
@@ -279,6 +310,15 @@ bool ClientAuthenticator::readServerHello(const ByteArray& buffer)
         return false;
     }
 
+    if (server_hello->retry_after_ms())
+    {
+        retry_after_ = std::chrono::milliseconds(server_hello->retry_after_ms());
+        LOG(LS_INFO) << "Server is overloaded. Retry after " << retry_after_.count() << " ms";
+
+        finish(FROM_HERE, ErrorCode::SESSION_DENIED);
+        return false;
+    }
+
     LOG(LS_INFO) << "Encryption: " << server_hello->encryption();
 
     encryption_ = server_hello->encryption();
@@ -295,6 +335,21 @@ bool ClientAuthenticator::readServerHello(const ByteArray& buffer)
 
     decrypt_iv_ = fromStdString(server_hello->iv());
 
+    if (server_hello->session_resumed())
+    {
+        if (identify_ != proto::IDENTIFY_SRP || !session_ticket_.isValid() || decrypt_iv_.empty())
+        {
+            finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
+            return false;
+        }
+
+        LOG(LS_INFO) << "Session is resumed";
+
+        session_key_ = SessionTicket::createSessionKey(
+            session_key_, session_ticket_.secret, encrypt_iv_, decrypt_iv_);
+        session_resumed_ = true;
+    }
+
     if (session_key_.empty() != decrypt_iv_.empty())
     {
         finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
@@ -411,6 +466,19 @@ bool ClientAuthenticator::readSessionChallenge(const ByteArray& buffer)
         return false;
     }
 
+    if (identify_ == proto::IDENTIFY_SRP)
+    {
+        // The previous ticket is replaced with a new one. If the server does not issue tickets,
+        // the previous ticket is no longer needed either.
+        session_ticket_ = SessionTicket();
+
+        if (!challenge->session_ticket().empty())
+        {
+            session_ticket_.ticket = fromStdString(challenge->session_ticket());
+            session_ticket_.secret = SessionTicket::createSecret(session_key_);
+        }
+    }
+
     setPeerVersion(challenge->version());
     setPeerOsName(challenge->os_name());
     setPeerComputerName(challenge->computer_name());
@@ -21,6 +21,9 @@
 
 #include "base/crypto/big_num.h"
 #include "base/peer/authenticator.h"
+#include "base/peer/session_ticket.h"
+
+#include <chrono>
 
 namespace base {
 
@@ -36,6 +39,22 @@ public:
     void setPassword(std::u16string_view password);
     void setSessionType(uint32_t session_type);
 
+    // Sets the ticket received in the previous session with the same server and user. If the
+    // server accepts the ticket, the session is resumed without the SRP exchange. Otherwise the
+    // user name and the password are used.
+    void setSessionTicket(const SessionTicket& session_ticket);
+
+    // Returns the ticket received from the server after successful authentication. The ticket is
+    // invalid if the server does not issue tickets.
+    const SessionTicket& sessionTicket() const { return session_ticket_; }
+
+    // Returns true if the session is resumed by a ticket.
+    bool isSessionResumed() const { return session_resumed_; }
+
+    // Delay after which the server asked to connect again if it rejected the connection because
+    // it is overloaded. Zero if there was no such request.
+    std::chrono::milliseconds retryAfter() const { return retry_after_; }
+
 protected:
     // Authenticator implementation.
     bool onStarted() override;
@@ -68,6 +87,10 @@ private:
     std::u16string username_;
     std::u16string password_;
 
+    SessionTicket session_ticket_;
+    bool session_resumed_ = false;
+    std::chrono::milliseconds retry_after_ { 0 };
+
     BigNum N_;
     BigNum g_;
     BigNum s_;
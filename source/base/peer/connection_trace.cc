@@ -0,0 +1,81 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/peer/connection_trace.h"
+
+#include "base/logging.h"
+#include "base/crypto/random.h"
+
+#include <iomanip>
+
+namespace base {
+
+ConnectionTrace::ConnectionTrace()
+    : ConnectionTrace(createId())
+{
+    // Nothing
+}
+
+ConnectionTrace::ConnectionTrace(Id id)
+    : id_(id),
+      start_time_(std::chrono::steady_clock::now()),
+      last_stage_time_(start_time_)
+{
+    // Nothing
+}
+
+// static
+ConnectionTrace::Id ConnectionTrace::createId()
+{
+    Id id;
+
+    do
+    {
+        id = Random::number64();
+    }
+    while (id == kInvalidId);
+
+    return id;
+}
+
+void ConnectionTrace::addStage(std::string_view stage)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const milliseconds wall_time =
+        duration_cast<milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+
+    LOG(LS_INFO) << "[Trace " << std::hex << std::setw(16) << std::setfill('0') << id_
+                 << std::dec << "] " << stage
+                 << " (time: " << wall_time.count()
+                 << ", stage: " << duration_cast<milliseconds>(now - last_stage_time_).count()
+                 << " ms, total: " << duration_cast<milliseconds>(now - start_time_).count()
+                 << " ms)";
+
+    last_stage_time_ = now;
+}
+
+std::chrono::milliseconds ConnectionTrace::elapsed() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time_);
+}
+
+} // namespace base
@@ -0,0 +1,70 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__PEER__CONNECTION_TRACE_H
+#define BASE__PEER__CONNECTION_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace base {
+
+// Logs the stages of establishing a connection between a client and a host through the router
+// and a relay. The client creates the trace ID and sends it in ConnectionRequest, the router
+// passes it in ConnectionOffer to both peers and the peers pass it to the relay in PeerToRelay. The
+// log records of all participants can be matched by the ID.
+class ConnectionTrace
+{
+public:
+    using Id = uint64_t;
+
+    static const Id kInvalidId = 0;
+
+    // Creates a trace with a new ID.
+    ConnectionTrace();
+
+    // Continues the trace with |id| received from another participant. The ID can be invalid if
+    // the participant does not support tracing.
+    explicit ConnectionTrace(Id id);
+    ~ConnectionTrace() = default;
+
+    ConnectionTrace(const ConnectionTrace& other) = default;
+    ConnectionTrace& operator=(const ConnectionTrace& other) = default;
+
+    // Creates a random trace ID.
+    static Id createId();
+
+    Id id() const { return id_; }
+
+    // Logs the stage with the wall clock time (to compare records of different computers), the
+    // time since the previous stage and the time since the start of the trace on this computer.
+    void addStage(std::string_view stage);
+
+    // Time since the start of the trace on this computer.
+    std::chrono::milliseconds elapsed() const;
+
+private:
+    Id id_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::steady_clock::time_point last_stage_time_;
+};
+
+} // namespace base
+
+#endif // BASE__PEER__CONNECTION_TRACE_H
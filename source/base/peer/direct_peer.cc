@@ -0,0 +1,173 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/peer/direct_peer.h"
+
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
+#include "base/net/network_channel.h"
+#include "base/strings/unicode.h"
+#include "proto/router_peer.pb.h"
+
+namespace base {
+
+namespace {
+
+// A direct connection inside a network is established in milliseconds and through the NAT of the
+// host in a round trip. If it takes longer, the host is most likely unreachable.
+const std::chrono::seconds kConnectTimeout { 3 };
+
+// A malformed offer must not make the client open many connections.
+const int kMaxCandidates = 8;
+
+} // namespace
+
+DirectPeer::DirectPeer()
+    : io_context_(MessageLoop::current()->pumpAsio()->ioContext()),
+      timer_(io_context_)
+{
+    // Nothing
+}
+
+DirectPeer::~DirectPeer()
+{
+    delegate_ = nullptr;
+    timer_.cancel();
+
+    std::error_code ignored_code;
+    for (const auto& socket : sockets_)
+    {
+        if (!socket)
+            continue;
+
+        socket->cancel(ignored_code);
+        socket->close(ignored_code);
+    }
+}
+
+void DirectPeer::start(const proto::ConnectionOffer& offer, Delegate* delegate)
+{
+    delegate_ = delegate;
+    DCHECK(delegate_);
+
+    trace_ = ConnectionTrace(offer.trace_id());
+
+    for (int i = 0; i < std::min(offer.candidate_size(), kMaxCandidates); ++i)
+    {
+        const proto::PeerCandidate& candidate = offer.candidate(i);
+
+        std::error_code error_code;
+        asio::ip::address address = asio::ip::make_address(candidate.address(), error_code);
+        if (error_code || !candidate.port() || candidate.port() > 65535)
+        {
+            LOG(LS_WARNING) << "Invalid candidate: " << candidate.address() << ":"
+                            << candidate.port();
+            continue;
+        }
+
+        LOG(LS_INFO) << "Connecting to candidate " << candidate.address() << ":"
+                     << candidate.port() << " (type: " << candidate.type() << ")";
+
+        const size_t index = sockets_.size();
+        sockets_.emplace_back(std::make_unique<asio::ip::tcp::socket>(io_context_));
+        ++pending_;
+
+        sockets_.back()->async_connect(
+            asio::ip::tcp::endpoint(address, static_cast<uint16_t>(candidate.port())),
+            [this, index](const std::error_code& error_code)
+        {
+            if (error_code == asio::error::operation_aborted)
+                return;
+
+            onConnected(index, error_code);
+        });
+    }
+
+    if (!pending_)
+    {
+        onFinished(nullptr);
+        return;
+    }
+
+    timer_.expires_after(kConnectTimeout);
+    timer_.async_wait([this](const std::error_code& error_code)
+    {
+        if (error_code == asio::error::operation_aborted)
+            return;
+
+        LOG(LS_INFO) << "Direct connection timeout";
+        onFinished(nullptr);
+    });
+}
+
+void DirectPeer::onConnected(size_t index, const std::error_code& error_code)
+{
+    DCHECK_LT(index, sockets_.size());
+    DCHECK_GT(pending_, 0U);
+    --pending_;
+
+    if (is_finished_)
+        return;
+
+    if (error_code)
+    {
+        LOG(LS_INFO) << "Candidate " << index << " failed: "
+                     << utf16FromLocal8Bit(error_code.message());
+
+        std::error_code ignored_code;
+        sockets_[index]->close(ignored_code);
+
+        // Without candidates there is nothing to wait for.
+        if (!pending_)
+            onFinished(nullptr);
+        return;
+    }
+
+    LOG(LS_INFO) << "Connected directly to candidate " << index;
+    trace_.addStage("Connected to host directly");
+
+    std::unique_ptr<asio::ip::tcp::socket> socket = std::move(sockets_[index]);
+    onFinished(std::unique_ptr<NetworkChannel>(
+        new NetworkChannel(std::move(*socket), NetworkChannel::Role::CLIENT)));
+}
+
+void DirectPeer::onFinished(std::unique_ptr<NetworkChannel> channel)
+{
+    is_finished_ = true;
+
+    // The rest of the connections are no longer needed.
+    timer_.cancel();
+
+    std::error_code ignored_code;
+    for (const auto& socket : sockets_)
+    {
+        if (socket)
+            socket->close(ignored_code);
+    }
+
+    if (!delegate_)
+        return;
+
+    if (channel)
+        delegate_->onDirectConnectionReady(std::move(channel));
+    else
+        delegate_->onDirectConnectionError();
+}
+
+} // namespace base
@@ -0,0 +1,79 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__PEER__DIRECT_PEER_H
+#define BASE__PEER__DIRECT_PEER_H
+
+#include "base/macros_magic.h"
+#include "base/peer/connection_trace.h"
+
+#include <asio/high_resolution_timer.hpp>
+#include <asio/ip/tcp.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace proto {
+class ConnectionOffer;
+} // namespace proto
+
+namespace base {
+
+class NetworkChannel;
+
+// Tries to connect to the host directly at the candidate addresses from the connection offer. The
+// connections to all candidates are started at the same time and the first established one is
+// used. If no connection is established within the timeout, the relay from the offer is used.
+class DirectPeer
+{
+public:
+    DirectPeer();
+    ~DirectPeer();
+
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        virtual void onDirectConnectionReady(std::unique_ptr<NetworkChannel> channel) = 0;
+        virtual void onDirectConnectionError() = 0;
+    };
+
+    void start(const proto::ConnectionOffer& offer, Delegate* delegate);
+    bool isFinished() const { return is_finished_; }
+
+private:
+    void onConnected(size_t index, const std::error_code& error_code);
+    void onFinished(std::unique_ptr<NetworkChannel> channel);
+
+    Delegate* delegate_ = nullptr;
+    bool is_finished_ = false;
+
+    ConnectionTrace trace_ { ConnectionTrace::kInvalidId };
+
+    asio::io_context& io_context_;
+    std::vector<std::unique_ptr<asio::ip::tcp::socket>> sockets_;
+    size_t pending_ = 0;
+    asio::high_resolution_timer timer_;
+
+    DISALLOW_COPY_AND_ASSIGN(DirectPeer);
+};
+
+} // namespace base
+
+#endif // BASE__PEER__DIRECT_PEER_H
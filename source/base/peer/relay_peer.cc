@@ -29,14 +29,16 @@
 #include "base/net/network_channel.h"
 #include "base/strings/unicode.h"
 #include "proto/relay_peer.pb.h"
+#include "proto/router_peer.pb.h"
 
 #include <asio/connect.hpp>
 #include <asio/write.hpp>
 
 namespace base {
 
-RelayPeer::RelayPeer()
-    : io_context_(MessageLoop::current()->pumpAsio()->ioContext()),
+RelayPeer::RelayPeer(NetworkChannel::Role role)
+    : role_(role),
+      io_context_(MessageLoop::current()->pumpAsio()->ioContext()),
       socket_(io_context_),
       resolver_(io_context_)
 {
@@ -52,12 +54,15 @@ RelayPeer::~RelayPeer()
     socket_.close(ignored_code);
 }
 
-void RelayPeer::start(const proto::RelayCredentials& credentials, Delegate* delegate)
+void RelayPeer::start(const proto::ConnectionOffer& offer, Delegate* delegate)
 {
     delegate_ = delegate;
     DCHECK(delegate_);
 
-    message_ = authenticationMessage(credentials.key(), credentials.secret());
+    const proto::RelayCredentials& credentials = offer.relay();
+
+    trace_ = ConnectionTrace(offer.trace_id());
+    message_ = authenticationMessage(credentials.key(), credentials.secret(), trace_.id());
 
     LOG(LS_INFO) << "Start resolving for " << credentials.host() << ":" << credentials.port();
 
@@ -87,6 +92,7 @@ void RelayPeer::start(const proto::RelayCredentials& credentials, Delegate* dele
             }
 
             LOG(LS_INFO) << "Connected";
+            trace_.addStage("Connected to relay");
             onConnected();
         });
     });
@@ -134,11 +140,13 @@ void RelayPeer::onConnected()
                 return;
             }
 
+            trace_.addStage("Authentication data sent to relay");
+
             is_finished_ = true;
             if (delegate_)
             {
                 delegate_->onRelayConnectionReady(
-                    std::unique_ptr<NetworkChannel>(new NetworkChannel(std::move(socket_))));
+                    std::unique_ptr<NetworkChannel>(new NetworkChannel(std::move(socket_), role_)));
             }
         });
     });
@@ -156,7 +164,8 @@ void RelayPeer::onErrorOccurred(const Location& location, const std::error_code&
 }
 
 // static
-ByteArray RelayPeer::authenticationMessage(const proto::RelayKey& key, const std::string& secret)
+ByteArray RelayPeer::authenticationMessage(const proto::RelayKey& key, const std::string& secret,
+                                           ConnectionTrace::Id trace_id)
 {
     if (key.type() != proto::RelayKey::TYPE_X25519)
     {
@@ -219,6 +228,7 @@ ByteArray RelayPeer::authenticationMessage(const proto::RelayKey& key, const std
     message.set_key_id(key.key_id());
     message.set_public_key(base::toStdString(key_pair.publicKey()));
     message.set_data(std::move(encrypted_secret));
+    message.set_trace_id(trace_id);
 
     return serialize(message);
 }
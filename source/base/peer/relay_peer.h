@@ -21,19 +21,26 @@
 
 #include "base/macros_magic.h"
 #include "base/memory/byte_array.h"
+#include "base/net/network_channel.h"
+#include "base/peer/connection_trace.h"
 #include "proto/router_common.pb.h"
 
 #include <asio/ip/tcp.hpp>
 
+namespace proto {
+class ConnectionOffer;
+} // namespace proto
+
 namespace base {
 
-class NetworkChannel;
 class Location;
 
 class RelayPeer
 {
 public:
-    RelayPeer();
+    // |role| is the role of this end of the connection in the session (the relay only forwards
+    // the data between the peers).
+    explicit RelayPeer(NetworkChannel::Role role);
     ~RelayPeer();
 
     class Delegate
@@ -45,18 +52,25 @@ public:
         virtual void onRelayConnectionError() = 0;
     };
 
-    void start(const proto::RelayCredentials& credentials, Delegate* delegate);
+    void start(const proto::ConnectionOffer& offer, Delegate* delegate);
     bool isFinished() const { return is_finished_; }
 
+    // Creates the message which a peer sends to the relay after connecting. Returns an empty
+    // array on failure.
+    static ByteArray authenticationMessage(const proto::RelayKey& key, const std::string& secret,
+                                           ConnectionTrace::Id trace_id);
+
 private:
     void onConnected();
     void onErrorOccurred(const Location& location, const std::error_code& error_code);
 
-    static ByteArray authenticationMessage(const proto::RelayKey& key, const std::string& secret);
+    const NetworkChannel::Role role_;
 
     Delegate* delegate_ = nullptr;
     bool is_finished_ = false;
 
+    ConnectionTrace trace_ { ConnectionTrace::kInvalidId };
+
     uint32_t message_size_ = 0;
     ByteArray message_;
 
@@ -36,10 +36,11 @@ RelayPeerManager::~RelayPeerManager()
     delegate_ = nullptr;
 }
 
-void RelayPeerManager::addConnectionOffer(const proto::RelayCredentials& credentials)
+void RelayPeerManager::addConnectionOffer(const proto::ConnectionOffer& offer)
 {
-    pending_.emplace_back(std::make_unique<RelayPeer>());
-    pending_.back()->start(credentials, this);
+    // The host is the server of the sessions.
+    pending_.emplace_back(std::make_unique<RelayPeer>(NetworkChannel::Role::SERVER));
+    pending_.back()->start(offer, this);
 }
 
 void RelayPeerManager::onRelayConnectionReady(std::unique_ptr<NetworkChannel> channel)
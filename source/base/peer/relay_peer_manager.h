@@ -25,7 +25,7 @@
 #include <memory>
 
 namespace proto {
-class RelayCredentials;
+class ConnectionOffer;
 } // namespace proto
 
 namespace base {
@@ -47,7 +47,7 @@ public:
     RelayPeerManager(std::shared_ptr<TaskRunner> task_runner, Delegate* delegate);
     ~RelayPeerManager();
 
-    void addConnectionOffer(const proto::RelayCredentials& credentials);
+    void addConnectionOffer(const proto::ConnectionOffer& offer);
 
 protected:
     // RelayPeer::Delegate implementation.
@@ -19,16 +19,20 @@
 #include "base/peer/server_authenticator.h"
 
 #include "base/bitset.h"
-#include "base/cpuid_util.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/sys_info.h"
+#include "base/task_runner.h"
+#include "base/crypto/cipher_benchmark.h"
 #include "base/crypto/generic_hash.h"
 #include "base/crypto/random.h"
 #include "base/crypto/srp_constants.h"
 #include "base/crypto/srp_math.h"
+#include "base/peer/authentication_limiter.h"
+#include "base/peer/session_ticket.h"
 #include "base/peer/user_list.h"
 #include "base/strings/unicode.h"
+#include "base/threading/thread_pool.h"
 #include "build/version.h"
 
 namespace base {
@@ -37,15 +41,56 @@ namespace {
 
 constexpr size_t kIvSize = 12;
 
+// SRP numbers which are passed to the thread pool for calculations.
+struct SrpValues
+{
+    BigNum N;
+    BigNum g;
+    BigNum s;
+    BigNum v;
+    BigNum b;
+    BigNum B;
+    BigNum A;
+
+    // If not empty, the verifier of a nonexistent user is calculated from the seed key.
+    ByteArray seed_key;
+    std::u16string user_name;
+
+    ByteArray srp_key;
+};
+
+ByteArray createSrpKey(const SrpValues& values)
+{
+    if (!SrpMath::verify_A_mod_N(values.A, values.N))
+    {
+        LOG(LS_ERROR) << "SrpMath::verify_A_mod_N failed";
+        return ByteArray();
+    }
+
+    BigNum u = SrpMath::calc_u(values.A, values.B, values.N);
+    BigNum server_key = SrpMath::calcServerKey(values.A, values.v, u, values.b, values.N);
+
+    return server_key.toByteArray();
+}
+
 } // namespace
 
 ServerAuthenticator::ServerAuthenticator(std::shared_ptr<TaskRunner> task_runner)
-    : Authenticator(std::move(task_runner))
+    : Authenticator(task_runner),
+      task_runner_(std::move(task_runner))
 {
     // Nothing
 }
 
-ServerAuthenticator::~ServerAuthenticator() = default;
+ServerAuthenticator::~ServerAuthenticator()
+{
+    if (limiter_)
+    {
+        if (anonymous_admitted_)
+            limiter_->finishAnonymous();
+        limiter_->finish();
+    }
+}
 
 void ServerAuthenticator::setUserList(std::shared_ptr<UserListBase> user_list)
 {
@@ -115,6 +160,23 @@ bool ServerAuthenticator::setAnonymousAccess(
     return true;
 }
 
+void ServerAuthenticator::setThreadPool(std::shared_ptr<ThreadPool> thread_pool)
+{
+    thread_pool_ = std::move(thread_pool);
+}
+
+void ServerAuthenticator::setSessionTicketKeeper(
+    std::shared_ptr<SessionTicketKeeper> ticket_keeper)
+{
+    ticket_keeper_ = std::move(ticket_keeper);
+}
+
+void ServerAuthenticator::setLimiter(std::shared_ptr<AuthenticationLimiter> limiter)
+{
+    DCHECK(!limiter_);
+    limiter_ = std::move(limiter);
+}
+
 bool ServerAuthenticator::onStarted()
 {
     internal_state_ = InternalState::READ_CLIENT_HELLO;
@@ -157,6 +219,13 @@ bool ServerAuthenticator::onStarted()
 
 void ServerAuthenticator::onReceived(const ByteArray& buffer)
 {
+    // The client does not send messages until it receives a reply to the previous one.
+    if (crypto_pending_)
+    {
+        finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
+        return;
+    }
+
     switch (internal_state_)
     {
         case InternalState::READ_CLIENT_HELLO:
@@ -199,7 +268,16 @@ void ServerAuthenticator::onWritten()
             {
                 case proto::IDENTIFY_SRP:
                 {
-                    internal_state_ = InternalState::READ_IDENTIFY;
+                    if (session_resumed_)
+                    {
+                        // The user is already known from the ticket.
+                        internal_state_ = InternalState::SEND_SESSION_CHALLENGE;
+                        doSessionChallenge();
+                    }
+                    else
+                    {
+                        internal_state_ = InternalState::READ_IDENTIFY;
+                    }
                 }
                 break;
 
@@ -217,6 +295,12 @@ void ServerAuthenticator::onWritten()
         }
         break;
 
+        case InternalState::SEND_RETRY_AFTER:
+        {
+            finish(FROM_HERE, ErrorCode::SESSION_DENIED);
+        }
+        break;
+
         case InternalState::SEND_SERVER_KEY_EXCHANGE:
         {
             LOG(LS_INFO) << "Sended: ServerKeyExchange";
@@ -274,6 +358,18 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
                 finish(FROM_HERE, ErrorCode::ACCESS_DENIED);
                 return;
             }
+
+            // Anonymous peers are rejected before the key exchange if there are too many of them.
+            if (limiter_)
+            {
+                if (!limiter_->admitAnonymous())
+                {
+                    sendRetryAfter();
+                    return;
+                }
+
+                anonymous_admitted_ = true;
+            }
         }
         break;
 
@@ -286,13 +382,15 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
     }
 
     std::unique_ptr<proto::ServerHello> server_hello = std::make_unique<proto::ServerHello>();
+    ByteArray session_ticket = fromStdString(client_hello->session_ticket());
 
     if (key_pair_.isValid())
     {
         ByteArray peer_public_key = fromStdString(client_hello->public_key());
         decrypt_iv_ = fromStdString(client_hello->iv());
 
-        if (peer_public_key.empty() != decrypt_iv_.empty())
+        // The client sends IV without a public key if it has a session ticket.
+        if (peer_public_key.empty() != decrypt_iv_.empty() && session_ticket.empty())
         {
             finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
             return;
@@ -319,26 +417,44 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
         }
     }
 
-    bool has_aes_ni = false;
+    if (identify_ == proto::IDENTIFY_SRP && !session_ticket.empty())
+    {
+        if (resumeSession(session_ticket, fromStdString(client_hello->iv())))
+        {
+            server_hello->set_iv(toStdString(encrypt_iv_));
+            server_hello->set_session_resumed(true);
+        }
+        else
+        {
+            LOG(LS_INFO) << "Session ticket is not accepted";
+        }
+    }
+
+    // Old clients do not report their speed. They offer AES256 GCM only if they have hardware
+    // support AES, and then the local speed decides.
+    CipherBenchmark::Result client_speed;
+    client_speed.chacha20_poly1305 = client_hello->chacha20_poly1305_speed();
+    client_speed.aes256_gcm = client_hello->aes256_gcm_speed();
+
+    LOG(LS_INFO) << "Client encryption speed: ChaCha20+Poly1305 "
+                 << client_speed.chacha20_poly1305 << " MB/s, AES256 GCM "
+                 << client_speed.aes256_gcm << " MB/s";
 
-#if defined(ARCH_CPU_X86_FAMILY)
-    has_aes_ni = CpuidUtil::hasAesNi();
-#endif
+    proto::Encryption encryption = CipherBenchmark::select(
+        client_hello->encryption(), CipherBenchmark::current(), client_speed);
 
-    if ((client_hello->encryption() & proto::ENCRYPTION_AES256_GCM) && has_aes_ni)
+    if (encryption == proto::ENCRYPTION_AES256_GCM)
     {
-        LOG(LS_INFO) << "Both sides have hardware support AES. Using AES256 GCM";
-        // If both sides of the connection support AES, then method AES256 GCM is the fastest option.
-        server_hello->set_encryption(proto::ENCRYPTION_AES256_GCM);
+        LOG(LS_INFO) << "Using AES256 GCM";
     }
     else
     {
+        DCHECK_EQ(encryption, proto::ENCRYPTION_CHACHA20_POLY1305);
         LOG(LS_INFO) << "Using ChaCha20+Poly1305";
-        // Otherwise, we use ChaCha20+Poly1305. This works faster in the absence of hardware
-        // support AES.
-        server_hello->set_encryption(proto::ENCRYPTION_CHACHA20_POLY1305);
     }
 
+    server_hello->set_encryption(encryption);
+
     // Now we are in the authentication phase.
     internal_state_ = InternalState::SEND_SERVER_HELLO;
     encryption_ = server_hello->encryption();
@@ -347,6 +463,68 @@ void ServerAuthenticator::onClientHello(const ByteArray& buffer)
     sendMessage(*server_hello);
 }
 
+void ServerAuthenticator::sendRetryAfter()
+{
+    DCHECK(limiter_);
+
+    const std::chrono::milliseconds delay = limiter_->retryDelay();
+
+    LOG_EVERY_T(LS_WARNING, std::chrono::seconds(1))
+        << "Too many anonymous authentications. Peer will retry after " << delay.count() << " ms";
+
+    std::unique_ptr<proto::ServerHello> server_hello = std::make_unique<proto::ServerHello>();
+    server_hello->set_retry_after_ms(static_cast<uint32_t>(delay.count()));
+
+    internal_state_ = InternalState::SEND_RETRY_AFTER;
+    sendMessage(*server_hello);
+}
+
+bool ServerAuthenticator::resumeSession(const ByteArray& ticket, const ByteArray& client_iv)
+{
+    if (!ticket_keeper_ || !user_list_ || client_iv.empty())
+        return false;
+
+    std::optional<SessionTicketKeeper::Data> data = ticket_keeper_->open(ticket);
+    if (!data.has_value())
+        return false;
+
+    User user = user_list_->find(base::utf16FromUtf8(data->user_name));
+    if (!user.isValid() || !(user.flags & User::ENABLED))
+    {
+        LOG(LS_INFO) << "User '" << data->user_name << "' NOT found or disabled";
+        return false;
+    }
+
+    // The ticket is not valid after the password change.
+    ByteArray verifier_hash = GenericHash::hash(GenericHash::BLAKE2s256, user.verifier);
+    if (verifier_hash != data->verifier_hash)
+    {
+        LOG(LS_INFO) << "Verifier of user '" << data->user_name << "' is changed";
+        return false;
+    }
+
+    // Without a private key IV is not generated in advance.
+    if (encrypt_iv_.empty())
+    {
+        encrypt_iv_ = Random::byteArray(kIvSize);
+        if (encrypt_iv_.empty())
+            return false;
+    }
+
+    decrypt_iv_ = client_iv;
+    session_key_ =
+        SessionTicket::createSessionKey(session_key_, data->secret, decrypt_iv_, encrypt_iv_);
+
+    user_name_ = std::move(data->user_name);
+    session_types_ = user.sessions;
+    verifier_hash_ = std::move(verifier_hash);
+    ticket_expire_time_ = data->expire_time;
+    session_resumed_ = true;
+
+    LOG(LS_INFO) << "Session of user '" << user_name_ << "' is resumed";
+    return true;
+}
+
 void ServerAuthenticator::onIdentify(const ByteArray& buffer)
 {
     LOG(LS_INFO) << "Received: Identify";
@@ -367,6 +545,8 @@ void ServerAuthenticator::onIdentify(const ByteArray& buffer)
 
     LOG(LS_INFO) << "Username: " << user_name_;
 
+    std::shared_ptr<SrpValues> values = std::make_shared<SrpValues>();
+
     do
     {
         std::u16string user_name_utf16 = base::utf16FromUtf8(user_name_);
@@ -403,10 +583,11 @@ void ServerAuthenticator::onIdentify(const ByteArray& buffer)
             std::optional<SrpNgPair> Ng_pair = pairByGroup(user.group);
             if (Ng_pair.has_value())
             {
-                N_ = BigNum::fromStdString(Ng_pair->first);
-                g_ = BigNum::fromStdString(Ng_pair->second);
-                s_ = BigNum::fromByteArray(user.salt);
-                v_ = BigNum::fromByteArray(user.verifier);
+                values->N = BigNum::fromStdString(Ng_pair->first);
+                values->g = BigNum::fromStdString(Ng_pair->second);
+                values->s = BigNum::fromByteArray(user.salt);
+                values->v = BigNum::fromByteArray(user.verifier);
+                verifier_hash_ = GenericHash::hash(GenericHash::BLAKE2s256, user.verifier);
                 break;
             }
             else
@@ -417,20 +598,49 @@ void ServerAuthenticator::onIdentify(const ByteArray& buffer)
 
         session_types_ = 0;
 
+        // A ticket for a nonexistent user looks the same, but it can never be used.
+        verifier_hash_ = Random::byteArray(32);
+
         GenericHash hash(GenericHash::BLAKE2b512);
         hash.addData(seed_key);
         hash.addData(user_name_);
 
-        N_ = BigNum::fromStdString(kSrpNgPair_8192.first);
-        g_ = BigNum::fromStdString(kSrpNgPair_8192.second);
-        s_ = BigNum::fromByteArray(hash.result());
-        v_ = SrpMath::calc_v(user_name_utf16, seed_key, s_, N_, g_);
+        values->N = BigNum::fromStdString(kSrpNgPair_8192.first);
+        values->g = BigNum::fromStdString(kSrpNgPair_8192.second);
+        values->s = BigNum::fromByteArray(hash.result());
+        values->seed_key = std::move(seed_key);
+        values->user_name = std::move(user_name_utf16);
     }
     while (false);
 
-    b_ = BigNum::fromByteArray(Random::byteArray(128)); // 1024 bits.
-    B_ = SrpMath::calc_B(b_, N_, g_, v_);
+    // Modular exponentiation with large groups takes milliseconds. It is done on the thread pool
+    // so that the handshakes of different clients do not wait for each other.
+    postCryptoTask([values]()
+    {
+        if (!values->seed_key.empty())
+        {
+            values->v = SrpMath::calc_v(
+                values->user_name, values->seed_key, values->s, values->N, values->g);
+        }
 
+        values->b = BigNum::fromByteArray(Random::byteArray(128)); // 1024 bits.
+        values->B = SrpMath::calc_B(values->b, values->N, values->g, values->v);
+    },
+    [this, values]()
+    {
+        N_ = std::move(values->N);
+        g_ = std::move(values->g);
+        s_ = std::move(values->s);
+        v_ = std::move(values->v);
+        b_ = std::move(values->b);
+        B_ = std::move(values->B);
+
+        doServerKeyExchange();
+    });
+}
+
+void ServerAuthenticator::doServerKeyExchange()
+{
     if (!N_.isValid() || !g_.isValid() || !s_.isValid() || !B_.isValid())
     {
         finish(FROM_HERE, ErrorCode::PROTOCOL_ERROR);
@@ -474,7 +684,25 @@ void ServerAuthenticator::onClientKeyExchange(const ByteArray& buffer)
         return;
     }
 
-    ByteArray srp_key = createSrpKey();
+    std::shared_ptr<SrpValues> values = std::make_shared<SrpValues>();
+    values->N = std::move(N_);
+    values->v = std::move(v_);
+    values->b = std::move(b_);
+    values->B = std::move(B_);
+    values->A = std::move(A_);
+
+    postCryptoTask([values]()
+    {
+        values->srp_key = createSrpKey(*values);
+    },
+    [this, values]()
+    {
+        onSrpKeyCreated(values->srp_key);
+    });
+}
+
+void ServerAuthenticator::onSrpKeyCreated(const ByteArray& srp_key)
+{
     if (srp_key.empty())
     {
         finish(FROM_HERE, ErrorCode::UNKNOWN_ERROR);
@@ -526,6 +754,18 @@ void ServerAuthenticator::doSessionChallenge()
     session_challenge->set_computer_name(SysInfo::computerName());
     session_challenge->set_cpu_cores(SysInfo::processorThreads());
 
+    if (identify_ == proto::IDENTIFY_SRP && ticket_keeper_)
+    {
+        // The ticket issued for a resumed session expires at the same time as the previous one.
+        SessionTicketKeeper::Data ticket_data;
+        ticket_data.user_name = user_name_;
+        ticket_data.secret = SessionTicket::createSecret(session_key_);
+        ticket_data.verifier_hash = verifier_hash_;
+        ticket_data.expire_time = ticket_expire_time_;
+
+        session_challenge->set_session_ticket(toStdString(ticket_keeper_->issue(ticket_data)));
+    }
+
     LOG(LS_INFO) << "Sending: SessionChallenge";
     sendMessage(*session_challenge);
 }
@@ -570,18 +810,40 @@ void ServerAuthenticator::onSessionResponse(const ByteArray& buffer)
     finish(FROM_HERE, ErrorCode::SUCCESS);
 }
 
-ByteArray ServerAuthenticator::createSrpKey()
+void ServerAuthenticator::postCryptoTask(std::function<void()> task, std::function<void()> reply)
 {
-    if (!SrpMath::verify_A_mod_N(A_, N_))
+    if (!thread_pool_)
     {
-        LOG(LS_ERROR) << "SrpMath::verify_A_mod_N failed";
-        return ByteArray();
+        task();
+        reply();
+        return;
     }
 
-    BigNum u = SrpMath::calc_u(A_, B_, N_);
-    BigNum server_key = SrpMath::calcServerKey(A_, v_, u, b_, N_);
+    crypto_pending_ = true;
 
-    return server_key.toByteArray();
+    std::weak_ptr<bool> alive = alive_;
+    std::function<void()> reply_task = [this, alive, reply = std::move(reply)]()
+    {
+        // The authenticator is destroyed on this thread, so it can not be destroyed while the
+        // reply is running.
+        if (alive.expired())
+            return;
+
+        crypto_pending_ = false;
+
+        // The authenticator could be finished by a timeout or a network error.
+        if (state() != State::PENDING)
+            return;
+
+        reply();
+    };
+
+    thread_pool_->postTask(
+        [task = std::move(task), reply_task = std::move(reply_task), task_runner = task_runner_]()
+    {
+        task();
+        task_runner->postTask(std::move(reply_task));
+    });
 }
 
 } // namespace base
@@ -24,8 +24,13 @@
 #include "base/net/network_channel.h"
 #include "base/peer/authenticator.h"
 
+#include <chrono>
+
 namespace base {
 
+class AuthenticationLimiter;
+class SessionTicketKeeper;
+class ThreadPool;
 class UserListBase;
 
 class ServerAuthenticator : public Authenticator
@@ -52,6 +57,19 @@ public:
     // By default, anonymous access is disabled.
     [[nodiscard]] bool setAnonymousAccess(AnonymousAccess anonymous_access, uint32_t session_types);
 
+    // Sets the pool on which SRP calculations are made. If the pool is not set, the calculations
+    // are made on the thread of the authenticator.
+    void setThreadPool(std::shared_ptr<ThreadPool> thread_pool);
+
+    // Sets the keeper of session tickets. If the keeper is set, users authenticated by SRP receive
+    // a ticket and can resume the session on reconnect without the SRP exchange.
+    void setSessionTicketKeeper(std::shared_ptr<SessionTicketKeeper> ticket_keeper);
+
+    // The authentication is admitted by |limiter| (see AuthenticationLimiter::admit). The admission
+    // is finished when the authenticator is destroyed. Anonymous peers are admitted by the limiter
+    // too and are asked to retry later if it rejects them.
+    void setLimiter(std::shared_ptr<AuthenticationLimiter> limiter);
+
 protected:
     // Authenticator implementation.
     bool onStarted() override;
@@ -60,18 +78,35 @@ protected:
 
 private:
     void onClientHello(const ByteArray& buffer);
+    void sendRetryAfter();
+    bool resumeSession(const ByteArray& ticket, const ByteArray& client_iv);
     void onIdentify(const ByteArray& buffer);
+    void doServerKeyExchange();
     void onClientKeyExchange(const ByteArray& buffer);
+    void onSrpKeyCreated(const ByteArray& srp_key);
     void doSessionChallenge();
     void onSessionResponse(const ByteArray& buffer);
-    [[nodiscard]] ByteArray createSrpKey();
 
+    // Runs |task| on the thread pool and then |reply| on the thread of the authenticator. The
+    // reply is not called if the authenticator is destroyed in the meantime.
+    void postCryptoTask(std::function<void()> task, std::function<void()> reply);
+
+    std::shared_ptr<TaskRunner> task_runner_;
+    std::shared_ptr<ThreadPool> thread_pool_;
     std::shared_ptr<UserListBase> user_list_;
+    std::shared_ptr<SessionTicketKeeper> ticket_keeper_;
+    std::shared_ptr<AuthenticationLimiter> limiter_;
+    bool anonymous_admitted_ = false;
+
+    // True while a calculation is made on the thread pool.
+    bool crypto_pending_ = false;
+    std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
 
     enum class InternalState
     {
         READ_CLIENT_HELLO,
         SEND_SERVER_HELLO,
+        SEND_RETRY_AFTER,
         READ_IDENTIFY,
         SEND_SERVER_KEY_EXCHANGE,
         READ_CLIENT_KEY_EXCHANGE,
@@ -85,6 +120,14 @@ private:
     // Bitmask of allowed session types.
     uint32_t session_types_ = 0;
 
+    // True if the session is resumed by a ticket.
+    bool session_resumed_ = false;
+
+    // Hash of the user's verifier and the expiration time of the resumed ticket (the ticket issued
+    // for a resumed session expires at the same time).
+    ByteArray verifier_hash_;
+    std::chrono::system_clock::time_point ticket_expire_time_;
+
     KeyPair key_pair_;
     BigNum N_;
     BigNum g_;
@@ -20,6 +20,7 @@
 
 #include "base/logging.h"
 #include "base/task_runner.h"
+#include "base/peer/authentication_limiter.h"
 #include "base/peer/user_list_base.h"
 
 namespace base {
@@ -52,26 +53,49 @@ void ServerAuthenticatorManager::setAnonymousAccess(
     anonymous_session_types_ = session_types;
 }
 
-void ServerAuthenticatorManager::addNewChannel(std::unique_ptr<NetworkChannel> channel)
+void ServerAuthenticatorManager::setThreadPool(std::shared_ptr<ThreadPool> thread_pool)
+{
+    thread_pool_ = std::move(thread_pool);
+}
+
+void ServerAuthenticatorManager::setSessionTicketKeeper(
+    std::shared_ptr<SessionTicketKeeper> ticket_keeper)
+{
+    ticket_keeper_ = std::move(ticket_keeper);
+}
+
+void ServerAuthenticatorManager::setLimiter(std::shared_ptr<AuthenticationLimiter> limiter)
+{
+    limiter_ = std::move(limiter);
+}
+
+bool ServerAuthenticatorManager::addNewChannel(std::unique_ptr<NetworkChannel> channel)
 {
     DCHECK(channel);
 
+    if (limiter_ && !limiter_->admit())
+        return false;
+
     std::unique_ptr<ServerAuthenticator> authenticator =
         std::make_unique<ServerAuthenticator>(task_runner_);
+    if (limiter_)
+        authenticator->setLimiter(limiter_);
     authenticator->setUserList(user_list_);
+    authenticator->setThreadPool(thread_pool_);
+    authenticator->setSessionTicketKeeper(ticket_keeper_);
 
     if (!private_key_.empty())
     {
         if (!authenticator->setPrivateKey(private_key_))
         {
             LOG(LS_ERROR) << "Failed to set private key for authenticator";
-            return;
+            return true;
         }
 
         if (!authenticator->setAnonymousAccess(anonymous_access_, anonymous_session_types_))
         {
             LOG(LS_ERROR) << "Failed to set anonymous access settings";
-            return;
+            return true;
         }
     }
 
@@ -81,6 +105,7 @@ void ServerAuthenticatorManager::addNewChannel(std::unique_ptr<NetworkChannel> c
     // Start the authentication process.
     pending_.back()->start(
         std::move(channel), std::bind(&ServerAuthenticatorManager::onComplete, this));
+    return true;
 }
 
 void ServerAuthenticatorManager::onComplete()
@@ -104,6 +129,7 @@ void ServerAuthenticatorManager::onComplete()
                     session_info.computer_name = current->peerComputerName();
                     session_info.user_name     = current->userName();
                     session_info.session_type  = current->sessionType();
+                    session_info.auth_duration = current->duration();
 
                     delegate_->onNewSession(std::move(session_info));
                 }
@@ -42,6 +42,9 @@ public:
         std::string computer_name;
         std::string user_name;
         uint32_t session_type = 0;
+
+        // Time spent on the authentication.
+        std::chrono::milliseconds auth_duration { 0 };
     };
 
     class Delegate
@@ -63,16 +66,30 @@ public:
     void setAnonymousAccess(
         ServerAuthenticator::AnonymousAccess anonymous_access, uint32_t session_types);
 
+    // See ServerAuthenticator::setThreadPool.
+    void setThreadPool(std::shared_ptr<ThreadPool> thread_pool);
+
+    // See ServerAuthenticator::setSessionTicketKeeper.
+    void setSessionTicketKeeper(std::shared_ptr<SessionTicketKeeper> ticket_keeper);
+
+    // Sets the admission control of the new channels (see AuthenticationLimiter). The limiter can
+    // be shared by several managers.
+    void setLimiter(std::shared_ptr<AuthenticationLimiter> limiter);
+
     // Adds a channel to the authentication queue. After success completion, a session will be
     // created (in a stopped state) and method Delegate::onNewSession will be called.
-    // If authentication fails, the channel will be automatically deleted.
-    void addNewChannel(std::unique_ptr<NetworkChannel> channel);
+    // If authentication fails, the channel will be automatically deleted. If the limiter does not
+    // admit the channel, it is deleted and false is returned.
+    bool addNewChannel(std::unique_ptr<NetworkChannel> channel);
 
 private:
     void onComplete();
 
     std::shared_ptr<TaskRunner> task_runner_;
     std::shared_ptr<UserListBase> user_list_;
+    std::shared_ptr<ThreadPool> thread_pool_;
+    std::shared_ptr<SessionTicketKeeper> ticket_keeper_;
+    std::shared_ptr<AuthenticationLimiter> limiter_;
     std::vector<std::unique_ptr<ServerAuthenticator>> pending_;
 
     ByteArray private_key_;
@@ -0,0 +1,228 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/peer/session_ticket.h"
+
+#include "base/logging.h"
+#include "base/crypto/data_cryptor_chacha20_poly1305.h"
+#include "base/crypto/generic_hash.h"
+#include "base/crypto/random.h"
+#include "proto/key_exchange.pb.h"
+
+namespace base {
+
+namespace {
+
+const size_t kKeySize = 32; // 256 bits.
+const size_t kMaxCacheSize = 64;
+
+const char kSecretLabel[] = "aspia session resumption";
+
+std::mutex g_cache_lock;
+std::map<std::string, SessionTicket, std::less<>> g_cache;
+
+std::unique_ptr<DataCryptor> createCryptor()
+{
+    std::string key = Random::string(kKeySize);
+    if (key.size() != kKeySize)
+    {
+        LOG(LS_ERROR) << "Unable to generate ticket key";
+        return nullptr;
+    }
+
+    return std::make_unique<DataCryptorChaCha20Poly1305>(key);
+}
+
+int64_t toSeconds(std::chrono::system_clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point fromSeconds(int64_t seconds)
+{
+    return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+}
+
+} // namespace
+
+// static
+ByteArray SessionTicket::createSecret(const ByteArray& session_key)
+{
+    DCHECK(!session_key.empty());
+
+    GenericHash hash(GenericHash::BLAKE2s256);
+    hash.addData(kSecretLabel);
+    hash.addData(session_key);
+    return hash.result();
+}
+
+// static
+ByteArray SessionTicket::createSessionKey(const ByteArray& session_key, const ByteArray& secret,
+                                          const ByteArray& client_iv, const ByteArray& server_iv)
+{
+    DCHECK(!secret.empty());
+
+    // AES256-GCM and ChaCha20-Poly1305 requires 256 bit key.
+    GenericHash hash(GenericHash::BLAKE2s256);
+
+    if (!session_key.empty())
+        hash.addData(session_key);
+    hash.addData(secret);
+    hash.addData(client_iv);
+    hash.addData(server_iv);
+
+    return hash.result();
+}
+
+// static
+const std::chrono::seconds SessionTicketKeeper::kDefaultLifetime = std::chrono::hours(12);
+
+SessionTicketKeeper::SessionTicketKeeper(std::chrono::seconds lifetime)
+    : lifetime_(lifetime)
+{
+    DCHECK_GT(lifetime_.count(), 0);
+}
+
+SessionTicketKeeper::~SessionTicketKeeper() = default;
+
+ByteArray SessionTicketKeeper::issue(const Data& data)
+{
+    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+
+    proto::SessionTicketData ticket_data;
+    ticket_data.set_user_name(data.user_name);
+    ticket_data.set_secret(toStdString(data.secret));
+    ticket_data.set_verifier_hash(toStdString(data.verifier_hash));
+
+    if (data.expire_time == std::chrono::system_clock::time_point())
+        ticket_data.set_expire_time(toSeconds(now + lifetime_));
+    else
+        ticket_data.set_expire_time(toSeconds(data.expire_time));
+
+    std::string ticket;
+
+    {
+        std::scoped_lock lock(lock_);
+
+        rotateKeys(now);
+        if (!current_ || !current_->encrypt(ticket_data.SerializeAsString(), &ticket))
+        {
+            LOG(LS_ERROR) << "Unable to encrypt session ticket";
+            return ByteArray();
+        }
+    }
+
+    return fromStdString(ticket);
+}
+
+std::optional<SessionTicketKeeper::Data> SessionTicketKeeper::open(const ByteArray& ticket)
+{
+    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+    std::string_view encrypted(reinterpret_cast<const char*>(ticket.data()), ticket.size());
+    std::string decrypted;
+
+    {
+        std::scoped_lock lock(lock_);
+
+        rotateKeys(now);
+
+        // Tickets issued before the last rotation are encrypted with the previous key.
+        if ((!current_ || !current_->decrypt(encrypted, &decrypted)) &&
+            (!previous_ || !previous_->decrypt(encrypted, &decrypted)))
+        {
+            LOG(LS_INFO) << "Unable to decrypt session ticket";
+            return std::nullopt;
+        }
+    }
+
+    proto::SessionTicketData ticket_data;
+    if (!ticket_data.ParseFromString(decrypted))
+    {
+        LOG(LS_ERROR) << "Invalid session ticket";
+        return std::nullopt;
+    }
+
+    Data data;
+    data.user_name = std::move(*ticket_data.mutable_user_name());
+    data.secret = fromStdString(ticket_data.secret());
+    data.verifier_hash = fromStdString(ticket_data.verifier_hash());
+    data.expire_time = fromSeconds(ticket_data.expire_time());
+
+    if (data.expire_time <= now)
+    {
+        LOG(LS_INFO) << "Session ticket expired";
+        return std::nullopt;
+    }
+
+    if (data.user_name.empty() || data.secret.empty())
+    {
+        LOG(LS_ERROR) << "Invalid session ticket";
+        return std::nullopt;
+    }
+
+    return data;
+}
+
+void SessionTicketKeeper::rotateKeys(std::chrono::system_clock::time_point now)
+{
+    if (current_ && now < rotate_time_)
+        return;
+
+    // A ticket does not live longer than |lifetime_|, so it is enough to keep one previous key.
+    // If the keys were not used for a long time, the previous key is outdated too.
+    if (current_ && now < rotate_time_ + lifetime_)
+        previous_ = std::move(current_);
+    else
+        previous_.reset();
+
+    current_ = createCryptor();
+    rotate_time_ = now + lifetime_;
+}
+
+// static
+SessionTicket SessionTicketCache::find(std::string_view key)
+{
+    std::scoped_lock lock(g_cache_lock);
+
+    auto it = g_cache.find(key);
+    if (it == g_cache.end())
+        return SessionTicket();
+
+    return it->second;
+}
+
+// static
+void SessionTicketCache::store(std::string_view key, const SessionTicket& ticket)
+{
+    std::scoped_lock lock(g_cache_lock);
+
+    if (!ticket.isValid())
+    {
+        auto it = g_cache.find(key);
+        if (it != g_cache.end())
+            g_cache.erase(it);
+        return;
+    }
+
+    if (g_cache.size() >= kMaxCacheSize && g_cache.find(key) == g_cache.end())
+        g_cache.erase(g_cache.begin());
+
+    g_cache.insert_or_assign(std::string(key), ticket);
+}
+
+} // namespace base
@@ -0,0 +1,113 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__PEER__SESSION_TICKET_H
+#define BASE__PEER__SESSION_TICKET_H
+
+#include "base/macros_magic.h"
+#include "base/memory/byte_array.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace base {
+
+class DataCryptor;
+
+// Ticket which allows to resume an authenticated session without the SRP exchange.
+struct SessionTicket
+{
+    bool isValid() const { return !ticket.empty() && !secret.empty(); }
+
+    // Ticket encrypted by the server. The client stores it as is.
+    ByteArray ticket;
+
+    // Resumption secret. Known only by the client and the server.
+    ByteArray secret;
+
+    // Calculates the resumption secret from the key of the authenticated session.
+    static ByteArray createSecret(const ByteArray& session_key);
+
+    // Calculates the key of a resumed session. |session_key| is the key received from the
+    // X25519 exchange or an empty array.
+    static ByteArray createSessionKey(const ByteArray& session_key, const ByteArray& secret,
+                                      const ByteArray& client_iv, const ByteArray& server_iv);
+};
+
+// Issues and checks session tickets on the server side. The tickets are encrypted with random
+// keys which exist only in memory and are rotated every |lifetime|. The class is thread-safe.
+class SessionTicketKeeper
+{
+public:
+    static const std::chrono::seconds kDefaultLifetime;
+
+    explicit SessionTicketKeeper(std::chrono::seconds lifetime = kDefaultLifetime);
+    ~SessionTicketKeeper();
+
+    struct Data
+    {
+        std::string user_name;
+        ByteArray secret;
+
+        // Hash of the user's verifier. The ticket becomes invalid if the password is changed.
+        ByteArray verifier_hash;
+
+        std::chrono::system_clock::time_point expire_time;
+    };
+
+    // Encrypts a ticket. If |data.expire_time| is not set, the ticket expires after |lifetime|.
+    // Returns an empty array on error.
+    ByteArray issue(const Data& data);
+
+    // Decrypts a ticket. Returns std::nullopt if the ticket is damaged, expired or encrypted with
+    // an outdated key.
+    std::optional<Data> open(const ByteArray& ticket);
+
+    std::chrono::seconds lifetime() const { return lifetime_; }
+
+private:
+    void rotateKeys(std::chrono::system_clock::time_point now);
+
+    const std::chrono::seconds lifetime_;
+
+    std::mutex lock_;
+    std::unique_ptr<DataCryptor> current_;
+    std::unique_ptr<DataCryptor> previous_;
+    std::chrono::system_clock::time_point rotate_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(SessionTicketKeeper);
+};
+
+// Keeps the tickets received by the client until the end of the process. The key identifies the
+// server and the user (for example, the address and the user name). The class is thread-safe.
+class SessionTicketCache
+{
+public:
+    static SessionTicket find(std::string_view key);
+    static void store(std::string_view key, const SessionTicket& ticket);
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(SessionTicketCache);
+};
+
+} // namespace base
+
+#endif // BASE__PEER__SESSION_TICKET_H
@@ -0,0 +1,117 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/peer/session_ticket.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+SessionTicketKeeper::Data testData()
+{
+    SessionTicketKeeper::Data data;
+    data.user_name = "user";
+    data.secret = SessionTicket::createSecret(fromStdString("session key"));
+    data.verifier_hash = fromStdString("verifier hash");
+    return data;
+}
+
+} // namespace
+
+TEST(SessionTicketTest, IssueAndOpen)
+{
+    SessionTicketKeeper keeper;
+
+    ByteArray ticket = keeper.issue(testData());
+    ASSERT_FALSE(ticket.empty());
+
+    std::optional<SessionTicketKeeper::Data> data = keeper.open(ticket);
+    ASSERT_TRUE(data.has_value());
+    EXPECT_EQ(data->user_name, "user");
+    EXPECT_EQ(data->secret, testData().secret);
+    EXPECT_EQ(data->verifier_hash, testData().verifier_hash);
+    EXPECT_GT(data->expire_time, std::chrono::system_clock::now());
+    EXPECT_LE(data->expire_time, std::chrono::system_clock::now() + keeper.lifetime());
+
+    // The ticket is opened only by the keeper which issued it.
+    SessionTicketKeeper other_keeper;
+    EXPECT_FALSE(other_keeper.open(ticket).has_value());
+
+    // A damaged ticket is rejected.
+    ticket[ticket.size() / 2] ^= 1;
+    EXPECT_FALSE(keeper.open(ticket).has_value());
+    EXPECT_FALSE(keeper.open(ByteArray()).has_value());
+}
+
+TEST(SessionTicketTest, Expiration)
+{
+    SessionTicketKeeper keeper;
+
+    SessionTicketKeeper::Data data = testData();
+    data.expire_time = std::chrono::system_clock::now() - std::chrono::seconds(1);
+    EXPECT_FALSE(keeper.open(keeper.issue(data)).has_value());
+
+    // The expiration time of a reissued ticket is preserved.
+    data.expire_time = std::chrono::system_clock::now() + std::chrono::minutes(5);
+    std::optional<SessionTicketKeeper::Data> opened = keeper.open(keeper.issue(data));
+    ASSERT_TRUE(opened.has_value());
+    EXPECT_EQ(std::chrono::duration_cast<std::chrono::seconds>(opened->expire_time -
+                                                               data.expire_time).count(), 0);
+}
+
+TEST(SessionTicketTest, SessionKey)
+{
+    ByteArray secret = SessionTicket::createSecret(fromStdString("session key"));
+    ByteArray client_iv = fromStdString("client iv");
+    ByteArray server_iv = fromStdString("server iv");
+
+    ByteArray key = SessionTicket::createSessionKey(ByteArray(), secret, client_iv, server_iv);
+    EXPECT_EQ(key.size(), 32u);
+    EXPECT_NE(key, secret);
+
+    // The key depends on all values.
+    EXPECT_EQ(key, SessionTicket::createSessionKey(ByteArray(), secret, client_iv, server_iv));
+    EXPECT_NE(key, SessionTicket::createSessionKey(
+        fromStdString("x25519 key"), secret, client_iv, server_iv));
+    EXPECT_NE(key, SessionTicket::createSessionKey(ByteArray(), secret, server_iv, client_iv));
+    EXPECT_NE(secret, SessionTicket::createSecret(fromStdString("other session key")));
+}
+
+TEST(SessionTicketTest, Cache)
+{
+    SessionTicket ticket;
+    ticket.ticket = fromStdString("ticket");
+    ticket.secret = fromStdString("secret");
+
+    EXPECT_FALSE(SessionTicketCache::find("user@host").isValid());
+
+    SessionTicketCache::store("user@host", ticket);
+    SessionTicket found = SessionTicketCache::find("user@host");
+    EXPECT_TRUE(found.isValid());
+    EXPECT_EQ(found.ticket, ticket.ticket);
+    EXPECT_EQ(found.secret, ticket.secret);
+    EXPECT_FALSE(SessionTicketCache::find("other@host").isValid());
+
+    // An invalid ticket removes the previous one.
+    SessionTicketCache::store("user@host", SessionTicket());
+    EXPECT_FALSE(SessionTicketCache::find("user@host").isValid());
+}
+
+} // namespace base
@@ -0,0 +1,216 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/prometheus_writer.h"
+
+#include "base/logging.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace base {
+
+namespace {
+
+const char* typeToString(PrometheusWriter::Type type)
+{
+    switch (type)
+    {
+        case PrometheusWriter::Type::COUNTER:
+            return "counter";
+
+        case PrometheusWriter::Type::GAUGE:
+            return "gauge";
+
+        case PrometheusWriter::Type::HISTOGRAM:
+            return "histogram";
+
+        default:
+            return "untyped";
+    }
+}
+
+void appendValue(double value, std::string* out)
+{
+    if (std::isinf(value))
+    {
+        out->append(value > 0 ? "+Inf" : "-Inf");
+        return;
+    }
+
+    if (std::isnan(value))
+    {
+        out->append("NaN");
+        return;
+    }
+
+    char buffer[32];
+
+    // Counters are integers and must not lose digits to the exponent notation.
+    if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0)
+        snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+    else
+        snprintf(buffer, sizeof(buffer), "%.15g", value);
+
+    out->append(buffer);
+}
+
+// Help text escapes backslash and line feed, label values also escape the double quote.
+void appendEscaped(std::string_view text, bool escape_quote, std::string* out)
+{
+    for (char ch : text)
+    {
+        if (ch == '\\')
+            out->append("\\\\");
+        else if (ch == '\n')
+            out->append("\\n");
+        else if (ch == '"' && escape_quote)
+            out->append("\\\"");
+        else
+            out->push_back(ch);
+    }
+}
+
+} // namespace
+
+// static
+const char PrometheusWriter::kContentType[] = "text/plain; version=0.0.4; charset=utf-8";
+
+// static
+PrometheusWriter::Histogram PrometheusWriter::fromLatency(
+    const LatencyHistogram::Snapshot& snapshot)
+{
+    Histogram histogram;
+
+    for (int64_t bound : snapshot.upper_bounds)
+        histogram.upper_bounds.emplace_back(static_cast<double>(bound) / 1000.0);
+
+    histogram.counts = snapshot.counts;
+    histogram.sum = static_cast<double>(snapshot.sum.count()) / 1000000.0;
+    return histogram;
+}
+
+void PrometheusWriter::addFamily(std::string_view name, Type type, std::string_view help)
+{
+    text_.append("# HELP ");
+    text_.append(name);
+    text_.push_back(' ');
+    appendEscaped(help, false, &text_);
+    text_.append("\n# TYPE ");
+    text_.append(name);
+    text_.push_back(' ');
+    text_.append(typeToString(type));
+    text_.push_back('\n');
+}
+
+void PrometheusWriter::addSample(std::string_view name, double value, const Labels& labels)
+{
+    appendSample(name, std::string_view(), labels, nullptr, 0, value);
+}
+
+void PrometheusWriter::addHistogram(std::string_view name, const Histogram& histogram,
+                                    const Labels& labels)
+{
+    DCHECK_EQ(histogram.counts.size(), histogram.upper_bounds.size() + 1);
+
+    // Buckets of the exposition format are cumulative.
+    uint64_t cumulative = 0;
+
+    for (size_t i = 0; i < histogram.counts.size(); ++i)
+    {
+        cumulative += histogram.counts[i];
+
+        const double bound = i < histogram.upper_bounds.size() ?
+            histogram.upper_bounds[i] : HUGE_VAL;
+
+        appendSample(name, "_bucket", labels, "le", bound, static_cast<double>(cumulative));
+    }
+
+    appendSample(name, "_sum", labels, nullptr, 0, histogram.sum);
+    appendSample(name, "_count", labels, nullptr, 0, static_cast<double>(cumulative));
+}
+
+void PrometheusWriter::addCounter(std::string_view name, std::string_view help, double value)
+{
+    addFamily(name, Type::COUNTER, help);
+    addSample(name, value);
+}
+
+void PrometheusWriter::addGauge(std::string_view name, std::string_view help, double value)
+{
+    addFamily(name, Type::GAUGE, help);
+    addSample(name, value);
+}
+
+void PrometheusWriter::addMemory(std::string_view name, const MemoryAccount& account)
+{
+    addFamily(name, Type::GAUGE, "Memory used by the subsystems in bytes.");
+
+    for (int i = 0; i < static_cast<int>(MemoryTag::COUNT); ++i)
+    {
+        const MemoryTag tag = static_cast<MemoryTag>(i);
+        addSample(name, static_cast<double>(account.current(tag)),
+                  { { "tag", MemoryAccount::tagToString(tag) } });
+    }
+}
+
+void PrometheusWriter::appendSample(std::string_view name, std::string_view suffix,
+                                    const Labels& labels, const char* extra_label,
+                                    double extra_value, double value)
+{
+    text_.append(name);
+    text_.append(suffix);
+
+    if (!labels.empty() || extra_label)
+    {
+        text_.push_back('{');
+
+        bool first = true;
+
+        for (const auto& label : labels)
+        {
+            if (!first)
+                text_.push_back(',');
+            first = false;
+
+            text_.append(label.first);
+            text_.append("=\"");
+            appendEscaped(label.second, true, &text_);
+            text_.push_back('"');
+        }
+
+        if (extra_label)
+        {
+            if (!first)
+                text_.push_back(',');
+
+            text_.append(extra_label);
+            text_.append("=\"");
+            appendValue(extra_value, &text_);
+            text_.push_back('"');
+        }
+
+        text_.push_back('}');
+    }
+
+    text_.push_back(' ');
+    appendValue(value, &text_);
+    text_.push_back('\n');
+}
+
+} // namespace base
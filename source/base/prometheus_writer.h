@@ -0,0 +1,84 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__PROMETHEUS_WRITER_H
+#define BASE__PROMETHEUS_WRITER_H
+
+#include "base/latency_histogram.h"
+#include "base/memory/memory_accounting.h"
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace base {
+
+// Writes metrics in the Prometheus text exposition format (version 0.0.4), which is also accepted
+// by OpenMetrics scrapers. The metrics of one family must be written after its addFamily() call.
+class PrometheusWriter
+{
+public:
+    PrometheusWriter() = default;
+    ~PrometheusWriter() = default;
+
+    // Value of the Content-Type header of the response.
+    static const char kContentType[];
+
+    enum class Type { COUNTER, GAUGE, HISTOGRAM };
+
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    struct Histogram
+    {
+        std::vector<double> upper_bounds;
+        std::vector<uint64_t> counts; // Not cumulative, one more than |upper_bounds|.
+        double sum = 0;
+    };
+
+    // Converts |snapshot| to a histogram in seconds.
+    static Histogram fromLatency(const LatencyHistogram::Snapshot& snapshot);
+
+    // Writes the HELP and TYPE lines of the family.
+    void addFamily(std::string_view name, Type type, std::string_view help);
+
+    void addSample(std::string_view name, double value, const Labels& labels = Labels());
+    void addHistogram(std::string_view name, const Histogram& histogram,
+                      const Labels& labels = Labels());
+
+    // Write a family with a single sample.
+    void addCounter(std::string_view name, std::string_view help, double value);
+    void addGauge(std::string_view name, std::string_view help, double value);
+
+    // Writes a gauge family with the current memory of each tag of |account|.
+    void addMemory(std::string_view name, const MemoryAccount& account);
+
+    const std::string& text() const { return text_; }
+
+private:
+    void appendSample(std::string_view name, std::string_view suffix, const Labels& labels,
+                      const char* extra_label, double extra_value, double value);
+
+    std::string text_;
+
+    DISALLOW_COPY_AND_ASSIGN(PrometheusWriter);
+};
+
+} // namespace base
+
+#endif // BASE__PROMETHEUS_WRITER_H
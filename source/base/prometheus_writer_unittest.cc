@@ -0,0 +1,94 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/prometheus_writer.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(PrometheusWriterTest, Counter)
+{
+    PrometheusWriter writer;
+    writer.addCounter("aspia_bytes_total", "Bytes\\sent\nby peers", 12345678901234.0);
+
+    EXPECT_EQ(writer.text(),
+              "# HELP aspia_bytes_total Bytes\\\\sent\\nby peers\n"
+              "# TYPE aspia_bytes_total counter\n"
+              "aspia_bytes_total 12345678901234\n");
+}
+
+TEST(PrometheusWriterTest, Labels)
+{
+    PrometheusWriter writer;
+    writer.addFamily("aspia_sessions", PrometheusWriter::Type::GAUGE, "Sessions");
+    writer.addSample("aspia_sessions", 3, { { "type", "host" } });
+    writer.addSample("aspia_sessions", 0.5, { { "type", "a\"b" }, { "region", "eu" } });
+
+    EXPECT_EQ(writer.text(),
+              "# HELP aspia_sessions Sessions\n"
+              "# TYPE aspia_sessions gauge\n"
+              "aspia_sessions{type=\"host\"} 3\n"
+              "aspia_sessions{type=\"a\\\"b\",region=\"eu\"} 0.5\n");
+}
+
+TEST(PrometheusWriterTest, Histogram)
+{
+    PrometheusWriter::Histogram histogram;
+    histogram.upper_bounds = { 0.001, 0.01 };
+    histogram.counts = { 1, 2, 3 };
+    histogram.sum = 1.25;
+
+    PrometheusWriter writer;
+    writer.addHistogram("aspia_latency_seconds", histogram, { { "type", "client" } });
+
+    EXPECT_EQ(writer.text(),
+              "aspia_latency_seconds_bucket{type=\"client\",le=\"0.001\"} 1\n"
+              "aspia_latency_seconds_bucket{type=\"client\",le=\"0.01\"} 3\n"
+              "aspia_latency_seconds_bucket{type=\"client\",le=\"+Inf\"} 6\n"
+              "aspia_latency_seconds_sum{type=\"client\"} 1.25\n"
+              "aspia_latency_seconds_count{type=\"client\"} 6\n");
+}
+
+TEST(PrometheusWriterTest, LatencyHistogram)
+{
+    LatencyHistogram latency;
+    latency.add(std::chrono::microseconds(500));
+    latency.add(std::chrono::milliseconds(1));
+    latency.add(std::chrono::microseconds(1001));
+    latency.add(std::chrono::seconds(60));
+    latency.add(std::chrono::microseconds(-5));
+
+    LatencyHistogram::Snapshot snapshot = latency.snapshot();
+    ASSERT_EQ(snapshot.counts.size(), LatencyHistogram::kBoundsCount + 1);
+    EXPECT_EQ(snapshot.count, 5u);
+
+    // The bound belongs to its bucket, the negative value is counted as zero.
+    EXPECT_EQ(snapshot.counts[0], 3u);
+    EXPECT_EQ(snapshot.counts[1], 1u);
+    EXPECT_EQ(snapshot.counts.back(), 1u);
+    EXPECT_EQ(snapshot.sum, std::chrono::microseconds(500 + 1000 + 1001 + 60000000));
+
+    PrometheusWriter::Histogram histogram = PrometheusWriter::fromLatency(snapshot);
+    ASSERT_EQ(histogram.upper_bounds.size(), LatencyHistogram::kBoundsCount);
+    EXPECT_DOUBLE_EQ(histogram.upper_bounds[0], 0.001);
+    EXPECT_DOUBLE_EQ(histogram.upper_bounds.back(), 10.0);
+    EXPECT_DOUBLE_EQ(histogram.sum, 60.002501);
+}
+
+} // namespace base
@@ -23,6 +23,7 @@
 #include "base/files/base_paths.h"
 #include "base/files/file_util.h"
 #include "base/files/scoped_temp_file.h"
+#include "base/settings/settings_writer.h"
 #include "base/strings/string_split.h"
 
 #include <rapidjson/document.h>
@@ -99,7 +100,7 @@ JsonSettings::JsonSettings(std::string_view file_name, Encrypted encrypted)
     if (path_.empty())
         return;
 
-    readFile(path_, map());
+    readFile(path_, map(), encrypted_);
 }
 
 JsonSettings::JsonSettings(Scope scope,
@@ -117,8 +118,13 @@ JsonSettings::JsonSettings(Scope scope,
 
 JsonSettings::~JsonSettings()
 {
-    if (isChanged())
-        writeFile(path_, constMap(), encrypted_);
+    if (!isChanged() || path_.empty())
+        return;
+
+    // The file is written in the background, the next readFile() of the file waits for it.
+    std::string data;
+    if (serialize(constMap(), encrypted_, &data))
+        SettingsWriter::instance()->write(path_, std::move(data));
 }
 
 bool JsonSettings::isWritable() const
@@ -146,12 +152,17 @@ bool JsonSettings::isWritable() const
 
 void JsonSettings::sync()
 {
-    readFile(path_, map());
+    if (readFile(path_, map(), encrypted_))
+        setChanged(false);
 }
 
 void JsonSettings::flush()
 {
-    writeFile(path_, map());
+    if (!isChanged())
+        return;
+
+    if (writeFile(path_, constMap(), encrypted_))
+        setChanged(false);
 }
 
 // static
@@ -210,6 +221,9 @@ bool JsonSettings::readFile(const std::filesystem::path& file, Map& map, Encrypt
 {
     map.clear();
 
+    // Settings destroyed earlier may not have been written to the file yet.
+    SettingsWriter::instance()->flush(file);
+
     std::error_code ignored_code;
     std::filesystem::file_status status = std::filesystem::status(file, ignored_code);
 
@@ -268,13 +282,19 @@ bool JsonSettings::readFile(const std::filesystem::path& file, Map& map, Encrypt
 // static
 bool JsonSettings::writeFile(const std::filesystem::path& file, const Map& map, Encrypted encrypted)
 {
-    std::error_code error_code;
-    if (!std::filesystem::create_directories(file.parent_path(), error_code))
-    {
-        if (error_code)
-            return false;
-    }
+    std::string data;
+    if (!serialize(map, encrypted, &data))
+        return false;
+
+    // The write goes through the writer, so it is not overtaken by an older write of the file.
+    SettingsWriter* writer = SettingsWriter::instance();
+    writer->write(file, std::move(data));
+    return writer->flush(file);
+}
 
+// static
+bool JsonSettings::serialize(const Map& map, Encrypted encrypted, std::string* data)
+{
     rapidjson::StringBuffer buffer;
     rapidjson::PrettyWriter<rapidjson::StringBuffer> json(buffer);
 
@@ -313,7 +333,7 @@ bool JsonSettings::writeFile(const std::filesystem::path& file, const Map& map,
     }
 
     // End objects.
-    for (size_t i = 0; i < prev.size() - 1; ++i)
+    for (size_t i = 1; i < prev.size(); ++i)
         json.EndObject();
 
     // End JSON document.
@@ -329,29 +349,16 @@ bool JsonSettings::writeFile(const std::filesystem::path& file, const Map& map,
 
     if (encrypted == Encrypted::YES)
     {
-        std::string cipher_buffer;
-
-        if (!OSCrypt::encryptString(source_buffer, &cipher_buffer))
+        if (!OSCrypt::encryptString(source_buffer, data))
         {
             LOG(LS_ERROR) << "Failed to encrypt config file";
             return false;
         }
-
-        if (!base::writeFile(file, cipher_buffer))
-        {
-            LOG(LS_ERROR) << "Failed to write config file";
-            return false;
-        }
     }
     else
     {
         DCHECK_EQ(encrypted, Encrypted::NO);
-
-        if (!base::writeFile(file, source_buffer))
-        {
-            LOG(LS_ERROR) << "Failed to write config file";
-            return false;
-        }
+        data->assign(source_buffer);
     }
 
     return true;
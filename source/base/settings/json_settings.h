@@ -40,7 +40,12 @@ public:
     ~JsonSettings();
 
     bool isWritable() const;
+
+    // Re-reads the settings from the file. Unsaved changes are lost.
     void sync();
+
+    // Writes the changed settings to the file and waits until they are written. If flush() is not
+    // called, the changed settings are written in the background after the object is destroyed.
     void flush();
 
     const std::filesystem::path& filePath() const { return path_; }
@@ -58,6 +63,8 @@ public:
                           Encrypted encrypted = Encrypted::NO);
 
 private:
+    static bool serialize(const Map& map, Encrypted encrypted, std::string* data);
+
     const Encrypted encrypted_;
     std::filesystem::path path_;
 
@@ -79,10 +79,12 @@ Settings Settings::getGroup(std::string_view key) const
     const std::string prefix = strCat({ key, kSeparator });
     Map map;
 
-    for (auto it = map_.cbegin(); it != map_.cend(); ++it)
+    // The keys of the group follow each other in the sorted map.
+    for (auto it = map_.lower_bound(prefix);
+         it != map_.cend() && startsWith(it->first, prefix);
+         ++it)
     {
-        if (startsWith(it->first, prefix))
-            map.insert_or_assign(it->first.substr(prefix.length()), it->second);
+        map.insert_or_assign(it->first.substr(prefix.length()), it->second);
     }
 
     return Settings(std::move(map));
@@ -102,13 +104,13 @@ void Settings::remove(std::string_view key)
 {
     const std::string prefix = strCat({ key, kSeparator });
 
-    for (auto it = map_.begin(); it != map_.end();)
-    {
-        if (startsWith(it->first, prefix))
-            it = map_.erase(it);
-        else
-            ++it;
-    }
+    auto first = map_.lower_bound(prefix);
+    auto last = first;
+
+    while (last != map_.end() && startsWith(last->first, prefix))
+        ++last;
+
+    map_.erase(first, last);
 
     is_changed_ = true;
 }
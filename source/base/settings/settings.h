@@ -20,29 +20,14 @@
 #define BASE__SETTINGS__SETTINGS_H
 
 #include "base/converter.h"
-
-#include <map>
+#include "base/settings/settings_map.h"
 
 namespace base {
 
-namespace internal {
-
-struct StringLess
-{
-    using is_transparent = void;
-
-    bool operator()(std::string_view lhs, std::string_view rhs) const
-    {
-        return lhs < rhs;
-    }
-};
-
-} // namespace internal
-
 class Settings
 {
 public:
-    using Map = std::map<std::string, std::string, internal::StringLess>;
+    using Map = SettingsMap;
     using Array = std::vector<Settings>;
 
     static const std::string_view kSeparator;
@@ -102,6 +87,9 @@ public:
 
     bool isChanged() const { return is_changed_; }
 
+protected:
+    void setChanged(bool changed) { is_changed_ = changed; }
+
 private:
     bool is_changed_ = false;
     Map map_;
@@ -0,0 +1,151 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__SETTINGS__SETTINGS_MAP_H
+#define BASE__SETTINGS__SETTINGS_MAP_H
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace base {
+
+// Ordered map of the settings stored in a sorted vector. Settings are loaded once and then looked
+// up many times, so a contiguous array is faster and smaller than a tree. The interface follows
+// std::map, keys are compared as strings and may be looked up by std::string_view.
+class SettingsMap
+{
+public:
+    using key_type = std::string;
+    using mapped_type = std::string;
+    using value_type = std::pair<std::string, std::string>;
+    using Container = std::vector<value_type>;
+    using iterator = Container::iterator;
+    using const_iterator = Container::const_iterator;
+    using size_type = Container::size_type;
+
+    SettingsMap() = default;
+
+    SettingsMap(const SettingsMap& other) = default;
+    SettingsMap& operator=(const SettingsMap& other) = default;
+
+    SettingsMap(SettingsMap&& other) noexcept = default;
+    SettingsMap& operator=(SettingsMap&& other) noexcept = default;
+
+    iterator begin() { return items_.begin(); }
+    iterator end() { return items_.end(); }
+    const_iterator begin() const { return items_.begin(); }
+    const_iterator end() const { return items_.end(); }
+    const_iterator cbegin() const { return items_.cbegin(); }
+    const_iterator cend() const { return items_.cend(); }
+
+    bool empty() const { return items_.empty(); }
+    size_type size() const { return items_.size(); }
+    void clear() { items_.clear(); }
+    void reserve(size_type size) { items_.reserve(size); }
+
+    iterator lower_bound(std::string_view key)
+    {
+        return std::lower_bound(items_.begin(), items_.end(), key, KeyLess());
+    }
+
+    const_iterator lower_bound(std::string_view key) const
+    {
+        return std::lower_bound(items_.cbegin(), items_.cend(), key, KeyLess());
+    }
+
+    iterator find(std::string_view key)
+    {
+        iterator it = lower_bound(key);
+        return (it != items_.end() && it->first == key) ? it : items_.end();
+    }
+
+    const_iterator find(std::string_view key) const
+    {
+        const_iterator it = lower_bound(key);
+        return (it != items_.cend() && it->first == key) ? it : items_.cend();
+    }
+
+    size_type count(std::string_view key) const { return find(key) != cend() ? 1 : 0; }
+
+    // Inserts the value if there is no such key yet. Does nothing otherwise.
+    std::pair<iterator, bool> emplace(std::string key, std::string value)
+    {
+        iterator it = insertPosition(key);
+        if (it != items_.end() && it->first == key)
+            return std::make_pair(it, false);
+
+        return std::make_pair(items_.emplace(it, std::move(key), std::move(value)), true);
+    }
+
+    // Inserts the value or replaces the value of an existing key.
+    std::pair<iterator, bool> insert_or_assign(std::string key, std::string value)
+    {
+        iterator it = insertPosition(key);
+        if (it != items_.end() && it->first == key)
+        {
+            it->second = std::move(value);
+            return std::make_pair(it, false);
+        }
+
+        return std::make_pair(items_.emplace(it, std::move(key), std::move(value)), true);
+    }
+
+    iterator erase(const_iterator pos) { return items_.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last) { return items_.erase(first, last); }
+
+    size_type erase(std::string_view key)
+    {
+        const_iterator it = find(key);
+        if (it == cend())
+            return 0;
+
+        items_.erase(it);
+        return 1;
+    }
+
+    bool operator==(const SettingsMap& other) const { return items_ == other.items_; }
+    bool operator!=(const SettingsMap& other) const { return items_ != other.items_; }
+
+private:
+    struct KeyLess
+    {
+        bool operator()(const value_type& lhs, std::string_view rhs) const
+        {
+            return std::string_view(lhs.first) < rhs;
+        }
+    };
+
+    iterator insertPosition(std::string_view key)
+    {
+        // Settings files and groups are written in the order of the keys, so when they are loaded
+        // each key goes to the end of the array.
+        if (items_.empty() || std::string_view(items_.back().first) < key)
+            return items_.end();
+
+        return lower_bound(key);
+    }
+
+    Container items_;
+};
+
+} // namespace base
+
+#endif // BASE__SETTINGS__SETTINGS_MAP_H
@@ -0,0 +1,96 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/settings/settings.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(SettingsMapTest, InsertAndFind)
+{
+    SettingsMap map;
+
+    EXPECT_TRUE(map.insert_or_assign("b", "2").second);
+    EXPECT_TRUE(map.insert_or_assign("a", "1").second);
+    EXPECT_TRUE(map.insert_or_assign("c", "3").second);
+    EXPECT_FALSE(map.insert_or_assign("b", "22").second);
+
+    EXPECT_TRUE(map.emplace("d", "4").second);
+    EXPECT_FALSE(map.emplace("a", "11").second);
+
+    ASSERT_EQ(map.size(), 4u);
+
+    // The keys are sorted regardless of the insertion order.
+    std::vector<std::string> keys;
+    for (const auto& item : map)
+        keys.emplace_back(item.first);
+    EXPECT_EQ(keys, std::vector<std::string>({ "a", "b", "c", "d" }));
+
+    EXPECT_EQ(map.find("a")->second, "1");
+    EXPECT_EQ(map.find("b")->second, "22");
+    EXPECT_EQ(map.find(std::string_view("cd", 1))->second, "3");
+    EXPECT_EQ(map.find("e"), map.end());
+    EXPECT_EQ(map.find(""), map.end());
+    EXPECT_EQ(map.count("d"), 1u);
+}
+
+TEST(SettingsMapTest, Erase)
+{
+    SettingsMap map;
+    map.insert_or_assign("a", "1");
+    map.insert_or_assign("b", "2");
+    map.insert_or_assign("c", "3");
+
+    EXPECT_EQ(map.erase("b"), 1u);
+    EXPECT_EQ(map.erase("b"), 0u);
+    EXPECT_EQ(map.find("b"), map.end());
+
+    auto it = map.erase(map.find("a"));
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(it->first, "c");
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(SettingsMapTest, Groups)
+{
+    Settings settings;
+    settings.set<int>("Group/A", 1);
+    settings.set<int>("Group/B", 2);
+    settings.set<int>("Group/Sub/C", 3);
+    settings.set<int>("Group0", 4);
+    settings.set<int>("Grou", 5);
+    settings.set<int>("Other/A", 6);
+
+    Settings group = settings.getGroup("Group");
+    EXPECT_EQ(group.constMap().size(), 3u);
+    EXPECT_EQ(group.get<int>("A"), 1);
+    EXPECT_EQ(group.get<int>("B"), 2);
+    EXPECT_EQ(group.get<int>("Sub/C"), 3);
+
+    settings.remove("Group");
+    EXPECT_EQ(settings.constMap().size(), 3u);
+    EXPECT_EQ(settings.get<int>("Group0"), 4);
+    EXPECT_EQ(settings.get<int>("Grou"), 5);
+    EXPECT_EQ(settings.get<int>("Other/A"), 6);
+    EXPECT_EQ(settings.get<int>("Group/A", -1), -1);
+}
+
+} // namespace base
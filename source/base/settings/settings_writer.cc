@@ -0,0 +1,185 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/settings/settings_writer.h"
+
+#include "base/logging.h"
+#include "base/files/file_util.h"
+
+namespace base {
+
+// static
+const std::chrono::milliseconds SettingsWriter::kWriteDelay { 500 };
+
+SettingsWriter::SettingsWriter()
+{
+    thread_ = std::thread(&SettingsWriter::run, this);
+}
+
+SettingsWriter::~SettingsWriter()
+{
+    {
+        std::scoped_lock lock(lock_);
+        stopping_ = true;
+    }
+
+    // The thread writes all pending data before it exits.
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+// static
+SettingsWriter* SettingsWriter::instance()
+{
+    // The destructor writes the remaining data only if the thread of the writer is still running
+    // at exit. It is not in a shared library on Windows, so the applications call flushAll()
+    // before they exit.
+    static SettingsWriter writer;
+    return &writer;
+}
+
+void SettingsWriter::write(const std::filesystem::path& file, std::string&& data)
+{
+    {
+        std::scoped_lock lock(lock_);
+
+        auto result = pending_.try_emplace(file);
+        PendingWrite& pending = result.first->second;
+
+        // The deadline is not moved by subsequent writes, so a file which is changed all the time
+        // is still written every kWriteDelay.
+        if (result.second)
+            pending.deadline = std::chrono::steady_clock::now() + kWriteDelay;
+
+        pending.data = std::move(data);
+    }
+
+    wakeup_.notify_one();
+}
+
+bool SettingsWriter::flush(const std::filesystem::path& file)
+{
+    std::unique_lock lock(lock_);
+
+    // The writer thread may be writing older data of the same file right now.
+    written_.wait(lock, [&]() { return writing_.count(file) == 0; });
+
+    auto it = pending_.find(file);
+    if (it == pending_.end())
+        return true;
+
+    std::string data = std::move(it->second.data);
+    pending_.erase(it);
+    writing_.insert(file);
+    lock.unlock();
+
+    // The data is written on the calling thread, the caller waits for it anyway.
+    bool result = writeData(file, data);
+
+    lock.lock();
+    writing_.erase(file);
+    lock.unlock();
+
+    written_.notify_all();
+    return result;
+}
+
+void SettingsWriter::flushAll()
+{
+    std::unique_lock lock(lock_);
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (auto& pending : pending_)
+        pending.second.deadline = now;
+
+    wakeup_.notify_one();
+    written_.wait(lock, [this]() { return pending_.empty() && writing_.empty(); });
+}
+
+void SettingsWriter::run()
+{
+    std::unique_lock lock(lock_);
+
+    while (true)
+    {
+        if (pending_.empty())
+        {
+            if (stopping_)
+                break;
+
+            wakeup_.wait(lock);
+            continue;
+        }
+
+        auto next = std::min_element(pending_.begin(), pending_.end(),
+            [](const PendingMap::value_type& lhs, const PendingMap::value_type& rhs)
+        {
+            return lhs.second.deadline < rhs.second.deadline;
+        });
+
+        if (!stopping_ && std::chrono::steady_clock::now() < next->second.deadline)
+        {
+            wakeup_.wait_until(lock, next->second.deadline);
+            continue;
+        }
+
+        if (writing_.count(next->first) != 0)
+        {
+            // The file is being written by flush() on another thread.
+            written_.wait(lock);
+            continue;
+        }
+
+        std::filesystem::path file = next->first;
+        std::string data = std::move(next->second.data);
+
+        pending_.erase(next);
+        writing_.insert(file);
+        lock.unlock();
+
+        writeData(file, data);
+
+        lock.lock();
+        writing_.erase(file);
+        written_.notify_all();
+    }
+}
+
+// static
+bool SettingsWriter::writeData(const std::filesystem::path& file, const std::string& data)
+{
+    std::error_code error_code;
+    if (!std::filesystem::create_directories(file.parent_path(), error_code))
+    {
+        if (error_code)
+        {
+            LOG(LS_ERROR) << "Unable to create directory for config file: " << error_code.message();
+            return false;
+        }
+    }
+
+    if (!writeFileAtomically(file, data))
+    {
+        LOG(LS_ERROR) << "Failed to write config file: " << file;
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace base
@@ -0,0 +1,85 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__SETTINGS__SETTINGS_WRITER_H
+#define BASE__SETTINGS__SETTINGS_WRITER_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace base {
+
+// Writes settings files on a background thread. Writes of the same file which follow each other
+// within kWriteDelay are merged and only the latest contents are written. Files are replaced
+// atomically (see writeFileAtomically), so a crash or a concurrent reader never sees a partially
+// written file. All methods can be called from any thread.
+class SettingsWriter
+{
+public:
+    static const std::chrono::milliseconds kWriteDelay;
+
+    static SettingsWriter* instance();
+
+    // Schedules writing |data| to |file|. Replaces the data scheduled for the file earlier.
+    void write(const std::filesystem::path& file, std::string&& data);
+
+    // Writes the data scheduled for |file| right now and waits until all writes of the file are
+    // completed. Returns false if the write failed. Returns true if nothing was scheduled.
+    bool flush(const std::filesystem::path& file);
+
+    // Writes all scheduled data and waits until it is written. The applications call it before
+    // exit (see instance()).
+    void flushAll();
+
+private:
+    SettingsWriter();
+    ~SettingsWriter();
+
+    struct PendingWrite
+    {
+        std::string data;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    using PendingMap = std::map<std::filesystem::path, PendingWrite>;
+
+    void run();
+    static bool writeData(const std::filesystem::path& file, const std::string& data);
+
+    std::mutex lock_;
+    std::condition_variable wakeup_;
+    std::condition_variable written_;
+    PendingMap pending_;
+    std::set<std::filesystem::path> writing_;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    DISALLOW_COPY_AND_ASSIGN(SettingsWriter);
+};
+
+} // namespace base
+
+#endif // BASE__SETTINGS__SETTINGS_WRITER_H
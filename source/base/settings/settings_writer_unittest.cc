@@ -0,0 +1,127 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/settings/settings_writer.h"
+
+#include "base/files/base_paths.h"
+#include "base/files/file_util.h"
+#include "base/settings/json_settings.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+namespace {
+
+std::filesystem::path testFilePath()
+{
+    std::filesystem::path file_path;
+    EXPECT_TRUE(BasePaths::userAppData(&file_path));
+    file_path.append("test_settings_writer");
+    file_path.append("temp.txt");
+    return file_path;
+}
+
+void removeFile(const std::filesystem::path& file_path)
+{
+    std::error_code ignored_code;
+    std::filesystem::remove_all(file_path.parent_path(), ignored_code);
+}
+
+} // namespace
+
+TEST(SettingsWriterTest, WritesLatestData)
+{
+    std::filesystem::path file_path = testFilePath();
+    SettingsWriter* writer = SettingsWriter::instance();
+
+    writer->write(file_path, "first");
+    writer->write(file_path, "second");
+    EXPECT_TRUE(writer->flush(file_path));
+
+    std::string data;
+    EXPECT_TRUE(readFile(file_path, &data));
+    EXPECT_EQ(data, "second");
+
+    // Nothing is scheduled.
+    EXPECT_TRUE(writer->flush(file_path));
+
+    // The data is written in the background.
+    writer->write(file_path, "third");
+    writer->flushAll();
+
+    EXPECT_TRUE(readFile(file_path, &data));
+    EXPECT_EQ(data, "third");
+
+    // Only the target file is left in the directory.
+    size_t count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(file_path.parent_path()))
+    {
+        EXPECT_EQ(entry.path().filename(), file_path.filename());
+        ++count;
+    }
+    EXPECT_EQ(count, 1u);
+
+    removeFile(file_path);
+}
+
+TEST(SettingsWriterTest, ReadAfterDestroy)
+{
+    std::filesystem::path file_path;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        {
+            JsonSettings settings(JsonSettings::Scope::USER, "test_settings_writer", "temp");
+            file_path = settings.filePath();
+
+            EXPECT_EQ(settings.get<int>("Counter"), i);
+            EXPECT_FALSE(settings.isChanged());
+
+            settings.set<int>("Counter", i + 1);
+        }
+
+        // The file is not written yet, but readFile() waits for it.
+        JsonSettings::Map map;
+        EXPECT_TRUE(JsonSettings::readFile(file_path, map));
+        EXPECT_EQ(map.size(), 1u);
+    }
+
+    removeFile(file_path);
+}
+
+TEST(SettingsWriterTest, FlushSkipsUnchanged)
+{
+    JsonSettings settings(JsonSettings::Scope::USER, "test_settings_writer", "temp");
+    std::filesystem::path file_path = settings.filePath();
+
+    // Nothing is changed, the file is not created.
+    settings.flush();
+    std::error_code ignored_code;
+    EXPECT_FALSE(std::filesystem::exists(file_path, ignored_code));
+
+    settings.set<int>("Value", 1);
+    EXPECT_TRUE(settings.isChanged());
+    settings.flush();
+    EXPECT_FALSE(settings.isChanged());
+    EXPECT_TRUE(std::filesystem::exists(file_path, ignored_code));
+
+    removeFile(file_path);
+}
+
+} // namespace base
@@ -23,6 +23,7 @@
 #include "base/files/base_paths.h"
 #include "base/files/file_util.h"
 #include "base/files/scoped_temp_file.h"
+#include "base/settings/settings_writer.h"
 #include "base/strings/string_split.h"
 
 #include <rapidxml/rapidxml.hpp>
@@ -111,8 +112,11 @@ XmlSettings::XmlSettings(Scope scope,
 
 XmlSettings::~XmlSettings()
 {
-    if (isChanged())
-        writeFile(path_, constMap());
+    if (!isChanged() || path_.empty())
+        return;
+
+    // The file is written in the background, the next readFile() of the file waits for it.
+    SettingsWriter::instance()->write(path_, serialize(constMap()));
 }
 
 bool XmlSettings::isWritable() const
@@ -140,12 +144,17 @@ bool XmlSettings::isWritable() const
 
 void XmlSettings::sync()
 {
-    readFile(path_, map());
+    if (readFile(path_, map()))
+        setChanged(false);
 }
 
 void XmlSettings::flush()
 {
-    writeFile(path_, map());
+    if (!isChanged())
+        return;
+
+    if (writeFile(path_, constMap()))
+        setChanged(false);
 }
 
 // static
@@ -204,6 +213,9 @@ bool XmlSettings::readFile(const std::filesystem::path& file, Map& map)
 {
     map.clear();
 
+    // Settings destroyed earlier may not have been written to the file yet.
+    SettingsWriter::instance()->flush(file);
+
     std::string buffer;
     if (!base::readFile(file, &buffer))
         return false;
@@ -240,14 +252,15 @@ bool XmlSettings::readFile(const std::filesystem::path& file, Map& map)
 // static
 bool XmlSettings::writeFile(const std::filesystem::path& file, const Map& map)
 {
-    std::error_code error_code;
-
-    if (!std::filesystem::create_directories(file.parent_path(), error_code))
-    {
-        if (error_code)
-            return false;
-    }
+    // The write goes through the writer, so it is not overtaken by an older write of the file.
+    SettingsWriter* writer = SettingsWriter::instance();
+    writer->write(file, serialize(map));
+    return writer->flush(file);
+}
 
+// static
+std::string XmlSettings::serialize(const Map& map)
+{
     std::stringstream string_stream;
 
     XmlSaxWriter xml(string_stream);
@@ -289,16 +302,7 @@ bool XmlSettings::writeFile(const std::filesystem::path& file, const Map& map)
     xml.endElement();
     xml.endDocument();
 
-    std::ofstream file_stream;
-
-    file_stream.open(file, std::ofstream::binary | std::ofstream::out | std::ofstream::trunc);
-    if (!file_stream.is_open())
-        return false;
-
-    // It is necessary to write a file in one operation.
-    file_stream << string_stream.str();
-
-    return !file_stream.fail();
+    return string_stream.str();
 }
 
 } // namespace base
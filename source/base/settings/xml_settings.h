@@ -38,7 +38,12 @@ public:
     ~XmlSettings();
 
     bool isWritable() const;
+
+    // Re-reads the settings from the file. Unsaved changes are lost.
     void sync();
+
+    // Writes the changed settings to the file and waits until they are written. If flush() is not
+    // called, the changed settings are written in the background after the object is destroyed.
     void flush();
 
     const std::filesystem::path& filePath() const { return path_; }
@@ -52,6 +57,8 @@ public:
     static bool writeFile(const std::filesystem::path& file, const Map& map);
 
 private:
+    static std::string serialize(const Map& map);
+
     std::filesystem::path path_;
 
     DISALLOW_COPY_AND_ASSIGN(XmlSettings);
@@ -20,19 +20,282 @@
 
 #include "base/logging.h"
 
+#include <cstring>
+
+#if defined(ARCH_CPU_X86_64)
+#include <emmintrin.h>
+#elif defined(ARCH_CPU_ARM64)
+#include <arm_neon.h>
+#endif // defined(ARCH_CPU_*)
+
 #if defined(OS_WIN)
 #include <Windows.h>
 #endif // defined(OS_WIN)
 
-#if defined(OS_LINUX) || defined(OS_MAC)
-#include <unicode/utypes.h>
-#include <unicode/ustring.h>
-#endif // OS_POSIX || OS_MAC
-
 namespace base {
 
 namespace {
 
+// Converts the leading ASCII characters of |in| (up to |size| of them) and returns their count.
+// Only whole blocks are converted, the caller converts the rest.
+size_t asciiToUtf16Block(const uint8_t* in, size_t size, char16_t* out)
+{
+    size_t count = 0;
+
+#if defined(ARCH_CPU_X86_64)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; count + 16 <= size; count += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + count));
+        if (_mm_movemask_epi8(bytes))
+            break;
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + count), _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + count + 8),
+                         _mm_unpackhi_epi8(bytes, zero));
+    }
+#elif defined(ARCH_CPU_ARM64)
+    for (; count + 16 <= size; count += 16)
+    {
+        const uint8x16_t bytes = vld1q_u8(in + count);
+        if (vmaxvq_u8(bytes) >= 0x80)
+            break;
+
+        vst1q_u16(reinterpret_cast<uint16_t*>(out + count), vmovl_u8(vget_low_u8(bytes)));
+        vst1q_u16(reinterpret_cast<uint16_t*>(out + count + 8), vmovl_high_u8(bytes));
+    }
+#else
+    for (; count + 8 <= size; count += 8)
+    {
+        uint64_t bytes;
+        memcpy(&bytes, in + count, sizeof(bytes));
+        if (bytes & 0x8080808080808080ULL)
+            break;
+
+        for (size_t i = 0; i < 8; ++i)
+            out[count + i] = static_cast<char16_t>(in[count + i]);
+    }
+#endif // defined(ARCH_CPU_*)
+
+    return count;
+}
+
+// Converts the leading ASCII characters of |in| (up to |size| of them) and returns their count.
+// Only whole blocks are converted, the caller converts the rest.
+size_t asciiFromUtf16Block(const char16_t* in, size_t size, uint8_t* out)
+{
+    size_t count = 0;
+
+#if defined(ARCH_CPU_X86_64)
+    const __m128i non_ascii_mask = _mm_set1_epi16(static_cast<int16_t>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; count + 16 <= size; count += 16)
+    {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + count));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + count + 8));
+        const __m128i non_ascii = _mm_and_si128(_mm_or_si128(low, high), non_ascii_mask);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xFFFF)
+            break;
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + count), _mm_packus_epi16(low, high));
+    }
+#elif defined(ARCH_CPU_ARM64)
+    for (; count + 16 <= size; count += 16)
+    {
+        const uint16x8_t low = vld1q_u16(reinterpret_cast<const uint16_t*>(in + count));
+        const uint16x8_t high = vld1q_u16(reinterpret_cast<const uint16_t*>(in + count + 8));
+        if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80)
+            break;
+
+        vst1q_u8(out + count, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+    }
+#else
+    for (; count + 4 <= size; count += 4)
+    {
+        uint64_t units;
+        memcpy(&units, in + count, sizeof(units));
+        if (units & 0xFF80FF80FF80FF80ULL)
+            break;
+
+        for (size_t i = 0; i < 4; ++i)
+            out[count + i] = static_cast<uint8_t>(in[count + i]);
+    }
+#endif // defined(ARCH_CPU_*)
+
+    return count;
+}
+
+bool isTrailByte(uint8_t byte)
+{
+    return (byte & 0xC0) == 0x80;
+}
+
+// The conversion is done in one pass into the output string. Strings are mostly ASCII, so the
+// ASCII characters are converted by blocks. Invalid input (overlong forms, surrogates, truncated
+// sequences, code points above U+10FFFF) fails the conversion.
+bool utf8ToUtf16Impl(std::string_view in, std::u16string* out)
+{
+    out->clear();
+
+    if (in.empty())
+        return true;
+
+    // A UTF-8 string never has fewer bytes than UTF-16 code units.
+    out->resize(in.size());
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(in.data());
+    const uint8_t* end = src + in.size();
+    char16_t* dst = out->data();
+
+    while (src < end)
+    {
+        const size_t ascii = asciiToUtf16Block(src, static_cast<size_t>(end - src), dst);
+        src += ascii;
+        dst += ascii;
+
+        if (src == end)
+            break;
+
+        const uint8_t lead = *src;
+        const size_t remaining = static_cast<size_t>(end - src);
+
+        if (lead < 0x80)
+        {
+            *dst++ = lead;
+            src += 1;
+        }
+        else if (lead >= 0xC2 && lead <= 0xDF)
+        {
+            if (remaining < 2 || !isTrailByte(src[1]))
+                return false;
+
+            *dst++ = static_cast<char16_t>(((lead & 0x1F) << 6) | (src[1] & 0x3F));
+            src += 2;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            if (remaining < 3 || !isTrailByte(src[1]) || !isTrailByte(src[2]))
+                return false;
+
+            // Overlong forms and surrogates.
+            if ((lead == 0xE0 && src[1] < 0xA0) || (lead == 0xED && src[1] > 0x9F))
+                return false;
+
+            *dst++ = static_cast<char16_t>(
+                ((lead & 0x0F) << 12) | ((src[1] & 0x3F) << 6) | (src[2] & 0x3F));
+            src += 3;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            if (remaining < 4 || !isTrailByte(src[1]) || !isTrailByte(src[2]) ||
+                !isTrailByte(src[3]))
+            {
+                return false;
+            }
+
+            // Overlong forms and code points above U+10FFFF.
+            if ((lead == 0xF0 && src[1] < 0x90) || (lead == 0xF4 && src[1] > 0x8F))
+                return false;
+
+            const uint32_t code_point = ((lead & 0x07) << 18) | ((src[1] & 0x3F) << 12) |
+                ((src[2] & 0x3F) << 6) | (src[3] & 0x3F);
+
+            *dst++ = static_cast<char16_t>(0xD800 + ((code_point - 0x10000) >> 10));
+            *dst++ = static_cast<char16_t>(0xDC00 + ((code_point - 0x10000) & 0x3FF));
+            src += 4;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    out->resize(static_cast<size_t>(dst - out->data()));
+    return true;
+}
+
+// See utf8ToUtf16Impl. Unpaired surrogates fail the conversion.
+bool utf16ToUtf8Impl(std::u16string_view in, std::string* out)
+{
+    out->clear();
+
+    if (in.empty())
+        return true;
+
+    // Enough for an ASCII string. The string grows once when the first non-ASCII character is met.
+    out->resize(in.size());
+    bool grown = false;
+
+    const char16_t* src = in.data();
+    const char16_t* end = src + in.size();
+    size_t pos = 0;
+
+    while (src < end)
+    {
+        const size_t ascii = asciiFromUtf16Block(
+            src, static_cast<size_t>(end - src), reinterpret_cast<uint8_t*>(out->data() + pos));
+        src += ascii;
+        pos += ascii;
+
+        if (src == end)
+            break;
+
+        const char16_t unit = *src;
+        if (unit < 0x80)
+        {
+            (*out)[pos++] = static_cast<char>(unit);
+            src += 1;
+            continue;
+        }
+
+        if (!grown)
+        {
+            // Each of the remaining code units takes at most 3 bytes (a surrogate pair takes 4).
+            out->resize(pos + static_cast<size_t>(end - src) * 3);
+            grown = true;
+        }
+
+        uint8_t* dst = reinterpret_cast<uint8_t*>(out->data() + pos);
+
+        if (unit < 0x800)
+        {
+            dst[0] = static_cast<uint8_t>(0xC0 | (unit >> 6));
+            dst[1] = static_cast<uint8_t>(0x80 | (unit & 0x3F));
+            pos += 2;
+            src += 1;
+        }
+        else if (unit < 0xD800 || unit > 0xDFFF)
+        {
+            dst[0] = static_cast<uint8_t>(0xE0 | (unit >> 12));
+            dst[1] = static_cast<uint8_t>(0x80 | ((unit >> 6) & 0x3F));
+            dst[2] = static_cast<uint8_t>(0x80 | (unit & 0x3F));
+            pos += 3;
+            src += 1;
+        }
+        else
+        {
+            // A high surrogate must be followed by a low surrogate.
+            if (unit > 0xDBFF || end - src < 2 || src[1] < 0xDC00 || src[1] > 0xDFFF)
+                return false;
+
+            const uint32_t code_point = 0x10000 + ((unit - 0xD800) << 10) + (src[1] - 0xDC00);
+
+            dst[0] = static_cast<uint8_t>(0xF0 | (code_point >> 18));
+            dst[1] = static_cast<uint8_t>(0x80 | ((code_point >> 12) & 0x3F));
+            dst[2] = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3F));
+            dst[3] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+            pos += 4;
+            src += 2;
+        }
+    }
+
+    out->resize(pos);
+    return true;
+}
+
 #if defined(OS_WIN)
 
 template <class InputType>
@@ -145,52 +408,6 @@ bool utf8ToWideImpl(std::string_view in, OutputType* out)
 
 #else
 
-bool utf16ToUtf8Impl(std::u16string_view in, std::string* out)
-{
-    out->clear();
-
-    if (!in.length())
-        return true;
-
-    UErrorCode error_code = U_ZERO_ERROR;
-    int32_t out_len = 0;
-    u_strToUTF8(nullptr, 0, &out_len, in.data(), in.length(), &error_code);
-    if (error_code != U_BUFFER_OVERFLOW_ERROR || out_len <= 0)
-        return false;
-
-    error_code = U_ZERO_ERROR;
-    out->resize(out_len);
-
-    u_strToUTF8(out->data(), out->length(), &out_len, in.data(), in.length(), &error_code);
-    if (!U_SUCCESS(error_code) || out_len <= 0)
-        return false;
-
-    return true;
-}
-
-bool utf8ToUtf16Impl(std::string_view in, std::u16string* out)
-{
-    out->clear();
-
-    if (!in.length())
-        return true;
-
-    UErrorCode error_code = U_ZERO_ERROR;
-    int32_t out_len = 0;
-    u_strFromUTF8(nullptr, 0, &out_len, in.data(), in.length(), &error_code);
-    if (error_code != U_BUFFER_OVERFLOW_ERROR || out_len <= 0)
-        return false;
-
-    error_code = U_ZERO_ERROR;
-    out->resize(out_len);
-
-    u_strFromUTF8(out->data(), out->length(), &out_len, in.data(), in.length(), &error_code);
-    if (!U_SUCCESS(error_code) || out_len <= 0)
-        return false;
-
-    return true;
-}
-
 bool utf16ToLocalImpl(std::u16string_view in, std::string* out)
 {
     return utf16ToUtf8Impl(in, out);
@@ -219,20 +436,12 @@ OutputString asciiConverter(InputString in)
 
 bool utf16ToUtf8(std::u16string_view in, std::string* out)
 {
-#if defined(WCHAR_T_IS_UTF16)
-    return wideToUtf8Impl(in, out);
-#else
     return utf16ToUtf8Impl(in, out);
-#endif
 }
 
 bool utf8ToUtf16(std::string_view in, std::u16string* out)
 {
-#if defined(WCHAR_T_IS_UTF16)
-    return utf8ToWideImpl(in, out);
-#else
     return utf8ToUtf16Impl(in, out);
-#endif
 }
 
 std::u16string utf16FromUtf8(std::string_view in)
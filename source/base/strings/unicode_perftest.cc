@@ -0,0 +1,81 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/strings/unicode.h"
+
+#include <benchmark/benchmark.h>
+
+namespace base {
+
+namespace {
+
+std::u16string makeText(const char16_t* pattern)
+{
+    std::u16string text;
+    while (text.size() < 65536)
+        text += pattern;
+    return text;
+}
+
+void BM_Utf8FromUtf16Ascii(benchmark::State& state)
+{
+    const std::u16string input = makeText(u"C:\\Users\\User\\Documents\\report_");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utf8FromUtf16(input));
+
+    state.SetBytesProcessed(state.iterations() * input.size() * sizeof(char16_t));
+}
+BENCHMARK(BM_Utf8FromUtf16Ascii);
+
+void BM_Utf8FromUtf16Mixed(benchmark::State& state)
+{
+    const std::u16string input = makeText(u"C:\\Пользователи\\Документы\\отчёт_");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utf8FromUtf16(input));
+
+    state.SetBytesProcessed(state.iterations() * input.size() * sizeof(char16_t));
+}
+BENCHMARK(BM_Utf8FromUtf16Mixed);
+
+void BM_Utf16FromUtf8Ascii(benchmark::State& state)
+{
+    const std::string input = utf8FromUtf16(makeText(u"C:\\Users\\User\\Documents\\report_"));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utf16FromUtf8(input));
+
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Utf16FromUtf8Ascii);
+
+void BM_Utf16FromUtf8Mixed(benchmark::State& state)
+{
+    const std::string input = utf8FromUtf16(makeText(u"C:\\Пользователи\\Документы\\отчёт_"));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(utf16FromUtf8(input));
+
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Utf16FromUtf8Mixed);
+
+} // namespace
+
+} // namespace base
@@ -0,0 +1,144 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/strings/unicode.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(UnicodeTest, Empty)
+{
+    std::u16string utf16 = u"x";
+    EXPECT_TRUE(utf8ToUtf16("", &utf16));
+    EXPECT_TRUE(utf16.empty());
+
+    std::string utf8 = "x";
+    EXPECT_TRUE(utf16ToUtf8(u"", &utf8));
+    EXPECT_TRUE(utf8.empty());
+}
+
+TEST(UnicodeTest, Ascii)
+{
+    // All lengths around the block sizes of the fast path.
+    for (size_t size = 0; size < 100; ++size)
+    {
+        std::string utf8;
+        std::u16string utf16;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            utf8 += static_cast<char>(0x20 + (i * 7) % 0x5F);
+            utf16 += static_cast<char16_t>(0x20 + (i * 7) % 0x5F);
+        }
+
+        EXPECT_EQ(utf16FromUtf8(utf8), utf16);
+        EXPECT_EQ(utf8FromUtf16(utf16), utf8);
+    }
+}
+
+TEST(UnicodeTest, Mixed)
+{
+    const std::string utf8 =
+        "Address book \xD0\x90\xD0\xB4\xD1\x80\xD0\xB5\xD1\x81 \xE4\xB8\xAD\xE6\x96\x87 "
+        "\xF0\x9F\x98\x80 and a long ASCII tail after the non-ASCII characters";
+    const std::u16string utf16 =
+        u"Address book Адрес 中文 "
+        u"\U0001F600 and a long ASCII tail after the non-ASCII characters";
+
+    EXPECT_EQ(utf16FromUtf8(utf8), utf16);
+    EXPECT_EQ(utf8FromUtf16(utf16), utf8);
+
+    // Non-ASCII characters at every position relative to the blocks.
+    for (size_t i = 0; i < 40; ++i)
+    {
+        std::u16string text(40, u'a');
+        text[i] = u'é';
+
+        EXPECT_EQ(utf16FromUtf8(utf8FromUtf16(text)), text) << "Position " << i;
+    }
+}
+
+TEST(UnicodeTest, AllCodePoints)
+{
+    std::u16string utf16;
+
+    for (char32_t code_point = 0; code_point <= 0x10FFFF; ++code_point)
+    {
+        if (code_point >= 0xD800 && code_point <= 0xDFFF)
+            continue;
+
+        if (code_point < 0x10000)
+        {
+            utf16 += static_cast<char16_t>(code_point);
+        }
+        else
+        {
+            utf16 += static_cast<char16_t>(0xD800 + ((code_point - 0x10000) >> 10));
+            utf16 += static_cast<char16_t>(0xDC00 + ((code_point - 0x10000) & 0x3FF));
+        }
+    }
+
+    std::string utf8;
+    ASSERT_TRUE(utf16ToUtf8(utf16, &utf8));
+
+    std::u16string result;
+    ASSERT_TRUE(utf8ToUtf16(utf8, &result));
+    EXPECT_EQ(result, utf16);
+}
+
+TEST(UnicodeTest, InvalidUtf8)
+{
+    const char* kInvalid[] =
+    {
+        "\x80",                 // Unexpected continuation byte.
+        "abc\xC3",              // Truncated sequence.
+        "\xC3\x28",             // Invalid continuation byte.
+        "\xC0\xAF",             // Overlong form.
+        "\xE0\x80\xAF",         // Overlong form.
+        "\xED\xA0\x80",         // Surrogate.
+        "\xF4\x90\x80\x80",     // Above U+10FFFF.
+        "\xF8\x88\x80\x80\x80", // Five bytes.
+        "\xFF"
+    };
+
+    for (const char* input : kInvalid)
+    {
+        std::u16string out;
+        EXPECT_FALSE(utf8ToUtf16(input, &out)) << input;
+    }
+}
+
+TEST(UnicodeTest, InvalidUtf16)
+{
+    const std::u16string kInvalid[] =
+    {
+        std::u16string(1, static_cast<char16_t>(0xD800)),
+        std::u16string(1, static_cast<char16_t>(0xDC00)),
+        u"abc" + std::u16string(1, static_cast<char16_t>(0xD83D)) + u"def",
+        std::u16string(2, static_cast<char16_t>(0xDE00))
+    };
+
+    for (const std::u16string& input : kInvalid)
+    {
+        std::string out;
+        EXPECT_FALSE(utf16ToUtf8(input, &out));
+    }
+}
+
+} // namespace base
@@ -59,6 +59,16 @@ private:
 
 } // namespace
 
+void TaskRunner::postPriorityTask(Callback task, Priority /* priority */)
+{
+    postTask(std::move(task));
+}
+
+void TaskRunner::postCoarseDelayedTask(Callback callback, const Milliseconds& delay)
+{
+    postDelayedTask(std::move(callback), delay);
+}
+
 void TaskRunner::deleteSoonInternal(void(*deleter)(const void*), const void* object)
 {
     postNonNestableTask(
@@ -19,8 +19,9 @@
 #ifndef BASE__TASK_RUNNER_H
 #define BASE__TASK_RUNNER_H
 
+#include "base/unique_function.h"
+
 #include <chrono>
-#include <functional>
 #include <memory>
 
 namespace base {
@@ -30,12 +31,32 @@ class TaskRunner : public std::enable_shared_from_this<TaskRunner>
 public:
     virtual ~TaskRunner() = default;
 
-    using Callback = std::function<void()>;
+    // Tasks are move-only and small tasks are posted without a heap allocation.
+    using Callback = UniqueFunction<void()>;
     using Milliseconds = std::chrono::milliseconds;
 
+    // Tasks with a higher priority are run before the queued tasks with a lower priority. The
+    // order of tasks with the same priority is preserved.
+    enum class Priority
+    {
+        HIGH,   // Latency-sensitive tasks (for example, input events).
+        NORMAL, // Default priority (for example, video).
+        LOW     // Bulk work which can wait (for example, file operations).
+    };
+
     virtual bool belongsToCurrentThread() const = 0;
     virtual void postTask(Callback task) = 0;
+
+    // Task runners which do not support priorities run the task as posted by postTask.
+    virtual void postPriorityTask(Callback task, Priority priority);
+
     virtual void postDelayedTask(Callback callback, const Milliseconds& delay) = 0;
+
+    // Posts a delayed task which does not need to run at the exact time (see timer_slack.h). The
+    // task can be delayed by up to timerSlack(delay) to share a wakeup with other coarse tasks.
+    // Task runners which do not support coarse tasks run the task as posted by postDelayedTask.
+    virtual void postCoarseDelayedTask(Callback callback, const Milliseconds& delay);
+
     virtual void postNonNestableTask(Callback callback) = 0;
     virtual void postNonNestableDelayedTask(Callback callback, const Milliseconds& delay) = 0;
     virtual void postQuit() = 0;
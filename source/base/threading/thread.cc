@@ -31,6 +31,12 @@ Thread::~Thread()
     stop();
 }
 
+void Thread::setProfile(ThreadProfile profile)
+{
+    DCHECK(state_ == State::STOPPED);
+    profile_ = profile;
+}
+
 void Thread::start(MessageLoop::Type message_loop_type, Delegate* delegate)
 {
     DCHECK(!message_loop_);
@@ -67,7 +73,8 @@ void Thread::stop()
     stopSoon();
 
 #if defined(OS_WIN)
-    if (message_loop_ && message_loop_->type() == MessageLoop::Type::WIN)
+    if (message_loop_ && (message_loop_->type() == MessageLoop::Type::WIN ||
+                          message_loop_->type() == MessageLoop::Type::WIN_ASIO))
         PostThreadMessageW(thread_id_, WM_QUIT, 0, 0);
 #endif // defined(OS_WIN)
 
@@ -112,6 +119,8 @@ void Thread::threadMain(MessageLoop::Type message_loop_type)
     thread_id_ = GetCurrentThreadId();
 #endif // defined(OS_WIN)
 
+    ScopedThreadProfile thread_profile(profile_);
+
     // Let the thread do extra initialization.
     // Let's do this before signaling we are started.
     if (delegate_)
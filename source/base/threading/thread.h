@@ -20,6 +20,7 @@
 #define BASE__THREADING__THREAD_H
 
 #include "base/message_loop/message_loop.h"
+#include "base/threading/thread_profile.h"
 #include "build/build_config.h"
 
 #include <atomic>
@@ -54,6 +55,9 @@ public:
         }
     };
 
+    // Sets the scheduling profile of the thread. Must be called before start.
+    void setProfile(ThreadProfile profile);
+
     // Starts the thread.
     void start(MessageLoop::Type message_loop_type, Delegate* delegate = nullptr);
 
@@ -98,6 +102,7 @@ private:
     void threadMain(MessageLoop::Type message_loop_type);
 
     Delegate* delegate_ = nullptr;
+    ThreadProfile profile_ = ThreadProfile::DEFAULT;
 
     enum class State { STARTING, STARTED, STOPPING, STOPPED };
 
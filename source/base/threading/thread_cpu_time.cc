@@ -0,0 +1,66 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_cpu_time.h"
+
+#include "base/logging.h"
+#include "build/build_config.h"
+
+#if defined(OS_WIN)
+#include <Windows.h>
+#else
+#include <time.h>
+#endif // defined(OS_WIN)
+
+namespace base {
+
+std::chrono::nanoseconds threadCpuTime()
+{
+#if defined(OS_WIN)
+    FILETIME creation_time;
+    FILETIME exit_time;
+    FILETIME kernel_time;
+    FILETIME user_time;
+
+    if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+    {
+        PLOG(LS_WARNING) << "GetThreadTimes failed";
+        return std::chrono::nanoseconds();
+    }
+
+    auto to_ticks = [](const FILETIME& time)
+    {
+        return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+
+    // FILETIME is measured in 100 nanosecond intervals.
+    return std::chrono::nanoseconds((to_ticks(kernel_time) + to_ticks(user_time)) * 100);
+#else
+    timespec time;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+    {
+        PLOG(LS_WARNING) << "clock_gettime failed";
+        return std::chrono::nanoseconds();
+    }
+
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#endif // defined(OS_WIN)
+}
+
+} // namespace base
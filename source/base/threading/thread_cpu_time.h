@@ -0,0 +1,32 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__THREADING__THREAD_CPU_TIME_H
+#define BASE__THREADING__THREAD_CPU_TIME_H
+
+#include <chrono>
+
+namespace base {
+
+// Returns the CPU time (user and kernel) used by the calling thread. On Windows the time is
+// updated on the scheduler ticks, so short intervals are measured only on average.
+std::chrono::nanoseconds threadCpuTime();
+
+} // namespace base
+
+#endif // BASE__THREADING__THREAD_CPU_TIME_H
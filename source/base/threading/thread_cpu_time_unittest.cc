@@ -0,0 +1,60 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_cpu_time.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace base {
+
+namespace {
+
+// Spins until the calling thread uses at least |duration| of the CPU time.
+void burnCpu(std::chrono::nanoseconds duration)
+{
+    const std::chrono::nanoseconds start = threadCpuTime();
+    volatile uint64_t value = 0;
+
+    while (threadCpuTime() - start < duration)
+    {
+        for (int i = 0; i < 10000; ++i)
+            value = value + i;
+    }
+}
+
+} // namespace
+
+TEST(ThreadCpuTimeTest, Grows)
+{
+    const std::chrono::nanoseconds start = threadCpuTime();
+    burnCpu(std::chrono::milliseconds(50));
+    EXPECT_GE(threadCpuTime() - start, std::chrono::milliseconds(50));
+}
+
+TEST(ThreadCpuTimeTest, SleepDoesNotCount)
+{
+    const std::chrono::nanoseconds start = threadCpuTime();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // The thread is not running while it sleeps.
+    EXPECT_LT(threadCpuTime() - start, std::chrono::milliseconds(50));
+}
+
+} // namespace base
@@ -0,0 +1,401 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_pool.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+
+#include <algorithm>
+
+namespace base {
+
+namespace {
+
+// The pool and the index of the thread which runs the current task.
+thread_local ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+class SequencedTaskRunner : public TaskRunner
+{
+public:
+    explicit SequencedTaskRunner(ThreadPool* pool)
+        : pool_(pool)
+    {
+        DCHECK(pool_);
+    }
+
+    // TaskRunner implementation.
+    bool belongsToCurrentThread() const override;
+    void postTask(Callback task) override;
+    void postDelayedTask(Callback callback, const Milliseconds& delay) override;
+    void postNonNestableTask(Callback callback) override;
+    void postNonNestableDelayedTask(Callback callback, const Milliseconds& delay) override;
+    void postQuit() override;
+
+private:
+    void runNextTask();
+
+    ThreadPool* pool_;
+
+    std::mutex queue_lock_;
+    std::queue<Callback> queue_;
+    bool running_ = false;
+
+    std::atomic<std::thread::id> running_thread_;
+
+    DISALLOW_COPY_AND_ASSIGN(SequencedTaskRunner);
+};
+
+bool SequencedTaskRunner::belongsToCurrentThread() const
+{
+    return running_thread_.load() == std::this_thread::get_id();
+}
+
+void SequencedTaskRunner::postTask(Callback task)
+{
+    DCHECK(task);
+
+    {
+        std::scoped_lock lock(queue_lock_);
+
+        queue_.emplace(std::move(task));
+
+        // The next task is posted to the pool when the current one is completed.
+        if (running_)
+            return;
+
+        running_ = true;
+    }
+
+    auto self = std::static_pointer_cast<SequencedTaskRunner>(shared_from_this());
+    pool_->postTask([self]() { self->runNextTask(); });
+}
+
+void SequencedTaskRunner::postDelayedTask(Callback callback, const Milliseconds& delay)
+{
+    // Tasks of the pool are copyable, the callback is not.
+    auto self = shared_from_this();
+    auto task = std::make_shared<Callback>(std::move(callback));
+    pool_->postDelayedTask([self, task]()
+    {
+        self->postTask(std::move(*task));
+    }, delay);
+}
+
+void SequencedTaskRunner::postNonNestableTask(Callback callback)
+{
+    // Tasks of the pool are never nested.
+    postTask(std::move(callback));
+}
+
+void SequencedTaskRunner::postNonNestableDelayedTask(Callback callback, const Milliseconds& delay)
+{
+    postDelayedTask(std::move(callback), delay);
+}
+
+void SequencedTaskRunner::postQuit()
+{
+    // There is no message loop to quit.
+    NOTREACHED();
+}
+
+void SequencedTaskRunner::runNextTask()
+{
+    Callback task;
+
+    {
+        std::scoped_lock lock(queue_lock_);
+        DCHECK(!queue_.empty());
+
+        task = std::move(queue_.front());
+        queue_.pop();
+    }
+
+    running_thread_ = std::this_thread::get_id();
+    task();
+    running_thread_ = std::thread::id();
+
+    {
+        std::scoped_lock lock(queue_lock_);
+
+        if (queue_.empty())
+        {
+            running_ = false;
+            return;
+        }
+    }
+
+    // One task is run at a time, so the other tasks of the pool are not delayed by a long
+    // sequence.
+    auto self = std::static_pointer_cast<SequencedTaskRunner>(shared_from_this());
+    pool_->postTask([self]() { self->runNextTask(); });
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count, ThreadProfile profile)
+{
+    if (!thread_count)
+        thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+
+    workers_.reserve(thread_count);
+
+    for (size_t i = 0; i < thread_count; ++i)
+        workers_.emplace_back(std::make_unique<Worker>());
+
+    // The threads are started when all the workers are created, because they take tasks from
+    // each other.
+    for (size_t i = 0; i < thread_count; ++i)
+        workers_[i]->thread = std::thread(&ThreadPool::threadMain, this, i, profile);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock lock(sleep_lock_);
+        stopping_ = true;
+    }
+
+    sleep_event_.notify_all();
+
+    for (auto& worker : workers_)
+        worker->thread.join();
+
+    DCHECK_EQ(pending_count_, 0u);
+}
+
+// static
+ThreadPool* ThreadPool::shared()
+{
+    // The pool is not destroyed, so it can be used by objects which are destroyed at exit.
+    static ThreadPool* pool = new ThreadPool(0, ThreadProfile::CAPTURE);
+    return pool;
+}
+
+void ThreadPool::postTask(Task task)
+{
+    DCHECK(task);
+
+    size_t index;
+
+    if (current_pool == this)
+    {
+        // The task will probably use the data which is already in the cache of this thread.
+        index = current_worker;
+    }
+    else
+    {
+        index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+
+    addTask(index, std::move(task));
+}
+
+void ThreadPool::postDelayedTask(Task task, const Milliseconds& delay)
+{
+    DCHECK(task);
+
+    {
+        std::scoped_lock lock(sleep_lock_);
+        DCHECK(!stopping_);
+
+        delayed_tasks_.push(DelayedTask{ std::chrono::steady_clock::now() + delay,
+                                         next_sequence_num_++,
+                                         std::move(task) });
+    }
+
+    // One of the idle threads waits for the earliest delayed task.
+    sleep_event_.notify_all();
+}
+
+void ThreadPool::runTasks(std::vector<Task> tasks, size_t max_parallelism)
+{
+    parallelFor(tasks.size(), [&tasks](size_t index) { tasks[index](); }, max_parallelism);
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t index)>& function,
+                             size_t max_parallelism)
+{
+    if (!count)
+        return;
+
+    struct Batch
+    {
+        std::atomic<size_t> next_index = 0;
+        std::atomic<size_t> completed = 0;
+        size_t count = 0;
+
+        // Is called only while the caller waits for the completion.
+        const std::function<void(size_t index)>* function = nullptr;
+
+        std::mutex done_lock;
+        std::condition_variable done_event;
+    };
+
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    batch->count = count;
+    batch->function = &function;
+
+    auto run = [](Batch* batch)
+    {
+        for (;;)
+        {
+            const size_t index = batch->next_index.fetch_add(1);
+            if (index >= batch->count)
+                return;
+
+            (*batch->function)(index);
+
+            if (batch->completed.fetch_add(1) + 1 == batch->count)
+            {
+                {
+                    std::scoped_lock lock(batch->done_lock);
+                }
+                batch->done_event.notify_all();
+            }
+        }
+    };
+
+    size_t helper_count = std::min(count, workers_.size() + 1) - 1;
+    if (max_parallelism)
+        helper_count = std::min(helper_count, max_parallelism - 1);
+
+    // The helpers which start after all indexes are taken only check the index.
+    for (size_t i = 0; i < helper_count; ++i)
+        postTask([batch, run]() { run(batch.get()); });
+
+    run(batch.get());
+
+    std::unique_lock lock(batch->done_lock);
+    batch->done_event.wait(lock, [&batch]() { return batch->completed == batch->count; });
+}
+
+std::shared_ptr<TaskRunner> ThreadPool::createSequencedTaskRunner()
+{
+    return std::make_shared<SequencedTaskRunner>(this);
+}
+
+void ThreadPool::threadMain(size_t index, ThreadProfile profile)
+{
+    ScopedThreadProfile thread_profile(profile);
+
+    current_pool = this;
+    current_worker = index;
+
+    for (;;)
+    {
+        Task task;
+
+        if (takeTask(index, &task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock lock(sleep_lock_);
+
+        if (!delayed_tasks_.empty() &&
+            delayed_tasks_.top().time <= std::chrono::steady_clock::now())
+        {
+            // std::priority_queue does not allow to move the top element.
+            task = std::move(const_cast<DelayedTask&>(delayed_tasks_.top()).task);
+            delayed_tasks_.pop();
+
+            lock.unlock();
+            task();
+            continue;
+        }
+
+        // The thread is marked as idle before it checks the queues, so a thread which adds a task
+        // after the check sees it and wakes it up.
+        ++idle_count_;
+
+        if (!pending_count_)
+        {
+            // The queues are drained before the threads exit.
+            if (stopping_)
+            {
+                --idle_count_;
+                return;
+            }
+
+            if (delayed_tasks_.empty())
+                sleep_event_.wait(lock);
+            else
+                sleep_event_.wait_until(lock, delayed_tasks_.top().time);
+        }
+
+        --idle_count_;
+    }
+}
+
+void ThreadPool::addTask(size_t index, Task task)
+{
+    Worker* worker = workers_[index].get();
+
+    {
+        std::scoped_lock lock(worker->queue_lock);
+        worker->queue.emplace_back(std::move(task));
+    }
+
+    ++pending_count_;
+
+    if (idle_count_)
+    {
+        // The idle thread either has not yet checked the counter or already waits for the event.
+        {
+            std::scoped_lock lock(sleep_lock_);
+        }
+        sleep_event_.notify_one();
+    }
+}
+
+bool ThreadPool::takeTask(size_t index, Task* task)
+{
+    // The thread takes the oldest task of its own queue and the newest task of the other queues,
+    // so it does not compete with the owner of the queue for the same end.
+    for (size_t i = 0; i < workers_.size(); ++i)
+    {
+        Worker* worker = workers_[(index + i) % workers_.size()].get();
+
+        std::scoped_lock lock(worker->queue_lock);
+
+        if (worker->queue.empty())
+            continue;
+
+        if (!i)
+        {
+            *task = std::move(worker->queue.front());
+            worker->queue.pop_front();
+        }
+        else
+        {
+            *task = std::move(worker->queue.back());
+            worker->queue.pop_back();
+        }
+
+        --pending_count_;
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace base
@@ -0,0 +1,132 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__THREADING__THREAD_POOL_H
+#define BASE__THREADING__THREAD_POOL_H
+
+#include "base/macros_magic.h"
+#include "base/threading/thread_profile.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+class TaskRunner;
+
+// A fixed set of threads which run CPU-bound tasks (for example, big number arithmetic or image
+// processing) outside of the network threads. Each thread has its own queue of tasks. Tasks
+// posted from a thread of the pool are added to its queue, other tasks are distributed between
+// the queues. A thread whose queue is empty takes tasks from the queues of the other threads.
+// The order of tasks is not guaranteed (use createSequencedTaskRunner for that). The class is
+// thread-safe.
+class ThreadPool
+{
+public:
+    // If |thread_count| is 0, the number of processor threads is used. The threads are run with
+    // the scheduling |profile|.
+    explicit ThreadPool(size_t thread_count = 0, ThreadProfile profile = ThreadProfile::DEFAULT);
+
+    // Completes the tasks which are already posted and stops the threads. Delayed tasks which are
+    // not yet due are dropped.
+    ~ThreadPool();
+
+    // Returns the pool which is shared by the whole process. It has a thread for each processor
+    // thread and is never destroyed. The pool runs the parallel parts of the video pipeline
+    // (diff, scaling and color conversion), so its threads use the capture profile.
+    static ThreadPool* shared();
+
+    using Task = std::function<void()>;
+    using Milliseconds = std::chrono::milliseconds;
+
+    void postTask(Task task);
+    void postDelayedTask(Task task, const Milliseconds& delay);
+
+    // Runs |tasks| in parallel and waits until all of them are completed. The calling thread runs
+    // the tasks too, so the method can be called from a task of the same pool. Not more than
+    // |max_parallelism| threads (including the calling thread) run the tasks at the same time. If
+    // it is 0, the number is not limited.
+    void runTasks(std::vector<Task> tasks, size_t max_parallelism = 0);
+
+    // Calls |function| for each index from 0 to |count| - 1 in parallel and waits until all calls
+    // are completed. See runTasks.
+    void parallelFor(size_t count,
+                     const std::function<void(size_t index)>& function,
+                     size_t max_parallelism = 0);
+
+    // Returns a task runner whose tasks are run on the pool one at a time in the order in which
+    // they were posted. The pool must outlive the task runner.
+    std::shared_ptr<TaskRunner> createSequencedTaskRunner();
+
+    size_t threadCount() const { return workers_.size(); }
+
+private:
+    struct Worker
+    {
+        std::mutex queue_lock;
+        std::deque<Task> queue;
+        std::thread thread;
+    };
+
+    struct DelayedTask
+    {
+        std::chrono::steady_clock::time_point time;
+        uint64_t sequence_num;
+        Task task;
+
+        // The earliest task is at the top of the priority queue.
+        bool operator<(const DelayedTask& other) const
+        {
+            if (time != other.time)
+                return time > other.time;
+            return sequence_num > other.sequence_num;
+        }
+    };
+
+    void threadMain(size_t index, ThreadProfile profile);
+    void addTask(size_t index, Task task);
+    bool takeTask(size_t index, Task* task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    // Number of tasks in the queues of the threads.
+    std::atomic<size_t> pending_count_ = 0;
+    std::atomic<size_t> idle_count_ = 0;
+    std::atomic<size_t> next_worker_ = 0;
+
+    // Protects waiting of idle threads, |delayed_tasks_| and |stopping_|.
+    std::mutex sleep_lock_;
+    std::condition_variable sleep_event_;
+    std::priority_queue<DelayedTask> delayed_tasks_;
+    uint64_t next_sequence_num_ = 0;
+    bool stopping_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+};
+
+} // namespace base
+
+#endif // BASE__THREADING__THREAD_POOL_H
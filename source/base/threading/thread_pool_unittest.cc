@@ -0,0 +1,239 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_pool.h"
+
+#include "base/task_runner.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <set>
+
+namespace base {
+
+TEST(ThreadPoolTest, DefaultThreadCount)
+{
+    ThreadPool pool;
+    EXPECT_GE(pool.threadCount(), 1U);
+}
+
+TEST(ThreadPoolTest, RunsAllTasks)
+{
+    std::atomic<int> counter = 0;
+
+    {
+        ThreadPool pool(4);
+        EXPECT_EQ(pool.threadCount(), 4U);
+
+        for (int i = 0; i < 1000; ++i)
+            pool.postTask([&counter]() { ++counter; });
+    }
+
+    // The destructor completes the posted tasks.
+    EXPECT_EQ(counter, 1000);
+}
+
+TEST(ThreadPoolTest, Profile)
+{
+    std::atomic<int> counter = 0;
+
+    {
+        // The profile may not be applied without privileges, but the pool works in any case.
+        ThreadPool pool(2, ThreadProfile::CAPTURE);
+
+        for (int i = 0; i < 100; ++i)
+            pool.postTask([&counter]() { ++counter; });
+    }
+
+    EXPECT_EQ(counter, 100);
+}
+
+TEST(ThreadPoolTest, RunTasksWaits)
+{
+    ThreadPool pool(3);
+
+    std::vector<int> results(100);
+    std::vector<ThreadPool::Task> tasks;
+
+    for (size_t i = 0; i < results.size(); ++i)
+        tasks.emplace_back([&results, i]() { results[i] = static_cast<int>(i) * 2; });
+
+    pool.runTasks(std::move(tasks));
+
+    // All results are ready when runTasks returns.
+    for (size_t i = 0; i < results.size(); ++i)
+        EXPECT_EQ(results[i], static_cast<int>(i) * 2);
+}
+
+TEST(ThreadPoolTest, RunsTasksInParallel)
+{
+    static const size_t kThreadCount = 4;
+
+    std::mutex lock;
+    std::condition_variable event;
+    size_t started = 0;
+    std::set<std::thread::id> thread_ids;
+
+    {
+        ThreadPool pool(kThreadCount);
+
+        // Each task waits until all tasks have started, so they can only finish when they run on
+        // different threads at the same time.
+        for (size_t i = 0; i < kThreadCount; ++i)
+        {
+            pool.postTask([&]()
+            {
+                std::unique_lock guard(lock);
+
+                thread_ids.insert(std::this_thread::get_id());
+                ++started;
+                event.notify_all();
+
+                event.wait(guard, [&]() { return started == kThreadCount; });
+            });
+        }
+    }
+
+    EXPECT_EQ(thread_ids.size(), kThreadCount);
+}
+
+TEST(ThreadPoolTest, ParallelFor)
+{
+    ThreadPool pool(4);
+
+    std::vector<std::atomic<int>> calls(1000);
+    pool.parallelFor(calls.size(), [&calls](size_t index) { ++calls[index]; });
+
+    // Each index is processed exactly once.
+    for (const auto& call : calls)
+        EXPECT_EQ(call, 1);
+}
+
+TEST(ThreadPoolTest, MaxParallelism)
+{
+    ThreadPool pool(4);
+
+    std::atomic<int> running = 0;
+    std::atomic<int> max_running = 0;
+
+    pool.parallelFor(200, [&](size_t /* index */)
+    {
+        const int current = ++running;
+
+        int expected = max_running;
+        while (current > expected && !max_running.compare_exchange_weak(expected, current))
+        {
+            // Nothing
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        --running;
+    }, 2);
+
+    EXPECT_LE(max_running, 2);
+}
+
+TEST(ThreadPoolTest, NestedRunTasks)
+{
+    ThreadPool pool(2);
+
+    std::atomic<int> counter = 0;
+    std::vector<ThreadPool::Task> tasks;
+
+    // Each task waits for its own tasks. The calling threads run them, so all threads of the pool
+    // can wait at the same time.
+    for (int i = 0; i < 8; ++i)
+    {
+        tasks.emplace_back([&]()
+        {
+            pool.parallelFor(10, [&counter](size_t /* index */) { ++counter; });
+        });
+    }
+
+    pool.runTasks(std::move(tasks));
+    EXPECT_EQ(counter, 80);
+}
+
+TEST(ThreadPoolTest, DelayedTask)
+{
+    ThreadPool pool(2);
+
+    std::mutex lock;
+    std::condition_variable event;
+    std::vector<int> order;
+
+    pool.postDelayedTask([&]()
+    {
+        std::scoped_lock guard(lock);
+        order.push_back(2);
+        event.notify_all();
+    }, std::chrono::milliseconds(50));
+
+    pool.postDelayedTask([&]()
+    {
+        std::scoped_lock guard(lock);
+        order.push_back(1);
+        event.notify_all();
+    }, std::chrono::milliseconds(10));
+
+    std::unique_lock guard(lock);
+    event.wait(guard, [&]() { return order.size() == 2; });
+
+    EXPECT_EQ(order[0], 1);
+    EXPECT_EQ(order[1], 2);
+}
+
+TEST(ThreadPoolTest, SequencedTaskRunner)
+{
+    ThreadPool pool(4);
+    std::shared_ptr<TaskRunner> task_runner = pool.createSequencedTaskRunner();
+
+    EXPECT_FALSE(task_runner->belongsToCurrentThread());
+
+    std::mutex lock;
+    std::condition_variable event;
+    std::vector<int> order;
+    std::atomic<int> running = 0;
+    bool belongs = true;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        task_runner->postTask([&, i]()
+        {
+            // The tasks are not run at the same time.
+            EXPECT_EQ(++running, 1);
+            belongs = belongs && task_runner->belongsToCurrentThread();
+            --running;
+
+            std::scoped_lock guard(lock);
+            order.push_back(i);
+            event.notify_all();
+        });
+    }
+
+    std::unique_lock guard(lock);
+    event.wait(guard, [&]() { return order.size() == 100; });
+
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(order[i], i);
+
+    EXPECT_TRUE(belongs);
+}
+
+} // namespace base
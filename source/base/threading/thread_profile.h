@@ -0,0 +1,77 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__THREADING__THREAD_PROFILE_H
+#define BASE__THREADING__THREAD_PROFILE_H
+
+#include "base/macros_magic.h"
+#include "build/build_config.h"
+
+#include <memory>
+
+#if defined(OS_LINUX)
+#include <sched.h>
+#endif // defined(OS_LINUX)
+
+namespace base {
+
+// Scheduling profile of a thread. The threads of the video and audio pipeline are scheduled before
+// the other threads of the system, so the frame time does not jitter when the computer is loaded.
+enum class ThreadProfile
+{
+    // Normal scheduling.
+    DEFAULT,
+
+    // Capture, diff and encode (MMCSS "Capture" on Windows, SCHED_RR on Linux, user-interactive
+    // QoS class on macOS).
+    CAPTURE,
+
+    // Decode and render (MMCSS "Playback" on Windows, SCHED_RR on Linux, user-interactive QoS
+    // class on macOS).
+    PLAYBACK
+};
+
+class ScopedMMCSSRegistration;
+
+// Applies the profile to the calling thread and restores the previous scheduling when destroyed.
+// If the profile can not be applied (for example, a real-time policy requires privileges on
+// Linux), the thread keeps the normal scheduling.
+class ScopedThreadProfile
+{
+public:
+    explicit ScopedThreadProfile(ThreadProfile profile);
+    ~ScopedThreadProfile();
+
+    bool isApplied() const { return applied_; }
+
+private:
+    bool applied_ = false;
+
+#if defined(OS_WIN)
+    std::unique_ptr<ScopedMMCSSRegistration> mmcss_registration_;
+#elif defined(OS_LINUX)
+    int old_policy_ = SCHED_OTHER;
+    sched_param old_param_;
+#endif
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedThreadProfile);
+};
+
+} // namespace base
+
+#endif // BASE__THREADING__THREAD_PROFILE_H
@@ -0,0 +1,71 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_profile.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// Low real-time priorities: the media threads are run before the normal threads, but do not
+// compete with the audio server and the kernel threads.
+const int kCapturePriority = 2;
+const int kPlaybackPriority = 1;
+
+} // namespace
+
+ScopedThreadProfile::ScopedThreadProfile(ThreadProfile profile)
+{
+    if (profile == ThreadProfile::DEFAULT)
+        return;
+
+    old_policy_ = sched_getscheduler(0);
+    if (old_policy_ == -1 || sched_getparam(0, &old_param_) != 0)
+    {
+        PLOG(LS_WARNING) << "Unable to get the scheduling policy";
+        return;
+    }
+
+    sched_param param = {};
+    param.sched_priority = sched_get_priority_min(SCHED_RR) +
+        (profile == ThreadProfile::CAPTURE ? kCapturePriority : kPlaybackPriority);
+
+    // The policy is not inherited by the child processes.
+    if (sched_setscheduler(0, SCHED_RR | SCHED_RESET_ON_FORK, &param) != 0)
+    {
+        // The real-time policy requires CAP_SYS_NICE or RLIMIT_RTPRIO. The thread keeps the
+        // normal scheduling.
+        PLOG(LS_INFO) << "Unable to set the real-time scheduling policy";
+        return;
+    }
+
+    applied_ = true;
+}
+
+ScopedThreadProfile::~ScopedThreadProfile()
+{
+    if (!applied_)
+        return;
+
+    if (sched_setscheduler(0, old_policy_, &old_param_) != 0)
+        PLOG(LS_WARNING) << "Unable to restore the scheduling policy";
+}
+
+} // namespace base
@@ -0,0 +1,52 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_profile.h"
+
+#include "base/logging.h"
+
+#include <pthread.h>
+
+namespace base {
+
+ScopedThreadProfile::ScopedThreadProfile(ThreadProfile profile)
+{
+    if (profile == ThreadProfile::DEFAULT)
+        return;
+
+    // The user-interactive class is used for the work which updates the user interface. The
+    // threads of the class are run before the other threads and are not throttled.
+    int error = pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+    if (error != 0)
+    {
+        LOG(LS_WARNING) << "pthread_set_qos_class_self_np failed: " << error;
+        return;
+    }
+
+    applied_ = true;
+}
+
+ScopedThreadProfile::~ScopedThreadProfile()
+{
+    if (!applied_)
+        return;
+
+    pthread_set_qos_class_self_np(QOS_CLASS_DEFAULT, 0);
+}
+
+} // namespace base
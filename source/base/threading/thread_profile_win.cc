@@ -0,0 +1,42 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/threading/thread_profile.h"
+
+#include "base/audio/win/scoped_mmcss_registration.h"
+
+namespace base {
+
+ScopedThreadProfile::ScopedThreadProfile(ThreadProfile profile)
+{
+    if (profile == ThreadProfile::DEFAULT)
+        return;
+
+    // The Multimedia Class Scheduler Service raises the priority of the thread while the CPU is
+    // not reserved for the other tasks of the system.
+    mmcss_registration_ = std::make_unique<ScopedMMCSSRegistration>(
+        profile == ThreadProfile::CAPTURE ? L"Capture" : L"Playback");
+
+    applied_ = mmcss_registration_->isSucceeded();
+    if (!applied_)
+        mmcss_registration_.reset();
+}
+
+ScopedThreadProfile::~ScopedThreadProfile() = default;
+
+} // namespace base
@@ -0,0 +1,44 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/timer_slack.h"
+
+namespace base {
+
+namespace {
+
+// The slack is not more than 1/16 (about 6%) of the delay.
+constexpr int kSlackShift = 4;
+constexpr std::chrono::milliseconds kMaxSlack{ 1024 };
+
+} // namespace
+
+std::chrono::milliseconds timerSlack(const std::chrono::milliseconds& delay)
+{
+    const std::chrono::milliseconds::rep limit = delay.count() >> kSlackShift;
+    if (limit < 2)
+        return std::chrono::milliseconds::zero();
+
+    std::chrono::milliseconds::rep slack = 1;
+    while ((slack << 1) <= limit && (slack << 1) <= kMaxSlack.count())
+        slack <<= 1;
+
+    return std::chrono::milliseconds(slack);
+}
+
+} // namespace base
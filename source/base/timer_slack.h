@@ -0,0 +1,57 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__TIMER_SLACK_H
+#define BASE__TIMER_SLACK_H
+
+#include <chrono>
+
+namespace base {
+
+// Returns the slack allowed for a timer which does not need to be precise (keep alive, timeouts,
+// reconnects and so on). The slack is the largest power of two milliseconds which is not larger
+// than 1/16 of |delay| and not larger than 1024 ms. Delays shorter than 32 ms have no slack.
+std::chrono::milliseconds timerSlack(const std::chrono::milliseconds& delay);
+
+// Returns the expiration time of a coarse timer started at |now| with |delay|. The time is rounded
+// up to a multiple of timerSlack(delay) since the clock epoch. The timer fires no earlier than
+// |now| + |delay| and no later than |now| + |delay| + slack. Timers with close delays get the same
+// slack and expire together, so that the thread wakes up once for all of them.
+template <class TimePoint>
+TimePoint coarseExpiration(const TimePoint& now, const std::chrono::milliseconds& delay)
+{
+    using Duration = typename TimePoint::duration;
+
+    TimePoint expiration = now + std::chrono::duration_cast<Duration>(delay);
+
+    const Duration slack = std::chrono::duration_cast<Duration>(timerSlack(delay));
+    if (slack <= Duration::zero())
+        return expiration;
+
+    const Duration remainder = expiration.time_since_epoch() % slack;
+    if (remainder > Duration::zero())
+        expiration += slack - remainder;
+    else if (remainder < Duration::zero())
+        expiration -= remainder;
+
+    return expiration;
+}
+
+} // namespace base
+
+#endif // BASE__TIMER_SLACK_H
@@ -0,0 +1,68 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/timer_slack.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+using namespace std::chrono_literals;
+
+TEST(TimerSlackTest, Slack)
+{
+    EXPECT_EQ(timerSlack(0ms), 0ms);
+    EXPECT_EQ(timerSlack(31ms), 0ms);
+    EXPECT_EQ(timerSlack(32ms), 2ms);
+    EXPECT_EQ(timerSlack(1000ms), 32ms);
+    EXPECT_EQ(timerSlack(30000ms), 1024ms);
+    EXPECT_EQ(timerSlack(3600000ms), 1024ms);
+}
+
+TEST(TimerSlackTest, Expiration)
+{
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    const TimePoint now(12345ms);
+
+    // Short delays are not changed.
+    EXPECT_EQ(coarseExpiration(now, 10ms), now + 10ms);
+
+    for (auto delay : { 100ms, 1000ms, 5000ms, 30000ms })
+    {
+        const TimePoint expiration = coarseExpiration(now, delay);
+        EXPECT_GE(expiration, now + delay);
+        EXPECT_LT(expiration, now + delay + timerSlack(delay));
+        EXPECT_EQ(expiration.time_since_epoch() % timerSlack(delay), 0ms);
+    }
+}
+
+TEST(TimerSlackTest, Coalescing)
+{
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    // The first timer expires right after a multiple of the slack.
+    const TimePoint now(200 * 1024ms - 30000ms + 1ms);
+
+    // Timers started at close moments with the same delay expire together.
+    const TimePoint expiration = coarseExpiration(now, 30000ms);
+    for (int i = 1; i < 1023; i += 100)
+        EXPECT_EQ(coarseExpiration(now + std::chrono::milliseconds(i), 30000ms), expiration);
+}
+
+} // namespace base
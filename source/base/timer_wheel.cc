@@ -0,0 +1,99 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/timer_wheel.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+
+namespace base {
+
+TimerWheel::Item::~Item()
+{
+    TimerWheel::cancel(this);
+}
+
+TimerWheel::TimerWheel(size_t slot_count)
+    : slot_count_(std::max(slot_count, static_cast<size_t>(2))),
+      slots_(std::make_unique<Item[]>(slot_count_))
+{
+    // An empty list is a head that refers to itself.
+    for (size_t i = 0; i < slot_count_; ++i)
+        slots_[i].prev_ = slots_[i].next_ = &slots_[i];
+}
+
+TimerWheel::~TimerWheel()
+{
+    // Items that are still scheduled must not refer to the destroyed slots.
+    for (size_t i = 0; i < slot_count_; ++i)
+    {
+        Item* head = &slots_[i];
+
+        while (head->next_ != head)
+            cancel(head->next_);
+
+        head->prev_ = head->next_ = nullptr;
+    }
+}
+
+void TimerWheel::schedule(Item* item, size_t ticks)
+{
+    DCHECK(item);
+
+    ticks = std::clamp(ticks, static_cast<size_t>(1), slot_count_ - 1);
+
+    cancel(item);
+
+    Item* head = &slots_[(current_slot_ + ticks) % slot_count_];
+
+    // The item is added to the end of the list.
+    item->prev_ = head->prev_;
+    item->next_ = head;
+    head->prev_->next_ = item;
+    head->prev_ = item;
+}
+
+// static
+void TimerWheel::cancel(Item* item)
+{
+    if (!item->isScheduled())
+        return;
+
+    item->prev_->next_ = item->next_;
+    item->next_->prev_ = item->prev_;
+    item->prev_ = item->next_ = nullptr;
+}
+
+std::vector<TimerWheel::Item*> TimerWheel::advance()
+{
+    current_slot_ = (current_slot_ + 1) % slot_count_;
+
+    Item* head = &slots_[current_slot_];
+    std::vector<Item*> expired;
+
+    while (head->next_ != head)
+    {
+        Item* item = head->next_;
+        cancel(item);
+        expired.emplace_back(item);
+    }
+
+    return expired;
+}
+
+} // namespace base
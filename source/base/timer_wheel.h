@@ -0,0 +1,82 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#ifndef BASE__TIMER_WHEEL_H
+#define BASE__TIMER_WHEEL_H
+
+#include "base/macros_magic.h"
+
+#include <memory>
+#include <vector>
+
+namespace base {
+
+// Hashed timer wheel. The wheel has a fixed number of slots, and each slot has an intrusive list
+// of the items that expire when the wheel reaches the slot. Adding, removing and rescheduling an
+// item are O(1), and advancing the wheel touches only the items of one slot.
+// The wheel does not own the items and is not thread-safe.
+class TimerWheel
+{
+public:
+    class Item
+    {
+    public:
+        Item() = default;
+        ~Item();
+
+        // Returns true if the item is added to the wheel.
+        bool isScheduled() const { return prev_ != nullptr; }
+
+    private:
+        friend class TimerWheel;
+
+        Item* prev_ = nullptr;
+        Item* next_ = nullptr;
+
+        DISALLOW_COPY_AND_ASSIGN(Item);
+    };
+
+    // An item can be scheduled not more than |slot_count| - 1 ticks ahead.
+    explicit TimerWheel(size_t slot_count);
+    ~TimerWheel();
+
+    size_t slotCount() const { return slot_count_; }
+
+    // Adds |item| to the slot which expires after |ticks| ticks. |ticks| is limited to the range
+    // from 1 to slotCount() - 1. If the item is already scheduled, it is moved.
+    void schedule(Item* item, size_t ticks);
+
+    // Removes |item| from the wheel. Nothing happens if the item is not scheduled.
+    static void cancel(Item* item);
+
+    // Moves the wheel one tick forward and returns the items of the reached slot. The returned
+    // items are removed from the wheel.
+    std::vector<Item*> advance();
+
+private:
+    const size_t slot_count_;
+
+    // Heads of the circular lists of the slots.
+    std::unique_ptr<Item[]> slots_;
+    size_t current_slot_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+} // namespace base
+
+#endif // BASE__TIMER_WHEEL_H
@@ -0,0 +1,105 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+#include "base/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+namespace base {
+
+TEST(TimerWheelTest, Expire)
+{
+    TimerWheel wheel(4);
+    TimerWheel::Item item1;
+    TimerWheel::Item item2;
+    TimerWheel::Item item3;
+
+    wheel.schedule(&item1, 1);
+    wheel.schedule(&item2, 3);
+    wheel.schedule(&item3, 1);
+
+    EXPECT_TRUE(item1.isScheduled());
+
+    std::vector<TimerWheel::Item*> expired = wheel.advance();
+    ASSERT_EQ(expired.size(), 2u);
+    EXPECT_EQ(expired[0], &item1);
+    EXPECT_EQ(expired[1], &item3);
+    EXPECT_FALSE(item1.isScheduled());
+    EXPECT_FALSE(item3.isScheduled());
+
+    EXPECT_TRUE(wheel.advance().empty());
+
+    expired = wheel.advance();
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0], &item2);
+
+    EXPECT_TRUE(wheel.advance().empty());
+}
+
+TEST(TimerWheelTest, Reschedule)
+{
+    TimerWheel wheel(4);
+    TimerWheel::Item item;
+
+    wheel.schedule(&item, 1);
+    wheel.schedule(&item, 2);
+
+    EXPECT_TRUE(wheel.advance().empty());
+    EXPECT_EQ(wheel.advance().size(), 1u);
+
+    // The number of ticks is limited by the size of the wheel.
+    wheel.schedule(&item, 100);
+    EXPECT_TRUE(wheel.advance().empty());
+    EXPECT_TRUE(wheel.advance().empty());
+    EXPECT_EQ(wheel.advance().size(), 1u);
+}
+
+TEST(TimerWheelTest, Cancel)
+{
+    TimerWheel wheel(8);
+    TimerWheel::Item item1;
+
+    {
+        TimerWheel::Item item2;
+        wheel.schedule(&item1, 1);
+        wheel.schedule(&item2, 1);
+
+        // A destroyed item is removed from the wheel.
+    }
+
+    TimerWheel::cancel(&item1);
+    EXPECT_FALSE(item1.isScheduled());
+
+    // Cancelling an item which is not scheduled does nothing.
+    TimerWheel::cancel(&item1);
+
+    EXPECT_TRUE(wheel.advance().empty());
+}
+
+TEST(TimerWheelTest, DestroyWheel)
+{
+    TimerWheel::Item item;
+
+    {
+        TimerWheel wheel(4);
+        wheel.schedule(&item, 2);
+    }
+
+    EXPECT_FALSE(item.isScheduled());
+}
+
+} // namespace base
@@ -0,0 +1,69 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/trace_dumper.h"
+
+#include "base/logging.h"
+#include "base/trace_event.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
+
+#include <csignal>
+
+namespace base {
+
+TraceDumper::TraceDumper(const std::filesystem::path& file_path)
+    : file_path_(file_path)
+#if defined(OS_POSIX)
+      , signals_(MessageLoop::current()->pumpAsio()->ioContext(), SIGUSR1)
+#endif // defined(OS_POSIX)
+{
+    LOG(LS_INFO) << "Trace file: " << file_path_;
+
+    TraceLog::instance()->start();
+    doWaitSignal();
+}
+
+TraceDumper::~TraceDumper()
+{
+#if defined(OS_POSIX)
+    std::error_code ignored_code;
+    signals_.cancel(ignored_code);
+#endif // defined(OS_POSIX)
+
+    TraceLog* trace_log = TraceLog::instance();
+    trace_log->stop();
+    trace_log->writeChromeJson(file_path_);
+}
+
+void TraceDumper::doWaitSignal()
+{
+#if defined(OS_POSIX)
+    signals_.async_wait([this](const std::error_code& error_code, int /* signal_number */)
+    {
+        if (error_code)
+            return;
+
+        // The recording continues, the next dump contains the last events again.
+        TraceLog::instance()->writeChromeJson(file_path_);
+        doWaitSignal();
+    });
+#endif // defined(OS_POSIX)
+}
+
+} // namespace base
@@ -0,0 +1,56 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__TRACE_DUMPER_H
+#define BASE__TRACE_DUMPER_H
+
+#include "base/macros_magic.h"
+#include "build/build_config.h"
+
+#if defined(OS_POSIX)
+#include <asio/signal_set.hpp>
+#endif // defined(OS_POSIX)
+
+#include <filesystem>
+
+namespace base {
+
+// Starts the tracing (see TraceLog) for the lifetime of the object. The trace is written to
+// |file_path| when the process receives SIGUSR1 (only on POSIX) and when the object is destroyed.
+// Must be created and destroyed on the thread of an ASIO message loop.
+class TraceDumper
+{
+public:
+    explicit TraceDumper(const std::filesystem::path& file_path);
+    ~TraceDumper();
+
+private:
+    void doWaitSignal();
+
+    const std::filesystem::path file_path_;
+
+#if defined(OS_POSIX)
+    asio::signal_set signals_;
+#endif // defined(OS_POSIX)
+
+    DISALLOW_COPY_AND_ASSIGN(TraceDumper);
+};
+
+} // namespace base
+
+#endif // BASE__TRACE_DUMPER_H
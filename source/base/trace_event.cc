@@ -0,0 +1,186 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/trace_event.h"
+
+#include "base/logging.h"
+#include "base/process_handle.h"
+#include "base/files/file_util.h"
+
+#include <string_view>
+
+namespace base {
+
+namespace {
+
+int64_t toMicroseconds(const TraceLog::Clock::duration& duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+// The categories and the names are string literals, but they are escaped anyway, so that the
+// output is always valid JSON.
+void appendString(std::string_view value, std::string* json)
+{
+    json->push_back('"');
+
+    for (char ch : value)
+    {
+        if (ch == '"' || ch == '\\')
+        {
+            json->push_back('\\');
+            json->push_back(ch);
+        }
+        else if (static_cast<unsigned char>(ch) >= 0x20)
+        {
+            json->push_back(ch);
+        }
+    }
+
+    json->push_back('"');
+}
+
+} // namespace
+
+// static
+std::atomic_bool TraceLog::enabled_ { false };
+
+// static
+TraceLog* TraceLog::instance()
+{
+    // The log is never destroyed because events can be added from any thread at any time.
+    static TraceLog* log = new TraceLog();
+    return log;
+}
+
+void TraceLog::start(size_t capacity)
+{
+    DCHECK_GT(capacity, 0u);
+
+    {
+        std::scoped_lock lock(lock_);
+
+        events_.clear();
+        events_.shrink_to_fit();
+        events_.reserve(capacity);
+        next_ = 0;
+        wrapped_ = false;
+    }
+
+    enabled_.store(true, std::memory_order_relaxed);
+    LOG(LS_INFO) << "Tracing started (capacity: " << capacity << " events)";
+}
+
+void TraceLog::stop()
+{
+    enabled_.store(false, std::memory_order_relaxed);
+    LOG(LS_INFO) << "Tracing stopped";
+}
+
+void TraceLog::addEvent(const char* category, const char* name,
+                        const Clock::time_point& start, const Clock::time_point& end)
+{
+    const Event event = { category, name, start, end - start, currentThreadId() };
+
+    std::scoped_lock lock(lock_);
+
+    // The events of the scopes which were entered before the start are ignored.
+    if (!events_.capacity())
+        return;
+
+    if (!wrapped_ && events_.size() < events_.capacity())
+    {
+        events_.push_back(event);
+        return;
+    }
+
+    events_[next_] = event;
+    next_ = (next_ + 1) % events_.size();
+    wrapped_ = true;
+}
+
+std::vector<TraceLog::Event> TraceLog::events() const
+{
+    std::scoped_lock lock(lock_);
+
+    std::vector<Event> events;
+    events.reserve(events_.size());
+
+    events.insert(events.end(), events_.begin() + next_, events_.end());
+    events.insert(events.end(), events_.begin(), events_.begin() + next_);
+
+    return events;
+}
+
+std::string TraceLog::toChromeJson() const
+{
+    const std::vector<Event> events = this->events();
+    const std::string process_id = std::to_string(currentProcessId());
+
+    std::string json;
+    json.reserve(events.size() * 128);
+    json += "{\"traceEvents\":[";
+
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const Event& event = events[i];
+
+        if (i)
+            json += ',';
+
+        // Complete events ("X") contain the start and the duration, in microseconds.
+        json += "{\"name\":";
+        appendString(event.name, &json);
+        json += ",\"cat\":";
+        appendString(event.category, &json);
+        json += ",\"ph\":\"X\",\"ts\":";
+        json += std::to_string(toMicroseconds(event.start.time_since_epoch()));
+        json += ",\"dur\":";
+        json += std::to_string(toMicroseconds(event.duration));
+        json += ",\"pid\":";
+        json += process_id;
+        json += ",\"tid\":";
+        json += std::to_string(event.thread_id);
+        json += '}';
+    }
+
+    json += "],\"displayTimeUnit\":\"ms\"}";
+    return json;
+}
+
+bool TraceLog::writeChromeJson(const std::filesystem::path& file_path) const
+{
+    if (!writeFile(file_path, toChromeJson()))
+    {
+        LOG(LS_ERROR) << "Unable to write trace file: " << file_path;
+        return false;
+    }
+
+    LOG(LS_INFO) << "Trace written to: " << file_path;
+    return true;
+}
+
+// static
+uint32_t TraceLog::currentThreadId()
+{
+    static std::atomic_uint32_t last_thread_id { 0 };
+    thread_local uint32_t thread_id = last_thread_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    return thread_id;
+}
+
+} // namespace base
@@ -0,0 +1,130 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__TRACE_EVENT_H
+#define BASE__TRACE_EVENT_H
+
+#include "base/macros_magic.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace base {
+
+// Process-wide ring buffer of trace events. When it is full, the oldest events are overwritten, so
+// the buffer always contains the last events before the dump. The events are recorded only while
+// the tracing is started. The dump is written in the Chrome trace event format, which is opened by
+// chrome://tracing and by the Perfetto UI.
+class TraceLog
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event
+    {
+        // The category and the name must be string literals: only the pointers are stored.
+        const char* category;
+        const char* name;
+        Clock::time_point start;
+        Clock::duration duration;
+        uint32_t thread_id;
+    };
+
+    static const size_t kDefaultCapacity = 64 * 1024;
+
+    // Returns the process-wide instance of the log.
+    static TraceLog* instance();
+
+    // Cheap enough to be called in every traced scope.
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Starts the recording. The previous events are removed.
+    void start(size_t capacity = kDefaultCapacity);
+    void stop();
+
+    // Can be called from any thread.
+    void addEvent(const char* category, const char* name,
+                  const Clock::time_point& start, const Clock::time_point& end);
+
+    // Returns the recorded events in the order they were completed.
+    std::vector<Event> events() const;
+
+    // Returns the recorded events in the Chrome trace event format (JSON).
+    std::string toChromeJson() const;
+    bool writeChromeJson(const std::filesystem::path& file_path) const;
+
+    // Small sequential number of the current thread (the native identifiers are not small on all
+    // platforms).
+    static uint32_t currentThreadId();
+
+private:
+    TraceLog() = default;
+
+    static std::atomic_bool enabled_;
+
+    mutable std::mutex lock_;
+    std::vector<Event> events_;
+    size_t next_ = 0;
+    bool wrapped_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(TraceLog);
+};
+
+// Adds an event with the duration of its scope to the trace log. See TRACE_EVENT.
+class ScopedTraceEvent
+{
+public:
+    ScopedTraceEvent(const char* category, const char* name)
+    {
+        if (TraceLog::isEnabled())
+        {
+            category_ = category;
+            name_ = name;
+            start_ = TraceLog::Clock::now();
+        }
+    }
+
+    ~ScopedTraceEvent()
+    {
+        if (category_)
+            TraceLog::instance()->addEvent(category_, name_, start_, TraceLog::Clock::now());
+    }
+
+private:
+    const char* category_ = nullptr;
+    const char* name_ = nullptr;
+    TraceLog::Clock::time_point start_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedTraceEvent);
+};
+
+} // namespace base
+
+#define TRACE_EVENT_CONCAT_IMPL(a, b) a##b
+#define TRACE_EVENT_CONCAT(a, b) TRACE_EVENT_CONCAT_IMPL(a, b)
+
+// Records the duration of the current scope. |category| and |name| must be string literals.
+// Example: TRACE_EVENT("net", "NetworkChannel::onMessageReceived");
+#define TRACE_EVENT(category, name) \
+    base::ScopedTraceEvent TRACE_EVENT_CONCAT(trace_event_, __LINE__)(category, name)
+
+#endif // BASE__TRACE_EVENT_H
@@ -0,0 +1,114 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/trace_event.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+
+namespace base {
+
+TEST(TraceEventTest, Disabled)
+{
+    TraceLog* log = TraceLog::instance();
+    log->start(16);
+    log->stop();
+
+    {
+        TRACE_EVENT("test", "Disabled");
+    }
+
+    EXPECT_TRUE(log->events().empty());
+}
+
+TEST(TraceEventTest, Scope)
+{
+    TraceLog* log = TraceLog::instance();
+    log->start(16);
+
+    {
+        TRACE_EVENT("test", "Outer");
+        TRACE_EVENT("test", "Inner");
+    }
+
+    log->stop();
+
+    std::vector<TraceLog::Event> events = log->events();
+    ASSERT_EQ(events.size(), 2u);
+
+    // The inner scope is completed first.
+    EXPECT_STREQ(events[0].name, "Inner");
+    EXPECT_STREQ(events[1].name, "Outer");
+    EXPECT_STREQ(events[1].category, "test");
+    EXPECT_LE(events[1].start, events[0].start);
+    EXPECT_GE(events[1].duration, events[0].duration);
+}
+
+TEST(TraceEventTest, RingBuffer)
+{
+    static const char* kNames[] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+
+    TraceLog* log = TraceLog::instance();
+    log->start(4);
+
+    const TraceLog::Clock::time_point now = TraceLog::Clock::now();
+    for (const char* name : kNames)
+        log->addEvent("test", name, now, now);
+
+    log->stop();
+
+    // Only the last events are kept, the oldest first.
+    std::vector<TraceLog::Event> events = log->events();
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_STREQ(events[0].name, "6");
+    EXPECT_STREQ(events[1].name, "7");
+    EXPECT_STREQ(events[2].name, "8");
+    EXPECT_STREQ(events[3].name, "9");
+}
+
+TEST(TraceEventTest, ThreadId)
+{
+    const uint32_t thread_id = TraceLog::currentThreadId();
+    EXPECT_EQ(TraceLog::currentThreadId(), thread_id);
+
+    uint32_t other_thread_id = thread_id;
+    std::thread thread([&]() { other_thread_id = TraceLog::currentThreadId(); });
+    thread.join();
+
+    EXPECT_NE(other_thread_id, thread_id);
+}
+
+TEST(TraceEventTest, ChromeJson)
+{
+    TraceLog* log = TraceLog::instance();
+    log->start(16);
+
+    const TraceLog::Clock::time_point start(std::chrono::microseconds(1000));
+    log->addEvent("net", "Read", start, start + std::chrono::microseconds(250));
+
+    log->stop();
+
+    const std::string json = log->toChromeJson();
+    EXPECT_EQ(json.find("{\"traceEvents\":[{\"name\":\"Read\",\"cat\":\"net\",\"ph\":\"X\","
+                        "\"ts\":1000,\"dur\":250,"), 0u);
+    EXPECT_NE(json.find("\"displayTimeUnit\":\"ms\""), std::string::npos);
+}
+
+} // namespace base
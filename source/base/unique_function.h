@@ -0,0 +1,215 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__UNIQUE_FUNCTION_H
+#define BASE__UNIQUE_FUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace base {
+
+template <typename Signature>
+class UniqueFunction;
+
+// Move-only replacement for std::function. Function objects up to |kInlineSize| bytes (for example,
+// a lambda which captures a shared_ptr, a ByteArray and a pointer) are stored inside the object
+// without a heap allocation. Larger objects are stored on the heap. Unlike std::function, the
+// function object does not have to be copyable.
+template <typename R, typename... Args>
+class UniqueFunction<R(Args...)>
+{
+public:
+    static const size_t kInlineSize = 64;
+
+    UniqueFunction() noexcept = default;
+    UniqueFunction(std::nullptr_t) noexcept { /* Nothing */ }
+
+    template <typename F,
+              typename Functor = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Functor, UniqueFunction> &&
+                                          std::is_invocable_r_v<R, Functor&, Args...>>>
+    UniqueFunction(F&& function)
+    {
+        // Empty function pointers and std::function objects give an empty UniqueFunction.
+        if (isNull(function))
+            return;
+
+        if constexpr (kFitsInline<Functor>)
+        {
+            new (&storage_) Functor(std::forward<F>(function));
+            ops_ = &InlineOps<Functor>::kOps;
+        }
+        else
+        {
+            *reinterpret_cast<Functor**>(&storage_) = new Functor(std::forward<F>(function));
+            ops_ = &HeapOps<Functor>::kOps;
+        }
+    }
+
+    UniqueFunction(UniqueFunction&& other) noexcept
+    {
+        moveFrom(&other);
+    }
+
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(&other);
+        }
+
+        return *this;
+    }
+
+    UniqueFunction& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    ~UniqueFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    R operator()(Args... args) const
+    {
+        return ops_->invoke(const_cast<Storage*>(&storage_), std::forward<Args>(args)...);
+    }
+
+    friend bool operator==(const UniqueFunction& function, std::nullptr_t) { return !function; }
+    friend bool operator==(std::nullptr_t, const UniqueFunction& function) { return !function; }
+    friend bool operator!=(const UniqueFunction& function, std::nullptr_t) { return !!function; }
+    friend bool operator!=(std::nullptr_t, const UniqueFunction& function) { return !!function; }
+
+private:
+    using Storage = std::aligned_storage_t<kInlineSize, alignof(std::max_align_t)>;
+
+    struct Ops
+    {
+        R (*invoke)(void* storage, Args&&... args);
+
+        // Move-constructs the function object at |to| and destroys the object at |from|.
+        void (*move)(void* from, void* to) noexcept;
+
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename Functor>
+    static constexpr bool kFitsInline = sizeof(Functor) <= kInlineSize &&
+                                        alignof(Functor) <= alignof(Storage) &&
+                                        std::is_nothrow_move_constructible_v<Functor>;
+
+    template <typename Functor>
+    static R invokeFunctor(Functor& functor, Args&&... args)
+    {
+        if constexpr (std::is_void_v<R>)
+            std::invoke(functor, std::forward<Args>(args)...);
+        else
+            return std::invoke(functor, std::forward<Args>(args)...);
+    }
+
+    template <typename Functor>
+    struct InlineOps
+    {
+        static R invoke(void* storage, Args&&... args)
+        {
+            return invokeFunctor(*static_cast<Functor*>(storage), std::forward<Args>(args)...);
+        }
+
+        static void move(void* from, void* to) noexcept
+        {
+            Functor* functor = static_cast<Functor*>(from);
+            new (to) Functor(std::move(*functor));
+            functor->~Functor();
+        }
+
+        static void destroy(void* storage) noexcept
+        {
+            static_cast<Functor*>(storage)->~Functor();
+        }
+
+        static constexpr Ops kOps = { &invoke, &move, &destroy };
+    };
+
+    template <typename Functor>
+    struct HeapOps
+    {
+        static R invoke(void* storage, Args&&... args)
+        {
+            return invokeFunctor(**static_cast<Functor**>(storage), std::forward<Args>(args)...);
+        }
+
+        static void move(void* from, void* to) noexcept
+        {
+            *static_cast<Functor**>(to) = *static_cast<Functor**>(from);
+        }
+
+        static void destroy(void* storage) noexcept
+        {
+            delete *static_cast<Functor**>(storage);
+        }
+
+        static constexpr Ops kOps = { &invoke, &move, &destroy };
+    };
+
+    template <typename F>
+    static bool isNull(const F& function)
+    {
+        if constexpr (std::is_pointer_v<F> || std::is_member_pointer_v<F>)
+            return function == nullptr;
+        else
+            return isNullFunction(function);
+    }
+
+    template <typename Signature>
+    static bool isNullFunction(const std::function<Signature>& function) { return !function; }
+
+    template <typename F>
+    static bool isNullFunction(const F& /* function */) { return false; }
+
+    void moveFrom(UniqueFunction* other) noexcept
+    {
+        if (!other->ops_)
+            return;
+
+        other->ops_->move(&other->storage_, &storage_);
+        ops_ = other->ops_;
+        other->ops_ = nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (!ops_)
+            return;
+
+        ops_->destroy(&storage_);
+        ops_ = nullptr;
+    }
+
+    Storage storage_;
+    const Ops* ops_ = nullptr;
+};
+
+} // namespace base
+
+#endif // BASE__UNIQUE_FUNCTION_H
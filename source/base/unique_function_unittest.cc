@@ -0,0 +1,118 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/unique_function.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <string>
+
+namespace base {
+
+namespace {
+
+int add(int a, int b)
+{
+    return a + b;
+}
+
+} // namespace
+
+TEST(UniqueFunctionTest, Empty)
+{
+    UniqueFunction<void()> function;
+    EXPECT_FALSE(function);
+    EXPECT_TRUE(function == nullptr);
+
+    UniqueFunction<int(int, int)> null_pointer(static_cast<int(*)(int, int)>(nullptr));
+    EXPECT_FALSE(null_pointer);
+
+    UniqueFunction<void()> null_function(std::function<void()>{});
+    EXPECT_FALSE(null_function);
+}
+
+TEST(UniqueFunctionTest, Call)
+{
+    UniqueFunction<int(int, int)> function(&add);
+    ASSERT_TRUE(function);
+    EXPECT_EQ(function(2, 3), 5);
+
+    int value = 0;
+    UniqueFunction<void(int)> lambda([&value](int new_value) { value = new_value; });
+    lambda(42);
+    EXPECT_EQ(value, 42);
+}
+
+TEST(UniqueFunctionTest, MoveOnly)
+{
+    auto pointer = std::make_unique<int>(7);
+    UniqueFunction<int()> function([pointer = std::move(pointer)]() { return *pointer; });
+
+    UniqueFunction<int()> other(std::move(function));
+    EXPECT_FALSE(function);
+    ASSERT_TRUE(other);
+    EXPECT_EQ(other(), 7);
+
+    function = std::move(other);
+    EXPECT_FALSE(other);
+    EXPECT_EQ(function(), 7);
+
+    function = nullptr;
+    EXPECT_FALSE(function);
+}
+
+TEST(UniqueFunctionTest, LargeFunctor)
+{
+    std::shared_ptr<int> counter = std::make_shared<int>(0);
+    std::array<char, UniqueFunction<void()>::kInlineSize * 2> large;
+    large.fill(1);
+
+    {
+        UniqueFunction<int()> function([counter, large]() { return large[0] + *counter; });
+        EXPECT_EQ(counter.use_count(), 2);
+
+        UniqueFunction<int()> other(std::move(function));
+        EXPECT_EQ(other(), 1);
+        EXPECT_EQ(counter.use_count(), 2);
+    }
+
+    // The function object is destroyed with the last UniqueFunction.
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(UniqueFunctionTest, Destroy)
+{
+    std::shared_ptr<int> counter = std::make_shared<int>(0);
+
+    {
+        UniqueFunction<void()> function([counter]() {});
+        EXPECT_EQ(counter.use_count(), 2);
+
+        UniqueFunction<void()> other([counter]() {});
+        EXPECT_EQ(counter.use_count(), 3);
+
+        other = std::move(function);
+        EXPECT_EQ(counter.use_count(), 2);
+    }
+
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+} // namespace base
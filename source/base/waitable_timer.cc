@@ -26,9 +26,10 @@ namespace base {
 class WaitableTimer::Impl : public std::enable_shared_from_this<Impl>
 {
 public:
-    explicit Impl(Type type,
-                  TimeoutCallback signal_callback,
-                  std::shared_ptr<TaskRunner> task_runner);
+    Impl(Type type,
+         Precision precision,
+         TimeoutCallback signal_callback,
+         std::shared_ptr<TaskRunner> task_runner);
     ~Impl();
 
     void start(const std::chrono::milliseconds& time_delta);
@@ -38,6 +39,7 @@ private:
     void onSignal();
 
     Type type_;
+    Precision precision_;
     TimeoutCallback signal_callback_;
     std::shared_ptr<TaskRunner> task_runner_;
     std::chrono::milliseconds time_delta_;
@@ -46,9 +48,11 @@ private:
 };
 
 WaitableTimer::Impl::Impl(Type type,
+                          Precision precision,
                           TimeoutCallback signal_callback,
                           std::shared_ptr<TaskRunner> task_runner)
     : type_(type),
+      precision_(precision),
       signal_callback_(std::move(signal_callback)),
       task_runner_(std::move(task_runner))
 {
@@ -62,7 +66,15 @@ WaitableTimer::Impl::~Impl()
 
 void WaitableTimer::Impl::start(const std::chrono::milliseconds& time_delta)
 {
-    task_runner_->postDelayedTask(std::bind(&Impl::onSignal, shared_from_this()), time_delta);
+    // Repeated timers are restarted with the same interval.
+    time_delta_ = time_delta;
+
+    TaskRunner::Callback callback = std::bind(&Impl::onSignal, shared_from_this());
+
+    if (precision_ == Precision::COARSE)
+        task_runner_->postCoarseDelayedTask(std::move(callback), time_delta);
+    else
+        task_runner_->postDelayedTask(std::move(callback), time_delta);
 }
 
 void WaitableTimer::Impl::dettach()
@@ -81,8 +93,11 @@ void WaitableTimer::Impl::onSignal()
         start(time_delta_);
 }
 
-WaitableTimer::WaitableTimer(Type type, std::shared_ptr<TaskRunner> task_runner)
+WaitableTimer::WaitableTimer(Type type,
+                             std::shared_ptr<TaskRunner> task_runner,
+                             Precision precision)
     : type_(type),
+      precision_(precision),
       task_runner_(std::move(task_runner))
 {
     DCHECK(task_runner_);
@@ -96,7 +111,7 @@ WaitableTimer::~WaitableTimer()
 void WaitableTimer::start(const std::chrono::milliseconds& time_delta,
                           TimeoutCallback signal_callback)
 {
-    impl_ = std::make_shared<Impl>(type_, std::move(signal_callback), task_runner_);
+    impl_ = std::make_shared<Impl>(type_, precision_, std::move(signal_callback), task_runner_);
     impl_->start(time_delta);
 }
 
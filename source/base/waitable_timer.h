@@ -34,7 +34,13 @@ class WaitableTimer
 public:
     enum class Type { SINGLE_SHOT, REPEATED };
 
-    WaitableTimer(Type type, std::shared_ptr<TaskRunner> task_runner);
+    // Coarse timers may fire a little later than requested (see timer_slack.h). They are used for
+    // timeouts and reconnects, so that the thread wakes up once for several timers.
+    enum class Precision { PRECISE, COARSE };
+
+    WaitableTimer(Type type,
+                  std::shared_ptr<TaskRunner> task_runner,
+                  Precision precision = Precision::PRECISE);
     ~WaitableTimer();
 
     using TimeoutCallback = std::function<void()>;
@@ -54,6 +60,7 @@ private:
     std::shared_ptr<Impl> impl_;
 
     Type type_;
+    Precision precision_;
     std::shared_ptr<TaskRunner> task_runner_;
 
     DISALLOW_COPY_AND_ASSIGN(WaitableTimer);
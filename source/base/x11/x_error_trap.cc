@@ -0,0 +1,67 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/x11/x_error_trap.h"
+
+#include "base/logging.h"
+
+namespace base {
+
+namespace {
+
+// The error handler is called by Xlib without any context, so the state is global.
+bool g_xserver_error_trap_enabled = false;
+int g_last_xserver_error_code = 0;
+
+int xServerErrorHandler(Display* /* display */, XErrorEvent* error_event)
+{
+    DCHECK(g_xserver_error_trap_enabled);
+    g_last_xserver_error_code = error_event->error_code;
+    return 0;
+}
+
+} // namespace
+
+XErrorTrap::XErrorTrap()
+    : original_error_handler_(nullptr)
+{
+    DCHECK(!g_xserver_error_trap_enabled);
+
+    original_error_handler_ = XSetErrorHandler(&xServerErrorHandler);
+    g_xserver_error_trap_enabled = true;
+    g_last_xserver_error_code = 0;
+}
+
+XErrorTrap::~XErrorTrap()
+{
+    if (enabled_)
+        lastErrorAndDisable();
+}
+
+int XErrorTrap::lastErrorAndDisable()
+{
+    DCHECK(enabled_);
+
+    enabled_ = false;
+    g_xserver_error_trap_enabled = false;
+    XSetErrorHandler(original_error_handler_);
+
+    return g_last_xserver_error_code;
+}
+
+} // namespace base
@@ -0,0 +1,50 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef BASE__X11__X_ERROR_TRAP_H
+#define BASE__X11__X_ERROR_TRAP_H
+
+#include "base/macros_magic.h"
+
+#include <X11/Xlib.h>
+
+namespace base {
+
+// Helper class that registers an X Window error handler. Caller can use lastErrorAndDisable() to
+// get the last error that was caught, if any. The error handler is global for the process, so the
+// trap must not be used on several threads at the same time.
+class XErrorTrap
+{
+public:
+    XErrorTrap();
+    ~XErrorTrap();
+
+    // Returns the last error code (Success if there was no error) and disables the trap. The
+    // requests which can fail must be completed (for example with XSync) before the call.
+    int lastErrorAndDisable();
+
+private:
+    XErrorHandler original_error_handler_;
+    bool enabled_ = true;
+
+    DISALLOW_COPY_AND_ASSIGN(XErrorTrap);
+};
+
+} // namespace base
+
+#endif // BASE__X11__X_ERROR_TRAP_H
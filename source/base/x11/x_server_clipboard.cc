@@ -25,6 +25,13 @@
 
 namespace base {
 
+namespace {
+
+// Further requests are refused while the announced data is not received.
+const size_t kMaxPendingRequests = 32;
+
+} // namespace
+
 XServerClipboard::XServerClipboard() = default;
 XServerClipboard::~XServerClipboard() = default;
 
@@ -92,6 +99,31 @@ void XServerClipboard::setClipboard(const std::string& data)
 
     data_ = data;
 
+    if (data_announced_)
+    {
+        data_announced_ = false;
+        data_request_callback_ = nullptr;
+        answerPendingRequests(false);
+    }
+
+    assertSelectionOwnership(XA_PRIMARY);
+    assertSelectionOwnership(clipboard_atom_);
+}
+
+void XServerClipboard::announceClipboard(const DataRequestCallback& callback)
+{
+    DCHECK(display_);
+
+    if (clipboard_window_ == BadValue)
+      return;
+
+    // The requests for the previous announcement are not answered anymore.
+    answerPendingRequests(true);
+
+    data_.clear();
+    data_announced_ = true;
+    data_request_callback_ = callback;
+
     assertSelectionOwnership(XA_PRIMARY);
     assertSelectionOwnership(clipboard_atom_);
 }
@@ -243,8 +275,30 @@ void XServerClipboard::onSelectionRequest(XEvent* event)
         }
         else if (selection_event.target == utf8_string_atom_ || selection_event.target == XA_STRING)
         {
-            sendStringResponse(selection_event.requestor, selection_event.property,
-                               selection_event.target);
+            if (data_announced_)
+            {
+                if (pending_requests_.size() < kMaxPendingRequests)
+                {
+                    // The selection is notified when the data is received. X11 allows to answer
+                    // the request later.
+                    pending_requests_.emplace_back(selection_event);
+
+                    if (data_request_callback_)
+                    {
+                        DataRequestCallback callback = std::move(data_request_callback_);
+                        data_request_callback_ = nullptr;
+                        callback();
+                    }
+                    return;
+                }
+
+                selection_event.property = None;
+            }
+            else
+            {
+                sendStringResponse(selection_event.requestor, selection_event.property,
+                                   selection_event.target);
+            }
         }
     }
     XSendEvent(display_, selection_event.requestor, False, 0,
@@ -291,6 +345,27 @@ void XServerClipboard::sendStringResponse(Window requestor, Atom property, Atom
     }
 }
 
+void XServerClipboard::answerPendingRequests(bool refuse)
+{
+    for (XSelectionEvent& selection_event : pending_requests_)
+    {
+        if (refuse)
+        {
+            selection_event.property = None;
+        }
+        else
+        {
+            sendStringResponse(selection_event.requestor, selection_event.property,
+                               selection_event.target);
+        }
+
+        XSendEvent(display_, selection_event.requestor, False, 0,
+                   reinterpret_cast<XEvent*>(&selection_event));
+    }
+
+    pending_requests_.clear();
+}
+
 void XServerClipboard::handleSelectionNotify(XSelectionEvent* event,
                                              Atom /* type */,
                                              int format,
@@ -25,6 +25,7 @@
 #include <functional>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <X11/Xlib.h>
 
@@ -39,9 +40,15 @@ public:
     using ClipboardChangedCallback =
         std::function<void(const std::string& data)>;
 
+    using DataRequestCallback = std::function<void()>;
+
     void init(Display* display, const ClipboardChangedCallback& callback);
     void setClipboard(const std::string& data);
 
+    // Takes the ownership of the selections without the data. When an application requests the
+    // string, |callback| is called and the request is answered by the next setClipboard().
+    void announceClipboard(const DataRequestCallback& callback);
+
     // Process |event| if it is an X selection notification. The caller should invoke this for every
     // event it receives from |display|.
     void processXEvent(XEvent* event);
@@ -62,6 +69,10 @@ private:
     void sendTimestampResponse(Window requestor, Atom property);
     void sendStringResponse(Window requestor, Atom property, Atom target);
 
+    // Answers the requests received after announceClipboard(). If |refuse| is true, the requestors
+    // are told that the data is not available.
+    void answerPendingRequests(bool refuse);
+
     // Called by onSelectionNotify() when the selection owner has replied to a request for
     // information about a selection.
     // |event| is the raw X event from the notification.
@@ -134,6 +145,15 @@ private:
     // |callback| argument supplied to init().
     ClipboardChangedCallback callback_;
 
+    // |callback| argument supplied to announceClipboard(). It is reset when the data is requested.
+    DataRequestCallback data_request_callback_;
+
+    // The data is announced, but it is not received yet.
+    bool data_announced_ = false;
+
+    // String requests which are answered when the announced data is received.
+    std::vector<XSelectionEvent> pending_requests_;
+
     DISALLOW_COPY_AND_ASSIGN(XServerClipboard);
 };
 
@@ -20,18 +20,41 @@
 
 #include "base/logging.h"
 #include "base/task_runner.h"
+#include "base/peer/client_authenticator.h"
 #include "base/strings/strcat.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/unicode.h"
 #include "build/build_config.h"
 #include "build/version.h"
 #include "client/status_window_proxy.h"
 
+#include <map>
+
 #if defined(OS_MAC)
 #include "base/mac/app_nap_blocker.h"
 #endif // defined(OS_MAC)
 
 namespace client {
 
+namespace {
+
+// Identifies the host and the user for which the session ticket is issued.
+std::string sessionTicketKey(const Config& config)
+{
+    return base::utf8FromUtf16(base::strCat({ config.username, u"@", config.address_or_id, u":",
+                                              base::numberToString16(config.port) }));
+}
+
+// Clients whose connection can be shared with new sessions to the same host and user. All clients
+// work in the IO thread, so the map is not protected.
+std::map<std::string, Client*>& primaryClients()
+{
+    static std::map<std::string, Client*> clients;
+    return clients;
+}
+
+} // namespace
+
 Client::Client(std::shared_ptr<base::TaskRunner> io_task_runner)
     : io_task_runner_(std::move(io_task_runner))
 {
@@ -66,6 +89,23 @@ void Client::start(const Config& config)
     config_ = config;
     state_ = State::STARTED;
 
+    auto primary = primaryClients().find(sessionTicketKey(config_));
+    if (primary != primaryClients().end() && primary->second->channel_)
+    {
+        // A session to the same host and user is already running. The new session is opened as a
+        // stream inside its connection, so no new TCP connection (or relay peer) is required.
+        channel_ = primary->second->channel_->openStream();
+        if (channel_)
+        {
+            LOG(LS_INFO) << "Starting STREAM connection";
+
+            status_window_proxy_->onStarted(config_.address_or_id);
+            channel_->setListener(this);
+            startAuthentication();
+            return;
+        }
+    }
+
     if (base::isHostId(config_.address_or_id))
     {
         LOG(LS_INFO) << "Starting RELAY connection";
@@ -105,9 +145,13 @@ void Client::stop()
         LOG(LS_INFO) << "Stopping client...";
         state_ = State::STOPPPED;
 
+        removePrimary();
+
         router_controller_.reset();
         authenticator_.reset();
-        channel_.reset();
+
+        // Sessions opened later may still use the connection as streams.
+        base::NetworkChannel::destroy(std::move(channel_));
 
         status_window_proxy_->onStopped();
 
@@ -136,7 +180,8 @@ proto::SessionType Client::sessionType() const
     return config_.session_type;
 }
 
-void Client::sendMessage(const google::protobuf::MessageLite& message)
+void Client::sendMessage(const google::protobuf::MessageLite& message,
+                         base::NetworkChannel::Priority priority)
 {
     if (!channel_)
     {
@@ -144,7 +189,7 @@ void Client::sendMessage(const google::protobuf::MessageLite& message)
         return;
     }
 
-    channel_->send(base::serialize(message));
+    channel_->send(message, priority);
 }
 
 int64_t Client::totalRx() const
@@ -191,6 +236,14 @@ int Client::speedTx()
     return channel_->speedTx();
 }
 
+std::chrono::milliseconds Client::roundTripTime() const
+{
+    if (!channel_)
+        return std::chrono::milliseconds::zero();
+
+    return channel_->estimate().rtt;
+}
+
 void Client::onConnected()
 {
     startAuthentication();
@@ -198,6 +251,8 @@ void Client::onConnected()
 
 void Client::onDisconnected(base::NetworkChannel::ErrorCode error_code)
 {
+    removePrimary();
+
     // Show an error to the user.
     status_window_proxy_->onDisconnected(error_code);
 }
@@ -209,10 +264,12 @@ void Client::onHostConnected(std::unique_ptr<base::NetworkChannel> channel)
     channel_ = std::move(channel);
     channel_->setListener(this);
 
-    startAuthentication();
+    if (router_controller_)
+        trace_.emplace(router_controller_->trace());
 
-    // Router controller is no longer needed.
-    io_task_runner_->deleteSoon(std::move(router_controller_));
+    // The router controller is kept until the authentication, its relay is used if the direct
+    // connection is not authenticated.
+    startAuthentication();
 }
 
 void Client::onErrorOccurred(const RouterController::Error& error)
@@ -220,11 +277,20 @@ void Client::onErrorOccurred(const RouterController::Error& error)
     status_window_proxy_->onRouterError(error);
 }
 
+void Client::removePrimary()
+{
+    auto primary = primaryClients().find(sessionTicketKey(config_));
+    if (primary != primaryClients().end() && primary->second == this)
+        primaryClients().erase(primary);
+}
+
 void Client::startAuthentication()
 {
     static const size_t kReadBufferSize = 2 * 1024 * 1024; // 2 Mb.
+    static const size_t kMaxBufferSize = 16 * 1024 * 1024; // 16 Mb.
 
     channel_->setReadBufferSize(kReadBufferSize);
+    channel_->setBufferAutotuning(kMaxBufferSize);
     channel_->setNoDelay(true);
 
     authenticator_ = std::make_unique<base::ClientAuthenticator>(io_task_runner_);
@@ -233,6 +299,7 @@ void Client::startAuthentication()
     authenticator_->setUserName(config_.username);
     authenticator_->setPassword(config_.password);
     authenticator_->setSessionType(config_.session_type);
+    authenticator_->setSessionTicket(base::SessionTicketCache::find(sessionTicketKey(config_)));
 
     authenticator_->start(std::move(channel_),
                           [this](base::ClientAuthenticator::ErrorCode error_code)
@@ -244,6 +311,14 @@ void Client::startAuthentication()
             channel_ = authenticator_->takeChannel();
             channel_->setListener(this);
 
+            // The ticket allows to reconnect to the host without the SRP exchange.
+            base::SessionTicketCache::store(
+                sessionTicketKey(config_), authenticator_->sessionTicket());
+
+            // Versions 2.1.0+ accept streams, the connection can be shared with new sessions.
+            if (!channel_->isStream() && authenticator_->peerVersion() >= base::Version(2, 1, 0))
+                primaryClients().emplace(sessionTicketKey(config_), this);
+
             if (authenticator_->peerVersion() >= base::Version(2, 0, 0))
             {
                 // Versions 2.0.0+ support their own implementation keep alive.
@@ -255,6 +330,13 @@ void Client::startAuthentication()
                 channel_->setTcpKeepAlive(true);
             }
 
+            if (trace_.has_value())
+                trace_->addStage("Authenticated by host");
+
+            // Router controller is no longer needed.
+            if (router_controller_)
+                io_task_runner_->deleteSoon(std::move(router_controller_));
+
             status_window_proxy_->onConnected();
 
             // Signal that everything is ready to start the session (connection established,
@@ -264,7 +346,7 @@ void Client::startAuthentication()
             // Now the session will receive incoming messages.
             channel_->resume();
         }
-        else
+        else if (!router_controller_ || !router_controller_->connectToRelayAfterFailure())
         {
             status_window_proxy_->onAccessDenied(error_code);
         }
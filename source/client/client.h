@@ -24,6 +24,8 @@
 #include "client/router_controller.h"
 #include "base/net/network_channel.h"
 
+#include <optional>
+
 namespace base {
 class ClientAuthenticator;
 class TaskRunner;
@@ -68,13 +70,15 @@ protected:
     virtual void onSessionStarted(const base::Version& peer_version) = 0;
 
     // Sends outgoing message.
-    void sendMessage(const google::protobuf::MessageLite& message);
+    void sendMessage(const google::protobuf::MessageLite& message,
+                     base::NetworkChannel::Priority priority = base::NetworkChannel::Priority::NORMAL);
 
     // Methods for obtaining network metrics.
     int64_t totalRx() const;
     int64_t totalTx() const;
     int speedRx();
     int speedTx();
+    std::chrono::milliseconds roundTripTime() const;
 
     // base::NetworkChannel::Listener implementation.
     void onConnected() override;
@@ -85,6 +89,7 @@ protected:
     void onErrorOccurred(const RouterController::Error& error) override;
 
 private:
+    void removePrimary();
     void startAuthentication();
 
     std::shared_ptr<base::TaskRunner> io_task_runner_;
@@ -93,6 +98,9 @@ private:
     std::unique_ptr<base::ClientAuthenticator> authenticator_;
     std::shared_ptr<StatusWindowProxy> status_window_proxy_;
 
+    // Trace of the connection through the router. Empty for direct connections.
+    std::optional<base::ConnectionTrace> trace_;
+
     Config config_;
 
     enum class State { CREATED, STARTED, STOPPPED };
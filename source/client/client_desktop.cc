@@ -19,16 +19,18 @@
 #include "client/client_desktop.h"
 
 #include "base/logging.h"
+#include "base/stl_util.h"
 #include "base/task_runner.h"
 #include "base/audio/audio_player.h"
 #include "base/codec/audio_decoder_opus.h"
 #include "base/codec/cursor_decoder.h"
-#include "base/codec/video_decoder.h"
 #include "base/desktop/mouse_cursor.h"
+#include "base/strings/string_split.h"
 #include "client/desktop_control_proxy.h"
 #include "client/desktop_window.h"
 #include "client/desktop_window_proxy.h"
 #include "client/config_factory.h"
+#include "client/video_decode_worker.h"
 #include "common/desktop_session_constants.h"
 
 namespace client {
@@ -51,13 +53,41 @@ size_t calculateAvgSize(size_t last_avg_size, size_t bytes)
         ((1.0 - kAlpha) * static_cast<double>(last_avg_size)));
 }
 
+int64_t calculateAvgTime(int64_t last_avg_time, int64_t time)
+{
+    static const double kAlpha = 0.1;
+    return static_cast<int64_t>(
+        (kAlpha * static_cast<double>(time)) +
+        ((1.0 - kAlpha) * static_cast<double>(last_avg_time)));
+}
+
+// Adds the durations of the host stages of a frame to the averages in |latency|.
+void updateHostLatency(const proto::VideoPacketTiming& timing, DesktopWindow::Latency* latency)
+{
+    latency->capture = calculateAvgTime(latency->capture, timing.capture());
+    latency->diff = calculateAvgTime(latency->diff, timing.diff());
+    latency->host_wait = calculateAvgTime(latency->host_wait, timing.wait());
+    latency->scale = calculateAvgTime(latency->scale, timing.scale());
+    latency->encode = calculateAvgTime(latency->encode, timing.encode());
+    latency->enqueue = calculateAvgTime(latency->enqueue, timing.enqueue());
+    latency->send = calculateAvgTime(latency->send, timing.send());
+}
+
+base::AudioOutput::Latency audioLatency(const proto::DesktopConfig& config)
+{
+    if (config.flags() & proto::LOW_LATENCY_AUDIO)
+        return base::AudioOutput::Latency::LOW;
+
+    return base::AudioOutput::Latency::NORMAL;
+}
+
 } // namespace
 
 ClientDesktop::ClientDesktop(std::shared_ptr<base::TaskRunner> io_task_runner)
     : Client(io_task_runner),
       desktop_control_proxy_(std::make_shared<DesktopControlProxy>(io_task_runner, this)),
       incoming_message_(std::make_unique<proto::HostToClient>()),
-      outgoing_message_(std::make_unique<proto::ClientToHost>())
+      outgoing_message_(outgoing_arena_.create<proto::ClientToHost>())
 {
     // Nothing
 }
@@ -85,7 +115,7 @@ void ClientDesktop::onSessionStarted(const base::Version& peer_version)
     clipboard_monitor_ = std::make_unique<common::ClipboardMonitor>();
     clipboard_monitor_->start(ioTaskRunner(), this);
 
-    audio_player_ = base::AudioPlayer::create();
+    // The audio player is created with the first audio packet (see readAudioPacket).
 }
 
 void ClientDesktop::onMessageReceived(const base::ByteArray& buffer)
@@ -94,17 +124,22 @@ void ClientDesktop::onMessageReceived(const base::ByteArray& buffer)
 
     if (!base::parse(buffer, incoming_message_.get()))
     {
-        LOG(LS_ERROR) << "Invalid message from host";
+        LOG_EVERY_T(LS_ERROR, std::chrono::seconds(1)) << "Invalid message from host";
         return;
     }
 
-    if (incoming_message_->has_video_packet() || incoming_message_->has_cursor_shape())
+    if (incoming_message_->has_video_packet() || incoming_message_->has_cursor_shape() ||
+        incoming_message_->has_cursor_position())
     {
         if (incoming_message_->has_video_packet())
-            readVideoPacket(incoming_message_->video_packet());
+            readVideoPacket(
+                std::unique_ptr<proto::VideoPacket>(incoming_message_->release_video_packet()));
 
         if (incoming_message_->has_cursor_shape())
             readCursorShape(incoming_message_->cursor_shape());
+
+        if (incoming_message_->has_cursor_position())
+            readCursorPosition(incoming_message_->cursor_position());
     }
     else if (incoming_message_->has_audio_packet())
     {
@@ -125,13 +160,18 @@ void ClientDesktop::onMessageReceived(const base::ByteArray& buffer)
     else
     {
         // Unknown messages are ignored.
-        LOG(LS_WARNING) << "Unhandled message from host";
+        LOG_EVERY_T(LS_WARNING, std::chrono::seconds(1)) << "Unhandled message from host";
     }
 }
 
-void ClientDesktop::onMessageWritten(size_t /* pending */)
+void ClientDesktop::onMessageWritten(size_t pending)
 {
-    // Nothing
+    if (pending)
+        return;
+
+    // All queued messages are written. The last mouse move received meanwhile can be sent.
+    mouse_move_in_flight_ = false;
+    sendPendingMouseMove();
 }
 
 void ClientDesktop::onClipboardEvent(const proto::ClipboardEvent& event)
@@ -140,9 +180,22 @@ void ClientDesktop::onClipboardEvent(const proto::ClipboardEvent& event)
     if (!out_event.has_value())
         return;
 
-    outgoing_message_->Clear();
-    outgoing_message_->mutable_clipboard_event()->CopyFrom(out_event.value());
-    sendMessage(*outgoing_message_);
+    if (!clipboard_chunks_supported_)
+    {
+        outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+        outgoing_message_->mutable_clipboard_event()->CopyFrom(out_event.value());
+        sendMessage(*outgoing_message_);
+        return;
+    }
+
+    // The clipboard is sent after the input queued at the same time. Small events have the same
+    // priority as the parts, so they are not mixed with the parts of a large one.
+    for (proto::ClipboardEvent& part : common::ClipboardChunker::split(out_event.value()))
+    {
+        outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+        outgoing_message_->mutable_clipboard_event()->Swap(&part);
+        sendMessage(*outgoing_message_, base::NetworkChannel::Priority::LOW);
+    }
 }
 
 void ClientDesktop::setDesktopConfig(const proto::DesktopConfig& desktop_config)
@@ -167,7 +220,18 @@ void ClientDesktop::setDesktopConfig(const proto::DesktopConfig& desktop_config)
 
     input_event_filter_.setClipboardEnabled(desktop_config_.flags() & proto::ENABLE_CLIPBOARD);
 
-    outgoing_message_->Clear();
+    // The latency of the audio output is chosen when the device is opened. The player is created
+    // again with the next audio packet.
+    const base::AudioOutput::Latency audio_latency = audioLatency(desktop_config_);
+    if (audio_player_ && audio_player_->latency() != audio_latency)
+    {
+        LOG(LS_INFO) << "Audio player is created again (low latency: "
+                     << (audio_latency == base::AudioOutput::Latency::LOW) << ")";
+        audio_player_.reset();
+    }
+    audio_player_error_ = false;
+
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
     outgoing_message_->mutable_config()->CopyFrom(desktop_config_);
 
     LOG(LS_INFO) << "Send new config to host";
@@ -178,7 +242,7 @@ void ClientDesktop::setCurrentScreen(const proto::Screen& screen)
 {
     LOG(LS_INFO) << "Current screen changed: " << screen.id();
 
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
     proto::DesktopExtension* extension = outgoing_message_->mutable_extension();
 
     extension->set_name(common::kSelectScreenExtension);
@@ -191,7 +255,7 @@ void ClientDesktop::setPreferredSize(int width, int height)
 {
     LOG(LS_INFO) << "Preferred size changed: " << width << "x" << height;
 
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
 
     proto::PreferredSize preferred_size;
     preferred_size.set_width(width);
@@ -205,16 +269,68 @@ void ClientDesktop::setPreferredSize(int width, int height)
     sendMessage(*outgoing_message_);
 }
 
+void ClientDesktop::setViewport(int x, int y, int width, int height)
+{
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+
+    proto::Viewport viewport;
+    viewport.set_x(x);
+    viewport.set_y(y);
+    viewport.set_width(width);
+    viewport.set_height(height);
+
+    proto::DesktopExtension* extension = outgoing_message_->mutable_extension();
+
+    extension->set_name(common::kViewportExtension);
+    extension->set_data(viewport.SerializeAsString());
+
+    sendMessage(*outgoing_message_);
+}
+
+void ClientDesktop::setVisibility(bool visible)
+{
+    LOG(LS_INFO) << "Window visibility changed: " << visible;
+
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+
+    proto::Visibility visibility;
+    visibility.set_visible(visible);
+
+    proto::DesktopExtension* extension = outgoing_message_->mutable_extension();
+
+    extension->set_name(common::kVisibilityExtension);
+    extension->set_data(visibility.SerializeAsString());
+
+    sendMessage(*outgoing_message_);
+}
+
+void ClientDesktop::setWindowState(bool visible, bool focused)
+{
+    using Priority = VideoDecodePool::Priority;
+
+    if (!visible)
+        decode_priority_ = Priority::BACKGROUND;
+    else
+        decode_priority_ = focused ? Priority::FOCUSED : Priority::VISIBLE;
+
+    if (video_decode_worker_)
+        video_decode_worker_->setPriority(decode_priority_);
+}
+
 void ClientDesktop::onKeyEvent(const proto::KeyEvent& event)
 {
     std::optional<proto::KeyEvent> out_event = input_event_filter_.keyEvent(event);
     if (!out_event.has_value())
         return;
 
-    outgoing_message_->Clear();
+    // The cursor must be at its last position when the key is pressed.
+    sendPendingMouseMove();
+
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
     outgoing_message_->mutable_key_event()->CopyFrom(out_event.value());
 
-    sendMessage(*outgoing_message_);
+    // Input events should not wait in the queue behind other messages.
+    sendMessage(*outgoing_message_, base::NetworkChannel::Priority::HIGH);
 }
 
 void ClientDesktop::onMouseEvent(const proto::MouseEvent& event)
@@ -223,10 +339,47 @@ void ClientDesktop::onMouseEvent(const proto::MouseEvent& event)
     if (!out_event.has_value())
         return;
 
-    outgoing_message_->Clear();
-    outgoing_message_->mutable_mouse_event()->CopyFrom(out_event.value());
+    static const uint32_t kWheelMask = proto::MouseEvent::WHEEL_DOWN | proto::MouseEvent::WHEEL_UP;
 
-    sendMessage(*outgoing_message_);
+    uint32_t mask = out_event->mask();
+    bool is_move = !(mask & kWheelMask) && mask == last_mouse_mask_;
+
+    last_mouse_mask_ = mask & ~kWheelMask;
+
+    if (is_move)
+    {
+        // While the previous move is not written to the channel, only the last position is kept.
+        // It is sent when the channel has written all queued messages.
+        pending_mouse_move_ = std::move(out_event);
+
+        if (!mouse_move_in_flight_)
+            sendPendingMouseMove();
+        return;
+    }
+
+    // Clicks and the wheel are sent immediately. The event has the current position of the cursor,
+    // so the pending move is no longer needed.
+    pending_mouse_move_.reset();
+    sendMouseEvent(out_event.value());
+}
+
+void ClientDesktop::sendPendingMouseMove()
+{
+    if (!pending_mouse_move_.has_value())
+        return;
+
+    sendMouseEvent(pending_mouse_move_.value());
+    pending_mouse_move_.reset();
+    mouse_move_in_flight_ = true;
+}
+
+void ClientDesktop::sendMouseEvent(const proto::MouseEvent& event)
+{
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+    outgoing_message_->mutable_mouse_event()->CopyFrom(event);
+
+    // Input events should not wait in the queue behind other messages.
+    sendMessage(*outgoing_message_, base::NetworkChannel::Priority::HIGH);
 }
 
 void ClientDesktop::onPowerControl(proto::PowerControl::Action action)
@@ -237,7 +390,7 @@ void ClientDesktop::onPowerControl(proto::PowerControl::Action action)
         return;
     }
 
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
 
     proto::DesktopExtension* extension = outgoing_message_->mutable_extension();
 
@@ -252,15 +405,24 @@ void ClientDesktop::onPowerControl(proto::PowerControl::Action action)
 
 void ClientDesktop::onRemoteUpdate()
 {
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
     outgoing_message_->mutable_extension()->set_name(common::kRemoteUpdateExtension);
     sendMessage(*outgoing_message_);
 }
 
-void ClientDesktop::onSystemInfoRequest()
+void ClientDesktop::onSystemInfoRequest(bool refresh)
 {
-    outgoing_message_->Clear();
-    outgoing_message_->mutable_extension()->set_name(common::kSystemInfoExtension);
+    // The window shows all categories.
+    proto::SystemInfoRequest request;
+    request.set_categories(proto::SystemInfoRequest::CATEGORY_ALL);
+    request.set_refresh(refresh);
+
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+
+    proto::DesktopExtension* extension = outgoing_message_->mutable_extension();
+    extension->set_name(common::kSystemInfoExtension);
+    extension->set_data(request.SerializeAsString());
+
     sendMessage(*outgoing_message_);
 }
 
@@ -318,6 +480,17 @@ void ClientDesktop::onMetricsRequest()
     metrics.read_clipboard = input_event_filter_.readClipboardCount();
     metrics.send_clipboard = input_event_filter_.sendClipboardCount();
 
+    metrics.latency = host_latency_;
+    metrics.latency.network = std::chrono::duration_cast<std::chrono::microseconds>(
+        roundTripTime()).count() / 2;
+
+    if (video_decode_worker_)
+    {
+        VideoDecodeWorker::Timing decode_timing = video_decode_worker_->timing();
+        metrics.latency.decode_wait = decode_timing.wait.count();
+        metrics.latency.decode = decode_timing.decode.count();
+    }
+
     desktop_window_proxy_->setMetrics(metrics);
 }
 
@@ -330,6 +503,37 @@ void ClientDesktop::readConfigRequest(const proto::DesktopConfigRequest& config_
     desktop_window_proxy_->setCapabilities(
         config_request.extensions(), config_request.video_encodings());
 
+    std::vector<std::string_view> extensions_list = base::splitStringView(
+        config_request.extensions(), ";", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    video_recovery_supported_ =
+        base::contains(extensions_list, common::kVideoRecoveryExtension);
+
+    if (!clipboard_chunks_supported_ &&
+        base::contains(extensions_list, common::kClipboardChunksExtension))
+    {
+        // The host sends large clipboard data in parts only after the client has confirmed that it
+        // can receive them.
+        clipboard_chunks_supported_ = true;
+
+        outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+        outgoing_message_->mutable_extension()->set_name(common::kClipboardChunksExtension);
+        sendMessage(*outgoing_message_);
+    }
+
+    if (!clipboard_lazy_supported_ &&
+        base::contains(extensions_list, common::kClipboardLazyExtension))
+    {
+        // Both sides announce the clipboard changes and send the data when it is pasted.
+        clipboard_lazy_supported_ = true;
+
+        outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+        outgoing_message_->mutable_extension()->set_name(common::kClipboardLazyExtension);
+        sendMessage(*outgoing_message_);
+
+        if (clipboard_monitor_)
+            clipboard_monitor_->setLazy(true);
+    }
+
     // If current video encoding not supported.
     if (!(config_request.video_encodings() & desktop_config_.video_encoding()))
     {
@@ -345,87 +549,56 @@ void ClientDesktop::readConfigRequest(const proto::DesktopConfigRequest& config_
     }
 }
 
-void ClientDesktop::readVideoPacket(const proto::VideoPacket& packet)
+void ClientDesktop::readVideoPacket(std::unique_ptr<proto::VideoPacket> packet)
 {
-    if (video_encoding_ != packet.encoding())
-    {
-        video_decoder_ = base::VideoDecoder::create(packet.encoding());
-        video_encoding_ = packet.encoding();
-
-        LOG(LS_INFO) << "Video encoding changed to: " << video_encoding_;
-    }
-
-    if (!video_decoder_)
-    {
-        LOG(LS_ERROR) << "Video decoder not initialized";
-        return;
-    }
-
-    if (packet.has_format())
-    {
-        const proto::VideoPacketFormat& format = packet.format();
-        base::Size video_size(format.video_rect().width(), format.video_rect().height());
-        base::Size screen_size = video_size;
-
-        static const int kMaxValue = std::numeric_limits<uint16_t>::max();
-
-        if (video_size.width()  <= 0 || video_size.width()  >= kMaxValue ||
-            video_size.height() <= 0 || video_size.height() >= kMaxValue)
-        {
-            LOG(LS_ERROR) << "Wrong video frame size";
-            return;
-        }
-
-        if (format.has_screen_size())
-        {
-            screen_size = base::Size(
-                format.screen_size().width(), format.screen_size().height());
-
-            if (screen_size.width() <= 0 || screen_size.width() >= kMaxValue ||
-                screen_size.height() <= 0 || screen_size.height() >= kMaxValue)
-            {
-                LOG(LS_ERROR) << "Wrong screen size";
-                return;
-            }
-        }
-
-        video_capturer_type_ = format.capturer_type();
-
-        LOG(LS_INFO) << "New video size: " << video_size.width() << "x" << video_size.height();
-        LOG(LS_INFO) << "New screen size: " << screen_size.width() << "x" << screen_size.height();
-
-        desktop_frame_ = desktop_window_proxy_->allocateFrame(video_size);
-        desktop_window_proxy_->setFrame(screen_size, desktop_frame_);
-    }
-
-    if (!desktop_frame_)
+    if (!video_decode_worker_)
     {
-        LOG(LS_ERROR) << "The desktop frame is not initialized";
-        return;
+        video_decode_worker_ = std::make_unique<VideoDecodeWorker>(desktop_window_proxy_);
+        video_decode_worker_->setPriority(decode_priority_);
     }
 
-    if (!video_decoder_->decode(packet, desktop_frame_.get()))
-    {
-        LOG(LS_ERROR) << "The video packet could not be decoded";
-        return;
-    }
+    if (packet->has_format())
+        video_capturer_type_ = packet->format().capturer_type();
 
     ++video_packet_count_;
     ++fps_frame_count_;
 
-    size_t packet_size = packet.ByteSizeLong();
+    size_t packet_size = packet->ByteSizeLong();
 
     avg_video_packet_ = calculateAvgSize(avg_video_packet_, packet_size);
     min_video_packet_ = std::min(min_video_packet_, packet_size);
     max_video_packet_ = std::max(max_video_packet_, packet_size);
 
-    desktop_window_proxy_->drawFrame();
+    if (packet->has_timing())
+        updateHostLatency(packet->timing(), &host_latency_);
+
+    // Packets can be dropped only if the host can start the video again with a key frame.
+    if (!video_decode_worker_->decode(std::move(packet), video_recovery_supported_))
+    {
+        LOG(LS_INFO) << "Request video recovery";
+
+        outgoing_message_ = outgoing_arena_.resetAndCreate<proto::ClientToHost>();
+        outgoing_message_->mutable_extension()->set_name(common::kVideoRecoveryExtension);
+        sendMessage(*outgoing_message_, base::NetworkChannel::Priority::HIGH);
+    }
 }
 
 void ClientDesktop::readAudioPacket(const proto::AudioPacket& packet)
 {
     if (!audio_player_)
-        return;
+    {
+        // Opening the audio device takes a while, so it is not done before the first frame.
+        if (audio_player_error_)
+            return;
+
+        audio_player_ = base::AudioPlayer::create(audioLatency(desktop_config_));
+        if (!audio_player_)
+        {
+            LOG(LS_WARNING) << "Unable to create audio player";
+            audio_player_error_ = true;
+            return;
+        }
+    }
 
     if (packet.encoding() != audio_encoding_)
     {
@@ -478,6 +651,21 @@ void ClientDesktop::readCursorShape(const proto::CursorShape& cursor_shape)
     desktop_window_proxy_->setMouseCursor(mouse_cursor);
 }
 
+void ClientDesktop::readCursorPosition(const proto::CursorPosition& cursor_position)
+{
+    if (!(desktop_config_.flags() & proto::ENABLE_CURSOR_POSITION))
+    {
+        LOG(LS_WARNING) << "Cursor position received but disabled in client";
+        return;
+    }
+
+    // The host has moved the cursor. The pending move of the local mouse is out of date.
+    pending_mouse_move_.reset();
+
+    desktop_window_proxy_->setMouseCursorPosition(
+        base::Point(cursor_position.x(), cursor_position.y()));
+}
+
 void ClientDesktop::readClipboardEvent(const proto::ClipboardEvent& event)
 {
     if (!clipboard_monitor_)
@@ -486,7 +674,12 @@ void ClientDesktop::readClipboardEvent(const proto::ClipboardEvent& event)
         return;
     }
 
-    std::optional<proto::ClipboardEvent> out_event = input_event_filter_.readClipboardEvent(event);
+    std::optional<proto::ClipboardEvent> whole_event = clipboard_chunker_.addPart(event);
+    if (!whole_event.has_value())
+        return;
+
+    std::optional<proto::ClipboardEvent> out_event =
+        input_event_filter_.readClipboardEvent(*whole_event);
     if (!out_event.has_value())
         return;
 
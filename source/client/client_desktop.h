@@ -20,25 +20,27 @@
 #define CLIENT__CLIENT_DESKTOP_H
 
 #include "base/macros_magic.h"
+#include "base/memory/message_arena.h"
 #include "client/client.h"
 #include "client/desktop_control.h"
+#include "client/desktop_window.h"
 #include "client/input_event_filter.h"
+#include "client/video_decode_pool.h"
+#include "common/clipboard_chunker.h"
 #include "common/clipboard_monitor.h"
 
 namespace base {
 class AudioDecoder;
 class AudioPlayer;
 class CursorDecoder;
-class Frame;
-class VideoDecoder;
 } // namespace base
 
 namespace client {
 
 class AudioRenderer;
 class DesktopControlProxy;
-class DesktopWindow;
 class DesktopWindowProxy;
+class VideoDecodeWorker;
 
 class ClientDesktop
     : public Client,
@@ -55,11 +57,14 @@ public:
     void setDesktopConfig(const proto::DesktopConfig& config) override;
     void setCurrentScreen(const proto::Screen& screen) override;
     void setPreferredSize(int width, int height) override;
+    void setViewport(int x, int y, int width, int height) override;
+    void setVisibility(bool visible) override;
+    void setWindowState(bool visible, bool focused) override;
     void onKeyEvent(const proto::KeyEvent& event) override;
     void onMouseEvent(const proto::MouseEvent& event) override;
     void onPowerControl(proto::PowerControl::Action action) override;
     void onRemoteUpdate() override;
-    void onSystemInfoRequest() override;
+    void onSystemInfoRequest(bool refresh) override;
     void onMetricsRequest() override;
 
 protected:
@@ -75,33 +80,53 @@ protected:
 
 private:
     void readConfigRequest(const proto::DesktopConfigRequest& config_request);
-    void readVideoPacket(const proto::VideoPacket& packet);
+    void readVideoPacket(std::unique_ptr<proto::VideoPacket> packet);
     void readAudioPacket(const proto::AudioPacket& packet);
     void readCursorShape(const proto::CursorShape& cursor_shape);
+    void readCursorPosition(const proto::CursorPosition& cursor_position);
     void readClipboardEvent(const proto::ClipboardEvent& event);
     void readExtension(const proto::DesktopExtension& extension);
+    void sendPendingMouseMove();
+    void sendMouseEvent(const proto::MouseEvent& event);
 
     bool started_ = false;
 
     std::shared_ptr<DesktopControlProxy> desktop_control_proxy_;
     std::shared_ptr<DesktopWindowProxy> desktop_window_proxy_;
-    std::shared_ptr<base::Frame> desktop_frame_;
     proto::DesktopConfig desktop_config_;
 
+    // The incoming message is on the heap because the video packets are moved out of it. The
+    // outgoing message is created again in its arena for every message.
     std::unique_ptr<proto::HostToClient> incoming_message_;
-    std::unique_ptr<proto::ClientToHost> outgoing_message_;
+    base::MessageArena outgoing_arena_;
+    proto::ClientToHost* outgoing_message_;
 
-    proto::VideoEncoding video_encoding_ = proto::VIDEO_ENCODING_UNKNOWN;
     proto::AudioEncoding audio_encoding_ = proto::AUDIO_ENCODING_UNKNOWN;
 
-    std::unique_ptr<base::VideoDecoder> video_decoder_;
+    std::unique_ptr<VideoDecodeWorker> video_decode_worker_;
+    VideoDecodePool::Priority decode_priority_ = VideoDecodePool::Priority::VISIBLE;
+
+    // The host can start the video again with a key frame when the client drops packets.
+    bool video_recovery_supported_ = false;
+
     std::unique_ptr<base::CursorDecoder> cursor_decoder_;
     std::unique_ptr<base::AudioDecoder> audio_decoder_;
     std::unique_ptr<base::AudioPlayer> audio_player_;
+    bool audio_player_error_ = false;
     std::unique_ptr<common::ClipboardMonitor> clipboard_monitor_;
 
+    // Large clipboard data is sent in parts if the host can receive them.
+    bool clipboard_chunks_supported_ = false;
+    common::ClipboardChunker clipboard_chunker_;
+    bool clipboard_lazy_supported_ = false;
+
     InputEventFilter input_event_filter_;
 
+    // Mouse moves are coalesced: a new move is sent only after the previous one is written.
+    std::optional<proto::MouseEvent> pending_mouse_move_;
+    bool mouse_move_in_flight_ = false;
+    uint32_t last_mouse_mask_ = 0;
+
     using Clock = std::chrono::high_resolution_clock;
     using TimePoint = std::chrono::time_point<Clock>;
 
@@ -119,6 +144,10 @@ private:
     size_t avg_audio_packet_ = 0;
     int fps_ = 0;
 
+    // Averages of the host stages of the video frames. The client stages are added to them by the
+    // decoder and the window.
+    DesktopWindow::Latency host_latency_;
+
     DISALLOW_COPY_AND_ASSIGN(ClientDesktop);
 };
 
@@ -22,18 +22,31 @@
 #include "base/task_runner.h"
 #include "client/file_control_proxy.h"
 #include "client/file_manager_window_proxy.h"
+#include "client/file_transfer_window_proxy.h"
+#include "client/folder_sync.h"
 #include "common/file_task_factory.h"
 #include "common/file_task_consumer_proxy.h"
 #include "common/file_task_producer_proxy.h"
 #include "common/file_worker.h"
 
+#include <algorithm>
+
 namespace client {
 
+namespace {
+
+// The first page of a directory is small, so that it is shown immediately.
+const uint32_t kFirstFileListPageSize = 256;
+const uint32_t kMaxFileListPageSize = 65536;
+
+} // namespace
+
 ClientFileTransfer::ClientFileTransfer(std::shared_ptr<base::TaskRunner> io_task_runner)
     : Client(io_task_runner),
       task_consumer_proxy_(std::make_shared<common::FileTaskConsumerProxy>(this)),
       task_producer_proxy_(std::make_shared<common::FileTaskProducerProxy>(this)),
-      local_worker_(std::make_unique<common::FileWorker>(io_task_runner)),
+      local_worker_(std::make_unique<common::FileWorker>(
+          io_task_runner, common::FileWorker::ThreadMode::IO_THREADS)),
       file_control_proxy_(std::make_shared<FileControlProxy>(io_task_runner, this))
 {
     // Nothing
@@ -47,6 +60,7 @@ ClientFileTransfer::~ClientFileTransfer()
 
     remover_.reset();
     transfer_.reset();
+    sync_.reset();
 }
 
 void ClientFileTransfer::setFileManagerWindow(
@@ -89,9 +103,6 @@ void ClientFileTransfer::onMessageReceived(const base::ByteArray& buffer)
 
         // Remove the request from the queue.
         remote_task_queue_.pop();
-
-        // Execute the next request.
-        doNextRemoteTask();
     }
     else
     {
@@ -116,8 +127,27 @@ void ClientFileTransfer::onTaskDone(std::shared_ptr<common::FileTask> task)
     }
     else if (request.has_file_list_request())
     {
-        file_manager_window_proxy_->onFileList(
-            task->target(), reply.error_code(), reply.file_list());
+        const proto::FileListRequest& file_list_request = request.file_list_request();
+
+        if (file_list_request.next_page())
+        {
+            file_manager_window_proxy_->onFileListContinued(task->target(), reply.file_list());
+        }
+        else
+        {
+            file_manager_window_proxy_->onFileList(
+                task->target(), reply.error_code(), reply.file_list());
+        }
+
+        if (reply.error_code() == proto::FILE_ERROR_SUCCESS && reply.file_list().has_more())
+        {
+            // The pages grow, so that large directories do not need too many requests.
+            const uint32_t page_size =
+                std::min(file_list_request.page_size() * 2, kMaxFileListPageSize);
+
+            task_consumer_proxy_->doTask(taskFactory(task->target())->fileList(
+                file_list_request.path(), page_size, true));
+        }
     }
     else if (request.has_create_directory_request())
     {
@@ -141,26 +171,15 @@ void ClientFileTransfer::doTask(std::shared_ptr<common::FileTask> task)
     }
     else
     {
-        const bool schedule = remote_task_queue_.empty();
+        // The host executes requests one by one and replies in the same order. The request is
+        // sent right away, so that several requests (for example, file packets) can be in flight.
+        sendMessage(task->request());
 
-        // Add the request to the queue.
+        // Add the request to the queue. It is removed when the reply is received.
         remote_task_queue_.emplace(std::move(task));
-
-        // If the request queue was empty, then run execution.
-        if (schedule)
-            doNextRemoteTask();
     }
 }
 
-void ClientFileTransfer::doNextRemoteTask()
-{
-    if (remote_task_queue_.empty())
-        return;
-
-    // Send a request to the remote computer.
-    sendMessage(remote_task_queue_.front()->request());
-}
-
 common::FileTaskFactory* ClientFileTransfer::taskFactory(common::FileTask::Target target)
 {
     common::FileTaskFactory* task_factory;
@@ -186,7 +205,7 @@ void ClientFileTransfer::driveList(common::FileTask::Target target)
 
 void ClientFileTransfer::fileList(common::FileTask::Target target, const std::string& path)
 {
-    task_consumer_proxy_->doTask(taskFactory(target)->fileList(path));
+    task_consumer_proxy_->doTask(taskFactory(target)->fileList(path, kFirstFileListPageSize));
 }
 
 void ClientFileTransfer::createDirectory(common::FileTask::Target target, const std::string& path)
@@ -233,4 +252,26 @@ void ClientFileTransfer::transfer(std::shared_ptr<FileTransferWindowProxy> trans
     });
 }
 
+void ClientFileTransfer::startSync(std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
+                                   const std::string& local_path,
+                                   const std::string& remote_path)
+{
+    DCHECK(!sync_);
+
+    // The folder watcher needs a thread with an I/O message loop.
+    sync_ = std::make_unique<FolderSync>(
+        ioTaskRunner(), transfer_window_proxy, task_consumer_proxy_);
+
+    if (!sync_->start(local_path, remote_path))
+    {
+        sync_.reset();
+        transfer_window_proxy->stop();
+    }
+}
+
+void ClientFileTransfer::stopSync()
+{
+    sync_.reset();
+}
+
 } // namespace client
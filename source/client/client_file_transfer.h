@@ -39,6 +39,7 @@ namespace client {
 
 class FileControlProxy;
 class FileManagerWindowProxy;
+class FolderSync;
 
 class ClientFileTransfer
     : public Client,
@@ -67,8 +68,6 @@ protected:
     void onTaskDone(std::shared_ptr<common::FileTask> task) override;
 
 private:
-    void doNextRemoteTask();
-
     common::FileTaskFactory* taskFactory(common::FileTask::Target target);
 
     // FileControl implementation.
@@ -86,6 +85,10 @@ private:
                   const std::string& source_path,
                   const std::string& target_path,
                   const std::vector<FileTransfer::Item>& items) override;
+    void startSync(std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
+                   const std::string& local_path,
+                   const std::string& remote_path) override;
+    void stopSync() override;
 
     std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy_;
     std::shared_ptr<common::FileTaskProducerProxy> task_producer_proxy_;
@@ -100,6 +103,7 @@ private:
     std::shared_ptr<FileManagerWindowProxy> file_manager_window_proxy_;
     std::unique_ptr<FileRemover> remover_;
     std::unique_ptr<FileTransfer> transfer_;
+    std::unique_ptr<FolderSync> sync_;
 
     DISALLOW_COPY_AND_ASSIGN(ClientFileTransfer);
 };
@@ -26,6 +26,7 @@ namespace {
 
 const proto::VideoEncoding kDefaultVideoEncoding = proto::VIDEO_ENCODING_VP8;
 const proto::AudioEncoding kDefaultAudioEncoding = proto::AUDIO_ENCODING_OPUS;
+const uint32_t kLowLatencyAudioFrameDuration = 10; // 10 ms.
 
 } // namespace
 
@@ -45,6 +46,14 @@ proto::DesktopConfig ConfigFactory::defaultDesktopViewConfig()
     return config;
 }
 
+// static
+proto::DesktopConfig ConfigFactory::defaultDesktopPreviewConfig()
+{
+    proto::DesktopConfig config;
+    setDefaultDesktopPreviewConfig(&config);
+    return config;
+}
+
 // static
 void ConfigFactory::setDefaultDesktopManageConfig(proto::DesktopConfig* config)
 {
@@ -76,6 +85,19 @@ void ConfigFactory::setDefaultDesktopViewConfig(proto::DesktopConfig* config)
     fixupDesktopConfig(config);
 }
 
+// static
+void ConfigFactory::setDefaultDesktopPreviewConfig(proto::DesktopConfig* config)
+{
+    DCHECK(config);
+
+    // The preview does not change the desktop of the host and has no sound.
+    config->set_flags(proto::PREVIEW_MODE);
+    config->set_video_encoding(kDefaultVideoEncoding);
+    config->set_audio_encoding(proto::AUDIO_ENCODING_UNKNOWN);
+
+    fixupDesktopConfig(config);
+}
+
 // static
 void ConfigFactory::fixupDesktopConfig(proto::DesktopConfig* config)
 {
@@ -89,6 +111,20 @@ void ConfigFactory::fixupDesktopConfig(proto::DesktopConfig* config)
 
     if (config->audio_encoding() == proto::AUDIO_ENCODING_DEFAULT)
         config->set_audio_encoding(kDefaultAudioEncoding);
+
+    // Low latency audio uses the shortest Opus frames. The client plays them with small device
+    // buffers and a small jitter buffer.
+    if (config->flags() & proto::LOW_LATENCY_AUDIO)
+        config->set_audio_frame_duration(kLowLatencyAudioFrameDuration);
+    else
+        config->set_audio_frame_duration(0);
+
+    // The cursor is drawn by the client only if the cursor shape is received. In this case the
+    // client also follows the cursor when it is moved on the host.
+    if (config->flags() & proto::ENABLE_CURSOR_SHAPE)
+        config->set_flags(config->flags() | proto::ENABLE_CURSOR_POSITION);
+    else
+        config->set_flags(config->flags() & ~proto::ENABLE_CURSOR_POSITION);
 }
 
 } // namespace client
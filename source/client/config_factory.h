@@ -29,9 +29,11 @@ class ConfigFactory
 public:
     static proto::DesktopConfig defaultDesktopManageConfig();
     static proto::DesktopConfig defaultDesktopViewConfig();
+    static proto::DesktopConfig defaultDesktopPreviewConfig();
 
     static void setDefaultDesktopManageConfig(proto::DesktopConfig* config);
     static void setDefaultDesktopViewConfig(proto::DesktopConfig* config);
+    static void setDefaultDesktopPreviewConfig(proto::DesktopConfig* config);
 
     // Corrects invalid values in the configuration if they are.
     static void fixupDesktopConfig(proto::DesktopConfig* config);
@@ -32,12 +32,20 @@ public:
     virtual void setDesktopConfig(const proto::DesktopConfig& desktop_config) = 0;
     virtual void setCurrentScreen(const proto::Screen& screen) = 0;
     virtual void setPreferredSize(int width, int height) = 0;
+    // The visible area of the video in the window. An empty area means the whole video.
+    virtual void setViewport(int x, int y, int width, int height) = 0;
+    // The window is minimized or hidden (|visible| is false) or shown again.
+    virtual void setVisibility(bool visible) = 0;
+    // Local state of the window. The video of the focused window is decoded first and the video
+    // of a hidden window is decoded last (see VideoDecodePool).
+    virtual void setWindowState(bool visible, bool focused) = 0;
 
     virtual void onKeyEvent(const proto::KeyEvent& event) = 0;
     virtual void onMouseEvent(const proto::MouseEvent& event) = 0;
     virtual void onPowerControl(proto::PowerControl::Action action) = 0;
     virtual void onRemoteUpdate() = 0;
-    virtual void onSystemInfoRequest() = 0;
+    // If |refresh| is set, the host collects the information again instead of using its cache.
+    virtual void onSystemInfoRequest(bool refresh) = 0;
     virtual void onMetricsRequest() = 0;
 };
 
@@ -83,12 +83,52 @@ void DesktopControlProxy::setPreferredSize(int width, int height)
         desktop_control_->setPreferredSize(width, height);
 }
 
-void DesktopControlProxy::onKeyEvent(const proto::KeyEvent& event)
+void DesktopControlProxy::setViewport(int x, int y, int width, int height)
+{
+    if (!io_task_runner_->belongsToCurrentThread())
+    {
+        io_task_runner_->postTask(
+            std::bind(&DesktopControlProxy::setViewport, shared_from_this(), x, y, width, height));
+        return;
+    }
+
+    if (desktop_control_)
+        desktop_control_->setViewport(x, y, width, height);
+}
+
+void DesktopControlProxy::setVisibility(bool visible)
 {
     if (!io_task_runner_->belongsToCurrentThread())
     {
         io_task_runner_->postTask(
-            std::bind(&DesktopControlProxy::onKeyEvent, shared_from_this(), event));
+            std::bind(&DesktopControlProxy::setVisibility, shared_from_this(), visible));
+        return;
+    }
+
+    if (desktop_control_)
+        desktop_control_->setVisibility(visible);
+}
+
+void DesktopControlProxy::setWindowState(bool visible, bool focused)
+{
+    if (!io_task_runner_->belongsToCurrentThread())
+    {
+        io_task_runner_->postTask(std::bind(
+            &DesktopControlProxy::setWindowState, shared_from_this(), visible, focused));
+        return;
+    }
+
+    if (desktop_control_)
+        desktop_control_->setWindowState(visible, focused);
+}
+
+void DesktopControlProxy::onKeyEvent(const proto::KeyEvent& event)
+{
+    if (!io_task_runner_->belongsToCurrentThread())
+    {
+        io_task_runner_->postPriorityTask(
+            std::bind(&DesktopControlProxy::onKeyEvent, shared_from_this(), event),
+            base::TaskRunner::Priority::HIGH);
         return;
     }
 
@@ -100,8 +140,9 @@ void DesktopControlProxy::onMouseEvent(const proto::MouseEvent& event)
 {
     if (!io_task_runner_->belongsToCurrentThread())
     {
-        io_task_runner_->postTask(
-            std::bind(&DesktopControlProxy::onMouseEvent, shared_from_this(), event));
+        io_task_runner_->postPriorityTask(
+            std::bind(&DesktopControlProxy::onMouseEvent, shared_from_this(), event),
+            base::TaskRunner::Priority::HIGH);
         return;
     }
 
@@ -135,17 +176,17 @@ void DesktopControlProxy::onRemoteUpdate()
         desktop_control_->onRemoteUpdate();
 }
 
-void DesktopControlProxy::onSystemInfoRequest()
+void DesktopControlProxy::onSystemInfoRequest(bool refresh)
 {
     if (!io_task_runner_->belongsToCurrentThread())
     {
         io_task_runner_->postTask(
-            std::bind(&DesktopControlProxy::onSystemInfoRequest, shared_from_this()));
+            std::bind(&DesktopControlProxy::onSystemInfoRequest, shared_from_this(), refresh));
         return;
     }
 
     if (desktop_control_)
-        desktop_control_->onSystemInfoRequest();
+        desktop_control_->onSystemInfoRequest(refresh);
 }
 
 void DesktopControlProxy::onMetricsRequest()
@@ -43,11 +43,14 @@ public:
     void setDesktopConfig(const proto::DesktopConfig& desktop_config);
     void setCurrentScreen(const proto::Screen& screen);
     void setPreferredSize(int width, int height);
+    void setViewport(int x, int y, int width, int height);
+    void setVisibility(bool visible);
+    void setWindowState(bool visible, bool focused);
     void onKeyEvent(const proto::KeyEvent& event);
     void onMouseEvent(const proto::MouseEvent& event);
     void onPowerControl(proto::PowerControl::Action action);
     void onRemoteUpdate();
-    void onSystemInfoRequest();
+    void onSystemInfoRequest(bool refresh);
     void onMetricsRequest();
 
 private:
@@ -26,6 +26,8 @@
 namespace base {
 class Frame;
 class MouseCursor;
+class Point;
+class Region;
 class Size;
 class Version;
 } // namespace base
@@ -46,6 +48,28 @@ class DesktopWindow
 public:
     virtual ~DesktopWindow() = default;
 
+    // Average time (in microseconds) which the video frames spend in the stages of the host and
+    // of the client.
+    struct Latency
+    {
+        // Host.
+        int64_t capture = 0;
+        int64_t diff = 0;
+        int64_t host_wait = 0;
+        int64_t scale = 0;
+        int64_t encode = 0;
+        int64_t enqueue = 0;
+        int64_t send = 0;
+
+        // Half of the round-trip time.
+        int64_t network = 0;
+
+        // Client.
+        int64_t decode_wait = 0;
+        int64_t decode = 0;
+        int64_t paint = 0;
+    };
+
     struct Metrics
     {
         std::chrono::seconds duration;
@@ -68,6 +92,7 @@ public:
         int send_key = 0;
         int read_clipboard = 0;
         int send_clipboard = 0;
+        Latency latency;
     };
 
     virtual void showWindow(std::shared_ptr<DesktopControlProxy> desktop_control_proxy,
@@ -83,8 +108,13 @@ public:
     virtual std::unique_ptr<FrameFactory> frameFactory() = 0;
     virtual void setFrame(const base::Size& screen_size,
                           std::shared_ptr<base::Frame> frame) = 0;
-    virtual void drawFrame() = 0;
+
+    // Paints the |updated_region| of the frame (in the coordinates of the frame) again.
+    virtual void drawFrame(const base::Region& updated_region) = 0;
     virtual void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor) = 0;
+
+    // Moves the local cursor to |position| in the coordinates of the video.
+    virtual void setMouseCursorPosition(const base::Point& position) = 0;
 };
 
 } // namespace client
@@ -22,6 +22,7 @@
 #include "base/task_runner.h"
 #include "base/version.h"
 #include "base/desktop/geometry.h"
+#include "base/desktop/region.h"
 #include "client/desktop_control_proxy.h"
 #include "client/desktop_window.h"
 #include "client/frame_factory.h"
@@ -152,16 +153,17 @@ void DesktopWindowProxy::setFrame(
         desktop_window_->setFrame(screen_size, frame);
 }
 
-void DesktopWindowProxy::drawFrame()
+void DesktopWindowProxy::drawFrame(const base::Region& updated_region)
 {
     if (!ui_task_runner_->belongsToCurrentThread())
     {
-        ui_task_runner_->postTask(std::bind(&DesktopWindowProxy::drawFrame, shared_from_this()));
+        ui_task_runner_->postTask(
+            std::bind(&DesktopWindowProxy::drawFrame, shared_from_this(), updated_region));
         return;
     }
 
     if (desktop_window_)
-        desktop_window_->drawFrame();
+        desktop_window_->drawFrame(updated_region);
 }
 
 void DesktopWindowProxy::setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor)
@@ -177,4 +179,17 @@ void DesktopWindowProxy::setMouseCursor(std::shared_ptr<base::MouseCursor> mouse
         desktop_window_->setMouseCursor(mouse_cursor);
 }
 
+void DesktopWindowProxy::setMouseCursorPosition(const base::Point& position)
+{
+    if (!ui_task_runner_->belongsToCurrentThread())
+    {
+        ui_task_runner_->postTask(
+            std::bind(&DesktopWindowProxy::setMouseCursorPosition, shared_from_this(), position));
+        return;
+    }
+
+    if (desktop_window_)
+        desktop_window_->setMouseCursorPosition(position);
+}
+
 } // namespace client
@@ -53,8 +53,9 @@ public:
 
     std::shared_ptr<base::Frame> allocateFrame(const base::Size& size);
     void setFrame(const base::Size& screen_size, std::shared_ptr<base::Frame> frame);
-    void drawFrame();
+    void drawFrame(const base::Region& updated_region);
     void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor);
+    void setMouseCursorPosition(const base::Point& position);
 
 private:
     std::shared_ptr<base::TaskRunner> ui_task_runner_;
@@ -46,6 +46,13 @@ public:
                           const std::string& source_path,
                           const std::string& target_path,
                           const std::vector<FileTransfer::Item>& items) = 0;
+
+    // Uploads the local folder |local_path| to |remote_path| and keeps uploading its changes until
+    // stopSync() is called (see FolderSync).
+    virtual void startSync(std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
+                           const std::string& local_path,
+                           const std::string& remote_path) = 0;
+    virtual void stopSync() = 0;
 };
 
 } // namespace client
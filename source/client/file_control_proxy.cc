@@ -129,4 +129,31 @@ void FileControlProxy::transfer(std::shared_ptr<FileTransferWindowProxy> transfe
         file_control_->transfer(transfer_window_proxy, transfer_type, source_path, target_path, items);
 }
 
+void FileControlProxy::startSync(std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
+                                 const std::string& local_path,
+                                 const std::string& remote_path)
+{
+    if (!io_task_runner_->belongsToCurrentThread())
+    {
+        io_task_runner_->postTask(std::bind(&FileControlProxy::startSync, shared_from_this(),
+                                            transfer_window_proxy, local_path, remote_path));
+        return;
+    }
+
+    if (file_control_)
+        file_control_->startSync(transfer_window_proxy, local_path, remote_path);
+}
+
+void FileControlProxy::stopSync()
+{
+    if (!io_task_runner_->belongsToCurrentThread())
+    {
+        io_task_runner_->postTask(std::bind(&FileControlProxy::stopSync, shared_from_this()));
+        return;
+    }
+
+    if (file_control_)
+        file_control_->stopSync();
+}
+
 } // namespace client
@@ -53,6 +53,11 @@ public:
                   const std::string& target_path,
                   const std::vector<FileTransfer::Item>& items);
 
+    void startSync(std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
+                   const std::string& local_path,
+                   const std::string& remote_path);
+    void stopSync();
+
 private:
     std::shared_ptr<base::TaskRunner> io_task_runner_;
     FileControl* file_control_;
@@ -45,6 +45,11 @@ public:
                             proto::FileError error_code,
                             const proto::FileList& file_list) = 0;
 
+    // Called when the next page of a file list is received. The items are added to the list
+    // received in onFileList.
+    virtual void onFileListContinued(common::FileTask::Target target,
+                                     const proto::FileList& file_list) = 0;
+
     // Called upon receipt of a response to a directory creation request.
     virtual void onCreateDirectory(common::FileTask::Target target, proto::FileError error_code) = 0;
 
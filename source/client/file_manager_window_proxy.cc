@@ -105,6 +105,22 @@ void FileManagerWindowProxy::onFileList(
         file_manager_window_->onFileList(target, error_code, file_list);
 }
 
+void FileManagerWindowProxy::onFileListContinued(
+    common::FileTask::Target target, const proto::FileList& file_list)
+{
+    if (!ui_task_runner_->belongsToCurrentThread())
+    {
+        ui_task_runner_->postTask(std::bind(&FileManagerWindowProxy::onFileListContinued,
+                                            shared_from_this(),
+                                            target,
+                                            file_list));
+        return;
+    }
+
+    if (file_manager_window_)
+        file_manager_window_->onFileListContinued(target, file_list);
+}
+
 void FileManagerWindowProxy::onCreateDirectory(
     common::FileTask::Target target, proto::FileError error_code)
 {
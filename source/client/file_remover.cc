@@ -28,6 +28,14 @@
 
 namespace client {
 
+namespace {
+
+// Maximum number of remove requests which are sent without waiting for the replies. The requests
+// are executed in order, so the contents of a directory are removed before the directory itself.
+const size_t kMaxRequestsInFlight = 64;
+
+} // namespace
+
 FileRemover::FileRemover(std::shared_ptr<base::TaskRunner> io_task_runner,
                          std::shared_ptr<FileRemoveWindowProxy> remove_window_proxy,
                          std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy,
@@ -67,7 +75,7 @@ void FileRemover::start(const TaskList& items, const FinishCallback& callback)
             tasks_ = queue_builder_->takeQueue();
             tasks_count_ = tasks_.size();
 
-            doCurrentTask();
+            doRequests();
         }
         else
         {
@@ -82,6 +90,7 @@ void FileRemover::stop()
 {
     queue_builder_.reset();
     tasks_.clear();
+    replies_.clear();
 
     onFinished();
 }
@@ -91,12 +100,14 @@ void FileRemover::setAction(Action action)
     switch (action)
     {
         case ACTION_SKIP:
-            doNextTask();
+            waiting_for_action_ = false;
+            doReplies();
             break;
 
         case ACTION_SKIP_ALL:
             failure_action_ = action;
-            doNextTask();
+            waiting_for_action_ = false;
+            doReplies();
             break;
 
         case ACTION_ABORT:
@@ -111,18 +122,40 @@ void FileRemover::setAction(Action action)
 
 void FileRemover::onTaskDone(std::shared_ptr<common::FileTask> task)
 {
-    const proto::FileRequest& request = task->request();
-    const proto::FileReply& reply = task->reply();
+    DCHECK_NE(requests_in_flight_, 0u);
+    --requests_in_flight_;
 
-    if (!request.has_remove_request())
-    {
-        remove_window_proxy_->errorOccurred(
-            request.remove_request().path(), proto::FILE_ERROR_UNKNOWN, ACTION_ABORT);
-        return;
-    }
+    // While the user chooses an action for the failed item, the replies to the requests which have
+    // already been sent are kept.
+    replies_.emplace_back(std::move(task));
 
-    if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+    if (!waiting_for_action_)
+        doReplies();
+}
+
+void FileRemover::doReplies()
+{
+    while (!replies_.empty())
     {
+        std::shared_ptr<common::FileTask> task = std::move(replies_.front());
+        replies_.pop_front();
+
+        ++removed_count_;
+
+        const proto::FileRequest& request = task->request();
+        const proto::FileReply& reply = task->reply();
+
+        if (!request.has_remove_request())
+        {
+            waiting_for_action_ = true;
+            remove_window_proxy_->errorOccurred(
+                request.remove_request().path(), proto::FILE_ERROR_UNKNOWN, ACTION_ABORT);
+            return;
+        }
+
+        if (reply.error_code() == proto::FILE_ERROR_SUCCESS)
+            continue;
+
         uint32_t actions;
 
         switch (reply.error_code())
@@ -130,11 +163,9 @@ void FileRemover::onTaskDone(std::shared_ptr<common::FileTask> task)
             case proto::FILE_ERROR_PATH_NOT_FOUND:
             case proto::FILE_ERROR_ACCESS_DENIED:
             {
+                // The item is skipped without asking the user.
                 if (failure_action_ != ACTION_ASK)
-                {
-                    setAction(failure_action_);
-                    return;
-                }
+                    continue;
 
                 actions = ACTION_ABORT | ACTION_SKIP | ACTION_SKIP_ALL;
             }
@@ -145,41 +176,46 @@ void FileRemover::onTaskDone(std::shared_ptr<common::FileTask> task)
                 break;
         }
 
+        waiting_for_action_ = true;
         remove_window_proxy_->errorOccurred(
             request.remove_request().path(), reply.error_code(), actions);
         return;
     }
 
-    doNextTask();
+    doRequests();
 }
 
-void FileRemover::doNextTask()
+void FileRemover::doRequests()
 {
-    // The task is completed. We delete it.
-    if (!tasks_.empty())
-        tasks_.pop_front();
-
-    doCurrentTask();
-}
+    // No more items are removed until the user chooses an action for the failed one.
+    if (waiting_for_action_)
+        return;
 
-void FileRemover::doCurrentTask()
-{
     if (tasks_.empty())
     {
-        onFinished();
+        if (!requests_in_flight_)
+            onFinished();
         return;
     }
 
-    DCHECK_NE(tasks_count_, 0);
+    if (requests_in_flight_ >= kMaxRequestsInFlight)
+        return;
+
+    DCHECK_NE(tasks_count_, 0u);
 
-    const size_t percentage = (tasks_count_ - tasks_.size()) * 100 / tasks_count_;
-    const std::string& path = tasks_.front().path();
+    const size_t percentage = removed_count_ * 100 / tasks_count_;
 
     // Updating progress in UI.
-    remove_window_proxy_->setCurrentProgress(path, percentage);
+    remove_window_proxy_->setCurrentProgress(tasks_.front().path(), percentage);
 
-    // Send a request to delete the next item.
-    task_consumer_proxy_->doTask(task_factory_->remove(path));
+    // Send requests to delete the next items.
+    while (!tasks_.empty() && requests_in_flight_ < kMaxRequestsInFlight)
+    {
+        task_consumer_proxy_->doTask(task_factory_->remove(tasks_.front().path()));
+        tasks_.pop_front();
+
+        ++requests_in_flight_;
+    }
 }
 
 void FileRemover::onFinished()
@@ -93,8 +93,8 @@ protected:
     void onTaskDone(std::shared_ptr<common::FileTask> task) override;
 
 private:
-    void doNextTask();
-    void doCurrentTask();
+    void doReplies();
+    void doRequests();
     void onFinished();
 
     std::shared_ptr<FileRemoverProxy> remover_proxy_;
@@ -105,11 +105,19 @@ private:
 
     std::unique_ptr<FileRemoveQueueBuilder> queue_builder_;
 
+    // Tasks for which the requests have not yet been sent.
     TaskList tasks_;
+
+    // Received replies which have not yet been processed.
+    std::deque<std::shared_ptr<common::FileTask>> replies_;
+
     FinishCallback finish_callback_;
 
     Action failure_action_ = ACTION_ASK;
+    bool waiting_for_action_ = false;
     size_t tasks_count_ = 0;
+    size_t removed_count_ = 0;
+    size_t requests_in_flight_ = 0;
 
     DISALLOW_COPY_AND_ASSIGN(FileRemover);
 };
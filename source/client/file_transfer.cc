@@ -27,10 +27,37 @@
 #include "common/file_task_producer_proxy.h"
 #include "common/file_packet.h"
 
+#include <algorithm>
+
 namespace client {
 
 namespace {
 
+// Number of packets which can be requested before the reply to the first of them is received.
+const int kInitialWindowSize = 4;
+const int kMinWindowSize = 2;
+const int kMaxWindowSize = 64;
+
+// Limits the size of the window when large packets are used.
+const int64_t kMaxBytesInFlight = 16 * 1024 * 1024; // 16 MB
+
+// Maximum number of small files and directories in one batch. A batch is used only if there are
+// at least |kMinBatchSize| such tasks in a row.
+const size_t kMaxBatchSize = 32;
+const size_t kMinBatchSize = 2;
+
+// Size of the file data in the packet (before compression).
+int64_t packetDataSize(const proto::FilePacket& packet)
+{
+    if (packet.compression() != proto::FILE_COMPRESSION_NONE ||
+        (packet.flags() & proto::FilePacket::SKIP_DATA))
+    {
+        return static_cast<int64_t>(packet.data_size());
+    }
+
+    return static_cast<int64_t>(packet.data().size());
+}
+
 struct ActionsMap
 {
     FileTransfer::Error::Type type;
@@ -94,7 +121,9 @@ FileTransfer::FileTransfer(std::shared_ptr<base::TaskRunner> io_task_runner,
       task_consumer_proxy_(std::move(task_consumer_proxy)),
       task_producer_proxy_(std::make_shared<common::FileTaskProducerProxy>(this)),
       cancel_timer_(base::WaitableTimer::Type::SINGLE_SHOT, io_task_runner),
-      type_(type)
+      type_(type),
+      window_size_(kInitialWindowSize),
+      packet_size_(common::kDefaultFilePacketSize)
 {
     // Nothing
 }
@@ -149,11 +178,12 @@ void FileTransfer::start(const std::string& source_path,
 
             if (tasks_.empty())
             {
+                is_completed_ = true;
                 onFinished();
             }
             else
             {
-                doFrontTask(false);
+                doFrontTasks();
             }
         }
         else
@@ -179,6 +209,11 @@ void FileTransfer::stop()
     }
 }
 
+void FileTransfer::setDefaultAction(Error::Type error_type, Error::Action action)
+{
+    setActionForErrorType(error_type, action);
+}
+
 void FileTransfer::setActionForErrorType(Error::Type error_type, Error::Action action)
 {
     actions_.insert_or_assign(error_type, action);
@@ -186,6 +221,15 @@ void FileTransfer::setActionForErrorType(Error::Type error_type, Error::Action a
 
 void FileTransfer::onTaskDone(std::shared_ptr<common::FileTask> task)
 {
+    if (!batch_.empty())
+    {
+        if (task->target() == task_factory_source_->target())
+            batchSourceReply(task->request(), task->reply());
+        else
+            batchTargetReply(task->request(), task->reply());
+        return;
+    }
+
     if (type_ == Type::DOWNLOADER)
     {
         if (task->target() == common::FileTask::Target::LOCAL)
@@ -250,27 +294,49 @@ void FileTransfer::targetReply(const proto::FileRequest& request, const proto::F
             return;
         }
 
-        task_consumer_proxy_->doTask(
-            task_factory_source_->packetRequest(proto::FilePacketRequest::NO_FLAGS));
+        // Older versions do not report the compression and accept only uncompressed packets.
+        target_compression_ = reply.compression();
+        target_block_list_ = reply.block_list();
+
+        doPacketRequests();
     }
     else if (request.has_packet())
     {
+        if (stale_packets_)
+        {
+            --stale_packets_;
+            return;
+        }
+
+        DCHECK_GT(packets_in_flight_, 0);
+        --packets_in_flight_;
+
+        if (packet_error_)
+            return;
+
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
         {
+            packet_error_ = true;
             onError(Error::Type::WRITE_FILE, reply.error_code(), frontTask().targetPath());
             return;
         }
 
+        if (!packet_request_times_.empty())
+        {
+            updateWindowSize(std::chrono::steady_clock::now() - packet_request_times_.front());
+            packet_request_times_.pop_front();
+        }
+
         const int64_t full_task_size = frontTask().size();
         if (full_task_size && total_size_)
         {
-            int64_t packet_size = common::kMaxFilePacketSize;
+            int64_t packet_size = packetDataSize(request.packet());
 
             task_transfered_size_ += packet_size;
 
             if (task_transfered_size_ > full_task_size)
             {
-                packet_size = task_transfered_size_ - full_task_size;
+                packet_size -= task_transfered_size_ - full_task_size;
                 task_transfered_size_ = full_task_size;
             }
 
@@ -296,11 +362,7 @@ void FileTransfer::targetReply(const proto::FileRequest& request, const proto::F
             return;
         }
 
-        uint32_t flags = proto::FilePacketRequest::NO_FLAGS;
-        if (is_canceled_)
-            flags = proto::FilePacketRequest::CANCEL;
-
-        task_consumer_proxy_->doTask(task_factory_source_->packetRequest(flags));
+        doPacketRequests();
     }
     else
     {
@@ -323,17 +385,62 @@ void FileTransfer::sourceReply(const proto::FileRequest& request, const proto::F
             return;
         }
 
-        task_consumer_proxy_->doTask(
-            task_factory_target_->upload(front_task.targetPath(), front_task.overwrite()));
+        // If the existing file is replaced, only the changed blocks of it are transferred.
+        task_consumer_proxy_->doTask(task_factory_target_->upload(
+            front_task.targetPath(), front_task.overwrite(), front_task.overwrite()));
     }
     else if (request.has_packet_request())
     {
+        if (stale_packet_requests_)
+        {
+            --stale_packet_requests_;
+            return;
+        }
+
+        DCHECK_GT(packet_requests_in_flight_, 0);
+        --packet_requests_in_flight_;
+
+        DCHECK(!requested_packet_sizes_.empty());
+        const int64_t requested_packet_size = requested_packet_sizes_.front();
+        requested_packet_sizes_.pop_front();
+
+        // If the file has become smaller since the queue was built, more packets may have been
+        // requested than the file contains. The source replies to them with an error.
+        if (packet_error_ || last_packet_read_)
+            return;
+
         if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
         {
+            packet_error_ = true;
             onError(Error::Type::READ_FILE, reply.error_code(), frontTask().sourcePath());
             return;
         }
 
+        const proto::FilePacket& packet = reply.packet();
+        const int64_t received_size = packetDataSize(packet);
+
+        if (packet.flags() & proto::FilePacket::LAST_PACKET)
+        {
+            last_packet_read_ = true;
+        }
+        else if (packet_size_adaptive_ && received_size < requested_packet_size)
+        {
+            // Older versions ignore the requested size and send packets of the default size.
+            LOG(LS_INFO) << "Source does not support the packet size (requested: "
+                         << requested_packet_size << ", received: "
+                         << received_size << ")";
+
+            packet_size_adaptive_ = false;
+            packet_size_ = common::kDefaultFilePacketSize;
+
+            // The rest of the requests in flight are answered with the default size too.
+            requested_size_ = received_size_ + received_size +
+                static_cast<int64_t>(packet_requests_in_flight_) * packet_size_;
+        }
+
+        received_size_ += received_size;
+
+        ++packets_in_flight_;
         task_consumer_proxy_->doTask(task_factory_target_->packet(reply.packet()));
     }
     else
@@ -366,6 +473,9 @@ void FileTransfer::setAction(Error::Type error_type, Error::Action action)
             if (action == Error::ACTION_SKIP_ALL)
                 setActionForErrorType(error_type, action);
 
+            if (!tasks_.empty())
+                skipped_paths_.emplace_back(frontTask().sourcePath());
+
             doNextTask();
         }
         break;
@@ -376,11 +486,32 @@ void FileTransfer::setAction(Error::Type error_type, Error::Action action)
     }
 }
 
+void FileTransfer::doFrontTasks()
+{
+    if (!startBatch())
+        doFrontTask(false);
+}
+
 void FileTransfer::doFrontTask(bool overwrite)
 {
     task_percentage_ = 0;
     task_transfered_size_ = 0;
 
+    // Replies to the requests of the previous task are received before the replies for the new
+    // task.
+    stale_packet_requests_ += packet_requests_in_flight_;
+    stale_packets_ += packets_in_flight_;
+    packet_requests_in_flight_ = 0;
+    packets_in_flight_ = 0;
+    requested_size_ = 0;
+    received_size_ = 0;
+    last_packet_read_ = false;
+    cancel_requested_ = false;
+    packet_error_ = false;
+    target_block_list_.Clear();
+    packet_request_times_.clear();
+    requested_packet_sizes_.clear();
+
     Task& front_task = frontTask();
     front_task.setOverwrite(overwrite);
 
@@ -398,6 +529,107 @@ void FileTransfer::doFrontTask(bool overwrite)
     }
 }
 
+void FileTransfer::doPacketRequests()
+{
+    if (packet_error_ || last_packet_read_ || cancel_requested_)
+        return;
+
+    if (is_canceled_)
+    {
+        // The source replies to the cancel request with an empty last packet. Packets requested
+        // before it are still written to the target.
+        cancel_requested_ = true;
+        ++packet_requests_in_flight_;
+        packet_request_times_.emplace_back(std::chrono::steady_clock::now());
+        requested_packet_sizes_.emplace_back(0);
+        task_consumer_proxy_->doTask(
+            task_factory_source_->packetRequest(proto::FilePacketRequest::CANCEL));
+        return;
+    }
+
+    // The source replies to the requests in the order they were sent, so several requests can
+    // be in flight at the same time.
+    while (packet_requests_in_flight_ + packets_in_flight_ < window_size_)
+    {
+        const bool in_flight = packet_requests_in_flight_ + packets_in_flight_ != 0;
+
+        // The file may have become larger since the queue was built. In this case the rest of
+        // the file is requested one packet at a time.
+        if (requested_size_ >= frontTask().size() && in_flight)
+            break;
+
+        proto::FilePacketRequest packet_request;
+        packet_request.set_compression(target_compression_);
+
+        // Older versions ignore the size, so it is sent only when it differs from the default.
+        if (packet_size_ != common::kDefaultFilePacketSize)
+            packet_request.set_packet_size(static_cast<uint32_t>(packet_size_));
+
+        // The source receives the blocks of the existing target file with the first request.
+        if (!requested_size_ && target_block_list_.hash_size())
+            *packet_request.mutable_target_block_list() = target_block_list_;
+
+        // While there are blocks in the target file, the source sends whole blocks.
+        int64_t packet_size = static_cast<int64_t>(packet_size_);
+        if (requested_size_ < static_cast<int64_t>(target_block_list_.hash_size()) *
+                static_cast<int64_t>(common::kFileBlockSize))
+        {
+            packet_size = std::max(packet_size, static_cast<int64_t>(common::kFileBlockSize));
+        }
+
+        requested_size_ += packet_size;
+        ++packet_requests_in_flight_;
+        packet_request_times_.emplace_back(std::chrono::steady_clock::now());
+        requested_packet_sizes_.emplace_back(packet_size);
+        task_consumer_proxy_->doTask(
+            task_factory_source_->packetRequest(std::move(packet_request)));
+    }
+}
+
+void FileTransfer::updateWindowSize(std::chrono::steady_clock::duration rtt)
+{
+    if (min_rtt_ == std::chrono::steady_clock::duration::zero() || rtt < min_rtt_)
+        min_rtt_ = rtt;
+
+    const int max_window_size = std::clamp(
+        static_cast<int>(kMaxBytesInFlight / static_cast<int64_t>(packet_size_)),
+        kMinWindowSize, kMaxWindowSize);
+
+    // While the round-trip time stays close to the minimum, the packets do not queue up anywhere
+    // and the window grows by one packet per reply (doubles every round trip). When the delay
+    // grows, the window shrinks to drain the queue.
+    if (rtt <= min_rtt_ * 2)
+    {
+        if (window_size_ < max_window_size)
+        {
+            ++window_size_;
+        }
+        else if (packet_size_adaptive_ && packet_size_ < common::kMaxFilePacketSize)
+        {
+            // The window is full, so the link is fast (typically a LAN). Larger packets reduce
+            // the per-packet overhead. The number of bytes in flight stays the same.
+            packet_size_ *= 2;
+            window_size_ = std::max(window_size_ / 2, kMinWindowSize);
+
+            // Larger packets take longer to deliver.
+            min_rtt_ = std::chrono::steady_clock::duration::zero();
+        }
+    }
+    else
+    {
+        if (window_size_ > kMinWindowSize)
+        {
+            --window_size_;
+        }
+        else if (packet_size_ > common::kDefaultFilePacketSize)
+        {
+            packet_size_ /= 2;
+            window_size_ = std::min(window_size_ * 2, kMaxWindowSize);
+            min_rtt_ = std::chrono::steady_clock::duration::zero();
+        }
+    }
+}
+
 void FileTransfer::doNextTask()
 {
     if (is_canceled_)
@@ -417,10 +649,223 @@ void FileTransfer::doNextTask()
         if (cancel_timer_.isActive())
             cancel_timer_.stop();
 
+        is_completed_ = !is_canceled_;
+        onFinished();
+        return;
+    }
+
+    doFrontTasks();
+}
+
+bool FileTransfer::isBatchTask(const Task& task) const
+{
+    // Files which fit into one packet.
+    return task.isDirectory() || task.size() <= static_cast<int64_t>(packet_size_);
+}
+
+bool FileTransfer::startBatch()
+{
+    // Replies to the requests of the previous task must be received first.
+    if (is_canceled_ || stale_packet_requests_ || stale_packets_)
+        return false;
+
+    size_t count = 0;
+    while (count < tasks_.size() && count < kMaxBatchSize && isBatchTask(tasks_[count]))
+        ++count;
+
+    if (count < kMinBatchSize)
+        return false;
+
+    // If the user has chosen to replace all existing files, they are replaced in the batch too.
+    auto action = actions_.find(Error::Type::ALREADY_EXISTS);
+    const bool overwrite =
+        action != actions_.end() && action->second == Error::ACTION_REPLACE_ALL;
+
+    uint32_t packet_size = 0;
+    if (packet_size_ != common::kDefaultFilePacketSize)
+        packet_size = static_cast<uint32_t>(packet_size_);
+
+    batch_.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        batch_.emplace_back(std::move(tasks_.front()));
+        tasks_.pop_front();
+
+        BatchTask& batch_task = batch_.back();
+        batch_task.task.setOverwrite(overwrite);
+
+        if (batch_task.task.isDirectory())
+            continue;
+
+        // The source opens the file and sends all of it in one packet. Requests to the target are
+        // sent when the packet is received.
+        task_consumer_proxy_->doTask(task_factory_source_->download(batch_task.task.sourcePath()));
+        task_consumer_proxy_->doTask(task_factory_source_->packetRequest(
+            proto::FilePacketRequest::NO_FLAGS, packet_size, target_compression_));
+
+        batch_source_requests_.emplace_back(i);
+        batch_source_requests_.emplace_back(i);
+        batch_task.source_replies = 2;
+    }
+
+    transfer_window_proxy_->setCurrentItem(
+        batch_.front().task.sourcePath(), batch_.front().task.targetPath());
+
+    doBatchTargetRequests();
+    return true;
+}
+
+void FileTransfer::batchSourceReply(const proto::FileRequest& request,
+                                    const proto::FileReply& reply)
+{
+    DCHECK(!batch_source_requests_.empty());
+
+    BatchTask& batch_task = batch_[batch_source_requests_.front()];
+    batch_source_requests_.pop_front();
+
+    DCHECK_GT(batch_task.source_replies, 0);
+    --batch_task.source_replies;
+
+    if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+    {
+        batch_task.failed = true;
+    }
+    else if (request.has_packet_request() && !batch_task.failed)
+    {
+        // The file may have become larger since the queue was built. It is transferred
+        // separately.
+        if (reply.packet().flags() & proto::FilePacket::LAST_PACKET)
+            batch_task.packet = std::make_unique<proto::FilePacket>(reply.packet());
+        else
+            batch_task.failed = true;
+    }
+
+    doBatchTargetRequests();
+}
+
+void FileTransfer::batchTargetReply(const proto::FileRequest& request,
+                                    const proto::FileReply& reply)
+{
+    DCHECK(!batch_target_requests_.empty());
+
+    BatchTask& batch_task = batch_[batch_target_requests_.front()];
+    batch_target_requests_.pop_front();
+
+    DCHECK_GT(batch_task.target_replies, 0);
+    --batch_task.target_replies;
+
+    if (request.has_create_directory_request())
+    {
+        if (reply.error_code() == proto::FILE_ERROR_SUCCESS ||
+            reply.error_code() == proto::FILE_ERROR_PATH_ALREADY_EXISTS)
+        {
+            batch_task.done = true;
+        }
+        else
+        {
+            batch_task.failed = true;
+        }
+    }
+    else if (reply.error_code() != proto::FILE_ERROR_SUCCESS)
+    {
+        // If the upload request has failed, the target replies to the packet with an error too.
+        batch_task.failed = true;
+    }
+    else if (request.has_upload_request())
+    {
+        target_compression_ = reply.compression();
+    }
+    else if (request.has_packet() && !batch_task.failed)
+    {
+        batch_task.done = true;
+    }
+
+    if (batch_task.done && !batch_task.task.isDirectory() && total_size_)
+    {
+        total_transfered_size_ += batch_task.task.size();
+
+        const int total_percentage = static_cast<int>(total_transfered_size_ * 100 / total_size_);
+        if (total_percentage != total_percentage_)
+        {
+            total_percentage_ = total_percentage;
+            transfer_window_proxy_->setCurrentProgress(total_percentage_, 100);
+        }
+    }
+
+    doBatchTargetRequests();
+}
+
+void FileTransfer::doBatchTargetRequests()
+{
+    // The target has one file open at a time, so the requests are sent in the order of the tasks.
+    while (batch_target_index_ < batch_.size() && !is_canceled_)
+    {
+        BatchTask& batch_task = batch_[batch_target_index_];
+
+        if (batch_task.task.isDirectory())
+        {
+            task_consumer_proxy_->doTask(
+                task_factory_target_->createDirectory(batch_task.task.targetPath()));
+
+            batch_target_requests_.emplace_back(batch_target_index_);
+            batch_task.target_replies = 1;
+        }
+        else
+        {
+            if (batch_task.source_replies)
+                break;
+
+            if (!batch_task.failed)
+            {
+                task_consumer_proxy_->doTask(task_factory_target_->upload(
+                    batch_task.task.targetPath(), batch_task.task.overwrite()));
+                task_consumer_proxy_->doTask(
+                    task_factory_target_->packet(std::move(batch_task.packet)));
+
+                batch_target_requests_.emplace_back(batch_target_index_);
+                batch_target_requests_.emplace_back(batch_target_index_);
+                batch_task.target_replies = 2;
+            }
+        }
+
+        ++batch_target_index_;
+    }
+
+    if (batch_source_requests_.empty() && batch_target_requests_.empty())
+        finishBatch();
+}
+
+void FileTransfer::finishBatch()
+{
+    // Tasks which have not been completed are returned to the queue.
+    for (auto it = batch_.rbegin(); it != batch_.rend(); ++it)
+    {
+        if (!it->done)
+            tasks_.emplace_front(std::move(it->task));
+    }
+
+    batch_.clear();
+    batch_target_index_ = 0;
+
+    if (is_canceled_)
+    {
+        while (!tasks_.empty())
+            tasks_.pop_front();
+    }
+
+    if (tasks_.empty())
+    {
+        if (cancel_timer_.isActive())
+            cancel_timer_.stop();
+
+        is_completed_ = !is_canceled_;
         onFinished();
         return;
     }
 
+    // The first of the failed tasks is repeated separately. If it fails again, the error is
+    // reported as usual.
     doFrontTask(false);
 }
 
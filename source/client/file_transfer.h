@@ -24,6 +24,7 @@
 #include "common/file_task_producer.h"
 #include "proto/file_transfer.pb.h"
 
+#include <chrono>
 #include <deque>
 
 namespace base {
@@ -169,6 +170,16 @@ public:
 
     void setAction(Error::Type error_type, Error::Action action);
 
+    // Sets the action which is taken for errors of |error_type| without asking the window. Must be
+    // called before start().
+    void setDefaultAction(Error::Type error_type, Error::Action action);
+
+    // Returns true if all items have been processed, i.e. the transfer was not stopped or aborted.
+    bool isCompleted() const { return is_completed_; }
+
+    // Source paths of the tasks which have been skipped after errors.
+    const std::vector<std::string>& skippedPaths() const { return skipped_paths_; }
+
 protected:
     // common::FileTaskProducer implementation.
     void onTaskDone(std::shared_ptr<common::FileTask> task) override;
@@ -177,7 +188,16 @@ private:
     Task& frontTask();
     void targetReply(const proto::FileRequest& request, const proto::FileReply& reply);
     void sourceReply(const proto::FileRequest& request, const proto::FileReply& reply);
+    void doFrontTasks();
     void doFrontTask(bool overwrite);
+    void doPacketRequests();
+    void updateWindowSize(std::chrono::steady_clock::duration rtt);
+    bool isBatchTask(const Task& task) const;
+    bool startBatch();
+    void batchSourceReply(const proto::FileRequest& request, const proto::FileReply& reply);
+    void batchTargetReply(const proto::FileRequest& request, const proto::FileReply& reply);
+    void doBatchTargetRequests();
+    void finishBatch();
     void doNextTask();
     void onError(Error::Type type, proto::FileError code, const std::string& path = std::string());
     void setActionForErrorType(Error::Type error_type, Error::Action action);
@@ -201,6 +221,33 @@ private:
 
     FinishCallback finish_callback_;
 
+    // Small files and directories are transferred in batches. All requests of the tasks of a batch
+    // are sent without waiting for replies.
+    struct BatchTask
+    {
+        explicit BatchTask(Task&& task)
+            : task(std::move(task))
+        {
+            // Nothing
+        }
+
+        Task task;
+        std::unique_ptr<proto::FilePacket> packet;
+        int source_replies = 0;
+        int target_replies = 0;
+        bool failed = false;
+        bool done = false;
+    };
+
+    std::vector<BatchTask> batch_;
+
+    // Indexes of the batch tasks for each request in flight, in the order of sending.
+    std::deque<size_t> batch_source_requests_;
+    std::deque<size_t> batch_target_requests_;
+
+    // Index of the next batch task for which requests to the target must be sent.
+    size_t batch_target_index_ = 0;
+
     int64_t total_size_ = 0;
     int64_t total_transfered_size_ = 0;
     int64_t task_transfered_size_ = 0;
@@ -209,6 +256,39 @@ private:
     int task_percentage_ = 0;
 
     bool is_canceled_ = false;
+    bool is_completed_ = false;
+    std::vector<std::string> skipped_paths_;
+
+    // Packets of the current task requested from the source and written to the target, for
+    // which no reply has been received yet.
+    int packet_requests_in_flight_ = 0;
+    int packets_in_flight_ = 0;
+
+    // Replies to the requests of the previous task which are still in flight. They are ignored.
+    int stale_packet_requests_ = 0;
+    int stale_packets_ = 0;
+
+    // Number of bytes requested from the source and received from it for the current task.
+    int64_t requested_size_ = 0;
+    int64_t received_size_ = 0;
+    bool last_packet_read_ = false;
+    bool cancel_requested_ = false;
+    bool packet_error_ = false;
+
+    // Compression of packets supported by the target of the current task.
+    proto::FileCompression target_compression_ = proto::FILE_COMPRESSION_NONE;
+
+    // Blocks of the existing target file of the current task (if it is updated in place).
+    proto::FileBlockList target_block_list_;
+
+    // Maximum number of packets in flight and the size of the packets. They are adjusted by the
+    // round-trip time of the packets.
+    int window_size_;
+    size_t packet_size_;
+    bool packet_size_adaptive_ = true;
+    std::chrono::steady_clock::duration min_rtt_ = std::chrono::steady_clock::duration::zero();
+    std::deque<std::chrono::steady_clock::time_point> packet_request_times_;
+    std::deque<int64_t> requested_packet_sizes_;
 
     DISALLOW_COPY_AND_ASSIGN(FileTransfer);
 };
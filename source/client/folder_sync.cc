@@ -0,0 +1,315 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/folder_sync.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "base/files/file_path_watcher.h"
+#include "base/strings/string_util.h"
+
+#include <set>
+
+namespace client {
+
+namespace {
+
+// Changes usually come in bursts (for example, an editor saves a file in several steps). The sync
+// starts when there are no new changes for kSyncDelay, but not later than kMaxSyncDelay after the
+// first change.
+constexpr std::chrono::milliseconds kSyncDelay{ 2000 };
+constexpr std::chrono::milliseconds kMaxSyncDelay{ 30000 };
+
+} // namespace
+
+FolderSync::FolderSync(std::shared_ptr<base::TaskRunner> io_task_runner,
+                       std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
+                       std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy)
+    : io_task_runner_(std::move(io_task_runner)),
+      transfer_window_proxy_(std::move(transfer_window_proxy)),
+      task_consumer_proxy_(std::move(task_consumer_proxy)),
+      sync_timer_(base::WaitableTimer::Type::SINGLE_SHOT, io_task_runner_,
+                  base::WaitableTimer::Precision::COARSE),
+      self_(std::make_shared<FolderSync*>(this))
+{
+    DCHECK(io_task_runner_);
+    DCHECK(transfer_window_proxy_);
+    DCHECK(task_consumer_proxy_);
+
+    scan_thread_.start(base::MessageLoop::Type::DEFAULT);
+}
+
+FolderSync::~FolderSync()
+{
+    self_.reset();
+    watcher_.reset();
+    sync_timer_.stop();
+    scan_thread_.stop();
+
+    if (transfer_)
+    {
+        LOG(LS_INFO) << "Folder sync is stopped during the transfer";
+        transfer_.reset();
+    }
+}
+
+bool FolderSync::start(const std::string& local_path, const std::string& remote_path)
+{
+    DCHECK(io_task_runner_->belongsToCurrentThread());
+    DCHECK(!watcher_);
+
+    local_path_ = local_path;
+    remote_path_ = remote_path;
+
+    watcher_ = std::make_unique<base::FilePathWatcher>(io_task_runner_);
+    if (!watcher_->watch(std::filesystem::u8path(local_path_), true,
+                         [this](const std::filesystem::path& /* path */, bool error)
+    {
+        onFolderChanged(error);
+    }))
+    {
+        LOG(LS_WARNING) << "Unable to watch folder: " << local_path_;
+        watcher_.reset();
+        return false;
+    }
+
+    LOG(LS_INFO) << "Folder sync started (local: " << local_path_
+                 << " remote: " << remote_path_ << ")";
+
+    // The first sync uploads the whole folder.
+    has_changes_ = true;
+    first_change_time_ = std::chrono::steady_clock::now();
+    startScan();
+    return true;
+}
+
+void FolderSync::onFolderChanged(bool error)
+{
+    if (error)
+    {
+        // The watcher does not report the changes after an error.
+        LOG(LS_WARNING) << "Error while watching folder: " << local_path_;
+        io_task_runner_->deleteSoon(std::move(watcher_));
+        return;
+    }
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (!has_changes_)
+    {
+        has_changes_ = true;
+        first_change_time_ = now;
+    }
+
+    // The changes are picked up when the current scan or transfer is finished.
+    if (scan_running_ || transfer_)
+        return;
+
+    std::chrono::milliseconds remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        first_change_time_ + kMaxSyncDelay - now);
+
+    scheduleSync(std::max(std::min(kSyncDelay, remaining), std::chrono::milliseconds::zero()));
+}
+
+void FolderSync::scheduleSync(std::chrono::milliseconds delay)
+{
+    // The timer is restarted, so a burst of changes results in one sync.
+    sync_timer_.stop();
+    sync_timer_.start(delay, std::bind(&FolderSync::startScan, this));
+}
+
+void FolderSync::startScan()
+{
+    DCHECK(!scan_running_);
+    DCHECK(!transfer_);
+
+    scan_running_ = true;
+    has_changes_ = false;
+
+    std::weak_ptr<FolderSync*> self = self_;
+    std::shared_ptr<base::TaskRunner> io_task_runner = io_task_runner_;
+    std::filesystem::path folder = std::filesystem::u8path(local_path_);
+
+    scan_thread_.taskRunner()->postTask([self, io_task_runner, folder]()
+    {
+        Snapshot snapshot = scan(folder);
+
+        io_task_runner->postTask([self, snapshot = std::move(snapshot)]() mutable
+        {
+            std::shared_ptr<FolderSync*> folder_sync = self.lock();
+            if (folder_sync)
+                (*folder_sync)->onScanFinished(std::move(snapshot));
+        });
+    });
+}
+
+void FolderSync::onScanFinished(Snapshot&& snapshot)
+{
+    scan_running_ = false;
+
+    std::vector<FileTransfer::Item> items = changedItems(synced_, snapshot);
+
+    if (items.empty())
+    {
+        // Only removed items, which are kept in the remote folder.
+        synced_ = std::move(snapshot);
+
+        if (has_changes_)
+            scheduleSync(kSyncDelay);
+        return;
+    }
+
+    uploading_ = std::move(snapshot);
+
+    LOG(LS_INFO) << "Folder sync: " << items.size() << " changed items";
+
+    transfer_ = std::make_unique<FileTransfer>(
+        io_task_runner_, transfer_window_proxy_, task_consumer_proxy_,
+        FileTransfer::Type::UPLOADER);
+
+    // The existing remote files are replaced without asking, so only their changed blocks are sent.
+    // The files which are locked or removed while they are uploaded are skipped. They are not
+    // marked as synced, so the next sync tries them again.
+    transfer_->setDefaultAction(FileTransfer::Error::Type::ALREADY_EXISTS,
+                                FileTransfer::Error::ACTION_REPLACE_ALL);
+    transfer_->setDefaultAction(FileTransfer::Error::Type::OPEN_FILE,
+                                FileTransfer::Error::ACTION_SKIP_ALL);
+    transfer_->setDefaultAction(FileTransfer::Error::Type::READ_FILE,
+                                FileTransfer::Error::ACTION_SKIP_ALL);
+
+    transfer_->start(local_path_, remote_path_, items,
+                     std::bind(&FolderSync::onTransferFinished, this));
+}
+
+void FolderSync::onTransferFinished()
+{
+    if (transfer_->isCompleted())
+    {
+        // Source paths of the transfer are the paths of the snapshot after the local folder.
+        for (const std::string& path : transfer_->skippedPaths())
+        {
+            if (path.size() > local_path_.size() && base::startsWith(path, local_path_))
+                uploading_.erase(path.substr(local_path_.size() + 1));
+        }
+
+        synced_ = std::move(uploading_);
+    }
+    else
+    {
+        // It is not known which items have been uploaded, all of them are sent with the next
+        // sync. The replaced files which have not changed are not transferred again.
+        LOG(LS_INFO) << "Folder sync transfer is not completed";
+    }
+
+    uploading_.clear();
+
+    // The callback is called by the transfer itself, so it cannot be destroyed here.
+    io_task_runner_->deleteSoon(std::move(transfer_));
+
+    if (has_changes_)
+        scheduleSync(kSyncDelay);
+}
+
+// static
+FolderSync::Snapshot FolderSync::scan(const std::filesystem::path& folder)
+{
+    Snapshot snapshot;
+
+    std::error_code error_code;
+    std::filesystem::recursive_directory_iterator it(
+        folder, std::filesystem::directory_options::skip_permission_denied, error_code);
+
+    for (const std::filesystem::recursive_directory_iterator end;
+         !error_code && it != end; it.increment(error_code))
+    {
+        const std::filesystem::directory_entry& item = *it;
+        std::error_code item_error;
+
+        // Links are not followed, as the file worker does not follow them.
+        if (item.is_symlink(item_error))
+            continue;
+
+        Entry entry;
+        entry.is_directory = item.is_directory(item_error);
+
+        if (!entry.is_directory)
+        {
+            if (!item.is_regular_file(item_error))
+                continue;
+
+            entry.size = static_cast<int64_t>(item.file_size(item_error));
+            entry.last_write = item.last_write_time(item_error);
+        }
+
+        // The item could be removed during the scan.
+        if (item_error)
+            continue;
+
+        snapshot.emplace(item.path().lexically_relative(folder).generic_u8string(), entry);
+    }
+
+    if (error_code)
+        LOG(LS_WARNING) << "Unable to scan folder: " << error_code.message();
+
+    return snapshot;
+}
+
+// static
+std::vector<FileTransfer::Item> FolderSync::changedItems(const Snapshot& previous,
+                                                         const Snapshot& current)
+{
+    std::vector<FileTransfer::Item> items;
+    std::set<std::string, std::less<>> new_directories;
+
+    for (const auto& [path, entry] : current)
+    {
+        // Parents go before their children in the snapshot.
+        bool inside_new_directory = false;
+
+        for (size_t pos = path.find('/'); pos != std::string::npos; pos = path.find('/', pos + 1))
+        {
+            if (new_directories.find(std::string_view(path.data(), pos)) != new_directories.end())
+            {
+                inside_new_directory = true;
+                break;
+            }
+        }
+
+        if (inside_new_directory)
+            continue;
+
+        auto old = previous.find(path);
+
+        if (entry.is_directory)
+        {
+            if (old == previous.end() || !old->second.is_directory)
+            {
+                items.emplace_back(path, 0, true);
+                new_directories.emplace(path);
+            }
+            continue;
+        }
+
+        if (old == previous.end() || old->second != entry)
+            items.emplace_back(path, entry.size, false);
+    }
+
+    return items;
+}
+
+} // namespace client
@@ -0,0 +1,127 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__FOLDER_SYNC_H
+#define CLIENT__FOLDER_SYNC_H
+
+#include "base/waitable_timer.h"
+#include "base/threading/thread.h"
+#include "client/file_transfer.h"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+namespace base {
+class FilePathWatcher;
+class TaskRunner;
+} // namespace base
+
+namespace common {
+class FileTaskConsumerProxy;
+} // namespace common
+
+namespace client {
+
+class FileTransferWindowProxy;
+
+// Keeps a remote folder in sync with a local folder. The local folder is watched for changes. When
+// there are no new changes for kSyncDelay (or changes keep coming for kMaxSyncDelay), the folder
+// is scanned and the new and modified files are uploaded. Existing remote files are replaced in
+// place, so only their changed blocks are transferred. Files removed from the local folder are
+// kept in the remote folder.
+class FolderSync
+{
+public:
+    FolderSync(std::shared_ptr<base::TaskRunner> io_task_runner,
+               std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy,
+               std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy);
+    ~FolderSync();
+
+    // Uploads the contents of |local_path| to |remote_path| and then keeps uploading the changes.
+    // Returns false if the local folder cannot be watched.
+    bool start(const std::string& local_path, const std::string& remote_path);
+
+    struct Entry
+    {
+        bool is_directory = false;
+        int64_t size = 0;
+        std::filesystem::file_time_type last_write;
+
+        bool operator==(const Entry& other) const
+        {
+            return is_directory == other.is_directory && size == other.size &&
+                   last_write == other.last_write;
+        }
+
+        bool operator!=(const Entry& other) const { return !(*this == other); }
+    };
+
+    // Entries of the folder by their paths relative to the folder (UTF-8, '/' as separator).
+    using Snapshot = std::map<std::string, Entry>;
+
+    // Returns the items which are new or modified in |current| since |previous|. A new directory
+    // is transferred as a whole, so the items inside it are not listed.
+    static std::vector<FileTransfer::Item> changedItems(const Snapshot& previous,
+                                                        const Snapshot& current);
+
+private:
+    void onFolderChanged(bool error);
+    void scheduleSync(std::chrono::milliseconds delay);
+    void startScan();
+    void onScanFinished(Snapshot&& snapshot);
+    void onTransferFinished();
+
+    // Called on the scan thread.
+    static Snapshot scan(const std::filesystem::path& folder);
+
+    std::shared_ptr<base::TaskRunner> io_task_runner_;
+    std::shared_ptr<FileTransferWindowProxy> transfer_window_proxy_;
+    std::shared_ptr<common::FileTaskConsumerProxy> task_consumer_proxy_;
+
+    std::string local_path_;
+    std::string remote_path_;
+
+    std::unique_ptr<base::FilePathWatcher> watcher_;
+    base::WaitableTimer sync_timer_;
+
+    // Time of the first change which is not synced yet.
+    std::chrono::steady_clock::time_point first_change_time_;
+    bool has_changes_ = false;
+
+    base::Thread scan_thread_;
+    bool scan_running_ = false;
+
+    // The scan results posted to the I/O thread are dropped after the object is destroyed.
+    std::shared_ptr<FolderSync*> self_;
+
+    // State of the local folder at the last sync.
+    Snapshot synced_;
+
+    // State of the local folder which is being uploaded. It becomes |synced_| when the transfer is
+    // completed.
+    Snapshot uploading_;
+    std::unique_ptr<FileTransfer> transfer_;
+
+    DISALLOW_COPY_AND_ASSIGN(FolderSync);
+};
+
+} // namespace client
+
+#endif // CLIENT__FOLDER_SYNC_H
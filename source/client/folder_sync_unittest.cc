@@ -0,0 +1,151 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/folder_sync.h"
+
+#include <gtest/gtest.h>
+
+namespace client {
+
+namespace {
+
+FolderSync::Entry fileEntry(int64_t size, int seconds)
+{
+    FolderSync::Entry entry;
+    entry.size = size;
+    entry.last_write = std::filesystem::file_time_type(std::chrono::seconds(seconds));
+    return entry;
+}
+
+FolderSync::Entry directoryEntry()
+{
+    FolderSync::Entry entry;
+    entry.is_directory = true;
+    return entry;
+}
+
+std::vector<std::string> names(const std::vector<FileTransfer::Item>& items)
+{
+    std::vector<std::string> result;
+    for (const auto& item : items)
+        result.emplace_back(item.name);
+    return result;
+}
+
+} // namespace
+
+TEST(FolderSyncTest, NothingChanged)
+{
+    FolderSync::Snapshot snapshot;
+    snapshot.emplace("dir", directoryEntry());
+    snapshot.emplace("dir/file.txt", fileEntry(10, 1));
+    snapshot.emplace("file.txt", fileEntry(20, 2));
+
+    EXPECT_TRUE(FolderSync::changedItems(snapshot, snapshot).empty());
+}
+
+TEST(FolderSyncTest, EverythingIsNewAtFirstSync)
+{
+    FolderSync::Snapshot current;
+    current.emplace("a.txt", fileEntry(10, 1));
+    current.emplace("b.txt", fileEntry(20, 2));
+
+    std::vector<FileTransfer::Item> items =
+        FolderSync::changedItems(FolderSync::Snapshot(), current);
+
+    ASSERT_EQ(items.size(), 2u);
+    EXPECT_EQ(items[0].name, "a.txt");
+    EXPECT_FALSE(items[0].is_directory);
+    EXPECT_EQ(items[0].size, 10);
+    EXPECT_EQ(items[1].name, "b.txt");
+    EXPECT_EQ(items[1].size, 20);
+}
+
+TEST(FolderSyncTest, NewDirectoryIsTransferredAsWhole)
+{
+    FolderSync::Snapshot previous;
+    previous.emplace("file.txt", fileEntry(10, 1));
+
+    FolderSync::Snapshot current = previous;
+    current.emplace("new", directoryEntry());
+    current.emplace("new/file.txt", fileEntry(20, 2));
+    current.emplace("new/sub", directoryEntry());
+    current.emplace("new/sub/file.txt", fileEntry(30, 3));
+
+    std::vector<FileTransfer::Item> items = FolderSync::changedItems(previous, current);
+
+    ASSERT_EQ(items.size(), 1u);
+    EXPECT_EQ(items[0].name, "new");
+    EXPECT_TRUE(items[0].is_directory);
+}
+
+TEST(FolderSyncTest, ModifiedFile)
+{
+    FolderSync::Snapshot previous;
+    previous.emplace("resized.txt", fileEntry(10, 1));
+    previous.emplace("touched.txt", fileEntry(20, 2));
+    previous.emplace("unchanged.txt", fileEntry(30, 3));
+
+    FolderSync::Snapshot current;
+    current.emplace("resized.txt", fileEntry(15, 1));
+    current.emplace("touched.txt", fileEntry(20, 5));
+    current.emplace("unchanged.txt", fileEntry(30, 3));
+
+    std::vector<FileTransfer::Item> items = FolderSync::changedItems(previous, current);
+
+    EXPECT_EQ(names(items), std::vector<std::string>({ "resized.txt", "touched.txt" }));
+    ASSERT_EQ(items.size(), 2u);
+    EXPECT_EQ(items[0].size, 15);
+}
+
+TEST(FolderSyncTest, NestedPathInExistingDirectory)
+{
+    FolderSync::Snapshot previous;
+    previous.emplace("dir", directoryEntry());
+    previous.emplace("dir/sub", directoryEntry());
+    previous.emplace("dir/sub/old.txt", fileEntry(10, 1));
+
+    FolderSync::Snapshot current = previous;
+    current.emplace("dir/sub/new.txt", fileEntry(20, 2));
+
+    // A directory with a name which starts with the name of a new directory is not inside it.
+    current.emplace("dir/s", directoryEntry());
+    current.emplace("dir/s.txt", fileEntry(30, 3));
+
+    std::vector<FileTransfer::Item> items = FolderSync::changedItems(previous, current);
+
+    EXPECT_EQ(names(items), std::vector<std::string>({ "dir/s", "dir/s.txt", "dir/sub/new.txt" }));
+}
+
+TEST(FolderSyncTest, FileReplacedByDirectory)
+{
+    FolderSync::Snapshot previous;
+    previous.emplace("item", fileEntry(10, 1));
+
+    FolderSync::Snapshot current;
+    current.emplace("item", directoryEntry());
+    current.emplace("item/file.txt", fileEntry(20, 2));
+
+    std::vector<FileTransfer::Item> items = FolderSync::changedItems(previous, current);
+
+    ASSERT_EQ(items.size(), 1u);
+    EXPECT_EQ(items[0].name, "item");
+    EXPECT_TRUE(items[0].is_directory);
+}
+
+} // namespace client
@@ -0,0 +1,195 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/host_status_checker.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "base/peer/client_authenticator.h"
+#include "proto/router_peer.pb.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace client {
+
+namespace {
+
+// The router checks no more than 10000 hosts in one request (see router::Server::hostStatus).
+const size_t kHostsPerRequest = 1000;
+
+} // namespace
+
+HostStatusChecker::HostStatusChecker(const RouterConfig& router_config,
+                                     std::shared_ptr<base::TaskRunner> task_runner)
+    : task_runner_(std::move(task_runner)),
+      router_config_(router_config)
+{
+    DCHECK(task_runner_);
+}
+
+HostStatusChecker::~HostStatusChecker() = default;
+
+void HostStatusChecker::start(const std::vector<base::HostId>& host_ids, Delegate* delegate)
+{
+    host_ids_ = host_ids;
+    delegate_ = delegate;
+
+    DCHECK(delegate_);
+
+    if (host_ids_.empty())
+        return;
+
+    LOG(LS_INFO) << "Checking the status of " << host_ids_.size() << " hosts";
+
+    channel_ = std::make_unique<base::NetworkChannel>();
+    channel_->setListener(this);
+    channel_->connect(router_config_.address, router_config_.port);
+}
+
+void HostStatusChecker::onConnected()
+{
+    channel_->setOwnKeepAlive(true);
+    channel_->setNoDelay(true);
+
+    authenticator_ = std::make_unique<base::ClientAuthenticator>(task_runner_);
+
+    authenticator_->setIdentify(proto::IDENTIFY_SRP);
+    authenticator_->setUserName(router_config_.username);
+    authenticator_->setPassword(router_config_.password);
+    authenticator_->setSessionType(proto::ROUTER_SESSION_CLIENT);
+
+    authenticator_->start(std::move(channel_),
+                          [this](base::ClientAuthenticator::ErrorCode error_code)
+    {
+        if (error_code == base::ClientAuthenticator::ErrorCode::SUCCESS)
+        {
+            // The authenticator takes the listener on itself, we return the receipt of
+            // notifications.
+            channel_ = authenticator_->takeChannel();
+            channel_->setListener(this);
+
+            // Now the session will receive incoming messages.
+            channel_->resume();
+
+            sendRequests();
+        }
+        else
+        {
+            LOG(LS_WARNING) << "Authentication failed: "
+                            << base::ClientAuthenticator::errorToString(error_code);
+            onError();
+        }
+
+        // Authenticator is no longer needed.
+        task_runner_->deleteSoon(std::move(authenticator_));
+    });
+}
+
+void HostStatusChecker::onDisconnected(base::NetworkChannel::ErrorCode error_code)
+{
+    LOG(LS_INFO) << "Connection to the router is lost ("
+                 << base::NetworkChannel::errorToString(error_code) << ")";
+    onError();
+}
+
+void HostStatusChecker::onMessageReceived(const base::ByteArray& buffer)
+{
+    proto::RouterToPeer message;
+    if (!base::parse(buffer, &message))
+    {
+        LOG(LS_ERROR) << "Invalid message from router";
+        return;
+    }
+
+    if (!message.has_host_status_list())
+    {
+        LOG(LS_WARNING) << "Unhandled message from router";
+        return;
+    }
+
+    if (pending_batches_.empty())
+    {
+        LOG(LS_ERROR) << "Unexpected host status list";
+        return;
+    }
+
+    std::vector<base::HostId> batch = std::move(pending_batches_.front());
+    pending_batches_.pop_front();
+
+    const proto::HostStatusList& host_status_list = message.host_status_list();
+
+    std::unordered_set<base::HostId> online(host_status_list.online_host_id().begin(),
+                                            host_status_list.online_host_id().end());
+    std::vector<base::HostId> online_hosts;
+    std::vector<base::HostId> offline_hosts;
+
+    for (base::HostId host_id : batch)
+    {
+        if (online.count(host_id))
+            online_hosts.emplace_back(host_id);
+        else
+            offline_hosts.emplace_back(host_id);
+    }
+
+    if (pending_batches_.empty())
+    {
+        // All results are received, the connection is no longer needed.
+        channel_->setListener(nullptr);
+        task_runner_->deleteSoon(std::move(channel_));
+    }
+
+    if (delegate_)
+        delegate_->onHostStatus(online_hosts, offline_hosts);
+}
+
+void HostStatusChecker::onMessageWritten(size_t /* pending */)
+{
+    // Nothing
+}
+
+void HostStatusChecker::sendRequests()
+{
+    // All requests are sent at once, the router answers them in the same order.
+    for (size_t offset = 0; offset < host_ids_.size(); offset += kHostsPerRequest)
+    {
+        auto first = host_ids_.cbegin() + offset;
+        auto last = host_ids_.cbegin() + std::min(offset + kHostsPerRequest, host_ids_.size());
+
+        proto::PeerToRouter message;
+        proto::HostStatusRequest* request = message.mutable_host_status_request();
+
+        for (auto it = first; it != last; ++it)
+            request->add_host_id(*it);
+
+        channel_->send(base::serialize(message));
+        pending_batches_.emplace_back(first, last);
+    }
+
+    host_ids_.clear();
+}
+
+void HostStatusChecker::onError()
+{
+    pending_batches_.clear();
+
+    if (delegate_)
+        delegate_->onHostStatusError();
+}
+
+} // namespace client
@@ -0,0 +1,88 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__HOST_STATUS_CHECKER_H
+#define CLIENT__HOST_STATUS_CHECKER_H
+
+#include "base/macros_magic.h"
+#include "base/net/network_channel.h"
+#include "base/peer/host_id.h"
+#include "client/router_config.h"
+
+#include <deque>
+#include <vector>
+
+namespace base {
+class ClientAuthenticator;
+class TaskRunner;
+} // namespace base
+
+namespace client {
+
+// Asks the router which hosts are online. The hosts are sent in batches over one connection, the
+// results come for each batch. All methods must be called on the thread of |task_runner|.
+class HostStatusChecker : public base::NetworkChannel::Listener
+{
+public:
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        // Called for each batch of the hosts.
+        virtual void onHostStatus(const std::vector<base::HostId>& online_hosts,
+                                  const std::vector<base::HostId>& offline_hosts) = 0;
+
+        // Called if the router is not available. The status of the hosts for which no result was
+        // received is unknown.
+        virtual void onHostStatusError() = 0;
+    };
+
+    HostStatusChecker(const RouterConfig& router_config,
+                      std::shared_ptr<base::TaskRunner> task_runner);
+    ~HostStatusChecker();
+
+    void start(const std::vector<base::HostId>& host_ids, Delegate* delegate);
+
+protected:
+    // base::NetworkChannel::Listener implementation.
+    void onConnected() override;
+    void onDisconnected(base::NetworkChannel::ErrorCode error_code) override;
+    void onMessageReceived(const base::ByteArray& buffer) override;
+    void onMessageWritten(size_t pending) override;
+
+private:
+    void sendRequests();
+    void onError();
+
+    std::shared_ptr<base::TaskRunner> task_runner_;
+    std::unique_ptr<base::NetworkChannel> channel_;
+    std::unique_ptr<base::ClientAuthenticator> authenticator_;
+    RouterConfig router_config_;
+
+    std::vector<base::HostId> host_ids_;
+    // Batches which are sent to the router and are waiting for the result (in order of sending).
+    std::deque<std::vector<base::HostId>> pending_batches_;
+    Delegate* delegate_ = nullptr;
+
+    DISALLOW_COPY_AND_ASSIGN(HostStatusChecker);
+};
+
+} // namespace client
+
+#endif // CLIENT__HOST_STATUS_CHECKER_H
@@ -25,6 +25,13 @@
 
 namespace client {
 
+namespace {
+
+// The router sends the session list in parts of this size.
+const uint32_t kSessionsPerRequest = 500;
+
+} // namespace
+
 Router::Router(std::shared_ptr<RouterWindowProxy> window_proxy,
                std::shared_ptr<base::TaskRunner> io_task_runner)
     : io_task_runner_(io_task_runner),
@@ -56,11 +63,17 @@ void Router::connectToRouter(std::u16string_view address, uint16_t port)
 
 void Router::refreshSessionList()
 {
+    if (session_list_pending_)
+    {
+        LOG(LS_INFO) << "Session list is already being received";
+        return;
+    }
+
     LOG(LS_INFO) << "Sending session list request";
 
-    proto::AdminToRouter message;
-    message.mutable_session_list_request()->set_dummy(1);
-    channel_->send(base::serialize(message));
+    session_list_pending_ = true;
+    pending_sessions_.clear();
+    sendSessionListRequest(0);
 }
 
 void Router::stopSession(int64_t session_id)
@@ -173,10 +186,12 @@ void Router::onMessageReceived(const base::ByteArray& buffer)
 
     if (message.has_session_list())
     {
-        LOG(LS_INFO) << "Session list received";
-
-        window_proxy_->onSessionList(
-            std::shared_ptr<proto::SessionList>(message.release_session_list()));
+        onSessionListPart(message.session_list());
+    }
+    else if (message.has_session_list_update())
+    {
+        onSessionListUpdate(std::shared_ptr<proto::SessionListUpdate>(
+            message.release_session_list_update()));
     }
     else if (message.has_session_result())
     {
@@ -211,4 +226,80 @@ void Router::onMessageWritten(size_t /* pending */)
     // Not used.
 }
 
+void Router::sendSessionListRequest(int64_t start_session_id)
+{
+    proto::AdminToRouter message;
+
+    proto::SessionListRequest* request = message.mutable_session_list_request();
+    request->set_session_type_mask(proto::ROUTER_SESSION_HOST | proto::ROUTER_SESSION_RELAY);
+    request->set_start_session_id(start_session_id);
+    request->set_max_count(kSessionsPerRequest);
+    request->set_subscribe(true);
+
+    channel_->send(base::serialize(message));
+}
+
+void Router::onSessionListPart(const proto::SessionList& session_list)
+{
+    if (!session_list_pending_)
+    {
+        LOG(LS_WARNING) << "Unexpected session list";
+        return;
+    }
+
+    std::shared_ptr<proto::SessionList> result = std::make_shared<proto::SessionList>();
+
+    if (session_list.error_code() != proto::SessionList::SUCCESS)
+    {
+        LOG(LS_ERROR) << "Session list request failed: " << session_list.error_code();
+        result->set_error_code(session_list.error_code());
+    }
+    else
+    {
+        // Sessions received in the updates are replaced with the same sessions from the list.
+        for (int i = 0; i < session_list.session_size(); ++i)
+        {
+            const proto::Session& session = session_list.session(i);
+            pending_sessions_.insert_or_assign(session.session_id(), session);
+        }
+
+        if (session_list.next_session_id())
+        {
+            sendSessionListRequest(session_list.next_session_id());
+            return;
+        }
+
+        for (const auto& session : pending_sessions_)
+            result->add_session()->CopyFrom(session.second);
+
+        result->set_error_code(proto::SessionList::SUCCESS);
+    }
+
+    LOG(LS_INFO) << "Session list received (" << result->session_size() << " sessions)";
+
+    session_list_pending_ = false;
+    pending_sessions_.clear();
+
+    window_proxy_->onSessionList(std::move(result));
+}
+
+void Router::onSessionListUpdate(std::shared_ptr<proto::SessionListUpdate> update)
+{
+    if (!session_list_pending_)
+    {
+        window_proxy_->onSessionListUpdate(std::move(update));
+        return;
+    }
+
+    // The list is not yet received completely, the changes are applied to the received part.
+    for (int i = 0; i < update->session_size(); ++i)
+    {
+        const proto::Session& session = update->session(i);
+        pending_sessions_.insert_or_assign(session.session_id(), session);
+    }
+
+    for (int i = 0; i < update->removed_session_id_size(); ++i)
+        pending_sessions_.erase(update->removed_session_id(i));
+}
+
 } // namespace client
@@ -24,6 +24,8 @@
 #include "base/peer/host_id.h"
 #include "proto/router_admin.pb.h"
 
+#include <map>
+
 namespace base {
 class TaskRunner;
 } // namespace base
@@ -44,6 +46,8 @@ public:
 
     void connectToRouter(std::u16string_view address, uint16_t port);
 
+    // The list is received in parts. After that the router sends the changes of the list (see
+    // RouterWindow::onSessionListUpdate).
     void refreshSessionList();
     void stopSession(int64_t session_id);
 
@@ -60,11 +64,19 @@ protected:
     void onMessageWritten(size_t pending) override;
 
 private:
+    void sendSessionListRequest(int64_t start_session_id);
+    void onSessionListPart(const proto::SessionList& session_list);
+    void onSessionListUpdate(std::shared_ptr<proto::SessionListUpdate> update);
+
     std::shared_ptr<base::TaskRunner> io_task_runner_;
     std::unique_ptr<base::NetworkChannel> channel_;
     std::unique_ptr<base::ClientAuthenticator> authenticator_;
     std::shared_ptr<RouterWindowProxy> window_proxy_;
 
+    // Sessions received while the list is being received in parts.
+    bool session_list_pending_ = false;
+    std::map<int64_t, proto::Session> pending_sessions_;
+
     DISALLOW_COPY_AND_ASSIGN(Router);
 };
 
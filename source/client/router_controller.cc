@@ -21,10 +21,24 @@
 #include "base/logging.h"
 #include "base/task_runner.h"
 #include "base/peer/client_authenticator.h"
+#include "base/strings/strcat.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/unicode.h"
 #include "proto/router_peer.pb.h"
 
 namespace client {
 
+namespace {
+
+// Identifies the router and the user for which the session ticket is issued.
+std::string sessionTicketKey(const RouterConfig& config)
+{
+    return base::utf8FromUtf16(base::strCat(
+        { config.username, u"@", config.address, u":", base::numberToString16(config.port) }));
+}
+
+} // namespace
+
 RouterController::RouterController(const RouterConfig& router_config,
                                    std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(std::move(task_runner)),
@@ -44,6 +58,7 @@ void RouterController::connectTo(base::HostId host_id, Delegate* delegate)
     DCHECK(delegate_);
 
     LOG(LS_INFO) << "Connecting to router...";
+    trace_.addStage("Connecting to router");
 
     channel_ = std::make_unique<base::NetworkChannel>();
     channel_->setListener(this);
@@ -53,6 +68,7 @@ void RouterController::connectTo(base::HostId host_id, Delegate* delegate)
 void RouterController::onConnected()
 {
     LOG(LS_INFO) << "Connection to the router is established";
+    trace_.addStage("Connected to router");
 
     channel_->setOwnKeepAlive(true);
     channel_->setNoDelay(true);
@@ -63,6 +79,8 @@ void RouterController::onConnected()
     authenticator_->setUserName(router_config_.username);
     authenticator_->setPassword(router_config_.password);
     authenticator_->setSessionType(proto::ROUTER_SESSION_CLIENT);
+    authenticator_->setSessionTicket(
+        base::SessionTicketCache::find(sessionTicketKey(router_config_)));
 
     authenticator_->start(std::move(channel_),
                           [this](base::ClientAuthenticator::ErrorCode error_code)
@@ -74,6 +92,11 @@ void RouterController::onConnected()
             channel_ = authenticator_->takeChannel();
             channel_->setListener(this);
 
+            // Each connection to a host goes through a new connection to the router. The ticket
+            // allows to skip the SRP exchange with the router next time.
+            base::SessionTicketCache::store(
+                sessionTicketKey(router_config_), authenticator_->sessionTicket());
+
             LOG(LS_INFO) << "Sending connection request (host_id: " << host_id_ << ")";
 
             // Now the session will receive incoming messages.
@@ -81,8 +104,12 @@ void RouterController::onConnected()
 
             // Send connection request.
             proto::PeerToRouter message;
-            message.mutable_connection_request()->set_host_id(host_id_);
+            proto::ConnectionRequest* request = message.mutable_connection_request();
+            request->set_host_id(host_id_);
+            request->set_trace_id(trace_.id());
             channel_->send(base::serialize(message));
+
+            trace_.addStage("Connection request sent to router");
         }
         else
         {
@@ -130,13 +157,14 @@ void RouterController::onMessageReceived(const base::ByteArray& buffer)
 
     if (message.has_connection_offer())
     {
-        if (relay_peer_)
+        if (direct_peer_ || relay_peer_)
         {
             LOG(LS_ERROR) << "Re-offer connection detected";
             return;
         }
 
         const proto::ConnectionOffer& connection_offer = message.connection_offer();
+        trace_.addStage("Connection offer received from router");
 
         if (connection_offer.error_code() != proto::ConnectionOffer::SUCCESS ||
             connection_offer.peer_role() != proto::ConnectionOffer::CLIENT)
@@ -170,8 +198,20 @@ void RouterController::onMessageReceived(const base::ByteArray& buffer)
         }
         else
         {
-            relay_peer_ = std::make_unique<base::RelayPeer>();
-            relay_peer_->start(connection_offer.relay(), this);
+            offer_ = std::make_unique<proto::ConnectionOffer>(connection_offer);
+
+            if (connection_offer.candidate_size() > 0)
+            {
+                // The relay is not needed if the host is reachable directly.
+                LOG(LS_INFO) << "Trying " << connection_offer.candidate_size()
+                             << " direct candidates";
+                direct_peer_ = std::make_unique<base::DirectPeer>();
+                direct_peer_->start(*offer_, this);
+            }
+            else
+            {
+                connectToRelay();
+            }
         }
     }
     else
@@ -185,8 +225,47 @@ void RouterController::onMessageWritten(size_t /* pending */)
     // Nothing
 }
 
+void RouterController::onDirectConnectionReady(std::unique_ptr<base::NetworkChannel> channel)
+{
+    trace_.addStage("Direct connection to host established");
+
+    if (delegate_)
+        delegate_->onHostConnected(std::move(channel));
+}
+
+void RouterController::onDirectConnectionError()
+{
+    LOG(LS_INFO) << "Direct connection failed. Connecting through relay";
+    trace_.addStage("Direct connection to host failed");
+    connectToRelay();
+}
+
+bool RouterController::connectToRelayAfterFailure()
+{
+    // The relay is connected once, and only after a direct connection.
+    if (!offer_ || !direct_peer_ || relay_peer_)
+        return false;
+
+    LOG(LS_INFO) << "Authentication over direct connection failed. Connecting through relay";
+    trace_.addStage("Authentication over direct connection failed");
+    connectToRelay();
+    return true;
+}
+
+void RouterController::connectToRelay()
+{
+    DCHECK(offer_);
+    DCHECK(!relay_peer_);
+
+    relay_peer_ = std::make_unique<base::RelayPeer>(base::NetworkChannel::Role::CLIENT);
+    relay_peer_->start(*offer_, this);
+    offer_.reset();
+}
+
 void RouterController::onRelayConnectionReady(std::unique_ptr<base::NetworkChannel> channel)
 {
+    trace_.addStage("Connection to host established");
+
     if (delegate_)
         delegate_->onHostConnected(std::move(channel));
 }
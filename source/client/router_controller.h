@@ -22,6 +22,8 @@
 #include "base/waitable_timer.h"
 #include "base/net/network_channel.h"
 #include "base/peer/authenticator.h"
+#include "base/peer/connection_trace.h"
+#include "base/peer/direct_peer.h"
 #include "base/peer/host_id.h"
 #include "base/peer/relay_peer.h"
 #include "client/router_config.h"
@@ -34,6 +36,7 @@ namespace client {
 
 class RouterController
     : public base::NetworkChannel::Listener,
+      public base::DirectPeer::Delegate,
       public base::RelayPeer::Delegate
 {
 public:
@@ -81,6 +84,14 @@ public:
 
     void connectTo(base::HostId host_id, Delegate* delegate);
 
+    // Called by the delegate if the authentication over the direct connection has failed (it may
+    // have reached another computer with the same private address). Returns true if the relay of
+    // the offer is connected instead, the delegate gets its channel by onHostConnected then.
+    bool connectToRelayAfterFailure();
+
+    // Trace of the connection to the host (see base::ConnectionTrace).
+    base::ConnectionTrace& trace() { return trace_; }
+
 protected:
     // base::NetworkChannel::Listener implementation.
     void onConnected() override;
@@ -88,19 +99,31 @@ protected:
     void onMessageReceived(const base::ByteArray& buffer) override;
     void onMessageWritten(size_t pending) override;
 
+    // base::DirectPeer::Delegate implementation.
+    void onDirectConnectionReady(std::unique_ptr<base::NetworkChannel> channel) override;
+    void onDirectConnectionError() override;
+
     // base::RelayPeer::Delegate implementation.
     void onRelayConnectionReady(std::unique_ptr<base::NetworkChannel> channel) override;
     void onRelayConnectionError() override;
 
 private:
+    void connectToRelay();
+
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::unique_ptr<base::NetworkChannel> channel_;
     std::unique_ptr<base::ClientAuthenticator> authenticator_;
+    std::unique_ptr<base::DirectPeer> direct_peer_;
     std::unique_ptr<base::RelayPeer> relay_peer_;
+
+    // The offer is kept until the direct connection is authenticated. Its relay is used if the
+    // connection or the authentication fails.
+    std::unique_ptr<proto::ConnectionOffer> offer_;
     RouterConfig router_config_;
 
     base::HostId host_id_ = base::kInvalidHostId;
     Delegate* delegate_ = nullptr;
+    base::ConnectionTrace trace_;
 
     DISALLOW_COPY_AND_ASSIGN(RouterController);
 };
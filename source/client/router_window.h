@@ -23,6 +23,7 @@
 
 namespace proto {
 class SessionList;
+class SessionListUpdate;
 class SessionResult;
 class UserList;
 class UserResult;
@@ -39,6 +40,7 @@ public:
     virtual void onDisconnected(base::NetworkChannel::ErrorCode error_code) = 0;
     virtual void onAccessDenied(base::ClientAuthenticator::ErrorCode error_code) = 0;
     virtual void onSessionList(std::shared_ptr<proto::SessionList> session_list) = 0;
+    virtual void onSessionListUpdate(std::shared_ptr<proto::SessionListUpdate> update) = 0;
     virtual void onSessionResult(std::shared_ptr<proto::SessionResult> session_result) = 0;
     virtual void onUserList(std::shared_ptr<proto::UserList> user_list) = 0;
     virtual void onUserResult(std::shared_ptr<proto::UserResult> user_result) = 0;
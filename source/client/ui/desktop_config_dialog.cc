@@ -18,6 +18,7 @@
 
 #include "client/ui/desktop_config_dialog.h"
 
+#include "build/build_config.h"
 #include "client/config_factory.h"
 #include "ui_desktop_config_dialog.h"
 
@@ -37,6 +38,15 @@ DesktopConfigDialog::DesktopConfigDialog(proto::SessionType session_type,
 
     QComboBox* combo_codec = ui->combo_codec;
 
+#if defined(OS_WIN)
+    // Only the Windows client has a decoder for H.264.
+    if (video_encodings & proto::VIDEO_ENCODING_H264)
+        combo_codec->addItem(QStringLiteral("H.264"), proto::VIDEO_ENCODING_H264);
+#endif // defined(OS_WIN)
+
+    if (video_encodings & proto::VIDEO_ENCODING_AV1)
+        combo_codec->addItem(QStringLiteral("AV1"), proto::VIDEO_ENCODING_AV1);
+
     if (video_encodings & proto::VIDEO_ENCODING_VP9)
         combo_codec->addItem(QStringLiteral("VP9"), proto::VIDEO_ENCODING_VP9);
 
@@ -49,9 +59,30 @@ DesktopConfigDialog::DesktopConfigDialog(proto::SessionType session_type,
 
     combo_codec->setCurrentIndex(current_codec);
 
+    if (config_.flags() & proto::FULL_CHROMA)
+        ui->checkbox_full_chroma->setChecked(true);
+
+    // Only VP9 has a profile without the chroma subsampling.
+    auto update_full_chroma = [this]()
+    {
+        ui->checkbox_full_chroma->setEnabled(
+            ui->combo_codec->currentData().toInt() == proto::VIDEO_ENCODING_VP9);
+    };
+
+    update_full_chroma();
+    connect(combo_codec, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, update_full_chroma);
+
     if (config_.audio_encoding() != proto::AUDIO_ENCODING_UNKNOWN)
         ui->checkbox_audio->setChecked(true);
 
+    if (config_.flags() & proto::LOW_LATENCY_AUDIO)
+        ui->checkbox_low_latency_audio->setChecked(true);
+
+    ui->checkbox_low_latency_audio->setEnabled(ui->checkbox_audio->isChecked());
+    connect(ui->checkbox_audio, &QCheckBox::toggled,
+            ui->checkbox_low_latency_audio, &QCheckBox::setEnabled);
+
     if (session_type == proto::SESSION_TYPE_DESKTOP_MANAGE)
     {
         if (config_.flags() & proto::LOCK_AT_DISCONNECT)
@@ -106,6 +137,9 @@ void DesktopConfigDialog::onButtonBoxClicked(QAbstractButton* button)
 
         uint32_t flags = 0;
 
+        if (ui->checkbox_full_chroma->isChecked() && ui->checkbox_full_chroma->isEnabled())
+            flags |= proto::FULL_CHROMA;
+
         if (ui->checkbox_cursor_shape->isChecked() && ui->checkbox_cursor_shape->isEnabled())
             flags |= proto::ENABLE_CURSOR_SHAPE;
 
@@ -121,6 +155,9 @@ void DesktopConfigDialog::onButtonBoxClicked(QAbstractButton* button)
         if (ui->checkbox_font_smoothing->isChecked())
             flags |= proto::DISABLE_FONT_SMOOTHING;
 
+        if (ui->checkbox_audio->isChecked() && ui->checkbox_low_latency_audio->isChecked())
+            flags |= proto::LOW_LATENCY_AUDIO;
+
         if (ui->checkbox_block_remote_input->isChecked())
             flags |= proto::BLOCK_REMOTE_INPUT;
 
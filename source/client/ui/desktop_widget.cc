@@ -25,6 +25,8 @@
 #include <QApplication>
 #include <QWheelEvent>
 
+#include <cmath>
+
 #if defined(OS_LINUX)
 #include <X11/XKBlib.h>
 #if defined(KeyPress)
@@ -122,6 +124,45 @@ void DesktopWidget::setDesktopFrame(std::shared_ptr<base::Frame>& frame)
     frame_ = std::move(frame);
 }
 
+void DesktopWidget::updateDesktopFrame(const base::Region& updated_region)
+{
+    if (!frame_ || frame_->size().isEmpty())
+        return;
+
+    const double scale_x = static_cast<double>(width()) / frame_->size().width();
+    const double scale_y = static_cast<double>(height()) / frame_->size().height();
+    const bool is_scaled = size() != QSize(frame_->size().width(), frame_->size().height());
+
+    QRegion region;
+
+    for (base::Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
+    {
+        const base::Rect& rect = it.rect();
+
+        if (!is_scaled)
+        {
+            region += QRect(rect.x(), rect.y(), rect.width(), rect.height());
+            continue;
+        }
+
+        // The scaled pixels at the edges of the rectangle are interpolated with their neighbours,
+        // so the rectangle is extended by one pixel.
+        const int left = static_cast<int>(std::floor(rect.left() * scale_x)) - 1;
+        const int top = static_cast<int>(std::floor(rect.top() * scale_y)) - 1;
+        const int right = static_cast<int>(std::ceil(rect.right() * scale_x)) + 1;
+        const int bottom = static_cast<int>(std::ceil(rect.bottom() * scale_y)) + 1;
+
+        region += QRect(left, top, right - left, bottom - top);
+    }
+
+    // The updates which come before the painting are painted together.
+    if (update_time_ == std::chrono::steady_clock::time_point())
+        update_time_ = std::chrono::steady_clock::now();
+
+    // Only the updated part of the widget is painted by paintEvent.
+    update(region);
+}
+
 void DesktopWidget::doMouseEvent(QEvent::Type event_type,
                                  const Qt::MouseButtons& buttons,
                                  const QPoint& pos,
@@ -324,9 +365,28 @@ void DesktopWidget::paintEvent(QPaintEvent* /* event */)
         painter_.setRenderHint(QPainter::SmoothPixmapTransform);
 #endif
 
-        painter_.drawImage(rect(), frame->constImage());
+        // The painter is clipped to the updated region of the widget.
+        const QImage& image = frame->constImage();
+        if (size() == image.size())
+            painter_.drawImage(QPoint(0, 0), image);
+        else
+            painter_.drawImage(rect(), image);
+
         painter_.end();
     }
+
+    if (update_time_ != std::chrono::steady_clock::time_point())
+    {
+        static const double kAlpha = 0.1;
+
+        const double paint_time = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - update_time_).count());
+
+        paint_time_ = std::chrono::microseconds(static_cast<int64_t>(
+            (kAlpha * paint_time) + ((1.0 - kAlpha) * static_cast<double>(paint_time_.count()))));
+        update_time_ = std::chrono::steady_clock::time_point();
+    }
 }
 
 void DesktopWidget::mouseMoveEvent(QMouseEvent* event)
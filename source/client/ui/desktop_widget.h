@@ -31,6 +31,7 @@
 #include <QPainter>
 #include <QWidget>
 
+#include <chrono>
 #include <memory>
 #include <set>
 
@@ -47,6 +48,12 @@ public:
     base::Frame* desktopFrame();
     void setDesktopFrame(std::shared_ptr<base::Frame>& frame);
 
+    // Repaints |updated_region| of the frame (in the coordinates of the frame).
+    void updateDesktopFrame(const base::Region& updated_region);
+
+    // Average time from the update of the frame to the end of its painting.
+    std::chrono::microseconds paintTime() const { return paint_time_; }
+
     void doMouseEvent(QEvent::Type event_type,
                       const Qt::MouseButtons& buttons,
                       const QPoint& pos,
@@ -90,6 +97,10 @@ private:
     std::shared_ptr<base::Frame> frame_;
     bool enable_key_sequenses_ = true;
 
+    // Time of the first update which is not painted yet.
+    std::chrono::steady_clock::time_point update_time_;
+    std::chrono::microseconds paint_time_ = std::chrono::microseconds::zero();
+
     QPoint prev_pos_;
     uint32_t prev_mask_ = 0;
 
@@ -80,6 +80,10 @@ QString fileErrorToString(proto::FileError error_code)
             message = QT_TRANSLATE_NOOP("FileError", "Drive not ready");
             break;
 
+        case proto::FILE_ERROR_HASH_MISMATCH:
+            message = QT_TRANSLATE_NOOP("FileError", "Transferred file is corrupted");
+            break;
+
         case proto::FILE_ERROR_NO_LOGGED_ON_USER:
             message = QT_TRANSLATE_NOOP("FileError", "No logged in user");
             break;
@@ -71,6 +71,9 @@ FileList::FileList(QWidget* parent)
 
     setModel(model_);
     setStyle(new TreeViewProxyStyle(style()));
+
+    // All rows have the same height, so the view does not measure each row of a large list.
+    setUniformRowHeights(true);
     setItemDelegate(new FileItemDelegate(this));
 
     connect(model_, &FileListModel::nameChangeRequest, this, &FileList::nameChangeRequest);
@@ -105,6 +108,14 @@ void FileList::showFileList(const proto::FileList& file_list)
     model_->setFileList(file_list);
 }
 
+void FileList::addFileList(const proto::FileList& file_list)
+{
+    if (!isFileListShown())
+        return;
+
+    model_->addFileList(file_list);
+}
+
 void FileList::setMimeType(const QString& mime_type)
 {
     model_->setMimeType(mime_type);
@@ -17,11 +17,14 @@
 //
 
 #include "client/ui/file_list_model.h"
+
+#include "base/logging.h"
 #include "client/ui/file_mime_data.h"
 #include "common/file_platform_util.h"
 
 #include <QDateTime>
 #include <QLocale>
+#include <QThread>
 
 namespace client {
 
@@ -36,69 +39,48 @@ enum Column
     COLUMN_COUNT      = 4
 };
 
-template<class T>
-void sortByName(T& list, Qt::SortOrder order)
-{
-    std::sort(list.begin(), list.end(),
-              [order](const typename T::value_type& f1, const typename T::value_type& f2)
-    {
-        const QString& f1_name = f1.name;
-        const QString& f2_name = f2.name;
-
-        if (order == Qt::AscendingOrder)
-            return f1_name.toLower() < f2_name.toLower();
-        else
-            return f1_name.toLower() > f2_name.toLower();
-    });
-}
-
-template<class T>
-void sortBySize(T& list, Qt::SortOrder order)
-{
-    std::sort(list.begin(), list.end(),
-              [order](const typename T::value_type& f1, const typename T::value_type& f2)
-    {
-        if (order == Qt::AscendingOrder)
-            return f1.size < f2.size;
-        else
-            return f1.size > f2.size;
-    });
-}
+// Lists with fewer items are sorted on the UI thread. It is faster than a round trip to the sort
+// thread and the list is shown sorted right away.
+const size_t kBackgroundSortThreshold = 5000;
 
-template<class T>
-void sortByType(T& list, Qt::SortOrder order)
+// The platform detects the type of a file by its extension, but may also match the whole name
+// (for example, "Makefile"), so a name without an extension is a key of its own.
+QString typeInfoKey(const QString& file_name)
 {
-    std::sort(list.begin(), list.end(),
-              [order](const typename T::value_type& f1, const typename T::value_type& f2)
-    {
-        if (order == Qt::AscendingOrder)
-            return f1.type < f2.type;
-        else
-            return f1.type > f2.type;
-    });
-}
+    const int dot = file_name.indexOf(QLatin1Char('.'), 1);
+    if (dot == -1)
+        return file_name;
 
-template<class T>
-void sortByTime(T& list, Qt::SortOrder order)
-{
-    std::sort(list.begin(), list.end(),
-              [order](const typename T::value_type& f1, const typename T::value_type& f2)
-    {
-        if (order == Qt::AscendingOrder)
-            return f1.last_write < f2.last_write;
-        else
-            return f1.last_write > f2.last_write;
-    });
+    return file_name.mid(dot);
 }
 
 } // namespace
 
+struct FileListModel::SortKey
+{
+    int index;
+    bool is_folder;
+    QString name;
+    QString type;
+    int64_t number;
+};
+
 FileListModel::FileListModel(QObject* parent)
     : QAbstractItemModel(parent),
       dir_icon_(common::FilePlatformUtil::directoryIcon()),
       dir_type_(tr("Folder"))
 {
-    // Nothing
+    new_folder_.is_folder = true;
+}
+
+FileListModel::~FileListModel()
+{
+    if (sort_thread_)
+    {
+        // A sort in progress is completed, its result is dropped with the model.
+        sort_thread_->quit();
+        sort_thread_->wait();
+    }
 }
 
 void FileListModel::setMimeType(const QString& mime_type)
@@ -108,43 +90,90 @@ void FileListModel::setMimeType(const QString& mime_type)
 
 void FileListModel::setFileList(const proto::FileList& list)
 {
-    clear();
+    beginResetModel();
+
+    items_.clear();
+    folder_rows_.clear();
+    file_rows_.clear();
+    has_new_folder_ = false;
+    ++epoch_;
+
+    addItems(list);
+
+    for (size_t i = 0; i < items_.size(); ++i)
+        (items_[i].is_folder ? folder_rows_ : file_rows_).push_back(static_cast<int>(i));
+
+    const bool background_sort = items_.size() >= kBackgroundSortThreshold;
+    if (!background_sort)
+    {
+        std::vector<SortKey> keys = sortKeys();
+        sortRows(&keys, current_column_, current_order_, &folder_rows_, &file_rows_);
+    }
+
+    endResetModel();
+
+    if (background_sort)
+        startBackgroundSort();
+}
 
+void FileListModel::addFileList(const proto::FileList& list)
+{
     if (!list.item_size())
         return;
 
-    beginInsertRows(QModelIndex(), 0, list.item_size() - 1);
+    const size_t first_item = items_.size();
+    addItems(list);
 
-    for (int i = 0; i < list.item_size(); ++i)
-    {
-        const proto::FileList::Item& item = list.item(i);
+    // The new items are inserted where they are stored, after the folders and after the files
+    // already shown. Then they are moved to their sorted positions by a layout change.
+    Rows new_folder_rows;
+    Rows new_file_rows;
 
-        if (item.is_directory())
-        {
-            Folder folder;
-            folder.name       = QString::fromStdString(item.name());
-            folder.last_write = item.modification_time();
+    for (size_t i = first_item; i < items_.size(); ++i)
+        (items_[i].is_folder ? new_folder_rows : new_file_rows).push_back(static_cast<int>(i));
 
-            folder_items_.append(folder);
-        }
-        else
-        {
-            File file;
-            file.name       = QString::fromStdString(item.name());
-            file.last_write = item.modification_time();
-            file.size       = item.size();
+    if (!new_folder_rows.empty())
+    {
+        const int row = static_cast<int>(folder_rows_.size());
 
-            QPair<QIcon, QString> file_info = common::FilePlatformUtil::fileTypeInfo(file.name);
-            file.icon = file_info.first;
-            file.type = file_info.second;
+        beginInsertRows(QModelIndex(), row, row + static_cast<int>(new_folder_rows.size()) - 1);
+        folder_rows_.insert(folder_rows_.end(), new_folder_rows.begin(), new_folder_rows.end());
+        endInsertRows();
+    }
 
-            file_items_.append(file);
-        }
+    if (!new_file_rows.empty())
+    {
+        const int row = itemCount();
+
+        beginInsertRows(QModelIndex(), row, row + static_cast<int>(new_file_rows.size()) - 1);
+        file_rows_.insert(file_rows_.end(), new_file_rows.begin(), new_file_rows.end());
+        endInsertRows();
     }
 
-    sortItems(current_column_, current_order_);
+    // The rows are inserted before the sort, so the views never see rows which are not counted.
+    sortItems();
+}
 
-    endInsertRows();
+void FileListModel::addItems(const proto::FileList& list)
+{
+    items_.reserve(items_.size() + static_cast<size_t>(list.item_size()));
+
+    for (int i = 0; i < list.item_size(); ++i)
+    {
+        const proto::FileList::Item& list_item = list.item(i);
+
+        Item item;
+        item.name       = QString::fromStdString(list_item.name());
+        item.sort_name  = item.name.toLower();
+        item.last_write = list_item.modification_time();
+        item.is_folder  = list_item.is_directory();
+
+        // The icon and the type are resolved when the item is shown for the first time.
+        if (!item.is_folder)
+            item.size = list_item.size();
+
+        items_.emplace_back(std::move(item));
+    }
 }
 
 void FileListModel::setSortOrder(int column, Qt::SortOrder order)
@@ -155,51 +184,44 @@ void FileListModel::setSortOrder(int column, Qt::SortOrder order)
 
 void FileListModel::clear()
 {
-    if (folder_items_.isEmpty() && file_items_.isEmpty())
+    if (!itemCount())
         return;
 
-    beginRemoveRows(QModelIndex(), 0, folder_items_.count() + file_items_.count() - 1);
+    beginRemoveRows(QModelIndex(), 0, itemCount() - 1);
 
-    folder_items_.clear();
-    file_items_.clear();
+    items_.clear();
+    folder_rows_.clear();
+    file_rows_.clear();
+    has_new_folder_ = false;
+    ++epoch_;
 
     endRemoveRows();
 }
 
 bool FileListModel::isFolder(const QModelIndex& index) const
 {
-    return index.row() < folder_items_.count();
+    return index.row() < static_cast<int>(folder_rows_.size()) + (has_new_folder_ ? 1 : 0);
 }
 
 QString FileListModel::nameAt(const QModelIndex& index) const
 {
-    if (isFolder(index))
-        return folder_items_.at(index.row()).name;
-
-    return file_items_.at(index.row() - folder_items_.count()).name;
+    return itemAt(index.row())->name;
 }
 
 int64_t FileListModel::sizeAt(const QModelIndex& index) const
 {
-    if (isFolder(index))
-        return 0;
-
-    return file_items_.at(index.row() - folder_items_.count()).size;
+    return itemAt(index.row())->size;
 }
 
 QModelIndex FileListModel::createFolder()
 {
-    int row = folder_items_.count();
+    if (has_new_folder_)
+        return QModelIndex();
 
-    if (row > 0)
-    {
-        QString last_folder = folder_items_.last().name;
-        if (last_folder.isEmpty())
-            return QModelIndex();
-    }
+    const int row = static_cast<int>(folder_rows_.size());
 
     beginInsertRows(QModelIndex(), row, row);
-    folder_items_.append(Folder());
+    has_new_folder_ = true;
     endInsertRows();
 
     return createIndex(row, COLUMN_NAME);
@@ -220,7 +242,7 @@ QModelIndex FileListModel::parent(const QModelIndex& /* child */) const
 
 int FileListModel::rowCount(const QModelIndex& /* parent */) const
 {
-    return folder_items_.count() + file_items_.count();
+    return itemCount();
 }
 
 int FileListModel::columnCount(const QModelIndex& /* parent */) const
@@ -233,13 +255,13 @@ QVariant FileListModel::data(const QModelIndex& index, int role) const
     int column = index.column();
     int row = index.row();
 
-    if (!index.isValid() || (folder_items_.count() + file_items_.count()) <= row)
+    if (!index.isValid() || itemCount() <= row)
         return QVariant();
 
-    if (isFolder(index))
-    {
-        const Folder& folder = folder_items_.at(row);
+    const Item& item = *itemAt(row);
 
+    if (item.is_folder)
+    {
         switch (role)
         {
             case Qt::DecorationRole:
@@ -255,10 +277,10 @@ QVariant FileListModel::data(const QModelIndex& index, int role) const
                 switch (column)
                 {
                     case COLUMN_NAME:
-                        return folder.name;
+                        return item.name;
 
                     case COLUMN_LAST_WRITE:
-                        return timeToString(folder.last_write);
+                        return timeToString(item.last_write);
 
                     case COLUMN_TYPE:
                         return dir_type_;
@@ -275,14 +297,12 @@ QVariant FileListModel::data(const QModelIndex& index, int role) const
     }
     else
     {
-        const File& file = file_items_.at(row - folder_items_.count());
-
         switch (role)
         {
             case Qt::DecorationRole:
             {
                 if (column == COLUMN_NAME)
-                    return file.icon;
+                    return typeInfo(item).icon;
             }
             break;
 
@@ -292,16 +312,16 @@ QVariant FileListModel::data(const QModelIndex& index, int role) const
                 switch (column)
                 {
                     case COLUMN_NAME:
-                        return file.name;
+                        return item.name;
 
                     case COLUMN_SIZE:
-                        return sizeToString(file.size);
+                        return sizeToString(item.size);
 
                     case COLUMN_TYPE:
-                        return file.type;
+                        return typeInfo(item).type;
 
                     case COLUMN_LAST_WRITE:
-                        return timeToString(file.last_write);
+                        return timeToString(item.last_write);
 
                     default:
                         break;
@@ -319,7 +339,7 @@ QVariant FileListModel::data(const QModelIndex& index, int role) const
 
 bool FileListModel::setData(const QModelIndex& index, const QVariant& value, int role)
 {
-    if (!index.isValid() || (folder_items_.count() + file_items_.count()) <= index.row())
+    if (!index.isValid() || itemCount() <= index.row())
         return false;
 
     if (role != Qt::EditRole)
@@ -328,20 +348,19 @@ bool FileListModel::setData(const QModelIndex& index, const QVariant& value, int
     if (index.column() != COLUMN_NAME)
         return false;
 
-    QString old_name = nameAt(index);
     QString new_name = value.toString();
 
-    if (old_name.isEmpty())
+    if (itemAt(index.row()) == &new_folder_)
     {
         beginRemoveRows(QModelIndex(), index.row(), index.row());
-        folder_items_.removeLast();
+        has_new_folder_ = false;
         endRemoveRows();
 
         emit createFolderRequest(new_name);
     }
     else
     {
-        emit nameChangeRequest(old_name, new_name);
+        emit nameChangeRequest(nameAt(index), new_name);
     }
 
     return true;
@@ -477,38 +496,279 @@ Qt::ItemFlags FileListModel::flags(const QModelIndex& index) const
 
 void FileListModel::sort(int column, Qt::SortOrder order)
 {
-    sortItems(column, order);
-    emit dataChanged(QModelIndex(), QModelIndex());
+    setSortOrder(column, order);
+    sortItems();
 }
 
-void FileListModel::sortItems(int column, Qt::SortOrder order)
+void FileListModel::sortItems()
 {
-    current_order_ = order;
-    current_column_ = column;
+    if (items_.size() >= kBackgroundSortThreshold)
+    {
+        startBackgroundSort();
+        return;
+    }
+
+    std::vector<SortKey> keys = sortKeys();
+    Rows folder_rows;
+    Rows file_rows;
+
+    sortRows(&keys, current_column_, current_order_, &folder_rows, &file_rows);
+    applyRows(std::move(folder_rows), std::move(file_rows));
+}
 
-    switch (column)
+const FileListModel::Item* FileListModel::itemAt(int row) const
+{
+    const int folder_count = static_cast<int>(folder_rows_.size());
+
+    if (row < folder_count)
+        return &items_[folder_rows_[row]];
+
+    if (has_new_folder_)
     {
-        case COLUMN_NAME:
-            sortByName(folder_items_, order);
-            sortByName(file_items_, order);
-            break;
+        if (row == folder_count)
+            return &new_folder_;
 
-        case COLUMN_SIZE:
-            sortBySize(file_items_, order);
-            break;
+        --row;
+    }
 
-        case COLUMN_TYPE:
-            sortByType(file_items_, order);
-            break;
+    return &items_[file_rows_[row - folder_count]];
+}
 
-        case COLUMN_LAST_WRITE:
-            sortByTime(folder_items_, order);
-            sortByTime(file_items_, order);
-            break;
+const FileListModel::TypeInfo& FileListModel::typeInfo(const Item& item) const
+{
+    if (item.type_info == -1)
+    {
+        const QString key = typeInfoKey(item.name);
 
-        default:
+        auto it = type_info_cache_.constFind(key);
+        if (it == type_info_cache_.constEnd())
+        {
+            QPair<QIcon, QString> file_info = common::FilePlatformUtil::fileTypeInfo(item.name);
+            type_info_.push_back({ file_info.first, file_info.second });
+
+            it = type_info_cache_.insert(key, static_cast<int>(type_info_.size() - 1));
+        }
+
+        item.type_info = it.value();
+    }
+
+    return type_info_[static_cast<size_t>(item.type_info)];
+}
+
+int FileListModel::itemCount() const
+{
+    return static_cast<int>(folder_rows_.size() + file_rows_.size()) + (has_new_folder_ ? 1 : 0);
+}
+
+std::vector<FileListModel::SortKey> FileListModel::sortKeys() const
+{
+    std::vector<SortKey> keys;
+    keys.reserve(items_.size());
+
+    for (size_t i = 0; i < items_.size(); ++i)
+    {
+        const Item& item = items_[i];
+
+        SortKey key;
+        key.index = static_cast<int>(i);
+        key.is_folder = item.is_folder;
+        key.number = 0;
+
+        switch (current_column_)
+        {
+            case COLUMN_NAME:
+                key.name = item.sort_name;
+                break;
+
+            case COLUMN_SIZE:
+                key.number = item.size;
+                break;
+
+            case COLUMN_TYPE:
+            {
+                // Only files are sorted by type, folders keep the order in which they are received.
+                if (!item.is_folder)
+                    key.type = typeInfo(item).type;
+            }
             break;
+
+            case COLUMN_LAST_WRITE:
+                key.number = item.last_write;
+                break;
+
+            default:
+                break;
+        }
+
+        keys.emplace_back(std::move(key));
     }
+
+    return keys;
+}
+
+// static
+void FileListModel::sortRows(std::vector<SortKey>* keys, int column, Qt::SortOrder order,
+                             Rows* folder_rows, Rows* file_rows)
+{
+    auto compare = [column](const SortKey& key1, const SortKey& key2)
+    {
+        switch (column)
+        {
+            case COLUMN_NAME:
+                return key1.name.compare(key2.name);
+
+            case COLUMN_TYPE:
+                return key1.type.compare(key2.type);
+
+            case COLUMN_SIZE:
+            case COLUMN_LAST_WRITE:
+                return (key1.number > key2.number) - (key1.number < key2.number);
+
+            default:
+                return 0;
+        }
+    };
+
+    // The items which are equal keep the order in which they are received, so the order of the
+    // rows does not change when the next page is sorted together with the items already shown.
+    std::sort(keys->begin(), keys->end(),
+              [order, &compare](const SortKey& key1, const SortKey& key2)
+    {
+        if (key1.is_folder != key2.is_folder)
+            return key1.is_folder;
+
+        const int result = compare(key1, key2);
+        if (result != 0)
+            return order == Qt::AscendingOrder ? result < 0 : result > 0;
+
+        return key1.index < key2.index;
+    });
+
+    folder_rows->clear();
+    file_rows->clear();
+
+    for (const SortKey& key : *keys)
+        (key.is_folder ? folder_rows : file_rows)->push_back(key.index);
+}
+
+void FileListModel::startBackgroundSort()
+{
+    if (sort_running_)
+    {
+        // The list is sorted again when the current sort is completed.
+        sort_pending_ = true;
+        return;
+    }
+
+    if (!sort_thread_)
+    {
+        sort_thread_ = new QThread(this);
+        sort_context_ = new QObject();
+        sort_context_->moveToThread(sort_thread_);
+
+        connect(sort_thread_, &QThread::finished, sort_context_, &QObject::deleteLater);
+        sort_thread_->start(QThread::LowPriority);
+    }
+
+    sort_running_ = true;
+    sort_pending_ = false;
+
+    const quint64 epoch = epoch_;
+    const size_t item_count = items_.size();
+    const int column = current_column_;
+    const Qt::SortOrder order = current_order_;
+
+    QMetaObject::invokeMethod(sort_context_,
+        [this, keys = sortKeys(), epoch, item_count, column, order]() mutable
+    {
+        Rows folder_rows;
+        Rows file_rows;
+
+        sortRows(&keys, column, order, &folder_rows, &file_rows);
+
+        QMetaObject::invokeMethod(this,
+            [this, epoch, item_count, column, order, folder_rows = std::move(folder_rows),
+             file_rows = std::move(file_rows)]() mutable
+        {
+            onBackgroundSortFinished(epoch, item_count, column, order, std::move(folder_rows),
+                                     std::move(file_rows));
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void FileListModel::onBackgroundSortFinished(quint64 epoch, size_t item_count, int column,
+                                             Qt::SortOrder order, Rows folder_rows,
+                                             Rows file_rows)
+{
+    sort_running_ = false;
+
+    if (epoch == epoch_ && column == current_column_ && order == current_order_)
+    {
+        // Items received while the list was being sorted stay at the end until the next sort.
+        for (int index : folder_rows_)
+        {
+            if (static_cast<size_t>(index) >= item_count)
+                folder_rows.push_back(index);
+        }
+
+        for (int index : file_rows_)
+        {
+            if (static_cast<size_t>(index) >= item_count)
+                file_rows.push_back(index);
+        }
+
+        applyRows(std::move(folder_rows), std::move(file_rows));
+    }
+    else
+    {
+        // The list or the sort order has changed while the list was being sorted.
+        sort_pending_ = true;
+    }
+
+    if (sort_pending_)
+        startBackgroundSort();
+}
+
+void FileListModel::applyRows(Rows&& folder_rows, Rows&& file_rows)
+{
+    DCHECK_EQ(folder_rows.size(), folder_rows_.size());
+    DCHECK_EQ(file_rows.size(), file_rows_.size());
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    const QModelIndexList old_indexes = persistentIndexList();
+    if (!old_indexes.isEmpty())
+    {
+        // Rows of the items after the sort.
+        std::vector<int> new_rows(items_.size());
+
+        for (size_t i = 0; i < folder_rows.size(); ++i)
+            new_rows[static_cast<size_t>(folder_rows[i])] = static_cast<int>(i);
+
+        const size_t first_file_row = folder_rows.size() + (has_new_folder_ ? 1 : 0);
+
+        for (size_t i = 0; i < file_rows.size(); ++i)
+            new_rows[static_cast<size_t>(file_rows[i])] = static_cast<int>(first_file_row + i);
+
+        QModelIndexList new_indexes;
+        new_indexes.reserve(old_indexes.size());
+
+        for (const QModelIndex& index : old_indexes)
+        {
+            const Item* item = itemAt(index.row());
+            const int row = (item == &new_folder_) ?
+                index.row() : new_rows[static_cast<size_t>(item - items_.data())];
+
+            new_indexes.append(createIndex(row, index.column()));
+        }
+
+        changePersistentIndexList(old_indexes, new_indexes);
+    }
+
+    folder_rows_ = std::move(folder_rows);
+    file_rows_ = std::move(file_rows);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
 }
 
 // static
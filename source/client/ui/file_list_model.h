@@ -22,8 +22,11 @@
 #include "client/file_transfer.h"
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QIcon>
 
+class QThread;
+
 namespace client {
 
 class FileListModel : public QAbstractItemModel
@@ -32,10 +35,15 @@ class FileListModel : public QAbstractItemModel
 
 public:
     explicit FileListModel(QObject* parent = nullptr);
+    ~FileListModel() override;
 
     void setMimeType(const QString& mime_type);
     QString mimeType() const { return mime_type_; }
     void setFileList(const proto::FileList& file_list);
+
+    // Adds the next page of the list to the items already shown. The new items are shown at the
+    // end of the list right away and take their sorted places when the background sort finishes.
+    void addFileList(const proto::FileList& file_list);
     void setSortOrder(int column, Qt::SortOrder order);
     void clear();
     bool isFolder(const QModelIndex& index) const;
@@ -68,28 +76,58 @@ signals:
     void fileListDropped(const QString& folder_name, const std::vector<FileTransfer::Item>& files);
 
 protected:
-    void sortItems(int column, Qt::SortOrder order);
+    void addItems(const proto::FileList& file_list);
+    void sortItems();
     static QString sizeToString(int64_t size);
     static QString timeToString(time_t time);
 
 private:
-    struct File
+    struct Item
     {
+        QString name;
+        QString sort_name; // Lower case name, the names are compared many times while sorting.
         int64_t size = 0;
         time_t last_write = 0;
-        QIcon icon;
-        QString name;
-        QString type;
+        bool is_folder = false;
+        mutable int type_info = -1; // Index in |type_info_| or -1 if it is not resolved yet.
     };
 
-    struct Folder
+    struct TypeInfo
     {
-        QString name;
-        time_t last_write = 0;
+        QIcon icon;
+        QString type;
     };
 
-    QList<Folder> folder_items_;
-    QList<File> file_items_;
+    struct SortKey;
+    using Rows = std::vector<int>;
+
+    // Returns the item shown in |row| or nullptr for the folder being created.
+    const Item* itemAt(int row) const;
+    const TypeInfo& typeInfo(const Item& item) const;
+    int itemCount() const;
+
+    std::vector<SortKey> sortKeys() const;
+    static void sortRows(std::vector<SortKey>* keys, int column, Qt::SortOrder order,
+                         Rows* folder_rows, Rows* file_rows);
+    void startBackgroundSort();
+    void onBackgroundSortFinished(quint64 epoch, size_t item_count, int column,
+                                  Qt::SortOrder order, Rows folder_rows, Rows file_rows);
+    void applyRows(Rows&& folder_rows, Rows&& file_rows);
+
+    // Items in the order in which they are received. The items are only appended, the rows below
+    // refer to them by index.
+    std::vector<Item> items_;
+    Rows folder_rows_;
+    Rows file_rows_;
+
+    // The folder being created is shown after all folders until it gets a name.
+    Item new_folder_;
+    bool has_new_folder_ = false;
+
+    // Icons and type names are resolved when an item is shown or sorted by type and are shared
+    // by all files with the same extension.
+    mutable std::vector<TypeInfo> type_info_;
+    mutable QHash<QString, int> type_info_cache_;
 
     const QIcon dir_icon_;
     const QString dir_type_;
@@ -97,6 +135,14 @@ private:
     Qt::SortOrder current_order_ = Qt::AscendingOrder;
     int current_column_ = 0;
 
+    // Large lists are sorted on |sort_thread_|. The epoch changes when the list is replaced, so a
+    // result for the previous list is dropped.
+    QThread* sort_thread_ = nullptr;
+    QObject* sort_context_ = nullptr;
+    quint64 epoch_ = 0;
+    bool sort_running_ = false;
+    bool sort_pending_ = false;
+
     QString mime_type_;
 
     DISALLOW_COPY_AND_ASSIGN(FileListModel);
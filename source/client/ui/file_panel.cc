@@ -71,6 +71,7 @@ FilePanel::FilePanel(QWidget* parent)
     connect(ui.action_add_folder, &QAction::triggered, this, &FilePanel::addFolder);
     connect(ui.action_delete, &QAction::triggered, this, &FilePanel::removeSelected);
     connect(ui.action_send, &QAction::triggered, this, &FilePanel::sendSelected);
+    connect(ui.action_sync, &QAction::triggered, [this]() { emit syncFolder(this); });
 
     connect(ui.list, &FileList::fileListDropped,
             [this](const QString& folder_name, const std::vector<FileTransfer::Item>& items)
@@ -112,6 +113,9 @@ void FilePanel::onFileList(proto::FileError error_code, const proto::FileList& f
         ui.action_up->setEnabled(true);
         ui.action_add_folder->setEnabled(true);
 
+        folder_opened_ = true;
+        updateSyncEnabled();
+
         ui.list->showFileList(file_list);
 
         QItemSelectionModel* selection_model = ui.list->selectionModel();
@@ -124,6 +128,11 @@ void FilePanel::onFileList(proto::FileError error_code, const proto::FileList& f
     setEnabled(true);
 }
 
+void FilePanel::onFileListContinued(const proto::FileList& file_list)
+{
+    ui.list->addFileList(file_list);
+}
+
 void FilePanel::onCreateDirectory(proto::FileError error_code)
 {
     if (error_code != proto::FILE_ERROR_SUCCESS)
@@ -154,6 +163,9 @@ void FilePanel::onPathChanged(const QString& path)
     ui.action_add_folder->setEnabled(false);
     ui.action_delete->setEnabled(false);
 
+    folder_opened_ = false;
+    updateSyncEnabled();
+
     setTransferEnabled(false);
 
     AddressBarModel* model = static_cast<AddressBarModel*>(ui.address_bar->model());
@@ -183,6 +195,7 @@ void FilePanel::setTransferAllowed(bool allowed)
 {
     transfer_allowed_ = allowed;
     ui.action_send->setEnabled(transfer_allowed_ && transfer_enabled_);
+    updateSyncEnabled();
 }
 
 void FilePanel::setTransferEnabled(bool enabled)
@@ -191,6 +204,11 @@ void FilePanel::setTransferEnabled(bool enabled)
     ui.action_send->setEnabled(transfer_allowed_ && transfer_enabled_);
 }
 
+void FilePanel::setSyncAvailable(bool available)
+{
+    ui.action_sync->setVisible(available);
+}
+
 QByteArray FilePanel::saveState() const
 {
     return ui.list->saveState();
@@ -429,4 +447,10 @@ void FilePanel::showError(const QString& message)
     QMessageBox::warning(this, tr("Warning"), message, QMessageBox::Ok);
 }
 
+void FilePanel::updateSyncEnabled()
+{
+    // The whole folder is synced, so the selection does not matter.
+    ui.action_sync->setEnabled(transfer_allowed_ && folder_opened_);
+}
+
 } // namespace client
@@ -36,6 +36,7 @@ public:
 
     void onDriveList(proto::FileError error_code, const proto::DriveList& drive_list);
     void onFileList(proto::FileError error_code, const proto::FileList& file_list);
+    void onFileListContinued(const proto::FileList& file_list);
     void onCreateDirectory(proto::FileError error_code);
     void onRename(proto::FileError error_code);
 
@@ -44,6 +45,9 @@ public:
     void setTransferAllowed(bool allowed);
     void setTransferEnabled(bool enabled);
 
+    // Shows the action which starts the folder sync (see FolderSync).
+    void setSyncAvailable(bool available);
+
     QString currentPath() const { return ui.address_bar->currentPath(); }
 
     QByteArray saveState() const;
@@ -60,6 +64,7 @@ signals:
                       const QString& folder,
                       const std::vector<FileTransfer::Item>& items);
     void pathChanged(FilePanel* sender, const QString& path);
+    void syncFolder(FilePanel* sender);
 
 public slots:
     void refresh();
@@ -84,12 +89,16 @@ private slots:
 
 private:
     void showError(const QString& message);
+    void updateSyncEnabled();
 
     Ui::FilePanel ui;
 
     bool transfer_allowed_ = false;
     bool transfer_enabled_ = false;
 
+    // The current path is a folder which has been listed.
+    bool folder_opened_ = false;
+
     DISALLOW_COPY_AND_ASSIGN(FilePanel);
 };
 
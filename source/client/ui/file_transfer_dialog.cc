@@ -74,11 +74,41 @@ FileTransferDialog::~FileTransferDialog()
 #endif
 }
 
+void FileTransferDialog::setSyncMode(const QString& local_path, const QString& remote_path)
+{
+    sync_mode_ = true;
+
+    setWindowTitle(tr("Folder Sync"));
+
+    ui.label_source->setText(tr("From: %1").arg(local_path));
+    ui.label_target->setText(tr("To: %1").arg(remote_path));
+
+    // The first transfer starts after the folder is scanned.
+    ui.label_task->setText(tr("Current Task: Scanning the folder..."));
+
+    // Until a transfer is started, the dialog is closed at once.
+    finished_ = true;
+}
+
 void FileTransferDialog::start(std::shared_ptr<FileTransferProxy> transfer_proxy)
 {
     transfer_proxy_ = std::move(transfer_proxy);
     DCHECK(transfer_proxy_);
 
+    if (sync_mode_)
+    {
+        // The transfers start on changes in the folder, the dialog does not take the focus.
+        finished_ = false;
+        task_queue_building_ = true;
+
+        ui.label_task->setText(tr("Current Task: Creating a list of files to copy..."));
+        ui.progress_total->setRange(0, 0);
+        ui.progress_current->setRange(0, 0);
+
+        show();
+        return;
+    }
+
     show();
     activateWindow();
 }
@@ -86,6 +116,23 @@ void FileTransferDialog::start(std::shared_ptr<FileTransferProxy> transfer_proxy
 void FileTransferDialog::stop()
 {
     finished_ = true;
+
+    if (sync_mode_ && !closing_)
+    {
+        if (transfer_proxy_)
+        {
+            transfer_proxy_.reset();
+            showSyncWaiting();
+            return;
+        }
+
+        // The sync is stopped before any transfer when the folder cannot be watched.
+        QMessageBox::warning(this,
+                             tr("Warning"),
+                             tr("Failed to start the folder sync."),
+                             QMessageBox::Ok);
+    }
+
     close();
 }
 
@@ -246,6 +293,15 @@ void FileTransferDialog::closeEvent(QCloseEvent* event)
     }
 }
 
+void FileTransferDialog::showSyncWaiting()
+{
+    ui.label_task->setText(tr("Current Task: Waiting for changes in the folder."));
+
+    ui.progress_total->setRange(0, 100);
+    ui.progress_current->setRange(0, 100);
+    setCurrentProgress(100, 100);
+}
+
 QString FileTransferDialog::errorToMessage(const FileTransfer::Error& error)
 {
     switch (error.type())
@@ -42,6 +42,10 @@ public:
 
     std::shared_ptr<FileTransferWindowProxy> windowProxy() { return transfer_window_proxy_; }
 
+    // The dialog shows the transfers of the folder sync. It stays open between the transfers and
+    // the sync is stopped when the dialog is closed.
+    void setSyncMode(const QString& local_path, const QString& remote_path);
+
     // FileTransferWindow implementation.
     void start(std::shared_ptr<FileTransferProxy> transfer_proxy) override;
     void stop() override;
@@ -56,6 +60,7 @@ protected:
 
 private:
     QString errorToMessage(const FileTransfer::Error& error);
+    void showSyncWaiting();
 
     Ui::FileTransferDialog ui;
 
@@ -70,6 +75,7 @@ private:
     bool task_queue_building_ = true;
     bool closing_ = false;
     bool finished_ = false;
+    bool sync_mode_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(FileTransferDialog);
 };
@@ -0,0 +1,238 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/ui/preview_tile.h"
+
+#include "base/logging.h"
+#include "base/peer/host_id.h"
+#include "client/client_desktop.h"
+#include "client/client_proxy.h"
+#include "client/config_factory.h"
+#include "client/desktop_window_proxy.h"
+#include "client/status_window_proxy.h"
+#include "client/ui/frame_factory_qimage.h"
+#include "client/ui/frame_qimage.h"
+#include "qt_base/application.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+
+namespace client {
+
+namespace {
+
+const int kTitleHeight = 20;
+
+} // namespace
+
+PreviewTile::PreviewTile(const Config& config, QWidget* parent)
+    : QWidget(parent),
+      config_(config),
+      status_window_proxy_(
+          std::make_shared<StatusWindowProxy>(qt_base::Application::uiTaskRunner(), this)),
+      desktop_window_proxy_(
+          std::make_shared<DesktopWindowProxy>(qt_base::Application::uiTaskRunner(), this))
+{
+    title_ = QString::fromStdU16String(config_.computer_name);
+    if (title_.isEmpty())
+        title_ = QString::fromStdU16String(config_.address_or_id);
+
+    setToolTip(title_);
+    setMinimumSize(160, 100 + kTitleHeight);
+}
+
+PreviewTile::~PreviewTile()
+{
+    stop();
+
+    desktop_window_proxy_->dettach();
+    status_window_proxy_->dettach();
+}
+
+void PreviewTile::start()
+{
+    if (client_proxy_)
+        return;
+
+    if (config_.username.empty() || config_.password.empty())
+    {
+        setStatus(tr("User name and password are not specified"));
+        return;
+    }
+
+    if (base::isHostId(config_.address_or_id) && !config_.router_config.has_value())
+    {
+        setStatus(tr("The router is not configured"));
+        return;
+    }
+
+    std::unique_ptr<ClientDesktop> client =
+        std::make_unique<ClientDesktop>(qt_base::Application::ioTaskRunner());
+
+    client->setDesktopConfig(ConfigFactory::defaultDesktopPreviewConfig());
+    client->setDesktopWindow(desktop_window_proxy_);
+    client->setStatusWindow(status_window_proxy_);
+
+    client_proxy_ = std::make_unique<ClientProxy>(
+        qt_base::Application::ioTaskRunner(), std::move(client), config_);
+    client_proxy_->start();
+}
+
+void PreviewTile::stop()
+{
+    if (!client_proxy_)
+        return;
+
+    client_proxy_->stop();
+    client_proxy_.reset();
+}
+
+void PreviewTile::showWindow(std::shared_ptr<DesktopControlProxy> /* desktop_control_proxy */,
+                             const base::Version& /* peer_version */)
+{
+    // The preview does not control the desktop.
+}
+
+void PreviewTile::configRequired()
+{
+    setStatus(tr("There are no supported video encodings"));
+}
+
+void PreviewTile::setCapabilities(const std::string& /* extensions */,
+                                  uint32_t /* video_encodings */)
+{
+    // Nothing
+}
+
+void PreviewTile::setScreenList(const proto::ScreenList& /* screen_list */)
+{
+    // Nothing
+}
+
+void PreviewTile::setSystemInfo(const proto::SystemInfo& /* system_info */)
+{
+    // Nothing
+}
+
+void PreviewTile::setMetrics(const DesktopWindow::Metrics& /* metrics */)
+{
+    // Nothing
+}
+
+std::unique_ptr<FrameFactory> PreviewTile::frameFactory()
+{
+    return std::make_unique<FrameFactoryQImage>();
+}
+
+void PreviewTile::setFrame(const base::Size& /* screen_size */, std::shared_ptr<base::Frame> frame)
+{
+    frame_ = std::move(frame);
+    update();
+}
+
+void PreviewTile::drawFrame(const base::Region& /* updated_region */)
+{
+    // The whole thumbnail is small, it is painted again entirely.
+    update();
+}
+
+void PreviewTile::setMouseCursor(std::shared_ptr<base::MouseCursor> /* mouse_cursor */)
+{
+    // Nothing
+}
+
+void PreviewTile::setMouseCursorPosition(const base::Point& /* position */)
+{
+    // Nothing
+}
+
+void PreviewTile::paintEvent(QPaintEvent* /* event */)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(25, 25, 25));
+
+    const QRect video_rect(0, 0, width(), height() - kTitleHeight);
+
+    if (frame_)
+    {
+        const QImage& image = static_cast<FrameQImage*>(frame_.get())->constImage();
+
+        QRect image_rect(QPoint(0, 0), image.size().scaled(video_rect.size(), Qt::KeepAspectRatio));
+        image_rect.moveCenter(video_rect.center());
+
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawImage(image_rect, image);
+    }
+
+    if (!status_.isEmpty())
+    {
+        painter.setPen(Qt::lightGray);
+        painter.drawText(video_rect, Qt::AlignCenter | Qt::TextWordWrap, status_);
+    }
+
+    const QRect title_rect(0, height() - kTitleHeight, width(), kTitleHeight);
+
+    painter.setPen(Qt::white);
+    painter.drawText(title_rect, Qt::AlignCenter,
+                     painter.fontMetrics().elidedText(title_, Qt::ElideRight, width()));
+}
+
+void PreviewTile::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    if (event->button() == Qt::LeftButton)
+        emit doubleClicked();
+}
+
+void PreviewTile::onStarted(const std::u16string& /* address_or_id */)
+{
+    setStatus(tr("Connecting..."));
+}
+
+void PreviewTile::onStopped()
+{
+    // Nothing
+}
+
+void PreviewTile::onConnected()
+{
+    setStatus(QString());
+}
+
+void PreviewTile::onDisconnected(base::NetworkChannel::ErrorCode /* error_code */)
+{
+    frame_.reset();
+    setStatus(tr("Disconnected"));
+}
+
+void PreviewTile::onAccessDenied(base::ClientAuthenticator::ErrorCode /* error_code */)
+{
+    setStatus(tr("Access denied"));
+}
+
+void PreviewTile::onRouterError(const RouterController::Error& /* error */)
+{
+    setStatus(tr("Router error"));
+}
+
+void PreviewTile::setStatus(const QString& status)
+{
+    status_ = status;
+    update();
+}
+
+} // namespace client
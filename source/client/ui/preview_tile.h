@@ -0,0 +1,103 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__UI__PREVIEW_TILE_H
+#define CLIENT__UI__PREVIEW_TILE_H
+
+#include "base/macros_magic.h"
+#include "client/client_config.h"
+#include "client/desktop_window.h"
+#include "client/status_window.h"
+
+#include <QWidget>
+
+namespace client {
+
+class ClientProxy;
+class DesktopWindowProxy;
+class StatusWindowProxy;
+
+// Thumbnail of the desktop of one host in the preview window (see PreviewWindow). The host sends a
+// small video with a low frame rate (see proto::PREVIEW_MODE). The tile shows it with the name of
+// the computer and the state of the connection.
+class PreviewTile
+    : public QWidget,
+      public StatusWindow,
+      public DesktopWindow
+{
+    Q_OBJECT
+
+public:
+    explicit PreviewTile(const Config& config, QWidget* parent = nullptr);
+    ~PreviewTile();
+
+    // Connects to the host. The credentials must be in the configuration, the tile does not ask
+    // for them.
+    void start();
+    void stop();
+
+    const Config& config() const { return config_; }
+
+    // DesktopWindow implementation.
+    void showWindow(std::shared_ptr<DesktopControlProxy> desktop_control_proxy,
+                    const base::Version& peer_version) override;
+    void configRequired() override;
+    void setCapabilities(const std::string& extensions, uint32_t video_encodings) override;
+    void setScreenList(const proto::ScreenList& screen_list) override;
+    void setSystemInfo(const proto::SystemInfo& system_info) override;
+    void setMetrics(const DesktopWindow::Metrics& metrics) override;
+    std::unique_ptr<FrameFactory> frameFactory() override;
+    void setFrame(const base::Size& screen_size, std::shared_ptr<base::Frame> frame) override;
+    void drawFrame(const base::Region& updated_region) override;
+    void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor) override;
+    void setMouseCursorPosition(const base::Point& position) override;
+
+signals:
+    void doubleClicked();
+
+protected:
+    // QWidget implementation.
+    void paintEvent(QPaintEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+
+    // StatusWindow implementation.
+    void onStarted(const std::u16string& address_or_id) override;
+    void onStopped() override;
+    void onConnected() override;
+    void onDisconnected(base::NetworkChannel::ErrorCode error_code) override;
+    void onAccessDenied(base::ClientAuthenticator::ErrorCode error_code) override;
+    void onRouterError(const RouterController::Error& error) override;
+
+private:
+    void setStatus(const QString& status);
+
+    const Config config_;
+    QString title_;
+    QString status_;
+
+    std::shared_ptr<StatusWindowProxy> status_window_proxy_;
+    std::shared_ptr<DesktopWindowProxy> desktop_window_proxy_;
+    std::unique_ptr<ClientProxy> client_proxy_;
+    std::shared_ptr<base::Frame> frame_;
+
+    DISALLOW_COPY_AND_ASSIGN(PreviewTile);
+};
+
+} // namespace client
+
+#endif // CLIENT__UI__PREVIEW_TILE_H
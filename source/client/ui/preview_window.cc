@@ -0,0 +1,94 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/ui/preview_window.h"
+
+#include "client/config_factory.h"
+#include "client/ui/preview_tile.h"
+#include "client/ui/qt_desktop_window.h"
+
+#include <QGridLayout>
+
+#include <cmath>
+
+namespace client {
+
+PreviewWindow::PreviewWindow(QWidget* parent)
+    : QWidget(parent)
+{
+    setWindowTitle(tr("Preview"));
+    setMinimumSize(400, 300);
+
+    QPalette window_palette(palette());
+    window_palette.setBrush(QPalette::Window, QBrush(QColor(45, 45, 45)));
+    setPalette(window_palette);
+
+    layout_ = new QGridLayout(this);
+    layout_->setContentsMargins(4, 4, 4, 4);
+    layout_->setSpacing(4);
+}
+
+PreviewWindow::~PreviewWindow() = default;
+
+void PreviewWindow::addHost(const Config& config)
+{
+    PreviewTile* tile = new PreviewTile(config, this);
+
+    connect(tile, &PreviewTile::doubleClicked, [this, tile]()
+    {
+        openSession(tile->config());
+    });
+
+    tiles_.append(tile);
+    updateLayout();
+
+    tile->start();
+}
+
+void PreviewWindow::closeEvent(QCloseEvent* /* event */)
+{
+    for (PreviewTile* tile : tiles_)
+        tile->stop();
+}
+
+void PreviewWindow::openSession(const Config& config)
+{
+    Config session_config = config;
+    session_config.session_type = proto::SESSION_TYPE_DESKTOP_VIEW;
+
+    QtDesktopWindow* session_window = new QtDesktopWindow(
+        session_config.session_type, ConfigFactory::defaultDesktopViewConfig());
+
+    session_window->setAttribute(Qt::WA_DeleteOnClose);
+    if (!session_window->connectToHost(session_config))
+        session_window->close();
+}
+
+void PreviewWindow::updateLayout()
+{
+    // The thumbnails are placed in a square grid.
+    const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(tiles_.size()))));
+
+    for (int i = 0; i < tiles_.size(); ++i)
+    {
+        layout_->removeWidget(tiles_[i]);
+        layout_->addWidget(tiles_[i], i / columns, i % columns);
+    }
+}
+
+} // namespace client
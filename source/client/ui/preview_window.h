@@ -0,0 +1,63 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__UI__PREVIEW_WINDOW_H
+#define CLIENT__UI__PREVIEW_WINDOW_H
+
+#include "base/macros_magic.h"
+#include "client/client_config.h"
+
+#include <QWidget>
+
+class QGridLayout;
+
+namespace client {
+
+class PreviewTile;
+
+// Shows the desktops of many hosts at once as a grid of thumbnails (for example, to watch a whole
+// group of computers). Each host sends a preview of tens of kilobits per second instead of a full
+// video. A double click on a thumbnail opens a desktop view session to the host.
+class PreviewWindow : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PreviewWindow(QWidget* parent = nullptr);
+    ~PreviewWindow();
+
+    // Adds a thumbnail of the host. The credentials must be in |config|.
+    void addHost(const Config& config);
+
+protected:
+    // QWidget implementation.
+    void closeEvent(QCloseEvent* event) override;
+
+private:
+    void openSession(const Config& config);
+    void updateLayout();
+
+    QGridLayout* layout_;
+    QList<PreviewTile*> tiles_;
+
+    DISALLOW_COPY_AND_ASSIGN(PreviewWindow);
+};
+
+} // namespace client
+
+#endif // CLIENT__UI__PREVIEW_WINDOW_H
@@ -40,15 +40,19 @@
 #include <QDesktopWidget>
 #include <QFileDialog>
 #include <QHBoxLayout>
+#include <QHideEvent>
 #include <QMessageBox>
 #include <QPalette>
 #include <QResizeEvent>
 #include <QScreen>
 #include <QScrollArea>
 #include <QScrollBar>
+#include <QShowEvent>
 #include <QTimer>
 #include <QWindow>
 
+#include <cmath>
+
 namespace client {
 
 namespace {
@@ -101,6 +105,17 @@ QtDesktopWindow::QtDesktopWindow(proto::SessionType session_type,
     scroll_timer_ = new QTimer(this);
     connect(scroll_timer_, &QTimer::timeout, this, &QtDesktopWindow::onScrollTimer);
 
+    viewport_timer_ = new QTimer(this);
+    viewport_timer_->setSingleShot(true);
+    viewport_timer_->setInterval(std::chrono::milliseconds(100));
+    connect(viewport_timer_, &QTimer::timeout, this, &QtDesktopWindow::onViewportTimer);
+
+    auto start_viewport_timer = [this]() { viewport_timer_->start(); };
+    connect(scroll_area_->horizontalScrollBar(), &QScrollBar::valueChanged,
+            this, start_viewport_timer);
+    connect(scroll_area_->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, start_viewport_timer);
+
     desktop_->enableKeyCombinations(panel_->sendKeyCombinations());
 
     connect(panel_, &DesktopPanel::keyCombination, desktop_, &DesktopWidget::executeKeyCombination);
@@ -128,7 +143,7 @@ QtDesktopWindow::QtDesktopWindow(proto::SessionType session_type,
 
     connect(panel_, &DesktopPanel::startSystemInfo, [this]()
     {
-        desktop_control_proxy_->onSystemInfoRequest();
+        desktop_control_proxy_->onSystemInfoRequest(false);
     });
 
     connect(panel_, &DesktopPanel::startStatistics, [this]()
@@ -264,6 +279,12 @@ void QtDesktopWindow::setCapabilities(const std::string& extensions, uint32_t vi
     panel_->enablePowerControl(base::contains(extensions_list, common::kPowerControlExtension));
     panel_->enableScreenSelect(base::contains(extensions_list, common::kSelectScreenExtension));
     panel_->enableSystemInfo(base::contains(extensions_list, common::kSystemInfoExtension));
+
+    viewport_supported_ = base::contains(extensions_list, common::kViewportExtension);
+    visibility_supported_ = base::contains(extensions_list, common::kVisibilityExtension);
+
+    // The window may be minimized before the host has told it about its capabilities.
+    updateVisibility();
 }
 
 void QtDesktopWindow::setScreenList(const proto::ScreenList& screen_list)
@@ -278,9 +299,10 @@ void QtDesktopWindow::setSystemInfo(const proto::SystemInfo& system_info)
         system_info_ = new SystemInfoWindow(this);
         system_info_->setAttribute(Qt::WA_DeleteOnClose);
 
+        // The window requests the information when the user refreshes it.
         connect(system_info_, &SystemInfoWindow::systemInfoRequired, [this]()
         {
-            desktop_control_proxy_->onSystemInfoRequest();
+            desktop_control_proxy_->onSystemInfoRequest(true);
         });
     }
 
@@ -305,7 +327,11 @@ void QtDesktopWindow::setMetrics(const DesktopWindow::Metrics& metrics)
         statistics_dialog_->activateWindow();
     }
 
-    statistics_dialog_->setMetrics(metrics);
+    // The painting is measured by the window itself.
+    DesktopWindow::Metrics window_metrics = metrics;
+    window_metrics.latency.paint = desktop_->paintTime().count();
+
+    statistics_dialog_->setMetrics(window_metrics);
 }
 
 std::unique_ptr<FrameFactory> QtDesktopWindow::frameFactory()
@@ -330,9 +356,9 @@ void QtDesktopWindow::setFrame(
     }
 }
 
-void QtDesktopWindow::drawFrame()
+void QtDesktopWindow::drawFrame(const base::Region& updated_region)
 {
-    desktop_->update();
+    desktop_->updateDesktopFrame(updated_region);
     panel_->update();
 }
 
@@ -348,6 +374,29 @@ void QtDesktopWindow::setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cu
         QPixmap::fromImage(std::move(image)), mouse_cursor->hotSpotX(), mouse_cursor->hotSpotY()));
 }
 
+void QtDesktopWindow::setMouseCursorPosition(const base::Point& position)
+{
+    // The cursor is not taken from the user if it is outside the window.
+    if (!isActiveWindow() || !desktop_->underMouse())
+        return;
+
+    base::Frame* current_frame = desktop_->desktopFrame();
+    if (!current_frame)
+        return;
+
+    const base::Size& source_size = current_frame->size();
+    QSize scaled_size = desktop_->size();
+
+    double scale_x = (scaled_size.width() * 100) / static_cast<double>(source_size.width());
+    double scale_y = (scaled_size.height() * 100) / static_cast<double>(source_size.height());
+    double scale = std::min(scale_x, scale_y);
+
+    QPoint pos(static_cast<int>(static_cast<double>(position.x()) * scale / 100),
+               static_cast<int>(static_cast<double>(position.y()) * scale / 100));
+
+    QCursor::setPos(desktop_->mapToGlobal(pos));
+}
+
 void QtDesktopWindow::resizeEvent(QResizeEvent* event)
 {
     panel_->move(QPoint(width() / 2 - panel_->width() / 2, 0));
@@ -355,6 +404,26 @@ void QtDesktopWindow::resizeEvent(QResizeEvent* event)
     QWidget::resizeEvent(event);
 }
 
+void QtDesktopWindow::changeEvent(QEvent* event)
+{
+    if (event->type() == QEvent::WindowStateChange || event->type() == QEvent::ActivationChange)
+        updateVisibility();
+
+    QWidget::changeEvent(event);
+}
+
+void QtDesktopWindow::showEvent(QShowEvent* event)
+{
+    updateVisibility();
+    QWidget::showEvent(event);
+}
+
+void QtDesktopWindow::hideEvent(QHideEvent* event)
+{
+    updateVisibility();
+    QWidget::hideEvent(event);
+}
+
 void QtDesktopWindow::leaveEvent(QEvent* event)
 {
     if (scroll_timer_->isActive())
@@ -583,6 +652,8 @@ void QtDesktopWindow::scaleDesktop()
 
     LOG(LS_INFO) << "Starting resize timer";
     resize_timer_->start(std::chrono::milliseconds(500));
+
+    viewport_timer_->start();
 }
 
 void QtDesktopWindow::onResizeTimer()
@@ -626,4 +697,68 @@ void QtDesktopWindow::onScrollTimer()
     }
 }
 
+void QtDesktopWindow::onViewportTimer()
+{
+    base::Frame* current_frame = desktop_->desktopFrame();
+    if (!viewport_supported_ || !current_frame || desktop_->width() <= 0 || desktop_->height() <= 0)
+        return;
+
+    // The part of the desktop widget which is inside the viewport of the scroll area.
+    QWidget* scroll_viewport = scroll_area_->viewport();
+    QRect visible_rect(desktop_->mapFrom(scroll_viewport, QPoint(0, 0)), scroll_viewport->size());
+    visible_rect = visible_rect.intersected(desktop_->rect());
+
+    // If the whole desktop is visible, an empty area is sent.
+    QRect viewport;
+
+    if (visible_rect != desktop_->rect() && !visible_rect.isEmpty())
+    {
+        // The video may be scaled in the window.
+        const base::Size& video_size = current_frame->size();
+        double scale_x = video_size.width() / static_cast<double>(desktop_->width());
+        double scale_y = video_size.height() / static_cast<double>(desktop_->height());
+
+        int left = static_cast<int>(std::floor(visible_rect.left() * scale_x));
+        int top = static_cast<int>(std::floor(visible_rect.top() * scale_y));
+        int right = static_cast<int>(std::ceil((visible_rect.right() + 1) * scale_x));
+        int bottom = static_cast<int>(std::ceil((visible_rect.bottom() + 1) * scale_y));
+
+        viewport = QRect(QPoint(left, top), QPoint(right - 1, bottom - 1))
+            .intersected(QRect(0, 0, video_size.width(), video_size.height()));
+    }
+
+    if (viewport == viewport_)
+        return;
+
+    viewport_ = viewport;
+
+    LOG(LS_INFO) << "Viewport changed: " << viewport.x() << "," << viewport.y() << " "
+                 << viewport.width() << "x" << viewport.height();
+
+    desktop_control_proxy_->setViewport(
+        viewport.x(), viewport.y(), viewport.width(), viewport.height());
+}
+
+void QtDesktopWindow::updateVisibility()
+{
+    if (!desktop_control_proxy_)
+        return;
+
+    bool is_visible = isVisible() && !isMinimized();
+    bool is_focused = is_visible && isActiveWindow();
+
+    if (is_visible != window_visible_ || is_focused != window_focused_)
+    {
+        window_visible_ = is_visible;
+        window_focused_ = is_focused;
+        desktop_control_proxy_->setWindowState(is_visible, is_focused);
+    }
+
+    if (!visibility_supported_ || is_visible == is_visible_)
+        return;
+
+    is_visible_ = is_visible;
+    desktop_control_proxy_->setVisibility(is_visible);
+}
+
 } // namespace client
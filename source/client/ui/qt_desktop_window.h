@@ -67,13 +67,17 @@ public:
     void setMetrics(const DesktopWindow::Metrics& metrics) override;
     std::unique_ptr<FrameFactory> frameFactory() override;
     void setFrame(const base::Size& screen_size, std::shared_ptr<base::Frame> frame) override;
-    void drawFrame() override;
+    void drawFrame(const base::Region& updated_region) override;
     void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor) override;
+    void setMouseCursorPosition(const base::Point& position) override;
 
 protected:
     // QWidget implementation.
     void resizeEvent(QResizeEvent* event) override;
     void leaveEvent(QEvent* event) override;
+    void changeEvent(QEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
     bool eventFilter(QObject* object, QEvent* event) override;
 
 private slots:
@@ -86,6 +90,8 @@ private slots:
     void scaleDesktop();
     void onResizeTimer();
     void onScrollTimer();
+    void onViewportTimer();
+    void updateVisibility();
 
 private:
     const proto::SessionType session_type_;
@@ -109,6 +115,19 @@ private:
     QTimer* scroll_timer_ = nullptr;
     QPoint scroll_delta_;
 
+    // The visible area of the video is sent to the host after the scrolling or the resizing stops.
+    bool viewport_supported_ = false;
+    QTimer* viewport_timer_ = nullptr;
+    QRect viewport_;
+
+    // The host updates the video of a minimized window rarely.
+    bool visibility_supported_ = false;
+    bool is_visible_ = true;
+
+    // The video of the focused window is decoded first (see VideoDecodePool).
+    bool window_visible_ = true;
+    bool window_focused_ = false;
+
     bool is_maximized_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(QtDesktopWindow);
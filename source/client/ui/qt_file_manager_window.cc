@@ -52,6 +52,10 @@ QtFileManagerWindow::QtFileManagerWindow(QWidget* parent)
     initPanel(common::FileTask::Target::LOCAL, tr("Local Computer"), mime_type, ui->local_panel);
     initPanel(common::FileTask::Target::REMOTE, tr("Remote Computer"), mime_type, ui->remote_panel);
 
+    // Only local folders can be watched for changes.
+    ui->local_panel->setSyncAvailable(true);
+    connect(ui->local_panel, &FilePanel::syncFolder, this, &QtFileManagerWindow::syncFolder);
+
     ui->local_panel->setFocus();
 }
 
@@ -117,6 +121,20 @@ void QtFileManagerWindow::onFileList(
     }
 }
 
+void QtFileManagerWindow::onFileListContinued(
+    common::FileTask::Target target, const proto::FileList& file_list)
+{
+    if (target == common::FileTask::Target::LOCAL)
+    {
+        ui->local_panel->onFileListContinued(file_list);
+    }
+    else
+    {
+        DCHECK_EQ(target, common::FileTask::Target::REMOTE);
+        ui->remote_panel->onFileListContinued(file_list);
+    }
+}
+
 void QtFileManagerWindow::onCreateDirectory(
     common::FileTask::Target target, proto::FileError error_code)
 {
@@ -190,6 +208,10 @@ void QtFileManagerWindow::closeEvent(QCloseEvent* event)
     if (remove_dialog_)
         remove_dialog_->stop();
 
+    // The sync is stopped together with the session.
+    if (sync_dialog_)
+        delete sync_dialog_.data();
+
     FileManagerSettings settings;
 
     settings.setWindowGeometry(saveGeometry());
@@ -290,6 +312,35 @@ void QtFileManagerWindow::transferItems(FileTransfer::Type type,
         items);
 }
 
+void QtFileManagerWindow::syncFolder()
+{
+    if (sync_dialog_)
+    {
+        // Only one folder is synced at a time.
+        sync_dialog_->show();
+        sync_dialog_->activateWindow();
+        return;
+    }
+
+    const QString local_path = ui->local_panel->currentPath();
+    const QString remote_path = ui->remote_panel->currentPath();
+
+    sync_dialog_ = new FileTransferDialog(this);
+    sync_dialog_->setAttribute(Qt::WA_DeleteOnClose);
+    sync_dialog_->setSyncMode(local_path, remote_path);
+
+    connect(sync_dialog_, &FileTransferDialog::finished, [this]()
+    {
+        file_control_proxy_->stopSync();
+        refresh();
+    });
+
+    sync_dialog_->show();
+
+    file_control_proxy_->startSync(
+        sync_dialog_->windowProxy(), local_path.toStdString(), remote_path.toStdString());
+}
+
 void QtFileManagerWindow::onPathChanged(FilePanel* sender, const QString& path)
 {
     bool allow = path != AddressBarModel::computerPath();
@@ -59,6 +59,8 @@ public:
     void onFileList(common::FileTask::Target target,
                     proto::FileError error_code,
                     const proto::FileList& file_list) override;
+    void onFileListContinued(common::FileTask::Target target,
+                             const proto::FileList& file_list) override;
     void onCreateDirectory(common::FileTask::Target target, proto::FileError error_code) override;
     void onRename(common::FileTask::Target target, proto::FileError error_code) override;
 
@@ -79,6 +81,7 @@ private slots:
                       const QString& target_folder,
                       const std::vector<FileTransfer::Item>& items);
     void onPathChanged(FilePanel* sender, const QString& path);
+    void syncFolder();
 
 private:
     void transferItems(FileTransfer::Type type,
@@ -97,6 +100,7 @@ private:
 
     QPointer<FileRemoveDialog> remove_dialog_;
     QPointer<FileTransferDialog> transfer_dialog_;
+    QPointer<FileTransferDialog> sync_dialog_;
 
     DISALLOW_COPY_AND_ASSIGN(QtFileManagerWindow);
 };
@@ -40,8 +40,16 @@ class HostTreeItem : public QTreeWidgetItem
 {
 public:
     explicit HostTreeItem(const proto::Session& session)
-        : session(session)
     {
+        update(session);
+    }
+
+    ~HostTreeItem() = default;
+
+    void update(const proto::Session& new_session)
+    {
+        session = new_session;
+
         QString time = QLocale::system().toString(
             QDateTime::fromTime_t(session.timepoint()), QLocale::ShortFormat);
 
@@ -50,8 +58,6 @@ public:
         setText(2, time);
     }
 
-    ~HostTreeItem() = default;
-
     proto::Session session;
 
 private:
@@ -63,6 +69,13 @@ class RelayTreeItem : public QTreeWidgetItem
 public:
     explicit RelayTreeItem(const proto::Session& session)
     {
+        update(session);
+    }
+
+    void update(const proto::Session& new_session)
+    {
+        session = new_session;
+
         QString time = QLocale::system().toString(
             QDateTime::fromTime_t(session.timepoint()), QLocale::ShortFormat);
 
@@ -74,7 +87,7 @@ public:
         {
             setText(2, QString::number(session_data.pool_size()));
         }
-        
+
         setText(3, QString("%1.%2.%3")
                 .arg(session.version().major())
                 .arg(session.version().minor())
@@ -83,6 +96,8 @@ public:
         setText(5, QString::fromStdString(session.os_name()));
     }
 
+    proto::Session session;
+
 private:
     DISALLOW_COPY_AND_ASSIGN(RelayTreeItem);
 };
@@ -107,6 +122,36 @@ private:
     DISALLOW_COPY_AND_ASSIGN(UserTreeItem);
 };
 
+// Adds a new session to the tree or updates the item of the session in place if it is already
+// there. The item keeps its position and selection.
+template <class ItemType>
+void updateSession(QTreeWidget* tree,
+                   std::unordered_map<int64_t, QTreeWidgetItem*>* items,
+                   const proto::Session& session)
+{
+    auto result = items->try_emplace(session.session_id(), nullptr);
+    if (result.second)
+    {
+        ItemType* item = new ItemType(session);
+        result.first->second = item;
+        tree->addTopLevelItem(item);
+        return;
+    }
+
+    static_cast<ItemType*>(result.first->second)->update(session);
+}
+
+void removeSession(std::unordered_map<int64_t, QTreeWidgetItem*>* items, int64_t session_id)
+{
+    auto it = items->find(session_id);
+    if (it == items->end())
+        return;
+
+    // Deleting the item also removes it from the tree.
+    delete it->second;
+    items->erase(it);
+}
+
 } // namespace
 
 RouterManagerWindow::RouterManagerWindow(QWidget* parent)
@@ -299,9 +344,8 @@ void RouterManagerWindow::onSessionList(std::shared_ptr<proto::SessionList> sess
 
     tree_hosts->clear();
     tree_relay->clear();
-
-    int host_count = 0;
-    int relay_count = 0;
+    host_items_.clear();
+    relay_items_.clear();
 
     for (int i = 0; i < session_list->session_size(); ++i)
     {
@@ -311,15 +355,13 @@ void RouterManagerWindow::onSessionList(std::shared_ptr<proto::SessionList> sess
         {
             case proto::ROUTER_SESSION_HOST:
             {
-                tree_hosts->addTopLevelItem(new HostTreeItem(session_list->session(i)));
-                ++host_count;
+                updateSession<HostTreeItem>(tree_hosts, &host_items_, session);
             }
             break;
 
             case proto::ROUTER_SESSION_RELAY:
             {
-                tree_relay->addTopLevelItem(new RelayTreeItem(session_list->session(i)));
-                ++relay_count;
+                updateSession<RelayTreeItem>(tree_relay, &relay_items_, session);
             }
             break;
 
@@ -328,8 +370,8 @@ void RouterManagerWindow::onSessionList(std::shared_ptr<proto::SessionList> sess
         }
     }
 
-    ui->label_hosts_conn_count->setText(QString::number(host_count));
-    ui->label_relay_conn_count->setText(QString::number(relay_count));
+    ui->label_hosts_conn_count->setText(QString::number(host_items_.size()));
+    ui->label_relay_conn_count->setText(QString::number(relay_items_.size()));
 
     for (int i = 0; i < tree_hosts->columnCount(); ++i)
         tree_hosts->resizeColumnToContents(i);
@@ -340,6 +382,42 @@ void RouterManagerWindow::onSessionList(std::shared_ptr<proto::SessionList> sess
     afterRequest();
 }
 
+void RouterManagerWindow::onSessionListUpdate(std::shared_ptr<proto::SessionListUpdate> update)
+{
+    QTreeWidget* tree_hosts = ui->tree_hosts;
+    QTreeWidget* tree_relay = ui->tree_relay;
+
+    for (int i = 0; i < update->removed_session_id_size(); ++i)
+    {
+        int64_t session_id = update->removed_session_id(i);
+
+        removeSession(&host_items_, session_id);
+        removeSession(&relay_items_, session_id);
+    }
+
+    for (int i = 0; i < update->session_size(); ++i)
+    {
+        const proto::Session& session = update->session(i);
+
+        switch (session.session_type())
+        {
+            case proto::ROUTER_SESSION_HOST:
+                updateSession<HostTreeItem>(tree_hosts, &host_items_, session);
+                break;
+
+            case proto::ROUTER_SESSION_RELAY:
+                updateSession<RelayTreeItem>(tree_relay, &relay_items_, session);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    ui->label_hosts_conn_count->setText(QString::number(host_items_.size()));
+    ui->label_relay_conn_count->setText(QString::number(relay_items_.size()));
+}
+
 void RouterManagerWindow::onSessionResult(std::shared_ptr<proto::SessionResult> session_result)
 {
     if (session_result->error_code() != proto::SessionResult::SUCCESS)
@@ -368,7 +446,7 @@ void RouterManagerWindow::onSessionResult(std::shared_ptr<proto::SessionResult>
         QMessageBox::warning(this, tr("Warning"), tr(message), QMessageBox::Ok);
     }
 
-    refreshSessionList();
+    // The disconnected session is removed from the list by the update from the router.
     afterRequest();
 }
 
@@ -602,6 +680,28 @@ void RouterManagerWindow::onCurrentHostChanged(QTreeWidgetItem* current,
                                                    .arg(session.version().patch()));
         add_item(tr("Operating System"), QString::fromStdString(session.os_name()));
 
+        if (session.has_stat())
+        {
+            const proto::SessionStat& stat = session.stat();
+
+            uint64_t received_messages = 0;
+            uint64_t received_bytes = 0;
+
+            for (int i = 0; i < stat.received_size(); ++i)
+            {
+                received_messages += stat.received(i).count();
+                received_bytes += stat.received(i).bytes();
+            }
+
+            add_item(tr("CPU Time"), tr("%1 ms").arg(stat.cpu_time_us() / 1000));
+            add_item(tr("Received"), tr("%1 messages (%2 bytes)")
+                     .arg(received_messages).arg(received_bytes));
+            add_item(tr("Sent"), tr("%1 messages (%2 bytes)")
+                     .arg(stat.sent_messages()).arg(stat.sent_bytes()));
+            add_item(tr("Write Queue"), tr("%1 (max %2)")
+                     .arg(stat.write_queue()).arg(stat.max_write_queue()));
+        }
+
         proto::HostSessionData session_data;
         if (session_data.ParseFromString(session.session_data()))
         {
@@ -25,6 +25,8 @@
 #include <QMainWindow>
 #include <QPointer>
 
+#include <unordered_map>
+
 namespace Ui {
 class RouterManagerWindow;
 } // namespace Ui
@@ -54,6 +56,7 @@ public:
     void onDisconnected(base::NetworkChannel::ErrorCode error_code) override;
     void onAccessDenied(base::ClientAuthenticator::ErrorCode error_code) override;
     void onSessionList(std::shared_ptr<proto::SessionList> session_list) override;
+    void onSessionListUpdate(std::shared_ptr<proto::SessionListUpdate> update) override;
     void onSessionResult(std::shared_ptr<proto::SessionResult> session_result) override;
     void onUserList(std::shared_ptr<proto::UserList> user_list) override;
     void onUserResult(std::shared_ptr<proto::UserResult> user_result) override;
@@ -86,6 +89,12 @@ private:
     std::shared_ptr<RouterWindowProxy> window_proxy_;
     std::unique_ptr<RouterProxy> router_proxy_;
 
+    // Tree items of the sessions by the session ID. Updates of the session list are applied to the
+    // items found here instead of searching the trees.
+    using SessionItems = std::unordered_map<int64_t, QTreeWidgetItem*>;
+    SessionItems host_items_;
+    SessionItems relay_items_;
+
     DISALLOW_COPY_AND_ASSIGN(RouterManagerWindow);
 };
 
@@ -40,6 +40,13 @@ StatisticsDialog::~StatisticsDialog() = default;
 
 void StatisticsDialog::setMetrics(const DesktopWindow::Metrics& metrics)
 {
+    const DesktopWindow::Latency& latency = metrics.latency;
+
+    // The search for the changed areas is a part of the capture.
+    const int64_t total_latency = latency.capture + latency.host_wait + latency.scale +
+        latency.encode + latency.enqueue + latency.send + latency.network + latency.decode_wait +
+        latency.decode + latency.paint;
+
     for (int i = 0; i < ui.tree->topLevelItemCount(); ++i)
     {
         QTreeWidgetItem* item = ui.tree->topLevelItem(i);
@@ -126,6 +133,54 @@ void StatisticsDialog::setMetrics(const DesktopWindow::Metrics& metrics)
             case 19:
                 item->setText(1, QString::number(metrics.send_clipboard));
                 break;
+
+            case 20:
+                item->setText(1, timeToString(latency.capture));
+                break;
+
+            case 21:
+                item->setText(1, timeToString(latency.diff));
+                break;
+
+            case 22:
+                item->setText(1, timeToString(latency.host_wait));
+                break;
+
+            case 23:
+                item->setText(1, timeToString(latency.scale));
+                break;
+
+            case 24:
+                item->setText(1, timeToString(latency.encode));
+                break;
+
+            case 25:
+                item->setText(1, timeToString(latency.enqueue));
+                break;
+
+            case 26:
+                item->setText(1, timeToString(latency.send));
+                break;
+
+            case 27:
+                item->setText(1, timeToString(latency.network));
+                break;
+
+            case 28:
+                item->setText(1, timeToString(latency.decode_wait));
+                break;
+
+            case 29:
+                item->setText(1, timeToString(latency.decode));
+                break;
+
+            case 30:
+                item->setText(1, timeToString(latency.paint));
+                break;
+
+            case 31:
+                item->setText(1, timeToString(total_latency));
+                break;
         }
     }
 }
@@ -214,4 +269,10 @@ QString StatisticsDialog::speedToString(int64_t speed)
         .arg(units);
 }
 
+// static
+QString StatisticsDialog::timeToString(int64_t time_us)
+{
+    return QString("%1 ms").arg(static_cast<double>(time_us) / 1000.0, 0, 'f', 2);
+}
+
 } // namespace client
@@ -0,0 +1,243 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/video_decode_pool.h"
+
+#include "base/logging.h"
+#include "build/build_config.h"
+
+#if defined(OS_WIN)
+#include "base/win/scoped_com_initializer.h"
+#endif // defined(OS_WIN)
+
+#include <algorithm>
+#include <thread>
+
+namespace client {
+
+namespace {
+
+// Half of the processor threads decode the video. The rest is left for the rendering and the
+// network. A single session still uses all of them, because its decoder has a thread team (see
+// codecThreads()).
+size_t poolThreadCount()
+{
+    return std::max(std::thread::hardware_concurrency() / 2, 1U);
+}
+
+// Time for which a scheduled client gives way to the clients with a higher priority, by priority.
+// The visible windows wait for about a frame, the background ones for a few.
+const std::chrono::milliseconds kPriorityDelay[] =
+{
+    std::chrono::milliseconds(0),  // FOCUSED
+    std::chrono::milliseconds(16), // VISIBLE
+    std::chrono::milliseconds(100) // BACKGROUND
+};
+
+} // namespace
+
+VideoDecodePool::VideoDecodePool()
+    : thread_pool_(poolThreadCount(), base::ThreadProfile::PLAYBACK)
+{
+    LOG(LS_INFO) << "Video decode pool started with " << thread_pool_.threadCount()
+                 << " threads";
+}
+
+VideoDecodePool::~VideoDecodePool()
+{
+    DCHECK(clients_.empty());
+}
+
+// static
+std::shared_ptr<VideoDecodePool> VideoDecodePool::shared()
+{
+    static std::mutex pool_lock;
+    static std::weak_ptr<VideoDecodePool> pool;
+
+    std::scoped_lock lock(pool_lock);
+
+    std::shared_ptr<VideoDecodePool> result = pool.lock();
+    if (!result)
+    {
+        result.reset(new VideoDecodePool());
+        pool = result;
+    }
+
+    return result;
+}
+
+void VideoDecodePool::addClient(Client* client)
+{
+    DCHECK(client);
+
+    std::scoped_lock lock(lock_);
+    clients_.emplace(client, Entry());
+}
+
+void VideoDecodePool::removeClient(Client* client)
+{
+    std::unique_lock lock(lock_);
+
+    auto it = clients_.find(client);
+    if (it == clients_.end())
+        return;
+
+    // The references to the elements stay valid if other clients are added while waiting.
+    Entry& entry = it->second;
+    entry.pending = false;
+    finished_event_.wait(lock, [&entry]() { return !entry.running; });
+
+    clients_.erase(client);
+}
+
+void VideoDecodePool::setPriority(Client* client, Priority priority)
+{
+    bool schedule_run = false;
+
+    {
+        std::scoped_lock lock(lock_);
+
+        auto it = clients_.find(client);
+        if (it == clients_.end() || it->second.priority == priority)
+            return;
+
+        // A background client which waits for the thread of the background clients can run now.
+        schedule_run = it->second.priority == Priority::BACKGROUND && it->second.pending;
+        it->second.priority = priority;
+    }
+
+    if (schedule_run)
+        thread_pool_.postTask(std::bind(&VideoDecodePool::runNext, this));
+}
+
+void VideoDecodePool::schedule(Client* client)
+{
+    {
+        std::scoped_lock lock(lock_);
+
+        auto it = clients_.find(client);
+        if (it == clients_.end() || it->second.pending)
+            return;
+
+        it->second.pending = true;
+        it->second.schedule_time = Clock::now();
+    }
+
+    thread_pool_.postTask(std::bind(&VideoDecodePool::runNext, this));
+}
+
+uint32_t VideoDecodePool::codecThreads() const
+{
+    const uint32_t processor_threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+    std::scoped_lock lock(lock_);
+    const uint32_t client_count = std::max(static_cast<uint32_t>(clients_.size()), 1U);
+
+    return std::max(processor_threads / client_count, 1U);
+}
+
+void VideoDecodePool::runNext()
+{
+    Client* client;
+    bool background;
+
+    {
+        std::scoped_lock lock(lock_);
+
+        client = takeNext();
+        if (!client)
+        {
+            // The clients are decoding on the other threads, which run this again when they
+            // finish.
+            return;
+        }
+
+        Entry& entry = clients_[client];
+        entry.pending = false;
+        entry.running = true;
+
+        background = entry.priority == Priority::BACKGROUND;
+        if (background)
+            ++background_running_;
+    }
+
+#if defined(OS_WIN)
+    // Media Foundation decoders need COM. It stays initialized until the thread exits.
+    thread_local base::win::ScopedCOMInitializer com_initializer(
+        base::win::ScopedCOMInitializer::kMTA);
+#endif // defined(OS_WIN)
+
+    client->onDecode();
+
+    bool schedule_run = false;
+
+    {
+        std::scoped_lock lock(lock_);
+
+        clients_[client].running = false;
+        if (background)
+            --background_running_;
+
+        // The client could be scheduled again while it was decoding, or other clients could wait
+        // for it or for the thread of the background clients.
+        for (const auto& other : clients_)
+        {
+            if (other.second.pending)
+            {
+                schedule_run = true;
+                break;
+            }
+        }
+    }
+
+    finished_event_.notify_all();
+
+    if (schedule_run)
+        thread_pool_.postTask(std::bind(&VideoDecodePool::runNext, this));
+}
+
+VideoDecodePool::Client* VideoDecodePool::takeNext()
+{
+    Client* next = nullptr;
+    Clock::time_point next_deadline;
+
+    for (const auto& client : clients_)
+    {
+        const Entry& entry = client.second;
+
+        if (!entry.pending || entry.running)
+            continue;
+
+        // The background clients are decoded on one thread at a time.
+        if (entry.priority == Priority::BACKGROUND && background_running_ != 0)
+            continue;
+
+        const Clock::time_point deadline =
+            entry.schedule_time + kPriorityDelay[static_cast<size_t>(entry.priority)];
+
+        if (next && deadline >= next_deadline)
+            continue;
+
+        next = client.first;
+        next_deadline = deadline;
+    }
+
+    return next;
+}
+
+} // namespace client
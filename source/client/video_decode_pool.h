@@ -0,0 +1,113 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__VIDEO_DECODE_POOL_H
+#define CLIENT__VIDEO_DECODE_POOL_H
+
+#include "base/macros_magic.h"
+#include "base/threading/thread_pool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace client {
+
+// Threads which decode the video of all the desktop sessions of the process. With many sessions
+// open, a thread and a team of codec threads for each of them would oversubscribe the processor.
+// The pool has a fixed number of threads and decodes the video of the focused window first. The
+// other sessions wait longer, but are not starved, and the background sessions get no more than
+// one thread. The class is thread-safe.
+class VideoDecodePool
+{
+public:
+    ~VideoDecodePool();
+
+    // Returns the pool of the process. It is created on first use and destroyed with the last
+    // reference.
+    static std::shared_ptr<VideoDecodePool> shared();
+
+    // Clients with a lower priority are decoded when they have waited longer (see kPriorityDelay).
+    enum class Priority
+    {
+        FOCUSED,   // The window has the input focus.
+        VISIBLE,   // The window is visible, but not focused.
+        BACKGROUND // The window is minimized or hidden.
+    };
+
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        // Decodes the queued video. Called on a thread of the pool, never on two threads at once.
+        virtual void onDecode() = 0;
+    };
+
+    void addClient(Client* client);
+
+    // Waits until onDecode of |client| returns if it is running.
+    void removeClient(Client* client);
+
+    void setPriority(Client* client, Priority priority);
+
+    // Requests a call of onDecode of |client|. If the client is decoding now, it is called again.
+    void schedule(Client* client);
+
+    // Number of the codec threads for a new decoder, so that the decoders of all the sessions
+    // together do not use more threads than the processor has.
+    uint32_t codecThreads() const;
+
+private:
+    VideoDecodePool();
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        Priority priority = Priority::VISIBLE;
+        bool pending = false;
+        bool running = false;
+
+        // Time of the scheduling. The client whose time plus the delay of its priority is the
+        // earliest is decoded first.
+        Clock::time_point schedule_time;
+    };
+
+    void runNext();
+
+    // Returns the client which should be decoded next or nullptr. Must be called with |lock_|
+    // held.
+    Client* takeNext();
+
+    mutable std::mutex lock_;
+    std::condition_variable finished_event_;
+    std::unordered_map<Client*, Entry> clients_;
+    size_t background_running_ = 0;
+
+    // Destroyed first: the posted tasks are completed while the other members exist.
+    base::ThreadPool thread_pool_;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoDecodePool);
+};
+
+} // namespace client
+
+#endif // CLIENT__VIDEO_DECODE_POOL_H
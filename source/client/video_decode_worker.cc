@@ -0,0 +1,319 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "client/video_decode_worker.h"
+
+#include "base/logging.h"
+#include "base/codec/palette_decoder.h"
+#include "base/codec/refinement_decoder.h"
+#include "base/codec/tile_cache_decoder.h"
+#include "base/codec/video_decoder.h"
+#include "base/desktop/frame.h"
+#include "client/desktop_window_proxy.h"
+
+#include <limits>
+
+namespace client {
+
+namespace {
+
+// The values of the packet are not trusted. The bounds are checked in 64 bits, so the sums of
+// the coordinates and the sizes cannot overflow.
+bool isValidCopyRect(const proto::CopyRect& copy_rect, const base::Size& frame_size)
+{
+    const proto::Rect& dest_rect = copy_rect.dest_rect();
+
+    if (dest_rect.width() <= 0 || dest_rect.height() <= 0)
+        return false;
+
+    auto contains = [&](int64_t x, int64_t y)
+    {
+        return x >= 0 && y >= 0 &&
+               x + dest_rect.width() <= frame_size.width() &&
+               y + dest_rect.height() <= frame_size.height();
+    };
+
+    return contains(dest_rect.x(), dest_rect.y()) && contains(copy_rect.src_x(), copy_rect.src_y());
+}
+
+} // namespace
+
+VideoDecodeWorker::VideoDecodeWorker(std::shared_ptr<DesktopWindowProxy> desktop_window_proxy)
+    : desktop_window_proxy_(std::move(desktop_window_proxy)),
+      pool_(VideoDecodePool::shared())
+{
+    DCHECK(desktop_window_proxy_);
+    pool_->addClient(this);
+}
+
+VideoDecodeWorker::~VideoDecodeWorker()
+{
+    {
+        std::scoped_lock lock(pending_packets_lock_);
+        pending_packets_.clear();
+    }
+
+    // The decoders are destroyed after the pool finishes the current packet.
+    pool_->removeClient(this);
+}
+
+void VideoDecodeWorker::setPriority(VideoDecodePool::Priority priority)
+{
+    pool_->setPriority(this, priority);
+}
+
+bool VideoDecodeWorker::decode(std::unique_ptr<proto::VideoPacket> packet, bool can_drop)
+{
+    bool schedule_decode;
+
+    {
+        std::scoped_lock lock(pending_packets_lock_);
+
+        if (waiting_for_format_)
+        {
+            if (!packet->has_format())
+                return true;
+
+            waiting_for_format_ = false;
+        }
+
+        if (can_drop && pending_packets_.size() >= kMaxPendingPackets)
+        {
+            LOG(LS_WARNING) << "Video decoder is behind. " << pending_packets_.size() + 1
+                            << " packets dropped";
+
+            pending_packets_.clear();
+            waiting_for_format_ = true;
+            return false;
+        }
+
+        pending_packets_.push_back({ std::move(packet), Clock::now() });
+
+        // If the decoding is scheduled, the packet is decoded after the packets queued before it.
+        schedule_decode = !decode_scheduled_;
+        decode_scheduled_ = true;
+    }
+
+    if (schedule_decode)
+        pool_->schedule(this);
+
+    return true;
+}
+
+void VideoDecodeWorker::onDecode()
+{
+    for (;;)
+    {
+        PendingPacket pending_packet;
+
+        {
+            std::scoped_lock lock(pending_packets_lock_);
+
+            if (pending_packets_.empty())
+            {
+                decode_scheduled_ = false;
+                return;
+            }
+
+            pending_packet = std::move(pending_packets_.front());
+            pending_packets_.pop_front();
+        }
+
+        const Clock::time_point decode_start = Clock::now();
+        decodePacket(*pending_packet.packet);
+
+        updateTiming(decode_start - pending_packet.receive_time, Clock::now() - decode_start);
+    }
+}
+
+VideoDecodeWorker::Timing VideoDecodeWorker::timing() const
+{
+    std::scoped_lock lock(timing_lock_);
+    return timing_;
+}
+
+void VideoDecodeWorker::updateTiming(const Clock::duration& wait, const Clock::duration& decode)
+{
+    static const double kAlpha = 0.1;
+
+    auto average = [](const std::chrono::microseconds& last, const Clock::duration& value)
+    {
+        const double value_us = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::microseconds>(value).count());
+
+        return std::chrono::microseconds(static_cast<int64_t>(
+            (kAlpha * value_us) + ((1.0 - kAlpha) * static_cast<double>(last.count()))));
+    };
+
+    std::scoped_lock lock(timing_lock_);
+    timing_.wait = average(timing_.wait, wait);
+    timing_.decode = average(timing_.decode, decode);
+}
+
+void VideoDecodeWorker::decodePacket(const proto::VideoPacket& packet)
+{
+    // The number of the codec threads depends on the number of the sessions. The decoder is
+    // created again only with the format, where the new video starts.
+    const uint32_t codec_threads = packet.has_format() ? pool_->codecThreads() : codec_threads_;
+
+    if (video_encoding_ != packet.encoding() || codec_threads_ != codec_threads)
+    {
+        video_decoder_ = base::VideoDecoder::create(packet.encoding(), codec_threads);
+        video_encoding_ = packet.encoding();
+        codec_threads_ = codec_threads;
+
+        LOG(LS_INFO) << "Video encoding changed to: " << video_encoding_ << " (codec threads: "
+                     << codec_threads_ << ")";
+    }
+
+    if (!video_decoder_)
+    {
+        LOG(LS_ERROR) << "Video decoder not initialized";
+        return;
+    }
+
+    if (packet.has_format())
+    {
+        const proto::VideoPacketFormat& format = packet.format();
+        base::Size video_size(format.video_rect().width(), format.video_rect().height());
+        base::Size screen_size = video_size;
+
+        static const int kMaxValue = std::numeric_limits<uint16_t>::max();
+
+        if (video_size.width()  <= 0 || video_size.width()  >= kMaxValue ||
+            video_size.height() <= 0 || video_size.height() >= kMaxValue)
+        {
+            LOG(LS_ERROR) << "Wrong video frame size";
+            return;
+        }
+
+        if (format.has_screen_size())
+        {
+            screen_size = base::Size(
+                format.screen_size().width(), format.screen_size().height());
+
+            if (screen_size.width() <= 0 || screen_size.width() >= kMaxValue ||
+                screen_size.height() <= 0 || screen_size.height() >= kMaxValue)
+            {
+                LOG(LS_ERROR) << "Wrong screen size";
+                return;
+            }
+        }
+
+        LOG(LS_INFO) << "New video size: " << video_size.width() << "x" << video_size.height();
+        LOG(LS_INFO) << "New screen size: " << screen_size.width() << "x" << screen_size.height();
+
+        // A new encoder of the host (for example, after a reconnection of another client) sends
+        // the same format again. The frame keeps its pixels until the key frame paints it over,
+        // so the window is not reset.
+        if (!desktop_frame_ || desktop_frame_->size() != video_size || screen_size_ != screen_size)
+        {
+            desktop_frame_ = desktop_window_proxy_->allocateFrame(video_size);
+            desktop_window_proxy_->setFrame(screen_size, desktop_frame_);
+            screen_size_ = screen_size;
+        }
+
+        if (!tile_cache_decoder_)
+            tile_cache_decoder_ = std::make_unique<base::TileCacheDecoder>();
+
+        if (!palette_decoder_)
+            palette_decoder_ = std::make_unique<base::PaletteDecoder>();
+
+        if (!refinement_decoder_)
+            refinement_decoder_ = std::make_unique<base::RefinementDecoder>();
+
+        // The host clears its tile cache every time it sends the format.
+        if (!tile_cache_decoder_->reset(format.tile_cache_size()))
+            return;
+    }
+
+    if (!desktop_frame_)
+    {
+        LOG(LS_ERROR) << "The desktop frame is not initialized";
+        return;
+    }
+
+    const base::Rect frame_rect = base::Rect::makeSize(desktop_frame_->size());
+
+    // The decoders add the areas which they change to the updated region of the frame. Only these
+    // areas are painted again by the window.
+    base::Region* updated_region = desktop_frame_->updatedRegion();
+    updated_region->clear();
+
+    // The moved areas are copied before decoding, because the sources of the copies are in the
+    // previous frame.
+    for (int i = 0; i < packet.copy_rect_size(); ++i)
+    {
+        const proto::CopyRect& copy_rect = packet.copy_rect(i);
+
+        if (!isValidCopyRect(copy_rect, desktop_frame_->size()))
+        {
+            LOG(LS_ERROR) << "Wrong copy rect";
+            return;
+        }
+
+        const proto::Rect& dest_rect = copy_rect.dest_rect();
+        base::Rect dest = base::Rect::makeXYWH(
+            dest_rect.x(), dest_rect.y(), dest_rect.width(), dest_rect.height());
+
+        desktop_frame_->movePixels(base::Point(copy_rect.src_x(), copy_rect.src_y()), dest);
+        updated_region->addRect(dest);
+    }
+
+    if (!tile_cache_decoder_->copyCachedTiles(packet, desktop_frame_.get()))
+    {
+        LOG(LS_ERROR) << "The cached tiles could not be copied";
+        return;
+    }
+
+    if (!video_decoder_->decode(packet, desktop_frame_.get()))
+    {
+        LOG(LS_ERROR) << "The video packet could not be decoded";
+        return;
+    }
+
+    for (int i = 0; i < packet.dirty_rect_size(); ++i)
+    {
+        const proto::Rect& dirty_rect = packet.dirty_rect(i);
+        updated_region->addRect(base::Rect::makeXYWH(
+            dirty_rect.x(), dirty_rect.y(), dirty_rect.width(), dirty_rect.height()));
+    }
+
+    if (!palette_decoder_->decode(packet, desktop_frame_.get()))
+    {
+        LOG(LS_ERROR) << "The palette blocks could not be decoded";
+        return;
+    }
+
+    if (!refinement_decoder_->decode(packet, desktop_frame_.get()))
+    {
+        LOG(LS_ERROR) << "The refinement blocks could not be decoded";
+        return;
+    }
+
+    if (!tile_cache_decoder_->storeNewTiles(packet, *desktop_frame_))
+    {
+        LOG(LS_ERROR) << "The new tiles could not be stored";
+        return;
+    }
+
+    updated_region->intersectWith(frame_rect);
+    desktop_window_proxy_->drawFrame(*updated_region);
+}
+
+} // namespace client
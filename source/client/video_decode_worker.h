@@ -0,0 +1,117 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CLIENT__VIDEO_DECODE_WORKER_H
+#define CLIENT__VIDEO_DECODE_WORKER_H
+
+#include "base/macros_magic.h"
+#include "base/desktop/geometry.h"
+#include "client/video_decode_pool.h"
+#include "proto/desktop.pb.h"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+namespace base {
+class Frame;
+class PaletteDecoder;
+class RefinementDecoder;
+class TileCacheDecoder;
+class VideoDecoder;
+} // namespace base
+
+namespace client {
+
+class DesktopWindowProxy;
+
+// Decodes video packets on the threads of VideoDecodePool so that the network thread does not
+// wait for the decoder. Audio, cursor and input messages are processed while a large frame is
+// decoded.
+class VideoDecodeWorker : public VideoDecodePool::Client
+{
+public:
+    explicit VideoDecodeWorker(std::shared_ptr<DesktopWindowProxy> desktop_window_proxy);
+    ~VideoDecodeWorker() override;
+
+    // Maximum number of packets waiting for the decoder.
+    static const size_t kMaxPendingPackets = 4;
+
+    // Queues |packet| for decoding. If |can_drop| is true and the decoder falls behind, the
+    // waiting packets are dropped and false is returned. The next packets depend on the dropped
+    // ones, so they are dropped too until a packet with the format (the start of a new video) is
+    // received. The caller should ask the host to restart the video.
+    bool decode(std::unique_ptr<proto::VideoPacket> packet, bool can_drop);
+
+    // Average time which the packets spend in the queue of the decoder and in the decoder itself.
+    struct Timing
+    {
+        std::chrono::microseconds wait = std::chrono::microseconds::zero();
+        std::chrono::microseconds decode = std::chrono::microseconds::zero();
+    };
+
+    Timing timing() const;
+
+    // The priority follows the state of the window of the session.
+    void setPriority(VideoDecodePool::Priority priority);
+
+protected:
+    // VideoDecodePool::Client implementation.
+    void onDecode() override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingPacket
+    {
+        std::unique_ptr<proto::VideoPacket> packet;
+        Clock::time_point receive_time;
+    };
+
+    // Called on a thread of the pool.
+    void decodePacket(const proto::VideoPacket& packet);
+    void updateTiming(const Clock::duration& wait, const Clock::duration& decode);
+
+    std::shared_ptr<DesktopWindowProxy> desktop_window_proxy_;
+
+    std::shared_ptr<VideoDecodePool> pool_;
+
+    std::mutex pending_packets_lock_;
+    std::deque<PendingPacket> pending_packets_;
+    bool decode_scheduled_ = false;
+    bool waiting_for_format_ = false;
+
+    mutable std::mutex timing_lock_;
+    Timing timing_;
+
+    // Used only in onDecode.
+    proto::VideoEncoding video_encoding_ = proto::VIDEO_ENCODING_UNKNOWN;
+    uint32_t codec_threads_ = 0;
+    std::unique_ptr<base::VideoDecoder> video_decoder_;
+    std::unique_ptr<base::TileCacheDecoder> tile_cache_decoder_;
+    std::unique_ptr<base::PaletteDecoder> palette_decoder_;
+    std::unique_ptr<base::RefinementDecoder> refinement_decoder_;
+    std::shared_ptr<base::Frame> desktop_frame_;
+    base::Size screen_size_;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoDecodeWorker);
+};
+
+} // namespace client
+
+#endif // CLIENT__VIDEO_DECODE_WORKER_H
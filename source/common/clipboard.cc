@@ -18,6 +18,7 @@
 
 #include "common/clipboard.h"
 
+#include "base/crypto/random.h"
 #include "base/logging.h"
 
 #include <zstd.h>
@@ -98,8 +99,72 @@ bool decompress(const std::string& in, std::string* out)
     return true;
 }
 
+bool decodeData(const proto::ClipboardEvent& event, std::string* data)
+{
+    if (event.mime_type() == kMimeTypeCompressedTextUtf8)
+        return decompress(event.data(), data);
+
+    if (event.mime_type() == kMimeTypeTextUtf8)
+    {
+        *data = event.data();
+        return true;
+    }
+
+    LOG(LS_WARNING) << "Unsupported mime type: " << event.mime_type();
+    return false;
+}
+
+uint32_t newSerial()
+{
+    // Zero means that the event does not belong to an announcement.
+    uint32_t serial;
+    do
+    {
+        serial = base::Random::number32();
+    }
+    while (!serial);
+
+    return serial;
+}
+
 } // namespace
 
+bool Clipboard::DataWaiter::deliver(const proto::ClipboardEvent& event)
+{
+    std::scoped_lock lock(lock_);
+
+    if (!serial_ || serial_ != event.serial())
+        return false;
+
+    serial_ = 0;
+    event_ = event;
+    event_delivered_.notify_one();
+    return true;
+}
+
+void Clipboard::DataWaiter::startWaiting(uint32_t serial)
+{
+    std::scoped_lock lock(lock_);
+    serial_ = serial;
+    event_.reset();
+}
+
+std::optional<proto::ClipboardEvent> Clipboard::DataWaiter::wait(
+    std::chrono::milliseconds timeout)
+{
+    std::unique_lock lock(lock_);
+
+    if (!event_delivered_.wait_for(lock, timeout, [this]() { return event_.has_value(); }))
+    {
+        serial_ = 0;
+        return std::nullopt;
+    }
+
+    std::optional<proto::ClipboardEvent> event = std::move(event_);
+    event_.reset();
+    return event;
+}
+
 void Clipboard::start(Delegate* delegate)
 {
     delegate_ = delegate;
@@ -107,29 +172,55 @@ void Clipboard::start(Delegate* delegate)
     init();
 }
 
-void Clipboard::injectClipboardEvent(const proto::ClipboardEvent& event)
+void Clipboard::setLazy(bool enable)
 {
-    if (event.mime_type() == kMimeTypeCompressedTextUtf8)
-    {
-        std::string decompressed_data;
-        if (!decompress(event.data(), &decompressed_data))
-            return;
+    lazy_ = enable;
+}
 
-        // Store last injected data.
-        last_data_ = std::move(decompressed_data);
-    }
-    else if (event.mime_type() == kMimeTypeTextUtf8)
-    {
-        // Store last injected data.
-        last_data_ = event.data();
-    }
-    else
+void Clipboard::setDataWaiter(std::shared_ptr<DataWaiter> waiter)
+{
+    waiter_ = std::move(waiter);
+}
+
+void Clipboard::injectClipboardEvent(const proto::ClipboardEvent& event)
+{
+    switch (event.type())
     {
-        LOG(LS_WARNING) << "Unsupported mime type: " << event.mime_type();
-        return;
+        case proto::ClipboardEvent::TYPE_ANNOUNCE:
+        {
+            remote_serial_ = event.serial();
+
+            // The data is unknown until it is requested.
+            last_data_.clear();
+            setDataAnnounced(event.mime_type(), event.data_size());
+        }
+        break;
+
+        case proto::ClipboardEvent::TYPE_REQUEST:
+        {
+            // A request for an older announcement is ignored. The peer receives the new one.
+            if (event.serial() && event.serial() == announced_serial_)
+                sendData(announced_data_, announced_serial_);
+        }
+        break;
+
+        default:
+        {
+            std::string data;
+            if (!decodeData(event, &data))
+                return;
+
+            // Store last injected data.
+            last_data_ = std::move(data);
+            setData(last_data_);
+        }
+        break;
     }
+}
 
-    setData(last_data_);
+void Clipboard::setDataAnnounced(const std::string& /* mime_type */, uint64_t /* data_size */)
+{
+    requestData();
 }
 
 void Clipboard::onData(const std::string& data)
@@ -137,7 +228,61 @@ void Clipboard::onData(const std::string& data)
     if (last_data_ == data)
         return;
 
+    if (!lazy_)
+    {
+        sendData(data, 0);
+        return;
+    }
+
+    announced_data_ = data;
+    announced_serial_ = newSerial();
+
+    proto::ClipboardEvent event;
+    event.set_type(proto::ClipboardEvent::TYPE_ANNOUNCE);
+    event.set_mime_type(kMimeTypeTextUtf8);
+    event.set_data_size(data.size());
+    event.set_serial(announced_serial_);
+
+    if (delegate_)
+        delegate_->onClipboardEvent(event);
+}
+
+void Clipboard::requestData()
+{
+    proto::ClipboardEvent event;
+    event.set_type(proto::ClipboardEvent::TYPE_REQUEST);
+    event.set_serial(remote_serial_);
+
+    if (delegate_)
+        delegate_->onClipboardEvent(event);
+}
+
+bool Clipboard::receiveAnnouncedData(std::chrono::milliseconds timeout, std::string* data)
+{
+    if (!waiter_ || !remote_serial_)
+        return false;
+
+    waiter_->startWaiting(remote_serial_);
+    requestData();
+
+    std::optional<proto::ClipboardEvent> event = waiter_->wait(timeout);
+    if (!event.has_value())
+    {
+        LOG(LS_WARNING) << "Announced clipboard data not received";
+        return false;
+    }
+
+    if (!decodeData(*event, data))
+        return false;
+
+    last_data_ = *data;
+    return true;
+}
+
+void Clipboard::sendData(const std::string& data, uint32_t serial)
+{
     proto::ClipboardEvent event;
+    event.set_serial(serial);
 
     if (data.size() > kMinSizeToCompress)
     {
@@ -151,7 +296,7 @@ void Clipboard::onData(const std::string& data)
     else
     {
         event.set_mime_type(kMimeTypeTextUtf8);
-        event.set_data(std::move(data));
+        event.set_data(data);
     }
 
     if (delegate_)
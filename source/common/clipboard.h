@@ -19,9 +19,14 @@
 #ifndef COMMON__CLIPBOARD_H
 #define COMMON__CLIPBOARD_H
 
+#include "base/macros_magic.h"
 #include "proto/desktop.pb.h"
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <optional>
 
 namespace common {
 
@@ -38,19 +43,72 @@ public:
         virtual void onClipboardEvent(const proto::ClipboardEvent& event) = 0;
     };
 
+    // Passes the requested data to the clipboard thread while it is blocked in
+    // receiveAnnouncedData(). The data is delivered from another thread.
+    class DataWaiter
+    {
+    public:
+        DataWaiter() = default;
+
+        // Returns true if the clipboard thread is waiting for |event|. The event is passed to it.
+        bool deliver(const proto::ClipboardEvent& event);
+
+    private:
+        friend class Clipboard;
+
+        void startWaiting(uint32_t serial);
+        std::optional<proto::ClipboardEvent> wait(std::chrono::milliseconds timeout);
+
+        std::mutex lock_;
+        std::condition_variable event_delivered_;
+        uint32_t serial_ = 0;
+        std::optional<proto::ClipboardEvent> event_;
+
+        DISALLOW_COPY_AND_ASSIGN(DataWaiter);
+    };
+
     void start(Delegate* delegate);
 
+    // In the lazy mode only the format and the size of the local clipboard are sent to the peer.
+    // The data is sent when the peer requests it (when it is pasted on the remote side).
+    void setLazy(bool enable);
+    void setDataWaiter(std::shared_ptr<DataWaiter> waiter);
+
     // Receiving the incoming clipboard.
     void injectClipboardEvent(const proto::ClipboardEvent& event);
 
 protected:
     virtual void init() = 0;
     virtual void setData(const std::string& data) = 0;
+
+    // Called when the peer has announced new clipboard data. The default implementation requests
+    // the data immediately. Implementations with delayed rendering take the ownership of the
+    // clipboard and request the data when it is pasted.
+    virtual void setDataAnnounced(const std::string& mime_type, uint64_t data_size);
+
     void onData(const std::string& data);
 
+    // Requests the announced data. It is received by injectClipboardEvent().
+    void requestData();
+
+    // Requests the announced data and blocks until it is received or |timeout| expires.
+    bool receiveAnnouncedData(std::chrono::milliseconds timeout, std::string* data);
+
 private:
+    void sendData(const std::string& data, uint32_t serial);
+
     Delegate* delegate_ = nullptr;
     std::string last_data_;
+
+    bool lazy_ = false;
+    std::shared_ptr<DataWaiter> waiter_;
+
+    // The local data which was announced to the peer.
+    std::string announced_data_;
+    uint32_t announced_serial_ = 0;
+
+    // The last announcement received from the peer.
+    uint32_t remote_serial_ = 0;
 };
 
 } // namespace common
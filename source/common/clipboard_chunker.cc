@@ -0,0 +1,106 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "common/clipboard_chunker.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+
+namespace common {
+
+namespace {
+
+// Larger clipboard data is dropped by the receiver.
+const size_t kMaxDataSize = 64 * 1024 * 1024; // 64 MB.
+
+} // namespace
+
+// static
+std::vector<proto::ClipboardEvent> ClipboardChunker::split(const proto::ClipboardEvent& event)
+{
+    std::vector<proto::ClipboardEvent> parts;
+
+    const std::string& data = event.data();
+    if (data.size() <= kChunkSize)
+    {
+        parts.emplace_back(event);
+        return parts;
+    }
+
+    parts.reserve((data.size() + kChunkSize - 1) / kChunkSize);
+
+    for (size_t offset = 0; offset < data.size(); offset += kChunkSize)
+    {
+        const size_t size = std::min(kChunkSize, data.size() - offset);
+
+        proto::ClipboardEvent& part = parts.emplace_back();
+        part.set_mime_type(event.mime_type());
+        part.set_serial(event.serial());
+        part.set_data(data.data() + offset, size);
+        part.set_has_more(offset + size < data.size());
+    }
+
+    return parts;
+}
+
+std::optional<proto::ClipboardEvent> ClipboardChunker::addPart(const proto::ClipboardEvent& part)
+{
+    if (skip_parts_)
+    {
+        skip_parts_ = part.has_more();
+        return std::nullopt;
+    }
+
+    if (!pending_.has_value())
+    {
+        if (!part.has_more())
+            return part;
+
+        pending_.emplace();
+        pending_->set_mime_type(part.mime_type());
+        pending_->set_serial(part.serial());
+    }
+    else if (pending_->mime_type() != part.mime_type())
+    {
+        LOG(LS_ERROR) << "Clipboard part with different mime type: " << part.mime_type();
+        pending_.reset();
+        skip_parts_ = part.has_more();
+        return std::nullopt;
+    }
+
+    if (pending_->data().size() + part.data().size() > kMaxDataSize)
+    {
+        LOG(LS_ERROR) << "Clipboard data is too large";
+
+        pending_.reset();
+        skip_parts_ = part.has_more();
+        return std::nullopt;
+    }
+
+    pending_->mutable_data()->append(part.data());
+
+    if (part.has_more())
+        return std::nullopt;
+
+    std::optional<proto::ClipboardEvent> event = std::move(pending_);
+    pending_.reset();
+    return event;
+}
+
+} // namespace common
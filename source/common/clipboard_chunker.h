@@ -0,0 +1,59 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef COMMON__CLIPBOARD_CHUNKER_H
+#define COMMON__CLIPBOARD_CHUNKER_H
+
+#include "base/macros_magic.h"
+#include "proto/desktop.pb.h"
+
+#include <optional>
+#include <vector>
+
+namespace common {
+
+// Large clipboard data is sent in parts with the low priority, so a big copied image or text does
+// not hold the video behind one huge message. The data is compressed before (see Clipboard).
+class ClipboardChunker
+{
+public:
+    ClipboardChunker() = default;
+    ~ClipboardChunker() = default;
+
+    static const size_t kChunkSize = 64 * 1024; // 64 kB.
+
+    // If the data is larger than kChunkSize, returns the parts of |event|. Otherwise returns the
+    // event itself.
+    static std::vector<proto::ClipboardEvent> split(const proto::ClipboardEvent& event);
+
+    // Adds a received part. Returns the whole event when its last part is added.
+    std::optional<proto::ClipboardEvent> addPart(const proto::ClipboardEvent& part);
+
+private:
+    // The parts received so far.
+    std::optional<proto::ClipboardEvent> pending_;
+
+    // Set if the data is too large, the rest of its parts is skipped.
+    bool skip_parts_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(ClipboardChunker);
+};
+
+} // namespace common
+
+#endif // COMMON__CLIPBOARD_CHUNKER_H
@@ -34,7 +34,8 @@
 namespace common {
 
 ClipboardMonitor::ClipboardMonitor()
-    : thread_(std::make_unique<base::Thread>())
+    : thread_(std::make_unique<base::Thread>()),
+      data_waiter_(std::make_shared<common::Clipboard::DataWaiter>())
 {
     // Nothing
 }
@@ -68,11 +69,31 @@ void ClipboardMonitor::start(std::shared_ptr<base::TaskRunner> caller_task_runne
     thread_->start(message_loop_type, this);
 }
 
+void ClipboardMonitor::setLazy(bool enable)
+{
+    if (!self_task_runner_)
+        return;
+
+    if (!self_task_runner_->belongsToCurrentThread())
+    {
+        self_task_runner_->postTask(std::bind(&ClipboardMonitor::setLazy, this, enable));
+        return;
+    }
+
+    if (clipboard_)
+        clipboard_->setLazy(enable);
+}
+
 void ClipboardMonitor::injectClipboardEvent(const proto::ClipboardEvent& event)
 {
     if (!self_task_runner_)
         return;
 
+    // The clipboard thread can be blocked while waiting for the requested data, so the data is
+    // passed to it directly.
+    if (event.type() == proto::ClipboardEvent::TYPE_DATA && data_waiter_->deliver(event))
+        return;
+
     if (!self_task_runner_->belongsToCurrentThread())
     {
         self_task_runner_->postTask(
@@ -98,6 +119,7 @@ void ClipboardMonitor::onBeforeThreadRunning()
 #else
 #error Not implemented
 #endif
+    clipboard_->setDataWaiter(data_waiter_);
     clipboard_->start(this);
 }
 
@@ -35,6 +35,9 @@ public:
     void start(std::shared_ptr<base::TaskRunner> caller_task_runner,
                common::Clipboard::Delegate* delegate);
 
+    // See Clipboard::setLazy.
+    void setLazy(bool enable);
+
     void injectClipboardEvent(const proto::ClipboardEvent& event);
 
 protected:
@@ -52,6 +55,7 @@ private:
     std::shared_ptr<base::TaskRunner> caller_task_runner_;
     std::shared_ptr<base::TaskRunner> self_task_runner_;
     std::unique_ptr<common::Clipboard> clipboard_;
+    std::shared_ptr<common::Clipboard::DataWaiter> data_waiter_;
 
     DISALLOW_COPY_AND_ASSIGN(ClipboardMonitor);
 };
@@ -27,6 +27,44 @@
 
 namespace common {
 
+namespace {
+
+// The application which pastes the data is blocked while it is received.
+constexpr std::chrono::seconds kRenderTimeout { 5 };
+
+HGLOBAL createTextGlobal(const std::string& data)
+{
+    std::wstring text;
+    if (!base::utf8ToWide(base::replaceLfByCrLf(data), &text))
+    {
+        LOG(LS_WARNING) << "Couldn't convert data to unicode";
+        return nullptr;
+    }
+
+    HGLOBAL text_global = GlobalAlloc(GMEM_MOVEABLE, (text.size() + 1) * sizeof(wchar_t));
+    if (!text_global)
+    {
+        PLOG(LS_WARNING) << "GlobalAlloc failed";
+        return nullptr;
+    }
+
+    LPWSTR text_global_locked = reinterpret_cast<LPWSTR>(GlobalLock(text_global));
+    if (!text_global_locked)
+    {
+        PLOG(LS_WARNING) << "GlobalLock failed";
+        GlobalFree(text_global);
+        return nullptr;
+    }
+
+    memcpy(text_global_locked, text.data(), text.size() * sizeof(wchar_t));
+    text_global_locked[text.size()] = 0;
+
+    GlobalUnlock(text_global);
+    return text_global;
+}
+
+} // namespace
+
 ClipboardWin::ClipboardWin() = default;
 
 ClipboardWin::~ClipboardWin()
@@ -66,46 +104,40 @@ void ClipboardWin::setData(const std::string& data)
     if (!window_)
         return;
 
-    std::wstring text;
-    if (!base::utf8ToWide(base::replaceLfByCrLf(data), &text))
-    {
-        LOG(LS_WARNING) << "Couldn't convert data to unicode";
+    HGLOBAL text_global = createTextGlobal(data);
+    if (!text_global)
         return;
-    }
 
     base::win::ScopedClipboard clipboard;
     if (!clipboard.init(window_->hwnd()))
     {
         PLOG(LS_WARNING) << "Couldn't open the clipboard";
+        GlobalFree(text_global);
         return;
     }
 
     clipboard.empty();
+    clipboard.setData(CF_UNICODETEXT, text_global);
+}
 
-    HGLOBAL text_global = GlobalAlloc(GMEM_MOVEABLE, (text.size() + 1) * sizeof(wchar_t));
-    if (!text_global)
-    {
-        PLOG(LS_WARNING) << "GlobalAlloc failed";
+void ClipboardWin::setDataAnnounced(const std::string& /* mime_type */, uint64_t /* data_size */)
+{
+    if (!window_)
         return;
-    }
 
-    LPWSTR text_global_locked = reinterpret_cast<LPWSTR>(GlobalLock(text_global));
-    if (!text_global_locked)
+    base::win::ScopedClipboard clipboard;
+    if (!clipboard.init(window_->hwnd()))
     {
-        PLOG(LS_WARNING) << "GlobalLock failed";
-        GlobalFree(text_global);
+        PLOG(LS_WARNING) << "Couldn't open the clipboard";
         return;
     }
 
-    memcpy(text_global_locked, text.data(), text.size() * sizeof(wchar_t));
-    text_global_locked[text.size()] = 0;
-
-    GlobalUnlock(text_global);
-
-    clipboard.setData(CF_UNICODETEXT, text_global);
+    // The window becomes the owner of the clipboard. The data is rendered on request.
+    clipboard.empty();
+    clipboard.setData(CF_UNICODETEXT, nullptr);
 }
 
-bool ClipboardWin::onMessage(UINT message, WPARAM /* wParam */, LPARAM /* lParam */, LRESULT& result)
+bool ClipboardWin::onMessage(UINT message, WPARAM wParam, LPARAM /* lParam */, LRESULT& result)
 {
     switch (message)
     {
@@ -113,6 +145,14 @@ bool ClipboardWin::onMessage(UINT message, WPARAM /* wParam */, LPARAM /* lParam
             onClipboardUpdate();
             break;
 
+        case WM_RENDERFORMAT:
+            onRenderFormat(static_cast<UINT>(wParam));
+            break;
+
+        case WM_RENDERALLFORMATS:
+            // The window is destroyed. The data which was not requested is not received anymore.
+            break;
+
         default:
             return false;
     }
@@ -123,6 +163,10 @@ bool ClipboardWin::onMessage(UINT message, WPARAM /* wParam */, LPARAM /* lParam
 
 void ClipboardWin::onClipboardUpdate()
 {
+    // The data set by us is not sent back.
+    if (GetClipboardOwner() == window_->hwnd())
+        return;
+
     if (!IsClipboardFormatAvailable(CF_UNICODETEXT))
         return;
 
@@ -165,4 +209,25 @@ void ClipboardWin::onClipboardUpdate()
         onData(base::replaceCrLfByLf(data));
 }
 
+void ClipboardWin::onRenderFormat(UINT format)
+{
+    if (format != CF_UNICODETEXT)
+        return;
+
+    std::string data;
+    if (!receiveAnnouncedData(kRenderTimeout, &data))
+        return;
+
+    HGLOBAL text_global = createTextGlobal(data);
+    if (!text_global)
+        return;
+
+    // The clipboard is already opened by the application which requested the data.
+    if (!SetClipboardData(CF_UNICODETEXT, text_global))
+    {
+        PLOG(LS_WARNING) << "SetClipboardData failed";
+        GlobalFree(text_global);
+    }
+}
+
 } // namespace common
@@ -40,10 +40,14 @@ protected:
     // Clipboard implementation.
     void init() override;
     void setData(const std::string& data) override;
+    void setDataAnnounced(const std::string& mime_type, uint64_t data_size) override;
 
 private:
     void onClipboardUpdate();
 
+    // The announced data is rendered when an application requests it (WM_RENDERFORMAT).
+    void onRenderFormat(UINT format);
+
     // Handles messages received by |window_|.
     bool onMessage(UINT message, WPARAM wParam, LPARAM lParam, LRESULT& result);
 
@@ -68,6 +68,13 @@ void ClipboardX11::setData(const std::string& data)
         x_server_clipboard_->setClipboard(data);
 }
 
+void ClipboardX11::setDataAnnounced(const std::string& /* mime_type */, uint64_t /* data_size */)
+{
+    // The data is requested when an application asks for the selection.
+    if (x_server_clipboard_)
+        x_server_clipboard_->announceClipboard(std::bind(&ClipboardX11::requestData, this));
+}
+
 void ClipboardX11::pumpXEvents()
 {
     DCHECK(display_ && x_server_clipboard_);
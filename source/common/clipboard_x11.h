@@ -41,6 +41,7 @@ protected:
     // Clipboard implementation.
     void init() override;
     void setData(const std::string& data) override;
+    void setDataAnnounced(const std::string& mime_type, uint64_t data_size) override;
 
 private:
     void pumpXEvents();
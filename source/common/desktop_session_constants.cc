@@ -27,14 +27,21 @@ const char kPreferredSizeExtension[] = "preferred_size";
 const char kPowerControlExtension[] = "power_control";
 const char kRemoteUpdateExtension[] = "remote_update";
 const char kSystemInfoExtension[] = "system_info";
+const char kVideoRecoveryExtension[] = "video_recovery";
+const char kClipboardChunksExtension[] = "clipboard_chunks";
+const char kClipboardLazyExtension[] = "clipboard_lazy";
+const char kViewportExtension[] = "viewport";
+const char kVisibilityExtension[] = "visibility";
 
 const char kSupportedExtensionsForManage[] =
-    "select_screen;preferred_size;power_control;remote_update;system_info";
+    "select_screen;preferred_size;power_control;remote_update;system_info;video_recovery;"
+    "clipboard_chunks;clipboard_lazy;viewport;visibility";
 
 const char kSupportedExtensionsForView[] =
-    "select_screen;preferred_size;system_info";
+    "select_screen;preferred_size;system_info;video_recovery;viewport;visibility";
 
-const uint32_t kSupportedVideoEncodings = proto::VIDEO_ENCODING_VP8 | proto::VIDEO_ENCODING_VP9;
+const uint32_t kSupportedVideoEncodings =
+    proto::VIDEO_ENCODING_VP8 | proto::VIDEO_ENCODING_VP9 | proto::VIDEO_ENCODING_AV1;
 const uint32_t kSupportedAudioEncodings = proto::AUDIO_ENCODING_OPUS;
 
 } // namespace common
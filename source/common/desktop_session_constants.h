@@ -28,6 +28,11 @@ extern const char kPreferredSizeExtension[];
 extern const char kPowerControlExtension[];
 extern const char kRemoteUpdateExtension[];
 extern const char kSystemInfoExtension[];
+extern const char kVideoRecoveryExtension[];
+extern const char kClipboardChunksExtension[];
+extern const char kClipboardLazyExtension[];
+extern const char kViewportExtension[];
+extern const char kVisibilityExtension[];
 
 extern const char kSupportedExtensionsForManage[];
 extern const char kSupportedExtensionsForView[];
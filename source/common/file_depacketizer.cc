@@ -19,15 +19,17 @@
 #include "common/file_depacketizer.h"
 
 #include "base/logging.h"
+#include "common/file_packet.h"
 
 namespace common {
 
-FileDepacketizer::FileDepacketizer(const std::filesystem::path& file_path,
-                                   std::ofstream&& file_stream)
+FileDepacketizer::FileDepacketizer(const std::filesystem::path& file_path)
     : file_path_(file_path),
-      file_stream_(std::move(file_stream))
+      stream_buffer_(std::make_unique<char[]>(kFileStreamBufferSize)),
+      hash_(kFileHashType)
 {
-    // Nothing
+    // The buffer can be set only before the file is opened.
+    file_stream_.rdbuf()->pubsetbuf(stream_buffer_.get(), kFileStreamBufferSize);
 }
 
 FileDepacketizer::~FileDepacketizer()
@@ -37,6 +39,10 @@ FileDepacketizer::~FileDepacketizer()
     {
         file_stream_.close();
 
+        // The blocks received are kept. The next update of the file transfers only the rest.
+        if (update_in_place_)
+            return;
+
         // The transfer of files was canceled. Delete the file.
         std::error_code ignored_error;
         std::filesystem::remove(file_path_, ignored_error);
@@ -45,29 +51,87 @@ FileDepacketizer::~FileDepacketizer()
 
 // static
 std::unique_ptr<FileDepacketizer> FileDepacketizer::create(
-    const std::filesystem::path& file_path, bool overwrite)
+    const std::filesystem::path& file_path, bool overwrite, proto::FileBlockList* block_list)
+{
+    std::unique_ptr<FileDepacketizer> depacketizer(new FileDepacketizer(file_path));
+    if (!depacketizer->open(overwrite, block_list))
+        return nullptr;
+
+    return depacketizer;
+}
+
+bool FileDepacketizer::open(bool overwrite, proto::FileBlockList* block_list)
 {
+    if (block_list && overwrite)
+    {
+        std::error_code ignored_error;
+        if (std::filesystem::is_regular_file(file_path_, ignored_error) &&
+            readBlockList(block_list))
+        {
+            // The file is opened for writing without truncation.
+            file_stream_.open(file_path_,
+                              std::ofstream::binary | std::ofstream::in | std::ofstream::out);
+            if (file_stream_.is_open())
+            {
+                update_in_place_ = true;
+                block_list_ = *block_list;
+                return true;
+            }
+
+            block_list->Clear();
+        }
+    }
+
     std::ofstream::openmode mode = std::ofstream::binary;
 
     if (overwrite)
         mode |= std::ofstream::trunc;
 
-    std::ofstream file_stream;
+    file_stream_.open(file_path_, mode);
+    return file_stream_.is_open();
+}
+
+bool FileDepacketizer::readBlockList(proto::FileBlockList* block_list)
+{
+    std::ifstream file_stream;
 
-    file_stream.open(file_path, mode);
+    file_stream.open(file_path_, std::ifstream::binary);
     if (!file_stream.is_open())
-        return nullptr;
+        return false;
+
+    std::string block;
+    block.resize(kFileBlockSize);
 
-    return std::unique_ptr<FileDepacketizer>(
-        new FileDepacketizer(file_path, std::move(file_stream)));
+    block_list->set_block_size(static_cast<uint32_t>(kFileBlockSize));
+
+    while (file_stream)
+    {
+        file_stream.read(block.data(), block.size());
+
+        const size_t block_size = static_cast<size_t>(file_stream.gcount());
+        if (!block_size)
+            break;
+
+        block_list->add_hash(fileBlockHash(block.data(), block_size));
+    }
+
+    if (file_stream.bad())
+    {
+        LOG(LS_WARNING) << "Unable to read file";
+        block_list->Clear();
+        return false;
+    }
+
+    return true;
 }
 
 bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
 {
     DCHECK(file_stream_.is_open());
 
-    const size_t packet_size = packet.data().size();
-    if (!packet_size)
+    const bool skip_data = packet.flags() & proto::FilePacket::SKIP_DATA;
+
+    if (packet.data().empty() && !skip_data)
     {
         // If an empty data packet with the last packet flag set is received, the transfer
         // is canceled.
@@ -78,6 +142,40 @@ bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
         return false;
     }
 
+    const char* packet_data = packet.data().data();
+    size_t packet_size = packet.data().size();
+
+    if (skip_data)
+    {
+        if (!update_in_place_ || !packet.data().empty())
+        {
+            LOG(LS_WARNING) << "Unexpected skipped packet";
+            return false;
+        }
+
+        packet_data = nullptr;
+        packet_size = packet.data_size();
+    }
+    else if (packet.compression() == proto::FILE_COMPRESSION_ZSTD)
+    {
+        if (!decompressPacket(packet))
+            return false;
+
+        packet_data = buffer_.data();
+        packet_size = buffer_.size();
+    }
+    else if (packet.compression() != proto::FILE_COMPRESSION_NONE)
+    {
+        LOG(LS_WARNING) << "Unsupported compression: " << packet.compression();
+        return false;
+    }
+
+    if (packet_size > kMaxFilePacketSize)
+    {
+        LOG(LS_WARNING) << "Too large packet: " << packet_size;
+        return false;
+    }
+
     // The first packet must have the full file size.
     if (packet.flags() & proto::FilePacket::FIRST_PACKET)
     {
@@ -85,8 +183,37 @@ bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
         left_size_ = file_size_;
     }
 
-    file_stream_.seekp(file_size_ - left_size_);
-    file_stream_.write(packet.data().data(), packet_size);
+    if (packet_size > left_size_)
+    {
+        LOG(LS_WARNING) << "Packet is out of the file";
+        return false;
+    }
+
+    const uint64_t position = file_size_ - left_size_;
+
+    if (packet_data)
+    {
+        // The file is written sequentially. Seeking is not needed and would flush the stream
+        // buffer.
+        file_stream_.write(packet_data, packet_size);
+        hash_.addData(packet_data, packet_size);
+    }
+    else
+    {
+        const uint64_t block_index = position / kFileBlockSize;
+
+        if (position % kFileBlockSize != 0 ||
+            block_index >= static_cast<uint64_t>(block_list_.hash_size()))
+        {
+            LOG(LS_WARNING) << "Skipped packet is out of the blocks";
+            return false;
+        }
+
+        // The data is already in the file. The source hashes the block by its block hash.
+        hash_.addData(block_list_.hash(static_cast<int>(block_index)));
+        file_stream_.seekp(position + packet_size);
+    }
+
     if (file_stream_.fail())
     {
         LOG(LS_WARNING) << "Unable to write file";
@@ -97,10 +224,86 @@ bool FileDepacketizer::writeNextPacket(const proto::FilePacket& packet)
 
     if (packet.flags() & proto::FilePacket::LAST_PACKET)
     {
-        file_size_ = 0;
+        // The rest of the stream buffer is written when the file is closed.
         file_stream_.close();
+
+        // Older versions do not send the hash.
+        if (!packet.hash().empty() && packet.hash() != base::toStdString(hash_.result()))
+        {
+            LOG(LS_WARNING) << "Hash mismatch for file: " << file_path_.u8string();
+            hash_mismatch_ = true;
+        }
+
+        std::error_code error_code;
+
+        // The existing file may be larger than the new one.
+        if (!file_stream_.fail() && update_in_place_)
+            std::filesystem::resize_file(file_path_, file_size_, error_code);
+
+        file_size_ = 0;
+
+        if (file_stream_.fail() || error_code || hash_mismatch_)
+        {
+            if (!hash_mismatch_)
+                LOG(LS_WARNING) << "Unable to write file";
+
+            if (!update_in_place_)
+            {
+                std::error_code ignored_error;
+                std::filesystem::remove(file_path_, ignored_error);
+            }
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool FileDepacketizer::decompressPacket(const proto::FilePacket& packet)
+{
+    const size_t data_size = packet.data_size();
+    if (!data_size || data_size > kMaxFilePacketSize)
+    {
+        LOG(LS_WARNING) << "Wrong uncompressed packet size: " << data_size;
+        return false;
+    }
+
+    if (!stream_)
+    {
+        stream_.reset(ZSTD_createDStream());
+
+        size_t ret = ZSTD_initDStream(stream_.get());
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_initDStream failed: " << ZSTD_getErrorName(ret);
+            return false;
+        }
+    }
+
+    // One more byte in the buffer allows to detect packets which are larger than declared.
+    buffer_.resize(data_size + 1);
+
+    ZSTD_inBuffer input = { packet.data().data(), packet.data().size(), 0 };
+    ZSTD_outBuffer output = { buffer_.data(), buffer_.size(), 0 };
+
+    while (input.pos < input.size && output.pos < output.size)
+    {
+        size_t ret = ZSTD_decompressStream(stream_.get(), &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_decompressStream failed: " << ZSTD_getErrorName(ret);
+            return false;
+        }
+    }
+
+    if (input.pos != input.size || output.pos != data_size)
+    {
+        LOG(LS_WARNING) << "Wrong uncompressed packet size: " << output.pos
+                        << " (expected: " << data_size << ")";
+        return false;
     }
 
+    buffer_.resize(data_size);
     return true;
 }
 
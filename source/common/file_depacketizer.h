@@ -20,6 +20,8 @@
 #define COMMON__FILE_DEPACKETIZER_H
 
 #include "base/macros_magic.h"
+#include "base/codec/scoped_zstd_stream.h"
+#include "base/crypto/generic_hash.h"
 #include "proto/file_transfer.pb.h"
 
 #include <filesystem>
@@ -33,18 +35,45 @@ class FileDepacketizer
 public:
     ~FileDepacketizer();
 
+    // If |block_list| is not null, |overwrite| is true and the file exists, the file is updated
+    // in place: |block_list| receives the blocks of the existing file and the source can skip the
+    // blocks which are not changed. If such a transfer is interrupted, the file is not deleted, so
+    // the next update transfers only the rest of it.
     static std::unique_ptr<FileDepacketizer> create(const std::filesystem::path& file_path,
-                                                    bool overwrite);
+                                                    bool overwrite,
+                                                    proto::FileBlockList* block_list = nullptr);
 
     // Reads the packet and writes its contents to a file.
     bool writeNextPacket(const proto::FilePacket& packet);
 
+    // Returns true if writeNextPacket failed because the hash of the written data does not match
+    // the hash of the source file.
+    bool hashMismatch() const { return hash_mismatch_; }
+
 private:
-    FileDepacketizer(const std::filesystem::path& file_path, std::ofstream&& file_stream);
+    explicit FileDepacketizer(const std::filesystem::path& file_path);
+
+    bool open(bool overwrite, proto::FileBlockList* block_list);
+    bool readBlockList(proto::FileBlockList* block_list);
+    bool decompressPacket(const proto::FilePacket& packet);
 
     std::filesystem::path file_path_;
+
+    // The buffer must be destroyed after the stream.
+    std::unique_ptr<char[]> stream_buffer_;
     std::ofstream file_stream_;
 
+    base::ScopedZstdDStream stream_;
+    std::string buffer_;
+
+    bool update_in_place_ = false;
+
+    // Blocks of the existing file which is updated in place. The source may skip them.
+    proto::FileBlockList block_list_;
+
+    base::GenericHash hash_;
+    bool hash_mismatch_ = false;
+
     uint64_t file_size_ = 0;
     uint64_t left_size_ = 0;
 
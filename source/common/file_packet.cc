@@ -0,0 +1,31 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "common/file_packet.h"
+
+#include "base/crypto/generic_hash.h"
+
+namespace common {
+
+std::string fileBlockHash(const char* data, size_t size)
+{
+    return base::toStdString(
+        base::GenericHash::hash(base::GenericHash::Type::BLAKE2s256, data, size));
+}
+
+} // namespace common
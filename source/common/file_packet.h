@@ -19,11 +19,32 @@
 #ifndef COMMON__FILE_PACKET_H
 #define COMMON__FILE_PACKET_H
 
+#include "base/crypto/generic_hash.h"
+
+#include <string>
+
 namespace common {
 
 // When transferring a file is divided into parts and each part is transmitted separately.
-// This parameter specifies the size of the part.
-static const size_t kMaxFilePacketSize = 16 * 1024; // 16 kB
+// This parameter specifies the size of the part if the request does not specify it (older
+// versions always use this size).
+static const size_t kDefaultFilePacketSize = 16 * 1024; // 16 kB
+
+// Maximum size of the part which can be requested.
+static const size_t kMaxFilePacketSize = 1024 * 1024; // 1 MB
+
+// Size of the buffer of file streams. Files are read ahead and written behind in blocks of this
+// size, so small packets do not result in small disk operations.
+static const size_t kFileStreamBufferSize = 1024 * 1024; // 1 MB
+
+// When an existing file is updated, it is compared with the source in blocks of this size.
+static const size_t kFileBlockSize = kMaxFilePacketSize;
+
+// Returns the hash of the block of the file.
+std::string fileBlockHash(const char* data, size_t size);
+
+// Hash of the file contents which is computed while the file is transferred.
+static const base::GenericHash::Type kFileHashType = base::GenericHash::BLAKE2b512;
 
 } // namespace common
 
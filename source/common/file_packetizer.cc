@@ -21,10 +21,52 @@
 #include "base/logging.h"
 #include "common/file_packet.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace common {
 
 namespace {
 
+// The compression ratio can be in the range of 1 to 22. Low values are used so that compression
+// does not become a bottleneck on fast links.
+const int kCompressionRatio = 3;
+
+// Smaller data will not be compressed.
+const size_t kMinSizeToCompress = 512;
+
+// The entropy is estimated from the beginning of the packet.
+const size_t kEntropySampleSize = 4096;
+
+// Data with a higher entropy (in bits per byte) is considered already compressed (archives,
+// media files and so on) and is sent as is.
+const double kMaxEntropyToCompress = 7.5;
+
+bool isCompressible(const std::string& data)
+{
+    if (data.size() < kMinSizeToCompress)
+        return false;
+
+    const size_t sample_size = std::min(data.size(), kEntropySampleSize);
+    uint32_t histogram[256] = { 0 };
+
+    for (size_t i = 0; i < sample_size; ++i)
+        ++histogram[static_cast<uint8_t>(data[i])];
+
+    double entropy = 0;
+
+    for (size_t i = 0; i < std::size(histogram); ++i)
+    {
+        if (!histogram[i])
+            continue;
+
+        const double probability = static_cast<double>(histogram[i]) / sample_size;
+        entropy -= probability * std::log2(probability);
+    }
+
+    return entropy < kMaxEntropyToCompress;
+}
+
 char* outputBuffer(proto::FilePacket* packet, size_t size)
 {
     packet->mutable_data()->resize(size);
@@ -33,24 +75,34 @@ char* outputBuffer(proto::FilePacket* packet, size_t size)
 
 } // namespace
 
-FilePacketizer::FilePacketizer(std::ifstream&& file_stream)
-    : file_stream_(std::move(file_stream))
+FilePacketizer::FilePacketizer()
+    : stream_buffer_(std::make_unique<char[]>(kFileStreamBufferSize)),
+      hash_(kFileHashType)
 {
-    file_stream_.seekg(0, file_stream_.end);
-    file_size_ = file_stream_.tellg();
-    file_stream_.seekg(0);
-    left_size_ = file_size_;
+    // The buffer can be set only before the file is opened.
+    file_stream_.rdbuf()->pubsetbuf(stream_buffer_.get(), kFileStreamBufferSize);
 }
 
 std::unique_ptr<FilePacketizer> FilePacketizer::create(const std::filesystem::path& file_path)
 {
-    std::ifstream file_stream;
-
-    file_stream.open(file_path, std::ifstream::binary);
-    if (!file_stream.is_open())
+    std::unique_ptr<FilePacketizer> packetizer(new FilePacketizer());
+    if (!packetizer->open(file_path))
         return nullptr;
 
-    return std::unique_ptr<FilePacketizer>(new FilePacketizer(std::move(file_stream)));
+    return packetizer;
+}
+
+bool FilePacketizer::open(const std::filesystem::path& file_path)
+{
+    file_stream_.open(file_path, std::ifstream::binary);
+    if (!file_stream_.is_open())
+        return false;
+
+    file_stream_.seekg(0, file_stream_.end);
+    file_size_ = file_stream_.tellg();
+    file_stream_.seekg(0);
+    left_size_ = file_size_;
+    return true;
 }
 
 std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
@@ -67,16 +119,42 @@ std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
         return packet;
     }
 
-    size_t packet_buffer_size = kMaxFilePacketSize;
+    if (request.has_target_block_list())
+    {
+        if (request.target_block_list().block_size() == kFileBlockSize)
+        {
+            target_block_list_ = request.target_block_list();
+        }
+        else
+        {
+            LOG(LS_WARNING) << "Unsupported block size: "
+                            << request.target_block_list().block_size();
+        }
+    }
+
+    size_t packet_buffer_size = kDefaultFilePacketSize;
+
+    if (request.packet_size())
+    {
+        packet_buffer_size = std::clamp(static_cast<size_t>(request.packet_size()),
+                                        kDefaultFilePacketSize, kMaxFilePacketSize);
+    }
+
+    // If the target has a block at the current position, the packet contains the whole block.
+    const uint64_t position = file_size_ - left_size_;
+    const bool compare_block = position % kFileBlockSize == 0 &&
+        position / kFileBlockSize < static_cast<uint64_t>(target_block_list_.hash_size());
 
-    if (left_size_ < kMaxFilePacketSize)
+    if (compare_block)
+        packet_buffer_size = kFileBlockSize;
+
+    if (left_size_ < packet_buffer_size)
         packet_buffer_size = static_cast<size_t>(left_size_);
 
     char* packet_buffer = outputBuffer(packet.get(), packet_buffer_size);
 
-    // Moving to a new position in file.
-    file_stream_.seekg(file_size_ - left_size_);
-
+    // The file is read sequentially. Seeking is not needed and would discard the data read
+    // ahead in the stream buffer.
     file_stream_.read(packet_buffer, packet_buffer_size);
     if (file_stream_.fail())
     {
@@ -84,6 +162,33 @@ std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
         return nullptr;
     }
 
+    std::string block_hash;
+
+    if (compare_block)
+        block_hash = fileBlockHash(packet->data().data(), packet->data().size());
+
+    if (compare_block &&
+        block_hash == target_block_list_.hash(static_cast<int>(position / kFileBlockSize)))
+    {
+        // The target does not have the data of the block, but it has the same block hash.
+        hash_.addData(block_hash);
+
+        packet->clear_data();
+        packet->set_flags(proto::FilePacket::SKIP_DATA);
+        packet->set_data_size(static_cast<uint32_t>(packet_buffer_size));
+    }
+    else
+    {
+        hash_.addData(packet->data());
+
+        if (request.compression() == proto::FILE_COMPRESSION_ZSTD &&
+            isCompressible(packet->data()))
+        {
+            if (!compressPacket(packet.get()))
+                return nullptr;
+        }
+    }
+
     if (left_size_ == file_size_)
     {
         packet->set_flags(packet->flags() | proto::FilePacket::FIRST_PACKET);
@@ -100,9 +205,70 @@ std::unique_ptr<proto::FilePacket> FilePacketizer::readNextPacket(
         file_stream_.close();
 
         packet->set_flags(packet->flags() | proto::FilePacket::LAST_PACKET);
+        packet->set_hash(base::toStdString(hash_.result()));
     }
 
     return packet;
 }
 
+bool FilePacketizer::compressPacket(proto::FilePacket* packet)
+{
+    if (!stream_)
+    {
+        stream_.reset(ZSTD_createCStream());
+
+        size_t ret = ZSTD_initCStream(stream_.get(), kCompressionRatio);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_initCStream failed: " << ZSTD_getErrorName(ret);
+            return false;
+        }
+    }
+
+    const std::string& data = packet->data();
+
+    buffer_.resize(ZSTD_compressBound(data.size()));
+
+    ZSTD_inBuffer input = { data.data(), data.size(), 0 };
+    ZSTD_outBuffer output = { buffer_.data(), buffer_.size(), 0 };
+
+    while (input.pos < input.size)
+    {
+        size_t ret = ZSTD_compressStream(stream_.get(), &output, &input);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_compressStream failed: " << ZSTD_getErrorName(ret);
+            return false;
+        }
+    }
+
+    // The target must be able to decompress the packet without waiting for the next one.
+    size_t ret;
+
+    do
+    {
+        if (output.pos == output.size)
+        {
+            buffer_.resize(buffer_.size() + ZSTD_CStreamOutSize());
+            output.dst = buffer_.data();
+            output.size = buffer_.size();
+        }
+
+        ret = ZSTD_flushStream(stream_.get(), &output);
+        if (ZSTD_isError(ret))
+        {
+            LOG(LS_ERROR) << "ZSTD_flushStream failed: " << ZSTD_getErrorName(ret);
+            return false;
+        }
+    }
+    while (ret != 0);
+
+    buffer_.resize(output.pos);
+
+    packet->set_compression(proto::FILE_COMPRESSION_ZSTD);
+    packet->set_data_size(static_cast<uint32_t>(data.size()));
+    packet->mutable_data()->swap(buffer_);
+    return true;
+}
+
 } // namespace common
@@ -20,6 +20,8 @@
 #define COMMON__FILE_PACKETIZER_H
 
 #include "base/macros_magic.h"
+#include "base/codec/scoped_zstd_stream.h"
+#include "base/crypto/generic_hash.h"
 #include "proto/file_transfer.pb.h"
 
 #include <filesystem>
@@ -42,10 +44,23 @@ public:
     std::unique_ptr<proto::FilePacket> readNextPacket(const proto::FilePacketRequest& request);
 
 private:
-    explicit FilePacketizer(std::ifstream&& file_stream);
+    FilePacketizer();
 
+    bool open(const std::filesystem::path& file_path);
+    bool compressPacket(proto::FilePacket* packet);
+
+    // The buffer must be destroyed after the stream.
+    std::unique_ptr<char[]> stream_buffer_;
     std::ifstream file_stream_;
 
+    base::ScopedZstdCStream stream_;
+    std::string buffer_;
+
+    // Blocks of the existing target file. The blocks which are equal are not sent.
+    proto::FileBlockList target_block_list_;
+
+    base::GenericHash hash_;
+
     uint64_t file_size_ = 0;
     uint64_t left_size_ = 0;
 
@@ -0,0 +1,381 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "common/file_packetizer.h"
+
+#include "base/files/file_util.h"
+#include "common/file_depacketizer.h"
+#include "common/file_packet.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace common {
+
+namespace {
+
+class FilePacketizerTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory_ = std::filesystem::temp_directory_path();
+        directory_.append("test_file_packetizer");
+
+        std::error_code ignored_error;
+        std::filesystem::remove_all(directory_, ignored_error);
+        ASSERT_TRUE(std::filesystem::create_directories(directory_));
+
+        source_path_ = directory_;
+        source_path_.append("source.bin");
+
+        target_path_ = directory_;
+        target_path_.append("target.bin");
+    }
+
+    void TearDown() override
+    {
+        std::error_code ignored_error;
+        std::filesystem::remove_all(directory_, ignored_error);
+    }
+
+    // Transfers the source file to the target file and returns the packets which were sent.
+    // If |update| is true, the existing target file is updated in place.
+    std::vector<proto::FilePacket> transfer(proto::FileCompression compression,
+                                            bool update = false)
+    {
+        std::vector<proto::FilePacket> packets;
+
+        std::unique_ptr<FilePacketizer> packetizer = FilePacketizer::create(source_path_);
+        EXPECT_TRUE(packetizer);
+
+        proto::FileBlockList block_list;
+
+        std::unique_ptr<FileDepacketizer> depacketizer =
+            FileDepacketizer::create(target_path_, true, update ? &block_list : nullptr);
+        EXPECT_TRUE(depacketizer);
+
+        if (!packetizer || !depacketizer)
+            return packets;
+
+        proto::FilePacketRequest request;
+        request.set_compression(compression);
+
+        // The block list is sent only in the first request.
+        if (block_list.hash_size())
+            *request.mutable_target_block_list() = block_list;
+
+        while (true)
+        {
+            std::unique_ptr<proto::FilePacket> packet = packetizer->readNextPacket(request);
+            request.clear_target_block_list();
+            EXPECT_TRUE(packet);
+            if (!packet)
+                break;
+
+            EXPECT_TRUE(depacketizer->writeNextPacket(*packet));
+            EXPECT_FALSE(depacketizer->hashMismatch());
+
+            packets.emplace_back(std::move(*packet));
+
+            if (packets.back().flags() & proto::FilePacket::LAST_PACKET)
+                break;
+        }
+
+        return packets;
+    }
+
+    void writeSource(const std::string& data)
+    {
+        ASSERT_TRUE(base::writeFile(source_path_, data));
+    }
+
+    void writeTarget(const std::string& data)
+    {
+        ASSERT_TRUE(base::writeFile(target_path_, data));
+    }
+
+    std::string readTarget()
+    {
+        std::string data;
+        EXPECT_TRUE(base::readFile(target_path_, &data));
+        return data;
+    }
+
+    std::filesystem::path directory_;
+    std::filesystem::path source_path_;
+    std::filesystem::path target_path_;
+};
+
+std::string compressibleData(size_t size)
+{
+    static const char kText[] = "The quick brown fox jumps over the lazy dog. ";
+
+    std::string data;
+    data.reserve(size + sizeof(kText));
+
+    for (size_t i = 0; data.size() < size; ++i)
+    {
+        data += kText;
+        data += std::to_string(i);
+    }
+
+    data.resize(size);
+    return data;
+}
+
+std::string randomData(size_t size)
+{
+    std::mt19937 random(size);
+    std::uniform_int_distribution<int> distribution(0, 255);
+
+    std::string data;
+    data.resize(size);
+
+    for (size_t i = 0; i < size; ++i)
+        data[i] = static_cast<char>(distribution(random));
+
+    return data;
+}
+
+// Returns the number of packets which were skipped because the target has the same data.
+size_t skippedCount(const std::vector<proto::FilePacket>& packets)
+{
+    size_t count = 0;
+
+    for (const auto& packet : packets)
+    {
+        if (packet.flags() & proto::FilePacket::SKIP_DATA)
+            ++count;
+    }
+
+    return count;
+}
+
+// Returns the size of the data of the packet before compression.
+size_t dataSize(const proto::FilePacket& packet)
+{
+    if (packet.compression() == proto::FILE_COMPRESSION_ZSTD ||
+        (packet.flags() & proto::FilePacket::SKIP_DATA))
+    {
+        return packet.data_size();
+    }
+
+    return packet.data().size();
+}
+
+} // namespace
+
+TEST_F(FilePacketizerTest, CompressedRoundTrip)
+{
+    const std::string data = compressibleData(3 * kDefaultFilePacketSize + 4096);
+    writeSource(data);
+
+    std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_ZSTD);
+    ASSERT_EQ(packets.size(), 4u);
+
+    for (const auto& packet : packets)
+    {
+        // Each packet is decompressed by the target without waiting for the next one.
+        EXPECT_EQ(packet.compression(), proto::FILE_COMPRESSION_ZSTD);
+        EXPECT_LT(packet.data().size(), packet.data_size() / 2);
+    }
+
+    EXPECT_EQ(readTarget(), data);
+}
+
+TEST_F(FilePacketizerTest, IncompressibleData)
+{
+    const std::string data = randomData(2 * kDefaultFilePacketSize + 1000);
+    writeSource(data);
+
+    std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_ZSTD);
+    ASSERT_EQ(packets.size(), 3u);
+
+    // Random data is sent as is.
+    for (const auto& packet : packets)
+        EXPECT_EQ(packet.compression(), proto::FILE_COMPRESSION_NONE);
+
+    EXPECT_EQ(readTarget(), data);
+}
+
+TEST_F(FilePacketizerTest, PacketBoundaries)
+{
+    static const size_t kSizes[] =
+    {
+        1, 511, 512, 513,
+        kDefaultFilePacketSize - 1,
+        kDefaultFilePacketSize,
+        kDefaultFilePacketSize + 1,
+        kDefaultFilePacketSize + 511,
+        kDefaultFilePacketSize + 512,
+        2 * kDefaultFilePacketSize
+    };
+
+    for (size_t size : kSizes)
+    {
+        SCOPED_TRACE(size);
+
+        const std::string data = compressibleData(size);
+        writeSource(data);
+
+        std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_ZSTD);
+        ASSERT_EQ(packets.size(), (size + kDefaultFilePacketSize - 1) / kDefaultFilePacketSize);
+
+        size_t total_size = 0;
+
+        for (const auto& packet : packets)
+        {
+            // Packets smaller than 512 bytes are not compressed.
+            const proto::FileCompression expected = dataSize(packet) < 512 ?
+                proto::FILE_COMPRESSION_NONE : proto::FILE_COMPRESSION_ZSTD;
+
+            EXPECT_EQ(packet.compression(), expected);
+            EXPECT_LE(dataSize(packet), kDefaultFilePacketSize);
+            total_size += dataSize(packet);
+        }
+
+        EXPECT_EQ(total_size, size);
+        EXPECT_EQ(readTarget(), data);
+    }
+}
+
+TEST_F(FilePacketizerTest, PeerWithoutCompression)
+{
+    const std::string data = compressibleData(2 * kDefaultFilePacketSize + 1000);
+    writeSource(data);
+
+    // Older versions do not set the compression in the request.
+    std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_NONE);
+    ASSERT_EQ(packets.size(), 3u);
+
+    for (const auto& packet : packets)
+    {
+        EXPECT_EQ(packet.compression(), proto::FILE_COMPRESSION_NONE);
+        EXPECT_EQ(packet.data_size(), 0u);
+    }
+
+    EXPECT_EQ(readTarget(), data);
+}
+
+TEST_F(FilePacketizerTest, UnsupportedCompression)
+{
+    writeSource(compressibleData(1000));
+
+    std::unique_ptr<FilePacketizer> packetizer = FilePacketizer::create(source_path_);
+    ASSERT_TRUE(packetizer);
+
+    std::unique_ptr<proto::FilePacket> packet =
+        packetizer->readNextPacket(proto::FilePacketRequest());
+    ASSERT_TRUE(packet);
+
+    // A target which does not know the compression rejects the packet and the file is removed.
+    packet->set_compression(static_cast<proto::FileCompression>(100));
+
+    std::unique_ptr<FileDepacketizer> depacketizer = FileDepacketizer::create(target_path_, true);
+    ASSERT_TRUE(depacketizer);
+    EXPECT_FALSE(depacketizer->writeNextPacket(*packet));
+
+    depacketizer.reset();
+    EXPECT_FALSE(std::filesystem::exists(target_path_));
+}
+
+TEST_F(FilePacketizerTest, UpdateIdenticalFile)
+{
+    const std::string data = randomData(3 * kFileBlockSize + kFileBlockSize / 2);
+    writeSource(data);
+    writeTarget(data);
+
+    // No data is sent.
+    std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_ZSTD, true);
+    ASSERT_EQ(packets.size(), 4u);
+    EXPECT_EQ(skippedCount(packets), 4u);
+
+    for (const auto& packet : packets)
+        EXPECT_TRUE(packet.data().empty());
+
+    EXPECT_EQ(readTarget(), data);
+}
+
+TEST_F(FilePacketizerTest, UpdateAppendedFile)
+{
+    const std::string old_data = randomData(2 * kFileBlockSize + kFileBlockSize / 2);
+    writeTarget(old_data);
+
+    const std::string data = old_data + randomData(kFileBlockSize + 1000);
+    writeSource(data);
+
+    // The last block of the old file is not complete, so it is sent with the appended data.
+    std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_ZSTD, true);
+    EXPECT_EQ(skippedCount(packets), 2u);
+    EXPECT_TRUE(packets[0].flags() & proto::FilePacket::SKIP_DATA);
+    EXPECT_TRUE(packets[1].flags() & proto::FilePacket::SKIP_DATA);
+    EXPECT_EQ(dataSize(packets[2]), kFileBlockSize);
+
+    EXPECT_EQ(readTarget(), data);
+}
+
+TEST_F(FilePacketizerTest, UpdateFileWithInsertedData)
+{
+    const std::string old_data = randomData(3 * kFileBlockSize);
+    writeTarget(old_data);
+
+    std::string data = old_data;
+    data.insert(kFileBlockSize + kFileBlockSize / 2, randomData(100));
+    writeSource(data);
+
+    // Blocks are compared at the same offsets, so everything after the inserted data is sent.
+    std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_ZSTD, true);
+    EXPECT_EQ(skippedCount(packets), 1u);
+    EXPECT_TRUE(packets[0].flags() & proto::FilePacket::SKIP_DATA);
+
+    EXPECT_EQ(readTarget(), data);
+}
+
+TEST_F(FilePacketizerTest, UpdateTruncatedFile)
+{
+    const std::string old_data = randomData(3 * kFileBlockSize + kFileBlockSize / 2);
+    writeTarget(old_data);
+
+    const std::string data = old_data.substr(0, 2 * kFileBlockSize + 1000);
+    writeSource(data);
+
+    // The rest of the old file is removed.
+    std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_ZSTD, true);
+    ASSERT_EQ(packets.size(), 3u);
+    EXPECT_EQ(skippedCount(packets), 2u);
+    EXPECT_EQ(dataSize(packets[2]), 1000u);
+
+    EXPECT_EQ(readTarget(), data);
+}
+
+TEST_F(FilePacketizerTest, UpdateMissingFile)
+{
+    const std::string data = randomData(kFileBlockSize + 1000);
+    writeSource(data);
+
+    // If the target file does not exist, it is transferred as usual.
+    std::vector<proto::FilePacket> packets = transfer(proto::FILE_COMPRESSION_ZSTD, true);
+    EXPECT_EQ(skippedCount(packets), 0u);
+
+    EXPECT_EQ(readTarget(), data);
+}
+
+} // namespace common
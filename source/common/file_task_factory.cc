@@ -41,10 +41,16 @@ std::shared_ptr<FileTask> FileTaskFactory::driveList()
     return makeTask(std::move(request));
 }
 
-std::shared_ptr<FileTask> FileTaskFactory::fileList(const std::string& path)
+std::shared_ptr<FileTask> FileTaskFactory::fileList(
+    const std::string& path, uint32_t page_size, bool next_page)
 {
     auto request = std::make_unique<proto::FileRequest>();
-    request->mutable_file_list_request()->set_path(path);
+
+    proto::FileListRequest* file_list_request = request->mutable_file_list_request();
+    file_list_request->set_path(path);
+    file_list_request->set_page_size(page_size);
+    file_list_request->set_next_page(next_page);
+
     return makeTask(std::move(request));
 }
 
@@ -81,21 +87,33 @@ std::shared_ptr<FileTask> FileTaskFactory::download(const std::string& file_path
     return makeTask(std::move(request));
 }
 
-std::shared_ptr<FileTask> FileTaskFactory::upload(const std::string& file_path, bool overwrite)
+std::shared_ptr<FileTask> FileTaskFactory::upload(
+    const std::string& file_path, bool overwrite, bool delta)
 {
     auto request = std::make_unique<proto::FileRequest>();
 
     proto::UploadRequest* upload_request = request->mutable_upload_request();
     upload_request->set_path(file_path);
     upload_request->set_overwrite(overwrite);
+    upload_request->set_delta(delta);
 
     return makeTask(std::move(request));
 }
 
-std::shared_ptr<FileTask> FileTaskFactory::packetRequest(uint32_t flags)
+std::shared_ptr<FileTask> FileTaskFactory::packetRequest(
+    uint32_t flags, uint32_t packet_size, proto::FileCompression compression)
 {
     auto request = std::make_unique<proto::FileRequest>();
     request->mutable_packet_request()->set_flags(flags);
+    request->mutable_packet_request()->set_packet_size(packet_size);
+    request->mutable_packet_request()->set_compression(compression);
+    return makeTask(std::move(request));
+}
+
+std::shared_ptr<FileTask> FileTaskFactory::packetRequest(proto::FilePacketRequest&& packet_request)
+{
+    auto request = std::make_unique<proto::FileRequest>();
+    *request->mutable_packet_request() = std::move(packet_request);
     return makeTask(std::move(request));
 }
 
@@ -20,13 +20,10 @@
 #define CLIENT__FILE_TASK_FACTORY_H
 
 #include "common/file_task.h"
+#include "proto/file_transfer.pb.h"
 
 #include <string>
 
-namespace proto {
-class FilePacket;
-} // namespace proto
-
 namespace common {
 
 class FileTaskFactory
@@ -38,13 +35,20 @@ public:
     FileTask::Target target() const { return target_; }
 
     std::shared_ptr<FileTask> driveList();
-    std::shared_ptr<FileTask> fileList(const std::string& path);
+    std::shared_ptr<FileTask> fileList(const std::string& path,
+                                       uint32_t page_size = 0,
+                                       bool next_page = false);
     std::shared_ptr<FileTask> createDirectory(const std::string& path);
     std::shared_ptr<FileTask> rename(const std::string& old_name, const std::string& new_name);
     std::shared_ptr<FileTask> remove(const std::string& path);
     std::shared_ptr<FileTask> download(const std::string& file_path);
-    std::shared_ptr<FileTask> upload(const std::string& file_path, bool overwrite);
-    std::shared_ptr<FileTask> packetRequest(uint32_t flags);
+    std::shared_ptr<FileTask> upload(const std::string& file_path, bool overwrite,
+                                     bool delta = false);
+    std::shared_ptr<FileTask> packetRequest(
+        uint32_t flags,
+        uint32_t packet_size = 0,
+        proto::FileCompression compression = proto::FILE_COMPRESSION_NONE);
+    std::shared_ptr<FileTask> packetRequest(proto::FilePacketRequest&& packet_request);
     std::shared_ptr<FileTask> packet(const proto::FilePacket& packet);
     std::shared_ptr<FileTask> packet(std::unique_ptr<proto::FilePacket> packet);
 
@@ -21,6 +21,7 @@
 #include "base/logging.h"
 #include "base/task_runner.h"
 #include "base/files/base_paths.h"
+#include "base/threading/thread.h"
 #include "build/build_config.h"
 #include "common/file_depacketizer.h"
 #include "common/file_packetizer.h"
@@ -34,6 +35,33 @@
 
 namespace common {
 
+namespace {
+
+// Requests of one lane are executed in order on one I/O thread. The state of a transfer
+// (packetizer and depacketizer) and of a paged listing (enumerator) is used by one lane only.
+enum Lane
+{
+    LANE_LIST,     // Drive and file lists.
+    LANE_TRANSFER, // Directories and files of a transfer.
+    LANE_REMOVE,   // Removing and renaming.
+    LANE_COUNT
+};
+
+Lane requestLane(const proto::FileRequest& request)
+{
+    if (request.has_drive_list_request() || request.has_file_list_request())
+        return LANE_LIST;
+
+    if (request.has_remove_request() || request.has_rename_request())
+        return LANE_REMOVE;
+
+    // A transfer creates the directories before it uploads the files into them, so these requests
+    // stay in the same order.
+    return LANE_TRANSFER;
+}
+
+} // namespace
+
 class FileWorker::Impl : public std::enable_shared_from_this<Impl>
 {
 public:
@@ -42,12 +70,23 @@ public:
 
     void doTask(std::shared_ptr<FileTask> task);
 
+    // Executes the request on |io_task_runner| and delivers the reply on the task runner of the
+    // worker.
+    void doTask(std::shared_ptr<FileTask> task, std::shared_ptr<base::TaskRunner> io_task_runner);
+
     std::shared_ptr<base::TaskRunner> taskRunner() { return task_runner_; }
 
 private:
     std::unique_ptr<proto::FileReply> doRequest(const proto::FileRequest& request);
     std::unique_ptr<proto::FileReply> doDriveListRequest();
     std::unique_ptr<proto::FileReply> doFileListRequest(const proto::FileListRequest& request);
+    std::unique_ptr<proto::FileReply> doFileListPage(
+        uint32_t page_size, std::unique_ptr<proto::FileReply> reply);
+
+    // Adds up to |page_size| items (all items if zero) to the reply. Returns true if the
+    // directory has more items.
+    static bool readFileList(
+        FileEnumerator* enumerator, uint32_t page_size, proto::FileReply* reply);
     std::unique_ptr<proto::FileReply> doCreateDirectoryRequest(const proto::CreateDirectoryRequest& request);
     std::unique_ptr<proto::FileReply> doRenameRequest(const proto::RenameRequest& request);
     std::unique_ptr<proto::FileReply> doRemoveRequest(const proto::RemoveRequest& request);
@@ -60,6 +99,10 @@ private:
     std::unique_ptr<FileDepacketizer> depacketizer_;
     std::unique_ptr<FilePacketizer> packetizer_;
 
+    // Enumerator of the directory which is sent by pages.
+    std::unique_ptr<FileEnumerator> enumerator_;
+    std::string enumerator_path_;
+
     DISALLOW_COPY_AND_ASSIGN(Impl);
 };
 
@@ -80,6 +123,22 @@ void FileWorker::Impl::doTask(std::shared_ptr<FileTask> task)
     });
 }
 
+void FileWorker::Impl::doTask(
+    std::shared_ptr<FileTask> task, std::shared_ptr<base::TaskRunner> io_task_runner)
+{
+    auto self = shared_from_this();
+    io_task_runner->postTask([self, task]()
+    {
+        std::shared_ptr<proto::FileReply> reply = self->doRequest(task->request());
+
+        // File operations do not delay the input and video handled on the same thread.
+        self->task_runner_->postPriorityTask([task, reply]()
+        {
+            task->setReply(std::make_unique<proto::FileReply>(std::move(*reply)));
+        }, base::TaskRunner::Priority::LOW);
+    });
+}
+
 std::unique_ptr<proto::FileReply> FileWorker::Impl::doRequest(const proto::FileRequest& request)
 {
 #if defined(OS_WIN)
@@ -222,6 +281,19 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doFileListRequest(
 {
     std::unique_ptr<proto::FileReply> reply = std::make_unique<proto::FileReply>();
 
+    if (request.next_page())
+    {
+        // If another directory has been requested since the previous page, the list ends.
+        if (!enumerator_ || enumerator_path_ != request.path())
+        {
+            reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+            reply->mutable_file_list();
+            return reply;
+        }
+
+        return doFileListPage(request.page_size(), std::move(reply));
+    }
+
     std::filesystem::path path = std::filesystem::u8path(request.path());
 
     std::error_code ignored_code;
@@ -239,12 +311,51 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doFileListRequest(
         return reply;
     }
 
+    if (!request.page_size())
+    {
+        // The whole list is sent at once.
+        FileEnumerator enumerator(path);
+        readFileList(&enumerator, 0, reply.get());
+        return reply;
+    }
+
+    // A new paged request cancels the previous one.
+    enumerator_ = std::make_unique<FileEnumerator>(path);
+    enumerator_path_ = request.path();
+
+    return doFileListPage(request.page_size(), std::move(reply));
+}
+
+std::unique_ptr<proto::FileReply> FileWorker::Impl::doFileListPage(
+    uint32_t page_size, std::unique_ptr<proto::FileReply> reply)
+{
+    DCHECK(enumerator_);
+
+    // The enumerator is kept until the next page is requested.
+    if (!readFileList(enumerator_.get(), page_size, reply.get()))
+    {
+        enumerator_.reset();
+        enumerator_path_.clear();
+    }
+
+    return reply;
+}
+
+// static
+bool FileWorker::Impl::readFileList(
+    FileEnumerator* enumerator, uint32_t page_size, proto::FileReply* reply)
+{
     proto::FileList* file_list = reply->mutable_file_list();
-    FileEnumerator enumerator(path);
 
-    while (!enumerator.isAtEnd())
+    while (!enumerator->isAtEnd())
     {
-        const FileEnumerator::FileInfo& file_info = enumerator.fileInfo();
+        if (page_size && static_cast<uint32_t>(file_list->item_size()) >= page_size)
+        {
+            file_list->set_has_more(true);
+            break;
+        }
+
+        const FileEnumerator::FileInfo& file_info = enumerator->fileInfo();
 
         proto::FileList::Item* item = file_list->add_item();
         item->set_name(file_info.u8name());
@@ -252,11 +363,11 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doFileListRequest(
         item->set_modification_time(file_info.lastWriteTime());
         item->set_is_directory(file_info.isDirectory());
 
-        enumerator.advance();
+        enumerator->advance();
     }
 
-    reply->set_error_code(enumerator.errorCode());
-    return reply;
+    reply->set_error_code(enumerator->errorCode());
+    return file_list->has_more();
 }
 
 std::unique_ptr<proto::FileReply> FileWorker::Impl::doCreateDirectoryRequest(
@@ -401,7 +512,11 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doUploadRequest(
             }
         }
 
-        depacketizer_ = FileDepacketizer::create(file_path, request.overwrite());
+        proto::FileBlockList* block_list = nullptr;
+        if (request.delta())
+            block_list = reply->mutable_block_list();
+
+        depacketizer_ = FileDepacketizer::create(file_path, request.overwrite(), block_list);
         if (!depacketizer_)
         {
             reply->set_error_code(proto::FILE_ERROR_FILE_CREATE_ERROR);
@@ -409,6 +524,7 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doUploadRequest(
         }
 
         reply->set_error_code(proto::FILE_ERROR_SUCCESS);
+        reply->set_compression(proto::FILE_COMPRESSION_ZSTD);
     }
     while (false);
 
@@ -461,7 +577,8 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doPacket(const proto::FilePa
     {
         if (!depacketizer_->writeNextPacket(packet))
         {
-            reply->set_error_code(proto::FILE_ERROR_FILE_WRITE_ERROR);
+            reply->set_error_code(depacketizer_->hashMismatch() ?
+                proto::FILE_ERROR_HASH_MISMATCH : proto::FILE_ERROR_FILE_WRITE_ERROR);
             depacketizer_.reset();
         }
         else
@@ -476,17 +593,39 @@ std::unique_ptr<proto::FileReply> FileWorker::Impl::doPacket(const proto::FilePa
     return reply;
 }
 
-FileWorker::FileWorker(std::shared_ptr<base::TaskRunner> task_runner)
+FileWorker::FileWorker(std::shared_ptr<base::TaskRunner> task_runner, ThreadMode thread_mode)
     : impl_(std::make_shared<Impl>(std::move(task_runner)))
 {
-    // Nothing
+    if (thread_mode == ThreadMode::IO_THREADS)
+    {
+        for (int i = 0; i < LANE_COUNT; ++i)
+        {
+            std::unique_ptr<base::Thread> thread = std::make_unique<base::Thread>();
+            thread->start(base::MessageLoop::Type::DEFAULT);
+            io_threads_.emplace_back(std::move(thread));
+        }
+    }
 }
 
-FileWorker::~FileWorker() = default;
+FileWorker::~FileWorker()
+{
+    // The threads complete the current requests before they stop.
+    for (auto& thread : io_threads_)
+        thread->stop();
+}
 
 void FileWorker::doTask(std::shared_ptr<FileTask> task)
 {
-    impl_->doTask(std::move(task));
+    if (io_threads_.empty())
+    {
+        impl_->doTask(std::move(task));
+        return;
+    }
+
+    std::shared_ptr<base::TaskRunner> io_task_runner =
+        io_threads_[requestLane(task->request())]->taskRunner();
+
+    impl_->doTask(std::move(task), std::move(io_task_runner));
 }
 
 std::shared_ptr<base::TaskRunner> FileWorker::taskRunner()
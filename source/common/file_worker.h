@@ -22,9 +22,11 @@
 #include "base/macros_magic.h"
 
 #include <memory>
+#include <vector>
 
 namespace base {
 class TaskRunner;
+class Thread;
 } // namespace base
 
 namespace common {
@@ -34,7 +36,19 @@ class FileTask;
 class FileWorker
 {
 public:
-    explicit FileWorker(std::shared_ptr<base::TaskRunner> task_runner);
+    enum class ThreadMode
+    {
+        // All requests are executed on the task runner of the worker.
+        SINGLE_THREAD,
+
+        // Requests are executed on separate I/O threads and the replies are delivered on the task
+        // runner of the worker. Requests of one kind (for example, the requests of a transfer) are
+        // executed in order. Listings, removals and transfers are executed in parallel.
+        IO_THREADS
+    };
+
+    explicit FileWorker(std::shared_ptr<base::TaskRunner> task_runner,
+                        ThreadMode thread_mode = ThreadMode::SINGLE_THREAD);
     ~FileWorker();
 
     void doTask(std::shared_ptr<FileTask> task);
@@ -44,6 +58,7 @@ public:
 private:
     class Impl;
     std::shared_ptr<Impl> impl_;
+    std::vector<std::unique_ptr<base::Thread>> io_threads_;
 
     DISALLOW_COPY_AND_ASSIGN(FileWorker);
 };
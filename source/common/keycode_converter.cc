@@ -21,6 +21,8 @@
 
 #include <QtCore>
 
+#include <array>
+
 namespace common {
 
 namespace {
@@ -36,12 +38,83 @@ namespace {
 #else
 #define USB_KEYMAP(usb, evdev, xkb, win, mac, qt) {usb, 0, qt}
 #endif
-#define USB_KEYMAP_DECLARATION const KeycodeMapEntry usb_keycode_map[] =
+#define USB_KEYMAP_DECLARATION constexpr KeycodeMapEntry usb_keycode_map[] =
 #include "common/keycode_converter_data.inc"
 #undef USB_KEYMAP
 #undef USB_KEYMAP_DECLARATION
 
-const size_t kKeycodeMapEntries = std::size(usb_keycode_map);
+constexpr size_t kKeycodeMapEntries = std::size(usb_keycode_map);
+
+// The lookup tables are open addressing hash tables built at compile time. Each slot holds an index
+// in |usb_keycode_map| or |kEmptySlot|. The table is at least twice as large as the map, so a
+// lookup takes one or two probes.
+constexpr size_t lookupTableSize()
+{
+    size_t size = 1;
+    while (size < kKeycodeMapEntries * 2)
+        size <<= 1;
+    return size;
+}
+
+constexpr size_t kLookupTableSize = lookupTableSize();
+constexpr uint16_t kEmptySlot = 0xFFFF;
+
+static_assert(kKeycodeMapEntries < kEmptySlot);
+
+using LookupTable = std::array<uint16_t, kLookupTableSize>;
+
+constexpr size_t lookupSlot(uint32_t key)
+{
+    // Fibonacci hashing spreads both small (scancodes) and large (USB and Qt) codes evenly.
+    return static_cast<size_t>((key * 0x9E3779B1u) >> 16) & (kLookupTableSize - 1);
+}
+
+// When several entries have the same key, the first of them is found, as by a linear scan.
+template <typename KeyType>
+constexpr LookupTable buildLookupTable(KeyType KeycodeMapEntry::* member)
+{
+    LookupTable table {};
+    for (size_t i = 0; i < kLookupTableSize; ++i)
+        table[i] = kEmptySlot;
+
+    for (size_t i = 0; i < kKeycodeMapEntries; ++i)
+    {
+        const uint32_t key = static_cast<uint32_t>(usb_keycode_map[i].*member);
+        size_t slot = lookupSlot(key);
+
+        while (table[slot] != kEmptySlot &&
+               static_cast<uint32_t>(usb_keycode_map[table[slot]].*member) != key)
+        {
+            slot = (slot + 1) & (kLookupTableSize - 1);
+        }
+
+        if (table[slot] == kEmptySlot)
+            table[slot] = static_cast<uint16_t>(i);
+    }
+
+    return table;
+}
+
+// Returns the index of the entry with |key| or 0 (the invalid entry) if there is no such entry.
+template <typename KeyType>
+size_t findEntry(const LookupTable& table, KeyType KeycodeMapEntry::* member, KeyType key)
+{
+    size_t slot = lookupSlot(static_cast<uint32_t>(key));
+
+    while (table[slot] != kEmptySlot)
+    {
+        if (usb_keycode_map[table[slot]].*member == key)
+            return table[slot];
+
+        slot = (slot + 1) & (kLookupTableSize - 1);
+    }
+
+    return 0;
+}
+
+constexpr LookupTable kUsbLookupTable = buildLookupTable(&KeycodeMapEntry::usb_keycode);
+constexpr LookupTable kNativeLookupTable = buildLookupTable(&KeycodeMapEntry::native_keycode);
+constexpr LookupTable kQtLookupTable = buildLookupTable(&KeycodeMapEntry::qt_keycode);
 
 } // namespace
 
@@ -74,37 +147,23 @@ int KeycodeConverter::usbKeycodeToNativeKeycode(uint32_t usb_keycode)
         usb_keycode = 0x070068; // F13.
 #endif
 
-    for (size_t i = 0; i < kKeycodeMapEntries; ++i)
-    {
-        if (usb_keycode_map[i].usb_keycode == usb_keycode)
-            return usb_keycode_map[i].native_keycode;
-    }
-
-    return invalidNativeKeycode();
+    const size_t index = findEntry(kUsbLookupTable, &KeycodeMapEntry::usb_keycode, usb_keycode);
+    return usb_keycode_map[index].native_keycode;
 }
 
 // static
 uint32_t KeycodeConverter::nativeKeycodeToUsbKeycode(int native_keycode)
 {
-    for (size_t i = 0; i < kKeycodeMapEntries; ++i)
-    {
-        if (usb_keycode_map[i].native_keycode == native_keycode)
-            return usb_keycode_map[i].usb_keycode;
-    }
-
-    return invalidUsbKeycode();
+    const size_t index =
+        findEntry(kNativeLookupTable, &KeycodeMapEntry::native_keycode, native_keycode);
+    return usb_keycode_map[index].usb_keycode;
 }
 
 // static
 uint32_t KeycodeConverter::qtKeycodeToUsbKeycode(int qt_keycode)
 {
-    for (size_t i = 0; i < kKeycodeMapEntries; ++i)
-    {
-        if (usb_keycode_map[i].qt_keycode == qt_keycode)
-            return usb_keycode_map[i].usb_keycode;
-    }
-
-    return invalidUsbKeycode();
+    const size_t index = findEntry(kQtLookupTable, &KeycodeMapEntry::qt_keycode, qt_keycode);
+    return usb_keycode_map[index].usb_keycode;
 }
 
 } // namespace common
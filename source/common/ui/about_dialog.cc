@@ -25,6 +25,7 @@
 #include <QDesktopServices>
 #include <QFile>
 
+#include <aom/aom_codec.h>
 #include <asio/version.hpp>
 #include <google/protobuf/stubs/common.h>
 #include <libyuv.h>
@@ -60,6 +61,7 @@ const char* kTranslators[] =
 const char* kThirdParty[] =
 {
     "asio &copy; 2003-2018 Christopher M. Kohlhoff; Boost Software License 1.0",
+    "libaom &copy; 2016, Alliance for Open Media; BSD 2-Clause License",
     "icu &copy; 2016 and later Unicode, Inc. and others; ICU License",
     "libvpx &copy; 2010, The WebM Project authors; BSD 3-Clause License",
     "libyuv &copy; 2011 The LibYuv Project Authors; BSD 3-Clause License",
@@ -160,6 +162,7 @@ AboutDialog::AboutDialog(QWidget* parent)
     add_version("icu", icu_version_string);
 #endif
 
+    add_version("libaom", aom_codec_version_str());
     add_version("libvpx", vpx_codec_version_str());
     add_version("libyuv", QString::number(LIBYUV_VERSION));
     add_version("openssl", OpenSSL_version(OPENSSL_VERSION));
@@ -0,0 +1,192 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "console/address_book_saver.h"
+
+#include "base/logging.h"
+#include "base/crypto/data_cryptor_chacha20_poly1305.h"
+#include "base/crypto/data_cryptor_fake.h"
+#include "base/crypto/secure_memory.h"
+
+#include <QCoreApplication>
+#include <QSaveFile>
+
+namespace console {
+
+struct AddressBookSaver::Task
+{
+    Task() = default;
+
+    Task(Task&& other) = default;
+
+    // The replaced data would not be cleared.
+    Task& operator=(Task&& other) = delete;
+
+    ~Task()
+    {
+        base::memZero(&data);
+        base::memZero(&key);
+        base::memZero(file.mutable_hashing_salt());
+    }
+
+    QString file_path;
+    proto::address_book::File file;
+    std::string data;
+    std::string key;
+};
+
+AddressBookSaver::AddressBookSaver(QObject* parent)
+    : QObject(parent)
+{
+    thread_ = std::thread(&AddressBookSaver::run, this);
+}
+
+AddressBookSaver::~AddressBookSaver()
+{
+    {
+        std::scoped_lock lock(lock_);
+        stopping_ = true;
+    }
+
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+void AddressBookSaver::save(const QString& file_path,
+                            const proto::address_book::File& file,
+                            std::string&& data,
+                            const std::string& key)
+{
+    Task task;
+    task.file_path = file_path;
+    task.file = file;
+    task.data = std::move(data);
+    task.key = key;
+
+    {
+        std::scoped_lock lock(lock_);
+
+        if (!tasks_.empty() && tasks_.back().file_path == file_path)
+            tasks_.pop_back();
+
+        tasks_.emplace_back(std::move(task));
+    }
+
+    wakeup_.notify_one();
+}
+
+void AddressBookSaver::waitForFinished()
+{
+    {
+        std::unique_lock lock(lock_);
+        idle_.wait(lock, [this]() { return tasks_.empty() && !busy_; });
+    }
+
+    // The results are posted to this object from the saver thread.
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+
+void AddressBookSaver::run()
+{
+    std::unique_lock lock(lock_);
+
+    while (true)
+    {
+        if (tasks_.empty())
+        {
+            if (stopping_)
+                break;
+
+            wakeup_.wait(lock);
+            continue;
+        }
+
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        busy_ = true;
+        lock.unlock();
+
+        const QString file_path = task.file_path;
+        const Error error = writeFile(&task);
+
+        QMetaObject::invokeMethod(this, [this, file_path, error]()
+        {
+            emit finished(file_path, error);
+        }, Qt::QueuedConnection);
+
+        lock.lock();
+        busy_ = false;
+        idle_.notify_all();
+    }
+}
+
+// static
+AddressBookSaver::Error AddressBookSaver::writeFile(Task* task)
+{
+    std::unique_ptr<base::DataCryptor> cryptor;
+
+    switch (task->file.encryption_type())
+    {
+        case proto::address_book::ENCRYPTION_TYPE_NONE:
+            cryptor = std::make_unique<base::DataCryptorFake>();
+            break;
+
+        case proto::address_book::ENCRYPTION_TYPE_CHACHA20_POLY1305:
+            cryptor = std::make_unique<base::DataCryptorChaCha20Poly1305>(task->key);
+            break;
+
+        default:
+            LOG(LS_FATAL) << "Unknown encryption type: " << task->file.encryption_type();
+            return Error::WRITE_FAILED;
+    }
+
+    std::string encrypted_data;
+    CHECK(cryptor->encrypt(task->data, &encrypted_data));
+    base::memZero(&task->data);
+
+    task->file.set_data(std::move(encrypted_data));
+
+    base::ByteArray buffer = base::serialize(task->file);
+    base::memZero(task->file.mutable_data());
+
+    // The data is written to a temporary file which replaces the address book file on commit.
+    QSaveFile file(task->file_path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        base::memZero(buffer.data(), buffer.size());
+        return Error::OPEN_FAILED;
+    }
+
+    int64_t bytes_written = file.write(
+        reinterpret_cast<const char*>(buffer.data()), static_cast<qint64>(buffer.size()));
+
+    base::memZero(buffer.data(), buffer.size());
+
+    if (bytes_written != static_cast<int64_t>(buffer.size()))
+    {
+        file.cancelWriting();
+        return Error::WRITE_FAILED;
+    }
+
+    if (!file.commit())
+        return Error::WRITE_FAILED;
+
+    return Error::SUCCESS;
+}
+
+} // namespace console
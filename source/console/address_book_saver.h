@@ -0,0 +1,81 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CONSOLE__ADDRESS_BOOK_SAVER_H
+#define CONSOLE__ADDRESS_BOOK_SAVER_H
+
+#include "base/macros_magic.h"
+#include "proto/address_book.pb.h"
+
+#include <QObject>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace console {
+
+// Encrypts and writes address book files on a background thread. The file is replaced atomically,
+// so a failed or interrupted save leaves the previous version of the address book intact.
+class AddressBookSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Error { SUCCESS, OPEN_FAILED, WRITE_FAILED };
+
+    explicit AddressBookSaver(QObject* parent = nullptr);
+
+    // Completes all scheduled saves. Their results are not reported.
+    ~AddressBookSaver() override;
+
+    // Schedules writing of the address book to |file_path|. |file| is the header of the address
+    // book file, |data| is serialized proto::address_book::Data. If a save of the same file is
+    // still waiting in the queue, it is replaced, because only the latest data matters.
+    void save(const QString& file_path,
+              const proto::address_book::File& file,
+              std::string&& data,
+              const std::string& key);
+
+    // Blocks until all scheduled saves are completed and reports their results.
+    void waitForFinished();
+
+signals:
+    void finished(const QString& file_path, console::AddressBookSaver::Error error);
+
+private:
+    struct Task;
+
+    void run();
+    static Error writeFile(Task* task);
+
+    std::mutex lock_;
+    std::condition_variable wakeup_;
+    std::condition_variable idle_;
+    std::deque<Task> tasks_;
+    bool busy_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    DISALLOW_COPY_AND_ASSIGN(AddressBookSaver);
+};
+
+} // namespace console
+
+#endif // CONSOLE__ADDRESS_BOOK_SAVER_H
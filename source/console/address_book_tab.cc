@@ -27,18 +27,57 @@
 #include "console/address_book_dialog.h"
 #include "console/computer_dialog.h"
 #include "console/computer_group_dialog.h"
+#include "console/computer_index.h"
 #include "console/computer_item.h"
+#include "console/computer_status_prober.h"
 #include "console/open_address_book_dialog.h"
 #include "console/settings.h"
 
+#include <QEventLoop>
 #include <QFileDialog>
 #include <QMenu>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QThread>
+#include <QTimer>
 
 namespace console {
 
 namespace {
 
+// The search shows no more than this number of computers.
+const size_t kMaxSearchResults = 1000;
+
+const std::chrono::seconds kStatusRefreshInterval{ 60 };
+
+void collectComputers(const proto::address_book::ComputerGroup& group,
+                      std::vector<const proto::address_book::Computer*>* computers)
+{
+    for (int i = 0; i < group.computer_size(); ++i)
+        computers->emplace_back(&group.computer(i));
+
+    for (int i = 0; i < group.computer_group_size(); ++i)
+        collectComputers(group.computer_group(i), computers);
+}
+
+// Runs |task| in a separate thread. Meanwhile the window is redrawn, but user input is not
+// processed. If the task takes long, a progress dialog with |label| is shown.
+void runInBackground(QWidget* parent, const QString& label, std::function<void()> task)
+{
+    QProgressDialog progress(label, QString(), 0, 0, parent);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+
+    QEventLoop loop;
+
+    std::unique_ptr<QThread> thread(QThread::create(std::move(task)));
+    QObject::connect(thread.get(), &QThread::finished, &loop, &QEventLoop::quit);
+
+    thread->start();
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+    thread->wait();
+}
+
 void cleanupComputer(proto::address_book::Computer* computer)
 {
     if (!computer)
@@ -115,18 +154,18 @@ AddressBookTab::AddressBookTab(const QString& file_path,
 
     updateComputerList(group_item);
 
-    group_item->setExpanded(group_item->IsExpanded());
-
+    // Only the expanded groups get the items of their children. The rest of the tree is created
+    // when the groups are expanded (see onGroupItemExpanded).
     std::function<void(ComputerGroupItem*)> restore_child = [&](ComputerGroupItem* item)
     {
+        item->populate();
+
         for (int i = 0; i < item->childCount(); ++i)
         {
             ComputerGroupItem* child_item = dynamic_cast<ComputerGroupItem*>(item->child(i));
-            if (child_item)
+            if (child_item && child_item->IsExpanded())
             {
-                if (child_item->IsExpanded())
-                    child_item->setExpanded(true);
-
+                child_item->setExpanded(true);
                 restore_child(child_item);
             }
         }
@@ -134,6 +173,8 @@ AddressBookTab::AddressBookTab(const QString& file_path,
 
     restore_child(group_item);
 
+    group_item->setExpanded(group_item->IsExpanded());
+
     connect(ui.tree_group, &ComputerGroupTree::itemSelectionChanged, [this]()
     {
         if (ui.tree_group->dragging())
@@ -167,10 +208,25 @@ AddressBookTab::AddressBookTab(const QString& file_path,
 
     connect(ui.tree_computer, &ComputerTree::itemDoubleClicked,
             this, &AddressBookTab::onComputerItemDoubleClicked);
+
+    connect(ui.edit_search, &QLineEdit::textChanged,
+            this, &AddressBookTab::onSearchTextChanged);
+
+    status_prober_ = new ComputerStatusProber(this);
+    connect(status_prober_, &ComputerStatusProber::statusChanged,
+            this, &AddressBookTab::onStatusChanged);
+
+    status_timer_ = new QTimer(this);
+    status_timer_->setInterval(kStatusRefreshInterval);
+    connect(status_timer_, &QTimer::timeout, this, &AddressBookTab::refreshStatus);
+
+    saver_ = new AddressBookSaver(this);
+    connect(saver_, &AddressBookSaver::finished, this, &AddressBookTab::onSaveFinished);
 }
 
 AddressBookTab::~AddressBookTab()
 {
+    search_index_.reset();
     cleanupData(&data_);
     cleanupFile(&file_);
 
@@ -232,13 +288,11 @@ AddressBookTab* AddressBookTab::openFromFile(const QString& file_path, QWidget*
 
     proto::address_book::Data address_book_data;
 
-    std::unique_ptr<base::DataCryptor> cryptor;
-    std::string key;
+    std::string password;
 
     switch (address_book_file.encryption_type())
     {
         case proto::address_book::ENCRYPTION_TYPE_NONE:
-            cryptor = std::make_unique<base::DataCryptorFake>();
             break;
 
         case proto::address_book::ENCRYPTION_TYPE_CHACHA20_POLY1305:
@@ -247,40 +301,60 @@ AddressBookTab* AddressBookTab::openFromFile(const QString& file_path, QWidget*
             if (dialog.exec() != QDialog::Accepted)
                 return nullptr;
 
-            key = base::PasswordHash::hash(
-                base::PasswordHash::SCRYPT,
-                dialog.password().toStdString(),
-                address_book_file.hashing_salt());
-
-            cryptor = std::make_unique<base::DataCryptorChaCha20Poly1305>(key);
+            password = dialog.password().toStdString();
         }
         break;
 
         default:
-            break;
+            showOpenError(parent, tr("The address book file is encrypted with an unsupported encryption type."));
+            return nullptr;
     }
 
-    if (!cryptor)
+    std::string key;
+    bool is_decrypted = false;
+    bool is_parsed = false;
+
+    // Hashing of the password, decryption and parsing of a large address book take a while. They
+    // are done in a separate thread, so the window does not freeze.
+    runInBackground(parent, tr("Opening address book..."), [&]()
     {
-        showOpenError(parent, tr("The address book file is encrypted with an unsupported encryption type."));
-        return nullptr;
-    }
+        std::unique_ptr<base::DataCryptor> cryptor;
+
+        if (address_book_file.encryption_type() == proto::address_book::ENCRYPTION_TYPE_NONE)
+        {
+            cryptor = std::make_unique<base::DataCryptorFake>();
+        }
+        else
+        {
+            key = base::PasswordHash::hash(
+                base::PasswordHash::SCRYPT, password, address_book_file.hashing_salt());
 
-    std::string decrypted_data;
-    if (!cryptor->decrypt(address_book_file.data(), &decrypted_data))
+            cryptor = std::make_unique<base::DataCryptorChaCha20Poly1305>(key);
+        }
+
+        std::string decrypted_data;
+
+        is_decrypted = cryptor->decrypt(address_book_file.data(), &decrypted_data);
+        if (is_decrypted)
+            is_parsed = address_book_data.ParseFromString(decrypted_data);
+
+        base::memZero(&decrypted_data);
+    });
+
+    base::memZero(&password);
+
+    if (!is_decrypted)
     {
         showOpenError(parent, tr("Unable to decrypt the address book with the specified password."));
         return nullptr;
     }
 
-    if (!address_book_data.ParseFromString(decrypted_data))
+    if (!is_parsed)
     {
         showOpenError(parent, tr("The address book file is corrupted or has an unknown format."));
         return nullptr;
     }
 
-    base::memZero(&decrypted_data);
-
     return new AddressBookTab(file_path,
                               std::move(address_book_file),
                               std::move(address_book_data),
@@ -332,6 +406,12 @@ bool AddressBookTab::saveAs()
     return saveToFile(QString());
 }
 
+bool AddressBookTab::waitForSave()
+{
+    saver_->waitForFinished();
+    return !isChanged();
+}
+
 bool AddressBookTab::isRouterEnabled() const
 {
     return data_.enable_router();
@@ -551,6 +631,14 @@ void AddressBookTab::onGroupItemClicked(QTreeWidgetItem* item, int /* column */)
 
     bool is_root = !current_item->parent();
     emit computerGroupActivated(true, is_root);
+
+    // Selecting a group leaves the search.
+    if (!ui.edit_search->text().isEmpty())
+    {
+        QSignalBlocker blocker(ui.edit_search);
+        ui.edit_search->clear();
+    }
+
     updateComputerList(current_item);
 }
 
@@ -584,19 +672,28 @@ void AddressBookTab::onGroupItemExpanded(QTreeWidgetItem* item)
     if (!current_item)
         return;
 
+    if (!current_item->isPopulated())
+    {
+        current_item->populate();
+
+        // The child groups keep their state. Each of them is populated when it is expanded.
+        for (int i = 0; i < current_item->childCount(); ++i)
+        {
+            ComputerGroupItem* child_item =
+                dynamic_cast<ComputerGroupItem*>(current_item->child(i));
+            if (child_item && child_item->IsExpanded())
+                child_item->setExpanded(true);
+        }
+    }
+
     current_item->SetExpanded(true);
     setChanged(true);
 }
 
 void AddressBookTab::onGroupItemDropped()
 {
-    ComputerGroupItem* current_item =
-        dynamic_cast<ComputerGroupItem*>(ui.tree_group->currentItem());
-    if (!current_item)
-        return;
-
-    updateComputerList(current_item);
     setChanged(true);
+    refreshComputerList();
 }
 
 void AddressBookTab::onComputerItemClicked(QTreeWidgetItem* item, int /* column */)
@@ -629,8 +726,48 @@ void AddressBookTab::onComputerItemDoubleClicked(QTreeWidgetItem* item, int /* c
     emit computerDoubleClicked(current_item->computer());
 }
 
+void AddressBookTab::onSearchTextChanged(const QString& text)
+{
+    if (text.isEmpty())
+    {
+        refreshComputerList();
+        return;
+    }
+
+    showSearchResults(text);
+}
+
+void AddressBookTab::onStatusChanged()
+{
+    for (int i = 0; i < ui.tree_computer->topLevelItemCount(); ++i)
+    {
+        ComputerItem* item = dynamic_cast<ComputerItem*>(ui.tree_computer->topLevelItem(i));
+        if (item)
+            item->setStatus(status_prober_->status(*item->computer()));
+    }
+}
+
+void AddressBookTab::refreshStatus()
+{
+    // Hidden tabs do not check the computers.
+    if (!isVisible())
+        return;
+
+    std::vector<const proto::address_book::Computer*> computers;
+    collectComputers(data_.root_group(), &computers);
+
+    status_prober_->start(computers, routerConfig());
+}
+
 void AddressBookTab::showEvent(QShowEvent* event)
 {
+    // The first check is made when the tab is shown for the first time.
+    if (!status_timer_->isActive())
+    {
+        status_timer_->start();
+        QTimer::singleShot(0, this, &AddressBookTab::refreshStatus);
+    }
+
     ComputerGroupItem* current_group =
         dynamic_cast<ComputerGroupItem*>(ui.tree_group->currentItem());
     if (!current_group)
@@ -721,6 +858,10 @@ void AddressBookTab::keyPressEvent(QKeyEvent* event)
 
 void AddressBookTab::setChanged(bool value)
 {
+    // The index refers to the computers and groups which may be changed or removed.
+    if (value)
+        search_index_.reset();
+
     is_changed_ = value;
     emit addressBookChanged(value);
 }
@@ -782,40 +923,85 @@ void AddressBookTab::restoreState(const QByteArray& state)
     }
 }
 
-void AddressBookTab::updateComputerList(ComputerGroupItem* computer_group)
+void AddressBookTab::clearComputerList()
 {
     for (int i = ui.tree_computer->topLevelItemCount() - 1; i >= 0; --i)
         std::unique_ptr<QTreeWidgetItem> item_deleter(ui.tree_computer->takeTopLevelItem(i));
+}
 
+void AddressBookTab::updateComputerList(ComputerGroupItem* computer_group)
+{
+    clearComputerList();
     ui.tree_computer->addTopLevelItems(computer_group->ComputerList());
+    onStatusChanged();
 }
 
-bool AddressBookTab::saveToFile(const QString& file_path)
+void AddressBookTab::refreshComputerList()
 {
-    std::string serialized_data = data_.SerializeAsString();
-    std::unique_ptr<base::DataCryptor> cryptor;
-
-    switch (file_.encryption_type())
+    const QString search_text = ui.edit_search->text();
+    if (!search_text.isEmpty())
     {
-        case proto::address_book::ENCRYPTION_TYPE_NONE:
-            cryptor = std::make_unique<base::DataCryptorFake>();
-            break;
+        showSearchResults(search_text);
+        return;
+    }
 
-        case proto::address_book::ENCRYPTION_TYPE_CHACHA20_POLY1305:
-            cryptor = std::make_unique<base::DataCryptorChaCha20Poly1305>(key_);
-            break;
+    ComputerGroupItem* current_item =
+        dynamic_cast<ComputerGroupItem*>(ui.tree_group->currentItem());
+    if (current_item)
+        updateComputerList(current_item);
+}
 
-        default:
-            LOG(LS_FATAL) << "Unknown encryption type: " << file_.encryption_type();
-            return false;
+void AddressBookTab::showSearchResults(const QString& text)
+{
+    ComputerGroupItem* root_item = rootComputerGroup();
+    if (!root_item)
+        return;
+
+    if (!search_index_)
+        search_index_ = std::make_unique<ComputerIndex>(data_.mutable_root_group());
+
+    clearComputerList();
+
+    // The items of the computers need the items of their groups. The groups which are not
+    // populated yet get their items now.
+    QHash<proto::address_book::ComputerGroup*, ComputerGroupItem*> group_items;
+    QList<QTreeWidgetItem*> items;
+
+    for (const auto& entry : search_index_->find(text, kMaxSearchResults))
+    {
+        auto group_item = group_items.find(entry.group);
+        if (group_item == group_items.end())
+        {
+            group_item = group_items.insert(
+                entry.group, groupItem(root_item, search_index_->groupPath(entry.group)));
+        }
+
+        if (group_item.value())
+            items.push_back(new ComputerItem(entry.computer, group_item.value()));
     }
 
-    std::string encrypted_data;
-    CHECK(cryptor->encrypt(serialized_data, &encrypted_data));
-    base::memZero(&serialized_data);
+    ui.tree_computer->addTopLevelItems(items);
+    onStatusChanged();
+}
 
-    file_.set_data(std::move(encrypted_data));
+void AddressBookTab::onSaveFinished(const QString& file_path, AddressBookSaver::Error error)
+{
+    if (error == AddressBookSaver::Error::SUCCESS)
+        return;
 
+    LOG(LS_ERROR) << "Failed to save address book: " << file_path;
+
+    // The changes are not saved.
+    setChanged(true);
+
+    if (error == AddressBookSaver::Error::OPEN_FAILED)
+        showSaveError(this, tr("Unable to create or open address book file."));
+    else
+        showSaveError(this, tr("Unable to write address book file."));
+}
+
+bool AddressBookTab::saveToFile(const QString& file_path)
+{
     QString path = file_path;
     if (path.isEmpty())
     {
@@ -831,25 +1017,14 @@ bool AddressBookTab::saveToFile(const QString& file_path)
         settings.setLastDirectory(QFileInfo(path).absolutePath());
     }
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly))
-    {
-        showSaveError(this, tr("Unable to create or open address book file."));
-        return false;
-    }
-
-    base::ByteArray buffer = base::serialize(file_);
+    // The encrypted data of the opened file is not needed anymore, the saver encrypts the current
+    // data into a copy of the header.
+    base::memZero(file_.mutable_data());
+    file_.clear_data();
 
-    int64_t bytes_written = file.write(
-        reinterpret_cast<const char*>(buffer.data()), buffer.size());
-
-    base::memZero(buffer.data(), buffer.size());
-
-    if (bytes_written != static_cast<int64_t>(buffer.size()))
-    {
-        showSaveError(this, tr("Unable to write address book file."));
-        return false;
-    }
+    // Serialization makes a snapshot of the address book, so it can be changed while the snapshot
+    // is encrypted and written.
+    saver_->save(path, file_, data_.SerializeAsString(), key_);
 
     file_path_ = path;
 
@@ -871,6 +1046,21 @@ ComputerGroupItem* AddressBookTab::rootComputerGroup()
     return root_item;
 }
 
+// static
+ComputerGroupItem* AddressBookTab::groupItem(
+    ComputerGroupItem* root_item, const std::vector<proto::address_book::ComputerGroup*>& path)
+{
+    if (path.empty() || path.front() != root_item->computerGroup())
+        return nullptr;
+
+    ComputerGroupItem* item = root_item;
+
+    for (size_t i = 1; i < path.size() && item; ++i)
+        item = item->childComputerGroupItem(path[i]);
+
+    return item;
+}
+
 // static
 QString AddressBookTab::parentName(ComputerGroupItem* item)
 {
@@ -21,14 +21,21 @@
 
 #include "base/macros_magic.h"
 #include "client/router_config.h"
+#include "console/address_book_saver.h"
 #include "proto/address_book.pb.h"
 #include "ui_address_book_tab.h"
 
+#include <memory>
 #include <optional>
+#include <vector>
+
+class QTimer;
 
 namespace console {
 
+class ComputerIndex;
 class ComputerItem;
+class ComputerStatusProber;
 
 class AddressBookTab : public QWidget
 {
@@ -50,9 +57,14 @@ public:
 
     AddressBookTab* duplicateTab() const;
 
+    // The address book is saved in the background. Returns false if the user has not selected a
+    // file to save to. A failed save is reported to the user and marks the address book as changed.
     bool save();
     bool saveAs();
-\
+
+    // Waits until the saves are completed. Returns true if all changes are saved.
+    bool waitForSave();
+
     bool isRouterEnabled() const;
     std::optional<client::RouterConfig> routerConfig() const;
 
@@ -90,6 +102,10 @@ private slots:
     void onComputerItemClicked(QTreeWidgetItem* item, int column);
     void onComputerContextMenu(const QPoint& point);
     void onComputerItemDoubleClicked(QTreeWidgetItem* item, int column);
+    void onSearchTextChanged(const QString& text);
+    void onStatusChanged();
+    void refreshStatus();
+    void onSaveFinished(const QString& file_path, console::AddressBookSaver::Error error);
 
 private:
     AddressBookTab(const QString& file_path,
@@ -100,10 +116,15 @@ private:
 
     QByteArray saveState();
     void restoreState(const QByteArray& state);
+    void clearComputerList();
     void updateComputerList(ComputerGroupItem* computer_group);
+    void refreshComputerList();
+    void showSearchResults(const QString& text);
     bool saveToFile(const QString& file_path);
     ComputerGroupItem* rootComputerGroup();
 
+    static ComputerGroupItem* groupItem(
+        ComputerGroupItem* root_item, const std::vector<proto::address_book::ComputerGroup*>& path);
     static QString parentName(ComputerGroupItem* item);
     static void showOpenError(QWidget* parent, const QString& message);
     static void showSaveError(QWidget* parent, const QString& message);
@@ -116,6 +137,15 @@ private:
     proto::address_book::File file_;
     proto::address_book::Data data_;
 
+    // Built on the first search and dropped when the address book is changed.
+    std::unique_ptr<ComputerIndex> search_index_;
+
+    // Periodically checks which computers are online while the tab is visible.
+    ComputerStatusProber* status_prober_;
+    QTimer* status_timer_;
+
+    AddressBookSaver* saver_;
+
     bool is_changed_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(AddressBookTab);
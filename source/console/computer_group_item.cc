@@ -30,15 +30,45 @@ ComputerGroupItem::ComputerGroupItem(proto::address_book::ComputerGroup* compute
     setIcon(0, QIcon(QStringLiteral(":/img/folder.png")));
     updateItem();
 
+    // Child items are created when the group is expanded (see populate()). Until then the item
+    // shows the expand indicator if the group has child groups.
+    setChildIndicatorPolicy(computer_group_->computer_group_size() ?
+        QTreeWidgetItem::ShowIndicator : QTreeWidgetItem::DontShowIndicatorWhenChildless);
+}
+
+void ComputerGroupItem::populate()
+{
+    if (populated_)
+        return;
+
+    populated_ = true;
+    setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+
     for (int i = 0; i < computer_group_->computer_group_size(); ++i)
+        new ComputerGroupItem(computer_group_->mutable_computer_group(i), this);
+}
+
+ComputerGroupItem* ComputerGroupItem::childComputerGroupItem(
+    proto::address_book::ComputerGroup* computer_group)
+{
+    populate();
+
+    for (int i = 0; i < childCount(); ++i)
     {
-        addChild(new ComputerGroupItem(computer_group_->mutable_computer_group(i), this));
+        ComputerGroupItem* item = dynamic_cast<ComputerGroupItem*>(child(i));
+        if (item && item->computerGroup() == computer_group)
+            return item;
     }
+
+    return nullptr;
 }
 
 ComputerGroupItem* ComputerGroupItem::addChildComputerGroup(
     proto::address_book::ComputerGroup* computer_group)
 {
+    // The existing children must have their items before the new one is added.
+    populate();
+
     computer_group_->mutable_computer_group()->AddAllocated(computer_group);
 
     ComputerGroupItem* item = new ComputerGroupItem(computer_group, this);
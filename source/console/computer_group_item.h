@@ -31,6 +31,13 @@ public:
                       ComputerGroupItem* parent_item);
     virtual ~ComputerGroupItem() = default;
 
+    // Creates the items of the child groups if they are not created yet.
+    void populate();
+    bool isPopulated() const { return populated_; }
+
+    // Returns the item of the child group |computer_group| or nullptr.
+    ComputerGroupItem* childComputerGroupItem(proto::address_book::ComputerGroup* computer_group);
+
     ComputerGroupItem* addChildComputerGroup(proto::address_book::ComputerGroup* computer_group);
     bool deleteChildComputerGroup(ComputerGroupItem* computer_group_item);
     proto::address_book::ComputerGroup* takeChildComputerGroup(ComputerGroupItem* computer_group_item);
@@ -50,6 +57,7 @@ private:
     friend class ComputerGroupTree;
 
     proto::address_book::ComputerGroup* computer_group_;
+    bool populated_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(ComputerGroupItem);
 };
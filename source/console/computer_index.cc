@@ -0,0 +1,126 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "console/computer_index.h"
+
+#include "base/crypto/secure_memory.h"
+
+#include <algorithm>
+
+namespace console {
+
+namespace {
+
+void cleanupString(QString* str)
+{
+    if (!str->isEmpty())
+        base::memZero(str->data(), static_cast<size_t>(str->size()) * sizeof(QChar));
+}
+
+} // namespace
+
+ComputerIndex::ComputerIndex(proto::address_book::ComputerGroup* root_group)
+{
+    parents_.emplace(root_group, nullptr);
+    addGroup(root_group);
+
+    std::sort(names_.begin(), names_.end());
+}
+
+ComputerIndex::~ComputerIndex()
+{
+    // The address book is cleaned up when it is closed, the copies of its strings too.
+    for (auto& text : texts_)
+        cleanupString(&text);
+
+    for (auto& name : names_)
+        cleanupString(&name.first);
+}
+
+std::vector<ComputerIndex::Entry> ComputerIndex::find(const QString& text, size_t max_count) const
+{
+    std::vector<Entry> result;
+
+    const QString pattern = text.toLower();
+    if (pattern.isEmpty())
+        return result;
+
+    std::vector<bool> found(entries_.size());
+
+    // Names with the prefix are next to each other in the sorted list.
+    auto it = std::lower_bound(names_.cbegin(), names_.cend(), std::make_pair(pattern, size_t(0)));
+    for (; it != names_.cend() && it->first.startsWith(pattern) && result.size() < max_count; ++it)
+    {
+        found[it->second] = true;
+        result.push_back(entries_[it->second]);
+    }
+
+    for (size_t i = 0; i < texts_.size() && result.size() < max_count; ++i)
+    {
+        if (!found[i] && texts_[i].contains(pattern))
+            result.push_back(entries_[i]);
+    }
+
+    return result;
+}
+
+std::vector<proto::address_book::ComputerGroup*> ComputerIndex::groupPath(
+    proto::address_book::ComputerGroup* group) const
+{
+    std::vector<proto::address_book::ComputerGroup*> path;
+
+    while (group)
+    {
+        path.push_back(group);
+
+        auto parent = parents_.find(group);
+        if (parent == parents_.end())
+            return {};
+
+        group = parent->second;
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+void ComputerIndex::addGroup(proto::address_book::ComputerGroup* group)
+{
+    for (int i = 0; i < group->computer_size(); ++i)
+    {
+        proto::address_book::Computer* computer = group->mutable_computer(i);
+        const QString name = QString::fromStdString(computer->name()).toLower();
+
+        names_.emplace_back(name, entries_.size());
+        texts_.emplace_back(name + QLatin1Char('\n') +
+                            QString::fromStdString(computer->address()).toLower() +
+                            QLatin1Char('\n') +
+                            QString::fromStdString(computer->comment()).toLower());
+        entries_.push_back(Entry{ computer, group });
+    }
+
+    for (int i = 0; i < group->computer_group_size(); ++i)
+    {
+        proto::address_book::ComputerGroup* child_group = group->mutable_computer_group(i);
+
+        parents_.emplace(child_group, group);
+        addGroup(child_group);
+    }
+}
+
+} // namespace console
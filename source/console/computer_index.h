@@ -0,0 +1,75 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CONSOLE__COMPUTER_INDEX_H
+#define CONSOLE__COMPUTER_INDEX_H
+
+#include "base/macros_magic.h"
+#include "proto/address_book.pb.h"
+
+#include <QString>
+
+#include <unordered_map>
+#include <vector>
+
+namespace console {
+
+// Search index of the computers of an address book. The index refers to the messages of the
+// address book and must be built again after the address book is changed.
+class ComputerIndex
+{
+public:
+    explicit ComputerIndex(proto::address_book::ComputerGroup* root_group);
+    ~ComputerIndex();
+
+    struct Entry
+    {
+        proto::address_book::Computer* computer;
+        proto::address_book::ComputerGroup* group;
+    };
+
+    // Returns up to |max_count| computers whose name, address or comment contains |text| (the
+    // case is ignored). The computers whose name starts with |text| go first.
+    std::vector<Entry> find(const QString& text, size_t max_count) const;
+
+    // Returns the groups from the root group to |group| (inclusive).
+    std::vector<proto::address_book::ComputerGroup*> groupPath(
+        proto::address_book::ComputerGroup* group) const;
+
+    size_t size() const { return entries_.size(); }
+
+private:
+    void addGroup(proto::address_book::ComputerGroup* group);
+
+    std::vector<Entry> entries_;
+
+    // Name, address and comment of each entry in lower case, separated by new lines.
+    std::vector<QString> texts_;
+
+    // Names in lower case with the indexes of their entries, sorted for the prefix search.
+    std::vector<std::pair<QString, size_t>> names_;
+
+    std::unordered_map<proto::address_book::ComputerGroup*,
+                       proto::address_book::ComputerGroup*> parents_;
+
+    DISALLOW_COPY_AND_ASSIGN(ComputerIndex);
+};
+
+} // namespace console
+
+#endif // CONSOLE__COMPUTER_INDEX_H
@@ -22,6 +22,7 @@
 #include "base/strings/unicode.h"
 #include "console/computer_group_item.h"
 
+#include <QApplication>
 #include <QDateTime>
 
 namespace console {
@@ -73,6 +74,26 @@ void ComputerItem::updateItem()
     setText(COLUMN_INDEX_MODIFIED, modify_time);
 }
 
+void ComputerItem::setStatus(ComputerStatusProber::Status status)
+{
+    switch (status)
+    {
+        case ComputerStatusProber::Status::ONLINE:
+            setText(COLUMN_INDEX_STATUS, QApplication::translate("ComputerItem", "Online"));
+            setForeground(COLUMN_INDEX_STATUS, QBrush(Qt::darkGreen));
+            break;
+
+        case ComputerStatusProber::Status::OFFLINE:
+            setText(COLUMN_INDEX_STATUS, QApplication::translate("ComputerItem", "Offline"));
+            setForeground(COLUMN_INDEX_STATUS, QBrush(Qt::gray));
+            break;
+
+        default:
+            setText(COLUMN_INDEX_STATUS, QString());
+            break;
+    }
+}
+
 ComputerGroupItem* ComputerItem::parentComputerGroupItem()
 {
     return parent_group_item_;
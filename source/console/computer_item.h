@@ -20,6 +20,7 @@
 #define CONSOLE__COMPUTER_ITEM_H
 
 #include "base/macros_magic.h"
+#include "console/computer_status_prober.h"
 #include "proto/address_book.pb.h"
 
 #include <QTreeWidget>
@@ -35,6 +36,7 @@ public:
     ~ComputerItem() = default;
 
     void updateItem();
+    void setStatus(ComputerStatusProber::Status status);
 
     enum ColumnIndex
     {
@@ -42,7 +44,8 @@ public:
         COLUMN_INDEX_ADDRESS   = 1,
         COLUMN_INDEX_COMMENT   = 2,
         COLUMN_INDEX_CREATED   = 3,
-        COLUMN_INDEX_MODIFIED  = 4
+        COLUMN_INDEX_MODIFIED  = 4,
+        COLUMN_INDEX_STATUS    = 5
     };
 
     proto::address_book::Computer* computer() { return computer_; }
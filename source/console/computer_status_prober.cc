@@ -0,0 +1,309 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "console/computer_status_prober.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "client/host_status_checker.h"
+#include "qt_base/application.h"
+
+#include <QSet>
+#include <QTcpSocket>
+
+#include <algorithm>
+
+namespace console {
+
+namespace {
+
+const size_t kMaxConcurrentProbes = 256;
+const std::chrono::milliseconds kProbeTimeout{ 3000 };
+const std::chrono::milliseconds kUpdateInterval{ 250 };
+
+bool isHostId(const std::string& address)
+{
+    if (address.empty())
+        return false;
+
+    for (char ch : address)
+    {
+        if (ch < '0' || ch > '9')
+            return false;
+    }
+
+    return true;
+}
+
+QString hostIdKey(base::HostId host_id)
+{
+    return QString::fromStdString(base::hostIdToString(host_id));
+}
+
+} // namespace
+
+// Lives while the router check is in progress. The checker is created and deleted on the IO
+// thread, the results are passed to the prober on the UI thread.
+class ComputerStatusProber::RouterDelegate
+    : public client::HostStatusChecker::Delegate,
+      public std::enable_shared_from_this<RouterDelegate>
+{
+public:
+    RouterDelegate(ComputerStatusProber* prober,
+                   std::shared_ptr<base::TaskRunner> ui_task_runner,
+                   std::shared_ptr<base::TaskRunner> io_task_runner)
+        : prober_(prober),
+          ui_task_runner_(std::move(ui_task_runner)),
+          io_task_runner_(std::move(io_task_runner))
+    {
+        // Nothing
+    }
+
+    void start(const client::RouterConfig& router_config, std::vector<base::HostId> host_ids)
+    {
+        io_task_runner_->postTask(
+            [self = shared_from_this(), router_config, host_ids = std::move(host_ids)]()
+        {
+            self->checker_ = std::make_unique<client::HostStatusChecker>(
+                router_config, self->io_task_runner_);
+            self->checker_->start(host_ids, self.get());
+        });
+    }
+
+    // Must be called on the UI thread. The prober receives no more results.
+    void stop()
+    {
+        prober_ = nullptr;
+
+        io_task_runner_->postTask([self = shared_from_this()]()
+        {
+            self->checker_.reset();
+        });
+    }
+
+    // client::HostStatusChecker::Delegate implementation.
+    void onHostStatus(const std::vector<base::HostId>& online_hosts,
+                      const std::vector<base::HostId>& offline_hosts) override
+    {
+        ui_task_runner_->postTask(
+            [self = shared_from_this(), online_hosts, offline_hosts]()
+        {
+            if (self->prober_)
+                self->prober_->onRouterStatus(online_hosts, offline_hosts);
+        });
+    }
+
+    void onHostStatusError() override
+    {
+        LOG(LS_WARNING) << "Unable to get the status of the hosts from the router";
+    }
+
+private:
+    // Used only on the UI thread.
+    ComputerStatusProber* prober_;
+
+    std::shared_ptr<base::TaskRunner> ui_task_runner_;
+    std::shared_ptr<base::TaskRunner> io_task_runner_;
+
+    // Used only on the IO thread.
+    std::unique_ptr<client::HostStatusChecker> checker_;
+
+    DISALLOW_COPY_AND_ASSIGN(RouterDelegate);
+};
+
+ComputerStatusProber::ComputerStatusProber(QObject* parent)
+    : QObject(parent),
+      ui_task_runner_(qt_base::Application::uiTaskRunner()),
+      io_task_runner_(qt_base::Application::ioTaskRunner())
+{
+    update_timer_.setSingleShot(true);
+    update_timer_.setInterval(kUpdateInterval);
+
+    connect(&update_timer_, &QTimer::timeout, this, &ComputerStatusProber::statusChanged);
+}
+
+ComputerStatusProber::~ComputerStatusProber()
+{
+    stop();
+}
+
+void ComputerStatusProber::start(
+    const std::vector<const proto::address_book::Computer*>& computers,
+    const std::optional<client::RouterConfig>& router_config)
+{
+    stop();
+
+    std::vector<base::HostId> host_ids;
+    QSet<QString> keys;
+
+    for (const proto::address_book::Computer* computer : computers)
+    {
+        const QString key = statusKey(*computer);
+        if (keys.contains(key))
+            continue;
+
+        keys.insert(key);
+
+        if (isHostId(computer->address()))
+        {
+            if (router_config.has_value())
+                host_ids.emplace_back(base::stringToHostId(computer->address()));
+        }
+        else
+        {
+            uint16_t port = static_cast<uint16_t>(computer->port());
+            if (!port)
+                port = DEFAULT_HOST_TCP_PORT;
+
+            queue_.emplace_back(QString::fromStdString(computer->address()), port);
+        }
+    }
+
+    LOG(LS_INFO) << "Checking the status of computers (" << host_ids.size() << " by ID, "
+                 << queue_.size() << " by address)";
+
+    if (!host_ids.empty())
+    {
+        router_delegate_ = std::make_shared<RouterDelegate>(
+            this, ui_task_runner_, io_task_runner_);
+        router_delegate_->start(*router_config, std::move(host_ids));
+    }
+
+    startProbes();
+}
+
+void ComputerStatusProber::stop()
+{
+    if (router_delegate_)
+    {
+        router_delegate_->stop();
+        router_delegate_.reset();
+    }
+
+    queue_.clear();
+
+    for (Probe& probe : probes_)
+    {
+        probe.socket->disconnect(this);
+        probe.socket->abort();
+        probe.socket->deleteLater();
+        delete probe.timer;
+    }
+
+    probes_.clear();
+}
+
+ComputerStatusProber::Status ComputerStatusProber::status(
+    const proto::address_book::Computer& computer) const
+{
+    return statuses_.value(statusKey(computer), Status::UNKNOWN);
+}
+
+void ComputerStatusProber::startProbes()
+{
+    while (!queue_.empty() && probes_.size() < kMaxConcurrentProbes)
+    {
+        const QString address = queue_.front().first;
+        const uint16_t port = queue_.front().second;
+        queue_.pop_front();
+
+        QTcpSocket* socket = new QTcpSocket(this);
+        QTimer* timer = new QTimer(this);
+
+        timer->setSingleShot(true);
+
+        connect(socket, &QTcpSocket::connected, this, [this, socket]()
+        {
+            onProbeFinished(socket, true);
+        });
+        connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error),
+                this, [this, socket]()
+        {
+            onProbeFinished(socket, false);
+        });
+        connect(timer, &QTimer::timeout, this, [this, socket]()
+        {
+            onProbeFinished(socket, false);
+        });
+
+        probes_.push_back({ address + QLatin1Char(':') + QString::number(port), socket, timer });
+
+        timer->start(kProbeTimeout);
+        socket->connectToHost(address, port);
+    }
+}
+
+// static
+QString ComputerStatusProber::statusKey(const proto::address_book::Computer& computer)
+{
+    if (isHostId(computer.address()))
+        return hostIdKey(base::stringToHostId(computer.address()));
+
+    uint16_t port = static_cast<uint16_t>(computer.port());
+    if (!port)
+        port = DEFAULT_HOST_TCP_PORT;
+
+    return QString::fromStdString(computer.address()) + QLatin1Char(':') + QString::number(port);
+}
+
+void ComputerStatusProber::setStatus(const QString& key, Status status)
+{
+    auto it = statuses_.find(key);
+    if (it != statuses_.end() && it.value() == status)
+        return;
+
+    statuses_.insert(key, status);
+
+    // The changes are collected and reported together.
+    if (!update_timer_.isActive())
+        update_timer_.start();
+}
+
+void ComputerStatusProber::onProbeFinished(QTcpSocket* socket, bool connected)
+{
+    auto probe = std::find_if(probes_.begin(), probes_.end(), [socket](const Probe& probe)
+    {
+        return probe.socket == socket;
+    });
+    if (probe == probes_.end())
+        return;
+
+    setStatus(probe->key, connected ? Status::ONLINE : Status::OFFLINE);
+
+    socket->disconnect(this);
+    socket->abort();
+    socket->deleteLater();
+    probe->timer->deleteLater();
+
+    probes_.erase(probe);
+
+    // The next probes are started after the signals of the socket are handled.
+    QTimer::singleShot(0, this, &ComputerStatusProber::startProbes);
+}
+
+void ComputerStatusProber::onRouterStatus(const std::vector<base::HostId>& online_hosts,
+                                          const std::vector<base::HostId>& offline_hosts)
+{
+    for (base::HostId host_id : online_hosts)
+        setStatus(hostIdKey(host_id), Status::ONLINE);
+
+    for (base::HostId host_id : offline_hosts)
+        setStatus(hostIdKey(host_id), Status::OFFLINE);
+}
+
+} // namespace console
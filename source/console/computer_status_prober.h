@@ -0,0 +1,111 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef CONSOLE__COMPUTER_STATUS_PROBER_H
+#define CONSOLE__COMPUTER_STATUS_PROBER_H
+
+#include "base/macros_magic.h"
+#include "base/peer/host_id.h"
+#include "client/router_config.h"
+#include "proto/address_book.pb.h"
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class QTcpSocket;
+
+namespace base {
+class TaskRunner;
+} // namespace base
+
+namespace console {
+
+// Checks which computers of the address book are online. The computers with an ID are checked by
+// the router in batches, the computers with an address are checked by connecting to them. The
+// connections are made asynchronously, no more than 256 at a time.
+class ComputerStatusProber : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Status { UNKNOWN, ONLINE, OFFLINE };
+
+    explicit ComputerStatusProber(QObject* parent = nullptr);
+    ~ComputerStatusProber() override;
+
+    // Starts a new check of |computers|. The check in progress is stopped. The known statuses are
+    // kept until the new results are received.
+    void start(const std::vector<const proto::address_book::Computer*>& computers,
+               const std::optional<client::RouterConfig>& router_config);
+    void stop();
+
+    Status status(const proto::address_book::Computer& computer) const;
+
+signals:
+    // Statuses of one or more computers have changed. The changes are collected for a quarter of a
+    // second, so the lists are not redrawn for each computer.
+    void statusChanged();
+
+private slots:
+    void startProbes();
+
+private:
+    class RouterDelegate;
+
+    struct Probe
+    {
+        QString key;
+        QTcpSocket* socket;
+        QTimer* timer;
+    };
+
+    static QString statusKey(const proto::address_book::Computer& computer);
+
+    void setStatus(const QString& key, Status status);
+    void onProbeFinished(QTcpSocket* socket, bool connected);
+    void onRouterStatus(const std::vector<base::HostId>& online_hosts,
+                        const std::vector<base::HostId>& offline_hosts);
+
+    std::shared_ptr<base::TaskRunner> ui_task_runner_;
+    std::shared_ptr<base::TaskRunner> io_task_runner_;
+
+    // Statuses by the address (or the ID) of the computers.
+    QHash<QString, Status> statuses_;
+
+    // Addresses and ports waiting for a probe and the probes in progress.
+    std::deque<std::pair<QString, uint16_t>> queue_;
+    std::vector<Probe> probes_;
+
+    // Receives the results of the router on the IO thread and passes them to the UI thread.
+    std::shared_ptr<RouterDelegate> router_delegate_;
+
+    QTimer update_timer_;
+
+    DISALLOW_COPY_AND_ASSIGN(ComputerStatusProber);
+};
+
+} // namespace console
+
+#endif // CONSOLE__COMPUTER_STATUS_PROBER_H
@@ -21,6 +21,7 @@
 #include "base/strings/unicode.h"
 #include "build/build_config.h"
 #include "build/version.h"
+#include "client/ui/preview_window.h"
 #include "client/ui/qt_desktop_window.h"
 #include "client/ui/qt_file_manager_window.h"
 #include "client/ui/router_manager_window.h"
@@ -120,6 +121,9 @@ MainWindow::MainWindow(const QString& file_path)
     connect(ui.action_file_transfer_connect, &QAction::triggered,
             this, &MainWindow::onFileTransferConnect);
 
+    connect(ui.action_preview_computers, &QAction::triggered,
+            this, &MainWindow::onPreviewComputers);
+
     connect(ui.tool_bar, &QToolBar::visibilityChanged, ui.action_toolbar, &QAction::setChecked);
     connect(ui.action_toolbar, &QAction::toggled, ui.tool_bar, &QToolBar::setVisible);
     connect(ui.action_statusbar, &QAction::toggled, ui.status_bar, &QStatusBar::setVisible);
@@ -481,6 +485,27 @@ void MainWindow::onFileTransferConnect()
     }
 }
 
+void MainWindow::onPreviewComputers()
+{
+    AddressBookTab* tab = currentAddressBookTab();
+    if (!tab)
+        return;
+
+    proto::address_book::ComputerGroup* computer_group = tab->currentComputerGroup();
+    if (!computer_group || !computer_group->computer_size())
+        return;
+
+    client::PreviewWindow* preview_window = new client::PreviewWindow();
+    preview_window->setAttribute(Qt::WA_DeleteOnClose);
+    preview_window->setWindowTitle(
+        tr("Preview - %1").arg(QString::fromStdString(computer_group->name())));
+
+    for (int i = 0; i < computer_group->computer_size(); ++i)
+        preview_window->addHost(computerConfig(computer_group->computer(i), tab->routerConfig()));
+
+    preview_window->showMaximized();
+}
+
 void MainWindow::onCurrentTabChanged(int index)
 {
     if (index == -1)
@@ -533,8 +558,12 @@ void MainWindow::onCloseTab(int index)
         switch (ret)
         {
             case QMessageBox::Yes:
-                tab->save();
-                break;
+            {
+                // The tab is closed right after it is saved.
+                if (tab->save())
+                    tab->waitForSave();
+            }
+            break;
 
             case QMessageBox::Cancel:
                 return;
@@ -641,6 +670,9 @@ void MainWindow::onComputerGroupContextMenu(const QPoint& point, bool is_root)
         menu.addAction(ui.action_delete_computer_group);
     }
 
+    menu.addSeparator();
+    menu.addAction(ui.action_preview_computers);
+
     menu.addSeparator();
     menu.addAction(ui.action_add_computer_group);
     menu.addAction(ui.action_add_computer);
@@ -777,7 +809,7 @@ void MainWindow::onTabContextMenu(const QPoint& pos)
         {
             if (tab->isChanged())
             {
-                if (!tab->save())
+                if (!tab->save() || !tab->waitForSave())
                     return;
             }
 
@@ -918,8 +950,11 @@ void MainWindow::closeEvent(QCloseEvent* event)
             switch (ret)
             {
                 case QMessageBox::Yes:
-                    tab->save();
-                    break;
+                {
+                    if (tab->save())
+                        tab->waitForSave();
+                }
+                break;
 
                 case QMessageBox::Cancel:
                     event->ignore();
@@ -1129,6 +1164,22 @@ bool MainWindow::hasUnpinnedTabs() const
     return false;
 }
 
+// static
+client::Config MainWindow::computerConfig(
+    const proto::address_book::Computer& computer,
+    const std::optional<client::RouterConfig>& router_config)
+{
+    client::Config config;
+    config.router_config = router_config;
+    config.computer_name = base::utf16FromUtf8(computer.name());
+    config.address_or_id = base::utf16FromUtf8(computer.address());
+    config.port          = computer.port();
+    config.username      = base::utf16FromUtf8(computer.username());
+    config.password      = base::utf16FromUtf8(computer.password());
+    config.session_type  = computer.session_type();
+    return config;
+}
+
 void MainWindow::connectToComputer(const proto::address_book::Computer& computer,
                                    const std::optional<client::RouterConfig>& router_config)
 {
@@ -1155,14 +1206,7 @@ void MainWindow::connectToComputer(const proto::address_book::Computer& computer
         return;
     }
 
-    client::Config config;
-    config.router_config = router_config;
-    config.computer_name = base::utf16FromUtf8(computer.name());
-    config.address_or_id = base::utf16FromUtf8(computer.address());
-    config.port          = computer.port();
-    config.username      = base::utf16FromUtf8(computer.username());
-    config.password      = base::utf16FromUtf8(computer.password());
-    config.session_type  = computer.session_type();
+    client::Config config = computerConfig(computer, router_config);
 
     client::SessionWindow* session_window = nullptr;
 
@@ -19,7 +19,7 @@
 #ifndef CONSOLE__MAIN_WINDOW_H
 #define CONSOLE__MAIN_WINDOW_H
 
-#include "client/router_config.h"
+#include "client/client_config.h"
 #include "common/ui/update_checker.h"
 #include "console/mru.h"
 #include "proto/address_book.pb.h"
@@ -75,6 +75,7 @@ private slots:
     void onDesktopManageConnect();
     void onDesktopViewConnect();
     void onFileTransferConnect();
+    void onPreviewComputers();
 
     void onCurrentTabChanged(int index);
     void onCloseTab(int index);
@@ -99,6 +100,9 @@ private:
     AddressBookTab* currentAddressBookTab();
     bool hasChangedTabs() const;
     bool hasUnpinnedTabs() const;
+    static client::Config computerConfig(
+        const proto::address_book::Computer& computer,
+        const std::optional<client::RouterConfig>& router_config);
     void connectToComputer(const proto::address_book::Computer& computer,
                            const std::optional<client::RouterConfig>& router_config);
     void connectToRouter();
@@ -0,0 +1,158 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "host/audio_encoder_cache.h"
+
+#include "base/logging.h"
+#include "base/codec/audio_encoder_opus.h"
+
+#include <algorithm>
+
+namespace host {
+
+namespace {
+
+std::unique_ptr<base::AudioEncoder> createEncoder(
+    proto::AudioEncoding encoding, std::chrono::milliseconds frame_duration)
+{
+    switch (encoding)
+    {
+        case proto::AUDIO_ENCODING_OPUS:
+            return std::make_unique<base::AudioEncoderOpus>(frame_duration);
+
+        default:
+            LOG(LS_WARNING) << "Unsupported audio encoding: " << encoding;
+            return nullptr;
+    }
+}
+
+} // namespace
+
+bool AudioEncoderCache::Key::operator==(const Key& other) const
+{
+    return encoding == other.encoding && frame_duration == other.frame_duration;
+}
+
+bool AudioEncoderCache::Key::operator<(const Key& other) const
+{
+    if (encoding != other.encoding)
+        return encoding < other.encoding;
+
+    return frame_duration < other.frame_duration;
+}
+
+AudioEncoderCache::Group::Group() = default;
+AudioEncoderCache::Group::~Group() = default;
+
+AudioEncoderCache::AudioEncoderCache() = default;
+AudioEncoderCache::~AudioEncoderCache() = default;
+
+void AudioEncoderCache::beginPacket()
+{
+    ++packet_number_;
+
+    // Every active client gets every packet. A client which did not get the previous packet is
+    // disconnected or has audio disabled.
+    for (auto it = clients_.begin(); it != clients_.end();)
+    {
+        if (it->second.packet_number + 1 < packet_number_)
+            it = clients_.erase(it);
+        else
+            ++it;
+    }
+
+    for (auto it = groups_.begin(); it != groups_.end();)
+    {
+        if (!hasClients(it->first))
+            it = groups_.erase(it);
+        else
+            ++it;
+    }
+}
+
+const proto::AudioPacket* AudioEncoderCache::encode(uint32_t client_id,
+                                                    proto::AudioEncoding encoding,
+                                                    std::chrono::milliseconds frame_duration,
+                                                    int bitrate,
+                                                    const proto::AudioPacket& packet)
+{
+    const Key key{ encoding, frame_duration };
+
+    Client& client = clients_[client_id];
+    client.key = key;
+    client.bitrate = bitrate;
+    client.packet_number = packet_number_;
+
+    Group& group = groups_[key];
+
+    if (group.packet_number != packet_number_)
+    {
+        // The first client of the group encodes the packet for all the others. Audio frames do not
+        // depend on each other the way video frames do, so a client can join at any packet.
+        group.packet_number = packet_number_;
+        group.packet.Clear();
+        group.is_encoded = false;
+
+        if (!group.encoder)
+        {
+            group.encoder = createEncoder(encoding, frame_duration);
+            if (!group.encoder)
+                return nullptr;
+        }
+
+        // The clients which get their packets later in this round still have the bitrate from
+        // the previous packet. The difference is one packet and does not matter.
+        group.encoder->setBitrate(groupBitrate(key));
+        group.is_encoded = group.encoder->encode(packet, &group.packet);
+    }
+
+    if (!group.is_encoded)
+        return nullptr;
+
+    return &group.packet;
+}
+
+bool AudioEncoderCache::hasClients(const Key& key) const
+{
+    for (const auto& client : clients_)
+    {
+        if (client.second.key == key)
+            return true;
+    }
+
+    return false;
+}
+
+int AudioEncoderCache::groupBitrate(const Key& key) const
+{
+    int bitrate = 0;
+    bool has_bitrate = false;
+
+    for (const auto& client : clients_)
+    {
+        if (!(client.second.key == key))
+            continue;
+
+        bitrate = has_bitrate ? std::min(bitrate, client.second.bitrate) : client.second.bitrate;
+        has_bitrate = true;
+    }
+
+    return bitrate;
+}
+
+} // namespace host
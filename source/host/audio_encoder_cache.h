@@ -0,0 +1,101 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST__AUDIO_ENCODER_CACHE_H
+#define HOST__AUDIO_ENCODER_CACHE_H
+
+#include "base/macros_magic.h"
+#include "proto/desktop.pb.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+
+namespace base {
+class AudioEncoder;
+} // namespace base
+
+namespace host {
+
+// Shares audio encoders between the desktop clients of one user session. All the clients get the
+// same captured audio, so the clients with the same encoding and the same frame duration get the
+// same audio packets. The audio is resampled and encoded once for all of them.
+class AudioEncoderCache
+{
+public:
+    AudioEncoderCache();
+    ~AudioEncoderCache();
+
+    // Must be called for every captured packet before the clients call encode(). The clients which
+    // did not get the previous packet are considered to be gone.
+    void beginPacket();
+
+    // Returns the encoded packet of the current captured packet for the client |client_id| or
+    // nullptr if there is nothing to send (the encoder collects samples for a whole frame, or
+    // the frame is silent). |bitrate| is the audio bitrate the channel of the client can carry
+    // (in bits per second). An encoder that is shared uses the lowest bitrate of its clients.
+    const proto::AudioPacket* encode(uint32_t client_id,
+                                     proto::AudioEncoding encoding,
+                                     std::chrono::milliseconds frame_duration,
+                                     int bitrate,
+                                     const proto::AudioPacket& packet);
+
+private:
+    struct Key
+    {
+        proto::AudioEncoding encoding;
+        std::chrono::milliseconds frame_duration;
+
+        bool operator==(const Key& other) const;
+        bool operator<(const Key& other) const;
+    };
+
+    struct Group
+    {
+        Group();
+        ~Group();
+
+        std::unique_ptr<base::AudioEncoder> encoder;
+
+        // Packet of the current captured packet (if |packet_number| is equal to the current
+        // packet number).
+        proto::AudioPacket packet;
+        uint64_t packet_number = 0;
+        bool is_encoded = false;
+    };
+
+    struct Client
+    {
+        Key key;
+        int bitrate = 0;
+        uint64_t packet_number = 0;
+    };
+
+    bool hasClients(const Key& key) const;
+    int groupBitrate(const Key& key) const;
+
+    std::map<Key, Group> groups_;
+    std::map<uint32_t, Client> clients_;
+    uint64_t packet_number_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(AudioEncoderCache);
+};
+
+} // namespace host
+
+#endif // HOST__AUDIO_ENCODER_CACHE_H
@@ -0,0 +1,185 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "host/capture_budget.h"
+
+#include "base/logging.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace host {
+
+namespace {
+
+// A software VP8 encoder processes about 1080p at 30 fps on one core, the differ and the
+// conversion of the colors take a part of it.
+const int64_t kPixelRatePerProcessor = 40 * 1000 * 1000;
+
+// The host process itself and the system need some of the processors.
+const int kReservedProcessors = 1;
+
+// Weight of the average frame in the estimate of the changed pixels.
+const double kAverageWeight = 0.2;
+
+// A session which has not captured a frame for this time does not use its share.
+const std::chrono::seconds kInactiveTime{ 2 };
+
+// A limited session still gets a frame at least this often.
+const CaptureBudget::Milliseconds kMaxInterval{ 1000 };
+
+double weight(CaptureBudget::Priority priority)
+{
+    switch (priority)
+    {
+        case CaptureBudget::Priority::LOW:
+            return 1.0;
+
+        case CaptureBudget::Priority::NORMAL:
+        default:
+            return 4.0;
+    }
+}
+
+} // namespace
+
+CaptureBudget::CaptureBudget(int64_t pixel_rate)
+    : pixel_rate_(pixel_rate)
+{
+    DCHECK_GT(pixel_rate_, 0);
+}
+
+CaptureBudget::~CaptureBudget() = default;
+
+// static
+int64_t CaptureBudget::defaultPixelRate()
+{
+    const int processors = static_cast<int>(std::thread::hardware_concurrency());
+    return kPixelRatePerProcessor * std::max(processors - kReservedProcessors, 1);
+}
+
+int CaptureBudget::addSession()
+{
+    const int session_id = ++last_session_id_;
+    sessions_.emplace(session_id, Session());
+    return session_id;
+}
+
+void CaptureBudget::removeSession(int session_id)
+{
+    sessions_.erase(session_id);
+}
+
+CaptureBudget::Milliseconds CaptureBudget::update(int session_id,
+                                                  int64_t changed_pixels,
+                                                  const Milliseconds& interval,
+                                                  Priority priority,
+                                                  const Clock::time_point& time)
+{
+    auto it = sessions_.find(session_id);
+    if (it == sessions_.end())
+        return interval;
+
+    Session& session = it->second;
+
+    const bool is_active = session.update_time != Clock::time_point() &&
+                           time - session.update_time < kInactiveTime;
+    if (is_active)
+    {
+        session.pixels_per_frame +=
+            (static_cast<double>(changed_pixels) - session.pixels_per_frame) * kAverageWeight;
+    }
+    else
+    {
+        session.pixels_per_frame = static_cast<double>(changed_pixels);
+    }
+
+    session.interval = std::max(interval, Milliseconds(1));
+    session.priority = priority;
+    session.update_time = time;
+
+    allocate(time);
+
+    if (session.demand <= session.allocation || session.allocation <= 0)
+        return interval;
+
+    // The frames have about the same changed area at a lower rate, so the interval is increased
+    // in proportion to the excess.
+    const double scale = session.demand / session.allocation;
+    const Milliseconds limited(
+        static_cast<Milliseconds::rep>(static_cast<double>(session.interval.count()) * scale));
+
+    return std::clamp(limited, interval, std::max(interval, kMaxInterval));
+}
+
+void CaptureBudget::allocate(const Clock::time_point& time)
+{
+    std::vector<Session*> unsatisfied;
+
+    for (auto& [session_id, session] : sessions_)
+    {
+        session.allocation = 0;
+        session.demand = 0;
+
+        if (time - session.update_time >= kInactiveTime)
+            continue;
+
+        session.demand = session.pixels_per_frame * 1000.0 /
+            static_cast<double>(session.interval.count());
+        if (session.demand > 0)
+            unsatisfied.push_back(&session);
+    }
+
+    // Water filling: the sessions which need less than their share of the remaining capacity get
+    // what they need, the rest is divided again between the others.
+    double remaining = static_cast<double>(pixel_rate_);
+
+    while (!unsatisfied.empty())
+    {
+        double total_weight = 0;
+        for (const Session* session : unsatisfied)
+            total_weight += weight(session->priority);
+
+        const size_t count = unsatisfied.size();
+
+        auto satisfied_end = std::partition(unsatisfied.begin(), unsatisfied.end(),
+            [remaining, total_weight](const Session* session)
+        {
+            return session->demand > remaining * weight(session->priority) / total_weight;
+        });
+
+        for (auto it = satisfied_end; it != unsatisfied.end(); ++it)
+        {
+            (*it)->allocation = (*it)->demand;
+            remaining -= (*it)->demand;
+        }
+
+        unsatisfied.erase(satisfied_end, unsatisfied.end());
+
+        if (unsatisfied.size() == count)
+        {
+            // Nobody fits in the share, the capacity is divided by the weights.
+            for (Session* session : unsatisfied)
+                session->allocation = remaining * weight(session->priority) / total_weight;
+            break;
+        }
+    }
+}
+
+} // namespace host
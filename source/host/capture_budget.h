@@ -0,0 +1,92 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST__CAPTURE_BUDGET_H
+#define HOST__CAPTURE_BUDGET_H
+
+#include "base/macros_magic.h"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+
+namespace host {
+
+// Shares the capture and encoding capacity of the host between the user sessions (on a terminal
+// server there can be dozens of them). The capacity is measured in the changed pixels per second,
+// which is what the differ and the encoders process. While the sessions request less than the
+// capacity, they are not limited. Otherwise the capacity is divided in proportion to the weights
+// of the priorities, the sessions which need less than their share give the rest to the others,
+// and the capture interval of the other sessions is increased so that they fit in their shares.
+class CaptureBudget
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::milliseconds;
+
+    enum class Priority
+    {
+        LOW,   // Only previews, hidden windows or a recording.
+        NORMAL // A client works with the desktop.
+    };
+
+    // |pixel_rate| is the capacity of the host in pixels per second.
+    explicit CaptureBudget(int64_t pixel_rate = defaultPixelRate());
+    ~CaptureBudget();
+
+    // The capacity for the number of the processors of the computer.
+    static int64_t defaultPixelRate();
+
+    int addSession();
+    void removeSession(int session_id);
+
+    // Called for every captured frame of the session. |changed_pixels| is the area of the updated
+    // region of the frame and |interval| is the capture interval the clients of the session can
+    // receive. Returns the capture interval allowed to the session (not less than |interval|).
+    Milliseconds update(int session_id,
+                        int64_t changed_pixels,
+                        const Milliseconds& interval,
+                        Priority priority,
+                        const Clock::time_point& time = Clock::now());
+
+private:
+    struct Session
+    {
+        // Average changed pixels per frame.
+        double pixels_per_frame = 0;
+        Milliseconds interval { 0 };
+        Priority priority = Priority::NORMAL;
+        Clock::time_point update_time;
+
+        // Requested pixels per second and the allocated part of the capacity.
+        double demand = 0;
+        double allocation = 0;
+    };
+
+    void allocate(const Clock::time_point& time);
+
+    const int64_t pixel_rate_;
+    std::map<int, Session> sessions_;
+    int last_session_id_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(CaptureBudget);
+};
+
+} // namespace host
+
+#endif // HOST__CAPTURE_BUDGET_H
@@ -19,6 +19,7 @@
 #include "host/client_session.h"
 
 #include "base/logging.h"
+#include "base/memory/memory_accounting.h"
 #include "base/net/network_channel_proxy.h"
 #include "host/client_session_desktop.h"
 #include "host/client_session_file_transfer.h"
@@ -36,6 +37,18 @@ ClientSession::ClientSession(
     // Session IDs must start with 1.
     static uint32_t id_counter = 0;
     id_ = ++id_counter;
+
+    memory_account_ = std::make_shared<base::MemoryAccount>("session " + std::to_string(id_));
+    channel_->setMemoryAccount(memory_account_);
+}
+
+ClientSession::~ClientSession()
+{
+    // Other sessions of the client may still use the connection as streams.
+    base::NetworkChannel::destroy(std::move(channel_));
+
+    LOG(LS_INFO) << memory_account_->toString();
+    LOG(LS_INFO) << base::MemoryAccount::global()->toString();
 }
 
 // static
@@ -126,9 +139,15 @@ std::shared_ptr<base::NetworkChannelProxy> ClientSession::channelProxy()
     return channel_->channelProxy();
 }
 
-void ClientSession::sendMessage(base::ByteArray&& buffer)
+void ClientSession::sendMessage(base::ByteArray&& buffer, base::NetworkChannel::Priority priority)
+{
+    channel_->send(std::move(buffer), priority);
+}
+
+void ClientSession::sendMessage(const google::protobuf::MessageLite& message,
+                                base::NetworkChannel::Priority priority)
 {
-    channel_->send(std::move(buffer));
+    channel_->send(message, priority);
 }
 
 void ClientSession::onConnected()
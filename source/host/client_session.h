@@ -25,6 +25,7 @@
 #include "proto/common.pb.h"
 
 namespace base {
+class MemoryAccount;
 class NetworkChannelProxy;
 } // namespace base
 
@@ -35,7 +36,7 @@ class DesktopSessionProxy;
 class ClientSession : public base::NetworkChannel::Listener
 {
 public:
-    virtual ~ClientSession() = default;
+    virtual ~ClientSession();
 
     class Delegate
     {
@@ -84,7 +85,12 @@ protected:
     virtual void onStarted() = 0;
 
     std::shared_ptr<base::NetworkChannelProxy> channelProxy();
-    void sendMessage(base::ByteArray&& buffer);
+    base::NetworkChannel& channel() { return *channel_; }
+    const base::NetworkChannel& channel() const { return *channel_; }
+    void sendMessage(base::ByteArray&& buffer,
+                     base::NetworkChannel::Priority priority = base::NetworkChannel::Priority::NORMAL);
+    void sendMessage(const google::protobuf::MessageLite& message,
+                     base::NetworkChannel::Priority priority = base::NetworkChannel::Priority::NORMAL);
 
     // base::NetworkChannel::Listener implementation.
     void onConnected() override;
@@ -101,6 +107,8 @@ private:
     std::string username_;
     std::string computer_name_;
 
+    // Memory used by the session (see base::MemoryAccount). Reported when the session ends.
+    std::shared_ptr<base::MemoryAccount> memory_account_;
     std::unique_ptr<base::NetworkChannel> channel_;
 };
 
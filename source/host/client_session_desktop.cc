@@ -20,25 +20,96 @@
 
 #include "base/logging.h"
 #include "base/power_controller.h"
+#include "base/trace_event.h"
 #include "base/codec/audio_encoder_opus.h"
 #include "base/codec/cursor_encoder.h"
-#include "base/codec/scale_reducer.h"
-#include "base/codec/video_encoder_vpx.h"
+#include "base/codec/video_encoder_mf.h"
+#include "base/codec/video_rate_controller.h"
 #include "base/desktop/frame.h"
 #include "base/desktop/screen_capturer.h"
+#include "base/net/network_channel_proxy.h"
 #include "common/desktop_session_constants.h"
+#include "host/audio_encoder_cache.h"
 #include "host/desktop_session_proxy.h"
-#include "host/system_info.h"
+#include "host/system_info_cache.h"
+#include "host/video_encoder_cache.h"
 #include "host/win/updater_launcher.h"
 #include "proto/desktop_internal.pb.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace host {
 
+namespace {
+
+// Amount of data which the system can hold in the send buffer without sending it.
+const size_t kWriteLowWatermark = 32 * 1024; // 32 KB
+
+// Number of the last cursor positions injected by the client which are recognized in the frames.
+const size_t kMaxInjectedPositions = 32;
+
+// The system may report an injected position moved by a pixel (rounding of the coordinates of
+// scaled displays), so positions this close to an injected one are recognized as well.
+const int kInjectedPositionTolerance = 1;
+
+// Audio gets 1/16 of the video bitrate (about 64 kb/s with 1 Mb/s of video).
+const uint32_t kAudioBitrateShare = 16;
+
+// Budget of the messages queued in the channel. If the link of the client stalls, the rate
+// control can not slow down the video enough. When the budget is exceeded, the queued video
+// packets are stale and are discarded in favour of a key frame of the current screen. The budget
+// is the amount of data the link can send in kMaxQueueDelay, within the limits below.
+const size_t kMinPendingVideoBytes = 1 * 1024 * 1024; // 1 MB
+const size_t kMaxPendingVideoBytes = 16 * 1024 * 1024; // 16 MB
+const std::chrono::seconds kMaxQueueDelay(2);
+
+// A preview (see proto::PREVIEW_MODE) is a thumbnail which fits into kMaxPreviewWidth x
+// kMaxPreviewHeight, updated no more often than kPreviewInterval and limited to kPreviewBitrate.
+const int kMaxPreviewWidth = 320;
+const int kMaxPreviewHeight = 240;
+const std::chrono::milliseconds kPreviewInterval{ 1000 };
+const uint32_t kPreviewBitrate = 64; // kbit/s
+
+// The video of a hidden window is only kept up to date for the moment it is shown again.
+const std::chrono::milliseconds kHiddenInterval{ 5000 };
+
+// When the link of the client degrades, the desktop effects, the wallpaper and the font smoothing
+// are disabled, which makes the screen much cheaper to encode. The link is degraded when its
+// bandwidth is below kLowBandwidth or its round-trip time is above kHighRtt for kDegradedDelay.
+// The settings of the client are restored when the bandwidth is above kRecoveredBandwidth and the
+// round-trip time is below half of kHighRtt for kRecoveredDelay.
+const uint32_t kLowBandwidthFlags =
+    proto::DISABLE_DESKTOP_EFFECTS | proto::DISABLE_DESKTOP_WALLPAPER |
+    proto::DISABLE_FONT_SMOOTHING;
+const int64_t kLowBandwidth = 256 * 1024; // 2 Mbit/s
+const int64_t kRecoveredBandwidth = 512 * 1024; // 4 Mbit/s
+const std::chrono::milliseconds kHighRtt{ 500 };
+const std::chrono::seconds kDegradedDelay(5);
+const std::chrono::seconds kRecoveredDelay(30);
+
+base::Size previewSize(const base::Size& size)
+{
+    if (size.width() <= kMaxPreviewWidth && size.height() <= kMaxPreviewHeight)
+        return size;
+
+    const double scale = std::min(static_cast<double>(kMaxPreviewWidth) / size.width(),
+                                  static_cast<double>(kMaxPreviewHeight) / size.height());
+
+    // The encoders work with even sizes.
+    return base::Size(std::max(static_cast<int>(size.width() * scale) & ~1, 2),
+                      std::max(static_cast<int>(size.height() * scale) & ~1, 2));
+}
+
+} // namespace
+
 ClientSessionDesktop::ClientSessionDesktop(
     proto::SessionType session_type, std::unique_ptr<base::NetworkChannel> channel)
     : ClientSession(session_type, std::move(channel)),
-      incoming_message_(std::make_unique<proto::ClientToHost>()),
-      outgoing_message_(std::make_unique<proto::HostToClient>())
+      rate_controller_(std::make_unique<base::VideoRateController>()),
+      incoming_message_(incoming_arena_.create<proto::ClientToHost>()),
+      outgoing_message_(outgoing_arena_.create<proto::HostToClient>()),
+      video_message_(std::make_unique<proto::HostToClient>())
 {
     // Nothing
 }
@@ -54,9 +125,9 @@ void ClientSessionDesktop::setDesktopSessionProxy(
 
 void ClientSessionDesktop::onMessageReceived(const base::ByteArray& buffer)
 {
-    incoming_message_->Clear();
+    incoming_message_ = incoming_arena_.resetAndCreate<proto::ClientToHost>();
 
-    if (!base::parse(buffer, incoming_message_.get()))
+    if (!base::parse(buffer, incoming_message_))
     {
         LOG(LS_ERROR) << "Invalid message from client";
         return;
@@ -67,21 +138,26 @@ void ClientSessionDesktop::onMessageReceived(const base::ByteArray& buffer)
         if (sessionType() != proto::SESSION_TYPE_DESKTOP_MANAGE)
             return;
 
-        if (!scale_reducer_)
+        if (video_size_.isEmpty())
             return;
 
         const proto::MouseEvent& mouse_event = incoming_message_->mouse_event();
 
-        int pos_x = static_cast<int>(
-            static_cast<double>(mouse_event.x() * 100) / scale_reducer_->scaleFactorX());
-        int pos_y = static_cast<int>(
-            static_cast<double>(mouse_event.y() * 100) / scale_reducer_->scaleFactorY());
+        // The client sends coordinates in the video which can be scaled down from the screen.
+        int pos_x = static_cast<int>(static_cast<double>(mouse_event.x()) *
+            source_size_.width() / video_size_.width());
+        int pos_y = static_cast<int>(static_cast<double>(mouse_event.y()) *
+            source_size_.height() / video_size_.height());
 
         proto::MouseEvent out_mouse_event;
         out_mouse_event.set_mask(mouse_event.mask());
         out_mouse_event.set_x(pos_x);
         out_mouse_event.set_y(pos_y);
 
+        injected_positions_.emplace_back(pos_x, pos_y);
+        if (injected_positions_.size() > kMaxInjectedPositions)
+            injected_positions_.pop_front();
+
         desktop_session_proxy_->injectMouseEvent(out_mouse_event);
     }
     else if (incoming_message_->has_key_event())
@@ -92,7 +168,17 @@ void ClientSessionDesktop::onMessageReceived(const base::ByteArray& buffer)
     else if (incoming_message_->has_clipboard_event())
     {
         if (sessionType() == proto::SESSION_TYPE_DESKTOP_MANAGE)
-            desktop_session_proxy_->injectClipboardEvent(incoming_message_->clipboard_event());
+        {
+            std::optional<proto::ClipboardEvent> event =
+                clipboard_chunker_.addPart(incoming_message_->clipboard_event());
+            if (event.has_value())
+            {
+                if (event->type() == proto::ClipboardEvent::TYPE_REQUEST)
+                    requested_clipboard_serial_ = event->serial();
+
+                desktop_session_proxy_->injectClipboardEvent(*event);
+            }
+        }
     }
     else if (incoming_message_->has_extension())
     {
@@ -111,11 +197,29 @@ void ClientSessionDesktop::onMessageReceived(const base::ByteArray& buffer)
 
 void ClientSessionDesktop::onMessageWritten(size_t /* pending */)
 {
-    // Nothing
+    updateRateControl();
+}
+
+void ClientSessionDesktop::onEstimateChanged(
+    const base::ChannelEstimator::Estimate& /* estimate */)
+{
+    updateRateControl();
+}
+
+void ClientSessionDesktop::onWritable()
+{
+    // All sent messages have been passed to the system and the channel is ready for the next
+    // frame.
+    updateRateControl();
 }
 
 void ClientSessionDesktop::onStarted()
 {
+    // Video that the system can not send right away waits in the queue of the channel, where the
+    // rate control sees it, and not in the send buffer of the system.
+    if (!channel().setWriteLowWatermark(kWriteLowWatermark))
+        LOG(LS_WARNING) << "Failed to set write low watermark";
+
     const char* extensions;
 
     // Supported extensions are different for managing and viewing the desktop.
@@ -134,7 +238,12 @@ void ClientSessionDesktop::onStarted()
 
     // Add supported extensions and video encodings.
     request->set_extensions(extensions);
-    request->set_video_encodings(common::kSupportedVideoEncodings);
+
+    uint32_t video_encodings = common::kSupportedVideoEncodings;
+    if (base::VideoEncoderMF::isSupported())
+        video_encodings |= proto::VIDEO_ENCODING_H264;
+
+    request->set_video_encodings(video_encodings);
     request->set_audio_encodings(common::kSupportedAudioEncodings);
 
     LOG(LS_INFO) << "Sending config request";
@@ -143,20 +252,53 @@ void ClientSessionDesktop::onStarted()
     LOG(LS_INFO) << "Supported audio encodings: " << request->audio_encodings();
 
     // Send the request.
-    sendMessage(base::serialize(*outgoing_message_));
+    sendMessage(*outgoing_message_);
 }
 
-void ClientSessionDesktop::encodeScreen(const base::Frame* frame, const base::MouseCursor* cursor)
+void ClientSessionDesktop::requestScreen(const base::Frame* frame,
+                                         VideoEncoderCache* encoder_cache)
 {
-    outgoing_message_->Clear();
+    TRACE_EVENT("host", "ClientSessionDesktop::requestScreen");
+
+    video_requested_ = false;
+
+    // The frames without changes only let the encoder improve the static areas.
+    const bool has_changes = frame && frame->hasChanges();
+
+    if (has_changes && !video_paused_ && channel().pendingBytes() > pendingVideoBudget())
+    {
+        // Each delta frame depends on the previous ones, so all the queued video packets are
+        // dropped together and the video starts again with a key frame of the current screen.
+        const size_t discarded = channel().discardQueued();
+        dropped_frames_ += discarded;
+        video_restart_ = true;
+
+        const size_t pending_bytes = channel().pendingBytes();
 
-    if (frame && video_encoder_ && scale_reducer_)
+        LOG(LS_WARNING) << "Send queue is over the budget. " << discarded
+                        << " stale video packets discarded (" << pending_bytes
+                        << " bytes still pending)";
+
+        // If the rest of the queue is still too large, the video waits until it drains.
+        if (pending_bytes > pendingVideoBudget())
+            video_paused_ = true;
+    }
+
+    if (has_changes && video_paused_)
+    {
+        // The packets of the shared encoder are skipped, so the video is resumed from scratch.
+        video_restart_ = true;
+        ++dropped_frames_;
+    }
+
+    if (frame && !video_paused_ && video_encoding_ != proto::VIDEO_ENCODING_UNKNOWN)
     {
         if (source_size_ != frame->size())
         {
             // Every time we change the resolution, we have to reset the preferred size.
             source_size_ = frame->size();
             preferred_size_ = base::Size();
+            viewport_ = base::Rect();
         }
 
         base::Size current_size = preferred_size_;
@@ -172,82 +314,251 @@ void ClientSessionDesktop::encodeScreen(const base::Frame* frame, const base::Mo
         if (current_size.isEmpty())
             current_size = source_size_;
 
-        const base::Frame* scaled_frame = scale_reducer_->scaleFrame(frame, current_size);
-        if (!scaled_frame)
+        base::VideoRateController::Settings settings = rate_controller_->settings();
+        std::chrono::milliseconds frame_interval = std::chrono::milliseconds::zero();
+
+        if (preview_)
         {
-            LOG(LS_ERROR) << "No scaled frame";
-            return;
+            // The frame is scaled down before the conversion of colors by the encoder.
+            current_size = previewSize(current_size);
+            settings.bitrate = std::min(settings.bitrate, kPreviewBitrate);
+            frame_interval = kPreviewInterval;
         }
 
-        proto::VideoPacket* packet = outgoing_message_->mutable_video_packet();
+        if (hidden_)
+            frame_interval = kHiddenInterval;
+
+        // The frame is encoded into a video packet later together with the other clients (or the
+        // packet encoded for another client is taken).
+        encoder_cache->request(id(), video_encoding_, full_chroma_, frame, current_size,
+                               frame_interval, viewport_, settings, video_restart_);
+        video_restart_ = false;
+        video_requested_ = true;
+        requested_size_ = current_size;
+    }
+}
+
+void ClientSessionDesktop::sendScreen(const base::Frame* frame,
+                                      const base::MouseCursor* cursor,
+                                      VideoEncoderCache* encoder_cache,
+                                      base::CursorEncoder::SharedCache* cursor_cache)
+{
+    TRACE_EVENT("host", "ClientSessionDesktop::sendScreen");
 
-        // Encode the frame into a video packet.
-        video_encoder_->encode(scaled_frame, packet);
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::HostToClient>();
+    bool has_video_packet = false;
 
-        if (packet->has_format())
+    if (frame && video_requested_)
+    {
+        encode_end_time_ = std::chrono::steady_clock::now();
+
+        const proto::VideoPacket* encoded_packet = encoder_cache->packet(id());
+        if (encoded_packet)
         {
-            proto::VideoPacketFormat* format = packet->mutable_format();
-
-            // In video packets that contain the format, we pass the screen capture type.
-            format->set_capturer_type(frame->capturerType());
-
-            // Real screen size.
-            proto::Size* screen_size = format->mutable_screen_size();
-            screen_size->set_width(frame->size().width());
-            screen_size->set_height(frame->size().height());
-
-            LOG(LS_INFO) << "Video packet has format";
-            LOG(LS_INFO) << "Capturer type: " << base::ScreenCapturer::typeToString(
-                static_cast<base::ScreenCapturer::Type>(frame->capturerType()));
-            LOG(LS_INFO) << "Screen size: " << screen_size->width() << "x"
-                         << screen_size->height();
-            LOG(LS_INFO) << "Video size: " << format->video_rect().width() << "x"
-                         << format->video_rect().height();
+            video_size_ = requested_size_;
+
+            // The packet of the previous frame is overwritten, its buffers are reused.
+            proto::VideoPacket* packet = video_message_->mutable_video_packet();
+            packet->CopyFrom(*encoded_packet);
+            has_video_packet = true;
+
+            if (packet->has_format())
+            {
+                proto::VideoPacketFormat* format = packet->mutable_format();
+
+                // In video packets that contain the format, we pass the screen capture type.
+                format->set_capturer_type(frame->capturerType());
+
+                // Real screen size.
+                proto::Size* screen_size = format->mutable_screen_size();
+                screen_size->set_width(frame->size().width());
+                screen_size->set_height(frame->size().height());
+
+                LOG(LS_INFO) << "Video packet has format";
+                LOG(LS_INFO) << "Capturer type: " << base::ScreenCapturer::typeToString(
+                    static_cast<base::ScreenCapturer::Type>(frame->capturerType()));
+                LOG(LS_INFO) << "Screen size: " << screen_size->width() << "x"
+                             << screen_size->height();
+                LOG(LS_INFO) << "Video size: " << format->video_rect().width() << "x"
+                             << format->video_rect().height();
+            }
         }
     }
 
     if (cursor && cursor_encoder_)
     {
-        if (!cursor_encoder_->encode(*cursor, outgoing_message_->mutable_cursor_shape()))
+        if (!cursor_encoder_->encode(
+                *cursor, outgoing_message_->mutable_cursor_shape(), cursor_cache))
             outgoing_message_->clear_cursor_shape();
     }
 
-    if (outgoing_message_->has_video_packet() || outgoing_message_->has_cursor_shape())
-        sendMessage(base::serialize(*outgoing_message_));
+    if (frame && send_cursor_position_)
+        encodeCursorPosition(frame->cursorPosition());
+
+    if (has_video_packet)
+    {
+        // The video packet may be discarded from the queue (see discardQueued()), so it is sent
+        // apart from the cursor. The cursor shapes are cached by the client and can not be lost.
+        setSendTiming(video_message_->mutable_video_packet()->mutable_timing());
+        channel().sendDiscardable(*video_message_);
+    }
+
+    if (outgoing_message_->has_cursor_shape() || outgoing_message_->has_cursor_position())
+    {
+        // A message with only the cursor is small and can go ahead of the queued video.
+        sendMessage(*outgoing_message_, base::NetworkChannel::Priority::HIGH);
+    }
+}
+
+void ClientSessionDesktop::sendCursorPosition(const base::Point& position)
+{
+    if (!send_cursor_position_)
+        return;
+
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::HostToClient>();
+
+    encodeCursorPosition(position);
+
+    // The position goes ahead of the queued video, so the cursor moves smoothly even if the video
+    // is slow.
+    if (outgoing_message_->has_cursor_position())
+        sendMessage(*outgoing_message_, base::NetworkChannel::Priority::HIGH);
 }
 
-void ClientSessionDesktop::encodeAudio(const proto::AudioPacket& audio_packet)
+void ClientSessionDesktop::encodeCursorPosition(const std::optional<base::Point>& position)
 {
-    if (!audio_encoder_)
+    if (!position.has_value() || source_size_.isEmpty() || video_size_.isEmpty())
         return;
 
-    outgoing_message_->Clear();
+    if (last_cursor_position_ == position)
+        return;
+
+    last_cursor_position_ = position;
+
+    // The client draws the cursor itself at the position of its local mouse. If the cursor is at
+    // a position injected by the client, the frame shows the cursor moved by the client (may be a
+    // few moves behind) and the client already knows it.
+    auto is_injected = [&position](const base::Point& injected)
+    {
+        return std::abs(injected.x() - position->x()) <= kInjectedPositionTolerance &&
+               std::abs(injected.y() - position->y()) <= kInjectedPositionTolerance;
+    };
 
-    if (!audio_encoder_->encode(audio_packet, outgoing_message_->mutable_audio_packet()))
+    if (std::any_of(injected_positions_.cbegin(), injected_positions_.cend(), is_injected))
         return;
 
-    sendMessage(base::serialize(*outgoing_message_));
+    proto::CursorPosition* cursor_position = outgoing_message_->mutable_cursor_position();
+    cursor_position->set_x(static_cast<int>(static_cast<double>(position->x()) *
+        video_size_.width() / source_size_.width()));
+    cursor_position->set_y(static_cast<int>(static_cast<double>(position->y()) *
+        video_size_.height() / source_size_.height()));
+}
+
+std::chrono::milliseconds ClientSessionDesktop::captureInterval() const
+{
+    if (hidden_)
+        return kHiddenInterval;
+
+    if (preview_)
+        return kPreviewInterval;
+
+    return rate_controller_->settings().capture_interval;
+}
+
+void ClientSessionDesktop::encodeAudio(const proto::AudioPacket& audio_packet,
+                                       AudioEncoderCache* encoder_cache)
+{
+    if (audio_encoding_ == proto::AUDIO_ENCODING_UNKNOWN)
+        return;
+
+    // Audio follows the video bitrate so that it does not take the bandwidth of a slow channel.
+    // The encoder keeps the bitrate within the range it supports.
+    const int bitrate =
+        static_cast<int>(rate_controller_->settings().bitrate * 1000 / kAudioBitrateShare);
+
+    const proto::AudioPacket* encoded_packet = encoder_cache->encode(
+        id(), audio_encoding_, audio_frame_duration_, bitrate, audio_packet);
+    if (!encoded_packet)
+        return;
+
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::HostToClient>();
+    outgoing_message_->mutable_audio_packet()->CopyFrom(*encoded_packet);
+    sendMessage(*outgoing_message_);
 }
 
 void ClientSessionDesktop::setScreenList(const proto::ScreenList& list)
 {
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::HostToClient>();
 
     proto::DesktopExtension* extension = outgoing_message_->mutable_extension();
     extension->set_name(common::kSelectScreenExtension);
     extension->set_data(list.SerializeAsString());
 
-    sendMessage(base::serialize(*outgoing_message_));
+    sendMessage(*outgoing_message_);
 }
 
 void ClientSessionDesktop::injectClipboardEvent(const proto::ClipboardEvent& event)
 {
-    if (sessionType() == proto::SESSION_TYPE_DESKTOP_MANAGE)
+    if (sessionType() != proto::SESSION_TYPE_DESKTOP_MANAGE)
+        return;
+
+    switch (event.type())
+    {
+        case proto::ClipboardEvent::TYPE_ANNOUNCE:
+        {
+            if (!clipboard_lazy_supported_)
+            {
+                // The client receives only the data. Request it immediately.
+                requested_clipboard_serial_ = event.serial();
+
+                proto::ClipboardEvent request;
+                request.set_type(proto::ClipboardEvent::TYPE_REQUEST);
+                request.set_serial(event.serial());
+                desktop_session_proxy_->injectClipboardEvent(request);
+                return;
+            }
+        }
+        break;
+
+        case proto::ClipboardEvent::TYPE_REQUEST:
+        {
+            // The request is for data announced by another client.
+            if (!clipboard_lazy_supported_)
+                return;
+        }
+        break;
+
+        default:
+        {
+            // The data is sent to all clients. Only the client which requested it receives it.
+            if (event.serial())
+            {
+                if (event.serial() != requested_clipboard_serial_)
+                    return;
+
+                requested_clipboard_serial_ = 0;
+            }
+        }
+        break;
+    }
+
+    if (!clipboard_chunks_supported_)
     {
-        outgoing_message_->Clear();
+        outgoing_message_ = outgoing_arena_.resetAndCreate<proto::HostToClient>();
 
         outgoing_message_->mutable_clipboard_event()->CopyFrom(event);
-        sendMessage(base::serialize(*outgoing_message_));
+        sendMessage(*outgoing_message_);
+        return;
+    }
+
+    // The clipboard is sent after the video and the input queued at the same time. Small events
+    // have the same priority as the parts, so they are not mixed with the parts of a large one.
+    for (proto::ClipboardEvent& part : common::ClipboardChunker::split(event))
+    {
+        outgoing_message_ = outgoing_arena_.resetAndCreate<proto::HostToClient>();
+
+        outgoing_message_->mutable_clipboard_event()->Swap(&part);
+        sendMessage(*outgoing_message_, base::NetworkChannel::Priority::LOW);
     }
 }
 
@@ -265,6 +576,7 @@ void ClientSessionDesktop::readExtension(const proto::DesktopExtension& extensio
 
         desktop_session_proxy_->selectScreen(screen);
         preferred_size_ = base::Size();
+        viewport_ = base::Rect();
     }
     else if (extension.name() == common::kPreferredSizeExtension)
     {
@@ -290,8 +602,60 @@ void ClientSessionDesktop::readExtension(const proto::DesktopExtension& extensio
                      << preferred_size.width() << "x" << preferred_size.height();
 
         preferred_size_.set(preferred_size.width(), preferred_size.height());
+        viewport_ = base::Rect();
         desktop_session_proxy_->captureScreen();
     }
+    else if (extension.name() == common::kViewportExtension)
+    {
+        proto::Viewport viewport;
+
+        if (!viewport.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse viewport extension data";
+            return;
+        }
+
+        static const int kMaxScreenSize = std::numeric_limits<int16_t>::max();
+
+        if (viewport.x() < 0 || viewport.x() > kMaxScreenSize ||
+            viewport.y() < 0 || viewport.y() > kMaxScreenSize ||
+            viewport.width() < 0 || viewport.width() > kMaxScreenSize ||
+            viewport.height() < 0 || viewport.height() > kMaxScreenSize)
+        {
+            LOG(LS_ERROR) << "Invalid viewport: " << viewport.x() << "," << viewport.y() << " "
+                          << viewport.width() << "x" << viewport.height();
+            return;
+        }
+
+        viewport_ = base::Rect::makeXYWH(
+            viewport.x(), viewport.y(), viewport.width(), viewport.height());
+
+        // The areas which became visible are sent with the next frame.
+        desktop_session_proxy_->captureScreen();
+    }
+    else if (extension.name() == common::kVisibilityExtension)
+    {
+        proto::Visibility visibility;
+
+        if (!visibility.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse visibility extension data";
+            return;
+        }
+
+        if (hidden_ == !visibility.visible())
+            return;
+
+        hidden_ = !visibility.visible();
+        LOG(LS_INFO) << "Client window is " << (hidden_ ? "hidden" : "visible");
+
+        if (!hidden_)
+        {
+            // The client gets the current screen right away instead of the next rare update.
+            video_restart_ = true;
+            desktop_session_proxy_->captureScreen();
+        }
+    }
     else if (extension.name() == common::kPowerControlExtension)
     {
         if (sessionType() != proto::SESSION_TYPE_DESKTOP_MANAGE)
@@ -344,16 +708,46 @@ void ClientSessionDesktop::readExtension(const proto::DesktopExtension& extensio
     }
     else if (extension.name() == common::kSystemInfoExtension)
     {
-        proto::SystemInfo system_info;
-        createSystemInfo(&system_info);
+        proto::SystemInfoRequest request;
+
+        if (!extension.data().empty() && !request.ParseFromString(extension.data()))
+        {
+            LOG(LS_ERROR) << "Unable to parse system info request";
+            return;
+        }
+
+        // The information is collected on a background thread and is sent from there.
+        std::shared_ptr<base::NetworkChannelProxy> channel_proxy = channelProxy();
 
-        outgoing_message_->Clear();
+        SystemInfoCache::instance()->request(request.categories(), request.refresh(),
+            [channel_proxy](const proto::SystemInfo& system_info)
+        {
+            proto::HostToClient message;
+
+            proto::DesktopExtension* desktop_extension = message.mutable_extension();
+            desktop_extension->set_name(common::kSystemInfoExtension);
+            desktop_extension->set_data(system_info.SerializeAsString());
 
-        proto::DesktopExtension* desktop_extension = outgoing_message_->mutable_extension();
-        desktop_extension->set_name(common::kSystemInfoExtension);
-        desktop_extension->set_data(system_info.SerializeAsString());
+            channel_proxy->send(message);
+        });
+    }
+    else if (extension.name() == common::kVideoRecoveryExtension)
+    {
+        LOG(LS_INFO) << "Video recovery requested";
 
-        sendMessage(base::serialize(*outgoing_message_));
+        // The client has dropped video packets. The next frame is encoded from scratch.
+        video_restart_ = true;
+        desktop_session_proxy_->captureScreen();
+    }
+    else if (extension.name() == common::kClipboardChunksExtension)
+    {
+        LOG(LS_INFO) << "Client receives the clipboard in parts";
+        clipboard_chunks_supported_ = true;
+    }
+    else if (extension.name() == common::kClipboardLazyExtension)
+    {
+        LOG(LS_INFO) << "Client requests the clipboard data on paste";
+        clipboard_lazy_supported_ = true;
     }
     else
     {
@@ -363,63 +757,63 @@ void ClientSessionDesktop::readExtension(const proto::DesktopExtension& extensio
 
 void ClientSessionDesktop::readConfig(const proto::DesktopConfig& config)
 {
-    switch (config.video_encoding())
+    if (!VideoEncoderCache::isSupported(config.video_encoding()))
     {
-        case proto::VIDEO_ENCODING_VP8:
-            video_encoder_ = base::VideoEncoderVPX::createVP8();
-            break;
+        // No supported video encoding.
+        LOG(LS_ERROR) << "Unsupported video encoding: " << config.video_encoding();
+        return;
+    }
 
-        case proto::VIDEO_ENCODING_VP9:
-            video_encoder_ = base::VideoEncoderVPX::createVP9();
-            break;
+    video_encoding_ = config.video_encoding();
+    video_restart_ = true;
+    preview_ = (config.flags() & proto::PREVIEW_MODE);
 
-        default:
-        {
-            // No supported video encoding.
-            LOG(LS_WARNING) << "Unsupported video encoding: " << config.video_encoding();
-        }
-        break;
-    }
+    // Only VP9 has a profile with the full chroma. A thumbnail does not need it.
+    full_chroma_ = (config.flags() & proto::FULL_CHROMA) &&
+                   video_encoding_ == proto::VIDEO_ENCODING_VP9 && !preview_;
 
-    if (!video_encoder_)
-    {
-        LOG(LS_ERROR) << "Video encoder not initialized!";
-        return;
-    }
+    // The new encoder starts with the default parameters.
+    rate_controller_->reset();
 
     switch (config.audio_encoding())
     {
         case proto::AUDIO_ENCODING_OPUS:
-            audio_encoder_ = std::make_unique<base::AudioEncoderOpus>();
-            break;
+        {
+            std::chrono::milliseconds frame_duration(config.audio_frame_duration());
+            if (!base::AudioEncoderOpus::isSupportedFrameDuration(frame_duration))
+                frame_duration = base::AudioEncoderOpus::kDefaultFrameDuration;
+
+            audio_encoding_ = proto::AUDIO_ENCODING_OPUS;
+            audio_frame_duration_ = frame_duration;
+        }
+        break;
 
         default:
         {
             LOG(LS_WARNING) << "Unsupported audio encoding: " << config.audio_encoding();
-            audio_encoder_.reset();
+            audio_encoding_ = proto::AUDIO_ENCODING_UNKNOWN;
         }
         break;
     }
 
+    // A preview has no sound.
+    if (preview_)
+        audio_encoding_ = proto::AUDIO_ENCODING_UNKNOWN;
+
     cursor_encoder_.reset();
     if (config.flags() & proto::ENABLE_CURSOR_SHAPE)
         cursor_encoder_ = std::make_unique<base::CursorEncoder>();
 
-    scale_reducer_ = std::make_unique<base::ScaleReducer>();
+    send_cursor_position_ = (config.flags() & proto::ENABLE_CURSOR_POSITION);
+    last_cursor_position_.reset();
 
-    desktop_session_config_.disable_font_smoothing =
-        (config.flags() & proto::DISABLE_FONT_SMOOTHING);
-    desktop_session_config_.disable_effects =
-        (config.flags() & proto::DISABLE_DESKTOP_EFFECTS);
-    desktop_session_config_.disable_wallpaper =
-        (config.flags() & proto::DISABLE_DESKTOP_WALLPAPER);
-    desktop_session_config_.block_input =
-        (config.flags() & proto::BLOCK_REMOTE_INPUT);
-    desktop_session_config_.lock_at_disconnect =
-        (config.flags() & proto::LOCK_AT_DISCONNECT);
+    desktop_flags_ = config.flags();
+    updateDesktopSessionConfig();
 
     LOG(LS_INFO) << "Client configuration changed";
     LOG(LS_INFO) << "Video encoding: " << config.video_encoding();
+    LOG(LS_INFO) << "Preview mode: " << preview_;
+    LOG(LS_INFO) << "Full chroma: " << full_chroma_;
     LOG(LS_INFO) << "Enable cursor shape: " << (cursor_encoder_ != nullptr);
     LOG(LS_INFO) << "Disable font smoothing: " << desktop_session_config_.disable_font_smoothing;
     LOG(LS_INFO) << "Disable desktop effects: " << desktop_session_config_.disable_effects;
@@ -430,4 +824,115 @@ void ClientSessionDesktop::readConfig(const proto::DesktopConfig& config)
     delegate_->onClientSessionConfigured();
 }
 
+void ClientSessionDesktop::setSendTiming(proto::VideoPacketTiming* timing) const
+{
+    using Microseconds = std::chrono::microseconds;
+
+    timing->set_enqueue(static_cast<uint32_t>(std::chrono::duration_cast<Microseconds>(
+        std::chrono::steady_clock::now() - encode_end_time_).count()));
+
+    // The time in the send queue of this packet is not known yet. The average of the previous
+    // messages is sent instead.
+    timing->set_send(static_cast<uint32_t>(std::chrono::duration_cast<Microseconds>(
+        channel().estimate().queue_delay).count()));
+}
+
+size_t ClientSessionDesktop::pendingVideoBudget() const
+{
+    const int64_t bandwidth = channel().estimate().bandwidth;
+    if (bandwidth <= 0)
+        return kMaxPendingVideoBytes;
+
+    const size_t budget = static_cast<size_t>(bandwidth * kMaxQueueDelay.count());
+    return std::clamp(budget, kMinPendingVideoBytes, kMaxPendingVideoBytes);
+}
+
+void ClientSessionDesktop::updateRateControl()
+{
+    if (video_encoding_ == proto::VIDEO_ENCODING_UNKNOWN)
+        return;
+
+    const base::NetworkChannel& network_channel = channel();
+
+    if (video_paused_ && network_channel.pendingBytes() < pendingVideoBudget() / 2)
+    {
+        LOG(LS_INFO) << "Send queue has drained. Video is resumed (" << dropped_frames_
+                     << " frames dropped in total)";
+        video_paused_ = false;
+
+        // The screen may not change, so the key frame is requested right away.
+        desktop_session_proxy_->captureScreen();
+    }
+
+    // The bitrate, the quantizer range and the capture interval are chosen so that the queue of
+    // outgoing messages stays close to empty. The encoder gets the new settings with the next
+    // frame (see VideoEncoderCache).
+    rate_controller_->update(base::VideoRateController::Clock::now(),
+                             network_channel.pendingBytes(),
+                             network_channel.estimate().bandwidth);
+
+    updateLinkState();
+}
+
+void ClientSessionDesktop::updateLinkState()
+{
+    // A preview is small anyway and must not change the desktop for the other clients.
+    if (preview_)
+        return;
+
+    const base::ChannelEstimator::Estimate& estimate = channel().estimate();
+
+    bool changing;
+    if (low_bandwidth_)
+    {
+        changing = estimate.bandwidth >= kRecoveredBandwidth && estimate.rtt < kHighRtt / 2;
+    }
+    else
+    {
+        changing = (estimate.bandwidth > 0 && estimate.bandwidth < kLowBandwidth) ||
+                   estimate.rtt > kHighRtt;
+    }
+
+    if (!changing)
+    {
+        link_change_time_.reset();
+        return;
+    }
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (!link_change_time_.has_value())
+    {
+        link_change_time_ = now;
+        return;
+    }
+
+    if (now - *link_change_time_ < (low_bandwidth_ ? kRecoveredDelay : kDegradedDelay))
+        return;
+
+    link_change_time_.reset();
+    low_bandwidth_ = !low_bandwidth_;
+
+    LOG(LS_INFO) << "Link of the client is " << (low_bandwidth_ ? "degraded" : "recovered")
+                 << " (bandwidth: " << estimate.bandwidth << " B/s, RTT: "
+                 << estimate.rtt.count() << " ms). Desktop optimizations are "
+                 << (low_bandwidth_ ? "enabled" : "restored");
+
+    updateDesktopSessionConfig();
+    delegate_->onClientSessionConfigured();
+}
+
+void ClientSessionDesktop::updateDesktopSessionConfig()
+{
+    uint32_t flags = desktop_flags_;
+    if (low_bandwidth_)
+        flags |= kLowBandwidthFlags;
+
+    desktop_session_config_.disable_font_smoothing = (flags & proto::DISABLE_FONT_SMOOTHING);
+    desktop_session_config_.disable_effects = (flags & proto::DISABLE_DESKTOP_EFFECTS);
+    desktop_session_config_.disable_wallpaper = (flags & proto::DISABLE_DESKTOP_WALLPAPER);
+    desktop_session_config_.block_input = (flags & proto::BLOCK_REMOTE_INPUT);
+    desktop_session_config_.lock_at_disconnect = (flags & proto::LOCK_AT_DISCONNECT);
+}
+
 } // namespace host
@@ -20,22 +20,27 @@
 #define HOST__CLIENT_SESSION_DESKTOP_H
 
 #include "base/macros_magic.h"
+#include "base/codec/cursor_encoder.h"
 #include "base/desktop/geometry.h"
+#include "base/memory/message_arena.h"
+#include "common/clipboard_chunker.h"
 #include "host/client_session.h"
 #include "host/desktop_session.h"
 
+#include <deque>
+#include <optional>
+
 namespace base {
-class AudioEncoder;
-class CursorEncoder;
 class Frame;
 class MouseCursor;
-class ScaleReducer;
-class VideoEncoder;
+class VideoRateController;
 } // namespace base
 
 namespace host {
 
+class AudioEncoderCache;
 class DesktopSessionProxy;
+class VideoEncoderCache;
 
 class ClientSessionDesktop : public ClientSession
 {
@@ -46,17 +51,44 @@ public:
 
     void setDesktopSessionProxy(std::shared_ptr<DesktopSessionProxy> desktop_session_proxy);
 
-    void encodeScreen(const base::Frame* frame, const base::MouseCursor* cursor);
-    void encodeAudio(const proto::AudioPacket& audio_packet);
+    // Video packets are made by |encoder_cache| and cursor shapes are compressed once in
+    // |cursor_cache|. Both are shared by all the desktop clients of the user session. All the
+    // clients request the video packet of the frame first, then the cache encodes the frame (see
+    // VideoEncoderCache::encodeFrames()) and the clients send the packets.
+    void requestScreen(const base::Frame* frame, VideoEncoderCache* encoder_cache);
+    void sendScreen(const base::Frame* frame,
+                    const base::MouseCursor* cursor,
+                    VideoEncoderCache* encoder_cache,
+                    base::CursorEncoder::SharedCache* cursor_cache);
+
+    // Sends the position of the cursor moved between the frames (in the coordinates of the
+    // frame) without waiting for the next video packet.
+    void sendCursorPosition(const base::Point& position);
+
+    // Audio packets are made by |encoder_cache|, which is shared by all the desktop clients of the
+    // user session.
+    void encodeAudio(const proto::AudioPacket& audio_packet, AudioEncoderCache* encoder_cache);
+
     void setScreenList(const proto::ScreenList& list);
     void injectClipboardEvent(const proto::ClipboardEvent& event);
 
     const DesktopSession::Config& desktopSessionConfig() const { return desktop_session_config_; }
 
+    // Interval between screen captures which the network channel of the client can carry.
+    std::chrono::milliseconds captureInterval() const;
+
+    // The client shows a thumbnail of the desktop (see proto::PREVIEW_MODE).
+    bool isPreview() const { return preview_; }
+
+    // The window of the client is minimized or hidden (see proto::Visibility).
+    bool isHidden() const { return hidden_; }
+
 protected:
     // net::Listener implementation.
     void onMessageReceived(const base::ByteArray& buffer) override;
     void onMessageWritten(size_t pending) override;
+    void onEstimateChanged(const base::ChannelEstimator::Estimate& estimate) override;
+    void onWritable() override;
 
     // ClientSession implementation.
     void onStarted() override;
@@ -64,18 +96,94 @@ protected:
 private:
     void readExtension(const proto::DesktopExtension& extension);
     void readConfig(const proto::DesktopConfig& config);
+    void updateRateControl();
+
+    // Enables or restores the desktop optimizations when the link of the client degrades or
+    // recovers.
+    void updateLinkState();
+    void updateDesktopSessionConfig();
+
+    // Returns the size of the send queue at which the queued video is considered stale.
+    size_t pendingVideoBudget() const;
+    void setSendTiming(proto::VideoPacketTiming* timing) const;
+    void encodeCursorPosition(const std::optional<base::Point>& position);
 
     std::shared_ptr<DesktopSessionProxy> desktop_session_proxy_;
-    std::unique_ptr<base::ScaleReducer> scale_reducer_;
-    std::unique_ptr<base::VideoEncoder> video_encoder_;
+    proto::VideoEncoding video_encoding_ = proto::VIDEO_ENCODING_UNKNOWN;
+
+    // The client has sent a new configuration and must start with a key frame.
+    bool video_restart_ = false;
+
+    // The client gets a small video with a low frame rate.
+    bool preview_ = false;
+
+    // The VP9 video has no chroma subsampling (see proto::FULL_CHROMA).
+    bool full_chroma_ = false;
+
+    // The window of the client is hidden. The video is updated no more often than once in
+    // kHiddenInterval.
+    bool hidden_ = false;
+
+    // Video is not sent while the send queue is over the budget even after the stale video packets
+    // are discarded (see pendingVideoBudget()).
+    bool video_paused_ = false;
+    uint64_t dropped_frames_ = 0;
+
+    // End of the encoding of the current frame (for the latency statistics).
+    std::chrono::steady_clock::time_point encode_end_time_;
+
+    std::unique_ptr<base::VideoRateController> rate_controller_;
     std::unique_ptr<base::CursorEncoder> cursor_encoder_;
-    std::unique_ptr<base::AudioEncoder> audio_encoder_;
+    proto::AudioEncoding audio_encoding_ = proto::AUDIO_ENCODING_UNKNOWN;
+    std::chrono::milliseconds audio_frame_duration_ = std::chrono::milliseconds::zero();
     DesktopSession::Config desktop_session_config_;
+
+    // proto::DesktopFlags requested by the client.
+    uint32_t desktop_flags_ = 0;
+
+    // The link of the client is degraded and the desktop optimizations are enabled regardless of
+    // |desktop_flags_|. |link_change_time_| is the time when the link started to degrade or
+    // recover.
+    bool low_bandwidth_ = false;
+    std::optional<std::chrono::steady_clock::time_point> link_change_time_;
     base::Size source_size_;
     base::Size preferred_size_;
 
-    std::unique_ptr<proto::ClientToHost> incoming_message_;
-    std::unique_ptr<proto::HostToClient> outgoing_message_;
+    // Visible area of the video in the window of the client (empty if the whole video is visible).
+    base::Rect viewport_;
+
+    // Size of the video which the client receives.
+    base::Size video_size_;
+
+    // The video packet of the current frame is requested from the encoder cache in the size.
+    bool video_requested_ = false;
+    base::Size requested_size_;
+
+    // The client draws the cursor locally. The position of the cursor is sent only if the cursor is
+    // moved on the host by something other than the input of the client.
+    bool send_cursor_position_ = false;
+    std::optional<base::Point> last_cursor_position_;
+    std::deque<base::Point> injected_positions_;
+
+    // Large clipboard data is sent in parts if the client can receive them.
+    bool clipboard_chunks_supported_ = false;
+    common::ClipboardChunker clipboard_chunker_;
+
+    // Only announcements of the clipboard are sent if the client requests the data itself.
+    // Otherwise the data is requested on behalf of the client.
+    bool clipboard_lazy_supported_ = false;
+    uint32_t requested_clipboard_serial_ = 0;
+
+    // The messages are created again in their arenas for every message instead of being cleared
+    // (Clear() frees all the nested messages and their fields).
+    base::MessageArena incoming_arena_;
+    proto::ClientToHost* incoming_message_;
+    base::MessageArena outgoing_arena_;
+    proto::HostToClient* outgoing_message_;
+
+    // Video packets are sent in their own message. The packet is not cleared between the frames,
+    // so its buffers keep their capacity (see sendScreen()).
+    std::unique_ptr<proto::HostToClient> video_message_;
 
     DISALLOW_COPY_AND_ASSIGN(ClientSessionDesktop);
 };
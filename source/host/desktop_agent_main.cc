@@ -21,6 +21,7 @@
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/message_loop/message_loop.h"
+#include "base/threading/thread_profile.h"
 #include "host/desktop_session_agent.h"
 
 void desktopAgentMain(int argc, const char* const* argv)
@@ -32,6 +33,9 @@ void desktopAgentMain(int argc, const char* const* argv)
 
     if (command_line->hasSwitch(u"channel_id"))
     {
+        // The screen is captured on the main thread of the agent.
+        base::ScopedThreadProfile thread_profile(base::ThreadProfile::CAPTURE);
+
         std::unique_ptr<base::MessageLoop> message_loop =
             std::make_unique<base::MessageLoop>(base::MessageLoop::Type::ASIO);
 
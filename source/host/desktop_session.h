@@ -21,9 +21,12 @@
 
 #include "proto/desktop_internal.pb.h"
 
+#include <chrono>
+
 namespace base {
 class Frame;
 class MouseCursor;
+class Point;
 } // namespace base
 
 namespace host {
@@ -40,8 +43,13 @@ public:
 
         virtual void onDesktopSessionStarted() = 0;
         virtual void onDesktopSessionStopped() = 0;
+        // |frame| has an empty updated region if the screen has not changed since the previous
+        // frame.
         virtual void onScreenCaptured(const base::Frame* frame, const base::MouseCursor* cursor) = 0;
         virtual void onAudioCaptured(const proto::AudioPacket& audio_packet) = 0;
+        // The cursor is moved. |position| is in the coordinates of the last frame. It may be
+        // called many times between the frames.
+        virtual void onCursorPositionChanged(const base::Point& position) = 0;
         virtual void onScreenListChanged(const proto::ScreenList& list) = 0;
         virtual void onClipboardEvent(const proto::ClipboardEvent& event) = 0;
     };
@@ -71,6 +79,7 @@ public:
     virtual void configure(const Config& config) = 0;
     virtual void selectScreen(const proto::Screen& screen) = 0;
     virtual void captureScreen() = 0;
+    virtual void setCaptureInterval(const std::chrono::milliseconds& interval) = 0;
 
     virtual void injectKeyEvent(const proto::KeyEvent& event) = 0;
     virtual void injectMouseEvent(const proto::MouseEvent& event) = 0;
@@ -25,15 +25,91 @@
 #include "base/desktop/mouse_cursor.h"
 #include "base/desktop/screen_capturer_wrapper.h"
 #include "base/desktop/shared_frame.h"
+#include "base/desktop/win/screen_capture_utils.h"
 #include "base/ipc/shared_memory.h"
 #include "base/threading/thread.h"
+#include "base/trace_event.h"
 #include "host/input_injector_win.h"
 #include "host/system_settings.h"
 
+#include <algorithm>
+
 namespace host {
 
 namespace {
 
+// Time that the initialized screen capturer is kept after the last client is disconnected.
+const std::chrono::minutes kIdleCapturerTimeout { 5 };
+
+// Interval of the polling of the cursor position (about the refresh rate of the screen).
+const std::chrono::milliseconds kCursorPositionInterval { 16 };
+
+// Maximum time of one wait for an update of the screen. The other uses of the capturer (a new
+// client, a selection of the screen) wait no longer than this.
+const std::chrono::milliseconds kMaxUpdateWait { 100 };
+
+int64_t toMicroseconds(const std::chrono::steady_clock::time_point& time)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        time.time_since_epoch()).count();
+}
+
+// Adds the times of the capture to |serialized_frame|. The capture is finished when the frame is
+// passed to the agent.
+void serializeTiming(const std::chrono::steady_clock::time_point& capture_start,
+                     const base::Frame::Timing& timing,
+                     proto::internal::DesktopFrame* serialized_frame)
+{
+    serialized_frame->set_capture_start(toMicroseconds(capture_start));
+    serialized_frame->set_capture_end(toMicroseconds(std::chrono::steady_clock::now()));
+    serialized_frame->set_diff_time(timing.diff.count());
+}
+
+// Adds the position of the cursor and the rectangle of the foreground window (in the coordinates
+// of the frame) to |serialized_frame|.
+void serializeFocus(const base::Frame* frame, proto::internal::DesktopFrame* serialized_frame)
+{
+    // The frame is at |frame->topLeft()| relative to the top-left corner of the virtual screen.
+    const base::Point frame_pos =
+        base::ScreenCaptureUtils::fullScreenRect().topLeft().add(frame->topLeft());
+    const base::Rect frame_rect = base::Rect::makeSize(frame->size());
+
+    POINT cursor_pos;
+    if (GetCursorPos(&cursor_pos))
+    {
+        base::Point position = base::Point(cursor_pos.x, cursor_pos.y).subtract(frame_pos);
+
+        if (frame_rect.contains(position.x(), position.y()))
+        {
+            proto::internal::Point* serialized_position =
+                serialized_frame->mutable_cursor_position();
+            serialized_position->set_x(position.x());
+            serialized_position->set_y(position.y());
+        }
+    }
+
+    HWND window = GetForegroundWindow();
+    RECT window_rect;
+
+    if (window && !IsIconic(window) && GetWindowRect(window, &window_rect))
+    {
+        base::Rect rect = base::Rect::makeLTRB(
+            window_rect.left, window_rect.top, window_rect.right, window_rect.bottom);
+        rect.translate(-frame_pos.x(), -frame_pos.y());
+        rect.intersectWith(frame_rect);
+
+        // A window which covers the whole frame does not point to any part of it.
+        if (!rect.isEmpty() && rect != frame_rect)
+        {
+            proto::Rect* serialized_rect = serialized_frame->mutable_active_window_rect();
+            serialized_rect->set_x(rect.x());
+            serialized_rect->set_y(rect.y());
+            serialized_rect->set_width(rect.width());
+            serialized_rect->set_height(rect.height());
+        }
+    }
+}
+
 const char* controlActionToString(proto::internal::Control::Action action)
 {
     switch (action)
@@ -59,8 +135,12 @@ const char* controlActionToString(proto::internal::Control::Action action)
 
 DesktopSessionAgent::DesktopSessionAgent(std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(std::move(task_runner)),
-      incoming_message_(std::make_unique<proto::internal::ServiceToDesktop>()),
-      outgoing_message_(std::make_unique<proto::internal::DesktopToService>())
+      incoming_message_(incoming_arena_.create<proto::internal::ServiceToDesktop>()),
+      outgoing_message_(outgoing_arena_.create<proto::internal::DesktopToService>()),
+      capture_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner_),
+      idle_capturer_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner_,
+                           base::WaitableTimer::Precision::COARSE),
+      cursor_timer_(base::WaitableTimer::Type::REPEATED, task_runner_)
 {
     // At the end of the user's session, the program ends later than the others.
     SetProcessShutdownParameters(0, SHUTDOWN_NORETRY);
@@ -69,6 +149,7 @@ DesktopSessionAgent::DesktopSessionAgent(std::shared_ptr<base::TaskRunner> task_
     SystemSettings settings;
     preferred_video_capturer_ =
         static_cast<base::ScreenCapturer::Type>(settings.preferredVideoCapturer());
+    fake_screen_file_ = settings.fakeScreenFile();
 }
 
 DesktopSessionAgent::~DesktopSessionAgent() = default;
@@ -94,9 +175,9 @@ void DesktopSessionAgent::onDisconnected()
 
 void DesktopSessionAgent::onMessageReceived(const base::ByteArray& buffer)
 {
-    incoming_message_->Clear();
+    incoming_message_ = incoming_arena_.resetAndCreate<proto::internal::ServiceToDesktop>();
 
-    if (!base::parse(buffer, incoming_message_.get()))
+    if (!base::parse(buffer, incoming_message_))
     {
         LOG(LS_ERROR) << "Invalid message from service";
         return;
@@ -104,18 +185,30 @@ void DesktopSessionAgent::onMessageReceived(const base::ByteArray& buffer)
 
     if (incoming_message_->has_next_screen_capture())
     {
-        captureEnd(std::chrono::milliseconds(
-            incoming_message_->next_screen_capture().update_interval()));
+        // The service asks for the next frame after the previous one is encoded and sent.
+        const proto::internal::NextScreenCapture& next_screen_capture =
+            incoming_message_->next_screen_capture();
+
+        captureReleased(std::chrono::milliseconds(next_screen_capture.update_interval()),
+                        next_screen_capture.full_screen());
     }
     else if (incoming_message_->has_mouse_event())
     {
         if (input_injector_)
-            input_injector_->injectMouseEvent(incoming_message_->mouse_event());
+        {
+            addMouseEvent(incoming_message_->mouse_event());
+            onUserInput();
+        }
     }
     else if (incoming_message_->has_key_event())
     {
         if (input_injector_)
+        {
+            // The mouse events received before the key event are injected before it.
+            flushMouseEvents();
             input_injector_->injectKeyEvent(incoming_message_->key_event());
+            onUserInput();
+        }
     }
     else if (incoming_message_->has_clipboard_event())
     {
@@ -128,6 +221,7 @@ void DesktopSessionAgent::onMessageReceived(const base::ByteArray& buffer)
 
         if (screen_capturer_)
         {
+            std::scoped_lock lock(capturer_lock_);
             screen_capturer_->selectScreen(static_cast<base::ScreenCapturer::ScreenId>(
                 incoming_message_->select_source().screen().id()));
         }
@@ -208,7 +302,7 @@ void DesktopSessionAgent::onSharedMemoryCreate(int id)
 {
     LOG(LS_INFO) << "Shared memory created: " << id;
 
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::internal::DesktopToService>();
 
     proto::internal::SharedBuffer* shared_buffer = outgoing_message_->mutable_shared_buffer();
     shared_buffer->set_type(proto::internal::SharedBuffer::CREATE);
@@ -221,7 +315,7 @@ void DesktopSessionAgent::onSharedMemoryDestroy(int id)
 {
     LOG(LS_INFO) << "Shared memory destroyed: " << id;
 
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::internal::DesktopToService>();
 
     proto::internal::SharedBuffer* shared_buffer = outgoing_message_->mutable_shared_buffer();
     shared_buffer->set_type(proto::internal::SharedBuffer::RELEASE);
@@ -233,7 +327,7 @@ void DesktopSessionAgent::onSharedMemoryDestroy(int id)
 void DesktopSessionAgent::onScreenListChanged(
     const base::ScreenCapturer::ScreenList& list, base::ScreenCapturer::ScreenId current)
 {
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::internal::DesktopToService>();
 
     proto::ScreenList* screen_list = outgoing_message_->mutable_screen_list();
     screen_list->set_current_screen(current);
@@ -255,15 +349,22 @@ void DesktopSessionAgent::onScreenListChanged(
 void DesktopSessionAgent::onScreenCaptured(
     const base::Frame* frame, const base::MouseCursor* mouse_cursor)
 {
-    outgoing_message_->Clear();
+    TRACE_EVENT("host", "DesktopSessionAgent::onScreenCaptured");
+
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::internal::DesktopToService>();
 
     proto::internal::ScreenCaptured* screen_captured = outgoing_message_->mutable_screen_captured();
 
-    if (frame && !frame->constUpdatedRegion().isEmpty())
+    if (frame && (full_screen_requested_ || !frame->constUpdatedRegion().isEmpty() ||
+                  !frame->constMovedRects().empty()))
     {
         if (input_injector_)
             input_injector_->setScreenOffset(frame->topLeft());
 
+        frame_rect_ = base::Rect::makeXYWH(
+            base::ScreenCaptureUtils::fullScreenRect().topLeft().add(frame->topLeft()),
+            frame->size());
+
         proto::internal::DesktopFrame* serialized_frame = screen_captured->mutable_frame();
 
         serialized_frame->set_capturer_type(frame->capturerType());
@@ -273,7 +374,10 @@ void DesktopSessionAgent::onScreenCaptured(
         serialized_frame->set_dpi_x(frame->dpi().x());
         serialized_frame->set_dpi_y(frame->dpi().y());
 
-        for (base::Region::Iterator it(frame->constUpdatedRegion()); !it.isAtEnd(); it.advance())
+        const base::Region updated_region = full_screen_requested_ ?
+            base::Region(base::Rect::makeSize(frame->size())) : frame->constUpdatedRegion();
+
+        for (base::Region::Iterator it(updated_region); !it.isAtEnd(); it.advance())
         {
             proto::Rect* dirty_rect = serialized_frame->add_dirty_rect();
             base::Rect rect = it.rect();
@@ -283,6 +387,28 @@ void DesktopSessionAgent::onScreenCaptured(
             dirty_rect->set_width(rect.width());
             dirty_rect->set_height(rect.height());
         }
+
+        // The moves are not needed if the whole screen is sent.
+        if (!full_screen_requested_)
+        {
+            for (const auto& moved_rect : frame->constMovedRects())
+            {
+                proto::CopyRect* serialized_moved_rect = serialized_frame->add_moved_rect();
+                proto::Rect* dest_rect = serialized_moved_rect->mutable_dest_rect();
+
+                serialized_moved_rect->set_src_x(moved_rect.src_pos.x());
+                serialized_moved_rect->set_src_y(moved_rect.src_pos.y());
+                dest_rect->set_x(moved_rect.dest_rect.x());
+                dest_rect->set_y(moved_rect.dest_rect.y());
+                dest_rect->set_width(moved_rect.dest_rect.width());
+                dest_rect->set_height(moved_rect.dest_rect.height());
+            }
+        }
+
+        serializeFocus(frame, serialized_frame);
+        serializeTiming(capture_start_time_, frame->timing(), serialized_frame);
+
+        full_screen_requested_ = false;
     }
 
     if (mouse_cursor)
@@ -290,26 +416,42 @@ void DesktopSessionAgent::onScreenCaptured(
         proto::internal::MouseCursor* serialized_mouse_cursor =
             screen_captured->mutable_mouse_cursor();
 
-        serialized_mouse_cursor->set_width(mouse_cursor->width());
-        serialized_mouse_cursor->set_height(mouse_cursor->height());
-        serialized_mouse_cursor->set_hotspot_x(mouse_cursor->hotSpotX());
-        serialized_mouse_cursor->set_hotspot_y(mouse_cursor->hotSpotY());
-        serialized_mouse_cursor->set_data(base::toStdString(mouse_cursor->constImage()));
+        uint32_t hash = mouse_cursor->hash();
+        serialized_mouse_cursor->set_hash(hash);
+
+        // The service already has the cursor in its cache. Only the hash is sent.
+        if (!cursor_cache_.contains(hash))
+        {
+            serialized_mouse_cursor->set_width(mouse_cursor->width());
+            serialized_mouse_cursor->set_height(mouse_cursor->height());
+            serialized_mouse_cursor->set_hotspot_x(mouse_cursor->hotSpotX());
+            serialized_mouse_cursor->set_hotspot_y(mouse_cursor->hotSpotY());
+            serialized_mouse_cursor->set_data(base::toStdString(mouse_cursor->constImage()));
+
+            cursor_cache_.add(hash);
+        }
     }
 
     if (screen_captured->has_frame() || screen_captured->has_mouse_cursor())
     {
+        if (screen_captured->has_frame())
+            last_sent_frame_ = capture_count_ - 1;
+
+        frames_in_flight_.push_back(last_sent_frame_);
         channel_->send(base::serialize(*outgoing_message_));
+
+        // The next frame is captured while the service encodes this one.
+        captureEnd(capture_scheduler_->updateInterval(), true);
     }
     else
     {
-        captureEnd(capture_scheduler_->updateInterval());
+        captureEnd(capture_scheduler_->updateInterval(), false);
     }
 }
 
 void DesktopSessionAgent::onClipboardEvent(const proto::ClipboardEvent& event)
 {
-    outgoing_message_->Clear();
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::internal::DesktopToService>();
     outgoing_message_->mutable_clipboard_event()->CopyFrom(event);
     channel_->send(base::serialize(*outgoing_message_));
 }
@@ -327,39 +469,80 @@ void DesktopSessionAgent::setEnabled(bool enable)
         }
 
         input_injector_ = std::make_unique<InputInjectorWin>();
+        cursor_cache_.clear();
 
         // A window is created to monitor the clipboard. We cannot create windows in the current
         // thread. Create a separate thread.
         clipboard_monitor_ = std::make_unique<common::ClipboardMonitor>();
         clipboard_monitor_->start(task_runner_, this);
 
-        // Create a shared memory factory.
-        // We will receive notifications of all creations and destruction of shared memory.
-        shared_memory_factory_ = std::make_unique<base::SharedMemoryFactory>(this);
+        // Clients which do not receive announcements are served by ClientSessionDesktop.
+        clipboard_monitor_->setLazy(true);
 
         capture_scheduler_ = std::make_unique<base::CaptureScheduler>(
             std::chrono::milliseconds(40));
 
-        screen_capturer_ = std::make_unique<base::ScreenCapturerWrapper>(
-            preferred_video_capturer_, this);
-        screen_capturer_->setSharedMemoryFactory(shared_memory_factory_.get());
+        screen_change_monitor_ = std::make_unique<base::ScreenChangeMonitor>();
+        screen_change_monitor_->start(task_runner_, this);
+        capture_scheduler_->setChangeHintsEnabled(true);
+
+        idle_capturer_timer_.stop();
+
+        std::scoped_lock lock(capturer_lock_);
+
+        if (screen_capturer_)
+        {
+            // The capturer of the previous connection is still initialized.
+            screen_capturer_->resume();
+        }
+        else
+        {
+            // Create a shared memory factory.
+            // We will receive notifications of all creations and destruction of shared memory.
+            shared_memory_factory_ = std::make_unique<base::SharedMemoryFactory>(this);
+
+            screen_capturer_ = std::make_unique<base::ScreenCapturerWrapper>(
+                preferred_video_capturer_, this, fake_screen_file_);
+            screen_capturer_->setSharedMemoryFactory(shared_memory_factory_.get());
+        }
 
-        audio_capturer_ = std::make_unique<base::AudioCapturerWrapper>(channel_->channelProxy());
-        audio_capturer_->start();
+        frame_rect_ = base::Rect();
+        last_cursor_position_.reset();
+        cursor_timer_.start(kCursorPositionInterval,
+                            std::bind(&DesktopSessionAgent::sendCursorPosition, this));
 
         LOG(LS_INFO) << "Session successfully enabled";
 
+        // Opening the audio device takes a while. It is done after the first frame is captured,
+        // so it does not delay the first frame of the session.
         task_runner_->postTask(std::bind(&DesktopSessionAgent::captureBegin, shared_from_this()));
+        task_runner_->postTask(std::bind(&DesktopSessionAgent::startAudio, shared_from_this()));
     }
     else
     {
         input_injector_.reset();
+        pending_mouse_events_.clear();
+        capture_timer_.stop();
+        cursor_timer_.stop();
+        capture_scheduled_ = false;
+        capture_after_wait_ = false;
+        update_wait_deadline_.reset();
+        frames_in_flight_.clear();
+        waiting_for_release_ = false;
+        full_screen_requested_ = false;
         capture_scheduler_.reset();
-        screen_capturer_.reset();
-        shared_memory_factory_.reset();
+        screen_change_monitor_.reset();
         clipboard_monitor_.reset();
         audio_capturer_.reset();
 
+        if (screen_capturer_)
+        {
+            std::scoped_lock lock(capturer_lock_);
+            screen_capturer_->suspend();
+            idle_capturer_timer_.start(kIdleCapturerTimeout,
+                                       std::bind(&DesktopSessionAgent::releaseCapturer, this));
+        }
+
         if (lock_at_disconnect_)
         {
             LOG(LS_INFO) << "Enabled locking of user session when disconnected";
@@ -372,21 +555,66 @@ void DesktopSessionAgent::setEnabled(bool enable)
     }
 }
 
+void DesktopSessionAgent::startAudio()
+{
+    // The session may be disabled before the task is run.
+    if (!input_injector_ || audio_capturer_)
+        return;
+
+    audio_capturer_ = std::make_unique<base::AudioCapturerWrapper>(channel_->channelProxy());
+    audio_capturer_->start();
+}
+
+void DesktopSessionAgent::releaseCapturer()
+{
+    LOG(LS_INFO) << "Idle screen capturer released";
+
+    std::scoped_lock lock(capturer_lock_);
+    screen_capturer_.reset();
+    shared_memory_factory_.reset();
+}
+
 void DesktopSessionAgent::captureBegin()
 {
+    if (update_wait_pending_)
+    {
+        // The capturer is used by the wait. The frame is captured when the wait ends.
+        capture_after_wait_ = true;
+        return;
+    }
+
+    capture_scheduled_ = false;
+    update_wait_deadline_.reset();
+
     if (!capture_scheduler_ || !screen_capturer_)
         return;
 
+    // The items are in the order of the captures, the first one with a frame is the oldest.
+    auto oldest_frame = std::find_if(frames_in_flight_.begin(), frames_in_flight_.end(),
+        [](const std::optional<int64_t>& frame) { return frame.has_value(); });
+
+    if (oldest_frame != frames_in_flight_.end() &&
+        capture_count_ - **oldest_frame >= screen_capturer_->frameBufferCount())
+    {
+        // The capturer would overwrite the frame which the service is still processing.
+        waiting_for_release_ = true;
+        return;
+    }
+
+    ++capture_count_;
+
     capture_scheduler_->beginCapture();
+    capture_start_time_ = std::chrono::steady_clock::now();
     screen_capturer_->captureFrame();
 }
 
-void DesktopSessionAgent::captureEnd(const std::chrono::milliseconds& update_interval)
+void DesktopSessionAgent::captureEnd(
+    const std::chrono::milliseconds& update_interval, bool has_changes)
 {
     if (!capture_scheduler_)
         return;
 
-    capture_scheduler_->endCapture();
+    capture_scheduler_->endCapture(has_changes);
 
     if (update_interval == std::chrono::milliseconds::zero())
     {
@@ -396,11 +624,245 @@ void DesktopSessionAgent::captureEnd(const std::chrono::milliseconds& update_int
     else
     {
         capture_scheduler_->setUpdateInterval(update_interval);
+        scheduleCapture();
+    }
+}
+
+void DesktopSessionAgent::captureReleased(
+    const std::chrono::milliseconds& update_interval, bool full_screen)
+{
+    if (!capture_scheduler_)
+        return;
 
-        task_runner_->postDelayedTask(
-            std::bind(&DesktopSessionAgent::captureBegin, shared_from_this()),
-            capture_scheduler_->nextCaptureDelay());
+    if (full_screen)
+    {
+        // The service has no frame for a new client, nothing is released.
+        full_screen_requested_ = true;
     }
+    else if (!frames_in_flight_.empty())
+    {
+        // The frames are released in the order in which they were sent.
+        frames_in_flight_.pop_front();
+    }
+
+    if (update_interval != std::chrono::milliseconds::zero())
+        capture_scheduler_->setUpdateInterval(update_interval);
+
+    if (waiting_for_release_)
+    {
+        waiting_for_release_ = false;
+
+        if (update_interval == std::chrono::milliseconds::zero())
+        {
+            task_runner_->postTask(
+                std::bind(&DesktopSessionAgent::captureBegin, shared_from_this()));
+        }
+        else
+        {
+            scheduleCapture();
+        }
+    }
+    else if (update_interval == std::chrono::milliseconds::zero() && capture_scheduled_)
+    {
+        // The frame is needed at once.
+        capture_timer_.stop();
+        capture_scheduled_ = false;
+        task_runner_->postTask(std::bind(&DesktopSessionAgent::captureBegin, shared_from_this()));
+    }
+}
+
+void DesktopSessionAgent::scheduleCapture()
+{
+    capture_scheduled_ = true;
+
+    const std::chrono::milliseconds delay = capture_scheduler_->nextCaptureDelay();
+    const std::chrono::milliseconds min_delay = capture_scheduler_->minCaptureDelay();
+
+    // The timers are stopped with the agent, so the callbacks never outlive it.
+    if (delay > min_delay && screen_capturer_ && screen_capturer_->canWaitForUpdate())
+    {
+        // The capture is delayed because the screen is static. After the update interval the
+        // capturer waits for an update until the scheduled time.
+        update_wait_deadline_ = std::chrono::steady_clock::now() + delay;
+
+        capture_timer_.start(min_delay, [this]()
+        {
+            waitForUpdate();
+        });
+        return;
+    }
+
+    update_wait_deadline_.reset();
+
+    capture_timer_.start(delay, [this]()
+    {
+        captureBegin();
+    });
+}
+
+void DesktopSessionAgent::waitForUpdate()
+{
+    if (!update_wait_deadline_.has_value() || update_wait_pending_)
+        return;
+
+    const std::chrono::milliseconds remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            *update_wait_deadline_ - std::chrono::steady_clock::now());
+
+    if (remaining <= std::chrono::milliseconds::zero() || !screen_capturer_ ||
+        !screen_capturer_->canWaitForUpdate())
+    {
+        captureBegin();
+        return;
+    }
+
+    if (!update_wait_thread_)
+    {
+        update_wait_thread_ = std::make_unique<base::Thread>();
+        update_wait_thread_->start(base::MessageLoop::Type::DEFAULT);
+    }
+
+    update_wait_pending_ = true;
+
+    const std::chrono::milliseconds timeout = std::min(remaining, kMaxUpdateWait);
+
+    update_wait_thread_->taskRunner()->postTask([self = shared_from_this(), timeout]()
+    {
+        bool updated = false;
+
+        {
+            std::scoped_lock lock(self->capturer_lock_);
+            if (self->screen_capturer_)
+                updated = self->screen_capturer_->waitForUpdate(timeout);
+        }
+
+        self->task_runner_->postTask(
+            std::bind(&DesktopSessionAgent::onUpdateWaited, self, updated));
+    });
+}
+
+void DesktopSessionAgent::onUpdateWaited(bool updated)
+{
+    update_wait_pending_ = false;
+
+    if (capture_after_wait_)
+    {
+        // The capture is requested during the wait.
+        capture_after_wait_ = false;
+        captureBegin();
+        return;
+    }
+
+    // The capture is cancelled or scheduled again during the wait. If the update interval has not
+    // passed yet, the timer starts the wait again, which returns the update at once.
+    if (!capture_scheduled_ || !update_wait_deadline_.has_value() || capture_timer_.isActive())
+        return;
+
+    if (updated)
+        captureBegin();
+    else
+        waitForUpdate();
+}
+
+void DesktopSessionAgent::addMouseEvent(const proto::MouseEvent& event)
+{
+    static const uint32_t kWheelMask =
+        proto::MouseEvent::WHEEL_UP | proto::MouseEvent::WHEEL_DOWN;
+
+    // An event that does not change the buttons and does not scroll only moves the cursor.
+    // Consecutive moves are replaced by the last one. Presses, releases and scrolls are kept at
+    // their positions.
+    bool is_move = event.mask() == last_mouse_mask_ && !(event.mask() & kWheelMask);
+
+    if (is_move && last_mouse_event_is_move_ && !pending_mouse_events_.empty())
+        pending_mouse_events_.back() = event;
+    else
+        pending_mouse_events_.emplace_back(event);
+
+    last_mouse_mask_ = event.mask();
+    last_mouse_event_is_move_ = is_move;
+
+    // The events received in one iteration of the message loop are injected together. The input
+    // is not delayed by the queued capture tasks.
+    if (pending_mouse_events_.size() == 1)
+    {
+        task_runner_->postPriorityTask(
+            std::bind(&DesktopSessionAgent::flushMouseEvents, shared_from_this()),
+            base::TaskRunner::Priority::HIGH);
+    }
+}
+
+void DesktopSessionAgent::flushMouseEvents()
+{
+    if (pending_mouse_events_.empty())
+        return;
+
+    if (input_injector_)
+        input_injector_->injectMouseEvents(pending_mouse_events_);
+
+    pending_mouse_events_.clear();
+}
+
+void DesktopSessionAgent::onUserInput()
+{
+    if (!capture_scheduler_)
+        return;
+
+    const std::chrono::milliseconds interval = capture_scheduler_->captureInterval();
+    capture_scheduler_->onUserInput();
+    onCaptureIntervalReduced(interval);
+}
+
+void DesktopSessionAgent::onScreenChangeHint()
+{
+    if (!capture_scheduler_)
+        return;
+
+    const std::chrono::milliseconds interval = capture_scheduler_->captureInterval();
+    capture_scheduler_->onChangeHint();
+    onCaptureIntervalReduced(interval);
+}
+
+void DesktopSessionAgent::onCaptureIntervalReduced(
+    const std::chrono::milliseconds& previous_interval)
+{
+    // If the capture is delayed because the screen was static, it is moved to the time allowed
+    // by the update interval. A capture in progress is not affected.
+    if (capture_scheduled_ && capture_scheduler_->captureInterval() < previous_interval)
+    {
+        capture_timer_.stop();
+        scheduleCapture();
+    }
+}
+
+void DesktopSessionAgent::sendCursorPosition()
+{
+    // The position is not known relative to the frame until the first frame is captured.
+    if (frame_rect_.isEmpty())
+        return;
+
+    POINT cursor_pos;
+    if (!GetCursorPos(&cursor_pos))
+        return;
+
+    base::Point position = base::Point(cursor_pos.x, cursor_pos.y).subtract(
+        frame_rect_.topLeft());
+
+    if (!base::Rect::makeSize(frame_rect_.size()).contains(position.x(), position.y()))
+        return;
+
+    if (last_cursor_position_ == position)
+        return;
+
+    last_cursor_position_ = position;
+
+    outgoing_message_ = outgoing_arena_.resetAndCreate<proto::internal::DesktopToService>();
+
+    proto::internal::Point* serialized_position = outgoing_message_->mutable_cursor_position();
+    serialized_position->set_x(position.x());
+    serialized_position->set_y(position.y());
+
+    channel_->send(base::serialize(*outgoing_message_));
 }
 
 } // namespace host
@@ -19,12 +19,21 @@
 #ifndef HOST__DESKTOP_SESSION_AGENT_H
 #define HOST__DESKTOP_SESSION_AGENT_H
 
+#include "base/desktop/mouse_cursor_cache.h"
 #include "base/desktop/screen_capturer_wrapper.h"
+#include "base/desktop/win/screen_change_monitor.h"
 #include "base/ipc/ipc_channel.h"
 #include "base/ipc/shared_memory_factory.h"
+#include "base/memory/message_arena.h"
+#include "base/waitable_timer.h"
 #include "common/clipboard_monitor.h"
 #include "proto/desktop_internal.pb.h"
 
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
 namespace base {
 class AudioCapturerWrapper;
 class CaptureScheduler;
@@ -42,6 +51,7 @@ class DesktopSessionAgent
       public base::IpcChannel::Listener,
       public base::SharedMemoryFactory::Delegate,
       public base::ScreenCapturerWrapper::Delegate,
+      public base::ScreenChangeMonitor::Delegate,
       public common::Clipboard::Delegate
 {
 public:
@@ -65,29 +75,94 @@ protected:
     void onScreenCaptured(const base::Frame* frame,
                           const base::MouseCursor* mouse_cursor) override;
 
+    // base::ScreenChangeMonitor::Delegate implementation.
+    void onScreenChangeHint() override;
+
     // common::Clipboard::Delegate implementation.
     void onClipboardEvent(const proto::ClipboardEvent& event) override;
 
 private:
     void setEnabled(bool enable);
+    void startAudio();
+    void releaseCapturer();
     void captureBegin();
-    void captureEnd(const std::chrono::milliseconds& update_interval);
+    void captureEnd(const std::chrono::milliseconds& update_interval, bool has_changes);
+    void captureReleased(const std::chrono::milliseconds& update_interval, bool full_screen);
+    void scheduleCapture();
+    void waitForUpdate();
+    void onUpdateWaited(bool updated);
+    void addMouseEvent(const proto::MouseEvent& event);
+    void flushMouseEvents();
+    void onUserInput();
+    void onCaptureIntervalReduced(const std::chrono::milliseconds& previous_interval);
+    void sendCursorPosition();
 
     std::shared_ptr<base::TaskRunner> task_runner_;
 
     std::unique_ptr<base::IpcChannel> channel_;
-    std::unique_ptr<proto::internal::ServiceToDesktop> incoming_message_;
-    std::unique_ptr<proto::internal::DesktopToService> outgoing_message_;
+    // The messages are created again in their arenas for every message instead of being cleared
+    // (Clear() frees all the nested messages and their fields).
+    base::MessageArena incoming_arena_;
+    proto::internal::ServiceToDesktop* incoming_message_;
+    base::MessageArena outgoing_arena_;
+    proto::internal::DesktopToService* outgoing_message_;
 
     std::unique_ptr<common::ClipboardMonitor> clipboard_monitor_;
     std::unique_ptr<InputInjector> input_injector_;
 
+    // Mouse events waiting to be injected at the end of the current iteration of the message loop.
+    std::vector<proto::MouseEvent> pending_mouse_events_;
+    uint32_t last_mouse_mask_ = 0;
+    bool last_mouse_event_is_move_ = false;
+
     std::unique_ptr<base::SharedMemoryFactory> shared_memory_factory_;
     std::unique_ptr<base::CaptureScheduler> capture_scheduler_;
+    base::WaitableTimer capture_timer_;
+    bool capture_scheduled_ = false;
+    // While the screen is static, it is captured rarely unless the monitor reports a change.
+    std::unique_ptr<base::ScreenChangeMonitor> screen_change_monitor_;
+
+    // The capture is pipelined with the encoding in the service: the next frame is captured while
+    // the service processes the previous ones. |frames_in_flight_| contains an item for each
+    // message which is sent to the service and not released by it yet: the number of the capture
+    // whose frame the service reads for the message. A message with only the cursor carries the
+    // last frame sent, the service passes it with the cursor. The capture waits for a release if it
+    // could write to the buffer of a frame in flight.
+    int64_t capture_count_ = 0;
+    std::optional<int64_t> last_sent_frame_;
+    std::deque<std::optional<int64_t>> frames_in_flight_;
+    bool waiting_for_release_ = false;
+    bool full_screen_requested_ = false;
+
+    // Start of the current capture (for the latency statistics).
+    std::chrono::steady_clock::time_point capture_start_time_;
+    // The capturer is kept suspended for some time after the last client is disconnected, so the
+    // next connection does not wait for its initialization.
     std::unique_ptr<base::ScreenCapturerWrapper> screen_capturer_;
+    base::WaitableTimer idle_capturer_timer_;
+
+    // The position of the cursor is polled much more often than the screen is captured. Only the
+    // changes of the position are sent. |frame_rect_| is the last captured frame in the
+    // coordinates of the virtual screen.
+    base::WaitableTimer cursor_timer_;
+    base::Rect frame_rect_;
+    std::optional<base::Point> last_cursor_position_;
+    base::MouseCursorCache cursor_cache_;
     std::unique_ptr<base::AudioCapturerWrapper> audio_capturer_;
 
+    // While the screen is static, a capturer which can wait for the updates of the screen waits on
+    // its own thread, and the frame is captured as soon as the screen is updated (not earlier than
+    // the update interval allows and not later than the scheduled capture at
+    // |update_wait_deadline_|). The capture is not started during the wait, it is made after it
+    // (|capture_after_wait_|). The other uses of the capturer take |capturer_lock_|.
+    std::unique_ptr<base::Thread> update_wait_thread_;
+    std::mutex capturer_lock_;
+    bool update_wait_pending_ = false;
+    bool capture_after_wait_ = false;
+    std::optional<std::chrono::steady_clock::time_point> update_wait_deadline_;
+
     base::ScreenCapturer::Type preferred_video_capturer_ = base::ScreenCapturer::Type::DEFAULT;
+    std::filesystem::path fake_screen_file_;
     bool lock_at_disconnect_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(DesktopSessionAgent);
@@ -167,6 +167,11 @@ void DesktopSessionFake::captureScreen()
     frame_generator_->generateFrame();
 }
 
+void DesktopSessionFake::setCaptureInterval(const std::chrono::milliseconds& /* interval */)
+{
+    // Nothing
+}
+
 void DesktopSessionFake::injectKeyEvent(const proto::KeyEvent& /* event */)
 {
     // Nothing
@@ -19,6 +19,7 @@
 #include "host/desktop_session_ipc.h"
 
 #include "base/logging.h"
+#include "base/trace_event.h"
 #include "base/desktop/mouse_cursor.h"
 #include "base/desktop/shared_memory_frame.h"
 #include "base/ipc/shared_memory.h"
@@ -126,21 +127,24 @@ void DesktopSessionIpc::selectScreen(const proto::Screen& screen)
 
 void DesktopSessionIpc::captureScreen()
 {
-    if (last_frame_)
-    {
-        last_frame_->updatedRegion()->addRect(base::Rect::makeSize(last_frame_->size()));
+    if (last_screen_list_)
+        delegate_->onScreenListChanged(*last_screen_list_);
 
-        if (last_screen_list_)
-            delegate_->onScreenListChanged(*last_screen_list_);
+    // The buffer of the last frame is released already and the agent may be writing to it, so the
+    // whole screen is captured again.
+    outgoing_message_->Clear();
+    proto::internal::NextScreenCapture* next_screen_capture =
+        outgoing_message_->mutable_next_screen_capture();
+    next_screen_capture->set_update_interval(0);
+    next_screen_capture->set_full_screen(true);
+    channel_->send(base::serialize(*outgoing_message_));
 
-        delegate_->onScreenCaptured(last_frame_.get(), last_mouse_cursor_.get());
-    }
-    else
-    {
-        outgoing_message_->Clear();
-        outgoing_message_->mutable_next_screen_capture()->set_update_interval(0);
-        channel_->send(base::serialize(*outgoing_message_));
-    }
+    full_screen_requested_ = true;
+}
+
+void DesktopSessionIpc::setCaptureInterval(const std::chrono::milliseconds& interval)
+{
+    capture_interval_ = interval;
 }
 
 void DesktopSessionIpc::injectKeyEvent(const proto::KeyEvent& event)
@@ -191,6 +195,11 @@ void DesktopSessionIpc::onMessageReceived(const base::ByteArray& buffer)
     {
         onAudioCaptured(incoming_message_->audio_packet());
     }
+    else if (incoming_message_->has_cursor_position())
+    {
+        const proto::internal::Point& position = incoming_message_->cursor_position();
+        delegate_->onCursorPositionChanged(base::Point(position.x(), position.y()));
+    }
     else if (incoming_message_->has_screen_list())
     {
         last_screen_list_.reset(incoming_message_->release_screen_list());
@@ -226,26 +235,39 @@ void DesktopSessionIpc::onMessageReceived(const base::ByteArray& buffer)
 
 void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured& screen_captured)
 {
+    TRACE_EVENT("host", "DesktopSessionIpc::onScreenCaptured");
+
     const base::Frame* frame = nullptr;
     const base::MouseCursor* mouse_cursor = nullptr;
 
     if (screen_captured.has_frame())
     {
         const proto::internal::DesktopFrame& serialized_frame = screen_captured.frame();
+        const base::Size size(serialized_frame.width(), serialized_frame.height());
 
-        std::unique_ptr<SharedBuffer> shared_buffer = sharedBuffer(
-            serialized_frame.shared_buffer_id());
-        if (shared_buffer)
+        // The capturer usually writes every frame to the same buffer. The frame is attached to
+        // the buffer again only when the buffer or the size changes.
+        bool has_frame = last_frame_ && last_frame_->size() == size &&
+                         last_frame_->sharedMemory()->id() == serialized_frame.shared_buffer_id();
+        if (!has_frame)
         {
-            last_frame_ = base::SharedMemoryFrame::attach(
-                base::Size(serialized_frame.width(), serialized_frame.height()),
-                std::move(shared_buffer));
+            std::unique_ptr<SharedBuffer> shared_buffer = sharedBuffer(
+                serialized_frame.shared_buffer_id());
+            if (shared_buffer)
+            {
+                last_frame_ = base::SharedMemoryFrame::attach(size, std::move(shared_buffer));
+                has_frame = true;
+            }
+        }
 
+        if (has_frame)
+        {
             last_frame_->setCapturerType(serialized_frame.capturer_type());
             last_frame_->setDpi(base::Point(
                 serialized_frame.dpi_x(), serialized_frame.dpi_y()));
 
             base::Region* updated_region = last_frame_->updatedRegion();
+            updated_region->clear();
 
             for (int i = 0; i < serialized_frame.dirty_rect_size(); ++i)
             {
@@ -254,30 +276,115 @@ void DesktopSessionIpc::onScreenCaptured(const proto::internal::ScreenCaptured&
                     dirty_rect.x(), dirty_rect.y(), dirty_rect.width(), dirty_rect.height()));
             }
 
+            if (serialized_frame.has_cursor_position())
+            {
+                last_frame_->setCursorPosition(base::Point(
+                    serialized_frame.cursor_position().x(),
+                    serialized_frame.cursor_position().y()));
+            }
+            else
+            {
+                last_frame_->setCursorPosition(std::nullopt);
+            }
+
+            if (serialized_frame.has_active_window_rect())
+            {
+                const proto::Rect& rect = serialized_frame.active_window_rect();
+                last_frame_->setActiveWindowRect(
+                    base::Rect::makeXYWH(rect.x(), rect.y(), rect.width(), rect.height()));
+            }
+            else
+            {
+                last_frame_->setActiveWindowRect(base::Rect());
+            }
+
+            base::Frame::MovedRects* moved_rects = last_frame_->movedRects();
+            moved_rects->clear();
+
+            for (int i = 0; i < serialized_frame.moved_rect_size(); ++i)
+            {
+                const proto::CopyRect& moved_rect = serialized_frame.moved_rect(i);
+                const proto::Rect& dest_rect = moved_rect.dest_rect();
+
+                moved_rects->push_back({ base::Point(moved_rect.src_x(), moved_rect.src_y()),
+                                         base::Rect::makeXYWH(dest_rect.x(), dest_rect.y(),
+                                                              dest_rect.width(),
+                                                              dest_rect.height()) });
+            }
+
+            using Microseconds = std::chrono::microseconds;
+            using TimePoint = std::chrono::steady_clock::time_point;
+
+            base::Frame::Timing* timing = last_frame_->mutableTiming();
+            timing->capture_start = TimePoint(Microseconds(serialized_frame.capture_start()));
+            timing->capture_end = TimePoint(Microseconds(serialized_frame.capture_end()));
+            timing->diff = Microseconds(serialized_frame.diff_time());
+
             frame = last_frame_.get();
         }
     }
+    else if (last_frame_)
+    {
+        // The screen has not changed. The frame is passed without changes, so the encoders can
+        // improve the static areas which they sent before.
+        last_frame_->updatedRegion()->clear();
+        last_frame_->movedRects()->clear();
+        frame = last_frame_.get();
+    }
 
     if (screen_captured.has_mouse_cursor())
     {
         const proto::internal::MouseCursor& serialized_mouse_cursor =
             screen_captured.mouse_cursor();
 
-        base::Size size =
-            base::Size(serialized_mouse_cursor.width(), serialized_mouse_cursor.height());
-        base::Point hotspot =
-            base::Point(serialized_mouse_cursor.hotspot_x(), serialized_mouse_cursor.hotspot_y());
+        if (serialized_mouse_cursor.data().empty())
+        {
+            // The cursor was sent before. Only its hash is received.
+            std::shared_ptr<base::MouseCursor> cached_mouse_cursor =
+                cursor_cache_.find(serialized_mouse_cursor.hash());
+            if (cached_mouse_cursor)
+            {
+                last_mouse_cursor_ = std::move(cached_mouse_cursor);
+                mouse_cursor = last_mouse_cursor_.get();
+            }
+            else
+            {
+                LOG(LS_ERROR) << "Mouse cursor not found in cache: "
+                              << serialized_mouse_cursor.hash();
+            }
+        }
+        else
+        {
+            base::Size size =
+                base::Size(serialized_mouse_cursor.width(), serialized_mouse_cursor.height());
+            base::Point hotspot = base::Point(
+                serialized_mouse_cursor.hotspot_x(), serialized_mouse_cursor.hotspot_y());
 
-        last_mouse_cursor_ = std::make_unique<base::MouseCursor>(
-            base::fromStdString(serialized_mouse_cursor.data()), size, hotspot);
+            last_mouse_cursor_ = std::make_shared<base::MouseCursor>(
+                base::fromStdString(serialized_mouse_cursor.data()), size, hotspot);
+
+            if (serialized_mouse_cursor.hash())
+                last_mouse_cursor_->setHash(serialized_mouse_cursor.hash());
+
+            cursor_cache_.add(serialized_mouse_cursor.hash(), last_mouse_cursor_);
+            mouse_cursor = last_mouse_cursor_.get();
+        }
+    }
+
+    if (full_screen_requested_ && screen_captured.has_frame())
+    {
+        // The new clients get the current cursor with the whole screen.
+        if (!mouse_cursor)
+            mouse_cursor = last_mouse_cursor_.get();
 
-        mouse_cursor = last_mouse_cursor_.get();
+        full_screen_requested_ = false;
     }
 
     delegate_->onScreenCaptured(frame, mouse_cursor);
 
     outgoing_message_->Clear();
-    outgoing_message_->mutable_next_screen_capture()->set_update_interval(40);
+    outgoing_message_->mutable_next_screen_capture()->set_update_interval(
+        static_cast<uint32_t>(capture_interval_.count()));
     channel_->send(base::serialize(*outgoing_message_));
 }
 
@@ -19,6 +19,7 @@
 #ifndef HOST__DESKTOP_SESSION_IPC_H
 #define HOST__DESKTOP_SESSION_IPC_H
 
+#include "base/desktop/mouse_cursor_cache.h"
 #include "base/ipc/ipc_channel.h"
 #include "host/desktop_session.h"
 
@@ -39,6 +40,7 @@ public:
     void configure(const Config& config) override;
     void selectScreen(const proto::Screen& screen) override;
     void captureScreen() override;
+    void setCaptureInterval(const std::chrono::milliseconds& interval) override;
     void injectKeyEvent(const proto::KeyEvent& event) override;
     void injectMouseEvent(const proto::MouseEvent& event) override;
     void injectClipboardEvent(const proto::ClipboardEvent& event) override;
@@ -61,13 +63,18 @@ private:
     std::unique_ptr<base::IpcChannel> channel_;
     SharedBuffers shared_buffers_;
     std::unique_ptr<base::Frame> last_frame_;
-    std::unique_ptr<base::MouseCursor> last_mouse_cursor_;
+    std::shared_ptr<base::MouseCursor> last_mouse_cursor_;
+    base::MouseCursorCache cursor_cache_;
     std::unique_ptr<proto::ScreenList> last_screen_list_;
+    bool full_screen_requested_ = false;
 
     std::unique_ptr<proto::internal::ServiceToDesktop> outgoing_message_;
     std::unique_ptr<proto::internal::DesktopToService> incoming_message_;
     Delegate* delegate_;
 
+    // Interval between screen captures requested from the desktop agent.
+    std::chrono::milliseconds capture_interval_{ 40 };
+
     DISALLOW_COPY_AND_ASSIGN(DesktopSessionIpc);
 };
 
@@ -33,7 +33,8 @@ namespace host {
 DesktopSessionManager::DesktopSessionManager(
     std::shared_ptr<base::TaskRunner> task_runner, DesktopSession::Delegate* delegate)
     : task_runner_(task_runner),
-      session_attach_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner),
+      session_attach_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner,
+                            base::WaitableTimer::Precision::COARSE),
       session_proxy_(std::make_shared<DesktopSessionProxy>()),
       delegate_(delegate)
 {
@@ -178,6 +179,11 @@ void DesktopSessionManager::onAudioCaptured(const proto::AudioPacket& audio_pack
     delegate_->onAudioCaptured(audio_packet);
 }
 
+void DesktopSessionManager::onCursorPositionChanged(const base::Point& position)
+{
+    delegate_->onCursorPositionChanged(position);
+}
+
 void DesktopSessionManager::onScreenListChanged(const proto::ScreenList& list)
 {
     delegate_->onScreenListChanged(list);
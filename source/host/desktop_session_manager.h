@@ -60,6 +60,7 @@ protected:
     void onDesktopSessionStopped() override;
     void onScreenCaptured(const base::Frame* frame, const base::MouseCursor* mouse_cursor) override;
     void onAudioCaptured(const proto::AudioPacket& audio_packet) override;
+    void onCursorPositionChanged(const base::Point& position) override;
     void onScreenListChanged(const proto::ScreenList& list) override;
     void onClipboardEvent(const proto::ClipboardEvent& event) override;
 
@@ -53,6 +53,12 @@ void DesktopSessionProxy::captureScreen()
         desktop_session_->captureScreen();
 }
 
+void DesktopSessionProxy::setCaptureInterval(const std::chrono::milliseconds& interval)
+{
+    if (desktop_session_)
+        desktop_session_->setCaptureInterval(interval);
+}
+
 void DesktopSessionProxy::injectKeyEvent(const proto::KeyEvent& event)
 {
     if (desktop_session_)
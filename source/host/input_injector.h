@@ -23,6 +23,8 @@
 #include "base/desktop/geometry.h"
 #include "proto/desktop.pb.h"
 
+#include <vector>
+
 namespace host {
 
 class InputInjector
@@ -33,7 +35,10 @@ public:
     virtual void setScreenOffset(const base::Point& offset) = 0;
     virtual void setBlockInput(bool enable) = 0;
     virtual void injectKeyEvent(const proto::KeyEvent& event) = 0;
-    virtual void injectMouseEvent(const proto::MouseEvent& event) = 0;
+
+    // Injects |events| in the order given. The events are sent to the system at once when
+    // the platform allows it.
+    virtual void injectMouseEvents(const std::vector<proto::MouseEvent>& events) = 0;
 };
 
 } // namespace host
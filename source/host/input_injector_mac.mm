@@ -41,7 +41,7 @@ void InputInjectorMac::injectKeyEvent(const proto::KeyEvent& /* event */)
     NOTIMPLEMENTED();
 }
 
-void InputInjectorMac::injectMouseEvent(const proto::MouseEvent& /* event */)
+void InputInjectorMac::injectMouseEvents(const std::vector<proto::MouseEvent>& /* events */)
 {
     NOTIMPLEMENTED();
 }
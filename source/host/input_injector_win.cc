@@ -151,8 +151,11 @@ void InputInjectorWin::injectKeyEvent(const proto::KeyEvent& event)
     sendKeyboardScancode(static_cast<WORD>(scancode), flags);
 }
 
-void InputInjectorWin::injectMouseEvent(const proto::MouseEvent& event)
+void InputInjectorWin::injectMouseEvents(const std::vector<proto::MouseEvent>& events)
 {
+    if (events.empty())
+        return;
+
     switchToInputDesktop();
 
     base::Size full_size(GetSystemMetrics(SM_CXVIRTUALSCREEN),
@@ -160,6 +163,35 @@ void InputInjectorWin::injectMouseEvent(const proto::MouseEvent& event)
     if (full_size.width() <= 1 || full_size.height() <= 1)
         return;
 
+    // If the host is configured to swap left & right buttons.
+    bool swap_buttons = !!GetSystemMetrics(SM_SWAPBUTTON);
+
+    std::vector<INPUT> inputs;
+    inputs.reserve(events.size());
+
+    for (const auto& event : events)
+    {
+        INPUT input;
+        if (mouseEventToInput(event, full_size, swap_buttons, &input))
+            inputs.emplace_back(input);
+    }
+
+    if (inputs.empty())
+        return;
+
+    // All events are injected with a single call, so they are not interleaved with the input of
+    // other sources.
+    if (!SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT)))
+    {
+        PLOG(LS_WARNING) << "SendInput failed";
+    }
+}
+
+bool InputInjectorWin::mouseEventToInput(const proto::MouseEvent& event,
+                                         const base::Size& full_size,
+                                         bool swap_buttons,
+                                         INPUT* input)
+{
     // Translate the coordinates of the cursor into the coordinates of the virtual screen.
     base::Point pos(((event.x() + screen_offset_.x()) * 65535) / (full_size.width() - 1),
                     ((event.y() + screen_offset_.y()) * 65535) / (full_size.height() - 1));
@@ -175,9 +207,6 @@ void InputInjectorWin::injectMouseEvent(const proto::MouseEvent& event)
 
     uint32_t mask = event.mask();
 
-    // If the host is configured to swap left & right buttons.
-    bool swap_buttons = !!GetSystemMetrics(SM_SWAPBUTTON);
-
     bool prev = (last_mouse_mask_ & proto::MouseEvent::LEFT_BUTTON) != 0;
     bool curr = (mask & proto::MouseEvent::LEFT_BUTTON) != 0;
     if (curr != prev)
@@ -216,22 +245,19 @@ void InputInjectorWin::injectMouseEvent(const proto::MouseEvent& event)
         wheel_movement = static_cast<DWORD>(-WHEEL_DELTA);
     }
 
-    INPUT input;
-    memset(&input, 0, sizeof(input));
+    last_mouse_mask_ = mask;
 
-    input.type = INPUT_MOUSE;
-    input.mi.dx = pos.x();
-    input.mi.dy = pos.y();
-    input.mi.mouseData = wheel_movement;
-    input.mi.dwFlags = flags;
+    if (flags == (MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK))
+        return false;
 
-    // Do the mouse event.
-    if (!SendInput(1, &input, sizeof(input)))
-    {
-        PLOG(LS_WARNING) << "SendInput failed";
-    }
+    memset(input, 0, sizeof(*input));
 
-    last_mouse_mask_ = mask;
+    input->type = INPUT_MOUSE;
+    input->mi.dx = pos.x();
+    input->mi.dy = pos.y();
+    input->mi.mouseData = wheel_movement;
+    input->mi.dwFlags = flags;
+    return true;
 }
 
 void InputInjectorWin::switchToInputDesktop()
@@ -34,9 +34,13 @@ public:
     void setScreenOffset(const base::Point& offset) override;
     void setBlockInput(bool enable) override;
     void injectKeyEvent(const proto::KeyEvent& event) override;
-    void injectMouseEvent(const proto::MouseEvent& event) override;
+    void injectMouseEvents(const std::vector<proto::MouseEvent>& events) override;
 
 private:
+    // Converts |event| to the input for SendInput. Returns false if the event does not change
+    // anything.
+    bool mouseEventToInput(const proto::MouseEvent& event, const base::Size& full_size,
+                           bool swap_buttons, INPUT* input);
     void switchToInputDesktop();
     bool isCtrlAndAltPressed();
 
@@ -41,7 +41,7 @@ void InputInjectorX11::injectKeyEvent(const proto::KeyEvent& /* event */)
     NOTIMPLEMENTED();
 }
 
-void InputInjectorX11::injectMouseEvent(const proto::MouseEvent& /* event */)
+void InputInjectorX11::injectMouseEvents(const std::vector<proto::MouseEvent>& /* events */)
 {
     NOTIMPLEMENTED();
 }
@@ -33,7 +33,7 @@ public:
     void setScreenOffset(const base::Point& offset) override;
     void setBlockInput(bool enable) override;
     void injectKeyEvent(const proto::KeyEvent& event) override;
-    void injectMouseEvent(const proto::MouseEvent& event) override;
+    void injectMouseEvents(const std::vector<proto::MouseEvent>& events) override;
 
 private:
     DISALLOW_COPY_AND_ASSIGN(InputInjectorX11);
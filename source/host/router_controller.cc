@@ -20,23 +20,46 @@
 
 #include "base/logging.h"
 #include "base/task_runner.h"
+#include "base/crypto/random.h"
+#include "base/net/adapter_enumerator.h"
+#include "base/net/ip_util.h"
 #include "base/peer/client_authenticator.h"
+#include "base/peer/connection_trace.h"
 #include "base/strings/unicode.h"
 #include "host/host_key_storage.h"
 #include "proto/router_peer.pb.h"
 
+#include <algorithm>
+
 namespace host {
 
 namespace {
 
-const std::chrono::seconds kReconnectTimeout{ 10 };
+// The reconnect delay is chosen randomly up to a limit which is doubled after each failed attempt
+// (full jitter exponential backoff). Hosts which lost the connection at the same time do not
+// reconnect at the same time.
+const std::chrono::milliseconds kReconnectMinDelay { 1000 };
+const std::chrono::milliseconds kReconnectBaseDelay { 5000 };
+const std::chrono::milliseconds kReconnectMaxDelay { 5 * 60 * 1000 };
+const int kMaxReconnectExponent = 10;
+
+// The router uses only a few addresses of the network interfaces of the host.
+const int kMaxCandidates = 4;
+
+// Returns a random delay from 0 to |max_delay|.
+std::chrono::milliseconds randomDelay(std::chrono::milliseconds max_delay)
+{
+    const uint64_t max_ms = static_cast<uint64_t>(max_delay.count());
+    return std::chrono::milliseconds(base::Random::number64() % (max_ms + 1));
+}
 
 } // namespace
 
 RouterController::RouterController(std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(task_runner),
       peer_manager_(std::make_unique<base::RelayPeerManager>(task_runner, this)),
-      reconnect_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner)
+      reconnect_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner,
+                       base::WaitableTimer::Precision::COARSE)
 {
     // Nothing
 }
@@ -110,6 +133,36 @@ void RouterController::resetHostId(base::HostId host_id)
     channel_->send(base::serialize(message));
 }
 
+void RouterController::sendCandidates()
+{
+    if (!router_info_.direct_port)
+        return;
+
+    proto::PeerToRouter message;
+    proto::HostCandidates* candidates = message.mutable_host_candidates();
+    candidates->set_port(router_info_.direct_port);
+
+    // Clients from the same network connect to the addresses of the interfaces. The router accepts
+    // only the addresses of private networks.
+    for (base::AdapterEnumerator adapter; !adapter.isAtEnd(); adapter.advance())
+    {
+        for (base::AdapterEnumerator::IpAddressEnumerator ip(adapter); !ip.isAtEnd(); ip.advance())
+        {
+            std::string address = ip.address();
+
+            if (candidates->address_size() < kMaxCandidates &&
+                base::isPrivateIpV4Address(base::utf16FromUtf8(address)))
+            {
+                candidates->add_address(std::move(address));
+            }
+        }
+    }
+
+    LOG(LS_INFO) << "Send " << candidates->address_size() << " candidates to router (port: "
+                 << router_info_.direct_port << ")";
+    channel_->send(base::serialize(message));
+}
+
 void RouterController::onConnected()
 {
     DCHECK(channel_);
@@ -136,7 +189,9 @@ void RouterController::onConnected()
             channel_->setListener(this);
 
             LOG(LS_INFO) << "Router connected";
+            reconnect_attempt_ = 0;
             routerStateChanged(proto::internal::RouterState::CONNECTED);
+            sendCandidates();
 
             // Now the session will receive incoming messages.
             channel_->resume();
@@ -145,6 +200,9 @@ void RouterController::onConnected()
         {
             LOG(LS_WARNING) << "Authentication failed: "
                             << base::ClientAuthenticator::errorToString(error_code);
+
+            // The router may be overloaded and ask to connect later.
+            retry_after_ = authenticator_->retryAfter();
             delayedConnectToRouter();
         }
 
@@ -209,9 +267,24 @@ void RouterController::onMessageReceived(const base::ByteArray& buffer)
         if (connection_offer.error_code() == proto::ConnectionOffer::SUCCESS &&
             connection_offer.peer_role() == proto::ConnectionOffer::HOST)
         {
-            peer_manager_->addConnectionOffer(connection_offer.relay());
+            base::ConnectionTrace(connection_offer.trace_id()).addStage(
+                "Connection offer received by host");
+            peer_manager_->addConnectionOffer(connection_offer);
         }
     }
+    else if (message.has_retry_after())
+    {
+        retry_after_ = std::chrono::milliseconds(message.retry_after().delay_ms());
+
+        LOG(LS_INFO) << "Router is overloaded. Retry after " << retry_after_.count() << " ms";
+
+        // The channel is deleted after the listener returns.
+        channel_->setListener(nullptr);
+        task_runner_->deleteSoon(std::move(channel_));
+
+        routerStateChanged(proto::internal::RouterState::FAILED);
+        delayedConnectToRouter();
+    }
     else
     {
         LOG(LS_WARNING) << "Unhandled message from router";
@@ -242,8 +315,24 @@ void RouterController::connectToRouter()
 
 void RouterController::delayedConnectToRouter()
 {
-    LOG(LS_INFO) << "Reconnect after " << kReconnectTimeout.count() << " seconds";
-    reconnect_timer_.start(kReconnectTimeout, std::bind(&RouterController::connectToRouter, this));
+    const int exponent = std::min(reconnect_attempt_, kMaxReconnectExponent);
+    const std::chrono::milliseconds max_delay =
+        std::min(kReconnectBaseDelay * (int64_t(1) << exponent), kReconnectMaxDelay);
+
+    std::chrono::milliseconds delay = std::max(randomDelay(max_delay), kReconnectMinDelay);
+
+    // The delay asked by the router is spread the same way.
+    if (retry_after_.count() > 0)
+    {
+        delay = std::max(delay, retry_after_ + randomDelay(retry_after_));
+        retry_after_ = std::chrono::milliseconds::zero();
+    }
+
+    ++reconnect_attempt_;
+
+    LOG(LS_INFO) << "Reconnect after " << delay.count() << " ms (attempt " << reconnect_attempt_
+                 << ")";
+    reconnect_timer_.start(delay, std::bind(&RouterController::connectToRouter, this));
 }
 
 void RouterController::routerStateChanged(proto::internal::RouterState::State state)
@@ -44,6 +44,10 @@ public:
         std::u16string address;
         uint16_t port = 0;
         base::ByteArray public_key;
+
+        // Port on which the host accepts direct connections. If it is not 0, the host sends its
+        // addresses to the router and clients try to connect to them before using a relay.
+        uint16_t direct_port = 0;
     };
 
     class Delegate
@@ -79,6 +83,7 @@ private:
     void connectToRouter();
     void delayedConnectToRouter();
     void routerStateChanged(proto::internal::RouterState::State state);
+    void sendCandidates();
 
     Delegate* delegate_ = nullptr;
 
@@ -87,6 +92,8 @@ private:
     std::unique_ptr<base::ClientAuthenticator> authenticator_;
     std::unique_ptr<base::RelayPeerManager> peer_manager_;
     base::WaitableTimer reconnect_timer_;
+    int reconnect_attempt_ = 0;
+    std::chrono::milliseconds retry_after_ { 0 };
     RouterInfo router_info_;
 
     std::queue<std::string> pending_id_requests_;
@@ -20,11 +20,15 @@
 
 #include "base/logging.h"
 #include "base/task_runner.h"
+#include "base/codec/video_encoder_mf.h"
 #include "base/files/base_paths.h"
 #include "base/files/file_path_watcher.h"
 #include "base/net/network_channel.h"
 #include "base/net/firewall_manager.h"
+#include "base/peer/session_ticket.h"
+#include "base/threading/thread_pool.h"
 #include "host/client_session.h"
+#include "host/system_info_cache.h"
 
 namespace host {
 
@@ -70,6 +74,7 @@ void Server::start()
         std::bind(&Server::updateConfiguration, this, std::placeholders::_1, std::placeholders::_2));
 
     authenticator_manager_ = std::make_unique<base::ServerAuthenticatorManager>(task_runner_, this);
+    authenticator_manager_->setSessionTicketKeeper(std::make_shared<base::SessionTicketKeeper>());
 
     user_session_manager_ = std::make_unique<UserSessionManager>(task_runner_);
     user_session_manager_->start(this);
@@ -83,6 +88,13 @@ void Server::start()
     if (settings_.isRouterEnabled())
         connectToRouter();
 
+    // Inventory requests are answered from the cache (see SystemInfoCache).
+    SystemInfoCache::instance()->prefetch();
+
+    // Enumeration of the hardware encoders takes a while. The result is cached, so it is done in
+    // the background and the first connection does not wait for it.
+    base::ThreadPool::shared()->postTask([]() { base::VideoEncoderMF::isSupported(); });
+
     LOG(LS_INFO) << "Host server is started successfully";
 }
 
@@ -121,6 +133,13 @@ void Server::onNewConnection(std::unique_ptr<base::NetworkChannel> channel)
     startAuthentication(std::move(channel));
 }
 
+void Server::onStreamOpened(std::unique_ptr<base::NetworkChannel> stream)
+{
+    // The stream is authenticated separately, as a new connection to the host.
+    LOG(LS_INFO) << "New STREAM connection";
+    startAuthentication(std::move(stream));
+}
+
 void Server::onRouterStateChanged(const proto::internal::RouterState& router_state)
 {
     user_session_manager_->setRouterState(router_state);
@@ -140,6 +159,10 @@ void Server::onClientConnected(std::unique_ptr<base::NetworkChannel> channel)
 
 void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& session_info)
 {
+    // The peer may open streams only after the connection is authenticated. The channel stays
+    // paused until the session starts, so no streams arrive before the listener is set.
+    session_info.channel->setStreamListener(this);
+
     std::unique_ptr<ClientSession> session = ClientSession::create(
         static_cast<proto::SessionType>(session_info.session_type), std::move(session_info.channel));
 
@@ -178,10 +201,16 @@ void Server::onUserListChanged()
 void Server::startAuthentication(std::unique_ptr<base::NetworkChannel> channel)
 {
     static const size_t kReadBufferSize = 1 * 1024 * 1024; // 1 Mb.
+    static const size_t kMaxBufferSize = 16 * 1024 * 1024; // 16 Mb.
 
     channel->setReadBufferSize(kReadBufferSize);
+    channel->setBufferAutotuning(kMaxBufferSize);
     channel->setNoDelay(true);
 
+    const std::string congestion_control = settings_.congestionControl();
+    if (!congestion_control.empty())
+        channel->setCongestionControl(congestion_control);
+
     if (authenticator_manager_)
         authenticator_manager_->addNewChannel(std::move(channel));
 }
@@ -287,6 +316,7 @@ void Server::connectToRouter()
     router_info.address = settings_.routerAddress();
     router_info.port = settings_.routerPort();
     router_info.public_key = settings_.routerPublicKey();
+    router_info.direct_port = settings_.tcpPort();
 
     // Connect to the router.
     router_controller_ = std::make_unique<RouterController>(task_runner_);
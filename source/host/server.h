@@ -34,6 +34,7 @@ namespace host {
 
 class Server
     : public base::NetworkServer::Delegate,
+      public base::NetworkChannel::StreamListener,
       public RouterController::Delegate,
       public base::ServerAuthenticatorManager::Delegate,
       public UserSessionManager::Delegate
@@ -50,6 +51,9 @@ protected:
     // net::Server::Delegate implementation.
     void onNewConnection(std::unique_ptr<base::NetworkChannel> channel) override;
 
+    // base::NetworkChannel::StreamListener implementation.
+    void onStreamOpened(std::unique_ptr<base::NetworkChannel> stream) override;
+
     // RouterController::Delegate implementation.
     void onRouterStateChanged(const proto::internal::RouterState& router_state) override;
     void onHostIdAssigned(const std::string& session_name, base::HostId host_id) override;
@@ -0,0 +1,116 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "host/session_recorder.h"
+
+#include "base/logging.h"
+#include "base/codec/audio_encoder_opus.h"
+#include "base/codec/video_encoder_vpx.h"
+#include "base/desktop/frame.h"
+#include "base/strings/unicode.h"
+#include "host/audio_encoder_cache.h"
+#include "host/system_settings.h"
+
+namespace host {
+
+namespace {
+
+// Length of the recorded files.
+constexpr std::chrono::minutes kSegmentDuration { 30 };
+
+// The recording does not depend on the channels of the clients.
+const uint32_t kVideoBitrate = 1000; // kbps
+const uint32_t kMinQuantizer = 20;
+const uint32_t kMaxQuantizer = 30;
+const int kAudioBitrate = 96000; // bps
+
+} // namespace
+
+SessionRecorder::SessionRecorder(const std::filesystem::path& path, std::string_view name)
+    : writer_(path, name)
+{
+    resetEncoder();
+}
+
+SessionRecorder::~SessionRecorder() = default;
+
+// static
+std::unique_ptr<SessionRecorder> SessionRecorder::create(std::string_view name)
+{
+    SystemSettings settings;
+
+    std::filesystem::path path = settings.sessionRecordingPath();
+    if (path.empty())
+        return nullptr;
+
+    std::error_code error_code;
+    if (!std::filesystem::exists(path, error_code))
+    {
+        if (!std::filesystem::create_directories(path, error_code))
+        {
+            LOG(LS_ERROR) << "Unable to create directory for recordings: "
+                          << base::utf16FromLocal8Bit(error_code.message());
+            return nullptr;
+        }
+    }
+
+    LOG(LS_INFO) << "Session recording started (path: " << path << ")";
+    return std::unique_ptr<SessionRecorder>(new SessionRecorder(path, name));
+}
+
+void SessionRecorder::encodeScreen(const base::Frame* frame)
+{
+    if (!frame || !frame->hasChanges())
+        return;
+
+    if (std::chrono::steady_clock::now() - segment_start_time_ >= kSegmentDuration)
+    {
+        // The new encoder starts with a key frame, the writer starts a new file with it.
+        resetEncoder();
+    }
+
+    packet_.Clear();
+    encoder_->encode(frame, &packet_);
+
+    // The frame without changes is not encoded.
+    if (!packet_.data().empty())
+        writer_.addVideoPacket(packet_);
+}
+
+void SessionRecorder::encodeAudio(const proto::AudioPacket& audio_packet,
+                                  AudioEncoderCache* encoder_cache)
+{
+    // The packets are shared with the clients which use the same frame duration.
+    const proto::AudioPacket* encoded_packet = encoder_cache->encode(
+        kClientId, proto::AUDIO_ENCODING_OPUS, base::AudioEncoderOpus::kDefaultFrameDuration,
+        kAudioBitrate, audio_packet);
+    if (encoded_packet)
+        writer_.addAudioPacket(*encoded_packet);
+}
+
+void SessionRecorder::resetEncoder()
+{
+    encoder_ = base::VideoEncoderVPX::createVP8();
+    encoder_->setBitstreamOnly(true);
+    encoder_->setBitrate(kVideoBitrate);
+    encoder_->setQuantizerRange(kMinQuantizer, kMaxQuantizer);
+
+    segment_start_time_ = std::chrono::steady_clock::now();
+}
+
+} // namespace host
@@ -0,0 +1,73 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST__SESSION_RECORDER_H
+#define HOST__SESSION_RECORDER_H
+
+#include "base/macros_magic.h"
+#include "base/codec/webm_file_writer.h"
+#include "proto/desktop.pb.h"
+
+#include <chrono>
+#include <memory>
+#include <string_view>
+
+namespace base {
+class Frame;
+class VideoEncoderVPX;
+} // namespace base
+
+namespace host {
+
+class AudioEncoderCache;
+
+// Records the desktop of a user session to WebM files on the host. The video has its own VP8
+// encoder: the packets of the clients contain cached tiles, palette blocks and copy rects, which a
+// WebM player can not show (see VideoEncoderVPX::setBitstreamOnly). The audio packets are shared
+// with the clients (see AudioEncoderCache). The packets are muxed as they are, without decoding.
+// Every segment of the recording starts with a key frame in a new file.
+class SessionRecorder
+{
+public:
+    ~SessionRecorder();
+
+    // Returns nullptr if the sessions are not recorded (see SystemSettings::sessionRecordingPath).
+    static std::unique_ptr<SessionRecorder> create(std::string_view name);
+
+    void encodeScreen(const base::Frame* frame);
+    void encodeAudio(const proto::AudioPacket& audio_packet, AudioEncoderCache* encoder_cache);
+
+    // Client ID of the recorder in the encoder caches. The IDs of the client sessions start from 1.
+    static const uint32_t kClientId = 0;
+
+private:
+    SessionRecorder(const std::filesystem::path& path, std::string_view name);
+
+    void resetEncoder();
+
+    base::WebmFileWriter writer_;
+    std::unique_ptr<base::VideoEncoderVPX> encoder_;
+    proto::VideoPacket packet_;
+    std::chrono::steady_clock::time_point segment_start_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(SessionRecorder);
+};
+
+} // namespace host
+
+#endif // HOST__SESSION_RECORDER_H
@@ -27,26 +27,38 @@
 
 namespace host {
 
-void createSystemInfo(proto::SystemInfo* system_info)
+namespace {
+
+void addComputer(proto::SystemInfo* system_info)
 {
     proto::system_info::Computer* computer = system_info->mutable_computer();
     computer->set_name(base::SysInfo::computerName());
     computer->set_domain(base::SysInfo::computerDomain());
     computer->set_workgroup(base::SysInfo::computerWorkgroup());
     computer->set_uptime(base::SysInfo::uptime());
+}
 
+void addOperatingSystem(proto::SystemInfo* system_info)
+{
     proto::system_info::OperatingSystem* operating_system = system_info->mutable_operating_system();
     operating_system->set_name(base::SysInfo::operatingSystemName());
     operating_system->set_version(base::SysInfo::operatingSystemVersion());
     operating_system->set_arch(base::SysInfo::operatingSystemArchitecture());
+}
 
+void addProcessor(proto::SystemInfo* system_info)
+{
     proto::system_info::Processor* processor = system_info->mutable_processor();
     processor->set_vendor(base::SysInfo::processorVendor());
     processor->set_model(base::SysInfo::processorName());
     processor->set_packages(base::SysInfo::processorPackages());
     processor->set_cores(base::SysInfo::processorCores());
     processor->set_threads(base::SysInfo::processorThreads());
+}
 
+// BIOS, motherboard and memory modules are read from one SMBIOS dump.
+void addSmbios(uint32_t categories, proto::SystemInfo* system_info)
+{
     for (base::SmbiosTableEnumerator enumerator(base::readSmbiosDump());
          !enumerator.isAtEnd(); enumerator.advance())
     {
@@ -56,6 +68,9 @@ void createSystemInfo(proto::SystemInfo* system_info)
         {
             case base::SMBIOS_TABLE_TYPE_BIOS:
             {
+                if (!(categories & proto::SystemInfoRequest::CATEGORY_BIOS))
+                    continue;
+
                 base::SmbiosBios bios_table(table);
 
                 proto::system_info::Bios* bios = system_info->mutable_bios();
@@ -67,6 +82,9 @@ void createSystemInfo(proto::SystemInfo* system_info)
 
             case base::SMBIOS_TABLE_TYPE_BASEBOARD:
             {
+                if (!(categories & proto::SystemInfoRequest::CATEGORY_MOTHERBOARD))
+                    continue;
+
                 base::SmbiosBaseboard baseboard_table(table);
                 if (!baseboard_table.isValid())
                     continue;
@@ -79,6 +97,9 @@ void createSystemInfo(proto::SystemInfo* system_info)
 
             case base::SMBIOS_TABLE_TYPE_MEMORY_DEVICE:
             {
+                if (!(categories & proto::SystemInfoRequest::CATEGORY_MEMORY))
+                    continue;
+
                 base::SmbiosMemoryDevice memory_device_table(table);
                 if (!memory_device_table.isValid())
                     continue;
@@ -105,7 +126,10 @@ void createSystemInfo(proto::SystemInfo* system_info)
                 break;
         }
     }
+}
 
+void addLogicalDrives(proto::SystemInfo* system_info)
+{
     for (base::win::DriveEnumerator enumerator; !enumerator.isAtEnd(); enumerator.advance())
     {
         const base::win::DriveEnumerator::DriveInfo& drive_info = enumerator.driveInfo();
@@ -118,7 +142,10 @@ void createSystemInfo(proto::SystemInfo* system_info)
         drive->set_total_size(drive_info.totalSpace());
         drive->set_free_size(drive_info.freeSpace());
     }
+}
 
+void addPrinters(proto::SystemInfo* system_info)
+{
     for (base::win::PrinterEnumerator enumerator; !enumerator.isAtEnd(); enumerator.advance())
     {
         proto::system_info::Printers::Printer* printer =
@@ -132,7 +159,10 @@ void createSystemInfo(proto::SystemInfo* system_info)
         printer->set_jobs_count(enumerator.jobsCount());
         printer->set_share_name(enumerator.shareName());
     }
+}
 
+void addNetworkAdapters(proto::SystemInfo* system_info)
+{
     for (base::AdapterEnumerator enumerator; !enumerator.isAtEnd(); enumerator.advance())
     {
         proto::system_info::NetworkAdapters::Adapter* adapter =
@@ -175,4 +205,33 @@ void createSystemInfo(proto::SystemInfo* system_info)
     }
 }
 
+} // namespace
+
+void createSystemInfo(uint32_t categories, proto::SystemInfo* system_info)
+{
+    if (categories & proto::SystemInfoRequest::CATEGORY_COMPUTER)
+        addComputer(system_info);
+
+    if (categories & proto::SystemInfoRequest::CATEGORY_OPERATING_SYSTEM)
+        addOperatingSystem(system_info);
+
+    if (categories & proto::SystemInfoRequest::CATEGORY_PROCESSOR)
+        addProcessor(system_info);
+
+    const uint32_t kSmbiosCategories = proto::SystemInfoRequest::CATEGORY_BIOS |
+        proto::SystemInfoRequest::CATEGORY_MOTHERBOARD | proto::SystemInfoRequest::CATEGORY_MEMORY;
+
+    if (categories & kSmbiosCategories)
+        addSmbios(categories, system_info);
+
+    if (categories & proto::SystemInfoRequest::CATEGORY_LOGICAL_DRIVES)
+        addLogicalDrives(system_info);
+
+    if (categories & proto::SystemInfoRequest::CATEGORY_PRINTERS)
+        addPrinters(system_info);
+
+    if (categories & proto::SystemInfoRequest::CATEGORY_NETWORK_ADAPTERS)
+        addNetworkAdapters(system_info);
+}
+
 } // namespace host
@@ -23,7 +23,10 @@
 
 namespace host {
 
-void createSystemInfo(proto::SystemInfo* system_info);
+// Collects the |categories| of the system information (combination of
+// proto::SystemInfoRequest::Category values). On some computers it takes seconds (see
+// SystemInfoCache).
+void createSystemInfo(uint32_t categories, proto::SystemInfo* system_info);
 
 } // namespace host
 
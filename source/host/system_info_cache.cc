@@ -0,0 +1,210 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "host/system_info_cache.h"
+
+#include "base/logging.h"
+#include "base/sys_info.h"
+#include "base/task_runner.h"
+#include "base/threading/thread_pool.h"
+#include "host/system_info.h"
+
+#include <algorithm>
+
+namespace host {
+
+using Seconds = std::chrono::seconds;
+
+struct SystemInfoCache::Category
+{
+    uint32_t mask;
+
+    // Time to keep the category. It is doubled up to |max_ttl| while the category does not change.
+    Seconds ttl;
+    Seconds max_ttl;
+
+    google::protobuf::MessageLite* (*field)(proto::SystemInfo* system_info);
+};
+
+// static
+const SystemInfoCache::Category SystemInfoCache::kCategories[kCategoryCount] =
+{
+    // The uptime is not cached (see request).
+    { proto::SystemInfoRequest::CATEGORY_COMPUTER, Seconds(600), Seconds(3600),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_computer();
+      }
+    },
+    { proto::SystemInfoRequest::CATEGORY_OPERATING_SYSTEM, Seconds(600), Seconds(3600),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_operating_system();
+      }
+    },
+    { proto::SystemInfoRequest::CATEGORY_MOTHERBOARD, Seconds(3600), Seconds(86400),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_motherboard();
+      }
+    },
+    { proto::SystemInfoRequest::CATEGORY_BIOS, Seconds(3600), Seconds(86400),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_bios();
+      }
+    },
+    { proto::SystemInfoRequest::CATEGORY_PROCESSOR, Seconds(3600), Seconds(86400),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_processor();
+      }
+    },
+    { proto::SystemInfoRequest::CATEGORY_MEMORY, Seconds(3600), Seconds(86400),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_memory();
+      }
+    },
+    // The free space of the drives changes all the time.
+    { proto::SystemInfoRequest::CATEGORY_LOGICAL_DRIVES, Seconds(30), Seconds(300),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_logical_drives();
+      }
+    },
+    { proto::SystemInfoRequest::CATEGORY_PRINTERS, Seconds(60), Seconds(600),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_printers();
+      }
+    },
+    { proto::SystemInfoRequest::CATEGORY_NETWORK_ADAPTERS, Seconds(60), Seconds(600),
+      [](proto::SystemInfo* info) -> google::protobuf::MessageLite*
+      {
+          return info->mutable_network_adapters();
+      }
+    }
+};
+
+SystemInfoCache::SystemInfoCache()
+    : thread_pool_(std::make_unique<base::ThreadPool>(1))
+{
+    task_runner_ = thread_pool_->createSequencedTaskRunner();
+}
+
+SystemInfoCache::~SystemInfoCache() = default;
+
+// static
+SystemInfoCache* SystemInfoCache::instance()
+{
+    static SystemInfoCache* cache = new SystemInfoCache();
+    return cache;
+}
+
+void SystemInfoCache::request(uint32_t categories, bool refresh, Callback callback)
+{
+    if (!categories)
+        categories = ~0u;
+
+    task_runner_->postTask([this, categories, refresh, callback = std::move(callback)]()
+    {
+        update(categories, refresh);
+
+        proto::SystemInfo result;
+
+        for (size_t i = 0; i < kCategoryCount; ++i)
+        {
+            const Category& category = kCategories[i];
+            if (!(categories & category.mask))
+                continue;
+
+            category.field(&result)->CheckTypeAndMergeFrom(*category.field(&system_info_));
+        }
+
+        if (categories & proto::SystemInfoRequest::CATEGORY_COMPUTER)
+            result.mutable_computer()->set_uptime(base::SysInfo::uptime());
+
+        callback(result);
+    });
+}
+
+void SystemInfoCache::prefetch()
+{
+    task_runner_->postTask([this]()
+    {
+        update(~0u, false);
+    });
+}
+
+void SystemInfoCache::update(uint32_t categories, bool refresh)
+{
+    const TimePoint now = Clock::now();
+    uint32_t expired = 0;
+
+    for (size_t i = 0; i < kCategoryCount; ++i)
+    {
+        const Entry& entry = entries_[i];
+
+        if (!(categories & kCategories[i].mask))
+            continue;
+
+        if (refresh || !entry.valid || now - entry.time >= entry.ttl)
+            expired |= kCategories[i].mask;
+    }
+
+    if (!expired)
+        return;
+
+    proto::SystemInfo system_info;
+    createSystemInfo(expired, &system_info);
+
+    for (size_t i = 0; i < kCategoryCount; ++i)
+    {
+        const Category& category = kCategories[i];
+        if (!(expired & category.mask))
+            continue;
+
+        google::protobuf::MessageLite* field = category.field(&system_info);
+        std::string data = field->SerializeAsString();
+        Entry& entry = entries_[i];
+
+        if (entry.valid && entry.data == data)
+        {
+            // The category has not changed, it is checked less often.
+            entry.ttl = std::min(entry.ttl * 2, category.max_ttl);
+        }
+        else
+        {
+            if (entry.valid)
+                LOG(LS_INFO) << "System info category " << category.mask << " has changed";
+
+            entry.ttl = category.ttl;
+            entry.data = std::move(data);
+
+            google::protobuf::MessageLite* cached = category.field(&system_info_);
+            cached->Clear();
+            cached->CheckTypeAndMergeFrom(*field);
+        }
+
+        entry.valid = true;
+        entry.time = now;
+    }
+}
+
+} // namespace host
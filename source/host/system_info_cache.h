@@ -0,0 +1,93 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST__SYSTEM_INFO_CACHE_H
+#define HOST__SYSTEM_INFO_CACHE_H
+
+#include "base/macros_magic.h"
+#include "proto/desktop_extensions.pb.h"
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace base {
+class TaskRunner;
+class ThreadPool;
+} // namespace base
+
+namespace host {
+
+// Collects the system information on a background thread and keeps each category for a time that
+// depends on how often it changes. If a category is collected again and has not changed, it is
+// kept twice as long next time (up to a limit). The class is thread-safe.
+class SystemInfoCache
+{
+public:
+    using Callback = std::function<void(const proto::SystemInfo& system_info)>;
+
+    // Returns the cache which is shared by the whole process. It is never destroyed.
+    static SystemInfoCache* instance();
+
+    // Calls |callback| on the background thread with the |categories| (combination of
+    // proto::SystemInfoRequest::Category values, zero means all). The categories which are not in
+    // the cache or are expired are collected. If |refresh| is set, all requested categories are
+    // collected.
+    void request(uint32_t categories, bool refresh, Callback callback);
+
+    // Collects all categories in advance, so the first request is answered from the cache.
+    void prefetch();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    struct Category;
+
+    static const size_t kCategoryCount = 9;
+    static const Category kCategories[kCategoryCount];
+
+    struct Entry
+    {
+        bool valid = false;
+        TimePoint time;
+        std::chrono::seconds ttl;
+        std::string data; // Serialized part of proto::SystemInfo to detect changes.
+    };
+
+    SystemInfoCache();
+    ~SystemInfoCache();
+
+    // Must be called on the background thread.
+    void update(uint32_t categories, bool refresh);
+
+    std::unique_ptr<base::ThreadPool> thread_pool_;
+    std::shared_ptr<base::TaskRunner> task_runner_;
+
+    // Used only on the background thread.
+    std::array<Entry, kCategoryCount> entries_;
+    proto::SystemInfo system_info_;
+
+    DISALLOW_COPY_AND_ASSIGN(SystemInfoCache);
+};
+
+} // namespace host
+
+#endif // HOST__SYSTEM_INFO_CACHE_H
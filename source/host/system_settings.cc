@@ -236,4 +236,34 @@ void SystemSettings::setPreferredVideoCapturer(uint32_t type)
     settings_.set("PreferredVideoCapturer", type);
 }
 
+std::u16string SystemSettings::fakeScreenFile() const
+{
+    return settings_.get<std::u16string>("FakeScreenFile");
+}
+
+void SystemSettings::setFakeScreenFile(const std::u16string& file)
+{
+    settings_.set("FakeScreenFile", file);
+}
+
+std::u16string SystemSettings::sessionRecordingPath() const
+{
+    return settings_.get<std::u16string>("SessionRecordingPath");
+}
+
+void SystemSettings::setSessionRecordingPath(const std::u16string& path)
+{
+    settings_.set("SessionRecordingPath", path);
+}
+
+std::string SystemSettings::congestionControl() const
+{
+    return settings_.get<std::string>("CongestionControl");
+}
+
+void SystemSettings::setCongestionControl(const std::string& algorithm)
+{
+    settings_.set("CongestionControl", algorithm);
+}
+
 } // namespace host
@@ -64,6 +64,21 @@ public:
     uint32_t preferredVideoCapturer() const;
     void setPreferredVideoCapturer(uint32_t type);
 
+    // File with the recorded screen which is replayed by the fake video capturer (see
+    // base::ScreenFixture). If empty, synthetic frames are used.
+    std::u16string fakeScreenFile() const;
+    void setFakeScreenFile(const std::u16string& file);
+
+    // Directory where the desktop sessions are recorded (see SessionRecorder). If empty, the
+    // sessions are not recorded.
+    std::u16string sessionRecordingPath() const;
+    void setSessionRecordingPath(const std::u16string& path);
+
+    // TCP congestion control algorithm of the client connections (for example, "bbr"). If empty,
+    // the default algorithm of the system is used. Supported only on Linux.
+    std::string congestionControl() const;
+    void setCongestionControl(const std::string& algorithm);
+
 private:
     base::JsonSettings settings_;
 
@@ -143,11 +143,18 @@ ConfigDialog::ConfigDialog(QWidget* parent)
     ui.combo_video_capturer->addItem(
         QStringLiteral("DXGI"), static_cast<uint32_t>(base::ScreenCapturer::Type::WIN_DXGI));
 
+    ui.combo_video_capturer->addItem(
+        QStringLiteral("WGC"), static_cast<uint32_t>(base::ScreenCapturer::Type::WIN_WGC));
+
     ui.combo_video_capturer->addItem(
         QStringLiteral("GDI"), static_cast<uint32_t>(base::ScreenCapturer::Type::WIN_GDI));
 #elif defined(OS_LINUX)
     ui.combo_video_capturer->addItem(
         QStringLiteral("X11"), static_cast<uint32_t>(base::ScreenCapturer::Type::LINUX_X11));
+
+    ui.combo_video_capturer->addItem(
+        QStringLiteral("PipeWire"),
+        static_cast<uint32_t>(base::ScreenCapturer::Type::LINUX_PIPEWIRE));
 #elif defined(OS_MAC)
     ui.combo_video_capturer->addItem(
         QStringLiteral("MACOSX"), static_cast<uint32_t>(base::ScreenCapturer::Type::MACOSX));
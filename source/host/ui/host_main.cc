@@ -20,6 +20,8 @@
 
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/macros_magic.h"
+#include "base/settings/settings_writer.h"
 #include "host/integrity_check.h"
 #include "host/system_settings.h"
 #include "host/ui/application.h"
@@ -36,6 +38,18 @@
 
 namespace {
 
+// The settings writer of the shared library is not destroyed before the threads of the process
+// are terminated, so the scheduled writes are completed when the host returns.
+class ScopedSettingsFlush
+{
+public:
+    ScopedSettingsFlush() = default;
+    ~ScopedSettingsFlush() { base::SettingsWriter::instance()->flushAll(); }
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(ScopedSettingsFlush);
+};
+
 bool waitForValidInputDesktop()
 {
     int max_attempt_count = 600;
@@ -70,6 +84,8 @@ int hostMain(int argc, char* argv[])
     Q_INIT_RESOURCE(common);
     Q_INIT_RESOURCE(common_translations);
 
+    ScopedSettingsFlush settings_flush;
+
     base::CommandLine command_line(argc, argv);
 
     bool is_hidden = command_line.hasSwitch(u"hidden");
@@ -34,11 +34,15 @@ namespace host {
 
 UserSession::UserSession(std::shared_ptr<base::TaskRunner> task_runner,
                          base::SessionId session_id,
-                         std::unique_ptr<base::IpcChannel> channel)
+                         std::unique_ptr<base::IpcChannel> channel,
+                         CaptureBudget* capture_budget)
     : task_runner_(task_runner),
       channel_(std::move(channel)),
-      attach_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner),
-      session_id_(session_id)
+      attach_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner,
+                    base::WaitableTimer::Precision::COARSE),
+      session_id_(session_id),
+      capture_budget_(capture_budget),
+      capture_budget_id_(capture_budget->addSession())
 {
     DCHECK(task_runner_);
 
@@ -50,7 +54,10 @@ UserSession::UserSession(std::shared_ptr<base::TaskRunner> task_runner,
     router_state_.set_state(proto::internal::RouterState::DISABLED);
 }
 
-UserSession::~UserSession() = default;
+UserSession::~UserSession()
+{
+    capture_budget_->removeSession(capture_budget_id_);
+}
 
 void UserSession::start(Delegate* delegate)
 {
@@ -173,6 +180,7 @@ void UserSession::addNewSession(std::unique_ptr<ClientSession> client_session)
 
             desktop_client_session->setDesktopSessionProxy(desktop_session_proxy_);
             desktop_session_proxy_->control(proto::internal::Control::ENABLE);
+            updateRecording();
         }
         break;
 
@@ -333,6 +341,7 @@ void UserSession::onDesktopSessionStopped()
     {
         desktop_clients_.clear();
         file_transfer_clients_.clear();
+        updateRecording();
 
         onSessionDettached(FROM_HERE);
     }
@@ -340,14 +349,85 @@ void UserSession::onDesktopSessionStopped()
 
 void UserSession::onScreenCaptured(const base::Frame* frame, const base::MouseCursor* cursor)
 {
+    std::chrono::milliseconds capture_interval = std::chrono::milliseconds::zero();
+    std::chrono::milliseconds preview_interval = std::chrono::milliseconds::zero();
+
+    if (frame)
+        video_encoder_cache_.beginFrame();
+
+    for (const auto& client : desktop_clients_)
+    {
+        ClientSessionDesktop* desktop_client = static_cast<ClientSessionDesktop*>(client.get());
+        desktop_client->requestScreen(frame, &video_encoder_cache_);
+    }
+
+    // The frame is encoded for all the clients at once, the different formats in parallel.
+    if (frame)
+        video_encoder_cache_.encodeFrames();
+
     for (const auto& client : desktop_clients_)
-        static_cast<ClientSessionDesktop*>(client.get())->encodeScreen(frame, cursor);
+    {
+        ClientSessionDesktop* desktop_client = static_cast<ClientSessionDesktop*>(client.get());
+
+        desktop_client->sendScreen(frame, cursor, &video_encoder_cache_, &cursor_cache_);
+
+        if (desktop_client->isPreview() || desktop_client->isHidden())
+        {
+            // The previews and the hidden windows skip the frames they do not need and do not slow
+            // down the others.
+            preview_interval = std::max(preview_interval, desktop_client->captureInterval());
+            continue;
+        }
+
+        // All clients get the same frames, so the screen is captured no more often than the
+        // slowest client can receive.
+        capture_interval = std::max(capture_interval, desktop_client->captureInterval());
+    }
+
+    // If there are only previews and hidden windows, the screen is captured at their rate. Such
+    // sessions give way to the others when the capacity of the host is shared.
+    CaptureBudget::Priority priority = CaptureBudget::Priority::NORMAL;
+    if (capture_interval == std::chrono::milliseconds::zero())
+    {
+        capture_interval = preview_interval;
+        priority = CaptureBudget::Priority::LOW;
+    }
+
+    if (recorder_)
+        recorder_->encodeScreen(frame);
+
+    if (capture_interval == std::chrono::milliseconds::zero())
+        return;
+
+    int64_t changed_pixels = 0;
+    if (frame)
+    {
+        for (base::Region::Iterator it(frame->constUpdatedRegion()); !it.isAtEnd(); it.advance())
+            changed_pixels += static_cast<int64_t>(it.rect().width()) * it.rect().height();
+    }
+
+    desktop_session_proxy_->setCaptureInterval(
+        capture_budget_->update(capture_budget_id_, changed_pixels, capture_interval, priority));
 }
 
 void UserSession::onAudioCaptured(const proto::AudioPacket& audio_packet)
+{
+    audio_encoder_cache_.beginPacket();
+
+    for (const auto& client : desktop_clients_)
+    {
+        static_cast<ClientSessionDesktop*>(client.get())->encodeAudio(
+            audio_packet, &audio_encoder_cache_);
+    }
+
+    if (recorder_)
+        recorder_->encodeAudio(audio_packet, &audio_encoder_cache_);
+}
+
+void UserSession::onCursorPositionChanged(const base::Point& position)
 {
     for (const auto& client : desktop_clients_)
-        static_cast<ClientSessionDesktop*>(client.get())->encodeAudio(audio_packet);
+        static_cast<ClientSessionDesktop*>(client.get())->sendCursorPosition(position);
 }
 
 void UserSession::onScreenListChanged(const proto::ScreenList& list)
@@ -441,6 +521,8 @@ void UserSession::onClientSessionFinished()
     delete_finished(&desktop_clients_);
     delete_finished(&file_transfer_clients_);
 
+    updateRecording();
+
     if (desktop_clients_.empty())
         desktop_session_proxy_->control(proto::internal::Control::DISABLE);
 }
@@ -576,4 +658,26 @@ void UserSession::sendRouterState()
     channel_->send(base::serialize(outgoing_message_));
 }
 
+void UserSession::updateRecording()
+{
+    if (desktop_clients_.empty())
+    {
+        if (recorder_)
+            LOG(LS_INFO) << "Session recording stopped";
+
+        // The queued packets are written and the file is finalized.
+        recorder_.reset();
+        return;
+    }
+
+    if (recorder_)
+        return;
+
+    std::string name = sessionName();
+    if (name.empty())
+        name = "console";
+
+    recorder_ = SessionRecorder::create("session-" + name);
+}
+
 } // namespace host
@@ -21,12 +21,17 @@
 
 #include "base/session_id.h"
 #include "base/waitable_timer.h"
+#include "base/codec/cursor_encoder.h"
 #include "base/ipc/ipc_channel.h"
 #include "base/peer/host_id.h"
 #include "base/peer/user_list.h"
 #include "base/win/session_status.h"
+#include "host/audio_encoder_cache.h"
+#include "host/capture_budget.h"
 #include "host/client_session.h"
 #include "host/desktop_session_manager.h"
+#include "host/session_recorder.h"
+#include "host/video_encoder_cache.h"
 #include "proto/host_internal.pb.h"
 
 namespace host {
@@ -60,9 +65,11 @@ public:
         virtual void onUserSessionFinished() = 0;
     };
 
+    // |capture_budget| is shared by all the user sessions of the host and must outlive them.
     UserSession(std::shared_ptr<base::TaskRunner> task_runner,
                 base::SessionId session_id,
-                std::unique_ptr<base::IpcChannel> channel);
+                std::unique_ptr<base::IpcChannel> channel,
+                CaptureBudget* capture_budget);
     ~UserSession();
 
     void start(Delegate* delegate);
@@ -90,6 +97,7 @@ protected:
     void onDesktopSessionStopped() override;
     void onScreenCaptured(const base::Frame* frame, const base::MouseCursor* cursor) override;
     void onAudioCaptured(const proto::AudioPacket& audio_packet) override;
+    void onCursorPositionChanged(const base::Point& position) override;
     void onScreenListChanged(const proto::ScreenList& list) override;
     void onClipboardEvent(const proto::ClipboardEvent& event) override;
 
@@ -105,6 +113,7 @@ private:
     void sendCredentials();
     void killClientSession(uint32_t id);
     void sendRouterState();
+    void updateRecording();
 
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::unique_ptr<base::IpcChannel> channel_;
@@ -127,6 +136,19 @@ private:
     std::unique_ptr<DesktopSessionManager> desktop_session_;
     std::shared_ptr<DesktopSessionProxy> desktop_session_proxy_;
 
+    // Encoders and compressed cursor shapes shared by the desktop clients.
+    VideoEncoderCache video_encoder_cache_;
+    AudioEncoderCache audio_encoder_cache_;
+    base::CursorEncoder::SharedCache cursor_cache_;
+
+    // The capture rate requested by the clients is limited by the share of the session in the
+    // capacity of the host.
+    CaptureBudget* capture_budget_;
+    const int capture_budget_id_;
+
+    // Records the desktop while there are desktop clients.
+    std::unique_ptr<SessionRecorder> recorder_;
+
     proto::internal::UiToService incoming_message_;
     proto::internal::ServiceToUi outgoing_message_;
 
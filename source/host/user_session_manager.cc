@@ -429,7 +429,7 @@ void UserSessionManager::addUserSession(
     }
 
     std::unique_ptr<UserSession> user_session = std::make_unique<UserSession>(
-        task_runner_, session_id, std::move(channel));
+        task_runner_, session_id, std::move(channel), &capture_budget_);
     user_session->setRouterState(router_state_);
 
     sessions_.emplace_back(std::move(user_session));
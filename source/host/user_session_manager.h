@@ -22,6 +22,7 @@
 #include "base/session_id.h"
 #include "base/ipc/ipc_server.h"
 #include "base/win/session_status.h"
+#include "host/capture_budget.h"
 #include "host/user_session.h"
 
 namespace host {
@@ -69,6 +70,7 @@ private:
 
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::unique_ptr<base::IpcServer> ipc_server_;
+    CaptureBudget capture_budget_;
     std::vector<std::unique_ptr<UserSession>> sessions_;
     Delegate* delegate_ = nullptr;
 
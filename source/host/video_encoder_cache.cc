@@ -0,0 +1,547 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "host/video_encoder_cache.h"
+
+#include "base/logging.h"
+#include "base/codec/scale_reducer.h"
+#include "base/codec/video_encoder_aom.h"
+#include "base/codec/video_encoder_mf.h"
+#include "base/codec/video_encoder_vpx.h"
+#include "base/codec/viewport_filter.h"
+#include "base/desktop/frame_view.h"
+#include "base/threading/thread_pool.h"
+#include "base/trace_event.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace host {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint32_t toMicroseconds(const Clock::duration& duration)
+{
+    const int64_t value = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return static_cast<uint32_t>(
+        std::clamp<int64_t>(value, 0, std::numeric_limits<uint32_t>::max()));
+}
+
+// Fills the durations of the capture, the scaling and the encoding of the frame.
+void setTiming(const base::Frame::Timing& frame_timing,
+               const Clock::time_point& scale_start,
+               const Clock::time_point& encode_start,
+               proto::VideoPacketTiming* timing)
+{
+    // The frames of the fake desktop session have no capture times.
+    if (frame_timing.capture_end != Clock::time_point())
+    {
+        timing->set_capture(toMicroseconds(frame_timing.capture_end - frame_timing.capture_start));
+        timing->set_diff(toMicroseconds(frame_timing.diff));
+        timing->set_wait(toMicroseconds(scale_start - frame_timing.capture_end));
+    }
+
+    timing->set_scale(toMicroseconds(encode_start - scale_start));
+    timing->set_encode(toMicroseconds(Clock::now() - encode_start));
+}
+
+std::unique_ptr<base::VideoEncoder> createEncoder(
+    proto::VideoEncoding encoding, bool full_chroma, bool layered)
+{
+    switch (encoding)
+    {
+        case proto::VIDEO_ENCODING_VP8:
+            return base::VideoEncoderVPX::createVP8();
+
+        case proto::VIDEO_ENCODING_VP9:
+        {
+            std::unique_ptr<base::VideoEncoderVPX> encoder = base::VideoEncoderVPX::createVP9();
+            encoder->setFullChroma(full_chroma);
+
+            if (layered)
+            {
+                // The frames of a client must not depend on the tiles and the copy rects of the
+                // frames it skipped.
+                encoder->setBitstreamOnly(true);
+                encoder->setTemporalLayers(true);
+            }
+
+            return encoder;
+        }
+
+        case proto::VIDEO_ENCODING_AV1:
+            return base::VideoEncoderAOM::createAV1();
+
+        case proto::VIDEO_ENCODING_H264:
+        {
+            std::unique_ptr<base::VideoEncoder> encoder = base::VideoEncoderMF::createH264();
+            if (!encoder)
+            {
+                // The client changes the decoder when it sees another encoding in video packets.
+                LOG(LS_WARNING) << "Hardware H.264 encoder not available. VP8 is used instead";
+                encoder = base::VideoEncoderVPX::createVP8();
+            }
+
+            return encoder;
+        }
+
+        default:
+            LOG(LS_WARNING) << "Unsupported video encoding: " << encoding;
+            return nullptr;
+    }
+}
+
+} // namespace
+
+bool VideoEncoderCache::Key::operator==(const Key& other) const
+{
+    return encoding == other.encoding && full_chroma == other.full_chroma &&
+           size == other.size && frame_interval == other.frame_interval;
+}
+
+bool VideoEncoderCache::Key::operator<(const Key& other) const
+{
+    if (encoding != other.encoding)
+        return encoding < other.encoding;
+
+    if (full_chroma != other.full_chroma)
+        return full_chroma < other.full_chroma;
+
+    if (size.width() != other.size.width())
+        return size.width() < other.size.width();
+
+    if (size.height() != other.size.height())
+        return size.height() < other.size.height();
+
+    return frame_interval < other.frame_interval;
+}
+
+VideoEncoderCache::Group::Group() = default;
+VideoEncoderCache::Group::~Group() = default;
+
+VideoEncoderCache::VideoEncoderCache() = default;
+VideoEncoderCache::~VideoEncoderCache() = default;
+
+// static
+bool VideoEncoderCache::isSupported(proto::VideoEncoding encoding)
+{
+    switch (encoding)
+    {
+        case proto::VIDEO_ENCODING_VP8:
+        case proto::VIDEO_ENCODING_VP9:
+        case proto::VIDEO_ENCODING_AV1:
+        case proto::VIDEO_ENCODING_H264:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void VideoEncoderCache::beginFrame()
+{
+    ++frame_number_;
+
+    // Every active client gets every frame. A client which did not get the previous frame is
+    // disconnected or not configured.
+    for (auto it = clients_.begin(); it != clients_.end();)
+    {
+        if (it->second.frame_number + 1 < frame_number_)
+            it = clients_.erase(it);
+        else
+            ++it;
+    }
+
+    for (auto it = groups_.begin(); it != groups_.end();)
+    {
+        if (!hasClients(it->first))
+            it = groups_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void VideoEncoderCache::request(uint32_t client_id,
+                                proto::VideoEncoding encoding,
+                                bool full_chroma,
+                                const base::Frame* frame,
+                                const base::Size& size,
+                                const std::chrono::milliseconds& frame_interval,
+                                const base::Rect& viewport,
+                                const base::VideoRateController::Settings& settings,
+                                bool restart)
+{
+    TRACE_EVENT("host", "VideoEncoderCache::request");
+
+    const Key key{ encoding, full_chroma, size, frame_interval };
+
+    auto client = clients_.find(client_id);
+
+    bool is_joined = restart;
+    if (client == clients_.end())
+    {
+        client = clients_.emplace(client_id, Client()).first;
+        is_joined = true;
+    }
+    else if (!(client->second.key == key))
+    {
+        is_joined = true;
+    }
+
+    client->second.key = key;
+    client->second.settings = settings;
+    client->second.viewport = viewport;
+    client->second.frame_number = frame_number_;
+
+    Group& group = groups_[key];
+
+    if (group.frame_number != frame_number_)
+    {
+        // The first client of the group in this frame decides whether the frame is encoded.
+        group.frame_number = frame_number_;
+        group.frame = frame;
+        group.packet.Clear();
+        group.is_pending = false;
+        group.is_encoded = false;
+        group.is_key_frame = false;
+
+        const Clock::time_point now = Clock::now();
+
+        if (is_joined || group.reset_required || !group.encoder)
+        {
+            group.reset_required = true;
+        }
+        else if (!frame->hasChanges() && !group.encoder->isRefining() &&
+                 !group.viewport_filter->hasDeferredChanges())
+        {
+            // Nothing to send.
+            return;
+        }
+        else if (now - group.encode_time < frame_interval * 3 / 4)
+        {
+            // Not the time for the next frame yet. The captures are not exactly periodic, so a
+            // frame which comes a bit early is not skipped.
+            if (frame->hasChanges())
+                group.has_skipped_frames = true;
+            return;
+        }
+        else if (group.has_skipped_frames)
+        {
+            // The changes of the skipped frames are not in the updated region of this frame.
+            group.scale_reducer->invalidate();
+        }
+
+        group.encode_time = now;
+        group.has_skipped_frames = false;
+        group.is_pending = true;
+    }
+    else if (is_joined)
+    {
+        // The frame is not encoded yet. The encoder is created again, so all the clients of the
+        // group get a key frame.
+        group.reset_required = true;
+        group.is_pending = true;
+        group.encode_time = Clock::now();
+        group.has_skipped_frames = false;
+    }
+}
+
+void VideoEncoderCache::encodeFrames()
+{
+    TRACE_EVENT("host", "VideoEncoderCache::encodeFrames");
+
+    std::vector<base::ThreadPool::Task> tasks;
+
+    for (auto& [key, group] : groups_)
+    {
+        if (group.frame_number != frame_number_ || !group.is_pending)
+            continue;
+
+        // The encoders are created and configured here using all the clients of the group.
+        if (group.reset_required)
+        {
+            resetEncoder(key, &group);
+            if (!group.encoder)
+                continue;
+        }
+
+        updateRateControl(key, &group);
+
+        if (!group.is_key_frame)
+            group.viewport_filter->setViewport(groupViewport(key));
+
+        // The scale reducer may add to the updated region of the frame. Each group changes its own
+        // view of the frame.
+        group.frame_view = std::make_unique<base::FrameView>(*group.frame);
+
+        tasks.emplace_back([&group = group, size = key.size]() { encodeFrame(size, &group); });
+    }
+
+    if (tasks.size() == 1)
+    {
+        tasks.front()();
+        return;
+    }
+
+    // The groups do not share anything but the frame, which they only read. The call returns when
+    // all the groups are encoded, so the frame stays valid.
+    base::ThreadPool::shared()->runTasks(std::move(tasks));
+}
+
+const proto::VideoPacket* VideoEncoderCache::packet(uint32_t client_id)
+{
+    auto client = clients_.find(client_id);
+    if (client == clients_.end() || client->second.frame_number != frame_number_)
+        return nullptr;
+
+    auto group = groups_.find(client->second.key);
+    if (group == groups_.end() || group->second.frame_number != frame_number_ ||
+        !group->second.is_encoded)
+    {
+        return nullptr;
+    }
+
+    if (group->second.layered)
+        return layerPacket(group->second, &client->second);
+
+    return &group->second.packet;
+}
+
+// static
+void VideoEncoderCache::encodeFrame(const base::Size& size, Group* group)
+{
+    TRACE_EVENT("host", "VideoEncoderCache::encodeFrame");
+
+    const Clock::time_point scale_start = Clock::now();
+
+    const base::Frame* scaled_frame =
+        group->scale_reducer->scaleFrame(group->frame_view.get(), size);
+    if (!scaled_frame)
+    {
+        LOG(LS_ERROR) << "No scaled frame";
+        return;
+    }
+
+    if (group->is_key_frame)
+    {
+        // The key frame contains the whole frame.
+        group->viewport_filter->reset();
+    }
+    else
+    {
+        scaled_frame = group->viewport_filter->filterFrame(scaled_frame);
+        if (!scaled_frame)
+            return;
+    }
+
+    const Clock::time_point encode_start = Clock::now();
+
+    group->encoder->encode(scaled_frame, &group->packet);
+
+    // A hardware encoder may keep the frame and give it with one of the next frames. The packet
+    // has nothing to send then.
+    const proto::VideoPacket& packet = group->packet;
+    group->is_encoded =
+        !packet.data().empty() || packet.has_format() || packet.dirty_rect_size() != 0;
+
+    setTiming(group->frame->timing(), scale_start, encode_start, group->packet.mutable_timing());
+}
+
+bool VideoEncoderCache::hasClients(const Key& key) const
+{
+    for (const auto& client : clients_)
+    {
+        if (client.second.key == key)
+            return true;
+    }
+
+    return false;
+}
+
+int VideoEncoderCache::clientCount(const Key& key) const
+{
+    int count = 0;
+
+    for (const auto& client : clients_)
+    {
+        if (client.second.key == key)
+            ++count;
+    }
+
+    return count;
+}
+
+const proto::VideoPacket* VideoEncoderCache::layerPacket(const Group& group, Client* client)
+{
+    const proto::VideoPacket& packet = group.packet;
+
+    // The client gets the layers which fit into its bitrate. The base layer is always sent.
+    int max_layer = 0;
+    while (max_layer + 1 < base::VideoEncoderVPX::kTemporalLayers &&
+           base::VideoEncoderVPX::temporalLayerBitrate(max_layer + 1, group.bitrate) <=
+               client->settings.bitrate)
+    {
+        ++max_layer;
+    }
+
+    if (packet.has_format())
+    {
+        // The key frame contains everything.
+        client->skipped_region.clear();
+        return &packet;
+    }
+
+    if (static_cast<int>(packet.temporal_layer()) > max_layer)
+    {
+        for (int i = 0; i < packet.dirty_rect_size(); ++i)
+        {
+            const proto::Rect& rect = packet.dirty_rect(i);
+            client->skipped_region.addRect(
+                base::Rect::makeXYWH(rect.x(), rect.y(), rect.width(), rect.height()));
+        }
+
+        return nullptr;
+    }
+
+    if (client->skipped_region.isEmpty())
+        return &packet;
+
+    // The decoder has the whole image after this frame, but the client copies only the dirty
+    // rects from it.
+    client->packet.CopyFrom(packet);
+
+    for (base::Region::Iterator it(client->skipped_region); !it.isAtEnd(); it.advance())
+    {
+        const base::Rect& rect = it.rect();
+
+        proto::Rect* dirty_rect = client->packet.add_dirty_rect();
+        dirty_rect->set_x(rect.x());
+        dirty_rect->set_y(rect.y());
+        dirty_rect->set_width(rect.width());
+        dirty_rect->set_height(rect.height());
+    }
+
+    client->skipped_region.clear();
+    return &client->packet;
+}
+
+void VideoEncoderCache::resetEncoder(const Key& key, Group* group)
+{
+    // Several clients of VP9 get the temporal layers which fit into their bitrates.
+    group->layered = (key.encoding == proto::VIDEO_ENCODING_VP9 && clientCount(key) > 1);
+
+    // The new encoder starts with a key frame which contains the video format.
+    group->encoder = takeResizableEncoder(key, group->layered);
+    if (!group->encoder)
+        group->encoder = createEncoder(key.encoding, key.full_chroma, group->layered);
+    group->scale_reducer = std::make_unique<base::ScaleReducer>();
+    group->viewport_filter = std::make_unique<base::ViewportFilter>();
+    group->reset_required = false;
+    group->is_key_frame = true;
+}
+
+std::unique_ptr<base::VideoEncoder> VideoEncoderCache::takeResizableEncoder(
+    const Key& key, bool layered)
+{
+    // Only the VPX encoders change the size in place.
+    if (key.encoding != proto::VIDEO_ENCODING_VP8 && key.encoding != proto::VIDEO_ENCODING_VP9)
+        return nullptr;
+
+    for (auto it = groups_.begin(); it != groups_.end(); ++it)
+    {
+        const Key& other = it->first;
+        Group& other_group = it->second;
+
+        // The clients of the group have moved to another size (for example, the screen is
+        // switched). The group would be removed at the next frame.
+        if (other.encoding != key.encoding || other.full_chroma != key.full_chroma ||
+            other.frame_interval != key.frame_interval || other.size == key.size ||
+            other_group.layered != layered || !other_group.encoder || hasClients(other))
+        {
+            continue;
+        }
+
+        std::unique_ptr<base::VideoEncoder> encoder = std::move(other_group.encoder);
+        groups_.erase(it);
+
+        // The encoder sends the new format with a key frame when it sees the new size.
+        return encoder;
+    }
+
+    return nullptr;
+}
+
+void VideoEncoderCache::updateRateControl(const Key& key, Group* group)
+{
+    bool has_settings = false;
+    base::VideoRateController::Settings settings;
+
+    for (const auto& client : clients_)
+    {
+        if (!(client.second.key == key))
+            continue;
+
+        const base::VideoRateController::Settings& client_settings = client.second.settings;
+
+        if (!has_settings)
+        {
+            settings = client_settings;
+            has_settings = true;
+            continue;
+        }
+
+        // The layers of the video are sent at the bitrate of the fastest client.
+        if (group->layered)
+            settings.bitrate = std::max(settings.bitrate, client_settings.bitrate);
+        else
+            settings.bitrate = std::min(settings.bitrate, client_settings.bitrate);
+
+        settings.min_quantizer = std::max(settings.min_quantizer, client_settings.min_quantizer);
+        settings.max_quantizer = std::max(settings.max_quantizer, client_settings.max_quantizer);
+    }
+
+    if (!has_settings)
+        return;
+
+    group->bitrate = settings.bitrate;
+    group->encoder->setBitrate(settings.bitrate);
+    group->encoder->setQuantizerRange(settings.min_quantizer, settings.max_quantizer);
+}
+
+base::Rect VideoEncoderCache::groupViewport(const Key& key) const
+{
+    base::Rect viewport;
+
+    for (const auto& client : clients_)
+    {
+        if (!(client.second.key == key))
+            continue;
+
+        // The client sees the whole video.
+        if (client.second.viewport.isEmpty())
+            return base::Rect();
+
+        viewport.unionWith(client.second.viewport);
+    }
+
+    return viewport;
+}
+
+} // namespace host
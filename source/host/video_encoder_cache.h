@@ -0,0 +1,178 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST__VIDEO_ENCODER_CACHE_H
+#define HOST__VIDEO_ENCODER_CACHE_H
+
+#include "base/macros_magic.h"
+#include "base/codec/video_rate_controller.h"
+#include "base/desktop/geometry.h"
+#include "base/desktop/region.h"
+#include "proto/desktop.pb.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+
+namespace base {
+class Frame;
+class FrameView;
+class ScaleReducer;
+class VideoEncoder;
+class ViewportFilter;
+} // namespace base
+
+namespace host {
+
+// Shares video encoders between the desktop clients of one user session. All the clients get the
+// same captured frames, so the clients with the same encoding and the same video size can get the
+// same video packets. The frame is scaled and encoded once for all of them. All the clients
+// request their packets first, then the encoders of the different formats encode the frame in
+// parallel (encodeFrames()) and the clients take the packets.
+//
+// A VP9 encoder shared by several clients encodes the video in temporal layers at the bitrate of
+// the fastest client. A slower client gets only the layers which fit into its bitrate.
+class VideoEncoderCache
+{
+public:
+    VideoEncoderCache();
+    ~VideoEncoderCache();
+
+    // Returns true if there is an encoder for |encoding|.
+    static bool isSupported(proto::VideoEncoding encoding);
+
+    // Must be called for every captured frame before the clients call request(). The clients
+    // which did not get the previous frame are considered to be gone.
+    void beginFrame();
+
+    // Requests the video packet of the current frame for the client |client_id|. |settings| are
+    // the rate control settings of the client. An encoder that is shared uses the most
+    // conservative settings of its clients (like the capture interval, which is chosen by the
+    // slowest client). When a client joins a shared encoder or |restart| is true, the encoder is
+    // created again so that all its clients get a key frame. If |frame_interval| is not zero, the
+    // frames are encoded no more often than |frame_interval| and the clients of the encoder skip
+    // the other frames together. |viewport| is the area of the video which the client sees (empty
+    // if the client sees the whole video). The changes outside of the viewports of all the
+    // clients of the encoder are sent later (see base::ViewportFilter). If |full_chroma| is true,
+    // the VP9 video is encoded without the chroma subsampling (see
+    // base::VideoEncoderVPX::setFullChroma).
+    void request(uint32_t client_id,
+                 proto::VideoEncoding encoding,
+                 bool full_chroma,
+                 const base::Frame* frame,
+                 const base::Size& size,
+                 const std::chrono::milliseconds& frame_interval,
+                 const base::Rect& viewport,
+                 const base::VideoRateController::Settings& settings,
+                 bool restart);
+
+    // Encodes the requested frames. The encoders run in parallel on the thread pool, so the time
+    // does not depend on the number of the different video formats. The frame must stay valid
+    // until the call returns.
+    void encodeFrames();
+
+    // Returns the video packet of the current frame for the client |client_id| or nullptr if the
+    // client gets no packet in this frame (the frame is skipped, has no changes or could not be
+    // encoded).
+    const proto::VideoPacket* packet(uint32_t client_id);
+
+private:
+    struct Key
+    {
+        proto::VideoEncoding encoding;
+        bool full_chroma;
+        base::Size size;
+        std::chrono::milliseconds frame_interval;
+
+        bool operator==(const Key& other) const;
+        bool operator<(const Key& other) const;
+    };
+
+    struct Group
+    {
+        Group();
+        ~Group();
+
+        std::unique_ptr<base::ScaleReducer> scale_reducer;
+        std::unique_ptr<base::ViewportFilter> viewport_filter;
+        std::unique_ptr<base::VideoEncoder> encoder;
+
+        // Packet of the current frame (if |frame_number| is equal to the current frame number).
+        proto::VideoPacket packet;
+        uint64_t frame_number = 0;
+        bool is_encoded = false;
+
+        // The current frame and the view of it which the group changes (see encodeFrames()). The
+        // frame is encoded if it is pending.
+        const base::Frame* frame = nullptr;
+        std::unique_ptr<base::FrameView> frame_view;
+        bool is_pending = false;
+
+        // The packet of the current frame is a key frame.
+        bool is_key_frame = false;
+
+        // The encoder is created again for the current frame.
+        bool reset_required = false;
+
+        // The video has temporal layers (see base::VideoEncoderVPX::setTemporalLayers) and its
+        // bitrate.
+        bool layered = false;
+        uint32_t bitrate = 0;
+
+        // Time of the last encoded frame and whether the frames after it were skipped (see
+        // |frame_interval| of encode()).
+        std::chrono::steady_clock::time_point encode_time;
+        bool has_skipped_frames = false;
+    };
+
+    struct Client
+    {
+        Key key;
+        base::VideoRateController::Settings settings;
+        base::Rect viewport;
+        uint64_t frame_number = 0;
+
+        // Dirty rects of the frames of the upper layers which the client skipped and the packet
+        // of the current frame with them.
+        base::Region skipped_region;
+        proto::VideoPacket packet;
+    };
+
+    bool hasClients(const Key& key) const;
+    int clientCount(const Key& key) const;
+    const proto::VideoPacket* layerPacket(const Group& group, Client* client);
+    static void encodeFrame(const base::Size& size, Group* group);
+    void resetEncoder(const Key& key, Group* group);
+
+    // Returns the encoder of a group which has no clients anymore and differs from |key| only
+    // in the size. Changing the size of the encoder is cheaper than creating it again.
+    std::unique_ptr<base::VideoEncoder> takeResizableEncoder(const Key& key, bool layered);
+
+    void updateRateControl(const Key& key, Group* group);
+    base::Rect groupViewport(const Key& key) const;
+
+    std::map<Key, Group> groups_;
+    std::map<uint32_t, Client> clients_;
+    uint64_t frame_number_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(VideoEncoderCache);
+};
+
+} // namespace host
+
+#endif // HOST__VIDEO_ENCODER_CACHE_H
@@ -19,6 +19,7 @@
 #include "host/win/service_main.h"
 
 #include "base/logging.h"
+#include "base/settings/settings_writer.h"
 #include "host/integrity_check.h"
 #include "host/win/service.h"
 
@@ -37,6 +38,10 @@ void hostServiceMain()
         Service().exec();
     }
 
+    // The settings writer of the shared library is not destroyed before the threads of the
+    // process are terminated.
+    base::SettingsWriter::instance()->flushAll();
+
     base::shutdownLogging();
 }
 
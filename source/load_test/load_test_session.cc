@@ -0,0 +1,276 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "load_test/load_test_session.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "base/desktop/frame_simple.h"
+#include "base/desktop/frame_stamp.h"
+#include "base/peer/authenticator.h"
+#include "client/client_desktop.h"
+#include "client/client_proxy.h"
+#include "client/desktop_window_proxy.h"
+#include "client/frame_factory.h"
+#include "client/status_window_proxy.h"
+
+namespace load_test {
+
+namespace {
+
+class FrameFactorySimple : public client::FrameFactory
+{
+public:
+    FrameFactorySimple() = default;
+    ~FrameFactorySimple() override = default;
+
+    std::shared_ptr<base::Frame> allocateFrame(const base::Size& size) override
+    {
+        return std::shared_ptr<base::Frame>(base::FrameSimple::create(size).release());
+    }
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(FrameFactorySimple);
+};
+
+const char* routerErrorToString(client::RouterController::ErrorCode error_code)
+{
+    switch (error_code)
+    {
+        case client::RouterController::ErrorCode::SUCCESS:
+            return "SUCCESS";
+
+        case client::RouterController::ErrorCode::PEER_NOT_FOUND:
+            return "PEER_NOT_FOUND";
+
+        case client::RouterController::ErrorCode::ACCESS_DENIED:
+            return "ACCESS_DENIED";
+
+        case client::RouterController::ErrorCode::KEY_POOL_EMPTY:
+            return "KEY_POOL_EMPTY";
+
+        case client::RouterController::ErrorCode::RELAY_ERROR:
+            return "RELAY_ERROR";
+
+        default:
+            return "UNKNOWN_ERROR";
+    }
+}
+
+} // namespace
+
+LoadTestSession::LoadTestSession(int id,
+                                 std::shared_ptr<base::TaskRunner> ui_task_runner,
+                                 std::shared_ptr<base::TaskRunner> io_task_runner)
+    : ui_task_runner_(std::move(ui_task_runner)),
+      io_task_runner_(std::move(io_task_runner))
+{
+    DCHECK(ui_task_runner_ && io_task_runner_);
+
+    statistics_.id = id;
+
+    desktop_window_proxy_ = std::make_shared<client::DesktopWindowProxy>(ui_task_runner_, this);
+    status_window_proxy_ = std::make_shared<client::StatusWindowProxy>(ui_task_runner_, this);
+}
+
+LoadTestSession::~LoadTestSession()
+{
+    stop();
+
+    desktop_window_proxy_->dettach();
+    status_window_proxy_->dettach();
+}
+
+void LoadTestSession::start(const client::Config& config,
+                            const proto::DesktopConfig& desktop_config)
+{
+    DCHECK(ui_task_runner_->belongsToCurrentThread());
+
+    if (client_proxy_)
+    {
+        LOG(LS_ERROR) << "Session " << statistics_.id << " is already started";
+        return;
+    }
+
+    std::unique_ptr<client::ClientDesktop> client =
+        std::make_unique<client::ClientDesktop>(io_task_runner_);
+
+    client->setDesktopConfig(desktop_config);
+    client->setDesktopWindow(desktop_window_proxy_);
+    client->setStatusWindow(status_window_proxy_);
+
+    start_time_ = Clock::now();
+
+    client_proxy_ =
+        std::make_unique<client::ClientProxy>(io_task_runner_, std::move(client), config);
+    client_proxy_->start();
+}
+
+void LoadTestSession::stop()
+{
+    DCHECK(ui_task_runner_->belongsToCurrentThread());
+
+    if (client_proxy_)
+    {
+        client_proxy_->stop();
+        client_proxy_.reset();
+    }
+}
+
+void LoadTestSession::showWindow(
+    std::shared_ptr<client::DesktopControlProxy> /* desktop_control_proxy */,
+    const base::Version& /* peer_version */)
+{
+    LOG(LS_INFO) << "Session " << statistics_.id << " started";
+}
+
+void LoadTestSession::configRequired()
+{
+    onError("The video encoding is not supported by the host");
+}
+
+void LoadTestSession::setCapabilities(const std::string& /* extensions */,
+                                      uint32_t /* video_encodings */)
+{
+    // Nothing
+}
+
+void LoadTestSession::setScreenList(const proto::ScreenList& /* screen_list */)
+{
+    // Nothing
+}
+
+void LoadTestSession::setSystemInfo(const proto::SystemInfo& /* system_info */)
+{
+    // Nothing
+}
+
+void LoadTestSession::setMetrics(const Metrics& /* metrics */)
+{
+    // Nothing
+}
+
+std::unique_ptr<client::FrameFactory> LoadTestSession::frameFactory()
+{
+    return std::make_unique<FrameFactorySimple>();
+}
+
+void LoadTestSession::setFrame(const base::Size& /* screen_size */,
+                               std::shared_ptr<base::Frame> frame)
+{
+    frame_ = std::move(frame);
+}
+
+void LoadTestSession::drawFrame(const base::Region& updated_region)
+{
+    if (!frame_)
+        return;
+
+    const TimePoint now = Clock::now();
+
+    if (!statistics_.frame_count)
+        statistics_.first_frame_time = now;
+
+    statistics_.last_frame_time = now;
+    ++statistics_.frame_count;
+
+    // If the area of the stamp is not updated, it still contains the time of a previous frame.
+    base::Region stamp_region(base::FrameStamp::rect());
+    stamp_region.intersectWith(updated_region);
+    if (stamp_region.isEmpty())
+        return;
+
+    std::optional<uint64_t> stamp = base::FrameStamp::read(*frame_);
+    if (stamp)
+        statistics_.latencies.emplace_back(base::FrameStamp::elapsedSince(*stamp));
+}
+
+void LoadTestSession::setMouseCursor(std::shared_ptr<base::MouseCursor> /* mouse_cursor */)
+{
+    // Nothing
+}
+
+void LoadTestSession::setMouseCursorPosition(const base::Point& /* position */)
+{
+    // Nothing
+}
+
+void LoadTestSession::onStarted(const std::u16string& /* address_or_id */)
+{
+    // Nothing
+}
+
+void LoadTestSession::onStopped()
+{
+    // Nothing
+}
+
+void LoadTestSession::onConnected()
+{
+    statistics_.connected = true;
+    statistics_.connect_time =
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start_time_);
+
+    LOG(LS_INFO) << "Session " << statistics_.id << " connected in "
+                 << statistics_.connect_time.count() << " ms";
+}
+
+void LoadTestSession::onDisconnected(base::NetworkChannel::ErrorCode error_code)
+{
+    onError("Network error: " + base::NetworkChannel::errorToString(error_code));
+}
+
+void LoadTestSession::onAccessDenied(base::ClientAuthenticator::ErrorCode error_code)
+{
+    onError(std::string("Access denied: ") + base::Authenticator::errorToString(error_code));
+}
+
+void LoadTestSession::onRouterError(const client::RouterController::Error& error)
+{
+    switch (error.type)
+    {
+        case client::RouterController::ErrorType::NETWORK:
+            onError("Router network error: " +
+                    base::NetworkChannel::errorToString(error.code.network));
+            break;
+
+        case client::RouterController::ErrorType::AUTHENTICATION:
+            onError(std::string("Router authentication error: ") +
+                    base::Authenticator::errorToString(error.code.authentication));
+            break;
+
+        case client::RouterController::ErrorType::ROUTER:
+            onError(std::string("Router error: ") + routerErrorToString(error.code.router));
+            break;
+
+        default:
+            NOTREACHED();
+            break;
+    }
+}
+
+void LoadTestSession::onError(const std::string& error)
+{
+    LOG(LS_ERROR) << "Session " << statistics_.id << ": " << error;
+
+    // The first error is the cause, the next ones are its consequences.
+    if (statistics_.error.empty())
+        statistics_.error = error;
+}
+
+} // namespace load_test
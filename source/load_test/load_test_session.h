@@ -0,0 +1,128 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef LOAD_TEST__LOAD_TEST_SESSION_H
+#define LOAD_TEST__LOAD_TEST_SESSION_H
+
+#include "base/macros_magic.h"
+#include "client/client_config.h"
+#include "client/desktop_window.h"
+#include "client/status_window.h"
+#include "proto/desktop.pb.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace base {
+class TaskRunner;
+} // namespace base
+
+namespace client {
+class ClientProxy;
+class DesktopWindowProxy;
+class StatusWindowProxy;
+} // namespace client
+
+namespace load_test {
+
+// A desktop client without a window. The video is decoded as in the real client and the frame
+// rate and the latency from the capture on the host to the display are measured. The latency can
+// be measured only if the host replays frames with the fake screen capturer, which writes the time
+// of the capture into the frames (see base::FrameStamp).
+//
+// All methods are called on the UI thread.
+class LoadTestSession
+    : public client::DesktopWindow,
+      public client::StatusWindow
+{
+public:
+    LoadTestSession(int id,
+                    std::shared_ptr<base::TaskRunner> ui_task_runner,
+                    std::shared_ptr<base::TaskRunner> io_task_runner);
+    ~LoadTestSession() override;
+
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    struct Statistics
+    {
+        int id = 0;
+        bool connected = false;
+        std::string error;
+
+        // Time from the start of the session to the established connection.
+        std::chrono::milliseconds connect_time = std::chrono::milliseconds::zero();
+
+        int64_t frame_count = 0;
+        TimePoint first_frame_time;
+        TimePoint last_frame_time;
+
+        // Latency of every displayed frame which has a time stamp.
+        std::vector<std::chrono::microseconds> latencies;
+    };
+
+    void start(const client::Config& config, const proto::DesktopConfig& desktop_config);
+    void stop();
+
+    const Statistics& statistics() const { return statistics_; }
+
+protected:
+    // client::DesktopWindow implementation.
+    void showWindow(std::shared_ptr<client::DesktopControlProxy> desktop_control_proxy,
+                    const base::Version& peer_version) override;
+    void configRequired() override;
+    void setCapabilities(const std::string& extensions, uint32_t video_encodings) override;
+    void setScreenList(const proto::ScreenList& screen_list) override;
+    void setSystemInfo(const proto::SystemInfo& system_info) override;
+    void setMetrics(const Metrics& metrics) override;
+    std::unique_ptr<client::FrameFactory> frameFactory() override;
+    void setFrame(const base::Size& screen_size, std::shared_ptr<base::Frame> frame) override;
+    void drawFrame(const base::Region& updated_region) override;
+    void setMouseCursor(std::shared_ptr<base::MouseCursor> mouse_cursor) override;
+    void setMouseCursorPosition(const base::Point& position) override;
+
+    // client::StatusWindow implementation.
+    void onStarted(const std::u16string& address_or_id) override;
+    void onStopped() override;
+    void onConnected() override;
+    void onDisconnected(base::NetworkChannel::ErrorCode error_code) override;
+    void onAccessDenied(base::ClientAuthenticator::ErrorCode error_code) override;
+    void onRouterError(const client::RouterController::Error& error) override;
+
+private:
+    void onError(const std::string& error);
+
+    std::shared_ptr<base::TaskRunner> ui_task_runner_;
+    std::shared_ptr<base::TaskRunner> io_task_runner_;
+
+    std::shared_ptr<client::DesktopWindowProxy> desktop_window_proxy_;
+    std::shared_ptr<client::StatusWindowProxy> status_window_proxy_;
+    std::unique_ptr<client::ClientProxy> client_proxy_;
+
+    std::shared_ptr<base::Frame> frame_;
+
+    TimePoint start_time_;
+    Statistics statistics_;
+
+    DISALLOW_COPY_AND_ASSIGN(LoadTestSession);
+};
+
+} // namespace load_test
+
+#endif // LOAD_TEST__LOAD_TEST_SESSION_H
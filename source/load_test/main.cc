@@ -0,0 +1,318 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "base/crypto/scoped_crypto_initializer.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/unicode.h"
+#include "base/threading/thread.h"
+#include "build/build_config.h"
+#include "client/config_factory.h"
+#include "load_test/load_test_session.h"
+#include "load_test/report.h"
+
+#include <iostream>
+
+namespace {
+
+const int kDefaultSessionCount = 1;
+const int kDefaultDuration = 60; // Seconds.
+const int kDefaultStartInterval = 100; // Milliseconds.
+
+struct Options
+{
+    client::Config config;
+    proto::DesktopConfig desktop_config;
+    int session_count = kDefaultSessionCount;
+    std::chrono::seconds duration = std::chrono::seconds(kDefaultDuration);
+    std::chrono::milliseconds start_interval = std::chrono::milliseconds(kDefaultStartInterval);
+    std::filesystem::path json_file;
+};
+
+void showHelp()
+{
+    std::cout << "aspia_load_test --address=<address or ID> [switches]" << std::endl
+        << "Available switches:" << std::endl
+        << '\t' << "--address" << '\t' << "Address of the host or its ID for router" << std::endl
+        << '\t' << "--port" << '\t' << "Port of the host (" << DEFAULT_HOST_TCP_PORT << ")"
+        << std::endl
+        << '\t' << "--username" << '\t' << "User name" << std::endl
+        << '\t' << "--password" << '\t' << "Password" << std::endl
+        << '\t' << "--router-address" << '\t' << "Connect through the router" << std::endl
+        << '\t' << "--router-port" << '\t' << "Port of the router (" << DEFAULT_ROUTER_TCP_PORT
+        << ")" << std::endl
+        << '\t' << "--router-username" << '\t' << "User name for the router" << std::endl
+        << '\t' << "--router-password" << '\t' << "Password for the router" << std::endl
+        << '\t' << "--sessions" << '\t' << "Number of concurrent sessions ("
+        << kDefaultSessionCount << ")" << std::endl
+        << '\t' << "--duration" << '\t' << "Duration of the test in seconds ("
+        << kDefaultDuration << ")" << std::endl
+        << '\t' << "--start-interval" << '\t' << "Interval between session starts in ms ("
+        << kDefaultStartInterval << ")" << std::endl
+        << '\t' << "--encoding" << '\t' << "Video encoding: vp8 or vp9 (vp8)" << std::endl
+        << '\t' << "--json" << '\t' << "Write the results to a JSON file" << std::endl
+        << '\t' << "--help" << '\t' << "Show help" << std::endl;
+}
+
+bool readPort(const base::CommandLine& command_line, std::u16string_view name, uint16_t* port)
+{
+    if (!command_line.hasSwitch(name))
+        return true;
+
+    unsigned short value;
+    if (!base::stringToUShort(command_line.switchValue(name), &value) || !value)
+    {
+        std::cout << "Invalid port: " << base::utf8FromUtf16(command_line.switchValue(name))
+                  << std::endl;
+        return false;
+    }
+
+    *port = value;
+    return true;
+}
+
+bool readPositive(const base::CommandLine& command_line, std::u16string_view name, int* output)
+{
+    if (!command_line.hasSwitch(name))
+        return true;
+
+    int value;
+    if (!base::stringToInt(command_line.switchValue(name), &value) || value <= 0)
+    {
+        std::cout << "Invalid value of " << base::utf8FromUtf16(name) << ": "
+                  << base::utf8FromUtf16(command_line.switchValue(name)) << std::endl;
+        return false;
+    }
+
+    *output = value;
+    return true;
+}
+
+bool parseOptions(const base::CommandLine& command_line, Options* options)
+{
+    client::Config& config = options->config;
+
+    config.address_or_id = command_line.switchValue(u"address");
+    if (config.address_or_id.empty())
+    {
+        std::cout << "The address of the host is not specified" << std::endl;
+        return false;
+    }
+
+    config.port = DEFAULT_HOST_TCP_PORT;
+    config.username = command_line.switchValue(u"username");
+    config.password = command_line.switchValue(u"password");
+
+    // The host is not controlled, so the view session is enough.
+    config.session_type = proto::SESSION_TYPE_DESKTOP_VIEW;
+
+    if (!readPort(command_line, u"port", &config.port))
+        return false;
+
+    if (command_line.hasSwitch(u"router-address"))
+    {
+        client::RouterConfig router_config;
+
+        router_config.address = command_line.switchValue(u"router-address");
+        router_config.port = DEFAULT_ROUTER_TCP_PORT;
+        router_config.username = command_line.switchValue(u"router-username");
+        router_config.password = command_line.switchValue(u"router-password");
+
+        if (!readPort(command_line, u"router-port", &router_config.port))
+            return false;
+
+        if (!router_config.isValid())
+        {
+            std::cout << "Invalid router configuration" << std::endl;
+            return false;
+        }
+
+        // When connecting with a one-time password, the username must be in the following
+        // format: #host_id.
+        if (config.username.empty())
+            config.username = u"#" + config.address_or_id;
+
+        config.router_config = std::move(router_config);
+    }
+
+    proto::DesktopConfig& desktop_config = options->desktop_config;
+
+    // The cursor, the clipboard and the audio are not needed: only the video is measured.
+    client::ConfigFactory::setDefaultDesktopViewConfig(&desktop_config);
+    desktop_config.set_flags(proto::DISABLE_DESKTOP_EFFECTS | proto::DISABLE_DESKTOP_WALLPAPER);
+    desktop_config.set_audio_encoding(proto::AUDIO_ENCODING_UNKNOWN);
+
+    if (command_line.hasSwitch(u"encoding"))
+    {
+        const std::u16string& encoding = command_line.switchValue(u"encoding");
+
+        if (encoding == u"vp8")
+        {
+            desktop_config.set_video_encoding(proto::VIDEO_ENCODING_VP8);
+        }
+        else if (encoding == u"vp9")
+        {
+            desktop_config.set_video_encoding(proto::VIDEO_ENCODING_VP9);
+        }
+        else
+        {
+            std::cout << "Unknown video encoding: " << base::utf8FromUtf16(encoding) << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        desktop_config.set_video_encoding(proto::VIDEO_ENCODING_VP8);
+    }
+
+    int duration = kDefaultDuration;
+    int start_interval = kDefaultStartInterval;
+
+    if (!readPositive(command_line, u"sessions", &options->session_count) ||
+        !readPositive(command_line, u"duration", &duration) ||
+        !readPositive(command_line, u"start-interval", &start_interval))
+    {
+        return false;
+    }
+
+    options->duration = std::chrono::seconds(duration);
+    options->start_interval = std::chrono::milliseconds(start_interval);
+    options->json_file = command_line.switchValuePath(u"json");
+    return true;
+}
+
+int runLoadTest(const Options& options)
+{
+    std::unique_ptr<base::MessageLoop> message_loop = std::make_unique<base::MessageLoop>();
+    std::shared_ptr<base::TaskRunner> ui_task_runner = message_loop->taskRunner();
+
+    base::Thread io_thread;
+    io_thread.start(base::MessageLoop::Type::ASIO);
+    std::shared_ptr<base::TaskRunner> io_task_runner = io_thread.taskRunner();
+
+    std::vector<std::unique_ptr<load_test::LoadTestSession>> sessions;
+
+    for (int i = 0; i < options.session_count; ++i)
+    {
+        sessions.emplace_back(
+            std::make_unique<load_test::LoadTestSession>(i + 1, ui_task_runner, io_task_runner));
+
+        // The sessions are started one by one, so that the authentication of all sessions at the
+        // same time does not distort the results.
+        load_test::LoadTestSession* session = sessions.back().get();
+        ui_task_runner->postDelayedTask([session, &options]()
+        {
+            session->start(options.config, options.desktop_config);
+        }, options.start_interval * i);
+    }
+
+    load_test::Report report(options.duration);
+
+    // The test lasts for |duration| after the start of the last session.
+    ui_task_runner->postDelayedTask([&]()
+    {
+        for (const auto& session : sessions)
+        {
+            report.addSession(session->statistics());
+            session->stop();
+        }
+
+        // The clients are stopped on the I/O thread. The loop quits after they are stopped.
+        io_task_runner->postTask([ui_task_runner]()
+        {
+            ui_task_runner->postQuit();
+        });
+    }, options.start_interval * (options.session_count - 1) + options.duration);
+
+    std::cout << "Starting " << options.session_count << " session(s) for "
+              << options.duration.count() << " s..." << std::endl;
+
+    message_loop->run();
+
+    sessions.clear();
+    io_thread.stop();
+    message_loop.reset();
+
+    report.print(std::cout);
+
+    if (!options.json_file.empty() && !report.writeJson(options.json_file))
+    {
+        std::cout << "Unable to write the results to " << options.json_file << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int loadTestMain(const base::CommandLine& command_line)
+{
+    if (command_line.hasSwitch(u"help"))
+    {
+        showHelp();
+        return 0;
+    }
+
+    Options options;
+    if (!parseOptions(command_line, &options))
+    {
+        showHelp();
+        return 1;
+    }
+
+    base::ScopedCryptoInitializer crypto_initializer;
+    if (!crypto_initializer.isSucceeded())
+    {
+        std::cout << "Unable to initialize the crypto library" << std::endl;
+        return 1;
+    }
+
+    return runLoadTest(options);
+}
+
+} // namespace
+
+#if defined(OS_WIN)
+int wmain()
+{
+    base::LoggingSettings logging_settings;
+    logging_settings.min_log_level = base::LOG_LS_WARNING;
+    base::initLogging(logging_settings);
+
+    base::CommandLine::init(0, nullptr); // On Windows ignores arguments.
+    int result = loadTestMain(*base::CommandLine::forCurrentProcess());
+
+    base::shutdownLogging();
+    return result;
+}
+#else
+int main(int argc, const char* const* argv)
+{
+    base::LoggingSettings logging_settings;
+    logging_settings.min_log_level = base::LOG_LS_WARNING;
+    base::initLogging(logging_settings);
+
+    base::CommandLine::init(argc, argv);
+    int result = loadTestMain(*base::CommandLine::forCurrentProcess());
+
+    base::shutdownLogging();
+    return result;
+}
+#endif
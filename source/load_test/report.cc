@@ -0,0 +1,218 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "load_test/report.h"
+
+#include "base/logging.h"
+
+#include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/writer.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+
+namespace load_test {
+
+namespace {
+
+double toMilliseconds(int64_t microseconds)
+{
+    return static_cast<double>(microseconds) / 1000.0;
+}
+
+} // namespace
+
+Report::Report(std::chrono::seconds duration)
+    : duration_(duration)
+{
+    // Nothing
+}
+
+Report::~Report() = default;
+
+void Report::addSession(const LoadTestSession::Statistics& statistics)
+{
+    Session session;
+
+    session.id = statistics.id;
+    session.connected = statistics.connected;
+    session.error = statistics.error;
+    session.connect_time = statistics.connect_time;
+    session.frame_count = statistics.frame_count;
+
+    // The frame rate is measured from the first frame, so that the time of the connection is not
+    // taken into account.
+    if (statistics.frame_count > 1)
+    {
+        const std::chrono::duration<double> time =
+            statistics.last_frame_time - statistics.first_frame_time;
+        if (time.count() > 0)
+            session.fps = static_cast<double>(statistics.frame_count - 1) / time.count();
+    }
+
+    session.latency = calcLatency(statistics.latencies);
+
+    latencies_.insert(latencies_.end(), statistics.latencies.begin(), statistics.latencies.end());
+    sessions_.emplace_back(std::move(session));
+}
+
+void Report::print(std::ostream& stream) const
+{
+    stream << std::fixed << std::setprecision(1)
+           << std::setw(8) << "Session" << std::setw(12) << "Connect,ms" << std::setw(10)
+           << "Frames" << std::setw(8) << "FPS" << std::setw(11) << "Lat.avg,ms" << std::setw(11)
+           << "Lat.p50,ms" << std::setw(11) << "Lat.p95,ms" << std::setw(11) << "Lat.max,ms"
+           << "  Error" << std::endl;
+
+    int connected_count = 0;
+    int64_t frame_count = 0;
+    double fps = 0;
+
+    for (const auto& session : sessions_)
+    {
+        stream << std::setw(8) << session.id;
+
+        if (session.connected)
+            stream << std::setw(12) << session.connect_time.count();
+        else
+            stream << std::setw(12) << "-";
+
+        stream << std::setw(10) << session.frame_count << std::setw(8) << session.fps
+               << std::setw(11) << toMilliseconds(session.latency.average)
+               << std::setw(11) << toMilliseconds(session.latency.p50)
+               << std::setw(11) << toMilliseconds(session.latency.p95)
+               << std::setw(11) << toMilliseconds(session.latency.max)
+               << "  " << session.error << std::endl;
+
+        if (session.connected)
+            ++connected_count;
+
+        frame_count += session.frame_count;
+        fps += session.fps;
+    }
+
+    const Latency latency = calcLatency(latencies_);
+
+    stream << std::endl
+           << "Duration:          " << duration_.count() << " s" << std::endl
+           << "Sessions:          " << connected_count << " of " << sessions_.size()
+           << " connected" << std::endl
+           << "Frames:            " << frame_count << std::endl
+           << "FPS per session:   "
+           << (sessions_.empty() ? 0.0 : fps / static_cast<double>(sessions_.size())) << std::endl
+           << "Latency (ms):      min " << toMilliseconds(latency.min)
+           << ", avg " << toMilliseconds(latency.average)
+           << ", p50 " << toMilliseconds(latency.p50)
+           << ", p95 " << toMilliseconds(latency.p95)
+           << ", max " << toMilliseconds(latency.max)
+           << " (" << latency.count << " stamped frames)" << std::endl;
+}
+
+bool Report::writeJson(const std::filesystem::path& file_path) const
+{
+    std::ofstream stream(file_path, std::ofstream::out | std::ofstream::trunc);
+    if (!stream.is_open())
+    {
+        LOG(LS_ERROR) << "Unable to open file: " << file_path;
+        return false;
+    }
+
+    rapidjson::OStreamWrapper stream_wrapper(stream);
+    rapidjson::Writer<rapidjson::OStreamWrapper> writer(stream_wrapper);
+
+    auto write_latency = [&writer](const Latency& latency)
+    {
+        writer.StartObject();
+        writer.Key("count");
+        writer.Uint64(latency.count);
+        writer.Key("min_us");
+        writer.Int64(latency.min);
+        writer.Key("avg_us");
+        writer.Int64(latency.average);
+        writer.Key("p50_us");
+        writer.Int64(latency.p50);
+        writer.Key("p95_us");
+        writer.Int64(latency.p95);
+        writer.Key("max_us");
+        writer.Int64(latency.max);
+        writer.EndObject();
+    };
+
+    writer.StartObject();
+    writer.Key("duration_s");
+    writer.Int64(duration_.count());
+
+    writer.Key("sessions");
+    writer.StartArray();
+
+    for (const auto& session : sessions_)
+    {
+        writer.StartObject();
+        writer.Key("id");
+        writer.Int(session.id);
+        writer.Key("connected");
+        writer.Bool(session.connected);
+        writer.Key("connect_time_ms");
+        writer.Int64(session.connect_time.count());
+        writer.Key("frames");
+        writer.Int64(session.frame_count);
+        writer.Key("fps");
+        writer.Double(session.fps);
+        writer.Key("latency");
+        write_latency(session.latency);
+        writer.Key("error");
+        writer.String(session.error.c_str());
+        writer.EndObject();
+    }
+
+    writer.EndArray();
+
+    writer.Key("latency");
+    write_latency(calcLatency(latencies_));
+    writer.EndObject();
+
+    stream << std::endl;
+    return !stream.fail();
+}
+
+// static
+Report::Latency Report::calcLatency(std::vector<std::chrono::microseconds> latencies)
+{
+    Latency latency;
+
+    if (latencies.empty())
+        return latency;
+
+    std::sort(latencies.begin(), latencies.end());
+
+    const std::chrono::microseconds sum =
+        std::accumulate(latencies.begin(), latencies.end(), std::chrono::microseconds::zero());
+
+    latency.count = latencies.size();
+    latency.min = latencies.front().count();
+    latency.max = latencies.back().count();
+    latency.average = sum.count() / static_cast<int64_t>(latencies.size());
+    latency.p50 = latencies[(latencies.size() - 1) / 2].count();
+    latency.p95 = latencies[(latencies.size() - 1) * 95 / 100].count();
+
+    return latency;
+}
+
+} // namespace load_test
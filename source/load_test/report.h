@@ -0,0 +1,77 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef LOAD_TEST__REPORT_H
+#define LOAD_TEST__REPORT_H
+
+#include "base/macros_magic.h"
+#include "load_test/load_test_session.h"
+
+#include <filesystem>
+#include <ostream>
+
+namespace load_test {
+
+// Results of the load test: the frame rate and the latency of every session and of all sessions
+// together.
+class Report
+{
+public:
+    explicit Report(std::chrono::seconds duration);
+    ~Report();
+
+    void addSession(const LoadTestSession::Statistics& statistics);
+
+    void print(std::ostream& stream) const;
+    bool writeJson(const std::filesystem::path& file_path) const;
+
+private:
+    // Latency in microseconds.
+    struct Latency
+    {
+        size_t count = 0;
+        int64_t min = 0;
+        int64_t average = 0;
+        int64_t p50 = 0;
+        int64_t p95 = 0;
+        int64_t max = 0;
+    };
+
+    struct Session
+    {
+        int id = 0;
+        bool connected = false;
+        std::string error;
+        std::chrono::milliseconds connect_time = std::chrono::milliseconds::zero();
+        int64_t frame_count = 0;
+        double fps = 0;
+        Latency latency;
+    };
+
+    static Latency calcLatency(std::vector<std::chrono::microseconds> latencies);
+
+    const std::chrono::seconds duration_;
+    std::vector<Session> sessions_;
+    std::vector<std::chrono::microseconds> latencies_;
+
+    DISALLOW_COPY_AND_ASSIGN(Report);
+};
+
+} // namespace load_test
+
+#endif // LOAD_TEST__REPORT_H
@@ -0,0 +1,165 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "relay/cascade_connector.h"
+
+#include "base/endian_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/peer/relay_peer.h"
+#include "base/strings/unicode.h"
+#include "relay/pending_session.h"
+
+#include <asio/connect.hpp>
+#include <asio/write.hpp>
+
+#include <array>
+
+namespace relay {
+
+CascadeConnector::CascadeConnector(asio::io_context& io_context,
+                                   PendingSession* pending_session,
+                                   Delegate* delegate)
+    : pending_session_(pending_session),
+      delegate_(delegate),
+      socket_(io_context),
+      resolver_(io_context)
+{
+    DCHECK(pending_session_ && delegate_);
+}
+
+CascadeConnector::~CascadeConnector()
+{
+    stop();
+}
+
+void CascadeConnector::start(const proto::RelayCredentials& next)
+{
+    message_ = base::RelayPeer::authenticationMessage(
+        next.key(), next.secret(), pending_session_->trace().id());
+    if (message_.empty())
+    {
+        onErrorOccurred(FROM_HERE, std::error_code());
+        return;
+    }
+
+    LOG(LS_INFO) << "Connecting to next relay " << next.host() << ":" << next.port();
+
+    resolver_.async_resolve(base::local8BitFromUtf16(base::utf16FromUtf8(next.host())),
+                            std::to_string(next.port()),
+        [this](const std::error_code& error_code,
+               const asio::ip::tcp::resolver::results_type& endpoints)
+    {
+        if (error_code)
+        {
+            if (error_code != asio::error::operation_aborted)
+                onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        asio::async_connect(socket_, endpoints,
+                            [this](const std::error_code& error_code,
+                                   const asio::ip::tcp::endpoint& /* endpoint */)
+        {
+            if (error_code)
+            {
+                if (error_code != asio::error::operation_aborted)
+                    onErrorOccurred(FROM_HERE, error_code);
+                return;
+            }
+
+            onConnected();
+        });
+    });
+}
+
+void CascadeConnector::stop()
+{
+    delegate_ = nullptr;
+
+    std::error_code ignored_code;
+    resolver_.cancel();
+    socket_.cancel(ignored_code);
+    socket_.close(ignored_code);
+}
+
+asio::ip::tcp::socket CascadeConnector::takeSocket()
+{
+    return std::move(socket_);
+}
+
+void CascadeConnector::onConnected()
+{
+    std::error_code error_code;
+
+    // The connection between relays lives as long as the session. Keep-alive detects a broken
+    // long-distance path when the peers are silent.
+    socket_.set_option(asio::ip::tcp::no_delay(true), error_code);
+    if (error_code)
+    {
+        LOG(LS_WARNING) << "Failed to disable Nagle's algorithm: "
+                        << base::utf16FromLocal8Bit(error_code.message());
+    }
+
+    socket_.set_option(asio::socket_base::keep_alive(true), error_code);
+    if (error_code)
+    {
+        LOG(LS_WARNING) << "Failed to enable keep alive: "
+                        << base::utf16FromLocal8Bit(error_code.message());
+    }
+
+    message_size_ = base::EndianUtil::toBig(static_cast<uint32_t>(message_.size()));
+
+    std::array<asio::const_buffer, 2> buffers =
+    {
+        asio::const_buffer(&message_size_, sizeof(message_size_)),
+        asio::const_buffer(message_.data(), message_.size())
+    };
+
+    asio::async_write(socket_, buffers,
+                      [this](const std::error_code& error_code, size_t /* bytes_transferred */)
+    {
+        if (error_code)
+        {
+            if (error_code != asio::error::operation_aborted)
+                onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        LOG(LS_INFO) << "Connected to next relay";
+
+        if (delegate_)
+            delegate_->onCascadeConnected(this);
+    });
+}
+
+void CascadeConnector::onErrorOccurred(
+    const base::Location& location, const std::error_code& error_code)
+{
+    LOG(LS_ERROR) << "Failed to connect to next relay: "
+                  << base::utf16FromLocal8Bit(error_code.message())
+                  << " (" << location.toString() << ")";
+
+    Delegate* delegate = delegate_;
+    stop();
+
+    if (delegate)
+        delegate->onCascadeFailed(this);
+}
+
+} // namespace relay
@@ -0,0 +1,81 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef RELAY__CASCADE_CONNECTOR_H
+#define RELAY__CASCADE_CONNECTOR_H
+
+#include "base/macros_magic.h"
+#include "base/memory/byte_array.h"
+#include "proto/router_common.pb.h"
+
+#include <asio/ip/tcp.hpp>
+
+namespace base {
+class Location;
+} // namespace base
+
+namespace relay {
+
+class PendingSession;
+
+// Connects to the next relay of a cascade as a peer (see proto::RelayCascade). When the connection
+// is authenticated, the socket is ready for the data of |pending_session|.
+class CascadeConnector
+{
+public:
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        virtual void onCascadeConnected(CascadeConnector* connector) = 0;
+        virtual void onCascadeFailed(CascadeConnector* connector) = 0;
+    };
+
+    CascadeConnector(asio::io_context& io_context,
+                     PendingSession* pending_session,
+                     Delegate* delegate);
+    ~CascadeConnector();
+
+    void start(const proto::RelayCredentials& next);
+    void stop();
+
+    PendingSession* pendingSession() const { return pending_session_; }
+
+    // Releases the connected socket.
+    asio::ip::tcp::socket takeSocket();
+
+private:
+    void onConnected();
+    void onErrorOccurred(const base::Location& location, const std::error_code& error_code);
+
+    PendingSession* pending_session_;
+    Delegate* delegate_;
+
+    asio::ip::tcp::socket socket_;
+    asio::ip::tcp::resolver resolver_;
+
+    uint32_t message_size_ = 0;
+    base::ByteArray message_;
+
+    DISALLOW_COPY_AND_ASSIGN(CascadeConnector);
+};
+
+} // namespace relay
+
+#endif // RELAY__CASCADE_CONNECTOR_H
@@ -19,16 +19,31 @@
 #include "relay/controller.h"
 
 #include "base/logging.h"
+#include "base/prometheus_writer.h"
 #include "base/task_runner.h"
+#include "base/message_loop/message_loop_lag_probe.h"
 #include "base/peer/client_authenticator.h"
+#include "base/strings/unicode.h"
 #include "proto/router_common.pb.h"
 #include "relay/settings.h"
 
+#include <algorithm>
+#include <thread>
+
 namespace relay {
 
 namespace {
 
 const std::chrono::seconds kReconnectTimeout{ 15 };
+const std::chrono::seconds kStatisticsInterval{ 60 };
+
+#if defined(OS_POSIX)
+const std::chrono::seconds kDrainCheckInterval{ 5 };
+#endif // defined(OS_POSIX)
+
+// The maximum number of extra keys as a percentage of the maximum number of peers. Extra keys
+// replace keys which have been given to peers that have not yet connected.
+const uint32_t kMaxExtraKeysPercent = 25;
 
 #if defined(OS_WIN)
 const wchar_t kFirewallRuleName[] = L"Aspia Relay Service";
@@ -63,8 +78,12 @@ private:
 
 Controller::Controller(std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(task_runner),
-      reconnect_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner),
-      shared_pool_(std::make_unique<SharedPool>(this))
+      reconnect_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner,
+                       base::WaitableTimer::Precision::COARSE),
+      statistics_timer_(base::WaitableTimer::Type::REPEATED, task_runner,
+                        base::WaitableTimer::Precision::COARSE),
+      shared_pool_(std::make_unique<SharedPool>(this)),
+      statistics_(std::make_shared<Statistics>())
 {
     Settings settings;
 
@@ -82,14 +101,46 @@ Controller::Controller(std::shared_ptr<base::TaskRunner> task_runner)
     peer_port_ = settings.peerPort();
     peer_idle_timeout_ = settings.peerIdleTimeout();
     max_peer_count_ = settings.maxPeerCount();
+    region_ = settings.region();
+
+    session_bandwidth_limit_ = settings.sessionBandwidthLimit();
+    total_bandwidth_limit_ = settings.totalBandwidthLimit();
+    congestion_control_ = settings.congestionControl();
+
+    thread_count_ = settings.threadCount();
+    if (!thread_count_)
+        thread_count_ = std::max(std::thread::hardware_concurrency(), 1U);
+
+    metrics_address_ = settings.metricsAddress();
+    metrics_port_ = settings.metricsPort();
 
     LOG(LS_INFO) << "Peer address: " << peer_address_;
     LOG(LS_INFO) << "Peer port: " << peer_port_;
     LOG(LS_INFO) << "Peer idle timeout: " << peer_idle_timeout_.count();
     LOG(LS_INFO) << "Max peer count: " << max_peer_count_;
+    LOG(LS_INFO) << "Region: " << region_;
+    LOG(LS_INFO) << "Session bandwidth limit: " << session_bandwidth_limit_;
+    LOG(LS_INFO) << "Total bandwidth limit: " << total_bandwidth_limit_;
+    LOG(LS_INFO) << "Congestion control: " << congestion_control_;
+    LOG(LS_INFO) << "Thread count: " << thread_count_;
+    LOG(LS_INFO) << "Metrics address: " << metrics_address_;
+    LOG(LS_INFO) << "Metrics port: " << metrics_port_;
 }
 
-Controller::~Controller() = default;
+Controller::~Controller()
+{
+    metrics_server_.reset();
+    key_generator_.reset();
+
+    // Workers pass connections to each other, so all of them are stopped before destruction.
+    for (auto& worker : sessions_workers_)
+        worker->stop();
+}
+
+void Controller::setInheritedState(HotRestartState&& state)
+{
+    inherited_state_ = std::move(state);
+}
 
 bool Controller::start()
 {
@@ -131,14 +182,176 @@ bool Controller::start()
         return false;
     }
 
-    sessions_worker_ = std::make_unique<SessionsWorker>(
-        peer_port_, peer_idle_timeout_, shared_pool_->share());
-    sessions_worker_->start(task_runner_, this);
+    // Keys are generated in advance for the whole pool including the extra keys.
+    key_generator_ = std::make_unique<KeyGenerator>(
+        max_peer_count_ + max_peer_count_ * kMaxExtraKeysPercent / 100, task_runner_, this);
+
+    // The total limit is shared by the sessions of all workers.
+    std::shared_ptr<base::TokenBucket> total_bandwidth_limit;
+    if (total_bandwidth_limit_)
+        total_bandwidth_limit = Session::createBandwidthLimit(total_bandwidth_limit_);
+
+    std::vector<SessionsWorker*> workers;
+
+    for (uint32_t i = 0; i < thread_count_; ++i)
+    {
+        sessions_workers_.emplace_back(std::make_unique<SessionsWorker>(
+            peer_port_, peer_idle_timeout_, shared_pool_->share(), i, thread_count_));
+        sessions_workers_.back()->setBandwidthLimit(
+            session_bandwidth_limit_, total_bandwidth_limit);
+        sessions_workers_.back()->setCongestionControl(congestion_control_);
+        sessions_workers_.back()->setStatistics(statistics_);
+        sessions_workers_.back()->start(task_runner_, this);
+
+        workers.emplace_back(sessions_workers_.back().get());
+    }
+
+#if defined(OS_POSIX)
+    if (!inherited_state_.listeners.empty() || !inherited_state_.sessions.empty())
+    {
+        // Each worker gets one listener. The workers without a listener create their own ones
+        // (see SessionManager::listen), and the listeners left are closed.
+        std::vector<HotRestartState> states(sessions_workers_.size());
+        HotRestartState unused;
+
+        for (size_t i = 0; i < inherited_state_.listeners.size(); ++i)
+        {
+            if (i < states.size())
+                states[i].listeners.emplace_back(inherited_state_.listeners[i]);
+            else
+                unused.listeners.emplace_back(inherited_state_.listeners[i]);
+        }
+
+        for (size_t i = 0; i < inherited_state_.sessions.size(); ++i)
+            states[i % states.size()].sessions.emplace_back(inherited_state_.sessions[i]);
+
+        HotRestart::close(&unused);
+        inherited_state_ = HotRestartState();
+
+        for (size_t i = 0; i < states.size(); ++i)
+            sessions_workers_[i]->adoptState(std::move(states[i]));
+    }
+#endif // defined(OS_POSIX)
 
+    // Connections are accepted only when all workers are running.
+    for (auto& worker : sessions_workers_)
+        worker->startAccepting(workers);
+
+    lag_probe_ = std::make_unique<base::MessageLoopLagProbe>(task_runner_);
+
+    startMetricsServer();
     connectToRouter();
+
+#if defined(OS_POSIX)
+    // The relay works without hot restarts if the local socket cannot be created.
+    hot_restart_ = std::make_unique<HotRestart>();
+    if (!hot_restart_->start(this))
+        hot_restart_.reset();
+#endif // defined(OS_POSIX)
+
     return true;
 }
 
+#if defined(OS_POSIX)
+
+void Controller::onHotRestartRequested()
+{
+    DCHECK(hand_off_states_.empty());
+
+    hand_off_states_.resize(sessions_workers_.size());
+    pending_hand_offs_ = sessions_workers_.size();
+    remaining_sessions_ = 0;
+
+    for (size_t i = 0; i < sessions_workers_.size(); ++i)
+    {
+        sessions_workers_[i]->handOff([this, i](HotRestartState&& state, size_t remaining)
+        {
+            onHandOffFinished(i, std::move(state), remaining);
+        });
+    }
+}
+
+void Controller::onHandOffFinished(size_t index, HotRestartState&& state, size_t remaining)
+{
+    DCHECK_LT(index, hand_off_states_.size());
+
+    hand_off_states_[index] = std::move(state);
+    remaining_sessions_ += remaining;
+
+    if (--pending_hand_offs_)
+        return;
+
+    HotRestartState all_states;
+    for (const HotRestartState& worker_state : hand_off_states_)
+    {
+        all_states.listeners.insert(all_states.listeners.end(),
+                                    worker_state.listeners.begin(), worker_state.listeners.end());
+        all_states.sessions.insert(all_states.sessions.end(),
+                                   worker_state.sessions.begin(), worker_state.sessions.end());
+    }
+
+    // The new process starts its own metrics listener on the same port.
+    metrics_server_.reset();
+
+    if (!hot_restart_->send(all_states))
+    {
+        LOG(LS_ERROR) << "Hot restart failed. The sessions are continued by this process";
+
+        // The sessions keep their inherited flags, so a session inherited from the previous
+        // process still does not return its key to the pool of this one.
+        for (size_t i = 0; i < sessions_workers_.size(); ++i)
+            sessions_workers_[i]->adoptState(std::move(hand_off_states_[i]));
+        hand_off_states_.clear();
+
+        startMetricsServer();
+
+        // Waiting for the next attempt.
+        hot_restart_ = std::make_unique<HotRestart>();
+        if (!hot_restart_->start(this))
+            hot_restart_.reset();
+        return;
+    }
+
+    // The new process has its own copies of the sockets.
+    HotRestart::close(&all_states);
+    hand_off_states_.clear();
+    hot_restart_.reset();
+
+    startDraining();
+}
+
+void Controller::startDraining()
+{
+    LOG(LS_INFO) << "Sessions are passed to the new process (remaining sessions: "
+                 << remaining_sessions_ << ")";
+
+    // The new process connects to the router with its own key pool.
+    reconnect_timer_.stop();
+    statistics_timer_.stop();
+    authenticated_ = false;
+    authenticator_.reset();
+    channel_.reset();
+
+    if (!remaining_sessions_)
+    {
+        task_runner_->postQuit();
+        return;
+    }
+
+    drain_timer_ = std::make_unique<base::WaitableTimer>(
+        base::WaitableTimer::Type::REPEATED, task_runner_, base::WaitableTimer::Precision::COARSE);
+    drain_timer_->start(kDrainCheckInterval, [this]()
+    {
+        if (statistics_->activeSessions() > 0)
+            return;
+
+        LOG(LS_INFO) << "All remaining sessions are finished";
+        task_runner_->postQuit();
+    });
+}
+
+#endif // defined(OS_POSIX)
+
 void Controller::onConnected()
 {
     LOG(LS_INFO) << "Connection to the router is established";
@@ -167,7 +380,11 @@ void Controller::onConnected()
             // Now the session will receive incoming messages.
             channel_->resume();
 
+            authenticated_ = true;
             sendKeyPool(max_peer_count_);
+
+            statistics_timer_.start(kStatisticsInterval,
+                                    std::bind(&Controller::sendStatistics, this));
         }
         else
         {
@@ -186,8 +403,13 @@ void Controller::onDisconnected(base::NetworkChannel::ErrorCode error_code)
     LOG(LS_INFO) << "The connection to the router has been lost: "
                  << base::NetworkChannel::errorToString(error_code);
 
+    statistics_timer_.stop();
+    authenticated_ = false;
+
     // Clearing the key pool.
     shared_pool_->clear();
+    extra_keys_ = 0;
+    owed_keys_ = 0;
 
     // Retrying a connection at a time interval.
     delayedConnectToRouter();
@@ -212,6 +434,31 @@ void Controller::onMessageReceived(const base::ByteArray& buffer)
         task_runner_->postDelayedTask(
             std::bind(&KeyDeleter::deleteKey, key_deleter), std::chrono::seconds(30));
     }
+    else if (message->has_key_request())
+    {
+        const uint32_t max_extra_keys = max_peer_count_ * kMaxExtraKeysPercent / 100;
+        const uint32_t key_count = std::min(message->key_request().key_count(),
+                                            max_extra_keys - std::min(extra_keys_, max_extra_keys));
+
+        LOG(LS_INFO) << "Refill requested: " << message->key_request().key_count()
+                     << " keys (sending: " << key_count << ", extra keys: " << extra_keys_ << ")";
+
+        // The reply is sent even without keys, so that the router can make the next request.
+        extra_keys_ += key_count;
+        sendKeyPool(key_count, true);
+    }
+    else if (message->has_cascade())
+    {
+        if (sessions_workers_.empty())
+        {
+            LOG(LS_WARNING) << "Cascade received before the start of workers";
+            return;
+        }
+
+        // The cascade is handled by the worker which serves the sessions of the key.
+        const uint32_t key_id = message->cascade().key_id();
+        sessions_workers_[key_id % sessions_workers_.size()]->addCascade(message->cascade());
+    }
     else
     {
         LOG(LS_WARNING) << "Unhandled message from router";
@@ -223,18 +470,106 @@ void Controller::onMessageWritten(size_t /* pending */)
     // Nothing
 }
 
+std::string Controller::onMetricsRequest()
+{
+    base::PrometheusWriter writer;
+
+    statistics_->writeMetrics(&writer);
+
+    writer.addGauge("aspia_relay_keys", "Number of keys in the pool.",
+                    static_cast<double>(shared_pool_->count()));
+    writer.addGauge("aspia_relay_ready_keys", "Number of keys generated in advance.",
+                    static_cast<double>(key_generator_ ? key_generator_->readyCount() : 0));
+    writer.addMemory("aspia_relay_memory_bytes", *base::MemoryAccount::global());
+
+    writer.addFamily("aspia_relay_event_loop_lag_seconds", base::PrometheusWriter::Type::HISTOGRAM,
+                     "Time from posting a task to running it on the main and worker threads.");
+    writer.addHistogram("aspia_relay_event_loop_lag_seconds",
+                        base::PrometheusWriter::fromLatency(lag_probe_->snapshot()),
+                        { { "thread", "main" } });
+
+    for (size_t i = 0; i < sessions_workers_.size(); ++i)
+    {
+        base::LatencyHistogram::Snapshot lag = sessions_workers_[i]->lag();
+        if (lag.counts.empty())
+            continue;
+
+        writer.addHistogram("aspia_relay_event_loop_lag_seconds",
+                            base::PrometheusWriter::fromLatency(lag),
+                            { { "thread", "worker-" + std::to_string(i) } });
+    }
+
+    return writer.text();
+}
+
 void Controller::onSessionFinished()
 {
     // After disconnecting the peer, one key is released.
-    // Add a new key to the pool and send it to the router.
-    sendKeyPool(1);
+    onKeyReleased();
 }
 
 void Controller::onPoolKeyExpired(uint32_t /* key_id */)
 {
     // The key has expired and has been removed from the pool.
-    // Add a new key to the pool and send it to the router.
-    sendKeyPool(1);
+    onKeyReleased();
+}
+
+void Controller::onKeyReleased()
+{
+    if (extra_keys_)
+    {
+        // The released key was one of the extra keys.
+        --extra_keys_;
+        return;
+    }
+
+    if (!authenticated_)
+        return;
+
+    // Keys released at nearly the same time (for example, when many sessions are finished at once)
+    // are replaced in one message.
+    ++owed_keys_;
+    scheduleFlush();
+}
+
+void Controller::onKeysReady()
+{
+    // The generator notifies as soon as the first key is ready. The keys made until the posted
+    // flush runs are sent in the same message.
+    scheduleFlush();
+}
+
+void Controller::scheduleFlush()
+{
+    if (flush_scheduled_)
+        return;
+
+    flush_scheduled_ = true;
+    task_runner_->postTask(std::bind(&Controller::flushKeys, this));
+}
+
+void Controller::flushKeys()
+{
+    flush_scheduled_ = false;
+
+    if (!authenticated_ || !owed_keys_)
+        return;
+
+    const uint32_t key_count = owed_keys_;
+    owed_keys_ = 0;
+
+    sendKeyPool(key_count);
+}
+
+void Controller::startMetricsServer()
+{
+    if (!metrics_port_)
+        return;
+
+    // The relay works without metrics if the listener cannot be started.
+    metrics_server_ = std::make_unique<base::MetricsServer>();
+    if (!metrics_server_->start(base::utf8FromUtf16(metrics_address_), metrics_port_, this))
+        metrics_server_.reset();
 }
 
 void Controller::connectToRouter()
@@ -255,21 +590,28 @@ void Controller::delayedConnectToRouter()
     reconnect_timer_.start(kReconnectTimeout, std::bind(&Controller::connectToRouter, this));
 }
 
-void Controller::sendKeyPool(uint32_t key_count)
+void Controller::sendKeyPool(uint32_t key_count, bool refill)
 {
     std::unique_ptr<proto::RelayToRouter> message = std::make_unique<proto::RelayToRouter>();
     proto::RelayKeyPool* relay_key_pool = message->mutable_key_pool();
+    relay_key_pool->set_refill(refill);
 
     relay_key_pool->set_peer_host(base::utf8FromUtf16(peer_address_));
     relay_key_pool->set_peer_port(peer_port_);
+    relay_key_pool->set_region(base::utf8FromUtf16(region_));
 
-    // Add the requested number of keys to the pool.
-    for (uint32_t i = 0; i < key_count; ++i)
-    {
-        SessionKey session_key = SessionKey::create();
-        if (!session_key.isValid())
-            return;
+    // Only the keys generated in advance are sent. The keys that are not ready yet are sent as soon
+    // as the generator makes them.
+    std::vector<SessionKey> session_keys = key_generator_->take(key_count);
+    if (session_keys.size() < key_count)
+        owed_keys_ += key_count - static_cast<uint32_t>(session_keys.size());
+
+    // A refill reply is sent even without keys, so that the router can make the next request.
+    if (session_keys.empty() && !refill)
+        return;
 
+    for (const auto& session_key : session_keys)
+    {
         // Add the key to the outgoing message.
         proto::RelayKey* key = relay_key_pool->add_key();
 
@@ -277,13 +619,22 @@ void Controller::sendKeyPool(uint32_t key_count)
         key->set_encryption(proto::RelayKey::ENCRYPTION_CHACHA20_POLY1305);
         key->set_public_key(base::toStdString(session_key.publicKey()));
         key->set_iv(base::toStdString(session_key.iv()));
-
-        // Add the key to the pool.
-        key->set_key_id(shared_pool_->addKey(std::move(session_key)));
     }
 
+    // All the keys are added to the pool at once.
+    std::vector<uint32_t> key_ids = shared_pool_->addKeys(std::move(session_keys));
+    for (size_t i = 0; i < key_ids.size(); ++i)
+        relay_key_pool->mutable_key(static_cast<int>(i))->set_key_id(key_ids[i]);
+
     // Send a message to the router.
-    channel_->send(base::serialize(*message));
+    channel_->send(*message);
+}
+
+void Controller::sendStatistics()
+{
+    std::unique_ptr<proto::RelayToRouter> message = std::make_unique<proto::RelayToRouter>();
+    statistics_->takeSnapshot(message->mutable_relay_stat());
+    channel_->send(*message);
 }
 
 } // namespace relay
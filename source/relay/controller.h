@@ -20,27 +20,41 @@
 #define RELAY__CONTROLLER_H
 
 #include "base/waitable_timer.h"
+#include "base/net/metrics_server.h"
 #include "base/net/network_channel.h"
 #include "build/build_config.h"
 #include "proto/router_relay.pb.h"
+#include "relay/hot_restart.h"
+#include "relay/key_generator.h"
 #include "relay/sessions_worker.h"
 #include "relay/shared_pool.h"
+#include "relay/statistics.h"
 
 namespace base {
 class ClientAuthenticator;
+class MessageLoopLagProbe;
 } // namespace base
 
 namespace relay {
 
 class Controller
     : public base::NetworkChannel::Listener,
-      public SessionManager::Delegate,
-      public SharedPool::Delegate
+      public base::MetricsServer::Delegate,
+#if defined(OS_POSIX)
+      public HotRestart::Delegate,
+#endif // defined(OS_POSIX)
+      public SessionsWorker::Delegate,
+      public SharedPool::Delegate,
+      public KeyGenerator::Delegate
 {
 public:
     explicit Controller(std::shared_ptr<base::TaskRunner> task_runner);
     ~Controller();
 
+    // Sets the state received from the previous process of the relay (see HotRestart). Must be
+    // called before start().
+    void setInheritedState(HotRestartState&& state);
+
     bool start();
 
 protected:
@@ -50,16 +64,46 @@ protected:
     void onMessageReceived(const base::ByteArray& buffer) override;
     void onMessageWritten(size_t pending) override;
 
-    // SessionManager::Delegate implementation.
+    // base::MetricsServer::Delegate implementation.
+    std::string onMetricsRequest() override;
+
+#if defined(OS_POSIX)
+    // HotRestart::Delegate implementation.
+    void onHotRestartRequested() override;
+#endif // defined(OS_POSIX)
+
+    // SessionsWorker::Delegate implementation.
     void onSessionFinished() override;
 
     // SharedPool::Delegate implementation.
     void onPoolKeyExpired(uint32_t key_id) override;
 
+    // KeyGenerator::Delegate implementation.
+    void onKeysReady() override;
+
 private:
     void connectToRouter();
     void delayedConnectToRouter();
-    void sendKeyPool(uint32_t key_count);
+    void sendKeyPool(uint32_t key_count, bool refill = false);
+
+    // Called when a key leaves the pool (the session with it has finished or it has expired).
+    void onKeyReleased();
+
+    // Posts flushKeys() unless it is already posted.
+    void scheduleFlush();
+
+    // Sends the keys owed to the router in one message.
+    void flushKeys();
+    void sendStatistics();
+    void startMetricsServer();
+
+#if defined(OS_POSIX)
+    void onHandOffFinished(size_t index, HotRestartState&& state, size_t remaining);
+
+    // Called when the sessions are passed to the new process. The relay serves the remaining
+    // sessions and exits when all of them are finished.
+    void startDraining();
+#endif // defined(OS_POSIX)
 
     // Router settings.
     std::u16string router_address_;
@@ -68,16 +112,53 @@ private:
 
     // Peers settings.
     std::u16string peer_address_;
+    std::u16string region_;
     uint16_t peer_port_ = 0;
     std::chrono::minutes peer_idle_timeout_;
     uint32_t max_peer_count_ = 0;
 
+    // Keys sent to the router in reply to its refill requests in addition to |max_peer_count_|.
+    // They are not replaced when released, so the number of keys returns to |max_peer_count_|.
+    uint32_t extra_keys_ = 0;
+
+    // Keys which had to be sent to the router but the generator had no ready keys for them, and
+    // released keys waiting to be replaced. They are sent in one message as soon as possible.
+    uint32_t owed_keys_ = 0;
+    bool flush_scheduled_ = false;
+    bool authenticated_ = false;
+
+    uint32_t thread_count_ = 1;
+    uint32_t session_bandwidth_limit_ = 0;
+    uint32_t total_bandwidth_limit_ = 0;
+    std::string congestion_control_;
+
+    // Metrics listener settings.
+    std::u16string metrics_address_;
+    uint16_t metrics_port_ = 0;
+
     std::shared_ptr<base::TaskRunner> task_runner_;
     base::WaitableTimer reconnect_timer_;
+    base::WaitableTimer statistics_timer_;
     std::unique_ptr<base::NetworkChannel> channel_;
     std::unique_ptr<base::ClientAuthenticator> authenticator_;
     std::unique_ptr<SharedPool> shared_pool_;
-    std::unique_ptr<SessionsWorker> sessions_worker_;
+    std::unique_ptr<KeyGenerator> key_generator_;
+    std::shared_ptr<Statistics> statistics_;
+    std::vector<std::unique_ptr<SessionsWorker>> sessions_workers_;
+    std::unique_ptr<base::MessageLoopLagProbe> lag_probe_;
+    std::unique_ptr<base::MetricsServer> metrics_server_;
+
+    HotRestartState inherited_state_;
+
+#if defined(OS_POSIX)
+    std::unique_ptr<HotRestart> hot_restart_;
+
+    // States passed by the workers for the new process.
+    std::vector<HotRestartState> hand_off_states_;
+    size_t pending_hand_offs_ = 0;
+    size_t remaining_sessions_ = 0;
+    std::unique_ptr<base::WaitableTimer> drain_timer_;
+#endif // defined(OS_POSIX)
 
     DISALLOW_COPY_AND_ASSIGN(Controller);
 };
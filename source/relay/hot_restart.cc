@@ -0,0 +1,495 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "relay/hot_restart.h"
+
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_asio.h"
+#include "base/strings/unicode.h"
+
+#include <asio/read.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace relay {
+
+namespace {
+
+const char kSocketPath[] = "/var/run/aspia_relay.sock";
+
+// The new process waits for the old one while it releases the sessions (see
+// SessionManager::handOff).
+const int kReceiveTimeoutSeconds = 30;
+
+// Changes with the layout of the records, so processes of incompatible versions do not pass the
+// sockets to each other.
+const uint32_t kMagic = 0x41524831; // "ARH1"
+
+enum RecordType : uint32_t
+{
+    RECORD_REQUEST = 1, // The new process requests the state.
+    RECORD_LISTENER,    // One listening socket.
+    RECORD_SESSION,     // Two sockets of a session.
+    RECORD_END          // The last record of the state.
+};
+
+// The sockets are passed in the ancillary data of the records.
+struct Record
+{
+    uint32_t magic;
+    uint32_t type;
+    int64_t duration;
+    int64_t bytes_transferred;
+};
+
+const size_t kMaxSocketsPerRecord = 2;
+
+#if defined(OS_LINUX)
+const int kSendFlags = MSG_NOSIGNAL;
+#else
+const int kSendFlags = 0;
+#endif
+
+bool sendRecord(int fd, const Record& record, const int* sockets, size_t count)
+{
+    DCHECK_LE(count, kMaxSocketsPerRecord);
+
+    iovec iov;
+    iov.iov_base = const_cast<Record*>(&record);
+    iov.iov_len = sizeof(record);
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxSocketsPerRecord)];
+    memset(control, 0, sizeof(control));
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+
+    if (count)
+    {
+        message.msg_control = control;
+        message.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int) * count);
+        memcpy(CMSG_DATA(header), sockets, sizeof(int) * count);
+    }
+
+    ssize_t sent;
+    do
+    {
+        sent = sendmsg(fd, &message, kSendFlags);
+    }
+    while (sent == -1 && errno == EINTR);
+
+    if (sent != static_cast<ssize_t>(sizeof(record)))
+    {
+        PLOG(LS_ERROR) << "sendmsg failed";
+        return false;
+    }
+
+    return true;
+}
+
+// Receives a record and the sockets attached to it. Returns the number of the sockets or -1 on
+// error.
+int receiveRecord(int fd, Record* record, int* sockets)
+{
+    iovec iov;
+    iov.iov_base = record;
+    iov.iov_len = sizeof(*record);
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxSocketsPerRecord)];
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do
+    {
+        received = recvmsg(fd, &message, 0);
+    }
+    while (received == -1 && errno == EINTR);
+
+    if (received == -1)
+    {
+        PLOG(LS_ERROR) << "recvmsg failed";
+        return -1;
+    }
+
+    if (received == 0)
+    {
+        LOG(LS_ERROR) << "Connection closed by the running relay";
+        return -1;
+    }
+
+    int count = 0;
+
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header;
+         header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+            continue;
+
+        const size_t size = header->cmsg_len - CMSG_LEN(0);
+        const int header_count = static_cast<int>(size / sizeof(int));
+
+        for (int i = 0; i < header_count; ++i)
+        {
+            int socket;
+            memcpy(&socket, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+
+            // The received sockets must not leak into the child processes.
+            fcntl(socket, F_SETFD, FD_CLOEXEC);
+
+            if (count < static_cast<int>(kMaxSocketsPerRecord))
+                sockets[count++] = socket;
+            else
+                ::close(socket);
+        }
+    }
+
+    bool has_error = (message.msg_flags & MSG_CTRUNC) != 0;
+
+    // The ancillary data comes with the first byte of the record. The rest of the stream socket
+    // can come in pieces.
+    size_t offset = static_cast<size_t>(received);
+    while (!has_error && offset < sizeof(*record))
+    {
+        received = recv(
+            fd, reinterpret_cast<uint8_t*>(record) + offset, sizeof(*record) - offset, 0);
+        if (received == -1 && errno == EINTR)
+            continue;
+
+        if (received <= 0)
+        {
+            LOG(LS_ERROR) << "Incomplete record";
+            has_error = true;
+            break;
+        }
+
+        offset += static_cast<size_t>(received);
+    }
+
+    if (has_error || record->magic != kMagic)
+    {
+        LOG(LS_ERROR) << "Invalid record";
+
+        for (int i = 0; i < count; ++i)
+            ::close(sockets[i]);
+        return -1;
+    }
+
+    return count;
+}
+
+} // namespace
+
+HotRestart::HotRestart()
+    : acceptor_(base::MessageLoop::current()->pumpAsio()->ioContext()),
+      socket_(base::MessageLoop::current()->pumpAsio()->ioContext())
+{
+    // Nothing
+}
+
+HotRestart::~HotRestart()
+{
+    std::error_code ignored_code;
+    acceptor_.close(ignored_code);
+    socket_.close(ignored_code);
+}
+
+bool HotRestart::start(Delegate* delegate)
+{
+    delegate_ = delegate;
+    DCHECK(delegate_);
+
+    // The socket of the previous process is left after a hot restart or a crash.
+    unlink(kSocketPath);
+
+    asio::local::stream_protocol::endpoint endpoint(kSocketPath);
+    std::error_code error_code;
+
+    acceptor_.open(endpoint.protocol(), error_code);
+    if (!error_code)
+        acceptor_.bind(endpoint, error_code);
+    if (error_code)
+    {
+        LOG(LS_WARNING) << "Unable to bind hot restart socket " << kSocketPath << ": "
+                        << base::utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+    // Anyone who can connect gets the connections of the peers.
+    if (chmod(kSocketPath, S_IRUSR | S_IWUSR) == -1)
+    {
+        PLOG(LS_ERROR) << "chmod failed";
+        return false;
+    }
+
+    acceptor_.listen(1, error_code);
+    if (error_code)
+    {
+        LOG(LS_WARNING) << "Unable to listen hot restart socket: "
+                        << base::utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+    doAccept(this);
+    return true;
+}
+
+bool HotRestart::send(const HotRestartState& state)
+{
+    DCHECK(socket_.is_open());
+
+    std::error_code error_code;
+
+    // The records are written with blocking calls. The new process reads them right away.
+    socket_.native_non_blocking(false, error_code);
+
+    const int fd = socket_.native_handle();
+    bool result = true;
+
+#if !defined(OS_LINUX)
+    int no_sigpipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif // !defined(OS_LINUX)
+
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.magic = kMagic;
+
+    for (const HotRestartState::NativeSocket listener : state.listeners)
+    {
+        record.type = RECORD_LISTENER;
+        if (!sendRecord(fd, record, &listener, 1))
+        {
+            result = false;
+            break;
+        }
+    }
+
+    for (size_t i = 0; result && i < state.sessions.size(); ++i)
+    {
+        const HotRestartState::Session& session = state.sessions[i];
+
+        record.type = RECORD_SESSION;
+        record.duration = session.duration.count();
+        record.bytes_transferred = session.bytes_transferred;
+
+        result = sendRecord(fd, record, session.sockets, 2);
+    }
+
+    if (result)
+    {
+        memset(&record, 0, sizeof(record));
+        record.magic = kMagic;
+        record.type = RECORD_END;
+
+        result = sendRecord(fd, record, nullptr, 0);
+    }
+
+    socket_.close(error_code);
+
+    LOG(LS_INFO) << "Hot restart state sent (listeners: " << state.listeners.size()
+                 << ", sessions: " << state.sessions.size() << ", result: " << result << ")";
+    return result;
+}
+
+// static
+bool HotRestart::receive(HotRestartState* state)
+{
+    DCHECK(state);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+    {
+        PLOG(LS_ERROR) << "socket failed";
+        return false;
+    }
+
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    timeval timeout;
+    timeout.tv_sec = kReceiveTimeoutSeconds;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+#if !defined(OS_LINUX)
+    int no_sigpipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif // !defined(OS_LINUX)
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, kSocketPath, sizeof(address.sun_path) - 1);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+    {
+        PLOG(LS_WARNING) << "Unable to connect to the running relay";
+        ::close(fd);
+        return false;
+    }
+
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.magic = kMagic;
+    record.type = RECORD_REQUEST;
+
+    bool result = sendRecord(fd, record, nullptr, 0);
+
+    while (result)
+    {
+        int sockets[kMaxSocketsPerRecord];
+        const int count = receiveRecord(fd, &record, sockets);
+        if (count == -1)
+        {
+            result = false;
+            break;
+        }
+
+        if (record.type == RECORD_END && count == 0)
+            break;
+
+        if (record.type == RECORD_LISTENER && count == 1)
+        {
+            state->listeners.emplace_back(sockets[0]);
+        }
+        else if (record.type == RECORD_SESSION && count == 2)
+        {
+            HotRestartState::Session session;
+            session.sockets[0] = sockets[0];
+            session.sockets[1] = sockets[1];
+            session.duration = std::chrono::seconds(record.duration);
+            session.bytes_transferred = record.bytes_transferred;
+
+            state->sessions.emplace_back(session);
+        }
+        else
+        {
+            LOG(LS_ERROR) << "Unexpected record: " << record.type << " (sockets: " << count << ")";
+
+            for (int i = 0; i < count; ++i)
+                ::close(sockets[i]);
+            result = false;
+        }
+    }
+
+    ::close(fd);
+
+    if (!result)
+    {
+        // A part of the state is useless: the old process has stopped accepting connections, and
+        // the new one must listen on its own.
+        close(state);
+        return false;
+    }
+
+    LOG(LS_INFO) << "Hot restart state received (listeners: " << state->listeners.size()
+                 << ", sessions: " << state->sessions.size() << ")";
+    return true;
+}
+
+// static
+void HotRestart::close(HotRestartState* state)
+{
+    for (const HotRestartState::NativeSocket listener : state->listeners)
+        ::close(listener);
+
+    for (const HotRestartState::Session& session : state->sessions)
+    {
+        ::close(session.sockets[0]);
+        ::close(session.sockets[1]);
+    }
+
+    state->listeners.clear();
+    state->sessions.clear();
+}
+
+// static
+void HotRestart::doAccept(HotRestart* self)
+{
+    self->acceptor_.async_accept(self->socket_, [self](const std::error_code& error_code)
+    {
+        if (error_code)
+        {
+            if (error_code == asio::error::operation_aborted)
+                return;
+
+            LOG(LS_WARNING) << "Error while accepting hot restart connection: "
+                            << base::utf16FromLocal8Bit(error_code.message());
+            doAccept(self);
+            return;
+        }
+
+        self->doReadRequest();
+    });
+}
+
+void HotRestart::doReadRequest()
+{
+    static_assert(sizeof(request_) == sizeof(Record), "The request is a whole record");
+
+    asio::async_read(socket_, asio::buffer(request_, sizeof(request_)),
+        [this](const std::error_code& error_code, size_t /* bytes_transferred */)
+    {
+        if (error_code == asio::error::operation_aborted)
+            return;
+
+        Record request;
+        memcpy(&request, request_, sizeof(request));
+
+        if (error_code || request.magic != kMagic || request.type != RECORD_REQUEST ||
+            request.duration != 0 || request.bytes_transferred != 0)
+        {
+            LOG(LS_WARNING) << "Invalid hot restart request";
+
+            std::error_code ignored_code;
+            socket_.close(ignored_code);
+            doAccept(this);
+            return;
+        }
+
+        LOG(LS_INFO) << "Hot restart requested";
+
+        // The new process creates its own listener when it has received the state.
+        std::error_code ignored_code;
+        acceptor_.close(ignored_code);
+
+        delegate_->onHotRestartRequested();
+    });
+}
+
+} // namespace relay
@@ -0,0 +1,113 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef RELAY__HOT_RESTART_H
+#define RELAY__HOT_RESTART_H
+
+#include "base/macros_magic.h"
+#include "build/build_config.h"
+
+#include <asio/ip/tcp.hpp>
+
+#if defined(OS_POSIX)
+#include <asio/local/stream_protocol.hpp>
+#endif // defined(OS_POSIX)
+
+#include <chrono>
+#include <vector>
+
+namespace relay {
+
+// Sockets which the running process of the relay passes to a new one (see HotRestart).
+struct HotRestartState
+{
+    using NativeSocket = asio::ip::tcp::socket::native_handle_type;
+
+    struct Session
+    {
+        NativeSocket sockets[2];
+        std::chrono::seconds duration;
+        int64_t bytes_transferred;
+
+        // The session was released by another process of the relay, which owns its key. The flag is
+        // not passed: a received session is always inherited. In the releasing process the flag
+        // keeps the value of the session, so the session is restored as it was if the hand off
+        // fails.
+        bool inherited = true;
+    };
+
+    std::vector<NativeSocket> listeners;
+    std::vector<Session> sessions;
+};
+
+#if defined(OS_POSIX)
+
+// Restarts the relay (for example, to update it) without breaking the sessions of peers. The
+// running process listens on a local socket. A new process started with --hot-restart connects to
+// it and receives the listening sockets and the sockets of the active sessions (SCM_RIGHTS, see
+// unix(7)). The sessions which cannot be passed are served by the old process until they are
+// finished.
+class HotRestart
+{
+public:
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        // A new process is connected and waits for the state (see send()).
+        virtual void onHotRestartRequested() = 0;
+    };
+
+    HotRestart();
+    ~HotRestart();
+
+    // Starts listening for a new process. Only one request is accepted.
+    bool start(Delegate* delegate);
+
+    // Passes |state| to the new process and closes the connection to it. The sockets of |state|
+    // stay open in this process.
+    bool send(const HotRestartState& state);
+
+    // Called by the new process before it starts serving peers. Receives the state of the running
+    // process. Returns false if there is no running process or the state cannot be received.
+    static bool receive(HotRestartState* state);
+
+    // Closes all sockets of |state| and clears it.
+    static void close(HotRestartState* state);
+
+private:
+    static void doAccept(HotRestart* self);
+    void doReadRequest();
+
+    // The size of a record of the protocol (see hot_restart.cc).
+    static const size_t kRecordSize = 24;
+
+    asio::local::stream_protocol::acceptor acceptor_;
+    asio::local::stream_protocol::socket socket_;
+    uint8_t request_[kRecordSize];
+    Delegate* delegate_ = nullptr;
+
+    DISALLOW_COPY_AND_ASSIGN(HotRestart);
+};
+
+#endif // defined(OS_POSIX)
+
+} // namespace relay
+
+#endif // RELAY__HOT_RESTART_H
@@ -0,0 +1,137 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "relay/key_generator.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+
+#include <algorithm>
+
+namespace relay {
+
+KeyGenerator::KeyGenerator(size_t capacity,
+                           std::shared_ptr<base::TaskRunner> caller_task_runner,
+                           Delegate* delegate)
+    : capacity_(std::max(capacity, size_t(1))),
+      caller_task_runner_(std::move(caller_task_runner)),
+      delegate_(delegate),
+      self_(std::make_shared<KeyGenerator*>(this))
+{
+    DCHECK(caller_task_runner_);
+    DCHECK(delegate_);
+
+    thread_.start(base::MessageLoop::Type::DEFAULT);
+
+    generating_ = true;
+    thread_.taskRunner()->postTask(std::bind(&KeyGenerator::generate, this));
+}
+
+KeyGenerator::~KeyGenerator()
+{
+    stopping_ = true;
+    thread_.stop();
+}
+
+std::vector<SessionKey> KeyGenerator::take(size_t count)
+{
+    std::vector<SessionKey> keys;
+    bool start_generation = false;
+
+    {
+        std::scoped_lock lock(lock_);
+
+        const size_t ready_count = std::min(count, ready_.size());
+        keys.reserve(ready_count);
+
+        for (size_t i = 0; i < ready_count; ++i)
+        {
+            keys.emplace_back(std::move(ready_.front()));
+            ready_.pop_front();
+        }
+
+        if (ready_count < count)
+            notify_ = true;
+
+        if (!generating_ && ready_.size() < capacity_ / 2 + 1)
+        {
+            generating_ = true;
+            start_generation = true;
+        }
+    }
+
+    if (start_generation)
+        thread_.taskRunner()->postTask(std::bind(&KeyGenerator::generate, this));
+
+    return keys;
+}
+
+size_t KeyGenerator::readyCount() const
+{
+    std::scoped_lock lock(lock_);
+    return ready_.size();
+}
+
+void KeyGenerator::generate()
+{
+    while (!stopping_)
+    {
+        {
+            std::scoped_lock lock(lock_);
+            if (ready_.size() >= capacity_)
+            {
+                generating_ = false;
+                return;
+            }
+        }
+
+        SessionKey session_key = SessionKey::create();
+        if (!session_key.isValid())
+        {
+            LOG(LS_ERROR) << "Failed to generate a session key";
+
+            std::scoped_lock lock(lock_);
+            generating_ = false;
+            return;
+        }
+
+        bool notify;
+
+        {
+            std::scoped_lock lock(lock_);
+            ready_.emplace_back(std::move(session_key));
+
+            notify = notify_;
+            notify_ = false;
+        }
+
+        if (notify)
+        {
+            std::weak_ptr<KeyGenerator*> self = self_;
+
+            caller_task_runner_->postTask([self]()
+            {
+                std::shared_ptr<KeyGenerator*> generator = self.lock();
+                if (generator)
+                    (*generator)->delegate_->onKeysReady();
+            });
+        }
+    }
+}
+
+} // namespace relay
@@ -0,0 +1,88 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef RELAY__KEY_GENERATOR_H
+#define RELAY__KEY_GENERATOR_H
+
+#include "base/threading/thread.h"
+#include "relay/session_key.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace base {
+class TaskRunner;
+} // namespace base
+
+namespace relay {
+
+// Generates session keys ahead of time on a background thread, so that the controller does not
+// spend its time on key generation when the router asks for keys. The queue of ready keys is kept
+// full: the generation starts when the queue falls below half of its capacity.
+class KeyGenerator
+{
+public:
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        // New keys are ready after take() could not return all the requested keys. Called on the
+        // thread of the caller task runner.
+        virtual void onKeysReady() = 0;
+    };
+
+    KeyGenerator(size_t capacity,
+                 std::shared_ptr<base::TaskRunner> caller_task_runner,
+                 Delegate* delegate);
+    ~KeyGenerator();
+
+    // Returns up to |count| ready keys without waiting.
+    std::vector<SessionKey> take(size_t count);
+
+    // Number of the ready keys. Can be called from any thread.
+    size_t readyCount() const;
+
+private:
+    // Called on the generator thread.
+    void generate();
+
+    const size_t capacity_;
+    std::shared_ptr<base::TaskRunner> caller_task_runner_;
+    Delegate* delegate_;
+
+    // The notifications posted to the caller are dropped after the generator is destroyed.
+    std::shared_ptr<KeyGenerator*> self_;
+
+    base::Thread thread_;
+    std::atomic_bool stopping_ = false;
+
+    mutable std::mutex lock_;
+    std::deque<SessionKey> ready_;
+    bool generating_ = false;
+    bool notify_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(KeyGenerator);
+};
+
+} // namespace relay
+
+#endif // RELAY__KEY_GENERATOR_H
@@ -0,0 +1,143 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "relay/key_generator.h"
+
+#include "base/message_loop/message_loop.h"
+#include "base/task_runner.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+
+namespace relay {
+
+namespace {
+
+const size_t kCapacity = 8;
+
+class KeyGeneratorTest
+    : public testing::Test,
+      public KeyGenerator::Delegate
+{
+protected:
+    // Waits until the generator has filled its queue.
+    static bool waitForKeys(const KeyGenerator& generator, size_t count)
+    {
+        for (int i = 0; i < 1000 && generator.readyCount() < count; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        return generator.readyCount() >= count;
+    }
+
+    // Runs the message loop until onKeysReady() is called or the timeout expires.
+    void runUntilKeysReady()
+    {
+        std::shared_ptr<base::TaskRunner> task_runner = message_loop_.taskRunner();
+        task_runner->postDelayedTask([task_runner]() { task_runner->postQuit(); },
+                                     std::chrono::seconds(5));
+        message_loop_.run();
+    }
+
+    // KeyGenerator::Delegate implementation.
+    void onKeysReady() override
+    {
+        ++keys_ready_count_;
+        message_loop_.taskRunner()->postQuit();
+    }
+
+    base::MessageLoop message_loop_;
+    int keys_ready_count_ = 0;
+};
+
+} // namespace
+
+TEST_F(KeyGeneratorTest, FillsQueue)
+{
+    KeyGenerator generator(kCapacity, message_loop_.taskRunner(), this);
+    ASSERT_TRUE(waitForKeys(generator, kCapacity));
+
+    // The queue is not filled over its capacity.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(generator.readyCount(), kCapacity);
+}
+
+TEST_F(KeyGeneratorTest, TakesReadyKeys)
+{
+    KeyGenerator generator(kCapacity, message_loop_.taskRunner(), this);
+    ASSERT_TRUE(waitForKeys(generator, kCapacity));
+
+    // The queue falls below half of its capacity and is filled again.
+    std::vector<SessionKey> keys = generator.take(kCapacity / 2 + 1);
+    ASSERT_EQ(keys.size(), kCapacity / 2 + 1);
+
+    std::set<base::ByteArray> public_keys;
+    for (const SessionKey& key : keys)
+    {
+        EXPECT_TRUE(key.isValid());
+        public_keys.insert(key.publicKey());
+    }
+
+    EXPECT_EQ(public_keys.size(), keys.size());
+
+    // All the requested keys were returned, so the delegate is not notified.
+    ASSERT_TRUE(waitForKeys(generator, kCapacity));
+    message_loop_.taskRunner()->postQuit();
+    message_loop_.run();
+    EXPECT_EQ(keys_ready_count_, 0);
+}
+
+TEST_F(KeyGeneratorTest, NotifiesWhenKeysAreMissing)
+{
+    KeyGenerator generator(kCapacity, message_loop_.taskRunner(), this);
+    ASSERT_TRUE(waitForKeys(generator, kCapacity));
+
+    // More keys than ready are requested. The ready keys are returned without waiting.
+    std::vector<SessionKey> keys = generator.take(kCapacity * 2);
+    EXPECT_EQ(keys.size(), kCapacity);
+
+    runUntilKeysReady();
+    EXPECT_EQ(keys_ready_count_, 1);
+
+    // The queue is filled again, and one notification is sent for the missing keys.
+    ASSERT_TRUE(waitForKeys(generator, kCapacity));
+    message_loop_.taskRunner()->postQuit();
+    message_loop_.run();
+    EXPECT_EQ(keys_ready_count_, 1);
+
+    EXPECT_EQ(generator.take(kCapacity).size(), kCapacity);
+}
+
+TEST_F(KeyGeneratorTest, NoNotificationAfterDestruction)
+{
+    {
+        KeyGenerator generator(kCapacity, message_loop_.taskRunner(), this);
+        ASSERT_TRUE(waitForKeys(generator, kCapacity));
+
+        generator.take(kCapacity * 2);
+        ASSERT_TRUE(waitForKeys(generator, 1));
+    }
+
+    // The notification posted by the destroyed generator is dropped.
+    message_loop_.taskRunner()->postQuit();
+    message_loop_.run();
+    EXPECT_EQ(keys_ready_count_, 0);
+}
+
+} // namespace relay
@@ -27,7 +27,9 @@
 #else
 #include "base/crypto/scoped_crypto_initializer.h"
 #include "base/message_loop/message_loop.h"
+#include "base/trace_dumper.h"
 #include "relay/controller.h"
+#include "relay/hot_restart.h"
 #endif
 
 #include <iostream>
@@ -40,6 +42,7 @@ void initLogging()
 
     base::LoggingSettings logging_settings;
     logging_settings.min_log_level = settings.minLogLevel();
+    logging_settings.asynchronous = true;
 
     base::initLogging(logging_settings);
 }
@@ -79,6 +82,12 @@ void showHelp()
         << '\t' << "--stop"    << '\t' << "Stop service"    << std::endl
 #endif // defined(OS_WIN)
         << '\t' << "--create-config" << '\t' << "Creates a configuration" << std::endl
+#if !defined(OS_WIN)
+        << '\t' << "--trace=<file>" << '\t'
+        << "Record a trace, write it to the file on SIGUSR1" << std::endl
+        << '\t' << "--hot-restart" << '\t'
+        << "Take over the sessions of the running relay" << std::endl
+#endif // !defined(OS_WIN)
         << '\t' << "--help"    << '\t' << "Show help"       << std::endl;
 }
 
@@ -148,13 +157,32 @@ int main(int argc, const char* const* argv)
         std::unique_ptr<base::MessageLoop> message_loop =
             std::make_unique<base::MessageLoop>(base::MessageLoop::Type::ASIO);
 
+        // The trace is written in the Chrome trace event format (see TraceLog).
+        std::unique_ptr<base::TraceDumper> trace_dumper;
+        if (command_line->hasSwitch(u"trace"))
+        {
+            trace_dumper = std::make_unique<base::TraceDumper>(
+                command_line->switchValuePath(u"trace"));
+        }
+
+        // The running relay passes its listening sockets and sessions to this process and exits
+        // when its remaining sessions are finished.
+        relay::HotRestartState inherited_state;
+        if (command_line->hasSwitch(u"hot-restart") &&
+            !relay::HotRestart::receive(&inherited_state))
+        {
+            LOG(LS_WARNING) << "Unable to take over the running relay";
+        }
+
         std::unique_ptr<relay::Controller> controller =
             std::make_unique<relay::Controller>(message_loop->taskRunner());
 
+        controller->setInheritedState(std::move(inherited_state));
         controller->start();
         message_loop->run();
 
         controller.reset();
+        trace_dumper.reset();
         message_loop.reset();
     }
 
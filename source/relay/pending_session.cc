@@ -38,7 +38,8 @@ PendingSession::PendingSession(std::shared_ptr<base::TaskRunner> task_runner,
                                asio::ip::tcp::socket&& socket,
                                Delegate* delegate)
     : delegate_(delegate),
-      timer_(base::WaitableTimer::Type::SINGLE_SHOT, std::move(task_runner)),
+      timer_(base::WaitableTimer::Type::SINGLE_SHOT, std::move(task_runner),
+             base::WaitableTimer::Precision::COARSE),
       socket_(std::move(socket))
 {
     // Nothing
@@ -53,6 +54,8 @@ void PendingSession::start()
 {
     LOG(LS_INFO) << "Starting pending session";
 
+    start_time_ = std::chrono::steady_clock::now();
+
     asio::ip::tcp::no_delay option(true);
     asio::error_code error_code;
 
@@ -68,6 +71,17 @@ void PendingSession::start()
     PendingSession::doReadMessage(this);
 }
 
+void PendingSession::start(const proto::PeerToRelay& message)
+{
+    LOG(LS_INFO) << "Starting pending session with received message";
+
+    timer_.start(kTimeout, std::bind(
+        &PendingSession::onErrorOccurred, this, FROM_HERE, std::error_code()));
+
+    if (delegate_)
+        delegate_->onPendingSessionReady(this, message);
+}
+
 void PendingSession::stop()
 {
     if (!delegate_)
@@ -81,10 +95,14 @@ void PendingSession::stop()
     socket_.close(ignored_code);
 }
 
-void PendingSession::setIdentify(uint32_t key_id, const base::ByteArray& secret)
+void PendingSession::setIdentify(uint32_t key_id, const base::ByteArray& secret,
+                                 base::ConnectionTrace::Id trace_id)
 {
     secret_ = secret;
     key_id_ = key_id;
+
+    trace_ = base::ConnectionTrace(trace_id);
+    trace_.addStage("Peer authenticated by relay");
 }
 
 bool PendingSession::isPeerFor(const PendingSession& other) const
@@ -174,6 +192,9 @@ void PendingSession::onMessage()
         return;
     }
 
+    handshake_latency_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time_);
+
     if (delegate_)
         delegate_->onPendingSessionReady(this, message);
 }
@@ -21,11 +21,15 @@
 
 #include "base/waitable_timer.h"
 #include "base/memory/byte_array.h"
+#include "base/peer/connection_trace.h"
 #include "base/peer/host_id.h"
 #include "proto/relay_peer.pb.h"
 
 #include <asio/ip/tcp.hpp>
 
+#include <chrono>
+#include <optional>
+
 namespace base {
 class Location;
 class TaskRunner;
@@ -59,11 +63,22 @@ public:
     // will be called.
     void start();
 
+    // Starts a session for which the authentication data has already been received by another
+    // session manager. Method onPendingSessionReady() is called immediately.
+    void start(const proto::PeerToRelay& message);
+
     // Stops a session. No notifications will not come after calling this method.
     void stop();
 
-    // Sets session credentials.
-    void setIdentify(uint32_t key_id, const base::ByteArray& secret);
+    // Sets session credentials. The peer is ready to be paired from this moment, the trace of the
+    // connection is continued with |trace_id| (see base::ConnectionTrace).
+    void setIdentify(uint32_t key_id, const base::ByteArray& secret,
+                     base::ConnectionTrace::Id trace_id);
+
+    base::ConnectionTrace& trace() { return trace_; }
+
+    // Returns the key identifier set by setIdentify().
+    uint32_t keyId() const { return key_id_; }
 
     // Returns true if the other session is a pair and false otherwise.
     bool isPeerFor(const PendingSession& other) const;
@@ -71,6 +86,13 @@ public:
     // Releases a socket from a class.
     asio::ip::tcp::socket takeSocket();
 
+    // Time from the start until the authentication data is read. Empty if the data was received by
+    // another session manager.
+    const std::optional<std::chrono::milliseconds>& handshakeLatency() const
+    {
+        return handshake_latency_;
+    }
+
 private:
     static void doReadMessage(PendingSession* pending_session);
     void onErrorOccurred(const base::Location& location, const std::error_code& error_code);
@@ -87,6 +109,11 @@ private:
     base::ByteArray secret_;
     uint32_t key_id_ = -1;
 
+    std::chrono::steady_clock::time_point start_time_;
+    std::optional<std::chrono::milliseconds> handshake_latency_;
+
+    base::ConnectionTrace trace_ { base::ConnectionTrace::kInvalidId };
+
     DISALLOW_COPY_AND_ASSIGN(PendingSession);
 };
 
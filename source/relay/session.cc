@@ -20,31 +20,127 @@
 
 #include "base/location.h"
 #include "base/logging.h"
+#include "base/memory/buffer_pool.h"
 #include "base/strings/unicode.h"
+#include "base/trace_event.h"
 
 #include <asio/write.hpp>
 
+#include <algorithm>
+
+#if defined(OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif // defined(OS_LINUX)
+
 namespace relay {
 
+#if defined(OS_LINUX)
+
+namespace {
+
+// Maximum number of splice operations in a row for one direction. After that, other sessions get
+// their turn.
+const int kMaxSpliceIterations = 16;
+
+} // namespace
+
+#endif // defined(OS_LINUX)
+
+namespace {
+
+// Minimum burst of the bandwidth limit.
+const int64_t kMinBandwidthBurst = 16 * 1024;
+
+} // namespace
+
 Session::Session(std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>&& sockets)
-    : socket_{ std::move(sockets.first), std::move(sockets.second) }
+    : socket_{ std::move(sockets.first), std::move(sockets.second) },
+      limit_timer_{ asio::high_resolution_timer(socket_[0].get_executor()),
+                    asio::high_resolution_timer(socket_[1].get_executor()) }
 {
+#if defined(OS_LINUX)
     for (size_t i = 0; i < kNumberOfSides; ++i)
-        std::fill(buffer_[i].begin(), buffer_[i].end(), 0);
+        pipe_[i][0] = pipe_[i][1] = -1;
+#endif // defined(OS_LINUX)
 }
 
 Session::~Session()
 {
     stop();
+
+#if defined(OS_LINUX)
+    for (size_t i = 0; i < kNumberOfSides; ++i)
+    {
+        for (size_t j = 0; j < 2; ++j)
+        {
+            if (pipe_[i][j] != -1)
+                close(pipe_[i][j]);
+        }
+    }
+#endif // defined(OS_LINUX)
+}
+
+void Session::setBandwidthLimit(uint32_t session_limit,
+                                std::shared_ptr<base::TokenBucket> total_limit)
+{
+    if (session_limit)
+        session_limit_ = createBandwidthLimit(session_limit);
+
+    total_limit_ = std::move(total_limit);
+}
+
+// static
+std::shared_ptr<base::TokenBucket> Session::createBandwidthLimit(int64_t rate)
+{
+    return std::make_shared<base::TokenBucket>(rate, std::max(rate / 10, kMinBandwidthBurst));
+}
+
+void Session::setStatistics(std::shared_ptr<Statistics> statistics)
+{
+    statistics_ = std::move(statistics);
+}
+
+void Session::resume(const std::chrono::seconds& duration, int64_t bytes_transferred,
+                     bool inherited)
+{
+    inherited_ = inherited;
+    previous_duration_ = duration;
+    bytes_transferred_ = bytes_transferred;
 }
 
 void Session::start(Delegate* delegate)
 {
-    LOG(LS_INFO) << "Starting peers session";
+    LOG(LS_INFO) << "Starting peers session" << (inherited_ ? " (inherited)" : "");
+
+    DCHECK(statistics_);
 
-    start_time_ = Clock::now();
+    last_activity_time_ = Clock::now();
+    start_time_ = last_activity_time_ - previous_duration_;
     delegate_ = delegate;
 
+#if defined(OS_LINUX)
+    splice_ = initSplice();
+    if (splice_)
+    {
+        for (int i = 0; i < kNumberOfSides; ++i)
+            Session::doSplice(this, i);
+        return;
+    }
+#endif // defined(OS_LINUX)
+
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        // Data is read only after the socket becomes readable, and the read must not block.
+        std::error_code error_code;
+        socket_[i].non_blocking(true, error_code);
+        if (error_code)
+        {
+            LOG(LS_WARNING) << "Failed to set non-blocking mode: "
+                            << base::utf16FromLocal8Bit(error_code.message());
+        }
+    }
+
     for (int i = 0; i < kNumberOfSides; ++i)
         Session::doReadSome(this, i);
 }
@@ -59,6 +155,7 @@ void Session::stop()
     std::error_code ignored_code;
     for (int i = 0; i < kNumberOfSides; ++i)
     {
+        limit_timer_[i].cancel(ignored_code);
         socket_[i].cancel(ignored_code);
         socket_[i].close(ignored_code);
     }
@@ -67,15 +164,29 @@ void Session::stop()
                  << " seconds, bytes transferred: " << bytesTransferred() << ")";
 }
 
-std::chrono::seconds Session::idleTime(const TimePoint& current_time) const
+void Session::release(ReleaseCallback callback)
 {
-    if (start_idle_time_ == TimePoint())
-    {
-        start_idle_time_ = current_time;
-        return std::chrono::seconds(0);
-    }
+    DCHECK(delegate_);
+    DCHECK(callback);
+
+    release_callback_ = std::move(callback);
+    tryRelease();
+}
+
+void Session::cancelRelease()
+{
+    release_callback_ = nullptr;
+}
 
-    return std::chrono::duration_cast<std::chrono::seconds>(current_time - start_idle_time_);
+std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket> Session::takeSockets()
+{
+    DCHECK(released_);
+    return std::make_pair(std::move(socket_[0]), std::move(socket_[1]));
+}
+
+std::chrono::seconds Session::idleTime(const TimePoint& current_time) const
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(current_time - last_activity_time_);
 }
 
 std::chrono::seconds Session::duration() const
@@ -91,9 +202,136 @@ int64_t Session::bytesTransferred() const
 // static
 void Session::doReadSome(Session* session, int source)
 {
-    session->socket_[source].async_read_some(
-        asio::buffer(session->buffer_[source].data(), session->buffer_[source].size()),
-        [session, source](const std::error_code& error_code, size_t bytes_transferred)
+    // The buffer is taken from the pool when the data is already available.
+    session->socket_[source].async_wait(asio::ip::tcp::socket::wait_read,
+        base::makeAllocatingHandler(session->handler_memory_[source],
+                                    [session, source](const std::error_code& error_code)
+    {
+        if (session->released_)
+            return;
+
+        session->idle_[source] = false;
+
+        if (error_code)
+        {
+            if (error_code != asio::error::operation_aborted)
+                session->onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        TRACE_EVENT("relay", "Session::readSome");
+
+        size_t& buffer_size = session->buffer_size_[source];
+
+        const size_t allowed = session->allowedBytes(buffer_size);
+        if (!allowed)
+        {
+            doWaitBandwidth(session, source, &Session::doReadSome);
+            return;
+        }
+
+        base::BufferPool* pool = base::BufferPool::instance();
+        base::ByteArray& buffer = session->buffer_[source];
+
+        buffer = pool->acquire(buffer_size);
+        session->buffer_memory_[source].set(buffer.capacity());
+
+        std::error_code read_error_code;
+        size_t bytes_transferred = session->socket_[source].read_some(
+            asio::buffer(buffer.data(), allowed), read_error_code);
+        if (read_error_code)
+        {
+            pool->release(std::move(buffer));
+            session->buffer_memory_[source].set(0);
+
+            if (read_error_code == asio::error::would_block)
+                doReadSome(session, source);
+            else
+                session->onErrorOccurred(FROM_HERE, read_error_code);
+            return;
+        }
+
+        // If the read filled the buffer, more data is probably waiting. If the read took only a
+        // small part of the buffer (and was not limited by the bandwidth), the buffer is reduced.
+        if (bytes_transferred == buffer_size)
+        {
+            session->statistics_->addBufferFull();
+            buffer_size = std::min(buffer_size * 2, kMaxBufferSize);
+        }
+        else if (allowed == buffer_size && bytes_transferred < buffer_size / 4)
+            buffer_size = std::max(buffer_size / 2, kMinBufferSize);
+
+        session->consumeBytes(bytes_transferred);
+        session->statistics_->addBytes(source, bytes_transferred);
+        session->bytes_transferred_ += bytes_transferred;
+        session->last_activity_time_ = Clock::now();
+
+        asio::async_write(
+            session->socket_[(source + kNumberOfSides - 1) % kNumberOfSides],
+            asio::const_buffer(buffer.data(), bytes_transferred),
+            base::makeAllocatingHandler(session->handler_memory_[source],
+                [session, source](const std::error_code& error_code, size_t /* bytes_transferred */)
+        {
+            if (error_code)
+            {
+                if (error_code != asio::error::operation_aborted)
+                    session->onErrorOccurred(FROM_HERE, error_code);
+            }
+            else
+            {
+                base::BufferPool::instance()->release(std::move(session->buffer_[source]));
+                session->buffer_memory_[source].set(0);
+                doReadSome(session, source);
+            }
+        }));
+    }));
+
+    session->setIdle(source);
+}
+
+#if defined(OS_LINUX)
+
+bool Session::initSplice()
+{
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        if (pipe2(pipe_[i], O_NONBLOCK | O_CLOEXEC) == -1)
+        {
+            PLOG(LS_WARNING) << "pipe2 failed";
+            return false;
+        }
+    }
+
+    std::error_code error_code;
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        // splice() is called directly for the native sockets and must not block.
+        socket_[i].native_non_blocking(true, error_code);
+        if (error_code)
+        {
+            LOG(LS_WARNING) << "Failed to set non-blocking mode: "
+                            << base::utf16FromLocal8Bit(error_code.message());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// static
+void Session::doSplice(Session* session, int source)
+{
+    if (session->released_)
+        return;
+
+    session->idle_[source] = false;
+
+    const int target = (source + kNumberOfSides - 1) % kNumberOfSides;
+    const int read_pipe = session->pipe_[source][0];
+    const int write_pipe = session->pipe_[source][1];
+
+    auto on_ready = base::makeAllocatingHandler(session->handler_memory_[source],
+                                                [session, source](const std::error_code& error_code)
     {
         if (error_code)
         {
@@ -102,26 +340,214 @@ void Session::doReadSome(Session* session, int source)
         }
         else
         {
-            session->bytes_transferred_ += bytes_transferred;
-            session->start_idle_time_ = TimePoint();
+            doSplice(session, source);
+        }
+    });
+
+    TRACE_EVENT("relay", "Session::splice");
 
-            asio::async_write(
-                session->socket_[(source + kNumberOfSides - 1) % kNumberOfSides],
-                asio::const_buffer(session->buffer_[source].data(), bytes_transferred),
-                [session, source](const std::error_code& error_code, size_t bytes_transferred)
+    for (int i = 0; i < kMaxSpliceIterations; ++i)
+    {
+        // The data remaining in the pipe is written to the target socket first.
+        while (session->pipe_bytes_[source])
+        {
+            ssize_t written = splice(read_pipe, nullptr,
+                                     session->socket_[target].native_handle(), nullptr,
+                                     session->pipe_bytes_[source],
+                                     SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (written == -1)
             {
-                if (error_code)
-                {
-                    if (error_code != asio::error::operation_aborted)
-                        session->onErrorOccurred(FROM_HERE, error_code);
-                }
-                else
+                if (errno == EAGAIN)
                 {
-                    doReadSome(session, source);
+                    session->socket_[target].async_wait(
+                        asio::ip::tcp::socket::wait_write, std::move(on_ready));
+                    return;
                 }
-            });
+
+                session->onErrorOccurred(
+                    FROM_HERE, std::error_code(errno, std::system_category()));
+                return;
+            }
+
+            session->pipe_bytes_[source] -= static_cast<size_t>(written);
         }
-    });
+
+        const size_t allowed = session->allowedBytes(session->pipe_size_[source]);
+        if (!allowed)
+        {
+            doWaitBandwidth(session, source, &Session::doSplice);
+            return;
+        }
+
+        ssize_t bytes_read = splice(session->socket_[source].native_handle(), nullptr,
+                                    write_pipe, nullptr,
+                                    allowed,
+                                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (bytes_read == -1)
+        {
+            if (errno == EAGAIN)
+            {
+                session->socket_[source].async_wait(
+                    asio::ip::tcp::socket::wait_read, std::move(on_ready));
+                session->setIdle(source);
+                return;
+            }
+
+            session->onErrorOccurred(FROM_HERE, std::error_code(errno, std::system_category()));
+            return;
+        }
+
+        if (!bytes_read)
+        {
+            // The peer closed the connection.
+            session->onErrorOccurred(FROM_HERE, asio::error::eof);
+            return;
+        }
+
+        if (static_cast<size_t>(bytes_read) == session->pipe_size_[source])
+        {
+            session->statistics_->addBufferFull();
+            session->growPipe(source);
+        }
+
+        session->consumeBytes(static_cast<size_t>(bytes_read));
+        session->statistics_->addBytes(source, static_cast<size_t>(bytes_read));
+        session->pipe_bytes_[source] += static_cast<size_t>(bytes_read);
+        session->bytes_transferred_ += bytes_read;
+        session->last_activity_time_ = Clock::now();
+    }
+
+    // The direction is busy. The operation is continued through the event loop, so that other
+    // sessions get their turn.
+    if (session->pipe_bytes_[source])
+    {
+        session->socket_[target].async_wait(
+            asio::ip::tcp::socket::wait_write, std::move(on_ready));
+    }
+    else
+    {
+        session->socket_[source].async_wait(
+            asio::ip::tcp::socket::wait_read, std::move(on_ready));
+        session->setIdle(source);
+    }
+}
+
+void Session::growPipe(int source)
+{
+    if (!pipe_can_grow_[source] || pipe_size_[source] >= kMaxPipeSize)
+        return;
+
+    const size_t new_size = std::min(pipe_size_[source] * 4, kMaxPipeSize);
+
+    // The data in the pipe is kept when its size is changed.
+    const int result = fcntl(pipe_[source][1], F_SETPIPE_SZ, static_cast<int>(new_size));
+    if (result == -1)
+    {
+        // The limit of the pipe memory of the user is reached (see /proc/sys/fs/pipe-max-size and
+        // pipe-user-pages-soft). The direction continues with the current pipe.
+        PLOG(LS_WARNING) << "Unable to resize pipe to " << new_size << " bytes";
+        pipe_can_grow_[source] = false;
+        return;
+    }
+
+    pipe_size_[source] = static_cast<size_t>(result);
+}
+
+#endif // defined(OS_LINUX)
+
+size_t Session::allowedBytes(size_t wanted)
+{
+    if (!session_limit_ && !total_limit_)
+        return wanted;
+
+    const base::TokenBucket::TimePoint now = base::TokenBucket::Clock::now();
+    size_t allowed = wanted;
+
+    if (session_limit_)
+        allowed = std::min(allowed, session_limit_->available(now));
+    if (total_limit_)
+        allowed = std::min(allowed, total_limit_->available(now));
+
+    // Very small reads are not worth a system call. Reading is paused until more data is allowed.
+    if (allowed < std::min(wanted, kMinBufferSize))
+        return 0;
+
+    return allowed;
+}
+
+void Session::consumeBytes(size_t bytes)
+{
+    if (session_limit_)
+        session_limit_->consume(bytes);
+    if (total_limit_)
+        total_limit_->consume(bytes);
+}
+
+// static
+void Session::doWaitBandwidth(Session* session, int source, void(*callback)(Session*, int))
+{
+    const base::TokenBucket::TimePoint now = base::TokenBucket::Clock::now();
+    base::TokenBucket::Milliseconds delay(1);
+
+    if (session->session_limit_)
+        delay = std::max(delay, session->session_limit_->delay(kMinBufferSize, now));
+    if (session->total_limit_)
+        delay = std::max(delay, session->total_limit_->delay(kMinBufferSize, now));
+
+    session->limit_timer_[source].expires_after(delay);
+    session->limit_timer_[source].async_wait(base::makeAllocatingHandler(
+        session->handler_memory_[source],
+        [session, source, callback](const std::error_code& error_code)
+    {
+        if (session->released_)
+            return;
+
+        session->idle_[source] = false;
+
+        if (error_code)
+        {
+            if (error_code != asio::error::operation_aborted)
+                session->onErrorOccurred(FROM_HERE, error_code);
+            return;
+        }
+
+        callback(session, source);
+    }));
+
+    // Reading is paused before any data is read.
+    session->setIdle(source);
+}
+
+void Session::setIdle(int source)
+{
+    idle_[source] = true;
+
+    if (release_callback_)
+        tryRelease();
+}
+
+void Session::tryRelease()
+{
+    if (!release_callback_ || !idle_[0] || !idle_[1])
+        return;
+
+    // No data is in flight. The pending waits are cancelled, and their handlers do nothing.
+    std::error_code ignored_code;
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        limit_timer_[i].cancel(ignored_code);
+        socket_[i].cancel(ignored_code);
+    }
+
+    released_ = true;
+    delegate_ = nullptr;
+
+    LOG(LS_INFO) << "Session released (duration: " << duration().count()
+                 << " seconds, bytes transferred: " << bytesTransferred() << ")";
+
+    ReleaseCallback callback = std::move(release_callback_);
+    release_callback_ = nullptr;
+    callback(this);
 }
 
 void Session::onErrorOccurred(const base::Location& location, const std::error_code& error_code)
@@ -20,16 +20,27 @@
 #define RELAY__SESSION_H
 
 #include "base/macros_magic.h"
-
+#include "base/timer_wheel.h"
+#include "base/memory/byte_array.h"
+#include "base/memory/memory_accounting.h"
+#include "base/net/handler_allocator.h"
+#include "base/net/token_bucket.h"
+#include "build/build_config.h"
+#include "relay/statistics.h"
+
+#include <asio/high_resolution_timer.hpp>
 #include <asio/ip/tcp.hpp>
 
+#include <functional>
+
 namespace base {
 class Location;
 } // namespace base
 
 namespace relay {
 
-class Session
+// The session is an item of the idle timer wheel of SessionManager.
+class Session : public base::TimerWheel::Item
 {
 public:
     explicit Session(std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket>&& sockets);
@@ -46,26 +57,124 @@ public:
         virtual void onSessionFinished(Session* session) = 0;
     };
 
+    // Limits the speed of the session (in both directions, in bytes per second) and the total
+    // speed of all sessions that share |total_limit|. Zero or null means no limit. When a limit is
+    // reached, reading from the sockets is paused and no data is dropped. Must be called before
+    // start().
+    void setBandwidthLimit(uint32_t session_limit, std::shared_ptr<base::TokenBucket> total_limit);
+
+    // Creates a limit for |rate| bytes per second. Bursts are limited to 100 ms of data.
+    static std::shared_ptr<base::TokenBucket> createBandwidthLimit(int64_t rate);
+
+    // Sets the statistics of the relay which are updated by the session. Must be called before
+    // start().
+    void setStatistics(std::shared_ptr<Statistics> statistics);
+
+    // The session continues a session released for a hot restart (see HotRestart). If |inherited|
+    // is true, it was released by the previous process of the relay, which owns its key. Must be
+    // called before start().
+    void resume(const std::chrono::seconds& duration, int64_t bytes_transferred, bool inherited);
+    bool isInherited() const { return inherited_; }
+
     void start(Delegate* delegate);
     void stop();
 
+    // Stops the data transfer as soon as all data read from each peer is written to the opposite
+    // one and calls |callback|. After that, the sockets can be taken with takeSockets() and the
+    // transfer can be continued by another process. The callback can be called before release()
+    // returns.
+    using ReleaseCallback = std::function<void(Session* session)>;
+    void release(ReleaseCallback callback);
+
+    // The session continues the data transfer if it has not been released yet.
+    void cancelRelease();
+
+    std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket> takeSockets();
+
     std::chrono::seconds idleTime(const TimePoint& current_time) const;
     std::chrono::seconds duration() const;
     int64_t bytesTransferred() const;
 
 private:
     static void doReadSome(Session* session, int source);
+
+#if defined(OS_LINUX)
+    // Data is moved from one socket to another through a pipe with splice(), so it is not copied
+    // to the user space. If the pipes cannot be created, the data is copied through the buffers.
+    bool initSplice();
+    static void doSplice(Session* session, int source);
+    void growPipe(int source);
+#endif // defined(OS_LINUX)
+
+    // Returns the number of bytes which the limits allow to read now (not more than |wanted|).
+    // Returns zero if reading must be paused.
+    size_t allowedBytes(size_t wanted);
+    void consumeBytes(size_t bytes);
+
+    // Waits until the limits allow reading and calls |callback|.
+    static void doWaitBandwidth(Session* session, int source, void(*callback)(Session*, int));
+
+    // Called when the direction |source| waits for data to read and holds no data of the peer.
+    void setIdle(int source);
+    void tryRelease();
+
     void onErrorOccurred(const base::Location& location, const std::error_code& error_code);
 
     TimePoint start_time_;
-    mutable TimePoint start_idle_time_;
+    TimePoint last_activity_time_;
     int64_t bytes_transferred_ = 0;
+    std::chrono::seconds previous_duration_{ 0 };
+    bool inherited_ = false;
 
     static const int kNumberOfSides = 2;
-    static const int kBufferSize = 8192;
+
+    // The buffer of a direction grows while reads fill it completely and shrinks when reads
+    // are small.
+    static constexpr size_t kMinBufferSize = 4096;
+    static constexpr size_t kInitialBufferSize = 8192;
+    static constexpr size_t kMaxBufferSize = 256 * 1024;
 
     asio::ip::tcp::socket socket_[kNumberOfSides];
-    std::array<uint8_t, kBufferSize> buffer_[kNumberOfSides];
+
+    std::shared_ptr<base::TokenBucket> session_limit_;
+    std::shared_ptr<base::TokenBucket> total_limit_;
+    asio::high_resolution_timer limit_timer_[kNumberOfSides];
+
+    std::shared_ptr<Statistics> statistics_;
+
+    // Buffers are taken from the pool only while data is transferred, so idle sessions do not hold
+    // any buffers.
+    base::ByteArray buffer_[kNumberOfSides];
+    size_t buffer_size_[kNumberOfSides] = { kInitialBufferSize, kInitialBufferSize };
+    base::TrackedMemory buffer_memory_[kNumberOfSides] =
+        { base::TrackedMemory(base::MemoryTag::RELAY_BUFFERS),
+          base::TrackedMemory(base::MemoryTag::RELAY_BUFFERS) };
+
+    // Only one operation of a direction is pending at a time, so its handlers are allocated from
+    // the same block.
+    base::HandlerMemory handler_memory_[kNumberOfSides];
+
+#if defined(OS_LINUX)
+    // The pipe of a direction grows while splice() fills it completely, so a busy direction moves
+    // more data with each system call. Idle sessions keep the default size: the kernel limits the
+    // total size of the pipes of a user.
+    static constexpr size_t kInitialPipeSize = 65536;
+    static constexpr size_t kMaxPipeSize = 1024 * 1024;
+
+    // Pipe for each direction: the data read from the socket |source| is written to pipe_[source]
+    // and then from the pipe to the opposite socket.
+    int pipe_[kNumberOfSides][2];
+    size_t pipe_bytes_[kNumberOfSides] = { 0, 0 };
+    size_t pipe_size_[kNumberOfSides] = { kInitialPipeSize, kInitialPipeSize };
+    bool pipe_can_grow_[kNumberOfSides] = { true, true };
+    bool splice_ = false;
+#endif // defined(OS_LINUX)
+
+    // A direction is idle while it waits for data to read. The session can be released only when
+    // both directions are idle.
+    bool idle_[kNumberOfSides] = { false, false };
+    ReleaseCallback release_callback_;
+    bool released_ = false;
 
     Delegate* delegate_ = nullptr;
 
@@ -22,9 +22,13 @@
 #include "base/task_runner.h"
 #include "base/message_loop/message_loop.h"
 #include "base/message_loop/message_pump_asio.h"
+#include "base/net/tcp_congestion_control.h"
 #include "base/crypto/message_decryptor_openssl.h"
 #include "base/peer/host_id.h"
 #include "base/strings/unicode.h"
+#include "build/build_config.h"
+
+#include <algorithm>
 
 namespace relay {
 
@@ -32,6 +36,26 @@ namespace {
 
 const std::chrono::minutes kIdleTimerInterval { 1 };
 
+// A cascade which is not used during this time is removed. The router gives the peers 30 seconds to
+// use the key (see Controller).
+const std::chrono::seconds kCascadeTimeout { 60 };
+
+// Maximum number of pending sessions matched in one task. After that, other tasks of the thread
+// (like the data transfer of active sessions) get their turn.
+const size_t kMaxReadySessionsPerTask = 32;
+
+// Time for the sessions to finish the writes in progress when they are passed to another process
+// of the relay.
+const std::chrono::seconds kHandOffTimeout { 5 };
+
+// Returns the number of the idle timer intervals that cover |duration|.
+size_t idleTicks(const std::chrono::seconds& duration)
+{
+    const int64_t interval =
+        std::chrono::duration_cast<std::chrono::seconds>(kIdleTimerInterval).count();
+    return static_cast<size_t>((duration.count() + interval - 1) / interval);
+}
+
 // Decrypts an encrypted pair of peer identifiers using key |session_key|.
 base::ByteArray decryptSecret(const proto::PeerToRelay& message, const SharedPool::Key& key)
 {
@@ -68,45 +92,27 @@ base::ByteArray decryptSecret(const proto::PeerToRelay& message, const SharedPoo
     return target;
 }
 
-// Removes a session from the list and returns a pointer to it.
-template<class T>
-std::unique_ptr<T> removeSessionT(std::vector<std::unique_ptr<T>>* session_list, T* session)
-{
-    session->stop();
-
-    auto it = session_list->begin();
-    while (it != session_list->end())
-    {
-        if (it->get() == session)
-            break;
-
-        ++it;
-    }
-
-    if (it != session_list->end())
-    {
-        std::unique_ptr<T> result = std::move(*it);
-        session_list->erase(it);
-        return result;
-    }
-
-    return nullptr;
-}
-
 } // namespace
 
 SessionManager::SessionManager(std::shared_ptr<base::TaskRunner> task_runner,
                                uint16_t port,
-                               const std::chrono::minutes& idle_timeout)
+                               const std::chrono::minutes& idle_timeout,
+                               size_t index,
+                               size_t count)
     : task_runner_(std::move(task_runner)),
-      acceptor_(base::MessageLoop::current()->pumpAsio()->ioContext(),
-                asio::ip::tcp::endpoint(asio::ip::tcp::v4(), port)),
+      port_(port),
+      index_(index),
+      count_(count),
+      acceptor_(base::MessageLoop::current()->pumpAsio()->ioContext()),
       idle_timeout_(idle_timeout),
-      idle_timer_(base::MessageLoop::current()->pumpAsio()->ioContext())
+      idle_timer_(base::MessageLoop::current()->pumpAsio()->ioContext()),
+      idle_wheel_(idleTicks(idle_timeout) + 1),
+      hand_off_timer_(base::MessageLoop::current()->pumpAsio()->ioContext())
 {
     DCHECK(task_runner_);
+    DCHECK_LT(index_, count_);
 
-    LOG(LS_INFO) << "Session manager port: " << port;
+    LOG(LS_INFO) << "Session manager port: " << port << " (" << index_ << "/" << count_ << ")";
 }
 
 SessionManager::~SessionManager()
@@ -115,6 +121,7 @@ SessionManager::~SessionManager()
     acceptor_.cancel(ignored_code);
     acceptor_.close(ignored_code);
     idle_timer_.cancel();
+    hand_off_timer_.cancel();
 }
 
 void SessionManager::start(std::unique_ptr<SharedPool> shared_pool, Delegate* delegate)
@@ -124,67 +131,217 @@ void SessionManager::start(std::unique_ptr<SharedPool> shared_pool, Delegate* de
     shared_pool_ = std::move(shared_pool);
     delegate_ = delegate;
 
-    DCHECK(delegate_ && shared_pool_);
+    DCHECK(delegate_ && shared_pool_ && statistics_);
 
     idle_timer_.expires_after(kIdleTimerInterval);
     idle_timer_.async_wait(std::bind(&SessionManager::doIdleTimeout, this, std::placeholders::_1));
 
+#if !defined(OS_POSIX)
+    // Without SO_REUSEPORT, only one acceptor can listen on the port. The first manager accepts all
+    // connections and passes them to other managers.
+    if (index_ != 0)
+        return;
+#endif // !defined(OS_POSIX)
+
+    // The listening socket can be received from the previous process of the relay.
+    if (!acceptor_.is_open() && !listen())
+        return;
+
     SessionManager::doAccept(this);
 }
 
-void SessionManager::onPendingSessionReady(
-    PendingSession* session, const proto::PeerToRelay& message)
+void SessionManager::setBandwidthLimit(uint32_t session_limit,
+                                       std::shared_ptr<base::TokenBucket> total_limit)
 {
-    LOG(LS_INFO) << "Pending session ready for key_id: " << message.key_id();
+    session_bandwidth_limit_ = session_limit;
+    total_bandwidth_limit_ = std::move(total_limit);
+}
 
-    // Looking for a key with the specified identifier.
-    std::optional<SharedPool::Key> key = shared_pool_->key(message.key_id(), message.public_key());
-    if (key.has_value())
+void SessionManager::setCongestionControl(const std::string& algorithm)
+{
+    congestion_control_ = algorithm;
+}
+
+void SessionManager::setStatistics(std::shared_ptr<Statistics> statistics)
+{
+    statistics_ = std::move(statistics);
+}
+
+void SessionManager::addPendingSession(asio::ip::tcp::socket::native_handle_type socket,
+                                       const proto::PeerToRelay& message)
+{
+    asio::ip::tcp::socket pending_socket(base::MessageLoop::current()->pumpAsio()->ioContext());
+
+    std::error_code error_code;
+    pending_socket.assign(asio::ip::tcp::v4(), socket, error_code);
+    if (error_code)
     {
-        // Decrypt the identifiers of peers.
-        base::ByteArray secret = decryptSecret(message, key.value());
-        if (!secret.empty())
-        {
-            // Save the identifiers of peers and the identifier of their shared key.
-            session->setIdentify(message.key_id(), secret);
+        LOG(LS_ERROR) << "Failed to assign socket: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        return;
+    }
 
-            // Trying to find a peer that wants to be connected.
-            for (auto& other_session : pending_sessions_)
-            {
-                if (session->isPeerFor(*other_session))
-                {
-                    LOG(LS_INFO) << "Both peers are connected with key " << message.key_id();
-
-                    // Delete the key from the pool. It can no longer be used.
-                    shared_pool_->removeKey(message.key_id());
-
-                    // Now the opposite peer is found, start the data transfer between them.
-                    active_sessions_.emplace_back(std::make_unique<Session>(
-                        std::make_pair(session->takeSocket(), other_session->takeSocket())));
-                    active_sessions_.back()->start(this);
-
-                    // Pending sessions are no longer needed, remove them.
-                    removePendingSession(other_session.get());
-                    removePendingSession(session);
-                    return;
-                }
-            }
+    std::unique_ptr<PendingSession> pending_session = std::make_unique<PendingSession>(
+        task_runner_, std::move(pending_socket), this);
+    PendingSession* pending_session_ptr = pending_session.get();
 
-            LOG(LS_INFO) << "Second peer has not connected yet";
-            return;
+    pending_sessions_.emplace(pending_session_ptr, std::move(pending_session));
+    statistics_->addPendingSession();
+    pending_session_ptr->start(message);
+}
+
+void SessionManager::addCascade(const proto::RelayCascade& cascade)
+{
+    LOG(LS_INFO) << "Cascade for key " << cascade.key_id() << " to " << cascade.next().host()
+                 << ":" << cascade.next().port();
+
+    // If the peer is already waiting, it is connected to the next relay right away.
+    auto waiting = waiting_sessions_.find(cascade.key_id());
+    if (waiting != waiting_sessions_.end())
+    {
+        PendingSession* session = waiting->second;
+        waiting_sessions_.erase(waiting);
+
+        startCascade(session, cascade.next());
+        return;
+    }
+
+    Cascade& item = cascades_[cascade.key_id()];
+
+    item.next = cascade.next();
+    item.expire_time = std::chrono::steady_clock::now() + kCascadeTimeout;
+}
+
+void SessionManager::setListener(HotRestartState::NativeSocket listener)
+{
+    std::error_code error_code;
+    acceptor_.assign(asio::ip::tcp::v4(), listener, error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Failed to assign listener: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        return;
+    }
+
+    // The manager is already started.
+    if (delegate_)
+        SessionManager::doAccept(this);
+}
+
+void SessionManager::addSession(const HotRestartState::Session& session)
+{
+    asio::io_context& io_context = base::MessageLoop::current()->pumpAsio()->ioContext();
+    asio::ip::tcp::socket first(io_context);
+    asio::ip::tcp::socket second(io_context);
+
+    std::error_code error_code;
+    first.assign(asio::ip::tcp::v4(), session.sockets[0], error_code);
+    if (!error_code)
+        second.assign(asio::ip::tcp::v4(), session.sockets[1], error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Failed to assign socket: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        return;
+    }
+
+    std::unique_ptr<Session> active_session =
+        std::make_unique<Session>(std::make_pair(std::move(first), std::move(second)));
+    active_session->resume(session.duration, session.bytes_transferred, session.inherited);
+
+    startActiveSession(std::move(active_session));
+}
+
+void SessionManager::handOff(HandOffCallback callback)
+{
+    LOG(LS_INFO) << "Hand off (active sessions: " << active_sessions_.size()
+                 << ", pending sessions: " << pending_sessions_.size() << ")";
+
+    DCHECK(!hand_off_callback_);
+    hand_off_callback_ = std::move(callback);
+
+    if (acceptor_.is_open())
+    {
+        std::error_code error_code;
+        HotRestartState::NativeSocket listener = acceptor_.release(error_code);
+        if (error_code)
+        {
+            LOG(LS_ERROR) << "Failed to release listener: "
+                          << base::utf16FromLocal8Bit(error_code.message());
         }
         else
         {
-            LOG(LS_WARNING) << "Failed to decrypt shared secret. Connection will be completed";
+            hand_off_state_.listeners.emplace_back(listener);
         }
     }
-    else
+
+    std::vector<PendingSession*> pending_sessions;
+    for (const auto& pending_session : pending_sessions_)
+        pending_sessions.emplace_back(pending_session.first);
+
+    for (PendingSession* pending_session : pending_sessions)
+        removePendingSession(pending_session);
+
+    // A session can be released right away, so the list is copied.
+    std::vector<Session*> sessions;
+    for (const auto& session : active_sessions_)
+        sessions.emplace_back(session.first);
+
+    for (Session* session : sessions)
     {
-        LOG(LS_WARNING) << "Key with id " << message.key_id() << " NOT found!";
+        session->release(
+            std::bind(&SessionManager::onSessionReleased, this, std::placeholders::_1));
     }
 
-    // The key was not found in the pool.
-    removePendingSession(session);
+    if (!hand_off_callback_)
+        return;
+
+    hand_off_timer_.expires_after(kHandOffTimeout);
+    hand_off_timer_.async_wait([this](const std::error_code& error_code)
+    {
+        if (error_code != asio::error::operation_aborted)
+            finishHandOff();
+    });
+
+    checkHandOffFinished();
+}
+
+void SessionManager::onPendingSessionReady(
+    PendingSession* session, const proto::PeerToRelay& message)
+{
+    LOG(LS_INFO) << "Pending session ready for key_id: " << message.key_id();
+
+    if (session->handshakeLatency().has_value())
+        statistics_->addHandshake(session->handshakeLatency().value());
+
+    // Both peers use the same key, so they always meet in the same manager.
+    const size_t index = message.key_id() % count_;
+    if (index != index_)
+    {
+        asio::ip::tcp::socket socket = session->takeSocket();
+        removePendingSession(session);
+
+        std::error_code error_code;
+        asio::ip::tcp::socket::native_handle_type native_socket = socket.release(error_code);
+        if (error_code)
+        {
+            LOG(LS_ERROR) << "Failed to release socket: "
+                          << base::utf16FromLocal8Bit(error_code.message());
+            return;
+        }
+
+        if (delegate_)
+            delegate_->onPendingSessionMoved(index, native_socket, message);
+        return;
+    }
+
+    // The key checks and the matching of peers are done in batches, so that a lot of peers which
+    // connect at the same time do not block the thread for long.
+    ready_sessions_.emplace_back(session, message);
+    queued_sessions_.insert(session);
+
+    if (ready_sessions_.size() == 1)
+        task_runner_->postTask(std::bind(&SessionManager::processReadySessions, this));
 }
 
 void SessionManager::onPendingSessionFailed(PendingSession* session)
@@ -192,11 +349,275 @@ void SessionManager::onPendingSessionFailed(PendingSession* session)
     removePendingSession(session);
 }
 
+void SessionManager::onCascadeConnected(CascadeConnector* connector)
+{
+    PendingSession* session = connector->pendingSession();
+    session->trace().addStage("Connected to next relay");
+
+    asio::ip::tcp::socket socket = connector->takeSocket();
+    if (!congestion_control_.empty())
+        base::setTcpCongestionControl(socket.native_handle(), congestion_control_);
+
+    startSession(session, std::move(socket));
+}
+
+void SessionManager::onCascadeFailed(CascadeConnector* connector)
+{
+    removePendingSession(connector->pendingSession());
+}
+
 void SessionManager::onSessionFinished(Session* session)
 {
     removeSession(session);
 }
 
+void SessionManager::processReadySessions()
+{
+    for (size_t i = 0; i < kMaxReadySessionsPerTask && !ready_sessions_.empty(); ++i)
+    {
+        std::pair<PendingSession*, proto::PeerToRelay> ready = std::move(ready_sessions_.front());
+        ready_sessions_.pop_front();
+        queued_sessions_.erase(ready.first);
+
+        matchPendingSession(ready.first, ready.second);
+    }
+
+    if (!ready_sessions_.empty())
+        task_runner_->postTask(std::bind(&SessionManager::processReadySessions, this));
+}
+
+void SessionManager::matchPendingSession(
+    PendingSession* session, const proto::PeerToRelay& message)
+{
+    // Looking for a key with the specified identifier.
+    std::optional<SharedPool::Key> key = shared_pool_->key(message.key_id(), message.public_key());
+    if (!key.has_value())
+    {
+        LOG(LS_WARNING) << "Key with id " << message.key_id() << " NOT found!";
+        removePendingSession(session);
+        return;
+    }
+
+    // Decrypt the identifiers of peers.
+    base::ByteArray secret = decryptSecret(message, key.value());
+    if (secret.empty())
+    {
+        LOG(LS_WARNING) << "Failed to decrypt shared secret. Connection will be completed";
+        removePendingSession(session);
+        return;
+    }
+
+    // Save the identifiers of peers and the identifier of their shared key.
+    session->setIdentify(message.key_id(), secret, message.trace_id());
+
+    // The opposite peer is served by another relay.
+    auto cascade = cascades_.find(message.key_id());
+    if (cascade != cascades_.end())
+    {
+        proto::RelayCredentials next = std::move(cascade->second.next);
+        cascades_.erase(cascade);
+
+        startCascade(session, next);
+        return;
+    }
+
+    // Trying to find a peer that wants to be connected.
+    auto range = waiting_sessions_.equal_range(message.key_id());
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        PendingSession* other_session = it->second;
+        if (!session->isPeerFor(*other_session))
+            continue;
+
+        LOG(LS_INFO) << "Both peers are connected with key " << message.key_id();
+
+        // The time the first peer has waited for the second one.
+        statistics_->addPairing(other_session->trace().elapsed());
+        session->trace().addStage("Peers paired by relay");
+
+        asio::ip::tcp::socket other_socket = other_session->takeSocket();
+        removePendingSession(other_session);
+
+        startSession(session, std::move(other_socket));
+        return;
+    }
+
+    LOG(LS_INFO) << "Second peer has not connected yet";
+    waiting_sessions_.emplace(message.key_id(), session);
+}
+
+void SessionManager::startCascade(PendingSession* session, const proto::RelayCredentials& next)
+{
+    std::unique_ptr<CascadeConnector> connector = std::make_unique<CascadeConnector>(
+        base::MessageLoop::current()->pumpAsio()->ioContext(), session, this);
+    CascadeConnector* connector_ptr = connector.get();
+
+    cascade_connectors_.emplace(session, std::move(connector));
+    connector_ptr->start(next);
+}
+
+void SessionManager::startSession(PendingSession* session, asio::ip::tcp::socket&& other_socket)
+{
+    // Delete the key from the pool. It can no longer be used.
+    shared_pool_->removeKey(session->keyId());
+
+    // Now the opposite peer is found, start the data transfer between them.
+    startActiveSession(std::make_unique<Session>(
+        std::make_pair(session->takeSocket(), std::move(other_socket))));
+
+    // The pending session is no longer needed, remove it.
+    removePendingSession(session);
+}
+
+void SessionManager::startActiveSession(std::unique_ptr<Session> session)
+{
+    Session* session_ptr = session.get();
+
+    session_ptr->setBandwidthLimit(session_bandwidth_limit_, total_bandwidth_limit_);
+    session_ptr->setStatistics(statistics_);
+    statistics_->addActiveSession();
+
+    active_sessions_.emplace(session_ptr, std::move(session));
+    idle_wheel_.schedule(session_ptr, idleTicks(idle_timeout_));
+    session_ptr->start(this);
+}
+
+void SessionManager::onSessionReleased(Session* session)
+{
+    std::pair<asio::ip::tcp::socket, asio::ip::tcp::socket> sockets = session->takeSockets();
+
+    std::error_code error_code;
+    HotRestartState::Session state;
+    state.sockets[0] = sockets.first.release(error_code);
+    if (!error_code)
+        state.sockets[1] = sockets.second.release(error_code);
+
+    if (error_code)
+    {
+        // The sockets which are not released are closed with the session.
+        LOG(LS_ERROR) << "Failed to release socket: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        if (!sockets.first.is_open())
+            sockets.first.assign(asio::ip::tcp::v4(), state.sockets[0], error_code);
+    }
+    else
+    {
+        state.duration = session->duration();
+        state.bytes_transferred = session->bytesTransferred();
+        state.inherited = session->isInherited();
+        hand_off_state_.sessions.emplace_back(state);
+    }
+
+    base::TimerWheel::cancel(session);
+
+    auto it = active_sessions_.find(session);
+    if (it != active_sessions_.end())
+    {
+        statistics_->removeActiveSession(session->bytesTransferred(), session->duration());
+        task_runner_->deleteSoon(std::move(it->second));
+        active_sessions_.erase(it);
+    }
+
+    checkHandOffFinished();
+}
+
+void SessionManager::checkHandOffFinished()
+{
+    if (hand_off_callback_ && active_sessions_.empty())
+        finishHandOff();
+}
+
+void SessionManager::finishHandOff()
+{
+    hand_off_timer_.cancel();
+
+    // Sessions which are busy writing stay here.
+    for (const auto& session : active_sessions_)
+        session.first->cancelRelease();
+
+    LOG(LS_INFO) << "Hand off finished (released sessions: " << hand_off_state_.sessions.size()
+                 << ", remaining sessions: " << active_sessions_.size() << ")";
+
+    HandOffCallback callback = std::move(hand_off_callback_);
+    hand_off_callback_ = nullptr;
+
+    callback(std::move(hand_off_state_), active_sessions_.size());
+    hand_off_state_ = HotRestartState();
+}
+
+void SessionManager::removeExpiredCascades()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    auto it = cascades_.begin();
+    while (it != cascades_.end())
+    {
+        if (it->second.expire_time <= now)
+            it = cascades_.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool SessionManager::listen()
+{
+    asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port_);
+    std::error_code error_code;
+
+    acceptor_.open(endpoint.protocol(), error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Failed to open acceptor: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+    acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true), error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Failed to set reuse address: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+#if defined(OS_POSIX)
+    if (count_ > 1)
+    {
+        // Each manager has its own acceptor on the same port.
+        using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+        acceptor_.set_option(reuse_port(true), error_code);
+        if (error_code)
+        {
+            LOG(LS_ERROR) << "Failed to set reuse port: "
+                          << base::utf16FromLocal8Bit(error_code.message());
+            return false;
+        }
+    }
+#endif // defined(OS_POSIX)
+
+    // The algorithm is not required, the relay works with the default one.
+    if (!congestion_control_.empty())
+        base::setTcpCongestionControl(acceptor_.native_handle(), congestion_control_);
+
+    acceptor_.bind(endpoint, error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Failed to bind acceptor: "
+                      << base::utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+    acceptor_.listen(asio::socket_base::max_listen_connections, error_code);
+    if (error_code)
+    {
+        LOG(LS_ERROR) << "Failed to listen: " << base::utf16FromLocal8Bit(error_code.message());
+        return false;
+    }
+
+    return true;
+}
+
 // static
 void SessionManager::doAccept(SessionManager* self)
 {
@@ -208,10 +629,16 @@ void SessionManager::doAccept(SessionManager* self)
             LOG(LS_INFO) << "New accepted connection: " << base::utf16FromLocal8Bit(
                 socket.remote_endpoint().address().to_string());
 
+            self->statistics_->addAcceptedConnection();
+
             // A new peer is connected. Create and start the pending session.
-            self->pending_sessions_.emplace_back(std::make_unique<PendingSession>(
-                self->task_runner_, std::move(socket), self));
-            self->pending_sessions_.back()->start();
+            std::unique_ptr<PendingSession> pending_session = std::make_unique<PendingSession>(
+                self->task_runner_, std::move(socket), self);
+            PendingSession* pending_session_ptr = pending_session.get();
+
+            self->pending_sessions_.emplace(pending_session_ptr, std::move(pending_session));
+            self->statistics_->addPendingSession();
+            pending_session_ptr->start();
         }
         else
         {
@@ -241,23 +668,36 @@ void SessionManager::doIdleTimeoutImpl(const std::error_code& error_code)
     if (!error_code)
     {
         auto current_time = Session::Clock::now();
-        auto it = active_sessions_.begin();
         int count = 0;
 
-        while (it != active_sessions_.end())
+        // Only the sessions whose idle timeout could expire by now are checked. Sessions that have
+        // been active since they were scheduled get their next check at the time when the timeout
+        // would expire after the last activity.
+        for (base::TimerWheel::Item* item : idle_wheel_.advance())
         {
-            if ((*it)->idleTime(current_time) >= idle_timeout_)
+            Session* session = static_cast<Session*>(item);
+
+            const std::chrono::seconds idle_time = session->idleTime(current_time);
+            if (idle_time >= idle_timeout_)
             {
-                it = active_sessions_.erase(it);
+                statistics_->removeActiveSession(session->bytesTransferred(), session->duration());
+                active_sessions_.erase(session);
                 ++count;
             }
             else
             {
-                ++it;
+                idle_wheel_.schedule(session, idleTicks(idle_timeout_ - idle_time));
             }
         }
 
-        LOG(LS_INFO) << "Sessions ended by timeout: " << count;
+        if (count)
+        {
+            LOG(LS_INFO) << "Sessions ended by timeout: " << count;
+            statistics_->addIdleEvictions(count);
+            checkHandOffFinished();
+        }
+
+        removeExpiredCascades();
     }
     else
     {
@@ -270,15 +710,65 @@ void SessionManager::doIdleTimeoutImpl(const std::error_code& error_code)
 
 void SessionManager::removePendingSession(PendingSession* session)
 {
-    task_runner_->deleteSoon(removeSessionT(&pending_sessions_, session));
+    session->stop();
+
+    // A session is rarely removed while it waits for the matching (for example, by the timeout).
+    if (queued_sessions_.erase(session))
+    {
+        auto it = std::find_if(ready_sessions_.begin(), ready_sessions_.end(),
+            [session](const std::pair<PendingSession*, proto::PeerToRelay>& ready)
+        {
+            return ready.first == session;
+        });
+        if (it != ready_sessions_.end())
+            ready_sessions_.erase(it);
+    }
+
+    auto range = waiting_sessions_.equal_range(session->keyId());
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == session)
+        {
+            waiting_sessions_.erase(it);
+            break;
+        }
+    }
+
+    auto connector = cascade_connectors_.find(session);
+    if (connector != cascade_connectors_.end())
+    {
+        connector->second->stop();
+        task_runner_->deleteSoon(std::move(connector->second));
+        cascade_connectors_.erase(connector);
+    }
+
+    auto it = pending_sessions_.find(session);
+    if (it != pending_sessions_.end())
+    {
+        statistics_->removePendingSession();
+        task_runner_->deleteSoon(std::move(it->second));
+        pending_sessions_.erase(it);
+    }
 }
 
 void SessionManager::removeSession(Session* session)
 {
-    task_runner_->deleteSoon(removeSessionT(&active_sessions_, session));
+    session->stop();
+    base::TimerWheel::cancel(session);
 
-    if (delegate_)
+    auto it = active_sessions_.find(session);
+    if (it != active_sessions_.end())
+    {
+        statistics_->removeActiveSession(session->bytesTransferred(), session->duration());
+        task_runner_->deleteSoon(std::move(it->second));
+        active_sessions_.erase(it);
+    }
+
+    // The key of an inherited session belongs to the previous process of the relay.
+    if (delegate_ && !session->isInherited())
         delegate_->onSessionFinished();
+
+    checkHandOffFinished();
 }
 
 } // namespace relay
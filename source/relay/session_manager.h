@@ -19,13 +19,22 @@
 #ifndef RELAY__SESSION_MANAGER_H
 #define RELAY__SESSION_MANAGER_H
 
+#include "base/timer_wheel.h"
 #include "proto/relay_peer.pb.h"
+#include "proto/router_relay.pb.h"
+#include "relay/cascade_connector.h"
+#include "relay/hot_restart.h"
 #include "relay/pending_session.h"
 #include "relay/session.h"
 #include "relay/shared_pool.h"
 
 #include <asio/high_resolution_timer.hpp>
 
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace base {
 class TaskRunner;
 } // namespace base
@@ -34,6 +43,7 @@ namespace relay {
 
 class SessionManager
     : public PendingSession::Delegate,
+      public CascadeConnector::Delegate,
       public Session::Delegate
 {
 public:
@@ -43,41 +53,140 @@ public:
         virtual ~Delegate() = default;
 
         virtual void onSessionFinished() = 0;
+
+        // Called when a peer with the key that belongs to the manager |index| is connected to this
+        // manager. The socket is released from the manager and must be passed to
+        // addPendingSession() of the manager |index|.
+        virtual void onPendingSessionMoved(size_t index,
+                                           asio::ip::tcp::socket::native_handle_type socket,
+                                           const proto::PeerToRelay& message) = 0;
     };
 
+    // Sessions can be served by several managers on different threads. Each of them has its own
+    // acceptor on the same port (the system distributes connections between them), and both peers
+    // of a session are brought to the manager that is chosen by the key of the session. |index|
+    // is the number of the manager and |count| is the number of managers.
     SessionManager(std::shared_ptr<base::TaskRunner> task_runner,
                    uint16_t port,
-                   const std::chrono::minutes& idle_timeout);
+                   const std::chrono::minutes& idle_timeout,
+                   size_t index = 0,
+                   size_t count = 1);
     ~SessionManager();
 
     void start(std::unique_ptr<SharedPool> shared_pool, Delegate* delegate);
 
+    // Sets the bandwidth limits for new sessions (see Session::setBandwidthLimit).
+    void setBandwidthLimit(uint32_t session_limit, std::shared_ptr<base::TokenBucket> total_limit);
+
+    // Sets the congestion control algorithm of the peer connections. It is set for the acceptor
+    // (the accepted sockets inherit it) and for the connections to the next relays. If empty, the
+    // default algorithm of the system is used. Must be called before start().
+    void setCongestionControl(const std::string& algorithm);
+
+    // Sets the statistics of the relay. Must be called before start().
+    void setStatistics(std::shared_ptr<Statistics> statistics);
+
+    // Adds a peer which has been connected to another manager (see
+    // Delegate::onPendingSessionMoved).
+    void addPendingSession(asio::ip::tcp::socket::native_handle_type socket,
+                           const proto::PeerToRelay& message);
+
+    // The peer with the key of |cascade| is connected to the next relay instead of a local peer.
+    void addCascade(const proto::RelayCascade& cascade);
+
+    // Accepts connections on |listener| received from another process of the relay (see
+    // HotRestart). If called before start(), start() does not create a listening socket.
+    void setListener(HotRestartState::NativeSocket listener);
+
+    // Continues a session received from another process of the relay.
+    void addSession(const HotRestartState::Session& session);
+
+    // Stops accepting connections and passes the listening socket and the sockets of the active
+    // sessions to |callback|. Pending sessions are closed, their peers connect again. A session is
+    // passed when no data of it is in flight (see Session::release). The sessions which are not
+    // released within kHandOffTimeout stay in the manager until they are finished, their number
+    // is passed in |remaining|.
+    using HandOffCallback = std::function<void(HotRestartState&& state, size_t remaining)>;
+    void handOff(HandOffCallback callback);
+
 protected:
     // PendingSession::Delegate implementation.
     void onPendingSessionReady(
         PendingSession* session, const proto::PeerToRelay& message) override;
     void onPendingSessionFailed(PendingSession* session) override;
 
+    // CascadeConnector::Delegate implementation.
+    void onCascadeConnected(CascadeConnector* connector) override;
+    void onCascadeFailed(CascadeConnector* connector) override;
+
     // Session::Delegate implementation.
     void onSessionFinished(Session* session) override;
 
 private:
+    bool listen();
     static void doAccept(SessionManager* self);
     static void doIdleTimeout(SessionManager* self, const std::error_code& error_code);
     void doIdleTimeoutImpl(const std::error_code& error_code);
 
-    void removePendingSession(PendingSession* sessions);
+    void processReadySessions();
+    void matchPendingSession(PendingSession* session, const proto::PeerToRelay& message);
+    void startCascade(PendingSession* session, const proto::RelayCredentials& next);
+    void startSession(PendingSession* session, asio::ip::tcp::socket&& other_socket);
+    void removeExpiredCascades();
+
+    void startActiveSession(std::unique_ptr<Session> session);
+    void onSessionReleased(Session* session);
+    void checkHandOffFinished();
+    void finishHandOff();
+
+    void removePendingSession(PendingSession* session);
     void removeSession(Session* session);
 
     std::shared_ptr<base::TaskRunner> task_runner_;
 
+    const uint16_t port_;
+    const size_t index_;
+    const size_t count_;
+
     asio::ip::tcp::acceptor acceptor_;
-    std::vector<std::unique_ptr<PendingSession>> pending_sessions_;
-    std::vector<std::unique_ptr<Session>> active_sessions_;
+    std::unordered_map<PendingSession*, std::unique_ptr<PendingSession>> pending_sessions_;
+
+    // Sessions which have received the authentication data and wait for the matching.
+    std::deque<std::pair<PendingSession*, proto::PeerToRelay>> ready_sessions_;
+    std::unordered_set<PendingSession*> queued_sessions_;
 
+    // Identified sessions which wait for the opposite peer, by the key identifier.
+    std::unordered_multimap<uint32_t, PendingSession*> waiting_sessions_;
+
+    // Cascades by the key identifier. A cascade is received from the router before or after the
+    // peer is connected.
+    struct Cascade
+    {
+        proto::RelayCredentials next;
+        std::chrono::steady_clock::time_point expire_time;
+    };
+    std::unordered_map<uint32_t, Cascade> cascades_;
+
+    // Connections to the next relays for the pending sessions.
+    std::unordered_map<PendingSession*, std::unique_ptr<CascadeConnector>> cascade_connectors_;
+
+    std::unordered_map<Session*, std::unique_ptr<Session>> active_sessions_;
+
+    // Active sessions are scheduled in the wheel to be checked when their idle timeout expires.
+    // One tick of the wheel is one interval of the idle timer.
     const std::chrono::minutes idle_timeout_;
     asio::high_resolution_timer idle_timer_;
+    base::TimerWheel idle_wheel_;
+
+    uint32_t session_bandwidth_limit_ = 0;
+    std::shared_ptr<base::TokenBucket> total_bandwidth_limit_;
+    std::string congestion_control_;
+
+    HandOffCallback hand_off_callback_;
+    HotRestartState hand_off_state_;
+    asio::high_resolution_timer hand_off_timer_;
 
+    std::shared_ptr<Statistics> statistics_;
     std::unique_ptr<SharedPool> shared_pool_;
     Delegate* delegate_ = nullptr;
 
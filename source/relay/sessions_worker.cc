@@ -24,9 +24,13 @@ namespace relay {
 
 SessionsWorker::SessionsWorker(uint16_t peer_port,
                                const std::chrono::minutes& peer_idle_timeout,
-                               std::unique_ptr<SharedPool> shared_pool)
+                               std::unique_ptr<SharedPool> shared_pool,
+                               size_t index,
+                               size_t count)
     : peer_port_(peer_port),
       peer_idle_timeout_(peer_idle_timeout),
+      index_(index),
+      count_(count),
       shared_pool_(std::move(shared_pool)),
       thread_(std::make_unique<base::Thread>())
 {
@@ -35,11 +39,28 @@ SessionsWorker::SessionsWorker(uint16_t peer_port,
 
 SessionsWorker::~SessionsWorker()
 {
-    thread_->stop();
+    stop();
+}
+
+void SessionsWorker::setBandwidthLimit(uint32_t session_limit,
+                                       std::shared_ptr<base::TokenBucket> total_limit)
+{
+    session_bandwidth_limit_ = session_limit;
+    total_bandwidth_limit_ = std::move(total_limit);
+}
+
+void SessionsWorker::setCongestionControl(const std::string& algorithm)
+{
+    congestion_control_ = algorithm;
+}
+
+void SessionsWorker::setStatistics(std::shared_ptr<Statistics> statistics)
+{
+    statistics_ = std::move(statistics);
 }
 
 void SessionsWorker::start(std::shared_ptr<base::TaskRunner> caller_task_runner,
-                           SessionManager::Delegate* delegate)
+                           Delegate* delegate)
 {
     caller_task_runner_ = std::move(caller_task_runner);
     delegate_ = delegate;
@@ -50,18 +71,109 @@ void SessionsWorker::start(std::shared_ptr<base::TaskRunner> caller_task_runner,
     thread_->start(base::MessageLoop::Type::ASIO, this);
 }
 
+void SessionsWorker::startAccepting(const std::vector<SessionsWorker*>& workers)
+{
+    DCHECK(self_task_runner_);
+    DCHECK_EQ(workers.size(), count_);
+
+    // The list is filled before the task is posted and is only read by the thread of the worker.
+    workers_ = workers;
+
+    self_task_runner_->postTask([this]()
+    {
+        session_manager_->start(std::move(shared_pool_), this);
+    });
+}
+
+void SessionsWorker::addCascade(const proto::RelayCascade& cascade)
+{
+    self_task_runner_->postTask([this, cascade]()
+    {
+        if (session_manager_)
+            session_manager_->addCascade(cascade);
+    });
+}
+
+void SessionsWorker::adoptState(HotRestartState&& state)
+{
+    DCHECK(self_task_runner_);
+    DCHECK_LE(state.listeners.size(), 1U);
+
+    self_task_runner_->postTask([this, state = std::move(state)]()
+    {
+        if (!session_manager_)
+            return;
+
+        if (!state.listeners.empty())
+            session_manager_->setListener(state.listeners.front());
+
+        for (const HotRestartState::Session& session : state.sessions)
+            session_manager_->addSession(session);
+    });
+}
+
+void SessionsWorker::handOff(SessionManager::HandOffCallback callback)
+{
+    self_task_runner_->postTask([this, callback = std::move(callback)]() mutable
+    {
+        if (!session_manager_)
+            return;
+
+        session_manager_->handOff(
+            [this, callback = std::move(callback)](HotRestartState&& state, size_t remaining)
+        {
+            caller_task_runner_->postTask(
+                [callback, state = std::move(state), remaining]() mutable
+            {
+                callback(std::move(state), remaining);
+            });
+        });
+    });
+}
+
+void SessionsWorker::stop()
+{
+    thread_->stop();
+}
+
+base::LatencyHistogram::Snapshot SessionsWorker::lag() const
+{
+    std::scoped_lock lock(lag_probe_lock_);
+
+    if (!lag_probe_)
+        return base::LatencyHistogram::Snapshot();
+
+    return lag_probe_->snapshot();
+}
+
 void SessionsWorker::onBeforeThreadRunning()
 {
     self_task_runner_ = thread_->taskRunner();
     DCHECK(self_task_runner_);
 
     session_manager_ = std::make_unique<SessionManager>(
-        self_task_runner_, peer_port_, peer_idle_timeout_);
-    session_manager_->start(std::move(shared_pool_), this);
+        self_task_runner_, peer_port_, peer_idle_timeout_, index_, count_);
+    session_manager_->setBandwidthLimit(session_bandwidth_limit_, total_bandwidth_limit_);
+    session_manager_->setCongestionControl(congestion_control_);
+    session_manager_->setStatistics(statistics_);
+
+    std::unique_ptr<base::MessageLoopLagProbe> lag_probe =
+        std::make_unique<base::MessageLoopLagProbe>(self_task_runner_);
+
+    std::scoped_lock lock(lag_probe_lock_);
+    lag_probe_ = std::move(lag_probe);
 }
 
 void SessionsWorker::onAfterThreadRunning()
 {
+    std::unique_ptr<base::MessageLoopLagProbe> lag_probe;
+
+    {
+        std::scoped_lock lock(lag_probe_lock_);
+        lag_probe = std::move(lag_probe_);
+    }
+
+    lag_probe.reset();
     session_manager_.reset();
 }
 
@@ -77,4 +189,23 @@ void SessionsWorker::onSessionFinished()
         delegate_->onSessionFinished();
 }
 
+void SessionsWorker::onPendingSessionMoved(size_t index,
+                                           asio::ip::tcp::socket::native_handle_type socket,
+                                           const proto::PeerToRelay& message)
+{
+    DCHECK_LT(index, workers_.size());
+    workers_[index]->addPendingSession(socket, message);
+}
+
+void SessionsWorker::addPendingSession(asio::ip::tcp::socket::native_handle_type socket,
+                                       const proto::PeerToRelay& message)
+{
+    // Called from the thread of another worker.
+    self_task_runner_->postTask([this, socket, message]()
+    {
+        if (session_manager_)
+            session_manager_->addPendingSession(socket, message);
+    });
+}
+
 } // namespace relay
@@ -19,25 +19,75 @@
 #ifndef RELAY__SESSIONS_WORKER_H
 #define RELAY__SESSIONS_WORKER_H
 
+#include "base/message_loop/message_loop_lag_probe.h"
 #include "base/threading/thread.h"
 #include "relay/session_manager.h"
 
+#include <mutex>
+
 namespace relay {
 
 class SharedPool;
 
+// Serves peer sessions on its own thread. A relay has several workers, and each of them has its
+// own acceptor and sessions (see SessionManager).
 class SessionsWorker
     : public base::Thread::Delegate,
       public SessionManager::Delegate
 {
 public:
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        virtual void onSessionFinished() = 0;
+    };
+
     SessionsWorker(uint16_t peer_port,
                    const std::chrono::minutes& peer_idle_timeout,
-                   std::unique_ptr<SharedPool> shared_pool);
+                   std::unique_ptr<SharedPool> shared_pool,
+                   size_t index = 0,
+                   size_t count = 1);
     ~SessionsWorker();
 
-    void start(std::shared_ptr<base::TaskRunner> caller_task_runner,
-               SessionManager::Delegate* delegate);
+    // Sets the bandwidth limits for sessions (see Session::setBandwidthLimit). The total limit can
+    // be shared by several workers. Must be called before start().
+    void setBandwidthLimit(uint32_t session_limit, std::shared_ptr<base::TokenBucket> total_limit);
+
+    // Sets the congestion control algorithm of the peer connections (see
+    // SessionManager::setCongestionControl). Must be called before start().
+    void setCongestionControl(const std::string& algorithm);
+
+    // Sets the statistics shared by all workers. Must be called before start().
+    void setStatistics(std::shared_ptr<Statistics> statistics);
+
+    // Starts the thread of the worker. Connections are not accepted yet.
+    void start(std::shared_ptr<base::TaskRunner> caller_task_runner, Delegate* delegate);
+
+    // Starts accepting connections. All |workers| must be started before, because a worker can
+    // pass a connection to another one.
+    void startAccepting(const std::vector<SessionsWorker*>& workers);
+
+    // Passes a cascade received from the router to the session manager. Can be called from any
+    // thread.
+    void addCascade(const proto::RelayCascade& cascade);
+
+    // Continues the listening socket and the sessions received from another process of the relay
+    // (see HotRestart). The state can have at most one listener. If called before
+    // startAccepting(), the worker does not create its own listening socket.
+    void adoptState(HotRestartState&& state);
+
+    // Passes the listening socket and the sessions of the worker to |callback| (see
+    // SessionManager::handOff). The callback is called on the thread of the caller of start().
+    void handOff(SessionManager::HandOffCallback callback);
+
+    // Stops the thread of the worker. All workers must be stopped before any of them is destroyed.
+    void stop();
+
+    // Returns the lag of the message loop of the worker or an empty snapshot if the thread of the
+    // worker is not running. Can be called from any thread.
+    base::LatencyHistogram::Snapshot lag() const;
 
 protected:
     // base::Thread::Delegate implementation.
@@ -46,18 +96,40 @@ protected:
 
     // SessionManager::Delegate implementation.
     void onSessionFinished() override;
+    void onPendingSessionMoved(size_t index,
+                               asio::ip::tcp::socket::native_handle_type socket,
+                               const proto::PeerToRelay& message) override;
 
 private:
+    void addPendingSession(asio::ip::tcp::socket::native_handle_type socket,
+                           const proto::PeerToRelay& message);
+
     const uint16_t peer_port_;
     const std::chrono::minutes peer_idle_timeout_;
+    const size_t index_;
+    const size_t count_;
 
     std::unique_ptr<SharedPool> shared_pool_;
 
+    uint32_t session_bandwidth_limit_ = 0;
+    std::shared_ptr<base::TokenBucket> total_bandwidth_limit_;
+    std::string congestion_control_;
+    std::shared_ptr<Statistics> statistics_;
+
+    // All workers of the relay (including this one). The list does not change after the start.
+    std::vector<SessionsWorker*> workers_;
+
     std::unique_ptr<base::Thread> thread_;
     std::shared_ptr<base::TaskRunner> caller_task_runner_;
     std::shared_ptr<base::TaskRunner> self_task_runner_;
     std::unique_ptr<SessionManager> session_manager_;
-    SessionManager::Delegate* delegate_ = nullptr;
+
+    // The probe is created and destroyed on the thread of the worker and is read by lag() on the
+    // thread of the controller.
+    mutable std::mutex lag_probe_lock_;
+    std::unique_ptr<base::MessageLoopLagProbe> lag_probe_;
+
+    Delegate* delegate_ = nullptr;
 
     DISALLOW_COPY_AND_ASSIGN(SessionsWorker);
 };
@@ -54,6 +54,13 @@ void Settings::reset()
     setPeerPort(DEFAULT_RELAY_PEER_TCP_PORT);
     setPeerIdleTimeout(std::chrono::minutes(5));
     setMaxPeerCount(100);
+    setRegion(std::u16string());
+    setSessionBandwidthLimit(0);
+    setTotalBandwidthLimit(0);
+    setThreadCount(1);
+    setCongestionControl(std::string());
+    setMetricsAddress(u"127.0.0.1");
+    setMetricsPort(0);
     setMinLogLevel(1);
 }
 
@@ -132,6 +139,76 @@ uint32_t Settings::maxPeerCount() const
     return impl_.get<uint32_t>("MaxPeerCount", 100);
 }
 
+void Settings::setRegion(const std::u16string& region)
+{
+    impl_.set<std::u16string>("Region", region);
+}
+
+std::u16string Settings::region() const
+{
+    return impl_.get<std::u16string>("Region");
+}
+
+void Settings::setSessionBandwidthLimit(uint32_t limit)
+{
+    impl_.set<uint32_t>("SessionBandwidthLimit", limit);
+}
+
+uint32_t Settings::sessionBandwidthLimit() const
+{
+    return impl_.get<uint32_t>("SessionBandwidthLimit", 0);
+}
+
+void Settings::setTotalBandwidthLimit(uint32_t limit)
+{
+    impl_.set<uint32_t>("TotalBandwidthLimit", limit);
+}
+
+uint32_t Settings::totalBandwidthLimit() const
+{
+    return impl_.get<uint32_t>("TotalBandwidthLimit", 0);
+}
+
+void Settings::setThreadCount(uint32_t count)
+{
+    impl_.set<uint32_t>("ThreadCount", count);
+}
+
+uint32_t Settings::threadCount() const
+{
+    return impl_.get<uint32_t>("ThreadCount", 1);
+}
+
+void Settings::setCongestionControl(const std::string& algorithm)
+{
+    impl_.set<std::string>("CongestionControl", algorithm);
+}
+
+std::string Settings::congestionControl() const
+{
+    return impl_.get<std::string>("CongestionControl");
+}
+
+void Settings::setMetricsAddress(const std::u16string& address)
+{
+    impl_.set<std::u16string>("MetricsAddress", address);
+}
+
+std::u16string Settings::metricsAddress() const
+{
+    return impl_.get<std::u16string>("MetricsAddress", u"127.0.0.1");
+}
+
+void Settings::setMetricsPort(uint16_t port)
+{
+    impl_.set<uint16_t>("MetricsPort", port);
+}
+
+uint16_t Settings::metricsPort() const
+{
+    return impl_.get<uint16_t>("MetricsPort", 0);
+}
+
 void Settings::setMinLogLevel(int level)
 {
     impl_.set<int>("MinLogLevel", level);
@@ -57,6 +57,36 @@ public:
     void setMaxPeerCount(uint32_t count);
     uint32_t maxPeerCount() const;
 
+    // Region of the relay. The router uses it to choose relays close to the peers and to cascade
+    // relays of different regions.
+    void setRegion(const std::u16string& region);
+    std::u16string region() const;
+
+    // Maximum speed of one session and of all sessions of the relay in bytes per second. If zero,
+    // the speed is not limited.
+    void setSessionBandwidthLimit(uint32_t limit);
+    uint32_t sessionBandwidthLimit() const;
+
+    void setTotalBandwidthLimit(uint32_t limit);
+    uint32_t totalBandwidthLimit() const;
+
+    // Number of threads that serve peer sessions. If zero, the number of processors is used.
+    void setThreadCount(uint32_t count);
+    uint32_t threadCount() const;
+
+    // TCP congestion control algorithm of the peer connections (for example, "bbr"). If empty,
+    // the default algorithm of the system is used. Supported only on Linux.
+    void setCongestionControl(const std::string& algorithm);
+    std::string congestionControl() const;
+
+    // Address and port of the HTTP listener for Prometheus metrics ("GET /metrics"). If the port
+    // is zero, the listener is disabled.
+    void setMetricsAddress(const std::u16string& address);
+    std::u16string metricsAddress() const;
+
+    void setMetricsPort(uint16_t port);
+    uint16_t metricsPort() const;
+
     void setMinLogLevel(int level);
     int minLogLevel() const;
 
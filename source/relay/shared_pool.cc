@@ -20,6 +20,8 @@
 
 #include "base/logging.h"
 
+#include <map>
+#include <memory>
 #include <mutex>
 
 namespace relay {
@@ -32,24 +34,37 @@ public:
 
     void dettach();
 
-    uint32_t addKey(SessionKey&& session_key);
+    std::vector<uint32_t> addKeys(std::vector<SessionKey>&& session_keys);
     bool removeKey(uint32_t key_id);
     void setKeyExpired(uint32_t key_id);
     std::optional<Key> key(uint32_t key_id, std::string_view peer_public_key) const;
     void clear();
+    size_t count() const;
 
 private:
+    using Map = std::map<uint32_t, std::shared_ptr<const SessionKey>>;
+
+    // Replaces the current snapshot of the keys. Must be called with |write_lock_| held.
+    void publish(std::shared_ptr<const Map> map);
+
     Delegate* delegate_;
 
-    mutable std::mutex pool_lock_;
-    std::map<uint32_t, SessionKey> map_;
+    // Keys are read by all session threads and changed rarely, so the keys are kept in an
+    // immutable snapshot. A reader takes the current snapshot atomically and never waits for
+    // writers. A writer copies the snapshot (only the pointers to the keys are copied), changes the
+    // copy and publishes it. The old snapshot is freed when the last reader releases it.
+    std::shared_ptr<const Map> map_;
+
+    // Serializes writers.
+    std::mutex write_lock_;
     uint32_t current_key_id_ = 0;
 
     DISALLOW_COPY_AND_ASSIGN(Pool);
 };
 
 SharedPool::Pool::Pool(Delegate* delegate)
-    : delegate_(delegate)
+    : delegate_(delegate),
+      map_(std::make_shared<const Map>())
 {
     DCHECK(delegate_);
 }
@@ -59,25 +74,43 @@ void SharedPool::Pool::dettach()
     delegate_ = nullptr;
 }
 
-uint32_t SharedPool::Pool::addKey(SessionKey&& session_key)
+std::vector<uint32_t> SharedPool::Pool::addKeys(std::vector<SessionKey>&& session_keys)
 {
-    std::scoped_lock lock(pool_lock_);
+    std::vector<uint32_t> key_ids;
+    if (session_keys.empty())
+        return key_ids;
+
+    key_ids.reserve(session_keys.size());
+
+    std::scoped_lock lock(write_lock_);
+
+    // The snapshot is copied once for all the keys.
+    std::shared_ptr<Map> map = std::make_shared<Map>(*std::atomic_load(&map_));
+
+    for (auto& session_key : session_keys)
+    {
+        uint32_t key_id = current_key_id_++;
+        map->emplace(key_id, std::make_shared<const SessionKey>(std::move(session_key)));
+        key_ids.emplace_back(key_id);
+    }
 
-    uint32_t key_id = current_key_id_++;
-    map_.emplace(key_id, std::move(session_key));
+    publish(std::move(map));
 
-    LOG(LS_INFO) << "Key with id " << key_id << " added to pool";
-    return key_id;
+    LOG(LS_INFO) << key_ids.size() << " keys added to pool (ids " << key_ids.front() << "-"
+                 << key_ids.back() << ")";
+    return key_ids;
 }
 
 bool SharedPool::Pool::removeKey(uint32_t key_id)
 {
-    std::scoped_lock lock(pool_lock_);
+    std::scoped_lock lock(write_lock_);
 
-    auto result = map_.find(key_id);
-    if (result != map_.end())
+    std::shared_ptr<const Map> current = std::atomic_load(&map_);
+    if (current->find(key_id) != current->end())
     {
-        map_.erase(result);
+        std::shared_ptr<Map> map = std::make_shared<Map>(*current);
+        map->erase(key_id);
+        publish(std::move(map));
 
         LOG(LS_INFO) << "Key with id " << key_id << " removed from pool";
         return true;
@@ -100,22 +133,34 @@ void SharedPool::Pool::setKeyExpired(uint32_t key_id)
 std::optional<SharedPool::Key> SharedPool::Pool::key(
     uint32_t key_id, std::string_view peer_public_key) const
 {
-    std::scoped_lock lock(pool_lock_);
+    std::shared_ptr<const Map> map = std::atomic_load(&map_);
 
-    auto result = map_.find(key_id);
-    if (result == map_.end())
+    auto result = map->find(key_id);
+    if (result == map->end())
         return std::nullopt;
 
-    const SessionKey& session_key = result->second;
+    // The key is owned by the snapshot, so it stays alive while it is used even if the key is
+    // removed from the pool by another thread.
+    const SessionKey& session_key = *result->second;
     return std::make_pair(session_key.sessionKey(peer_public_key), session_key.iv());
 }
 
 void SharedPool::Pool::clear()
 {
-    std::scoped_lock lock(pool_lock_);
+    std::scoped_lock lock(write_lock_);
 
     LOG(LS_INFO) << "Key pool cleared";
-    map_.clear();
+    publish(std::make_shared<const Map>());
+}
+
+size_t SharedPool::Pool::count() const
+{
+    return std::atomic_load(&map_)->size();
+}
+
+void SharedPool::Pool::publish(std::shared_ptr<const Map> map)
+{
+    std::atomic_store(&map_, std::move(map));
 }
 
 SharedPool::SharedPool(Delegate* delegate)
@@ -143,9 +188,9 @@ std::unique_ptr<SharedPool> SharedPool::share()
     return std::unique_ptr<SharedPool>(new SharedPool(pool_));
 }
 
-uint32_t SharedPool::addKey(SessionKey&& session_key)
+std::vector<uint32_t> SharedPool::addKeys(std::vector<SessionKey>&& session_keys)
 {
-    return pool_->addKey(std::move(session_key));
+    return pool_->addKeys(std::move(session_keys));
 }
 
 bool SharedPool::removeKey(uint32_t key_id)
@@ -169,4 +214,9 @@ void SharedPool::clear()
     pool_->clear();
 }
 
+size_t SharedPool::count() const
+{
+    return pool_->count();
+}
+
 } // namespace relay
@@ -22,6 +22,7 @@
 #include "relay/session_key.h"
 
 #include <optional>
+#include <vector>
 
 namespace relay {
 
@@ -43,12 +44,16 @@ public:
 
     std::unique_ptr<SharedPool> share();
 
-    uint32_t addKey(SessionKey&& session_key);
+    // Adds the keys with one change of the pool and returns their IDs in the same order.
+    std::vector<uint32_t> addKeys(std::vector<SessionKey>&& session_keys);
     bool removeKey(uint32_t key_id);
     void setKeyExpired(uint32_t key_id);
     std::optional<Key> key(uint32_t key_id, std::string_view peer_public_key) const;
     void clear();
 
+    // Returns the number of keys in the pool.
+    size_t count() const;
+
 private:
     class Pool;
     explicit SharedPool(std::shared_ptr<Pool> pool);
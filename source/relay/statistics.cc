@@ -0,0 +1,250 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "relay/statistics.h"
+
+#include "base/logging.h"
+#include "base/prometheus_writer.h"
+#include "proto/router_common.pb.h"
+
+#include <algorithm>
+
+namespace relay {
+
+namespace {
+
+// Buckets of the handshake latency (in milliseconds).
+const std::initializer_list<uint64_t> kHandshakeLatencyBounds =
+    { 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+
+// Buckets of the time a peer waits for the opposite peer (in milliseconds).
+const std::initializer_list<uint64_t> kPairingLatencyBounds =
+    { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 20000 };
+
+// Buckets of the session throughput (in bytes per second).
+const std::initializer_list<uint64_t> kSessionThroughputBounds =
+    { 1024, 4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024,
+      16 * 1024 * 1024, 64 * 1024 * 1024 };
+
+} // namespace
+
+Statistics::Histogram::Histogram(std::initializer_list<uint64_t> upper_bounds)
+    : bounds_count_(upper_bounds.size())
+{
+    DCHECK_LT(bounds_count_, kMaxBuckets);
+    DCHECK(std::is_sorted(upper_bounds.begin(), upper_bounds.end()));
+
+    std::copy(upper_bounds.begin(), upper_bounds.end(), upper_bounds_.begin());
+
+    for (auto& count : counts_)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void Statistics::Histogram::add(uint64_t value)
+{
+    const auto bounds_end = upper_bounds_.begin() + bounds_count_;
+    const size_t bucket = static_cast<size_t>(
+        std::lower_bound(upper_bounds_.begin(), bounds_end, value) - upper_bounds_.begin());
+
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+void Statistics::Histogram::toProto(proto::RelayHistogram* histogram) const
+{
+    for (size_t i = 0; i < bounds_count_; ++i)
+        histogram->add_upper_bound(upper_bounds_[i]);
+
+    for (size_t i = 0; i <= bounds_count_; ++i)
+        histogram->add_count(counts_[i].load(std::memory_order_relaxed));
+}
+
+void Statistics::Histogram::toPrometheus(std::string_view name, double scale,
+                                         base::PrometheusWriter* writer) const
+{
+    base::PrometheusWriter::Histogram histogram;
+
+    for (size_t i = 0; i < bounds_count_; ++i)
+        histogram.upper_bounds.emplace_back(static_cast<double>(upper_bounds_[i]) * scale);
+
+    for (size_t i = 0; i <= bounds_count_; ++i)
+        histogram.counts.emplace_back(counts_[i].load(std::memory_order_relaxed));
+
+    histogram.sum = static_cast<double>(sum_.load(std::memory_order_relaxed)) * scale;
+
+    writer->addHistogram(name, histogram);
+}
+
+Statistics::Statistics()
+    : handshake_latency_(kHandshakeLatencyBounds),
+      session_throughput_(kSessionThroughputBounds),
+      pairing_latency_(kPairingLatencyBounds),
+      last_snapshot_time_(std::chrono::steady_clock::now())
+{
+    for (int i = 0; i < kNumberOfSides; ++i)
+        bytes_[i].store(0, std::memory_order_relaxed);
+}
+
+Statistics::~Statistics() = default;
+
+void Statistics::addAcceptedConnection()
+{
+    accepted_connections_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Statistics::addPendingSession()
+{
+    pending_sessions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Statistics::removePendingSession()
+{
+    pending_sessions_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Statistics::addActiveSession()
+{
+    active_sessions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Statistics::removeActiveSession(int64_t bytes_transferred,
+                                     const std::chrono::seconds& duration)
+{
+    active_sessions_.fetch_sub(1, std::memory_order_relaxed);
+
+    const int64_t seconds = std::max<int64_t>(duration.count(), 1);
+    const int64_t bytes = std::max<int64_t>(bytes_transferred, 0);
+
+    session_throughput_.add(static_cast<uint64_t>(bytes / seconds));
+}
+
+int64_t Statistics::activeSessions() const
+{
+    return active_sessions_.load(std::memory_order_relaxed);
+}
+
+void Statistics::addBytes(int source, size_t bytes)
+{
+    DCHECK(source >= 0 && source < kNumberOfSides);
+    bytes_[source].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Statistics::addBufferFull()
+{
+    buffer_full_events_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Statistics::addHandshake(const std::chrono::milliseconds& latency)
+{
+    handshake_latency_.add(static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)));
+}
+
+void Statistics::addPairing(const std::chrono::milliseconds& latency)
+{
+    pairing_latency_.add(static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)));
+}
+
+void Statistics::addIdleEvictions(size_t count)
+{
+    idle_evictions_.fetch_add(count, std::memory_order_relaxed);
+}
+
+void Statistics::takeSnapshot(proto::RelayStat* stat)
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const double interval = std::max(
+        std::chrono::duration<double>(now - last_snapshot_time_).count(), 0.001);
+
+    const uint64_t accepted_connections = accepted_connections_.load(std::memory_order_relaxed);
+    uint64_t bytes[kNumberOfSides];
+    uint64_t bytes_per_second[kNumberOfSides];
+
+    for (int i = 0; i < kNumberOfSides; ++i)
+    {
+        bytes[i] = bytes_[i].load(std::memory_order_relaxed);
+        bytes_per_second[i] = static_cast<uint64_t>((bytes[i] - last_bytes_[i]) / interval);
+        last_bytes_[i] = bytes[i];
+    }
+
+    stat->set_interval(static_cast<uint32_t>(interval + 0.5));
+    stat->set_active_sessions(static_cast<uint32_t>(
+        std::max<int64_t>(active_sessions_.load(std::memory_order_relaxed), 0)));
+    stat->set_pending_sessions(static_cast<uint32_t>(
+        std::max<int64_t>(pending_sessions_.load(std::memory_order_relaxed), 0)));
+    stat->set_accepted_connections(accepted_connections);
+    stat->set_bytes_transferred(bytes[0] + bytes[1]);
+    stat->set_buffer_full_events(buffer_full_events_.load(std::memory_order_relaxed));
+    stat->set_idle_evictions(idle_evictions_.load(std::memory_order_relaxed));
+    stat->set_accept_rate((accepted_connections - last_accepted_connections_) / interval);
+    stat->set_bytes_per_second_from_second_peer(bytes_per_second[0]);
+    stat->set_bytes_per_second_from_first_peer(bytes_per_second[1]);
+
+    handshake_latency_.toProto(stat->mutable_handshake_latency());
+    session_throughput_.toProto(stat->mutable_session_throughput());
+    pairing_latency_.toProto(stat->mutable_pairing_latency());
+
+    last_accepted_connections_ = accepted_connections;
+    last_snapshot_time_ = now;
+}
+
+void Statistics::writeMetrics(base::PrometheusWriter* writer) const
+{
+    using Type = base::PrometheusWriter::Type;
+
+    writer->addFamily("aspia_relay_sessions", Type::GAUGE, "Number of sessions by state.");
+    writer->addSample("aspia_relay_sessions",
+                      static_cast<double>(pending_sessions_.load(std::memory_order_relaxed)),
+                      { { "state", "pending" } });
+    writer->addSample("aspia_relay_sessions",
+                      static_cast<double>(active_sessions_.load(std::memory_order_relaxed)),
+                      { { "state", "active" } });
+
+    writer->addCounter("aspia_relay_accepted_connections_total", "Number of accepted connections.",
+                       static_cast<double>(accepted_connections_.load(std::memory_order_relaxed)));
+
+    // The same order of the peers as in takeSnapshot.
+    writer->addFamily("aspia_relay_bytes_total", Type::COUNTER, "Bytes relayed by direction.");
+    writer->addSample("aspia_relay_bytes_total",
+                      static_cast<double>(bytes_[0].load(std::memory_order_relaxed)),
+                      { { "direction", "from_second_peer" } });
+    writer->addSample("aspia_relay_bytes_total",
+                      static_cast<double>(bytes_[1].load(std::memory_order_relaxed)),
+                      { { "direction", "from_first_peer" } });
+
+    writer->addCounter("aspia_relay_buffer_full_total",
+                       "Number of reads that filled the whole buffer.",
+                       static_cast<double>(buffer_full_events_.load(std::memory_order_relaxed)));
+    writer->addCounter("aspia_relay_idle_evictions_total",
+                       "Number of sessions closed because they were idle.",
+                       static_cast<double>(idle_evictions_.load(std::memory_order_relaxed)));
+
+    writer->addFamily("aspia_relay_handshake_seconds", Type::HISTOGRAM,
+                      "Time from the connection of a peer until its authentication data is read.");
+    handshake_latency_.toPrometheus("aspia_relay_handshake_seconds", 0.001, writer);
+
+    writer->addFamily("aspia_relay_pairing_seconds", Type::HISTOGRAM,
+                      "Time a peer waits for the opposite peer.");
+    pairing_latency_.toPrometheus("aspia_relay_pairing_seconds", 0.001, writer);
+
+    writer->addFamily("aspia_relay_session_throughput_bytes_per_second", Type::HISTOGRAM,
+                      "Average throughput of the finished sessions.");
+    session_throughput_.toPrometheus(
+        "aspia_relay_session_throughput_bytes_per_second", 1.0, writer);
+}
+
+} // namespace relay
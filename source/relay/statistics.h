@@ -0,0 +1,122 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef RELAY__STATISTICS_H
+#define RELAY__STATISTICS_H
+
+#include "base/macros_magic.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <string_view>
+
+namespace base {
+class PrometheusWriter;
+} // namespace base
+
+namespace proto {
+class RelayHistogram;
+class RelayStat;
+} // namespace proto
+
+namespace relay {
+
+// Counters of the relay. They are updated by the sessions of all worker threads and are sent to
+// the router periodically. All methods except takeSnapshot() can be called from any thread.
+class Statistics
+{
+public:
+    Statistics();
+    ~Statistics();
+
+    void addAcceptedConnection();
+
+    void addPendingSession();
+    void removePendingSession();
+
+    void addActiveSession();
+    void removeActiveSession(int64_t bytes_transferred, const std::chrono::seconds& duration);
+    int64_t activeSessions() const;
+
+    // |source| is the index of the peer in the session (see Session) that sent the data.
+    void addBytes(int source, size_t bytes);
+    void addBufferFull();
+    void addHandshake(const std::chrono::milliseconds& latency);
+    void addPairing(const std::chrono::milliseconds& latency);
+    void addIdleEvictions(size_t count);
+
+    // Fills |stat| with the current values. The rates are calculated for the time since the
+    // previous call. Must be called from one thread only.
+    void takeSnapshot(proto::RelayStat* stat);
+
+    // Writes the counters since the start of the relay (the rates are left to the scraper). Can
+    // be called from any thread.
+    void writeMetrics(base::PrometheusWriter* writer) const;
+
+private:
+    // Counts values in buckets with fixed upper bounds.
+    class Histogram
+    {
+    public:
+        static constexpr size_t kMaxBuckets = 16;
+
+        // |upper_bounds| must be in ascending order and must contain less than kMaxBuckets items.
+        Histogram(std::initializer_list<uint64_t> upper_bounds);
+
+        void add(uint64_t value);
+        void toProto(proto::RelayHistogram* histogram) const;
+
+        // Writes the histogram with the bounds and the sum multiplied by |scale|.
+        void toPrometheus(std::string_view name, double scale,
+                          base::PrometheusWriter* writer) const;
+
+    private:
+        std::array<uint64_t, kMaxBuckets> upper_bounds_;
+        size_t bounds_count_;
+        std::array<std::atomic<uint64_t>, kMaxBuckets> counts_;
+        std::atomic<uint64_t> sum_ { 0 };
+
+        DISALLOW_COPY_AND_ASSIGN(Histogram);
+    };
+
+    static constexpr int kNumberOfSides = 2;
+
+    std::atomic<int64_t> pending_sessions_ { 0 };
+    std::atomic<int64_t> active_sessions_ { 0 };
+    std::atomic<uint64_t> accepted_connections_ { 0 };
+    std::atomic<uint64_t> bytes_[kNumberOfSides];
+    std::atomic<uint64_t> buffer_full_events_ { 0 };
+    std::atomic<uint64_t> idle_evictions_ { 0 };
+
+    Histogram handshake_latency_;
+    Histogram session_throughput_;
+    Histogram pairing_latency_;
+
+    // Values at the time of the previous snapshot.
+    std::chrono::steady_clock::time_point last_snapshot_time_;
+    uint64_t last_accepted_connections_ = 0;
+    uint64_t last_bytes_[kNumberOfSides] = { 0, 0 };
+
+    DISALLOW_COPY_AND_ASSIGN(Statistics);
+};
+
+} // namespace relay
+
+#endif // RELAY__STATISTICS_H
@@ -0,0 +1,120 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/cached_database.h"
+
+#include "base/logging.h"
+#include "router/host_id_index.h"
+#include "router/user_cache.h"
+
+namespace router {
+
+CachedDatabase::CachedDatabase(Database* db, HostIdIndex* host_id_index, UserCache* user_cache)
+    : db_(db),
+      host_id_index_(host_id_index),
+      user_cache_(user_cache)
+{
+    DCHECK(db_);
+    DCHECK(host_id_index_);
+    DCHECK(user_cache_);
+}
+
+CachedDatabase::~CachedDatabase() = default;
+
+std::vector<base::User> CachedDatabase::userList() const
+{
+    return db_->userList();
+}
+
+bool CachedDatabase::addUser(const base::User& user)
+{
+    bool result = db_->addUser(user);
+    user_cache_->clear();
+    return result;
+}
+
+bool CachedDatabase::addUsers(const std::vector<base::User>& users)
+{
+    bool result = db_->addUsers(users);
+    user_cache_->clear();
+    return result;
+}
+
+bool CachedDatabase::modifyUser(const base::User& user)
+{
+    bool result = db_->modifyUser(user);
+    user_cache_->clear();
+    return result;
+}
+
+bool CachedDatabase::removeUser(int64_t entry_id)
+{
+    bool result = db_->removeUser(entry_id);
+    user_cache_->clear();
+    return result;
+}
+
+base::User CachedDatabase::findUser(std::u16string_view username)
+{
+    uint64_t generation;
+
+    std::optional<base::User> user = user_cache_->find(username, &generation);
+    if (user.has_value())
+        return std::move(*user);
+
+    base::User result = db_->findUser(username);
+    user_cache_->add(username, result, generation);
+    return result;
+}
+
+base::HostId CachedDatabase::hostId(const base::ByteArray& keyHash) const
+{
+    base::HostId host_id = host_id_index_->find(keyHash);
+    if (host_id != base::kInvalidHostId)
+        return host_id;
+
+    host_id = db_->hostId(keyHash);
+    host_id_index_->add(keyHash, host_id);
+    return host_id;
+}
+
+bool CachedDatabase::addHost(const base::ByteArray& keyHash)
+{
+    if (!db_->addHost(keyHash))
+        return false;
+
+    host_id_index_->add(keyHash, db_->hostId(keyHash));
+    return true;
+}
+
+std::vector<base::HostId> CachedDatabase::addHosts(const std::vector<base::ByteArray>& key_hashes)
+{
+    std::vector<base::HostId> host_ids = db_->addHosts(key_hashes);
+
+    for (size_t i = 0; i < host_ids.size(); ++i)
+        host_id_index_->add(key_hashes[i], host_ids[i]);
+
+    return host_ids;
+}
+
+std::optional<std::vector<Database::Host>> CachedDatabase::hostList() const
+{
+    return db_->hostList();
+}
+
+} // namespace router
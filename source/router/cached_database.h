@@ -0,0 +1,61 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__CACHED_DATABASE_H
+#define ROUTER__CACHED_DATABASE_H
+
+#include "base/macros_magic.h"
+#include "router/database.h"
+
+namespace router {
+
+class HostIdIndex;
+class UserCache;
+
+// Forwards the calls to a connection of the database. The hosts are found in the index and the
+// users in the cache shared by all the connections, the connection is used on a miss. Any change
+// of the users clears the cache. Changes are rare compared to authentications.
+class CachedDatabase : public Database
+{
+public:
+    CachedDatabase(Database* db, HostIdIndex* host_id_index, UserCache* user_cache);
+    ~CachedDatabase() override;
+
+    // Database implementation.
+    std::vector<base::User> userList() const override;
+    bool addUser(const base::User& user) override;
+    bool addUsers(const std::vector<base::User>& users) override;
+    bool modifyUser(const base::User& user) override;
+    bool removeUser(int64_t entry_id) override;
+    base::User findUser(std::u16string_view username) override;
+    base::HostId hostId(const base::ByteArray& keyHash) const override;
+    bool addHost(const base::ByteArray& keyHash) override;
+    std::vector<base::HostId> addHosts(const std::vector<base::ByteArray>& key_hashes) override;
+    std::optional<std::vector<Host>> hostList() const override;
+
+private:
+    Database* db_;
+    HostIdIndex* host_id_index_;
+    UserCache* user_cache_;
+
+    DISALLOW_COPY_AND_ASSIGN(CachedDatabase);
+};
+
+} // namespace router
+
+#endif // ROUTER__CACHED_DATABASE_H
@@ -0,0 +1,156 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/cached_database.h"
+
+#include "router/database_sqlite.h"
+#include "router/host_id_index.h"
+#include "router/user_cache.h"
+
+#include <gtest/gtest.h>
+
+namespace router {
+
+namespace {
+
+class CachedDatabaseTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory_ = std::filesystem::temp_directory_path();
+        directory_.append("test_cached_database");
+
+        std::error_code ignored_error;
+        std::filesystem::remove_all(directory_, ignored_error);
+        ASSERT_TRUE(std::filesystem::create_directories(directory_));
+
+        std::filesystem::path file_path = directory_;
+        file_path.append("router.db3");
+
+        sqlite_ = DatabaseSqlite::create(file_path);
+        ASSERT_TRUE(sqlite_);
+
+        db_ = std::make_unique<CachedDatabase>(sqlite_.get(), &host_id_index_, &user_cache_);
+    }
+
+    void TearDown() override
+    {
+        db_.reset();
+        sqlite_.reset();
+
+        std::error_code ignored_error;
+        std::filesystem::remove_all(directory_, ignored_error);
+    }
+
+    static base::User createUser(std::u16string_view name)
+    {
+        base::User user = base::User::create(name, u"password");
+        user.flags = base::User::ENABLED;
+        return user;
+    }
+
+    std::filesystem::path directory_;
+    HostIdIndex host_id_index_;
+    UserCache user_cache_;
+    std::unique_ptr<DatabaseSqlite> sqlite_;
+    std::unique_ptr<CachedDatabase> db_;
+};
+
+} // namespace
+
+TEST_F(CachedDatabaseTest, FindUser)
+{
+    EXPECT_FALSE(db_->findUser(u"user").isValid());
+
+    ASSERT_TRUE(db_->addUser(createUser(u"user")));
+
+    base::User user = db_->findUser(u"user");
+    ASSERT_TRUE(user.isValid());
+    EXPECT_EQ(user.name, u"user");
+
+    // The second lookup is served by the cache.
+    uint64_t generation;
+    EXPECT_TRUE(user_cache_.find(u"user", &generation).has_value());
+    EXPECT_EQ(db_->findUser(u"user").entry_id, user.entry_id);
+}
+
+TEST_F(CachedDatabaseTest, ChangesClearCache)
+{
+    ASSERT_TRUE(db_->addUser(createUser(u"user")));
+
+    base::User user = db_->findUser(u"user");
+    ASSERT_TRUE(user.isValid());
+
+    user.flags = 0;
+    ASSERT_TRUE(db_->modifyUser(user));
+    EXPECT_EQ(db_->findUser(u"user").flags, 0u);
+
+    ASSERT_TRUE(db_->removeUser(user.entry_id));
+    EXPECT_FALSE(db_->findUser(u"user").isValid());
+}
+
+TEST_F(CachedDatabaseTest, AddUsers)
+{
+    ASSERT_TRUE(db_->addUsers({ createUser(u"user1"), createUser(u"user2") }));
+    EXPECT_EQ(db_->userList().size(), 2u);
+
+    // The batch is added in one transaction, a duplicate name rolls back all the users.
+    EXPECT_FALSE(db_->addUsers({ createUser(u"user3"), createUser(u"user1") }));
+    EXPECT_EQ(db_->userList().size(), 2u);
+    EXPECT_FALSE(db_->findUser(u"user3").isValid());
+}
+
+TEST_F(CachedDatabaseTest, HostId)
+{
+    const base::ByteArray key_hash = base::fromStdString("key_hash");
+
+    EXPECT_EQ(db_->hostId(key_hash), base::kInvalidHostId);
+
+    ASSERT_TRUE(db_->addHost(key_hash));
+
+    base::HostId host_id = host_id_index_.find(key_hash);
+    ASSERT_NE(host_id, base::kInvalidHostId);
+    EXPECT_EQ(db_->hostId(key_hash), host_id);
+    EXPECT_EQ(sqlite_->hostId(key_hash), host_id);
+}
+
+TEST_F(CachedDatabaseTest, AddHosts)
+{
+    const std::vector<base::ByteArray> key_hashes =
+        { base::fromStdString("key_hash1"), base::fromStdString("key_hash2") };
+
+    std::vector<base::HostId> host_ids = db_->addHosts(key_hashes);
+    ASSERT_EQ(host_ids.size(), key_hashes.size());
+    EXPECT_NE(host_ids[0], host_ids[1]);
+
+    for (size_t i = 0; i < key_hashes.size(); ++i)
+        EXPECT_EQ(host_id_index_.find(key_hashes[i]), host_ids[i]);
+
+    std::optional<std::vector<Database::Host>> host_list = db_->hostList();
+    ASSERT_TRUE(host_list.has_value());
+    EXPECT_EQ(host_list->size(), key_hashes.size());
+
+    // A duplicate key rolls back the batch and nothing is added to the index.
+    const base::ByteArray key_hash3 = base::fromStdString("key_hash3");
+    EXPECT_TRUE(db_->addHosts({ key_hash3, key_hashes[0] }).empty());
+    EXPECT_EQ(host_id_index_.find(key_hash3), base::kInvalidHostId);
+    EXPECT_EQ(sqlite_->hostId(key_hash3), base::kInvalidHostId);
+}
+
+} // namespace router
@@ -0,0 +1,145 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/cluster_connector.h"
+
+#include "base/logging.h"
+#include "base/task_runner.h"
+#include "base/peer/client_authenticator.h"
+#include "proto/router_common.pb.h"
+
+namespace router {
+
+namespace {
+
+const std::chrono::seconds kReconnectTimeout{ 15 };
+
+} // namespace
+
+ClusterConnector::ClusterConnector(std::shared_ptr<base::TaskRunner> task_runner,
+                                   const Settings::ClusterPeer& peer,
+                                   Delegate* delegate)
+    : task_runner_(task_runner),
+      peer_(peer),
+      delegate_(delegate),
+      reconnect_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner,
+                       base::WaitableTimer::Precision::COARSE),
+      session_timer_(base::WaitableTimer::Type::SINGLE_SHOT, task_runner,
+                     base::WaitableTimer::Precision::COARSE)
+{
+    DCHECK(task_runner_ && delegate_);
+}
+
+ClusterConnector::~ClusterConnector() = default;
+
+void ClusterConnector::start()
+{
+    connect();
+}
+
+void ClusterConnector::onConnected()
+{
+    LOG(LS_INFO) << "Connection to router " << peer_.address << " is established";
+
+    channel_->setOwnKeepAlive(true);
+    channel_->setNoDelay(true);
+
+    authenticator_ = std::make_unique<base::ClientAuthenticator>(task_runner_);
+
+    authenticator_->setIdentify(proto::IDENTIFY_ANONYMOUS);
+    authenticator_->setPeerPublicKey(peer_.public_key);
+    authenticator_->setSessionType(proto::ROUTER_SESSION_ROUTER);
+
+    authenticator_->start(std::move(channel_),
+                          [this](base::ClientAuthenticator::ErrorCode error_code)
+    {
+        if (error_code == base::ClientAuthenticator::ErrorCode::SUCCESS)
+        {
+            LOG(LS_INFO) << "Authentication with router " << peer_.address << " complete";
+
+            base::ServerAuthenticatorManager::SessionInfo session_info;
+
+            session_info.channel       = authenticator_->takeChannel();
+            session_info.version       = authenticator_->peerVersion();
+            session_info.os_name       = authenticator_->peerOsName();
+            session_info.computer_name = authenticator_->peerComputerName();
+            session_info.session_type  = proto::ROUTER_SESSION_ROUTER;
+
+            session_alive_ = delegate_->onClusterConnected(std::move(session_info));
+            session_timer_.start(
+                kReconnectTimeout, std::bind(&ClusterConnector::checkSession, this));
+        }
+        else
+        {
+            LOG(LS_WARNING) << "Authentication with router " << peer_.address << " failed: "
+                            << base::ClientAuthenticator::errorToString(error_code);
+            delayedConnect();
+        }
+
+        // Authenticator is no longer needed.
+        task_runner_->deleteSoon(std::move(authenticator_));
+    });
+}
+
+void ClusterConnector::onDisconnected(base::NetworkChannel::ErrorCode error_code)
+{
+    LOG(LS_INFO) << "Unable to connect to router " << peer_.address << ": "
+                 << base::NetworkChannel::errorToString(error_code);
+    delayedConnect();
+}
+
+void ClusterConnector::onMessageReceived(const base::ByteArray& /* buffer */)
+{
+    // The channel is passed to the session before any messages are received.
+    NOTREACHED();
+}
+
+void ClusterConnector::onMessageWritten(size_t /* pending */)
+{
+    // Nothing
+}
+
+void ClusterConnector::connect()
+{
+    LOG(LS_INFO) << "Connecting to router " << peer_.address << ":" << peer_.port;
+
+    channel_ = std::make_unique<base::NetworkChannel>();
+    channel_->setListener(this);
+    channel_->connect(peer_.address, peer_.port);
+}
+
+void ClusterConnector::delayedConnect()
+{
+    LOG(LS_INFO) << "Reconnect to router " << peer_.address << " after "
+                 << kReconnectTimeout.count() << " seconds";
+    reconnect_timer_.start(kReconnectTimeout, std::bind(&ClusterConnector::connect, this));
+}
+
+void ClusterConnector::checkSession()
+{
+    if (!session_alive_.expired())
+    {
+        session_timer_.start(kReconnectTimeout, std::bind(&ClusterConnector::checkSession, this));
+        return;
+    }
+
+    LOG(LS_INFO) << "Session with router " << peer_.address << " is finished";
+    connect();
+}
+
+} // namespace router
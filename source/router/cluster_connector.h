@@ -0,0 +1,84 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__CLUSTER_CONNECTOR_H
+#define ROUTER__CLUSTER_CONNECTOR_H
+
+#include "base/waitable_timer.h"
+#include "base/net/network_channel.h"
+#include "base/peer/server_authenticator_manager.h"
+#include "router/settings.h"
+
+namespace base {
+class ClientAuthenticator;
+} // namespace base
+
+namespace router {
+
+// Keeps the connection to another router of the cluster. When the connection is authenticated,
+// the channel is passed to the delegate, which creates a session for it. When the session ends,
+// the connector connects again.
+class ClusterConnector : public base::NetworkChannel::Listener
+{
+public:
+    class Delegate
+    {
+    public:
+        virtual ~Delegate() = default;
+
+        // Returns a pointer that expires when the created session is destroyed.
+        virtual std::weak_ptr<bool> onClusterConnected(
+            base::ServerAuthenticatorManager::SessionInfo&& session_info) = 0;
+    };
+
+    ClusterConnector(std::shared_ptr<base::TaskRunner> task_runner,
+                     const Settings::ClusterPeer& peer,
+                     Delegate* delegate);
+    ~ClusterConnector();
+
+    void start();
+
+protected:
+    // base::NetworkChannel::Listener implementation.
+    void onConnected() override;
+    void onDisconnected(base::NetworkChannel::ErrorCode error_code) override;
+    void onMessageReceived(const base::ByteArray& buffer) override;
+    void onMessageWritten(size_t pending) override;
+
+private:
+    void connect();
+    void delayedConnect();
+    void checkSession();
+
+    std::shared_ptr<base::TaskRunner> task_runner_;
+    const Settings::ClusterPeer peer_;
+    Delegate* delegate_;
+
+    std::unique_ptr<base::NetworkChannel> channel_;
+    std::unique_ptr<base::ClientAuthenticator> authenticator_;
+    std::weak_ptr<bool> session_alive_;
+
+    base::WaitableTimer reconnect_timer_;
+    base::WaitableTimer session_timer_;
+
+    DISALLOW_COPY_AND_ASSIGN(ClusterConnector);
+};
+
+} // namespace router
+
+#endif // ROUTER__CLUSTER_CONNECTOR_H
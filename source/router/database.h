@@ -22,6 +22,8 @@
 #include "base/peer/host_id.h"
 #include "base/peer/user_list.h"
 
+#include <optional>
+
 namespace router {
 
 class Database
@@ -29,13 +31,30 @@ class Database
 public:
     virtual ~Database() = default;
 
+    struct Host
+    {
+        base::HostId host_id;
+        base::ByteArray key_hash;
+    };
+
     virtual std::vector<base::User> userList() const = 0;
     virtual bool addUser(const base::User& user) = 0;
+
+    // Adds users in one transaction. On failure no users are added.
+    virtual bool addUsers(const std::vector<base::User>& users) = 0;
+
     virtual bool modifyUser(const base::User& user) = 0;
     virtual bool removeUser(int64_t entry_id) = 0;
     virtual base::User findUser(std::u16string_view username) = 0;
     virtual base::HostId hostId(const base::ByteArray& keyHash) const = 0;
     virtual bool addHost(const base::ByteArray& keyHash) = 0;
+
+    // Adds hosts in one transaction. Returns the IDs of the added hosts in the order of
+    // |key_hashes|. On failure no hosts are added and an empty list is returned.
+    virtual std::vector<base::HostId> addHosts(const std::vector<base::ByteArray>& key_hashes) = 0;
+
+    // Returns all registered hosts or std::nullopt on failure.
+    virtual std::optional<std::vector<Host>> hostList() const = 0;
 };
 
 } // namespace router
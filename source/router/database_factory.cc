@@ -0,0 +1,50 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/database_factory.h"
+
+#include "base/logging.h"
+#include "router/database_factory_sqlite.h"
+#include "router/settings.h"
+
+#if defined(USE_POSTGRESQL)
+#include "router/database_factory_postgres.h"
+#endif // defined(USE_POSTGRESQL)
+
+namespace router {
+
+// static
+std::unique_ptr<DatabaseFactory> DatabaseFactory::create()
+{
+    std::string connection_string = Settings().databaseConnection();
+    if (!connection_string.empty())
+    {
+#if defined(USE_POSTGRESQL)
+        LOG(LS_INFO) << "Using PostgreSQL database";
+        return std::make_unique<DatabaseFactoryPostgres>(connection_string);
+#else
+        LOG(LS_WARNING) << "The router is built without PostgreSQL, the connection string is "
+                           "ignored";
+#endif // defined(USE_POSTGRESQL)
+    }
+
+    LOG(LS_INFO) << "Using SQLite database";
+    return std::make_unique<DatabaseFactorySqlite>();
+}
+
+} // namespace router
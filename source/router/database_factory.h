@@ -30,6 +30,10 @@ class DatabaseFactory
 public:
     virtual ~DatabaseFactory() = default;
 
+    // Returns the factory of the database selected in the settings of the router: PostgreSQL if
+    // a connection string is set, otherwise SQLite.
+    static std::unique_ptr<DatabaseFactory> create();
+
     virtual std::unique_ptr<Database> createDatabase() const = 0;
     virtual std::unique_ptr<Database> openDatabase() const = 0;
 };
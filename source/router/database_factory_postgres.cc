@@ -0,0 +1,144 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/database_factory_postgres.h"
+
+#include "base/logging.h"
+#include "router/cached_database.h"
+#include "router/database_postgres.h"
+#include "router/host_id_index.h"
+#include "router/user_cache.h"
+
+#include <mutex>
+#include <vector>
+
+namespace router {
+
+namespace {
+
+// Connections above this number are closed when they are returned to the pool.
+const size_t kMaxIdleConnections = 8;
+
+} // namespace
+
+class DatabaseFactoryPostgres::Pool
+{
+public:
+    explicit Pool(const std::string& connection_string)
+        : connection_string_(connection_string)
+    {
+        // Nothing
+    }
+
+    const std::string& connectionString() const { return connection_string_; }
+
+    std::unique_ptr<DatabasePostgres> take()
+    {
+        {
+            std::scoped_lock lock(lock_);
+
+            if (!idle_.empty())
+            {
+                std::unique_ptr<DatabasePostgres> db = std::move(idle_.back());
+                idle_.pop_back();
+                return db;
+            }
+        }
+
+        // Connecting takes a round trip (and the authentication), it is made without the lock.
+        return DatabasePostgres::open(connection_string_);
+    }
+
+    void release(std::unique_ptr<DatabasePostgres> db)
+    {
+        // Broken connections are not reused.
+        if (!db->isConnected())
+            return;
+
+        std::scoped_lock lock(lock_);
+
+        if (idle_.size() < kMaxIdleConnections)
+            idle_.emplace_back(std::move(db));
+    }
+
+private:
+    const std::string connection_string_;
+
+    std::mutex lock_;
+    std::vector<std::unique_ptr<DatabasePostgres>> idle_;
+
+    DISALLOW_COPY_AND_ASSIGN(Pool);
+};
+
+// Holds a connection of the pool while it is used.
+class DatabaseFactoryPostgres::PooledDatabase : public CachedDatabase
+{
+public:
+    PooledDatabase(std::unique_ptr<DatabasePostgres> db,
+                   std::shared_ptr<Pool> pool,
+                   HostIdIndex* host_id_index,
+                   UserCache* user_cache)
+        : CachedDatabase(db.get(), host_id_index, user_cache),
+          db_(std::move(db)),
+          pool_(std::move(pool))
+    {
+        // Nothing
+    }
+
+    ~PooledDatabase() override
+    {
+        pool_->release(std::move(db_));
+    }
+
+private:
+    std::unique_ptr<DatabasePostgres> db_;
+    std::shared_ptr<Pool> pool_;
+
+    DISALLOW_COPY_AND_ASSIGN(PooledDatabase);
+};
+
+DatabaseFactoryPostgres::DatabaseFactoryPostgres(const std::string& connection_string)
+    : pool_(std::make_shared<Pool>(connection_string)),
+      host_id_index_(std::make_shared<HostIdIndex>()),
+      user_cache_(std::make_shared<UserCache>())
+{
+    // Nothing
+}
+
+DatabaseFactoryPostgres::~DatabaseFactoryPostgres() = default;
+
+std::unique_ptr<Database> DatabaseFactoryPostgres::createDatabase() const
+{
+    return DatabasePostgres::create(pool_->connectionString());
+}
+
+std::unique_ptr<Database> DatabaseFactoryPostgres::openDatabase() const
+{
+    std::unique_ptr<DatabasePostgres> db = pool_->take();
+    if (!db)
+        return nullptr;
+
+    // The index is loaded when the database is opened for the first time (at server startup).
+    if (!host_id_index_->isLoaded())
+        host_id_index_->load(*db);
+
+    return std::make_unique<PooledDatabase>(
+        std::move(db), pool_, host_id_index_.get(), user_cache_.get());
+}
+
+} // namespace router
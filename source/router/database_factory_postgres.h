@@ -0,0 +1,60 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__DATABASE_FACTORY_POSTGRES_H
+#define ROUTER__DATABASE_FACTORY_POSTGRES_H
+
+#include "base/macros_magic.h"
+#include "router/database_factory.h"
+
+#include <memory>
+#include <string>
+
+namespace router {
+
+class HostIdIndex;
+class UserCache;
+
+// Opens the databases from a pool of PostgreSQL connections. A database returned by
+// openDatabase() takes a connection from the pool (or connects if the pool is empty) and returns
+// it when destroyed, so it can be used on any thread. Unlike SQLite connections, the connections
+// are not bound to the threads and their number is limited by the number of the databases in use.
+class DatabaseFactoryPostgres : public DatabaseFactory
+{
+public:
+    explicit DatabaseFactoryPostgres(const std::string& connection_string);
+    ~DatabaseFactoryPostgres();
+
+    std::unique_ptr<Database> createDatabase() const override;
+    std::unique_ptr<Database> openDatabase() const override;
+
+private:
+    class Pool;
+    class PooledDatabase;
+
+    // Shared by the databases of all threads.
+    std::shared_ptr<Pool> pool_;
+    std::shared_ptr<HostIdIndex> host_id_index_;
+    std::shared_ptr<UserCache> user_cache_;
+
+    DISALLOW_COPY_AND_ASSIGN(DatabaseFactoryPostgres);
+};
+
+} // namespace router
+
+#endif // ROUTER__DATABASE_FACTORY_POSTGRES_H
@@ -18,11 +18,19 @@
 
 #include "router/database_factory_sqlite.h"
 
+#include "router/cached_database.h"
 #include "router/database_sqlite.h"
+#include "router/host_id_index.h"
+#include "router/user_cache.h"
 
 namespace router {
 
-DatabaseFactorySqlite::DatabaseFactorySqlite() = default;
+DatabaseFactorySqlite::DatabaseFactorySqlite()
+    : host_id_index_(std::make_shared<HostIdIndex>()),
+      user_cache_(std::make_shared<UserCache>())
+{
+    // Nothing
+}
 
 DatabaseFactorySqlite::~DatabaseFactorySqlite() = default;
 
@@ -33,7 +41,22 @@ std::unique_ptr<Database> DatabaseFactorySqlite::createDatabase() const
 
 std::unique_ptr<Database> DatabaseFactorySqlite::openDatabase() const
 {
-    return DatabaseSqlite::open();
+    // The returned object must be used on the thread that opened it. Opening a connection and
+    // preparing its statements is expensive, so the connection is kept for the lifetime of the
+    // thread.
+    thread_local std::unique_ptr<DatabaseSqlite> db;
+    if (!db)
+    {
+        db = DatabaseSqlite::open();
+        if (!db)
+            return nullptr;
+    }
+
+    // The index is loaded when the database is opened for the first time (at server startup).
+    if (!host_id_index_->isLoaded())
+        host_id_index_->load(*db);
+
+    return std::make_unique<CachedDatabase>(db.get(), host_id_index_.get(), user_cache_.get());
 }
 
 } // namespace router
@@ -22,8 +22,13 @@
 #include "base/macros_magic.h"
 #include "router/database_factory.h"
 
+#include <memory>
+
 namespace router {
 
+class HostIdIndex;
+class UserCache;
+
 class DatabaseFactorySqlite : public DatabaseFactory
 {
 public:
@@ -34,6 +39,10 @@ public:
     std::unique_ptr<Database> openDatabase() const override;
 
 private:
+    // Shared by the databases of all threads.
+    std::shared_ptr<HostIdIndex> host_id_index_;
+    std::shared_ptr<UserCache> user_cache_;
+
     DISALLOW_COPY_AND_ASSIGN(DatabaseFactorySqlite);
 };
 
@@ -0,0 +1,655 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/database_postgres.h"
+
+#include "base/endian_util.h"
+#include "base/logging.h"
+#include "base/strings/unicode.h"
+
+#include <cstring>
+#include <optional>
+
+namespace router {
+
+namespace {
+
+// Types of the parameters (see pg_type.h).
+const Oid kInt4Oid = 23;
+const Oid kInt8Oid = 20;
+const Oid kTextOid = 25;
+const Oid kByteaOid = 17;
+
+// Format of the parameters and the results.
+const int kBinaryFormat = 1;
+
+struct QueryInfo
+{
+    const char* sql;
+    int param_count;
+    Oid param_types[7];
+};
+
+// Queries of DatabasePostgres::Query.
+const QueryInfo kQueries[] =
+{
+    { "SELECT id, name, \"group\", salt, verifier, sessions, flags FROM users", 0, {} },
+    { "INSERT INTO users (name, \"group\", salt, verifier, sessions, flags) "
+      "VALUES ($1, $2, $3, $4, $5, $6)",
+      6, { kTextOid, kTextOid, kByteaOid, kByteaOid, kInt4Oid, kInt4Oid } },
+    { "UPDATE users SET name=$1, \"group\"=$2, salt=$3, verifier=$4, sessions=$5, flags=$6 "
+      "WHERE id=$7",
+      7, { kTextOid, kTextOid, kByteaOid, kByteaOid, kInt4Oid, kInt4Oid, kInt8Oid } },
+    { "DELETE FROM users WHERE id=$1", 1, { kInt8Oid } },
+    { "SELECT id, name, \"group\", salt, verifier, sessions, flags FROM users WHERE name=$1",
+      1, { kTextOid } },
+    { "SELECT id FROM hosts WHERE key=$1", 1, { kByteaOid } },
+    { "INSERT INTO hosts (key) VALUES ($1) RETURNING id", 1, { kByteaOid } },
+    { "SELECT id, key FROM hosts", 0, {} }
+};
+
+static_assert(std::size(kQueries) == static_cast<size_t>(DatabasePostgres::Query::COUNT));
+
+const char kCreateSql[] =
+    "BEGIN;"
+    "CREATE TABLE users ("
+        "id BIGSERIAL PRIMARY KEY,"
+        "name TEXT NOT NULL UNIQUE,"
+        "\"group\" TEXT NOT NULL,"
+        "salt BYTEA NOT NULL,"
+        "verifier BYTEA NOT NULL,"
+        "sessions INTEGER NOT NULL DEFAULT 0,"
+        "flags INTEGER NOT NULL DEFAULT 0);"
+    "CREATE TABLE hosts ("
+        "id BIGSERIAL PRIMARY KEY,"
+        "key BYTEA NOT NULL UNIQUE);"
+    "COMMIT;";
+
+// Frees the result when it goes out of scope.
+class ScopedResult
+{
+public:
+    explicit ScopedResult(PGresult* result)
+        : result_(result)
+    {
+        // Nothing
+    }
+
+    ~ScopedResult()
+    {
+        if (result_)
+            PQclear(result_);
+    }
+
+    PGresult* get() const { return result_; }
+
+private:
+    PGresult* result_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedResult);
+};
+
+template <typename T>
+std::optional<T> readInteger(const PGresult* result, int row, int column)
+{
+    if (PQgetisnull(result, row, column))
+        return std::nullopt;
+
+    const char* value = PQgetvalue(result, row, column);
+
+    switch (PQgetlength(result, row, column))
+    {
+        case sizeof(uint32_t):
+        {
+            uint32_t number;
+            memcpy(&number, value, sizeof(number));
+            return static_cast<T>(static_cast<int32_t>(base::EndianUtil::fromBig(number)));
+        }
+
+        case sizeof(uint64_t):
+        {
+            uint64_t number;
+            memcpy(&number, value, sizeof(number));
+            return static_cast<T>(static_cast<int64_t>(base::EndianUtil::fromBig(number)));
+        }
+
+        default:
+            LOG(LS_ERROR) << "Field is not an integer";
+            return std::nullopt;
+    }
+}
+
+std::optional<base::ByteArray> readBlob(const PGresult* result, int row, int column)
+{
+    if (PQgetisnull(result, row, column))
+        return std::nullopt;
+
+    int size = PQgetlength(result, row, column);
+    if (size <= 0)
+    {
+        LOG(LS_ERROR) << "Field has an invalid size";
+        return std::nullopt;
+    }
+
+    return base::fromData(PQgetvalue(result, row, column), static_cast<size_t>(size));
+}
+
+std::optional<std::string> readText(const PGresult* result, int row, int column)
+{
+    if (PQgetisnull(result, row, column))
+        return std::nullopt;
+
+    int size = PQgetlength(result, row, column);
+    if (size <= 0)
+    {
+        LOG(LS_ERROR) << "Field has an invalid size";
+        return std::nullopt;
+    }
+
+    return std::string(PQgetvalue(result, row, column), static_cast<size_t>(size));
+}
+
+std::optional<base::User> readUser(const PGresult* result, int row)
+{
+    std::optional<int64_t> entry_id = readInteger<int64_t>(result, row, 0);
+    std::optional<std::string> name = readText(result, row, 1);
+    std::optional<std::string> group = readText(result, row, 2);
+    std::optional<base::ByteArray> salt = readBlob(result, row, 3);
+    std::optional<base::ByteArray> verifier = readBlob(result, row, 4);
+    std::optional<uint32_t> sessions = readInteger<uint32_t>(result, row, 5);
+    std::optional<uint32_t> flags = readInteger<uint32_t>(result, row, 6);
+
+    if (!entry_id.has_value() || !name.has_value() || !group.has_value() ||
+        !salt.has_value() || !verifier.has_value() || !sessions.has_value() ||
+        !flags.has_value())
+    {
+        LOG(LS_ERROR) << "Failed to read the fields of a user";
+        return std::nullopt;
+    }
+
+    base::User user;
+
+    user.entry_id  = entry_id.value();
+    user.name      = base::utf16FromUtf8(name.value());
+    user.group     = std::move(group.value());
+    user.salt      = std::move(salt.value());
+    user.verifier  = std::move(verifier.value());
+    user.sessions  = sessions.value();
+    user.flags     = flags.value();
+
+    return user;
+}
+
+bool isSucceeded(const PGresult* result)
+{
+    ExecStatusType status = PQresultStatus(result);
+    return status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK;
+}
+
+} // namespace
+
+// Binary parameters of a prepared statement. The values are referenced, not copied, and must
+// outlive the execution.
+class DatabasePostgres::Params
+{
+public:
+    Params() = default;
+
+    void addText(const std::string& text)
+    {
+        add(text.data(), text.size());
+    }
+
+    void addBlob(const base::ByteArray& blob)
+    {
+        add(blob.data(), blob.size());
+    }
+
+    void addInt(int32_t number)
+    {
+        uint32_t value = base::EndianUtil::toBig(static_cast<uint32_t>(number));
+        std::string& storage = storage_[count_];
+        storage.assign(reinterpret_cast<const char*>(&value), sizeof(value));
+        add(storage.data(), storage.size());
+    }
+
+    void addInt64(int64_t number)
+    {
+        uint64_t value = base::EndianUtil::toBig(static_cast<uint64_t>(number));
+        std::string& storage = storage_[count_];
+        storage.assign(reinterpret_cast<const char*>(&value), sizeof(value));
+        add(storage.data(), storage.size());
+    }
+
+    int count() const { return count_; }
+    const char* const* values() const { return values_; }
+    const int* lengths() const { return lengths_; }
+    const int* formats() const { return formats_; }
+
+private:
+    static const int kMaxParams = 7;
+
+    void add(const void* data, size_t size)
+    {
+        DCHECK_LT(count_, kMaxParams);
+
+        values_[count_] = reinterpret_cast<const char*>(data);
+        lengths_[count_] = static_cast<int>(size);
+        formats_[count_] = kBinaryFormat;
+        ++count_;
+    }
+
+    int count_ = 0;
+    const char* values_[kMaxParams] = {};
+    int lengths_[kMaxParams] = {};
+    int formats_[kMaxParams] = {};
+
+    // Integers in the network byte order.
+    std::string storage_[kMaxParams];
+
+    DISALLOW_COPY_AND_ASSIGN(Params);
+};
+
+DatabasePostgres::DatabasePostgres(PGconn* connection)
+    : connection_(connection)
+{
+    DCHECK(connection_);
+}
+
+DatabasePostgres::~DatabasePostgres()
+{
+    PQfinish(connection_);
+}
+
+// static
+std::unique_ptr<DatabasePostgres> DatabasePostgres::create(const std::string& connection_string)
+{
+    std::unique_ptr<DatabasePostgres> db = open(connection_string);
+    if (!db)
+        return nullptr;
+
+    // The tables are created without IF NOT EXISTS, so an existing database is not reused.
+    if (!db->execute(kCreateSql))
+    {
+        LOG(LS_WARNING) << "Failed to create the tables (the database may already exist)";
+        return nullptr;
+    }
+
+    return db;
+}
+
+// static
+std::unique_ptr<DatabasePostgres> DatabasePostgres::open(const std::string& connection_string)
+{
+    PGconn* connection = PQconnectdb(connection_string.c_str());
+    if (!connection)
+    {
+        LOG(LS_ERROR) << "PQconnectdb failed";
+        return nullptr;
+    }
+
+    if (PQstatus(connection) != CONNECTION_OK)
+    {
+        LOG(LS_ERROR) << "Failed to connect to PostgreSQL: " << PQerrorMessage(connection);
+        PQfinish(connection);
+        return nullptr;
+    }
+
+    return std::unique_ptr<DatabasePostgres>(new DatabasePostgres(connection));
+}
+
+bool DatabasePostgres::isConnected() const
+{
+    return PQstatus(connection_) == CONNECTION_OK;
+}
+
+bool DatabasePostgres::prepare(Query query) const
+{
+    const size_t index = static_cast<size_t>(query);
+    if (prepared_[index])
+        return true;
+
+    const QueryInfo& info = kQueries[index];
+    const std::string name = "aspia_" + std::to_string(index);
+
+    ScopedResult result(PQprepare(
+        connection_, name.c_str(), info.sql, info.param_count, info.param_types));
+    if (!isSucceeded(result.get()))
+    {
+        LOG(LS_ERROR) << "PQprepare failed: " << PQerrorMessage(connection_);
+        return false;
+    }
+
+    prepared_[index] = true;
+    return true;
+}
+
+bool DatabasePostgres::checkConnection() const
+{
+    if (isConnected())
+        return true;
+
+    if (in_transaction_)
+    {
+        // A new session would execute the rest of the transaction without its beginning.
+        LOG(LS_ERROR) << "Connection to PostgreSQL is lost inside a transaction";
+        return false;
+    }
+
+    // The statements of the lost session are gone.
+    LOG(LS_WARNING) << "Connection to PostgreSQL is lost, reconnecting";
+    PQreset(connection_);
+    prepared_.fill(false);
+
+    if (!isConnected())
+    {
+        LOG(LS_ERROR) << "PQreset failed: " << PQerrorMessage(connection_);
+        return false;
+    }
+
+    return true;
+}
+
+bool DatabasePostgres::beginTransaction()
+{
+    DCHECK(!in_transaction_);
+
+    if (!checkConnection() || !execute("BEGIN"))
+        return false;
+
+    in_transaction_ = true;
+    return true;
+}
+
+bool DatabasePostgres::commitTransaction()
+{
+    DCHECK(in_transaction_);
+
+    if (!execute("COMMIT"))
+    {
+        rollbackTransaction();
+        return false;
+    }
+
+    in_transaction_ = false;
+    return true;
+}
+
+void DatabasePostgres::rollbackTransaction()
+{
+    DCHECK(in_transaction_);
+
+    // If the connection is lost, the server has already rolled back the transaction.
+    if (isConnected())
+        execute("ROLLBACK");
+
+    in_transaction_ = false;
+}
+
+PGresult* DatabasePostgres::execute(Query query, const Params& params) const
+{
+    if (!checkConnection())
+        return nullptr;
+
+    if (!prepare(query))
+        return nullptr;
+
+    const size_t index = static_cast<size_t>(query);
+    DCHECK_EQ(params.count(), kQueries[index].param_count);
+
+    const std::string name = "aspia_" + std::to_string(index);
+
+    PGresult* result = PQexecPrepared(connection_, name.c_str(), params.count(), params.values(),
+                                      params.lengths(), params.formats(), kBinaryFormat);
+    if (!isSucceeded(result))
+    {
+        LOG(LS_ERROR) << "PQexecPrepared failed: " << PQerrorMessage(connection_);
+        if (result)
+            PQclear(result);
+        return nullptr;
+    }
+
+    return result;
+}
+
+bool DatabasePostgres::execute(const char* sql)
+{
+    ScopedResult result(PQexec(connection_, sql));
+    if (!isSucceeded(result.get()))
+    {
+        LOG(LS_ERROR) << "PQexec failed: " << PQerrorMessage(connection_);
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<base::User> DatabasePostgres::userList() const
+{
+    ScopedResult result(execute(Query::USER_LIST, Params()));
+    if (!result.get())
+        return std::vector<base::User>();
+
+    std::vector<base::User> users;
+
+    const int rows = PQntuples(result.get());
+    for (int row = 0; row < rows; ++row)
+    {
+        std::optional<base::User> user = readUser(result.get(), row);
+        if (user.has_value())
+            users.emplace_back(std::move(user.value()));
+    }
+
+    return users;
+}
+
+bool DatabasePostgres::addUser(const base::User& user)
+{
+    if (!user.isValid())
+    {
+        LOG(LS_ERROR) << "Not valid user";
+        return false;
+    }
+
+    std::string username = base::utf8FromUtf16(user.name);
+
+    Params params;
+    params.addText(username);
+    params.addText(user.group);
+    params.addBlob(user.salt);
+    params.addBlob(user.verifier);
+    params.addInt(static_cast<int32_t>(user.sessions));
+    params.addInt(static_cast<int32_t>(user.flags));
+
+    ScopedResult result(execute(Query::ADD_USER, params));
+    return result.get() != nullptr;
+}
+
+bool DatabasePostgres::addUsers(const std::vector<base::User>& users)
+{
+    if (users.empty())
+        return true;
+
+    if (!beginTransaction())
+        return false;
+
+    for (const auto& user : users)
+    {
+        if (!addUser(user))
+        {
+            rollbackTransaction();
+            return false;
+        }
+    }
+
+    return commitTransaction();
+}
+
+bool DatabasePostgres::modifyUser(const base::User& user)
+{
+    if (!user.isValid())
+    {
+        LOG(LS_ERROR) << "Not valid user";
+        return false;
+    }
+
+    std::string username = base::utf8FromUtf16(user.name);
+
+    Params params;
+    params.addText(username);
+    params.addText(user.group);
+    params.addBlob(user.salt);
+    params.addBlob(user.verifier);
+    params.addInt(static_cast<int32_t>(user.sessions));
+    params.addInt(static_cast<int32_t>(user.flags));
+    params.addInt64(user.entry_id);
+
+    ScopedResult result(execute(Query::MODIFY_USER, params));
+    return result.get() != nullptr;
+}
+
+bool DatabasePostgres::removeUser(int64_t entry_id)
+{
+    Params params;
+    params.addInt64(entry_id);
+
+    ScopedResult result(execute(Query::REMOVE_USER, params));
+    return result.get() != nullptr;
+}
+
+base::User DatabasePostgres::findUser(std::u16string_view username)
+{
+    std::string username_utf8 = base::utf8FromUtf16(username);
+
+    Params params;
+    params.addText(username_utf8);
+
+    ScopedResult result(execute(Query::FIND_USER, params));
+    if (!result.get() || PQntuples(result.get()) < 1)
+        return base::User::kInvalidUser;
+
+    return readUser(result.get(), 0).value_or(base::User::kInvalidUser);
+}
+
+base::HostId DatabasePostgres::hostId(const base::ByteArray& keyHash) const
+{
+    if (keyHash.empty())
+    {
+        LOG(LS_ERROR) << "Invalid parameters";
+        return base::kInvalidHostId;
+    }
+
+    Params params;
+    params.addBlob(keyHash);
+
+    ScopedResult result(execute(Query::HOST_ID, params));
+    if (!result.get() || PQntuples(result.get()) < 1)
+        return base::kInvalidHostId;
+
+    std::optional<int64_t> entry_id = readInteger<int64_t>(result.get(), 0, 0);
+    if (!entry_id.has_value())
+    {
+        LOG(LS_ERROR) << "Failed to get field 'id'";
+        return base::kInvalidHostId;
+    }
+
+    return static_cast<base::HostId>(entry_id.value());
+}
+
+bool DatabasePostgres::addHost(const base::ByteArray& keyHash)
+{
+    return insertHost(keyHash) != base::kInvalidHostId;
+}
+
+std::vector<base::HostId> DatabasePostgres::addHosts(
+    const std::vector<base::ByteArray>& key_hashes)
+{
+    if (key_hashes.empty())
+        return std::vector<base::HostId>();
+
+    if (!beginTransaction())
+        return std::vector<base::HostId>();
+
+    std::vector<base::HostId> host_ids;
+    host_ids.reserve(key_hashes.size());
+
+    for (const auto& key_hash : key_hashes)
+    {
+        base::HostId host_id = insertHost(key_hash);
+        if (host_id == base::kInvalidHostId)
+        {
+            rollbackTransaction();
+            return std::vector<base::HostId>();
+        }
+
+        host_ids.emplace_back(host_id);
+    }
+
+    if (!commitTransaction())
+        return std::vector<base::HostId>();
+
+    return host_ids;
+}
+
+std::optional<std::vector<Database::Host>> DatabasePostgres::hostList() const
+{
+    ScopedResult result(execute(Query::HOST_LIST, Params()));
+    if (!result.get())
+        return std::nullopt;
+
+    std::vector<Host> hosts;
+
+    const int rows = PQntuples(result.get());
+    hosts.reserve(static_cast<size_t>(rows));
+
+    for (int row = 0; row < rows; ++row)
+    {
+        std::optional<int64_t> entry_id = readInteger<int64_t>(result.get(), row, 0);
+        std::optional<base::ByteArray> key_hash = readBlob(result.get(), row, 1);
+        if (!entry_id.has_value() || !key_hash.has_value())
+            continue;
+
+        hosts.push_back({ static_cast<base::HostId>(*entry_id), std::move(*key_hash) });
+    }
+
+    return hosts;
+}
+
+base::HostId DatabasePostgres::insertHost(const base::ByteArray& keyHash)
+{
+    if (keyHash.empty())
+    {
+        LOG(LS_ERROR) << "Invalid parameters";
+        return base::kInvalidHostId;
+    }
+
+    Params params;
+    params.addBlob(keyHash);
+
+    ScopedResult result(execute(Query::ADD_HOST, params));
+    if (!result.get() || PQntuples(result.get()) < 1)
+        return base::kInvalidHostId;
+
+    std::optional<int64_t> entry_id = readInteger<int64_t>(result.get(), 0, 0);
+    if (!entry_id.has_value())
+        return base::kInvalidHostId;
+
+    return static_cast<base::HostId>(entry_id.value());
+}
+
+} // namespace router
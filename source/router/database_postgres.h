@@ -0,0 +1,110 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__DATABASE_POSTGRES_H
+#define ROUTER__DATABASE_POSTGRES_H
+
+#include "base/macros_magic.h"
+#include "router/database.h"
+
+#include <array>
+#include <string>
+
+#include <libpq-fe.h>
+
+namespace router {
+
+// A connection to a PostgreSQL server. Unlike the SQLite database, the server serves many
+// connections (and many routers of a cluster) at the same time without a global write lock.
+// Parameters and results are passed in the binary format. A connection must be used by one
+// thread at a time.
+class DatabasePostgres : public Database
+{
+public:
+    ~DatabasePostgres();
+
+    // |connection_string| is a libpq connection string ("host=... dbname=... user=...").
+    // create() fails if the tables already exist.
+    static std::unique_ptr<DatabasePostgres> create(const std::string& connection_string);
+    static std::unique_ptr<DatabasePostgres> open(const std::string& connection_string);
+
+    // Returns false if the connection is lost. A lost connection is reset on the next query
+    // outside a transaction.
+    bool isConnected() const;
+
+    // Database implementation.
+    std::vector<base::User> userList() const override;
+    bool addUser(const base::User& user) override;
+    bool addUsers(const std::vector<base::User>& users) override;
+    bool modifyUser(const base::User& user) override;
+    bool removeUser(int64_t entry_id) override;
+    base::User findUser(std::u16string_view username) override;
+    base::HostId hostId(const base::ByteArray& keyHash) const override;
+    bool addHost(const base::ByteArray& keyHash) override;
+    std::vector<base::HostId> addHosts(const std::vector<base::ByteArray>& key_hashes) override;
+    std::optional<std::vector<Host>> hostList() const override;
+
+    // Statements are prepared on first use and are kept for the lifetime of the connection.
+    enum class Query
+    {
+        USER_LIST,
+        ADD_USER,
+        MODIFY_USER,
+        REMOVE_USER,
+        FIND_USER,
+        HOST_ID,
+        ADD_HOST,
+        HOST_LIST,
+        COUNT
+    };
+
+    class Params;
+
+private:
+    explicit DatabasePostgres(PGconn* connection);
+
+    // Executes the prepared statement of |query|. Returns nullptr on failure, otherwise the result
+    // must be freed with PQclear.
+    PGresult* execute(Query query, const Params& params) const;
+
+    // Executes a statement without parameters and results (for example, "BEGIN").
+    bool execute(const char* sql);
+
+    bool prepare(Query query) const;
+
+    // Resets a lost connection. The statements of a transaction are lost with the session of the
+    // server, so inside a transaction the connection is not reset and false is returned.
+    bool checkConnection() const;
+
+    bool beginTransaction();
+    bool commitTransaction();
+    void rollbackTransaction();
+
+    // Inserts the host and returns its ID.
+    base::HostId insertHost(const base::ByteArray& keyHash);
+
+    PGconn* connection_;
+    mutable std::array<bool, static_cast<size_t>(Query::COUNT)> prepared_ {};
+    bool in_transaction_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(DatabasePostgres);
+};
+
+} // namespace router
+
+#endif // ROUTER__DATABASE_POSTGRES_H
@@ -29,6 +29,53 @@ namespace router {
 
 namespace {
 
+// Time in milliseconds during which a connection waits for a lock of another connection.
+const int kBusyTimeout = 5000;
+
+// Queries of DatabaseSqlite::Query.
+const char* kQueries[] =
+{
+    "SELECT * FROM users",
+    "INSERT INTO users ('id', 'name', 'group', 'salt', 'verifier', 'sessions', 'flags') "
+    "VALUES (NULL, ?, ?, ?, ?, ?, ?)",
+    "UPDATE users SET ('name', 'group', 'salt', 'verifier', 'sessions', 'flags') = "
+    "(?, ?, ?, ?, ?, ?) WHERE id=?",
+    "DELETE FROM users WHERE id=?",
+    "SELECT * FROM users WHERE name=?",
+    "SELECT * FROM hosts WHERE key=?",
+    "INSERT INTO hosts ('id', 'key') VALUES (NULL, ?)",
+    "SELECT id, key FROM hosts"
+};
+
+static_assert(std::size(kQueries) == static_cast<size_t>(DatabaseSqlite::Query::COUNT));
+
+// Resets a prepared statement for the next use when it goes out of scope.
+class ScopedStatement
+{
+public:
+    explicit ScopedStatement(sqlite3_stmt* statement)
+        : statement_(statement)
+    {
+        // Nothing
+    }
+
+    ~ScopedStatement()
+    {
+        if (!statement_)
+            return;
+
+        sqlite3_reset(statement_);
+        sqlite3_clear_bindings(statement_);
+    }
+
+    sqlite3_stmt* get() const { return statement_; }
+
+private:
+    sqlite3_stmt* statement_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedStatement);
+};
+
 bool writeText(sqlite3_stmt* statement, const std::string& text, int column)
 {
     int error_code = sqlite3_bind_text(
@@ -230,13 +277,27 @@ DatabaseSqlite::DatabaseSqlite(sqlite3* db)
 
 DatabaseSqlite::~DatabaseSqlite()
 {
+    for (sqlite3_stmt* statement : statements_)
+        sqlite3_finalize(statement);
+
     sqlite3_close(db_);
 }
 
 // static
 std::unique_ptr<DatabaseSqlite> DatabaseSqlite::create()
 {
-    std::filesystem::path file_path = filePath();
+    return create(filePath());
+}
+
+// static
+std::unique_ptr<DatabaseSqlite> DatabaseSqlite::open()
+{
+    return open(filePath());
+}
+
+// static
+std::unique_ptr<DatabaseSqlite> DatabaseSqlite::create(const std::filesystem::path& file_path)
+{
     if (file_path.empty())
     {
         LOG(LS_WARNING) << "Invalid file path";
@@ -250,7 +311,7 @@ std::unique_ptr<DatabaseSqlite> DatabaseSqlite::create()
         return nullptr;
     }
 
-    std::unique_ptr<DatabaseSqlite> db = open();
+    std::unique_ptr<DatabaseSqlite> db = open(file_path);
     if (!db)
         return nullptr;
 
@@ -282,9 +343,8 @@ std::unique_ptr<DatabaseSqlite> DatabaseSqlite::create()
 }
 
 // static
-std::unique_ptr<DatabaseSqlite> DatabaseSqlite::open()
+std::unique_ptr<DatabaseSqlite> DatabaseSqlite::open(const std::filesystem::path& file_path)
 {
-    std::filesystem::path file_path = filePath();
     if (file_path.empty())
     {
         LOG(LS_WARNING) << "Invalid file path";
@@ -300,9 +360,26 @@ std::unique_ptr<DatabaseSqlite> DatabaseSqlite::open()
     if (error_code != SQLITE_OK)
     {
         LOG(LS_WARNING) << "sqlite3_open failed: " << sqlite3_errstr(error_code);
+        sqlite3_close(db);
         return nullptr;
     }
 
+    // With the write-ahead log, readers do not block the writer and a commit does not rewrite the
+    // database file. With synchronous=NORMAL, the log is synced at checkpoints only. A power
+    // failure can lose the last commits, but cannot corrupt the database.
+    const char kPragmas[] = "PRAGMA journal_mode=WAL;PRAGMA synchronous=NORMAL;";
+
+    char* error_string = nullptr;
+    error_code = sqlite3_exec(db, kPragmas, nullptr, nullptr, &error_string);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_WARNING) << "sqlite3_exec failed: " << (error_string ? error_string : "");
+        sqlite3_free(error_string);
+    }
+
+    // Connections of different threads wait for each other instead of failing with SQLITE_BUSY.
+    sqlite3_busy_timeout(db, kBusyTimeout);
+
     return std::unique_ptr<DatabaseSqlite>(new DatabaseSqlite(db));
 }
 
@@ -325,18 +402,48 @@ std::filesystem::path DatabaseSqlite::filePath()
     return file_path;
 }
 
-std::vector<base::User> DatabaseSqlite::userList() const
+sqlite3_stmt* DatabaseSqlite::preparedStatement(Query query) const
 {
-    const char kQuery[] = "SELECT * FROM users";
+    sqlite3_stmt*& statement = statements_[static_cast<size_t>(query)];
+    if (statement)
+        return statement;
+
+    const char* sql = kQueries[static_cast<size_t>(query)];
 
-    sqlite3_stmt* statement;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
+    int error_code = sqlite3_prepare_v3(
+        db_, sql, -1, SQLITE_PREPARE_PERSISTENT, &statement, nullptr);
     if (error_code != SQLITE_OK)
     {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
-        return std::vector<base::User>();
+        LOG(LS_ERROR) << "sqlite3_prepare_v3 failed: " << sqlite3_errstr(error_code);
+        statement = nullptr;
+    }
+
+    return statement;
+}
+
+bool DatabaseSqlite::execute(const char* sql)
+{
+    char* error_message = nullptr;
+
+    int error_code = sqlite3_exec(db_, sql, nullptr, nullptr, &error_message);
+    if (error_code != SQLITE_OK)
+    {
+        LOG(LS_ERROR) << "sqlite3_exec failed: " << (error_message ? error_message : "")
+                      << " (" << error_code << ")";
+        sqlite3_free(error_message);
+        return false;
     }
 
+    return true;
+}
+
+std::vector<base::User> DatabaseSqlite::userList() const
+{
+    ScopedStatement scoped_statement(preparedStatement(Query::USER_LIST));
+    sqlite3_stmt* statement = scoped_statement.get();
+    if (!statement)
+        return std::vector<base::User>();
+
     std::vector<base::User> users;
     for (;;)
     {
@@ -348,7 +455,6 @@ std::vector<base::User> DatabaseSqlite::userList() const
             users.emplace_back(std::move(user.value()));
     }
 
-    sqlite3_finalize(statement);
     return users;
 }
 
@@ -360,17 +466,10 @@ bool DatabaseSqlite::addUser(const base::User& user)
         return false;
     }
 
-    static const char kQuery[] =
-        "INSERT INTO users ('id', 'name', 'group', 'salt', 'verifier', 'sessions', 'flags') "
-        "VALUES (NULL, ?, ?, ?, ?, ?, ?)";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    ScopedStatement scoped_statement(preparedStatement(Query::ADD_USER));
+    sqlite3_stmt* statement = scoped_statement.get();
+    if (!statement)
         return false;
-    }
 
     std::string username = base::utf8FromUtf16(user.name);
     bool result = false;
@@ -395,7 +494,7 @@ bool DatabaseSqlite::addUser(const base::User& user)
         if (!writeInt(statement, static_cast<int>(user.flags), 6))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_DONE)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code);
@@ -406,30 +505,48 @@ bool DatabaseSqlite::addUser(const base::User& user)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
-bool DatabaseSqlite::modifyUser(const base::User& user)
+bool DatabaseSqlite::addUsers(const std::vector<base::User>& users)
 {
-    if (!user.isValid())
+    if (users.empty())
+        return true;
+
+    if (!execute("BEGIN IMMEDIATE"))
+        return false;
+
+    for (const auto& user : users)
     {
-        LOG(LS_ERROR) << "Not valid user";
+        if (!addUser(user))
+        {
+            execute("ROLLBACK");
+            return false;
+        }
+    }
+
+    if (!execute("COMMIT"))
+    {
+        execute("ROLLBACK");
         return false;
     }
 
-    static const char kQuery[] =
-        "UPDATE users SET ('name', 'group', 'salt', 'verifier', 'sessions', 'flags') = "
-        "(?, ?, ?, ?, ?, ?) WHERE id=?";
+    return true;
+}
 
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
+bool DatabaseSqlite::modifyUser(const base::User& user)
+{
+    if (!user.isValid())
     {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+        LOG(LS_ERROR) << "Not valid user";
         return false;
     }
 
+    ScopedStatement scoped_statement(preparedStatement(Query::MODIFY_USER));
+    sqlite3_stmt* statement = scoped_statement.get();
+    if (!statement)
+        return false;
+
     std::string username = base::utf8FromUtf16(user.name);
     bool result = false;
 
@@ -456,7 +573,7 @@ bool DatabaseSqlite::modifyUser(const base::User& user)
         if (!writeInt64(statement, user.entry_id, 7))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_DONE)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code);
@@ -467,21 +584,15 @@ bool DatabaseSqlite::modifyUser(const base::User& user)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
 bool DatabaseSqlite::removeUser(int64_t entry_id)
 {
-    static const char kQuery[] = "DELETE FROM users WHERE id=?";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    ScopedStatement scoped_statement(preparedStatement(Query::REMOVE_USER));
+    sqlite3_stmt* statement = scoped_statement.get();
+    if (!statement)
         return false;
-    }
 
     bool result = false;
 
@@ -490,7 +601,7 @@ bool DatabaseSqlite::removeUser(int64_t entry_id)
         if (!writeInt64(statement, entry_id, 1))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_DONE)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code);
@@ -501,21 +612,15 @@ bool DatabaseSqlite::removeUser(int64_t entry_id)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
 base::User DatabaseSqlite::findUser(std::u16string_view username)
 {
-    const char kQuery[] = "SELECT * FROM users WHERE name=?";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    ScopedStatement scoped_statement(preparedStatement(Query::FIND_USER));
+    sqlite3_stmt* statement = scoped_statement.get();
+    if (!statement)
         return base::User::kInvalidUser;
-    }
 
     std::string username_utf8 = base::utf8FromUtf16(username);
     std::optional<base::User> user;
@@ -532,7 +637,6 @@ base::User DatabaseSqlite::findUser(std::u16string_view username)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return user.value_or(base::User::kInvalidUser);
 }
 
@@ -544,15 +648,10 @@ base::HostId DatabaseSqlite::hostId(const base::ByteArray& keyHash) const
         return base::kInvalidHostId;
     }
 
-    const char kQuery[] = "SELECT * FROM hosts WHERE key=?";
-
-    sqlite3_stmt* statement;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    ScopedStatement scoped_statement(preparedStatement(Query::HOST_ID));
+    sqlite3_stmt* statement = scoped_statement.get();
+    if (!statement)
         return base::kInvalidHostId;
-    }
 
     base::HostId result = base::kInvalidHostId;
 
@@ -561,7 +660,8 @@ base::HostId DatabaseSqlite::hostId(const base::ByteArray& keyHash) const
         if (!writeBlob(statement, keyHash, 1))
             break;
 
-        if (sqlite3_step(statement) != SQLITE_ROW)
+        int error_code = sqlite3_step(statement);
+        if (error_code != SQLITE_ROW)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code);
             break;
@@ -578,7 +678,6 @@ base::HostId DatabaseSqlite::hostId(const base::ByteArray& keyHash) const
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
@@ -590,15 +689,10 @@ bool DatabaseSqlite::addHost(const base::ByteArray& keyHash)
         return false;
     }
 
-    const char kQuery[] = "INSERT INTO hosts ('id', 'key') VALUES (NULL, ?)";
-
-    sqlite3_stmt* statement = nullptr;
-    int error_code = sqlite3_prepare(db_, kQuery, std::size(kQuery), &statement, nullptr);
-    if (error_code != SQLITE_OK)
-    {
-        LOG(LS_ERROR) << "sqlite3_prepare failed: " << sqlite3_errstr(error_code);
+    ScopedStatement scoped_statement(preparedStatement(Query::ADD_HOST));
+    sqlite3_stmt* statement = scoped_statement.get();
+    if (!statement)
         return false;
-    }
 
     bool result = false;
 
@@ -607,7 +701,7 @@ bool DatabaseSqlite::addHost(const base::ByteArray& keyHash)
         if (!writeBlob(statement, keyHash, 1))
             break;
 
-        error_code = sqlite3_step(statement);
+        int error_code = sqlite3_step(statement);
         if (error_code != SQLITE_DONE)
         {
             LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code)
@@ -619,8 +713,69 @@ bool DatabaseSqlite::addHost(const base::ByteArray& keyHash)
     }
     while (false);
 
-    sqlite3_finalize(statement);
     return result;
 }
 
+std::vector<base::HostId> DatabaseSqlite::addHosts(const std::vector<base::ByteArray>& key_hashes)
+{
+    if (key_hashes.empty())
+        return std::vector<base::HostId>();
+
+    if (!execute("BEGIN IMMEDIATE"))
+        return std::vector<base::HostId>();
+
+    std::vector<base::HostId> host_ids;
+    host_ids.reserve(key_hashes.size());
+
+    for (const auto& key_hash : key_hashes)
+    {
+        if (!addHost(key_hash))
+        {
+            execute("ROLLBACK");
+            return std::vector<base::HostId>();
+        }
+
+        host_ids.emplace_back(static_cast<base::HostId>(sqlite3_last_insert_rowid(db_)));
+    }
+
+    if (!execute("COMMIT"))
+    {
+        execute("ROLLBACK");
+        return std::vector<base::HostId>();
+    }
+
+    return host_ids;
+}
+
+std::optional<std::vector<Database::Host>> DatabaseSqlite::hostList() const
+{
+    ScopedStatement scoped_statement(preparedStatement(Query::HOST_LIST));
+    sqlite3_stmt* statement = scoped_statement.get();
+    if (!statement)
+        return std::nullopt;
+
+    std::vector<Host> hosts;
+    for (;;)
+    {
+        int error_code = sqlite3_step(statement);
+        if (error_code == SQLITE_DONE)
+            break;
+
+        if (error_code != SQLITE_ROW)
+        {
+            LOG(LS_ERROR) << "sqlite3_step failed: " << sqlite3_errstr(error_code);
+            return std::nullopt;
+        }
+
+        std::optional<int64_t> entry_id = readInteger<int64_t>(statement, 0);
+        std::optional<base::ByteArray> key_hash = readBlob(statement, 1);
+        if (!entry_id.has_value() || !key_hash.has_value())
+            continue;
+
+        hosts.push_back({ static_cast<base::HostId>(*entry_id), std::move(*key_hash) });
+    }
+
+    return hosts;
+}
+
 } // namespace router
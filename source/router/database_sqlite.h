@@ -22,6 +22,7 @@
 #include "base/macros_magic.h"
 #include "router/database.h"
 
+#include <array>
 #include <filesystem>
 
 #include <sqlite3.h>
@@ -35,21 +36,49 @@ public:
 
     static std::unique_ptr<DatabaseSqlite> create();
     static std::unique_ptr<DatabaseSqlite> open();
+
+    // Same as above, but the database is in |file_path| instead of filePath().
+    static std::unique_ptr<DatabaseSqlite> create(const std::filesystem::path& file_path);
+    static std::unique_ptr<DatabaseSqlite> open(const std::filesystem::path& file_path);
     static std::filesystem::path filePath();
 
     // Database implementation.
     std::vector<base::User> userList() const override;
     bool addUser(const base::User& user) override;
+    bool addUsers(const std::vector<base::User>& users) override;
     bool modifyUser(const base::User& user) override;
     bool removeUser(int64_t entry_id) override;
     base::User findUser(std::u16string_view username) override;
     base::HostId hostId(const base::ByteArray& keyHash) const override;
     bool addHost(const base::ByteArray& keyHash) override;
+    std::vector<base::HostId> addHosts(const std::vector<base::ByteArray>& key_hashes) override;
+    std::optional<std::vector<Host>> hostList() const override;
+
+    // Statements are prepared on first use and are kept for the lifetime of the connection.
+    enum class Query
+    {
+        USER_LIST,
+        ADD_USER,
+        MODIFY_USER,
+        REMOVE_USER,
+        FIND_USER,
+        HOST_ID,
+        ADD_HOST,
+        HOST_LIST,
+        COUNT
+    };
 
 private:
     explicit DatabaseSqlite(sqlite3* db);
 
+    // Returns the prepared statement for |query| or nullptr on failure.
+    sqlite3_stmt* preparedStatement(Query query) const;
+
+    // Executes a statement without parameters and results (for example, "BEGIN").
+    bool execute(const char* sql);
+
     sqlite3* db_;
+    mutable std::array<sqlite3_stmt*, static_cast<size_t>(Query::COUNT)> statements_ {};
 
     DISALLOW_COPY_AND_ASSIGN(DatabaseSqlite);
 };
@@ -0,0 +1,158 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/database_worker.h"
+
+#include "base/logging.h"
+#include "router/database.h"
+#include "router/database_factory.h"
+
+#include <algorithm>
+
+namespace router {
+
+namespace {
+
+// Maximum number of hosts written in one transaction.
+const size_t kMaxHostsPerTransaction = 256;
+
+} // namespace
+
+DatabaseWorker::DatabaseWorker(std::shared_ptr<DatabaseFactory> database_factory)
+    : database_factory_(std::move(database_factory))
+{
+    DCHECK(database_factory_);
+
+    thread_.start(base::MessageLoop::Type::DEFAULT);
+    task_runner_ = thread_.taskRunner();
+    DCHECK(task_runner_);
+}
+
+DatabaseWorker::~DatabaseWorker()
+{
+    // The database can only be used on the thread that opened it. Pending tasks are completed
+    // before the thread exits.
+    task_runner_->postTask([this]()
+    {
+        database_.reset();
+    });
+
+    thread_.stop();
+}
+
+void DatabaseWorker::postTask(Task task)
+{
+    ++pending_count_;
+
+    task_runner_->postTask([this, task = std::move(task), post_time = Clock::now()]()
+    {
+        --pending_count_;
+
+        const Clock::time_point start_time = Clock::now();
+        task(database());
+        addQueryTime(post_time, start_time);
+    });
+}
+
+void DatabaseWorker::addHost(base::ByteArray key_hash,
+                             std::shared_ptr<base::TaskRunner> reply_runner,
+                             HostIdCallback callback)
+{
+    bool schedule_write;
+
+    {
+        std::scoped_lock lock(pending_hosts_lock_);
+
+        // If there are pending hosts, the write is already scheduled and the new host is written
+        // together with them.
+        schedule_write = pending_hosts_.empty();
+        if (schedule_write)
+            pending_hosts_time_ = Clock::now();
+
+        pending_hosts_.push_back(
+            { std::move(key_hash), std::move(reply_runner), std::move(callback) });
+        ++pending_count_;
+    }
+
+    if (schedule_write)
+        task_runner_->postTask(std::bind(&DatabaseWorker::writePendingHosts, this));
+}
+
+Database* DatabaseWorker::database()
+{
+    DCHECK(task_runner_->belongsToCurrentThread());
+
+    if (!database_)
+    {
+        database_ = database_factory_->openDatabase();
+        if (!database_)
+            LOG(LS_ERROR) << "Failed to connect to database";
+    }
+
+    return database_.get();
+}
+
+void DatabaseWorker::writePendingHosts()
+{
+    const Clock::time_point start_time = Clock::now();
+    std::vector<PendingHost> pending_hosts;
+    Clock::time_point post_time;
+
+    {
+        std::scoped_lock lock(pending_hosts_lock_);
+        pending_hosts.swap(pending_hosts_);
+        post_time = pending_hosts_time_;
+        pending_count_ -= pending_hosts.size();
+    }
+
+    Database* db = database();
+
+    for (size_t offset = 0; offset < pending_hosts.size(); offset += kMaxHostsPerTransaction)
+    {
+        size_t count = std::min(kMaxHostsPerTransaction, pending_hosts.size() - offset);
+
+        std::vector<base::ByteArray> key_hashes;
+        key_hashes.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+            key_hashes.emplace_back(std::move(pending_hosts[offset + i].key_hash));
+
+        std::vector<base::HostId> host_ids;
+        if (db)
+            host_ids = db->addHosts(key_hashes);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            base::HostId host_id = i < host_ids.size() ? host_ids[i] : base::kInvalidHostId;
+            PendingHost& host = pending_hosts[offset + i];
+
+            host.reply_runner->postTask(std::bind(std::move(host.callback), host_id));
+        }
+    }
+
+    addQueryTime(post_time, start_time);
+}
+
+void DatabaseWorker::addQueryTime(Clock::time_point post_time, Clock::time_point start_time)
+{
+    queue_wait_.add(std::chrono::duration_cast<std::chrono::microseconds>(start_time - post_time));
+    query_time_.add(std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - start_time));
+}
+
+} // namespace router
@@ -0,0 +1,125 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__DATABASE_WORKER_H
+#define ROUTER__DATABASE_WORKER_H
+
+#include "base/latency_histogram.h"
+#include "base/macros_magic.h"
+#include "base/task_runner.h"
+#include "base/memory/byte_array.h"
+#include "base/peer/host_id.h"
+#include "base/threading/thread.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace router {
+
+class Database;
+class DatabaseFactory;
+
+// Serves database requests on a dedicated thread so that network threads do not wait for the
+// disk. Results are posted back to the task runner of the caller.
+class DatabaseWorker
+{
+public:
+    explicit DatabaseWorker(std::shared_ptr<DatabaseFactory> database_factory);
+    ~DatabaseWorker();
+
+    // |database| is nullptr if the database could not be opened.
+    using Task = std::function<void(Database* database)>;
+    using HostIdCallback = std::function<void(base::HostId host_id)>;
+
+    // Runs |task| on the database thread.
+    void postTask(Task task);
+
+    // Runs |task| on the database thread and then calls |reply| with its result on |reply_runner|.
+    template <typename Result>
+    void postTaskAndReply(std::function<Result(Database* database)> task,
+                          std::shared_ptr<base::TaskRunner> reply_runner,
+                          std::function<void(Result result)> reply)
+    {
+        postTask([task = std::move(task), reply_runner = std::move(reply_runner),
+                  reply = std::move(reply)](Database* database)
+        {
+            std::shared_ptr<Result> result = std::make_shared<Result>(task(database));
+            reply_runner->postTask([reply, result]()
+            {
+                reply(std::move(*result));
+            });
+        });
+    }
+
+    // Adds a host with |key_hash| and calls |callback| with the ID of the host on |reply_runner|.
+    // On failure the ID is base::kInvalidHostId. Hosts that are added while the database thread is
+    // busy are written in one transaction.
+    void addHost(base::ByteArray key_hash,
+                 std::shared_ptr<base::TaskRunner> reply_runner,
+                 HostIdCallback callback);
+
+    // Time the tasks wait for the database thread and the time of the queries (a task or a
+    // transaction of added hosts). Can be called from any thread.
+    const base::LatencyHistogram& queueWait() const { return queue_wait_; }
+    const base::LatencyHistogram& queryTime() const { return query_time_; }
+
+    // Number of the tasks and the added hosts which wait for the database thread. Can be called
+    // from any thread.
+    size_t pendingCount() const { return pending_count_; }
+
+private:
+    struct PendingHost
+    {
+        base::ByteArray key_hash;
+        std::shared_ptr<base::TaskRunner> reply_runner;
+        HostIdCallback callback;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    // Called on the database thread. Adds the times of a query posted at |post_time| which started
+    // at |start_time|.
+    void addQueryTime(Clock::time_point post_time, Clock::time_point start_time);
+
+    // Called on the database thread.
+    Database* database();
+    void writePendingHosts();
+
+    std::shared_ptr<DatabaseFactory> database_factory_;
+    std::unique_ptr<Database> database_;
+
+    base::Thread thread_;
+    std::shared_ptr<base::TaskRunner> task_runner_;
+
+    std::mutex pending_hosts_lock_;
+    std::vector<PendingHost> pending_hosts_;
+    Clock::time_point pending_hosts_time_;
+
+    base::LatencyHistogram queue_wait_;
+    base::LatencyHistogram query_time_;
+
+    std::atomic<size_t> pending_count_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(DatabaseWorker);
+};
+
+} // namespace router
+
+#endif // ROUTER__DATABASE_WORKER_H
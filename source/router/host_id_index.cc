@@ -0,0 +1,83 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/host_id_index.h"
+
+#include "base/logging.h"
+#include "router/database.h"
+
+#include <mutex>
+
+namespace router {
+
+HostIdIndex::HostIdIndex() = default;
+
+HostIdIndex::~HostIdIndex() = default;
+
+bool HostIdIndex::load(const Database& database)
+{
+    std::optional<std::vector<Database::Host>> host_list = database.hostList();
+    if (!host_list.has_value())
+    {
+        LOG(LS_ERROR) << "Unable to load host list";
+        return false;
+    }
+
+    std::unordered_map<std::string, base::HostId> hosts;
+    hosts.reserve(host_list->size());
+
+    for (const auto& host : *host_list)
+        hosts.emplace(base::toStdString(host.key_hash), host.host_id);
+
+    std::unique_lock lock(lock_);
+
+    // Hosts added while the list was being read are already in the index.
+    hosts_.merge(hosts);
+    loaded_ = true;
+
+    LOG(LS_INFO) << "Host index loaded (" << hosts_.size() << " hosts)";
+    return true;
+}
+
+bool HostIdIndex::isLoaded() const
+{
+    std::shared_lock lock(lock_);
+    return loaded_;
+}
+
+base::HostId HostIdIndex::find(const base::ByteArray& key_hash) const
+{
+    std::shared_lock lock(lock_);
+
+    auto it = hosts_.find(base::toStdString(key_hash));
+    if (it == hosts_.end())
+        return base::kInvalidHostId;
+
+    return it->second;
+}
+
+void HostIdIndex::add(const base::ByteArray& key_hash, base::HostId host_id)
+{
+    if (key_hash.empty() || host_id == base::kInvalidHostId)
+        return;
+
+    std::unique_lock lock(lock_);
+    hosts_.insert_or_assign(base::toStdString(key_hash), host_id);
+}
+
+} // namespace router
@@ -0,0 +1,60 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__HOST_ID_INDEX_H
+#define ROUTER__HOST_ID_INDEX_H
+
+#include "base/macros_magic.h"
+#include "base/memory/byte_array.h"
+#include "base/peer/host_id.h"
+
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace router {
+
+class Database;
+
+// In-memory index from the hash of a host key to the host ID. Keeps host registration off the
+// disk on the common path. The class is thread-safe.
+class HostIdIndex
+{
+public:
+    HostIdIndex();
+    ~HostIdIndex();
+
+    // Loads all hosts from |database|. Entries added before the load are kept.
+    bool load(const Database& database);
+    bool isLoaded() const;
+
+    // Returns base::kInvalidHostId if |key_hash| is not in the index.
+    base::HostId find(const base::ByteArray& key_hash) const;
+    void add(const base::ByteArray& key_hash, base::HostId host_id);
+
+private:
+    mutable std::shared_mutex lock_;
+    std::unordered_map<std::string, base::HostId> hosts_;
+    bool loaded_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(HostIdIndex);
+};
+
+} // namespace router
+
+#endif // ROUTER__HOST_ID_INDEX_H
@@ -22,16 +22,22 @@
 #include "base/files/base_paths.h"
 #include "base/files/file_util.h"
 #include "base/peer/user.h"
+#include "base/strings/unicode.h"
 #include "router/database_factory_sqlite.h"
 #include "router/database.h"
 #include "router/settings.h"
 
+#if defined(USE_POSTGRESQL)
+#include "router/database_factory_postgres.h"
+#endif // defined(USE_POSTGRESQL)
+
 #if defined(OS_WIN)
 #include "router/win/service.h"
 #include "router/win/service_util.h"
 #else
 #include "base/crypto/scoped_crypto_initializer.h"
 #include "base/message_loop/message_loop.h"
+#include "base/trace_dumper.h"
 #include "router/server.h"
 #endif
 
@@ -45,6 +51,7 @@ void initLogging()
 
     base::LoggingSettings logging_settings;
     logging_settings.min_log_level = settings.minLogLevel();
+    logging_settings.asynchronous = true;
 
     base::initLogging(logging_settings);
 }
@@ -113,10 +120,29 @@ void createConfig()
         return;
     }
 
-    std::unique_ptr<router::Database> db = router::DatabaseFactorySqlite().createDatabase();
+    // The settings do not exist yet, the database is selected by the command line.
+    const std::string database_connection = base::utf8FromUtf16(
+        base::CommandLine::forCurrentProcess()->switchValue(u"database"));
+
+    std::unique_ptr<router::DatabaseFactory> database_factory;
+    if (database_connection.empty())
+    {
+        database_factory = std::make_unique<router::DatabaseFactorySqlite>();
+    }
+    else
+    {
+#if defined(USE_POSTGRESQL)
+        database_factory = std::make_unique<router::DatabaseFactoryPostgres>(database_connection);
+#else
+        std::cout << "The router is built without PostgreSQL support." << std::endl;
+        return;
+#endif // defined(USE_POSTGRESQL)
+    }
+
+    std::unique_ptr<router::Database> db = database_factory->createDatabase();
     if (!db)
     {
-        db = router::DatabaseFactorySqlite().openDatabase();
+        db = database_factory->openDatabase();
         if (db)
         {
             std::cout << "Database already exists. Continuation is impossible." << std::endl;
@@ -165,6 +191,7 @@ void createConfig()
     router::Settings settings;
     settings.reset();
     settings.setPrivateKey(private_key);
+    settings.setDatabaseConnection(database_connection);
     settings.flush();
 
     std::cout << "Configuration successfully created. Don't forget to change your password!"
@@ -182,7 +209,14 @@ void showHelp()
         << '\t' << "--stop" << '\t' << "Stop service" << std::endl
 #endif // defined(OS_WIN)
         << '\t' << "--create-config" << '\t' << "Creates a configuration" << std::endl
+        << '\t' << "--database=<connection>" << '\t'
+        << "With --create-config, keep the database in PostgreSQL (a libpq connection string)"
+        << std::endl
         << '\t' << "--keygen" << '\t' << "Generating public and private keys" << std::endl
+#if !defined(OS_WIN)
+        << '\t' << "--trace=<file>" << '\t'
+        << "Record a trace, write it to the file on SIGUSR1" << std::endl
+#endif // !defined(OS_WIN)
         << '\t' << "--help" << '\t' << "Show help" << std::endl;
 }
 
@@ -260,6 +294,14 @@ int main(int argc, const char* const* argv)
         std::unique_ptr<base::MessageLoop> message_loop =
             std::make_unique<base::MessageLoop>(base::MessageLoop::Type::ASIO);
 
+        // The trace is written in the Chrome trace event format (see TraceLog).
+        std::unique_ptr<base::TraceDumper> trace_dumper;
+        if (command_line->hasSwitch(u"trace"))
+        {
+            trace_dumper = std::make_unique<base::TraceDumper>(
+                command_line->switchValuePath(u"trace"));
+        }
+
         std::unique_ptr<router::Server> server =
             std::make_unique<router::Server>(message_loop->taskRunner());
 
@@ -267,6 +309,7 @@ int main(int argc, const char* const* argv)
         message_loop->run();
 
         server.reset();
+        trace_dumper.reset();
         message_loop.reset();
     }
 
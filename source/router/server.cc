@@ -24,16 +24,27 @@
 #include "base/crypto/key_pair.h"
 #include "base/files/base_paths.h"
 #include "base/files/file_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_lag_probe.h"
 #include "base/net/network_channel.h"
-#include "router/database_factory_sqlite.h"
+#include "base/peer/session_ticket.h"
+#include "base/prometheus_writer.h"
+#include "base/threading/thread_pool.h"
+#include "base/strings/string_util.h"
+#include "base/strings/unicode.h"
+#include "router/database_factory.h"
 #include "router/database_sqlite.h"
+#include "router/database_worker.h"
 #include "router/session_admin.h"
 #include "router/session_client.h"
 #include "router/session_host.h"
 #include "router/session_relay.h"
+#include "router/session_router.h"
 #include "router/settings.h"
 #include "router/user_list_db.h"
 
+#include <algorithm>
+
 namespace router {
 
 namespace {
@@ -54,21 +65,137 @@ const char* sessionTypeToString(proto::RouterSession session_type)
         case proto::ROUTER_SESSION_RELAY:
             return "ROUTER_SESSION_RELAY";
 
+        case proto::ROUTER_SESSION_ROUTER:
+            return "ROUTER_SESSION_ROUTER";
+
         default:
             return "ROUTER_SESSION_UNKNOWN";
     }
 }
 
+// Session types and their labels in the metrics. The index in the list is the index of the type
+// in the metrics arrays.
+const std::pair<proto::RouterSession, const char*> kSessionTypes[] =
+{
+    { proto::ROUTER_SESSION_CLIENT, "client" },
+    { proto::ROUTER_SESSION_HOST, "host" },
+    { proto::ROUTER_SESSION_ADMIN, "admin" },
+    { proto::ROUTER_SESSION_RELAY, "relay" },
+    { proto::ROUTER_SESSION_ROUTER, "router" }
+};
+
+// Returns the index of |session_type| in kSessionTypes or std::size(kSessionTypes) if the type
+// is unknown.
+size_t sessionTypeIndex(uint32_t session_type)
+{
+    for (size_t i = 0; i < std::size(kSessionTypes); ++i)
+    {
+        if (static_cast<uint32_t>(kSessionTypes[i].first) == session_type)
+            return i;
+    }
+
+    return std::size(kSessionTypes);
+}
+
+// Names of the incoming messages of the sessions in the metrics. The index in the list is the
+// number of the field which is set in the top-level message (see Session::Stat).
+const char* const kPeerMessages[] =
+{
+    "unknown", "connection_request", "host_id_request", "reset_host_id", "host_status_request",
+    "host_candidates"
+};
+
+const char* const kAdminMessages[] =
+{
+    "unknown", "session_list_request", "session_request", "user_list_request", "user_request",
+    "user_import_request", "trace_request", "host_status_request"
+};
+
+const char* const kRelayMessages[] = { "unknown", "key_pool", "relay_stat" };
+const char* const kRouterMessages[] = { "unknown", "host_list", "connection_offer" };
+
+// Returns the name of the message or nullptr if the sessions of |session_type| do not receive
+// messages of |message_type|.
+const char* messageTypeName(proto::RouterSession session_type, size_t message_type)
+{
+    auto name = [message_type](const auto& names) -> const char*
+    {
+        return message_type < std::size(names) ? names[message_type] : nullptr;
+    };
+
+    switch (session_type)
+    {
+        case proto::ROUTER_SESSION_CLIENT:
+        case proto::ROUTER_SESSION_HOST:
+            return name(kPeerMessages);
+
+        case proto::ROUTER_SESSION_ADMIN:
+            return name(kAdminMessages);
+
+        case proto::ROUTER_SESSION_RELAY:
+            return name(kRelayMessages);
+
+        case proto::ROUTER_SESSION_ROUTER:
+            return name(kRouterMessages);
+
+        default:
+            return nullptr;
+    }
+}
+
+// Takes ownership of |object| so that it is destroyed on the thread of |task_runner|, whichever
+// thread releases the last reference.
+template <class T>
+std::shared_ptr<T> bindToThread(std::unique_ptr<T> object,
+                                std::shared_ptr<base::TaskRunner> task_runner)
+{
+    return std::shared_ptr<T>(object.release(), [task_runner](T* object)
+    {
+        if (task_runner->belongsToCurrentThread())
+            delete object;
+        else
+            task_runner->deleteSoon(object);
+    });
+}
+
 } // namespace
 
 Server::Server(std::shared_ptr<base::TaskRunner> task_runner)
     : task_runner_(std::move(task_runner)),
-      database_factory_(std::make_shared<DatabaseFactorySqlite>())
+      database_factory_(DatabaseFactory::create())
 {
     DCHECK(task_runner_);
 }
 
-Server::~Server() = default;
+Server::~Server()
+{
+    SessionMap sessions;
+    std::map<std::thread::id, std::shared_ptr<base::ServerAuthenticatorManager>> managers;
+    std::vector<std::shared_ptr<base::MessageLoopLagProbe>> lag_probes;
+
+    metrics_server_.reset();
+    cluster_connectors_.clear();
+
+    {
+        std::scoped_lock lock(lock_);
+
+        stopping_ = true;
+        sessions.swap(sessions_);
+        host_index_.clear();
+        router_sessions_.clear();
+        session_list_subscribers_.clear();
+        cluster_hosts_.clear();
+        managers.swap(authenticator_managers_);
+        lag_probes.swap(lag_probes_);
+    }
+
+    // Sessions and authenticators served on other threads are scheduled for destruction on their
+    // threads. The network server completes these tasks before stopping the threads.
+    sessions.clear();
+    managers.clear();
+    lag_probes.clear();
+    server_.reset();
+}
 
 bool Server::start()
 {
@@ -84,8 +211,8 @@ bool Server::start()
 
     Settings settings;
 
-    base::ByteArray private_key = settings.privateKey();
-    if (private_key.empty())
+    private_key_ = settings.privateKey();
+    if (private_key_.empty())
     {
         LOG(LS_INFO) << "The private key is not specified in the configuration file";
         return false;
@@ -150,65 +277,121 @@ bool Server::start()
             LOG(LS_INFO) << "#" << (i + 1) << ": " << relay_white_list_[i];
     }
 
-    std::unique_ptr<base::UserListBase> user_list = UserListDb::open(*database_factory_);
+    router_white_list_ = settings.routerWhiteList();
+    if (router_white_list_.empty())
+    {
+        LOG(LS_INFO) << "Empty router white list. Connections from all cluster routers will be "
+                        "allowed";
+    }
+    else
+    {
+        LOG(LS_INFO) << "Router white list is not empty. Allowed routers:";
+
+        for (size_t i = 0; i < router_white_list_.size(); ++i)
+            LOG(LS_INFO) << "#" << (i + 1) << ": " << router_white_list_[i];
+    }
+
+    // The list is read by the threads of the sessions, so it is filled before the connections are
+    // accepted.
+    for (const auto& peer : settings.clusterPeerList())
+        cluster_peer_addresses_.emplace_back(peer.address);
+
+    for (const auto& region : settings.regionList())
+    {
+        LOG(LS_INFO) << "Region '" << region.second << "' for addresses " << region.first << "*";
+        region_list_.emplace_back(base::utf8FromUtf16(region.first),
+                                  base::utf8FromUtf16(region.second));
+    }
 
-    authenticator_manager_ =
-        std::make_unique<base::ServerAuthenticatorManager>(task_runner_, this);
-    authenticator_manager_->setPrivateKey(private_key);
-    authenticator_manager_->setUserList(std::move(user_list));
-    authenticator_manager_->setAnonymousAccess(
-        base::ServerAuthenticator::AnonymousAccess::ENABLE,
-        proto::ROUTER_SESSION_HOST | proto::ROUTER_SESSION_RELAY);
+    const uint32_t thread_count = settings.threadCount();
+    if (thread_count)
+        LOG(LS_INFO) << "Connections are served on " << thread_count << " threads";
 
     relay_key_pool_ = std::make_unique<SharedKeyPool>(this);
 
+    // SRP calculations of the authenticators of all network threads share one pool.
+    crypto_pool_ = std::make_shared<base::ThreadPool>();
+    LOG(LS_INFO) << "Authentication is served on " << crypto_pool_->threadCount() << " threads";
+
+    // A ticket issued on one network thread must be accepted on any other.
+    ticket_keeper_ = std::make_shared<base::SessionTicketKeeper>();
+
+    // The limits are shared by the authenticators of all network threads.
+    base::AuthenticationLimiter::Limits auth_limits;
+    auth_limits.accept_rate = settings.acceptRate();
+    auth_limits.max_pending = settings.maxPendingAuthentications();
+    auth_limits.max_anonymous_pending = settings.maxAnonymousPendingAuthentications();
+
+    LOG(LS_INFO) << "Accept rate: " << auth_limits.accept_rate << "/s, max pending "
+                 << "authentications: " << auth_limits.max_pending << " (anonymous: "
+                 << auth_limits.max_anonymous_pending << ")";
+
+    auth_limiter_ = std::make_shared<base::AuthenticationLimiter>(auth_limits);
+
+    // Sessions access the database on a separate thread. Network threads do not wait for disk.
+    database_worker_ = std::make_shared<DatabaseWorker>(database_factory_);
+
     server_ = std::make_unique<base::NetworkServer>();
+    server_->setThreadCount(thread_count);
     server_->start(port, this);
 
+    lag_probes_.emplace_back(std::make_shared<base::MessageLoopLagProbe>(task_runner_));
+
+    const uint16_t metrics_port = settings.metricsPort();
+    if (metrics_port)
+    {
+        // The router works without metrics if the listener cannot be started.
+        metrics_server_ = std::make_unique<base::MetricsServer>();
+        if (!metrics_server_->start(base::utf8FromUtf16(settings.metricsAddress()),
+                                    metrics_port, this))
+        {
+            metrics_server_.reset();
+        }
+    }
+
+    for (const auto& peer : settings.clusterPeerList())
+    {
+        LOG(LS_INFO) << "Cluster router: " << peer.address << ":" << peer.port;
+
+        cluster_connectors_.emplace_back(
+            std::make_unique<ClusterConnector>(task_runner_, peer, this));
+        cluster_connectors_.back()->start();
+    }
+
     LOG(LS_INFO) << "Server started";
     return true;
 }
 
-std::unique_ptr<proto::SessionList> Server::sessionList() const
+std::unique_ptr<proto::SessionList> Server::sessionList(
+    const proto::SessionListRequest& request, SessionAdmin* session)
 {
     std::unique_ptr<proto::SessionList> result = std::make_unique<proto::SessionList>();
+    uint32_t session_type_mask = request.session_type_mask();
 
-    for (const auto& session : sessions_)
-    {
-        proto::Session* item = result->add_session();
-
-        item->set_session_id(session->sessionId());
-        item->set_session_type(session->sessionType());
-        item->set_timepoint(session->startTime());
-        item->set_ip_address(session->address());
-        item->mutable_version()->CopyFrom(session->version().toProto());
-        item->set_os_name(session->osName());
-        item->set_computer_name(session->computerName());
+    std::scoped_lock lock(lock_);
 
-        switch (session->sessionType())
-        {
-            case proto::ROUTER_SESSION_HOST:
-            {
-                proto::HostSessionData session_data;
+    // The subscription is changed under the same lock as the list is read, so that the admin does
+    // not miss changes between the list and the first update.
+    if (request.subscribe())
+        session_list_subscribers_.insert_or_assign(session, session_type_mask);
+    else
+        session_list_subscribers_.erase(session);
 
-                for (const auto& host_id : static_cast<SessionHost*>(session.get())->hostIdList())
-                    session_data.add_host_id(host_id);
+    uint32_t count = 0;
 
-                item->set_session_data(session_data.SerializeAsString());
-            }
-            break;
+    for (auto it = sessions_.lower_bound(request.start_session_id()); it != sessions_.end(); ++it)
+    {
+        if (session_type_mask && !(session_type_mask & it->second->sessionType()))
+            continue;
 
-            case proto::ROUTER_SESSION_RELAY:
-            {
-                proto::RelaySessionData session_data;
-                session_data.set_pool_size(relay_key_pool_->countForRelay(session->sessionId()));
-                item->set_session_data(session_data.SerializeAsString());
-            }
+        if (request.max_count() && count >= request.max_count())
+        {
+            result->set_next_session_id(it->first);
             break;
-
-            default:
-                break;
         }
+
+        fillSession(*it->second, result->add_session());
+        ++count;
     }
 
     result->set_error_code(proto::SessionList::SUCCESS);
@@ -217,69 +400,219 @@ std::unique_ptr<proto::SessionList> Server::sessionList() const
 
 bool Server::stopSession(Session::SessionId session_id)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
+    std::shared_ptr<Session> session;
+
     {
-        if (it->get()->sessionId() == session_id)
-        {
-            sessions_.erase(it);
-            return true;
-        }
+        std::scoped_lock lock(lock_);
+        session = removeSession(session_id);
     }
 
-    return false;
+    // The session is released outside of the lock. It is destroyed on the thread that serves it.
+    return session != nullptr;
 }
 
 void Server::onHostSessionWithId(SessionHost* session)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end();)
+    SessionList removed_sessions;
+
     {
-        if (it->get()->sessionType() == proto::ROUTER_SESSION_HOST)
+        std::scoped_lock lock(lock_);
+
+        auto current = sessions_.find(session->sessionId());
+        if (current == sessions_.end())
+            return;
+
+        proto::ClusterHostList host_list;
+
+        for (const auto& host_id : session->hostIdList())
         {
-            SessionHost* other_session = reinterpret_cast<SessionHost*>(it->get());
-            if (other_session != session)
+            auto it = host_index_.find(host_id);
+            if (it != host_index_.end() && it->second != session)
             {
-                for (const auto& host_id : session->hostIdList())
-                {
-                    if (other_session->hasHostId(host_id))
-                    {
-                        LOG(LS_INFO) << "Detected previous connection with ID " << host_id;
-
-                        it = sessions_.erase(it);
-                        continue;
-                    }
-                }
+                LOG(LS_INFO) << "Detected previous connection with ID " << host_id;
+
+                std::shared_ptr<Session> other_session = removeSession(it->second->sessionId());
+                if (other_session)
+                    removed_sessions.emplace_back(std::move(other_session));
             }
+
+            auto result = host_index_.insert_or_assign(host_id, session);
+            if (result.second)
+                host_list.add_added(host_id);
         }
 
-        ++it;
+        if (host_list.added_size())
+            sendClusterHostList(host_list);
+
+        sendSessionListUpdate(*current->second, false);
     }
 }
 
-SessionHost* Server::hostSessionById(base::HostId host_id)
+void Server::onHostIdRemoved(SessionHost* session, base::HostId host_id)
+{
+    std::scoped_lock lock(lock_);
+
+    auto it = host_index_.find(host_id);
+    if (it == host_index_.end() || it->second != session)
+        return;
+
+    host_index_.erase(it);
+
+    proto::ClusterHostList host_list;
+    host_list.add_removed(host_id);
+    sendClusterHostList(host_list);
+
+    sendSessionListUpdate(*session, false);
+}
+
+std::shared_ptr<SessionHost> Server::hostSessionById(base::HostId host_id)
+{
+    std::scoped_lock lock(lock_);
+
+    auto host = host_index_.find(host_id);
+    if (host == host_index_.end())
+        return nullptr;
+
+    auto session = sessions_.find(host->second->sessionId());
+    if (session == sessions_.end())
+        return nullptr;
+
+    return std::static_pointer_cast<SessionHost>(session->second);
+}
+
+std::unique_ptr<proto::HostStatusList> Server::hostStatus(const proto::HostStatusRequest& request)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
+    const int count = std::min(request.host_id_size(), kMaxHostStatusCount);
+    if (count < request.host_id_size())
+    {
+        LOG(LS_WARNING) << "Too many hosts in the status request: " << request.host_id_size()
+                        << " (only " << count << " are checked)";
+    }
+
+    std::unique_ptr<proto::HostStatusList> result = std::make_unique<proto::HostStatusList>();
+
+    // The whole request is served under one lock.
+    std::scoped_lock lock(lock_);
+
+    for (int i = 0; i < count; ++i)
     {
-        Session* entry = it->get();
+        base::HostId host_id = request.host_id(i);
+
+        if (base::contains(host_index_, host_id) || base::contains(cluster_hosts_, host_id))
+            result->add_online_host_id(host_id);
+    }
+
+    return result;
+}
+
+std::shared_ptr<Session> Server::sessionById(Session::SessionId session_id)
+{
+    std::scoped_lock lock(lock_);
+
+    auto it = sessions_.find(session_id);
+    if (it == sessions_.end())
+        return nullptr;
 
-        if (entry->sessionType() == proto::ROUTER_SESSION_HOST &&
-            static_cast<SessionHost*>(entry)->hasHostId(host_id))
+    return it->second;
+}
+
+void Server::onRouterSessionReady(SessionRouter* session)
+{
+    std::scoped_lock lock(lock_);
+
+    if (sessions_.find(session->sessionId()) == sessions_.end())
+        return;
+
+    // The full list is sent under the lock, so the changes sent after it are not lost.
+    proto::ClusterHostList host_list;
+    host_list.set_full_list(true);
+
+    for (const auto& host : host_index_)
+        host_list.add_added(host.first);
+
+    router_sessions_.insert(session);
+    session->sendHostList(host_list);
+
+    LOG(LS_INFO) << "Router session " << session->sessionId() << " is ready ("
+                 << host_list.added_size() << " hosts sent)";
+}
+
+void Server::onClusterHostList(SessionRouter* session, const proto::ClusterHostList& host_list)
+{
+    std::scoped_lock lock(lock_);
+
+    if (router_sessions_.find(session) == router_sessions_.end())
+        return;
+
+    if (host_list.full_list())
+    {
+        for (auto it = cluster_hosts_.begin(); it != cluster_hosts_.end();)
         {
-            return static_cast<SessionHost*>(entry);
+            if (it->second == session)
+                it = cluster_hosts_.erase(it);
+            else
+                ++it;
         }
     }
 
-    return nullptr;
+    for (const auto& host_id : host_list.removed())
+    {
+        auto it = cluster_hosts_.find(host_id);
+        if (it != cluster_hosts_.end() && it->second == session)
+            cluster_hosts_.erase(it);
+    }
+
+    // The latest announcement wins. A host which moves to another router is announced there
+    // before the old router reports it as removed, and the routers which connect to each other
+    // both ways announce the same hosts in both sessions.
+    int taken_over = 0;
+
+    for (const auto& host_id : host_list.added())
+    {
+        auto it = cluster_hosts_.find(host_id);
+        if (it != cluster_hosts_.end() && it->second != session)
+            ++taken_over;
+
+        cluster_hosts_.insert_or_assign(host_id, session);
+    }
+
+    if (taken_over)
+    {
+        LOG(LS_INFO) << "Router session " << session->sessionId() << " took over " << taken_over
+                     << " hosts announced by other router sessions";
+    }
 }
 
-Session* Server::sessionById(Session::SessionId session_id)
+std::shared_ptr<SessionRouter> Server::routerSessionByHostId(base::HostId host_id)
 {
-    for (auto& session : sessions_)
+    std::scoped_lock lock(lock_);
+
+    auto router = cluster_hosts_.find(host_id);
+    if (router == cluster_hosts_.end())
+        return nullptr;
+
+    auto session = sessions_.find(router->second->sessionId());
+    if (session == sessions_.end())
+        return nullptr;
+
+    return std::static_pointer_cast<SessionRouter>(session->second);
+}
+
+std::string Server::regionForAddress(const std::string& address) const
+{
+    // The longest matching prefix wins.
+    const std::pair<std::string, std::string>* result = nullptr;
+
+    for (const auto& region : region_list_)
     {
-        if (session->sessionId() == session_id)
-            return session.get();
+        if (!base::startsWith(address, region.first))
+            continue;
+
+        if (!result || region.first.size() > result->first.size())
+            result = &region;
     }
 
-    return nullptr;
+    return result ? result->second : std::string();
 }
 
 void Server::onNewConnection(std::unique_ptr<base::NetworkChannel> channel)
@@ -289,18 +622,190 @@ void Server::onNewConnection(std::unique_ptr<base::NetworkChannel> channel)
     channel->setOwnKeepAlive(true);
     channel->setNoDelay(true);
 
-    if (authenticator_manager_)
-        authenticator_manager_->addNewChannel(std::move(channel));
+    base::ServerAuthenticatorManager* authenticator_manager = authenticatorManager();
+    if (authenticator_manager && !authenticator_manager->addNewChannel(std::move(channel)))
+    {
+        // The connection is closed before the authentication. The peers reconnect later.
+        LOG_EVERY_T(LS_WARNING, std::chrono::seconds(1))
+            << "Connection rejected by admission control (pending authentications: "
+            << auth_limiter_->pendingCount() << ")";
+    }
 }
 
-void Server::onPoolKeyUsed(Session::SessionId session_id, uint32_t key_id)
+std::string Server::onMetricsRequest()
 {
-    for (const auto& session : sessions_)
+    static_assert(std::size(kSessionTypes) == kSessionTypeCount);
+
+    std::array<size_t, kSessionTypeCount> session_count = { 0 };
+    size_t host_id_count;
+    size_t cluster_host_id_count;
+    std::vector<base::LatencyHistogram::Snapshot> lag;
+    std::array<Session::Stat, kSessionTypeCount> session_stat;
+    std::array<Session::Stat, kSessionTypeCount> total_stat;
+
     {
-        SessionRelay* relay_session = static_cast<SessionRelay*>(session.get());
-        if (relay_session->sessionId() == session_id)
-            relay_session->sendKeyUsed(key_id);
+        std::scoped_lock lock(lock_);
+
+        for (const auto& session : sessions_)
+        {
+            const size_t index = sessionTypeIndex(session.second->sessionType());
+            if (index < session_count.size())
+            {
+                ++session_count[index];
+                session_stat[index].add(session.second->stat());
+            }
+        }
+
+        total_stat = finished_stat_;
+
+        host_id_count = host_index_.size();
+        cluster_host_id_count = cluster_hosts_.size();
+
+        for (const auto& probe : lag_probes_)
+            lag.emplace_back(probe->snapshot());
+    }
+
+    using Type = base::PrometheusWriter::Type;
+    base::PrometheusWriter writer;
+
+    writer.addFamily("aspia_router_sessions", Type::GAUGE, "Number of sessions by type.");
+    for (size_t i = 0; i < kSessionTypeCount; ++i)
+    {
+        writer.addSample("aspia_router_sessions", static_cast<double>(session_count[i]),
+                         { { "type", kSessionTypes[i].second } });
+    }
+
+    for (size_t i = 0; i < kSessionTypeCount; ++i)
+        total_stat[i].add(session_stat[i]);
+
+    writer.addFamily("aspia_router_session_cpu_seconds_total", Type::COUNTER,
+                     "CPU time spent handling the messages of the sessions by session type.");
+    for (size_t i = 0; i < kSessionTypeCount; ++i)
+    {
+        writer.addSample("aspia_router_session_cpu_seconds_total",
+                         std::chrono::duration<double>(total_stat[i].cpu_time).count(),
+                         { { "type", kSessionTypes[i].second } });
+    }
+
+    writer.addFamily("aspia_router_session_received_messages_total", Type::COUNTER,
+                     "Messages received from the sessions by session type and message.");
+    writer.addFamily("aspia_router_session_received_bytes_total", Type::COUNTER,
+                     "Bytes received from the sessions by session type and message.");
+    for (size_t i = 0; i < kSessionTypeCount; ++i)
+    {
+        for (size_t j = 0; j < Session::kMaxMessageTypes; ++j)
+        {
+            const char* message = messageTypeName(kSessionTypes[i].first, j);
+            if (!message)
+                continue;
+
+            const base::PrometheusWriter::Labels labels =
+                { { "type", kSessionTypes[i].second }, { "message", message } };
+
+            writer.addSample("aspia_router_session_received_messages_total",
+                             static_cast<double>(total_stat[i].received[j].count), labels);
+            writer.addSample("aspia_router_session_received_bytes_total",
+                             static_cast<double>(total_stat[i].received[j].bytes), labels);
+        }
+    }
+
+    writer.addFamily("aspia_router_session_sent_messages_total", Type::COUNTER,
+                     "Messages sent to the sessions by session type.");
+    writer.addFamily("aspia_router_session_sent_bytes_total", Type::COUNTER,
+                     "Bytes sent to the sessions by session type.");
+    for (size_t i = 0; i < kSessionTypeCount; ++i)
+    {
+        const base::PrometheusWriter::Labels labels = { { "type", kSessionTypes[i].second } };
+
+        writer.addSample("aspia_router_session_sent_messages_total",
+                         static_cast<double>(total_stat[i].sent.count), labels);
+        writer.addSample("aspia_router_session_sent_bytes_total",
+                         static_cast<double>(total_stat[i].sent.bytes), labels);
+    }
+
+    writer.addFamily("aspia_router_session_write_queue", Type::GAUGE,
+                     "Messages waiting to be sent to the sessions by session type.");
+    writer.addFamily("aspia_router_session_max_write_queue", Type::GAUGE,
+                     "Largest write queue of the connected sessions by session type.");
+    for (size_t i = 0; i < kSessionTypeCount; ++i)
+    {
+        const base::PrometheusWriter::Labels labels = { { "type", kSessionTypes[i].second } };
+
+        writer.addSample("aspia_router_session_write_queue",
+                         static_cast<double>(session_stat[i].write_queue), labels);
+        writer.addSample("aspia_router_session_max_write_queue",
+                         static_cast<double>(session_stat[i].max_write_queue), labels);
+    }
+
+    writer.addGauge("aspia_router_host_ids", "Number of host IDs of the connected hosts.",
+                    static_cast<double>(host_id_count));
+    writer.addGauge("aspia_router_cluster_host_ids",
+                    "Number of host IDs connected to the other routers of the cluster.",
+                    static_cast<double>(cluster_host_id_count));
+    writer.addGauge("aspia_router_relay_keys", "Number of relay keys in the pool.",
+                    static_cast<double>(relay_key_pool_->count()));
+    writer.addMemory("aspia_router_memory_bytes", *base::MemoryAccount::global());
+
+    writer.addGauge("aspia_router_pending_authentications",
+                    "Number of authentications in progress.",
+                    static_cast<double>(auth_limiter_->pendingCount()));
+    writer.addCounter("aspia_router_rejected_connections_total",
+                      "Number of connections rejected by the admission control.",
+                      static_cast<double>(auth_limiter_->rejectedCount()));
+
+    writer.addFamily("aspia_router_auth_duration_seconds", Type::HISTOGRAM,
+                     "Duration of successful authentications by session type.");
+    for (size_t i = 0; i < kSessionTypeCount; ++i)
+    {
+        writer.addHistogram("aspia_router_auth_duration_seconds",
+                            base::PrometheusWriter::fromLatency(auth_latency_[i].snapshot()),
+                            { { "type", kSessionTypes[i].second } });
+    }
+
+    writer.addFamily("aspia_router_db_queue_wait_seconds", Type::HISTOGRAM,
+                     "Time the database requests wait for the database thread.");
+    writer.addHistogram("aspia_router_db_queue_wait_seconds",
+                        base::PrometheusWriter::fromLatency(
+                            database_worker_->queueWait().snapshot()));
+
+    writer.addFamily("aspia_router_db_query_seconds", Type::HISTOGRAM,
+                     "Duration of the database requests.");
+    writer.addHistogram("aspia_router_db_query_seconds",
+                        base::PrometheusWriter::fromLatency(
+                            database_worker_->queryTime().snapshot()));
+
+    writer.addFamily("aspia_router_event_loop_lag_seconds", Type::HISTOGRAM,
+                     "Time from posting a task to running it on the main and network threads.");
+    for (size_t i = 0; i < lag.size(); ++i)
+    {
+        writer.addHistogram("aspia_router_event_loop_lag_seconds",
+                            base::PrometheusWriter::fromLatency(lag[i]),
+                            { { "thread", i ? "network-" + std::to_string(i) : "main" } });
     }
+
+    return writer.text();
+}
+
+void Server::onPoolKeyUsed(Session::SessionId session_id, uint32_t key_id)
+{
+    std::scoped_lock lock(lock_);
+
+    auto it = sessions_.find(session_id);
+    if (it == sessions_.end() || it->second->sessionType() != proto::ROUTER_SESSION_RELAY)
+        return;
+
+    static_cast<SessionRelay*>(it->second.get())->sendKeyUsed(key_id);
+}
+
+void Server::onPoolRefillNeeded(Session::SessionId session_id, uint32_t key_count)
+{
+    std::scoped_lock lock(lock_);
+
+    auto it = sessions_.find(session_id);
+    if (it == sessions_.end() || it->second->sessionType() != proto::ROUTER_SESSION_RELAY)
+        return;
+
+    static_cast<SessionRelay*>(it->second.get())->sendKeyRequest(key_count);
 }
 
 void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& session_info)
@@ -311,6 +816,10 @@ void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& sessio
 
     LOG(LS_INFO) << "New session: " << sessionTypeToString(session_type) << " (" << address << ")";
 
+    const size_t type_index = sessionTypeIndex(session_info.session_type);
+    if (type_index < auth_latency_.size())
+        auth_latency_[type_index].add(session_info.auth_duration);
+
     std::unique_ptr<Session> session;
 
     switch (session_info.session_type)
@@ -351,6 +860,23 @@ void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& sessio
         }
         break;
 
+        case proto::ROUTER_SESSION_ROUTER:
+        {
+            if (!router_white_list_.empty() && !base::contains(router_white_list_, address))
+                break;
+
+            // Routers connect anonymously, so only the configured peers of the cluster can
+            // announce hosts and forward offers.
+            if (!base::contains(cluster_peer_addresses_, address))
+            {
+                LOG(LS_WARNING) << "Router '" << address << "' is not a cluster peer";
+                break;
+            }
+
+            session = std::make_unique<SessionRouter>();
+        }
+        break;
+
         default:
         {
             LOG(LS_ERROR) << "Unsupported session type: "
@@ -365,31 +891,251 @@ void Server::onNewSession(base::ServerAuthenticatorManager::SessionInfo&& sessio
         return;
     }
 
+    startSession(std::move(session), std::move(session_info));
+}
+
+std::weak_ptr<bool> Server::onClusterConnected(
+    base::ServerAuthenticatorManager::SessionInfo&& session_info)
+{
+    std::unique_ptr<Session> session = std::make_unique<SessionRouter>();
+    std::weak_ptr<bool> alive = session->alive();
+
+    startSession(std::move(session), std::move(session_info));
+    return alive;
+}
+
+void Server::startSession(std::unique_ptr<Session> session,
+                          base::ServerAuthenticatorManager::SessionInfo&& session_info)
+{
     session->setChannel(std::move(session_info.channel));
-    session->setDatabaseFactory(database_factory_);
+    session->setDatabaseWorker(database_worker_);
     session->setServer(this);
     session->setRelayKeyPool(relay_key_pool_->share());
     session->setVersion(session_info.version);
     session->setOsName(session_info.os_name);
     session->setComputerName(session_info.computer_name);
 
-    sessions_.emplace_back(std::move(session));
-    sessions_.back()->start(this);
+    Session* new_session = session.get();
+
+    {
+        std::scoped_lock lock(lock_);
+
+        if (stopping_)
+            return;
+
+        // The session is destroyed on the thread that serves it.
+        std::shared_ptr<Session> shared_session =
+            bindToThread(std::move(session), base::MessageLoop::current()->taskRunner());
+
+        sessions_.emplace(new_session->sessionId(), std::move(shared_session));
+        sendSessionListUpdate(*new_session, false);
+    }
+
+    new_session->start(this);
 }
 
 void Server::onSessionFinished(Session::SessionId session_id, proto::RouterSession /* session_type */)
 {
-    for (auto it = sessions_.begin(); it != sessions_.end(); ++it)
+    std::shared_ptr<Session> session;
+
     {
-        if (it->get()->sessionId() == session_id)
+        std::scoped_lock lock(lock_);
+        session = removeSession(session_id);
+    }
+
+    if (!session)
+        return;
+
+    // Session will be destroyed after completion of the current call. The method is called on the
+    // thread that serves the session.
+    base::MessageLoop::current()->taskRunner()->postTask([session]()
+    {
+        // Nothing
+    });
+}
+
+base::ServerAuthenticatorManager* Server::authenticatorManager()
+{
+    std::scoped_lock lock(lock_);
+
+    if (stopping_)
+        return nullptr;
+
+    std::shared_ptr<base::ServerAuthenticatorManager>& manager =
+        authenticator_managers_[std::this_thread::get_id()];
+
+    if (!manager)
+    {
+        std::shared_ptr<base::TaskRunner> task_runner = base::MessageLoop::current()->taskRunner();
+
+        std::unique_ptr<base::ServerAuthenticatorManager> new_manager =
+            std::make_unique<base::ServerAuthenticatorManager>(task_runner, this);
+
+        new_manager->setPrivateKey(private_key_);
+        new_manager->setUserList(UserListDb::open(*database_factory_));
+        new_manager->setThreadPool(crypto_pool_);
+        new_manager->setSessionTicketKeeper(ticket_keeper_);
+        new_manager->setLimiter(auth_limiter_);
+        new_manager->setAnonymousAccess(
+            base::ServerAuthenticator::AnonymousAccess::ENABLE,
+            proto::ROUTER_SESSION_HOST | proto::ROUTER_SESSION_RELAY |
+            proto::ROUTER_SESSION_ROUTER);
+
+        // The lag of the main thread is measured from the start.
+        if (!task_runner_->belongsToCurrentThread())
         {
-            // Session will be destroyed after completion of the current call.
-            task_runner_->deleteSoon(std::move(*it));
+            lag_probes_.emplace_back(bindToThread(
+                std::make_unique<base::MessageLoopLagProbe>(task_runner), task_runner));
+        }
 
-            // Delete a session from the list.
-            sessions_.erase(it);
-            break;
+        // The manager serves channels of the current thread and is destroyed on it.
+        manager = bindToThread(std::move(new_manager), std::move(task_runner));
+    }
+
+    return manager.get();
+}
+
+std::shared_ptr<Session> Server::removeSession(Session::SessionId session_id)
+{
+    auto it = sessions_.find(session_id);
+    if (it == sessions_.end())
+        return nullptr;
+
+    std::shared_ptr<Session> session = std::move(it->second);
+    sessions_.erase(it);
+
+    const size_t index = sessionTypeIndex(session->sessionType());
+    if (index < finished_stat_.size())
+        finished_stat_[index].add(session->stat());
+
+    if (session->sessionType() == proto::ROUTER_SESSION_HOST)
+    {
+        SessionHost* host_session = static_cast<SessionHost*>(session.get());
+        proto::ClusterHostList host_list;
+
+        for (const auto& host_id : host_session->hostIdList())
+        {
+            auto host = host_index_.find(host_id);
+            if (host != host_index_.end() && host->second == host_session)
+            {
+                host_index_.erase(host);
+                host_list.add_removed(host_id);
+            }
+        }
+
+        if (host_list.removed_size())
+            sendClusterHostList(host_list);
+    }
+    else if (session->sessionType() == proto::ROUTER_SESSION_ROUTER)
+    {
+        SessionRouter* router_session = static_cast<SessionRouter*>(session.get());
+        router_sessions_.erase(router_session);
+
+        for (auto host = cluster_hosts_.begin(); host != cluster_hosts_.end();)
+        {
+            if (host->second == router_session)
+                host = cluster_hosts_.erase(host);
+            else
+                ++host;
+        }
+    }
+    else if (session->sessionType() == proto::ROUTER_SESSION_ADMIN)
+    {
+        session_list_subscribers_.erase(static_cast<SessionAdmin*>(session.get()));
+    }
+
+    sendSessionListUpdate(*session, true);
+    return session;
+}
+
+void Server::sendClusterHostList(const proto::ClusterHostList& host_list)
+{
+    for (const auto& session : router_sessions_)
+        session->sendHostList(host_list);
+}
+
+void Server::fillSession(const Session& session, proto::Session* item) const
+{
+    item->set_session_id(session.sessionId());
+    item->set_session_type(session.sessionType());
+    item->set_timepoint(session.startTime());
+    item->set_ip_address(session.address());
+    item->mutable_version()->CopyFrom(session.version().toProto());
+    item->set_os_name(session.osName());
+    item->set_computer_name(session.computerName());
+
+    const Session::Stat stat = session.stat();
+    proto::SessionStat* item_stat = item->mutable_stat();
+
+    item_stat->set_cpu_time_us(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(stat.cpu_time).count()));
+
+    for (size_t i = 0; i < stat.received.size(); ++i)
+    {
+        if (!stat.received[i].count)
+            continue;
+
+        proto::SessionMessageStat* message_stat = item_stat->add_received();
+        message_stat->set_type(static_cast<uint32_t>(i));
+        message_stat->set_count(stat.received[i].count);
+        message_stat->set_bytes(stat.received[i].bytes);
+    }
+
+    item_stat->set_sent_messages(stat.sent.count);
+    item_stat->set_sent_bytes(stat.sent.bytes);
+    item_stat->set_write_queue(static_cast<uint32_t>(stat.write_queue));
+    item_stat->set_max_write_queue(static_cast<uint32_t>(stat.max_write_queue));
+
+    switch (session.sessionType())
+    {
+        case proto::ROUTER_SESSION_HOST:
+        {
+            proto::HostSessionData session_data;
+
+            for (const auto& host_id : static_cast<const SessionHost&>(session).hostIdList())
+                session_data.add_host_id(host_id);
+
+            item->set_session_data(session_data.SerializeAsString());
         }
+        break;
+
+        case proto::ROUTER_SESSION_RELAY:
+        {
+            proto::RelaySessionData session_data;
+            session_data.set_pool_size(relay_key_pool_->countForRelay(session.sessionId()));
+
+            const std::optional<proto::RelayStat> relay_stat =
+                static_cast<const SessionRelay&>(session).relayStat();
+            if (relay_stat.has_value())
+                session_data.mutable_relay_stat()->CopyFrom(*relay_stat);
+
+            item->set_session_data(session_data.SerializeAsString());
+        }
+        break;
+
+        default:
+            break;
+    }
+}
+
+void Server::sendSessionListUpdate(const Session& session, bool removed)
+{
+    if (session_list_subscribers_.empty())
+        return;
+
+    proto::SessionListUpdate update;
+
+    if (removed)
+        update.add_removed_session_id(session.sessionId());
+    else
+        fillSession(session, update.add_session());
+
+    for (const auto& subscriber : session_list_subscribers_)
+    {
+        uint32_t session_type_mask = subscriber.second;
+
+        if (!session_type_mask || (session_type_mask & session.sessionType()))
+            subscriber.first->sendSessionListUpdate(update);
     }
 }
 
@@ -19,25 +19,48 @@
 #ifndef ROUTER__SERVER_H
 #define ROUTER__SERVER_H
 
+#include "base/latency_histogram.h"
+#include "base/net/metrics_server.h"
 #include "base/net/network_server.h"
+#include "base/peer/authentication_limiter.h"
 #include "base/peer/host_id.h"
 #include "base/peer/server_authenticator_manager.h"
 #include "build/build_config.h"
 #include "proto/router_admin.pb.h"
+#include "proto/router_cluster.pb.h"
+#include "router/cluster_connector.h"
 #include "router/session.h"
 #include "router/shared_key_pool.h"
 
+#include <array>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace base {
+class MessageLoopLagProbe;
+class SessionTicketKeeper;
+class ThreadPool;
+} // namespace base
+
 namespace router {
 
 class DatabaseFactory;
+class DatabaseWorker;
+class SessionAdmin;
 class SessionHost;
 class SessionRelay;
+class SessionRouter;
 
 class Server
     : public base::NetworkServer::Delegate,
+      public base::MetricsServer::Delegate,
       public SharedKeyPool::Delegate,
       public base::ServerAuthenticatorManager::Delegate,
-      public Session::Delegate
+      public Session::Delegate,
+      public ClusterConnector::Delegate
 {
 public:
     explicit Server(std::shared_ptr<base::TaskRunner> task_runner);
@@ -45,19 +68,44 @@ public:
 
     bool start();
 
-    std::unique_ptr<proto::SessionList> sessionList() const;
+    // The methods below are thread safe. Sessions can be served on different threads (see
+    // Settings::threadCount), each session is destroyed on the thread that serves it.
+    // Returns the part of the session list described by |request|. If the request has the
+    // subscribe flag, the changes of the list are sent to |session| until it is finished.
+    std::unique_ptr<proto::SessionList> sessionList(
+        const proto::SessionListRequest& request, SessionAdmin* session);
     bool stopSession(Session::SessionId session_id);
     void onHostSessionWithId(SessionHost* session);
+    void onHostIdRemoved(SessionHost* session, base::HostId host_id);
+
+    std::shared_ptr<SessionHost> hostSessionById(base::HostId host_id);
+
+    // Returns the hosts from |request| which are connected to this router or to another router of
+    // the cluster. Only the first kMaxHostStatusCount hosts of the request are checked.
+    std::unique_ptr<proto::HostStatusList> hostStatus(const proto::HostStatusRequest& request);
+    std::shared_ptr<Session> sessionById(Session::SessionId session_id);
 
-    SessionHost* hostSessionById(base::HostId host_id);
-    Session* sessionById(Session::SessionId session_id);
+    // Cluster of routers. The routers send each other the IDs of their hosts (see
+    // Settings::clusterPeerList).
+    void onRouterSessionReady(SessionRouter* session);
+    void onClusterHostList(SessionRouter* session, const proto::ClusterHostList& host_list);
+
+    // Returns the session of the router to which the host is connected.
+    std::shared_ptr<SessionRouter> routerSessionByHostId(base::HostId host_id);
+
+    // Returns the region of a peer with |address| (see Settings::regionList) or an empty string.
+    std::string regionForAddress(const std::string& address) const;
 
 protected:
     // base::NetworkServer::Delegate implementation.
     void onNewConnection(std::unique_ptr<base::NetworkChannel> channel) override;
 
+    // base::MetricsServer::Delegate implementation.
+    std::string onMetricsRequest() override;
+
     // SharedKeyPool::Delegate implementation.
     void onPoolKeyUsed(Session::SessionId session_id, uint32_t key_id) override;
+    void onPoolRefillNeeded(Session::SessionId session_id, uint32_t key_count) override;
 
     // base::ServerAuthenticatorManager::Delegate implementation.
     void onNewSession(base::ServerAuthenticatorManager::SessionInfo&& session_info) override;
@@ -66,18 +114,89 @@ protected:
     void onSessionFinished(Session::SessionId session_id,
                            proto::RouterSession session_type) override;
 
+    // ClusterConnector::Delegate implementation.
+    std::weak_ptr<bool> onClusterConnected(
+        base::ServerAuthenticatorManager::SessionInfo&& session_info) override;
+
+    static const int kMaxHostStatusCount = 10000;
+
 private:
+    using SessionList = std::vector<std::shared_ptr<Session>>;
+    using SessionMap = std::map<Session::SessionId, std::shared_ptr<Session>>;
+
+    // Number of session types in proto::RouterSession (except unknown).
+    static constexpr size_t kSessionTypeCount = 5;
+
+    // Returns the authenticator manager of the current thread. It is created on first use.
+    base::ServerAuthenticatorManager* authenticatorManager();
+
+    // Sets up |session| and starts it on the current thread.
+    void startSession(std::unique_ptr<Session> session,
+                      base::ServerAuthenticatorManager::SessionInfo&& session_info);
+
+    // Removes the session from the list and the indices. Must be called with |lock_| held.
+    std::shared_ptr<Session> removeSession(Session::SessionId session_id);
+
+    // Sends the changes of the local hosts to the other routers. Must be called with |lock_| held.
+    void sendClusterHostList(const proto::ClusterHostList& host_list);
+
+    // Fills the session list item. Must be called with |lock_| held.
+    void fillSession(const Session& session, proto::Session* item) const;
+
+    // Sends the new or changed |session| (or its removal) to the admins subscribed to the session
+    // list. Must be called with |lock_| held.
+    void sendSessionListUpdate(const Session& session, bool removed);
+
     std::shared_ptr<base::TaskRunner> task_runner_;
     std::shared_ptr<DatabaseFactory> database_factory_;
+    std::shared_ptr<DatabaseWorker> database_worker_;
+    std::shared_ptr<base::ThreadPool> crypto_pool_;
+    std::shared_ptr<base::SessionTicketKeeper> ticket_keeper_;
+    std::shared_ptr<base::AuthenticationLimiter> auth_limiter_;
     std::unique_ptr<base::NetworkServer> server_;
-    std::unique_ptr<base::ServerAuthenticatorManager> authenticator_manager_;
     std::unique_ptr<SharedKeyPool> relay_key_pool_;
-    std::vector<std::unique_ptr<Session>> sessions_;
+    std::unique_ptr<base::MetricsServer> metrics_server_;
+    base::ByteArray private_key_;
+
+    // Protects the session list and the list of authenticator managers.
+    mutable std::mutex lock_;
+    bool stopping_ = false;
+    // Sessions are ordered by ID, the admin receives the list in parts (see sessionList).
+    SessionMap sessions_;
+    std::unordered_map<base::HostId, SessionHost*> host_index_;
+
+    // Sessions of other routers and the hosts connected to them.
+    std::unordered_set<SessionRouter*> router_sessions_;
+    std::unordered_map<base::HostId, SessionRouter*> cluster_hosts_;
+
+    // Admins subscribed to the session list and the types of sessions they are interested in.
+    std::unordered_map<SessionAdmin*, uint32_t> session_list_subscribers_;
+    std::map<std::thread::id,
+             std::shared_ptr<base::ServerAuthenticatorManager>> authenticator_managers_;
+
+    // Lag of the main thread and of the network threads (in the order they served the first
+    // connection). Each probe is destroyed on its thread.
+    std::vector<std::shared_ptr<base::MessageLoopLagProbe>> lag_probes_;
+
+    // Statistics of the finished sessions by session type (see sessionTypeIndex). Only the
+    // counters are used, so the totals in the metrics do not decrease when sessions are closed.
+    std::array<Session::Stat, kSessionTypeCount> finished_stat_;
+
+    // Durations of successful authentications by session type (see sessionTypeIndex).
+    std::array<base::LatencyHistogram, kSessionTypeCount> auth_latency_;
 
     std::vector<std::u16string> client_white_list_;
     std::vector<std::u16string> host_white_list_;
     std::vector<std::u16string> admin_white_list_;
     std::vector<std::u16string> relay_white_list_;
+    std::vector<std::u16string> router_white_list_;
+    std::vector<std::u16string> cluster_peer_addresses_;
+
+    // Address prefixes and regions. The list does not change after the start.
+    std::vector<std::pair<std::string, std::string>> region_list_;
+
+    // Outgoing connections to the other routers of the cluster. Served on the main thread.
+    std::vector<std::unique_ptr<ClusterConnector>> cluster_connectors_;
 
     DISALLOW_COPY_AND_ASSIGN(Server);
 };
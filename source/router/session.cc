@@ -19,24 +19,75 @@
 #include "router/session.h"
 
 #include "base/logging.h"
+#include "base/message_loop/message_loop.h"
 #include "base/net/network_channel.h"
+#include "base/net/network_channel_proxy.h"
 #include "base/strings/unicode.h"
-#include "router/database.h"
-#include "router/database_factory.h"
+#include "base/threading/thread_cpu_time.h"
 #include "router/shared_key_pool.h"
 
+#include <algorithm>
+
 namespace router {
 
 Session::SessionId createSessionId()
 {
-    static Session::SessionId last_session_id = 0;
-    ++last_session_id;
-    return last_session_id;
+    // Sessions can be created on different threads.
+    static std::atomic<Session::SessionId> last_session_id = 0;
+    return ++last_session_id;
+}
+
+namespace {
+
+// Returns the number of the first field of the serialized message. The incoming messages have one
+// top-level field set, so it identifies the message. Field numbers below 16 are encoded in one
+// byte of the tag.
+size_t messageType(const base::ByteArray& buffer)
+{
+    if (buffer.empty() || (buffer[0] & 0x80))
+        return 0;
+
+    const size_t type = buffer[0] >> 3;
+    return type < Session::kMaxMessageTypes ? type : 0;
+}
+
+} // namespace
+
+void Session::Stat::add(const Stat& other)
+{
+    cpu_time += other.cpu_time;
+
+    for (size_t i = 0; i < received.size(); ++i)
+    {
+        received[i].count += other.received[i].count;
+        received[i].bytes += other.received[i].bytes;
+    }
+
+    sent.count += other.sent.count;
+    sent.bytes += other.sent.bytes;
+
+    write_queue += other.write_queue;
+    max_write_queue = std::max(max_write_queue, other.max_write_queue);
+}
+
+void Session::AtomicMessageCount::add(size_t message_size)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(message_size, std::memory_order_relaxed);
+}
+
+Session::MessageCount Session::AtomicMessageCount::load() const
+{
+    MessageCount result;
+    result.count = count.load(std::memory_order_relaxed);
+    result.bytes = bytes.load(std::memory_order_relaxed);
+    return result;
 }
 
-Session::Session(proto::RouterSession session_type)
+Session::Session(proto::RouterSession session_type, size_t arena_block_size)
     : session_type_(session_type),
-      session_id_(createSessionId())
+      session_id_(createSessionId()),
+      message_arena_(arena_block_size)
 {
     // Nothing
 }
@@ -46,6 +97,7 @@ Session::~Session() = default;
 void Session::setChannel(std::unique_ptr<base::NetworkChannel> channel)
 {
     channel_ = std::move(channel);
+    channel_proxy_ = channel_->channelProxy();
 }
 
 void Session::setRelayKeyPool(std::unique_ptr<SharedKeyPool> relay_key_pool)
@@ -53,9 +105,9 @@ void Session::setRelayKeyPool(std::unique_ptr<SharedKeyPool> relay_key_pool)
     relay_key_pool_ = std::move(relay_key_pool);
 }
 
-void Session::setDatabaseFactory(std::shared_ptr<DatabaseFactory> database_factory)
+void Session::setDatabaseWorker(std::shared_ptr<DatabaseWorker> database_worker)
 {
-    database_factory_ = std::move(database_factory);
+    database_worker_ = std::move(database_worker);
 }
 
 void Session::setServer(Server* server)
@@ -77,9 +129,9 @@ void Session::start(Delegate* delegate)
         return;
     }
 
-    if (!database_factory_)
+    if (!database_worker_)
     {
-        LOG(LS_FATAL) << "Invalid database factory";
+        LOG(LS_FATAL) << "Invalid database worker";
         return;
     }
 
@@ -103,9 +155,9 @@ void Session::start(Delegate* delegate)
     onSessionReady();
 }
 
-std::unique_ptr<Database> Session::openDatabase() const
+std::shared_ptr<base::TaskRunner> Session::taskRunner() const
 {
-    return database_factory_->openDatabase();
+    return base::MessageLoop::current()->taskRunner();
 }
 
 void Session::setVersion(const base::Version& version)
@@ -137,10 +189,29 @@ std::chrono::seconds Session::duration() const
         std::chrono::system_clock::now() - time_point);
 }
 
+Session::Stat Session::stat() const
+{
+    Stat result;
+    result.cpu_time = std::chrono::nanoseconds(cpu_time_.load(std::memory_order_relaxed));
+
+    for (size_t i = 0; i < received_.size(); ++i)
+        result.received[i] = received_[i].load();
+
+    result.sent = sent_.load();
+    result.write_queue = write_queue_.load(std::memory_order_relaxed);
+    result.max_write_queue = max_write_queue_.load(std::memory_order_relaxed);
+    return result;
+}
+
 void Session::sendMessage(const google::protobuf::MessageLite& message)
 {
-    if (channel_)
-        channel_->send(base::serialize(message));
+    // Messages can be sent by sessions served on other threads (for example, a connection offer
+    // for a host is sent by the client session), so they go through the thread safe proxy.
+    if (channel_proxy_)
+    {
+        sent_.add(message.ByteSizeLong());
+        channel_proxy_->send(message);
+    }
 }
 
 void Session::onConnected()
@@ -156,4 +227,30 @@ void Session::onDisconnected(base::NetworkChannel::ErrorCode error_code)
         delegate_->onSessionFinished(session_id_, session_type_);
 }
 
+void Session::onMessageReceived(const base::ByteArray& buffer)
+{
+    received_[messageType(buffer)].add(buffer.size());
+
+    // The session can be destroyed by the handler (for example, an administrator disconnects
+    // their own session).
+    std::weak_ptr<bool> alive = alive_;
+    const std::chrono::nanoseconds start = base::threadCpuTime();
+
+    onSessionMessageReceived(buffer);
+
+    if (alive.expired())
+        return;
+
+    cpu_time_.fetch_add((base::threadCpuTime() - start).count(), std::memory_order_relaxed);
+}
+
+void Session::onMessageWritten(size_t pending)
+{
+    write_queue_.store(pending, std::memory_order_relaxed);
+    if (pending > max_write_queue_.load(std::memory_order_relaxed))
+        max_write_queue_.store(pending, std::memory_order_relaxed);
+
+    onSessionMessageWritten(pending);
+}
+
 } // namespace router
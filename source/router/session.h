@@ -20,20 +20,26 @@
 #define ROUTER__SESSION_H
 
 #include "base/version.h"
+#include "base/memory/message_arena.h"
 #include "base/net/network_channel.h"
 #include "proto/router_common.pb.h"
+#include "router/database_worker.h"
+
+#include <array>
+#include <atomic>
 
 namespace router {
 
-class Database;
-class DatabaseFactory;
 class Server;
 class SharedKeyPool;
 
 class Session : public base::NetworkChannel::Listener
 {
 public:
-    explicit Session(proto::RouterSession session_type);
+    // |arena_block_size| is the size of the initial block of the arena for the incoming messages
+    // (see messageArena()).
+    explicit Session(proto::RouterSession session_type,
+                     size_t arena_block_size = base::MessageArena::kDefaultBlockSize);
     virtual ~Session();
 
     using SessionId = int64_t;
@@ -49,7 +55,7 @@ public:
 
     void setChannel(std::unique_ptr<base::NetworkChannel> channel);
     void setRelayKeyPool(std::unique_ptr<SharedKeyPool> relay_key_pool);
-    void setDatabaseFactory(std::shared_ptr<DatabaseFactory> database_factory);
+    void setDatabaseWorker(std::shared_ptr<DatabaseWorker> database_worker);
     void setServer(Server* server);
 
     void start(Delegate* delegate);
@@ -69,15 +75,77 @@ public:
     time_t startTime() const { return start_time_; }
     std::chrono::seconds duration() const;
 
+    static const size_t kMaxMessageTypes = 8;
+
+    struct MessageCount
+    {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Load which the session puts on the router.
+    struct Stat
+    {
+        void add(const Stat& other);
+
+        // CPU time spent handling the incoming messages.
+        std::chrono::nanoseconds cpu_time { 0 };
+
+        // Incoming messages by type. The type is the number of the field which is set in the
+        // top-level message (for example, PeerToRouter). Zero is for messages which can not be
+        // classified.
+        std::array<MessageCount, kMaxMessageTypes> received;
+
+        MessageCount sent;
+
+        // Messages waiting to be sent to the peer.
+        size_t write_queue = 0;
+        size_t max_write_queue = 0;
+    };
+
+    // Can be called on any thread.
+    Stat stat() const;
+
+    // The pointer expires when the session is destroyed. Callbacks which are posted to the thread
+    // of the session must check it before accessing the session.
+    std::weak_ptr<bool> alive() const { return alive_; }
+
 protected:
     void sendMessage(const google::protobuf::MessageLite& message);
-    std::unique_ptr<Database> openDatabase() const;
+
+    // Runs |task| on the database thread. |reply| is called with the result of |task| on the
+    // thread of the session if the session still exists.
+    template <typename Result>
+    void postDatabaseTask(std::function<Result(Database* database)> task,
+                          std::function<void(Result result)> reply)
+    {
+        std::weak_ptr<bool> alive = alive_;
+
+        database_worker_->postTaskAndReply<Result>(std::move(task), taskRunner(),
+            [alive, reply = std::move(reply)](Result result)
+        {
+            if (!alive.expired())
+                reply(std::move(result));
+        });
+    }
+
+    DatabaseWorker& databaseWorker() { return *database_worker_; }
+
+    // Task runner of the thread that serves the session.
+    std::shared_ptr<base::TaskRunner> taskRunner() const;
 
     virtual void onSessionReady() = 0;
 
+    // Called instead of onMessageReceived and onMessageWritten, which keep the statistics of
+    // the session.
+    virtual void onSessionMessageReceived(const base::ByteArray& buffer) = 0;
+    virtual void onSessionMessageWritten(size_t pending) = 0;
+
     // base::NetworkChannel::Listener implementation.
     void onConnected() override;
     void onDisconnected(base::NetworkChannel::ErrorCode error_code) override;
+    void onMessageReceived(const base::ByteArray& buffer) final;
+    void onMessageWritten(size_t pending) final;
 
     SharedKeyPool& relayKeyPool() { return *relay_key_pool_; }
     const SharedKeyPool& relayKeyPool() const { return *relay_key_pool_; }
@@ -85,13 +153,26 @@ protected:
     Server& server() { return *server_; }
     const Server& server() const { return *server_; }
 
+    // Arena for the incoming messages. It is reset when the next message is received.
+    base::MessageArena& messageArena() { return message_arena_; }
+
 private:
+    struct AtomicMessageCount
+    {
+        void add(size_t bytes);
+        MessageCount load() const;
+
+        std::atomic<uint64_t> count { 0 };
+        std::atomic<uint64_t> bytes { 0 };
+    };
+
     const proto::RouterSession session_type_;
     const SessionId session_id_;
     time_t start_time_ = 0;
 
     std::unique_ptr<base::NetworkChannel> channel_;
-    std::shared_ptr<DatabaseFactory> database_factory_;
+    std::shared_ptr<base::NetworkChannelProxy> channel_proxy_;
+    std::shared_ptr<DatabaseWorker> database_worker_;
     std::unique_ptr<SharedKeyPool> relay_key_pool_;
     Server* server_ = nullptr;
 
@@ -101,7 +182,18 @@ private:
     std::string os_name_;
     std::string computer_name_;
 
+    base::MessageArena message_arena_;
+
+    // Updated on the thread of the session (the sent messages on any thread) and read by the
+    // admin sessions and the metrics server.
+    std::atomic<int64_t> cpu_time_ { 0 };
+    std::array<AtomicMessageCount, kMaxMessageTypes> received_;
+    AtomicMessageCount sent_;
+    std::atomic<size_t> write_queue_ { 0 };
+    std::atomic<size_t> max_write_queue_ { 0 };
+
     Delegate* delegate_ = nullptr;
+    std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
 };
 
 } // namespace router
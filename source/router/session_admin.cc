@@ -22,9 +22,12 @@
 #include "base/strings/unicode.h"
 #include "base/net/network_channel.h"
 #include "base/peer/user.h"
+#include "base/trace_event.h"
 #include "router/database.h"
 #include "router/server.h"
 
+#include <algorithm>
+
 namespace router {
 
 SessionAdmin::SessionAdmin()
@@ -35,16 +38,25 @@ SessionAdmin::SessionAdmin()
 
 SessionAdmin::~SessionAdmin() = default;
 
+void SessionAdmin::sendSessionListUpdate(const proto::SessionListUpdate& update)
+{
+    std::unique_ptr<proto::RouterToAdmin> message = std::make_unique<proto::RouterToAdmin>();
+    message->mutable_session_list_update()->CopyFrom(update);
+    sendMessage(*message);
+}
+
 void SessionAdmin::onSessionReady()
 {
     // Nothing
 }
 
-void SessionAdmin::onMessageReceived(const base::ByteArray& buffer)
+void SessionAdmin::onSessionMessageReceived(const base::ByteArray& buffer)
 {
-    std::unique_ptr<proto::AdminToRouter> message = std::make_unique<proto::AdminToRouter>();
+    TRACE_EVENT("router", "SessionAdmin::onSessionMessageReceived");
+
+    proto::AdminToRouter* message = messageArena().resetAndCreate<proto::AdminToRouter>();
 
-    if (!base::parse(buffer, message.get()))
+    if (!base::parse(buffer, message))
     {
         LOG(LS_ERROR) << "Could not read message from manager";
         return;
@@ -66,69 +78,121 @@ void SessionAdmin::onMessageReceived(const base::ByteArray& buffer)
     {
         doUserRequest(message->user_request());
     }
+    else if (message->has_user_import_request())
+    {
+        doUserImportRequest(message->user_import_request());
+    }
+    else if (message->has_trace_request())
+    {
+        doTraceRequest(message->trace_request());
+    }
+    else if (message->has_host_status_request())
+    {
+        doHostStatusRequest(message->host_status_request());
+    }
     else
     {
         LOG(LS_WARNING) << "Unhandled message from manager";
     }
 }
 
-void SessionAdmin::onMessageWritten(size_t /* pending */)
+void SessionAdmin::onSessionMessageWritten(size_t /* pending */)
 {
     // Nothing
 }
 
 void SessionAdmin::doUserListRequest()
 {
-    std::unique_ptr<Database> database = openDatabase();
-    if (!database)
+    postDatabaseTask<std::optional<std::vector<base::User>>>([](Database* database)
+        -> std::optional<std::vector<base::User>>
     {
-        LOG(LS_ERROR) << "Failed to connect to database";
-        return;
-    }
+        if (!database)
+            return std::nullopt;
 
-    std::unique_ptr<proto::RouterToAdmin> message = std::make_unique<proto::RouterToAdmin>();
-    proto::UserList* list = message->mutable_user_list();
+        return database->userList();
+    },
+    [this](std::optional<std::vector<base::User>> users)
+    {
+        if (!users.has_value())
+        {
+            LOG(LS_ERROR) << "Failed to connect to database";
+            return;
+        }
 
-    std::vector<base::User> users = database->userList();
-    for (const auto& user : users)
-        list->add_user()->CopyFrom(user.serialize());
+        std::unique_ptr<proto::RouterToAdmin> message = std::make_unique<proto::RouterToAdmin>();
+        proto::UserList* list = message->mutable_user_list();
 
-    sendMessage(*message);
+        for (const auto& user : *users)
+            list->add_user()->CopyFrom(user.serialize());
+
+        sendMessage(*message);
+    });
 }
 
 void SessionAdmin::doUserRequest(const proto::UserRequest& request)
 {
-    std::unique_ptr<proto::RouterToAdmin> message = std::make_unique<proto::RouterToAdmin>();
-    proto::UserResult* result = message->mutable_user_result();
-    result->set_type(request.type());
-
     switch (request.type())
     {
         case proto::USER_REQUEST_ADD:
-            result->set_error_code(addUser(request.user()));
+            addUser(request.user());
             break;
 
         case proto::USER_REQUEST_MODIFY:
-            result->set_error_code(modifyUser(request.user()));
+            modifyUser(request.user());
             break;
 
         case proto::USER_REQUEST_DELETE:
-            result->set_error_code(deleteUser(request.user()));
+            deleteUser(request.user());
             break;
 
         default:
             LOG(LS_ERROR) << "Unknown request type: " << request.type();
+            break;
+    }
+}
+
+void SessionAdmin::doUserImportRequest(const proto::UserImportRequest& request)
+{
+    LOG(LS_INFO) << "User import request: " << request.user_size() << " users";
+
+    std::vector<base::User> users;
+    users.reserve(request.user_size());
+
+    for (int i = 0; i < request.user_size(); ++i)
+    {
+        base::User user = base::User::parseFrom(request.user(i));
+        if (!user.isValid() || !base::User::isValidUserName(user.name))
+        {
+            LOG(LS_ERROR) << "Invalid user: " << request.user(i).name();
+            sendUserResult(proto::USER_REQUEST_IMPORT, proto::UserResult::INVALID_DATA);
             return;
+        }
+
+        users.emplace_back(std::move(user));
     }
 
-    sendMessage(*message);
+    postDatabaseTask<proto::UserResult::ErrorCode>([users = std::move(users)](Database* database)
+    {
+        if (!database)
+        {
+            LOG(LS_ERROR) << "Failed to connect to database";
+            return proto::UserResult::INTERNAL_ERROR;
+        }
+
+        if (!database->addUsers(users))
+            return proto::UserResult::INTERNAL_ERROR;
+
+        return proto::UserResult::SUCCESS;
+    },
+    std::bind(&SessionAdmin::sendUserResult, this, proto::USER_REQUEST_IMPORT,
+              std::placeholders::_1));
 }
 
-void SessionAdmin::doSessionListRequest(const proto::SessionListRequest& /* request */)
+void SessionAdmin::doSessionListRequest(const proto::SessionListRequest& request)
 {
     std::unique_ptr<proto::RouterToAdmin> message = std::make_unique<proto::RouterToAdmin>();
 
-    message->set_allocated_session_list(server().sessionList().release());
+    message->set_allocated_session_list(server().sessionList(request, this).release());
     if (!message->has_session_list())
         message->mutable_session_list()->set_error_code(proto::SessionList::UNKNOWN_ERROR);
 
@@ -165,7 +229,54 @@ void SessionAdmin::doSessionRequest(const proto::SessionRequest& request)
     sendMessage(*message);
 }
 
-proto::UserResult::ErrorCode SessionAdmin::addUser(const proto::User& user)
+void SessionAdmin::doTraceRequest(const proto::TraceRequest& request)
+{
+    // The dump must fit into one message.
+    static const size_t kMaxTraceEvents = 100000;
+
+    base::TraceLog* trace_log = base::TraceLog::instance();
+
+    std::unique_ptr<proto::RouterToAdmin> message = std::make_unique<proto::RouterToAdmin>();
+    proto::TraceResult* result = message->mutable_trace_result();
+    result->set_type(request.type());
+
+    switch (request.type())
+    {
+        case proto::TRACE_REQUEST_START:
+        {
+            size_t capacity = base::TraceLog::kDefaultCapacity;
+            if (request.buffer_size())
+                capacity = std::min(static_cast<size_t>(request.buffer_size()), kMaxTraceEvents);
+
+            LOG(LS_INFO) << "Trace started by " << userName();
+            trace_log->start(capacity);
+        }
+        break;
+
+        case proto::TRACE_REQUEST_STOP:
+            trace_log->stop();
+            break;
+
+        case proto::TRACE_REQUEST_DUMP:
+            result->set_data(trace_log->toChromeJson());
+            break;
+
+        default:
+            LOG(LS_ERROR) << "Unknown trace request: " << request.type();
+            return;
+    }
+
+    sendMessage(*message);
+}
+
+void SessionAdmin::doHostStatusRequest(const proto::HostStatusRequest& request)
+{
+    std::unique_ptr<proto::RouterToAdmin> message = std::make_unique<proto::RouterToAdmin>();
+    message->set_allocated_host_status_list(server().hostStatus(request).release());
+    sendMessage(*message);
+}
+
+void SessionAdmin::addUser(const proto::User& user)
 {
     LOG(LS_INFO) << "User add request: " << user.name();
 
@@ -173,81 +284,110 @@ proto::UserResult::ErrorCode SessionAdmin::addUser(const proto::User& user)
     if (!new_user.isValid())
     {
         LOG(LS_ERROR) << "Failed to create user";
-        return proto::UserResult::INTERNAL_ERROR;
+        sendUserResult(proto::USER_REQUEST_ADD, proto::UserResult::INTERNAL_ERROR);
+        return;
     }
 
     if (!base::User::isValidUserName(new_user.name))
     {
         LOG(LS_ERROR) << "Invalid user name: " << new_user.name;
-        return proto::UserResult::INVALID_DATA;
+        sendUserResult(proto::USER_REQUEST_ADD, proto::UserResult::INVALID_DATA);
+        return;
     }
 
-    std::unique_ptr<Database> database = openDatabase();
-    if (!database)
+    postDatabaseTask<proto::UserResult::ErrorCode>([new_user](Database* database)
     {
-        LOG(LS_ERROR) << "Failed to connect to database";
-        return proto::UserResult::INTERNAL_ERROR;
-    }
+        if (!database)
+        {
+            LOG(LS_ERROR) << "Failed to connect to database";
+            return proto::UserResult::INTERNAL_ERROR;
+        }
 
-    if (!database->addUser(new_user))
-        return proto::UserResult::INTERNAL_ERROR;
+        if (!database->addUser(new_user))
+            return proto::UserResult::INTERNAL_ERROR;
 
-    return proto::UserResult::SUCCESS;
+        return proto::UserResult::SUCCESS;
+    },
+    std::bind(&SessionAdmin::sendUserResult, this, proto::USER_REQUEST_ADD,
+              std::placeholders::_1));
 }
 
-proto::UserResult::ErrorCode SessionAdmin::modifyUser(const proto::User& user)
+void SessionAdmin::modifyUser(const proto::User& user)
 {
     LOG(LS_INFO) << "User modify request: " << user.name();
 
     if (user.entry_id() <= 0)
     {
         LOG(LS_ERROR) << "Invalid user ID: " << user.entry_id();
-        return proto::UserResult::INVALID_DATA;
+        sendUserResult(proto::USER_REQUEST_MODIFY, proto::UserResult::INVALID_DATA);
+        return;
     }
 
     base::User new_user = base::User::parseFrom(user);
     if (!new_user.isValid())
     {
         LOG(LS_ERROR) << "Failed to create user";
-        return proto::UserResult::INTERNAL_ERROR;
+        sendUserResult(proto::USER_REQUEST_MODIFY, proto::UserResult::INTERNAL_ERROR);
+        return;
     }
 
     if (!base::User::isValidUserName(new_user.name))
     {
         LOG(LS_ERROR) << "Invalid user name: " << new_user.name;
-        return proto::UserResult::INVALID_DATA;
+        sendUserResult(proto::USER_REQUEST_MODIFY, proto::UserResult::INVALID_DATA);
+        return;
     }
 
-    std::unique_ptr<Database> database = openDatabase();
-    if (!database)
+    postDatabaseTask<proto::UserResult::ErrorCode>([new_user](Database* database)
     {
-        LOG(LS_ERROR) << "Failed to connect to database";
-        return proto::UserResult::INTERNAL_ERROR;
-    }
+        if (!database)
+        {
+            LOG(LS_ERROR) << "Failed to connect to database";
+            return proto::UserResult::INTERNAL_ERROR;
+        }
 
-    if (!database->modifyUser(new_user))
-        return proto::UserResult::INTERNAL_ERROR;
+        if (!database->modifyUser(new_user))
+            return proto::UserResult::INTERNAL_ERROR;
 
-    return proto::UserResult::SUCCESS;
+        return proto::UserResult::SUCCESS;
+    },
+    std::bind(&SessionAdmin::sendUserResult, this, proto::USER_REQUEST_MODIFY,
+              std::placeholders::_1));
 }
 
-proto::UserResult::ErrorCode SessionAdmin::deleteUser(const proto::User& user)
+void SessionAdmin::deleteUser(const proto::User& user)
 {
-    std::unique_ptr<Database> database = openDatabase();
-    if (!database)
-    {
-        LOG(LS_ERROR) << "Failed to connect to database";
-        return proto::UserResult::INTERNAL_ERROR;
-    }
-
     uint64_t entry_id = user.entry_id();
 
     LOG(LS_INFO) << "User remove request: " << entry_id;
 
-    if (!database->removeUser(entry_id))
-        return proto::UserResult::INTERNAL_ERROR;
+    postDatabaseTask<proto::UserResult::ErrorCode>([entry_id](Database* database)
+    {
+        if (!database)
+        {
+            LOG(LS_ERROR) << "Failed to connect to database";
+            return proto::UserResult::INTERNAL_ERROR;
+        }
+
+        if (!database->removeUser(entry_id))
+            return proto::UserResult::INTERNAL_ERROR;
+
+        return proto::UserResult::SUCCESS;
+    },
+    std::bind(&SessionAdmin::sendUserResult, this, proto::USER_REQUEST_DELETE,
+              std::placeholders::_1));
+}
 
-    return proto::UserResult::SUCCESS;
+void SessionAdmin::sendUserResult(proto::UserRequestType type,
+                                  proto::UserResult::ErrorCode error_code)
+{
+    std::unique_ptr<proto::RouterToAdmin> message = std::make_unique<proto::RouterToAdmin>();
+    proto::UserResult* result = message->mutable_user_result();
+
+    result->set_type(type);
+    result->set_error_code(error_code);
+
+    sendMessage(*message);
 }
 
 } // namespace router
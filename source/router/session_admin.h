@@ -32,23 +32,30 @@ public:
     SessionAdmin();
     ~SessionAdmin();
 
+    // Sends the changes of the session list if the admin is subscribed to it. Can be called from
+    // any thread.
+    void sendSessionListUpdate(const proto::SessionListUpdate& update);
+
 protected:
     // Session implementation.
     void onSessionReady() override;
-
-    // base::NetworkChannel::Listener implementation.
-    void onMessageReceived(const base::ByteArray& buffer) override;
-    void onMessageWritten(size_t pending) override;
+    void onSessionMessageReceived(const base::ByteArray& buffer) override;
+    void onSessionMessageWritten(size_t pending) override;
 
 private:
     void doUserListRequest();
     void doUserRequest(const proto::UserRequest& request);
+    void doUserImportRequest(const proto::UserImportRequest& request);
     void doSessionListRequest(const proto::SessionListRequest& request);
     void doSessionRequest(const proto::SessionRequest& request);
+    void doTraceRequest(const proto::TraceRequest& request);
+    void doHostStatusRequest(const proto::HostStatusRequest& request);
 
-    proto::UserResult::ErrorCode addUser(const proto::User& user);
-    proto::UserResult::ErrorCode modifyUser(const proto::User& user);
-    proto::UserResult::ErrorCode deleteUser(const proto::User& user);
+    // The result is sent to the admin when the database has completed the request.
+    void addUser(const proto::User& user);
+    void modifyUser(const proto::User& user);
+    void deleteUser(const proto::User& user);
+    void sendUserResult(proto::UserRequestType type, proto::UserResult::ErrorCode error_code);
 
     DISALLOW_COPY_AND_ASSIGN(SessionAdmin);
 };
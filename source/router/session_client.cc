@@ -20,10 +20,13 @@
 
 #include "base/logging.h"
 #include "base/crypto/random.h"
+#include "base/peer/connection_trace.h"
 #include "base/strings/unicode.h"
+#include "base/trace_event.h"
 #include "router/server.h"
 #include "router/session_host.h"
 #include "router/session_relay.h"
+#include "router/session_router.h"
 
 namespace router {
 
@@ -40,10 +43,12 @@ void SessionClient::onSessionReady()
     // Nothing
 }
 
-void SessionClient::onMessageReceived(const base::ByteArray& buffer)
+void SessionClient::onSessionMessageReceived(const base::ByteArray& buffer)
 {
-    std::unique_ptr<proto::PeerToRouter> message = std::make_unique<proto::PeerToRouter>();
-    if (!base::parse(buffer, message.get()))
+    TRACE_EVENT("router", "SessionClient::onSessionMessageReceived");
+
+    proto::PeerToRouter* message = messageArena().resetAndCreate<proto::PeerToRouter>();
+    if (!base::parse(buffer, message))
     {
         LOG(LS_ERROR) << "Could not read message from client";
         return;
@@ -53,13 +58,17 @@ void SessionClient::onMessageReceived(const base::ByteArray& buffer)
     {
         readConnectionRequest(message->connection_request());
     }
+    else if (message->has_host_status_request())
+    {
+        readHostStatusRequest(message->host_status_request());
+    }
     else
     {
         LOG(LS_WARNING) << "Unhandled message from client";
     }
 }
 
-void SessionClient::onMessageWritten(size_t /* pending */)
+void SessionClient::onSessionMessageWritten(size_t /* pending */)
 {
     // Nothing
 }
@@ -68,65 +77,151 @@ void SessionClient::readConnectionRequest(const proto::ConnectionRequest& reques
 {
     LOG(LS_INFO) << "New connection request (host_id: " << request.host_id() << ")";
 
+    // Clients without tracing do not send the ID, the router starts the trace for them.
+    base::ConnectionTrace trace = request.trace_id() != base::ConnectionTrace::kInvalidId ?
+        base::ConnectionTrace(request.trace_id()) : base::ConnectionTrace();
+    trace.addStage("Connection request received by router");
+
     std::unique_ptr<proto::RouterToPeer> message = std::make_unique<proto::RouterToPeer>();
     proto::ConnectionOffer* offer = message->mutable_connection_offer();
+    offer->set_trace_id(trace.id());
 
-    SessionHost* host = server().hostSessionById(request.host_id());
+    // If the host is not connected to this router, the offer for it is forwarded to the router of
+    // the cluster to which it is connected.
+    std::shared_ptr<SessionHost> host = server().hostSessionById(request.host_id());
+    std::shared_ptr<SessionRouter> router;
     if (!host)
+        router = server().routerSessionByHostId(request.host_id());
+
+    if (!host && !router)
     {
         LOG(LS_WARNING) << "Host with id " << request.host_id() << " NOT found!";
         offer->set_error_code(proto::ConnectionOffer::PEER_NOT_FOUND);
     }
     else
     {
-        LOG(LS_INFO) << "Host with id " << request.host_id() << " found";
-
-        std::optional<SharedKeyPool::Credentials> credentials = relayKeyPool().takeCredentials();
-        if (!credentials.has_value())
+        LOG(LS_INFO) << "Host with id " << request.host_id() << " found"
+                     << (router ? " on another router" : "");
+        trace.addStage("Host found by router");
+
+        // The address of a host connected to another router is unknown, so any relay can be used.
+        const std::string secret = base::Random::string(16);
+        const std::string host_region =
+            host ? server().regionForAddress(host->address()) : std::string();
+        const std::string client_region = server().regionForAddress(address());
+
+        // Without cascading, both peers use the relay chosen for the host.
+        std::shared_ptr<SessionRelay> host_relay;
+        std::string host_relay_region;
+        std::optional<proto::RelayCredentials> host_credentials = takeRelayCredentials(
+            host_region, SharedKeyPool::RegionPolicy::PREFERRED, secret, &host_relay,
+            &host_relay_region);
+        if (!host_credentials.has_value())
         {
-            LOG(LS_WARNING) << "Empty key pool";
             offer->set_error_code(proto::ConnectionOffer::KEY_POOL_EMPTY);
         }
         else
         {
-            SessionRelay* relay = static_cast<SessionRelay*>(
-                server().sessionById(credentials->session_id));
-            if (!relay)
-            {
-                LOG(LS_ERROR) << "No relay with session id " << credentials->session_id;
-                offer->set_error_code(proto::ConnectionOffer::KEY_POOL_EMPTY);
-            }
-            else
+            trace.addStage("Relay key taken by router");
+
+            proto::RelayCredentials client_credentials = *host_credentials;
+
+            if (!client_region.empty() && client_region != host_relay_region)
             {
-                const std::optional<SessionRelay::PeerData>& peer_data = relay->peerData();
-                if (!peer_data.has_value())
-                {
-                    LOG(LS_ERROR) << "No peer data for relay with session id "
-                                  << credentials->session_id;
-                    offer->set_error_code(proto::ConnectionOffer::KEY_POOL_EMPTY);
-                }
-                else
+                // The client is far from the relay of the host. If its region has a relay, the
+                // client connects to it and that relay connects to the relay of the host.
+                std::shared_ptr<SessionRelay> client_relay;
+                std::string client_relay_region;
+                std::optional<proto::RelayCredentials> near_credentials = takeRelayCredentials(
+                    client_region, SharedKeyPool::RegionPolicy::REQUIRED, secret, &client_relay,
+                    &client_relay_region);
+                if (near_credentials.has_value())
                 {
-                    offer->set_error_code(proto::ConnectionOffer::SUCCESS);
+                    LOG(LS_INFO) << "Cascading relays for regions '" << client_region
+                                 << "' and '" << host_relay_region << "'";
 
-                    proto::RelayCredentials* offer_credentials = offer->mutable_relay();
+                    proto::RelayCascade cascade;
+                    cascade.set_key_id(near_credentials->key().key_id());
+                    cascade.mutable_next()->CopyFrom(*host_credentials);
+                    client_relay->sendCascade(cascade);
 
-                    offer_credentials->set_host(relay->peerData()->first);
-                    offer_credentials->set_port(relay->peerData()->second);
-                    offer_credentials->mutable_key()->Swap(&credentials->key);
-                    offer_credentials->set_secret(base::Random::string(16));
-
-                    LOG(LS_INFO) << "Sending connection offer to host";
-                    offer->set_peer_role(proto::ConnectionOffer::HOST);
-                    host->sendConnectionOffer(*offer);
+                    client_credentials = std::move(*near_credentials);
                 }
             }
+
+            offer->set_error_code(proto::ConnectionOffer::SUCCESS);
+            offer->mutable_relay()->Swap(&*host_credentials);
+
+            LOG(LS_INFO) << "Sending connection offer to host";
+            offer->set_peer_role(proto::ConnectionOffer::HOST);
+            if (host)
+                host->sendConnectionOffer(*offer);
+            else
+                router->sendConnectionOffer(request.host_id(), *offer);
+            trace.addStage("Connection offer sent to host");
+
+            offer->mutable_relay()->Swap(&client_credentials);
+
+            // The client tries to connect to the host directly before using the relay. The
+            // addresses of a host connected to another router are unknown.
+            if (host)
+                host->addCandidates(address(), offer);
         }
     }
 
     LOG(LS_INFO) << "Sending connection offer to client";
     offer->set_peer_role(proto::ConnectionOffer::CLIENT);
     sendMessage(*message);
+    trace.addStage("Connection offer sent to client");
+}
+
+void SessionClient::readHostStatusRequest(const proto::HostStatusRequest& request)
+{
+    // The client learns no more than from a connection request (PEER_NOT_FOUND), but a whole
+    // address book is checked with a few messages.
+    std::unique_ptr<proto::RouterToPeer> message = std::make_unique<proto::RouterToPeer>();
+    message->set_allocated_host_status_list(server().hostStatus(request).release());
+    sendMessage(*message);
+}
+
+std::optional<proto::RelayCredentials> SessionClient::takeRelayCredentials(
+    std::string_view region,
+    SharedKeyPool::RegionPolicy policy,
+    const std::string& secret,
+    std::shared_ptr<SessionRelay>* relay,
+    std::string* relay_region)
+{
+    std::optional<SharedKeyPool::Credentials> credentials =
+        relayKeyPool().takeCredentials(region, policy);
+    if (!credentials.has_value())
+    {
+        LOG(LS_WARNING) << "Empty key pool";
+        return std::nullopt;
+    }
+
+    *relay = std::static_pointer_cast<SessionRelay>(server().sessionById(credentials->session_id));
+    if (!*relay)
+    {
+        LOG(LS_ERROR) << "No relay with session id " << credentials->session_id;
+        return std::nullopt;
+    }
+
+    const std::optional<SessionRelay::PeerData> peer_data = (*relay)->peerData();
+    if (!peer_data.has_value())
+    {
+        LOG(LS_ERROR) << "No peer data for relay with session id " << credentials->session_id;
+        return std::nullopt;
+    }
+
+    proto::RelayCredentials result;
+
+    result.set_host(peer_data->first);
+    result.set_port(peer_data->second);
+    result.mutable_key()->Swap(&credentials->key);
+    result.set_secret(secret);
+
+    *relay_region = std::move(credentials->region);
+    return result;
 }
 
 } // namespace router
@@ -21,11 +21,12 @@
 
 #include "proto/router_peer.pb.h"
 #include "router/session.h"
+#include "router/shared_key_pool.h"
 
 namespace router {
 
 class ServerProxy;
-class SharedKeyPool;
+class SessionRelay;
 
 class SessionClient : public Session
 {
@@ -36,13 +37,21 @@ public:
 protected:
     // Session implementation.
     void onSessionReady() override;
-
-    // base::NetworkChannel::Listener implementation.
-    void onMessageReceived(const base::ByteArray& buffer) override;
-    void onMessageWritten(size_t pending) override;
+    void onSessionMessageReceived(const base::ByteArray& buffer) override;
+    void onSessionMessageWritten(size_t pending) override;
 
 private:
     void readConnectionRequest(const proto::ConnectionRequest& request);
+    void readHostStatusRequest(const proto::HostStatusRequest& request);
+
+    // Takes a key from the pool and returns the credentials for a peer. |relay| receives the
+    // session of the relay which owns the key.
+    std::optional<proto::RelayCredentials> takeRelayCredentials(
+        std::string_view region,
+        SharedKeyPool::RegionPolicy policy,
+        const std::string& secret,
+        std::shared_ptr<SessionRelay>* relay,
+        std::string* relay_region);
 
     DISALLOW_COPY_AND_ASSIGN(SessionClient);
 };
@@ -20,30 +20,55 @@
 
 #include "base/logging.h"
 #include "base/stl_util.h"
+#include "base/trace_event.h"
 #include "base/crypto/generic_hash.h"
 #include "base/crypto/random.h"
+#include "base/net/ip_util.h"
 #include "base/net/network_channel.h"
+#include "base/strings/unicode.h"
 #include "router/database.h"
 #include "router/server.h"
 
+#include <algorithm>
+
 namespace router {
 
 namespace {
 
 const size_t kHostKeySize = 512;
 
+// Hosts send only small requests for their IDs, and most of the time they are idle. The arena of a
+// host session is much smaller than the default one, because there are many host sessions.
+const size_t kHostArenaBlockSize = 1024;
+
+// Maximum number of interface addresses of a host which are offered to the clients.
+const int kMaxHostCandidates = 4;
+
+// If more requests wait for the database, the hosts are asked to reconnect later. The delay is
+// the approximate time to serve the backlog (the hosts add a random delay to it).
+const size_t kMaxPendingDatabaseRequests = 1024;
+const std::chrono::milliseconds kRetryDelayPerRequest { 20 };
+const std::chrono::milliseconds kMaxRetryDelay { 5 * 60 * 1000 };
+
 } // namespace
 
 SessionHost::SessionHost()
-    : Session(proto::ROUTER_SESSION_HOST)
+    : Session(proto::ROUTER_SESSION_HOST, kHostArenaBlockSize)
 {
     // Nothing
 }
 
 SessionHost::~SessionHost() = default;
 
+SessionHost::HostIdList SessionHost::hostIdList() const
+{
+    std::scoped_lock lock(host_id_list_lock_);
+    return host_id_list_;
+}
+
 bool SessionHost::hasHostId(base::HostId host_id) const
 {
+    std::scoped_lock lock(host_id_list_lock_);
     return base::contains(host_id_list_, host_id);
 }
 
@@ -54,15 +79,48 @@ void SessionHost::sendConnectionOffer(const proto::ConnectionOffer& offer)
     sendMessage(*message);
 }
 
+void SessionHost::addCandidates(const std::string& client_address,
+                                proto::ConnectionOffer* offer) const
+{
+    std::shared_ptr<const proto::HostCandidates> candidates;
+    {
+        std::scoped_lock lock(candidates_lock_);
+        candidates = candidates_;
+    }
+
+    if (!candidates)
+        return;
+
+    // Inside one network the interfaces of the host are reachable without passing the NAT.
+    if (client_address == address())
+    {
+        for (const auto& host_address : candidates->address())
+        {
+            proto::PeerCandidate* candidate = offer->add_candidate();
+            candidate->set_type(proto::PeerCandidate::HOST);
+            candidate->set_address(host_address);
+            candidate->set_port(candidates->port());
+        }
+    }
+
+    // The client connects to the public address of the host if the port is forwarded to it.
+    proto::PeerCandidate* candidate = offer->add_candidate();
+    candidate->set_type(proto::PeerCandidate::SERVER_REFLEXIVE);
+    candidate->set_address(address());
+    candidate->set_port(candidates->port());
+}
+
 void SessionHost::onSessionReady()
 {
     // Nothing
 }
 
-void SessionHost::onMessageReceived(const base::ByteArray& buffer)
+void SessionHost::onSessionMessageReceived(const base::ByteArray& buffer)
 {
-    std::unique_ptr<proto::PeerToRouter> message = std::make_unique<proto::PeerToRouter>();
-    if (!base::parse(buffer, message.get()))
+    TRACE_EVENT("router", "SessionHost::onSessionMessageReceived");
+
+    proto::PeerToRouter* message = messageArena().resetAndCreate<proto::PeerToRouter>();
+    if (!base::parse(buffer, message))
     {
         LOG(LS_ERROR) << "Could not read message from host";
         return;
@@ -76,29 +134,25 @@ void SessionHost::onMessageReceived(const base::ByteArray& buffer)
     {
         readResetHostId(message->reset_host_id());
     }
+    else if (message->has_host_candidates())
+    {
+        readHostCandidates(message->host_candidates());
+    }
     else
     {
         LOG(LS_WARNING) << "Unhandled message from host";
     }
 }
 
-void SessionHost::onMessageWritten(size_t /* pending */)
+void SessionHost::onSessionMessageWritten(size_t /* pending */)
 {
     // Nothing
 }
 
 void SessionHost::readHostIdRequest(const proto::HostIdRequest& host_id_request)
 {
-    std::unique_ptr<Database> database = openDatabase();
-    if (!database)
-    {
-        LOG(LS_ERROR) << "Failed to connect to database";
+    if (sendRetryAfterIfOverloaded())
         return;
-    }
-
-    std::unique_ptr<proto::RouterToPeer> message = std::make_unique<proto::RouterToPeer>();
-    proto::HostIdResponse* host_id_response = message->mutable_host_id_response();
-    base::ByteArray key_hash;
 
     if (host_id_request.type() == proto::HostIdRequest::NEW_ID)
     {
@@ -106,44 +160,90 @@ void SessionHost::readHostIdRequest(const proto::HostIdRequest& host_id_request)
         std::string key = base::Random::string(kHostKeySize);
 
         // Calculate hash for key.
-        key_hash = base::GenericHash::hash(base::GenericHash::Type::BLAKE2b512, key);
+        base::ByteArray key_hash =
+            base::GenericHash::hash(base::GenericHash::Type::BLAKE2b512, key);
 
-        if (!database->addHost(key_hash))
+        databaseWorker().addHost(std::move(key_hash), taskRunner(),
+            [this, alive = alive(), key = std::move(key)](base::HostId host_id)
         {
-            LOG(LS_ERROR) << "Unable to add host";
-            return;
-        }
+            if (alive.expired())
+                return;
+
+            if (host_id == base::kInvalidHostId)
+            {
+                LOG(LS_ERROR) << "Unable to add host";
+                return;
+            }
 
-        host_id_response->set_key(std::move(key));
+            sendHostId(host_id, key);
+        });
     }
     else if (host_id_request.type() == proto::HostIdRequest::EXISTING_ID)
     {
         // Using existing key.
-        key_hash = base::GenericHash::hash(
+        base::ByteArray key_hash = base::GenericHash::hash(
             base::GenericHash::Type::BLAKE2b512, host_id_request.key());
+
+        postDatabaseTask<base::HostId>([key_hash = std::move(key_hash)](Database* database)
+        {
+            return database ? database->hostId(key_hash) : base::kInvalidHostId;
+        },
+        [this](base::HostId host_id)
+        {
+            if (host_id == base::kInvalidHostId)
+            {
+                LOG(LS_ERROR) << "Failed to get host ID";
+                return;
+            }
+
+            sendHostId(host_id, std::string());
+        });
     }
     else
     {
         LOG(LS_ERROR) << "Unknown request type: " << host_id_request.type();
-        return;
     }
+}
 
-    base::HostId host_id = database->hostId(key_hash);
-    if (host_id == base::kInvalidHostId)
+void SessionHost::sendHostId(base::HostId host_id, const std::string& key)
+{
     {
-        LOG(LS_ERROR) << "Failed to get host ID";
-        return;
+        std::scoped_lock lock(host_id_list_lock_);
+        host_id_list_.emplace_back(host_id);
     }
 
-    host_id_list_.emplace_back(host_id);
-
     // Notify the server that the ID has been assigned.
     server().onHostSessionWithId(this);
 
+    std::unique_ptr<proto::RouterToPeer> message = std::make_unique<proto::RouterToPeer>();
+    proto::HostIdResponse* host_id_response = message->mutable_host_id_response();
+
     host_id_response->set_host_id(host_id);
+    if (!key.empty())
+        host_id_response->set_key(key);
+
     sendMessage(*message);
 }
 
+bool SessionHost::sendRetryAfterIfOverloaded()
+{
+    const size_t pending = databaseWorker().pendingCount();
+    if (pending < kMaxPendingDatabaseRequests)
+        return false;
+
+    const std::chrono::milliseconds delay =
+        std::min(kRetryDelayPerRequest * static_cast<int64_t>(pending), kMaxRetryDelay);
+
+    LOG_EVERY_T(LS_WARNING, std::chrono::seconds(1))
+        << "Database is overloaded (" << pending << " pending requests). Host will retry after "
+        << delay.count() << " ms";
+
+    std::unique_ptr<proto::RouterToPeer> message = std::make_unique<proto::RouterToPeer>();
+    message->mutable_retry_after()->set_delay_ms(static_cast<uint32_t>(delay.count()));
+    sendMessage(*message);
+    return true;
+}
+
 void SessionHost::readResetHostId(const proto::ResetHostId& reset_host_id)
 {
     base::HostId host_id = reset_host_id.host_id();
@@ -153,23 +253,65 @@ void SessionHost::readResetHostId(const proto::ResetHostId& reset_host_id)
         return;
     }
 
-    if (host_id_list_.empty())
     {
-        LOG(LS_ERROR) << "Empty host ID list";
+        std::scoped_lock lock(host_id_list_lock_);
+
+        if (host_id_list_.empty())
+        {
+            LOG(LS_ERROR) << "Empty host ID list";
+            return;
+        }
+
+        auto it = std::find(host_id_list_.begin(), host_id_list_.end(), host_id);
+        if (it == host_id_list_.end())
+        {
+            LOG(LS_WARNING) << "Host ID " << host_id << " NOT found in list";
+            return;
+        }
+
+        LOG(LS_INFO) << "Host ID " << host_id << " remove from list";
+        host_id_list_.erase(it);
+    }
+
+    // The server takes its own lock and reads the list, so it is called without the lock.
+    server().onHostIdRemoved(this, host_id);
+}
+
+void SessionHost::readHostCandidates(const proto::HostCandidates& host_candidates)
+{
+    if (!host_candidates.port() || host_candidates.port() > 65535)
+    {
+        LOG(LS_WARNING) << "Invalid port of direct connections: " << host_candidates.port();
+
+        std::scoped_lock lock(candidates_lock_);
+        candidates_.reset();
         return;
     }
 
-    for (auto it = host_id_list_.begin(); it != host_id_list_.end(); ++it)
+    std::shared_ptr<proto::HostCandidates> candidates = std::make_shared<proto::HostCandidates>();
+    candidates->set_port(host_candidates.port());
+
+    // The client connects to the addresses given by the host, so only the addresses of private
+    // networks are accepted. The public address is the one the router sees.
+    for (const auto& host_address : host_candidates.address())
     {
-        if (*it == host_id)
+        if (candidates->address_size() >= kMaxHostCandidates)
+            break;
+
+        if (!base::isPrivateIpV4Address(base::utf16FromUtf8(host_address)))
         {
-            LOG(LS_INFO) << "Host ID " << host_id << " remove from list";
-            host_id_list_.erase(it);
-            return;
+            LOG(LS_WARNING) << "Invalid host candidate: " << host_address;
+            continue;
         }
+
+        candidates->add_address(host_address);
     }
 
-    LOG(LS_WARNING) << "Host ID " << host_id << " NOT found in list";
+    LOG(LS_INFO) << "Host candidates: " << candidates->address_size() << " (port: "
+                 << candidates->port() << ")";
+
+    std::scoped_lock lock(candidates_lock_);
+    candidates_ = std::move(candidates);
 }
 
 } // namespace router
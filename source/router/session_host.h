@@ -23,6 +23,9 @@
 #include "proto/router_peer.pb.h"
 #include "router/session.h"
 
+#include <memory>
+#include <mutex>
+
 namespace router {
 
 class ServerProxy;
@@ -35,25 +38,45 @@ public:
 
     using HostIdList = std::vector<base::HostId>;
 
-    const HostIdList& hostIdList() const { return host_id_list_; }
+    // The list is changed on the thread of the session and is read by the server on the threads
+    // of other sessions, so a copy is returned.
+    HostIdList hostIdList() const;
     bool hasHostId(base::HostId host_id) const;
 
     void sendConnectionOffer(const proto::ConnectionOffer& offer);
 
+    // Adds the direct addresses of the host to the offer for the client at |client_address|. The
+    // addresses of the network interfaces are added only if the client is in the same network
+    // (the router sees the same address for both peers). Can be called from any thread.
+    void addCandidates(const std::string& client_address, proto::ConnectionOffer* offer) const;
+
 protected:
     // Session implementation.
     void onSessionReady() override;
-
-    // base::NetworkChannel::Listener implementation.
-    void onMessageReceived(const base::ByteArray& buffer) override;
-    void onMessageWritten(size_t pending) override;
+    void onSessionMessageReceived(const base::ByteArray& buffer) override;
+    void onSessionMessageWritten(size_t pending) override;
 
 private:
     void readHostIdRequest(const proto::HostIdRequest& host_id_request);
     void readResetHostId(const proto::ResetHostId& reset_host_id);
+    void readHostCandidates(const proto::HostCandidates& host_candidates);
 
+    // Called on the thread of the session when the database has returned the ID.
+    void sendHostId(base::HostId host_id, const std::string& key);
+
+    // Asks the host to reconnect later if the database is overloaded. Returns true if the request
+    // should not be served.
+    bool sendRetryAfterIfOverloaded();
+
+    mutable std::mutex host_id_list_lock_;
     HostIdList host_id_list_;
 
+    // Validated addresses of direct connections reported by the host. The sessions of the clients
+    // read them on their own threads, so a new list replaces the published one and is never
+    // changed after that.
+    mutable std::mutex candidates_lock_;
+    std::shared_ptr<const proto::HostCandidates> candidates_;
+
     DISALLOW_COPY_AND_ASSIGN(SessionHost);
 };
 
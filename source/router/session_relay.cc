@@ -19,6 +19,7 @@
 #include "router/session_relay.h"
 
 #include "base/logging.h"
+#include "base/trace_event.h"
 #include "router/shared_key_pool.h"
 
 namespace router {
@@ -41,16 +42,32 @@ void SessionRelay::sendKeyUsed(uint32_t key_id)
     sendMessage(*message);
 }
 
+void SessionRelay::sendKeyRequest(uint32_t key_count)
+{
+    std::unique_ptr<proto::RouterToRelay> message = std::make_unique<proto::RouterToRelay>();
+    message->mutable_key_request()->set_key_count(key_count);
+    sendMessage(*message);
+}
+
+void SessionRelay::sendCascade(const proto::RelayCascade& cascade)
+{
+    std::unique_ptr<proto::RouterToRelay> message = std::make_unique<proto::RouterToRelay>();
+    message->mutable_cascade()->CopyFrom(cascade);
+    sendMessage(*message);
+}
+
 void SessionRelay::onSessionReady()
 {
     // Nothing
 }
 
-void SessionRelay::onMessageReceived(const base::ByteArray& buffer)
+void SessionRelay::onSessionMessageReceived(const base::ByteArray& buffer)
 {
-    std::unique_ptr<proto::RelayToRouter> message = std::make_unique<proto::RelayToRouter>();
+    TRACE_EVENT("router", "SessionRelay::onSessionMessageReceived");
+
+    proto::RelayToRouter* message = messageArena().resetAndCreate<proto::RelayToRouter>();
 
-    if (!base::parse(buffer, message.get()))
+    if (!base::parse(buffer, message))
     {
         LOG(LS_ERROR) << "Could not read message from relay server";
         return;
@@ -60,28 +77,57 @@ void SessionRelay::onMessageReceived(const base::ByteArray& buffer)
     {
         readKeyPool(message->key_pool());
     }
+    else if (message->has_relay_stat())
+    {
+        {
+            std::scoped_lock lock(data_lock_);
+            relay_stat_ = message->relay_stat();
+        }
+
+        relayKeyPool().setRelayLoad(sessionId(), message->relay_stat());
+    }
     else
     {
         LOG(LS_WARNING) << "Unhandled message from relay server";
     }
 }
 
-void SessionRelay::onMessageWritten(size_t /* pending */)
+void SessionRelay::onSessionMessageWritten(size_t /* pending */)
 {
     // Nothing
 }
 
+std::optional<SessionRelay::PeerData> SessionRelay::peerData() const
+{
+    std::scoped_lock lock(data_lock_);
+    return peer_data_;
+}
+
+std::optional<proto::RelayStat> SessionRelay::relayStat() const
+{
+    std::scoped_lock lock(data_lock_);
+    return relay_stat_;
+}
+
 void SessionRelay::readKeyPool(const proto::RelayKeyPool& key_pool)
 {
     SharedKeyPool& pool = relayKeyPool();
 
     LOG(LS_INFO) << "Received key pool: " << key_pool.key_size() << " (" << address() << ")";
 
-    peer_data_.emplace(std::make_pair(
-        key_pool.peer_host(), static_cast<uint16_t>(key_pool.peer_port())));
+    {
+        std::scoped_lock lock(data_lock_);
+        peer_data_.emplace(std::make_pair(
+            key_pool.peer_host(), static_cast<uint16_t>(key_pool.peer_port())));
+    }
+
+    pool.setRelayRegion(sessionId(), key_pool.region());
 
     for (int i = 0; i < key_pool.key_size(); ++i)
         pool.addKey(sessionId(), key_pool.key(i));
+
+    if (key_pool.refill())
+        pool.setRefillReceived(sessionId());
 }
 
 } // namespace router
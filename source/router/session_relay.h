@@ -23,6 +23,8 @@
 #include "router/session.h"
 #include "router/shared_key_pool.h"
 
+#include <mutex>
+
 namespace router {
 
 class SessionRelay : public Session
@@ -33,21 +35,28 @@ public:
 
     using PeerData = std::pair<std::string, uint16_t>;
 
-    const std::optional<PeerData>& peerData() const { return peer_data_; }
+    // The data is changed on the thread of the session and is read on the threads of other
+    // sessions, so copies are returned.
+    std::optional<PeerData> peerData() const;
+
+    // The last statistics received from the relay.
+    std::optional<proto::RelayStat> relayStat() const;
     void sendKeyUsed(uint32_t key_id);
+    void sendKeyRequest(uint32_t key_count);
+    void sendCascade(const proto::RelayCascade& cascade);
 
 protected:
     // Session implementation.
     void onSessionReady() override;
-
-    // base::NetworkChannel::Listener implementation.
-    void onMessageReceived(const base::ByteArray& buffer) override;
-    void onMessageWritten(size_t pending) override;
+    void onSessionMessageReceived(const base::ByteArray& buffer) override;
+    void onSessionMessageWritten(size_t pending) override;
 
 private:
     void readKeyPool(const proto::RelayKeyPool& key_pool);
 
+    mutable std::mutex data_lock_;
     std::optional<PeerData> peer_data_;
+    std::optional<proto::RelayStat> relay_stat_;
 
     DISALLOW_COPY_AND_ASSIGN(SessionRelay);
 };
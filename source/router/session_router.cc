@@ -0,0 +1,110 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/session_router.h"
+
+#include "base/logging.h"
+#include "base/trace_event.h"
+#include "base/peer/connection_trace.h"
+#include "router/server.h"
+#include "router/session_host.h"
+
+namespace router {
+
+SessionRouter::SessionRouter()
+    : Session(proto::ROUTER_SESSION_ROUTER)
+{
+    // Nothing
+}
+
+SessionRouter::~SessionRouter() = default;
+
+void SessionRouter::sendHostList(const proto::ClusterHostList& host_list)
+{
+    std::unique_ptr<proto::RouterToRouter> message = std::make_unique<proto::RouterToRouter>();
+    message->mutable_host_list()->CopyFrom(host_list);
+    sendMessage(*message);
+}
+
+void SessionRouter::sendConnectionOffer(base::HostId host_id, const proto::ConnectionOffer& offer)
+{
+    std::unique_ptr<proto::RouterToRouter> message = std::make_unique<proto::RouterToRouter>();
+    proto::ClusterConnectionOffer* connection_offer = message->mutable_connection_offer();
+
+    connection_offer->set_host_id(host_id);
+    connection_offer->mutable_offer()->CopyFrom(offer);
+    sendMessage(*message);
+}
+
+void SessionRouter::onSessionReady()
+{
+    // The other router receives the full list of our hosts and then the changes.
+    server().onRouterSessionReady(this);
+}
+
+void SessionRouter::onSessionMessageReceived(const base::ByteArray& buffer)
+{
+    TRACE_EVENT("router", "SessionRouter::onSessionMessageReceived");
+
+    proto::RouterToRouter* message = messageArena().resetAndCreate<proto::RouterToRouter>();
+    if (!base::parse(buffer, message))
+    {
+        LOG(LS_ERROR) << "Could not read message from router";
+        return;
+    }
+
+    if (message->has_host_list())
+    {
+        server().onClusterHostList(this, message->host_list());
+    }
+    else if (message->has_connection_offer())
+    {
+        readConnectionOffer(message->connection_offer());
+    }
+    else
+    {
+        LOG(LS_WARNING) << "Unhandled message from router";
+    }
+}
+
+void SessionRouter::onSessionMessageWritten(size_t /* pending */)
+{
+    // Nothing
+}
+
+void SessionRouter::readConnectionOffer(const proto::ClusterConnectionOffer& connection_offer)
+{
+    const base::HostId host_id = connection_offer.host_id();
+
+    // Offers are forwarded only to hosts connected to this router, so they can not loop between
+    // routers.
+    std::shared_ptr<SessionHost> host = server().hostSessionById(host_id);
+    if (!host)
+    {
+        LOG(LS_WARNING) << "Host with id " << host_id << " NOT found for forwarded offer";
+        return;
+    }
+
+    LOG(LS_INFO) << "Sending forwarded connection offer to host " << host_id;
+    host->sendConnectionOffer(connection_offer.offer());
+
+    base::ConnectionTrace(connection_offer.offer().trace_id()).addStage(
+        "Forwarded connection offer sent to host");
+}
+
+} // namespace router
@@ -0,0 +1,53 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__SESSION_ROUTER_H
+#define ROUTER__SESSION_ROUTER_H
+
+#include "proto/router_cluster.pb.h"
+#include "router/session.h"
+
+namespace router {
+
+// Session of another router of the cluster. The routers announce the hosts connected to them and
+// forward connection offers to each other. The session is the same for both directions of the
+// connection.
+class SessionRouter : public Session
+{
+public:
+    SessionRouter();
+    ~SessionRouter();
+
+    void sendHostList(const proto::ClusterHostList& host_list);
+    void sendConnectionOffer(base::HostId host_id, const proto::ConnectionOffer& offer);
+
+protected:
+    // Session implementation.
+    void onSessionReady() override;
+    void onSessionMessageReceived(const base::ByteArray& buffer) override;
+    void onSessionMessageWritten(size_t pending) override;
+
+private:
+    void readConnectionOffer(const proto::ClusterConnectionOffer& connection_offer);
+
+    DISALLOW_COPY_AND_ASSIGN(SessionRouter);
+};
+
+} // namespace router
+
+#endif // ROUTER__SESSION_ROUTER_H
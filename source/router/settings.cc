@@ -31,6 +31,9 @@ const base::JsonSettings::Scope kScope = base::JsonSettings::Scope::SYSTEM;
 const char kApplicationName[] = "aspia";
 const char kFileName[] = "router";
 
+const uint32_t kDefaultMaxPendingAuthentications = 4096;
+const uint32_t kDefaultMaxAnonymousPendingAuthentications = 3072;
+
 } // namespace
 
 Settings::Settings()
@@ -52,10 +55,20 @@ void Settings::reset()
     setPort(DEFAULT_ROUTER_TCP_PORT);
     setPrivateKey(base::ByteArray());
     setMinLogLevel(1);
+    setThreadCount(0);
+    setAcceptRate(0);
+    setMaxPendingAuthentications(kDefaultMaxPendingAuthentications);
+    setMaxAnonymousPendingAuthentications(kDefaultMaxAnonymousPendingAuthentications);
+    setMetricsAddress(u"127.0.0.1");
+    setMetricsPort(0);
+    setDatabaseConnection(std::string());
     setClientWhiteList(WhiteList());
     setHostWhiteList(WhiteList());
     setAdminWhiteList(WhiteList());
     setRelayWhiteList(WhiteList());
+    setRouterWhiteList(WhiteList());
+    setRegionList(RegionList());
+    setClusterPeerList(ClusterPeerList());
 }
 
 void Settings::flush()
@@ -93,6 +106,77 @@ int Settings::minLogLevel() const
     return impl_.get<int>("MinLogLevel", 1);
 }
 
+void Settings::setThreadCount(uint32_t count)
+{
+    impl_.set<uint32_t>("ThreadCount", count);
+}
+
+uint32_t Settings::threadCount() const
+{
+    return impl_.get<uint32_t>("ThreadCount", 0);
+}
+
+void Settings::setAcceptRate(uint32_t rate)
+{
+    impl_.set<uint32_t>("AcceptRate", rate);
+}
+
+uint32_t Settings::acceptRate() const
+{
+    return impl_.get<uint32_t>("AcceptRate", 0);
+}
+
+void Settings::setMaxPendingAuthentications(uint32_t count)
+{
+    impl_.set<uint32_t>("MaxPendingAuthentications", count);
+}
+
+uint32_t Settings::maxPendingAuthentications() const
+{
+    return impl_.get<uint32_t>("MaxPendingAuthentications", kDefaultMaxPendingAuthentications);
+}
+
+void Settings::setMaxAnonymousPendingAuthentications(uint32_t count)
+{
+    impl_.set<uint32_t>("MaxAnonymousPendingAuthentications", count);
+}
+
+uint32_t Settings::maxAnonymousPendingAuthentications() const
+{
+    return impl_.get<uint32_t>("MaxAnonymousPendingAuthentications",
+                               kDefaultMaxAnonymousPendingAuthentications);
+}
+
+void Settings::setMetricsAddress(const std::u16string& address)
+{
+    impl_.set<std::u16string>("MetricsAddress", address);
+}
+
+std::u16string Settings::metricsAddress() const
+{
+    return impl_.get<std::u16string>("MetricsAddress", u"127.0.0.1");
+}
+
+void Settings::setMetricsPort(uint16_t port)
+{
+    impl_.set<uint16_t>("MetricsPort", port);
+}
+
+uint16_t Settings::metricsPort() const
+{
+    return impl_.get<uint16_t>("MetricsPort", 0);
+}
+
+void Settings::setDatabaseConnection(const std::string& connection_string)
+{
+    impl_.set<std::string>("DatabaseConnection", connection_string);
+}
+
+std::string Settings::databaseConnection() const
+{
+    return impl_.get<std::string>("DatabaseConnection");
+}
+
 void Settings::setClientWhiteList(const std::vector<std::u16string>& list)
 {
     setWhiteList("ClientWhiteList", list);
@@ -133,6 +217,105 @@ Settings::WhiteList Settings::relayWhiteList() const
     return whiteList("RelayWhiteList");
 }
 
+void Settings::setRouterWhiteList(const WhiteList& list)
+{
+    setWhiteList("RouterWhiteList", list);
+}
+
+Settings::WhiteList Settings::routerWhiteList() const
+{
+    return whiteList("RouterWhiteList");
+}
+
+void Settings::setRegionList(const RegionList& list)
+{
+    std::u16string result;
+
+    for (const auto& entry : list)
+    {
+        if (entry.first.empty() || entry.second.empty() ||
+            entry.first.find_first_of(u"=;") != std::u16string::npos ||
+            entry.second.find_first_of(u"=;") != std::u16string::npos)
+        {
+            LOG(LS_ERROR) << "Invalid region entry '" << entry.first << "=" << entry.second << "'";
+            continue;
+        }
+
+        base::strAppend(&result, { entry.first, u"=", entry.second, u";" });
+    }
+
+    impl_.set<std::u16string>("Regions", result);
+}
+
+Settings::RegionList Settings::regionList() const
+{
+    RegionList result;
+
+    for (const auto& entry : base::splitString(impl_.get<std::u16string>("Regions"),
+                                               u";",
+                                               base::TRIM_WHITESPACE,
+                                               base::SPLIT_WANT_NONEMPTY))
+    {
+        std::vector<std::u16string> parts =
+            base::splitString(entry, u"=", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+        if (parts.size() != 2)
+        {
+            LOG(LS_ERROR) << "Invalid region entry '" << entry << "'";
+            continue;
+        }
+
+        result.emplace_back(std::move(parts[0]), std::move(parts[1]));
+    }
+
+    return result;
+}
+
+void Settings::setClusterPeerList(const ClusterPeerList& list)
+{
+    base::Settings::Array array;
+
+    for (const auto& peer : list)
+    {
+        if (peer.address.empty() || !peer.port || peer.public_key.empty())
+        {
+            LOG(LS_ERROR) << "Invalid cluster peer '" << peer.address << ":" << peer.port << "'";
+            continue;
+        }
+
+        base::Settings item;
+        item.set<std::u16string>("Address", peer.address);
+        item.set<uint16_t>("Port", peer.port);
+        item.set<std::string>("PublicKey", base::toHex(peer.public_key));
+
+        array.emplace_back(std::move(item));
+    }
+
+    impl_.setArray("ClusterPeers", array);
+}
+
+Settings::ClusterPeerList Settings::clusterPeerList() const
+{
+    ClusterPeerList result;
+
+    for (const auto& item : impl_.getArray("ClusterPeers"))
+    {
+        ClusterPeer peer;
+        peer.address = item.get<std::u16string>("Address");
+        peer.port = item.get<uint16_t>("Port", DEFAULT_ROUTER_TCP_PORT);
+        peer.public_key = base::fromHex(item.get<std::string>("PublicKey"));
+
+        if (peer.address.empty() || peer.public_key.empty())
+        {
+            LOG(LS_ERROR) << "Invalid cluster peer '" << peer.address << ":" << peer.port << "'";
+            continue;
+        }
+
+        result.emplace_back(std::move(peer));
+    }
+
+    return result;
+}
+
 void Settings::setWhiteList(std::string_view key, const WhiteList& value)
 {
     std::u16string result;
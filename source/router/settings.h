@@ -43,6 +43,37 @@ public:
     void setMinLogLevel(int level);
     int minLogLevel() const;
 
+    // Number of threads that serve network connections. If zero, all connections are served on
+    // the main thread.
+    void setThreadCount(uint32_t count);
+    uint32_t threadCount() const;
+
+    // Admission control of new connections (see base::AuthenticationLimiter). The accept rate is
+    // the number of connections per second. Anonymous authentications (hosts, relays and routers)
+    // have a separate lower limit, so clients and admins are admitted during reconnect storms of
+    // hosts. A zero limit is not enforced.
+    void setAcceptRate(uint32_t rate);
+    uint32_t acceptRate() const;
+
+    void setMaxPendingAuthentications(uint32_t count);
+    uint32_t maxPendingAuthentications() const;
+
+    void setMaxAnonymousPendingAuthentications(uint32_t count);
+    uint32_t maxAnonymousPendingAuthentications() const;
+
+    // Address and port of the HTTP listener for Prometheus metrics ("GET /metrics"). If the port
+    // is zero, the listener is disabled.
+    void setMetricsAddress(const std::u16string& address);
+    std::u16string metricsAddress() const;
+
+    void setMetricsPort(uint16_t port);
+    uint16_t metricsPort() const;
+
+    // libpq connection string of the PostgreSQL database ("host=... dbname=... user=..."). If it
+    // is empty, the database is kept in the SQLite file.
+    void setDatabaseConnection(const std::string& connection_string);
+    std::string databaseConnection() const;
+
     using WhiteList = std::vector<std::u16string>;
 
     void setClientWhiteList(const WhiteList& list);
@@ -57,6 +88,34 @@ public:
     void setRelayWhiteList(const WhiteList& list);
     WhiteList relayWhiteList() const;
 
+    // Addresses of the routers of the cluster which may connect to this router.
+    void setRouterWhiteList(const WhiteList& list);
+    WhiteList routerWhiteList() const;
+
+    // Regions of peers by the prefixes of their addresses (for example, "10.1." for the network
+    // 10.1.0.0/16). If a client and a host are in different regions which both have relays, each of
+    // them connects to the relay of its region and the relays are cascaded.
+    using RegionList = std::vector<std::pair<std::u16string, std::u16string>>; // Prefix, region.
+
+    void setRegionList(const RegionList& list);
+    RegionList regionList() const;
+
+    // Other routers of the cluster. The router connects to each of them, announces its hosts and
+    // forwards connection requests for their hosts. Every router must list all the others.
+    // Connections of other routers are accepted only from these addresses, so they must be the
+    // IP addresses the peers connect from.
+    struct ClusterPeer
+    {
+        std::u16string address;
+        uint16_t port = 0;
+        base::ByteArray public_key;
+    };
+
+    using ClusterPeerList = std::vector<ClusterPeer>;
+
+    void setClusterPeerList(const ClusterPeerList& list);
+    ClusterPeerList clusterPeerList() const;
+
 private:
     void setWhiteList(std::string_view key, const WhiteList& value);
     WhiteList whiteList(std::string_view key) const;
@@ -20,10 +20,33 @@
 
 #include "base/logging.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <map>
+#include <mutex>
 
 namespace router {
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Time during which a taken key is counted in the consumption rate with a weight of more than 1/e.
+const std::chrono::duration<double> kRateWindow = std::chrono::seconds(10);
+
+// The pool of the relay should last for this time at the current consumption rate.
+const std::chrono::duration<double> kRefillHorizon = std::chrono::seconds(10);
+
+// If the relay does not reply to the refill request within this time, a new request can be made.
+const std::chrono::seconds kRefillTimeout(5);
+
+// Keys are requested in batches of this size.
+const uint32_t kMinRefillCount = 5;
+const uint32_t kMaxRefillCount = 100;
+
+} // namespace
+
 class SharedKeyPool::Impl
 {
 public:
@@ -33,7 +56,10 @@ public:
     void dettach();
 
     void addKey(Session::SessionId session_id, const proto::RelayKey& key);
-    std::optional<Credentials> takeCredentials();
+    void setRefillReceived(Session::SessionId session_id);
+    void setRelayRegion(Session::SessionId session_id, const std::string& region);
+    void setRelayLoad(Session::SessionId session_id, const proto::RelayStat& relay_stat);
+    std::optional<Credentials> takeCredentials(std::string_view region, RegionPolicy policy);
     void removeKeysForRelay(Session::SessionId session_id);
     void clear();
     size_t countForRelay(Session::SessionId session_id) const;
@@ -43,6 +69,49 @@ public:
 private:
     using Keys = std::vector<proto::RelayKey>;
 
+    struct Load
+    {
+        // Values from the last statistics of the relay.
+        uint32_t active_sessions = 0;
+        uint64_t bytes_per_second = 0;
+
+        // Keys taken since the last statistics. They are expected to become active sessions.
+        uint32_t offers = 0;
+    };
+
+    struct Refill
+    {
+        // Keys taken per second (exponential moving average).
+        double rate = 0;
+        Clock::time_point last_take;
+
+        // The relay has not yet replied to the refill request.
+        bool pending = false;
+        Clock::time_point request_time;
+    };
+
+    // Updates the consumption rate of the relay after a key has been taken. Returns the number of
+    // keys to request from the relay in advance or zero if its free keys are enough.
+    uint32_t updateRefill(Session::SessionId session_id, size_t free_keys);
+
+    // Returns the share of the capacity of the relay which is in use (from 0 to 1). The capacity is
+    // the number of sessions the relay can serve: the sessions it already has and its free keys.
+    double utilization(Session::SessionId session_id, size_t free_keys) const;
+
+    // Returns the least loaded relay with free keys. If |region| is not empty, only relays of the
+    // region are considered.
+    std::map<Session::SessionId, Keys>::iterator findRelay(std::string_view region);
+
+    // Returns the region of the relay or an empty string.
+    std::string_view relayRegion(Session::SessionId session_id) const;
+
+    std::map<Session::SessionId, Load> load_;
+    std::map<Session::SessionId, std::string> region_;
+    std::map<Session::SessionId, Refill> refill_;
+
+    // Sessions served on different threads share the pool.
+    mutable std::mutex lock_;
+
     std::map<Session::SessionId, Keys> pool_;
     Delegate* delegate_;
 
@@ -57,11 +126,14 @@ SharedKeyPool::Impl::Impl(Delegate* delegate)
 
 void SharedKeyPool::Impl::dettach()
 {
+    std::scoped_lock lock(lock_);
     delegate_ = nullptr;
 }
 
 void SharedKeyPool::Impl::addKey(Session::SessionId session_id, const proto::RelayKey& key)
 {
+    std::scoped_lock lock(lock_);
+
     auto relay = pool_.find(session_id);
     if (relay == pool_.end())
     {
@@ -73,26 +145,52 @@ void SharedKeyPool::Impl::addKey(Session::SessionId session_id, const proto::Rel
     relay->second.emplace_back(std::move(key));
 }
 
-std::optional<SharedKeyPool::Credentials> SharedKeyPool::Impl::takeCredentials()
+void SharedKeyPool::Impl::setRefillReceived(Session::SessionId session_id)
+{
+    std::scoped_lock lock(lock_);
+
+    auto refill = refill_.find(session_id);
+    if (refill != refill_.end())
+        refill->second.pending = false;
+}
+
+void SharedKeyPool::Impl::setRelayRegion(Session::SessionId session_id, const std::string& region)
+{
+    std::scoped_lock lock(lock_);
+
+    if (region.empty())
+        region_.erase(session_id);
+    else
+        region_[session_id] = region;
+}
+
+void SharedKeyPool::Impl::setRelayLoad(Session::SessionId session_id,
+                                       const proto::RelayStat& relay_stat)
+{
+    std::scoped_lock lock(lock_);
+
+    Load& load = load_[session_id];
+
+    load.active_sessions = relay_stat.active_sessions();
+    load.bytes_per_second = relay_stat.bytes_per_second_from_first_peer() +
+        relay_stat.bytes_per_second_from_second_peer();
+    load.offers = 0;
+}
+
+std::optional<SharedKeyPool::Credentials> SharedKeyPool::Impl::takeCredentials(
+    std::string_view region, RegionPolicy policy)
 {
+    std::unique_lock lock(lock_);
+
     if (pool_.empty())
     {
         LOG(LS_WARNING) << "Empty key pool";
         return std::nullopt;
     }
 
-    auto preffered_relay = pool_.end();
-    size_t max_count = 0;
-
-    for (auto it = pool_.begin(); it != pool_.end(); ++it)
-    {
-        size_t count = it->second.size();
-        if (count > max_count)
-        {
-            preffered_relay = it;
-            max_count = count;
-        }
-    }
+    auto preffered_relay = findRelay(region);
+    if (preffered_relay == pool_.end() && !region.empty() && policy == RegionPolicy::PREFERRED)
+        preffered_relay = findRelay(std::string_view());
 
     if (preffered_relay == pool_.end())
     {
@@ -111,36 +209,65 @@ std::optional<SharedKeyPool::Credentials> SharedKeyPool::Impl::takeCredentials()
     Credentials credentials;
     credentials.session_id = preffered_relay->first;
     credentials.key = std::move(preffered_relay->second.back());
+    credentials.region = relayRegion(preffered_relay->first);
 
     // Removing the key from the pool.
     preffered_relay->second.pop_back();
 
+    // Until the next statistics, the key is counted as a session of the relay.
+    ++load_[credentials.session_id].offers;
+
+    const uint32_t refill_count =
+        updateRefill(credentials.session_id, preffered_relay->second.size());
+
     if (preffered_relay->second.empty())
     {
         LOG(LS_INFO) << "Last key in the pool for relay. The relay will be removed from the pool";
         pool_.erase(preffered_relay->first);
     }
 
-    if (delegate_)
-        delegate_->onPoolKeyUsed(credentials.session_id, credentials.key.key_id());
+    Delegate* delegate = delegate_;
+
+    // The delegate is notified without the lock, because it can access the pool.
+    lock.unlock();
+
+    if (delegate)
+    {
+        delegate->onPoolKeyUsed(credentials.session_id, credentials.key.key_id());
+
+        if (refill_count)
+            delegate->onPoolRefillNeeded(credentials.session_id, refill_count);
+    }
 
     return credentials;
 }
 
 void SharedKeyPool::Impl::removeKeysForRelay(Session::SessionId session_id)
 {
+    std::scoped_lock lock(lock_);
+
     LOG(LS_INFO) << "All keys for relay '" << session_id << "' removed";
     pool_.erase(session_id);
+    load_.erase(session_id);
+    region_.erase(session_id);
+    refill_.erase(session_id);
 }
 
 void SharedKeyPool::Impl::clear()
 {
+    std::scoped_lock lock(lock_);
+
     LOG(LS_INFO) << "Key pool cleared";
     pool_.clear();
+    load_.clear();
+    region_.clear();
+    refill_.clear();
 }
 
 size_t SharedKeyPool::Impl::countForRelay(Session::SessionId session_id) const
 {
+    std::scoped_lock lock(lock_);
+
     auto result = pool_.find(session_id);
     if (result == pool_.end())
         return 0;
@@ -150,6 +277,8 @@ size_t SharedKeyPool::Impl::countForRelay(Session::SessionId session_id) const
 
 size_t SharedKeyPool::Impl::count() const
 {
+    std::scoped_lock lock(lock_);
+
     size_t result = 0;
 
     for (const auto& relay : pool_)
@@ -160,9 +289,112 @@ size_t SharedKeyPool::Impl::count() const
 
 bool SharedKeyPool::Impl::isEmpty() const
 {
+    std::scoped_lock lock(lock_);
+
     return pool_.empty();
 }
 
+std::map<Session::SessionId, SharedKeyPool::Impl::Keys>::iterator SharedKeyPool::Impl::findRelay(
+    std::string_view region)
+{
+    // The relay with the smallest share of used capacity is preferred. Among equally loaded relays,
+    // the one with less traffic and then the one with more free keys is chosen.
+    auto preffered_relay = pool_.end();
+    double best_utilization = 0;
+    uint64_t best_bytes_per_second = 0;
+    size_t best_count = 0;
+
+    for (auto it = pool_.begin(); it != pool_.end(); ++it)
+    {
+        const size_t count = it->second.size();
+        if (!count)
+            continue;
+
+        if (!region.empty() && relayRegion(it->first) != region)
+            continue;
+
+        auto load = load_.find(it->first);
+
+        const double relay_utilization = utilization(it->first, count);
+        const uint64_t bytes_per_second = load != load_.end() ? load->second.bytes_per_second : 0;
+
+        bool is_better = preffered_relay == pool_.end();
+        if (!is_better && relay_utilization != best_utilization)
+            is_better = relay_utilization < best_utilization;
+        else if (!is_better && bytes_per_second != best_bytes_per_second)
+            is_better = bytes_per_second < best_bytes_per_second;
+        else if (!is_better)
+            is_better = count > best_count;
+
+        if (is_better)
+        {
+            preffered_relay = it;
+            best_utilization = relay_utilization;
+            best_bytes_per_second = bytes_per_second;
+            best_count = count;
+        }
+    }
+
+    return preffered_relay;
+}
+
+std::string_view SharedKeyPool::Impl::relayRegion(Session::SessionId session_id) const
+{
+    auto result = region_.find(session_id);
+    if (result == region_.end())
+        return std::string_view();
+
+    return result->second;
+}
+
+uint32_t SharedKeyPool::Impl::updateRefill(Session::SessionId session_id, size_t free_keys)
+{
+    const Clock::time_point now = Clock::now();
+    Refill& refill = refill_[session_id];
+
+    // Each taken key adds 1/kRateWindow to the rate, the contribution of older keys decays
+    // exponentially.
+    if (refill.last_take != Clock::time_point())
+    {
+        const std::chrono::duration<double> elapsed = now - refill.last_take;
+        refill.rate *= std::exp(-elapsed / kRateWindow);
+    }
+
+    refill.rate += 1.0 / kRateWindow.count();
+    refill.last_take = now;
+
+    // The relay may not reply if it has no spare capacity.
+    if (refill.pending && now - refill.request_time < kRefillTimeout)
+        return 0;
+
+    const size_t target = static_cast<size_t>(std::ceil(refill.rate * kRefillHorizon.count()));
+    if (target < free_keys + kMinRefillCount)
+        return 0;
+
+    const uint32_t key_count =
+        static_cast<uint32_t>(std::min<size_t>(target - free_keys, kMaxRefillCount));
+
+    LOG(LS_INFO) << "Refill for relay '" << session_id << "': " << key_count << " keys (rate: "
+                 << refill.rate << " keys/s, free: " << free_keys << ")";
+
+    refill.pending = true;
+    refill.request_time = now;
+    return key_count;
+}
+
+double SharedKeyPool::Impl::utilization(Session::SessionId session_id, size_t free_keys) const
+{
+    auto load = load_.find(session_id);
+    if (load == load_.end())
+        return 0;
+
+    const double used = static_cast<double>(load->second.active_sessions) +
+        static_cast<double>(load->second.offers);
+    const double capacity = used + static_cast<double>(free_keys);
+
+    return capacity > 0 ? used / capacity : 0;
+}
+
 SharedKeyPool::SharedKeyPool(Delegate* delegate)
     : impl_(std::make_shared<Impl>(delegate)),
       is_primary_(true)
@@ -193,9 +425,26 @@ void SharedKeyPool::addKey(Session::SessionId session_id, const proto::RelayKey&
     impl_->addKey(session_id, key);
 }
 
-std::optional<SharedKeyPool::Credentials> SharedKeyPool::takeCredentials()
+void SharedKeyPool::setRefillReceived(Session::SessionId session_id)
+{
+    impl_->setRefillReceived(session_id);
+}
+
+void SharedKeyPool::setRelayRegion(Session::SessionId session_id, const std::string& region)
+{
+    impl_->setRelayRegion(session_id, region);
+}
+
+void SharedKeyPool::setRelayLoad(Session::SessionId session_id,
+                                 const proto::RelayStat& relay_stat)
+{
+    impl_->setRelayLoad(session_id, relay_stat);
+}
+
+std::optional<SharedKeyPool::Credentials> SharedKeyPool::takeCredentials(
+    std::string_view region, RegionPolicy policy)
 {
-    return impl_->takeCredentials();
+    return impl_->takeCredentials(region, policy);
 }
 
 void SharedKeyPool::removeKeysForRelay(Session::SessionId session_id)
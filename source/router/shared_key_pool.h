@@ -26,6 +26,8 @@
 #include <cstdint>
 #include <optional>
 #include <memory>
+#include <string>
+#include <string_view>
 
 namespace router {
 
@@ -38,6 +40,10 @@ public:
         virtual ~Delegate() = default;
 
         virtual void onPoolKeyUsed(Session::SessionId session_id, uint32_t key_id) = 0;
+
+        // Called when the keys of the relay are taken faster than they are returned to the pool.
+        // The delegate should request |key_count| keys from the relay in advance.
+        virtual void onPoolRefillNeeded(Session::SessionId session_id, uint32_t key_count) = 0;
     };
 
     explicit SharedKeyPool(Delegate* delegate);
@@ -49,10 +55,32 @@ public:
     {
         Session::SessionId session_id;
         proto::RelayKey key;
+        std::string region;
+    };
+
+    enum class RegionPolicy
+    {
+        PREFERRED, // A relay of the region is preferred, but any relay can be taken.
+        REQUIRED   // Only a relay of the region can be taken.
     };
 
     void addKey(Session::SessionId session_id, const proto::RelayKey& key);
-    std::optional<Credentials> takeCredentials();
+
+    // Must be called when the relay has replied to the refill request (see
+    // Delegate::onPoolRefillNeeded). Until then, new requests are not made for the relay.
+    void setRefillReceived(Session::SessionId session_id);
+
+    // Sets the region of the relay (see Settings::regionList).
+    void setRelayRegion(Session::SessionId session_id, const std::string& region);
+
+    // Updates the load of the relay from its statistics.
+    void setRelayLoad(Session::SessionId session_id, const proto::RelayStat& relay_stat);
+
+    // Takes a key of the least loaded relay. If |region| is not empty, relays of the region are
+    // chosen according to |policy|.
+    std::optional<Credentials> takeCredentials(
+        std::string_view region = std::string_view(),
+        RegionPolicy policy = RegionPolicy::PREFERRED);
     void removeKeysForRelay(Session::SessionId session_id);
     void clear();
     size_t countForRelay(Session::SessionId session_id) const;
@@ -0,0 +1,74 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "router/user_cache.h"
+
+#include <mutex>
+
+namespace router {
+
+namespace {
+
+// The cache must not grow without limit. When the limit is reached, the cache is cleared.
+const size_t kMaxCachedUsers = 100000;
+
+} // namespace
+
+UserCache::UserCache() = default;
+
+UserCache::~UserCache() = default;
+
+std::optional<base::User> UserCache::find(
+    std::u16string_view username, uint64_t* generation) const
+{
+    std::shared_lock lock(lock_);
+
+    *generation = generation_;
+
+    auto it = users_.find(std::u16string(username));
+    if (it == users_.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+void UserCache::add(std::u16string_view username, const base::User& user, uint64_t generation)
+{
+    if (!user.isValid())
+        return;
+
+    std::unique_lock lock(lock_);
+
+    if (generation != generation_)
+        return;
+
+    if (users_.size() >= kMaxCachedUsers)
+        users_.clear();
+
+    users_.insert_or_assign(std::u16string(username), user);
+}
+
+void UserCache::clear()
+{
+    std::unique_lock lock(lock_);
+
+    users_.clear();
+    ++generation_;
+}
+
+} // namespace router
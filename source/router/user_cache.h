@@ -0,0 +1,62 @@
+//
+// Aspia Project
+// Copyright (C) 2020 Dmitry Chapyshev <dmitry@aspia.ru>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef ROUTER__USER_CACHE_H
+#define ROUTER__USER_CACHE_H
+
+#include "base/macros_magic.h"
+#include "base/peer/user.h"
+
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace router {
+
+// In-memory cache of users found by name. While a user is in the cache, its authentication does
+// not read the database. The cache is cleared on any change of the users. The class is
+// thread-safe.
+class UserCache
+{
+public:
+    UserCache();
+    ~UserCache();
+
+    // Returns the cached user or std::nullopt if the name is not in the cache. |generation|
+    // receives the value to pass to add().
+    std::optional<base::User> find(std::u16string_view username, uint64_t* generation) const;
+
+    // Adds the user read from the database after find(). Invalid users are not added, since a
+    // failed read can not be told from a missing user. The user is not added if the cache has
+    // been cleared since find(), because the database could have changed after the read.
+    void add(std::u16string_view username, const base::User& user, uint64_t generation);
+
+    void clear();
+
+private:
+    mutable std::shared_mutex lock_;
+    std::unordered_map<std::u16string, base::User> users_;
+    uint64_t generation_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(UserCache);
+};
+
+} // namespace router
+
+#endif // ROUTER__USER_CACHE_H
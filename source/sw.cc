@@ -111,6 +111,7 @@ void build(Solution &s)
     base.Public += "org.sw.demo.miloyip.rapidjson"_dep;
     base.Public += "org.sw.demo.google.protobuf.protobuf_lite"_dep;
     base.Public += "org.sw.demo.chromium.libyuv-master"_dep;
+    base.Public += "org.sw.demo.aomedia.aom"_dep;
     base.Public += "org.sw.demo.webmproject.vpx"_dep;
     base.Public += "org.sw.demo.webmproject.webm"_dep;
     base.Public += "org.sw.demo.xiph.opus"_dep;